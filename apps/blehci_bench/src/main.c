@@ -0,0 +1,794 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * HCI transport benchmark.
+ *
+ * The application plays the host side of whichever ble_hci transport the
+ * target is built with, without a host stack in between.  It exposes a
+ * "hcibench" shell command:
+ *
+ *   hcibench cmd [count]            - command round trips (Read BD_ADDR)
+ *   hcibench conn <addr> [random]   - connect to an advertising peer
+ *   hcibench acl [count] [len]      - stream ACL packets on the connection
+ *   hcibench disc                   - disconnect
+ *   hcibench stop                   - abort the current run
+ *
+ * Command latency is the time from handing the command to the transport
+ * until its Command Complete arrives.  ACL latency is the time until the
+ * controller reports the packet in a Number Of Completed Packets event,
+ * so it includes the air time; comparing runs over the same link isolates
+ * the transport.  The ACL stream uses the controller's buffer count from
+ * LE Read Buffer Size as its window.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "shell/shell.h"
+#include "parse/parse.h"
+#include "nimble/ble.h"
+#include "nimble/ble_hci_trans.h"
+
+#ifdef ARCH_sim
+#include <mcu/mcu_sim.h>
+#endif
+
+#define BENCH_OP(ogf, ocf)              (((ogf) << 10) | (ocf))
+#define BENCH_OP_DISCONNECT             BENCH_OP(0x01, 0x0006)
+#define BENCH_OP_RESET                  BENCH_OP(0x03, 0x0003)
+#define BENCH_OP_RD_BD_ADDR             BENCH_OP(0x04, 0x0009)
+#define BENCH_OP_LE_RD_BUF_SIZE         BENCH_OP(0x08, 0x0002)
+#define BENCH_OP_LE_CREATE_CONN         BENCH_OP(0x08, 0x000d)
+
+#define BENCH_EVT_DISCONN_CMP           0x05
+#define BENCH_EVT_CMD_COMPLETE          0x0e
+#define BENCH_EVT_CMD_STATUS            0x0f
+#define BENCH_EVT_NUM_COMP_PKTS         0x13
+#define BENCH_EVT_LE_META               0x3e
+#define BENCH_EVT_LE_CONN_CMP           0x01
+#define BENCH_EVT_LE_ENH_CONN_CMP       0x0a
+
+#define BENCH_ACL_HDR_LEN               4
+#define BENCH_L2CAP_HDR_LEN             4
+
+/* Unassigned LE fixed channel; a receiving host drops these frames. */
+#define BENCH_L2CAP_CID                 0x003e
+
+#define BENCH_CONN_NONE                 0xffff
+
+/* Upper bound on the ACL window, whatever the controller advertises. */
+#define BENCH_ACL_WINDOW_MAX            32
+
+#define BENCH_LAT_SAMPLES               MYNEWT_VAL(BLEHCI_BENCH_LAT_SAMPLES)
+
+/* Notifications from the transport callbacks to the benchmark task. */
+#define BENCH_F_READY                   0x01
+#define BENCH_F_CONN_UP                 0x02
+#define BENCH_F_CONN_DOWN               0x04
+#define BENCH_F_CONN_FAIL               0x08
+#define BENCH_F_RESET_DONE              0x10
+
+enum blehci_bench_mode {
+    BENCH_MODE_IDLE,
+    BENCH_MODE_CMD,
+    BENCH_MODE_ACL,
+};
+
+struct blehci_bench {
+    uint8_t mode;
+    uint8_t flags;
+    uint8_t hci_status;
+    uint8_t cmd_pending;
+
+    uint16_t conn_handle;
+    uint16_t acl_max_len;
+    uint8_t acl_window;
+    uint8_t acl_credits;
+    uint16_t acl_len;
+
+    uint32_t target;
+    uint32_t sent;
+    uint32_t done;
+    uint32_t bytes;
+    uint32_t start;
+    uint32_t end;
+
+    /* Send timestamps of ACL packets the controller still holds. */
+    uint32_t acl_ts[BENCH_ACL_WINDOW_MAX];
+    uint8_t acl_ts_head;
+    uint8_t acl_ts_cnt;
+    uint32_t cmd_ts;
+
+    /* Ring of the most recent latency samples, in usecs. */
+    uint32_t lat[BENCH_LAT_SAMPLES];
+    uint32_t lat_cnt;
+
+    int msys_min;
+    uint32_t alloc_fails;
+    uint32_t rx_acl_pkts;
+    uint32_t rx_acl_bytes;
+};
+
+static struct blehci_bench bench;
+static uint32_t bench_lat_sorted[BENCH_LAT_SAMPLES];
+
+static void blehci_bench_pump(struct os_event *ev);
+
+static struct os_event blehci_bench_ev = {
+    .ev_cb = blehci_bench_pump,
+};
+
+/* Retries a stalled ACL run once mbufs have had a chance to drain. */
+static struct os_callout blehci_bench_retry;
+
+static int blehci_bench_cli(int argc, char **argv);
+
+static const struct shell_cmd blehci_bench_cmd = {
+    .sc_cmd = "hcibench",
+    .sc_cmd_func = blehci_bench_cli,
+};
+
+static void
+blehci_bench_kick(void)
+{
+    os_eventq_put(os_eventq_dflt_get(), &blehci_bench_ev);
+}
+
+static void
+blehci_bench_msys_sample(void)
+{
+    int nfree;
+
+    nfree = os_msys_num_free();
+    if (nfree < bench.msys_min) {
+        bench.msys_min = nfree;
+    }
+}
+
+/**
+ * Records one completed packet.  Called with interrupts disabled.
+ */
+static void
+blehci_bench_complete(uint32_t sent_at, uint32_t now, uint16_t len)
+{
+    bench.lat[bench.lat_cnt % BENCH_LAT_SAMPLES] =
+        os_cputime_ticks_to_usecs(now - sent_at);
+    bench.lat_cnt++;
+    bench.done++;
+    bench.bytes += len;
+    bench.end = now;
+}
+
+static int
+blehci_bench_cmd_tx(uint16_t opcode, const void *params, uint8_t len)
+{
+    uint8_t *buf;
+
+    buf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_CMD);
+    if (buf == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    put_le16(buf, opcode);
+    buf[2] = len;
+    if (len > 0) {
+        memcpy(buf + 3, params, len);
+    }
+
+    return ble_hci_trans_hs_cmd_tx(buf);
+}
+
+static void
+blehci_bench_rx_cmd_complete(const uint8_t *evt, uint32_t now)
+{
+    uint16_t opcode;
+    uint8_t status;
+
+    if (evt[1] < 4) {
+        return;
+    }
+    opcode = get_le16(evt + 3);
+    status = evt[5];
+
+    switch (opcode) {
+    case BENCH_OP_RESET:
+        bench.hci_status = status;
+        bench.flags |= BENCH_F_RESET_DONE;
+        break;
+
+    case BENCH_OP_LE_RD_BUF_SIZE:
+        if (status == 0 && evt[1] >= 7) {
+            bench.acl_max_len = get_le16(evt + 6);
+            bench.acl_window = min(evt[8], BENCH_ACL_WINDOW_MAX);
+        }
+        bench.hci_status = status;
+        bench.flags |= BENCH_F_READY;
+        break;
+
+    case BENCH_OP_RD_BD_ADDR:
+        if (bench.mode == BENCH_MODE_CMD && bench.cmd_pending) {
+            bench.cmd_pending = 0;
+            blehci_bench_complete(bench.cmd_ts, now, 3 + evt[1]);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void
+blehci_bench_rx_num_comp_pkts(const uint8_t *evt, uint32_t now)
+{
+    const uint8_t *entry;
+    uint16_t handle;
+    uint16_t cnt;
+    int i;
+
+    if (evt[1] < 1 || evt[1] < 1 + evt[2] * 4) {
+        return;
+    }
+
+    entry = evt + 3;
+    for (i = 0; i < evt[2]; i++, entry += 4) {
+        handle = get_le16(entry);
+        cnt = get_le16(entry + 2);
+        if (handle != bench.conn_handle) {
+            continue;
+        }
+
+        while (cnt-- > 0 && bench.acl_ts_cnt > 0) {
+            if (bench.mode == BENCH_MODE_ACL) {
+                blehci_bench_complete(bench.acl_ts[bench.acl_ts_head], now,
+                                      bench.acl_len);
+            }
+            bench.acl_ts_head = (bench.acl_ts_head + 1) % BENCH_ACL_WINDOW_MAX;
+            bench.acl_ts_cnt--;
+            bench.acl_credits++;
+        }
+    }
+}
+
+static void
+blehci_bench_rx_le_meta(const uint8_t *evt)
+{
+    switch (evt[2]) {
+    case BENCH_EVT_LE_CONN_CMP:
+    case BENCH_EVT_LE_ENH_CONN_CMP:
+        if (evt[1] < 4) {
+            return;
+        }
+        bench.hci_status = evt[3];
+        if (evt[3] == 0) {
+            bench.conn_handle = get_le16(evt + 4) & 0x0fff;
+            bench.acl_credits = bench.acl_window;
+            bench.acl_ts_cnt = 0;
+            bench.flags |= BENCH_F_CONN_UP;
+        } else {
+            bench.flags |= BENCH_F_CONN_FAIL;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Transport event callback.  Depending on the transport this runs in the
+ * controller's task or in interrupt context, so it only updates counters
+ * and hands everything else to the default event queue.
+ */
+static int
+blehci_bench_rx_evt(uint8_t *evt, void *arg)
+{
+    uint32_t now;
+    os_sr_t sr;
+
+    now = os_cputime_get32();
+
+    OS_ENTER_CRITICAL(sr);
+    switch (evt[0]) {
+    case BENCH_EVT_CMD_COMPLETE:
+        blehci_bench_rx_cmd_complete(evt, now);
+        break;
+
+    case BENCH_EVT_CMD_STATUS:
+        /* Only LE Create Connection and Disconnect are sent without
+         * expecting a Command Complete.
+         */
+        if (evt[1] >= 4 && evt[2] != 0 &&
+            get_le16(evt + 4) == BENCH_OP_LE_CREATE_CONN) {
+
+            bench.hci_status = evt[2];
+            bench.flags |= BENCH_F_CONN_FAIL;
+        }
+        break;
+
+    case BENCH_EVT_NUM_COMP_PKTS:
+        blehci_bench_rx_num_comp_pkts(evt, now);
+        break;
+
+    case BENCH_EVT_DISCONN_CMP:
+        if (evt[1] >= 4 && evt[2] == 0 &&
+            get_le16(evt + 3) == bench.conn_handle) {
+
+            bench.conn_handle = BENCH_CONN_NONE;
+            bench.hci_status = evt[5];
+            bench.flags |= BENCH_F_CONN_DOWN;
+        }
+        break;
+
+    case BENCH_EVT_LE_META:
+        blehci_bench_rx_le_meta(evt);
+        break;
+
+    default:
+        break;
+    }
+    blehci_bench_msys_sample();
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hci_trans_buf_free(evt);
+    blehci_bench_kick();
+
+    return 0;
+}
+
+static int
+blehci_bench_rx_acl(struct os_mbuf *om, void *arg)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    bench.rx_acl_pkts++;
+    bench.rx_acl_bytes += OS_MBUF_PKTLEN(om);
+    OS_EXIT_CRITICAL(sr);
+
+    os_mbuf_free_chain(om);
+
+    return 0;
+}
+
+static int
+blehci_bench_lat_cmp(const void *a, const void *b)
+{
+    uint32_t la;
+    uint32_t lb;
+
+    la = *(const uint32_t *)a;
+    lb = *(const uint32_t *)b;
+
+    return (la > lb) - (la < lb);
+}
+
+static void
+blehci_bench_report(void)
+{
+    uint32_t elapsed;
+    uint32_t pps;
+    uint32_t bps;
+    uint32_t n;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    n = min(bench.lat_cnt, BENCH_LAT_SAMPLES);
+    memcpy(bench_lat_sorted, bench.lat, n * sizeof(bench.lat[0]));
+    elapsed = os_cputime_ticks_to_usecs(bench.end - bench.start);
+    OS_EXIT_CRITICAL(sr);
+
+    qsort(bench_lat_sorted, n, sizeof(bench_lat_sorted[0]),
+          blehci_bench_lat_cmp);
+
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    pps = (uint64_t)bench.done * 1000000 / elapsed;
+    bps = (uint64_t)bench.bytes * 1000000 / elapsed;
+
+    console_printf("hcibench: %lu pkts, %lu bytes in %lu us\n",
+                   (unsigned long)bench.done, (unsigned long)bench.bytes,
+                   (unsigned long)elapsed);
+    console_printf("  rate: %lu pkts/s, %lu bytes/s\n",
+                   (unsigned long)pps, (unsigned long)bps);
+    if (n > 0) {
+        console_printf("  latency (us, last %lu): p50=%lu p90=%lu p99=%lu "
+                       "max=%lu\n", (unsigned long)n,
+                       (unsigned long)bench_lat_sorted[n * 50 / 100],
+                       (unsigned long)bench_lat_sorted[n * 90 / 100],
+                       (unsigned long)bench_lat_sorted[n * 99 / 100],
+                       (unsigned long)bench_lat_sorted[n - 1]);
+    }
+    console_printf("  msys: %d/%d free at worst, %lu alloc failures\n",
+                   bench.msys_min, os_msys_count(),
+                   (unsigned long)bench.alloc_fails);
+    console_printf("  acl rx: %lu pkts, %lu bytes\n",
+                   (unsigned long)bench.rx_acl_pkts,
+                   (unsigned long)bench.rx_acl_bytes);
+}
+
+static struct os_mbuf *
+blehci_bench_acl_build(void)
+{
+    static const uint8_t pattern[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    struct os_mbuf *om;
+    uint8_t hdr[BENCH_ACL_HDR_LEN + BENCH_L2CAP_HDR_LEN];
+    uint16_t rem;
+    uint16_t chunk;
+    int rc;
+
+    om = os_msys_get_pkthdr(BENCH_ACL_HDR_LEN + bench.acl_len,
+                            sizeof(struct ble_mbuf_hdr));
+    if (om == NULL) {
+        return NULL;
+    }
+
+    /* Packet boundary flag 0: start of a non-flushable L2CAP frame. */
+    put_le16(hdr, bench.conn_handle);
+    put_le16(hdr + 2, bench.acl_len);
+    put_le16(hdr + 4, bench.acl_len - BENCH_L2CAP_HDR_LEN);
+    put_le16(hdr + 6, BENCH_L2CAP_CID);
+
+    rc = os_mbuf_append(om, hdr, sizeof(hdr));
+    rem = bench.acl_len - BENCH_L2CAP_HDR_LEN;
+    while (rc == 0 && rem > 0) {
+        chunk = min(rem, sizeof(pattern));
+        rc = os_mbuf_append(om, pattern, chunk);
+        rem -= chunk;
+    }
+    if (rc != 0) {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+
+    return om;
+}
+
+static void
+blehci_bench_pump_cmd(void)
+{
+    int rc;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (bench.cmd_pending || bench.sent >= bench.target) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    bench.cmd_pending = 1;
+    bench.sent++;
+    bench.cmd_ts = os_cputime_get32();
+    OS_EXIT_CRITICAL(sr);
+
+    rc = blehci_bench_cmd_tx(BENCH_OP_RD_BD_ADDR, NULL, 0);
+    if (rc != 0) {
+        console_printf("hcibench: command tx failed; rc=%d\n", rc);
+        bench.mode = BENCH_MODE_IDLE;
+    }
+}
+
+static void
+blehci_bench_pump_acl(void)
+{
+    struct os_mbuf *om;
+    uint8_t slot;
+    int rc;
+    os_sr_t sr;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (bench.acl_credits == 0 || bench.sent >= bench.target) {
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        om = blehci_bench_acl_build();
+        blehci_bench_msys_sample();
+        if (om == NULL) {
+            bench.alloc_fails++;
+            os_callout_reset(&blehci_bench_retry, 1);
+            return;
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        slot = (bench.acl_ts_head + bench.acl_ts_cnt) % BENCH_ACL_WINDOW_MAX;
+        bench.acl_ts[slot] = os_cputime_get32();
+        bench.acl_ts_cnt++;
+        bench.acl_credits--;
+        bench.sent++;
+        OS_EXIT_CRITICAL(sr);
+
+        rc = ble_hci_trans_hs_acl_tx(om);
+        if (rc != 0) {
+            console_printf("hcibench: acl tx failed; rc=%d\n", rc);
+            bench.mode = BENCH_MODE_IDLE;
+            return;
+        }
+    }
+}
+
+static void
+blehci_bench_pump(struct os_event *ev)
+{
+    uint8_t flags;
+    int rc;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    flags = bench.flags;
+    bench.flags = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (flags & BENCH_F_RESET_DONE) {
+        rc = blehci_bench_cmd_tx(BENCH_OP_LE_RD_BUF_SIZE, NULL, 0);
+        if (rc != 0) {
+            console_printf("hcibench: LE Read Buffer Size failed; rc=%d\n",
+                           rc);
+        }
+    }
+    if (flags & BENCH_F_READY) {
+        console_printf("hcibench: ready; status=0x%02x acl len=%u "
+                       "window=%u\n", bench.hci_status, bench.acl_max_len,
+                       bench.acl_window);
+    }
+    if (flags & BENCH_F_CONN_UP) {
+        console_printf("hcibench: connected; handle=%u\n",
+                       bench.conn_handle);
+    }
+    if (flags & BENCH_F_CONN_FAIL) {
+        console_printf("hcibench: connect failed; status=0x%02x\n",
+                       bench.hci_status);
+    }
+    if (flags & BENCH_F_CONN_DOWN) {
+        console_printf("hcibench: disconnected; reason=0x%02x\n",
+                       bench.hci_status);
+        if (bench.mode == BENCH_MODE_ACL) {
+            bench.mode = BENCH_MODE_IDLE;
+            blehci_bench_report();
+        }
+    }
+
+    switch (bench.mode) {
+    case BENCH_MODE_CMD:
+        blehci_bench_pump_cmd();
+        break;
+    case BENCH_MODE_ACL:
+        blehci_bench_pump_acl();
+        break;
+    default:
+        return;
+    }
+
+    if (bench.mode != BENCH_MODE_IDLE && bench.done >= bench.target) {
+        bench.mode = BENCH_MODE_IDLE;
+        blehci_bench_report();
+    }
+}
+
+static void
+blehci_bench_retry_cb(struct os_event *ev)
+{
+    blehci_bench_kick();
+}
+
+static void
+blehci_bench_start(uint8_t mode, uint32_t count)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    bench.mode = mode;
+    bench.target = count;
+    bench.sent = 0;
+    bench.done = 0;
+    bench.bytes = 0;
+    bench.lat_cnt = 0;
+    bench.cmd_pending = 0;
+    bench.alloc_fails = 0;
+    bench.rx_acl_pkts = 0;
+    bench.rx_acl_bytes = 0;
+    bench.msys_min = os_msys_num_free();
+    bench.start = os_cputime_get32();
+    bench.end = bench.start;
+    OS_EXIT_CRITICAL(sr);
+
+    blehci_bench_kick();
+}
+
+static int
+blehci_bench_cli_conn(int argc, char **argv)
+{
+    uint8_t params[25];
+    uint8_t addr[6];
+    int rc;
+    int i;
+
+    if (argc < 3) {
+        return SYS_EINVAL;
+    }
+
+    rc = parse_byte_stream_exact_length(argv[2], addr, sizeof(addr));
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(params, 0, sizeof(params));
+    put_le16(params + 0, 0x0010);            /* Scan interval. */
+    put_le16(params + 2, 0x0010);            /* Scan window. */
+    params[5] = argc > 3 && strcmp(argv[3], "random") == 0;
+    for (i = 0; i < 6; i++) {
+        /* Addresses are entered MSB first, sent LSB first. */
+        params[6 + i] = addr[5 - i];
+    }
+    put_le16(params + 13, 0x0006);           /* 7.5 ms interval. */
+    put_le16(params + 15, 0x0006);
+    put_le16(params + 19, 0x0100);           /* 2.56 s timeout. */
+
+    return blehci_bench_cmd_tx(BENCH_OP_LE_CREATE_CONN, params,
+                               sizeof(params));
+}
+
+static int
+blehci_bench_cli_acl(int argc, char **argv)
+{
+    uint32_t count;
+    uint16_t len;
+    int rc;
+
+    if (bench.conn_handle == BENCH_CONN_NONE || bench.acl_window == 0) {
+        console_printf("hcibench: not connected\n");
+        return SYS_ENOENT;
+    }
+
+    count = MYNEWT_VAL(BLEHCI_BENCH_DFLT_COUNT);
+    len = MYNEWT_VAL(BLEHCI_BENCH_DFLT_ACL_LEN);
+    if (argc > 2) {
+        count = parse_ull_bounds(argv[2], 1, UINT32_MAX, &rc);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    if (argc > 3) {
+        len = parse_ull_bounds(argv[3], BENCH_L2CAP_HDR_LEN,
+                               bench.acl_max_len, &rc);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    bench.acl_len = min(len, bench.acl_max_len);
+
+    blehci_bench_start(BENCH_MODE_ACL, count);
+    return 0;
+}
+
+static int
+blehci_bench_cli(int argc, char **argv)
+{
+    uint8_t params[3];
+    uint32_t count;
+    int rc;
+
+    if (argc < 2) {
+        goto usage;
+    }
+
+    if (bench.mode != BENCH_MODE_IDLE && strcmp(argv[1], "stop") != 0) {
+        console_printf("hcibench: run in progress\n");
+        return SYS_EBUSY;
+    }
+
+    if (strcmp(argv[1], "cmd") == 0) {
+        count = MYNEWT_VAL(BLEHCI_BENCH_DFLT_COUNT);
+        if (argc > 2) {
+            count = parse_ull_bounds(argv[2], 1, UINT32_MAX, &rc);
+            if (rc != 0) {
+                goto usage;
+            }
+        }
+        blehci_bench_start(BENCH_MODE_CMD, count);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "conn") == 0) {
+        rc = blehci_bench_cli_conn(argc, argv);
+    } else if (strcmp(argv[1], "acl") == 0) {
+        rc = blehci_bench_cli_acl(argc, argv);
+    } else if (strcmp(argv[1], "disc") == 0) {
+        if (bench.conn_handle == BENCH_CONN_NONE) {
+            console_printf("hcibench: not connected\n");
+            return SYS_ENOENT;
+        }
+        put_le16(params, bench.conn_handle);
+        params[2] = 0x13;                    /* Remote user terminated. */
+        rc = blehci_bench_cmd_tx(BENCH_OP_DISCONNECT, params,
+                                 sizeof(params));
+    } else if (strcmp(argv[1], "stop") == 0) {
+        if (bench.mode != BENCH_MODE_IDLE) {
+            bench.mode = BENCH_MODE_IDLE;
+            blehci_bench_report();
+        }
+        rc = 0;
+    } else {
+        goto usage;
+    }
+
+    if (rc == SYS_EINVAL || rc == SYS_ERANGE) {
+        goto usage;
+    }
+    return rc;
+
+usage:
+    console_printf("usage: hcibench cmd [count]\n"
+                   "       hcibench conn <addr> [random]\n"
+                   "       hcibench acl [count] [len]\n"
+                   "       hcibench disc\n"
+                   "       hcibench stop\n");
+    return SYS_EINVAL;
+}
+
+/**
+ * main
+ *
+ * The main task for the project. This function initializes the packages,
+ * takes over the host side of the HCI transport, then starts serving events
+ * from default event queue.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    int rc;
+
+#ifdef ARCH_sim
+    mcu_sim_parse_args(argc, argv);
+#endif
+
+    sysinit();
+
+    bench.conn_handle = BENCH_CONN_NONE;
+    os_callout_init(&blehci_bench_retry, os_eventq_dflt_get(),
+                    blehci_bench_retry_cb, NULL);
+
+    ble_hci_trans_cfg_hs(blehci_bench_rx_evt, NULL,
+                         blehci_bench_rx_acl, NULL);
+
+    /* Start from a known controller state; LE Read Buffer Size follows
+     * once the reset completes.
+     */
+    rc = blehci_bench_cmd_tx(BENCH_OP_RESET, NULL, 0);
+    assert(rc == 0);
+
+    rc = shell_cmd_register(&blehci_bench_cmd);
+    assert(rc == 0);
+
+    /*
+     * As the last thing, process events from default event queue.
+     */
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+}
@@ -0,0 +1,625 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Kernel primitives benchmark.
+ *
+ * Runs once at boot (KERNBENCH_AUTORUN) and on the "kernbench" shell
+ * command:
+ *
+ *   kernbench [iters]
+ *
+ * Each benchmark is a TEST_BENCH loop on the kernbench task; the helper
+ * task runs one priority higher so every wakeup switches straight to it.
+ *
+ *   ctx_switch          wake the helper, which blocks again (2 switches)
+ *   sem_pingpong        semaphore to the helper and back (2 switches)
+ *   mutex_handoff       helper blocks on a held mutex, gets it on release
+ *   eventq_dispatch     os_eventq_put() to the helper's queue
+ *   isr_wakeup          cputime timer ISR releases a semaphore
+ *   memblock_get_put    os_memblock_get() + os_memblock_put()
+ *   mbuf_chain          os_mbuf_get/append/pullup/free_chain, 3 buffers
+ *   callout_reset_N     re-arm one callout with N others pending
+ *   callout_expire_N    arm N callouts 1 tick out and drain them; includes
+ *                       the wait for the tick, so compare against N=1
+ *   malloc_free         os_malloc() + os_free(), unfragmented heap
+ *   malloc_free_frag    the same with every other block still allocated
+ *
+ * A summary is printed in nanoseconds and every result is appended to the
+ * "kernbench" log as a CBOR map, so runs can be pulled off a board with
+ * the log commands and compared across BSPs and configurations.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "shell/shell.h"
+#include "parse/parse.h"
+#include "cbmem/cbmem.h"
+#include "log/log.h"
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "testutil/testutil.h"
+
+#ifdef ARCH_sim
+#include <mcu/mcu_sim.h>
+#endif
+
+#define KB_STACK_SIZE           OS_STACK_ALIGN(384)
+#define KB_HELPER_STACK_SIZE    OS_STACK_ALIGN(256)
+
+#define KB_LOG_MODULE           (LOG_MODULE_PERUSER + 0)
+
+#define KB_POOL_BLOCKS          8
+#define KB_POOL_BLOCK_SIZE      32
+
+#define KB_MBUF_BUF_SIZE        128
+#define KB_MBUF_BLOCK_SIZE      (KB_MBUF_BUF_SIZE + sizeof(struct os_mbuf))
+#define KB_MBUF_COUNT           8
+#define KB_MBUF_DATA_LEN        300
+#define KB_MBUF_PULLUP_LEN      64
+
+#define KB_CALLOUT_MAX          MYNEWT_VAL(KERNBENCH_CALLOUT_MAX)
+
+#define KB_FRAG_BLOCKS          64
+
+static struct os_task kb_task;
+static struct os_task kb_helper_task;
+OS_TASK_STACK_DEFINE(kb_stack, KB_STACK_SIZE);
+OS_TASK_STACK_DEFINE(kb_helper_stack, KB_HELPER_STACK_SIZE);
+
+static struct os_eventq kb_evq;
+static struct os_eventq kb_helper_evq;
+static struct os_eventq kb_callout_evq;
+
+static struct os_sem kb_sem_a;
+static struct os_sem kb_sem_b;
+static struct os_sem kb_isr_sem;
+static struct os_mutex kb_mutex;
+static struct hal_timer kb_timer;
+
+static volatile int kb_stop;
+static struct os_event kb_helper_ev;
+static struct os_event kb_nop_ev;
+
+static os_membuf_t kb_pool_buf[OS_MEMPOOL_SIZE(KB_POOL_BLOCKS,
+                                               KB_POOL_BLOCK_SIZE)];
+static struct os_mempool kb_pool;
+
+static os_membuf_t kb_mbuf_buf[OS_MEMPOOL_SIZE(KB_MBUF_COUNT,
+                                               KB_MBUF_BLOCK_SIZE)];
+static struct os_mempool kb_mbuf_mempool;
+static struct os_mbuf_pool kb_mbuf_pool;
+static uint8_t kb_mbuf_data[KB_MBUF_DATA_LEN];
+
+static struct os_callout kb_callouts[KB_CALLOUT_MAX];
+static struct os_callout kb_probe;
+
+static void *kb_frag[KB_FRAG_BLOCKS];
+
+/* Set when a step inside a timed loop fails; reported with the result. */
+static int kb_errors;
+
+static uint8_t kb_cbmem_buf[MYNEWT_VAL(KERNBENCH_LOG_SIZE)];
+static struct cbmem kb_cbmem;
+static struct log kb_log;
+
+static uint32_t kb_run_iters;
+static struct os_event kb_run_ev;
+static volatile int kb_running;
+
+static int kb_cli(int argc, char **argv);
+
+static const struct shell_cmd kb_cmd = {
+    .sc_cmd = "kernbench",
+    .sc_cmd_func = kb_cli,
+};
+
+/*
+ * Helper task modes.  Each runs as an event callback on the helper task
+ * until kb_helper_halt() is called.
+ */
+static void
+kb_helper_ctx(struct os_event *ev)
+{
+    while (1) {
+        os_sem_pend(&kb_sem_a, OS_TIMEOUT_NEVER);
+        if (kb_stop) {
+            break;
+        }
+    }
+}
+
+static void
+kb_helper_sem(struct os_event *ev)
+{
+    while (1) {
+        os_sem_pend(&kb_sem_a, OS_TIMEOUT_NEVER);
+        if (kb_stop) {
+            break;
+        }
+        os_sem_release(&kb_sem_b);
+    }
+}
+
+static void
+kb_helper_mutex(struct os_event *ev)
+{
+    while (1) {
+        os_sem_pend(&kb_sem_a, OS_TIMEOUT_NEVER);
+        if (kb_stop) {
+            break;
+        }
+        os_mutex_pend(&kb_mutex, OS_TIMEOUT_NEVER);
+        os_mutex_release(&kb_mutex);
+        os_sem_release(&kb_sem_b);
+    }
+}
+
+static void
+kb_nop(struct os_event *ev)
+{
+}
+
+static void
+kb_helper_run(os_event_fn *fn)
+{
+    /* The helper preempts us here and runs until it blocks. */
+    kb_stop = 0;
+    kb_helper_ev.ev_cb = fn;
+    os_eventq_put(&kb_helper_evq, &kb_helper_ev);
+}
+
+static void
+kb_helper_halt(void)
+{
+    kb_stop = 1;
+    os_sem_release(&kb_sem_a);
+}
+
+static void
+kb_helper_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&kb_helper_evq);
+    }
+}
+
+static void
+kb_timer_cb(void *arg)
+{
+    os_sem_release(&kb_isr_sem);
+}
+
+static uint32_t
+kb_ticks_to_ns(uint32_t ticks)
+{
+    return (uint64_t)ticks * 1000000000 / tu_bench_clock_hz();
+}
+
+/*
+ * Prints the last result and appends it to the log as a CBOR map.
+ */
+static void
+kb_report(void)
+{
+    const struct tu_bench_result *r;
+    struct cbor_buf_writer writer;
+    CborEncoder enc;
+    CborEncoder map;
+    uint8_t buf[160];
+    CborError err;
+
+    r = tu_bench_result_get(tu_bench_result_count() - 1);
+    if (r == NULL) {
+        return;
+    }
+
+    console_printf("  %-18s %6lu %9lu %9lu %9lu %9lu %6ld %4ld %5ld%s\n",
+                   r->tbr_name, (unsigned long)r->tbr_iters,
+                   (unsigned long)kb_ticks_to_ns(r->tbr_min),
+                   (unsigned long)kb_ticks_to_ns(r->tbr_median),
+                   (unsigned long)kb_ticks_to_ns(r->tbr_p99),
+                   (unsigned long)kb_ticks_to_ns(r->tbr_max),
+                   (long)r->tbr_heap_delta, (long)r->tbr_mempool_delta,
+                   (long)r->tbr_stack_delta,
+                   kb_errors ? "  ERRORS" : "");
+
+    cbor_buf_writer_init(&writer, buf, sizeof(buf));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+
+    err = cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    err |= cbor_encode_text_stringz(&map, "name");
+    err |= cbor_encode_text_stringz(&map, r->tbr_name);
+    err |= cbor_encode_text_stringz(&map, "hz");
+    err |= cbor_encode_uint(&map, tu_bench_clock_hz());
+    err |= cbor_encode_text_stringz(&map, "iters");
+    err |= cbor_encode_uint(&map, r->tbr_iters);
+    err |= cbor_encode_text_stringz(&map, "min");
+    err |= cbor_encode_uint(&map, r->tbr_min);
+    err |= cbor_encode_text_stringz(&map, "median");
+    err |= cbor_encode_uint(&map, r->tbr_median);
+    err |= cbor_encode_text_stringz(&map, "p99");
+    err |= cbor_encode_uint(&map, r->tbr_p99);
+    err |= cbor_encode_text_stringz(&map, "max");
+    err |= cbor_encode_uint(&map, r->tbr_max);
+    err |= cbor_encode_text_stringz(&map, "heap");
+    err |= cbor_encode_int(&map, r->tbr_heap_delta);
+    err |= cbor_encode_text_stringz(&map, "mempool");
+    err |= cbor_encode_int(&map, r->tbr_mempool_delta);
+    err |= cbor_encode_text_stringz(&map, "stack");
+    err |= cbor_encode_int(&map, r->tbr_stack_delta);
+    err |= cbor_encode_text_stringz(&map, "errors");
+    err |= cbor_encode_uint(&map, kb_errors);
+    err |= cbor_encoder_close_container(&enc, &map);
+
+    if (err == CborNoError) {
+        log_append_body(&kb_log, KB_LOG_MODULE, LOG_LEVEL_INFO,
+                        LOG_ETYPE_CBOR, buf,
+                        cbor_buf_writer_buffer_size(&writer, buf));
+    }
+
+    kb_errors = 0;
+}
+
+static void
+kb_bench_sched(uint32_t iters)
+{
+    kb_helper_run(kb_helper_ctx);
+    TEST_BENCH(ctx_switch, iters) {
+        os_sem_release(&kb_sem_a);
+    }
+    kb_helper_halt();
+    kb_report();
+
+    kb_helper_run(kb_helper_sem);
+    TEST_BENCH(sem_pingpong, iters) {
+        os_sem_release(&kb_sem_a);
+        os_sem_pend(&kb_sem_b, OS_TIMEOUT_NEVER);
+    }
+    kb_helper_halt();
+    kb_report();
+
+    kb_helper_run(kb_helper_mutex);
+    TEST_BENCH(mutex_handoff, iters) {
+        os_mutex_pend(&kb_mutex, OS_TIMEOUT_NEVER);
+        os_sem_release(&kb_sem_a);
+        os_mutex_release(&kb_mutex);
+        os_sem_pend(&kb_sem_b, OS_TIMEOUT_NEVER);
+    }
+    kb_helper_halt();
+    kb_report();
+
+    TEST_BENCH(eventq_dispatch, iters) {
+        os_eventq_put(&kb_helper_evq, &kb_nop_ev);
+    }
+    kb_report();
+
+    TEST_BENCH(isr_wakeup, iters) {
+        os_cputime_timer_relative(&kb_timer, 0);
+        os_sem_pend(&kb_isr_sem, OS_TIMEOUT_NEVER);
+    }
+    kb_report();
+}
+
+static void
+kb_bench_mem(uint32_t iters)
+{
+    struct os_mbuf *om;
+    void *blk;
+
+    TEST_BENCH(memblock_get_put, iters) {
+        blk = os_memblock_get(&kb_pool);
+        if (blk == NULL) {
+            kb_errors++;
+            continue;
+        }
+        os_memblock_put(&kb_pool, blk);
+    }
+    kb_report();
+
+    TEST_BENCH(mbuf_chain, iters) {
+        om = os_mbuf_get(&kb_mbuf_pool, 0);
+        if (om == NULL) {
+            kb_errors++;
+            continue;
+        }
+        if (os_mbuf_append(om, kb_mbuf_data, KB_MBUF_DATA_LEN) != 0) {
+            kb_errors++;
+        }
+        om = os_mbuf_pullup(om, KB_MBUF_PULLUP_LEN);
+        if (om == NULL) {
+            kb_errors++;
+            continue;
+        }
+        os_mbuf_free_chain(om);
+    }
+    kb_report();
+}
+
+static const struct {
+    int n;
+    const char *reset;
+    const char *expire;
+} kb_callout_runs[] = {
+    { 1,    "callout_reset_1",    "callout_expire_1" },
+    { 10,   "callout_reset_10",   "callout_expire_10" },
+    { 100,  "callout_reset_100",  "callout_expire_100" },
+    { 1000, "callout_reset_1000", "callout_expire_1000" },
+};
+
+static void
+kb_bench_callout(uint32_t iters)
+{
+    struct os_event *ev;
+    os_time_t far;
+    int run;
+    int n;
+    int i;
+
+    far = OS_TICKS_PER_SEC * 60;
+
+    for (run = 0; run < sizeof(kb_callout_runs) / sizeof(kb_callout_runs[0]); run++) {
+        n = kb_callout_runs[run].n;
+        if (n > KB_CALLOUT_MAX) {
+            break;
+        }
+
+        /*
+         * Park n - 1 callouts a minute out, spread over a few seconds so
+         * that a sorted list has to walk them, then re-arm the probe in
+         * their midst.
+         */
+        for (i = 0; i < n - 1; i++) {
+            os_callout_reset(&kb_callouts[i], far + (i * 37) % 4096);
+        }
+        i = 0;
+        for (tu_bench_start(kb_callout_runs[run].reset, iters);
+             tu_bench_next(); ) {
+
+            os_callout_reset(&kb_probe, far + (i++ * 53) % 4096);
+        }
+        os_callout_stop(&kb_probe);
+        for (i = 0; i < n - 1; i++) {
+            os_callout_stop(&kb_callouts[i]);
+        }
+        kb_report();
+
+        /* Start on a tick boundary so every pass waits about as long. */
+        os_time_delay(1);
+        for (tu_bench_start(kb_callout_runs[run].expire,
+                            MYNEWT_VAL(KERNBENCH_EXPIRE_ITERS));
+             tu_bench_next(); ) {
+
+            for (i = 0; i < n; i++) {
+                os_callout_reset(&kb_callouts[i], 1);
+            }
+            for (i = 0; i < n; i++) {
+                ev = os_eventq_get(&kb_callout_evq);
+                if (ev == NULL) {
+                    kb_errors++;
+                }
+            }
+        }
+        kb_report();
+    }
+}
+
+static size_t
+kb_frag_size(int i)
+{
+    return 16 + (i * 37) % 240;
+}
+
+static void
+kb_bench_malloc(uint32_t iters)
+{
+    void *p;
+    int i;
+
+    i = 0;
+    TEST_BENCH(malloc_free, iters) {
+        p = os_malloc(kb_frag_size(i++));
+        if (p == NULL) {
+            kb_errors++;
+            continue;
+        }
+        os_free(p);
+    }
+    kb_report();
+
+    /* Leave every other block allocated to chop up the free list. */
+    for (i = 0; i < KB_FRAG_BLOCKS; i++) {
+        kb_frag[i] = os_malloc(kb_frag_size(i));
+    }
+    for (i = 0; i < KB_FRAG_BLOCKS; i += 2) {
+        os_free(kb_frag[i]);
+        kb_frag[i] = NULL;
+    }
+
+    i = 0;
+    TEST_BENCH(malloc_free_frag, iters) {
+        p = os_malloc(kb_frag_size(i++ * 7));
+        if (p == NULL) {
+            kb_errors++;
+            continue;
+        }
+        os_free(p);
+    }
+    kb_report();
+
+    for (i = 0; i < KB_FRAG_BLOCKS; i++) {
+        os_free(kb_frag[i]);
+        kb_frag[i] = NULL;
+    }
+}
+
+static void
+kb_run(struct os_event *ev)
+{
+    uint32_t iters;
+
+    iters = kb_run_iters;
+
+    console_printf("kernbench: %lu iterations, times in ns\n",
+                   (unsigned long)iters);
+    console_printf("  %-18s %6s %9s %9s %9s %9s %6s %4s %5s\n",
+                   "name", "iters", "min", "median", "p99", "max",
+                   "heap", "pool", "stack");
+
+    kb_bench_sched(iters);
+    kb_bench_mem(iters);
+    kb_bench_callout(iters);
+    kb_bench_malloc(iters);
+
+    console_printf("kernbench: done\n");
+    kb_running = 0;
+}
+
+static int
+kb_start(uint32_t iters)
+{
+    if (kb_running) {
+        return SYS_EBUSY;
+    }
+    kb_running = 1;
+
+    kb_run_iters = iters;
+    os_eventq_put(&kb_evq, &kb_run_ev);
+    return 0;
+}
+
+static int
+kb_cli(int argc, char **argv)
+{
+    uint32_t iters;
+    int rc;
+
+    iters = MYNEWT_VAL(KERNBENCH_DFLT_ITERS);
+    if (argc > 1) {
+        iters = parse_ull_bounds(argv[1], 1, UINT32_MAX, &rc);
+        if (rc != 0) {
+            console_printf("usage: kernbench [iters]\n");
+            return SYS_EINVAL;
+        }
+    }
+
+    rc = kb_start(iters);
+    if (rc != 0) {
+        console_printf("kernbench: already running\n");
+    }
+    return rc;
+}
+
+static void
+kb_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&kb_evq);
+    }
+}
+
+static void
+kb_init(void)
+{
+    int rc;
+    int i;
+
+    rc = cbmem_init(&kb_cbmem, kb_cbmem_buf, sizeof(kb_cbmem_buf));
+    assert(rc == 0);
+    rc = log_register("kernbench", &kb_log, &log_cbmem_handler, &kb_cbmem,
+                      LOG_SYSLEVEL);
+    assert(rc == 0);
+
+    os_eventq_init(&kb_evq);
+    os_eventq_init(&kb_helper_evq);
+    os_eventq_init(&kb_callout_evq);
+
+    os_sem_init(&kb_sem_a, 0);
+    os_sem_init(&kb_sem_b, 0);
+    os_sem_init(&kb_isr_sem, 0);
+    os_mutex_init(&kb_mutex);
+    os_cputime_timer_init(&kb_timer, kb_timer_cb, NULL);
+
+    kb_nop_ev.ev_cb = kb_nop;
+    kb_run_ev.ev_cb = kb_run;
+
+    rc = os_mempool_init(&kb_pool, KB_POOL_BLOCKS, KB_POOL_BLOCK_SIZE,
+                         kb_pool_buf, "kb_pool");
+    assert(rc == 0);
+
+    rc = os_mempool_init(&kb_mbuf_mempool, KB_MBUF_COUNT, KB_MBUF_BLOCK_SIZE,
+                         kb_mbuf_buf, "kb_mbuf");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&kb_mbuf_pool, &kb_mbuf_mempool,
+                           KB_MBUF_BLOCK_SIZE, KB_MBUF_COUNT);
+    assert(rc == 0);
+
+    for (i = 0; i < sizeof(kb_mbuf_data); i++) {
+        kb_mbuf_data[i] = i;
+    }
+
+    for (i = 0; i < KB_CALLOUT_MAX; i++) {
+        os_callout_init(&kb_callouts[i], &kb_callout_evq, kb_nop, NULL);
+    }
+    os_callout_init(&kb_probe, &kb_callout_evq, kb_nop, NULL);
+
+    os_task_init(&kb_helper_task, "kb_helper", kb_helper_handler, NULL,
+                 MYNEWT_VAL(KERNBENCH_HELPER_PRIO), OS_WAIT_FOREVER,
+                 kb_helper_stack, KB_HELPER_STACK_SIZE);
+    os_task_init(&kb_task, "kernbench", kb_handler, NULL,
+                 MYNEWT_VAL(KERNBENCH_TASK_PRIO), OS_WAIT_FOREVER,
+                 kb_stack, KB_STACK_SIZE);
+
+    rc = shell_cmd_register(&kb_cmd);
+    assert(rc == 0);
+}
+
+/**
+ * main
+ *
+ * The main task for the project. This function initializes the packages,
+ * creates the benchmark tasks, then starts serving events from default
+ * event queue.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+#ifdef ARCH_sim
+    mcu_sim_parse_args(argc, argv);
+#endif
+
+    sysinit();
+
+    kb_init();
+
+#if MYNEWT_VAL(KERNBENCH_AUTORUN)
+    kb_start(MYNEWT_VAL(KERNBENCH_DFLT_ITERS));
+#endif
+
+    /*
+     * As the last thing, process events from default event queue.
+     */
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+}
@@ -0,0 +1,1101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Soak and load generator.
+ *
+ * Puts a configurable mix of sustained load on the device and measures how
+ * it copes, to qualify a firmware build before it goes out.  Shell:
+ *
+ *   loadgen start [secs]     start a run; without secs it runs until stopped
+ *   loadgen stop
+ *   loadgen rate <gen> <n>   operations per second for one generator
+ *   loadgen                  print the results of the current or last run
+ *
+ * Generators, issued from the loadgen task every LOADGEN_TICK_MS:
+ *
+ *   nmgr     newtmgr echo requests through a loopback transport, up to
+ *            LOADGEN_NMGR_INFLIGHT outstanding; latency is request to
+ *            response and includes the newtmgr task's queueing
+ *   oic      notify the observers of "/loadgen" (LOADGEN_OIC)
+ *   log      log_printf() to the "loadgen" RAM log
+ *   conf     conf_save_one() of "loadgen/seq"
+ *   sensor   sensor_read() of LOADGEN_SENSOR_DEV (LOADGEN_SENSOR)
+ *
+ * For each generator the run records completed, failed and dropped
+ * operations, throughput and a log2 histogram of latencies in
+ * microseconds.  Alongside it records the low-water mark of every mempool
+ * (mp_min_free is reset when the run starts), the heap high-water mark and
+ * each task's share of the CPU over the run.
+ *
+ * The same results are read over newtmgr in group LOADGEN_NMGR_GROUP:
+ * command 0 returns them as a CBOR map and command 1 takes
+ * {"start": secs, "stop": true, "<gen>": rate, ...} to control a run, so a
+ * host can drive a soak and collect the numbers unattended.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "shell/shell.h"
+#include "parse/parse.h"
+#include "cbmem/cbmem.h"
+#include "log/log.h"
+#include "config/config.h"
+#include "mgmt/mgmt.h"
+#include "newtmgr/newtmgr.h"
+#include "nmgr_os/nmgr_os.h"
+#include "cborattr/cborattr.h"
+#include "tinycbor/cbor.h"
+#if MYNEWT_VAL(LOADGEN_OIC)
+#include "oic/oc_api.h"
+#endif
+#if MYNEWT_VAL(LOADGEN_SENSOR)
+#include "sensor/sensor.h"
+#endif
+
+#ifdef ARCH_sim
+#include <mcu/mcu_sim.h>
+#endif
+
+#define LG_STACK_SIZE           OS_STACK_ALIGN(512)
+
+#define LG_LOG_MODULE           (LOG_MODULE_PERUSER + 0)
+
+#define LG_HIST_BUCKETS         16
+
+/* Loopback transport never fragments; any size a response can have. */
+#define LG_NMGR_MTU             512
+
+#define LG_NMGR_ID_RESULT       0
+#define LG_NMGR_ID_CTRL         1
+
+#define LG_MAX_TASKS            MYNEWT_VAL(LOADGEN_MAX_TASKS)
+
+/*
+ * Returned by a generator whose operation completes asynchronously, and
+ * by one which has no room for another operation.  Kept clear of the OS,
+ * SYS and MGMT error codes the operations themselves return.
+ */
+#define LG_PENDING              INT_MAX
+#define LG_BUSY                 (INT_MAX - 1)
+
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+#define LG_TASK_RUNTIME(oti)    ((oti)->oti_run_cputime)
+#define LG_RUNTIME_FREQ         MYNEWT_VAL(OS_CPUTIME_FREQ)
+#else
+#define LG_TASK_RUNTIME(oti)    ((uint64_t)(oti)->oti_runtime)
+#define LG_RUNTIME_FREQ         OS_TICKS_PER_SEC
+#endif
+
+enum {
+    LG_GEN_NMGR,
+    LG_GEN_OIC,
+    LG_GEN_LOG,
+    LG_GEN_CONF,
+    LG_GEN_SENSOR,
+    LG_GEN_CNT
+};
+
+struct lg_gen {
+    const char *name;
+    /* Issues one operation; NULL if the generator is not built in. */
+    int (*op)(void);
+    /* Target operations per second. */
+    uint32_t rate;
+    /* Operations due, in thousandths. */
+    uint32_t credit;
+
+    uint32_t ok;
+    uint32_t err;
+    uint32_t drop;
+    uint32_t lat_min;
+    uint32_t lat_max;
+    uint64_t lat_sum;
+    /* Bucket 0 counts latencies below 1 us, bucket n those from 2^(n-1)
+     * up to 2^n us; the last one also takes everything longer.
+     */
+    uint32_t hist[LG_HIST_BUCKETS];
+};
+
+struct lg_task {
+    const char *name;
+    uint8_t taskid;
+    uint64_t rt_start;
+    uint64_t rt_end;
+};
+
+static int lg_nmgr_op(void);
+static int lg_log_op(void);
+static int lg_conf_op(void);
+#if MYNEWT_VAL(LOADGEN_OIC)
+static int lg_oic_op(void);
+#endif
+#if MYNEWT_VAL(LOADGEN_SENSOR)
+static int lg_sensor_op(void);
+#endif
+
+static struct lg_gen lg_gens[LG_GEN_CNT] = {
+    [LG_GEN_NMGR] = {
+        .name = "nmgr",
+        .op = lg_nmgr_op,
+        .rate = MYNEWT_VAL(LOADGEN_RATE_NMGR),
+    },
+    [LG_GEN_OIC] = {
+        .name = "oic",
+#if MYNEWT_VAL(LOADGEN_OIC)
+        .op = lg_oic_op,
+#endif
+        .rate = MYNEWT_VAL(LOADGEN_RATE_OIC),
+    },
+    [LG_GEN_LOG] = {
+        .name = "log",
+        .op = lg_log_op,
+        .rate = MYNEWT_VAL(LOADGEN_RATE_LOG),
+    },
+    [LG_GEN_CONF] = {
+        .name = "conf",
+        .op = lg_conf_op,
+        .rate = MYNEWT_VAL(LOADGEN_RATE_CONF),
+    },
+    [LG_GEN_SENSOR] = {
+        .name = "sensor",
+#if MYNEWT_VAL(LOADGEN_SENSOR)
+        .op = lg_sensor_op,
+#endif
+        .rate = MYNEWT_VAL(LOADGEN_RATE_SENSOR),
+    },
+};
+
+static struct os_task lg_task;
+OS_TASK_STACK_DEFINE(lg_stack, LG_STACK_SIZE);
+static struct os_eventq lg_evq;
+static struct os_callout lg_tick;
+static os_time_t lg_tick_ticks;
+
+static struct os_event lg_start_ev;
+static struct os_event lg_stop_ev;
+static uint32_t lg_start_secs;
+
+static volatile int lg_running;
+static os_time_t lg_start_time;
+static os_time_t lg_last_time;
+static uint32_t lg_run_ms;
+
+static struct lg_task lg_tasks[LG_MAX_TASKS];
+static int lg_task_cnt;
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+static uint32_t lg_heap_used_start;
+#endif
+
+static struct nmgr_transport lg_nmgr_transport;
+static uint32_t lg_nmgr_sent[256];
+static volatile int lg_nmgr_inflight;
+static uint8_t lg_nmgr_seq;
+
+/* {"d": "loadgen"} */
+static const uint8_t lg_nmgr_echo[] = {
+    0xa1, 0x61, 'd', 0x67, 'l', 'o', 'a', 'd', 'g', 'e', 'n',
+};
+
+static uint32_t lg_seq;
+
+static uint8_t lg_cbmem_buf[MYNEWT_VAL(LOADGEN_LOG_SIZE)];
+static struct cbmem lg_cbmem;
+static struct log lg_log;
+
+#if MYNEWT_VAL(LOADGEN_OIC)
+static oc_resource_t *lg_oic_res;
+#endif
+
+#if MYNEWT_VAL(LOADGEN_SENSOR)
+static struct sensor *lg_sensor;
+#endif
+
+static int lg_cli(int argc, char **argv);
+
+static const struct shell_cmd lg_cmd = {
+    .sc_cmd = "loadgen",
+    .sc_cmd_func = lg_cli,
+};
+
+static int lg_nmgr_result(struct mgmt_cbuf *cb);
+static int lg_nmgr_ctrl(struct mgmt_cbuf *cb);
+
+static const struct mgmt_handler lg_nmgr_handlers[] = {
+    [LG_NMGR_ID_RESULT] = { lg_nmgr_result, lg_nmgr_result },
+    [LG_NMGR_ID_CTRL] = { NULL, lg_nmgr_ctrl },
+};
+
+static struct mgmt_group lg_nmgr_group;
+
+/*
+ * Records the completion of one operation which was started at cputime
+ * 'start'.  Called from the loadgen task and, for newtmgr, the task which
+ * sends the response.
+ */
+static void
+lg_done(struct lg_gen *gen, int rc, uint32_t start)
+{
+    os_sr_t sr;
+    uint32_t us;
+    int bucket;
+
+    us = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+    if (us == 0) {
+        bucket = 0;
+    } else {
+        bucket = min(32 - __builtin_clz(us), LG_HIST_BUCKETS - 1);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (rc != 0) {
+        gen->err++;
+    } else {
+        if (gen->ok == 0 || us < gen->lat_min) {
+            gen->lat_min = us;
+        }
+        if (us > gen->lat_max) {
+            gen->lat_max = us;
+        }
+        gen->lat_sum += us;
+        gen->hist[bucket]++;
+        gen->ok++;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static uint16_t
+lg_nmgr_mtu(struct os_mbuf *m)
+{
+    return LG_NMGR_MTU;
+}
+
+/*
+ * Output of the loopback transport: every request gets exactly one
+ * response, anything but the echo's write response counts as a failure.
+ */
+static int
+lg_nmgr_out(struct nmgr_transport *nt, struct os_mbuf *m)
+{
+    struct nmgr_hdr hdr;
+    os_sr_t sr;
+    int rc;
+
+    rc = os_mbuf_copydata(m, 0, sizeof(hdr), &hdr);
+    os_mbuf_free_chain(m);
+
+    OS_ENTER_CRITICAL(sr);
+    lg_nmgr_inflight--;
+    OS_EXIT_CRITICAL(sr);
+
+    if (rc != 0) {
+        lg_done(&lg_gens[LG_GEN_NMGR], rc, 0);
+        return 0;
+    }
+
+    if (hdr.nh_op != NMGR_OP_WRITE_RSP ||
+        ntohs(hdr.nh_group) != MGMT_GROUP_ID_DEFAULT ||
+        hdr.nh_id != NMGR_ID_ECHO) {
+        rc = SYS_EUNKNOWN;
+    }
+    lg_done(&lg_gens[LG_GEN_NMGR], rc, lg_nmgr_sent[hdr.nh_seq]);
+
+    return 0;
+}
+
+static int
+lg_nmgr_op(void)
+{
+    struct nmgr_hdr hdr;
+    struct os_mbuf *m;
+    os_sr_t sr;
+    int rc;
+
+    if (lg_nmgr_inflight >= MYNEWT_VAL(LOADGEN_NMGR_INFLIGHT)) {
+        return LG_BUSY;
+    }
+
+    m = os_msys_get_pkthdr(sizeof(hdr) + sizeof(lg_nmgr_echo), 0);
+    if (m == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.nh_op = NMGR_OP_WRITE;
+    hdr.nh_len = htons(sizeof(lg_nmgr_echo));
+    hdr.nh_group = htons(MGMT_GROUP_ID_DEFAULT);
+    hdr.nh_seq = lg_nmgr_seq++;
+    hdr.nh_id = NMGR_ID_ECHO;
+
+    rc = os_mbuf_append(m, &hdr, sizeof(hdr));
+    if (rc == 0) {
+        rc = os_mbuf_append(m, lg_nmgr_echo, sizeof(lg_nmgr_echo));
+    }
+    if (rc != 0) {
+        os_mbuf_free_chain(m);
+        return SYS_ENOMEM;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    lg_nmgr_inflight++;
+    OS_EXIT_CRITICAL(sr);
+    lg_nmgr_sent[hdr.nh_seq] = os_cputime_get32();
+
+    rc = nmgr_rx_req(&lg_nmgr_transport, m);
+    if (rc != 0) {
+        OS_ENTER_CRITICAL(sr);
+        lg_nmgr_inflight--;
+        OS_EXIT_CRITICAL(sr);
+        return rc;
+    }
+
+    return LG_PENDING;
+}
+
+static int
+lg_log_op(void)
+{
+    log_printf(&lg_log, LG_LOG_MODULE, LOG_LEVEL_INFO, "loadgen %lu\n",
+               (unsigned long)lg_seq++);
+    return 0;
+}
+
+static int
+lg_conf_op(void)
+{
+    char buf[11];
+
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)lg_seq++);
+    return conf_save_one("loadgen/seq", buf);
+}
+
+#if MYNEWT_VAL(LOADGEN_OIC)
+static void
+lg_oic_get(oc_request_t *request, oc_interface_mask_t interface)
+{
+    oc_rep_start_root_object();
+    switch (interface) {
+    case OC_IF_BASELINE:
+        oc_process_baseline_interface(request->resource);
+    case OC_IF_R:
+        oc_rep_set_uint(root, seq, lg_seq);
+        break;
+    default:
+        break;
+    }
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+}
+
+static void
+lg_oic_init(void)
+{
+    oc_init_platform("MyNewt", NULL, NULL);
+    oc_add_device("/oic/d", "oic.d.loadgen", "MynewtLoadgen", "1.0", "1.0",
+                  NULL, NULL);
+
+    lg_oic_res = oc_new_resource("/loadgen", 1, 0);
+    oc_resource_bind_resource_type(lg_oic_res, "x.mynewt.loadgen");
+    oc_resource_bind_resource_interface(lg_oic_res, OC_IF_R);
+    oc_resource_set_default_interface(lg_oic_res, OC_IF_R);
+
+    oc_resource_set_discoverable(lg_oic_res);
+    oc_resource_set_observable(lg_oic_res);
+    oc_resource_set_request_handler(lg_oic_res, OC_GET, lg_oic_get);
+    oc_add_resource(lg_oic_res);
+}
+
+static const oc_handler_t lg_oc_handler = {
+    .init = lg_oic_init,
+};
+
+static int
+lg_oic_op(void)
+{
+    if (lg_oic_res == NULL) {
+        return SYS_ENOENT;
+    }
+    lg_seq++;
+    oc_notify_observers(lg_oic_res);
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(LOADGEN_SENSOR)
+static int
+lg_sensor_op(void)
+{
+    if (lg_sensor == NULL) {
+        lg_sensor = sensor_mgr_find_next_bydevname(
+          MYNEWT_VAL(LOADGEN_SENSOR_DEV), NULL);
+        if (lg_sensor == NULL) {
+            return SYS_ENOENT;
+        }
+    }
+    return sensor_read(lg_sensor, sensor_check_type(lg_sensor, SENSOR_TYPE_ALL),
+                       NULL, NULL, OS_TIMEOUT_NEVER);
+}
+#endif
+
+static void
+lg_issue(struct lg_gen *gen)
+{
+    uint32_t start;
+    int rc;
+
+    start = os_cputime_get32();
+    rc = gen->op();
+    switch (rc) {
+    case LG_PENDING:
+        break;
+    case LG_BUSY:
+        gen->drop++;
+        break;
+    default:
+        lg_done(gen, rc, start);
+        break;
+    }
+}
+
+/*
+ * Samples the run time of every task.  At the start of a run this takes
+ * the baseline, afterwards it updates the end point of the tasks in it;
+ * tasks created during the run are not tracked.
+ */
+static void
+lg_tasks_sample(int start)
+{
+    struct os_task_info oti;
+    struct os_task *t;
+    int i;
+
+    if (start) {
+        lg_task_cnt = 0;
+    }
+
+    t = NULL;
+    while (1) {
+        t = os_task_info_get_next(t, &oti);
+        if (t == NULL) {
+            break;
+        }
+
+        if (start) {
+            if (lg_task_cnt >= LG_MAX_TASKS) {
+                break;
+            }
+            lg_tasks[lg_task_cnt].name = t->t_name;
+            lg_tasks[lg_task_cnt].taskid = oti.oti_taskid;
+            lg_tasks[lg_task_cnt].rt_start = LG_TASK_RUNTIME(&oti);
+            lg_tasks[lg_task_cnt].rt_end = LG_TASK_RUNTIME(&oti);
+            lg_task_cnt++;
+            continue;
+        }
+
+        for (i = 0; i < lg_task_cnt; i++) {
+            if (lg_tasks[i].taskid == oti.oti_taskid) {
+                lg_tasks[i].rt_end = LG_TASK_RUNTIME(&oti);
+                break;
+            }
+        }
+    }
+}
+
+static uint32_t
+lg_elapsed_ms(void)
+{
+    if (lg_running) {
+        return os_time_ticks_to_ms32(os_time_get() - lg_start_time);
+    }
+    return lg_run_ms;
+}
+
+/* CPU share of a task over the run, in permille. */
+static uint32_t
+lg_task_share(const struct lg_task *lt, uint32_t ms)
+{
+    uint64_t total;
+
+    total = (uint64_t)ms * LG_RUNTIME_FREQ / 1000;
+    if (total == 0) {
+        return 0;
+    }
+    return (lt->rt_end - lt->rt_start) * 1000 / total;
+}
+
+static void
+lg_stop(struct os_event *ev)
+{
+    if (!lg_running) {
+        return;
+    }
+
+    os_callout_stop(&lg_tick);
+    lg_run_ms = os_time_ticks_to_ms32(os_time_get() - lg_start_time);
+    lg_tasks_sample(0);
+    lg_running = 0;
+
+    console_printf("loadgen: stopped after %lu ms\n",
+                   (unsigned long)lg_run_ms);
+}
+
+static void
+lg_tick_cb(struct os_event *ev)
+{
+    struct lg_gen *gen;
+    os_time_t now;
+    uint32_t ms;
+    uint32_t n;
+    int i;
+
+    now = os_time_get();
+    if (lg_start_secs != 0 &&
+        OS_TIME_TICK_GEQ(now, lg_start_time +
+                              os_time_ms_to_ticks32(lg_start_secs * 1000))) {
+        lg_stop(NULL);
+        return;
+    }
+
+    ms = os_time_ticks_to_ms32(now - lg_last_time);
+    lg_last_time = now;
+
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        gen = &lg_gens[i];
+        if (gen->op == NULL || gen->rate == 0) {
+            continue;
+        }
+
+        /* Never more than a second's worth at once, e.g. after the task
+         * was starved; those operations are lost rather than bunched up.
+         */
+        gen->credit += min(ms, 1000) * gen->rate;
+        n = gen->credit / 1000;
+        gen->credit %= 1000;
+
+        while (n-- > 0) {
+            lg_issue(gen);
+        }
+    }
+
+    os_callout_reset(&lg_tick, lg_tick_ticks);
+}
+
+static void
+lg_start(struct os_event *ev)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    struct lg_gen *gen;
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    struct os_heap_stats ohs;
+#endif
+    os_sr_t sr;
+    int i;
+
+    if (lg_running) {
+        return;
+    }
+
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        gen = &lg_gens[i];
+        OS_ENTER_CRITICAL(sr);
+        gen->credit = 0;
+        gen->ok = 0;
+        gen->err = 0;
+        gen->drop = 0;
+        gen->lat_min = 0;
+        gen->lat_max = 0;
+        gen->lat_sum = 0;
+        memset(gen->hist, 0, sizeof(gen->hist));
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    /* Low-water marks are reported for this run only. */
+    mp = NULL;
+    while (1) {
+        mp = os_mempool_info_get_next(mp, &omi);
+        if (mp == NULL) {
+            break;
+        }
+        OS_ENTER_CRITICAL(sr);
+        mp->mp_min_free = mp->mp_num_free;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    os_heap_stats_get(&ohs);
+    lg_heap_used_start = ohs.ohs_used;
+#endif
+
+    lg_tasks_sample(1);
+
+    lg_start_time = os_time_get();
+    lg_last_time = lg_start_time;
+    lg_running = 1;
+    os_callout_reset(&lg_tick, lg_tick_ticks);
+
+    if (lg_start_secs != 0) {
+        console_printf("loadgen: running for %lu s\n",
+                       (unsigned long)lg_start_secs);
+    } else {
+        console_printf("loadgen: running\n");
+    }
+}
+
+static int
+lg_req_start(uint32_t secs)
+{
+    if (lg_running) {
+        return SYS_EBUSY;
+    }
+    lg_start_secs = secs;
+    os_eventq_put(&lg_evq, &lg_start_ev);
+    return 0;
+}
+
+static void
+lg_req_stop(void)
+{
+    os_eventq_put(&lg_evq, &lg_stop_ev);
+}
+
+static struct lg_gen *
+lg_gen_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        if (!strcmp(lg_gens[i].name, name)) {
+            return &lg_gens[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t
+lg_gen_avg(const struct lg_gen *gen)
+{
+    if (gen->ok == 0) {
+        return 0;
+    }
+    return gen->lat_sum / gen->ok;
+}
+
+/* Completed operations per second, in thousandths. */
+static uint32_t
+lg_gen_tput(const struct lg_gen *gen, uint32_t ms)
+{
+    if (ms == 0) {
+        return 0;
+    }
+    return (uint64_t)gen->ok * 1000000 / ms;
+}
+
+static void
+lg_print(void)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    const struct lg_gen *gen;
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    struct os_heap_stats ohs;
+#endif
+    uint32_t tput;
+    uint32_t ms;
+    int i;
+    int j;
+
+    if (lg_running) {
+        lg_tasks_sample(0);
+    }
+    ms = lg_elapsed_ms();
+
+    console_printf("loadgen: %s, %lu ms\n", lg_running ? "running" : "idle",
+                   (unsigned long)ms);
+    console_printf("  %-7s %6s %8s %6s %6s %8s %8s %8s %8s\n",
+                   "gen", "rate", "ok", "err", "drop", "ops/s",
+                   "min(us)", "avg(us)", "max(us)");
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        gen = &lg_gens[i];
+        if (gen->op == NULL) {
+            continue;
+        }
+        tput = lg_gen_tput(gen, ms);
+        console_printf("  %-7s %6lu %8lu %6lu %6lu %4lu.%03lu %8lu %8lu "
+                       "%8lu\n",
+                       gen->name, (unsigned long)gen->rate,
+                       (unsigned long)gen->ok, (unsigned long)gen->err,
+                       (unsigned long)gen->drop,
+                       (unsigned long)(tput / 1000),
+                       (unsigned long)(tput % 1000),
+                       (unsigned long)gen->lat_min,
+                       (unsigned long)lg_gen_avg(gen),
+                       (unsigned long)gen->lat_max);
+        if (gen->ok != 0) {
+            console_printf("          hist");
+            for (j = 0; j < LG_HIST_BUCKETS; j++) {
+                console_printf(" %lu", (unsigned long)gen->hist[j]);
+            }
+            console_printf("\n");
+        }
+    }
+
+    console_printf("  %-16s %6s %8s\n", "pool", "blocks", "min_free");
+    mp = NULL;
+    while (1) {
+        mp = os_mempool_info_get_next(mp, &omi);
+        if (mp == NULL) {
+            break;
+        }
+        console_printf("  %-16s %6d %8d\n", omi.omi_name, omi.omi_num_blocks,
+                       omi.omi_min_free);
+    }
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    os_heap_stats_get(&ohs);
+    console_printf("  heap used %lu at start, %lu max, %lu now\n",
+                   (unsigned long)lg_heap_used_start,
+                   (unsigned long)ohs.ohs_used_max,
+                   (unsigned long)ohs.ohs_used);
+#endif
+
+    console_printf("  %-16s %6s\n", "task", "cpu(%)");
+    for (i = 0; i < lg_task_cnt; i++) {
+        tput = lg_task_share(&lg_tasks[i], ms);
+        console_printf("  %-16s %4lu.%lu\n", lg_tasks[i].name,
+                       (unsigned long)(tput / 10),
+                       (unsigned long)(tput % 10));
+    }
+}
+
+static int
+lg_cli(int argc, char **argv)
+{
+    struct lg_gen *gen;
+    uint32_t val;
+    int rc;
+
+    if (argc < 2) {
+        lg_print();
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "start") && argc <= 3) {
+        val = 0;
+        if (argc == 3) {
+            val = parse_ull_bounds(argv[2], 1, UINT32_MAX / 1000, &rc);
+            if (rc != 0) {
+                goto usage;
+            }
+        }
+        rc = lg_req_start(val);
+        if (rc != 0) {
+            console_printf("loadgen: already running\n");
+        }
+        return rc;
+    }
+
+    if (!strcmp(argv[1], "stop") && argc == 2) {
+        lg_req_stop();
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "rate") && argc == 4) {
+        gen = lg_gen_find(argv[2]);
+        if (gen == NULL || gen->op == NULL) {
+            console_printf("loadgen: no generator %s\n", argv[2]);
+            return SYS_ENOENT;
+        }
+        val = parse_ull_bounds(argv[3], 0, UINT32_MAX / 1000, &rc);
+        if (rc != 0) {
+            goto usage;
+        }
+        gen->rate = val;
+        return 0;
+    }
+
+usage:
+    console_printf("usage: loadgen [start [secs] | stop | "
+                   "rate <gen> <n>]\n");
+    return SYS_EINVAL;
+}
+
+static int
+lg_nmgr_result(struct mgmt_cbuf *cb)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    const struct lg_gen *gen;
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    struct os_heap_stats ohs;
+#endif
+    CborError g_err = CborNoError;
+    CborEncoder map;
+    CborEncoder sub;
+    CborEncoder arr;
+    uint32_t ms;
+    int i;
+    int j;
+
+    if (lg_running) {
+        lg_tasks_sample(0);
+    }
+    ms = lg_elapsed_ms();
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "running");
+    g_err |= cbor_encode_boolean(&cb->encoder, lg_running);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "ms");
+    g_err |= cbor_encode_uint(&cb->encoder, ms);
+
+    /* Throughput is in thousandths of an operation per second, latencies
+     * in microseconds.
+     */
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "gens");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &map, CborIndefiniteLength);
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        gen = &lg_gens[i];
+        if (gen->op == NULL) {
+            continue;
+        }
+        g_err |= cbor_encode_text_stringz(&map, gen->name);
+        g_err |= cbor_encoder_create_map(&map, &sub, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&sub, "rate");
+        g_err |= cbor_encode_uint(&sub, gen->rate);
+        g_err |= cbor_encode_text_stringz(&sub, "ok");
+        g_err |= cbor_encode_uint(&sub, gen->ok);
+        g_err |= cbor_encode_text_stringz(&sub, "err");
+        g_err |= cbor_encode_uint(&sub, gen->err);
+        g_err |= cbor_encode_text_stringz(&sub, "drop");
+        g_err |= cbor_encode_uint(&sub, gen->drop);
+        g_err |= cbor_encode_text_stringz(&sub, "tput");
+        g_err |= cbor_encode_uint(&sub, lg_gen_tput(gen, ms));
+        g_err |= cbor_encode_text_stringz(&sub, "min");
+        g_err |= cbor_encode_uint(&sub, gen->lat_min);
+        g_err |= cbor_encode_text_stringz(&sub, "avg");
+        g_err |= cbor_encode_uint(&sub, lg_gen_avg(gen));
+        g_err |= cbor_encode_text_stringz(&sub, "max");
+        g_err |= cbor_encode_uint(&sub, gen->lat_max);
+        g_err |= cbor_encode_text_stringz(&sub, "hist");
+        g_err |= cbor_encoder_create_array(&sub, &arr, LG_HIST_BUCKETS);
+        for (j = 0; j < LG_HIST_BUCKETS; j++) {
+            g_err |= cbor_encode_uint(&arr, gen->hist[j]);
+        }
+        g_err |= cbor_encoder_close_container(&sub, &arr);
+        g_err |= cbor_encoder_close_container(&map, &sub);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &map);
+
+    /* Pool name -> [blocks, min_free]. */
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "pools");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &map, CborIndefiniteLength);
+    mp = NULL;
+    while (1) {
+        mp = os_mempool_info_get_next(mp, &omi);
+        if (mp == NULL) {
+            break;
+        }
+        g_err |= cbor_encode_text_stringz(&map, omi.omi_name);
+        g_err |= cbor_encoder_create_array(&map, &arr, 2);
+        g_err |= cbor_encode_uint(&arr, omi.omi_num_blocks);
+        g_err |= cbor_encode_uint(&arr, omi.omi_min_free);
+        g_err |= cbor_encoder_close_container(&map, &arr);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &map);
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    os_heap_stats_get(&ohs);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "heap");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &map, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&map, "start");
+    g_err |= cbor_encode_uint(&map, lg_heap_used_start);
+    g_err |= cbor_encode_text_stringz(&map, "max");
+    g_err |= cbor_encode_uint(&map, ohs.ohs_used_max);
+    g_err |= cbor_encode_text_stringz(&map, "used");
+    g_err |= cbor_encode_uint(&map, ohs.ohs_used);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &map);
+#endif
+
+    /* Task name -> CPU share in permille. */
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "tasks");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &map, CborIndefiniteLength);
+    for (i = 0; i < lg_task_cnt; i++) {
+        g_err |= cbor_encode_text_stringz(&map, lg_tasks[i].name);
+        g_err |= cbor_encode_uint(&map, lg_task_share(&lg_tasks[i], ms));
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &map);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+static int
+lg_nmgr_ctrl(struct mgmt_cbuf *cb)
+{
+    unsigned long long rates[LG_GEN_CNT];
+    long long int start = -1;
+    bool stop = false;
+    struct cbor_attr_t attrs[] = {
+        { "start", CborAttrIntegerType, .addr.integer = &start,
+            .nodefault = true },
+        { "stop", CborAttrBooleanType, .addr.boolean = &stop,
+            .nodefault = true },
+        { "nmgr", CborAttrUnsignedIntegerType,
+            .addr.uinteger = &rates[LG_GEN_NMGR], .nodefault = true },
+        { "oic", CborAttrUnsignedIntegerType,
+            .addr.uinteger = &rates[LG_GEN_OIC], .nodefault = true },
+        { "log", CborAttrUnsignedIntegerType,
+            .addr.uinteger = &rates[LG_GEN_LOG], .nodefault = true },
+        { "conf", CborAttrUnsignedIntegerType,
+            .addr.uinteger = &rates[LG_GEN_CONF], .nodefault = true },
+        { "sensor", CborAttrUnsignedIntegerType,
+            .addr.uinteger = &rates[LG_GEN_SENSOR], .nodefault = true },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    int rc;
+    int i;
+
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        rates[i] = ULLONG_MAX;
+    }
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (start > (long long int)(UINT32_MAX / 1000)) {
+        return MGMT_ERR_EINVAL;
+    }
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        if (rates[i] == ULLONG_MAX) {
+            continue;
+        }
+        if (lg_gens[i].op == NULL || rates[i] > UINT32_MAX / 1000) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+
+    for (i = 0; i < LG_GEN_CNT; i++) {
+        if (rates[i] != ULLONG_MAX) {
+            lg_gens[i].rate = rates[i];
+        }
+    }
+    if (stop) {
+        lg_req_stop();
+    }
+    if (start >= 0) {
+        if (lg_req_start(start) != 0) {
+            return MGMT_ERR_EBADSTATE;
+        }
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+static void
+lg_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&lg_evq);
+    }
+}
+
+static void
+lg_init(void)
+{
+    int rc;
+
+    rc = cbmem_init(&lg_cbmem, lg_cbmem_buf, sizeof(lg_cbmem_buf));
+    assert(rc == 0);
+    rc = log_register("loadgen", &lg_log, &log_cbmem_handler, &lg_cbmem,
+                      LOG_SYSLEVEL);
+    assert(rc == 0);
+
+    rc = nmgr_transport_init(&lg_nmgr_transport, lg_nmgr_out, lg_nmgr_mtu);
+    assert(rc == 0);
+
+    MGMT_GROUP_SET_HANDLERS(&lg_nmgr_group, lg_nmgr_handlers);
+    lg_nmgr_group.mg_group_id = MYNEWT_VAL(LOADGEN_NMGR_GROUP);
+    rc = mgmt_group_register(&lg_nmgr_group);
+    assert(rc == 0);
+
+#if MYNEWT_VAL(LOADGEN_OIC)
+    oc_main_init((oc_handler_t *)&lg_oc_handler);
+#endif
+
+    lg_tick_ticks = max(os_time_ms_to_ticks32(MYNEWT_VAL(LOADGEN_TICK_MS)), 1);
+
+    os_eventq_init(&lg_evq);
+    os_callout_init(&lg_tick, &lg_evq, lg_tick_cb, NULL);
+    lg_start_ev.ev_cb = lg_start;
+    lg_stop_ev.ev_cb = lg_stop;
+
+    os_task_init(&lg_task, "loadgen", lg_handler, NULL,
+                 MYNEWT_VAL(LOADGEN_TASK_PRIO), OS_WAIT_FOREVER,
+                 lg_stack, LG_STACK_SIZE);
+
+    rc = shell_cmd_register(&lg_cmd);
+    assert(rc == 0);
+}
+
+/**
+ * main
+ *
+ * The main task for the project. This function initializes the packages,
+ * creates the load generator task, then starts serving events from default
+ * event queue.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+#ifdef ARCH_sim
+    mcu_sim_parse_args(argc, argv);
+#endif
+
+    sysinit();
+
+    lg_init();
+
+#if MYNEWT_VAL(LOADGEN_AUTORUN)
+    lg_req_start(MYNEWT_VAL(LOADGEN_AUTORUN));
+#endif
+
+    /*
+     * As the last thing, process events from default event queue.
+     */
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+}
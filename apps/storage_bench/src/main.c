@@ -0,0 +1,705 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Storage benchmark.
+ *
+ * Exposes a "storagebench" shell command:
+ *
+ *   storagebench [fcb|nffs|fatfs|config|all]
+ *
+ * Runs a fixed set of workloads over each storage backend enabled in
+ * syscfg.  Each workload is a TEST_BENCH loop, one pass per read, write or
+ * append, and prints one line:
+ *
+ *   min/median/p99/max  latency of a pass, in microseconds
+ *   KiB/s               bytes moved divided by the time spent in passes
+ *   rd/wr/er            hal_flash reads, writes and sector erases
+ *
+ * The workloads are sequential and random reads and writes, small appends,
+ * fill-rotate cycles over the whole area (the p99 and max show the
+ * garbage collection or rotation pauses), and mount time at increasing fill
+ * levels.  In sim, MCU_FLASH_SIM_TIMING charges emulated flash time to the
+ * OS clocks and the per-sector erase counts are printed after the rotate
+ * runs.
+ *
+ * The FCB and NFFS workloads wipe STORAGE_BENCH_FLASH_AREA.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "shell/shell.h"
+#include "hal/hal_bsp.h"
+#include "hal/hal_flash.h"
+#include "hal/hal_flash_int.h"
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+#include "testutil/testutil.h"
+#if MYNEWT_VAL(STORAGE_BENCH_NFFS) || MYNEWT_VAL(STORAGE_BENCH_FATFS)
+#include "fs/fs.h"
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_NFFS)
+#include "nffs/nffs.h"
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_FATFS)
+#include "disk/disk.h"
+#include "mmc/mmc.h"
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_CONFIG)
+#include "config/config.h"
+#endif
+
+#ifdef ARCH_sim
+#include <mcu/mcu_sim.h>
+#endif
+
+#define SB_CHUNK            MYNEWT_VAL(STORAGE_BENCH_CHUNK)
+#define SB_APPEND           MYNEWT_VAL(STORAGE_BENCH_APPEND)
+#define SB_MAX_SECTORS      MYNEWT_VAL(STORAGE_BENCH_MAX_SECTORS)
+#define SB_ROTATE_PASSES    MYNEWT_VAL(STORAGE_BENCH_ROTATE_PASSES)
+#define SB_MOUNT_ITERS      MYNEWT_VAL(STORAGE_BENCH_MOUNT_ITERS)
+
+#define SB_FCB_MAGIC        0x53424e43
+
+static const struct {
+    int pct;
+    const char *name;
+} sb_fill_levels[] = {
+    { 0,   "mount_0" },
+    { 25,  "mount_25" },
+    { 50,  "mount_50" },
+    { 75,  "mount_75" },
+    { 100, "mount_100" },
+};
+
+#define SB_FILL_LEVELS  (sizeof(sb_fill_levels) / sizeof(sb_fill_levels[0]))
+
+static const struct flash_area *sb_fa;
+static uint8_t sb_buf[SB_CHUNK];
+static uint32_t sb_rand_state;
+/* Set when a step inside a timed loop fails; reported with the result. */
+static int sb_errors;
+
+static int sb_cli(int argc, char **argv);
+
+static const struct shell_cmd sb_cmd = {
+    .sc_cmd = "storagebench",
+    .sc_cmd_func = sb_cli,
+};
+
+static uint32_t
+sb_rand(void)
+{
+    sb_rand_state = sb_rand_state * 1103515245 + 12345;
+    return sb_rand_state >> 8;
+}
+
+static uint32_t
+sb_ticks_to_us(uint32_t ticks)
+{
+    return (uint64_t)ticks * 1000000 / tu_bench_clock_hz();
+}
+
+static void
+sb_header(const char *backend)
+{
+    struct hal_flash_stats st;
+
+    console_printf("%s:\n", backend);
+    console_printf("  %-14s %6s %8s %8s %8s %8s %7s %6s %6s %5s\n",
+                   "workload", "passes", "min", "median", "p99", "max",
+                   "KiB/s", "rd", "wr", "er");
+
+    /* Start the flash counters from zero for the first workload. */
+    hal_flash_get_stats(sb_fa->fa_device_id, &st, 1);
+    sb_errors = 0;
+}
+
+/*
+ * Prints the last result along with the flash operations done since the
+ * previous report.
+ */
+static void
+sb_report(uint32_t bytes_per_pass)
+{
+    const struct tu_bench_result *r;
+    struct hal_flash_stats st;
+    uint32_t kbps;
+
+    r = tu_bench_result_get(tu_bench_result_count() - 1);
+    if (r == NULL) {
+        return;
+    }
+
+    memset(&st, 0, sizeof(st));
+    hal_flash_get_stats(sb_fa->fa_device_id, &st, 1);
+
+    kbps = 0;
+    if (r->tbr_total != 0) {
+        kbps = (uint64_t)bytes_per_pass * r->tbr_iters *
+               tu_bench_clock_hz() / r->tbr_total / 1024;
+    }
+
+    console_printf("  %-14s %6lu %8lu %8lu %8lu %8lu %7lu %6lu %6lu %5lu%s\n",
+                   r->tbr_name, (unsigned long)r->tbr_iters,
+                   (unsigned long)sb_ticks_to_us(r->tbr_min),
+                   (unsigned long)sb_ticks_to_us(r->tbr_median),
+                   (unsigned long)sb_ticks_to_us(r->tbr_p99),
+                   (unsigned long)sb_ticks_to_us(r->tbr_max),
+                   (unsigned long)kbps, (unsigned long)st.reads,
+                   (unsigned long)st.writes, (unsigned long)st.erases,
+                   sb_errors ? "  ERRORS" : "");
+    sb_errors = 0;
+}
+
+/*
+ * Prints how evenly the rotate runs spread erases over the area.  Only the
+ * emulated flash keeps per-sector counts.
+ */
+static void
+sb_report_wear(void)
+{
+#ifdef ARCH_sim
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    uint32_t cnt;
+    uint32_t min;
+    uint32_t max;
+    int i;
+
+    hf = hal_bsp_flash_dev(sb_fa->fa_device_id);
+    min = UINT32_MAX;
+    max = 0;
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start < sb_fa->fa_off || start >= sb_fa->fa_off + sb_fa->fa_size) {
+            continue;
+        }
+        cnt = native_flash_erase_count(i);
+        if (cnt < min) {
+            min = cnt;
+        }
+        if (cnt > max) {
+            max = cnt;
+        }
+    }
+    console_printf("  sector erases since boot: min %lu max %lu\n",
+                   (unsigned long)min, (unsigned long)max);
+#endif
+}
+
+/* Bytes the sequential and random runs cover. */
+static uint32_t
+sb_run_size(void)
+{
+    uint32_t size;
+
+    size = MYNEWT_VAL(STORAGE_BENCH_SIZE);
+    if (size > sb_fa->fa_size / 2) {
+        size = sb_fa->fa_size / 2;
+    }
+    return size - size % SB_CHUNK;
+}
+
+#if MYNEWT_VAL(STORAGE_BENCH_FCB)
+static struct flash_area sb_sectors[SB_MAX_SECTORS];
+static struct fcb sb_fcb;
+static int sb_sector_cnt;
+
+static int
+sb_fcb_init(void)
+{
+    memset(&sb_fcb, 0, sizeof(sb_fcb));
+    sb_fcb.f_magic = SB_FCB_MAGIC;
+    sb_fcb.f_version = 1;
+    sb_fcb.f_sector_cnt = sb_sector_cnt;
+    sb_fcb.f_scratch_cnt = 1;
+    sb_fcb.f_sectors = sb_sectors;
+
+    return fcb_init(&sb_fcb);
+}
+
+/*
+ * Appends one element, rotating out the oldest sector if the FCB is full.
+ */
+static int
+sb_fcb_append(uint16_t len, int rotate)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    rc = fcb_append(&sb_fcb, len, &loc);
+    if (rc == FCB_ERR_NOSPACE && rotate) {
+        rc = fcb_rotate(&sb_fcb);
+        if (rc == 0) {
+            rc = fcb_append(&sb_fcb, len, &loc);
+        }
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, sb_buf, len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return fcb_append_finish(&sb_fcb, &loc);
+}
+
+static void
+sb_fcb_run(void)
+{
+    struct fcb_entry loc;
+    uint32_t capacity;
+    uint32_t written;
+    uint32_t n;
+    uint32_t len;
+    int level;
+    int rc;
+
+    sb_sector_cnt = SB_MAX_SECTORS;
+    rc = flash_area_to_sectors(MYNEWT_VAL(STORAGE_BENCH_FLASH_AREA),
+                               &sb_sector_cnt, NULL);
+    if (rc != 0 || sb_sector_cnt < 2 || sb_sector_cnt > SB_MAX_SECTORS) {
+        console_printf("fcb: need 2..%d sectors in the flash area\n",
+                       SB_MAX_SECTORS);
+        return;
+    }
+    flash_area_to_sectors(MYNEWT_VAL(STORAGE_BENCH_FLASH_AREA),
+                          &sb_sector_cnt, sb_sectors);
+
+    sb_header("fcb");
+
+    flash_area_erase(sb_fa, 0, sb_fa->fa_size);
+    rc = sb_fcb_init();
+    if (rc != 0) {
+        console_printf("  fcb_init failed: %d\n", rc);
+        return;
+    }
+    capacity = sb_fa->fa_size - sb_sectors[0].fa_size;
+    sb_report_wear();
+
+    n = sb_run_size() / SB_CHUNK;
+    TEST_BENCH(seq_write, n) {
+        if (sb_fcb_append(SB_CHUNK, 0) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_CHUNK);
+
+    memset(&loc, 0, sizeof(loc));
+    TEST_BENCH(seq_read, n) {
+        if (fcb_getnext(&sb_fcb, &loc) != 0 ||
+            flash_area_read(loc.fe_area, loc.fe_data_off, sb_buf,
+                            loc.fe_data_len) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_CHUNK);
+
+    /* FCB has no random access; this is the raw flash underneath. */
+    TEST_BENCH(rand_read, n) {
+        if (flash_area_read(sb_fa, (sb_rand() % n) * SB_CHUNK, sb_buf,
+                            SB_CHUNK) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_CHUNK);
+
+    TEST_BENCH(small_append, n) {
+        if (sb_fcb_append(SB_APPEND, 1) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_APPEND);
+
+    TEST_BENCH(fill_rotate, SB_ROTATE_PASSES * (capacity / SB_CHUNK)) {
+        if (sb_fcb_append(SB_CHUNK, 1) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_CHUNK);
+    sb_report_wear();
+
+    for (level = 0; level < SB_FILL_LEVELS; level++) {
+        fcb_clear(&sb_fcb);
+        written = 0;
+        while (written < capacity / 100 * sb_fill_levels[level].pct) {
+            len = SB_CHUNK;
+            if (sb_fcb_append(len, 0) != 0) {
+                break;
+            }
+            written += len;
+        }
+
+        for (tu_bench_start(sb_fill_levels[level].name, SB_MOUNT_ITERS);
+             tu_bench_next(); ) {
+
+            if (sb_fcb_init() != 0) {
+                sb_errors++;
+            }
+        }
+        sb_report(0);
+    }
+}
+#endif
+
+#if MYNEWT_VAL(STORAGE_BENCH_NFFS) || MYNEWT_VAL(STORAGE_BENCH_FATFS)
+/*
+ * Writes len bytes to a new file at path.
+ */
+static int
+sb_fs_fill(const char *path, uint32_t len)
+{
+    struct fs_file *file;
+    uint32_t off;
+    int rc;
+
+    rc = fs_open(path, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    if (rc != 0) {
+        return rc;
+    }
+    for (off = 0; off < len && rc == 0; off += SB_CHUNK) {
+        rc = fs_write(file, sb_buf, SB_CHUNK);
+    }
+    fs_close(file);
+
+    return rc;
+}
+
+/*
+ * The file system workloads, on files under prefix.  capacity is roughly
+ * how much the medium holds.
+ */
+static void
+sb_fs_run(const char *prefix, uint32_t capacity)
+{
+    char path[32];
+    char path2[32];
+    struct fs_file *file;
+    uint32_t len;
+    uint32_t pos;
+    uint32_t n;
+    int rc;
+
+    snprintf(path, sizeof(path), "%s/sb_data", prefix);
+    snprintf(path2, sizeof(path2), "%s/sb_log", prefix);
+    fs_unlink(path);
+    fs_unlink(path2);
+
+    n = sb_run_size() / SB_CHUNK;
+
+    rc = fs_open(path, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    if (rc != 0) {
+        console_printf("  open %s failed: %d\n", path, rc);
+        return;
+    }
+    TEST_BENCH(seq_write, n) {
+        if (fs_write(file, sb_buf, SB_CHUNK) != 0) {
+            sb_errors++;
+        }
+    }
+    fs_close(file);
+    sb_report(SB_CHUNK);
+
+    fs_open(path, FS_ACCESS_READ, &file);
+    TEST_BENCH(seq_read, n) {
+        if (fs_read(file, SB_CHUNK, sb_buf, &len) != 0 || len != SB_CHUNK) {
+            sb_errors++;
+        }
+    }
+    sb_report(SB_CHUNK);
+
+    TEST_BENCH(rand_read, n) {
+        if (fs_seek(file, (sb_rand() % n) * SB_CHUNK) != 0 ||
+            fs_read(file, SB_CHUNK, sb_buf, &len) != 0) {
+            sb_errors++;
+        }
+    }
+    fs_close(file);
+    sb_report(SB_CHUNK);
+
+    fs_open(path, FS_ACCESS_WRITE, &file);
+    TEST_BENCH(rand_write, n) {
+        if (fs_seek(file, (sb_rand() % n) * SB_CHUNK) != 0 ||
+            fs_write(file, sb_buf, SB_CHUNK) != 0) {
+            sb_errors++;
+        }
+    }
+    fs_close(file);
+    sb_report(SB_CHUNK);
+
+    fs_open(path2, FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file);
+    TEST_BENCH(small_append, n) {
+        if (fs_write(file, sb_buf, SB_APPEND) != 0) {
+            sb_errors++;
+        }
+    }
+    fs_close(file);
+    fs_unlink(path2);
+    sb_report(SB_APPEND);
+
+    /*
+     * With the data file holding its share of the medium, keep rewriting
+     * a second file of an eighth of it.  The superseded blocks have to be
+     * reclaimed as the writes go on.
+     */
+    pos = 0;
+    file = NULL;
+    TEST_BENCH(fill_rotate, SB_ROTATE_PASSES * (capacity / SB_CHUNK)) {
+        if (pos == 0) {
+            if (fs_open(path2, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE,
+                        &file) != 0) {
+                sb_errors++;
+                continue;
+            }
+        }
+        if (fs_write(file, sb_buf, SB_CHUNK) != 0) {
+            sb_errors++;
+        }
+        pos += SB_CHUNK;
+        if (pos >= capacity / 8) {
+            fs_close(file);
+            pos = 0;
+        }
+    }
+    if (pos != 0) {
+        fs_close(file);
+    }
+    fs_unlink(path2);
+    sb_report(SB_CHUNK);
+    sb_report_wear();
+
+    fs_unlink(path);
+}
+#endif
+
+#if MYNEWT_VAL(STORAGE_BENCH_NFFS)
+static struct nffs_area_desc sb_nffs_descs[SB_MAX_SECTORS + 1];
+
+static void
+sb_nffs_run(void)
+{
+    uint32_t capacity;
+    int level;
+    int cnt;
+    int rc;
+
+    cnt = SB_MAX_SECTORS;
+    rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(STORAGE_BENCH_FLASH_AREA),
+                                        &cnt, sb_nffs_descs);
+    if (rc != 0 || cnt < 2) {
+        console_printf("nffs: need 2..%d areas in the flash area\n",
+                       SB_MAX_SECTORS);
+        return;
+    }
+    memset(&sb_nffs_descs[cnt], 0, sizeof(sb_nffs_descs[cnt]));
+
+    sb_header("nffs");
+
+    rc = nffs_format(sb_nffs_descs);
+    if (rc != 0) {
+        console_printf("  nffs_format failed: %d\n", rc);
+        return;
+    }
+
+    /* One area is kept back as scratch for garbage collection. */
+    capacity = sb_fa->fa_size - sb_nffs_descs[0].nad_length;
+    sb_fs_run("", capacity);
+
+    /* Levels are of the space left after the data file of the runs. */
+    capacity -= sb_run_size();
+    for (level = 0; level < SB_FILL_LEVELS; level++) {
+        nffs_format(sb_nffs_descs);
+        sb_fs_fill("/sb_fill", capacity / 100 * sb_fill_levels[level].pct);
+
+        for (tu_bench_start(sb_fill_levels[level].name, SB_MOUNT_ITERS);
+             tu_bench_next(); ) {
+
+            if (nffs_detect(sb_nffs_descs) != 0) {
+                sb_errors++;
+            }
+        }
+        sb_report(0);
+    }
+
+    console_printf("  the flash area now holds the nffs file system\n");
+}
+#endif
+
+#if MYNEWT_VAL(STORAGE_BENCH_FATFS)
+static int sb_mmc_ready;
+
+static void
+sb_fatfs_run(void)
+{
+    int rc;
+
+    if (!sb_mmc_ready) {
+        rc = mmc_init(MYNEWT_VAL(STORAGE_BENCH_MMC_SPI_NUM), NULL,
+                      MYNEWT_VAL(STORAGE_BENCH_MMC_SS_PIN));
+        if (rc != 0) {
+            console_printf("fatfs: mmc_init failed: %d\n", rc);
+            return;
+        }
+        rc = disk_register("mmc0", "fatfs", &mmc_ops);
+        if (rc != 0) {
+            console_printf("fatfs: disk_register failed: %d\n", rc);
+            return;
+        }
+        sb_mmc_ready = 1;
+    }
+
+    sb_header("fatfs (mmc0)");
+
+    /* The card is not on hal_flash, so rd/wr/er stay at zero. */
+    sb_fs_run("mmc0:", MYNEWT_VAL(STORAGE_BENCH_SIZE) * 4);
+}
+#endif
+
+#if MYNEWT_VAL(STORAGE_BENCH_CONFIG)
+static int
+sb_conf_set(int argc, char **argv, char *val)
+{
+    return 0;
+}
+
+static struct conf_handler sb_conf_handler = {
+    .ch_name = "sb",
+    .ch_set = sb_conf_set,
+};
+
+static void
+sb_config_run(void)
+{
+    char name[16];
+    char val[12];
+    uint32_t i;
+
+    sb_header("config");
+
+    /* Sixteen settings rewritten in turn, so the store has to compress. */
+    i = 0;
+    TEST_BENCH(save_one, sb_run_size() / SB_CHUNK * 4) {
+        snprintf(name, sizeof(name), "sb/k%d", (int)(i % 16));
+        snprintf(val, sizeof(val), "%lu", (unsigned long)i);
+        i++;
+        if (conf_save_one(name, val) != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(0);
+
+    TEST_BENCH(load, SB_MOUNT_ITERS) {
+        if (conf_load() != 0) {
+            sb_errors++;
+        }
+    }
+    sb_report(0);
+}
+#endif
+
+static int
+sb_cli(int argc, char **argv)
+{
+    const char *which;
+    int all;
+
+    which = "all";
+    if (argc > 1) {
+        which = argv[1];
+    }
+    all = !strcmp(which, "all");
+
+    sb_rand_state = 1;
+    console_printf("storagebench: %d byte chunks, %lu byte runs, "
+                   "times in us\n", SB_CHUNK, (unsigned long)sb_run_size());
+
+#if MYNEWT_VAL(STORAGE_BENCH_FCB)
+    if (all || !strcmp(which, "fcb")) {
+        sb_fcb_run();
+    }
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_NFFS)
+    if (all || !strcmp(which, "nffs")) {
+        sb_nffs_run();
+    }
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_FATFS)
+    if (all || !strcmp(which, "fatfs")) {
+        sb_fatfs_run();
+    }
+#endif
+#if MYNEWT_VAL(STORAGE_BENCH_CONFIG)
+    if (all || !strcmp(which, "config")) {
+        sb_config_run();
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * main
+ *
+ * The main task for the project. This function initializes the packages,
+ * fills the write buffer, then starts serving events from default event
+ * queue.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    int rc;
+    int i;
+
+#ifdef ARCH_sim
+    mcu_sim_parse_args(argc, argv);
+#endif
+
+    sysinit();
+
+    for (i = 0; i < sizeof(sb_buf); i++) {
+        sb_buf[i] = i * 7;
+    }
+
+    rc = flash_area_open(MYNEWT_VAL(STORAGE_BENCH_FLASH_AREA), &sb_fa);
+    assert(rc == 0);
+
+#if MYNEWT_VAL(STORAGE_BENCH_CONFIG)
+    rc = conf_register(&sb_conf_handler);
+    assert(rc == 0);
+#endif
+
+    rc = shell_cmd_register(&sb_cmd);
+    assert(rc == 0);
+
+    /*
+     * As the last thing, process events from default event queue.
+     */
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+}
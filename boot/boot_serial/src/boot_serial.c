@@ -47,7 +47,7 @@
 #error "Boot serial needs OS_CPUTIME timer"
 #endif
 
-#define BOOT_SERIAL_INPUT_MAX   512
+#define BOOT_SERIAL_INPUT_MAX   MYNEWT_VAL(BOOT_SERIAL_INPUT_MAX)
 #define BOOT_SERIAL_OUT_MAX     80
 #define BOOT_SERIAL_REPORT_DUR  \
     (MYNEWT_VAL(OS_CPUTIME_FREQ) / MYNEWT_VAL(BOOT_SERIAL_REPORT_FREQ))
@@ -55,6 +55,12 @@
 static uint32_t curr_off;
 static uint32_t img_size;
 static struct nmgr_hdr *bs_hdr;
+#if MYNEWT_VAL(BOOT_SERIAL_BINARY)
+static int bs_binary;
+#endif
+#if MYNEWT_VAL(BOOT_SERIAL_MAX_BAUD) != 0
+static uint32_t bs_new_baud;
+#endif
 
 static char bs_obuf[BOOT_SERIAL_OUT_MAX];
 
@@ -183,9 +189,10 @@ bs_upload(char *buf, int len)
     struct cbor_buf_reader reader;
     struct CborValue root_value;
     struct CborValue value;
-    uint8_t img_data[512];
+    static uint8_t img_data[BOOT_SERIAL_INPUT_MAX];
     long long int off = UINT_MAX;
     size_t img_blen = 0;
+    size_t write_len = 0;
     uint8_t rem_bytes;
     long long int data_len = UINT_MAX;
     size_t slen;
@@ -317,13 +324,20 @@ bs_upload(char *buf, int len)
             img_blen -= rem_bytes;
         }
     }
-    rc = flash_area_write(fap, curr_off, img_data, img_blen);
-    if (rc == 0) {
-        curr_off += img_blen;
-    } else {
+
+    /*
+     * Acknowledge the chunk before writing it, so the host can send the
+     * next one while flash is busy; the UART keeps receiving into the RX
+     * ring meanwhile.  If the write fails, the offset is rolled back and
+     * the host gets told to resend from there with its next chunk.
+     */
+    write_len = img_blen;
+    curr_off += write_len;
+    rc = 0;
+    goto out;
+
 out_invalid_data:
-        rc = MGMT_ERR_EINVAL;
-    }
+    rc = MGMT_ERR_EINVAL;
 
 out:
     cbor_encoder_create_map(&bs_root, &bs_rsp, CborIndefiniteLength);
@@ -336,9 +350,75 @@ out:
     cbor_encoder_close_container(&bs_root, &bs_rsp);
 
     boot_serial_output();
+
+    if (write_len != 0) {
+        rc = flash_area_write(fap, curr_off - write_len, img_data, write_len);
+        if (rc != 0) {
+            curr_off -= write_len;
+        }
+    }
     flash_area_close(fap);
 }
 
+#if MYNEWT_VAL(BOOT_SERIAL_MAX_BAUD) != 0
+/*
+ * Serial configuration request.  Switches to the requested baud rate once
+ * the response has been sent at the current one.
+ * {
+ *    "baud":<new baud rate>
+ * }
+ */
+static void
+bs_cfg(char *buf, int len)
+{
+    CborParser parser;
+    struct cbor_buf_reader reader;
+    struct CborValue root_value;
+    struct CborValue value;
+    long long int baud = 0;
+    char name_str[8];
+    size_t slen;
+    int rc;
+
+    cbor_buf_reader_init(&reader, (uint8_t *)buf, len);
+    cbor_parser_init(&reader.r, 0, &parser, &root_value);
+
+    rc = MGMT_ERR_EINVAL;
+    if (!cbor_value_is_container(&root_value) ||
+        cbor_value_enter_container(&root_value, &value)) {
+        goto out;
+    }
+    while (cbor_value_is_valid(&value)) {
+        if (!cbor_value_is_text_string(&value) ||
+            cbor_value_calculate_string_length(&value, &slen) ||
+            slen >= sizeof(name_str) - 1 ||
+            cbor_value_copy_text_string(&value, name_str, &slen, &value)) {
+            goto out;
+        }
+        name_str[slen] = '\0';
+        if (!strcmp(name_str, "baud") && value.type == CborIntegerType) {
+            if (cbor_value_get_int64(&value, &baud)) {
+                goto out;
+            }
+        }
+        if (cbor_value_advance(&value)) {
+            goto out;
+        }
+    }
+    if (baud > 0 && baud <= MYNEWT_VAL(BOOT_SERIAL_MAX_BAUD)) {
+        bs_new_baud = baud;
+        rc = 0;
+    }
+
+out:
+    cbor_encoder_create_map(&bs_root, &bs_rsp, CborIndefiniteLength);
+    cbor_encode_text_stringz(&bs_rsp, "rc");
+    cbor_encode_int(&bs_rsp, rc);
+    cbor_encoder_close_container(&bs_root, &bs_rsp);
+    boot_serial_output();
+}
+#endif
+
 /*
  * Console echo control/image erase. Send empty response, don't do anything.
  */
@@ -411,6 +491,11 @@ boot_serial_input(char *buf, int len)
         case NMGR_ID_RESET:
             bs_reset(buf, len);
             break;
+#if MYNEWT_VAL(BOOT_SERIAL_MAX_BAUD) != 0
+        case NMGR_ID_BOOT_SERIAL_CFG:
+            bs_cfg(buf, len);
+            break;
+#endif
         default:
             break;
         }
@@ -440,6 +525,20 @@ boot_serial_output(void)
     crc = crc16_ccitt(crc, data, len);
     crc = htons(crc);
 
+#if MYNEWT_VAL(BOOT_SERIAL_BINARY)
+    if (bs_binary) {
+        buf[0] = BOOT_SERIAL_BIN_START1;
+        buf[1] = BOOT_SERIAL_BIN_START2;
+        totlen = htons(len + sizeof(*bs_hdr) + sizeof(crc));
+        memcpy(&buf[2], &totlen, sizeof(totlen));
+        boot_serial_uart_write(buf, BOOT_SERIAL_BIN_HDR_SZ);
+        boot_serial_uart_write((char *)bs_hdr, sizeof(*bs_hdr));
+        boot_serial_uart_write(data, len);
+        boot_serial_uart_write((char *)&crc, sizeof(crc));
+        return;
+    }
+#endif
+
     boot_serial_uart_write(pkt_start, sizeof(pkt_start));
 
     totlen = len + sizeof(*bs_hdr) + sizeof(crc);
@@ -494,6 +593,67 @@ boot_serial_in_dec(char *in, int inlen, char *out, int *out_off, int maxout)
     return 0;
 }
 
+#if MYNEWT_VAL(BOOT_SERIAL_BINARY)
+/*
+ * Reads the remainder of a binary frame into buf.  On a complete frame with
+ * a good CRC, returns 1 and sets *off to the end of the NMP packet.
+ */
+static int
+boot_serial_in_bin(char *buf, int *off, int maxin)
+{
+    uint16_t len;
+    int need;
+    int rc;
+
+    need = BOOT_SERIAL_BIN_HDR_SZ;
+    if (*off >= BOOT_SERIAL_BIN_HDR_SZ) {
+        memcpy(&len, &buf[2], sizeof(len));
+        need += ntohs(len);
+        if (need > maxin) {
+            /* Doesn't fit; drop the frame and resynchronize. */
+            *off = 0;
+            return 0;
+        }
+    }
+
+    rc = boot_serial_uart_read_raw(buf + *off, need - *off);
+    *off += rc;
+    if (*off < need || need == BOOT_SERIAL_BIN_HDR_SZ) {
+        return 0;
+    }
+
+    len = need - BOOT_SERIAL_BIN_HDR_SZ;
+    if (len <= sizeof(uint16_t) ||
+        crc16_ccitt(CRC16_INITIAL_CRC, &buf[BOOT_SERIAL_BIN_HDR_SZ], len)) {
+        *off = 0;
+        return 0;
+    }
+    *off -= sizeof(uint16_t);
+
+    return 1;
+}
+#endif
+
+/*
+ * Applies a serial configuration change requested by the last command, now
+ * that its response has gone out.
+ */
+static void
+boot_serial_apply_cfg(void)
+{
+#if MYNEWT_VAL(BOOT_SERIAL_MAX_BAUD) != 0
+    int rc;
+
+    if (bs_new_baud) {
+        /* Let the last character leave the shift register. */
+        os_cputime_delay_usecs(2000);
+        rc = boot_serial_uart_set_speed(bs_new_baud);
+        assert(rc == 0);
+        bs_new_baud = 0;
+    }
+#endif
+}
+
 #if MYNEWT_VAL(BOOT_SERIAL_DETECT_TIMEOUT) != 0
 
 /** Don't include null-terminator in comparison. */
@@ -609,6 +769,29 @@ boot_serial_start(int max_input)
             hal_gpio_toggle(MYNEWT_VAL(BOOT_SERIAL_REPORT_PIN));
             tick = os_cputime_get32();
         }
+#endif
+#if MYNEWT_VAL(BOOT_SERIAL_BINARY)
+        if (off < 2) {
+            /* Frame type is not known yet; don't let a newline be eaten. */
+            rc = boot_serial_uart_read_raw(buf + off, 2 - off);
+            off += rc;
+            if (off > 0 && buf[off - 1] == '\n') {
+                off = 0;
+            }
+            continue;
+        }
+        if (buf[0] == BOOT_SERIAL_BIN_START1 &&
+          buf[1] == BOOT_SERIAL_BIN_START2) {
+            if (boot_serial_in_bin(buf, &off, max_input)) {
+                bs_binary = 1;
+                boot_serial_input(&buf[BOOT_SERIAL_BIN_HDR_SZ],
+                                  off - BOOT_SERIAL_BIN_HDR_SZ);
+                bs_binary = 0;
+                off = 0;
+                boot_serial_apply_cfg();
+            }
+            continue;
+        }
 #endif
         rc = boot_serial_uart_read(buf + off, max_input - off, &full_line);
         if (rc <= 0 && !full_line) {
@@ -636,6 +819,7 @@ boot_serial_start(int max_input)
             boot_serial_input(&dec[2], dec_off - 2);
         }
         off = 0;
+        boot_serial_apply_cfg();
     }
 }
 
@@ -33,6 +33,14 @@ extern "C" {
 #define SHELL_NLIP_DATA_START1  4
 #define SHELL_NLIP_DATA_START2  20
 
+/*
+ * Binary frame: start bytes, 16-bit big endian length, then the NMP packet
+ * followed by its CRC16, unencoded.
+ */
+#define BOOT_SERIAL_BIN_START1  6
+#define BOOT_SERIAL_BIN_START2  11
+#define BOOT_SERIAL_BIN_HDR_SZ  4
+
 /*
  * From newtmgr.h
  */
@@ -47,6 +55,9 @@ extern "C" {
 #define NMGR_ID_CONS_ECHO_CTRL  1
 #define NMGR_ID_RESET           5
 
+/* Only understood by the serial boot loader. */
+#define NMGR_ID_BOOT_SERIAL_CFG 32
+
 struct nmgr_hdr {
 #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
     uint8_t  nh_op:3;           /* NMGR_OP_XXX */
@@ -75,6 +86,8 @@ void boot_serial_input(char *buf, int len);
 int boot_serial_uart_open(void);
 void boot_serial_uart_close(void);
 int boot_serial_uart_read(char *str, int cnt, int *newline);
+int boot_serial_uart_read_raw(char *str, int cnt);
+int boot_serial_uart_set_speed(uint32_t speed);
 void boot_serial_uart_write(char *ptr, int cnt);
 
 #ifdef __cplusplus
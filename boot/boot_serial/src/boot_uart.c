@@ -30,9 +30,9 @@
 #define CONSOLE_TAIL_INC(cr) (((cr)->tail + 1) & (sizeof((cr)->buf) - 1))
 
 struct {
-    uint8_t head;
-    uint8_t tail;
-    uint8_t buf[16];
+    uint16_t head;
+    uint16_t tail;
+    uint8_t buf[MYNEWT_VAL(BOOT_SERIAL_RX_BUF_SZ)];
 } bs_uart_rx;
 
 struct {
@@ -41,6 +41,7 @@ struct {
 } volatile bs_uart_tx;
 
 static struct uart_dev *bs_uart;
+static uint32_t bs_uart_speed = MYNEWT_VAL(CONSOLE_UART_BAUD);
 
 static int bs_rx_char(void *arg, uint8_t byte);
 static int bs_tx_char(void *arg);
@@ -49,7 +50,7 @@ int
 boot_serial_uart_open(void)
 {
     struct uart_conf uc = {
-        .uc_speed = MYNEWT_VAL(CONSOLE_UART_BAUD),
+        .uc_speed = bs_uart_speed,
         .uc_databits = 8,
         .uc_stopbits = 1,
         .uc_parity = UART_PARITY_NONE,
@@ -75,6 +76,17 @@ boot_serial_uart_close(void)
     bs_uart_tx.cnt = 0;
 }
 
+/*
+ * Reopens the UART at a different baud rate.  Output must have drained.
+ */
+int
+boot_serial_uart_set_speed(uint32_t speed)
+{
+    boot_serial_uart_close();
+    bs_uart_speed = speed;
+    return boot_serial_uart_open();
+}
+
 static int
 bs_rx_char(void *arg, uint8_t byte)
 {
@@ -128,6 +140,29 @@ boot_serial_uart_read(char *str, int cnt, int *newline)
     return i;
 }
 
+/*
+ * Like boot_serial_uart_read(), but without newline processing.
+ */
+int
+boot_serial_uart_read_raw(char *str, int cnt)
+{
+    int i;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < cnt; i++) {
+        if (bs_uart_rx.head == bs_uart_rx.tail) {
+            break;
+        }
+        *str++ = bs_pull_char();
+    }
+    OS_EXIT_CRITICAL(sr);
+    if (i > 0) {
+        uart_start_rx(bs_uart);
+    }
+    return i;
+}
+
 static int
 bs_tx_char(void *arg)
 {
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BOOTUTIL_DELTA_
+#define H_BOOTUTIL_DELTA_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct flash_area;
+
+/*
+ * Delta images rebuild a full image from the one currently in an image slot.
+ * A delta image is a header followed by a sequence of operations, each an
+ * opcode byte followed by a LEB128 length:
+ *
+ *     COPY   <len> <src-off>  Copy len bytes of the source image at src-off.
+ *     ADD    <len> <src-off> <len bytes>
+ *                             Output source bytes at src-off plus the
+ *                             supplied bytes (mod 256), as in bsdiff.
+ *     INSERT <len> <len bytes>
+ *                             Output the supplied bytes.
+ *
+ * src-off is also LEB128 encoded.  The output is written sequentially to the
+ * destination flash area, which must be erased beforehand.  Operations may be
+ * split across any number of bootutil_delta_process() calls.
+ */
+#define BOOTUTIL_DELTA_MAGIC        0x7d5f1ad3
+
+#define BOOTUTIL_DELTA_OP_COPY      1
+#define BOOTUTIL_DELTA_OP_ADD       2
+#define BOOTUTIL_DELTA_OP_INSERT    3
+
+/** Delta image header.  All fields are in little endian byte order. */
+struct bootutil_delta_hdr {
+    uint32_t bdh_magic;
+    uint32_t bdh_src_size;      /* Size of the source image, incl. TLVs. */
+    uint32_t bdh_dst_size;      /* Size of the rebuilt image, incl. TLVs. */
+    uint8_t bdh_src_hash[32];   /* SHA256 TLV of the source image. */
+};
+
+struct bootutil_delta {
+    const struct flash_area *bd_src;
+    const struct flash_area *bd_dst;
+    struct bootutil_delta_hdr bd_hdr;
+
+    /* Offset of the next output byte not yet written to flash. */
+    uint32_t bd_dst_off;
+    uint32_t bd_src_off;
+    uint32_t bd_len;
+    uint32_t bd_varint;
+    uint8_t bd_varint_shift;
+    uint8_t bd_state;
+    uint8_t bd_op;
+
+    uint16_t bd_hdr_len;
+    uint16_t bd_buf_len;
+    uint8_t bd_buf[MYNEWT_VAL(BOOTUTIL_DELTA_BUF_SZ)];
+};
+
+/**
+ * Prepares to rebuild an image from the source area into the destination
+ * area.
+ */
+void bootutil_delta_init(struct bootutil_delta *bd,
+                         const struct flash_area *src,
+                         const struct flash_area *dst);
+
+/**
+ * Feeds the next len bytes of a delta image to the decoder.
+ *
+ * @return                      0 on success; nonzero if the delta image is
+ *                                  malformed or flash access failed.
+ */
+int bootutil_delta_process(struct bootutil_delta *bd, const void *data,
+                           uint32_t len);
+
+/**
+ * Flushes buffered output once the whole delta image has been processed.
+ *
+ * @return                      0 if a complete image of the size announced in
+ *                                  the header was written; nonzero otherwise.
+ */
+int bootutil_delta_finish(struct bootutil_delta *bd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
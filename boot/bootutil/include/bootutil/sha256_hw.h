@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BOOTUTIL_SHA256_HW_
+#define H_BOOTUTIL_SHA256_HW_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SHA-256 hooks used for image validation when BOOTUTIL_SHA256_HW is set.
+ * They are provided by a package implementing the "bootutil_sha256_hw" API,
+ * typically backed by a hash accelerator.  Only one hash is computed at a
+ * time.  Each returns 0 on success.
+ */
+int bootutil_sha256_hw_start(void);
+int bootutil_sha256_hw_update(const void *data, uint32_t len);
+int bootutil_sha256_hw_finish(uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
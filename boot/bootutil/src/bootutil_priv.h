@@ -37,7 +37,7 @@ struct flash_area;
 #define BOOT_ENOMEM     6
 #define BOOT_EBADARGS   7
 
-#define BOOT_TMPBUF_SZ  256
+#define BOOT_TMPBUF_SZ  MYNEWT_VAL(BOOTUTIL_HASH_BUF_SZ)
 
 /*
  * Maintain state of copy progress.
@@ -87,6 +87,11 @@ struct boot_swap_state {
 int bootutil_verify_sig(uint8_t *hash, uint32_t hlen, uint8_t *sig, int slen,
     uint8_t key_id);
 
+#if MYNEWT_VAL(BOOTUTIL_SIG_CACHE)
+int boot_sig_cache_lookup(uint8_t key_id, const uint8_t *hash);
+int boot_sig_cache_insert(uint8_t key_id, const uint8_t *hash);
+#endif
+
 uint32_t boot_trailer_sz(uint8_t min_write_sz);
 uint32_t boot_status_off(const struct flash_area *fap);
 int boot_read_swap_state(const struct flash_area *fap,
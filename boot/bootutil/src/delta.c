@@ -0,0 +1,329 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+#include "bootutil/delta.h"
+#include "bootutil_priv.h"
+
+#define BOOTUTIL_DELTA_STATE_HDR        0
+#define BOOTUTIL_DELTA_STATE_OP         1
+#define BOOTUTIL_DELTA_STATE_LEN        2
+#define BOOTUTIL_DELTA_STATE_SRC_OFF    3
+#define BOOTUTIL_DELTA_STATE_DATA       4
+
+void
+bootutil_delta_init(struct bootutil_delta *bd, const struct flash_area *src,
+                    const struct flash_area *dst)
+{
+    memset(bd, 0, sizeof *bd);
+    bd->bd_src = src;
+    bd->bd_dst = dst;
+    bd->bd_state = BOOTUTIL_DELTA_STATE_HDR;
+}
+
+static int
+bootutil_delta_flush(struct bootutil_delta *bd)
+{
+    int rc;
+
+    rc = flash_area_write(bd->bd_dst, bd->bd_dst_off, bd->bd_buf,
+                          bd->bd_buf_len);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    bd->bd_dst_off += bd->bd_buf_len;
+    bd->bd_buf_len = 0;
+    return 0;
+}
+
+/**
+ * Outputs n bytes of the source image starting at the current source offset.
+ * If add is non-NULL, its bytes are added to the source bytes first.
+ */
+static int
+bootutil_delta_emit_src(struct bootutil_delta *bd, const uint8_t *add,
+                        uint32_t n)
+{
+    uint32_t chunk;
+    uint32_t i;
+    uint8_t *dst;
+    int rc;
+
+    while (n > 0) {
+        chunk = sizeof bd->bd_buf - bd->bd_buf_len;
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        dst = bd->bd_buf + bd->bd_buf_len;
+        rc = flash_area_read(bd->bd_src, bd->bd_src_off, dst, chunk);
+        if (rc != 0) {
+            return BOOT_EFLASH;
+        }
+        if (add != NULL) {
+            for (i = 0; i < chunk; i++) {
+                dst[i] += add[i];
+            }
+            add += chunk;
+        }
+
+        bd->bd_buf_len += chunk;
+        bd->bd_src_off += chunk;
+        bd->bd_len -= chunk;
+        n -= chunk;
+
+        if (bd->bd_buf_len == sizeof bd->bd_buf) {
+            rc = bootutil_delta_flush(bd);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+bootutil_delta_emit_data(struct bootutil_delta *bd, const uint8_t *data,
+                         uint32_t n)
+{
+    uint32_t chunk;
+    int rc;
+
+    while (n > 0) {
+        chunk = sizeof bd->bd_buf - bd->bd_buf_len;
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        memcpy(bd->bd_buf + bd->bd_buf_len, data, chunk);
+        bd->bd_buf_len += chunk;
+        bd->bd_len -= chunk;
+        data += chunk;
+        n -= chunk;
+
+        if (bd->bd_buf_len == sizeof bd->bd_buf) {
+            rc = bootutil_delta_flush(bd);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Consumes one byte of a LEB128 value.
+ *
+ * @return                      1 if the value is complete; 0 if more bytes
+ *                                  are needed; -1 if the value overflows.
+ */
+static int
+bootutil_delta_varint(struct bootutil_delta *bd, uint8_t byte)
+{
+    if (bd->bd_varint_shift > 28) {
+        return -1;
+    }
+
+    bd->bd_varint |= (uint32_t)(byte & 0x7f) << bd->bd_varint_shift;
+    bd->bd_varint_shift += 7;
+
+    return !(byte & 0x80);
+}
+
+static int
+bootutil_delta_hdr_ok(const struct bootutil_delta *bd)
+{
+    return bd->bd_hdr.bdh_magic == BOOTUTIL_DELTA_MAGIC &&
+           bd->bd_hdr.bdh_src_size <= bd->bd_src->fa_size &&
+           bd->bd_hdr.bdh_dst_size <= bd->bd_dst->fa_size;
+}
+
+/**
+ * Indicates whether the current operation stays within the source image and
+ * the announced size of the rebuilt image.
+ */
+static int
+bootutil_delta_op_ok(const struct bootutil_delta *bd)
+{
+    uint32_t out_off;
+
+    out_off = bd->bd_dst_off + bd->bd_buf_len;
+    if (bd->bd_len > bd->bd_hdr.bdh_dst_size - out_off) {
+        return 0;
+    }
+
+    if (bd->bd_op != BOOTUTIL_DELTA_OP_INSERT) {
+        if (bd->bd_src_off > bd->bd_hdr.bdh_src_size ||
+            bd->bd_len > bd->bd_hdr.bdh_src_size - bd->bd_src_off) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int
+bootutil_delta_process(struct bootutil_delta *bd, const void *data,
+                       uint32_t len)
+{
+    const uint8_t *u8p;
+    uint32_t n;
+    int rc;
+
+    u8p = data;
+    while (len > 0) {
+        switch (bd->bd_state) {
+        case BOOTUTIL_DELTA_STATE_HDR:
+            n = sizeof bd->bd_hdr - bd->bd_hdr_len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy((uint8_t *)&bd->bd_hdr + bd->bd_hdr_len, u8p, n);
+            bd->bd_hdr_len += n;
+            u8p += n;
+            len -= n;
+
+            if (bd->bd_hdr_len == sizeof bd->bd_hdr) {
+                if (!bootutil_delta_hdr_ok(bd)) {
+                    return BOOT_EBADIMAGE;
+                }
+                bd->bd_state = BOOTUTIL_DELTA_STATE_OP;
+            }
+            break;
+
+        case BOOTUTIL_DELTA_STATE_OP:
+            bd->bd_op = *u8p++;
+            len--;
+            if (bd->bd_op < BOOTUTIL_DELTA_OP_COPY ||
+                bd->bd_op > BOOTUTIL_DELTA_OP_INSERT) {
+                return BOOT_EBADIMAGE;
+            }
+            bd->bd_varint = 0;
+            bd->bd_varint_shift = 0;
+            bd->bd_state = BOOTUTIL_DELTA_STATE_LEN;
+            break;
+
+        case BOOTUTIL_DELTA_STATE_LEN:
+            rc = bootutil_delta_varint(bd, *u8p++);
+            len--;
+            if (rc < 0) {
+                return BOOT_EBADIMAGE;
+            }
+            if (rc == 0) {
+                break;
+            }
+
+            bd->bd_len = bd->bd_varint;
+            if (bd->bd_op != BOOTUTIL_DELTA_OP_INSERT) {
+                bd->bd_varint = 0;
+                bd->bd_varint_shift = 0;
+                bd->bd_state = BOOTUTIL_DELTA_STATE_SRC_OFF;
+                break;
+            }
+
+            if (!bootutil_delta_op_ok(bd)) {
+                return BOOT_EBADIMAGE;
+            }
+            bd->bd_state = BOOTUTIL_DELTA_STATE_DATA;
+            break;
+
+        case BOOTUTIL_DELTA_STATE_SRC_OFF:
+            rc = bootutil_delta_varint(bd, *u8p++);
+            len--;
+            if (rc < 0) {
+                return BOOT_EBADIMAGE;
+            }
+            if (rc == 0) {
+                break;
+            }
+
+            bd->bd_src_off = bd->bd_varint;
+            if (!bootutil_delta_op_ok(bd)) {
+                return BOOT_EBADIMAGE;
+            }
+
+            if (bd->bd_op == BOOTUTIL_DELTA_OP_COPY) {
+                /* No payload; the copy can be carried out right away. */
+                rc = bootutil_delta_emit_src(bd, NULL, bd->bd_len);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+            bd->bd_state = BOOTUTIL_DELTA_STATE_DATA;
+            break;
+
+        case BOOTUTIL_DELTA_STATE_DATA:
+            n = bd->bd_len;
+            if (n > len) {
+                n = len;
+            }
+
+            if (bd->bd_op == BOOTUTIL_DELTA_OP_ADD) {
+                rc = bootutil_delta_emit_src(bd, u8p, n);
+            } else {
+                rc = bootutil_delta_emit_data(bd, u8p, n);
+            }
+            if (rc != 0) {
+                return rc;
+            }
+            u8p += n;
+            len -= n;
+            break;
+
+        default:
+            return BOOT_EBADARGS;
+        }
+
+        if (bd->bd_state == BOOTUTIL_DELTA_STATE_DATA && bd->bd_len == 0) {
+            bd->bd_state = BOOTUTIL_DELTA_STATE_OP;
+        }
+    }
+
+    return 0;
+}
+
+int
+bootutil_delta_finish(struct bootutil_delta *bd)
+{
+    uint8_t align;
+    uint16_t pad;
+
+    if (bd->bd_state != BOOTUTIL_DELTA_STATE_OP ||
+        bd->bd_dst_off + bd->bd_buf_len != bd->bd_hdr.bdh_dst_size) {
+        return BOOT_EBADIMAGE;
+    }
+
+    if (bd->bd_buf_len == 0) {
+        return 0;
+    }
+
+    /* Pad the final write up to the flash write size. */
+    align = flash_area_align(bd->bd_dst);
+    pad = (align - bd->bd_buf_len % align) % align;
+    memset(bd->bd_buf + bd->bd_buf_len, 0xff, pad);
+    bd->bd_buf_len += pad;
+
+    return bootutil_delta_flush(bd);
+}
@@ -135,6 +135,259 @@ tinycrypt_decode_sig(uint8_t signature[NUM_ECC_BYTES * 2], uint8_t *cp, uint8_t
     return 0;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_EC256_FAST_VERIFY)
+/*
+ * Signature check with interleaved width-w NAF scalar multiplication.
+ * u1 * G uses a width-5 window over the odd multiples of G below, which
+ * are constant and live in flash.  u2 * Q uses a width-3 window over Q
+ * and 3Q, computed per call.  Compared to uECC_verify()'s bitwise
+ * Shamir's trick this does the same number of doublings, but a little
+ * over half the point additions.
+ *
+ * Only public values are involved, so nothing here needs to be constant
+ * time.
+ */
+#define EC256_G_WINDOW      5
+#define EC256_Q_WINDOW      3
+#define EC256_NAF_LEN       (NUM_ECC_BYTES * 8 + 1)
+
+/* 1G, 3G, 5G ... 15G; x then y, as uECC native words. */
+static const uECC_word_t ec256_g_odd[8][2 * NUM_ECC_WORDS] = {
+    { /* 1G */
+        0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81,
+        0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2,
+        0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357,
+        0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2,
+    },
+    { /* 3G */
+        0xC6E7FD6C, 0xFB41661B, 0xEFADA985, 0xE6C6B721,
+        0x1D4BF165, 0xC8F7EF95, 0xA6330A44, 0x5ECBE4D1,
+        0xA27D5032, 0x9A79B127, 0x384FB83D, 0xD82AB036,
+        0x1A64A2EC, 0x374B06CE, 0x4998FF7E, 0x8734640C,
+    },
+    { /* 5G */
+        0xC3D033ED, 0x21554A0D, 0x1F5BE524, 0xEF8C82FD,
+        0x08668FDF, 0xD784C856, 0x515140D2, 0x51590B7A,
+        0xFDA16DA4, 0xD1D0BB44, 0xD4D80888, 0x0D012F00,
+        0xBF8A7926, 0x8AE1BF36, 0x904A727D, 0xE0C17DA8,
+    },
+    { /* 7G */
+        0x3187B2A3, 0x30062870, 0xA80FEF5B, 0x7EF9F8B8,
+        0x7C01FB60, 0x25BB3066, 0xA0BF7B46, 0x8E533B6F,
+        0xC1F400B4, 0xC55E1A86, 0xCB041B21, 0x53C73633,
+        0xA6F59000, 0x6D069F83, 0xE0331836, 0x73EB1DBD,
+    },
+    { /* 9G */
+        0x90949EE0, 0xD79E8A4B, 0x2C6DF8B3, 0x9E0ACB8C,
+        0x1D71F872, 0x878938D5, 0xFEDF0B71, 0xEA68D7B6,
+        0x4DD048FA, 0xE85A224A, 0xA4DE823F, 0x4D714FEA,
+        0x4A8EA0C8, 0x87014A96, 0x72C9FCE7, 0x2A2744C9,
+    },
+    { /* 11G */
+        0x74BC21D1, 0x433391D3, 0x255048BF, 0x16742ED0,
+        0xB0C21CDA, 0x0638379D, 0x883B4C59, 0x3ED113B7,
+        0xE82A3740, 0xE2F8EEFC, 0x5E9889DA, 0x090D04DA,
+        0xA4F4C68A, 0x24C843AF, 0xCCC4C8A2, 0x9099209A,
+    },
+    { /* 13G */
+        0x46072C01, 0x98E15D9D, 0x65EAD58A, 0x792E284B,
+        0xD85EE2FC, 0x61805DF2, 0xE0AC495A, 0x177C837A,
+        0xEFC7BFD8, 0x9C43BBE2, 0xA1FB4DF3, 0x26EE14C3,
+        0xB40F4E72, 0xA24091AD, 0x4EBEA558, 0x63BB58CD,
+    },
+    { /* 15G */
+        0xE59B9D5F, 0x63668C63, 0xDE3A0EF1, 0xAE03AF92,
+        0x99888265, 0xADFB3789, 0x971ABAE7, 0xF0454DC6,
+        0x0D034F36, 0x47E59CDE, 0x75B5FA3F, 0x2A3B21CE,
+        0x1F9643E6, 0x4E6594E5, 0x592E2D1F, 0xB5B93EE3,
+    },
+};
+
+/*
+ * Recode scalar into width-w NAF, least significant digit first.  Every
+ * nonzero digit is odd, smaller than 2^(w-1) in magnitude, and followed by
+ * at least w-1 zero digits.  Returns the number of digits.
+ */
+static int
+ec256_wnaf(int8_t *naf, const uECC_word_t *scalar, int w)
+{
+    uECC_word_t k[NUM_ECC_WORDS + 1];
+    uECC_word_t carry;
+    uECC_word_t t;
+    int digit;
+    int len;
+    int i;
+
+    uECC_vli_set(k, scalar, NUM_ECC_WORDS);
+    k[NUM_ECC_WORDS] = 0;
+    memset(naf, 0, EC256_NAF_LEN);
+
+    for (len = 0; !uECC_vli_isZero(k, NUM_ECC_WORDS + 1); len++) {
+        if (k[0] & 1) {
+            digit = k[0] & ((1 << w) - 1);
+            if (digit >= 1 << (w - 1)) {
+                digit -= 1 << w;
+            }
+            naf[len] = digit;
+
+            /* k -= digit; clears the low w bits. */
+            if (digit > 0) {
+                carry = digit;
+                for (i = 0; i <= NUM_ECC_WORDS && carry; i++) {
+                    t = k[i];
+                    k[i] -= carry;
+                    carry = k[i] > t;
+                }
+            } else {
+                carry = -digit;
+                for (i = 0; i <= NUM_ECC_WORDS && carry; i++) {
+                    k[i] += carry;
+                    carry = k[i] < carry;
+                }
+            }
+        }
+        for (i = 0; i < NUM_ECC_WORDS; i++) {
+            k[i] = (k[i] >> 1) | (k[i + 1] << (uECC_WORD_BITS - 1));
+        }
+        k[NUM_ECC_WORDS] >>= 1;
+    }
+    return len;
+}
+
+/*
+ * R += T, or R -= T if neg is set.  R is in Jacobian coordinates, with a Z
+ * of zero meaning the point at infinity.  T is affine.
+ */
+static void
+ec256_add(uECC_word_t *rx, uECC_word_t *ry, uECC_word_t *z,
+          const uECC_word_t *t, int neg, uECC_Curve curve)
+{
+    uECC_word_t tx[NUM_ECC_WORDS];
+    uECC_word_t ty[NUM_ECC_WORDS];
+    uECC_word_t tz[NUM_ECC_WORDS];
+
+    uECC_vli_set(tx, t, NUM_ECC_WORDS);
+    if (neg) {
+        uECC_vli_sub(ty, curve->p, t + NUM_ECC_WORDS, NUM_ECC_WORDS);
+    } else {
+        uECC_vli_set(ty, t + NUM_ECC_WORDS, NUM_ECC_WORDS);
+    }
+
+    if (uECC_vli_isZero(z, NUM_ECC_WORDS)) {
+        uECC_vli_set(rx, tx, NUM_ECC_WORDS);
+        uECC_vli_set(ry, ty, NUM_ECC_WORDS);
+        uECC_vli_clear(z, NUM_ECC_WORDS);
+        z[0] = 1;
+        return;
+    }
+
+    /* Bring T to R's Z and do a co-Z addition, as uECC_verify() does. */
+    apply_z(tx, ty, z, curve);
+    uECC_vli_modSub(tz, rx, tx, curve->p, NUM_ECC_WORDS);
+    XYcZ_add(tx, ty, rx, ry, curve);
+    uECC_vli_modMult_fast(z, z, tz, curve);
+}
+
+static int
+ec256_verify(const uint8_t *public_key, const uint8_t *hash,
+             const uint8_t *signature)
+{
+    uECC_Curve curve;
+    uECC_word_t q[2][2 * NUM_ECC_WORDS];
+    uECC_word_t r[NUM_ECC_WORDS];
+    uECC_word_t s[NUM_ECC_WORDS];
+    uECC_word_t u1[NUM_ECC_WORDS];
+    uECC_word_t u2[NUM_ECC_WORDS];
+    uECC_word_t rx[NUM_ECC_WORDS];
+    uECC_word_t ry[NUM_ECC_WORDS];
+    uECC_word_t z[NUM_ECC_WORDS];
+    uECC_word_t tz[NUM_ECC_WORDS];
+    int8_t naf1[EC256_NAF_LEN];
+    int8_t naf2[EC256_NAF_LEN];
+    int len1;
+    int len2;
+    int d;
+    int i;
+
+    curve = uECC_secp256r1();
+
+    uECC_vli_bytesToNative(r, signature, NUM_ECC_BYTES);
+    uECC_vli_bytesToNative(s, signature + NUM_ECC_BYTES, NUM_ECC_BYTES);
+
+    /* r, s must be in [1, n - 1]. */
+    if (uECC_vli_isZero(r, NUM_ECC_WORDS) ||
+        uECC_vli_isZero(s, NUM_ECC_WORDS) ||
+        uECC_vli_cmp_unsafe(curve->n, r, NUM_ECC_WORDS) != 1 ||
+        uECC_vli_cmp_unsafe(curve->n, s, NUM_ECC_WORDS) != 1) {
+        return -1;
+    }
+
+    /* u1 = e / s, u2 = r / s */
+    uECC_vli_modInv(z, s, curve->n, NUM_ECC_WORDS);
+    uECC_vli_bytesToNative(u1, hash, NUM_ECC_BYTES);
+    if (uECC_vli_cmp_unsafe(curve->n, u1, NUM_ECC_WORDS) != 1) {
+        uECC_vli_sub(u1, u1, curve->n, NUM_ECC_WORDS);
+    }
+    uECC_vli_modMult(u1, u1, z, curve->n, NUM_ECC_WORDS);
+    uECC_vli_modMult(u2, r, z, curve->n, NUM_ECC_WORDS);
+
+    /*
+     * Q and 3Q, both affine.  3Q is 2Q + Q with Q brought to 2Q's Z, then
+     * normalized.
+     */
+    uECC_vli_bytesToNative(q[0], public_key, NUM_ECC_BYTES);
+    uECC_vli_bytesToNative(q[0] + NUM_ECC_WORDS, public_key + NUM_ECC_BYTES,
+                           NUM_ECC_BYTES);
+    uECC_vli_set(rx, q[0], NUM_ECC_WORDS);
+    uECC_vli_set(ry, q[0] + NUM_ECC_WORDS, NUM_ECC_WORDS);
+    uECC_vli_clear(z, NUM_ECC_WORDS);
+    z[0] = 1;
+    curve->double_jacobian(rx, ry, z, curve);
+    uECC_vli_set(q[1], q[0], 2 * NUM_ECC_WORDS);
+    apply_z(q[1], q[1] + NUM_ECC_WORDS, z, curve);
+    uECC_vli_modSub(tz, rx, q[1], curve->p, NUM_ECC_WORDS);
+    XYcZ_add(q[1], q[1] + NUM_ECC_WORDS, rx, ry, curve);
+    uECC_vli_modMult_fast(z, z, tz, curve);
+    uECC_vli_modInv(z, z, curve->p, NUM_ECC_WORDS);
+    apply_z(rx, ry, z, curve);
+    uECC_vli_set(q[1], rx, NUM_ECC_WORDS);
+    uECC_vli_set(q[1] + NUM_ECC_WORDS, ry, NUM_ECC_WORDS);
+
+    len1 = ec256_wnaf(naf1, u1, EC256_G_WINDOW);
+    len2 = ec256_wnaf(naf2, u2, EC256_Q_WINDOW);
+
+    /* u1 * G + u2 * Q, starting from the point at infinity. */
+    uECC_vli_clear(z, NUM_ECC_WORDS);
+    for (i = (len1 > len2 ? len1 : len2) - 1; i >= 0; i--) {
+        curve->double_jacobian(rx, ry, z, curve);
+        d = naf1[i];
+        if (d) {
+            ec256_add(rx, ry, z, ec256_g_odd[(d < 0 ? -d : d) >> 1], d < 0,
+                      curve);
+        }
+        d = naf2[i];
+        if (d) {
+            ec256_add(rx, ry, z, q[(d < 0 ? -d : d) >> 1], d < 0, curve);
+        }
+    }
+    if (uECC_vli_isZero(z, NUM_ECC_WORDS)) {
+        return -1;
+    }
+
+    uECC_vli_modInv(z, z, curve->p, NUM_ECC_WORDS);
+    apply_z(rx, ry, z, curve);
+
+    /* v = x1 (mod n); accept only if v == r. */
+    if (uECC_vli_cmp_unsafe(curve->n, rx, NUM_ECC_WORDS) != 1) {
+        uECC_vli_sub(rx, rx, curve->n, NUM_ECC_WORDS);
+    }
+    if (uECC_vli_equal(rx, r, NUM_ECC_WORDS)) {
+        return -1;
+    }
+    return 0;
+}
+#endif
+
 int
 bootutil_verify_sig(uint8_t *hash, uint32_t hlen, uint8_t *sig, int slen,
   uint8_t key_id)
@@ -166,11 +419,20 @@ bootutil_verify_sig(uint8_t *hash, uint32_t hlen, uint8_t *sig, int slen,
         return -1;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_EC256_FAST_VERIFY)
+    rc = ec256_verify(public_key, hash, signature);
+    if (rc == 0) {
+        return 0;
+    } else {
+        return -2;
+    }
+#else
     rc = uECC_verify(public_key, hash, NUM_ECC_BYTES, signature, uECC_secp256r1());
     if (rc == 1) {
         return 0;
     } else {
         return -2;
     }
+#endif
 }
 #endif /* MYNEWT_VAL(BOOTUTIL_SIGN_EC256) */
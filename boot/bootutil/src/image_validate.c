@@ -34,8 +34,28 @@
 #include "mbedtls/ecdsa.h"
 #include "mbedtls/asn1.h"
 
+#if MYNEWT_VAL(BOOTUTIL_SHA256_HW)
+#include "bootutil/sha256_hw.h"
+#endif
+
 #include "bootutil_priv.h"
 
+#if MYNEWT_VAL(BOOTUTIL_SHA256_HW)
+#define BOOTUTIL_SHA256_START(ctx)                                      \
+    bootutil_sha256_hw_start()
+#define BOOTUTIL_SHA256_UPDATE(ctx, data, len)                          \
+    bootutil_sha256_hw_update((data), (len))
+#define BOOTUTIL_SHA256_FINISH(ctx, digest)                             \
+    bootutil_sha256_hw_finish(digest)
+#else
+#define BOOTUTIL_SHA256_START(ctx)                                      \
+    (mbedtls_sha256_init(ctx), mbedtls_sha256_starts((ctx), 0), 0)
+#define BOOTUTIL_SHA256_UPDATE(ctx, data, len)                          \
+    (mbedtls_sha256_update((ctx), (data), (len)), 0)
+#define BOOTUTIL_SHA256_FINISH(ctx, digest)                             \
+    (mbedtls_sha256_finish((ctx), (digest)), 0)
+#endif
+
 /*
  * Compute SHA256 over the image.
  */
@@ -44,19 +64,27 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
                   uint8_t *tmp_buf, uint32_t tmp_buf_sz,
                   uint8_t *hash_result, uint8_t *seed, int seed_len)
 {
+#if !MYNEWT_VAL(BOOTUTIL_SHA256_HW)
     mbedtls_sha256_context sha256_ctx;
+#endif
+    const void *blk;
     uint32_t blk_sz;
     uint32_t size;
     uint32_t off;
     int rc;
 
-    mbedtls_sha256_init(&sha256_ctx);
-    mbedtls_sha256_starts(&sha256_ctx, 0);
+    rc = BOOTUTIL_SHA256_START(&sha256_ctx);
+    if (rc) {
+        return rc;
+    }
 
     /* in some cases (split image) the hash is seeded with data from
      * the loader image */
     if(seed && (seed_len > 0)) {
-        mbedtls_sha256_update(&sha256_ctx, seed, seed_len);
+        rc = BOOTUTIL_SHA256_UPDATE(&sha256_ctx, seed, seed_len);
+        if (rc) {
+            return rc;
+        }
     }
 
     size = hdr->ih_img_size + hdr->ih_hdr_size;
@@ -74,15 +102,22 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
         if (blk_sz > tmp_buf_sz) {
             blk_sz = tmp_buf_sz;
         }
-        rc = flash_area_read(fap, off, tmp_buf, blk_sz);
+        /* Hash memory mapped flash in place */
+        rc = flash_area_map(fap, off, blk_sz, &blk);
+        if (rc) {
+            rc = flash_area_read(fap, off, tmp_buf, blk_sz);
+            if (rc) {
+                return rc;
+            }
+            blk = tmp_buf;
+        }
+        rc = BOOTUTIL_SHA256_UPDATE(&sha256_ctx, blk, blk_sz);
         if (rc) {
             return rc;
         }
-        mbedtls_sha256_update(&sha256_ctx, tmp_buf, blk_sz);
     }
-    mbedtls_sha256_finish(&sha256_ctx, hash_result);
 
-    return 0;
+    return BOOTUTIL_SHA256_FINISH(&sha256_ctx, hash_result);
 }
 
 /*
@@ -211,10 +246,19 @@ bootutil_img_validate(struct image_header *hdr, const struct flash_area *fap,
     if (hdr->ih_key_id >= bootutil_key_cnt) {
         return -1;
     }
+#if MYNEWT_VAL(BOOTUTIL_SIG_CACHE)
+    /* Hash matched; an image with this hash has been verified before. */
+    if (boot_sig_cache_lookup(hdr->ih_key_id, hash) == 0) {
+        return 0;
+    }
+#endif
     rc = bootutil_verify_sig(hash, sizeof(hash), buf, sig_len, hdr->ih_key_id);
     if (rc) {
         return -1;
     }
+#if MYNEWT_VAL(BOOTUTIL_SIG_CACHE)
+    boot_sig_cache_insert(hdr->ih_key_id, hash);
+#endif
 #endif
     return 0;
 }
@@ -62,6 +62,7 @@ struct boot_status_table {
     uint8_t bst_status_source;
 };
 
+#if !MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
 /**
  * This set of tables maps swap state contents to boot status location.
  * When searching for a match, these tables must be iterated in order.
@@ -134,6 +135,7 @@ static const struct boot_status_table boot_status_tables[] = {
 
 #define BOOT_STATUS_TABLES_COUNT \
     (sizeof boot_status_tables / sizeof boot_status_tables[0])
+#endif
 
 /**
  * This table indicates the next swap type that should be performed.  The first
@@ -157,6 +159,27 @@ static const uint8_t boot_swap_trans_table[][2] = {
  *
  * @return                      A BOOT_STATUS_SOURCE_[...] code indicating where *                                  status should be read from.
  */
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+static int
+boot_status_source(void)
+{
+    struct boot_swap_state state_scratch;
+    int rc;
+
+    /* A move-and-swap keeps its status in the scratch area for the whole
+     * operation.  The scratch trailer is only ever valid while a swap is in
+     * progress; it gets erased once the result has been persisted to slot 0.
+     */
+    rc = boot_read_swap_state_scratch(&state_scratch);
+    assert(rc == 0);
+
+    if (state_scratch.magic == BOOT_MAGIC_GOOD) {
+        return BOOT_STATUS_SOURCE_SCRATCH;
+    }
+
+    return BOOT_STATUS_SOURCE_NONE;
+}
+#else
 static int
 boot_status_source(void)
 {
@@ -192,6 +215,7 @@ boot_status_source(void)
 
     return BOOT_STATUS_SOURCE_NONE;
 }
+#endif
 
 /**
  * Calculates the type of swap that just completed.
@@ -305,9 +329,42 @@ boot_slots_compatible(void)
         }
     }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    /* Slot 0 gets shifted up by one sector, so every sector must be the same
+     * size.  The last two sectors are reserved for the shift and the trailer.
+     */
+    if (boot_data.imgs[0].num_sectors < 3) {
+        return 0;
+    }
+    for (i = 1; i < boot_data.imgs[0].num_sectors; i++) {
+        if (boot_data.imgs[0].sectors[i].fa_size !=
+            boot_data.imgs[0].sectors[0].fa_size) {
+            return 0;
+        }
+    }
+#endif
+
     return 1;
 }
 
+/**
+ * Indicates whether the supplied image fits in the part of a slot that gets
+ * swapped.
+ */
+static int
+boot_image_fits(const struct image_header *hdr)
+{
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    uint32_t max_sz;
+
+    max_sz = (boot_data.imgs[0].num_sectors - 2) *
+             boot_data.imgs[0].sectors[0].fa_size;
+    return IMAGE_SIZE(hdr) <= max_sz;
+#else
+    return 1;
+#endif
+}
+
 /**
  * Determines the sector layout of both image slots and the scratch area.
  * This information is necessary for calculating the number of bytes to erase
@@ -475,6 +532,12 @@ boot_write_status(struct boot_status *bs)
     uint8_t buf[8];
     uint8_t align;
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    /* Slot 0's trailer gets replaced near the end of a move-and-swap; the
+     * status lives in scratch throughout.
+     */
+    area_id = FLASH_AREA_IMAGE_SCRATCH;
+#else
     if (bs->idx == 0) {
         /* Write to scratch. */
         area_id = FLASH_AREA_IMAGE_SCRATCH;
@@ -482,6 +545,7 @@ boot_write_status(struct boot_status *bs)
         /* Write to slot 0. */
         area_id = FLASH_AREA_IMAGE_0;
     }
+#endif
 
     rc = flash_area_open(area_id, &fap);
     if (rc != 0) {
@@ -582,6 +646,7 @@ boot_validate_slot(int slot)
     }
 
     if (boot_data.imgs[slot].hdr.ih_magic != IMAGE_MAGIC ||
+        !boot_image_fits(&boot_data.imgs[slot].hdr) ||
         boot_image_check(&boot_data.imgs[slot].hdr, fap) != 0) {
 
         if (slot != 0) {
@@ -627,6 +692,7 @@ boot_validated_swap_type(void)
     return swap_type;
 }
 
+#if !MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
 /**
  * Calculates the number of sectors the scratch area can contain.  A "last"
  * source sector is specified because images are copied backwards in flash
@@ -663,6 +729,7 @@ boot_copy_sz(int last_sector_idx, int *out_first_sector_idx)
     *out_first_sector_idx = i + 1;
     return sz;
 }
+#endif
 
 /**
  * Erases a region of flash.
@@ -772,6 +839,7 @@ done:
     return rc;
 }
 
+#if !MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
 /**
  * Swaps the contents of two flash regions within the two image slots.
  *
@@ -891,6 +959,192 @@ boot_copy_image(struct boot_status *bs)
 
     return 0;
 }
+#else
+/*
+ * Move-and-swap: slot 0 is first shifted up by one sector, after which each
+ * sector can be swapped in place without going through the scratch area:
+ *
+ *     move:  slot0[n] -> slot0[n + 1], for n = N - 1 .. 0
+ *     swap:  slot1[n] -> slot0[n],
+ *            slot0[n + 1] -> slot1[n],   for n = 0 .. N - 1
+ *     trailer: slot1[last] -> slot0[last], erase slot1[last]
+ *
+ * where N is the number of sectors an image may occupy (all but the last two
+ * of a slot).  Every step erases and rewrites a single destination sector
+ * whose source is not modified until a later step, so an interrupted step can
+ * simply be repeated.  Steps are numbered consecutively and recorded in the
+ * scratch status area as (idx, state) = (step / 3, step % 3).
+ */
+
+#define BOOT_MOVE_NUM_STEPS(num_img_sectors)    (3 * (num_img_sectors) + 2)
+
+static uint32_t
+boot_move_step(const struct boot_status *bs)
+{
+    return bs->idx * BOOT_STATUS_STATE_COUNT + bs->state;
+}
+
+/**
+ * Erases the destination sector and copies a full sector into it.
+ */
+static int
+boot_move_sector(int flash_area_id_src, int flash_area_id_dst,
+                 uint32_t off_src, uint32_t off_dst, uint32_t sz)
+{
+    int rc;
+
+    rc = boot_erase_sector(flash_area_id_dst, off_dst, sz);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return boot_copy_sector(flash_area_id_src, flash_area_id_dst,
+                            off_src, off_dst, sz);
+}
+
+/**
+ * Performs a single step of a move-and-swap.
+ *
+ * @param step                  The step to perform.
+ * @param num_img_sectors       The number of sectors an image may occupy.
+ * @param sector_sz             The size of each slot sector.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+boot_move_do_step(uint32_t step, uint32_t num_img_sectors, uint32_t sector_sz)
+{
+    uint32_t off;
+    uint32_t n;
+
+    if (step < num_img_sectors) {
+        /* Shift slot 0 up by one sector, starting with the last one. */
+        off = (num_img_sectors - 1 - step) * sector_sz;
+        return boot_move_sector(FLASH_AREA_IMAGE_0, FLASH_AREA_IMAGE_0,
+                                off, off + sector_sz, sector_sz);
+    }
+
+    step -= num_img_sectors;
+    n = step / 2;
+    if (n < num_img_sectors) {
+        off = n * sector_sz;
+        if (step % 2 == 0) {
+            return boot_move_sector(FLASH_AREA_IMAGE_1, FLASH_AREA_IMAGE_0,
+                                    off, off, sector_sz);
+        } else {
+            /* The original slot0[n] now lives one sector higher. */
+            return boot_move_sector(FLASH_AREA_IMAGE_0, FLASH_AREA_IMAGE_1,
+                                    off + sector_sz, off, sector_sz);
+        }
+    }
+
+    /* Hand slot 1's trailer to slot 0, then clear slot 1's. */
+    off = (num_img_sectors + 1) * sector_sz;
+    if (step % 2 == 0) {
+        return boot_move_sector(FLASH_AREA_IMAGE_1, FLASH_AREA_IMAGE_0,
+                                off, off, sector_sz);
+    } else {
+        return boot_erase_sector(FLASH_AREA_IMAGE_1, off, sector_sz);
+    }
+}
+
+/**
+ * Marks the start of a move-and-swap by writing a fresh trailer to the
+ * scratch area.
+ */
+static int
+boot_move_start(void)
+{
+    const struct flash_area *fap;
+    int rc;
+
+    rc = boot_erase_sector(FLASH_AREA_IMAGE_SCRATCH, 0,
+                           boot_data.scratch_sector.fa_size);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    rc = boot_write_magic(fap);
+    flash_area_close(fap);
+    return rc;
+}
+
+/**
+ * Erases the move-and-swap status from the scratch area, if present.  Must
+ * only be called once the outcome of the swap has been written to slot 0.
+ */
+static int
+boot_move_clear_status(void)
+{
+    struct boot_swap_state state_scratch;
+    int rc;
+
+    rc = boot_read_swap_state_scratch(&state_scratch);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    if (state_scratch.magic == BOOT_MAGIC_UNSET) {
+        return 0;
+    }
+
+    return boot_erase_sector(FLASH_AREA_IMAGE_SCRATCH, 0,
+                             boot_data.scratch_sector.fa_size);
+}
+
+/**
+ * Swaps the two images in flash using the move-and-swap procedure.  If a
+ * prior swap was interrupted by a system reset, this function completes it.
+ *
+ * @param bs                    The current boot status.  This function reads
+ *                                  this struct to determine if it is resuming
+ *                                  an interrupted swap operation.  This
+ *                                  function writes the updated status to this
+ *                                  function on return.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+boot_copy_image(struct boot_status *bs)
+{
+    uint32_t sector_sz;
+    uint32_t step;
+    int num_img_sectors;
+    int rc;
+
+    num_img_sectors = boot_data.imgs[0].num_sectors - 2;
+    sector_sz = boot_data.imgs[0].sectors[0].fa_size;
+
+    step = boot_move_step(bs);
+    if (step == 0) {
+        rc = boot_move_start();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    for (; step < BOOT_MOVE_NUM_STEPS(num_img_sectors); step++) {
+        /* Pet the watchdog, in case it is still enabled after a soft reset. */
+        hal_watchdog_tickle();
+
+        rc = boot_move_do_step(step, num_img_sectors, sector_sz);
+        if (rc != 0) {
+            return rc;
+        }
+
+        bs->idx = (step + 1) / BOOT_STATUS_STATE_COUNT;
+        bs->state = (step + 1) % BOOT_STATUS_STATE_COUNT;
+        (void)boot_write_status(bs);
+    }
+
+    return 0;
+}
+#endif
 
 /**
  * Marks a test image in slot 0 as fully copied.
@@ -1094,6 +1348,11 @@ boot_go(struct boot_rsp *rsp)
         break;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    /* The outcome is now recorded in slot 0; drop the swap status. */
+    boot_move_clear_status();
+#endif
+
     /* Always boot from the primary slot. */
     rsp->br_flash_id = boot_data.imgs[0].sectors[0].fa_device_id;
     rsp->br_image_addr = boot_data.imgs[0].sectors[0].fa_off;
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Cache of image hashes whose signature has already been checked.
+ *
+ * Each entry records a key id and the SHA-256 of an image which verified
+ * against that key.  An image which hashes to a cached value, and whose
+ * hash TLV matches, needs no signature check; the image still gets hashed
+ * every time, only the public key operation is skipped.
+ *
+ * Entries are appended to the flash area until it is full, then the area
+ * is erased and filling starts over.  A few entries are enough to cover
+ * both slots across swaps and reverts.
+ *
+ * Anyone able to write the area can make any image pass, so it must be
+ * somewhere the application cannot write.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(BOOTUTIL_SIG_CACHE)
+#include "flash_map/flash_map.h"
+#include "bootutil_priv.h"
+
+#define BOOT_SIG_CACHE_MAGIC    0x5ca1ab1e
+
+struct boot_sig_cache_entry {
+    uint32_t bsc_magic;
+    uint8_t bsc_key_id;
+    uint8_t bsc_pad[3];
+    uint8_t bsc_hash[32];
+};
+
+static uint32_t
+boot_sig_cache_stride(const struct flash_area *fap)
+{
+    uint32_t align;
+
+    align = flash_area_align(fap);
+    return (sizeof(struct boot_sig_cache_entry) + align - 1) / align * align;
+}
+
+/*
+ * Scan the cache for key_id/hash.  Returns 0 if found.  Otherwise returns
+ * BOOT_EBADIMAGE, and sets *free_off to the offset of the first unused
+ * entry, or fa_size if the area is full.
+ */
+static int
+boot_sig_cache_find(const struct flash_area *fap, uint8_t key_id,
+                    const uint8_t *hash, uint32_t *free_off)
+{
+    struct boot_sig_cache_entry ent;
+    uint32_t stride;
+    uint32_t off;
+
+    stride = boot_sig_cache_stride(fap);
+    for (off = 0; off + stride <= fap->fa_size; off += stride) {
+        if (flash_area_read(fap, off, &ent, sizeof(ent))) {
+            break;
+        }
+        if (ent.bsc_magic != BOOT_SIG_CACHE_MAGIC) {
+            break;
+        }
+        if (ent.bsc_key_id == key_id &&
+            !memcmp(ent.bsc_hash, hash, sizeof(ent.bsc_hash))) {
+            return 0;
+        }
+    }
+    if (off + stride > fap->fa_size) {
+        off = fap->fa_size;
+    }
+    *free_off = off;
+    return BOOT_EBADIMAGE;
+}
+
+int
+boot_sig_cache_lookup(uint8_t key_id, const uint8_t *hash)
+{
+    const struct flash_area *fap;
+    uint32_t off;
+    int rc;
+
+    if (flash_area_open(MYNEWT_VAL(BOOTUTIL_SIG_CACHE_FLASH_AREA), &fap)) {
+        return BOOT_EFLASH;
+    }
+    rc = boot_sig_cache_find(fap, key_id, hash, &off);
+    flash_area_close(fap);
+
+    return rc;
+}
+
+int
+boot_sig_cache_insert(uint8_t key_id, const uint8_t *hash)
+{
+    const struct flash_area *fap;
+    struct boot_sig_cache_entry ent;
+    uint8_t buf[sizeof(ent) + 16];
+    uint32_t stride;
+    uint32_t off;
+    int rc;
+
+    if (flash_area_open(MYNEWT_VAL(BOOTUTIL_SIG_CACHE_FLASH_AREA), &fap)) {
+        return BOOT_EFLASH;
+    }
+    stride = boot_sig_cache_stride(fap);
+    if (stride > sizeof(buf)) {
+        rc = BOOT_EFLASH;
+        goto out;
+    }
+
+    if (boot_sig_cache_find(fap, key_id, hash, &off) == 0) {
+        rc = 0;
+        goto out;
+    }
+    if (off + stride > fap->fa_size) {
+        if (flash_area_erase(fap, 0, fap->fa_size)) {
+            rc = BOOT_EFLASH;
+            goto out;
+        }
+        off = 0;
+    }
+
+    memset(&ent, 0, sizeof(ent));
+    ent.bsc_magic = BOOT_SIG_CACHE_MAGIC;
+    ent.bsc_key_id = key_id;
+    memcpy(ent.bsc_hash, hash, sizeof(ent.bsc_hash));
+    memset(buf, 0xff, stride);
+    memcpy(buf, &ent, sizeof(ent));
+
+    rc = flash_area_write(fap, off, buf, stride) ? BOOT_EFLASH : 0;
+out:
+    flash_area_close(fap);
+    return rc;
+}
+#endif /* MYNEWT_VAL(BOOTUTIL_SIG_CACHE) */
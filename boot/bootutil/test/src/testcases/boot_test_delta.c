@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "boot_test.h"
+#include "bootutil/delta.h"
+
+static int
+boot_test_delta_put_varint(uint8_t *dst, uint32_t val)
+{
+    int len;
+
+    len = 0;
+    do {
+        dst[len] = val & 0x7f;
+        val >>= 7;
+        if (val != 0) {
+            dst[len] |= 0x80;
+        }
+        len++;
+    } while (val != 0);
+
+    return len;
+}
+
+TEST_CASE(boot_test_delta)
+{
+    struct image_header hdr = {
+        .ih_magic = IMAGE_MAGIC,
+        .ih_tlv_size = 4 + 32,
+        .ih_hdr_size = BOOT_TEST_HEADER_SIZE,
+        .ih_img_size = 12 * 1024,
+        .ih_flags = IMAGE_F_SHA256,
+        .ih_ver = { 0, 2, 3, 4 },
+    };
+    struct bootutil_delta_hdr dhdr = {
+        .bdh_magic = BOOTUTIL_DELTA_MAGIC,
+        .bdh_src_size = BOOT_TEST_HEADER_SIZE + 12 * 1024,
+    };
+    const struct flash_area *fap_src;
+    const struct flash_area *fap_dst;
+    struct bootutil_delta bd;
+    static uint8_t patch[4096];
+    static uint8_t expected[8192];
+    uint8_t buf[256];
+    uint32_t patch_len;
+    uint32_t exp_len;
+    uint32_t off;
+    uint32_t n;
+    int rc;
+    int i;
+
+    boot_test_util_init_flash();
+    boot_test_util_write_image(&hdr, 0);
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap_src);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_open(FLASH_AREA_IMAGE_1, &fap_dst);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    patch_len = sizeof dhdr;
+    exp_len = 0;
+
+    /* Reuse 3000 bytes of the old image. */
+    patch[patch_len++] = BOOTUTIL_DELTA_OP_COPY;
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 3000);
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 100);
+    rc = flash_area_read(fap_src, 100, expected, 3000);
+    TEST_ASSERT_FATAL(rc == 0);
+    exp_len += 3000;
+
+    /* New code. */
+    patch[patch_len++] = BOOTUTIL_DELTA_OP_INSERT;
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 333);
+    for (i = 0; i < 333; i++) {
+        patch[patch_len] = i ^ 0x5a;
+        expected[exp_len++] = patch[patch_len++];
+    }
+
+    /* Old code with relocated addresses. */
+    patch[patch_len++] = BOOTUTIL_DELTA_OP_ADD;
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 2000);
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 5000);
+    rc = flash_area_read(fap_src, 5000, expected + exp_len, 2000);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < 2000; i++) {
+        patch[patch_len] = i % 4 == 0 ? 0x10 : 0;
+        expected[exp_len++] += patch[patch_len++];
+    }
+
+    dhdr.bdh_dst_size = exp_len;
+    memcpy(patch, &dhdr, sizeof dhdr);
+
+    /* Feed the patch in odd-sized chunks to exercise split operations. */
+    bootutil_delta_init(&bd, fap_src, fap_dst);
+    for (off = 0; off < patch_len; off += n) {
+        n = patch_len - off;
+        if (n > 37) {
+            n = 37;
+        }
+        rc = bootutil_delta_process(&bd, patch + off, n);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = bootutil_delta_finish(&bd);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (off = 0; off < exp_len; off += n) {
+        n = exp_len - off;
+        if (n > sizeof buf) {
+            n = sizeof buf;
+        }
+        rc = flash_area_read(fap_dst, off, buf, n);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(memcmp(buf, expected + off, n) == 0);
+    }
+
+    /* A truncated patch must not be accepted. */
+    flash_area_erase(fap_dst, 0, fap_dst->fa_size);
+    bootutil_delta_init(&bd, fap_src, fap_dst);
+    rc = bootutil_delta_process(&bd, patch, patch_len - 1);
+    TEST_ASSERT(rc == 0);
+    rc = bootutil_delta_finish(&bd);
+    TEST_ASSERT(rc != 0);
+
+    /* Nor one that reads past the end of the old image. */
+    flash_area_erase(fap_dst, 0, fap_dst->fa_size);
+    patch_len = sizeof dhdr;
+    patch[patch_len++] = BOOTUTIL_DELTA_OP_COPY;
+    patch_len += boot_test_delta_put_varint(patch + patch_len, 16);
+    patch_len += boot_test_delta_put_varint(patch + patch_len,
+                                            dhdr.bdh_src_size - 8);
+    bootutil_delta_init(&bd, fap_src, fap_dst);
+    rc = bootutil_delta_process(&bd, patch, patch_len);
+    TEST_ASSERT(rc != 0);
+}
@@ -209,6 +209,14 @@ extern "C" {
 #undef MBEDTLS_CCM_C
 #endif
 
+/*
+ * Hook called by mbedtls_internal_aes_encrypt() before the software rounds;
+ * returns 0 if the block was encrypted in hardware.
+ */
+#if MYNEWT_VAL(MBEDTLS_AES_HW)
+#define MBEDTLS_AES_ENCRYPT_HW          mbedtls_mynewt_aes_hw_encrypt
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -757,6 +757,12 @@ exit:
 /*
  * AES-ECB block encryption
  */
+#if defined(MBEDTLS_AES_ENCRYPT_HW)
+int MBEDTLS_AES_ENCRYPT_HW( const mbedtls_aes_context *ctx,
+                            const unsigned char input[16],
+                            unsigned char output[16] );
+#endif
+
 #if !defined(MBEDTLS_AES_ENCRYPT_ALT)
 int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
                                   const unsigned char input[16],
@@ -765,6 +771,12 @@ int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+#if defined(MBEDTLS_AES_ENCRYPT_HW)
+    /* Mynewt: hand the block to the crypto engine, software if it declines */
+    if( MBEDTLS_AES_ENCRYPT_HW( ctx, input, output ) == 0 )
+        return( 0 );
+#endif
+
     RK = ctx->rk;
 
     GET_UINT32_LE( X0, input,  0 ); X0 ^= *RK++;
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(MBEDTLS_AES_HW)
+
+#include <string.h>
+#include "mbedtls/aes.h"
+#include "crypto/crypto.h"
+
+static struct crypto_dev *mbedtls_mynewt_crypto;
+
+/*
+ * Encrypts one block on the crypto device. Only AES-128 is offloaded; the
+ * key is recovered from the first four round key words, which
+ * mbedtls_aes_setkey_enc() fills with the key in little-endian order.
+ *
+ * Returns 0 on success, non-zero if mbedtls should do the block in
+ * software.
+ */
+int
+mbedtls_mynewt_aes_hw_encrypt(const mbedtls_aes_context *ctx,
+                              const unsigned char input[16],
+                              unsigned char output[16])
+{
+    uint8_t key[CRYPTO_AES128_KEY_LEN];
+    uint32_t rk;
+    int rc;
+    int i;
+
+    if (ctx->nr != 10) {
+        return -1;
+    }
+
+    if (mbedtls_mynewt_crypto == NULL) {
+        mbedtls_mynewt_crypto = (struct crypto_dev *)os_dev_open(
+            MYNEWT_VAL(MBEDTLS_AES_HW_DEV), 0, NULL);
+        if (mbedtls_mynewt_crypto == NULL) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        rk = ctx->rk[i];
+        key[4 * i] = rk;
+        key[4 * i + 1] = rk >> 8;
+        key[4 * i + 2] = rk >> 16;
+        key[4 * i + 3] = rk >> 24;
+    }
+
+    rc = crypto_aes_ecb_encrypt(mbedtls_mynewt_crypto, key, input, output);
+    memset(key, 0, sizeof(key));
+
+    return rc;
+}
+
+#endif
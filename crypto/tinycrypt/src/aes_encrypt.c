@@ -155,6 +155,11 @@ static inline void shift_rows(uint8_t *s)
 	(void) _copy(s, sizeof(t), t, sizeof(t));
 }
 
+#if defined(TC_AES_ENCRYPT_HW)
+int TC_AES_ENCRYPT_HW(uint8_t *out, const uint8_t *in,
+		      const TCAesKeySched_t s);
+#endif
+
 int tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 {
 	uint8_t state[Nk*Nb];
@@ -168,6 +173,13 @@ int tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 		return TC_CRYPTO_FAIL;
 	}
 
+#if defined(TC_AES_ENCRYPT_HW)
+	/* Mynewt: crypto engine first, software if it declines the block */
+	if (TC_AES_ENCRYPT_HW(out, in, s) == 0) {
+		return TC_CRYPTO_SUCCESS;
+	}
+#endif
+
 	(void)_copy(state, sizeof(state), in, sizeof(state));
 	add_round_key(state, s->words);
 
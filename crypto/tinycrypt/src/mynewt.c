@@ -50,3 +50,49 @@ mynewt_tinycrypt_pkg_init(void)
 }
 
 #endif
+
+#if MYNEWT_VAL(TINYCRYPT_AES_HW)
+
+#include <string.h>
+#include "tinycrypt/aes.h"
+#include "crypto/crypto.h"
+
+static struct crypto_dev *g_tc_crypto;
+
+/*
+ * Encrypts one block on the crypto device. The AES-128 key is recovered
+ * from the first Nk words of the key schedule, which
+ * tc_aes128_set_encrypt_key() fills with the key itself.
+ *
+ * Returns 0 on success, non-zero if the caller should fall back to software.
+ */
+int
+mynewt_tc_aes_hw_encrypt(uint8_t *out, const uint8_t *in,
+                         const TCAesKeySched_t s)
+{
+    uint8_t key[CRYPTO_AES128_KEY_LEN];
+    int rc;
+    int i;
+
+    if (g_tc_crypto == NULL) {
+        g_tc_crypto = (struct crypto_dev *)os_dev_open(
+            MYNEWT_VAL(TINYCRYPT_AES_HW_DEV), 0, NULL);
+        if (g_tc_crypto == NULL) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < Nk; i++) {
+        key[4 * i] = s->words[i] >> 24;
+        key[4 * i + 1] = s->words[i] >> 16;
+        key[4 * i + 2] = s->words[i] >> 8;
+        key[4 * i + 3] = s->words[i];
+    }
+
+    rc = crypto_aes_ecb_encrypt(g_tc_crypto, key, in, out);
+    memset(key, 0, sizeof(key));
+
+    return rc;
+}
+
+#endif
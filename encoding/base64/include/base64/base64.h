@@ -31,6 +31,24 @@ int base64_decode(const char *, void *buf);
 int base64_pad(char *, int);
 int base64_decode_len(const char *str);
 
+/*
+ * Incremental decoder, for input which arrives in pieces.
+ */
+struct base64_decoder {
+    uint32_t bd_acc;    /* sextets of the group being assembled */
+    uint8_t bd_cnt;     /* number of characters in bd_acc */
+    uint8_t bd_pad;     /* number of '=' seen in the group */
+};
+
+void base64_decoder_init(struct base64_decoder *bd);
+int base64_decoder_feed(struct base64_decoder *bd, const char *src,
+                        int *src_len, void *dst, int dst_len);
+int base64_decoder_finish(struct base64_decoder *bd);
+
+struct os_mbuf;
+int base64_decoder_feed_mbuf(struct base64_decoder *bd, const char *src,
+                             int src_len, struct os_mbuf *om);
+
 #define BASE64_ENCODE_SIZE(__size) (((((__size) - 1) / 3) * 4) + 4)
 
 #ifdef __cplusplus
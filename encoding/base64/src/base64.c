@@ -48,57 +48,81 @@
 static const char base64_chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static int
-pos(char c)
+#define BASE64_DEC_PAD      0x40
+#define BASE64_DEC_INVALID  0x80
+
+/*
+ * Sextet value of each ASCII character. '=' maps to BASE64_DEC_PAD and
+ * everything else that is not part of the alphabet to BASE64_DEC_INVALID,
+ * so OR-ing the values of a 4 character group and testing the top two
+ * bits tells whether the group can take the fast path.
+ */
+static const uint8_t base64_dec_tbl[128] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
+    0x3c, 0x3d, 0x80, 0x80, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
+    0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
+    0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+static inline uint8_t
+base64_dec(uint8_t c)
 {
-    const char *p;
-    for (p = base64_chars; *p; p++)
-        if (*p == c)
-            return p - base64_chars;
-    return -1;
+    if (c & 0x80) {
+        return BASE64_DEC_INVALID;
+    }
+    return base64_dec_tbl[c];
 }
 
 int
 base64_encode(const void *data, int size, char *s, uint8_t should_pad)
 {
-    char *p;
-    int i;
-    int c;
     const unsigned char *q;
-    char *last;
+    uint32_t c;
+    char *p;
     int diff;
+    int i;
 
     p = s;
-
     q = (const unsigned char *) data;
-    last = NULL;
-    i = 0;
-    while (i < size) {
-        c = q[i++];
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        p[0] = base64_chars[(c & 0x00fc0000) >> 18];
-        p[1] = base64_chars[(c & 0x0003f000) >> 12];
-        p[2] = base64_chars[(c & 0x00000fc0) >> 6];
-        p[3] = base64_chars[(c & 0x0000003f) >> 0];
-        last = p;
+
+    /* whole 3 byte groups */
+    for (i = 0; i + 3 <= size; i += 3) {
+        c = (q[i] << 16) | (q[i + 1] << 8) | q[i + 2];
+        p[0] = base64_chars[(c >> 18) & 0x3f];
+        p[1] = base64_chars[(c >> 12) & 0x3f];
+        p[2] = base64_chars[(c >> 6) & 0x3f];
+        p[3] = base64_chars[c & 0x3f];
         p += 4;
     }
 
-    if (last) {
-        diff = i - size;
-        if (diff > 0) {
-            if (should_pad) {
-                memset(last + (4 - diff), '=', diff);
-            } else {
-                p = last + (4 - diff);
-            }
+    /* 1 or 2 trailing bytes */
+    diff = size - i;
+    if (diff > 0) {
+        c = q[i] << 16;
+        if (diff > 1) {
+            c |= q[i + 1] << 8;
+        }
+        p[0] = base64_chars[(c >> 18) & 0x3f];
+        p[1] = base64_chars[(c >> 12) & 0x3f];
+        p[2] = base64_chars[(c >> 6) & 0x3f];
+        diff = 3 - diff;
+        if (should_pad) {
+            memset(p + (4 - diff), '=', diff);
+            p += 4;
+        } else {
+            p += 4 - diff;
         }
     }
 
@@ -122,47 +146,83 @@ base64_pad(char *buf, int len)
     return (4 - remainder);
 }
 
-#define DECODE_ERROR -1
-
-static unsigned int
-token_decode(const char *token)
+/*
+ * Decodes a group containing padding. Returns the number of bytes
+ * written, or -1 if the group is malformed.
+ */
+static int
+token_decode(const uint8_t *token, uint8_t *q)
 {
+    uint32_t val;
+    uint8_t v;
+    int marker;
     int i;
-    unsigned int val = 0;
-    int marker = 0;
-    if (strlen(token) < 4)
-        return DECODE_ERROR;
+
+    val = 0;
+    marker = 0;
     for (i = 0; i < 4; i++) {
-        val *= 64;
-        if (token[i] == '=')
+        v = base64_dec(token[i]);
+        val <<= 6;
+        if (v == BASE64_DEC_PAD) {
             marker++;
-        else if (marker > 0)
-            return DECODE_ERROR;
-        else
-            val += pos(token[i]);
+        } else if (marker > 0 || v == BASE64_DEC_INVALID) {
+            return -1;
+        } else {
+            val |= v;
+        }
     }
-    if (marker > 2)
-        return DECODE_ERROR;
-    return (marker << 24) | val;
+    if (marker > 2) {
+        return -1;
+    }
+    q[0] = val >> 16;
+    if (marker < 2) {
+        q[1] = val >> 8;
+    }
+    if (marker < 1) {
+        q[2] = val;
+    }
+    return 3 - marker;
 }
 
+/*
+ * Decodes str into data, stopping at the first character which is not part
+ * of the base64 alphabet. Decoding in place (data == str) is allowed.
+ */
 int
 base64_decode(const char *str, void *data)
 {
-    const char *p;
-    unsigned char *q;
+    const uint8_t *p;
+    const uint8_t *end;
+    uint8_t *q;
+    uint32_t val;
+    uint8_t a, b, c, d;
+    int rc;
 
     q = data;
-    for (p = str; *p && (*p == '=' || strchr(base64_chars, *p)); p += 4) {
-        unsigned int val = token_decode(p);
-        unsigned int marker = (val >> 24) & 0xff;
-        if (val == DECODE_ERROR)
+    p = (const uint8_t *)str;
+    end = p + strlen(str);
+    while (p < end && base64_dec(*p) != BASE64_DEC_INVALID) {
+        if (end - p < 4) {
             return -1;
-        *q++ = (val >> 16) & 0xff;
-        if (marker < 2)
-            *q++ = (val >> 8) & 0xff;
-        if (marker < 1)
-            *q++ = val & 0xff;
+        }
+        a = base64_dec(p[0]);
+        b = base64_dec(p[1]);
+        c = base64_dec(p[2]);
+        d = base64_dec(p[3]);
+        if ((a | b | c | d) & (BASE64_DEC_PAD | BASE64_DEC_INVALID)) {
+            rc = token_decode(p, q);
+            if (rc < 0) {
+                return -1;
+            }
+            q += rc;
+        } else {
+            val = (a << 18) | (b << 12) | (c << 6) | d;
+            q[0] = val >> 16;
+            q[1] = val >> 8;
+            q[2] = val;
+            q += 3;
+        }
+        p += 4;
     }
     return q - (unsigned char *) data;
 }
@@ -179,3 +239,123 @@ base64_decode_len(const char *str)
     }
     return len * 3 / 4;
 }
+
+void
+base64_decoder_init(struct base64_decoder *bd)
+{
+    memset(bd, 0, sizeof(*bd));
+}
+
+/*
+ * Decodes the next chunk of a base64 stream. The chunk does not need to
+ * end on a group boundary; a partial group is kept in the decoder until
+ * the rest of it arrives.
+ *
+ * @param bd            Decoder state
+ * @param src           Input characters
+ * @param src_len       In: number of input characters.
+ *                      Out: number of characters consumed. This is less
+ *                      than what was passed in if dst filled up.
+ * @param dst           Where to write decoded bytes
+ * @param dst_len       Space at dst
+ *
+ * @return              Number of bytes written; -1 on malformed input.
+ */
+int
+base64_decoder_feed(struct base64_decoder *bd, const char *src, int *src_len,
+                    void *dst, int dst_len)
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    uint8_t *q;
+    uint8_t *qend;
+    uint32_t val;
+    uint8_t a, b, c, d;
+    uint8_t pad;
+    uint8_t v;
+    int out;
+
+    p = (const uint8_t *)src;
+    end = p + *src_len;
+    q = dst;
+    qend = q + dst_len;
+
+    while (p < end) {
+        if (bd->bd_cnt == 0) {
+            /* whole groups straight from the input */
+            while (end - p >= 4 && qend - q >= 3) {
+                a = base64_dec(p[0]);
+                b = base64_dec(p[1]);
+                c = base64_dec(p[2]);
+                d = base64_dec(p[3]);
+                if ((a | b | c | d) & (BASE64_DEC_PAD | BASE64_DEC_INVALID)) {
+                    break;
+                }
+                val = (a << 18) | (b << 12) | (c << 6) | d;
+                q[0] = val >> 16;
+                q[1] = val >> 8;
+                q[2] = val;
+                q += 3;
+                p += 4;
+            }
+            if (p == end) {
+                break;
+            }
+        }
+
+        v = base64_dec(*p);
+        if (v == BASE64_DEC_INVALID) {
+            return -1;
+        }
+        pad = bd->bd_pad;
+        if (v == BASE64_DEC_PAD) {
+            if (bd->bd_cnt < 2) {
+                return -1;
+            }
+            pad++;
+            v = 0;
+        } else if (pad) {
+            return -1;
+        }
+
+        if (bd->bd_cnt < 3) {
+            bd->bd_acc = (bd->bd_acc << 6) | v;
+            bd->bd_cnt++;
+            bd->bd_pad = pad;
+        } else {
+            out = 3 - pad;
+            if (qend - q < out) {
+                break;
+            }
+            val = (bd->bd_acc << 6) | v;
+            q[0] = val >> 16;
+            if (out > 1) {
+                q[1] = val >> 8;
+            }
+            if (out > 2) {
+                q[2] = val;
+            }
+            q += out;
+            bd->bd_acc = 0;
+            bd->bd_cnt = 0;
+            bd->bd_pad = 0;
+        }
+        p++;
+    }
+
+    *src_len = p - (const uint8_t *)src;
+    return q - (uint8_t *)dst;
+}
+
+/*
+ * Returns 0 if the input fed so far ended on a group boundary, -1 if
+ * a partial group is pending.
+ */
+int
+base64_decoder_finish(struct base64_decoder *bd)
+{
+    if (bd->bd_cnt) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+#include <base64/base64.h>
+
+/*
+ * Decodes a chunk of base64 input and appends the result to om. Bytes are
+ * decoded directly into the trailing space of the last mbuf in the chain;
+ * more mbufs are taken from the pool of om as needed.
+ *
+ * @return              Number of bytes appended; -1 on malformed input or
+ *                      if mbufs ran out. On error, the chain may already
+ *                      have had part of the data appended.
+ */
+int
+base64_decoder_feed_mbuf(struct base64_decoder *bd, const char *src,
+                         int src_len, struct os_mbuf *om)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *new;
+    int consumed;
+    int space;
+    int total;
+    int rc;
+
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
+    total = 0;
+    while (src_len > 0) {
+        /* a group decodes to at most 3 bytes */
+        space = OS_MBUF_TRAILINGSPACE(last);
+        if (space < 3) {
+            new = os_mbuf_get(om->om_omp, 0);
+            if (new == NULL) {
+                return -1;
+            }
+            SLIST_INSERT_AFTER(last, new, om_next);
+            last = new;
+            space = OS_MBUF_TRAILINGSPACE(last);
+        }
+
+        consumed = src_len;
+        rc = base64_decoder_feed(bd, src, &consumed,
+                                 OS_MBUF_DATA(last, uint8_t *) + last->om_len,
+                                 space);
+        if (rc < 0) {
+            return -1;
+        }
+        last->om_len += rc;
+        if (OS_MBUF_IS_PKTHDR(om)) {
+            OS_MBUF_PKTHDR(om)->omp_len += rc;
+        }
+        total += rc;
+        src += consumed;
+        src_len -= consumed;
+    }
+    return total;
+}
@@ -18,7 +18,6 @@
  */
 
 #include <inttypes.h>
-#include <ctype.h>
 #include <stddef.h>
 
 #include "base64/hex.h"
@@ -65,12 +64,28 @@ hex_format(void *src_v, int src_len, char *dst, int dst_len)
  *
  * @return		-1 on failure; number of bytes of input
  */
+static inline int
+hex_nibble(char c)
+{
+    uint8_t v;
+
+    v = c - '0';
+    if (v < 10) {
+        return v;
+    }
+    v = (c | 0x20) - 'a';
+    if (v < 6) {
+        return v + 10;
+    }
+    return -1;
+}
+
 int
 hex_parse(const char *src, int src_len, void *dst_v, int dst_len)
 {
     int i;
     uint8_t *dst = (uint8_t *)dst_v;
-    char c;
+    int hi, lo;
 
     if (src_len & 0x1) {
         return -1;
@@ -78,24 +93,13 @@ hex_parse(const char *src, int src_len, void *dst_v, int dst_len)
     if (dst_len * 2 < src_len) {
         return -1;
     }
-    for (i = 0; i < src_len; i++, src++) {
-        c = *src;
-        if (isdigit((int) c)) {
-            c -= '0';
-        } else if (c >= 'a' && c <= 'f') {
-            c -= ('a' - 10);
-        } else if (c >= 'A' && c <= 'F') {
-            c -= ('A' - 10);
-        } else {
+    for (i = 0; i < src_len; i += 2) {
+        hi = hex_nibble(src[i]);
+        lo = hex_nibble(src[i + 1]);
+        if ((hi | lo) < 0) {
             return -1;
         }
-        if (i & 1) {
-            *dst |= c;
-            dst++;
-            dst_len--;
-        } else {
-            *dst = c << 4;
-        }
+        *dst++ = (hi << 4) | lo;
     }
     return src_len >> 1;
 }
@@ -24,6 +24,7 @@
 
 TEST_CASE_DECL(hex2str)
 TEST_CASE_DECL(str2hex)
+TEST_CASE_DECL(base64_codec)
 
 int
 hex_fmt_test_all(void)
@@ -36,6 +37,7 @@ TEST_SUITE(hex_fmt_test_suite)
 {
     hex2str();
     str2hex();
+    base64_codec();
 }
 
 #if MYNEWT_VAL(SELFTEST)
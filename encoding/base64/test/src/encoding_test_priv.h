@@ -22,6 +22,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include "os/mynewt.h"
+#include "base64/base64.h"
 #include "base64/hex.h"
 #include "testutil/testutil.h"
 
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "encoding_test_priv.h"
+
+#define TEST_MBUF_BLOCK_SIZE    64
+#define TEST_MBUF_BLOCK_COUNT   8
+
+static os_membuf_t test_mbuf_mem[
+    OS_MEMPOOL_SIZE(TEST_MBUF_BLOCK_COUNT, TEST_MBUF_BLOCK_SIZE)];
+static struct os_mempool test_mbuf_mempool;
+static struct os_mbuf_pool test_mbuf_pool;
+
+static const struct {
+    char *in;
+    char *out;
+} base64_vectors[] = {
+    { "", "" },
+    { "f", "Zg==" },
+    { "fo", "Zm8=" },
+    { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" },
+    { "fooba", "Zm9vYmE=" },
+    { "foobar", "Zm9vYmFy" },
+};
+
+static const char base64_long_txt[] =
+    "The quick brown fox jumps over the lazy dog, twice over.";
+
+TEST_CASE(base64_codec)
+{
+    struct base64_decoder bd;
+    struct os_mbuf *om;
+    char enc[128];
+    char dec[128];
+    int consumed;
+    int off;
+    int len;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof(base64_vectors) / sizeof(base64_vectors[0]); i++) {
+        len = strlen(base64_vectors[i].in);
+        rc = base64_encode(base64_vectors[i].in, len, enc, 1);
+        TEST_ASSERT(rc == strlen(base64_vectors[i].out));
+        TEST_ASSERT(!strcmp(enc, base64_vectors[i].out));
+
+        rc = base64_decode(base64_vectors[i].out, dec);
+        TEST_ASSERT(rc == len);
+        TEST_ASSERT(!memcmp(dec, base64_vectors[i].in, len));
+    }
+
+    /* unpadded output */
+    rc = base64_encode("fo", 2, enc, 0);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(!strcmp(enc, "Zm8"));
+
+    /* in place, as done by the shell and newtmgr transports */
+    len = base64_encode(base64_long_txt, sizeof(base64_long_txt), enc, 1);
+    rc = base64_decode(enc, enc);
+    TEST_ASSERT(rc == sizeof(base64_long_txt));
+    TEST_ASSERT(!memcmp(enc, base64_long_txt, sizeof(base64_long_txt)));
+
+    /* malformed */
+    TEST_ASSERT(base64_decode("Zm9", dec) == -1);
+    TEST_ASSERT(base64_decode("Z===", dec) == -1);
+    TEST_ASSERT(base64_decode("Zm=v", dec) == -1);
+    TEST_ASSERT(base64_decode("Zm!v", dec) == -1);
+
+    /* decoding stops at the first character not in the alphabet */
+    TEST_ASSERT(base64_decode("Zm9v\nZm9v", dec) == 3);
+
+    /*
+     * Incremental decoding, 5 characters at a time into a buffer with
+     * room for just 4 bytes per call.
+     */
+    len = base64_encode(base64_long_txt, sizeof(base64_long_txt), enc, 1);
+    base64_decoder_init(&bd);
+    off = 0;
+    i = 0;
+    while (off < len) {
+        consumed = len - off < 5 ? len - off : 5;
+        rc = base64_decoder_feed(&bd, enc + off, &consumed, dec + i, 4);
+        TEST_ASSERT_FATAL(rc >= 0);
+        off += consumed;
+        i += rc;
+    }
+    TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+    TEST_ASSERT(i == sizeof(base64_long_txt));
+    TEST_ASSERT(!memcmp(dec, base64_long_txt, sizeof(base64_long_txt)));
+
+    base64_decoder_init(&bd);
+    consumed = 2;
+    rc = base64_decoder_feed(&bd, "Zm9v", &consumed, dec, sizeof(dec));
+    TEST_ASSERT(rc == 0 && consumed == 2);
+    TEST_ASSERT(base64_decoder_finish(&bd) == -1);
+
+    /* incremental decoding into an mbuf chain */
+    rc = os_mempool_init(&test_mbuf_mempool, TEST_MBUF_BLOCK_COUNT,
+                         TEST_MBUF_BLOCK_SIZE, test_mbuf_mem, "b64_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mempool,
+                           TEST_MBUF_BLOCK_SIZE, TEST_MBUF_BLOCK_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    om = os_mbuf_get_pkthdr(&test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    base64_decoder_init(&bd);
+    for (off = 0; off < len; off += 7) {
+        rc = base64_decoder_feed_mbuf(&bd, enc + off,
+                                      len - off < 7 ? len - off : 7, om);
+        TEST_ASSERT_FATAL(rc >= 0);
+    }
+    TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == sizeof(base64_long_txt));
+    rc = os_mbuf_copydata(om, 0, sizeof(base64_long_txt), dec);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(dec, base64_long_txt, sizeof(base64_long_txt)));
+    os_mbuf_free_chain(om);
+}
@@ -139,7 +139,32 @@ struct cbor_attr_t {
 
 #define CBORATTR_ATTR_UNNAMED (char *)(-1)
 
+/*
+ * Key lookup index for an attribute array, used by
+ * cbor_read_object_indexed(). order[] holds the positions of the named
+ * attributes, sorted by name length and then name; it is filled in on
+ * first use.
+ */
+struct cbor_attr_index {
+    uint8_t *order;
+    uint8_t max;
+    uint8_t cnt;
+    uint8_t ready;
+};
+
+/*
+ * Declares a static index with room for n named attributes.
+ */
+#define CBORATTR_INDEX_DEFINE(name, n)                                  \
+    static uint8_t name##_order[n];                                     \
+    static struct cbor_attr_index name = {                              \
+        .order = name##_order,                                          \
+        .max = n,                                                       \
+    }
+
 int cbor_read_object(struct CborValue *, const struct cbor_attr_t *);
+int cbor_read_object_indexed(struct CborValue *, const struct cbor_attr_t *,
+                             struct cbor_attr_index *);
 int cbor_read_array(struct CborValue *, const struct cbor_array_t *);
 
 int cbor_read_flat_attrs(const uint8_t *data, int len,
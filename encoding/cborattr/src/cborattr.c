@@ -133,20 +133,108 @@ cbor_target_address(const struct cbor_attr_t *cursor,
     return targetaddr;
 }
 
+/* orders attribute names by length first, then by content; this is what
+ * the index is sorted by, and it lets a lookup reject most candidates on
+ * the length compare alone */
+static int
+cbor_attr_key_cmp(const char *name, const char *key, size_t len)
+{
+    size_t nlen;
+
+    nlen = strlen(name);
+    if (nlen != len) {
+        return nlen < len ? -1 : 1;
+    }
+    return memcmp(name, key, len);
+}
+
+static int
+cbor_attr_index_build(struct cbor_attr_index *idx,
+                      const struct cbor_attr_t *attrs)
+{
+    const char *name;
+    int i, j, n;
+
+    n = 0;
+    for (i = 0; attrs[i].attribute != NULL; i++) {
+        name = attrs[i].attribute;
+        if (name == CBORATTR_ATTR_UNNAMED) {
+            continue;
+        }
+        if (n >= idx->max || i > UINT8_MAX) {
+            return CborErrorOutOfMemory;
+        }
+
+        /* insertion sort; stable, so that attributes sharing a name are
+         * still tried in the order they were declared in */
+        for (j = n++; j > 0; j--) {
+            if (cbor_attr_key_cmp(attrs[idx->order[j - 1]].attribute,
+                                  name, strlen(name)) <= 0) {
+                break;
+            }
+            idx->order[j] = idx->order[j - 1];
+        }
+        idx->order[j] = i;
+    }
+    idx->cnt = n;
+    idx->ready = 1;
+    return 0;
+}
+
+static const struct cbor_attr_t *
+cbor_attr_index_find(const struct cbor_attr_index *idx,
+                     const struct cbor_attr_t *attrs,
+                     const char *key, size_t len, CborType type)
+{
+    const struct cbor_attr_t *cursor;
+    int lo, hi, mid;
+
+    lo = 0;
+    hi = idx->cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (cbor_attr_key_cmp(attrs[idx->order[mid]].attribute,
+                              key, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < idx->cnt; lo++) {
+        cursor = &attrs[idx->order[lo]];
+        if (cbor_attr_key_cmp(cursor->attribute, key, len)) {
+            break;
+        }
+        if (valid_attr_type(type, cursor->type)) {
+            return cursor;
+        }
+    }
+    return NULL;
+}
+
 static int
 cbor_internal_read_object(CborValue *root_value,
                           const struct cbor_attr_t *attrs,
+                          struct cbor_attr_index *idx,
                           const struct cbor_array_t *parent,
                           int offset)
 {
     const struct cbor_attr_t *cursor, *best_match;
     char attrbuf[MYNEWT_VAL(CBORATTR_MAX_SIZE) + 1];
+    const void *key;
     void *lptr;
     CborValue cur_value;
     CborError err = 0;
     size_t len;
     CborType type = CborInvalidType;
 
+    if (idx && !idx->ready) {
+        err = cbor_attr_index_build(idx, attrs);
+        if (err) {
+            return err;
+        }
+    }
+
     /* stuff fields with defaults in case they're omitted in the JSON input */
     for (cursor = attrs; cursor->attribute != NULL; cursor++) {
         if (!cursor->nodefault) {
@@ -189,13 +277,24 @@ cbor_internal_read_object(CborValue *root_value,
     while (cbor_value_is_valid(&cur_value) && !err) {
         /* get the attribute */
         if (cbor_value_is_text_string(&cur_value)) {
-            if (cbor_value_calculate_string_length(&cur_value, &len) == 0) {
-                if (len > MYNEWT_VAL(CBORATTR_MAX_SIZE)) {
-                    err |= CborErrorDataTooLarge;
-                    break;
+            /* look at the key in place when the reader allows it; only
+             * copy it out when it is split across buffers */
+            len = 0;
+            err |= cbor_value_get_string_ptr(&cur_value, &key, &len, NULL);
+            if (!err && key == NULL) {
+                err |= cbor_value_calculate_string_length(&cur_value, &len);
+                if (!err && len <= MYNEWT_VAL(CBORATTR_MAX_SIZE)) {
+                    err |= cbor_value_copy_text_string(&cur_value, attrbuf,
+                                                       &len, NULL);
+                    key = attrbuf;
                 }
-                err |= cbor_value_copy_text_string(&cur_value, attrbuf, &len,
-                                                     NULL);
+            }
+            if (err) {
+                break;
+            }
+            if (len > MYNEWT_VAL(CBORATTR_MAX_SIZE)) {
+                err |= CborErrorDataTooLarge;
+                break;
             }
 
             /* at least get the type of the next value so we can match the
@@ -208,28 +307,34 @@ cbor_internal_read_object(CborValue *root_value,
                 break;
             }
         } else {
-            attrbuf[0] = '\0';
+            key = "";
+            len = 0;
             type = cbor_value_get_type(&cur_value);
         }
 
         /* find this attribute in our list */
-        best_match = NULL;
-        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-            if (valid_attr_type(type, cursor->type)) {
-                if (cursor->attribute == CBORATTR_ATTR_UNNAMED &&
-                    attrbuf[0] == '\0') {
-                    best_match = cursor;
-                } else if (strlen(cursor->attribute) == len &&
-                    !memcmp(cursor->attribute, attrbuf, len)) {
-                    break;
+        if (idx && len > 0) {
+            cursor = cbor_attr_index_find(idx, attrs, key, len, type);
+        } else {
+            best_match = NULL;
+            for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+                if (valid_attr_type(type, cursor->type)) {
+                    if (cursor->attribute == CBORATTR_ATTR_UNNAMED) {
+                        if (len == 0) {
+                            best_match = cursor;
+                        }
+                    } else if (!cbor_attr_key_cmp(cursor->attribute,
+                                                  key, len)) {
+                        break;
+                    }
                 }
             }
-        }
-        if (!cursor->attribute && best_match) {
-            cursor = best_match;
+            if (!cursor->attribute) {
+                cursor = best_match;
+            }
         }
         /* we found a match */
-        if (cursor->attribute != NULL) {
+        if (cursor != NULL) {
             lptr = cbor_target_address(cursor, parent, offset);
             switch (cursor->type) {
             case CborAttrNullType:
@@ -270,7 +375,7 @@ cbor_internal_read_object(CborValue *root_value,
                 continue;
             case CborAttrObjectType:
                 err |= cbor_internal_read_object(&cur_value, cursor->addr.obj,
-                                                 NULL, 0);
+                                                 NULL, NULL, 0);
                 continue;
             default:
                 err |= CborErrorIllegalType;
@@ -330,7 +435,7 @@ cbor_read_array(struct CborValue *value, const struct cbor_array_t *arr)
             break;
         case CborAttrStructObjectType:
             err |= cbor_internal_read_object(&elem, arr->arr.objects.subtype,
-                                             arr, off);
+                                             NULL, arr, off);
             break;
         default:
             err |= CborErrorIllegalType;
@@ -360,10 +465,33 @@ cbor_read_object(struct CborValue *value, const struct cbor_attr_t *attrs)
 {
     int st;
 
-    st = cbor_internal_read_object(value, attrs, NULL, 0);
+    st = cbor_internal_read_object(value, attrs, NULL, NULL, 0);
     return st;
 }
 
+/*
+ * Same as cbor_read_object(), but looks keys up through a sorted index
+ * instead of scanning attrs for every key in the map.
+ *
+ * The index is built from attrs on first use and kept in idx, so attrs
+ * must list the same attribute names in the same order on every call;
+ * the target addresses may change. Nested objects are decoded without
+ * an index.
+ *
+ * @param value		Map to decode
+ * @param attrs		Array of cbor objects to look for.
+ * @param idx		Index, usually declared with CBORATTR_INDEX_DEFINE().
+ *
+ * @return		0 on success; non-zero on failure.
+ */
+int
+cbor_read_object_indexed(struct CborValue *value,
+                         const struct cbor_attr_t *attrs,
+                         struct cbor_attr_index *idx)
+{
+    return cbor_internal_read_object(value, attrs, idx, NULL, 0);
+}
+
 /*
  * Read in cbor key/values from flat buffer pointed by data, and fill them
  * into attrs.
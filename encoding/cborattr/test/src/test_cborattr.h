@@ -48,6 +48,9 @@ TEST_CASE_DECL(test_cborattr_decode_string_array);
 TEST_CASE_DECL(test_cborattr_decode_object_array);
 TEST_CASE_DECL(test_cborattr_decode_unnamed_array);
 TEST_CASE_DECL(test_cborattr_decode_substring_key);
+TEST_CASE_DECL(test_cborattr_decode_mbuf_chain);
+TEST_CASE_DECL(test_cborattr_decode_deferred_len);
+TEST_CASE_DECL(test_cborattr_decode_indexed);
 
 
 #ifdef __cplusplus
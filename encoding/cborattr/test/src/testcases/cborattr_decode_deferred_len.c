@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "tinycbor/cbor_cnt_writer.h"
+#include "tinycbor/cbor_mbuf_writer.h"
+
+#define TEST_MBUF_BLOCK_SIZE    64
+#define TEST_MBUF_BLOCK_COUNT   16
+
+static os_membuf_t test_mbuf_mem[
+    OS_MEMPOOL_SIZE(TEST_MBUF_BLOCK_COUNT, TEST_MBUF_BLOCK_SIZE)];
+static struct os_mempool test_mbuf_mempool;
+static struct os_mbuf_pool test_mbuf_pool;
+
+/*
+ * {"a": 1, "arr": [0, 1, ..., 29], "m": {"x": "y"}}
+ *
+ * The array is long enough to need a one byte length after its header.
+ */
+static int
+test_encode_deferred(struct cbor_encoder_writer *writer)
+{
+    CborEncoder enc;
+    CborEncoder map;
+    CborEncoder arr;
+    CborEncoder sub;
+    int rc;
+    int i;
+
+    rc = 0;
+    cbor_encoder_init(&enc, writer, 0);
+    rc |= cbor_encoder_create_map(&enc, &map, CborDeferredLength);
+    rc |= cbor_encode_text_stringz(&map, "a");
+    rc |= cbor_encode_uint(&map, 1);
+    rc |= cbor_encode_text_stringz(&map, "arr");
+    rc |= cbor_encoder_create_array(&map, &arr, CborDeferredLength);
+    for (i = 0; i < 30; i++) {
+        rc |= cbor_encode_uint(&arr, i);
+    }
+    rc |= cbor_encoder_close_container(&map, &arr);
+    rc |= cbor_encode_text_stringz(&map, "m");
+    rc |= cbor_encoder_create_map(&map, &sub, CborDeferredLength);
+    rc |= cbor_encode_text_stringz(&sub, "x");
+    rc |= cbor_encode_text_stringz(&sub, "y");
+    rc |= cbor_encoder_close_container(&map, &sub);
+    rc |= cbor_encoder_close_container(&enc, &map);
+
+    return rc;
+}
+
+/*
+ * Expected encoding, with definite lengths throughout.
+ */
+static void
+test_check_encoding(const uint8_t *data, int len)
+{
+    int i;
+
+    TEST_ASSERT_FATAL(len == 1 + 2 + 1 + 4 + 2 + 24 + 12 + 2 + 1 + 4);
+    TEST_ASSERT(data[0] == 0xa3);                   /* map(3) */
+    TEST_ASSERT(data[1] == 0x61 && data[2] == 'a');
+    TEST_ASSERT(data[3] == 0x01);
+    TEST_ASSERT(data[4] == 0x63 && memcmp(data + 5, "arr", 3) == 0);
+    TEST_ASSERT(data[8] == 0x98 && data[9] == 30);  /* array(30) */
+    for (i = 0; i < 24; i++) {
+        TEST_ASSERT(data[10 + i] == i);
+    }
+    for (i = 24; i < 30; i++) {
+        TEST_ASSERT(data[34 + (i - 24) * 2] == 0x18);
+        TEST_ASSERT(data[35 + (i - 24) * 2] == i);
+    }
+    TEST_ASSERT(data[46] == 0x61 && data[47] == 'm');
+    TEST_ASSERT(data[48] == 0xa1);                  /* map(1) */
+    TEST_ASSERT(memcmp(data + 49, "\x61x\x61y", 4) == 0);
+}
+
+/*
+ * Containers created with CborDeferredLength.
+ */
+TEST_CASE(test_cborattr_decode_deferred_len)
+{
+    struct cbor_buf_writer bw;
+    struct cbor_mbuf_writer mw;
+    struct CborCntWriter cw;
+    uint8_t buf[64];
+    uint8_t flat[64];
+    struct os_mbuf *om;
+    uint64_t a_val;
+    struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "a",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &a_val,
+            .nodefault = true
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+    int rc;
+
+    /* Counting pass gives the exact size. */
+    cbor_cnt_writer_init(&cw);
+    rc = test_encode_deferred(&cw.enc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cw.enc.bytes_written == 53);
+
+    /* Flat buffer. */
+    cbor_buf_writer_init(&bw, buf, sizeof(buf));
+    rc = test_encode_deferred(&bw.enc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cbor_buf_writer_buffer_size(&bw, buf) == 53);
+    test_check_encoding(buf, bw.enc.bytes_written);
+
+    a_val = 0;
+    rc = cbor_read_flat_attrs(buf, bw.enc.bytes_written, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(a_val == 1);
+
+    /* mbuf chain, after a 3 byte prefix that is not part of the CBOR. */
+    rc = os_mempool_init(&test_mbuf_mempool, TEST_MBUF_BLOCK_COUNT,
+                         TEST_MBUF_BLOCK_SIZE, test_mbuf_mem, "cbor_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mempool,
+                           TEST_MBUF_BLOCK_SIZE, TEST_MBUF_BLOCK_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, "pfx", 3);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    cbor_mbuf_writer_init(&mw, om);
+    rc = test_encode_deferred(&mw.enc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == 3 + 53);
+
+    rc = os_mbuf_copydata(om, 0, OS_MBUF_PKTLEN(om), flat);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(memcmp(flat, "pfx", 3) == 0);
+    test_check_encoding(flat + 3, OS_MBUF_PKTLEN(om) - 3);
+
+    a_val = 0;
+    rc = cbor_read_mbuf_attrs(om, 3, OS_MBUF_PKTLEN(om) - 3, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(a_val == 1);
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "tinycbor/cbor_buf_reader.h"
+
+static uint8_t test_cbor_buf[128];
+static int test_cbor_len;
+
+/*
+ * { "val": "v", "unknown": [ 1, { "x": 2 } ], "n": 7, "name": "nm",
+ *   "n": "s", "save": true }
+ */
+static void
+test_encode_indexed(void)
+{
+    struct cbor_buf_writer bw;
+    CborEncoder enc;
+    CborEncoder map;
+    CborEncoder arr;
+    CborEncoder sub;
+
+    cbor_buf_writer_init(&bw, test_cbor_buf, sizeof(test_cbor_buf));
+    cbor_encoder_init(&enc, &bw.enc, 0);
+    cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+
+    cbor_encode_text_stringz(&map, "val");
+    cbor_encode_text_stringz(&map, "v");
+    cbor_encode_text_stringz(&map, "unknown");
+    cbor_encoder_create_array(&map, &arr, 2);
+    cbor_encode_int(&arr, 1);
+    cbor_encoder_create_map(&arr, &sub, 1);
+    cbor_encode_text_stringz(&sub, "x");
+    cbor_encode_int(&sub, 2);
+    cbor_encoder_close_container(&arr, &sub);
+    cbor_encoder_close_container(&map, &arr);
+    cbor_encode_text_stringz(&map, "n");
+    cbor_encode_int(&map, 7);
+    cbor_encode_text_stringz(&map, "name");
+    cbor_encode_text_stringz(&map, "nm");
+    cbor_encode_text_stringz(&map, "n");
+    cbor_encode_text_stringz(&map, "s");
+    cbor_encode_text_stringz(&map, "save");
+    cbor_encode_boolean(&map, true);
+
+    cbor_encoder_close_container(&enc, &map);
+    test_cbor_len = bw.enc.bytes_written;
+}
+
+static int
+test_decode_indexed(const struct cbor_attr_t *attrs,
+                    struct cbor_attr_index *idx)
+{
+    struct cbor_buf_reader reader;
+    struct CborParser parser;
+    struct CborValue value;
+    CborError err;
+
+    cbor_buf_reader_init(&reader, test_cbor_buf, test_cbor_len);
+    err = cbor_parser_init(&reader.r, 0, &parser, &value);
+    if (err) {
+        return err;
+    }
+    return cbor_read_object_indexed(&value, attrs, idx);
+}
+
+CBORATTR_INDEX_DEFINE(test_idx, 6);
+
+TEST_CASE(test_cborattr_decode_indexed)
+{
+    CBORATTR_INDEX_DEFINE(small_idx, 2);
+    char name[8];
+    char val[8];
+    char nstr[8];
+    long long int nint;
+    bool save;
+    int i;
+    int rc;
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "save",
+            .type = CborAttrBooleanType,
+            .addr.boolean = &save,
+        },
+        [1] = {
+            .attribute = "val",
+            .type = CborAttrTextStringType,
+            .addr.string = val,
+            .len = sizeof(val),
+        },
+        [2] = {
+            .attribute = "n",
+            .type = CborAttrTextStringType,
+            .addr.string = nstr,
+            .len = sizeof(nstr),
+        },
+        [3] = {
+            .attribute = "name",
+            .type = CborAttrTextStringType,
+            .addr.string = name,
+            .len = sizeof(name),
+        },
+        [4] = {
+            .attribute = "n",
+            .type = CborAttrIntegerType,
+            .addr.integer = &nint,
+            .dflt.integer = -1,
+        },
+        [5] = {
+            .attribute = "zz",
+            .type = CborAttrIntegerType,
+            .addr.integer = NULL,
+            .nodefault = true,
+        },
+        [6] = {
+            .attribute = NULL
+        }
+    };
+
+    test_encode_indexed();
+
+    /*
+     * Decode twice; the second pass reuses the index built by the first.
+     */
+    for (i = 0; i < 2; i++) {
+        memset(name, 0, sizeof(name));
+        memset(val, 0, sizeof(val));
+        memset(nstr, 0, sizeof(nstr));
+        save = false;
+
+        rc = test_decode_indexed(attrs, &test_idx);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(test_idx.ready);
+        TEST_ASSERT(test_idx.cnt == 6);
+        TEST_ASSERT(!strcmp(name, "nm"));
+        TEST_ASSERT(!strcmp(val, "v"));
+        TEST_ASSERT(!strcmp(nstr, "s"));
+        TEST_ASSERT(nint == 7);
+        TEST_ASSERT(save == true);
+    }
+
+    /*
+     * Index too small for the attribute array.
+     */
+    rc = test_decode_indexed(attrs, &small_idx);
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(!small_idx.ready);
+}
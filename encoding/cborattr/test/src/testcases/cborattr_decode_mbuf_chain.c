@@ -0,0 +1,206 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+
+#define TEST_MBUF_BLOCK_SIZE    128
+#define TEST_MBUF_BLOCK_COUNT   96
+
+static os_membuf_t test_mbuf_mem[
+    OS_MEMPOOL_SIZE(TEST_MBUF_BLOCK_COUNT, TEST_MBUF_BLOCK_SIZE)];
+static struct os_mempool test_mbuf_mempool;
+static struct os_mbuf_pool test_mbuf_pool;
+
+static uint8_t test_cbor_buf[128];
+static int test_cbor_len;
+
+static const char test_name[] = "a text value long enough to span mbufs";
+static const uint8_t test_blob[] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+static int
+test_cbor_wr(struct cbor_encoder_writer *cew, const char *data, int len)
+{
+    memcpy(test_cbor_buf + test_cbor_len, data, len);
+    test_cbor_len += len;
+
+    assert(test_cbor_len < sizeof(test_cbor_buf));
+    return 0;
+}
+
+static struct cbor_encoder_writer test_writer = {
+    .write = test_cbor_wr
+};
+
+/*
+ * {"name": test_name, "id": 1234567, "blob": test_blob}
+ */
+static void
+test_encode_data(void)
+{
+    CborEncoder enc;
+    CborEncoder map;
+
+    test_cbor_len = 0;
+    cbor_encoder_init(&enc, &test_writer, 0);
+    cbor_encoder_create_map(&enc, &map, 3);
+    cbor_encode_text_stringz(&map, "name");
+    cbor_encode_text_stringz(&map, test_name);
+    cbor_encode_text_stringz(&map, "id");
+    cbor_encode_uint(&map, 1234567);
+    cbor_encode_text_stringz(&map, "blob");
+    cbor_encode_byte_string(&map, test_blob, sizeof(test_blob));
+    cbor_encoder_close_container(&enc, &map);
+}
+
+/*
+ * Splits the encoded data over a chain of mbufs holding chunk bytes each,
+ * behind an empty packet header mbuf.
+ */
+static struct os_mbuf *
+test_build_chain(int chunk)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int off;
+    int n;
+
+    om = os_mbuf_get_pkthdr(&test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    for (off = 0; off < test_cbor_len; off += n) {
+        n = min(chunk, test_cbor_len - off);
+        m = os_mbuf_get(&test_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        memcpy(m->om_data, test_cbor_buf + off, n);
+        m->om_len = n;
+        os_mbuf_concat(om, m);
+    }
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == test_cbor_len);
+
+    return om;
+}
+
+static void
+test_decode_attrs(struct os_mbuf *om)
+{
+    char name[sizeof(test_name)];
+    uint64_t id;
+    uint8_t blob[sizeof(test_blob)];
+    size_t blob_len;
+    struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "name",
+            .type = CborAttrTextStringType,
+            .addr.string = name,
+            .len = sizeof(name),
+        },
+        [1] = {
+            .attribute = "id",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &id,
+        },
+        [2] = {
+            .attribute = "blob",
+            .type = CborAttrByteStringType,
+            .addr.bytestring.data = blob,
+            .addr.bytestring.len = &blob_len,
+            .len = sizeof(blob),
+        },
+        [3] = {
+            .attribute = NULL
+        }
+    };
+    int rc;
+
+    memset(name, 0, sizeof(name));
+    id = 0;
+    blob_len = 0;
+
+    rc = cbor_read_mbuf_attrs(om, 0, OS_MBUF_PKTLEN(om), attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(strcmp(name, test_name) == 0);
+    TEST_ASSERT(id == 1234567);
+    TEST_ASSERT(blob_len == sizeof(test_blob));
+    TEST_ASSERT(memcmp(blob, test_blob, sizeof(test_blob)) == 0);
+}
+
+/*
+ * Returns a direct pointer to the "name" value, or NULL if it is split.
+ */
+static const void *
+test_name_ptr(struct os_mbuf *om)
+{
+    struct cbor_mbuf_reader reader;
+    CborParser parser;
+    CborValue map;
+    CborValue val;
+    const void *ptr;
+    size_t len;
+    int rc;
+
+    cbor_mbuf_reader_init(&reader, om, 0);
+    rc = cbor_parser_init(&reader.r, 0, &parser, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cbor_value_map_find_value(&map, "name", &val);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(cbor_value_is_text_string(&val));
+
+    rc = cbor_value_get_string_ptr(&val, &ptr, &len, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    if (ptr != NULL) {
+        TEST_ASSERT(len == strlen(test_name));
+        TEST_ASSERT(memcmp(ptr, test_name, len) == 0);
+    }
+    return ptr;
+}
+
+/*
+ * Decoding from fragmented mbuf chains.
+ */
+TEST_CASE(test_cborattr_decode_mbuf_chain)
+{
+    struct os_mbuf *om;
+    int chunk;
+    int rc;
+
+    rc = os_mempool_init(&test_mbuf_mempool, TEST_MBUF_BLOCK_COUNT,
+                         TEST_MBUF_BLOCK_SIZE, test_mbuf_mem, "cbor_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mempool,
+                           TEST_MBUF_BLOCK_SIZE, TEST_MBUF_BLOCK_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    test_encode_data();
+
+    /* Every integer and string straddles some mbuf boundary. */
+    for (chunk = 1; chunk <= 8; chunk++) {
+        om = test_build_chain(chunk);
+        test_decode_attrs(om);
+        TEST_ASSERT(test_name_ptr(om) == NULL);
+        os_mbuf_free_chain(om);
+    }
+
+    /* Contiguous data hands out a pointer into the mbuf. */
+    om = test_build_chain(test_cbor_len);
+    test_decode_attrs(om);
+    TEST_ASSERT(test_name_ptr(om) != NULL);
+    os_mbuf_free_chain(om);
+}
@@ -17,6 +17,7 @@
  * under the License.
  */
 #include "test_cborattr.h"
+#include "tinycbor/cbor_buf_reader.h"
 
 /*
  * Where we collect cbor data.
@@ -70,6 +71,11 @@ test_encode_substring_key(void)
  */
 TEST_CASE(test_cborattr_decode_substring_key)
 {
+    struct cbor_buf_reader reader;
+    struct CborParser parser;
+    struct CborValue value;
+    struct CborValue elem;
+    size_t len;
     int rc;
     char test_str_1a[4] = { '\0' };
     char test_str_2a[4] = { '\0' };
@@ -108,4 +114,19 @@ TEST_CASE(test_cborattr_decode_substring_key)
     TEST_ASSERT(!strcmp(test_str_1a, "A"));
     TEST_ASSERT(!strcmp(test_str_2a, "AA"));
     TEST_ASSERT(!strcmp(test_str_3a, "AAA"));
+
+    /*
+     * Map lookup must not stop at a key which is a prefix of the name.
+     */
+    cbor_buf_reader_init(&reader, test_cbor_buf, test_cbor_len);
+    rc = cbor_parser_init(&reader.r, 0, &parser, &value);
+    TEST_ASSERT(rc == 0);
+    rc = cbor_value_map_find_value(&value, "aaa", &elem);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cbor_value_is_text_string(&elem));
+    memset(test_str_3a, 0, sizeof(test_str_3a));
+    len = sizeof(test_str_3a);
+    rc = cbor_value_copy_text_string(&elem, test_str_3a, &len, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(test_str_3a, "AAA"));
 }
@@ -101,6 +101,11 @@ int json_encode_array_start(struct json_encoder *encoder);
 int json_encode_array_value(struct json_encoder *encoder, struct json_value *val);
 int json_encode_array_finish(struct json_encoder *encoder);
 
+/* Encoder writing to an mbuf chain */
+struct os_mbuf;
+int json_mbuf_write(void *arg, char *data, int len);
+void json_encoder_init_mbuf(struct json_encoder *encoder, struct os_mbuf *om);
+
 /* Json parser definitions */
 typedef enum {
     t_integer,
@@ -223,6 +228,51 @@ int json_read_array(struct json_buffer *, const struct json_array_t *);
 #define JSON_ERR_MISC        20  /* other data conversion error */
 #define JSON_ERR_BADNUM      21  /* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR     22  /* unexpected null value or attribute pointer */
+#define JSON_ERR_DEPTH       23  /* objects/arrays nested too deep */
+#define JSON_ERR_INCOMPLETE  24  /* input ended in the middle of the document */
+
+/*
+ * Streaming parser. The document is fed in chunks with json_stream_feed(),
+ * and the callback is called for every structural element as it is seen.
+ * Keys, strings and numbers are passed to the callback as a NUL terminated
+ * token from the buffer given to json_stream_init(); tok is NULL for the
+ * other events. A non-zero return from the callback stops parsing, and
+ * is returned from json_stream_feed().
+ */
+#define JSON_STREAM_EV_OBJ_START    1
+#define JSON_STREAM_EV_OBJ_END      2
+#define JSON_STREAM_EV_ARR_START    3
+#define JSON_STREAM_EV_ARR_END      4
+#define JSON_STREAM_EV_KEY          5
+#define JSON_STREAM_EV_STRING       6
+#define JSON_STREAM_EV_NUMBER       7
+#define JSON_STREAM_EV_TRUE         8
+#define JSON_STREAM_EV_FALSE        9
+#define JSON_STREAM_EV_NULL         10
+
+#define JSON_STREAM_MAX_DEPTH       32
+
+typedef int (*json_stream_cb_t)(void *arg, int event, char *tok, int len);
+
+struct json_stream {
+    json_stream_cb_t js_cb;
+    void *js_arg;
+    char *js_tok;
+    uint16_t js_tok_size;
+    uint16_t js_tok_len;
+    uint32_t js_stack;          /* bit per nesting level, set for objects */
+    uint16_t js_uval;
+    uint8_t js_ucnt;
+    uint8_t js_depth;
+    uint8_t js_state;
+    uint8_t js_flags;
+    int js_err;
+};
+
+void json_stream_init(struct json_stream *js, json_stream_cb_t cb, void *arg,
+                      char *tok, int tok_size);
+int json_stream_feed(struct json_stream *js, const char *data, int len);
+int json_stream_finish(struct json_stream *js);
 
 /*
  * Use the following macros to declare template initializers for structobject
@@ -48,6 +48,82 @@ json_encode_object_start(struct json_encoder *encoder)
     return (0);
 }
 
+/*
+ * Writes a string value, handing runs of characters that need no escaping
+ * to the writer in one call instead of one call per character.
+ */
+static void
+json_encode_string(struct json_encoder *encoder, char *str, int len)
+{
+    const char *esc;
+    int start;
+    int i;
+
+    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+    start = 0;
+    for (i = 0; i < len; i++) {
+        switch (str[i]) {
+            case '"':
+                esc = "\\\"";
+                break;
+            case '/':
+                esc = "\\/";
+                break;
+            case '\\':
+                esc = "\\\\";
+                break;
+            case '\t':
+                esc = "\\t";
+                break;
+            case '\r':
+                esc = "\\r";
+                break;
+            case '\n':
+                esc = "\\n";
+                break;
+            case '\f':
+                esc = "\\f";
+                break;
+            case '\b':
+                esc = "\\b";
+                break;
+            default:
+                continue;
+        }
+        if (i > start) {
+            encoder->je_write(encoder->je_arg, &str[start], i - start);
+        }
+        encoder->je_write(encoder->je_arg, (char *)esc, 2);
+        start = i + 1;
+    }
+    if (i > start) {
+        encoder->je_write(encoder->je_arg, &str[start], i - start);
+    }
+    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+}
+
+/*
+ * Writes '"key": ' with a single call to the writer when it fits in the
+ * encode buffer.
+ */
+static void
+json_encode_key(struct json_encoder *encoder, char *key)
+{
+    int len;
+
+    len = strlen(key);
+    if (len + sizeof("\"\": ") - 1 <= sizeof(encoder->je_encode_buf)) {
+        encoder->je_encode_buf[0] = '"';
+        memcpy(&encoder->je_encode_buf[1], key, len);
+        memcpy(&encoder->je_encode_buf[len + 1], "\": ", 3);
+        encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len + 4);
+    } else {
+        encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+        encoder->je_write(encoder->je_arg, key, len);
+        encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    }
+}
+
 static int
 json_encode_value(struct json_encoder *encoder, struct json_value *jv)
 {
@@ -72,46 +148,7 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
             encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
             break;
         case JSON_VALUE_TYPE_STRING:
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-            for (i = 0; i < jv->jv_len; i++) {
-                switch (jv->jv_val.str[i]) {
-                    case '"':
-                    case '/':
-                    case '\\':
-                        encoder->je_write(encoder->je_arg, "\\",
-                                sizeof("\\")-1);
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-
-                        break;
-                    case '\t':
-                        encoder->je_write(encoder->je_arg, "\\t",
-                                sizeof("\\t")-1);
-                        break;
-                    case '\r':
-                        encoder->je_write(encoder->je_arg, "\\r",
-                                sizeof("\\r")-1);
-                        break;
-                    case '\n':
-                        encoder->je_write(encoder->je_arg, "\\n",
-                                sizeof("\\n")-1);
-                        break;
-                    case '\f':
-                        encoder->je_write(encoder->je_arg, "\\f",
-                                sizeof("\\f")-1);
-                        break;
-                    case '\b':
-                        encoder->je_write(encoder->je_arg, "\\b",
-                                sizeof("\\b")-1);
-                        break;
-                   default:
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-                        break;
-                }
-
-            }
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_encode_string(encoder, jv->jv_val.str, jv->jv_len);
             break;
         case JSON_VALUE_TYPE_ARRAY:
             JSON_ENCODE_ARRAY_START(encoder);
@@ -158,9 +195,7 @@ json_encode_object_key(struct json_encoder *encoder, char *key)
     }
 
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_key(encoder, key);
 
     return (0);
 }
@@ -176,9 +211,7 @@ json_encode_object_entry(struct json_encoder *encoder, char *key,
         encoder->je_wr_commas = 0;
     }
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_key(encoder, key);
 
     rc = json_encode_value(encoder, val);
     if (rc != 0) {
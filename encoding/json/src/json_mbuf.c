@@ -0,0 +1,50 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <json/json.h>
+
+/*
+ * json_write_func_t which appends encoder output to the mbuf chain passed
+ * as the argument. Output is copied into the trailing space of the last
+ * mbuf a block at a time; new mbufs are allocated from the pool of the
+ * chain as it fills up.
+ */
+int
+json_mbuf_write(void *arg, char *data, int len)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = arg;
+    rc = os_mbuf_append(om, data, len);
+    if (rc != 0) {
+        return -1;
+    }
+    return len;
+}
+
+void
+json_encoder_init_mbuf(struct json_encoder *encoder, struct os_mbuf *om)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->je_write = json_mbuf_write;
+    encoder->je_arg = om;
+}
@@ -0,0 +1,425 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+
+#include <json/json.h>
+
+/*
+ * Event driven JSON parser. Input is fed in arbitrary sized chunks; the
+ * parser keeps just enough state between chunks to resume in the middle
+ * of a token. Keys, strings and literals are collected into the token
+ * buffer supplied by the caller and reported through the callback once
+ * complete, so the largest single token decides the RAM needed, not the
+ * size of the document.
+ */
+
+enum {
+    JSON_STREAM_S_VALUE,       /* expecting a value */
+    JSON_STREAM_S_VALUE_FIRST, /* expecting a value or ']' */
+    JSON_STREAM_S_KEY,         /* expecting a key */
+    JSON_STREAM_S_KEY_FIRST,   /* expecting a key or '}' */
+    JSON_STREAM_S_COLON,       /* expecting ':' */
+    JSON_STREAM_S_AFTER,       /* expecting ',' or end of container */
+    JSON_STREAM_S_STRING,      /* inside a string */
+    JSON_STREAM_S_ESCAPE,      /* after a '\' in a string */
+    JSON_STREAM_S_UESCAPE,     /* inside a \uXXXX escape */
+    JSON_STREAM_S_LITERAL,     /* inside a number, true, false or null */
+    JSON_STREAM_S_DONE,        /* top level value complete */
+};
+
+#define JSON_STREAM_F_KEY       0x01    /* string being collected is a key */
+
+static int
+json_stream_is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int
+json_stream_is_literal(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static int
+json_stream_in_object(const struct json_stream *js)
+{
+    return (js->js_stack >> (js->js_depth - 1)) & 1;
+}
+
+static int
+json_stream_putc(struct json_stream *js, char c, int err)
+{
+    if (js->js_tok_len >= js->js_tok_size - 1) {
+        return err;
+    }
+    js->js_tok[js->js_tok_len++] = c;
+    return 0;
+}
+
+static int
+json_stream_emit(struct json_stream *js, int event)
+{
+    char *tok;
+    int len;
+
+    tok = NULL;
+    len = 0;
+    if (event == JSON_STREAM_EV_KEY || event == JSON_STREAM_EV_STRING ||
+        event == JSON_STREAM_EV_NUMBER) {
+        tok = js->js_tok;
+        len = js->js_tok_len;
+        tok[len] = '\0';
+    }
+    js->js_tok_len = 0;
+    return js->js_cb(js->js_arg, event, tok, len);
+}
+
+static void
+json_stream_value_done(struct json_stream *js)
+{
+    if (js->js_depth == 0) {
+        js->js_state = JSON_STREAM_S_DONE;
+    } else {
+        js->js_state = JSON_STREAM_S_AFTER;
+    }
+}
+
+static int
+json_stream_push(struct json_stream *js, int object)
+{
+    if (js->js_depth >= JSON_STREAM_MAX_DEPTH) {
+        return JSON_ERR_DEPTH;
+    }
+    if (object) {
+        js->js_stack |= 1UL << js->js_depth;
+    } else {
+        js->js_stack &= ~(1UL << js->js_depth);
+    }
+    js->js_depth++;
+    if (object) {
+        js->js_state = JSON_STREAM_S_KEY_FIRST;
+        return json_stream_emit(js, JSON_STREAM_EV_OBJ_START);
+    } else {
+        js->js_state = JSON_STREAM_S_VALUE_FIRST;
+        return json_stream_emit(js, JSON_STREAM_EV_ARR_START);
+    }
+}
+
+static int
+json_stream_pop(struct json_stream *js, int object)
+{
+    if (js->js_depth == 0 || json_stream_in_object(js) != object) {
+        return JSON_ERR_BADTRAIL;
+    }
+    js->js_depth--;
+    json_stream_value_done(js);
+    return json_stream_emit(js, object ? JSON_STREAM_EV_OBJ_END :
+                                         JSON_STREAM_EV_ARR_END);
+}
+
+static int
+json_stream_literal_done(struct json_stream *js)
+{
+    const char *tok;
+    int len;
+    int i;
+
+    tok = js->js_tok;
+    len = js->js_tok_len;
+    json_stream_value_done(js);
+    if (len == 4 && !memcmp(tok, "true", 4)) {
+        return json_stream_emit(js, JSON_STREAM_EV_TRUE);
+    }
+    if (len == 5 && !memcmp(tok, "false", 5)) {
+        return json_stream_emit(js, JSON_STREAM_EV_FALSE);
+    }
+    if (len == 4 && !memcmp(tok, "null", 4)) {
+        return json_stream_emit(js, JSON_STREAM_EV_NULL);
+    }
+    if (tok[0] != '-' && (tok[0] < '0' || tok[0] > '9')) {
+        return JSON_ERR_BADNUM;
+    }
+    for (i = 1; i < len; i++) {
+        if (!strchr("0123456789+-.eE", tok[i])) {
+            return JSON_ERR_BADNUM;
+        }
+    }
+    return json_stream_emit(js, JSON_STREAM_EV_NUMBER);
+}
+
+/* appends a \uXXXX code unit to the token as UTF-8 */
+static int
+json_stream_put_utf8(struct json_stream *js, uint16_t u)
+{
+    int rc;
+
+    if (u < 0x80) {
+        return json_stream_putc(js, u, JSON_ERR_STRLONG);
+    }
+    if (u < 0x800) {
+        rc = json_stream_putc(js, 0xc0 | (u >> 6), JSON_ERR_STRLONG);
+    } else {
+        rc = json_stream_putc(js, 0xe0 | (u >> 12), JSON_ERR_STRLONG);
+        if (!rc) {
+            rc = json_stream_putc(js, 0x80 | ((u >> 6) & 0x3f),
+                                  JSON_ERR_STRLONG);
+        }
+    }
+    if (!rc) {
+        rc = json_stream_putc(js, 0x80 | (u & 0x3f), JSON_ERR_STRLONG);
+    }
+    return rc;
+}
+
+static int
+json_stream_escape(struct json_stream *js, char c)
+{
+    switch (c) {
+    case 'b':
+        c = '\b';
+        break;
+    case 'f':
+        c = '\f';
+        break;
+    case 'n':
+        c = '\n';
+        break;
+    case 'r':
+        c = '\r';
+        break;
+    case 't':
+        c = '\t';
+        break;
+    case 'u':
+        js->js_uval = 0;
+        js->js_ucnt = 0;
+        js->js_state = JSON_STREAM_S_UESCAPE;
+        return 0;
+    case '"':
+    case '\\':
+    case '/':
+        break;
+    default:
+        return JSON_ERR_BADSTRING;
+    }
+    js->js_state = JSON_STREAM_S_STRING;
+    return json_stream_putc(js, c, JSON_ERR_STRLONG);
+}
+
+static int
+json_stream_uescape(struct json_stream *js, char c)
+{
+    if (c >= '0' && c <= '9') {
+        c -= '0';
+    } else if (c >= 'a' && c <= 'f') {
+        c -= 'a' - 10;
+    } else if (c >= 'A' && c <= 'F') {
+        c -= 'A' - 10;
+    } else {
+        return JSON_ERR_BADSTRING;
+    }
+    js->js_uval = (js->js_uval << 4) | c;
+    if (++js->js_ucnt < 4) {
+        return 0;
+    }
+    js->js_state = JSON_STREAM_S_STRING;
+    return json_stream_put_utf8(js, js->js_uval);
+}
+
+static int
+json_stream_value(struct json_stream *js, char c)
+{
+    if (c == '{') {
+        return json_stream_push(js, 1);
+    }
+    if (c == '[') {
+        return json_stream_push(js, 0);
+    }
+    if (c == '"') {
+        js->js_flags &= ~JSON_STREAM_F_KEY;
+        js->js_state = JSON_STREAM_S_STRING;
+        return 0;
+    }
+    if (json_stream_is_literal(c)) {
+        js->js_state = JSON_STREAM_S_LITERAL;
+        return json_stream_putc(js, c, JSON_ERR_TOKLONG);
+    }
+    return JSON_ERR_BADTRAIL;
+}
+
+static int
+json_stream_char(struct json_stream *js, char c)
+{
+    int rc;
+
+    switch (js->js_state) {
+    case JSON_STREAM_S_STRING:
+        if (c == '"') {
+            if (js->js_flags & JSON_STREAM_F_KEY) {
+                js->js_state = JSON_STREAM_S_COLON;
+                return json_stream_emit(js, JSON_STREAM_EV_KEY);
+            }
+            json_stream_value_done(js);
+            return json_stream_emit(js, JSON_STREAM_EV_STRING);
+        }
+        if (c == '\\') {
+            js->js_state = JSON_STREAM_S_ESCAPE;
+            return 0;
+        }
+        if ((unsigned char)c < 0x20) {
+            return JSON_ERR_BADSTRING;
+        }
+        return json_stream_putc(js, c, JSON_ERR_STRLONG);
+    case JSON_STREAM_S_ESCAPE:
+        return json_stream_escape(js, c);
+    case JSON_STREAM_S_UESCAPE:
+        return json_stream_uescape(js, c);
+    case JSON_STREAM_S_LITERAL:
+        if (json_stream_is_literal(c)) {
+            return json_stream_putc(js, c, JSON_ERR_TOKLONG);
+        }
+        /* the character ending a literal is processed in the new state */
+        rc = json_stream_literal_done(js);
+        if (rc) {
+            return rc;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (json_stream_is_ws(c)) {
+        return 0;
+    }
+
+    switch (js->js_state) {
+    case JSON_STREAM_S_VALUE_FIRST:
+        if (c == ']') {
+            return json_stream_pop(js, 0);
+        }
+        /* fall through */
+    case JSON_STREAM_S_VALUE:
+        return json_stream_value(js, c);
+    case JSON_STREAM_S_KEY_FIRST:
+        if (c == '}') {
+            return json_stream_pop(js, 1);
+        }
+        /* fall through */
+    case JSON_STREAM_S_KEY:
+        if (c != '"') {
+            return JSON_ERR_ATTRSTART;
+        }
+        js->js_flags |= JSON_STREAM_F_KEY;
+        js->js_state = JSON_STREAM_S_STRING;
+        return 0;
+    case JSON_STREAM_S_COLON:
+        if (c != ':') {
+            return JSON_ERR_BADTRAIL;
+        }
+        js->js_state = JSON_STREAM_S_VALUE;
+        return 0;
+    case JSON_STREAM_S_AFTER:
+        if (c == ',') {
+            js->js_state = json_stream_in_object(js) ? JSON_STREAM_S_KEY :
+                                                       JSON_STREAM_S_VALUE;
+            return 0;
+        }
+        if (c == '}') {
+            return json_stream_pop(js, 1);
+        }
+        if (c == ']') {
+            return json_stream_pop(js, 0);
+        }
+        return JSON_ERR_BADTRAIL;
+    default:
+        return JSON_ERR_BADTRAIL;
+    }
+}
+
+void
+json_stream_init(struct json_stream *js, json_stream_cb_t cb, void *arg,
+                 char *tok, int tok_size)
+{
+    memset(js, 0, sizeof(*js));
+    js->js_cb = cb;
+    js->js_arg = arg;
+    js->js_tok = tok;
+    js->js_tok_size = tok_size;
+    js->js_state = JSON_STREAM_S_VALUE;
+}
+
+/*
+ * Feeds the next chunk of the document to the parser.
+ *
+ * @param js            Parser state
+ * @param data          Chunk of the document
+ * @param len           Number of bytes in the chunk
+ *
+ * @return              0 on success, JSON_ERR_* on malformed input, or the
+ *                      non-zero value returned by the callback. Errors are
+ *                      sticky; once one is returned, further calls return
+ *                      the same value.
+ */
+int
+json_stream_feed(struct json_stream *js, const char *data, int len)
+{
+    int rc;
+    int i;
+
+    if (js->js_err) {
+        return js->js_err;
+    }
+    for (i = 0; i < len; i++) {
+        rc = json_stream_char(js, data[i]);
+        if (rc) {
+            js->js_err = rc;
+            return rc;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Signals the end of input. Completes a top level literal, and checks
+ * that the document was not cut short.
+ *
+ * @return              0 if a complete document was parsed, error otherwise.
+ */
+int
+json_stream_finish(struct json_stream *js)
+{
+    int rc;
+
+    if (js->js_err) {
+        return js->js_err;
+    }
+    if (js->js_state == JSON_STREAM_S_LITERAL) {
+        rc = json_stream_literal_done(js);
+        if (rc) {
+            js->js_err = rc;
+            return rc;
+        }
+    }
+    if (js->js_state != JSON_STREAM_S_DONE) {
+        js->js_err = JSON_ERR_INCOMPLETE;
+    }
+    return js->js_err;
+}
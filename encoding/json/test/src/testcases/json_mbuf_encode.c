@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+#include "test_json_priv.h"
+
+#define TEST_MBUF_BLOCK_SIZE    64
+#define TEST_MBUF_BLOCK_COUNT   16
+
+static os_membuf_t test_mbuf_mem[
+    OS_MEMPOOL_SIZE(TEST_MBUF_BLOCK_COUNT, TEST_MBUF_BLOCK_SIZE)];
+static struct os_mempool test_mbuf_mempool;
+static struct os_mbuf_pool test_mbuf_pool;
+
+TEST_CASE(test_json_mbuf_encode)
+{
+    static const char expect[] =
+        "{\"str\": \"a \\\"quoted\\\" string long enough to span mbufs\","
+        "\"arr\": [1,2]}";
+    struct json_encoder encoder;
+    struct json_value value;
+    struct os_mbuf *om;
+    char out[sizeof(expect)];
+    int rc;
+
+    rc = os_mempool_init(&test_mbuf_mempool, TEST_MBUF_BLOCK_COUNT,
+                         TEST_MBUF_BLOCK_SIZE, test_mbuf_mem, "json_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mempool,
+                           TEST_MBUF_BLOCK_SIZE, TEST_MBUF_BLOCK_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    om = os_mbuf_get_pkthdr(&test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    json_encoder_init_mbuf(&encoder, om);
+    json_encode_object_start(&encoder);
+    JSON_VALUE_STRING(&value, "a \"quoted\" string long enough to span mbufs");
+    json_encode_object_entry(&encoder, "str", &value);
+    json_encode_array_name(&encoder, "arr");
+    json_encode_array_start(&encoder);
+    JSON_VALUE_INT(&value, 1);
+    json_encode_array_value(&encoder, &value);
+    JSON_VALUE_INT(&value, 2);
+    json_encode_array_value(&encoder, &value);
+    json_encode_array_finish(&encoder);
+    json_encode_object_finish(&encoder);
+
+    TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == sizeof(expect) - 1);
+    rc = os_mbuf_copydata(om, 0, sizeof(expect) - 1, out);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(out, expect, sizeof(expect) - 1));
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json_priv.h"
+
+static char test_stream_log[256];
+static int test_stream_log_len;
+static int test_stream_abort_at;
+
+static const char test_stream_doc[] =
+    " {\"name\": \"a\\\"b\\u00e9\", \"n\":[1, -2.5e3 ,true,false,null],"
+    "\"o\":{\"e\":{}, \"a\":[]}, \"last\" : 42}\n";
+
+static const char test_stream_expect[] =
+    "{K:name;S:a\"b\xc3\xa9;K:n;[N:1;N:-2.5e3;TFZ]K:o;{K:e;{}K:a;[]}"
+    "K:last;N:42;}";
+
+static int
+test_stream_cb(void *arg, int event, char *tok, int len)
+{
+    static const char ev_chars[] = "?{}[]KSNTFZ";
+    char *p;
+
+    TEST_ASSERT(arg == &test_stream_log_len);
+    p = &test_stream_log[test_stream_log_len];
+    *p++ = ev_chars[event];
+    if (tok) {
+        TEST_ASSERT(tok[len] == '\0');
+        *p++ = ':';
+        memcpy(p, tok, len);
+        p += len;
+        *p++ = ';';
+    }
+    test_stream_log_len = p - test_stream_log;
+    TEST_ASSERT(test_stream_log_len < sizeof(test_stream_log));
+    *p = '\0';
+
+    if (test_stream_abort_at && event == test_stream_abort_at) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Parses doc handing it to the parser chunk bytes at a time.
+ */
+static int
+test_stream_parse(const char *doc, int chunk, char *tok, int tok_size)
+{
+    struct json_stream js;
+    int len;
+    int off;
+    int rc;
+
+    test_stream_log_len = 0;
+    test_stream_log[0] = '\0';
+    json_stream_init(&js, test_stream_cb, &test_stream_log_len, tok,
+                     tok_size);
+
+    len = strlen(doc);
+    for (off = 0; off < len; off += chunk) {
+        rc = json_stream_feed(&js, doc + off,
+                              len - off < chunk ? len - off : chunk);
+        if (rc) {
+            TEST_ASSERT(json_stream_finish(&js) == rc);
+            return rc;
+        }
+    }
+    return json_stream_finish(&js);
+}
+
+TEST_CASE(test_json_stream_decode)
+{
+    char tok[16];
+    int chunk;
+    int rc;
+
+    for (chunk = 1; chunk <= sizeof(test_stream_doc); chunk++) {
+        rc = test_stream_parse(test_stream_doc, chunk, tok, sizeof(tok));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(test_stream_log, test_stream_expect));
+    }
+
+    /* top level literal is only complete at the end of input */
+    rc = test_stream_parse("-17", 1, tok, sizeof(tok));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(test_stream_log, "N:-17;"));
+
+    rc = test_stream_parse("{\"a\": [1, 2}", 3, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+
+    rc = test_stream_parse("{\"a\": [1, 2]", 3, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_INCOMPLETE);
+
+    rc = test_stream_parse("{\"a\": 1} x", 3, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+
+    rc = test_stream_parse("{\"a\": tru}", 3, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_BADNUM);
+
+    rc = test_stream_parse("{1: 2}", 3, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_ATTRSTART);
+
+    rc = test_stream_parse("[\"0123456789abcdef\"]", 4, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_STRLONG);
+
+    rc = test_stream_parse("[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]"
+                           "]]]]]]]]]]]]]]]]]", 8, tok, sizeof(tok));
+    TEST_ASSERT(rc == JSON_ERR_DEPTH);
+
+    /* callback stops the parse */
+    test_stream_abort_at = JSON_STREAM_EV_ARR_START;
+    rc = test_stream_parse(test_stream_doc, 5, tok, sizeof(tok));
+    test_stream_abort_at = 0;
+    TEST_ASSERT(rc == -1);
+    TEST_ASSERT(!strcmp(test_stream_log, "{K:name;S:a\"b\xc3\xa9;K:n;["));
+}
@@ -160,10 +160,15 @@ CBOR_API const char *cbor_error_string(CborError error);
 struct cbor_encoder_writer;
 
 typedef int (cbor_encoder_write)(struct cbor_encoder_writer *, const char *data, int len);
+/* Replaces len bytes at offset (counted like bytes_written) with data_len
+ * <= len bytes, moving everything written after them down. */
+typedef int (cbor_encoder_replace)(struct cbor_encoder_writer *, int offset, int len,
+                                   const char *data, int data_len);
 
 typedef struct cbor_encoder_writer {
     cbor_encoder_write *write;
     int                 bytes_written;
+    cbor_encoder_replace *replace;      /* optional */
 } cbor_encoder_writer;
 
 struct cbor_iovec {
@@ -177,10 +182,14 @@ struct CborEncoder {
     void *writer_arg;
     size_t added;
     int flags;
+    int hdr_off;
 };
 typedef struct CborEncoder CborEncoder;
 
 static const size_t CborIndefiniteLength = SIZE_MAX;
+/* Array/map length is counted and filled in on close; needs a writer
+ * with replace(), otherwise the container is indefinite-length. */
+static const size_t CborDeferredLength = SIZE_MAX - 1;
 
 
 CBOR_API void cbor_encoder_init(CborEncoder *encoder, cbor_encoder_writer *pwriter, int flags);
@@ -237,6 +246,7 @@ typedef uint32_t (cbor_reader_get32)(struct cbor_decoder_reader *d, int offset);
 typedef uint64_t (cbor_reader_get64)(struct cbor_decoder_reader *d, int offset);
 typedef uintptr_t (cbor_memcmp)(struct cbor_decoder_reader *d, char *buf, int offset, size_t len);
 typedef uintptr_t (cbor_memcpy)(struct cbor_decoder_reader *d, char *buf, int offset, size_t len);
+typedef const void *(cbor_reader_ptr)(struct cbor_decoder_reader *d, int offset, size_t len);
 
 struct cbor_decoder_reader {
     cbor_reader_get8  *get8;
@@ -246,6 +256,9 @@ struct cbor_decoder_reader {
     cbor_memcmp       *cmp;
     cbor_memcpy       *cpy;
     size_t             message_size;
+    /* Optional; returns a pointer to len contiguous bytes at offset, or
+     * NULL if the reader cannot provide one. */
+    cbor_reader_ptr   *ptr;
 };
 
 struct CborParser
@@ -424,6 +437,9 @@ CBOR_INLINE_API CborError cbor_value_dup_byte_string(const CborValue *value, uin
     return _cbor_value_dup_string(value, (void **)buffer, buflen, next);
 }
 
+CBOR_API CborError cbor_value_get_string_ptr(const CborValue *value, const void **ptr,
+                                             size_t *len, CborValue *next);
+
 /* ### TBD: partial reading API */
 
 CBOR_API CborError cbor_value_text_string_equals(const CborValue *value, const char *string, bool *result);
@@ -30,6 +30,8 @@ struct cbor_buf_writer {
     const uint8_t *end;
 };
 
+int cbor_buf_writer_replace(struct cbor_encoder_writer *arg, int off, int len,
+                            const char *data, int data_len);
 void cbor_buf_writer_init(struct cbor_buf_writer *cb, uint8_t *buffer,
                           size_t data);
 size_t cbor_buf_writer_buffer_size(struct cbor_buf_writer *cb,
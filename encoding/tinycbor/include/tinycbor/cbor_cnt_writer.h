@@ -44,10 +44,21 @@ cbor_cnt_writer(struct cbor_encoder_writer *arg, const char *data, int len) {
     return CborNoError;
 }
 
+    /* lets CborDeferredLength containers be sized exactly as they will
+     * be encoded by a real writer */
+static inline int
+cbor_cnt_writer_replace(struct cbor_encoder_writer *arg, int off, int len,
+                        const char *data, int data_len) {
+    struct CborCntWriter *cb = (struct CborCntWriter *) arg;
+    cb->enc.bytes_written -= len - data_len;
+    return CborNoError;
+}
+
 static inline void
 cbor_cnt_writer_init(struct CborCntWriter *cb) {
     cb->enc.bytes_written = 0;
     cb->enc.write = &cbor_cnt_writer;
+    cb->enc.replace = &cbor_cnt_writer_replace;
 }
 
 #ifdef __cplusplus
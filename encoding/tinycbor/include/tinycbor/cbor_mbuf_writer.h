@@ -33,6 +33,10 @@ struct cbor_mbuf_writer {
 };
 
 void cbor_mbuf_writer_init(struct cbor_mbuf_writer *cb, struct os_mbuf *m);
+int cbor_mbuf_writer(struct cbor_encoder_writer *arg, const char *data,
+                     int len);
+int cbor_mbuf_writer_replace(struct cbor_encoder_writer *arg, int off,
+                             int len, const char *data, int data_len);
 
 #ifdef __cplusplus
 }
@@ -44,6 +44,25 @@ cbor_buf_writer(struct cbor_encoder_writer *arg, const char *data, int len)
     return CborNoError;
 }
 
+int
+cbor_buf_writer_replace(struct cbor_encoder_writer *arg, int off, int len,
+                        const char *data, int data_len)
+{
+    struct cbor_buf_writer *cb = (struct cbor_buf_writer *) arg;
+    uint8_t *at;
+
+    if (off < 0 || off + len > cb->enc.bytes_written || data_len > len) {
+        return CborErrorInternalError;
+    }
+
+    at = cb->ptr - cb->enc.bytes_written + off;
+    memcpy(at, data, data_len);
+    memmove(at + data_len, at + len, cb->ptr - (at + len));
+    cb->ptr -= len - data_len;
+    cb->enc.bytes_written -= len - data_len;
+    return CborNoError;
+}
+
 void
 cbor_buf_writer_init(struct cbor_buf_writer *cb, uint8_t *buffer, size_t size)
 {
@@ -51,6 +70,7 @@ cbor_buf_writer_init(struct cbor_buf_writer *cb, uint8_t *buffer, size_t size)
     cb->end = buffer + size;
     cb->enc.bytes_written = 0;
     cb->enc.write = cbor_buf_writer;
+    cb->enc.replace = cbor_buf_writer_replace;
 }
 
 size_t
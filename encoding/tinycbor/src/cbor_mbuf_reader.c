@@ -21,14 +21,117 @@
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 
+/*
+ * The reader keeps a cursor on the mbuf of the most recent access.  The
+ * parser reads mostly front to back, so locating the next byte is a step
+ * forward from the cursor rather than a walk from the head of the chain.
+ */
+
+/**
+ * Returns the mbuf holding packet offset off and sets *moff to the offset
+ * within it; NULL if off is past the end of the chain.
+ */
+static struct os_mbuf *
+cbor_mbuf_reader_seek(struct cbor_mbuf_reader *cb, int off, int *moff)
+{
+    struct os_mbuf *m;
+    int start;
+
+    if (cb->cur != NULL && off >= cb->cur_off) {
+        m = cb->cur;
+        start = cb->cur_off;
+    } else {
+        m = cb->m;
+        start = 0;
+    }
+
+    while (m != NULL && off >= start + m->om_len) {
+        start += m->om_len;
+        m = SLIST_NEXT(m, om_next);
+    }
+    if (m == NULL) {
+        return NULL;
+    }
+
+    cb->cur = m;
+    cb->cur_off = start;
+    *moff = off - start;
+    return m;
+}
+
+/**
+ * Copies (dst != NULL) or compares (cmp != NULL) len bytes at packet
+ * offset off.  Returns 0 on success / match.
+ */
+static int
+cbor_mbuf_reader_walk(struct cbor_mbuf_reader *cb, int off, uint8_t *dst,
+                      const uint8_t *cmp, size_t len)
+{
+    struct os_mbuf *m;
+    size_t chunk;
+    int moff;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    m = cbor_mbuf_reader_seek(cb, off, &moff);
+    while (1) {
+        if (m == NULL) {
+            return -1;
+        }
+
+        chunk = min(len, (size_t)(m->om_len - moff));
+        if (dst != NULL) {
+            memcpy(dst, m->om_data + moff, chunk);
+            dst += chunk;
+        } else {
+            if (memcmp(cmp, m->om_data + moff, chunk) != 0) {
+                return 1;
+            }
+            cmp += chunk;
+        }
+        len -= chunk;
+        if (len == 0) {
+            return 0;
+        }
+
+        cb->cur_off += m->om_len;
+        m = SLIST_NEXT(m, om_next);
+        cb->cur = m;
+        moff = 0;
+    }
+}
+
+static void
+cbor_mbuf_reader_read(struct cbor_mbuf_reader *cb, int offset, void *dst,
+                      size_t len)
+{
+    struct os_mbuf *m;
+    int off;
+    int moff;
+
+    off = offset + cb->init_off;
+    m = cbor_mbuf_reader_seek(cb, off, &moff);
+    if (m != NULL && moff + len <= m->om_len) {
+        memcpy(dst, m->om_data + moff, len);
+    } else {
+        cbor_mbuf_reader_walk(cb, off, dst, NULL, len);
+    }
+}
+
 static uint8_t
 cbor_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
-    uint8_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
+    struct os_mbuf *m;
+    int moff;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return val;
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &moff);
+    if (m == NULL) {
+        return 0;
+    }
+    return m->om_data[moff];
 }
 
 static uint16_t
@@ -37,7 +140,7 @@ cbor_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset)
     uint16_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohs(val);
 }
 
@@ -47,7 +150,7 @@ cbor_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset)
     uint32_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohl(val);
 }
 
@@ -57,7 +160,7 @@ cbor_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset)
     uint64_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohll(val);
 }
 
@@ -66,21 +169,33 @@ cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
                      size_t len)
 {
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len) == 0;
+
+    return cbor_mbuf_reader_walk(cb, offset + cb->init_off, NULL,
+                                 (const uint8_t *)buf, len) == 0;
 }
 
 static uintptr_t
 cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
                      size_t len)
 {
-    int rc;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
-    if (rc == 0) {
-        return true;
+    return cbor_mbuf_reader_walk(cb, offset + cb->init_off, (uint8_t *)dst,
+                                 NULL, len) == 0;
+}
+
+static const void *
+cbor_mbuf_reader_ptr(struct cbor_decoder_reader *d, int offset, size_t len)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
+    struct os_mbuf *m;
+    int moff;
+
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &moff);
+    if (m == NULL || moff + len > m->om_len) {
+        return NULL;
     }
-    return false;
+    return m->om_data + moff;
 }
 
 void
@@ -95,10 +210,13 @@ cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
     cb->r.get64 = &cbor_mbuf_reader_get64;
     cb->r.cmp = &cbor_mbuf_reader_cmp;
     cb->r.cpy = &cbor_mbuf_reader_cpy;
+    cb->r.ptr = &cbor_mbuf_reader_ptr;
 
     assert(OS_MBUF_IS_PKTHDR(m));
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
+    cb->cur = NULL;
+    cb->cur_off = 0;
     cb->init_off = initial_offset;
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
@@ -37,11 +37,56 @@ cbor_mbuf_writer(struct cbor_encoder_writer *arg, const char *data, int len)
 }
 
 
+/*
+ * The encoding starts wherever the packet ended when the writer was
+ * initialized, so offsets are converted relative to the current end.
+ * The bytes are dropped from inside the mbufs that hold them; the chain
+ * keeps its shape.
+ */
+int
+cbor_mbuf_writer_replace(struct cbor_encoder_writer *arg, int off, int len,
+                         const char *data, int data_len)
+{
+    struct cbor_mbuf_writer *cb = (struct cbor_mbuf_writer *) arg;
+    struct os_mbuf *m;
+    uint16_t moff;
+    int drop;
+    int pkt_off;
+    int n;
+
+    if (off < 0 || off + len > cb->enc.bytes_written || data_len > len) {
+        return CborErrorInternalError;
+    }
+
+    pkt_off = OS_MBUF_PKTLEN(cb->m) - cb->enc.bytes_written + off;
+    drop = len - data_len;
+
+    /* New bytes go at the end of the old range; the front is dropped. */
+    if (os_mbuf_copyinto(cb->m, pkt_off + drop, data, data_len)) {
+        return CborErrorInternalError;
+    }
+
+    m = os_mbuf_off(cb->m, pkt_off, &moff);
+    while (drop > 0 && m != NULL) {
+        n = min(drop, m->om_len - moff);
+        memmove(m->om_data + moff, m->om_data + moff + n,
+                m->om_len - moff - n);
+        m->om_len -= n;
+        drop -= n;
+        m = SLIST_NEXT(m, om_next);
+        moff = 0;
+    }
+    OS_MBUF_PKTHDR(cb->m)->omp_len -= len - data_len;
+    cb->enc.bytes_written -= len - data_len;
+    return CborNoError;
+}
+
 void
 cbor_mbuf_writer_init(struct cbor_mbuf_writer *cb, struct os_mbuf *m)
 {
     cb->m = m;
     cb->enc.bytes_written = 0;
     cb->enc.write = &cbor_mbuf_writer;
+    cb->enc.replace = &cbor_mbuf_writer_replace;
 }
 
@@ -249,15 +249,21 @@ static inline CborError append_byte_to_buffer(CborEncoder *encoder, uint8_t byte
     return append_to_buffer(encoder, &byte, 1);
 }
 
-static inline CborError encode_number_no_update(CborEncoder *encoder, uint64_t ui, uint8_t shiftedMajorType)
+/* Set on containers created with CborDeferredLength. */
+#define CborEncoderFlag_DeferredLength  0x40
+
+/* Size of the header reserved for a CborDeferredLength container. */
+#define DEFERRED_HDR_LEN                5
+
+/* Encodes the head of a data item into the end of buf, returns its start. */
+static inline uint8_t *encode_head(uint64_t buf[2], uint64_t ui, uint8_t shiftedMajorType)
 {
     /* Little-endian would have been so much more convenient here:
      * We could just write at the beginning of buf but append_to_buffer
      * only the necessary bytes.
      * Since it has to be big endian, do it the other way around:
      * write from the end. */
-    uint64_t buf[2];
-    uint8_t *const bufend = (uint8_t *)buf + sizeof(buf);
+    uint8_t *const bufend = (uint8_t *)buf + 2 * sizeof(uint64_t);
     uint8_t *bufstart = bufend - 1;
     put64(buf + 1, ui);     /* we probably have a bunch of zeros in the beginning */
 
@@ -275,6 +281,15 @@ static inline CborError encode_number_no_update(CborEncoder *encoder, uint64_t u
         *bufstart = shiftedMajorType + Value8Bit + more;
     }
 
+    return bufstart;
+}
+
+static inline CborError encode_number_no_update(CborEncoder *encoder, uint64_t ui, uint8_t shiftedMajorType)
+{
+    uint64_t buf[2];
+    uint8_t *const bufend = (uint8_t *)buf + sizeof(buf);
+    uint8_t *bufstart = encode_head(buf, ui, shiftedMajorType);
+
     return append_to_buffer(encoder, bufstart, bufend - bufstart);
 }
 
@@ -457,6 +472,7 @@ __attribute__((noinline))
 static CborError create_container(CborEncoder *encoder, CborEncoder *container, size_t length, uint8_t shiftedMajorType)
 {
     CborError err;
+    uint8_t hdr[DEFERRED_HDR_LEN];
     container->writer = encoder->writer;
     ++encoder->added;
     container->added = 0;
@@ -465,7 +481,14 @@ static CborError create_container(CborEncoder *encoder, CborEncoder *container,
     cbor_static_assert(((ArrayType << MajorTypeShift) & CborIteratorFlag_ContainerIsMap) == 0);
     container->flags = shiftedMajorType & CborIteratorFlag_ContainerIsMap;
 
-    if (length == CborIndefiniteLength) {
+    if (length == CborDeferredLength && encoder->writer->replace) {
+        /* Reserve room for a 32-bit length; shrunk on close. */
+        container->flags |= CborEncoderFlag_DeferredLength;
+        container->hdr_off = encoder->writer->bytes_written;
+        memset(hdr, 0, sizeof(hdr));
+        hdr[0] = shiftedMajorType + Value32Bit;
+        err = append_to_buffer(container, hdr, sizeof(hdr));
+    } else if (length == CborIndefiniteLength || length == CborDeferredLength) {
         container->flags |= CborIteratorFlag_UnknownLength;
         err = append_byte_to_buffer(container, shiftedMajorType + IndefiniteLength);
     } else {
@@ -487,7 +510,9 @@ static CborError create_container(CborEncoder *encoder, CborEncoder *container,
  * The number of items inserted into the array must be exactly \a length items,
  * otherwise the stream is invalid. If the number of items is not known when
  * creating the array, the constant \ref CborIndefiniteLength may be passed as
- * length instead.
+ * length instead.  With \ref CborDeferredLength the items are counted and the
+ * length is filled in by cbor_encoder_close_container(), provided the writer
+ * implements replace(); otherwise this is the same as CborIndefiniteLength.
  *
  * \sa cbor_encoder_create_map
  */
@@ -505,8 +530,9 @@ CborError cbor_encoder_create_array(CborEncoder *encoder, CborEncoder *arrayEnco
  *
  * The number of pair of items inserted into the map must be exactly \a length
  * items, otherwise the stream is invalid. If the number of items is not known
- * when creating the map, the constant \ref CborIndefiniteLength may be passed as
- * length instead.
+ * when creating the map, the constant \ref CborIndefiniteLength or
+ * \ref CborDeferredLength may be passed as length instead (see
+ * cbor_encoder_create_array()).
  *
  * \b{Implementation limitation:} TinyCBOR cannot encode more than SIZE_MAX/2
  * key-value pairs in the stream. If the length \a length is larger than this
@@ -516,7 +542,8 @@ CborError cbor_encoder_create_array(CborEncoder *encoder, CborEncoder *arrayEnco
  */
 CborError cbor_encoder_create_map(CborEncoder *encoder, CborEncoder *mapEncoder, size_t length)
 {
-    if (length != CborIndefiniteLength && length > SIZE_MAX / 2)
+    if (length != CborIndefiniteLength && length != CborDeferredLength &&
+        length > SIZE_MAX / 2)
         return CborErrorDataTooLarge;
     return create_container(encoder, mapEncoder, length, MapType << MajorTypeShift);
 }
@@ -549,8 +576,25 @@ CborError cbor_encoder_create_indef_byte_string(CborEncoder *encoder, CborEncode
  */
 CborError cbor_encoder_close_container(CborEncoder *encoder, const CborEncoder *containerEncoder)
 {
+    uint64_t buf[2];
+    uint8_t *const bufend = (uint8_t *)buf + sizeof(buf);
+    uint8_t *bufstart;
+    size_t count;
+
     encoder->writer = containerEncoder->writer;
 
+    if (containerEncoder->flags & CborEncoderFlag_DeferredLength) {
+        count = containerEncoder->added;
+        if (containerEncoder->flags & CborIteratorFlag_ContainerIsMap) {
+            count /= 2;
+            bufstart = encode_head(buf, count, MapType << MajorTypeShift);
+        } else {
+            bufstart = encode_head(buf, count, ArrayType << MajorTypeShift);
+        }
+        return encoder->writer->replace(encoder->writer, containerEncoder->hdr_off,
+                                        DEFERRED_HDR_LEN, (const char *)bufstart,
+                                        bufend - bufstart);
+    }
     if (containerEncoder->flags & CborIteratorFlag_UnknownLength)
         return append_byte_to_buffer(encoder, BreakByte);
     return CborNoError;
@@ -984,11 +984,16 @@ static CborError iterate_string_chunks(const CborValue *value, char *buffer, siz
 
     /* is there enough room for the ending NUL byte? */
     if (*result && *buflen > total) {
-        /* we are just trying to write a NULL byte here,, but this is hard
-         * because this is called by function pointer with an abstract
-         * reader.  Since this is the output buffer, we can assume that if
-         * we have a valid buffer its ok to write a NULL here  */
-        if(buffer) {
+        if (func == value->parser->d->cmp) {
+            /* comparing against a longer string; it must end here too.
+             * buffer is the caller's string, don't write to it. */
+            *result = buffer[total] == '\0';
+        } else if (buffer) {
+            /* we are just trying to write a NULL byte here,, but this is
+             * hard because this is called by function pointer with an
+             * abstract reader.  Since this is the output buffer, we can
+             * assume that if we have a valid buffer its ok to write a NULL
+             * here  */
             *(buffer + total) = '\0';
         }
     }
@@ -1077,6 +1082,59 @@ CborError _cbor_value_copy_string(const CborValue *value, void *buffer,
                  copied_all ? CborNoError : CborErrorOutOfMemory;
 }
 
+/**
+ * Retrieves a pointer to the contents of the byte or text string at \a value
+ * without copying it.  This works when the string has a known length and
+ * the reader holds it in one contiguous piece (for an mbuf chain: within
+ * a single mbuf).
+ *
+ * On success \c{*ptr} points to the \c{*len} bytes of the string, which are
+ * not NUL-terminated, and \a next, if not null, is advanced past the string.
+ * If no direct pointer is available, \c{*ptr} is set to NULL, \a next is
+ * left untouched and the caller should use cbor_value_copy_text_string()
+ * or cbor_value_copy_byte_string() instead.
+ *
+ * The pointer stays valid for as long as the underlying buffer does.
+ *
+ * \sa cbor_value_copy_text_string(), cbor_value_copy_byte_string()
+ */
+CborError cbor_value_get_string_ptr(const CborValue *value, const void **ptr,
+                                    size_t *len, CborValue *next)
+{
+    assert(cbor_value_is_byte_string(value) || cbor_value_is_text_string(value));
+
+    const void *p;
+    size_t total;
+    CborError err;
+    int offset = value->offset;
+
+    *ptr = NULL;
+    if (!cbor_value_is_length_known(value) || value->parser->d->ptr == NULL)
+        return CborNoError;
+
+    err = extract_length(value->parser, &offset, &total);
+    if (err)
+        return err;
+    if (total > (size_t)(value->parser->end - offset))
+        return CborErrorUnexpectedEOF;
+
+    if (total == 0)
+        p = "";
+    else
+        p = value->parser->d->ptr(value->parser->d, offset, total);
+    if (p == NULL)
+        return CborNoError;
+
+    *ptr = p;
+    *len = total;
+    if (next) {
+        *next = *value;
+        next->offset = offset + total;
+        return preparse_next_value(next);
+    }
+    return CborNoError;
+}
+
 /**
  * Compares the entry \a value with the string \a string and store the result
  * in \a result. If the value is different from \a string \a result will
@@ -46,9 +46,36 @@ struct disk_ops {
 int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *dops);
 struct disk_ops *disk_ops_for(const char *disk_name);
 char *disk_fs_for(const char *disk_name);
+
+/*
+ * Path lookups which work on the caller's string, without allocating.
+ * Paths are of the form <disk>:<filepath>.
+ */
+struct disk_ops *disk_ops_for_path(const char *path);
+const char *disk_fs_for_path(const char *path);
+/* Length of the disk name in path, or 0 if path has no disk prefix. */
+size_t disk_name_len(const char *path);
+/* Part of path following the disk prefix; path itself if none. */
+const char *disk_filepath(const char *path);
+
+/*
+ * As above, but return copies of the disk name and file path which the
+ * caller must free.
+ */
 char *disk_name_from_path(const char *path);
 char *disk_filepath_from_path(const char *path);
 
+#if MYNEWT_VAL(DISK_CACHE)
+#define DISK_CACHE_SECTOR_SZ    512
+
+int disk_cache_read(struct disk_ops *dops, uint8_t id, uint32_t sector,
+                    void *buf, uint32_t count);
+int disk_cache_write(struct disk_ops *dops, uint8_t id, uint32_t sector,
+                     const void *buf, uint32_t count);
+int disk_cache_sync(struct disk_ops *dops, uint8_t id);
+void disk_cache_invalidate(struct disk_ops *dops, uint8_t id);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 
 struct disk_info {
     const char *disk_name;
+    size_t name_len;
     const char *fs_name;
     struct disk_ops *dops;
 
@@ -52,6 +53,7 @@ int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *d
     }
 
     info->disk_name = disk_name;
+    info->name_len = strlen(disk_name);
     info->fs_name = fs_name;
     info->dops = dops;
 
@@ -60,6 +62,25 @@ int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *d
     return 0;
 }
 
+/*
+ * Finds the disk whose name is the prefix of path, up to the colon.  The
+ * path is not copied or modified.
+ */
+static struct disk_info *
+disk_info_for_path(const char *path)
+{
+    struct disk_info *sc;
+
+    SLIST_FOREACH(sc, &disks, sc_next) {
+        if (strncmp(sc->disk_name, path, sc->name_len) == 0 &&
+            path[sc->name_len] == ':') {
+            return sc;
+        }
+    }
+
+    return NULL;
+}
+
 struct disk_ops *
 disk_ops_for(const char *disk_name)
 {
@@ -92,6 +113,54 @@ disk_fs_for(const char *disk_name)
     return NULL;
 }
 
+struct disk_ops *
+disk_ops_for_path(const char *path)
+{
+    struct disk_info *sc;
+
+    sc = disk_info_for_path(path);
+    if (!sc) {
+        return NULL;
+    }
+    return sc->dops;
+}
+
+const char *
+disk_fs_for_path(const char *path)
+{
+    struct disk_info *sc;
+
+    sc = disk_info_for_path(path);
+    if (!sc) {
+        return NULL;
+    }
+    return sc->fs_name;
+}
+
+size_t
+disk_name_len(const char *path)
+{
+    const char *colon;
+
+    colon = strchr(path, ':');
+    if (!colon) {
+        return 0;
+    }
+    return colon - path;
+}
+
+const char *
+disk_filepath(const char *path)
+{
+    const char *colon;
+
+    colon = strchr(path, ':');
+    if (!colon) {
+        return path;
+    }
+    return colon + 1;
+}
+
 char *
 disk_name_from_path(const char *path)
 {
@@ -0,0 +1,383 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include <disk/disk.h>
+
+#if MYNEWT_VAL(DISK_CACHE)
+
+#define DISK_CACHE_F_VALID      0x01
+#define DISK_CACHE_F_DIRTY      0x02
+
+#define DISK_CACHE_NUM          MYNEWT_VAL(DISK_CACHE_SECTORS)
+#define DISK_CACHE_MERGE_NUM    MYNEWT_VAL(DISK_CACHE_MERGE_SECTORS)
+
+/*
+ * Requests of this many sectors or more are treated as bulk file data: they
+ * go straight to the driver, so streaming a file does not flush the FAT and
+ * directory sectors out of the cache.  Single sectors are always cached.
+ */
+#define DISK_CACHE_BULK_MIN     (DISK_CACHE_NUM / 4 + 1)
+
+struct disk_cache_entry {
+    struct disk_ops *dce_dops;
+    uint32_t dce_sector;
+    uint32_t dce_used;          /* Value of disk_cache_clock at last use. */
+    uint8_t dce_id;
+    uint8_t dce_flags;
+};
+
+static struct disk_cache_entry disk_cache_entries[DISK_CACHE_NUM];
+static uint8_t disk_cache_data[DISK_CACHE_NUM][DISK_CACHE_SECTOR_SZ];
+#if DISK_CACHE_MERGE_NUM > 1
+static uint8_t disk_cache_merge_buf[DISK_CACHE_MERGE_NUM *
+                                    DISK_CACHE_SECTOR_SZ];
+#endif
+static uint32_t disk_cache_clock;
+
+static int
+disk_cache_entry_idx(const struct disk_cache_entry *dce)
+{
+    return dce - disk_cache_entries;
+}
+
+static void
+disk_cache_touch(struct disk_cache_entry *dce)
+{
+    dce->dce_used = ++disk_cache_clock;
+}
+
+static struct disk_cache_entry *
+disk_cache_find(struct disk_ops *dops, uint8_t id, uint32_t sector)
+{
+    struct disk_cache_entry *dce;
+    int i;
+
+    for (i = 0; i < DISK_CACHE_NUM; i++) {
+        dce = disk_cache_entries + i;
+        if (dce->dce_flags & DISK_CACHE_F_VALID &&
+            dce->dce_dops == dops &&
+            dce->dce_id == id &&
+            dce->dce_sector == sector) {
+
+            return dce;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+disk_cache_write_out(struct disk_cache_entry *dce)
+{
+    int rc;
+
+    rc = dce->dce_dops->write(dce->dce_id,
+                              dce->dce_sector * DISK_CACHE_SECTOR_SZ,
+                              disk_cache_data[disk_cache_entry_idx(dce)],
+                              DISK_CACHE_SECTOR_SZ);
+    if (rc < 0) {
+        return DISK_EHW;
+    }
+
+    dce->dce_flags &= ~DISK_CACHE_F_DIRTY;
+    return 0;
+}
+
+/**
+ * Picks an entry for a new sector: an unused one if possible, otherwise the
+ * least recently used one, which is written out first if dirty.
+ */
+static int
+disk_cache_alloc(struct disk_ops *dops, uint8_t id, uint32_t sector,
+                 struct disk_cache_entry **out_dce)
+{
+    struct disk_cache_entry *victim;
+    struct disk_cache_entry *dce;
+    int rc;
+    int i;
+
+    victim = NULL;
+    for (i = 0; i < DISK_CACHE_NUM; i++) {
+        dce = disk_cache_entries + i;
+        if (!(dce->dce_flags & DISK_CACHE_F_VALID)) {
+            victim = dce;
+            break;
+        }
+        if (victim == NULL ||
+            (int32_t)(dce->dce_used - victim->dce_used) < 0) {
+            victim = dce;
+        }
+    }
+
+    if (victim->dce_flags & DISK_CACHE_F_DIRTY) {
+        rc = disk_cache_write_out(victim);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    victim->dce_dops = dops;
+    victim->dce_id = id;
+    victim->dce_sector = sector;
+    victim->dce_flags = DISK_CACHE_F_VALID;
+    disk_cache_touch(victim);
+
+    *out_dce = victim;
+    return 0;
+}
+
+/**
+ * Reads sectors through the cache.  Cached sectors are copied from RAM; each
+ * run of consecutive missing sectors is read from the driver in a single
+ * request.
+ *
+ * @param dops                  The driver to read from.
+ * @param id                    The driver's disk ID.
+ * @param sector                The first sector to read.
+ * @param buf                   The buffer to read into.
+ * @param count                 The number of sectors to read.
+ *
+ * @return                      0 on success; DISK_EHW on driver failure.
+ */
+int
+disk_cache_read(struct disk_ops *dops, uint8_t id, uint32_t sector,
+                void *buf, uint32_t count)
+{
+    struct disk_cache_entry *dce;
+    uint8_t *dst;
+    uint32_t run;
+    uint32_t i;
+    uint32_t j;
+    int rc;
+
+    dst = buf;
+    i = 0;
+    while (i < count) {
+        dce = disk_cache_find(dops, id, sector + i);
+        if (dce != NULL) {
+            memcpy(dst + i * DISK_CACHE_SECTOR_SZ,
+                   disk_cache_data[disk_cache_entry_idx(dce)],
+                   DISK_CACHE_SECTOR_SZ);
+            disk_cache_touch(dce);
+            i++;
+            continue;
+        }
+
+        run = 1;
+        while (i + run < count &&
+               disk_cache_find(dops, id, sector + i + run) == NULL) {
+            run++;
+        }
+
+        rc = dops->read(id, (sector + i) * DISK_CACHE_SECTOR_SZ,
+                        dst + i * DISK_CACHE_SECTOR_SZ,
+                        run * DISK_CACHE_SECTOR_SZ);
+        if (rc < 0) {
+            return DISK_EHW;
+        }
+
+        if (count < DISK_CACHE_BULK_MIN || count == 1) {
+            for (j = i; j < i + run; j++) {
+                rc = disk_cache_alloc(dops, id, sector + j, &dce);
+                if (rc != 0) {
+                    return rc;
+                }
+                memcpy(disk_cache_data[disk_cache_entry_idx(dce)],
+                       dst + j * DISK_CACHE_SECTOR_SZ, DISK_CACHE_SECTOR_SZ);
+            }
+        }
+
+        i += run;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes sectors through the cache.  Small writes are kept in the cache
+ * until disk_cache_sync() or eviction; bulk writes go straight to the
+ * driver, updating any cached copies.
+ *
+ * @param dops                  The driver to write to.
+ * @param id                    The driver's disk ID.
+ * @param sector                The first sector to write.
+ * @param buf                   The data to write.
+ * @param count                 The number of sectors to write.
+ *
+ * @return                      0 on success; DISK_EHW on driver failure.
+ */
+int
+disk_cache_write(struct disk_ops *dops, uint8_t id, uint32_t sector,
+                 const void *buf, uint32_t count)
+{
+    struct disk_cache_entry *dce;
+    const uint8_t *src;
+    uint32_t i;
+    int rc;
+
+    src = buf;
+
+    if (count >= DISK_CACHE_BULK_MIN && count > 1) {
+        rc = dops->write(id, sector * DISK_CACHE_SECTOR_SZ, buf,
+                         count * DISK_CACHE_SECTOR_SZ);
+        if (rc < 0) {
+            return DISK_EHW;
+        }
+
+        for (i = 0; i < count; i++) {
+            dce = disk_cache_find(dops, id, sector + i);
+            if (dce != NULL) {
+                memcpy(disk_cache_data[disk_cache_entry_idx(dce)],
+                       src + i * DISK_CACHE_SECTOR_SZ, DISK_CACHE_SECTOR_SZ);
+                dce->dce_flags &= ~DISK_CACHE_F_DIRTY;
+            }
+        }
+
+        return 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        dce = disk_cache_find(dops, id, sector + i);
+        if (dce == NULL) {
+            rc = disk_cache_alloc(dops, id, sector + i, &dce);
+            if (rc != 0) {
+                return rc;
+            }
+        } else {
+            disk_cache_touch(dce);
+        }
+
+        memcpy(disk_cache_data[disk_cache_entry_idx(dce)],
+               src + i * DISK_CACHE_SECTOR_SZ, DISK_CACHE_SECTOR_SZ);
+        dce->dce_flags |= DISK_CACHE_F_DIRTY;
+    }
+
+    return 0;
+}
+
+static struct disk_cache_entry *
+disk_cache_first_dirty(struct disk_ops *dops, uint8_t id)
+{
+    struct disk_cache_entry *first;
+    struct disk_cache_entry *dce;
+    int i;
+
+    first = NULL;
+    for (i = 0; i < DISK_CACHE_NUM; i++) {
+        dce = disk_cache_entries + i;
+        if (dce->dce_flags & DISK_CACHE_F_DIRTY &&
+            dce->dce_dops == dops &&
+            dce->dce_id == id &&
+            (first == NULL || dce->dce_sector < first->dce_sector)) {
+
+            first = dce;
+        }
+    }
+
+    return first;
+}
+
+/**
+ * Writes all dirty sectors of a disk to the driver, in ascending order.
+ * Runs of consecutive dirty sectors are written in a single request, up to
+ * DISK_CACHE_MERGE_SECTORS at a time.
+ *
+ * @param dops                  The driver to sync.
+ * @param id                    The driver's disk ID.
+ *
+ * @return                      0 on success; DISK_EHW on driver failure.
+ */
+int
+disk_cache_sync(struct disk_ops *dops, uint8_t id)
+{
+    struct disk_cache_entry *dce;
+#if DISK_CACHE_MERGE_NUM > 1
+    struct disk_cache_entry *run[DISK_CACHE_MERGE_NUM];
+    struct disk_cache_entry *next;
+    int run_len;
+    int i;
+#endif
+    int rc;
+
+    while ((dce = disk_cache_first_dirty(dops, id)) != NULL) {
+#if DISK_CACHE_MERGE_NUM > 1
+        run[0] = dce;
+        run_len = 1;
+        while (run_len < DISK_CACHE_MERGE_NUM) {
+            next = disk_cache_find(dops, id, dce->dce_sector + run_len);
+            if (next == NULL || !(next->dce_flags & DISK_CACHE_F_DIRTY)) {
+                break;
+            }
+            run[run_len++] = next;
+        }
+
+        if (run_len > 1) {
+            for (i = 0; i < run_len; i++) {
+                memcpy(disk_cache_merge_buf + i * DISK_CACHE_SECTOR_SZ,
+                       disk_cache_data[disk_cache_entry_idx(run[i])],
+                       DISK_CACHE_SECTOR_SZ);
+            }
+
+            rc = dops->write(id, dce->dce_sector * DISK_CACHE_SECTOR_SZ,
+                             disk_cache_merge_buf,
+                             run_len * DISK_CACHE_SECTOR_SZ);
+            if (rc < 0) {
+                return DISK_EHW;
+            }
+
+            for (i = 0; i < run_len; i++) {
+                run[i]->dce_flags &= ~DISK_CACHE_F_DIRTY;
+            }
+            continue;
+        }
+#endif
+
+        rc = disk_cache_write_out(dce);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Drops every cached sector of a disk, including unsynced writes.  Use when
+ * the medium has been removed or replaced.
+ *
+ * @param dops                  The driver whose sectors to drop.
+ * @param id                    The driver's disk ID.
+ */
+void
+disk_cache_invalidate(struct disk_ops *dops, uint8_t id)
+{
+    struct disk_cache_entry *dce;
+    int i;
+
+    for (i = 0; i < DISK_CACHE_NUM; i++) {
+        dce = disk_cache_entries + i;
+        if (dce->dce_dops == dops && dce->dce_id == id) {
+            dce->dce_flags = 0;
+        }
+    }
+}
+
+#endif
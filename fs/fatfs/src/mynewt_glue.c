@@ -178,22 +178,23 @@ struct mounted_disk {
 static SLIST_HEAD(, mounted_disk) mounted_disks = SLIST_HEAD_INITIALIZER();
 
 static int
-drivenumber_from_disk(char *disk_name)
+drivenumber_from_path(const char *filepath)
 {
     struct mounted_disk *sc;
     struct mounted_disk *new_disk;
     int disk_number;
     FATFS *fs;
     char path[DRIVE_LEN];
+    size_t len;
 
+    len = disk_name_len(filepath);
     disk_number = 0;
-    if (disk_name) {
-        SLIST_FOREACH(sc, &mounted_disks, sc_next) {
-            if (strcmp(sc->disk_name, disk_name) == 0) {
-                return sc->disk_number;
-            }
-            disk_number++;
+    SLIST_FOREACH(sc, &mounted_disks, sc_next) {
+        if (strncmp(sc->disk_name, filepath, len) == 0 &&
+            sc->disk_name[len] == '\0') {
+            return sc->disk_number;
         }
+        disk_number++;
     }
 
     /* XXX: check for errors? */
@@ -203,9 +204,11 @@ drivenumber_from_disk(char *disk_name)
 
     /* FIXME */
     new_disk = malloc(sizeof(struct mounted_disk));
-    new_disk->disk_name = strdup(disk_name);
+    new_disk->disk_name = malloc(len + 1);
+    memcpy(new_disk->disk_name, filepath, len);
+    new_disk->disk_name[len] = '\0';
     new_disk->disk_number = disk_number;
-    new_disk->dops = disk_ops_for(disk_name);
+    new_disk->dops = disk_ops_for_path(filepath);
     SLIST_INSERT_HEAD(&mounted_disks, new_disk, sc_next);
 
     return disk_number;
@@ -218,9 +221,7 @@ fatfs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
     FIL *out_file = NULL;
     BYTE mode;
     struct fatfs_file *file = NULL;
-    char *disk;
     int number;
-    char *filepath;
     char drivepath[255 + DRIVE_LEN];  /* FIXME */
     int rc;
 
@@ -251,11 +252,8 @@ fatfs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
         mode |= FA_CREATE_ALWAYS;
     }
 
-    disk = disk_name_from_path(path);
-    number = drivenumber_from_disk(disk);
-    filepath = disk_filepath_from_path(path);
-    sprintf(drivepath, "%d:%s", number, filepath);
-    free(filepath);
+    number = drivenumber_from_path(path);
+    sprintf(drivepath, "%d:%s", number, disk_filepath(path));
 
     res = f_open(out_file, drivepath, mode);
     if (res != FR_OK) {
@@ -383,9 +381,7 @@ fatfs_opendir(const char *path, struct fs_dir **out_fs_dir)
     FRESULT res;
     FATFS_DIR *out_dir = NULL;
     struct fatfs_dir *dir = NULL;
-    char *disk;
     int number;
-    char *filepath;
     char drivepath[255 + DRIVE_LEN];  /* FIXME */
     int rc;
 
@@ -401,11 +397,8 @@ fatfs_opendir(const char *path, struct fs_dir **out_fs_dir)
         goto out;
     }
 
-    disk = disk_name_from_path(path);
-    number = drivenumber_from_disk(disk);
-    filepath = disk_filepath_from_path(path);
-    sprintf(drivepath, "%d:%s", number, filepath);
-    free(filepath);
+    number = drivenumber_from_path(path);
+    sprintf(drivepath, "%d:%s", number, disk_filepath(path));
 
     res = f_opendir(out_dir, drivepath);
     if (res != FR_OK) {
@@ -525,10 +518,19 @@ disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
         return STA_NOINIT;
     }
 
+#if MYNEWT_VAL(DISK_CACHE)
+    (void)address;
+    (void)num_bytes;
+    rc = disk_cache_read(dops, pdrv, sector, buff, count);
+    if (rc != 0) {
+        return STA_NOINIT;
+    }
+#else
     rc = dops->read(pdrv, address, (void *) buff, num_bytes);
     if (rc < 0) {
         return STA_NOINIT;
     }
+#endif
 
     return RES_OK;
 }
@@ -550,10 +552,19 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
         return STA_NOINIT;
     }
 
+#if MYNEWT_VAL(DISK_CACHE)
+    (void)address;
+    (void)num_bytes;
+    rc = disk_cache_write(dops, pdrv, sector, buff, count);
+    if (rc != 0) {
+        return STA_NOINIT;
+    }
+#else
     rc = dops->write(pdrv, address, (const void *) buff, num_bytes);
     if (rc < 0) {
         return STA_NOINIT;
     }
+#endif
 
     return RES_OK;
 }
@@ -561,6 +572,20 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 DRESULT
 disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
 {
+#if MYNEWT_VAL(DISK_CACHE)
+    struct disk_ops *dops;
+
+    if (cmd == CTRL_SYNC) {
+        dops = dops_from_handle(pdrv);
+        if (dops == NULL) {
+            return RES_NOTRDY;
+        }
+        if (disk_cache_sync(dops, pdrv) != 0) {
+            return RES_ERROR;
+        }
+    }
+#endif
+
     return RES_OK;
 }
 
@@ -33,6 +33,9 @@ extern "C" {
 
 #include "os/mynewt.h"
 #include "flash_map/flash_map.h"
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+#include "stats/stats.h"
+#endif
 
 #define FCB_MAX_LEN	(CHAR_MAX | CHAR_MAX << 7) /* Max length of element */
 
@@ -47,6 +50,28 @@ struct fcb_entry {
     uint16_t fe_data_len;	/* size of data area */
 };
 
+#if MYNEWT_VAL(FCB_READ_CACHE_SIZE) > 0
+/*
+ * Copy of flash contents at frc_off within frc_area.  Only valid while
+ * holding f_mtx.
+ */
+struct fcb_read_cache {
+    struct flash_area *frc_area;
+    uint32_t frc_off;
+    uint16_t frc_len;
+    uint8_t frc_buf[MYNEWT_VAL(FCB_READ_CACHE_SIZE)];
+};
+#endif
+
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+STATS_SECT_START(fcb_stats)
+    STATS_SECT_ENTRY(erases)
+    STATS_SECT_ENTRY(erase_fails)
+    STATS_SECT_ENTRY(erase_cnt_max)
+    STATS_SECT_ENTRY(erase_cnt_min)
+STATS_SECT_END
+#endif
+
 struct fcb {
     /* Caller of fcb_init fills this in */
     uint32_t f_magic;		/* As placed on the disk */
@@ -54,6 +79,13 @@ struct fcb {
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    uint8_t *f_wbuf;		/* Optional buffer for fcb_append_bufs() */
+    uint16_t f_wbuf_size;	/* Size of f_wbuf, multiple of alignment */
+#endif
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+    uint8_t f_pre_erase;	/* Active sector fill % to erase ahead at */
+#endif
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -61,6 +93,26 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    uint32_t f_wbuf_off;	/* Offset in active area of f_wbuf[0] */
+    uint16_t f_wbuf_len;	/* Bytes of f_wbuf in use */
+    uint16_t f_wbuf_cnt;	/* Number of elements in f_wbuf */
+#endif
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+    struct os_mutex f_erase_mtx; /* Held while erasing ahead */
+    struct os_event f_erase_ev;	/* Queued to erase ahead */
+    struct flash_area *f_erasing; /* Sector being erased ahead, if any */
+#endif
+#if MYNEWT_VAL(FCB_READ_CACHE_SIZE) > 0
+    struct fcb_read_cache f_rcache; /* Read-ahead for walks */
+#endif
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    /* Number of valid elements in each sector, or 0xffff if not known */
+    uint16_t f_sector_entries[MYNEWT_VAL(FCB_SECTOR_INDEX_MAX)];
+#endif
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    STATS_SECT_DECL(fcb_stats) f_stats; /* See fcb_stats_register() */
+#endif
 };
 
 /**
@@ -78,6 +130,15 @@ struct fcb {
 
 int fcb_init(struct fcb *fcb);
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+/* Index and timestamp of the first log entry in an FCB sector. */
+struct fcb_log_sector {
+    int64_t fls_ts;
+    uint32_t fls_index;
+    uint8_t fls_valid;
+};
+#endif
+
 /**
  * fcb_log is needed as the number of entries in a log
  */
@@ -89,6 +150,10 @@ struct fcb_log {
     /* Internal - tracking storage use */
     uint32_t fl_watermark_off;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Internal - first entry of each sector, for seeking on reads */
+    struct fcb_log_sector fl_sectors[MYNEWT_VAL(LOG_FCB_SECTOR_INDEX_MAX)];
+#endif
 };
 
 /**
@@ -98,8 +163,44 @@ struct fcb_log {
  * loc as argument.
  */
 int fcb_append(struct fcb *, uint16_t len, struct fcb_entry *loc);
+
+/**
+ * fcb_append_multi() reserves space for up to cnt entries, with lengths
+ * given in lens, in the active sector.  A new sector is taken into use only
+ * if the first entry does not fit.  Each reserved entry is written and
+ * finished as with fcb_append().  Returns the number of entries reserved,
+ * or a negative FCB_ERR_* value if none could be.
+ */
+int fcb_append_multi(struct fcb *, const uint16_t *lens, int cnt,
+                     struct fcb_entry *locs);
 int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
 
+/**
+ * One piece of the data of an element written with fcb_append_bufs().
+ */
+struct fcb_buf {
+    const void *fb_data;
+    uint16_t fb_len;
+};
+
+/**
+ * fcb_append_bufs() appends a complete element, made up of the cnt pieces
+ * in bufs, in one call.  If the FCB has a write buffer (f_wbuf, with syscfg
+ * FCB_WRITE_BUF) the element is assembled there, and goes to flash along
+ * with neighbouring elements when the buffer fills up or on fcb_flush().
+ * Until then it is not seen by fcb_getnext().  Otherwise this is the same
+ * as fcb_append(), writes and fcb_append_finish().  On success loc tells
+ * where the element is placed.
+ */
+int fcb_append_bufs(struct fcb *, const struct fcb_buf *bufs, int cnt,
+                    struct fcb_entry *loc);
+
+/**
+ * fcb_flush() writes out elements held in the write buffer.  Does nothing
+ * if the FCB has no write buffer.
+ */
+int fcb_flush(struct fcb *);
+
 /**
  * Walk over all log entries in FCB, or entries in a given flash_area.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -109,6 +210,7 @@ int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
  * loc->fe_area, loc->fe_data_off, and loc->fe_data_len as arguments.
  */
 typedef int (*fcb_walk_cb)(struct fcb_entry *loc, void *arg);
+/* fcb_walk() flushes the write buffer first; fcb_getnext() does not. */
 int fcb_walk(struct fcb *, struct flash_area *, fcb_walk_cb cb, void *cb_arg);
 int fcb_getnext(struct fcb *, struct fcb_entry *loc);
 
@@ -117,6 +219,39 @@ int fcb_getnext(struct fcb *, struct fcb_entry *loc);
  */
 int fcb_rotate(struct fcb *);
 
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+/**
+ * Reads how many times a sector has been erased by FCB.  Erases done
+ * outside FCB, or before FCB_ERASE_CNT was enabled, are not counted.
+ *
+ * @param fcb                   The FCB the sector belongs to.
+ * @param fap                   Sector within fcb->f_sectors.
+ * @param cnt                   On success, the erase count goes here.
+ *
+ * @return                      0 on success, FCB_ERR_FLASH on failure.
+ */
+int fcb_sector_erase_cnt(struct fcb *fcb, struct flash_area *fap,
+                         uint32_t *cnt);
+
+/**
+ * Registers the erase statistics of an FCB under the given name: total
+ * erases and failures since boot, and the highest and lowest erase count
+ * of its sectors.  Call after fcb_init().
+ *
+ * @return                      0 on success, FCB_ERR_ARGS on failure.
+ */
+int fcb_stats_register(struct fcb *fcb, const char *name);
+#endif
+
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+/**
+ * Sets the event queue on which sectors are erased ahead of the write
+ * position, for FCBs with f_pre_erase set.  Defaults to the default event
+ * queue; a queue served by a low priority task keeps erases out of the way.
+ */
+void fcb_pre_erase_evq_set(struct os_eventq *evq);
+#endif
+
 /**
  * Start using the scratch block.
  */
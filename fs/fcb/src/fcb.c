@@ -17,6 +17,7 @@
  * under the License.
  */
 #include <limits.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "fcb/fcb.h"
@@ -78,6 +79,12 @@ fcb_init(struct fcb *fcb)
         newest = oldest = 0;
     }
     fcb->f_align = max_align;
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    fcb->f_wbuf_len = 0;
+    fcb->f_wbuf_cnt = 0;
+#endif
+    fcb_read_cache_inval(fcb, NULL);
+    fcb_sector_index_init(fcb);
     fcb->f_oldest = oldest_fap;
     fcb->f_active.fe_area = newest_fap;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
@@ -99,6 +106,7 @@ fcb_init(struct fcb *fcb)
         }
     }
     os_mutex_init(&fcb->f_mtx);
+    fcb_pre_erase_init(fcb);
     return rc;
 }
 
@@ -170,10 +178,10 @@ fcb_sector_hdr_init(struct fcb *fcb, struct flash_area *fap, uint16_t id)
 
     fda.fd_magic = fcb->f_magic;
     fda.fd_ver = fcb->f_version;
-    fda._pad = 0xff;
+    fda.fd_fmt = FCB_DISK_FMT;
     fda.fd_id = id;
 
-    rc = flash_area_write(fap, 0, &fda, sizeof(fda));
+    rc = flash_area_write(fap, 0, &fda, FCB_DISK_ID_SZ);
     if (rc) {
         return FCB_ERR_FLASH;
     }
@@ -196,7 +204,7 @@ fcb_sector_hdr_read(struct fcb *fcb, struct flash_area *fap,
     if (!fdap) {
         fdap = &fda;
     }
-    if (flash_area_isempty_at(fap, 0, sizeof(*fdap))) {
+    if (flash_area_isempty_at(fap, 0, FCB_DISK_ID_SZ)) {
         return 0;
     }
     rc = flash_area_read(fap, 0, fdap, sizeof(*fdap));
@@ -206,12 +214,202 @@ fcb_sector_hdr_read(struct fcb *fcb, struct flash_area *fap,
     if (fdap->fd_magic != fcb->f_magic) {
         return FCB_ERR_MAGIC;
     }
-    if (fdap->fd_ver != fcb->f_version) {
+    if (fdap->fd_ver != fcb->f_version || fdap->fd_fmt != FCB_DISK_FMT) {
         return FCB_ERR_VERSION;
     }
     return 1;
 }
 
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+int
+fcb_sector_erase_cnt(struct fcb *fcb, struct flash_area *fap, uint32_t *cnt)
+{
+    int rc;
+
+    rc = flash_area_read(fap, offsetof(struct fcb_disk_area, fd_erase_cnt),
+                         cnt, sizeof(*cnt));
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    if (*cnt == 0xffffffff) {
+        /* Erased before counting started. */
+        *cnt = 0;
+    }
+    return 0;
+}
+
+void
+fcb_erase_stats_update(struct fcb *fcb)
+{
+    uint32_t cnt;
+    uint32_t hi;
+    uint32_t lo;
+    int i;
+
+    hi = 0;
+    lo = UINT32_MAX;
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        if (fcb_sector_erase_cnt(fcb, &fcb->f_sectors[i], &cnt)) {
+            continue;
+        }
+        hi = max(hi, cnt);
+        lo = min(lo, cnt);
+    }
+    if (lo > hi) {
+        lo = hi;
+    }
+    STATS_CLEAR(fcb->f_stats, erase_cnt_max);
+    STATS_INCN(fcb->f_stats, erase_cnt_max, hi);
+    STATS_CLEAR(fcb->f_stats, erase_cnt_min);
+    STATS_INCN(fcb->f_stats, erase_cnt_min, lo);
+}
+
+STATS_NAME_START(fcb_stats)
+    STATS_NAME(fcb_stats, erases)
+    STATS_NAME(fcb_stats, erase_fails)
+    STATS_NAME(fcb_stats, erase_cnt_max)
+    STATS_NAME(fcb_stats, erase_cnt_min)
+STATS_NAME_END(fcb_stats)
+
+int
+fcb_stats_register(struct fcb *fcb, const char *name)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(fcb->f_stats),
+                            STATS_SIZE_INIT_PARMS(fcb->f_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(fcb_stats), name);
+    if (rc) {
+        return FCB_ERR_ARGS;
+    }
+    fcb_erase_stats_update(fcb);
+    return 0;
+}
+#endif
+
+/**
+ * Erases a sector, keeping count of the erases in its header.
+ */
+int
+fcb_sector_erase(struct fcb *fcb, struct flash_area *fap)
+{
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    uint32_t cnt[2];
+#endif
+    int rc;
+
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    if (fcb_sector_erase_cnt(fcb, fap, &cnt[0])) {
+        cnt[0] = 0;
+    }
+#endif
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    if (rc) {
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+        STATS_INC(fcb->f_stats, erase_fails);
+#endif
+        return FCB_ERR_FLASH;
+    }
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    STATS_INC(fcb->f_stats, erases);
+    cnt[0]++;
+    cnt[1] = 0xffffffff;
+    rc = flash_area_write(fap, offsetof(struct fcb_disk_area, fd_erase_cnt),
+                          cnt, sizeof(cnt));
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    fcb_erase_stats_update(fcb);
+#endif
+    return 0;
+}
+
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+void
+fcb_sector_index_init(struct fcb *fcb)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FCB_SECTOR_INDEX_MAX); i++) {
+        fcb->f_sector_entries[i] = FCB_SECTOR_ENTRIES_UNKNOWN;
+    }
+}
+
+void
+fcb_sector_index_clear(struct fcb *fcb, struct flash_area *fap)
+{
+    int idx;
+
+    idx = fap - fcb->f_sectors;
+    if (idx < MYNEWT_VAL(FCB_SECTOR_INDEX_MAX)) {
+        fcb->f_sector_entries[idx] = 0;
+    }
+}
+
+void
+fcb_sector_index_add(struct fcb *fcb, struct flash_area *fap, int cnt)
+{
+    int idx;
+
+    idx = fap - fcb->f_sectors;
+    if (idx < MYNEWT_VAL(FCB_SECTOR_INDEX_MAX) &&
+        fcb->f_sector_entries[idx] != FCB_SECTOR_ENTRIES_UNKNOWN) {
+        if (fcb->f_sector_entries[idx] + cnt < FCB_SECTOR_ENTRIES_UNKNOWN) {
+            fcb->f_sector_entries[idx] += cnt;
+        } else {
+            fcb->f_sector_entries[idx] = FCB_SECTOR_ENTRIES_UNKNOWN;
+        }
+    }
+}
+
+/*
+ * Number of valid elements in a sector, counted the same way
+ * fcb_getnext() steps over them.  Caller holds f_mtx.
+ */
+static int
+fcb_sector_entries(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_entry loc;
+    int idx;
+    int cnt;
+    int rc;
+
+    idx = fap - fcb->f_sectors;
+    if (idx < MYNEWT_VAL(FCB_SECTOR_INDEX_MAX) &&
+        fcb->f_sector_entries[idx] != FCB_SECTOR_ENTRIES_UNKNOWN) {
+        return fcb->f_sector_entries[idx];
+    }
+
+    cnt = 0;
+    loc.fe_area = fap;
+    loc.fe_elem_off = sizeof(struct fcb_disk_area);
+    rc = fcb_elem_info(fcb, &loc);
+    while (rc == 0 || rc == FCB_ERR_CRC) {
+        if (rc == 0) {
+            cnt++;
+        }
+        loc.fe_elem_off = loc.fe_data_off +
+          fcb_len_in_flash(fcb, loc.fe_data_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+        rc = fcb_elem_info(fcb, &loc);
+    }
+
+    if (idx < MYNEWT_VAL(FCB_SECTOR_INDEX_MAX) &&
+        cnt < FCB_SECTOR_ENTRIES_UNKNOWN) {
+        fcb->f_sector_entries[idx] = cnt;
+    }
+    return cnt;
+}
+
+static struct flash_area *
+fcb_getprev_area(struct fcb *fcb, struct flash_area *fap)
+{
+    if (fap == &fcb->f_sectors[0]) {
+        return &fcb->f_sectors[fcb->f_sector_cnt - 1];
+    }
+    return fap - 1;
+}
+
 /**
  * Finds the fcb entry that gives back upto n entries at the end.
  * @param0 ptr to fcb
@@ -223,7 +421,69 @@ int
 fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         struct fcb_entry *last_n_entry)
 {
+    struct flash_area *fap;
     struct fcb_entry loc;
+    int total;
+    int cnt;
+    int rc;
+
+    /* assure a minimum amount of entries */
+    if (!entries) {
+        entries = 1;
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    rc = fcb_flush_nolock(fcb);
+    if (rc) {
+        os_mutex_release(&fcb->f_mtx);
+        return rc;
+    }
+
+    /* Go back from the active sector until enough entries are covered. */
+    fap = fcb->f_active.fe_area;
+    total = 0;
+    while (1) {
+        cnt = fcb_sector_entries(fcb, fap);
+        if (total + cnt >= entries || fap == fcb->f_oldest) {
+            break;
+        }
+        total += cnt;
+        fap = fcb_getprev_area(fcb, fap);
+    }
+
+    /* Then step over the surplus at the start of that sector. */
+    memset(&loc, 0, sizeof(loc));
+    loc.fe_area = fap;
+    rc = fcb_getnext_nolock(fcb, &loc);
+    for (cnt = total + cnt - entries; rc == 0 && cnt > 0; cnt--) {
+        rc = fcb_getnext_nolock(fcb, &loc);
+    }
+
+    os_mutex_release(&fcb->f_mtx);
+
+    if (rc) {
+        return OS_ENOENT;
+    }
+    *last_n_entry = loc;
+    return 0;
+}
+#else
+/**
+ * Finds the fcb entry that gives back upto n entries at the end.
+ * @param0 ptr to fcb
+ * @param1 n number of fcb entries the user wants to get
+ * @param2 ptr to the fcb_entry to be returned
+ * @return 0 on there are any fcbs aviable; OS_ENOENT otherwise
+ */
+int
+fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
+        struct fcb_entry *last_n_entry)
+{
+    struct fcb_entry loc;
+    int rc;
     int i;
 
     /* assure a minimum amount of entries */
@@ -231,6 +491,11 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         entries = 1;
     }
 
+    rc = fcb_flush(fcb);
+    if (rc) {
+        return rc;
+    }
+
     i = 0;
     memset(&loc, 0, sizeof(loc));
     while (!fcb_getnext(fcb, &loc)) {
@@ -247,6 +512,8 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
     return (i == 0) ? OS_ENOENT : 0;
 }
 
+#endif
+
 /**
  * Clear fcb
  * @param fcb
@@ -17,6 +17,9 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
+
+#include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
@@ -43,6 +46,43 @@ fcb_new_area(struct fcb *fcb, int cnt)
     return rfa;
 }
 
+/*
+ * Start a new active sector, which must have room for len bytes.
+ */
+static int
+fcb_append_new_area(struct fcb *fcb, uint32_t len)
+{
+    struct flash_area *fa;
+    int rc;
+
+    /*
+     * The sector we need may still be getting erased ahead.  Others can
+     * append while we wait, so look again at where the FCB is afterwards.
+     */
+    if (fcb_pre_erase_wait(fcb)) {
+        fa = fcb->f_active.fe_area;
+        if (fcb->f_active.fe_elem_off + len <= fa->fa_size) {
+            return FCB_OK;
+        }
+        rc = fcb_flush_nolock(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
+    fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+    if (!fa || (fa->fa_size < sizeof(struct fcb_disk_area) + len)) {
+        return FCB_ERR_NOSPACE;
+    }
+    rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+    if (rc) {
+        return rc;
+    }
+    fcb->f_active.fe_area = fa;
+    fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+    fcb->f_active_id++;
+    return FCB_OK;
+}
+
 /*
  * Take one of the scratch blocks into use, if at all possible.
  */
@@ -52,6 +92,17 @@ fcb_append_to_scratch(struct fcb *fcb)
     struct flash_area *fa;
     int rc;
 
+    rc = fcb_flush_nolock(fcb);
+    if (rc) {
+        return rc;
+    }
+
+    if (fcb_pre_erase_wait(fcb)) {
+        rc = fcb_flush_nolock(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
     fa = fcb_new_area(fcb, 0);
     if (!fa) {
         return FCB_ERR_NOSPACE;
@@ -67,61 +118,94 @@ fcb_append_to_scratch(struct fcb *fcb)
 }
 
 int
-fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
+fcb_append_multi(struct fcb *fcb, const uint16_t *lens, int cnt,
+                 struct fcb_entry *append_locs)
 {
     struct fcb_entry *active;
-    struct flash_area *fa;
-    uint8_t tmp_str[2];
-    int cnt;
+    uint8_t tmp_str[FCB_TMP_BUF_SZ];
+    uint16_t len;
+    int hdr_cnt;
     int rc;
+    int i;
 
-    cnt = fcb_put_len(tmp_str, len);
-    if (cnt < 0) {
-        return cnt;
+    if (cnt <= 0) {
+        return FCB_ERR_ARGS;
     }
-    cnt = fcb_len_in_flash(fcb, cnt);
-    len = fcb_len_in_flash(fcb, len) + fcb_len_in_flash(fcb, FCB_CRC_SZ);
 
     rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
     if (rc && rc != OS_NOT_STARTED) {
         return FCB_ERR_ARGS;
     }
     active = &fcb->f_active;
-    if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
-        if (!fa || (fa->fa_size <
-            sizeof(struct fcb_disk_area) + len + cnt)) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
+
+    /* Buffered elements go first. */
+    rc = fcb_flush_nolock(fcb);
+    if (rc) {
+        os_mutex_release(&fcb->f_mtx);
+        return rc;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        /* The length is padded up to the write alignment. */
+        memset(tmp_str, 0xff, sizeof(tmp_str));
+        hdr_cnt = fcb_put_len(tmp_str, lens[i]);
+        if (hdr_cnt < 0) {
+            rc = hdr_cnt;
+            break;
         }
-        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+        hdr_cnt = fcb_len_in_flash(fcb, hdr_cnt);
+        if (hdr_cnt > sizeof(tmp_str)) {
+            rc = FCB_ERR_ARGS;
+            break;
+        }
+        len = fcb_len_in_flash(fcb, lens[i]) +
+              fcb_len_in_flash(fcb, FCB_CRC_SZ);
+
+        if (active->fe_elem_off + len + hdr_cnt > active->fe_area->fa_size) {
+            if (i > 0) {
+                /* Leave the rest for the next sector. */
+                break;
+            }
+            rc = fcb_append_new_area(fcb, len + hdr_cnt);
+            if (rc) {
+                break;
+            }
+        }
+
+        rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str,
+                              hdr_cnt);
         if (rc) {
-            goto err;
+            rc = FCB_ERR_FLASH;
+            break;
         }
-        fcb->f_active.fe_area = fa;
-        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
-        fcb->f_active_id++;
-    }
+        append_locs[i].fe_area = active->fe_area;
+        append_locs[i].fe_elem_off = active->fe_elem_off;
+        append_locs[i].fe_data_off = active->fe_elem_off + hdr_cnt;
 
-    rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str, cnt);
-    if (rc) {
-        rc = FCB_ERR_FLASH;
-        goto err;
+        active->fe_elem_off = append_locs[i].fe_data_off + len;
     }
-    append_loc->fe_area = active->fe_area;
-    append_loc->fe_elem_off = active->fe_elem_off;
-    append_loc->fe_data_off = active->fe_elem_off + cnt;
-
-    active->fe_elem_off = append_loc->fe_data_off + len;
 
+    fcb_pre_erase_check(fcb);
     os_mutex_release(&fcb->f_mtx);
 
-    return FCB_OK;
-err:
-    os_mutex_release(&fcb->f_mtx);
+    if (i > 0) {
+        return i;
+    }
     return rc;
 }
 
+int
+fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
+{
+    int rc;
+
+    rc = fcb_append_multi(fcb, &len, 1, append_loc);
+    if (rc < 0) {
+        return rc;
+    }
+    return FCB_OK;
+}
+
 int
 fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
 {
@@ -129,15 +213,242 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
     uint8_t crc8;
     uint32_t off;
 
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+
+    /* The data was written behind the read-ahead buffer's back. */
+    fcb_read_cache_inval(fcb, loc->fe_area);
+
     rc = fcb_elem_crc8(fcb, loc, &crc8);
     if (rc) {
-        return rc;
+        goto out;
     }
     off = loc->fe_data_off + fcb_len_in_flash(fcb, loc->fe_data_len);
 
     rc = flash_area_write(loc->fe_area, off, &crc8, sizeof(crc8));
     if (rc) {
-        return FCB_ERR_FLASH;
+        rc = FCB_ERR_FLASH;
+        goto out;
+    }
+    fcb_read_cache_inval(fcb, loc->fe_area);
+    fcb_sector_index_add(fcb, loc->fe_area, 1);
+out:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
+
+/*
+ * Writes the pieces in bufs one after another starting at off.  They are
+ * gathered into chunks so that flash writes stay aligned; the tail is padded
+ * up to the alignment.
+ */
+static int
+fcb_write_bufs(struct fcb *fcb, struct flash_area *fap, uint32_t off,
+               const struct fcb_buf *bufs, int cnt)
+{
+    uint8_t tmp_str[FCB_TMP_BUF_SZ];
+    const uint8_t *u8p;
+    uint16_t left;
+    int tmp_len;
+    int blk_sz;
+    int rc;
+    int i;
+
+    if (fcb->f_align > sizeof(tmp_str)) {
+        return FCB_ERR_ARGS;
+    }
+
+    tmp_len = 0;
+    for (i = 0; i < cnt; i++) {
+        u8p = bufs[i].fb_data;
+        left = bufs[i].fb_len;
+        while (left > 0) {
+            blk_sz = min(left, sizeof(tmp_str) - tmp_len);
+            memcpy(tmp_str + tmp_len, u8p, blk_sz);
+            tmp_len += blk_sz;
+            u8p += blk_sz;
+            left -= blk_sz;
+
+            if (tmp_len == sizeof(tmp_str)) {
+                rc = flash_area_write(fap, off, tmp_str, tmp_len);
+                if (rc) {
+                    return FCB_ERR_FLASH;
+                }
+                off += tmp_len;
+                tmp_len = 0;
+            }
+        }
+    }
+    if (tmp_len > 0) {
+        blk_sz = fcb_len_in_flash(fcb, tmp_len);
+        memset(tmp_str + tmp_len, 0xff, blk_sz - tmp_len);
+        rc = flash_area_write(fap, off, tmp_str, blk_sz);
+        if (rc) {
+            return FCB_ERR_FLASH;
+        }
+    }
+    return 0;
+}
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+/* Space an element with len bytes of data takes in flash. */
+static uint32_t
+fcb_elem_len(struct fcb *fcb, uint16_t len)
+{
+    return fcb_len_in_flash(fcb, len < 0x80 ? 1 : 2) +
+           fcb_len_in_flash(fcb, len) + fcb_len_in_flash(fcb, FCB_CRC_SZ);
+}
+
+int
+fcb_flush_nolock(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    int rc;
+
+    if (fcb->f_wbuf_len == 0) {
+        return 0;
+    }
+
+    fap = fcb->f_active.fe_area;
+    rc = flash_area_write(fap, fcb->f_wbuf_off, fcb->f_wbuf,
+                          fcb->f_wbuf_len);
+    fcb_read_cache_inval(fcb, fap);
+    if (rc == 0) {
+        fcb_sector_index_add(fcb, fap, fcb->f_wbuf_cnt);
+    }
+    fcb->f_wbuf_len = 0;
+    fcb->f_wbuf_cnt = 0;
+
+    return rc ? FCB_ERR_FLASH : 0;
+}
+
+/*
+ * Assembles an element at the end of the write buffer, writing out the
+ * buffer first if the element does not fit.  Caller holds f_mtx.
+ */
+static int
+fcb_append_buffered(struct fcb *fcb, const struct fcb_buf *bufs, int cnt,
+                    uint16_t len, struct fcb_entry *loc)
+{
+    struct fcb_entry *active;
+    uint8_t tmp_str[2];
+    uint32_t elem_len;
+    uint8_t *u8p;
+    uint8_t crc8;
+    int hdr_cnt;
+    int rc;
+    int i;
+
+    hdr_cnt = fcb_put_len(tmp_str, len);
+    elem_len = fcb_elem_len(fcb, len);
+    active = &fcb->f_active;
+
+    if (active->fe_elem_off + elem_len > active->fe_area->fa_size) {
+        rc = fcb_flush_nolock(fcb);
+        if (rc) {
+            return rc;
+        }
+        rc = fcb_append_new_area(fcb, elem_len);
+        if (rc) {
+            return rc;
+        }
+    }
+    if (fcb->f_wbuf_len + elem_len > fcb->f_wbuf_size) {
+        rc = fcb_flush_nolock(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
+    if (fcb->f_wbuf_len == 0) {
+        fcb->f_wbuf_off = active->fe_elem_off;
+    }
+
+    loc->fe_area = active->fe_area;
+    loc->fe_elem_off = active->fe_elem_off;
+    loc->fe_data_off = active->fe_elem_off + fcb_len_in_flash(fcb, hdr_cnt);
+    loc->fe_data_len = len;
+
+    /* Same layout and CRC as fcb_append() and fcb_append_finish(). */
+    u8p = fcb->f_wbuf + fcb->f_wbuf_len;
+    memset(u8p, 0xff, elem_len);
+    memcpy(u8p, tmp_str, hdr_cnt);
+    crc8 = crc8_calc(crc8_init(), tmp_str, hdr_cnt);
+
+    u8p += loc->fe_data_off - loc->fe_elem_off;
+    for (i = 0; i < cnt; i++) {
+        memcpy(u8p, bufs[i].fb_data, bufs[i].fb_len);
+        crc8 = crc8_calc(crc8, (void *)bufs[i].fb_data, bufs[i].fb_len);
+        u8p += bufs[i].fb_len;
+    }
+    u8p = fcb->f_wbuf + fcb->f_wbuf_len +
+          (loc->fe_data_off - loc->fe_elem_off) + fcb_len_in_flash(fcb, len);
+    *u8p = crc8;
+
+    fcb->f_wbuf_len += elem_len;
+    fcb->f_wbuf_cnt++;
+    active->fe_elem_off += elem_len;
+
+    if (fcb->f_wbuf_len == fcb->f_wbuf_size) {
+        return fcb_flush_nolock(fcb);
     }
     return 0;
 }
+#endif
+
+int
+fcb_append_bufs(struct fcb *fcb, const struct fcb_buf *bufs, int cnt,
+                struct fcb_entry *loc)
+{
+    uint32_t len;
+    int rc;
+    int i;
+
+    len = 0;
+    for (i = 0; i < cnt; i++) {
+        len += bufs[i].fb_len;
+    }
+    if (len >= FCB_MAX_LEN) {
+        return FCB_ERR_ARGS;
+    }
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    /* Elements too big for the buffer are written directly. */
+    if (fcb->f_wbuf && fcb_elem_len(fcb, len) <= fcb->f_wbuf_size) {
+        rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+        if (rc && rc != OS_NOT_STARTED) {
+            return FCB_ERR_ARGS;
+        }
+        rc = fcb_append_buffered(fcb, bufs, cnt, len, loc);
+        fcb_pre_erase_check(fcb);
+        os_mutex_release(&fcb->f_mtx);
+        return rc;
+    }
+#endif
+
+    rc = fcb_append(fcb, len, loc);
+    if (rc) {
+        return rc;
+    }
+    rc = fcb_write_bufs(fcb, loc->fe_area, loc->fe_data_off, bufs, cnt);
+    if (rc) {
+        return rc;
+    }
+    return fcb_append_finish(fcb, loc);
+}
+
+int
+fcb_flush(struct fcb *fcb)
+{
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    rc = fcb_flush_nolock(fcb);
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
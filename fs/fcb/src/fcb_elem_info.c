@@ -17,11 +17,62 @@
  * under the License.
  */
 
+#include <string.h>
 #include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
 
+#if MYNEWT_VAL(FCB_READ_CACHE_SIZE) > 0
+/*
+ * Read through the read-ahead buffer.  On a miss the buffer is refilled
+ * starting at off, as walks read forward.  Caller holds f_mtx.
+ */
+int
+fcb_read(struct fcb *fcb, struct flash_area *fap, uint32_t off, void *dst,
+         uint32_t len)
+{
+    struct fcb_read_cache *frc;
+    uint32_t cnt;
+    int rc;
+
+    frc = &fcb->f_rcache;
+    if (frc->frc_area != fap || off < frc->frc_off ||
+        off + len > frc->frc_off + frc->frc_len) {
+        cnt = fap->fa_size - off;
+        if (cnt > sizeof(frc->frc_buf)) {
+            cnt = sizeof(frc->frc_buf);
+        }
+        if (off >= fap->fa_size || cnt < len) {
+            return flash_area_read(fap, off, dst, len);
+        }
+        rc = flash_area_read(fap, off, frc->frc_buf, cnt);
+        if (rc) {
+            frc->frc_area = NULL;
+            return rc;
+        }
+        frc->frc_area = fap;
+        frc->frc_off = off;
+        frc->frc_len = cnt;
+    }
+    memcpy(dst, frc->frc_buf + (off - frc->frc_off), len);
+
+    return 0;
+}
+
+/*
+ * Drop buffered contents of fap after it has been written or erased.  A NULL
+ * fap drops whatever is buffered.
+ */
+void
+fcb_read_cache_inval(struct fcb *fcb, struct flash_area *fap)
+{
+    if (!fap || fcb->f_rcache.frc_area == fap) {
+        fcb->f_rcache.frc_area = NULL;
+    }
+}
+#endif
+
 /*
  * Given offset in flash area, fill in rest of the fcb_entry, and crc8 over
  * the data.
@@ -41,6 +92,17 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
     if (loc->fe_elem_off + 2 > loc->fe_area->fa_size) {
         return FCB_ERR_NOVAR;
     }
+#if MYNEWT_VAL(FCB_READ_CACHE_SIZE) > 0
+    /* Only ask the flash driver when the buffered header looks erased. */
+    rc = fcb_read(fcb, loc->fe_area, loc->fe_elem_off, tmp_str, 2);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    if (tmp_str[0] == tmp_str[1] && (tmp_str[0] == 0xff || !tmp_str[0]) &&
+        flash_area_isempty_at(loc->fe_area, loc->fe_elem_off, 2)) {
+        return FCB_ERR_NOVAR;
+    }
+#else
     if (flash_area_isempty_at(loc->fe_area, loc->fe_elem_off, 2)) {
         return FCB_ERR_NOVAR;
     }
@@ -48,6 +110,7 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
     if (rc) {
         return FCB_ERR_FLASH;
     }
+#endif
 
     cnt = fcb_get_len(tmp_str, &len);
     loc->fe_data_off = loc->fe_elem_off + fcb_len_in_flash(fcb, cnt);
@@ -64,7 +127,7 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
             blk_sz = sizeof(tmp_str);
         }
 
-        rc = flash_area_read(loc->fe_area, off, tmp_str, blk_sz);
+        rc = fcb_read(fcb, loc->fe_area, off, tmp_str, blk_sz);
         if (rc) {
             return FCB_ERR_FLASH;
         }
@@ -89,7 +152,7 @@ fcb_elem_info(struct fcb *fcb, struct fcb_entry *loc)
     }
     off = loc->fe_data_off + fcb_len_in_flash(fcb, loc->fe_data_len);
 
-    rc = flash_area_read(loc->fe_area, off, &fl_crc8, sizeof(fl_crc8));
+    rc = fcb_read(fcb, loc->fe_area, off, &fl_crc8, sizeof(fl_crc8));
     if (rc) {
         return FCB_ERR_FLASH;
     }
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+static struct os_eventq *fcb_pre_erase_evq;
+
+void
+fcb_pre_erase_evq_set(struct os_eventq *evq)
+{
+    fcb_pre_erase_evq = evq;
+}
+
+/*
+ * Whether the oldest sector should be erased now: the active sector is
+ * past the fill threshold, and moving on from it would need a rotate.
+ * Caller holds f_mtx.
+ */
+static int
+fcb_pre_erase_needed(struct fcb *fcb)
+{
+    struct fcb_entry *active;
+
+    active = &fcb->f_active;
+    if (!fcb->f_pre_erase || fcb->f_erasing ||
+      fcb->f_oldest == active->fe_area) {
+        return 0;
+    }
+    if (active->fe_elem_off * 100 <
+      active->fe_area->fa_size * fcb->f_pre_erase) {
+        return 0;
+    }
+    return fcb_free_sector_cnt(fcb) <= fcb->f_scratch_cnt;
+}
+
+static void
+fcb_pre_erase_ev(struct os_event *ev)
+{
+    struct fcb *fcb;
+    struct flash_area *fap;
+    int rc;
+
+    fcb = ev->ev_arg;
+
+    os_mutex_pend(&fcb->f_erase_mtx, OS_WAIT_FOREVER);
+    os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (!fcb_pre_erase_needed(fcb)) {
+        os_mutex_release(&fcb->f_mtx);
+        os_mutex_release(&fcb->f_erase_mtx);
+        return;
+    }
+
+    /*
+     * The sector leaves the FCB before it is erased, so walkers and
+     * appenders can carry on while the erase runs without the lock.
+     */
+    fap = fcb->f_oldest;
+    fcb->f_oldest = fcb_getnext_area(fcb, fap);
+    fcb->f_erasing = fap;
+    fcb_read_cache_inval(fcb, fap);
+    fcb_sector_index_clear(fcb, fap);
+    os_mutex_release(&fcb->f_mtx);
+
+    rc = fcb_sector_erase(fcb, fap);
+
+    os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    fcb->f_erasing = NULL;
+    fcb_read_cache_inval(fcb, fap);
+    if (rc && fcb->f_oldest == fcb_getnext_area(fcb, fap)) {
+        /* Leave it for fcb_rotate() to try again. */
+        fcb->f_oldest = fap;
+    }
+    os_mutex_release(&fcb->f_mtx);
+    os_mutex_release(&fcb->f_erase_mtx);
+}
+
+void
+fcb_pre_erase_init(struct fcb *fcb)
+{
+    os_mutex_init(&fcb->f_erase_mtx);
+    fcb->f_erase_ev.ev_cb = fcb_pre_erase_ev;
+    fcb->f_erase_ev.ev_arg = fcb;
+    fcb->f_erasing = NULL;
+}
+
+void
+fcb_pre_erase_check(struct fcb *fcb)
+{
+    if (fcb_pre_erase_needed(fcb)) {
+        if (!fcb_pre_erase_evq) {
+            fcb_pre_erase_evq = os_eventq_dflt_get();
+        }
+        os_eventq_put(fcb_pre_erase_evq, &fcb->f_erase_ev);
+    }
+}
+
+/*
+ * Waits for an erase ahead to finish.  f_mtx is dropped meanwhile; returns
+ * 1 if that happened.  Pending on f_erase_mtx lends our priority to the
+ * eraser.
+ */
+int
+fcb_pre_erase_wait(struct fcb *fcb)
+{
+    int waited;
+
+    waited = 0;
+    while (fcb->f_erasing) {
+        os_mutex_release(&fcb->f_mtx);
+        os_mutex_pend(&fcb->f_erase_mtx, OS_WAIT_FOREVER);
+        os_mutex_release(&fcb->f_erase_mtx);
+        os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+        waited = 1;
+    }
+    return waited;
+}
+
+#endif
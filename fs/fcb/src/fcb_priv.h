@@ -28,13 +28,31 @@ extern "C" {
 
 #define FCB_ID_GT(a, b) (((int16_t)(a) - (int16_t)(b)) > 0)
 
+/*
+ * fd_fmt tells which layout the header has.  With FCB_ERASE_CNT it is
+ * followed by the erase count of the sector, which is written right after
+ * the sector is erased; the rest of the header when it is taken into use.
+ */
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+#define FCB_DISK_FMT	0x01
+#else
+#define FCB_DISK_FMT	0xff
+#endif
+
 struct fcb_disk_area {
     uint32_t fd_magic;
     uint8_t  fd_ver;
-    uint8_t  _pad;
+    uint8_t  fd_fmt;
     uint16_t fd_id;
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    uint32_t fd_erase_cnt;
+    uint32_t _pad;
+#endif
 };
 
+/* Part of fcb_disk_area written by fcb_sector_hdr_init(). */
+#define FCB_DISK_ID_SZ	8
+
 int fcb_put_len(uint8_t *buf, uint16_t len);
 int fcb_get_len(uint8_t *buf, uint16_t *len);
 
@@ -54,6 +72,89 @@ int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
 int fcb_elem_info(struct fcb *, struct fcb_entry *);
 int fcb_elem_crc8(struct fcb *, struct fcb_entry *loc, uint8_t *crc8p);
 
+#if MYNEWT_VAL(FCB_READ_CACHE_SIZE) > 0
+int fcb_read(struct fcb *fcb, struct flash_area *fap, uint32_t off,
+             void *dst, uint32_t len);
+void fcb_read_cache_inval(struct fcb *fcb, struct flash_area *fap);
+#else
+static inline int
+fcb_read(struct fcb *fcb, struct flash_area *fap, uint32_t off, void *dst,
+         uint32_t len)
+{
+    return flash_area_read(fap, off, dst, len);
+}
+
+static inline void
+fcb_read_cache_inval(struct fcb *fcb, struct flash_area *fap)
+{
+}
+#endif
+
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+#define FCB_SECTOR_ENTRIES_UNKNOWN  0xffff
+
+void fcb_sector_index_init(struct fcb *fcb);
+void fcb_sector_index_clear(struct fcb *fcb, struct flash_area *fap);
+void fcb_sector_index_add(struct fcb *fcb, struct flash_area *fap, int cnt);
+#else
+static inline void
+fcb_sector_index_init(struct fcb *fcb)
+{
+}
+
+static inline void
+fcb_sector_index_clear(struct fcb *fcb, struct flash_area *fap)
+{
+}
+
+static inline void
+fcb_sector_index_add(struct fcb *fcb, struct flash_area *fap, int cnt)
+{
+}
+#endif
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+int fcb_flush_nolock(struct fcb *fcb);
+#else
+static inline int
+fcb_flush_nolock(struct fcb *fcb)
+{
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+void fcb_pre_erase_init(struct fcb *fcb);
+void fcb_pre_erase_check(struct fcb *fcb);
+int fcb_pre_erase_wait(struct fcb *fcb);
+#else
+static inline void
+fcb_pre_erase_init(struct fcb *fcb)
+{
+}
+
+static inline void
+fcb_pre_erase_check(struct fcb *fcb)
+{
+}
+
+static inline int
+fcb_pre_erase_wait(struct fcb *fcb)
+{
+    return 0;
+}
+#endif
+
+int fcb_sector_erase(struct fcb *fcb, struct flash_area *fap);
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+void fcb_erase_stats_update(struct fcb *fcb);
+#else
+static inline void
+fcb_erase_stats_update(struct fcb *fcb)
+{
+}
+#endif
+
 int fcb_sector_hdr_init(struct fcb *, struct flash_area *fap, uint16_t id);
 int fcb_sector_hdr_read(struct fcb *, struct flash_area *fap,
   struct fcb_disk_area *fdap);
@@ -30,16 +30,23 @@ fcb_rotate(struct fcb *fcb)
     if (rc && rc != OS_NOT_STARTED) {
         return FCB_ERR_ARGS;
     }
+    fcb_pre_erase_wait(fcb);
 
-    rc = flash_area_erase(fcb->f_oldest, 0, fcb->f_oldest->fa_size);
+    rc = fcb_sector_erase(fcb, fcb->f_oldest);
     if (rc) {
-        rc = FCB_ERR_FLASH;
         goto out;
     }
+    fcb_read_cache_inval(fcb, fcb->f_oldest);
+    fcb_sector_index_clear(fcb, fcb->f_oldest);
     if (fcb->f_oldest == fcb->f_active.fe_area) {
         /*
          * Need to create a new active area, as we're wiping the current.
+         * Anything still buffered for it goes too.
          */
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+        fcb->f_wbuf_len = 0;
+        fcb->f_wbuf_cnt = 0;
+#endif
         fap = fcb_getnext_area(fcb, fcb->f_oldest);
         rc = fcb_sector_hdr_init(fcb, fap, fcb->f_active_id + 1);
         if (rc) {
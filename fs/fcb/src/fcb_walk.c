@@ -37,6 +37,11 @@ fcb_walk(struct fcb *fcb, struct flash_area *fap, fcb_walk_cb cb, void *cb_arg)
     if (rc && rc != OS_NOT_STARTED) {
         return FCB_ERR_ARGS;
     }
+    rc = fcb_flush_nolock(fcb);
+    if (rc) {
+        os_mutex_release(&fcb->f_mtx);
+        return rc;
+    }
     while ((rc = fcb_getnext_nolock(fcb, &loc)) != FCB_ERR_NOVAR) {
         os_mutex_release(&fcb->f_mtx);
         if (fap && loc.fe_area != fap) {
@@ -152,12 +152,17 @@ TEST_CASE_DECL(fcb_test_len)
 TEST_CASE_DECL(fcb_test_init)
 TEST_CASE_DECL(fcb_test_empty_walk)
 TEST_CASE_DECL(fcb_test_append)
+TEST_CASE_DECL(fcb_test_append_multi)
+TEST_CASE_DECL(fcb_test_append_bufs)
 TEST_CASE_DECL(fcb_test_append_too_big)
 TEST_CASE_DECL(fcb_test_append_fill)
 TEST_CASE_DECL(fcb_test_reset)
 TEST_CASE_DECL(fcb_test_rotate)
+TEST_CASE_DECL(fcb_test_erase_cnt)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
+TEST_CASE_DECL(fcb_test_last_of_n_multi)
+TEST_CASE_DECL(fcb_test_pre_erase)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -173,6 +178,12 @@ TEST_SUITE(fcb_test_all)
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_append();
 
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_append_multi();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_append_bufs();
+
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_append_too_big();
 
@@ -185,11 +196,20 @@ TEST_SUITE(fcb_test_all)
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_rotate();
 
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_erase_cnt();
+
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
     fcb_test_multiple_scratch();
 
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
     fcb_test_last_of_n();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
+    fcb_test_last_of_n_multi();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
+    fcb_test_pre_erase();
 }
 
 #if MYNEWT_VAL(SELFTEST)
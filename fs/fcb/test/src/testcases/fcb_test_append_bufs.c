@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_append_bufs)
+{
+    int rc;
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    struct fcb_buf bufs[2];
+    uint8_t test_data[128];
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    static uint8_t wbuf[256];
+#endif
+    int i;
+    int j;
+    int var_cnt;
+
+    fcb = &test_fcb;
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    fcb->f_wbuf = wbuf;
+    fcb->f_wbuf_size = sizeof(wbuf);
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+#endif
+
+    /* Elements in two pieces; the first half of them buffered. */
+    for (i = 0; i < sizeof(test_data); i++) {
+        for (j = 0; j < i; j++) {
+            test_data[j] = fcb_test_append_data(i, j);
+        }
+        bufs[0].fb_data = test_data;
+        bufs[0].fb_len = i / 3;
+        bufs[1].fb_data = test_data + i / 3;
+        bufs[1].fb_len = i - i / 3;
+        rc = fcb_append_bufs(fcb, bufs, 2, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(loc.fe_data_len == i);
+
+        if (i == 0) {
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+            /* Not in flash until the buffer is written out. */
+            memset(&loc, 0, sizeof(loc));
+            rc = fcb_getnext(fcb, &loc);
+            TEST_ASSERT(rc == FCB_ERR_NOVAR);
+            rc = fcb_flush(fcb);
+            TEST_ASSERT(rc == 0);
+#endif
+            memset(&loc, 0, sizeof(loc));
+            rc = fcb_getnext(fcb, &loc);
+            TEST_ASSERT(rc == 0);
+        }
+    }
+
+    /* Mixed with unbuffered appends. */
+    rc = fcb_append(fcb, sizeof(test_data), &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (j = 0; j < sizeof(test_data); j++) {
+        test_data[j] = fcb_test_append_data(sizeof(test_data), j);
+    }
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+                          sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == sizeof(test_data) + 1);
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    fcb->f_wbuf = NULL;
+    fcb->f_wbuf_size = 0;
+#endif
+}
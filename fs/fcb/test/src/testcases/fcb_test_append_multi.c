@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_append_multi)
+{
+    struct fcb *fcb;
+    struct fcb_entry locs[8];
+    uint16_t lens[8];
+    uint8_t test_data[128];
+    int var_cnt;
+    int done;
+    int rc;
+    int i;
+    int j;
+
+    fcb = &test_fcb;
+
+    /* Entries of length 0..127, reserved eight at a time. */
+    for (done = 0; done < sizeof(test_data); done += rc) {
+        for (i = 0; i < 8; i++) {
+            lens[i] = done + i;
+        }
+        rc = fcb_append_multi(fcb, lens, 8, locs);
+        /* All of them fit in the first sector. */
+        TEST_ASSERT_FATAL(rc == 8);
+
+        for (i = 0; i < rc; i++) {
+            for (j = 0; j < lens[i]; j++) {
+                test_data[j] = fcb_test_append_data(lens[i], j);
+            }
+            TEST_ASSERT(locs[i].fe_area == locs[0].fe_area);
+            TEST_ASSERT(flash_area_write(locs[i].fe_area,
+                                         locs[i].fe_data_off, test_data,
+                                         lens[i]) == 0);
+            TEST_ASSERT(fcb_append_finish(fcb, &locs[i]) == 0);
+        }
+    }
+    TEST_ASSERT(done == sizeof(test_data));
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == sizeof(test_data));
+}
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_erase_cnt)
+{
+#if MYNEWT_VAL(FCB_ERASE_CNT)
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint32_t cnt;
+    int rc;
+    int i;
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < 2; i++) {
+        rc = fcb_sector_erase_cnt(fcb, &test_fcb_area[i], &cnt);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(cnt == 0);
+    }
+
+    /* With two sectors, fcb_rotate() erases them in turn. */
+    for (i = 0; i < 5; i++) {
+        rc = fcb_rotate(fcb);
+        TEST_ASSERT(rc == 0);
+    }
+
+    /* The counts stay in place over a restart. */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+
+    rc = fcb_sector_erase_cnt(fcb, &test_fcb_area[0], &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 3);
+    rc = fcb_sector_erase_cnt(fcb, &test_fcb_area[1], &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 2);
+
+    /* Elements go after the count. */
+    rc = fcb_append(fcb, 16, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_elem_off == sizeof(struct fcb_disk_area));
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+#endif
+}
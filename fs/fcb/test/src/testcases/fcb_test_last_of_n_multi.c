@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+struct last_of_n_arg {
+    struct fcb_entry *locs;
+    int cnt;
+};
+
+static int
+fcb_test_last_of_n_multi_cb(struct fcb_entry *loc, void *arg)
+{
+    struct last_of_n_arg *la = arg;
+
+    la->locs[la->cnt++] = *loc;
+    return 0;
+}
+
+static void
+fcb_test_last_of_n_check(struct fcb *fcb)
+{
+    struct fcb_entry locs[512];
+    struct last_of_n_arg la;
+    struct fcb_entry loc;
+    int exp;
+    int rc;
+    int n;
+
+    la.locs = locs;
+    la.cnt = 0;
+    rc = fcb_walk(fcb, NULL, fcb_test_last_of_n_multi_cb, &la);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(la.cnt > 0);
+
+    for (n = 1; n < 256; n += 7) {
+        rc = fcb_offset_last_n(fcb, n, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        exp = la.cnt > n ? la.cnt - n : 0;
+        TEST_ASSERT(loc.fe_area == locs[exp].fe_area);
+        TEST_ASSERT(loc.fe_elem_off == locs[exp].fe_elem_off);
+        TEST_ASSERT(loc.fe_data_len == locs[exp].fe_data_len);
+    }
+}
+
+TEST_CASE(fcb_test_last_of_n_multi)
+{
+    uint8_t test_data[128];
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int rc;
+    int i;
+
+    fcb = &test_fcb;
+    fcb->f_scratch_cnt = 1;
+
+    memset(test_data, 0xa5, sizeof(test_data));
+
+    /* Spread the entries over three sectors. */
+    for (i = 0; i < 300; i++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT_FATAL(fcb->f_active.fe_area == &test_fcb_area[2]);
+    fcb_test_last_of_n_check(fcb);
+
+    /* Entries added after the sectors have been counted. */
+    for (i = 0; i < 10; i++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    fcb_test_last_of_n_check(fcb);
+
+    /* And after the oldest sector is gone. */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_last_of_n_check(fcb);
+}
@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_pre_erase)
+{
+#if MYNEWT_VAL(FCB_PRE_ERASE)
+    struct os_eventq evq;
+    struct os_event *ev;
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[128];
+    int erase_cnt;
+    int rc;
+    int i;
+
+    memset(test_data, 0xa5, sizeof(test_data));
+    os_eventq_init(&evq);
+    fcb_pre_erase_evq_set(&evq);
+
+    fcb = &test_fcb;
+    fcb->f_pre_erase = 75;
+
+    /*
+     * Write six sectors' worth.  The oldest sector is freed from the event
+     * queue each time, so appends never run out of space.
+     */
+    erase_cnt = 0;
+    for (i = 0; i < 6 * 0x4000 / (sizeof(test_data) + 2); i++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+                              sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+
+        ev = os_eventq_get_no_wait(&evq);
+        if (ev) {
+            TEST_ASSERT(fcb_free_sector_cnt(fcb) == 0);
+            TEST_ASSERT(fcb->f_active.fe_elem_off * 4 >= 0x4000 * 3);
+            ev->ev_cb(ev);
+            TEST_ASSERT(fcb_free_sector_cnt(fcb) == 1);
+            TEST_ASSERT(fcb->f_erasing == NULL);
+            erase_cnt++;
+        }
+    }
+    TEST_ASSERT(erase_cnt >= 2);
+
+    /* Nothing queued once pre-erase is turned off. */
+    fcb->f_pre_erase = 0;
+    while (1) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            break;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+
+    fcb_pre_erase_evq_set(NULL);
+#endif
+}
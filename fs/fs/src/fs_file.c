@@ -152,14 +152,11 @@ safe_fs_ops_for(const char *fs_name)
 struct fs_ops *
 fops_from_filename(const char *filename)
 {
-    char *disk;
-    char *fs_name = NULL;
+    const char *fs_name = NULL;
     struct fs_ops *unique;
 
-    disk = disk_name_from_path(filename);
-    if (disk) {
-        fs_name = disk_fs_for(disk);
-        free(disk);
+    if (strchr(filename, ':')) {
+        fs_name = disk_fs_for_path(filename);
     } else {
         /**
          * special case: if only one fs was ever registered,
@@ -35,13 +35,37 @@
 #include "fs/fs.h"
 #include "fs_priv.h"
 
+/*
+ * Transfers keep their file open between requests, so a client can keep
+ * several chunk requests in flight without each one reopening the file.
+ * A download is closed when its last byte has been sent or another file
+ * is requested; an upload when all bytes have arrived or another upload
+ * starts.
+ */
 static struct {
     struct {
         uint32_t off;
         uint32_t size;
         const struct flash_area *fa;
         struct fs_file *file;
+        char name[FS_NMGR_MAX_NAME + 1];
+#if MYNEWT_VAL(FS_NMGR_WRITE_BUF) > 0
+        /* Chunks are collected here and written in larger pieces. */
+        uint16_t buf_len;
+        uint8_t buf[MYNEWT_VAL(FS_NMGR_WRITE_BUF)];
+#endif
     } upload;
+    struct {
+        struct fs_file *file;
+        uint32_t len;
+        char name[FS_NMGR_MAX_NAME + 1];
+#if MYNEWT_VAL(FS_NMGR_READ_AHEAD) > 0
+        /* File data starting at buf_off, read ahead of the client. */
+        uint32_t buf_off;
+        uint32_t buf_len;
+        uint8_t buf[MYNEWT_VAL(FS_NMGR_READ_AHEAD)];
+#endif
+    } download;
 } fs_nmgr_state;
 
 static int fs_nmgr_file_download(struct mgmt_cbuf *cb);
@@ -63,12 +87,122 @@ static struct mgmt_group fs_nmgr_group = {
     .mg_group_id = MGMT_GROUP_ID_FS,
 };
 
+static int
+fs_nmgr_upload_flush(void)
+{
+#if MYNEWT_VAL(FS_NMGR_WRITE_BUF) > 0
+    int rc;
+
+    if (fs_nmgr_state.upload.buf_len) {
+        rc = fs_write(fs_nmgr_state.upload.file, fs_nmgr_state.upload.buf,
+                      fs_nmgr_state.upload.buf_len);
+        fs_nmgr_state.upload.buf_len = 0;
+        return rc;
+    }
+#endif
+    return 0;
+}
+
+static int
+fs_nmgr_upload_write(const void *data, int len)
+{
+#if MYNEWT_VAL(FS_NMGR_WRITE_BUF) > 0
+    int rc;
+
+    if (fs_nmgr_state.upload.buf_len + len > sizeof(fs_nmgr_state.upload.buf)) {
+        rc = fs_nmgr_upload_flush();
+        if (rc) {
+            return rc;
+        }
+    }
+    if (len < sizeof(fs_nmgr_state.upload.buf)) {
+        memcpy(fs_nmgr_state.upload.buf + fs_nmgr_state.upload.buf_len, data,
+               len);
+        fs_nmgr_state.upload.buf_len += len;
+        return 0;
+    }
+#endif
+    return fs_write(fs_nmgr_state.upload.file, data, len);
+}
+
+static int
+fs_nmgr_upload_close(void)
+{
+    int rc;
+
+    if (!fs_nmgr_state.upload.file) {
+        return 0;
+    }
+    rc = fs_nmgr_upload_flush();
+    fs_close(fs_nmgr_state.upload.file);
+    fs_nmgr_state.upload.file = NULL;
+    return rc;
+}
+
+static void
+fs_nmgr_download_close(void)
+{
+    if (fs_nmgr_state.download.file) {
+        fs_close(fs_nmgr_state.download.file);
+        fs_nmgr_state.download.file = NULL;
+    }
+}
+
+/*
+ * Returns a pointer to up to len bytes of the download file at off, reading
+ * into tmp (or the read-ahead buffer) as needed. len must not extend past
+ * the end of file.
+ */
+static int
+fs_nmgr_download_read(uint32_t off, uint8_t *tmp, uint32_t len,
+                      const uint8_t **data, uint32_t *out_len)
+{
+    struct fs_file *file;
+    int rc;
+
+    file = fs_nmgr_state.download.file;
+#if MYNEWT_VAL(FS_NMGR_READ_AHEAD) > 0
+    if (off < fs_nmgr_state.download.buf_off ||
+        off + len > fs_nmgr_state.download.buf_off +
+                    fs_nmgr_state.download.buf_len) {
+        fs_nmgr_state.download.buf_len = 0;
+        rc = fs_seek(file, off);
+        if (rc) {
+            return rc;
+        }
+        rc = fs_read(file, sizeof(fs_nmgr_state.download.buf),
+                     fs_nmgr_state.download.buf,
+                     &fs_nmgr_state.download.buf_len);
+        if (rc) {
+            return rc;
+        }
+        fs_nmgr_state.download.buf_off = off;
+    }
+    (void)tmp;
+    *data = fs_nmgr_state.download.buf + (off - fs_nmgr_state.download.buf_off);
+    *out_len = min(len, fs_nmgr_state.download.buf_off +
+                        fs_nmgr_state.download.buf_len - off);
+    return 0;
+#else
+    rc = fs_seek(file, off);
+    if (rc) {
+        return rc;
+    }
+    *data = tmp;
+    return fs_read(file, len, tmp, out_len);
+#endif
+}
+
 static int
 fs_nmgr_file_download(struct mgmt_cbuf *cb)
 {
     long long unsigned int off = UINT_MAX;
     char tmp_str[FS_NMGR_MAX_NAME + 1];
-    uint8_t img_data[MYNEWT_VAL(FS_UPLOAD_MAX_CHUNK_SIZE)];
+#if MYNEWT_VAL(FS_NMGR_READ_AHEAD) > 0
+    uint8_t *img_data = NULL;
+#else
+    uint8_t img_data[MYNEWT_VAL(FS_NMGR_DOWNLOAD_CHUNK_SIZE)];
+#endif
     const struct cbor_attr_t dload_attr[3] = {
         [0] = {
             .attribute = "off",
@@ -85,7 +219,7 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
     };
     int rc;
     uint32_t out_len;
-    struct fs_file *file;
+    const uint8_t *data;
     CborError g_err = CborNoError;
 
     rc = cbor_read_object(&cb->it, dload_attr);
@@ -93,17 +227,41 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
 
-    rc = fs_open(tmp_str, FS_ACCESS_READ, &file);
-    if (rc || !file) {
-        return MGMT_ERR_ENOMEM;
+    if (fs_nmgr_state.upload.file &&
+        !strcmp(tmp_str, fs_nmgr_state.upload.name)) {
+        /* Make what has been uploaded so far visible. */
+        rc = fs_nmgr_upload_flush();
+        if (rc) {
+            return MGMT_ERR_EUNKNOWN;
+        }
+#if MYNEWT_VAL(FS_NMGR_READ_AHEAD) > 0
+        fs_nmgr_state.download.buf_len = 0;
+#endif
     }
 
-    rc = fs_seek(file, off);
-    if (rc) {
+    if (!fs_nmgr_state.download.file ||
+        strcmp(tmp_str, fs_nmgr_state.download.name)) {
+        fs_nmgr_download_close();
+        rc = fs_open(tmp_str, FS_ACCESS_READ, &fs_nmgr_state.download.file);
+        if (rc || !fs_nmgr_state.download.file) {
+            fs_nmgr_state.download.file = NULL;
+            return MGMT_ERR_ENOMEM;
+        }
+        strcpy(fs_nmgr_state.download.name, tmp_str);
+#if MYNEWT_VAL(FS_NMGR_READ_AHEAD) > 0
+        fs_nmgr_state.download.buf_len = 0;
+#endif
+    }
+    rc = fs_filelen(fs_nmgr_state.download.file, &fs_nmgr_state.download.len);
+    if (rc || off > fs_nmgr_state.download.len) {
         rc = MGMT_ERR_EUNKNOWN;
         goto err_close;
     }
-    rc = fs_read(file, 32, img_data, &out_len);
+
+    rc = fs_nmgr_download_read(off, img_data,
+                               min(MYNEWT_VAL(FS_NMGR_DOWNLOAD_CHUNK_SIZE),
+                                   fs_nmgr_state.download.len - off),
+                               &data, &out_len);
     if (rc) {
         rc = MGMT_ERR_EUNKNOWN;
         goto err_close;
@@ -113,17 +271,18 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
     g_err |= cbor_encode_uint(&cb->encoder, off);
 
     g_err |= cbor_encode_text_stringz(&cb->encoder, "data");
-    g_err |= cbor_encode_byte_string(&cb->encoder, img_data, out_len);
+    g_err |= cbor_encode_byte_string(&cb->encoder, data, out_len);
 
     g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
     g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
     if (off == 0) {
-        rc = fs_filelen(file, &out_len);
         g_err |= cbor_encode_text_stringz(&cb->encoder, "len");
-        g_err |= cbor_encode_uint(&cb->encoder, out_len);
+        g_err |= cbor_encode_uint(&cb->encoder, fs_nmgr_state.download.len);
     }
 
-    fs_close(file);
+    if (off + out_len >= fs_nmgr_state.download.len) {
+        fs_nmgr_download_close();
+    }
     if (g_err) {
         return MGMT_ERR_ENOMEM;
     }
@@ -131,10 +290,41 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
     return 0;
 
 err_close:
-    fs_close(file);
+    fs_nmgr_download_close();
     return rc;
 }
 
+/*
+ * Continue an upload which is not the current one, e.g. after a reset.
+ * The client is told to resume from the current length of the file.
+ */
+static int
+fs_nmgr_upload_resume(const char *file_name, uint32_t size)
+{
+    uint32_t len;
+    int rc;
+
+    rc = fs_nmgr_upload_close();
+    if (rc) {
+        return MGMT_ERR_EUNKNOWN;
+    }
+    rc = fs_open(file_name, FS_ACCESS_WRITE | FS_ACCESS_APPEND,
+                 &fs_nmgr_state.upload.file);
+    if (rc) {
+        fs_nmgr_state.upload.file = NULL;
+        return MGMT_ERR_EINVAL;
+    }
+    rc = fs_filelen(fs_nmgr_state.upload.file, &len);
+    if (rc) {
+        fs_nmgr_upload_close();
+        return MGMT_ERR_EUNKNOWN;
+    }
+    strcpy(fs_nmgr_state.upload.name, file_name);
+    fs_nmgr_state.upload.off = len;
+    fs_nmgr_state.upload.size = size;
+    return 0;
+}
+
 static int
 fs_nmgr_file_upload(struct mgmt_cbuf *cb)
 {
@@ -189,16 +379,27 @@ fs_nmgr_file_upload(struct mgmt_cbuf *cb)
         if (!strlen(file_name)) {
             return MGMT_ERR_EINVAL;
         }
-        if (fs_nmgr_state.upload.file) {
-            fs_close(fs_nmgr_state.upload.file);
-            fs_nmgr_state.upload.file = NULL;
+        fs_nmgr_upload_close();
+        if (fs_nmgr_state.download.file &&
+            !strcmp(file_name, fs_nmgr_state.download.name)) {
+            fs_nmgr_download_close();
         }
         rc = fs_open(file_name, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE,
           &fs_nmgr_state.upload.file);
         if (rc) {
+            fs_nmgr_state.upload.file = NULL;
             return MGMT_ERR_EINVAL;
         }
-    } else if (off != fs_nmgr_state.upload.off) {
+        strcpy(fs_nmgr_state.upload.name, file_name);
+    } else if (strlen(file_name) &&
+               (!fs_nmgr_state.upload.file ||
+                strcmp(file_name, fs_nmgr_state.upload.name))) {
+        rc = fs_nmgr_upload_resume(file_name, size);
+        if (rc) {
+            return rc;
+        }
+    }
+    if (off != fs_nmgr_state.upload.off) {
         /*
          * Invalid offset. Drop the data, and respond with the offset we're
          * expecting data for.
@@ -210,7 +411,7 @@ fs_nmgr_file_upload(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
     if (img_len) {
-        rc = fs_write(fs_nmgr_state.upload.file, img_data, img_len);
+        rc = fs_nmgr_upload_write(img_data, img_len);
         if (rc) {
             rc = MGMT_ERR_EINVAL;
             goto err_close;
@@ -218,8 +419,11 @@ fs_nmgr_file_upload(struct mgmt_cbuf *cb)
         fs_nmgr_state.upload.off += img_len;
         if (fs_nmgr_state.upload.size == fs_nmgr_state.upload.off) {
             /* Done */
-            fs_close(fs_nmgr_state.upload.file);
-            fs_nmgr_state.upload.file = NULL;
+            rc = fs_nmgr_upload_close();
+            if (rc) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
         }
     }
 
@@ -234,8 +438,13 @@ out:
     return 0;
 
 err_close:
-    fs_close(fs_nmgr_state.upload.file);
-    fs_nmgr_state.upload.file = NULL;
+    if (fs_nmgr_state.upload.file) {
+        fs_close(fs_nmgr_state.upload.file);
+        fs_nmgr_state.upload.file = NULL;
+    }
+#if MYNEWT_VAL(FS_NMGR_WRITE_BUF) > 0
+    fs_nmgr_state.upload.buf_len = 0;
+#endif
     return rc;
 }
 
@@ -22,6 +22,7 @@
 
 #include <stddef.h>
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "fs/fs.h"
 
 #ifdef __cplusplus
@@ -49,6 +50,18 @@ struct nffs_config {
 
     /** Data block cache size; default=64. */
     uint32_t nc_num_cache_blocks;
+
+    /**
+     * Number of blocks to cache ahead of a sequential read;
+     * default=NFFS_CACHE_READAHEAD.
+     */
+    uint32_t nc_cache_readahead;
+
+    /**
+     * Number of RAM buffers for coalescing appends to open files;
+     * default=NFFS_WRITE_BUF_CNT.
+     */
+    uint32_t nc_num_write_bufs;
 };
 
 extern struct nffs_config nffs_config;
@@ -65,6 +78,15 @@ int nffs_format(const struct nffs_area_desc *area_descs);
 
 int nffs_misc_desc_from_flash_area(int idx, int *cnt, struct nffs_area_desc *nad);
 
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+int nffs_gc_step(int max_objects);
+#endif
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+int nffs_checkpoint_area_set(const struct nffs_area_desc *area_desc);
+int nffs_checkpoint(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
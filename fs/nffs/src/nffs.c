@@ -44,6 +44,7 @@ struct os_mempool nffs_inode_entry_pool;
 struct os_mempool nffs_block_entry_pool;
 struct os_mempool nffs_cache_inode_pool;
 struct os_mempool nffs_cache_block_pool;
+struct os_mempool nffs_wbuf_pool;
 
 void *nffs_file_mem;
 void *nffs_inode_mem;
@@ -51,6 +52,7 @@ void *nffs_block_entry_mem;
 void *nffs_cache_inode_mem;
 void *nffs_cache_block_mem;
 void *nffs_dir_mem;
+void *nffs_wbuf_mem;
 
 struct nffs_inode_entry *nffs_root_dir;
 struct nffs_inode_entry *nffs_lost_found_dir;
@@ -104,10 +106,16 @@ STATS_SECT_DECL(nffs_stats) nffs_stats;
 STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_hashcnt_ins)
     STATS_NAME(nffs_stats, nffs_hashcnt_rm)
+    STATS_NAME(nffs_stats, nffs_hash_buckets)
+    STATS_NAME(nffs_stats, nffs_hash_load_pct)
+    STATS_NAME(nffs_stats, nffs_hash_chain_max)
     STATS_NAME(nffs_stats, nffs_object_count)
     STATS_NAME(nffs_stats, nffs_iocnt_read)
     STATS_NAME(nffs_stats, nffs_iocnt_write)
     STATS_NAME(nffs_stats, nffs_gccnt)
+    STATS_NAME(nffs_stats, nffs_gc_steps)
+    STATS_NAME(nffs_stats, nffs_gc_pause_last_ms)
+    STATS_NAME(nffs_stats, nffs_gc_pause_max_ms)
     STATS_NAME(nffs_stats, nffs_readcnt_data)
     STATS_NAME(nffs_stats, nffs_readcnt_block)
     STATS_NAME(nffs_stats, nffs_readcnt_crc)
@@ -188,7 +196,7 @@ nffs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
 {
     int rc;
     struct nffs_file *out_file;
-    char *filepath = NULL;
+    const char *filepath;
 
     nffs_lock();
 
@@ -197,7 +205,7 @@ nffs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
         goto done;
     }
 
-    filepath = disk_filepath_from_path(path);
+    filepath = disk_filepath(path);
 
     rc = nffs_file_open(&out_file, filepath, access_flags);
     if (rc != 0) {
@@ -205,9 +213,6 @@ nffs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
     }
     *out_fs_file = (struct fs_file *)out_file;
 done:
-    if (filepath) {
-        free(filepath);
-    }
     nffs_unlock();
     if (rc != 0) {
         *out_fs_file = NULL;
@@ -301,6 +306,10 @@ nffs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
 
     nffs_lock();
     rc = nffs_inode_data_len(file->nf_inode_entry, out_len);
+    if (rc == 0) {
+        /* Include appended data this handle has not written out yet. */
+        *out_len += file->nf_wbuf_len;
+    }
     nffs_unlock();
 
     return rc;
@@ -493,7 +502,7 @@ nffs_opendir(const char *path, struct fs_dir **out_fs_dir)
 {
     int rc;
     struct nffs_dir **out_dir = (struct nffs_dir **)out_fs_dir;
-    char *filepath = NULL;
+    const char *filepath;
 
     nffs_lock();
 
@@ -502,14 +511,11 @@ nffs_opendir(const char *path, struct fs_dir **out_fs_dir)
         goto done;
     }
 
-    filepath = disk_filepath_from_path(path);
+    filepath = disk_filepath(path);
 
     rc = nffs_dir_open(filepath, out_dir);
 
 done:
-    if (filepath) {
-        free(filepath);
-    }
     nffs_unlock();
     if (rc != 0) {
         *out_dir = NULL;
@@ -668,6 +674,93 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Sets the flash region that checkpoints are written to.  When a valid
+ * checkpoint is found there, nffs_detect() restores the file system from it
+ * and only reads objects written after it from the nffs areas; otherwise the
+ * areas are read in full.  The region must not overlap any nffs area.
+ *
+ * @param area_desc         The region to use; NULL to stop using checkpoints.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_checkpoint_area_set(const struct nffs_area_desc *area_desc)
+{
+    nffs_lock();
+
+    if (area_desc != NULL) {
+        nffs_checkpoint_desc = *area_desc;
+    } else {
+        memset(&nffs_checkpoint_desc, 0, sizeof nffs_checkpoint_desc);
+    }
+    nffs_checkpoint_valid = 0;
+
+    nffs_unlock();
+
+    return 0;
+}
+
+/**
+ * Writes a checkpoint of the file system, for a faster nffs_detect() on the
+ * next boot.  Do this before a clean shutdown, or periodically; files
+ * written after the checkpoint are still found, but take longer to restore.
+ * The checkpoint is dropped by the next garbage collection cycle.
+ *
+ * @return                  0 on success;
+ *                          FS_EFULL if the checkpoint region is too small;
+ *                          other nonzero on failure.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_checkpoint_write();
+    nffs_unlock();
+
+    return rc;
+}
+#endif
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+/**
+ * Performs a bounded amount of garbage collection, ahead of the point where a
+ * writer would otherwise have to collect a whole area.  Intended to be called
+ * repeatedly from a low priority task or other idle-time hook until it
+ * returns FS_ENOENT.
+ *
+ * @param max_objects       The approximate number of objects to move.
+ *
+ * @return                  0 if some garbage collection was performed;
+ *                          FS_ENOENT if no garbage collection is needed;
+ *                          other nonzero on failure.
+ */
+int
+nffs_gc_step(int max_objects)
+{
+    int rc;
+
+    if (max_objects <= 0) {
+        return FS_EINVAL;
+    }
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        rc = nffs_gc_incremental(max_objects);
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+#endif
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -740,6 +833,17 @@ nffs_init(void)
         return FS_ENOMEM;
     }
 
+    free(nffs_wbuf_mem);
+    nffs_wbuf_mem = NULL;
+    if (nffs_config.nc_num_write_bufs > 0) {
+        nffs_wbuf_mem = malloc(
+            OS_MEMPOOL_BYTES(nffs_config.nc_num_write_bufs,
+                             MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)));
+        if (nffs_wbuf_mem == NULL) {
+            return FS_ENOMEM;
+        }
+    }
+
     rc = nffs_misc_reset();
     if (rc != 0) {
         return rc;
@@ -753,6 +857,10 @@ void
 nffs_pkg_init(void)
 {
     struct nffs_area_desc descs[MYNEWT_VAL(NFFS_NUM_AREAS) + 1];
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    struct nffs_area_desc ckpt_desc;
+    const struct flash_area *fa;
+#endif
     int cnt;
     int rc;
 
@@ -771,6 +879,16 @@ nffs_pkg_init(void)
         MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    rc = flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), &fa);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    ckpt_desc.nad_offset = fa->fa_off;
+    ckpt_desc.nad_length = fa->fa_size;
+    ckpt_desc.nad_flash_id = fa->fa_device_id;
+    flash_area_close(fa);
+    nffs_checkpoint_area_set(&ckpt_desc);
+#endif
+
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
     switch (rc) {
@@ -800,4 +918,11 @@ nffs_pkg_init(void)
         SYSINIT_PANIC();
         break;
     }
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Make the next mount quick.  Failure only costs boot time. */
+    if (nffs_misc_ready() && !nffs_checkpoint_valid) {
+        nffs_checkpoint();
+    }
+#endif
 }
@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
@@ -26,6 +27,14 @@ TAILQ_HEAD(nffs_cache_inode_list, nffs_cache_inode);
 static struct nffs_cache_inode_list nffs_cache_inode_list =
     TAILQ_HEAD_INITIALIZER(nffs_cache_inode_list);
 
+/**
+ * Blocks passed over while searching for a block beyond the end of the
+ * cache.  After a sequential seek, these are added to the cache so that the
+ * next few reads do not need to search again.
+ */
+static struct nffs_cache_block *nffs_cache_ra;
+static uint32_t nffs_cache_ra_max;
+
 static void nffs_cache_reclaim_blocks(void);
 
 static struct nffs_cache_block *
@@ -65,6 +74,39 @@ nffs_cache_block_acquire(void)
     return cache_block;
 }
 
+/**
+ * Allocates a cache block for a sequential read of the specified inode.  If
+ * no blocks are free, the inode's own oldest cached block is recycled rather
+ * than evicting the blocks of other inodes, so that streaming a large file
+ * does not push everything else out of the cache.
+ *
+ * @param cache_inode           The inode being read sequentially.
+ * @param keep                  A cached block that must not be recycled;
+ *                                  null if there is none.
+ *
+ * @return                      The allocated block; null if the pool is
+ *                                  empty and nothing could be recycled.
+ */
+static struct nffs_cache_block *
+nffs_cache_block_acquire_seq(struct nffs_cache_inode *cache_inode,
+                             const struct nffs_cache_block *keep)
+{
+    struct nffs_cache_block *cache_block;
+
+    cache_block = nffs_cache_block_alloc();
+    if (cache_block == NULL) {
+        cache_block = TAILQ_FIRST(&cache_inode->nci_block_list);
+        if (cache_block == NULL || cache_block == keep) {
+            return NULL;
+        }
+
+        TAILQ_REMOVE(&cache_inode->nci_block_list, cache_block, ncb_link);
+        memset(cache_block, 0, sizeof *cache_block);
+    }
+
+    return cache_block;
+}
+
 static int
 nffs_cache_block_populate(struct nffs_cache_block *cache_block,
                           struct nffs_hash_entry *block_entry,
@@ -253,6 +295,11 @@ nffs_cache_inode_ensure(struct nffs_cache_inode **out_cache_inode,
 
     cache_inode = nffs_cache_inode_find(inode_entry);
     if (cache_inode != NULL) {
+        /* Keep the list in LRU order; inodes are evicted from the tail. */
+        if (cache_inode != TAILQ_FIRST(&nffs_cache_inode_list)) {
+            TAILQ_REMOVE(&nffs_cache_inode_list, cache_inode, nci_link);
+            TAILQ_INSERT_HEAD(&nffs_cache_inode_list, cache_inode, nci_link);
+        }
         rc = 0;
         goto done;
     }
@@ -344,6 +391,45 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
     nffs_cache_log_insert_block(cache_inode, cache_block, tail);
 }
 
+/**
+ * Appends the blocks following a sequentially read block to the cache.  These
+ * were recorded in nffs_cache_ra while nffs_cache_seek() searched backwards
+ * from the end of the file, so no further flash reads are needed.  Read-ahead
+ * only recycles the inode's own older blocks, never those of other inodes.
+ *
+ * @param cache_inode           The inode being read.
+ * @param cache_block           The block just read; last in the cache.
+ * @param ra_cnt                The number of blocks recorded while searching.
+ */
+static void
+nffs_cache_readahead(struct nffs_cache_inode *cache_inode,
+                     struct nffs_cache_block *cache_block, uint32_t ra_cnt)
+{
+    struct nffs_cache_block *ra_block;
+    struct nffs_cache_block *src;
+    uint32_t num;
+    uint32_t i;
+
+    num = ra_cnt;
+    if (num > nffs_cache_ra_max) {
+        num = nffs_cache_ra_max;
+    }
+
+    /* The most recently recorded block directly follows the one just read. */
+    for (i = 1; i <= num; i++) {
+        src = nffs_cache_ra + (ra_cnt - i) % nffs_cache_ra_max;
+
+        ra_block = nffs_cache_block_acquire_seq(cache_inode, cache_block);
+        if (ra_block == NULL) {
+            break;
+        }
+
+        ra_block->ncb_block = src->ncb_block;
+        ra_block->ncb_file_offset = src->ncb_file_offset;
+        nffs_cache_insert_block(cache_inode, ra_block, 1);
+    }
+}
+
 /**
  * Finds the data block containing the specified offset within a file inode.
  * If the block is not yet cached, it gets cached as a result of this
@@ -362,6 +448,9 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
  *         list.
  *      b. Else, clear the cache, and populate it with the single entry
  *         corresponding to the requested block.
+ *     In case a, or if the requested block is the first in the file, the
+ *     access is considered sequential: up to nc_cache_readahead of the
+ *     blocks that follow it are cached as well.
  *
  * @param cache_inode           The cached file inode to seek within.
  * @param seek_offset           The file offset to seek to.
@@ -384,6 +473,7 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     uint32_t cache_end;
     uint32_t block_start;
     uint32_t block_end;
+    uint32_t ra_cnt;
     int rc;
 
     /* Empty files have no blocks that can be cached. */
@@ -416,6 +506,8 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         block_end = cache_inode->nci_file_size;
     }
 
+    ra_cnt = 0;
+
     /* Scan backwards until we find the block containing the seek offest. */
     while (1) {
         if (block_end <= cache_start) {
@@ -463,19 +555,29 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
                  * erase the current cache and populate it with this single
                  * block.
                  */
-                cache_block = nffs_cache_block_acquire();
-                cache_block->ncb_block = block;
-                cache_block->ncb_file_offset = block_start;
-
                 last_cached_entry = nffs_cache_inode_last_entry(cache_inode);
                 if (last_cached_entry != NULL &&
                     last_cached_entry == pred_entry) {
 
+                    cache_block = nffs_cache_block_acquire_seq(cache_inode,
+                                                               NULL);
+                    if (cache_block == NULL) {
+                        cache_block = nffs_cache_block_acquire();
+                    }
+                    cache_block->ncb_block = block;
+                    cache_block->ncb_file_offset = block_start;
                     nffs_cache_insert_block(cache_inode, cache_block, 1);
                 } else {
                     nffs_cache_inode_free_blocks(cache_inode);
+                    cache_block = nffs_cache_block_acquire();
+                    cache_block->ncb_block = block;
+                    cache_block->ncb_file_offset = block_start;
                     nffs_cache_insert_block(cache_inode, cache_block, 0);
                 }
+
+                if (last_cached_entry == pred_entry || pred_entry == NULL) {
+                    nffs_cache_readahead(cache_inode, cache_block, ra_cnt);
+                }
             }
 
             if (out_cache_block != NULL) {
@@ -488,6 +590,12 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         if (cache_block != NULL) {
             cache_block = TAILQ_PREV(cache_block, nffs_cache_block_list,
                                      ncb_link);
+        } else if (nffs_cache_ra_max > 0) {
+            /* Remember the blocks just past the one being sought. */
+            nffs_cache_ra[ra_cnt % nffs_cache_ra_max].ncb_block = block;
+            nffs_cache_ra[ra_cnt % nffs_cache_ra_max].ncb_file_offset =
+                block_start;
+            ra_cnt++;
         }
         block_entry = pred_entry;
         block_end = block_start;
@@ -496,6 +604,30 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     return 0;
 }
 
+/**
+ * Allocates the read-ahead buffer according to nc_cache_readahead.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_cache_init(void)
+{
+    free(nffs_cache_ra);
+    nffs_cache_ra = NULL;
+    nffs_cache_ra_max = 0;
+
+    if (nffs_config.nc_cache_readahead > 0) {
+        nffs_cache_ra = malloc(nffs_config.nc_cache_readahead *
+                               sizeof *nffs_cache_ra);
+        if (nffs_cache_ra == NULL) {
+            return FS_ENOMEM;
+        }
+        nffs_cache_ra_max = nffs_config.nc_cache_readahead;
+    }
+
+    return 0;
+}
+
 /**
  * Frees all cached inodes and blocks.
  */
@@ -0,0 +1,269 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+
+#include <stddef.h>
+#include <string.h>
+#include "hal/hal_flash.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+/** Where checkpoints go; nad_length is 0 if none have been configured. */
+struct nffs_area_desc nffs_checkpoint_desc;
+
+/** Set while the checkpoint in flash matches the file system. */
+uint8_t nffs_checkpoint_valid;
+
+#define NFFS_CHECKPOINT_BUF_CNT     8
+
+int
+nffs_checkpoint_read(uint32_t offset, void *data, uint32_t len)
+{
+    int rc;
+
+    if (offset + len > nffs_checkpoint_desc.nad_length) {
+        return FS_EOFFSET;
+    }
+
+    rc = hal_flash_read(nffs_checkpoint_desc.nad_flash_id,
+                        nffs_checkpoint_desc.nad_offset + offset, data, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_write_at(uint32_t offset, const void *data, uint32_t len)
+{
+    int rc;
+
+    if (offset + len > nffs_checkpoint_desc.nad_length) {
+        return FS_EFULL;
+    }
+
+    rc = hal_flash_write(nffs_checkpoint_desc.nad_flash_id,
+                         nffs_checkpoint_desc.nad_offset + offset, data, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+/**
+ * Marks the checkpoint in flash as stale.  Called before anything rewrites
+ * data which a checkpoint refers to (garbage collection, format).  Only the
+ * magic number gets cleared, so no erase is needed.
+ */
+void
+nffs_checkpoint_invalidate(void)
+{
+    uint32_t magic;
+
+    if (!nffs_checkpoint_valid) {
+        return;
+    }
+    nffs_checkpoint_valid = 0;
+
+    magic = 0;
+    nffs_checkpoint_write_at(offsetof(struct nffs_disk_checkpoint, ndc_magic),
+                             &magic, sizeof magic);
+}
+
+/**
+ * Fills in the checkpoint entry for an object, if it should be part of the
+ * checkpoint.
+ *
+ * @return                      0 if the entry was filled in;
+ *                              FS_ENOENT if the object is to be skipped;
+ *                              other nonzero on error.
+ */
+static int
+nffs_checkpoint_object(struct nffs_hash_entry *entry,
+                       struct nffs_disk_checkpoint_object *out_object)
+{
+    struct nffs_inode_entry *inode_entry;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    if (entry->nhe_flash_loc == NFFS_FLASH_LOC_NONE) {
+        return FS_ENOENT;
+    }
+    nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+    out_object->ndco_flash_loc = entry->nhe_flash_loc;
+
+    if (nffs_hash_id_is_inode(entry->nhe_id)) {
+        inode_entry = (struct nffs_inode_entry *)entry;
+        if (nffs_inode_is_dummy(inode_entry) ||
+            nffs_inode_is_deleted(inode_entry)) {
+
+            return FS_ENOENT;
+        }
+        return nffs_inode_read_disk(area_idx, area_offset,
+                                    &out_object->ndco_disk_inode);
+    }
+
+    rc = nffs_block_read_disk(area_idx, area_offset,
+                              &out_object->ndco_disk_block);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Blocks of deleted files are not restored either. */
+    inode_entry =
+        nffs_hash_find_inode(out_object->ndco_disk_block.ndb_inode_id);
+    if (inode_entry == NULL || nffs_inode_is_dummy(inode_entry) ||
+        nffs_inode_is_deleted(inode_entry)) {
+
+        return FS_ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a snapshot of the current inodes and data blocks to the checkpoint
+ * area, replacing the previous one.
+ *
+ * @return                      0 on success;
+ *                              FS_EFULL if the checkpoint area is too small;
+ *                              other nonzero on failure.
+ */
+int
+nffs_checkpoint_write(void)
+{
+    struct nffs_disk_checkpoint_object objects[NFFS_CHECKPOINT_BUF_CNT];
+    struct nffs_disk_checkpoint_area disk_area;
+    struct nffs_disk_checkpoint disk_ckpt;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_area *area;
+    uint32_t offset;
+    uint16_t crc;
+    int obj_cnt;
+    int rc;
+    int i;
+
+    if (nffs_checkpoint_desc.nad_length == 0) {
+        return FS_EINVAL;
+    }
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    /* An unfinished garbage collection cycle leaves two areas with the same
+     * ID; finish it so the checkpoint describes a consistent set of areas.
+     */
+    if (nffs_gc_from_area_idx != NFFS_AREA_ID_NONE) {
+        rc = nffs_gc(NULL);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    nffs_checkpoint_valid = 0;
+    rc = hal_flash_erase(nffs_checkpoint_desc.nad_flash_id,
+                         nffs_checkpoint_desc.nad_offset,
+                         nffs_checkpoint_desc.nad_length);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    memset(&disk_ckpt, 0xff, sizeof disk_ckpt);
+    disk_ckpt.ndc_ver = NFFS_CHECKPOINT_VER;
+    disk_ckpt.ndc_num_areas = nffs_num_areas;
+    disk_ckpt.ndc_scratch_area_idx = nffs_scratch_area_idx;
+    disk_ckpt.ndc_num_objects = 0;
+    disk_ckpt.ndc_next_dir_id = nffs_hash_next_dir_id;
+    disk_ckpt.ndc_next_file_id = nffs_hash_next_file_id;
+    disk_ckpt.ndc_next_block_id = nffs_hash_next_block_id;
+
+    crc = 0;
+    offset = sizeof disk_ckpt;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        area = nffs_areas + i;
+
+        memset(&disk_area, 0xff, sizeof disk_area);
+        disk_area.ndca_offset = area->na_offset;
+        disk_area.ndca_cur = area->na_cur;
+        disk_area.ndca_id = area->na_id;
+        disk_area.ndca_gc_seq = area->na_gc_seq;
+
+        rc = nffs_checkpoint_write_at(offset, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+        crc = crc16_ccitt(crc, &disk_area, sizeof disk_area);
+        offset += sizeof disk_area;
+    }
+
+    obj_cnt = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        rc = nffs_checkpoint_object(entry, objects + obj_cnt);
+        if (rc == FS_ENOENT) {
+            continue;
+        }
+        if (rc != 0) {
+            return rc;
+        }
+
+        obj_cnt++;
+        if (obj_cnt == NFFS_CHECKPOINT_BUF_CNT) {
+            rc = nffs_checkpoint_write_at(offset, objects, sizeof objects);
+            if (rc != 0) {
+                return rc;
+            }
+            crc = crc16_ccitt(crc, objects, sizeof objects);
+            offset += sizeof objects;
+            disk_ckpt.ndc_num_objects += obj_cnt;
+            obj_cnt = 0;
+        }
+    }
+    if (obj_cnt > 0) {
+        rc = nffs_checkpoint_write_at(offset, objects,
+                                      obj_cnt * sizeof objects[0]);
+        if (rc != 0) {
+            return rc;
+        }
+        crc = crc16_ccitt(crc, objects, obj_cnt * sizeof objects[0]);
+        disk_ckpt.ndc_num_objects += obj_cnt;
+    }
+
+    /* The header goes last; a checkpoint without its magic is ignored. */
+    disk_ckpt.ndc_crc16 = crc16_ccitt(crc, &disk_ckpt.ndc_ver,
+        NFFS_DISK_CHECKPOINT_OFFSET_CRC -
+        offsetof(struct nffs_disk_checkpoint, ndc_ver));
+    disk_ckpt.ndc_magic = NFFS_CHECKPOINT_MAGIC;
+    rc = nffs_checkpoint_write_at(0, &disk_ckpt, sizeof disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_checkpoint_valid = 1;
+    return 0;
+}
+
+#endif
@@ -28,6 +28,8 @@ const struct nffs_config nffs_config_dflt = {
     .nc_num_cache_inodes = 4,
     .nc_num_cache_blocks = 64,
     .nc_num_dirs = 4,
+    .nc_cache_readahead = MYNEWT_VAL(NFFS_CACHE_READAHEAD),
+    .nc_num_write_bufs = MYNEWT_VAL(NFFS_WRITE_BUF_CNT),
 };
 
 void
@@ -51,4 +53,10 @@ nffs_config_init(void)
     if (nffs_config.nc_num_dirs == 0) {
         nffs_config.nc_num_dirs = nffs_config_dflt.nc_num_dirs;
     }
+    if (nffs_config.nc_cache_readahead == 0) {
+        nffs_config.nc_cache_readahead = nffs_config_dflt.nc_cache_readahead;
+    }
+    if (nffs_config.nc_num_write_bufs == 0) {
+        nffs_config.nc_num_write_bufs = nffs_config_dflt.nc_num_write_bufs;
+    }
 }
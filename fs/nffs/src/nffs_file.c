@@ -272,6 +272,11 @@ nffs_file_seek(struct nffs_file *file, uint32_t offset)
     uint32_t len;
     int rc;
 
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = nffs_inode_data_len(file->nf_inode_entry, &len);
     if (rc != 0) {
         return rc;
@@ -313,6 +318,11 @@ nffs_file_read(struct nffs_file *file, uint32_t len, void *out_data,
         return FS_EACCESS;
     }
 
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = nffs_inode_read(file->nf_inode_entry, file->nf_offset, len, out_data,
                         &bytes_read);
     if (rc != 0) {
@@ -341,6 +351,12 @@ nffs_file_close(struct nffs_file *file)
 {
     int rc;
 
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+    nffs_write_buf_free(file);
+
     rc = nffs_inode_dec_refcnt(file->nf_inode_entry);
     if (rc != 0) {
         return rc;
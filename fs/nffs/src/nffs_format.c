@@ -111,6 +111,7 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     int i;
 
     /* Start from a clean state. */
+    nffs_checkpoint_invalidate();
     nffs_misc_reset();
 
     /* Select largest area to be the initial scratch area. */
@@ -31,6 +31,31 @@
  */
 unsigned int nffs_gc_count;
 
+/**
+ * Index of the source area of an unfinished garbage collection cycle;
+ * NFFS_AREA_ID_NONE if none is in progress.  Nothing new gets written to this
+ * area until the cycle completes.
+ */
+uint8_t nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
+
+/** Next hash bucket to collect in the current cycle. */
+static uint32_t nffs_gc_next_bucket;
+
+/** Number of objects moved so far in the current collection step. */
+static uint32_t nffs_gc_moved;
+
+/** Longest garbage collection pause seen, in milliseconds. */
+static uint32_t nffs_gc_pause_max;
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+/**
+ * Bytes written to all areas when the last garbage collection cycle
+ * completed.  A new incremental cycle is only started after something has
+ * been written since then; otherwise there is nothing new to reclaim.
+ */
+static uint32_t nffs_gc_written;
+#endif
+
 static int
 nffs_gc_copy_object(struct nffs_hash_entry *entry, uint16_t object_size,
                     uint8_t to_area_idx)
@@ -51,6 +76,7 @@ nffs_gc_copy_object(struct nffs_hash_entry *entry, uint16_t object_size,
     }
 
     entry->nhe_flash_loc = nffs_flash_loc(to_area_idx, to_area_offset);
+    nffs_gc_moved++;
 
     return 0;
 }
@@ -260,6 +286,7 @@ nffs_gc_block_chain_collate(struct nffs_hash_entry *last_entry,
     }
 
     last_entry->nhe_flash_loc = nffs_flash_loc(to_area_idx, to_area_offset);
+    nffs_gc_moved++;
 
     rc = 0;
 
@@ -395,6 +422,219 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
     return 0;
 }
 
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+static uint32_t
+nffs_gc_bytes_written(void)
+{
+    uint32_t written;
+    int i;
+
+    written = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            written += nffs_areas[i].na_cur;
+        }
+    }
+
+    return written;
+}
+#endif
+
+static void
+nffs_gc_record_pause(os_time_t start)
+{
+    uint32_t ms;
+
+    ms = os_time_ticks_to_ms32(os_time_get() - start);
+    if (ms > nffs_gc_pause_max) {
+        nffs_gc_pause_max = ms;
+        STATS_CLEAR(nffs_stats, nffs_gc_pause_max_ms);
+        STATS_INCN(nffs_stats, nffs_gc_pause_max_ms, ms);
+    }
+    STATS_CLEAR(nffs_stats, nffs_gc_pause_last_ms);
+    STATS_INCN(nffs_stats, nffs_gc_pause_last_ms, ms);
+}
+
+/**
+ * Starts a garbage collection cycle: selects the source area and turns the
+ * scratch area into the destination area (steps 1 and 2 of nffs_gc()).
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_begin(void)
+{
+    struct nffs_area *from_area;
+    uint8_t from_area_idx;
+    int rc;
+
+    from_area_idx = nffs_gc_select_area();
+    from_area = nffs_areas + from_area_idx;
+
+    /* Objects are about to move; a checkpoint would point at stale data. */
+    nffs_checkpoint_invalidate();
+
+    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
+                                       from_area->na_id);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_gc_from_area_idx = from_area_idx;
+    nffs_gc_next_bucket = 0;
+
+    return 0;
+}
+
+/**
+ * Copies the objects resident in the source area to the destination area
+ * (step 3 of nffs_gc()), one hash bucket at a time.  Objects which are
+ * created or moved while a cycle is in progress never land in the source
+ * area, so the buckets already visited need not be visited again.
+ *
+ * @param max_objects       Stop after the bucket in which this many objects
+ *                              have been moved; 0 for no limit.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_collect(uint32_t max_objects)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_inode_entry *inode_entry;
+    uint32_t area_offset;
+    uint8_t from_area_idx;
+    uint8_t area_idx;
+    int rc;
+
+    from_area_idx = nffs_gc_from_area_idx;
+    nffs_gc_moved = 0;
+
+    while (nffs_gc_next_bucket < nffs_hash_size) {
+        if (max_objects != 0 && nffs_gc_moved >= max_objects) {
+            break;
+        }
+
+        entry = SLIST_FIRST(nffs_hash + nffs_gc_next_bucket);
+        while (entry != NULL) {
+            next = SLIST_NEXT(entry, nhe_next);
+
+            if (nffs_hash_id_is_inode(entry->nhe_id)) {
+                /* The inode gets copied if it is in the source area. */
+                nffs_flash_loc_expand(entry->nhe_flash_loc,
+                                      &area_idx, &area_offset);
+                inode_entry = (struct nffs_inode_entry *)entry;
+                if (area_idx == from_area_idx) {
+                    rc = nffs_gc_copy_inode(inode_entry,
+                                            nffs_scratch_area_idx);
+                    if (rc != 0) {
+                        return rc;
+                    }
+                }
+
+                /* If the inode is a file, all constituent data blocks that are
+                 * resident in the source area get copied.
+                 */
+                if (nffs_hash_id_is_file(entry->nhe_id)) {
+                    rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
+                                              nffs_scratch_area_idx, &next);
+                    if (rc != 0) {
+                        return rc;
+                    }
+                }
+            }
+
+            entry = next;
+        }
+
+        nffs_gc_next_bucket++;
+    }
+
+    return 0;
+}
+
+/**
+ * Refreshes the cache after objects have been moved.  Garbage collection
+ * renders the cache invalid:
+ *     o All cached blocks are now invalid; drop them.
+ *     o Flash locations of inodes may have changed; the cached inodes need
+ *       updated to reflect this.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_refresh(void)
+{
+    int rc;
+
+    rc = nffs_cache_inode_refresh();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Increment the garbage collection counter so that client code knows to
+     * reset its pointers to cached objects.
+     */
+    nffs_gc_count++;
+
+    return 0;
+}
+
+/**
+ * Completes a garbage collection cycle once every object has been copied out
+ * of the source area (step 4 of nffs_gc()).
+ *
+ * @param out_area_idx      On success, the ID of the cleaned up area gets
+ *                              written here.  Pass null if you do not need
+ *                              this information.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_finish(uint8_t *out_area_idx)
+{
+    struct nffs_area *from_area;
+    struct nffs_area *to_area;
+    uint8_t from_area_idx;
+    int rc;
+
+    from_area_idx = nffs_gc_from_area_idx;
+    from_area = nffs_areas + from_area_idx;
+    to_area = nffs_areas + nffs_scratch_area_idx;
+
+    /* The amount of written data should never increase as a result of a gc
+     * cycle.
+     */
+    assert(to_area->na_cur <= from_area->na_cur);
+
+    /* Turn the source area into the new scratch area. */
+    from_area->na_gc_seq++;
+    rc = nffs_format_area(from_area_idx, 1);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (out_area_idx != NULL) {
+        *out_area_idx = nffs_scratch_area_idx;
+    }
+
+    nffs_scratch_area_idx = from_area_idx;
+    nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
+
+    rc = nffs_gc_refresh();
+    if (rc != 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    nffs_gc_written = nffs_gc_bytes_written();
+#endif
+    STATS_INC(nffs_stats, nffs_gccnt);
+
+    return 0;
+}
+
 /**
  * Triggers a garbage collection cycle.  This is implemented as follows:
  *
@@ -425,6 +665,9 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
  *      number is incremented prior to rewriting the header.  This area is now
  *      the new scratch sector.
  *
+ * If a cycle was started by nffs_gc_incremental() and has not finished yet,
+ * this function completes that cycle instead of starting a new one.
+ *
  * NOTE:
  *     Garbage collection invalidates all cached data blocks.  Whenever this
  *     function is called, all existing nffs_cache_block pointers are rendered
@@ -446,97 +689,122 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
 int
 nffs_gc(uint8_t *out_area_idx)
 {
-    struct nffs_hash_entry *entry;
-    struct nffs_hash_entry *next;
-    struct nffs_area *from_area;
-    struct nffs_area *to_area;
-    struct nffs_inode_entry *inode_entry;
-    uint32_t area_offset;
-    uint8_t from_area_idx;
-    uint8_t area_idx;
+    os_time_t start;
     int rc;
-    int i;
 
-    from_area_idx = nffs_gc_select_area();
-    from_area = nffs_areas + from_area_idx;
-    to_area = nffs_areas + nffs_scratch_area_idx;
+    start = os_time_get();
 
-    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
-                                       from_area->na_id);
+    if (nffs_gc_from_area_idx == NFFS_AREA_ID_NONE) {
+        rc = nffs_gc_begin();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    rc = nffs_gc_collect(0);
     if (rc != 0) {
         return rc;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        entry = SLIST_FIRST(nffs_hash + i);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
+    rc = nffs_gc_finish(out_area_idx);
+    if (rc != 0) {
+        return rc;
+    }
 
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
-                /* The inode gets copied if it is in the source area. */
-                nffs_flash_loc_expand(entry->nhe_flash_loc,
-                                      &area_idx, &area_offset);
-                inode_entry = (struct nffs_inode_entry *)entry;
-                if (area_idx == from_area_idx) {
-                    rc = nffs_gc_copy_inode(inode_entry,
-                                            nffs_scratch_area_idx);
-                    if (rc != 0) {
-                        return rc;
-                    }
-                }
+    nffs_gc_record_pause(start);
 
-                /* If the inode is a file, all constituent data blocks that are
-                 * resident in the source area get copied.
-                 */
-                if (nffs_hash_id_is_file(entry->nhe_id)) {
-                    rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
-                                              nffs_scratch_area_idx, &next);
-                    if (rc != 0) {
-                        return rc;
-                    }
-                }
-            }
+    return 0;
+}
 
-            entry = next;
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+/**
+ * Indicates whether it is time to start a background garbage collection
+ * cycle: free space outside the scratch area has dropped below
+ * NFFS_GC_INCREMENTAL_FREE_PCT percent, and something has been written since
+ * the last cycle.
+ */
+static int
+nffs_gc_incremental_needed(void)
+{
+    uint32_t capacity;
+    uint32_t written;
+    int i;
+
+    capacity = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            capacity += nffs_areas[i].na_length;
         }
     }
 
-    /* The amount of written data should never increase as a result of a gc
-     * cycle.
-     */
-    assert(to_area->na_cur <= from_area->na_cur);
+    written = nffs_gc_bytes_written();
+    if (written == nffs_gc_written) {
+        return 0;
+    }
 
-    /* Turn the source area into the new scratch area. */
-    from_area->na_gc_seq++;
-    rc = nffs_format_area(from_area_idx, 1);
-    if (rc != 0) {
-        return rc;
+    return (uint64_t)(capacity - written) * 100 <
+           (uint64_t)capacity * MYNEWT_VAL(NFFS_GC_INCREMENTAL_FREE_PCT);
+}
+
+/**
+ * Performs one bounded step of garbage collection, so that the cost of a
+ * cycle can be spread over idle time instead of stalling a writer.  A cycle
+ * is started when free space runs low; each call then moves roughly
+ * max_objects objects out of the source area, and the call which moves the
+ * last of them completes the cycle.  A writer which runs out of space while
+ * a cycle is in progress finishes it synchronously.
+ *
+ * @param max_objects       The number of objects to move in this step.  The
+ *                              objects in one hash bucket are always moved
+ *                              together, so this may be exceeded slightly.
+ *
+ * @return                  0 if a step was performed;
+ *                          FS_ENOENT if no garbage collection is needed;
+ *                          other nonzero on error.
+ */
+int
+nffs_gc_incremental(uint32_t max_objects)
+{
+    os_time_t start;
+    int rc;
+
+    if (max_objects == 0) {
+        return FS_EINVAL;
     }
 
-    if (out_area_idx != NULL) {
-        *out_area_idx = nffs_scratch_area_idx;
+    start = os_time_get();
+
+    if (nffs_gc_from_area_idx == NFFS_AREA_ID_NONE) {
+        if (!nffs_gc_incremental_needed()) {
+            return FS_ENOENT;
+        }
+
+        rc = nffs_gc_begin();
+        if (rc != 0) {
+            return rc;
+        }
     }
 
-    nffs_scratch_area_idx = from_area_idx;
+    rc = nffs_gc_collect(max_objects);
+    if (rc != 0) {
+        return rc;
+    }
 
-    /* Garbage collection renders the cache invalid:
-     *     o All cached blocks are now invalid; drop them.
-     *     o Flash locations of inodes may have changed; the cached inodes need
-     *       updated to reflect this.
-     */
-    rc = nffs_cache_inode_refresh();
+    if (nffs_gc_next_bucket >= nffs_hash_size) {
+        rc = nffs_gc_finish(NULL);
+    } else {
+        rc = nffs_gc_refresh();
+    }
     if (rc != 0) {
         return rc;
     }
 
-    /* Increment the garbage collection counter so that client code knows to
-     * reset its pointers to cached objects.
-     */
-    nffs_gc_count++;
-    STATS_INC(nffs_stats, nffs_gccnt);
+    STATS_INC(nffs_stats, nffs_gc_steps);
+    nffs_gc_record_pause(start);
 
     return 0;
 }
+#endif
 
 /**
  * Repeatedly performs garbage collection cycles until there is enough free
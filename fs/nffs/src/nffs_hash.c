@@ -25,6 +25,19 @@
 
 struct nffs_hash_list *nffs_hash;
 
+/** Total number of buckets in nffs_hash. */
+uint32_t nffs_hash_size;
+
+/**
+ * log2 of the number of buckets used for inode and for block IDs.  Without
+ * NFFS_HASH_SPLIT both share the whole table and these are equal.
+ */
+static uint8_t nffs_hash_inode_bits;
+static uint8_t nffs_hash_block_bits;
+
+static uint32_t nffs_hash_num_entries;
+static uint32_t nffs_hash_chain_max;
+
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
 uint32_t nffs_hash_next_block_id;
@@ -53,10 +66,41 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
-static int
+/**
+ * Fibonacci hashing: multiply by 2^32 / phi and keep the top bits.  This
+ * spreads the sequential IDs nffs hands out across all buckets no matter
+ * which ID range they come from.
+ */
+static uint32_t
+nffs_hash_mix(uint32_t id, uint8_t bits)
+{
+    return (id * 0x9e3779b1) >> (32 - bits);
+}
+
+int
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
+    if (nffs_hash_id_is_block(id)) {
+#if MYNEWT_VAL(NFFS_HASH_SPLIT)
+        /* Block buckets follow the inode buckets. */
+        return (1 << nffs_hash_inode_bits) +
+               nffs_hash_mix(id, nffs_hash_block_bits);
+#else
+        return nffs_hash_mix(id, nffs_hash_block_bits);
+#endif
+    }
+
+    return nffs_hash_mix(id, nffs_hash_inode_bits);
+}
+
+static void
+nffs_hash_stats_update(void)
+{
+    STATS_CLEAR(nffs_stats, nffs_hash_load_pct);
+    STATS_INCN(nffs_stats, nffs_hash_load_pct,
+               nffs_hash_num_entries * 100 / nffs_hash_size);
+    STATS_CLEAR(nffs_stats, nffs_hash_chain_max);
+    STATS_INCN(nffs_stats, nffs_hash_chain_max, nffs_hash_chain_max);
 }
 
 static struct nffs_hash_entry *
@@ -147,8 +191,10 @@ nffs_hash_id_is_dummy(uint32_t id)
 void
 nffs_hash_insert(struct nffs_hash_entry *entry)
 {
+    struct nffs_hash_entry *cur;
     struct nffs_hash_list *list;
     struct nffs_inode_entry *nie;
+    uint32_t chain_len;
     int idx;
 
     assert(nffs_hash_find(entry->nhe_id) == NULL);
@@ -158,6 +204,16 @@ nffs_hash_insert(struct nffs_hash_entry *entry)
     SLIST_INSERT_HEAD(list, entry, nhe_next);
     STATS_INC(nffs_stats, nffs_hashcnt_ins);
 
+    chain_len = 0;
+    SLIST_FOREACH(cur, list, nhe_next) {
+        chain_len++;
+    }
+    if (chain_len > nffs_hash_chain_max) {
+        nffs_hash_chain_max = chain_len;
+    }
+    nffs_hash_num_entries++;
+    nffs_hash_stats_update();
+
     if (nffs_hash_id_is_inode(entry->nhe_id)) {
         nie = nffs_hash_find_inode(entry->nhe_id);
         assert(nie);
@@ -188,12 +244,45 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     SLIST_REMOVE(list, entry, nffs_hash_entry, nhe_next);
     STATS_INC(nffs_stats, nffs_hashcnt_rm);
 
+    nffs_hash_num_entries--;
+    nffs_hash_stats_update();
+
     if (nffs_hash_id_is_inode(entry->nhe_id) && nie) {
         nffs_inode_unsetflags(nie, NFFS_INODE_FLAG_INHASH);
     }
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+/**
+ * Chooses the number of hash bits for a table expected to hold up to the
+ * specified number of entries.
+ */
+static uint8_t
+nffs_hash_bits(uint32_t max_entries)
+{
+    uint32_t target;
+    uint8_t bits;
+
+    target = max_entries / MYNEWT_VAL(NFFS_HASH_LOAD_FACTOR);
+    if (target < MYNEWT_VAL(NFFS_HASH_SIZE_MIN)) {
+        target = MYNEWT_VAL(NFFS_HASH_SIZE_MIN);
+    }
+    if (target > MYNEWT_VAL(NFFS_HASH_SIZE_MAX)) {
+        target = MYNEWT_VAL(NFFS_HASH_SIZE_MAX);
+    }
+
+    bits = 1;
+    while ((1UL << bits) < target) {
+        bits++;
+    }
+
+    return bits;
+}
+
+/**
+ * Allocates an empty hash table sized for the configured number of inodes
+ * and blocks.
+ */
 int
 nffs_hash_init(void)
 {
@@ -201,14 +290,33 @@ nffs_hash_init(void)
 
     free(nffs_hash);
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+#if MYNEWT_VAL(NFFS_HASH_SPLIT)
+    nffs_hash_inode_bits = nffs_hash_bits(nffs_config.nc_num_inodes);
+    nffs_hash_block_bits = nffs_hash_bits(nffs_config.nc_num_blocks);
+    nffs_hash_size = (1 << nffs_hash_inode_bits) +
+                     (1 << nffs_hash_block_bits);
+#else
+    nffs_hash_inode_bits = nffs_hash_bits(nffs_config.nc_num_inodes +
+                                          nffs_config.nc_num_blocks);
+    nffs_hash_block_bits = nffs_hash_inode_bits;
+    nffs_hash_size = 1 << nffs_hash_inode_bits;
+#endif
+
+    nffs_hash = malloc(nffs_hash_size * sizeof *nffs_hash);
     if (nffs_hash == NULL) {
+        nffs_hash_size = 0;
         return FS_ENOMEM;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         SLIST_INIT(nffs_hash + i);
     }
 
+    nffs_hash_num_entries = 0;
+    nffs_hash_chain_max = 0;
+    STATS_CLEAR(nffs_stats, nffs_hash_buckets);
+    STATS_INCN(nffs_stats, nffs_hash_buckets, nffs_hash_size);
+    nffs_hash_stats_update();
+
     return 0;
 }
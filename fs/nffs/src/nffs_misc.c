@@ -216,7 +216,7 @@ nffs_misc_reserve_space(uint16_t space,
 
     /* Find the first area with sufficient free space. */
     for (i = 0; i < nffs_num_areas; i++) {
-        if (i != nffs_scratch_area_idx) {
+        if (i != nffs_scratch_area_idx && i != nffs_gc_from_area_idx) {
             rc = nffs_misc_reserve_space_area(i, space, out_area_offset);
             if (rc == 0) {
                 *out_area_idx = i;
@@ -364,6 +364,10 @@ nffs_misc_reset(void)
     int rc;
 
     nffs_cache_clear();
+    rc = nffs_cache_init();
+    if (rc != 0) {
+        return rc;
+    }
 
     rc = os_mempool_init(&nffs_file_pool, nffs_config.nc_num_files,
                          sizeof (struct nffs_file), nffs_file_mem,
@@ -410,6 +414,16 @@ nffs_misc_reset(void)
         return FS_EOS;
     }
 
+    if (nffs_config.nc_num_write_bufs > 0) {
+        rc = os_mempool_init(&nffs_wbuf_pool,
+                             nffs_config.nc_num_write_bufs,
+                             MYNEWT_VAL(NFFS_WRITE_BUF_SIZE),
+                             nffs_wbuf_mem, "nffs_wbuf_pool");
+        if (rc != 0) {
+            return FS_EOS;
+        }
+    }
+
     rc = nffs_hash_init();
     if (rc != 0) {
         return rc;
@@ -422,6 +436,7 @@ nffs_misc_reset(void)
     nffs_root_dir = NULL;
     nffs_lost_found_dir = NULL;
     nffs_scratch_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
 
     nffs_hash_next_file_id = NFFS_ID_FILE_MIN;
     nffs_hash_next_dir_id = NFFS_ID_DIR_MIN;
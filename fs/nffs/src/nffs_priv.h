@@ -32,8 +32,6 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
-
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
 #define NFFS_ID_FILE_MIN             0x10000000
@@ -106,6 +104,49 @@ struct nffs_disk_block {
 
 #define NFFS_DISK_BLOCK_OFFSET_CRC  18
 
+#define NFFS_CHECKPOINT_MAGIC        0x4bc3f1a7
+#define NFFS_CHECKPOINT_VER          0
+
+/**
+ * On-disk representation of a checkpoint header.  The header is followed by
+ * one nffs_disk_checkpoint_area per area, then ndc_num_objects
+ * nffs_disk_checkpoint_object entries.
+ */
+struct nffs_disk_checkpoint {
+    uint32_t ndc_magic;         /* NFFS_CHECKPOINT_MAGIC; 0 if invalidated. */
+    uint8_t ndc_ver;            /* NFFS_CHECKPOINT_VER */
+    uint8_t ndc_num_areas;
+    uint8_t ndc_scratch_area_idx;
+    uint8_t reserved8;
+    uint32_t ndc_num_objects;
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_block_id;
+    uint16_t reserved16;
+    uint16_t ndc_crc16;         /* Covers the areas and objects, then the rest
+                                   of the header. */
+};
+
+#define NFFS_DISK_CHECKPOINT_OFFSET_CRC  26
+
+/** State of one area when the checkpoint was written. */
+struct nffs_disk_checkpoint_area {
+    uint32_t ndca_offset;       /* Flash offset of the area. */
+    uint32_t ndca_cur;          /* Objects from here on are not included. */
+    uint16_t ndca_id;
+    uint8_t ndca_gc_seq;
+    uint8_t reserved8;
+};
+
+/** Header of one object that was current when the checkpoint was written. */
+struct nffs_disk_checkpoint_object {
+    uint32_t ndco_flash_loc;
+    union {
+        struct nffs_disk_inode ndco_disk_inode;
+        struct nffs_disk_block ndco_disk_block;
+    };
+};
+
 /**
  * What gets stored in the hash table.  Each entry represents a data block or
  * an inode.
@@ -173,6 +214,8 @@ struct nffs_file {
     struct nffs_inode_entry *nf_inode_entry;
     uint32_t nf_offset;
     uint8_t nf_access_flags;
+    uint16_t nf_wbuf_len;       /* Bytes pending in nf_wbuf. */
+    uint8_t *nf_wbuf;           /* Appended data not yet written; or null. */
 };
 
 struct nffs_area {
@@ -250,10 +293,16 @@ struct nffs_dir {
 STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_hashcnt_ins)
     STATS_SECT_ENTRY(nffs_hashcnt_rm)
+    STATS_SECT_ENTRY(nffs_hash_buckets)
+    STATS_SECT_ENTRY(nffs_hash_load_pct)
+    STATS_SECT_ENTRY(nffs_hash_chain_max)
     STATS_SECT_ENTRY(nffs_object_count)
     STATS_SECT_ENTRY(nffs_iocnt_read)
     STATS_SECT_ENTRY(nffs_iocnt_write)
     STATS_SECT_ENTRY(nffs_gccnt)
+    STATS_SECT_ENTRY(nffs_gc_steps)
+    STATS_SECT_ENTRY(nffs_gc_pause_last_ms)
+    STATS_SECT_ENTRY(nffs_gc_pause_max_ms)
     STATS_SECT_ENTRY(nffs_readcnt_data)
     STATS_SECT_ENTRY(nffs_readcnt_block)
     STATS_SECT_ENTRY(nffs_readcnt_crc)
@@ -276,12 +325,14 @@ extern void *nffs_inode_mem;
 extern void *nffs_cache_inode_mem;
 extern void *nffs_cache_block_mem;
 extern void *nffs_dir_mem;
+extern void *nffs_wbuf_mem;
 extern struct os_mempool nffs_file_pool;
 extern struct os_mempool nffs_dir_pool;
 extern struct os_mempool nffs_inode_entry_pool;
 extern struct os_mempool nffs_block_entry_pool;
 extern struct os_mempool nffs_cache_inode_pool;
 extern struct os_mempool nffs_cache_block_pool;
+extern struct os_mempool nffs_wbuf_pool;
 extern uint32_t nffs_hash_next_file_id;
 extern uint32_t nffs_hash_next_dir_id;
 extern uint32_t nffs_hash_next_block_id;
@@ -290,12 +341,14 @@ extern uint8_t nffs_num_areas;
 extern uint8_t nffs_scratch_area_idx;
 extern uint16_t nffs_block_max_data_sz;
 extern unsigned int nffs_gc_count;
+extern uint8_t nffs_gc_from_area_idx;
 extern struct nffs_area_desc *nffs_current_area_descs;
 
 #define NFFS_FLASH_BUF_SZ        256
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern uint32_t nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -345,6 +398,7 @@ void nffs_cache_inode_range(const struct nffs_cache_inode *cache_inode,
 int nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t to,
                     struct nffs_cache_block **out_cache_block);
 void nffs_cache_clear(void);
+int nffs_cache_init(void);
 
 /* @crc */
 int nffs_crc_flash(uint16_t initial_crc, uint8_t area_idx,
@@ -359,6 +413,21 @@ int nffs_crc_disk_inode_validate(const struct nffs_disk_inode *disk_inode,
 void nffs_crc_disk_inode_fill(struct nffs_disk_inode *disk_inode,
                               const char *filename);
 
+/* @checkpoint */
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+extern struct nffs_area_desc nffs_checkpoint_desc;
+extern uint8_t nffs_checkpoint_valid;
+
+int nffs_checkpoint_write(void);
+void nffs_checkpoint_invalidate(void);
+int nffs_checkpoint_read(uint32_t offset, void *data, uint32_t len);
+#else
+static inline void
+nffs_checkpoint_invalidate(void)
+{
+}
+#endif
+
 /* @config */
 void nffs_config_init(void);
 
@@ -386,6 +455,9 @@ int nffs_format_full(const struct nffs_area_desc *area_descs);
 /* @gc */
 int nffs_gc(uint8_t *out_area_idx);
 int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+int nffs_gc_incremental(uint32_t max_objects);
+#endif
 
 /* @flash */
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
@@ -405,6 +477,7 @@ int nffs_hash_id_is_dir(uint32_t id);
 int nffs_hash_id_is_file(uint32_t id);
 int nffs_hash_id_is_inode(uint32_t id);
 int nffs_hash_id_is_block(uint32_t id);
+int nffs_hash_fn(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find(uint32_t id);
 struct nffs_inode_entry *nffs_hash_find_inode(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
@@ -500,10 +573,12 @@ int nffs_restore_full(const struct nffs_area_desc *area_descs);
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
+int nffs_write_flush(struct nffs_file *file);
+void nffs_write_buf_free(struct nffs_file *file);
 
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include "os/mynewt.h"
@@ -32,6 +33,19 @@
  */
 static uint16_t nffs_restore_largest_block_data_len;
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Set while objects are restored from a checkpoint.  Their CRCs were checked
+ * when the checkpoint was written, and the checkpoint has its own CRC.
+ */
+static uint8_t nffs_restore_from_checkpoint;
+
+/** Set while restoring again after a checkpoint turned out to be stale. */
+static uint8_t nffs_restore_ignore_checkpoint;
+#else
+#define nffs_restore_from_checkpoint 0
+#endif
+
 /**
  * Checks that each block a chain of data blocks was properly restored.
  *
@@ -287,7 +301,7 @@ nffs_restore_sweep(void)
     /* Iterate through every object in the hash table, deleting all inodes that
      * should be removed.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         list = nffs_hash + i;
 
         entry = SLIST_FIRST(list);
@@ -479,9 +493,11 @@ nffs_restore_inode(const struct nffs_disk_inode *disk_inode, uint8_t area_idx,
     new_inode = 0;
 
     /* Check the inode's CRC.  If the inode is corrupt, discard it. */
-    rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (!nffs_restore_from_checkpoint) {
+        rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     inode_entry = nffs_hash_find_inode(disk_inode->ndi_id);
@@ -800,9 +816,11 @@ nffs_restore_block(const struct nffs_disk_block *disk_block, uint8_t area_idx,
     /* Check the block's CRC.  If the block is corrupt, discard it.  If this
      * block would have superseded another, the old block becomes current.
      */
-    rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (!nffs_restore_from_checkpoint) {
+        rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     entry = nffs_hash_find_block(disk_block->ndb_id);
@@ -1030,7 +1048,7 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's na_cur.
  *
  * @param area_idx              The index of the area to read.
  *
@@ -1045,7 +1063,6 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
@@ -1087,6 +1104,154 @@ nffs_restore_area_contents(int area_idx)
     }
 }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Restores the objects recorded in the checkpoint, and sets each area's
+ * na_cur to where the checkpoint left off.  The areas must already have been
+ * detected.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no checkpoint;
+ *                              FS_ECORRUPT if the checkpoint does not match
+ *                                  the areas;
+ *                              other nonzero on failure.  On failure the RAM
+ *                                  state may be partially restored.
+ */
+static int
+nffs_restore_checkpoint(void)
+{
+    struct nffs_disk_checkpoint_object ckpt_object;
+    struct nffs_disk_checkpoint_area ckpt_area;
+    struct nffs_disk_checkpoint disk_ckpt;
+    struct nffs_disk_object disk_object;
+    struct nffs_area *area;
+    uint32_t chunk_len;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t i;
+    uint16_t crc;
+    int rc;
+
+    if (nffs_checkpoint_desc.nad_length == 0) {
+        return FS_ENOENT;
+    }
+
+    rc = nffs_checkpoint_read(0, &disk_ckpt, sizeof disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+    if (disk_ckpt.ndc_magic != NFFS_CHECKPOINT_MAGIC) {
+        return FS_ENOENT;
+    }
+    if (disk_ckpt.ndc_ver != NFFS_CHECKPOINT_VER ||
+        disk_ckpt.ndc_num_areas != nffs_num_areas ||
+        disk_ckpt.ndc_scratch_area_idx != nffs_scratch_area_idx) {
+
+        return FS_ECORRUPT;
+    }
+
+    /* Check the CRC before trusting any of the contents. */
+    len = nffs_num_areas * sizeof ckpt_area +
+          disk_ckpt.ndc_num_objects * sizeof ckpt_object;
+    if (disk_ckpt.ndc_num_objects > nffs_checkpoint_desc.nad_length ||
+        sizeof disk_ckpt + len > nffs_checkpoint_desc.nad_length) {
+
+        return FS_ECORRUPT;
+    }
+    crc = 0;
+    offset = sizeof disk_ckpt;
+    while (len > 0) {
+        if (len > sizeof nffs_flash_buf) {
+            chunk_len = sizeof nffs_flash_buf;
+        } else {
+            chunk_len = len;
+        }
+        rc = nffs_checkpoint_read(offset, nffs_flash_buf, chunk_len);
+        if (rc != 0) {
+            return rc;
+        }
+        crc = crc16_ccitt(crc, nffs_flash_buf, chunk_len);
+        offset += chunk_len;
+        len -= chunk_len;
+    }
+    crc = crc16_ccitt(crc, &disk_ckpt.ndc_ver,
+                      NFFS_DISK_CHECKPOINT_OFFSET_CRC -
+                      offsetof(struct nffs_disk_checkpoint, ndc_ver));
+    if (crc != disk_ckpt.ndc_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    offset = sizeof disk_ckpt;
+
+    /* The file system must not have been garbage collected since. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_checkpoint_read(offset, &ckpt_area, sizeof ckpt_area);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof ckpt_area;
+
+        area = nffs_areas + i;
+        if (ckpt_area.ndca_offset != area->na_offset ||
+            ckpt_area.ndca_id != area->na_id ||
+            ckpt_area.ndca_gc_seq != area->na_gc_seq ||
+            ckpt_area.ndca_cur > area->na_length) {
+
+            return FS_ECORRUPT;
+        }
+        area->na_cur = ckpt_area.ndca_cur;
+    }
+
+    nffs_restore_from_checkpoint = 1;
+    for (i = 0; i < disk_ckpt.ndc_num_objects; i++) {
+        rc = nffs_checkpoint_read(offset, &ckpt_object, sizeof ckpt_object);
+        if (rc != 0) {
+            break;
+        }
+        offset += sizeof ckpt_object;
+
+        memset(&disk_object, 0, sizeof disk_object);
+        nffs_flash_loc_expand(ckpt_object.ndco_flash_loc,
+                              &disk_object.ndo_area_idx,
+                              &disk_object.ndo_offset);
+        if (disk_object.ndo_area_idx >= nffs_num_areas) {
+            rc = FS_ECORRUPT;
+            break;
+        }
+        if (nffs_hash_id_is_inode(ckpt_object.ndco_disk_inode.ndi_id)) {
+            disk_object.ndo_type = NFFS_OBJECT_TYPE_INODE;
+            disk_object.ndo_disk_inode = ckpt_object.ndco_disk_inode;
+        } else {
+            disk_object.ndo_type = NFFS_OBJECT_TYPE_BLOCK;
+            disk_object.ndo_disk_block = ckpt_object.ndco_disk_block;
+        }
+
+        rc = nffs_restore_object(&disk_object);
+        if (rc != 0) {
+            break;
+        }
+    }
+    nffs_restore_from_checkpoint = 0;
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* IDs of objects deleted before the checkpoint must not be reused. */
+    if (disk_ckpt.ndc_next_dir_id > nffs_hash_next_dir_id) {
+        nffs_hash_next_dir_id = disk_ckpt.ndc_next_dir_id;
+    }
+    if (disk_ckpt.ndc_next_file_id > nffs_hash_next_file_id) {
+        nffs_hash_next_file_id = disk_ckpt.ndc_next_file_id;
+    }
+    if (disk_ckpt.ndc_next_block_id > nffs_hash_next_block_id) {
+        nffs_hash_next_block_id = disk_ckpt.ndc_next_block_id;
+    }
+
+    nffs_checkpoint_valid = 1;
+    return 0;
+}
+#endif
+
 /**
  * Reads and parses one area header.  This function does not read the area's
  * contents.
@@ -1159,7 +1324,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1357,11 +1522,37 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
             }
         }
     }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* If a checkpoint matches these areas, only objects written after it
+     * need to be read from the areas.  A checkpoint which cannot be used is
+     * stale; make sure it stays unused and start over without it.
+     */
+    nffs_checkpoint_valid = 0;
+    if (!nffs_restore_ignore_checkpoint) {
+        rc = nffs_restore_checkpoint();
+        if (rc != 0 && rc != FS_ENOENT) {
+            nffs_checkpoint_valid = 1;
+            nffs_checkpoint_invalidate();
+
+            nffs_restore_ignore_checkpoint = 1;
+            rc = nffs_restore_full(area_descs);
+            nffs_restore_ignore_checkpoint = 0;
+            return rc;
+        }
+    }
+#endif
+
+    /* Read the contents of each area. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            nffs_restore_area_contents(i);
+        }
+    }
+
     /* All areas have been restored from flash. */
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
@@ -1414,6 +1605,9 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     return 0;
 
 err:
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_checkpoint_valid = 0;
+#endif
     nffs_misc_reset();
     return rc;
 }
@@ -373,6 +373,117 @@ nffs_write_chunk(struct nffs_inode_entry *inode_entry, uint32_t file_offset,
     return 0;
 }
 
+/**
+ * Writes out any appended data buffered for the specified file handle, as a
+ * single new block at the end of the file.
+ *
+ * @param file                  The file handle to flush.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_write_flush(struct nffs_file *file)
+{
+    struct nffs_cache_inode *cache_inode;
+    int rc;
+
+    if (file->nf_wbuf_len == 0) {
+        return 0;
+    }
+
+    rc = nffs_cache_inode_ensure(&cache_inode, file->nf_inode_entry);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = nffs_write_append(cache_inode, file->nf_wbuf, file->nf_wbuf_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    file->nf_wbuf_len = 0;
+
+    return 0;
+}
+
+/**
+ * Returns the write buffer of the specified file handle to the pool.  Any
+ * buffered data must already have been flushed.
+ */
+void
+nffs_write_buf_free(struct nffs_file *file)
+{
+    assert(file->nf_wbuf_len == 0);
+
+    if (file->nf_wbuf != NULL) {
+        os_memblock_put(&nffs_wbuf_pool, file->nf_wbuf);
+        file->nf_wbuf = NULL;
+    }
+}
+
+static uint16_t
+nffs_write_buf_cap(void)
+{
+    if (MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) < nffs_block_max_data_sz) {
+        return MYNEWT_VAL(NFFS_WRITE_BUF_SIZE);
+    } else {
+        return nffs_block_max_data_sz;
+    }
+}
+
+/**
+ * Appends data to a file through the handle's write buffer, so that a series
+ * of small appends produces full-size blocks rather than one block each.
+ * Data which fills a whole block without the buffer's help is written
+ * directly.
+ *
+ * @param file                  The file to append to.  Its offset must be the
+ *                                  end of the file, including buffered data.
+ * @param data                  The data to append.
+ * @param len                   The length of data to append.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_write_buffered(struct nffs_file *file, const uint8_t *data, int len)
+{
+    uint16_t chunk_size;
+    uint16_t cap;
+    int rc;
+
+    cap = nffs_write_buf_cap();
+    while (len > 0) {
+        if (file->nf_wbuf_len == 0 && len >= cap) {
+            chunk_size = cap;
+            rc = nffs_write_chunk(file->nf_inode_entry, file->nf_offset,
+                                  data, chunk_size);
+            if (rc != 0) {
+                return rc;
+            }
+        } else {
+            chunk_size = cap - file->nf_wbuf_len;
+            if (chunk_size > len) {
+                chunk_size = len;
+            }
+            memcpy(file->nf_wbuf + file->nf_wbuf_len, data, chunk_size);
+            file->nf_wbuf_len += chunk_size;
+        }
+
+        len -= chunk_size;
+        data += chunk_size;
+        file->nf_offset += chunk_size;
+
+        if (file->nf_wbuf_len == cap) {
+            rc = nffs_write_flush(file);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Writes a chunk of contiguous data to a file.
  *
@@ -407,7 +518,23 @@ nffs_write_to_file(struct nffs_file *file, const void *data, int len)
      * seek position.
      */
     if (file->nf_access_flags & FS_ACCESS_APPEND) {
-        file->nf_offset = cache_inode->nci_file_size;
+        file->nf_offset = cache_inode->nci_file_size + file->nf_wbuf_len;
+    }
+
+    /* Appends go through the handle's write buffer, if one is available. */
+    if (file->nf_offset == cache_inode->nci_file_size + file->nf_wbuf_len) {
+        if (file->nf_wbuf == NULL && nffs_config.nc_num_write_bufs > 0) {
+            file->nf_wbuf = os_memblock_get(&nffs_wbuf_pool);
+        }
+        if (file->nf_wbuf != NULL) {
+            return nffs_write_buffered(file, data, len);
+        }
+    }
+
+    /* Buffered data precedes this write; put it on flash first. */
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
     }
 
     /* Write data as a sequence of blocks. */
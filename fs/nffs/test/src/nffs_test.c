@@ -108,6 +108,9 @@ TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_checkpoint)
+TEST_CASE_DECL(nffs_test_gc_incremental)
+TEST_CASE_DECL(nffs_test_write_buf)
 
 void
 nffs_test_suite_gen_1_1_init(void)
@@ -174,9 +177,13 @@ TEST_SUITE(nffs_test_suite)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_checkpoint();
+    nffs_test_gc_incremental();
+    nffs_test_write_buf();
 }
 
 TEST_CASE_DECL(nffs_test_cache_large_file)
+TEST_CASE_DECL(nffs_test_cache_readahead)
 
 TEST_SUITE(nffs_suite_cache)
 {
@@ -186,6 +193,7 @@ TEST_SUITE(nffs_suite_cache)
     TEST_ASSERT(rc == 0);
 
     nffs_test_cache_large_file();
+    nffs_test_cache_readahead();
 }
 
 void
@@ -209,6 +217,11 @@ main(void)
 
     sysinit();
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Test cases choose their own checkpoint region. */
+    nffs_checkpoint_area_set(NULL);
+#endif
+
     tu_suite_set_init_cb((void*)nffs_test_suite_gen_1_1_init, NULL);
     nffs_test_suite();
 
@@ -404,12 +417,6 @@ print_nffs_flash_areas(int verbose)
     }
 }
 
-static int
-nffs_hash_fn(uint32_t id)
-{
-    return id % NFFS_HASH_SIZE;
-}
-
 void
 print_hashlist(struct nffs_hash_entry *he)
 {
@@ -685,7 +692,7 @@ print_hash_entries(int verbose)
     struct nffs_hash_entry *next;
 
     printf("\nnffs_hash_entries:\n");
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         he = SLIST_FIRST(nffs_hash + i);
         while (he != NULL) {
             next = SLIST_NEXT(he, nhe_next);
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_checkpoint)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    static const struct nffs_area_desc area_descs_two[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0, 0 },
+    };
+    static const struct nffs_area_desc ckpt_desc = {
+        0x000e0000, 128 * 1024
+    };
+    struct nffs_inode_entry *inode_entry;
+    uint32_t gone_id;
+    int rc;
+
+    rc = nffs_checkpoint_area_set(&ckpt_desc);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(area_descs_two);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    nffs_test_util_create_file("/a.txt", "aaaa", 4);
+    rc = fs_mkdir("/dir");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/dir/b.txt", "bbbb", 4);
+    nffs_test_util_create_file("/dir/c.txt", "cccc", 4);
+
+    nffs_test_util_create_file("/gone.txt", "xx", 2);
+    rc = nffs_path_find_inode_entry("/gone.txt", &inode_entry);
+    TEST_ASSERT_FATAL(rc == 0);
+    gone_id = inode_entry->nie_hash_entry.nhe_id;
+    rc = fs_unlink("/gone.txt");
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Changes made after the checkpoint are read from the areas. */
+    nffs_test_util_append_file("/a.txt", "AAAA", 4);
+    rc = fs_rename("/dir/b.txt", "/b.txt");
+    TEST_ASSERT(rc == 0);
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "a.txt",
+                .contents = "aaaaAAAA",
+                .contents_len = 8,
+            }, {
+                .filename = "b.txt",
+                .contents = "bbbb",
+                .contents_len = 4,
+            }, {
+                .filename = "dir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "c.txt",
+                    .contents = "cccc",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_checkpoint_valid);
+    nffs_test_assert_system_once(expected_system);
+
+    /* The deleted file's ID is not handed out again. */
+    TEST_ASSERT(nffs_hash_next_file_id > gone_id);
+
+    /* Garbage collection drops the checkpoint; a full scan is done. */
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!nffs_checkpoint_valid);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!nffs_checkpoint_valid);
+    nffs_test_assert_system_once(expected_system);
+
+    rc = nffs_checkpoint_area_set(NULL);
+    TEST_ASSERT(rc == 0);
+#endif
+}
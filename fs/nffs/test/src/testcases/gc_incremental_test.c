@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_gc_incremental)
+{
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    static const struct nffs_area_desc area_descs_two[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0, 0 },
+    };
+    static char data[1000];
+    unsigned int gc_count;
+    int steps;
+    int rc;
+    int i;
+
+    rc = nffs_format(area_descs_two);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Nothing to collect in an empty file system. */
+    rc = nffs_gc_step(1);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    /* Fill most of the data area with garbage. */
+    memset(data, 'a', sizeof data);
+    for (i = 0; i < 100; i++) {
+        nffs_test_util_create_file("/myfile.txt", data, sizeof data);
+    }
+    nffs_test_util_create_file("/other.txt", "other", 5);
+    gc_count = nffs_gc_count;
+
+    /* Collect one object at a time, writing between steps. */
+    rc = nffs_gc_step(1);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_gc_from_area_idx != NFFS_AREA_ID_NONE);
+
+    nffs_test_util_create_file("/new.txt", "new", 3);
+
+    for (steps = 1; steps < 2000; steps++) {
+        rc = nffs_gc_step(1);
+        if (rc == FS_ENOENT) {
+            break;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(rc == FS_ENOENT);
+    TEST_ASSERT(steps > 1);
+    TEST_ASSERT(nffs_gc_from_area_idx == NFFS_AREA_ID_NONE);
+    TEST_ASSERT(nffs_gc_count > gc_count);
+
+    /* The garbage is gone from the data area. */
+    i = nffs_scratch_area_idx == 0 ? 1 : 0;
+    TEST_ASSERT(nffs_area_free_space(nffs_areas + i) > 64 * 1024);
+
+    nffs_test_util_assert_contents("/myfile.txt", data, sizeof data);
+    nffs_test_util_assert_contents("/other.txt", "other", 5);
+    nffs_test_util_assert_contents("/new.txt", "new", 3);
+
+    /* Everything survives a remount. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    nffs_test_util_assert_contents("/myfile.txt", data, sizeof data);
+    nffs_test_util_assert_contents("/other.txt", "other", 5);
+    nffs_test_util_assert_contents("/new.txt", "new", 3);
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_write_buf)
+{
+    static char expected[1000];
+    struct fs_file *file_a;
+    struct fs_file *file_b;
+    uint32_t len;
+    char rec[10];
+    int rc;
+    int i;
+
+    /*** Setup. */
+    nffs_config.nc_num_write_bufs = 1;
+    rc = nffs_init();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_open("/a.txt", FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file_a);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_open("/b.txt", FS_ACCESS_WRITE, &file_b);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The first handle to append gets the only buffer. */
+    for (i = 0; i < 100; i++) {
+        memset(rec, '0' + i % 10, sizeof rec);
+        memcpy(expected + i * sizeof rec, rec, sizeof rec);
+
+        rc = fs_write(file_a, rec, sizeof rec);
+        TEST_ASSERT(rc == 0);
+        if (i < 3) {
+            rc = fs_write(file_b, rec, sizeof rec);
+            TEST_ASSERT(rc == 0);
+        }
+    }
+
+    /* Buffered data counts towards the length seen by its handle. */
+    rc = fs_filelen(file_a, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == sizeof expected);
+
+    rc = fs_close(file_a);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file_b);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_assert_contents("/a.txt", expected, sizeof expected);
+    nffs_test_util_assert_block_count("/a.txt",
+        (sizeof expected + MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) - 1) /
+        MYNEWT_VAL(NFFS_WRITE_BUF_SIZE));
+
+    /* Without a buffer, each write is a block. */
+    nffs_test_util_assert_contents("/b.txt", expected, 3 * sizeof rec);
+    nffs_test_util_assert_block_count("/b.txt", 3);
+
+    nffs_config.nc_num_write_bufs = 0;
+    rc = nffs_init();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+}
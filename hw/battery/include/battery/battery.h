@@ -119,6 +119,18 @@ struct battery {
     /* Battery last reading time stamp. */
     os_time_t b_last_read_time;
 
+    /* Properties whose value changed since the last poll, indexed by
+     * bp_prop_num.  Set by any read, cleared when listeners are notified.
+     */
+    uint32_t b_prop_changed[(BATTERY_MAX_PROPERTY_COUNT + 31) / 32];
+
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+    /* Index of the driver status property + 1, 0 if not looked up yet,
+     * -1 if there is none.
+     */
+    int8_t b_status_prop;
+#endif
+
     /* A list of listeners that are registered to receive data from this
      * battery.
      */
@@ -209,6 +221,10 @@ char *battery_prop_get_name(const struct battery_property *prop, char *buf,
 /**
  * Set the battery poll rate
  *
+ * Only properties with a listener subscribed are read when polling.  With
+ * BATTERY_POLL_ADAPTIVE the rate is scaled by the BATTERY_POLL_MULT_*
+ * setting for the current battery status.
+ *
  * @param The battery
  * @param The poll rate in milliseconds
  *
@@ -228,8 +228,21 @@ struct battery_property {
     /* Value of property is valid */
     uint8_t                   bp_valid:1;
     battery_property_value_t  bp_value;
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+    /* bp_value was read from the driver and may be served from cache */
+    uint8_t                   bp_cached:1;
+    /* Time of the last successful read from the driver */
+    os_time_t                 bp_read_time;
+    /* How long, in ticks, a read value is served from the cache */
+    uint32_t                  bp_max_age;
+#endif
 };
 
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+/* bp_max_age of values which only change when set (e.g. thresholds) */
+#define BATTERY_PROP_MAX_AGE_FOREVER    UINT32_MAX
+#endif
+
 static inline int driver_property(const struct battery_property *prop)
 {
     return 0 == (prop->bp_flags & BATTERY_PROPERTY_FLAGS_DERIVED);
@@ -253,6 +266,26 @@ int battery_prop_set_value_int16(struct battery_property *prop, int16_t val);
 int battery_prop_set_value_uint32(struct battery_property *prop, uint32_t val);
 int battery_prop_set_value_int32(struct battery_property *prop, int32_t val);
 
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+/**
+ * Sets how long a value read from the driver is returned by
+ * battery_prop_get_value() without reading the driver again.  Values read
+ * by the battery manager's polling count too.
+ *
+ * @param The battery property
+ * @param Freshness window in milliseconds; 0 to always read the driver,
+ *        BATTERY_PROP_MAX_AGE_FOREVER to read it only once.
+ */
+void battery_prop_set_max_age(struct battery_property *prop, uint32_t ms);
+
+/**
+ * Makes the next battery_prop_get_value() read the driver.
+ *
+ * @param The battery property
+ */
+void battery_prop_invalidate(struct battery_property *prop);
+#endif
+
 /**
  * Register a property change listener. This allows a calling application to
  * receive callbacks when property changes.
@@ -24,6 +24,7 @@
 #include <battery/battery.h>
 #include <battery/battery_prop.h>
 #include <battery/battery_drv.h>
+#include "battery_priv.h"
 
 #define BATTERY_MAX_COUNT 1
 
@@ -71,6 +72,7 @@ battery_mgr_evq_set(struct os_eventq *evq)
 }
 
 static void battery_mgr_poll_battery(struct battery *battery);
+static uint32_t battery_mgr_poll_rate(struct battery *battery);
 
 static void
 battery_poll_event_cb(struct os_event *ev)
@@ -89,7 +91,8 @@ battery_poll_event_cb(struct os_event *ev)
             if (OS_TIME_TICK_GEQ(now, bat->b_next_run)) {
                 bat->b_last_read_time = now;
                 battery_mgr_poll_battery(battery_manager.bm_batteries[i]);
-                bat->b_next_run = now + os_time_ms_to_ticks32(bat->b_poll_rate);
+                bat->b_next_run = now +
+                    os_time_ms_to_ticks32(battery_mgr_poll_rate(bat));
             }
             if ((pflag == 0) || OS_TIME_TICK_LT(bat->b_next_run, next_poll)) {
                 pflag = 1;
@@ -247,7 +250,7 @@ find_driver_property(struct battery *bat, struct battery_driver *driver,
     int i;
     assert(driver);
 
-    for (i = 0; driver->bd_property_count; ++i, ++prop) {
+    for (i = 0; i < driver->bd_property_count; ++i, ++prop) {
         if (prop->bp_type == type && prop->bp_flags == flags)
             return prop;
     }
@@ -265,7 +268,8 @@ find_hardware_property(struct battery *battery, struct battery_driver *driver,
     if (driver) {
         res = find_driver_property(battery, driver, type, flags);
     } else {
-        for (i = 0; res == NULL && i < BATTERY_DRIVERS_MAX; ++i) {
+        for (i = 0; res == NULL && i < BATTERY_DRIVERS_MAX &&
+                    battery->b_drivers[i]; ++i) {
             res = find_driver_property(battery, battery->b_drivers[i],
                                        type, flags);
         }
@@ -409,25 +413,143 @@ battery_find_property_by_name(struct os_dev *battery, const char *name)
     return NULL;
 }
 
+static int
+test_bit(const uint32_t *mask, int bit)
+{
+    return (mask[bit / (sizeof(*mask) * 8)] >>
+            (bit & ((sizeof(*mask) * 8) - 1))) & 1;
+}
+
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+static int
+battery_prop_fresh(const struct battery_property *prop, os_time_t now)
+{
+    if (!prop->bp_cached || !prop->bp_valid) {
+        return 0;
+    }
+    if (prop->bp_max_age == BATTERY_PROP_MAX_AGE_FOREVER) {
+        return 1;
+    }
+    return (uint32_t)(now - prop->bp_read_time) < prop->bp_max_age;
+}
+
+void
+battery_prop_set_max_age(struct battery_property *prop, uint32_t ms)
+{
+    if (ms == BATTERY_PROP_MAX_AGE_FOREVER) {
+        prop->bp_max_age = BATTERY_PROP_MAX_AGE_FOREVER;
+    } else {
+        prop->bp_max_age = os_time_ms_to_ticks32(ms);
+    }
+}
+
+void
+battery_prop_invalidate(struct battery_property *prop)
+{
+    prop->bp_cached = 0;
+}
+#endif
+
+int
+battery_prop_read(struct battery *bat, struct battery_property *prop,
+        uint32_t timeout)
+{
+    struct battery_driver *drv = bat->b_drivers[prop->bp_drv_num];
+    battery_property_value_t old_val;
+    os_sr_t sr;
+
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+    if (battery_prop_fresh(prop, os_time_get())) {
+        return 0;
+    }
+#endif
+
+    old_val = prop->bp_value;
+    if (drv->bd_funcs->bdf_property_get(drv, prop, timeout)) {
+        prop->bp_valid = 0;
+        return -1;
+    }
+    prop->bp_valid = 1;
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+    prop->bp_cached = 1;
+    prop->bp_read_time = os_time_get();
+#endif
+
+    if (memcmp(&old_val, &prop->bp_value, sizeof(old_val))) {
+        OS_ENTER_CRITICAL(sr);
+        set_bit(bat->b_prop_changed, prop->bp_prop_num);
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    return 0;
+}
+
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+static struct battery_property *
+battery_mgr_status_prop(struct battery *battery)
+{
+    struct battery_property *prop;
+    int i;
+
+    if (battery->b_status_prop == 0) {
+        battery->b_status_prop = -1;
+        for (i = 0; i < battery->b_all_property_count; ++i) {
+            prop = &battery->b_properties[i];
+            if (prop->bp_type == BATTERY_PROP_STATUS &&
+                prop->bp_flags == BATTERY_PROPERTY_FLAGS_NONE) {
+                battery->b_status_prop = i + 1;
+                break;
+            }
+        }
+    }
+    if (battery->b_status_prop < 0) {
+        return NULL;
+    }
+    return &battery->b_properties[battery->b_status_prop - 1];
+}
+#endif
+
+/*
+ * Poll interval for the current charge state; the gauge changes slowly
+ * while discharging and hardly at all when the battery is full.
+ */
+static uint32_t
+battery_mgr_poll_rate(struct battery *battery)
+{
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+    struct battery_property *prop;
+
+    prop = battery_mgr_status_prop(battery);
+    if (prop != NULL && prop->bp_valid) {
+        switch (prop->bp_value.bpv_status) {
+        case BATTERY_STATUS_CHARGING:
+            return battery->b_poll_rate * MYNEWT_VAL(BATTERY_POLL_MULT_CHARGING);
+        case BATTERY_STATUS_DISCHARGING:
+            return battery->b_poll_rate *
+                   MYNEWT_VAL(BATTERY_POLL_MULT_DISCHARGING);
+        case BATTERY_STATUS_NOT_CHARGING:
+        case BATTERY_STATUS_FULL:
+            return battery->b_poll_rate * MYNEWT_VAL(BATTERY_POLL_MULT_IDLE);
+        default:
+            break;
+        }
+    }
+#endif
+    return battery->b_poll_rate;
+}
+
 static void
 battery_mgr_poll_battery_driver(struct battery *bat,
-        struct battery_driver *drv, uint32_t changed[], uint32_t queried[])
+        struct battery_driver *drv, const uint32_t wanted[],
+        uint32_t queried[])
 {
     int i;
-    battery_property_value_t old_val;
     struct battery_property *prop = &bat->b_properties[drv->bd_first_property];
 
-    /* Read requested properties */
+    /* Read the properties someone listens to, in one pass */
     for (i = 0; i < drv->bd_property_count; ++i, ++prop) {
-        if (driver_property(prop)) {
-            old_val = prop->bp_value;
-            if (drv->bd_funcs->bdf_property_get(drv, prop, 100)) {
-                prop->bp_valid = 0;
-            } else {
-                prop->bp_valid = 1;
-                if (memcmp(&old_val, &prop->bp_value, sizeof(old_val))) {
-                    set_bit(changed, prop->bp_prop_num);
-                }
+        if (driver_property(prop) && test_bit(wanted, prop->bp_prop_num)) {
+            if (battery_prop_read(bat, prop, 100) == 0) {
                 set_bit(queried, prop->bp_prop_num);
             }
         }
@@ -437,23 +559,48 @@ battery_mgr_poll_battery_driver(struct battery *bat,
 static void
 battery_mgr_poll_battery(struct battery *battery)
 {
-    uint32_t changed[PROP_MASK_SIZE] = {0};
+    uint32_t wanted[PROP_MASK_SIZE] = {0};
+    uint32_t changed[PROP_MASK_SIZE];
     uint32_t queried[PROP_MASK_SIZE] = {0};
     uint32_t masked;
     int first_one;
     struct listener_data *ld;
     struct battery_driver *driver;
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+    struct battery_property *prop;
+#endif
+    os_sr_t sr;
     int i;
     int j;
 
+    for (i = 0; i < battery->b_listener_count; ++i) {
+        ld = &battery->b_listeners[i];
+        for (j = 0; j < PROP_MASK_SIZE; ++j) {
+            wanted[j] |= ld->ld_prop_change_mask[j] | ld->ld_prop_read_mask[j];
+        }
+    }
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+    /* Status picks the next poll interval */
+    prop = battery_mgr_status_prop(battery);
+    if (prop != NULL) {
+        set_bit(wanted, prop->bp_prop_num);
+    }
+#endif
+
     /* Poll battery drivers */
     for(i = 0; i < BATTERY_DRIVERS_MAX; ++i) {
         driver = battery->b_drivers[i];
         if (driver) {
-            battery_mgr_poll_battery_driver(battery, driver, changed, queried);
+            battery_mgr_poll_battery_driver(battery, driver, wanted, queried);
         }
     }
 
+    /* Changes seen by reads made since the last poll count as well */
+    OS_ENTER_CRITICAL(sr);
+    memcpy(changed, battery->b_prop_changed, sizeof(changed));
+    memset(battery->b_prop_changed, 0, sizeof(battery->b_prop_changed));
+    OS_EXIT_CRITICAL(sr);
+
     /* Notify listeners about property changes */
     for (i = 0; i < battery->b_listener_count; ++i) {
         ld = &battery->b_listeners[i];
@@ -558,8 +705,20 @@ battery_add_driver(struct os_dev *battery, struct battery_driver *driver)
         prop->bp_drv_num = drv_num;
         prop->bp_bat_num = bat_num;
         prop->bp_prop_num = j;
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+        prop->bp_cached = 0;
+        /* Thresholds only change when they are set */
+        if (prop->bp_flags & BATTERY_PROPERTY_FLAGS_ALARM_THREASH) {
+            prop->bp_max_age = BATTERY_PROP_MAX_AGE_FOREVER;
+        } else {
+            battery_prop_set_max_age(prop, MYNEWT_VAL(BATTERY_PROP_CACHE_MS));
+        }
+#endif
     }
     bat->b_all_property_count = j;
+#if MYNEWT_VAL(BATTERY_POLL_ADAPTIVE)
+    bat->b_status_prop = 0;
+#endif
 
     return 0;
 }
@@ -0,0 +1,35 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BATTERY_PRIV_H__
+#define __BATTERY_PRIV_H__
+
+#include "os/mynewt.h"
+
+struct battery;
+struct battery_property;
+
+/*
+ * Reads a driver property, unless its cached value is still fresh, and
+ * records whether the value changed for the next poll's listeners.
+ */
+int battery_prop_read(struct battery *bat, struct battery_property *prop,
+                      uint32_t timeout);
+
+#endif /* __BATTERY_PRIV_H__ */
@@ -24,16 +24,15 @@
 #include <battery/battery_prop.h>
 #include <battery/battery_drv.h>
 #include <battery/battery.h>
+#include "battery_priv.h"
 
 int battery_prop_get_value(struct battery_property *prop)
 {
-    struct battery_driver *drv;
     struct battery *bat = (struct battery *)battery_get_battery(prop->bp_bat_num);
     int rc = -1;
 
     if (driver_property(prop)) {
-        drv = bat->b_drivers[prop->bp_drv_num];
-        rc = drv->bd_funcs->bdf_property_get(drv, prop, OS_WAIT_FOREVER);
+        rc = battery_prop_read(bat, prop, OS_WAIT_FOREVER);
     }
     return rc;
 }
@@ -124,6 +123,10 @@ battery_prop_set_value(struct battery_property *prop,
     if (drv) {
         prop->bp_value = *value;
         rc = drv->bd_funcs->bdf_property_set(drv, prop);
+#if MYNEWT_VAL(BATTERY_PROP_CACHE)
+        /* Read back what the hardware accepted */
+        battery_prop_invalidate(prop);
+#endif
     } else {
         prop->bp_value = *value;
         prop->bp_valid = 1;
@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BUS_H__
+#define __BUS_H__
+
+#include <stdint.h>
+#include "os/mynewt.h"
+#include "hal/hal_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUS_TYPE_SPI            (0)
+#define BUS_TYPE_I2C            (1)
+
+/* Highest and lowest node priorities, lower values are served first */
+#define BUS_PRIO_HIGHEST        (0)
+#define BUS_PRIO_LOWEST         (255)
+
+struct bus_node;
+
+/**
+ * Waiter queued on a busy bus, allocated on the waiting task's stack.
+ */
+struct bus_waiter {
+    struct bus_node *bw_node;
+    struct os_task *bw_task;
+    struct os_sem bw_sem;
+    /* Set once the bus has been handed to this waiter */
+    uint8_t bw_granted;
+    TAILQ_ENTRY(bus_waiter) bw_next;
+};
+
+/**
+ * A shared SPI or I2C bus.
+ *
+ * The bus is owned by at most one node at a time. Nodes waiting for a busy
+ * bus are served in node priority order, FIFO among equal priorities, so
+ * latency sensitive devices are not stuck behind bulk transfers of others.
+ */
+struct bus_dev {
+    /* BUS_TYPE_SPI or BUS_TYPE_I2C */
+    uint8_t bd_type;
+    /* HAL interface number */
+    uint8_t bd_num;
+    /* Nesting depth of the current owner's lock */
+    uint8_t bd_lock_cnt;
+    /* Node currently owning the bus, NULL if free */
+    struct bus_node *bd_owner;
+    struct os_task *bd_owner_task;
+    /* Node whose settings the bus was last configured with */
+    struct bus_node *bd_configured;
+    /* Waiters sorted by node priority */
+    TAILQ_HEAD(, bus_waiter) bd_waiters;
+    /* Number of times the HAL was reconfigured */
+    uint32_t bd_reconfigs;
+};
+
+/**
+ * A device attached to a shared bus.
+ */
+struct bus_node {
+    struct bus_dev *bn_bus;
+    /* Arbitration priority, BUS_PRIO_HIGHEST to BUS_PRIO_LOWEST */
+    uint8_t bn_prio;
+    /* I2C slave address */
+    uint8_t bn_addr;
+    /* SPI chip select pin, driven low while the node transfers, or -1 */
+    int bn_cs_pin;
+    /* SPI settings the bus is switched to for this node */
+    struct hal_spi_settings bn_spi_settings;
+};
+
+/**
+ * Initialize a bus device. The underlying HAL interface must have been
+ * initialized already.
+ *
+ * @param bdev The bus device to initialize
+ * @param type BUS_TYPE_SPI or BUS_TYPE_I2C
+ * @param num  The HAL interface number
+ */
+void bus_dev_init(struct bus_dev *bdev, uint8_t type, uint8_t num);
+
+/**
+ * Attach an SPI node to a bus. The chip select pin is configured as an
+ * output and deasserted.
+ *
+ * @param node     The node to initialize
+ * @param bdev     The SPI bus the node is attached to
+ * @param settings SPI settings the bus is switched to for this node
+ * @param cs_pin   Chip select pin, or -1 if the node drives it itself
+ * @param prio     Arbitration priority of the node
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int bus_node_init_spi(struct bus_node *node, struct bus_dev *bdev,
+                      const struct hal_spi_settings *settings, int cs_pin,
+                      uint8_t prio);
+
+/**
+ * Attach an I2C node to a bus.
+ *
+ * @param node The node to initialize
+ * @param bdev The I2C bus the node is attached to
+ * @param addr 7-bit slave address of the node
+ * @param prio Arbitration priority of the node
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int bus_node_init_i2c(struct bus_node *node, struct bus_dev *bdev,
+                      uint8_t addr, uint8_t prio);
+
+/**
+ * Take ownership of the bus for a node, reconfiguring the bus only if the
+ * node's settings differ from the ones it is currently configured with.
+ * Locks nest when taken again by the owning task.
+ *
+ * @param node    The node to lock the bus for
+ * @param timeout Time to wait for the bus, in OS ticks
+ *
+ * @return 0 on success, SYS_ETIMEOUT if the bus stayed busy, other
+ *         non-zero on failure.
+ */
+int bus_node_lock(struct bus_node *node, os_time_t timeout);
+
+/**
+ * Release a bus taken with bus_node_lock(), handing it to the highest
+ * priority waiter.
+ *
+ * @param node The node owning the bus
+ */
+void bus_node_unlock(struct bus_node *node);
+
+/**
+ * Write to a node. SPI nodes discard the data clocked in.
+ *
+ * @param node    The node to write to
+ * @param buf     Data to write
+ * @param len     Number of bytes to write
+ * @param timeout Time to wait for the bus and, on I2C, for the transfer,
+ *                in OS ticks
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int bus_node_write(struct bus_node *node, const void *buf, uint16_t len,
+                   os_time_t timeout);
+
+/**
+ * Read from a node. SPI nodes are clocked with 0xff.
+ *
+ * @param node    The node to read from
+ * @param buf     Buffer to read into
+ * @param len     Number of bytes to read
+ * @param timeout Time to wait for the bus and, on I2C, for the transfer,
+ *                in OS ticks
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int bus_node_read(struct bus_node *node, void *buf, uint16_t len,
+                  os_time_t timeout);
+
+/**
+ * Write to a node and read back its response in one transaction: chip
+ * select stays asserted on SPI, a repeated start is used on I2C.
+ *
+ * @param node    The node to access
+ * @param wbuf    Data to write
+ * @param wlen    Number of bytes to write
+ * @param rbuf    Buffer to read into
+ * @param rlen    Number of bytes to read
+ * @param timeout Time to wait for the bus and, on I2C, for the transfer,
+ *                in OS ticks
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int bus_node_write_read(struct bus_node *node, const void *wbuf,
+                        uint16_t wlen, void *rbuf, uint16_t rlen,
+                        os_time_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BUS_H__ */
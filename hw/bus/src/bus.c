@@ -0,0 +1,331 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_gpio.h"
+#include "hal/hal_i2c.h"
+#include "hal/hal_spi.h"
+#include "bus/bus.h"
+
+void
+bus_dev_init(struct bus_dev *bdev, uint8_t type, uint8_t num)
+{
+    memset(bdev, 0, sizeof(*bdev));
+    bdev->bd_type = type;
+    bdev->bd_num = num;
+    TAILQ_INIT(&bdev->bd_waiters);
+}
+
+int
+bus_node_init_spi(struct bus_node *node, struct bus_dev *bdev,
+                  const struct hal_spi_settings *settings, int cs_pin,
+                  uint8_t prio)
+{
+    if (bdev->bd_type != BUS_TYPE_SPI) {
+        return SYS_EINVAL;
+    }
+
+    memset(node, 0, sizeof(*node));
+    node->bn_bus = bdev;
+    node->bn_prio = prio;
+    node->bn_cs_pin = cs_pin;
+    node->bn_spi_settings = *settings;
+
+    if (cs_pin >= 0) {
+        return hal_gpio_init_out(cs_pin, 1);
+    }
+
+    return 0;
+}
+
+int
+bus_node_init_i2c(struct bus_node *node, struct bus_dev *bdev,
+                  uint8_t addr, uint8_t prio)
+{
+    if (bdev->bd_type != BUS_TYPE_I2C) {
+        return SYS_EINVAL;
+    }
+
+    memset(node, 0, sizeof(*node));
+    node->bn_bus = bdev;
+    node->bn_prio = prio;
+    node->bn_addr = addr;
+
+    return 0;
+}
+
+static bool
+bus_spi_settings_equal(const struct hal_spi_settings *a,
+                       const struct hal_spi_settings *b)
+{
+    return a->data_mode == b->data_mode &&
+           a->data_order == b->data_order &&
+           a->word_size == b->word_size &&
+           a->baudrate == b->baudrate;
+}
+
+/*
+ * Switch the bus to the node's settings. Only SPI has per node settings,
+ * the I2C slave address is passed with every transfer.
+ */
+static int
+bus_dev_configure(struct bus_dev *bdev, struct bus_node *node)
+{
+    struct bus_node *cur;
+    int rc;
+
+    cur = bdev->bd_configured;
+    if (bdev->bd_type != BUS_TYPE_SPI || cur == node) {
+        return 0;
+    }
+
+    if (cur && bus_spi_settings_equal(&cur->bn_spi_settings,
+                                      &node->bn_spi_settings)) {
+        bdev->bd_configured = node;
+        return 0;
+    }
+
+    hal_spi_disable(bdev->bd_num);
+    rc = hal_spi_config(bdev->bd_num, &node->bn_spi_settings);
+    hal_spi_enable(bdev->bd_num);
+    if (rc) {
+        bdev->bd_configured = NULL;
+        return rc;
+    }
+
+    bdev->bd_configured = node;
+    bdev->bd_reconfigs++;
+
+    return 0;
+}
+
+int
+bus_node_lock(struct bus_node *node, os_time_t timeout)
+{
+    struct bus_dev *bdev;
+    struct bus_waiter waiter;
+    struct bus_waiter *w;
+    struct os_task *task;
+    os_sr_t sr;
+    int rc;
+
+    bdev = node->bn_bus;
+    task = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    if (bdev->bd_owner == NULL) {
+        bdev->bd_owner = node;
+        bdev->bd_owner_task = task;
+        bdev->bd_lock_cnt = 1;
+        OS_EXIT_CRITICAL(sr);
+    } else if (bdev->bd_owner_task == task || !os_started()) {
+        if (bdev->bd_owner != node || bdev->bd_lock_cnt == UINT8_MAX) {
+            /* Waiting would deadlock on ourselves */
+            OS_EXIT_CRITICAL(sr);
+            return SYS_EBUSY;
+        }
+        bdev->bd_lock_cnt++;
+        OS_EXIT_CRITICAL(sr);
+        return 0;
+    } else {
+        waiter.bw_node = node;
+        waiter.bw_task = task;
+        waiter.bw_granted = 0;
+        os_sem_init(&waiter.bw_sem, 0);
+
+        TAILQ_FOREACH(w, &bdev->bd_waiters, bw_next) {
+            if (w->bw_node->bn_prio > node->bn_prio) {
+                break;
+            }
+        }
+        if (w) {
+            TAILQ_INSERT_BEFORE(w, &waiter, bw_next);
+        } else {
+            TAILQ_INSERT_TAIL(&bdev->bd_waiters, &waiter, bw_next);
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        os_sem_pend(&waiter.bw_sem, timeout);
+
+        OS_ENTER_CRITICAL(sr);
+        if (!waiter.bw_granted) {
+            TAILQ_REMOVE(&bdev->bd_waiters, &waiter, bw_next);
+            OS_EXIT_CRITICAL(sr);
+            return SYS_ETIMEOUT;
+        }
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    rc = bus_dev_configure(bdev, node);
+    if (rc) {
+        bus_node_unlock(node);
+    }
+
+    return rc;
+}
+
+void
+bus_node_unlock(struct bus_node *node)
+{
+    struct bus_dev *bdev;
+    struct bus_waiter *w;
+    os_sr_t sr;
+
+    bdev = node->bn_bus;
+
+    OS_ENTER_CRITICAL(sr);
+    assert(bdev->bd_owner == node && bdev->bd_lock_cnt);
+    if (--bdev->bd_lock_cnt) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+
+    w = TAILQ_FIRST(&bdev->bd_waiters);
+    if (w) {
+        TAILQ_REMOVE(&bdev->bd_waiters, w, bw_next);
+        w->bw_granted = 1;
+        bdev->bd_owner = w->bw_node;
+        bdev->bd_owner_task = w->bw_task;
+        bdev->bd_lock_cnt = 1;
+        os_sem_release(&w->bw_sem);
+    } else {
+        bdev->bd_owner = NULL;
+        bdev->bd_owner_task = NULL;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+bus_spi_cs(struct bus_node *node, int val)
+{
+    if (node->bn_cs_pin >= 0) {
+        hal_gpio_write(node->bn_cs_pin, val);
+    }
+}
+
+static int
+bus_spi_read(struct bus_node *node, uint8_t *buf, uint16_t len)
+{
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = hal_spi_tx_val(node->bn_bus->bd_num, 0xff);
+    }
+
+    return 0;
+}
+
+static int
+bus_i2c_xfer(struct bus_node *node, uint8_t *buf, uint16_t len, int read,
+             os_time_t timeout, uint8_t last_op)
+{
+    struct hal_i2c_master_data data;
+
+    data.address = node->bn_addr;
+    data.len = len;
+    data.buffer = buf;
+
+    if (read) {
+        return hal_i2c_master_read(node->bn_bus->bd_num, &data, timeout,
+                                   last_op);
+    }
+
+    return hal_i2c_master_write(node->bn_bus->bd_num, &data, timeout, last_op);
+}
+
+int
+bus_node_write(struct bus_node *node, const void *buf, uint16_t len,
+               os_time_t timeout)
+{
+    int rc;
+
+    rc = bus_node_lock(node, timeout);
+    if (rc) {
+        return rc;
+    }
+
+    if (node->bn_bus->bd_type == BUS_TYPE_SPI) {
+        bus_spi_cs(node, 0);
+        rc = hal_spi_txrx(node->bn_bus->bd_num, (void *)buf, NULL, len);
+        bus_spi_cs(node, 1);
+    } else {
+        rc = bus_i2c_xfer(node, (uint8_t *)buf, len, 0, timeout, 1);
+    }
+
+    bus_node_unlock(node);
+
+    return rc;
+}
+
+int
+bus_node_read(struct bus_node *node, void *buf, uint16_t len,
+              os_time_t timeout)
+{
+    int rc;
+
+    rc = bus_node_lock(node, timeout);
+    if (rc) {
+        return rc;
+    }
+
+    if (node->bn_bus->bd_type == BUS_TYPE_SPI) {
+        bus_spi_cs(node, 0);
+        rc = bus_spi_read(node, buf, len);
+        bus_spi_cs(node, 1);
+    } else {
+        rc = bus_i2c_xfer(node, buf, len, 1, timeout, 1);
+    }
+
+    bus_node_unlock(node);
+
+    return rc;
+}
+
+int
+bus_node_write_read(struct bus_node *node, const void *wbuf,
+                    uint16_t wlen, void *rbuf, uint16_t rlen,
+                    os_time_t timeout)
+{
+    int rc;
+
+    rc = bus_node_lock(node, timeout);
+    if (rc) {
+        return rc;
+    }
+
+    if (node->bn_bus->bd_type == BUS_TYPE_SPI) {
+        bus_spi_cs(node, 0);
+        rc = hal_spi_txrx(node->bn_bus->bd_num, (void *)wbuf, NULL, wlen);
+        if (!rc) {
+            rc = bus_spi_read(node, rbuf, rlen);
+        }
+        bus_spi_cs(node, 1);
+    } else {
+        rc = bus_i2c_xfer(node, (uint8_t *)wbuf, wlen, 0, timeout, 0);
+        if (!rc) {
+            rc = bus_i2c_xfer(node, rbuf, rlen, 1, timeout, 1);
+        }
+    }
+
+    bus_node_unlock(node);
+
+    return rc;
+}
@@ -353,6 +353,23 @@ struct charge_control {
      */
     uint32_t cc_poll_rate;
 
+    /* Types whose changes the driver reports with charge_control_notify().
+     * If these cover all types read, the charge controller is only polled at
+     * CHARGE_CONTROL_NOTIFY_POLL_RATE.
+     */
+    charge_control_type_t cc_notify_types;
+
+    /* Types reported with charge_control_notify() and not read yet */
+    charge_control_type_t cc_notify_pending;
+
+    /* Event reading the types reported with charge_control_notify() */
+    struct os_event cc_notify_ev;
+
+    /* Last values read, valid for the types in cc_cached_types */
+    charge_control_type_t cc_cached_types;
+    charge_control_status_t cc_status;
+    charge_control_fault_t cc_fault;
+
     /* The next time at which we will poll data from this charge controller */
     os_time_t cc_next_run;
 
@@ -440,6 +457,32 @@ int charge_control_unregister_listener(struct charge_control *,
 int charge_control_read(struct charge_control *, charge_control_type_t, 
         charge_control_data_func_t, void *, uint32_t);
 
+/**
+ * Return the last values read from a charge controller, without accessing the
+ * device.  The data function is called for each requested type which has been
+ * read before.
+ *
+ * @param The charge controller
+ * @param The type(s) of charge control value(s) to return, as a mask
+ * @param The function to call with each value
+ * @param The argument to pass to the data function
+ *
+ * @return 0 on success, SYS_ENOENT if none of the types have been read yet.
+ */
+int charge_control_read_cached(struct charge_control *, charge_control_type_t,
+        charge_control_data_func_t, void *);
+
+/**
+ * Report a change signalled by the charge controller, typically from the
+ * interrupt handler of its status or INT pin.  The types are read from the
+ * charge control manager's event queue, and listeners are notified.  May be
+ * called from interrupt context.
+ *
+ * @param The charge controller
+ * @param The type(s) which may have changed
+ */
+void charge_control_notify(struct charge_control *, charge_control_type_t);
+
 /**
  * Set the charge controller poll rate
  *
@@ -479,6 +522,23 @@ charge_control_set_driver(struct charge_control *cc, charge_control_type_t type,
     return (0);
 }
 
+/**
+ * Set the types whose changes the driver reports with charge_control_notify().
+ * Charge controllers reporting all the types they read are only polled at
+ * CHARGE_CONTROL_NOTIFY_POLL_RATE, as a safety net.
+ *
+ * @param The charge controller
+ * @param The types reported
+ */
+static inline int
+charge_control_set_notify_types(struct charge_control *cc,
+        charge_control_type_t types)
+{
+    cc->cc_notify_types = types;
+
+    return (0);
+}
+
 /**
  * Set the charge control driver mask so that the developer who configures the
  * charge controller tells the charge control framework which data types to 
@@ -31,6 +31,7 @@
 /* ---------------------------- OS -------------------------------- */
 
 static void charge_control_read_ev_cb(struct os_event *ev);
+static void charge_control_notify_ev_cb(struct os_event *ev);
 
 static void charge_control_mgr_wakeup_event(struct os_event *);
 static void charge_control_base_ts_update_event(struct os_event *);
@@ -68,6 +69,13 @@ charge_control_find_min_nextrun(os_time_t, os_time_t *);
 static void
 charge_control_update_nextrun(struct charge_control *, os_time_t);
 
+static uint32_t
+charge_control_poll_rate(struct charge_control *);
+
+static int
+charge_control_cache_update(struct charge_control *, void *,
+        charge_control_type_t);
+
 static int
 charge_control_read_data_func(struct charge_control *, void *, void *,
         charge_control_type_t);
@@ -215,6 +223,25 @@ charge_control_read_ev_cb(struct os_event *ev)
     assert(rc == 0);
 }
 
+static void
+charge_control_notify_ev_cb(struct os_event *ev)
+{
+    struct charge_control *cc;
+    charge_control_type_t type;
+    os_sr_t sr;
+
+    cc = ev->ev_arg;
+
+    OS_ENTER_CRITICAL(sr);
+    type = cc->cc_notify_pending;
+    cc->cc_notify_pending = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (type) {
+        charge_control_read(cc, type, NULL, NULL, OS_TIMEOUT_NEVER);
+    }
+}
+
 static void
 charge_control_mgr_wakeup_event(struct os_event *ev)
 {
@@ -379,12 +406,29 @@ charge_control_find_min_nextrun(os_time_t now, os_time_t *min_nextrun)
     return head;
 }
 
+static uint32_t
+charge_control_poll_rate(struct charge_control *cc)
+{
+    charge_control_type_t types;
+
+    /* If the driver reports changes of everything read, polling is only a
+     * safety net.
+     */
+    types = cc->cc_types & cc->cc_mask;
+    if (cc->cc_notify_types != 0 && (types & ~cc->cc_notify_types) == 0 &&
+        cc->cc_poll_rate < MYNEWT_VAL(CHARGE_CONTROL_NOTIFY_POLL_RATE)) {
+        return MYNEWT_VAL(CHARGE_CONTROL_NOTIFY_POLL_RATE);
+    }
+
+    return cc->cc_poll_rate;
+}
+
 static void
 charge_control_update_nextrun(struct charge_control *cc, os_time_t now)
 {
     os_time_t charge_control_ticks;
 
-    os_time_ms_to_ticks(cc->cc_poll_rate, &charge_control_ticks);
+    os_time_ms_to_ticks(charge_control_poll_rate(cc), &charge_control_ticks);
 
     charge_control_lock(cc);
 
@@ -402,16 +446,58 @@ charge_control_update_nextrun(struct charge_control *cc, os_time_t now)
     charge_control_unlock(cc);
 }
 
+/**
+ * Stores a value read in the charge controller's cache.
+ *
+ * @return 1 if the value differs from the cached one, 0 if not.
+ */
+static int
+charge_control_cache_update(struct charge_control *cc, void *data,
+        charge_control_type_t type)
+{
+    int changed;
+
+    changed = !(cc->cc_cached_types & type);
+
+    switch (type) {
+    case CHARGE_CONTROL_TYPE_STATUS:
+        if (cc->cc_status != *(charge_control_status_t *)data) {
+            cc->cc_status = *(charge_control_status_t *)data;
+            changed = 1;
+        }
+        break;
+    case CHARGE_CONTROL_TYPE_FAULT:
+        if (cc->cc_fault != *(charge_control_fault_t *)data) {
+            cc->cc_fault = *(charge_control_fault_t *)data;
+            changed = 1;
+        }
+        break;
+    default:
+        return 1;
+    }
+
+    cc->cc_cached_types |= type;
+
+    return changed;
+}
+
 static int
 charge_control_read_data_func(struct charge_control *cc, void *arg,
         void *data, charge_control_type_t type)
 {
     struct charge_control_listener *listener;
     struct charge_control_read_ctx *ctx;
+    int changed;
 
     ctx = (struct charge_control_read_ctx *) arg;
 
-    if ((uint8_t)(uintptr_t)(ctx->user_arg) != CHARGE_CONTROL_IGN_LISTENER) {
+    changed = charge_control_cache_update(cc, data, type);
+    if (!MYNEWT_VAL(CHARGE_CONTROL_NOTIFY_ON_CHANGE)) {
+        changed = 1;
+    }
+
+    if (changed &&
+        (uint8_t)(uintptr_t)(ctx->user_arg) != CHARGE_CONTROL_IGN_LISTENER) {
         /* Notify all listeners first */
         SLIST_FOREACH(listener, &cc->cc_listener_list, ccl_next) {
             if (listener->ccl_type & type) {
@@ -597,6 +683,8 @@ charge_control_init(struct charge_control *cc, struct os_dev *dev)
         goto err;
     }
     cc->cc_dev = dev;
+    cc->cc_notify_ev.ev_cb = charge_control_notify_ev_cb;
+    cc->cc_notify_ev.ev_arg = cc;
 
     return (0);
 err:
@@ -678,6 +766,60 @@ err:
     return (rc);
 }
 
+int
+charge_control_read_cached(struct charge_control *cc,
+        charge_control_type_t type, charge_control_data_func_t data_func,
+        void *arg)
+{
+    charge_control_status_t status;
+    charge_control_fault_t fault;
+    charge_control_type_t cached;
+    int rc;
+
+    rc = charge_control_lock(cc);
+    if (rc) {
+        return (rc);
+    }
+
+    cached = cc->cc_cached_types & type;
+    status = cc->cc_status;
+    fault = cc->cc_fault;
+
+    charge_control_unlock(cc);
+
+    if (!cached) {
+        return (SYS_ENOENT);
+    }
+
+    if (cached & CHARGE_CONTROL_TYPE_STATUS) {
+        data_func(cc, arg, &status, CHARGE_CONTROL_TYPE_STATUS);
+    }
+    if (cached & CHARGE_CONTROL_TYPE_FAULT) {
+        data_func(cc, arg, &fault, CHARGE_CONTROL_TYPE_FAULT);
+    }
+
+    return (0);
+}
+
+void
+charge_control_notify(struct charge_control *cc, charge_control_type_t type)
+{
+    struct os_eventq *evq;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    cc->cc_notify_pending |= type;
+    OS_EXIT_CRITICAL(sr);
+
+    /* Nothing to do before the manager is initialized; the first poll reads
+     * the current values.
+     */
+    evq = charge_control_mgr_evq_get();
+    if (evq != NULL) {
+        os_eventq_put(evq, &cc->cc_notify_ev);
+    }
+}
+
 /* =================================================================
  * ====================== CHARGE CONTROL MANAGER ===================
  * =================================================================
@@ -320,6 +320,28 @@ err:
     return (rc);
 }
 
+/**
+ * Queue a buffer behind the ones the SAADC holds; it holds at most two.
+ */
+static int
+nrf52_adc_queue_buffer(struct adc_dev *dev, void *buf, int buf_len)
+{
+    int rc;
+
+    if (buf == NULL) {
+        nrfx_saadc_abort();
+        return (0);
+    }
+
+    rc = nrfx_saadc_buffer_convert((nrf_saadc_value_t *) buf,
+            buf_len / sizeof(nrf_saadc_value_t));
+    if (rc != NRFX_SUCCESS) {
+        return (rc);
+    }
+
+    return (0);
+}
+
 /**
  * Trigger an ADC sample.
  */
@@ -406,6 +428,7 @@ static const struct adc_driver_funcs nrf52_adc_funcs = {
         .af_release_buffer = nrf52_adc_release_buffer,
         .af_read_buffer = nrf52_adc_read_buffer,
         .af_size_buffer = nrf52_adc_size_buffer,
+        .af_queue_buffer = nrf52_adc_queue_buffer,
 };
 
 /**
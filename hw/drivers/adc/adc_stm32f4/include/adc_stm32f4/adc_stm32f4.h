@@ -59,6 +59,10 @@ struct stm32f4_adc_dev_cfg {
     void *secondarybuf;
     int buflen;
     ADC_HandleTypeDef *sac_adc_handle;
+    /* Buffers are queued with adc_buf_queue() rather than recycled */
+    uint8_t sac_queued;
+    /* Sampling ran out of queued buffers */
+    uint8_t sac_starved;
 };
 
 int stm32f4_adc_dev_init(struct os_dev *, void *);
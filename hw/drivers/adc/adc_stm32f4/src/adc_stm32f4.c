@@ -342,6 +342,25 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
     cfg  = (struct stm32f4_adc_dev_cfg *)adc->ad_dev.od_init_arg;
 
     buf = cfg->primarybuf;
+
+    if (cfg->sac_queued) {
+        /*
+         * Queued buffers belong to the application once full; carry on
+         * with the next queued one, if any.  In scan mode on a timer
+         * trigger the restart happens well before the next conversion.
+         */
+        cfg->primarybuf = cfg->secondarybuf;
+        cfg->secondarybuf = NULL;
+        if (!cfg->primarybuf) {
+            /* Restart as soon as a buffer is queued */
+            cfg->sac_starved = 1;
+        } else if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf,
+                                     cfg->buflen) != HAL_OK) {
+            ++stm32f4_adc_stats.adc_dma_start_error;
+        }
+        goto done;
+    }
+
     /**
      * If primary buffer gets full and secondary buffer exists, swap the
      * buffers and start ADC conversion with DMA with the now primary
@@ -360,8 +379,10 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
         }
     }
 
-    rc = adc->ad_event_handler_func(adc, NULL, ADC_EVENT_RESULT, buf,
-                                    cfg->buflen);
+done:
+    rc = adc->ad_event_handler_func(adc, adc->ad_event_handler_arg,
+                                    ADC_EVENT_RESULT, buf,
+                                    cfg->buflen * sizeof(uint32_t));
 
     if (rc) {
         ++stm32f4_adc_stats.adc_error;
@@ -615,6 +636,60 @@ stm32f4_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
     return (0);
 }
 
+/**
+ * Queue a buffer to fill after the current one.  The first queued buffer
+ * switches the driver from recycling its two buffers to handing each
+ * full buffer to the application.
+ */
+static int
+stm32f4_adc_queue_buffer(struct adc_dev *dev, void *buf, int buflen)
+{
+    struct stm32f4_adc_dev_cfg *cfg;
+    os_sr_t sr;
+    int rc;
+
+    assert(dev);
+    cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+
+    if (buf == NULL) {
+        HAL_ADC_Stop_DMA(cfg->sac_adc_handle);
+        OS_ENTER_CRITICAL(sr);
+        cfg->primarybuf = NULL;
+        cfg->secondarybuf = NULL;
+        cfg->sac_queued = 0;
+        cfg->sac_starved = 0;
+        OS_EXIT_CRITICAL(sr);
+        return (OS_OK);
+    }
+
+    rc = OS_OK;
+    OS_ENTER_CRITICAL(sr);
+    if (!cfg->sac_queued) {
+        cfg->sac_queued = 1;
+        cfg->primarybuf = NULL;
+        cfg->secondarybuf = NULL;
+    }
+    if (cfg->primarybuf == NULL) {
+        cfg->primarybuf = buf;
+        cfg->buflen = buflen / sizeof(uint32_t);
+        if (cfg->sac_starved) {
+            cfg->sac_starved = 0;
+            if (HAL_ADC_Start_DMA(cfg->sac_adc_handle, cfg->primarybuf,
+                                  cfg->buflen) != HAL_OK) {
+                ++stm32f4_adc_stats.adc_dma_start_error;
+                rc = OS_EINVAL;
+            }
+        }
+    } else if (cfg->secondarybuf == NULL) {
+        cfg->secondarybuf = buf;
+    } else {
+        rc = OS_EBUSY;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (rc);
+}
+
 /**
  * Trigger an ADC sample.
  *
@@ -710,6 +785,7 @@ static const struct adc_driver_funcs stm32f4_adc_funcs = {
         .af_release_buffer = stm32f4_adc_release_buffer,
         .af_read_buffer = stm32f4_adc_read_buffer,
         .af_size_buffer = stm32f4_adc_size_buffer,
+        .af_queue_buffer = stm32f4_adc_queue_buffer,
 };
 
 /**
@@ -20,6 +20,7 @@
 #ifndef __ADC_H__
 #define __ADC_H__
 
+#include <errno.h>
 #include "os/mynewt.h"
 
 #ifdef __cplusplus
@@ -137,6 +138,22 @@ typedef int (*adc_buf_read_func_t)(struct adc_dev *, void *, int, int, int *);
  */
 typedef int (*adc_buf_size_func_t)(struct adc_dev *, int, int);
 
+/**
+ * Queue a buffer for the driver to fill after the ones it already holds.
+ * Unlike buffers given with adc_buf_set(), a queued buffer is not reused
+ * by the driver once it is reported full; it has to be queued again.  A
+ * NULL buffer stops sampling and drops all queued buffers.  This is
+ * implemented by the HW specific drivers, optionally.
+ *
+ * @param The ADC device to queue the buffer to
+ * @param The buffer, or NULL
+ * @param The length of the buffer in bytes
+ *
+ * @return 0 on success, non-zero error code on failure (e.g. the driver
+ *         already holds as many buffers as it can).
+ */
+typedef int (*adc_buf_queue_func_t)(struct adc_dev *, void *, int);
+
 struct adc_driver_funcs {
     adc_configure_channel_func_t af_configure_channel;
     adc_sample_func_t af_sample;
@@ -145,6 +162,7 @@ struct adc_driver_funcs {
     adc_buf_release_func_t af_release_buffer;
     adc_buf_read_func_t af_read_buffer;
     adc_buf_size_func_t af_size_buffer;
+    adc_buf_queue_func_t af_queue_buffer;
 };
 
 struct adc_chan_config {
@@ -171,6 +189,75 @@ int adc_chan_read(struct adc_dev *, uint8_t, int *);
 int adc_event_handler_set(struct adc_dev *, adc_event_handler_func_t,
         void *);
 
+#if MYNEWT_VAL(ADC_STREAM)
+/**
+ * User header of each mbuf delivered by an ADC stream.
+ */
+struct adc_stream_hdr {
+    /* os_cputime when the buffer was reported full */
+    uint32_t ash_cputime;
+    /* Sequence number of the buffer; gaps are buffers dropped because no
+     * mbuf was free to replace them.
+     */
+    uint32_t ash_seq;
+};
+
+/**
+ * Continuous sampling into a pool of mbufs.  The driver fills the mbufs
+ * in place (zero copy); each full one is stamped with an adc_stream_hdr
+ * and put on an mqueue for the application, which owns and frees it.
+ * Full buffers are replaced from the pool as they complete, so as many
+ * buffers as the pool holds can be in flight to the application.
+ */
+struct adc_stream {
+    struct adc_dev *as_dev;
+    struct os_mbuf_pool *as_pool;
+    struct os_mqueue *as_mq;
+    struct os_eventq *as_evq;
+    int as_buf_len;
+
+    /* Buffers queued to the driver, oldest first */
+    struct os_mbuf *as_queued[MYNEWT_VAL(ADC_STREAM_DEPTH)];
+    uint8_t as_nqueued;
+
+    uint32_t as_seq;
+    uint32_t as_dropped;
+
+    /* Handler replaced by the stream; gets all other events */
+    adc_event_handler_func_t as_prev_func;
+    void *as_prev_arg;
+};
+
+/**
+ * Start streaming ADC results into mbufs.  Sampling itself is triggered
+ * as configured for the device, e.g. by a hardware timer, or with
+ * adc_sample().  The device's driver must implement af_queue_buffer.
+ *
+ * @param as      The stream
+ * @param dev     The ADC device, opened and with its channels configured
+ * @param pool    Pool of packet header mbufs with room for an
+ *                adc_stream_hdr user header and buf_len bytes of data
+ * @param buf_len Size of each buffer in bytes, see adc_buf_size()
+ * @param mq      Mqueue full buffers are put on
+ * @param evq     Event queue to notify on for mq
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+int adc_stream_start(struct adc_stream *as, struct adc_dev *dev,
+                     struct os_mbuf_pool *pool, int buf_len,
+                     struct os_mqueue *mq, struct os_eventq *evq);
+
+/**
+ * Stop an ADC stream and free the buffers still queued to the driver.
+ * Buffers already delivered belong to the application.
+ *
+ * @param as The stream
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+int adc_stream_stop(struct adc_stream *as);
+#endif
+
 /**
  * Sample the device specified by dev.  This is used in non-blocking mode
  * to generate samples into the event buffer.
@@ -238,6 +325,25 @@ adc_buf_release(struct adc_dev *dev, void *buf, int buf_len)
     return (dev->ad_funcs->af_release_buffer(dev, buf, buf_len));
 }
 
+/**
+ * Queue a buffer for the driver to fill, see adc_buf_queue_func_t.
+ *
+ * @param dev The device to queue the buffer to
+ * @param buf The buffer, or NULL to stop and drop queued buffers
+ * @param buf_len The length of the buffer
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+static inline int
+adc_buf_queue(struct adc_dev *dev, void *buf, int buf_len)
+{
+    if (dev->ad_funcs->af_queue_buffer == NULL) {
+        return (ENOTSUP);
+    }
+
+    return (dev->ad_funcs->af_queue_buffer(dev, buf, buf_len));
+}
+
 /**
  * Read an entry from an ADC buffer
  *
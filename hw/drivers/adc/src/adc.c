@@ -21,6 +21,7 @@
 #include <adc/adc.h>
 #include <errno.h>
 #include <assert.h>
+#include <string.h>
 
 /**
  * Configure a channel on the ADC device.
@@ -87,3 +88,166 @@ adc_event_handler_set(struct adc_dev *dev, adc_event_handler_func_t func,
     return (0);
 }
 
+
+#if MYNEWT_VAL(ADC_STREAM)
+/**
+ * Queues a fresh mbuf to the driver.
+ */
+static int
+adc_stream_queue(struct adc_stream *as, struct os_mbuf *om)
+{
+    int rc;
+
+    rc = adc_buf_queue(as->as_dev, om->om_data, as->as_buf_len);
+    if (rc != 0) {
+        return (rc);
+    }
+    as->as_queued[as->as_nqueued++] = om;
+
+    return (0);
+}
+
+/**
+ * Event handler installed by adc_stream_start().  Runs in the driver's
+ * interrupt context.
+ */
+static int
+adc_stream_event(struct adc_dev *dev, void *arg, adc_event_type_t type,
+        void *buf, int buf_len)
+{
+    struct adc_stream_hdr *hdr;
+    struct adc_stream *as;
+    struct os_mbuf *full;
+    struct os_mbuf *om;
+    int i;
+
+    as = arg;
+
+    if (type != ADC_EVENT_RESULT) {
+        if (as->as_prev_func != NULL) {
+            return (as->as_prev_func(dev, as->as_prev_arg, type, buf,
+                                     buf_len));
+        }
+        return (0);
+    }
+
+    if (as->as_nqueued == 0 || as->as_queued[0]->om_data != buf) {
+        return (EINVAL);
+    }
+
+    full = as->as_queued[0];
+    for (i = 1; i < as->as_nqueued; i++) {
+        as->as_queued[i - 1] = as->as_queued[i];
+    }
+    as->as_nqueued--;
+
+    /* Keep the driver supplied; without a free mbuf the full buffer is
+     * dropped and refilled rather than letting sampling stall.
+     */
+    om = os_mbuf_get_pkthdr(as->as_pool, sizeof(struct adc_stream_hdr));
+    if (om == NULL) {
+        om = full;
+        full = NULL;
+        as->as_dropped++;
+    }
+    adc_stream_queue(as, om);
+
+    if (full != NULL) {
+        full->om_len = buf_len;
+        OS_MBUF_PKTHDR(full)->omp_len = buf_len;
+
+        hdr = OS_MBUF_USRHDR(full);
+        hdr->ash_cputime = os_cputime_get32();
+        hdr->ash_seq = as->as_seq;
+
+        if (os_mqueue_put(as->as_mq, as->as_evq, full) != 0) {
+            os_mbuf_free_chain(full);
+            as->as_dropped++;
+        }
+    }
+    as->as_seq++;
+
+    return (0);
+}
+
+int
+adc_stream_start(struct adc_stream *as, struct adc_dev *dev,
+        struct os_mbuf_pool *pool, int buf_len, struct os_mqueue *mq,
+        struct os_eventq *evq)
+{
+    struct os_mbuf *om;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    if (dev->ad_funcs->af_queue_buffer == NULL) {
+        return (ENOTSUP);
+    }
+
+    memset(as, 0, sizeof(*as));
+    as->as_dev = dev;
+    as->as_pool = pool;
+    as->as_mq = mq;
+    as->as_evq = evq;
+    as->as_buf_len = buf_len;
+
+    OS_ENTER_CRITICAL(sr);
+    as->as_prev_func = dev->ad_event_handler_func;
+    as->as_prev_arg = dev->ad_event_handler_arg;
+    adc_event_handler_set(dev, adc_stream_event, as);
+    OS_EXIT_CRITICAL(sr);
+
+    for (i = 0; i < MYNEWT_VAL(ADC_STREAM_DEPTH); i++) {
+        om = os_mbuf_get_pkthdr(pool, sizeof(struct adc_stream_hdr));
+        if (om == NULL) {
+            rc = ENOMEM;
+            goto err;
+        }
+        if (OS_MBUF_TRAILINGSPACE(om) < buf_len) {
+            os_mbuf_free_chain(om);
+            rc = EINVAL;
+            goto err;
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        rc = adc_stream_queue(as, om);
+        OS_EXIT_CRITICAL(sr);
+        if (rc != 0) {
+            os_mbuf_free_chain(om);
+            /* The driver cannot hold more; fine once it holds one */
+            if (i > 0) {
+                break;
+            }
+            goto err;
+        }
+    }
+
+    return (0);
+err:
+    adc_stream_stop(as);
+    return (rc);
+}
+
+int
+adc_stream_stop(struct adc_stream *as)
+{
+    struct adc_dev *dev;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    dev = as->as_dev;
+
+    OS_ENTER_CRITICAL(sr);
+    rc = adc_buf_queue(dev, NULL, 0);
+    adc_event_handler_set(dev, as->as_prev_func, as->as_prev_arg);
+    OS_EXIT_CRITICAL(sr);
+
+    for (i = 0; i < as->as_nqueued; i++) {
+        os_mbuf_free_chain(as->as_queued[i]);
+    }
+    as->as_nqueued = 0;
+
+    return (rc);
+}
+#endif
@@ -60,38 +60,16 @@ static const struct adp5061_config default_config = {
 
 #if MYNEWT_VAL(ADP5061_INT_PIN) >= 0
 /**
-* ADP5061 interrupt handler CB
-* gets interrupt status and prints to console
+* ADP5061 IRQ
+* Interrupt generated by charger triggers out of schedule read
 */
-
 static void
-adp5061_event(struct os_event *ev)
+adp5061_isr(void *arg)
 {
-    struct adp5061_dev *dev;
-
-    assert(ev);
-    dev = ev->ev_arg;
+    struct adp5061_dev *dev = arg;
 
-    /* Interrupt generated by charger triggers out of schedule read */
-    charge_control_read(&dev->a_chg_ctrl,
-            CHARGE_CONTROL_TYPE_STATUS | CHARGE_CONTROL_TYPE_FAULT,
-            NULL, NULL, OS_TIMEOUT_NEVER);
-}
-
-/**
-* ADP5061 interrupt handler structure
-*/
-static struct os_event interrupt_handler = {
-    .ev_cb = adp5061_event,
-};
-
-/**
-* ADP5061 IRQ
-* Add interrupt handling task to queue
-*/
-static void
-adp5061_isr(void *arg){
-    os_eventq_put(os_eventq_dflt_get(), &interrupt_handler);
+    charge_control_notify(&dev->a_chg_ctrl,
+            CHARGE_CONTROL_TYPE_STATUS | CHARGE_CONTROL_TYPE_FAULT);
 }
 #endif
 
@@ -480,7 +458,7 @@ adp5061_chg_ctrl_read(struct charge_control *cc, charge_control_type_t type,
         if (ADP5061_INT_ACTIVE_TSD_GET(int_reg)) {
             fault |= CHARGE_CONTROL_FAULT_THERM;
         }
-        if (fault && data_func) {
+        if (data_func) {
             data_func(cc, data_arg, &fault, CHARGE_CONTROL_TYPE_FAULT);
         }
     }
@@ -629,8 +607,13 @@ adp5061_init(struct os_dev *dev, void *arg)
     }
 
 #if MYNEWT_VAL(ADP5061_INT_PIN) >= 0
-    hal_gpio_irq_init(MYNEWT_VAL(ADP5061_INT_PIN), adp5061_isr, adp5061,
-                      HAL_GPIO_TRIG_FALLING, HAL_GPIO_PULL_NONE);
+    rc = hal_gpio_irq_init(MYNEWT_VAL(ADP5061_INT_PIN), adp5061_isr, adp5061,
+                           HAL_GPIO_TRIG_FALLING, HAL_GPIO_PULL_NONE);
+    if (rc) {
+        goto err;
+    }
+    charge_control_set_notify_types(cc,
+            CHARGE_CONTROL_TYPE_STATUS | CHARGE_CONTROL_TYPE_FAULT);
 #endif
     rc = adp5061_set_config(adp5061, cfg);
     if (rc) {
@@ -641,6 +624,9 @@ adp5061_init(struct os_dev *dev, void *arg)
     if (rc) {
         goto err;
     }
+#if MYNEWT_VAL(ADP5061_INT_PIN) >= 0
+    hal_gpio_irq_enable(MYNEWT_VAL(ADP5061_INT_PIN));
+#endif
 #if MYNEWT_VAL(ADP5061_CLI)
     adp5061_shell_init(adp5061);
 #endif
@@ -44,6 +44,7 @@ struct bq24040_pin {
 	int bp_init_value;
 	hal_gpio_irq_trig_t bp_irq_trig;
 	hal_gpio_pull_t bp_pull;
+	/* NULL with bp_irq_trig set: report changes with charge_control_notify() */
 	bq24040_interrupt_handler bp_irq_fn;
 };
 
@@ -46,18 +46,39 @@ static const struct charge_control_driver g_bq24040_chg_ctrl_driver = {
     .ccd_disable = bq24040_chg_ctrl_disable,
 };
 
+static void
+bq24040_pin_isr(void *arg)
+{
+    struct bq24040 *bq24040 = arg;
+
+    charge_control_notify(&bq24040->b_chg_ctrl, CHARGE_CONTROL_TYPE_STATUS);
+}
+
 static int
-bq24040_configure_pin(struct bq24040_pin *pin)
+bq24040_configure_pin(struct bq24040 *bq24040, struct bq24040_pin *pin)
 {
+    int rc;
+
     if ((!pin) || (pin->bp_pin_num == -1)) {
         return 0;
     }
 
     if (pin->bp_pin_direction == HAL_GPIO_MODE_IN) {
         if (pin->bp_irq_trig != HAL_GPIO_TRIG_NONE) {
-            assert(pin->bp_irq_fn != NULL);
-            return hal_gpio_irq_init(pin->bp_pin_num, pin->bp_irq_fn,
-                    NULL, pin->bp_irq_trig, pin->bp_pull);
+            if (pin->bp_irq_fn != NULL) {
+                return hal_gpio_irq_init(pin->bp_pin_num, pin->bp_irq_fn,
+                        NULL, pin->bp_irq_trig, pin->bp_pull);
+            }
+            /* No handler given, status changes are reported to the charge
+             * control manager.
+             */
+            rc = hal_gpio_irq_init(pin->bp_pin_num, bq24040_pin_isr,
+                    bq24040, pin->bp_irq_trig, pin->bp_pull);
+            if (rc) {
+                return rc;
+            }
+            hal_gpio_irq_enable(pin->bp_pin_num);
+            return 0;
         } else {
             return hal_gpio_init_in(pin->bp_pin_num, pin->bp_pull);
         }
@@ -68,6 +89,14 @@ bq24040_configure_pin(struct bq24040_pin *pin)
     return SYS_EINVAL;
 }
 
+static int
+bq24040_pin_notifies(struct bq24040_pin *pin)
+{
+    return pin && pin->bp_pin_num != -1 &&
+           pin->bp_pin_direction == HAL_GPIO_MODE_IN &&
+           pin->bp_irq_trig != HAL_GPIO_TRIG_NONE && pin->bp_irq_fn == NULL;
+}
+
 int
 bq24040_init(struct os_dev *dev, void *arg)
 {
@@ -120,18 +149,27 @@ bq24040_config(struct bq24040 *bq24040, struct bq24040_cfg *cfg)
 
     bq24040->b_cfg = *cfg;
 
-    rc = bq24040_configure_pin(cfg->bc_pg_pin);
+    rc = bq24040_configure_pin(bq24040, cfg->bc_pg_pin);
     if (rc) {
         goto err;
     }
 
-    rc = bq24040_configure_pin(cfg->bc_chg_pin);
+    rc = bq24040_configure_pin(bq24040, cfg->bc_chg_pin);
     if (rc) {
         goto err;
     }
 
+    /* Status only needs a safety net poll when both its pins interrupt */
+    if (bq24040_pin_notifies(cfg->bc_pg_pin) &&
+        bq24040_pin_notifies(cfg->bc_chg_pin)) {
+        charge_control_set_notify_types(&bq24040->b_chg_ctrl,
+                CHARGE_CONTROL_TYPE_STATUS);
+    } else {
+        charge_control_set_notify_types(&bq24040->b_chg_ctrl, 0);
+    }
+
     if (cfg->bc_ts_mode == BQ24040_TS_MODE_DISABLED) {
-        rc = bq24040_configure_pin(cfg->bc_ts_pin);
+        rc = bq24040_configure_pin(bq24040, cfg->bc_ts_pin);
         if (rc) {
             goto err;
         }
@@ -139,7 +177,7 @@ bq24040_config(struct bq24040 *bq24040, struct bq24040_cfg *cfg)
         bq24040->b_is_enabled = true;
     }
 
-    rc = bq24040_configure_pin(cfg->bc_iset2_pin);
+    rc = bq24040_configure_pin(bq24040, cfg->bc_iset2_pin);
     if (rc) {
         goto err;
     }
@@ -225,6 +263,7 @@ static int
 bq24040_chg_ctrl_read(struct charge_control *cc, charge_control_type_t type,
         charge_control_data_func_t data_func, void *data_arg, uint32_t timeout)
 {
+    charge_control_status_t cc_status;
     int status;
     int rc;
 
@@ -240,7 +279,8 @@ bq24040_chg_ctrl_read(struct charge_control *cc, charge_control_type_t type,
         goto err;
     }
 
-    data_func(cc, data_arg, (void*)&status, CHARGE_CONTROL_TYPE_STATUS);
+    cc_status = status;
+    data_func(cc, data_arg, (void*)&cc_status, CHARGE_CONTROL_TYPE_STATUS);
 
     return 0;
 err:
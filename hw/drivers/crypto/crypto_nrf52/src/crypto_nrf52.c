@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "mcu/cmsis_nvic.h"
+#include "crypto/crypto.h"
+#include "crypto_nrf52/crypto_nrf52.h"
+
+/* Layout expected by the ECB peripheral at ECBDATAPTR */
+static struct {
+    uint8_t key[CRYPTO_AES128_KEY_LEN];
+    uint8_t plain[CRYPTO_AES_BLOCK_LEN];
+    uint8_t cipher[CRYPTO_AES_BLOCK_LEN];
+} nrf52_ecb;
+
+static int
+nrf52_crypto_aes_ecb_encrypt(struct crypto_dev *crypto, const uint8_t *key,
+                             const uint8_t *in, uint8_t *out)
+{
+    os_sr_t sr;
+    int ctr = 0x100000;
+    int rc;
+
+    /*
+     * A block takes a few usecs, so poll with interrupts disabled.  This
+     * keeps other users of ECB (e.g. the BLE controller) from changing
+     * ECBDATAPTR underneath us.  If CCM or AAR preempts the AES core,
+     * ERRORECB is raised and the caller gets SYS_EBUSY.
+     */
+    OS_ENTER_CRITICAL(sr);
+
+    memcpy(nrf52_ecb.key, key, sizeof(nrf52_ecb.key));
+    memcpy(nrf52_ecb.plain, in, sizeof(nrf52_ecb.plain));
+
+    NRF_ECB->EVENTS_ENDECB = 0;
+    NRF_ECB->EVENTS_ERRORECB = 0;
+    NRF_ECB->ECBDATAPTR = (uint32_t)&nrf52_ecb;
+    NRF_ECB->TASKS_STARTECB = 1;
+
+    rc = SYS_ETIMEOUT;
+    while (ctr-- > 0) {
+        if (NRF_ECB->EVENTS_ENDECB) {
+            memcpy(out, nrf52_ecb.cipher, sizeof(nrf52_ecb.cipher));
+            rc = 0;
+            break;
+        }
+        if (NRF_ECB->EVENTS_ERRORECB) {
+            rc = SYS_EBUSY;
+            break;
+        }
+    }
+    if (rc) {
+        NRF_ECB->TASKS_STOPECB = 1;
+    }
+    NRF_ECB->EVENTS_ENDECB = 0;
+    NRF_ECB->EVENTS_ERRORECB = 0;
+
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+int
+nrf52_crypto_dev_init(struct os_dev *dev, void *arg)
+{
+    struct crypto_dev *crypto;
+
+    crypto = (struct crypto_dev *)dev;
+    assert(crypto);
+
+    crypto->interface.aes_ecb_encrypt = nrf52_crypto_aes_ecb_encrypt;
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "mcu/stm32_hal.h"
+#include "crypto/crypto.h"
+#include "crypto_stm32/crypto_stm32.h"
+
+#if !defined(AES)
+#error "This MCU has no AES peripheral"
+#endif
+
+static CRYP_HandleTypeDef g_hcryp;
+static struct os_mutex stm32_crypto_mtx;
+
+/* Key currently loaded into the peripheral */
+static uint8_t stm32_crypto_key[CRYPTO_AES128_KEY_LEN];
+static uint8_t stm32_crypto_key_valid;
+
+static int
+stm32_crypto_aes_ecb_encrypt(struct crypto_dev *crypto, const uint8_t *key,
+                             const uint8_t *in, uint8_t *out)
+{
+    HAL_StatusTypeDef status;
+    int rc;
+
+    os_mutex_pend(&stm32_crypto_mtx, OS_TIMEOUT_NEVER);
+
+    /* Reloading the key costs a full init; skip it for repeated keys */
+    if (!stm32_crypto_key_valid ||
+        memcmp(stm32_crypto_key, key, sizeof(stm32_crypto_key))) {
+        memcpy(stm32_crypto_key, key, sizeof(stm32_crypto_key));
+        stm32_crypto_key_valid = 0;
+        if (HAL_CRYP_Init(&g_hcryp) != HAL_OK) {
+            rc = SYS_EIO;
+            goto out;
+        }
+        stm32_crypto_key_valid = 1;
+    }
+
+    status = HAL_CRYPEx_AES(&g_hcryp, (uint8_t *)in, CRYPTO_AES_BLOCK_LEN, out,
+                            MYNEWT_VAL(STM32_CRYPTO_TIMEOUT));
+    if (status == HAL_OK) {
+        rc = 0;
+    } else if (status == HAL_TIMEOUT) {
+        rc = SYS_ETIMEOUT;
+    } else {
+        rc = SYS_EIO;
+    }
+
+out:
+    os_mutex_release(&stm32_crypto_mtx);
+    return rc;
+}
+
+int
+stm32_crypto_dev_init(struct os_dev *dev, void *arg)
+{
+    struct crypto_dev *crypto;
+
+    crypto = (struct crypto_dev *)dev;
+    assert(crypto);
+
+    os_mutex_init(&stm32_crypto_mtx);
+
+    __HAL_RCC_AES_CLK_ENABLE();
+
+    g_hcryp.Instance = AES;
+    g_hcryp.Init.DataType = CRYP_DATATYPE_8B;
+    g_hcryp.Init.KeySize = CRYP_KEYSIZE_128B;
+    g_hcryp.Init.OperatingMode = CRYP_ALGOMODE_ENCRYPT;
+    g_hcryp.Init.ChainingMode = CRYP_CHAINMODE_AES_ECB;
+    g_hcryp.Init.KeyWriteFlag = CRYP_KEY_WRITE_ENABLE;
+    g_hcryp.Init.pKey = stm32_crypto_key;
+
+    crypto->interface.aes_ecb_encrypt = stm32_crypto_aes_ecb_encrypt;
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __CRYPTO_H__
+#define __CRYPTO_H__
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRYPTO_AES_BLOCK_LEN    16
+#define CRYPTO_AES128_KEY_LEN   16
+
+struct crypto_dev;
+
+typedef int (* crypto_aes_ecb_encrypt_func_t)(struct crypto_dev *crypto,
+                                              const uint8_t *key,
+                                              const uint8_t *in,
+                                              uint8_t *out);
+
+struct crypto_interface {
+    crypto_aes_ecb_encrypt_func_t aes_ecb_encrypt;
+};
+
+struct crypto_dev {
+    struct os_dev dev;
+    struct crypto_interface interface;
+};
+
+/**
+ * Encrypt a single block with AES-128 in ECB mode
+ *
+ * Block cipher modes (CTR, CMAC, ...) are built on top of this by the
+ * caller.  \p in and \p out may point to the same buffer.
+ *
+ * @param crypto  OS device
+ * @param key     128-bit key
+ * @param in      plaintext block (CRYPTO_AES_BLOCK_LEN bytes)
+ * @param out     ciphertext block (CRYPTO_AES_BLOCK_LEN bytes)
+ *
+ * @return  0 on success, SYS_E* error code if the engine could not
+ *          complete the operation
+ */
+int crypto_aes_ecb_encrypt(struct crypto_dev *crypto, const uint8_t *key,
+                           const uint8_t *in, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_H__ */
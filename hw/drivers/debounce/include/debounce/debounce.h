@@ -61,6 +61,11 @@
  *
  * // ---------------------- Example end --------------------------
  *
+ * With DEBOUNCE_TIMESTAMP the pin interrupt stays enabled and every edge is
+ * timestamped by gpio_event. A pin is stable once it has not changed for
+ * the critical time, and all pins share one os_cputime deadline timer which
+ * only runs while some pin is bouncing.
+ *
  * The driver relies on
  *   hal_timer ... at least one HW timer needs to be configured
  *                 and running
@@ -68,8 +73,12 @@
  *                 to detect the initial trigger for debouncing
  */
 
+#include "os/mynewt.h"
 #include "hal/hal_gpio.h"
 #include "hal/hal_timer.h"
+#if MYNEWT_VAL(DEBOUNCE_GPIO_EVENT)
+#include "gpio_event/gpio_event.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,13 +94,23 @@ typedef struct debounce_pin {
     uint32_t state   :  1;
     uint32_t on_rise :  1;
     uint32_t on_fall :  1;
+    uint32_t active  :  1;
     uint32_t         :  0;
     uint32_t ticks   : 16;
     uint32_t count   :  8;
     uint32_t accu    :  8;
     void (*on_change)(struct debounce_pin*);
     void *arg;
+#if MYNEWT_VAL(DEBOUNCE_TIMESTAMP)
+    uint32_t last_edge;
+    SLIST_ENTRY(debounce_pin) next;
+#else
     struct hal_timer timer;
+#endif
+#if MYNEWT_VAL(DEBOUNCE_GPIO_EVENT)
+    uint32_t edge_time;
+    struct gpio_event_listener gel;
+#endif
 } debounce_pin_t;
 
 /*
@@ -128,7 +147,8 @@ typedef void (*debounce_callback_t)(debounce_pin_t *);
  * @param pull      Pull type, see hal_gpio.h
  * @param timer     The HW timer number to be used by the debouncer.
  *                  The timer has to be configured and setup properly by the
- *                  application before this call.
+ *                  application before this call. Ignored with
+ *                  DEBOUNCE_TIMESTAMP, which uses os_cputime.
  *
  * @return int  0: no error; -1 otherwise.
  */
@@ -145,7 +165,8 @@ int debounce_init(debounce_pin_t *d, int pin, hal_gpio_pull_t pull, int timer);
  *   critical_time = timer_tick_period * ticks * count
  * This value describes the minim latency introduce by debouncing a pin. It
  * also represents the minimum time a pin has to be asserted or not for the
- * change to be propagated.
+ * change to be propagated. With DEBOUNCE_TIMESTAMP the timer is os_cputime
+ * and the pin must see no edge at all for that long.
  *
  * The default values are defined by package values
  *   DEBOUNCE_PARAM_TICKS 1
@@ -228,6 +249,22 @@ debounce_arg(debounce_pin_t *d)
     return d->arg;
 }
 
+#if MYNEWT_VAL(DEBOUNCE_GPIO_EVENT)
+/**
+ * debounce edge time
+ *
+ * @param d         Structure to manage debouncing
+ *
+ * @return uint32_t  os_cputime of the pin change which started the last
+ *                   debouncing, i.e. when the state actually began changing
+ */
+static inline uint32_t
+debounce_edge_time(debounce_pin_t *d)
+{
+    return d->edge_time;
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
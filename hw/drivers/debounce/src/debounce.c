@@ -21,6 +21,114 @@
 #include "os/mynewt.h"
 #include "debounce/debounce.h"
 
+#if MYNEWT_VAL(DEBOUNCE_TIMESTAMP)
+
+/* Pins that have seen an edge and not yet settled; all share one timer. */
+static SLIST_HEAD(, debounce_pin) debounce_bouncing =
+    SLIST_HEAD_INITIALIZER(debounce_bouncing);
+static struct hal_timer debounce_timer;
+static bool debounce_timer_inited;
+
+static inline uint32_t
+debounce_deadline(const debounce_pin_t *d)
+{
+    return d->last_edge + (uint32_t)d->ticks * d->count;
+}
+
+/* Must be called with interrupts disabled. */
+static void
+debounce_timer_arm(void)
+{
+    debounce_pin_t *d;
+    uint32_t first;
+    uint32_t deadline;
+
+    os_cputime_timer_stop(&debounce_timer);
+
+    d = SLIST_FIRST(&debounce_bouncing);
+    if (d == NULL) {
+        /* nothing bouncing, let the CPU sleep */
+        return;
+    }
+
+    first = debounce_deadline(d);
+    SLIST_FOREACH(d, &debounce_bouncing, next) {
+        deadline = debounce_deadline(d);
+        if (CPUTIME_LT(deadline, first)) {
+            first = deadline;
+        }
+    }
+    os_cputime_timer_start(&debounce_timer, first);
+}
+
+static void
+debounce_timer_cb(void *arg)
+{
+    SLIST_HEAD(, debounce_pin) settled = SLIST_HEAD_INITIALIZER(settled);
+    debounce_pin_t *prev;
+    debounce_pin_t *next;
+    debounce_pin_t *d;
+    uint32_t now;
+    os_sr_t sr;
+    int level;
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_cputime_get32();
+    prev = NULL;
+    for (d = SLIST_FIRST(&debounce_bouncing); d != NULL; d = next) {
+        next = SLIST_NEXT(d, next);
+        if (CPUTIME_LT(now, debounce_deadline(d))) {
+            prev = d;
+            continue;
+        }
+        if (prev == NULL) {
+            SLIST_REMOVE_HEAD(&debounce_bouncing, next);
+        } else {
+            SLIST_NEXT(prev, next) = next;
+        }
+        d->active = 0;
+        SLIST_INSERT_HEAD(&settled, d, next);
+    }
+    debounce_timer_arm();
+    OS_EXIT_CRITICAL(sr);
+
+    /* no edge for the critical time, the pin now reads its stable level */
+    while ((d = SLIST_FIRST(&settled)) != NULL) {
+        SLIST_REMOVE_HEAD(&settled, next);
+
+        level = hal_gpio_read(d->pin) ? 1 : 0;
+        if (level == d->state) {
+            continue;
+        }
+        d->state = level;
+        if (level && d->on_rise && d->on_change) {
+            d->on_change(d);
+        } else if (!level && d->on_fall && d->on_change) {
+            d->on_change(d);
+        }
+    }
+}
+
+static void
+debounce_gpio_event(struct gpio_event_listener *gel,
+                    const struct gpio_event *ev)
+{
+    debounce_pin_t *d = (debounce_pin_t*)gpio_event_arg(gel);
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!d->active) {
+        d->active = 1;
+        d->edge_time = ev->ge_time;
+        SLIST_INSERT_HEAD(&debounce_bouncing, d, next);
+    }
+    d->last_edge = ev->ge_time;
+    debounce_timer_arm();
+    OS_EXIT_CRITICAL(sr);
+}
+
+#else
+
 static void
 debounce_check(void *arg)
 {
@@ -50,6 +158,7 @@ debounce_check(void *arg)
 
     if (0 == integrate || d->count == integrate) {
         /* debouncing complete, no point in periodically updating */
+        d->active = 0;
         hal_gpio_irq_enable(d->pin);
     } else {
         /* no decision yet, continue debouncing */
@@ -64,9 +173,28 @@ debounce_trigger(void *arg)
 
     /* once triggered, switch to periodic checks */
     hal_gpio_irq_disable(d->pin);
+    d->active = 1;
     hal_timer_start(&d->timer, d->ticks);
 }
 
+#if MYNEWT_VAL(DEBOUNCE_GPIO_EVENT)
+static void
+debounce_gpio_event(struct gpio_event_listener *gel,
+                    const struct gpio_event *ev)
+{
+    debounce_pin_t *d = (debounce_pin_t*)gpio_event_arg(gel);
+
+    /* edges queued before the irq got disabled belong to this debounce */
+    if (d->active) {
+        return;
+    }
+    d->edge_time = ev->ge_time;
+    debounce_trigger(d);
+}
+#endif
+
+
+#endif
 
 int
 debounce_init(debounce_pin_t *d, int pin, hal_gpio_pull_t pull, int timer)
@@ -76,13 +204,27 @@ debounce_init(debounce_pin_t *d, int pin, hal_gpio_pull_t pull, int timer)
     d->ticks = MYNEWT_VAL(DEBOUNCE_PARAM_TICKS);
     d->count = MYNEWT_VAL(DEBOUNCE_PARAM_COUNT);
 
+#if MYNEWT_VAL(DEBOUNCE_TIMESTAMP)
+    if (!debounce_timer_inited) {
+        os_cputime_timer_init(&debounce_timer, debounce_timer_cb, NULL);
+        debounce_timer_inited = true;
+    }
+#else
     if (hal_timer_set_cb(timer, &d->timer, debounce_check, d)) {
         return -1;
     }
+#endif
 
+#if MYNEWT_VAL(DEBOUNCE_GPIO_EVENT)
+    if (gpio_event_listener_init(&d->gel, pin, HAL_GPIO_TRIG_BOTH, pull,
+                                 debounce_gpio_event, d)) {
+        return -1;
+    }
+#else
     if (hal_gpio_irq_init(pin, debounce_trigger, d, HAL_GPIO_TRIG_BOTH, pull)) {
         return -1;
     }
+#endif
 
     if (hal_gpio_read(pin)) {
         d->state = 1;
@@ -122,7 +264,21 @@ debounce_start(debounce_pin_t *d,
 int
 debounce_stop(debounce_pin_t *d)
 {
+#if MYNEWT_VAL(DEBOUNCE_TIMESTAMP)
+    os_sr_t sr;
+
+    hal_gpio_irq_disable(d->pin);
+    OS_ENTER_CRITICAL(sr);
+    if (d->active) {
+        SLIST_REMOVE(&debounce_bouncing, d, debounce_pin, next);
+        debounce_timer_arm();
+    }
+    d->active = 0;
+    OS_EXIT_CRITICAL(sr);
+#else
     hal_gpio_irq_disable(d->pin);
     hal_timer_stop(&d->timer);
+    d->active = 0;
+#endif
     return 0;
 }
@@ -35,6 +35,8 @@ struct spiflash_dev {
     int ss_pin;
     uint16_t sector_size;
     uint16_t page_size;
+    uint32_t erase_addr;            /** Sector of erase in progress */
+    uint8_t flags;
 };
 
 extern struct spiflash_dev spiflash_dev;
@@ -46,6 +48,8 @@ extern struct spiflash_dev spiflash_dev;
 #define SPIFLASH_WRITE_ENABLE               0x06
 #define SPIFLASH_FAST_READ                  0x0B
 #define SPIFLASH_SECTOR_ERASE               0x20
+#define SPIFLASH_ERASE_SUSPEND              0x75
+#define SPIFLASH_ERASE_RESUME               0x7A
 #define SPIFLASH_RELEASE_POWER_DOWN         0xAB
 #define SPIFLASH_READ_MANUFACTURER_ID       0x90
 #define SPIFLASH_READ_JEDEC_ID              0x9F
@@ -55,6 +59,14 @@ extern struct spiflash_dev spiflash_dev;
 
 int spiflash_init(const struct hal_flash *dev);
 
+/**
+ * Waits for a page program or sector erase started with SPIFLASH_ASYNC to
+ * complete.
+ *
+ * @return 0 on success, -1 on timeout.
+ */
+int spiflash_wait_idle(struct spiflash_dev *dev);
+
 #ifdef __cplusplus
 }
 #endif
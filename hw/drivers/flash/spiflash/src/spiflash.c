@@ -60,6 +60,12 @@
 #error SPIFLASH_BAUDRATE must be set to the correct value in bsp syscfg.yml
 #endif
 
+/* spiflash_dev.flags */
+#define SPIFLASH_F_ERASING      0x01    /* Erase started, not yet waited on */
+
+/* Status polls before SPIFLASH_WAIT_YIELD starts sleeping between polls */
+#define SPIFLASH_WAIT_SPIN_CNT  16
+
 static int spiflash_read(const struct hal_flash *hal_flash_dev, uint32_t addr,
         void *buf, uint32_t len);
 static int spiflash_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
@@ -186,17 +192,45 @@ spiflash_wait_ready(struct spiflash_dev *dev, uint32_t timeout_ms)
 {
     uint32_t ticks;
     os_time_t exp_time;
+#if MYNEWT_VAL(SPIFLASH_WAIT_YIELD)
+    int polls = 0;
+#endif
+
     os_time_ms_to_ticks(timeout_ms, &ticks);
     exp_time = os_time_get() + ticks;
 
     while (!spiflash_device_ready(dev)) {
-        if (os_time_get() > exp_time) {
+        if (OS_TIME_TICK_GT(os_time_get(), exp_time)) {
             return -1;
         }
+#if MYNEWT_VAL(SPIFLASH_WAIT_YIELD)
+        if (++polls > SPIFLASH_WAIT_SPIN_CNT) {
+            os_time_delay(1);
+        }
+#endif
     }
     return 0;
 }
 
+int
+spiflash_wait_idle(struct spiflash_dev *dev)
+{
+    uint32_t timeout_ms;
+
+    if (dev->flags & SPIFLASH_F_ERASING) {
+        timeout_ms = MYNEWT_VAL(SPIFLASH_SECTOR_ERASE_TIMEOUT_MS);
+    } else {
+        timeout_ms = 100;
+    }
+
+    if (spiflash_wait_ready(dev, timeout_ms) != 0) {
+        return -1;
+    }
+
+    dev->flags &= ~SPIFLASH_F_ERASING;
+    return 0;
+}
+
 int
 spiflash_write_enable(struct spiflash_dev *dev)
 {
@@ -209,32 +243,101 @@ spiflash_write_enable(struct spiflash_dev *dev)
     return 0;
 }
 
+static void
+spiflash_cmd(struct spiflash_dev *dev, uint8_t cmd)
+{
+    spiflash_cs_activate(dev);
+
+    hal_spi_tx_val(dev->spi_num, cmd);
+
+    spiflash_cs_deactivate(dev);
+}
+
+static void
+spiflash_read_data(struct spiflash_dev *dev, uint32_t addr, void *buf,
+        uint32_t len)
+{
+#if MYNEWT_VAL(SPIFLASH_FAST_READ)
+    /* Fast read takes one dummy byte after the address */
+    uint8_t cmd[] = { SPIFLASH_FAST_READ,
+        (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)(addr), 0xFF };
+#else
+    uint8_t cmd[] = { SPIFLASH_READ,
+        (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)(addr) };
+#endif
+
+    spiflash_cs_activate(dev);
+
+    /* Send command + address */
+    hal_spi_txrx(dev->spi_num, cmd, NULL, sizeof cmd);
+    /* For security mostly, do not output random data, fill it with FF */
+    memset(buf, 0xFF, len);
+    /* Tx buf does not matter, for simplicity pass read buffer */
+    hal_spi_txrx(dev->spi_num, buf, buf, len);
+
+    spiflash_cs_deactivate(dev);
+}
+
+#if MYNEWT_VAL(SPIFLASH_ERASE_SUSPEND)
+/**
+ * Reads from the chip while a sector erase is running, by suspending the
+ * erase for the duration of the read.
+ *
+ * @return 0 on success, -1 if the read has to wait for the erase instead.
+ */
+static int
+spiflash_read_suspended(struct spiflash_dev *dev, uint32_t addr, void *buf,
+        uint32_t len)
+{
+    uint32_t erase_end;
+
+    erase_end = dev->erase_addr + dev->sector_size;
+    if (addr < erase_end && addr + len > dev->erase_addr) {
+        /* Contents of the sector being erased are undefined */
+        return -1;
+    }
+
+    if (spiflash_device_ready(dev)) {
+        return -1;
+    }
+
+    spiflash_cmd(dev, SPIFLASH_ERASE_SUSPEND);
+
+    /* Suspend takes effect within tSUS, typically 20us */
+    if (spiflash_wait_ready(dev, 1) != 0) {
+        return -1;
+    }
+
+    spiflash_read_data(dev, addr, buf, len);
+
+    spiflash_cmd(dev, SPIFLASH_ERASE_RESUME);
+
+    return 0;
+}
+#endif
+
 int
 spiflash_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *buf,
         uint32_t len)
 {
     int err = 0;
-    uint8_t cmd[] = { SPIFLASH_READ,
-        (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)(addr) };
     struct spiflash_dev *dev;
 
     dev = (struct spiflash_dev *)hal_flash_dev;
 
-    err = spiflash_wait_ready(dev, 100);
-    if (!err) {
-        spiflash_cs_activate(dev);
-
-        /* Send command + address */
-        hal_spi_txrx(dev->spi_num, cmd, NULL, sizeof cmd);
-        /* For security mostly, do not output random data, fill it with FF */
-        memset(buf, 0xFF, len);
-        /* Tx buf does not matter, for simplicity pass read buffer */
-        hal_spi_txrx(dev->spi_num, buf, buf, len);
+#if MYNEWT_VAL(SPIFLASH_ERASE_SUSPEND)
+    if (dev->flags & SPIFLASH_F_ERASING &&
+        spiflash_read_suspended(dev, addr, buf, len) == 0) {
+        return 0;
+    }
+#endif
 
-        spiflash_cs_deactivate(dev);
+    err = spiflash_wait_idle(dev);
+    if (!err) {
+        spiflash_read_data(dev, addr, buf, len);
     }
 
-    return 0;
+    return err;
 }
 
 int
@@ -250,7 +353,7 @@ spiflash_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
     u8buf = (uint8_t *)buf;
 
     while (len) {
-        if (spiflash_wait_ready(dev, 100) != 0) {
+        if (spiflash_wait_idle(dev) != 0) {
             return -1;
         }
 
@@ -271,10 +374,12 @@ spiflash_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
         addr += to_write;
         u8buf += to_write;
         len -= to_write;
-
-        spiflash_wait_ready(dev, 100);
     }
 
+#if !MYNEWT_VAL(SPIFLASH_ASYNC)
+    spiflash_wait_ready(dev, 100);
+#endif
+
     return 0;
 }
 
@@ -288,7 +393,7 @@ spiflash_erase_sector(const struct hal_flash *hal_flash_dev,
 
     dev = (struct spiflash_dev *)hal_flash_dev;
 
-    if (spiflash_wait_ready(dev, 100) != 0) {
+    if (spiflash_wait_idle(dev) != 0) {
         return -1;
     }
 
@@ -302,9 +407,14 @@ spiflash_erase_sector(const struct hal_flash *hal_flash_dev,
 
     spiflash_cs_deactivate(dev);
 
-    spiflash_wait_ready(dev, 100);
+    dev->erase_addr = addr;
+    dev->flags |= SPIFLASH_F_ERASING;
 
+#if !MYNEWT_VAL(SPIFLASH_ASYNC)
+    return spiflash_wait_idle(dev);
+#else
     return 0;
+#endif
 }
 
 int
@@ -328,6 +438,7 @@ spiflash_init(const struct hal_flash *hal_flash_dev)
     uint8_t capacity;
 
     dev = (struct spiflash_dev *)hal_flash_dev;
+    dev->flags = 0;
 
     hal_gpio_init_out(dev->ss_pin, 1);
 
@@ -891,6 +891,61 @@ lp5523_set_output_curr_ctrl(struct led_itf *itf, uint8_t output, uint8_t curr_ct
 int lp5523_shell_init(void);
 #endif
 
+#if MYNEWT_VAL(LP5523_FRAME_BUFFER)
+/*
+ * Frame buffer for the PWM registers.  Outputs are set in RAM and a callout
+ * writes the changed span of PWM registers in a single auto-increment I2C
+ * burst, LP5523_REFRESH_RATE times per second at most.  Auto-increment must
+ * be enabled in the chip config (auto_inc_en).
+ */
+struct lp5523_fb {
+    struct led_itf *lf_itf;
+    struct os_callout lf_co;
+    os_time_t lf_period;
+    /* Bit n set if output n + 1 changed since the last refresh */
+    uint16_t lf_dirty;
+    uint8_t lf_pwm[9];
+};
+
+/**
+ * Initialize a frame buffer, all outputs start at 0.
+ *
+ * @param fb The frame buffer
+ * @param itf LED interface, must stay valid while the frame buffer is used
+ * @param evq Eventq the refresh runs on, NULL for the default eventq
+ */
+void lp5523_fb_init(struct lp5523_fb *fb, struct led_itf *itf,
+    struct os_eventq *evq);
+
+/**
+ * Set the PWM value of an output in the frame buffer.
+ *
+ * @param fb The frame buffer
+ * @param output Number of the output (1 - 9)
+ * @param pwm PWM value
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int lp5523_fb_set(struct lp5523_fb *fb, uint8_t output, uint8_t pwm);
+
+/**
+ * Write the changed outputs to the chip now.
+ *
+ * @param fb The frame buffer
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int lp5523_fb_flush(struct lp5523_fb *fb);
+
+/**
+ * Start/stop the periodic refresh.
+ *
+ * @param fb The frame buffer
+ */
+void lp5523_fb_start(struct lp5523_fb *fb);
+void lp5523_fb_stop(struct lp5523_fb *fb);
+#endif
+
 /* instructions
  *
  * programs look like:
@@ -141,9 +141,12 @@ lp5523_set_n_regs(struct led_itf *itf, enum lp5523_registers addr,
         .buffer = regs
     };
 
-    memcpy(regs, vals, len + 1);
+    if (len >= LP5523_MAX_PAYLOAD) {
+        return SYS_EINVAL;
+    }
 
     regs[0] = addr;
+    memcpy(&regs[1], vals, len);
 
     rc = led_itf_lock(itf, MYNEWT_VAL(LP5523_ITF_LOCK_TMO));
     if (rc) {
@@ -1080,3 +1083,95 @@ lp5523_config(struct led_itf *itf, struct lp5523_cfg *cfg)
 err:
     return rc;
 }
+
+#if MYNEWT_VAL(LP5523_FRAME_BUFFER)
+static void
+lp5523_fb_tick(struct os_event *ev)
+{
+    struct lp5523_fb *fb;
+
+    fb = ev->ev_arg;
+
+    lp5523_fb_flush(fb);
+    os_callout_reset(&fb->lf_co, fb->lf_period);
+}
+
+void
+lp5523_fb_init(struct lp5523_fb *fb, struct led_itf *itf,
+    struct os_eventq *evq)
+{
+    memset(fb, 0, sizeof(*fb));
+    fb->lf_itf = itf;
+    fb->lf_period = max(OS_TICKS_PER_SEC / MYNEWT_VAL(LP5523_REFRESH_RATE), 1);
+    os_callout_init(&fb->lf_co, evq ? evq : os_eventq_dflt_get(),
+                    lp5523_fb_tick, fb);
+}
+
+int
+lp5523_fb_set(struct lp5523_fb *fb, uint8_t output, uint8_t pwm)
+{
+    os_sr_t sr;
+
+    if ((output < 1) || (output > 9)) {
+        return -1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (fb->lf_pwm[output - 1] != pwm) {
+        fb->lf_pwm[output - 1] = pwm;
+        fb->lf_dirty |= 1 << (output - 1);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+int
+lp5523_fb_flush(struct lp5523_fb *fb)
+{
+    int rc;
+    int first;
+    int last;
+    uint16_t dirty;
+    uint8_t pwm[9];
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    dirty = fb->lf_dirty;
+    fb->lf_dirty = 0;
+    memcpy(pwm, fb->lf_pwm, sizeof(pwm));
+    OS_EXIT_CRITICAL(sr);
+
+    if (!dirty) {
+        return 0;
+    }
+
+    /* One burst covering every changed output, unchanged ones in between
+     * are rewritten with their current value */
+    first = __builtin_ctz(dirty);
+    last = 31 - __builtin_clz(dirty);
+
+    rc = lp5523_set_n_regs(fb->lf_itf, LP5523_PWM_BASE + first, &pwm[first],
+                           last - first + 1);
+    if (rc) {
+        /* Retry on the next refresh */
+        OS_ENTER_CRITICAL(sr);
+        fb->lf_dirty |= dirty;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    return rc;
+}
+
+void
+lp5523_fb_start(struct lp5523_fb *fb)
+{
+    os_callout_reset(&fb->lf_co, 0);
+}
+
+void
+lp5523_fb_stop(struct lp5523_fb *fb)
+{
+    os_callout_stop(&fb->lf_co);
+}
+#endif
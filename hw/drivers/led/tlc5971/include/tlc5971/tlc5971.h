@@ -192,12 +192,29 @@ struct tlc5971_dev {
     uint8_t                     control_data;
     uint8_t                     is_enabled;
     uint8_t                     data_packet[TLC5971_PACKET_LENGTH];
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+    struct os_callout           fb_co;
+    uint8_t                     fb_running;
+    volatile uint8_t            fb_dirty;
+    volatile uint8_t            fb_busy;
+#endif
 };
 
 int tlc5971_init(struct os_dev *dev, void *arg);
 int tlc5971_is_enabled(struct tlc5971_dev *dev);
 int tlc5971_write(struct tlc5971_dev *dev);
 void tlc5971_set_cfg(struct tlc5971_dev *dev, struct tlc5971_cfg *cfg);
+
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+/*
+ * Frame buffer mode: the grayscale, brightness and config values set on the
+ * device act as a frame buffer, and a callout sends them to the chip with a
+ * non-blocking SPI transfer at TLC5971_REFRESH_RATE, only when they changed.
+ * While running, tlc5971_write() just schedules the next refresh.
+ */
+int tlc5971_fb_start(struct tlc5971_dev *dev, struct os_eventq *evq);
+void tlc5971_fb_stop(struct tlc5971_dev *dev);
+#endif
 void tlc5971_get_cfg(struct tlc5971_dev *dev, struct tlc5971_cfg *cfg);
 void tlc5971_set_global_brightness(struct tlc5971_dev *dev,
                                    tlc5971_bc_channel_t bc_channel,
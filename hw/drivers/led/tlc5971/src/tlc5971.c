@@ -21,6 +21,25 @@
 #include "tlc5971/tlc5971.h"
 #include "hal/hal_spi.h"
 
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+static void
+tlc5971_fb_done(void *arg, int len)
+{
+    struct tlc5971_dev *dev;
+
+    dev = arg;
+    dev->fb_busy = 0;
+}
+
+static void
+tlc5971_fb_mark(struct tlc5971_dev *dev)
+{
+    dev->fb_dirty = 1;
+}
+#else
+#define tlc5971_fb_mark(dev)
+#endif
+
 /**
  * tlc5972 open
  *
@@ -54,6 +73,12 @@ tlc5971_open(struct os_dev *odev, uint32_t wait, void *arg)
     if (rc) {
         return rc;
     }
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+    rc = hal_spi_set_txrx_cb(spi_num, tlc5971_fb_done, dev);
+    if (rc) {
+        return rc;
+    }
+#endif
     hal_spi_enable(spi_num);
 
     dev->is_enabled = true;
@@ -76,6 +101,10 @@ tlc5971_close(struct os_dev *odev)
 
     dev = (struct tlc5971_dev *)odev;
 
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+    tlc5971_fb_stop(dev);
+#endif
+
     /* Disable the SPI */
     hal_spi_disable(dev->tlc_itf.tpi_spi_num);
 
@@ -160,6 +189,13 @@ tlc5971_write(struct tlc5971_dev *dev)
         return -1;
     }
 
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+    if (dev->fb_running) {
+        tlc5971_fb_mark(dev);
+        return 0;
+    }
+#endif
+
     /*
      * XXX: for now, disable interrupts around write as it is possible that
      * too long a gap will cause mis-program of device.
@@ -174,6 +210,89 @@ tlc5971_write(struct tlc5971_dev *dev)
     return rc;
 }
 
+#if MYNEWT_VAL(TLC5971_FRAME_BUFFER)
+/**
+ * tlc5971 frame buffer refresh
+ *
+ * Callout handler. Starts a non-blocking transfer of the current values if
+ * they changed since the last one and the previous transfer has finished.
+ * Unlike tlc5971_write() this does not need interrupts disabled; the SPI
+ * DMA sends the packet without gaps.
+ *
+ * @param ev Callout event
+ */
+static void
+tlc5971_fb_refresh(struct os_event *ev)
+{
+    int rc;
+    struct tlc5971_dev *dev;
+
+    dev = ev->ev_arg;
+
+    if (dev->fb_dirty && !dev->fb_busy) {
+        /* Cleared first so a concurrent change is picked up next time */
+        dev->fb_dirty = 0;
+        dev->fb_busy = 1;
+        tlc5971_construct_packet(dev);
+        rc = hal_spi_txrx_noblock(dev->tlc_itf.tpi_spi_num, dev->data_packet,
+                                  NULL, TLC5971_PACKET_LENGTH);
+        if (rc) {
+            dev->fb_busy = 0;
+            dev->fb_dirty = 1;
+        }
+    }
+
+    os_callout_reset(&dev->fb_co,
+                     max(OS_TICKS_PER_SEC / MYNEWT_VAL(TLC5971_REFRESH_RATE),
+                         1));
+}
+
+/**
+ * tlc5971 frame buffer start
+ *
+ * Start refreshing the device from its frame buffer. The device must be
+ * open. The current values are sent on the first refresh.
+ *
+ * @param dev Pointer to tlc5971 device
+ * @param evq Eventq to run the refresh on, NULL for the default eventq
+ *
+ * @return int 0: success; -1 device not open
+ */
+int
+tlc5971_fb_start(struct tlc5971_dev *dev, struct os_eventq *evq)
+{
+    if (!dev->is_enabled) {
+        return -1;
+    }
+
+    if (!dev->fb_running) {
+        os_callout_init(&dev->fb_co, evq ? evq : os_eventq_dflt_get(),
+                        tlc5971_fb_refresh, dev);
+        dev->fb_running = 1;
+        dev->fb_dirty = 1;
+        os_callout_reset(&dev->fb_co, 0);
+    }
+
+    return 0;
+}
+
+/**
+ * tlc5971 frame buffer stop
+ *
+ * Stop the periodic refresh. A transfer already started still completes.
+ *
+ * @param dev Pointer to tlc5971 device
+ */
+void
+tlc5971_fb_stop(struct tlc5971_dev *dev)
+{
+    if (dev->fb_running) {
+        os_callout_stop(&dev->fb_co);
+        dev->fb_running = 0;
+    }
+}
+#endif
+
 /**
  * tlc5971 set global brightness
  *
@@ -207,6 +326,8 @@ tlc5971_set_global_brightness(struct tlc5971_dev *dev,
         dev->bc.bc_blue = brightness;
         break;
     }
+
+    tlc5971_fb_mark(dev);
 }
 
 /**
@@ -237,6 +358,8 @@ tlc5971_set_channel_rgb(struct tlc5971_dev *dev, tlc5971_channel_t channel,
         dev->gs[channel].gs_green = green;
         dev->gs[channel].gs_blue = blue;
     }
+
+    tlc5971_fb_mark(dev);
 }
 
 /**
@@ -251,6 +374,8 @@ void
 tlc5971_set_cfg(struct tlc5971_dev *dev, struct tlc5971_cfg *cfg)
 {
     dev->control_data = cfg->tlc_ctrl_data;
+
+    tlc5971_fb_mark(dev);
 }
 
 /**
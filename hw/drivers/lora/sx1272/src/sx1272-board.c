@@ -64,7 +64,9 @@ const struct Radio_s Radio =
     SX1272SetMaxPayloadLength,
     SX1272SetPublicNetwork,
     SX1272GetWakeupTime,
-    SX1272RxDisable
+    SX1272RxDisable,
+    SX1272SetEventq,
+    SX1272GetIrqTime
 };
 
 void
@@ -1224,6 +1224,22 @@ SX1272OnTimeoutIrq(void *unused)
     }
 }
 
+/*!
+ * LORA_MAC_TIMER_NUM ticks at which the last DIO0 interrupt fired
+ */
+static uint32_t Dio0IrqTime;
+
+void
+SX1272SetEventq(struct os_eventq *evq)
+{
+}
+
+uint32_t
+SX1272GetIrqTime(void)
+{
+    return Dio0IrqTime;
+}
+
 void
 SX1272OnDio0Irq(void *unused)
 {
@@ -1231,6 +1247,8 @@ SX1272OnDio0Irq(void *unused)
     int16_t rssi;
     int8_t snr;
 
+    Dio0IrqTime = hal_timer_read(SX1272_TIMER_NUM);
+
     switch (SX1272.Settings.State) {
         case RF_RX_RUNNING:
             //TimerStop(&RxTimeoutTimer);
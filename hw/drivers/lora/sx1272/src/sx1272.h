@@ -400,4 +400,16 @@ uint32_t SX1272GetWakeupTime(void);
 
 void SX1272RxDisable(void);
 
+/*!
+ * \brief DIO interrupts are handled in place; the event queue is ignored
+ */
+void SX1272SetEventq(struct os_eventq *evq);
+
+/*!
+ * \brief Gets the time at which the last DIO0 interrupt fired
+ *
+ * \retval time LORA_MAC_TIMER_NUM ticks
+ */
+uint32_t SX1272GetIrqTime(void);
+
 #endif // __SX1272_H__
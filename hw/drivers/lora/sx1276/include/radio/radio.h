@@ -26,6 +26,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+struct os_eventq;
+
 /*!
  * Radio driver supported modems
  */
@@ -346,6 +348,23 @@ struct Radio_s
      *
      */
     void  ( *RxDisable )( void );
+
+    /*!
+     * \brief Sets the event queue the driver defers interrupt work to.
+     *        Drivers that handle interrupts in place ignore it.
+     *
+     * \param [IN] evq Event queue; NULL selects the default event queue
+     */
+    void  ( *SetEventq )( struct os_eventq *evq );
+
+    /*!
+     * \brief Gets the time at which the radio interrupt currently being
+     *        handled fired. Only valid from within the RadioEvents_t
+     *        callbacks.
+     *
+     * \retval time LORA_MAC_TIMER_NUM ticks
+     */
+    uint32_t  ( *GetIrqTime )( void );
 };
 
 /*!
@@ -56,9 +56,41 @@ const struct Radio_s Radio =
     .SetMaxPayloadLength = SX1276SetMaxPayloadLength,
     .SetPublicNetwork = SX1276SetPublicNetwork,
     .GetWakeupTime = SX1276GetWakeupTime,
-    .RxDisable = SX1276RxDisable
+    .RxDisable = SX1276RxDisable,
+    .SetEventq = SX1276SetEventq,
+    .GetIrqTime = SX1276GetIrqTime
 };
 
+#if MYNEWT_VAL(SX1276_SPI_NOBLOCK)
+static struct os_sem SpiXferSem;
+
+static void
+SX1276SpiTxrxCb(void *arg, int len)
+{
+    os_sem_release(&SpiXferSem);
+}
+#endif
+
+void
+SX1276SpiXfer(uint8_t *txbuf, uint8_t *rxbuf, int len)
+{
+#if MYNEWT_VAL(SX1276_SPI_NOBLOCK)
+    os_time_t ticks;
+    int rc;
+
+    rc = hal_spi_txrx_noblock(RADIO_SPI_IDX, txbuf, rxbuf, len);
+    assert(rc == 0);
+
+    os_time_ms_to_ticks(MYNEWT_VAL(SX1276_SPI_XFER_TIMEOUT_MS), &ticks);
+    if (os_sem_pend(&SpiXferSem, ticks) != OS_OK) {
+        hal_spi_abort(RADIO_SPI_IDX);
+        assert(0);
+    }
+#else
+    hal_spi_txrx(RADIO_SPI_IDX, txbuf, rxbuf, len);
+#endif
+}
+
 void
 SX1276IoInit(void)
 {
@@ -83,6 +115,13 @@ SX1276IoInit(void)
     rc = hal_spi_config(RADIO_SPI_IDX, &spi_settings);
     assert(rc == 0);
 
+#if MYNEWT_VAL(SX1276_SPI_NOBLOCK)
+    os_sem_init(&SpiXferSem, 0);
+    hal_spi_set_txrx_cb(RADIO_SPI_IDX, SX1276SpiTxrxCb, NULL);
+#else
+    hal_spi_set_txrx_cb(RADIO_SPI_IDX, NULL, NULL);
+#endif
+
     rc = hal_spi_enable(RADIO_SPI_IDX);
     assert(rc == 0);
 }
@@ -93,42 +132,42 @@ SX1276IoIrqInit(DioIrqHandler **irqHandlers)
     int rc;
 
     if (irqHandlers[0] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO0, irqHandlers[0], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO0, irqHandlers[0], (void *)0,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO0);
     }
 
     if (irqHandlers[1] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO1, irqHandlers[1], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO1, irqHandlers[1], (void *)1,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO1);
     }
 
     if (irqHandlers[2] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO2, irqHandlers[2], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO2, irqHandlers[2], (void *)2,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO2);
     }
 
     if (irqHandlers[3] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO3, irqHandlers[3], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO3, irqHandlers[3], (void *)3,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO3);
     }
 
     if (irqHandlers[4] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO4, irqHandlers[4], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO4, irqHandlers[4], (void *)4,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO4);
     }
 
     if (irqHandlers[5] != NULL) {
-        rc = hal_gpio_irq_init(SX1276_DIO5, irqHandlers[5], NULL,
+        rc = hal_gpio_irq_init(SX1276_DIO5, irqHandlers[5], (void *)5,
                                HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
         assert(rc == 0);
         hal_gpio_irq_enable(SX1276_DIO5);
@@ -57,8 +57,21 @@ Maintainer: Miguel Luis and Gregory Cristian
  */
 void SX1276IoInit(void);
 
+/*!
+ * \brief Initializes the DIO interrupts.  Each handler is passed its DIO
+ *        number as argument.
+ */
 void SX1276IoIrqInit(DioIrqHandler **irqHandlers);
 
+/*!
+ * \brief Moves a buffer over SPI in one transfer. NSS must already be low.
+ *
+ * \param [IN]  txbuf Data to send
+ * \param [OUT] rxbuf Received data; may be txbuf or NULL
+ * \param [IN]  len   Number of bytes
+ */
+void SX1276SpiXfer(uint8_t *txbuf, uint8_t *rxbuf, int len);
+
 /*!
  * \brief De-initializes the radio I/Os pins interface.
  *
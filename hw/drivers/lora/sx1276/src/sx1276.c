@@ -209,11 +209,38 @@ static uint8_t RxTxBuffer[RX_BUFFER_SIZE];
 SX1276_t SX1276;
 
 /*!
- * Hardware DIO IRQ callback initialization
+ * DIO IRQ work, indexed by DIO number
  */
-DioIrqHandler *DioIrq[] = { SX1276OnDio0Irq, SX1276OnDio1Irq,
-                            SX1276OnDio2Irq, SX1276OnDio3Irq,
-                            SX1276OnDio4Irq, NULL };
+static DioIrqHandler *DioWork[] = { SX1276OnDio0Irq, SX1276OnDio1Irq,
+                                    SX1276OnDio2Irq, SX1276OnDio3Irq,
+                                    SX1276OnDio4Irq };
+
+static void SX1276OnDioIsr(void *arg);
+
+/*!
+ * Hardware DIO IRQ callback initialization.  The board passes the DIO
+ * number as the handler argument.
+ */
+DioIrqHandler *DioIrq[] = { SX1276OnDioIsr, SX1276OnDioIsr,
+                            SX1276OnDioIsr, SX1276OnDioIsr,
+                            SX1276OnDioIsr, NULL };
+
+/*!
+ * LORA_MAC_TIMER_NUM ticks at which each DIO interrupt last fired, and at
+ * which the interrupt currently being handled fired.
+ */
+static uint32_t DioIrqTime[5];
+static uint32_t IrqTime;
+
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+/*!
+ * Interrupt work is deferred to this queue; see SX1276SetEventq()
+ */
+static struct os_eventq *SX1276Evq;
+static struct os_event DioEvent[5];
+static struct os_event TimeoutEvent;
+static uint32_t TimeoutIrqTime;
+#endif
 
 /*!
  * Tx and Rx timers
@@ -224,6 +251,76 @@ struct hal_timer RxTimeoutSyncWord;
 
 static uint32_t rx_timeout_sync_delay = -1;
 
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+static struct os_eventq *
+SX1276GetEvq(void)
+{
+    if (SX1276Evq == NULL) {
+        return os_eventq_dflt_get();
+    }
+    return SX1276Evq;
+}
+
+static void
+SX1276DioEvent(struct os_event *ev)
+{
+    int dio;
+
+    dio = (int)(intptr_t)ev->ev_arg;
+    IrqTime = DioIrqTime[dio];
+    DioWork[dio](NULL);
+}
+
+static void
+SX1276TimeoutEvent(struct os_event *ev)
+{
+    IrqTime = TimeoutIrqTime;
+    SX1276OnTimeoutIrq(NULL);
+}
+
+static void
+SX1276OnTimeoutIsr(void *unused)
+{
+    TimeoutIrqTime = hal_timer_read(SX1276_TIMER_NUM);
+    os_eventq_put(SX1276GetEvq(), &TimeoutEvent);
+}
+
+/*
+ * Drops interrupt work that has not run yet.  Called whenever the radio
+ * state is reset, so work from a previous operation cannot act on the
+ * next one.
+ */
+static void
+SX1276CancelDeferred(void)
+{
+    int i;
+
+    for (i = 0; i < sizeof(DioEvent) / sizeof(DioEvent[0]); i++) {
+        os_eventq_remove(SX1276GetEvq(), &DioEvent[i]);
+    }
+    os_eventq_remove(SX1276GetEvq(), &TimeoutEvent);
+}
+#endif
+
+/*
+ * Only timestamps the interrupt; with SX1276_DIO_DEFER the radio work is
+ * done from the event queue instead of interrupt context.
+ */
+static void
+SX1276OnDioIsr(void *arg)
+{
+    int dio;
+
+    dio = (int)(intptr_t)arg;
+    DioIrqTime[dio] = hal_timer_read(SX1276_TIMER_NUM);
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    os_eventq_put(SX1276GetEvq(), &DioEvent[dio]);
+#else
+    IrqTime = DioIrqTime[dio];
+    DioWork[dio](NULL);
+#endif
+}
+
 double
 ceil(double d)
 {
@@ -298,10 +395,23 @@ SX1276Init(RadioEvents_t *events)
 
     RadioEvents = events;
 
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    for (i = 0; i < sizeof(DioEvent) / sizeof(DioEvent[0]); i++) {
+        DioEvent[i].ev_cb = SX1276DioEvent;
+        DioEvent[i].ev_arg = (void *)(intptr_t)i;
+    }
+    TimeoutEvent.ev_cb = SX1276TimeoutEvent;
+
+    // Initialize driver timeout timers. NOTE: assumes timer configured.
+    hal_timer_set_cb(SX1276_TIMER_NUM, &TxTimeoutTimer, SX1276OnTimeoutIsr, NULL);
+    hal_timer_set_cb(SX1276_TIMER_NUM, &RxTimeoutTimer, SX1276OnTimeoutIsr, NULL);
+    hal_timer_set_cb(SX1276_TIMER_NUM, &RxTimeoutSyncWord, SX1276OnTimeoutIsr, NULL);
+#else
     // Initialize driver timeout timers. NOTE: assumes timer configured.
     hal_timer_set_cb(SX1276_TIMER_NUM, &TxTimeoutTimer, SX1276OnTimeoutIrq, NULL);
     hal_timer_set_cb(SX1276_TIMER_NUM, &RxTimeoutTimer, SX1276OnTimeoutIrq, NULL);
     hal_timer_set_cb(SX1276_TIMER_NUM, &RxTimeoutSyncWord, SX1276OnTimeoutIrq, NULL);
+#endif
 
     SX1276IoInit();
     SX1276IoIrqInit(DioIrq);
@@ -770,78 +880,68 @@ SX1276SetTxConfig(RadioModems_t modem, int8_t power, uint32_t fdev,
     }
 }
 
+/*
+ * Time on air in msecs.  Computed in integer usecs: the LoRa symbol time
+ * is exact for the supported bandwidths, so this matches the formula from
+ * the datasheet without needing floating point.
+ */
 uint32_t
 SX1276GetTimeOnAir(RadioModems_t modem, uint8_t pktLen)
 {
     uint32_t airtime;
-    double bw;
+    uint32_t bits;
+    uint32_t bw_khz;
+    uint32_t ts;
+    int32_t num;
+    int32_t den;
+    int32_t nsym;
+    uint8_t sf;
 
     switch (modem) {
     case MODEM_FSK:
-        airtime = round((8 * (SX1276.Settings.Fsk.PreambleLen +
-                                 ((SX1276Read(REG_SYNCCONFIG) & ~RF_SYNCCONFIG_SYNCSIZE_MASK) + 1) +
-                                 ((SX1276.Settings.Fsk.FixLen == 0x01) ? 0.0 : 1.0) +
-                                 (((SX1276Read(REG_PACKETCONFIG1) & ~RF_PACKETCONFIG1_ADDRSFILTERING_MASK) != 0x00) ? 1.0 : 0) +
-                                 pktLen +
-                                 ((SX1276.Settings.Fsk.CrcOn == 0x01) ? 2.0 : 0)) /
-                                 SX1276.Settings.Fsk.Datarate) * 1e3);
+        bits = 8 * (SX1276.Settings.Fsk.PreambleLen +
+                    ((SX1276Read(REG_SYNCCONFIG) & ~RF_SYNCCONFIG_SYNCSIZE_MASK) + 1) +
+                    ((SX1276.Settings.Fsk.FixLen == 0x01) ? 0 : 1) +
+                    (((SX1276Read(REG_PACKETCONFIG1) & ~RF_PACKETCONFIG1_ADDRSFILTERING_MASK) != 0x00) ? 1 : 0) +
+                    pktLen +
+                    ((SX1276.Settings.Fsk.CrcOn == 0x01) ? 2 : 0));
+        // Rounded to the nearest msec
+        airtime = (bits * 1000 + SX1276.Settings.Fsk.Datarate / 2) /
+                  SX1276.Settings.Fsk.Datarate;
         break;
     case MODEM_LORA:
         // REMARK: When using LoRa modem only bandwidths 125, 250 and 500 kHz are supported
         switch (SX1276.Settings.LoRa.Bandwidth) {
-        //case 0: // 7.8 kHz
-        //    bw = 78e2;
-        //    break;
-        //case 1: // 10.4 kHz
-        //    bw = 104e2;
-        //    break;
-        //case 2: // 15.6 kHz
-        //    bw = 156e2;
-        //    break;
-        //case 3: // 20.8 kHz
-        //    bw = 208e2;
-        //    break;
-        //case 4: // 31.2 kHz
-        //    bw = 312e2;
-        //    break;
-        //case 5: // 41.4 kHz
-        //    bw = 414e2;
-        //    break;
-        //case 6: // 62.5 kHz
-        //    bw = 625e2;
-        //    break;
         case 7: // 125 kHz
-            bw = 125000;
+            bw_khz = 125;
             break;
         case 8: // 250 kHz
-            bw = 250000;
+            bw_khz = 250;
             break;
         case 9: // 500 kHz
-            bw = 500000;
+            bw_khz = 500;
             break;
         default:
-            bw = 0;
-            break;
+            return 0;
         }
 
-        // Symbol rate : time for one symbol (secs)
-        double rs = bw / (1 << SX1276.Settings.LoRa.Datarate);
-        double ts = 1 / rs;
-        // time of preamble
-        double tPreamble = (SX1276.Settings.LoRa.PreambleLen + 4.25) * ts;
-        // Symbol length of payload and time
-        double tmp = ceil((8 * pktLen - 4 * SX1276.Settings.LoRa.Datarate +
-                             28 + 16 * SX1276.Settings.LoRa.CrcOn -
-                             (SX1276.Settings.LoRa.FixLen ? 20 : 0)) /
-                             (double)(4 * (SX1276.Settings.LoRa.Datarate -
-                             ((SX1276.Settings.LoRa.LowDatarateOptimize > 0) ? 2 : 0)))) *
-                             (SX1276.Settings.LoRa.Coderate + 4);
-        double nPayload = 8 + ((tmp > 0) ? tmp : 0);
-        double tPayload = nPayload * ts;
-        // Time on air
-        double tOnAir = tPreamble + tPayload;
-        // return ms secs
-        airtime = floor(tOnAir * 1000 + 0.999);
+        sf = SX1276.Settings.LoRa.Datarate;
+        // Symbol time (usecs)
+        ts = ((uint32_t)1 << sf) * 1000 / bw_khz;
+        // Symbol length of payload, rounded up
+        num = 8 * pktLen - 4 * sf + 28 + 16 * SX1276.Settings.LoRa.CrcOn -
+              (SX1276.Settings.LoRa.FixLen ? 20 : 0);
+        den = 4 * (sf - ((SX1276.Settings.LoRa.LowDatarateOptimize > 0) ? 2 : 0));
+        nsym = num / den;
+        if (num > 0 && num % den) {
+            nsym++;
+        }
+        nsym = (nsym > 0) ? nsym * (SX1276.Settings.LoRa.Coderate + 4) : 0;
+        // Preamble of PreambleLen + 4.25 symbols, then 8 + nsym symbols
+        airtime = ((SX1276.Settings.LoRa.PreambleLen * 4 + 17) * ts) / 4 +
+                  (8 + nsym) * ts;
+        // return ms secs, rounded up
+        airtime = (airtime + 999) / 1000;
         break;
     default:
         airtime = 0;
@@ -915,6 +1015,9 @@ SX1276SetSleep(void)
 {
     hal_timer_stop(&RxTimeoutTimer);
     hal_timer_stop(&TxTimeoutTimer);
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    SX1276CancelDeferred();
+#endif
 
     SX1276SetOpMode(RF_OPMODE_SLEEP);
     SX1276.Settings.State = RF_IDLE;
@@ -925,6 +1028,9 @@ SX1276SetStby(void)
 {
     hal_timer_stop(&RxTimeoutTimer);
     hal_timer_stop(&TxTimeoutTimer);
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    SX1276CancelDeferred();
+#endif
 
     SX1276SetOpMode(RF_OPMODE_STANDBY);
     SX1276.Settings.State = RF_IDLE;
@@ -1052,6 +1158,9 @@ SX1276SetRx(uint32_t timeout)
 
     memset(RxTxBuffer, 0, (size_t)RX_BUFFER_SIZE);
 
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    SX1276CancelDeferred();
+#endif
     SX1276.Settings.State = RF_RX_RUNNING;
     if (timeout != 0) {
         hal_timer_stop(&RxTimeoutTimer);
@@ -1129,6 +1238,9 @@ SX1276SetTx(uint32_t timeout)
         break;
     }
 
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    SX1276CancelDeferred();
+#endif
     SX1276.Settings.State = RF_TX_RUNNING;
     hal_timer_stop(&TxTimeoutTimer);
     hal_timer_start(&TxTimeoutTimer, timeout * 1000);
@@ -1265,13 +1377,13 @@ SX1276Read(uint16_t addr)
 void
 SX1276WriteBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
 {
-    uint8_t i;
-
     hal_gpio_write(RADIO_NSS, 0);
 
     hal_spi_tx_val(RADIO_SPI_IDX, addr | 0x80);
-    for(i = 0; i < size; i++) {
-        hal_spi_tx_val(RADIO_SPI_IDX, buffer[i]);
+    if (size == 1) {
+        hal_spi_tx_val(RADIO_SPI_IDX, buffer[0]);
+    } else if (size > 1) {
+        SX1276SpiXfer(buffer, NULL, size);
     }
 
     hal_gpio_write(RADIO_NSS, 1);
@@ -1280,13 +1392,15 @@ SX1276WriteBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
 void
 SX1276ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
 {
-    uint8_t i;
-
     hal_gpio_write(RADIO_NSS, 0);
 
     hal_spi_tx_val(RADIO_SPI_IDX, addr & 0x7f);
-    for (i = 0; i < size; i++) {
-        buffer[i] = hal_spi_tx_val(RADIO_SPI_IDX, 0);
+    if (size == 1) {
+        buffer[0] = hal_spi_tx_val(RADIO_SPI_IDX, 0);
+    } else if (size > 1) {
+        // Clock out zeros from the buffer being read into
+        memset(buffer, 0, size);
+        SX1276SpiXfer(buffer, buffer, size);
     }
 
     hal_gpio_write(RADIO_NSS, 1);
@@ -1341,6 +1455,20 @@ SX1276GetWakeupTime(void)
     return SX1276GetBoardTcxoWakeupTime( ) + RADIO_WAKEUP_TIME;
 }
 
+void
+SX1276SetEventq(struct os_eventq *evq)
+{
+#if MYNEWT_VAL(SX1276_DIO_DEFER)
+    SX1276Evq = evq;
+#endif
+}
+
+uint32_t
+SX1276GetIrqTime(void)
+{
+    return IrqTime;
+}
+
 void
 SX1276OnTimeoutIrq(void *unused)
 {
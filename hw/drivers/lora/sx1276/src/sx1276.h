@@ -396,4 +396,18 @@ uint32_t SX1276GetWakeupTime(void);
 
 void SX1276RxDisable(void);
 
+/*!
+ * \brief Sets the event queue interrupt work is deferred to
+ *
+ * \param [IN] evq Event queue; NULL selects the default event queue
+ */
+void SX1276SetEventq(struct os_eventq *evq);
+
+/*!
+ * \brief Gets the time at which the interrupt being handled fired
+ *
+ * \retval time LORA_MAC_TIMER_NUM ticks
+ */
+uint32_t SX1276GetIrqTime(void);
+
 #endif // __SX1276_H__
@@ -59,8 +59,8 @@
 #define SMSC_8710_ISR_AUTO_DONE 0x40
 #define SMSC_8710_ISR_LINK_DOWN 0x10
 
-#define STM32_ETH_RX_DESC_SZ 3
-#define STM32_ETH_TX_DESC_SZ 4
+#define STM32_ETH_RX_DESC_SZ MYNEWT_VAL(STM32_ETH_RX_DESC_CNT)
+#define STM32_ETH_TX_DESC_SZ MYNEWT_VAL(STM32_ETH_TX_DESC_CNT)
 
 struct stm32_eth_desc {
     volatile ETH_DMADescTypeDef desc;
@@ -90,6 +90,19 @@ struct stm32_eth_stats {
 
 static struct stm32_eth_state stm32_eth_state;
 
+#if MYNEWT_VAL(STM32_ETH_RX_TASK)
+static void stm32_eth_rx_poll(struct os_event *ev);
+
+static struct os_task stm32_eth_task;
+OS_TASK_STACK_DEFINE(stm32_eth_stack,
+                     MYNEWT_VAL(STM32_ETH_RX_TASK_STACK_SIZE));
+static struct os_eventq stm32_eth_evq;
+static struct os_event stm32_eth_rx_ev = {
+    .ev_cb = stm32_eth_rx_poll,
+    .ev_arg = &stm32_eth_state,
+};
+#endif
+
 static void
 stm32_eth_setup_descs(struct stm32_eth_desc *descs, int cnt)
 {
@@ -122,6 +135,10 @@ stm32_eth_fill_rx(struct stm32_eth_state *ses)
         sed->p = p;
         sed->desc.Status = 0;
         sed->desc.ControlBufferSize = ETH_DMARXDESC_RCH | ETH_MAX_PACKET_SIZE;
+#if MYNEWT_VAL(STM32_ETH_RX_INT_WDT)
+        /* interrupt comes from the receive watchdog */
+        sed->desc.ControlBufferSize |= ETH_DMARXDESC_DIC;
+#endif
         sed->desc.Buffer1Addr = (uint32_t)p->payload;
         sed->desc.Status = ETH_DMARXDESC_OWN;
 
@@ -132,16 +149,21 @@ stm32_eth_fill_rx(struct stm32_eth_state *ses)
     }
 }
 
-static void
-stm32_eth_input(struct stm32_eth_state *ses)
+/*
+ * Passes up to budget received frames to lwIP, and refills the ring.
+ * Returns the number of descriptors consumed.
+ */
+static int
+stm32_eth_input(struct stm32_eth_state *ses, int budget)
 {
     struct stm32_eth_desc *sed;
     struct pbuf *p;
     struct netif *nif;
+    int cnt;
 
     nif = &ses->st_nif;
 
-    while (1) {
+    for (cnt = 0; cnt < budget; cnt++) {
         sed = &ses->st_rx_descs[ses->st_rx_head];
         if (!sed->p) {
             break;
@@ -151,6 +173,10 @@ stm32_eth_input(struct stm32_eth_state *ses)
         }
         p = sed->p;
         sed->p = NULL;
+        ses->st_rx_head++;
+        if (ses->st_rx_head >= STM32_ETH_RX_DESC_SZ) {
+            ses->st_rx_head = 0;
+        }
         if (!(sed->desc.Status & ETH_DMARXDESC_LS)) {
             /*
              * Incoming data spans multiple pbufs. XXX support later
@@ -161,10 +187,6 @@ stm32_eth_input(struct stm32_eth_state *ses)
         p->len = p->tot_len = (sed->desc.Status & ETH_DMARXDESC_FL) >> 16;
         ++stm32_eth_stats.iframe;
         nif->input(p, nif);
-        ses->st_rx_head++;
-        if (ses->st_rx_head >= STM32_ETH_RX_DESC_SZ) {
-            ses->st_rx_head = 0;
-        }
     }
 
     stm32_eth_fill_rx(ses);
@@ -176,12 +198,48 @@ stm32_eth_input(struct stm32_eth_state *ses)
         ses->st_eth.Instance->DMASR = ETH_DMASR_RBUS;
         ses->st_eth.Instance->DMARPDR = 0;
     }
+    return cnt;
+}
+
+#if MYNEWT_VAL(STM32_ETH_RX_TASK)
+static void
+stm32_eth_rx_poll(struct os_event *ev)
+{
+    struct stm32_eth_state *ses = ev->ev_arg;
+
+    if (stm32_eth_input(ses, MYNEWT_VAL(STM32_ETH_RX_BUDGET)) ==
+        MYNEWT_VAL(STM32_ETH_RX_BUDGET)) {
+        /*
+         * Possibly more to do; let others run first.
+         */
+        os_eventq_put(&stm32_eth_evq, ev);
+    } else {
+        /*
+         * Ring drained. Frames which arrived after the check leave
+         * the RX status bit set, and interrupt as soon as it's unmasked.
+         */
+        __HAL_ETH_DMA_ENABLE_IT(&ses->st_eth, ETH_DMA_IT_R);
+    }
+}
+
+static void
+stm32_eth_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&stm32_eth_evq);
+    }
 }
+#endif
 
 void
 HAL_ETH_RxCpltCallback(ETH_HandleTypeDef *heth)
 {
-    stm32_eth_input(&stm32_eth_state);
+#if MYNEWT_VAL(STM32_ETH_RX_TASK)
+    __HAL_ETH_DMA_DISABLE_IT(heth, ETH_DMA_IT_R);
+    os_eventq_put(&stm32_eth_evq, &stm32_eth_rx_ev);
+#else
+    stm32_eth_input(&stm32_eth_state, STM32_ETH_RX_DESC_SZ);
+#endif
 }
 
 /*
@@ -262,7 +320,7 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
         if (!q->len) {
             continue;
         }
-        if (sed->desc.Status & ETH_DMATXDESC_OWN) {
+        if (sed->p || sed->desc.Status & ETH_DMATXDESC_OWN) {
             /*
              * Not enough space.
              */
@@ -279,6 +337,9 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
         sed = &ses->st_tx_descs[ses->st_tx_head];
         if (q == p) {
             reg = ETH_DMATXDESC_FS | ETH_DMATXDESC_TCH;
+#if MYNEWT_VAL(STM32_ETH_CSUM_OFFLOAD)
+            reg |= ETH_DMATXDESC_CIC_TCPUDPICMP_FULL;
+#endif
         } else {
             reg = ETH_DMATXDESC_TCH;
         }
@@ -286,10 +347,10 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
             reg |= ETH_DMATXDESC_LS;
         }
         sed->desc.Status = reg;
-        sed->desc.ControlBufferSize = p->len;
-        sed->desc.Buffer1Addr = (uint32_t)p->payload;
-        sed->p = p;
-        pbuf_ref(p);
+        sed->desc.ControlBufferSize = q->len;
+        sed->desc.Buffer1Addr = (uint32_t)q->payload;
+        sed->p = q;
+        pbuf_ref(q);
         sed->desc.Status = reg | ETH_DMATXDESC_OWN;
         ses->st_tx_head++;
         if (ses->st_tx_head >= STM32_ETH_TX_DESC_SZ) {
@@ -368,6 +429,9 @@ stm32_lwip_init(struct netif *nif)
     nif->mtu = 1500;
     nif->hwaddr_len = ETHARP_HWADDR_LEN;
     nif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+#if MYNEWT_VAL(STM32_ETH_CSUM_OFFLOAD)
+    NETIF_SET_CHECKSUM_CTRL(nif, NETIF_CHECKSUM_DISABLE_ALL);
+#endif
 
 #if LWIP_IGMP
     nif->flags |= NETIF_FLAG_IGMP;
@@ -429,6 +493,9 @@ stm32_lwip_init(struct netif *nif)
     ses->st_eth.Instance->MACFFR |= ETH_MULTICASTFRAMESFILTER_NONE;
     ses->st_eth.Instance->DMATDLAR = (uint32_t)ses->st_tx_descs;
     ses->st_eth.Instance->DMARDLAR = (uint32_t)ses->st_rx_descs;
+#if MYNEWT_VAL(STM32_ETH_RX_INT_WDT)
+    ses->st_eth.Instance->DMARSWTR = MYNEWT_VAL(STM32_ETH_RX_INT_WDT);
+#endif
 
     /*
      * Generate an interrupt when link state changes
@@ -517,6 +584,15 @@ stm32_eth_open(void)
         return -1;
     }
 
+#if MYNEWT_VAL(STM32_ETH_RX_TASK)
+    os_eventq_init(&stm32_eth_evq);
+    rc = os_task_init(&stm32_eth_task, "eth", stm32_eth_task_handler, NULL,
+                      MYNEWT_VAL(STM32_ETH_RX_TASK_PRIO), OS_WAIT_FOREVER,
+                      stm32_eth_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(STM32_ETH_RX_TASK_STACK_SIZE)));
+    assert(rc == 0);
+#endif
+
     if (ses->cfg->sec_phy_irq >= 0) {
         rc = hal_gpio_irq_init(ses->cfg->sec_phy_irq, stm32_phy_isr, ses,
                                HAL_GPIO_TRIG_FALLING, HAL_GPIO_PULL_UP);
@@ -22,6 +22,7 @@
 #include <disk/disk.h>
 #include <mmc/mmc.h>
 #include <stdio.h>
+#include <string.h>
 
 #define MIN(n, m) (((n) < (m)) ? (n) : (m))
 
@@ -37,6 +38,7 @@
 #define CMD25               (25)           /* WRITE_MULTIPLE_BLOCK */
 #define CMD55               (55)           /* APP_CMD */
 #define CMD58               (58)           /* READ_OCR */
+#define ACMD23              (0x80 + 23)    /* SET_WR_BLK_ERASE_COUNT (SDC) */
 #define ACMD41              (0x80 + 41)    /* SEND_OP_COND (SDC) */
 
 #define HCS                 ((uint32_t) 1 << 30)
@@ -63,6 +65,12 @@
 
 #define BLOCK_LEN           (512)
 
+/*
+ * Number of bytes polled back to back while waiting for a token or for the
+ * card to leave the busy state, before yielding the CPU between polls.
+ */
+#define POLL_SPIN_CNT       (512)
+
 static uint8_t g_block_buf[BLOCK_LEN];
 
 static struct hal_spi_settings mmc_settings = {
@@ -80,6 +88,9 @@ static struct mmc_cfg {
     int                      ss_pin;
     void                     *spi_cfg;
     struct hal_spi_settings  *settings;
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    struct os_sem            xfer_sem;
+#endif
 } g_mmc_cfg;
 
 static int
@@ -120,6 +131,82 @@ mmc_cfg_dev(uint8_t id)
     return &g_mmc_cfg;
 }
 
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+static void
+mmc_txrx_cb(void *arg, int len)
+{
+    struct mmc_cfg *mmc;
+
+    mmc = arg;
+    os_sem_release(&mmc->xfer_sem);
+}
+#endif
+
+/**
+ * Moves a buffer over SPI in one transfer.  For reads, txbuf must hold 0xff
+ * bytes; it may be the same buffer as rxbuf.
+ */
+static int
+mmc_xfer(struct mmc_cfg *mmc, void *txbuf, void *rxbuf, int len)
+{
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    os_time_t ticks;
+    int rc;
+
+    rc = hal_spi_txrx_noblock(mmc->spi_num, txbuf, rxbuf, len);
+    if (rc) {
+        return MMC_DEVICE_ERROR;
+    }
+
+    os_time_ms_to_ticks(MYNEWT_VAL(MMC_XFER_TIMEOUT_MS), &ticks);
+    if (os_sem_pend(&mmc->xfer_sem, ticks) != OS_OK) {
+        hal_spi_abort(mmc->spi_num);
+        return MMC_TIMEOUT;
+    }
+
+    return MMC_OK;
+#else
+    if (hal_spi_txrx(mmc->spi_num, txbuf, rxbuf, len)) {
+        return MMC_DEVICE_ERROR;
+    }
+
+    return MMC_OK;
+#endif
+}
+
+/**
+ * Clocks 0xff out until the card answers with something else or the timeout
+ * expires.  Polls back to back at first, since the answer usually comes
+ * within a few bytes, and only then starts yielding between polls.
+ *
+ * @return The last byte received from the card.
+ */
+static uint8_t
+mmc_poll(struct mmc_cfg *mmc, uint8_t idle, os_time_t timeout_ticks)
+{
+    os_time_t timeout;
+    uint8_t res;
+    int n;
+
+    for (n = 0; n < POLL_SPIN_CNT; n++) {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != idle) {
+            return res;
+        }
+    }
+
+    timeout = os_time_get() + timeout_ticks;
+    do {
+        os_time_delay(1);
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != idle) {
+            break;
+        }
+    } while (OS_TIME_TICK_LT(os_time_get(), timeout));
+
+    return res;
+}
+
 static uint8_t
 send_mmc_cmd(struct mmc_cfg *mmc, uint8_t cmd, uint32_t payload)
 {
@@ -206,7 +293,12 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
         return (rc);
     }
 
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    os_sem_init(&mmc->xfer_sem, 0);
+    hal_spi_set_txrx_cb(mmc->spi_num, mmc_txrx_cb, mmc);
+#else
     hal_spi_set_txrx_cb(mmc->spi_num, NULL, NULL);
+#endif
     hal_spi_enable(mmc->spi_num);
 
     /**
@@ -343,17 +435,49 @@ out:
 static uint8_t
 wait_busy(struct mmc_cfg *mmc)
 {
-    os_time_t timeout;
+    return mmc_poll(mmc, 0x00, OS_TICKS_PER_SEC / 2);
+}
+
+/**
+ * 7.3.3 Control tokens
+ *   Wait up to 200ms for the start block token.
+ */
+static uint8_t
+wait_start_block(struct mmc_cfg *mmc)
+{
+    return mmc_poll(mmc, 0xff, OS_TICKS_PER_SEC / 5);
+}
+
+/**
+ * Receives one data block and its CRC.  The data is read straight into the
+ * destination; it doubles as the 0xff transmit buffer.
+ */
+static int
+read_block(struct mmc_cfg *mmc, uint8_t *dst)
+{
     uint8_t res;
+    int rc;
 
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 2;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res) break;
-        os_time_delay(OS_TICKS_PER_SEC / 1000);
-    } while (os_time_get() < timeout);
+    res = wait_start_block(mmc);
 
-    return res;
+    /**
+     * 7.3.3.2 Start Block Tokens and Stop Tran Token
+     */
+    if (res != START_BLOCK) {
+        return MMC_TIMEOUT;
+    }
+
+    memset(dst, 0xff, BLOCK_LEN);
+    rc = mmc_xfer(mmc, dst, dst, BLOCK_LEN);
+    if (rc) {
+        return rc;
+    }
+
+    /* TODO: CRC-16 not used here but would be cool to have */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+    return MMC_OK;
 }
 
 /**
@@ -365,10 +489,8 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
     uint8_t cmd;
     uint8_t res;
     int rc;
-    uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
@@ -382,10 +504,10 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
 
     rc = MMC_OK;
 
-    block_len = (len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
-    block_count = block_len / BLOCK_LEN;
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
+    block_len = (offset + len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
+    block_count = block_len / BLOCK_LEN;
 
     hal_gpio_write(mmc->ss_pin, 0);
 
@@ -396,38 +518,22 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         goto out;
     }
 
-    /**
-     * 7.3.3 Control tokens
-     *   Wait up to 200ms for control token.
-     */
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res != 0xFF) break;
-        os_time_delay(OS_TICKS_PER_SEC / 20);
-    } while (os_time_get() < timeout);
-
-    /**
-     * 7.3.3.2 Start Block Tokens and Stop Tran Token
-     */
-    if (res != START_BLOCK) {
-        rc = MMC_TIMEOUT;
-        goto out;
-    }
-
     index = 0;
     while (block_count--) {
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
-        }
-
-        /* TODO: CRC-16 not used here but would be cool to have */
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-
         amount = MIN(BLOCK_LEN - offset, len);
 
-        memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        /* Whole blocks go straight to the caller's buffer */
+        if (amount == BLOCK_LEN) {
+            rc = read_block(mmc, (uint8_t *)buf + index);
+        } else {
+            rc = read_block(mmc, g_block_buf);
+            if (rc == MMC_OK) {
+                memcpy((uint8_t *)buf + index, &g_block_buf[offset], amount);
+            }
+        }
+        if (rc) {
+            break;
+        }
 
         offset = 0;
         len -= amount;
@@ -444,6 +550,31 @@ out:
     return (rc);
 }
 
+/**
+ * Sends one data block preceded by the given start token and followed by a
+ * dummy CRC.
+ *
+ * @return The data response token, masked to its status bits.
+ */
+static uint8_t
+write_block(struct mmc_cfg *mmc, uint8_t token, const uint8_t *src)
+{
+    hal_spi_tx_val(mmc->spi_num, token);
+
+    if (mmc_xfer(mmc, (void *)src, NULL, BLOCK_LEN)) {
+        return 0;
+    }
+
+    /* CRC */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+    /**
+     * 7.3.3.1 Data Response Token
+     */
+    return hal_spi_tx_val(mmc->spi_num, 0xff) & 0x1f;
+}
+
 /**
  * @return 0 on success, non-zero on failure
  */
@@ -452,14 +583,13 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
 {
     uint8_t cmd;
     uint8_t res;
-    uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    const uint8_t *src;
     int rc;
     struct mmc_cfg *mmc;
 
@@ -468,10 +598,10 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
         return (MMC_DEVICE_ERROR);
     }
 
-    block_len = (len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
-    block_count = block_len / BLOCK_LEN;
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
+    block_len = (offset + len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
+    block_count = block_len / BLOCK_LEN;
 
     hal_gpio_write(mmc->ss_pin, 0);
 
@@ -490,62 +620,52 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             goto out;
         }
 
-        timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-        do {
-            res = hal_spi_tx_val(mmc->spi_num, 0xff);
-            if (res != 0xff) break;
-            os_time_delay(OS_TICKS_PER_SEC / 20);
-        } while (os_time_get() < timeout);
-
-        if (res != START_BLOCK) {
+        rc = read_block(mmc, g_block_buf);
+        if (rc) {
             rc = MMC_CARD_ERROR;
             goto out;
         }
-
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
-        }
-
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
     }
 
     /* now start write */
 
-    cmd = (block_count == 1) ? CMD24 : CMD25;
+    if (block_count == 1) {
+        cmd = CMD24;
+    } else {
+        cmd = CMD25;
+
+        /**
+         * 4.3.4: Let the card pre-erase the blocks about to be streamed.  This
+         * is only a hint, so a card that doesn't support it is not an error.
+         */
+        send_mmc_cmd(mmc, ACMD23, block_count);
+    }
+
     res = send_mmc_cmd(mmc, cmd, block_addr);
     if (res) {
         rc = error_by_response(res);
         goto out;
     }
 
+    res = 0;
     index = 0;
     while (block_count--) {
-        /**
-         * 7.3.3.2 Start Block Tokens and Stop Tran Token
-         */
-        if (cmd == CMD24) {
-            hal_spi_tx_val(mmc->spi_num, START_BLOCK);
-        } else {
-            hal_spi_tx_val(mmc->spi_num, START_BLOCK_TOKEN);
-        }
-
         amount = MIN(BLOCK_LEN - offset, len);
-        memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
 
-        for (n = 0; n < BLOCK_LEN; n++) {
-            hal_spi_tx_val(mmc->spi_num, g_block_buf[n]);
+        /* Whole blocks are sent straight from the caller's buffer */
+        if (amount == BLOCK_LEN) {
+            src = (const uint8_t *)buf + index;
+        } else {
+            memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+            src = g_block_buf;
         }
 
-        /* CRC */
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-
         /**
-         * 7.3.3.1 Data Response Token
+         * 7.3.3.2 Start Block Tokens and Stop Tran Token
          */
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if ((res & 0x1f) != 0x05) {
+        res = write_block(mmc, cmd == CMD24 ? START_BLOCK : START_BLOCK_TOKEN,
+                          src);
+        if (res != 0x05) {
             break;
         }
 
@@ -563,7 +683,6 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
         wait_busy(mmc);
     }
 
-    res &= 0x1f;
     switch (res) {
         case 0x05:
             rc = MMC_OK;
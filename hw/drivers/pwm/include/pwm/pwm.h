@@ -143,6 +143,18 @@ typedef int (*pwm_disable_func_t) (struct pwm_dev *);
 
 typedef void (*user_handler_t) (void*);
 
+struct pwm_seq;
+
+/**
+ * Start hardware-timed playback of a duty cycle sequence.
+ *
+ * @param dev The device to play the sequence on.
+ * @param seq The sequence to play.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+typedef int (*pwm_play_seq_func_t) (struct pwm_dev *, struct pwm_seq *);
+
 struct pwm_driver_funcs {
     pwm_config_device_func_t pwm_configure_device;
     pwm_config_channel_func_t pwm_configure_channel;
@@ -154,6 +166,7 @@ struct pwm_driver_funcs {
     pwm_get_top_value_funct_t pwm_get_top_value;
     pwm_get_resolution_bits_func_t pwm_get_resolution_bits;
     pwm_disable_func_t pwm_disable;
+    pwm_play_seq_func_t pwm_play_seq;
 };
 
 struct pwm_dev {
@@ -202,6 +215,35 @@ struct pwm_dev_cfg {
     void* data;
 };
 
+/**
+ * PWM duty cycle sequence.
+ *
+ * values - Duty cycle fractions, pwm_chan_count values per step with
+ * channel 0 first. The buffer is read by the hardware while playing and must
+ * stay valid until the sequence ends or the device is disabled. Drivers may
+ * rewrite the values in place into their hardware format; doing so again on
+ * replay leaves them unchanged.
+ * n_steps - The number of steps in values.
+ * repeats - The number of additional PWM periods each step is held for.
+ * n_loops - The number of times the sequence is played. 0 for loop mode.
+ * loop_handler - Called after each pass through the sequence, may be NULL.
+ * end_handler - Called once the last pass has been played, may be NULL.
+ * loop_data - User data to be passed to loop_handler as a parameter.
+ * end_data - User data to be passed to end_handler as a parameter.
+ *
+ * Handlers are called from interrupt context.
+ */
+struct pwm_seq {
+    uint16_t *values;
+    uint16_t n_steps;
+    uint16_t repeats;
+    uint32_t n_loops;
+    user_handler_t loop_handler;
+    user_handler_t end_handler;
+    void* loop_data;
+    void* end_data;
+};
+
 int pwm_configure_device(struct pwm_dev *dev, struct pwm_dev_cfg *cfg);
 int pwm_configure_channel(struct pwm_dev *dev, uint8_t cnum, struct pwm_chan_cfg *cfg);
 int pwm_set_duty_cycle(struct pwm_dev *pwm_d, uint8_t cnum, uint16_t fraction);
@@ -212,6 +254,7 @@ int pwm_get_clock_freq(struct pwm_dev *dev);
 int pwm_get_top_value(struct pwm_dev *dev);
 int pwm_get_resolution_bits(struct pwm_dev *dev);
 int pwm_disable(struct pwm_dev *dev);
+int pwm_play_seq(struct pwm_dev *dev, struct pwm_seq *seq);
 
 #ifdef __cplusplus
 }
@@ -37,6 +37,9 @@
 /* Max number on PWM instances on existing nRF52xxx MCUs */
 #define NRF52_PWM_MAX_INSTANCES     4
 
+/* Sequence value polarity bit, set when the output starts high */
+#define NRF52_PWM_SEQ_FALLING_EDGE  0x8000
+
 struct nrf52_pwm_dev_global {
     bool in_use;
     bool playing;
@@ -50,6 +53,7 @@ struct nrf52_pwm_dev_global {
     user_handler_t seq_end_handler;
     void* cycle_data;
     void* seq_end_data;
+    struct pwm_seq *seq;
 };
 
 static struct nrf52_pwm_dev_global instances[] =
@@ -115,18 +119,37 @@ static struct nrf52_pwm_dev_global instances[] =
 #endif
 };
 
-#if MYNEWT_VAL(PWM_0)
-static void handler_0(nrfx_pwm_evt_type_t event_type)
+/**
+ * Dispatch a driver event to the user handlers of an instance, or to those
+ * of the sequence being played.
+ */
+static void
+handle_event(struct nrf52_pwm_dev_global *instance,
+             nrfx_pwm_evt_type_t event_type)
 {
+    struct pwm_seq *seq = instance->seq;
+
     switch (event_type)
     {
     case NRFX_PWM_EVT_END_SEQ0 :
     case NRFX_PWM_EVT_END_SEQ1 :
-        instances[0].cycle_handler(instances[0].cycle_data);
+        if (seq) {
+            if (seq->loop_handler) {
+                seq->loop_handler(seq->loop_data);
+            }
+        } else {
+            instance->cycle_handler(instance->cycle_data);
+        }
         break;
 
     case NRFX_PWM_EVT_FINISHED :
-        instances[0].seq_end_handler(instances[0].seq_end_data);
+        if (seq) {
+            if (seq->end_handler) {
+                seq->end_handler(seq->end_data);
+            }
+        } else {
+            instance->seq_end_handler(instance->seq_end_data);
+        }
         break;
 
     case NRFX_PWM_EVT_STOPPED :
@@ -136,75 +159,32 @@ static void handler_0(nrfx_pwm_evt_type_t event_type)
         assert(0);
     }
 }
+
+#if MYNEWT_VAL(PWM_0)
+static void handler_0(nrfx_pwm_evt_type_t event_type)
+{
+    handle_event(&instances[0], event_type);
+}
 #endif
 
 #if MYNEWT_VAL(PWM_1)
 static void handler_1(nrfx_pwm_evt_type_t event_type)
 {
-    switch (event_type)
-    {
-    case NRFX_PWM_EVT_END_SEQ0 :
-    case NRFX_PWM_EVT_END_SEQ1 :
-        instances[1].cycle_handler(instances[1].cycle_data);
-        break;
-
-    case NRFX_PWM_EVT_FINISHED :
-        instances[1].seq_end_handler(instances[1].seq_end_data);
-        break;
-
-    case NRFX_PWM_EVT_STOPPED :
-        break;
-
-    default:
-        assert(0);
-    }
+    handle_event(&instances[1], event_type);
 }
 #endif
 
 #if MYNEWT_VAL(PWM_2)
 static void handler_2(nrfx_pwm_evt_type_t event_type)
 {
-    switch (event_type)
-    {
-    case NRFX_PWM_EVT_END_SEQ0 :
-    case NRFX_PWM_EVT_END_SEQ1 :
-        instances[2].cycle_handler(instances[2].cycle_data);
-        break;
-
-    case NRFX_PWM_EVT_FINISHED :
-        instances[2].seq_end_handler(instances[2].seq_end_data);
-        break;
-
-    case NRFX_PWM_EVT_STOPPED :
-        break;
-
-    default:
-        assert(0);
-    }
-
+    handle_event(&instances[2], event_type);
 }
 #endif
 
 #if MYNEWT_VAL(PWM_3)
 static void handler_3(nrfx_pwm_evt_type_t event_type)
 {
-    switch (event_type)
-    {
-    case NRFX_PWM_EVT_END_SEQ0 :
-    case NRFX_PWM_EVT_END_SEQ1 :
-        instances[3].cycle_handler(instances[3].cycle_data);
-        break;
-
-    case NRFX_PWM_EVT_FINISHED :
-        instances[3].seq_end_handler(instances[3].seq_end_data);
-        break;
-
-    case NRFX_PWM_EVT_STOPPED :
-        break;
-
-    default:
-        assert(0);
-    }
+    handle_event(&instances[3], event_type);
 }
 #endif
 
@@ -265,6 +245,7 @@ cleanup_instance(int inst_id)
     instances[inst_id].seq_end_handler = NULL;
     instances[inst_id].cycle_data = NULL;
     instances[inst_id].seq_end_data = NULL;
+    instances[inst_id].seq = NULL;
     memset((uint16_t *) &instances[inst_id].duty_cycles,
            0x00,
            4 * sizeof(uint16_t));
@@ -369,6 +350,7 @@ play_current_config(struct nrf52_pwm_dev_global *instance)
             .end_delay           = 0
         };
 
+    instance->seq = NULL;
     nrfx_pwm_simple_playback(&instance->drv_instance,
                              &seq,
                              instance->n_cycles,
@@ -557,6 +539,81 @@ nrf52_pwm_disable(struct pwm_dev *dev)
 
     nrfx_pwm_uninit(&instances[inst_id].drv_instance);
     instances[inst_id].playing = false;
+    instances[inst_id].seq = NULL;
+
+    return (0);
+}
+
+/**
+ * Play a duty cycle sequence straight from the user buffer using EasyDMA.
+ *
+ * The values are rewritten in place to carry the polarity bit matching each
+ * channel's inversion, so the buffer must be in RAM.
+ *
+ * @param dev The device to play the sequence on.
+ * @param seq The sequence to play.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+static int
+nrf52_pwm_play_seq(struct pwm_dev *dev, struct pwm_seq *seq)
+{
+    int inst_id = dev->pwm_instance_id;
+    struct nrf52_pwm_dev_global *instance = &instances[inst_id];
+    nrfx_pwm_config_t *config = &instance->config;
+    nrf_pwm_sequence_t nseq;
+    nrfx_pwm_handler_t handler;
+    nrfx_pwm_flag_t flags;
+    uint32_t n_values;
+    uint32_t i;
+    uint8_t cnum;
+
+    if (!instance->in_use) {
+        return (EINVAL);
+    }
+
+    n_values = (uint32_t)seq->n_steps * NRF_PWM_CHANNEL_COUNT;
+    if (n_values > PWM_SEQ_CNT_CNT_Msk ||
+        config->load_mode != NRF_PWM_LOAD_INDIVIDUAL ||
+        !nrfx_is_in_ram(seq->values)) {
+        return (EINVAL);
+    }
+
+    for (i = 0; i < n_values; i++) {
+        cnum = i % NRF_PWM_CHANNEL_COUNT;
+        if (config->output_pins[cnum] & NRFX_PWM_PIN_INVERTED) {
+            seq->values[i] &= ~NRF52_PWM_SEQ_FALLING_EDGE;
+        } else {
+            seq->values[i] |= NRF52_PWM_SEQ_FALLING_EDGE;
+        }
+    }
+
+    nseq.values.p_raw = seq->values;
+    nseq.length = n_values;
+    nseq.repeats = seq->repeats;
+    nseq.end_delay = 0;
+
+    flags = (seq->n_loops) ? 0 : NRFX_PWM_FLAG_LOOP;
+    flags |= (seq->loop_handler) ?
+        (NRFX_PWM_FLAG_SIGNAL_END_SEQ0 | NRFX_PWM_FLAG_SIGNAL_END_SEQ1) :
+        0;
+    flags |= (seq->end_handler) ?
+        0 :
+        NRFX_PWM_FLAG_NO_EVT_FINISHED;
+    handler = (seq->loop_handler || seq->end_handler) ?
+        internal_handlers[inst_id] :
+        NULL;
+
+    if (instance->playing) {
+        nrfx_pwm_uninit(&instance->drv_instance);
+    }
+    instance->seq = seq;
+    nrfx_pwm_init(&instance->drv_instance, config, handler);
+    nrfx_pwm_simple_playback(&instance->drv_instance,
+                             &nseq,
+                             (seq->n_loops) ? seq->n_loops : 1,
+                             flags);
+    instance->playing = true;
 
     return (0);
 }
@@ -829,6 +886,7 @@ nrf52_pwm_dev_init(struct os_dev *odev, void *arg)
     pwm_funcs->pwm_get_top_value = nrf52_pwm_get_top_value;
     pwm_funcs->pwm_get_resolution_bits = nrf52_pwm_get_resolution_bits;
     pwm_funcs->pwm_disable = nrf52_pwm_disable;
+    pwm_funcs->pwm_play_seq = nrf52_pwm_play_seq;
 
     switch (dev->pwm_instance_id) {
 #if MYNEWT_VAL(PWM_0)
@@ -49,6 +49,11 @@ typedef struct {
     uint16_t             pin[STM32_PWM_CH_MAX];
     uint16_t             irq;
     stm32_pwm_dev_cfg_t  cfg;
+    struct pwm_seq      *seq;
+    uint8_t              seq_chans;
+    uint16_t             seq_step;
+    uint16_t             seq_rpt;
+    uint32_t             seq_loop;
 } stm32_pwm_dev_t;
 
 static stm32_pwm_dev_t stm32_pwm_dev[PWM_CNT];
@@ -112,12 +117,81 @@ stm32_pwm_ch_unconfigure(const stm32_pwm_dev_t *pwm, uint32_t id)
     LL_TIM_OC_DisablePreload(pwm->timx,  ch);
 }
 
+static void
+stm32_pwm_seq_load(stm32_pwm_dev_t *pwm)
+{
+    const uint16_t *values;
+
+    values = &pwm->seq->values[pwm->seq_step * pwm->seq_chans];
+    for (int i=0; i < pwm->seq_chans; ++i) {
+        if (stm32_pwm_ch_is_active(pwm, i)) {
+            stm32_pwm_ch_set_compare(pwm->timx, i, values[i]);
+        }
+    }
+}
+
+/*
+ * Advance the sequence position by one PWM period and write the values of
+ * that period into the compare preload registers, which the timer picks up
+ * at the next update event.
+ */
+static void
+stm32_pwm_seq_advance(stm32_pwm_dev_t *pwm)
+{
+    struct pwm_seq *seq = pwm->seq;
+
+    if (pwm->seq_rpt < seq->repeats) {
+        ++pwm->seq_rpt;
+        return;
+    }
+
+    pwm->seq_rpt = 0;
+    if (++pwm->seq_step == seq->n_steps) {
+        pwm->seq_step = 0;
+        if (seq->n_loops && ++pwm->seq_loop == seq->n_loops) {
+            return;
+        }
+    }
+
+    stm32_pwm_seq_load(pwm);
+}
+
+static void
+stm32_pwm_seq_isr(stm32_pwm_dev_t *pwm)
+{
+    struct pwm_seq *seq = pwm->seq;
+
+    /* the position describes the period which has just started */
+    if (!pwm->seq_step && !pwm->seq_rpt && seq->loop_handler) {
+        seq->loop_handler(seq->loop_data);
+    }
+
+    if (seq->n_loops && pwm->seq_loop == seq->n_loops) {
+        stm32_pwm_active_ch_set_mode(pwm, STM32_PWM_CH_MODE_DIS);
+        LL_TIM_DisableCounter(pwm->timx);
+        LL_TIM_SetCounter(pwm->timx, 0);
+        pwm->seq = NULL;
+
+        if (seq->end_handler) {
+            seq->end_handler(seq->end_data);
+        }
+        return;
+    }
+
+    stm32_pwm_seq_advance(pwm);
+}
+
 static void
 stm32_pwm_isr(stm32_pwm_dev_t *pwm)
 {
     uint32_t sr = pwm->timx->SR;
     pwm->timx->SR = ~sr;
 
+    if (pwm->seq) {
+        stm32_pwm_seq_isr(pwm);
+        return;
+    }
+
     if (pwm->cfg.cycle_handler) {
         pwm->cfg.cycle_handler(pwm->cfg.cycle_data);
     }
@@ -166,6 +240,7 @@ stm32_pwm_enable(struct pwm_dev *dev)
 
     pwm = &stm32_pwm_dev[dev->pwm_instance_id];
     pwm->cycle = pwm->cfg.n_cycles;
+    pwm->seq = NULL;
 
     stm32_pwm_active_ch_set_mode(pwm, STM32_PWM_CH_MODE_ENA);
 
@@ -184,6 +259,47 @@ stm32_pwm_disable(struct pwm_dev *dev)
 
     LL_TIM_DisableCounter(pwm->timx);
     LL_TIM_SetCounter(pwm->timx, 0);
+    pwm->seq = NULL;
+
+    return STM32_PWM_ERR_OK;
+}
+
+/*
+ * The sequence is fed from the update interrupt: each step is written into
+ * the compare preload registers one period ahead and latched by the timer at
+ * the update event, so step boundaries are timed by the hardware as long as
+ * the interrupt is serviced within one PWM period.
+ */
+static int
+stm32_pwm_play_seq(struct pwm_dev *dev, struct pwm_seq *seq)
+{
+    stm32_pwm_dev_t *pwm;
+
+    pwm = &stm32_pwm_dev[dev->pwm_instance_id];
+
+    if (!pwm->irq || !LL_TIM_IsEnabledIT_UPDATE(pwm->timx)) {
+        return STM32_PWM_ERR_NOIRQ;
+    }
+
+    LL_TIM_DisableCounter(pwm->timx);
+    LL_TIM_SetCounter(pwm->timx, 0);
+
+    pwm->seq = NULL;
+    pwm->seq_chans = dev->pwm_chan_count;
+    pwm->seq_step = 0;
+    pwm->seq_rpt = 0;
+    pwm->seq_loop = 0;
+
+    stm32_pwm_active_ch_set_mode(pwm, STM32_PWM_CH_MODE_ENA);
+
+    /* latch the first step and preload the second one */
+    pwm->seq = seq;
+    stm32_pwm_seq_load(pwm);
+    LL_TIM_GenerateEvent_UPDATE(pwm->timx);
+    LL_TIM_ClearFlag_UPDATE(pwm->timx);
+    stm32_pwm_seq_advance(pwm);
+
+    LL_TIM_EnableCounter(pwm->timx);
 
     return STM32_PWM_ERR_OK;
 }
@@ -592,6 +708,7 @@ stm32_pwm_dev_init(struct os_dev *odev, void *arg)
     dev->pwm_funcs.pwm_get_resolution_bits = stm32_pwm_get_resolution_bits;
     dev->pwm_funcs.pwm_get_top_value = stm32_pwm_get_top_value;
     dev->pwm_funcs.pwm_is_enabled = stm32_pwm_is_enabled;
+    dev->pwm_funcs.pwm_play_seq = stm32_pwm_play_seq;
     dev->pwm_funcs.pwm_set_duty_cycle = stm32_pwm_ch_set_duty_cycle;
     dev->pwm_funcs.pwm_set_frequency = stm32_pwm_set_frequency;
 
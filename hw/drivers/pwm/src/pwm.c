@@ -205,3 +205,33 @@ pwm_disable(struct pwm_dev *dev)
 
     return (dev->pwm_funcs.pwm_disable(dev));
 }
+
+/**
+ * Play a sequence of duty cycles, one step per PWM period.
+ *
+ * Steps are loaded by the PWM hardware at period boundaries so the output
+ * does not depend on task or interrupt latency between steps. Playback
+ * replaces the duty cycles set with pwm_set_duty_cycle() until
+ * pwm_enable() or pwm_disable() is called.
+ *
+ * @param dev The device to play the sequence on. Its channels should be
+ * already configured.
+ * @param seq The sequence to play.
+ *
+ * @return 0 on success, ENOTSUP if the driver has no sequence support,
+ * non-zero error code on failure.
+ */
+int
+pwm_play_seq(struct pwm_dev *dev, struct pwm_seq *seq)
+{
+    assert(dev);
+
+    if (dev->pwm_funcs.pwm_play_seq == NULL) {
+        return (ENOTSUP);
+    }
+    if (seq == NULL || seq->values == NULL || seq->n_steps == 0) {
+        return (EINVAL);
+    }
+
+    return (dev->pwm_funcs.pwm_play_seq(dev, seq));
+}
@@ -35,10 +35,16 @@
 #define NUM_BUFFERS_BLE_MONITOR         0
 #endif
 
+#if MYNEWT_VAL(RTT_STREAM)
+#define NUM_BUFFERS_RTT_STREAM          1
+#else
+#define NUM_BUFFERS_RTT_STREAM          0
+#endif
+
 /* Maximum number of up-buffers (target -> host) available */
 #define SEGGER_RTT_MAX_NUM_UP_BUFFERS   \
     (1 + (NUM_BUFFERS_OS_SYSVIEW) + (NUM_BUFFERS_BLE_MONITOR) + \
-     (MYNEWT_VAL(RTT_NUM_BUFFERS_UP)))
+     (NUM_BUFFERS_RTT_STREAM) + (MYNEWT_VAL(RTT_NUM_BUFFERS_UP)))
 /* Maximum number of down-buffers (host -> target) available */
 #define SEGGER_RTT_MAX_NUM_DOWN_BUFFERS \
     (1 + (NUM_BUFFERS_OS_SYSVIEW) + (MYNEWT_VAL(RTT_NUM_BUFFERS_DOWN)))
@@ -34,9 +34,16 @@
 #include "modlog/modlog.h"
 #include "stats/stats.h"
 
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+#define BME280_INVALID              INT32_MIN
+#define BME280_IS_VALID(val)        ((val) != BME280_INVALID)
+#else
 #ifndef MATHLIB_SUPPORT
 static double NAN = 0.0/0.0;
 #endif
+#define BME280_INVALID              NAN
+#define BME280_IS_VALID(val)        ((val) == (val))
+#endif
 
 static struct hal_spi_settings spi_bme280_settings = {
     .data_order = HAL_SPI_MSB_FIRST,
@@ -313,14 +320,15 @@ bme280_compensate_humidity(struct sensor_itf *itf, int32_t rawhumid,
 #else
 
 /**
- * Returns temperature in DegC, as float
+ * Returns temperature in DegC using the integer compensation, so no
+ * floating point is needed with SENSOR_FIXED_POINT.
  * Output value of "51.23" equals 51.23 DegC.
  *
  * @param uncompensated raw temperature value
  * @param Per device data
- * @return 0 on success, non-zero on failure
+ * @return temperature, BME280_INVALID for invalid data
  */
-static float
+static sensor_fp_t
 bme280_compensate_temperature(int32_t rawtemp, struct bme280_pdd *pdd)
 {
     int32_t var1, var2, comptemp;
@@ -328,7 +336,7 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_pdd *pdd)
     if (rawtemp == 0x800000) {
         BME280_LOG(ERROR, "Invalid temp data\n");
         STATS_INC(g_bme280stats, invalid_data_errors);
-        return NAN;
+        return BME280_INVALID;
     }
 
     rawtemp >>= 4;
@@ -344,18 +352,18 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_pdd *pdd)
 
     comptemp = ((int32_t)(pdd->t_fine * 5 + 128)) >> 8;
 
-    return (float)comptemp/100;
+    return SENSOR_FP_FROM_RATIO(comptemp, 100);
 }
 
 /**
- * Returns pressure in Pa as float.
+ * Returns pressure in Pa using the 64-bit integer compensation.
  * Output value of "96386.2" equals 96386.2 Pa = 963.862 hPa
  *
  * @param uncompensated raw pressure value
  * @param Per device data
- * @return 0 on success, non-zero on failure
+ * @return pressure, BME280_INVALID for invalid data
  */
-static float
+static sensor_fp_t
 bme280_compensate_pressure(struct sensor_itf *itf, int32_t rawpress,
                            struct bme280_pdd *pdd)
 {
@@ -365,7 +373,7 @@ bme280_compensate_pressure(struct sensor_itf *itf, int32_t rawpress,
     if (rawpress == 0x800000) {
         BME280_LOG(ERROR, "Invalid pressure data\n");
         STATS_INC(g_bme280stats, invalid_data_errors);
-        return NAN;
+        return BME280_INVALID;
     }
 
     if (!pdd->t_fine) {
@@ -397,37 +405,37 @@ bme280_compensate_pressure(struct sensor_itf *itf, int32_t rawpress,
 
     p = ((int64_t)(p + var1 + var2) >> 8) + (((int64_t)pdd->bcd.bcd_dig_P7) << 4);
 
-    return (float)p/256;
+    return SENSOR_FP_FROM_RATIO(p, 256);
 }
 
 /**
- * Returns humidity in %rH as float.
+ * Returns humidity in %rH using the integer compensation.
  * Output value of "46.332" represents 46.332 %rH
  *
  * @param uncompensated raw humidity value
- * @return 0 on success, non-zero on failure
+ * @param Per device data
+ * @return humidity, BME280_INVALID for invalid data
  */
-static float
-bme280_compensate_humidity(struct sensor_itf *itf, uint32_t rawhumid,
-                           struct bme280_calib_data *bcd)
+static sensor_fp_t
+bme280_compensate_humidity(struct sensor_itf *itf, int32_t rawhumid,
+                           struct bme280_pdd *pdd)
 {
-    int32_t h;
     int32_t temp;
     int32_t tmp32;
 
     if (rawhumid == 0x8000) {
         BME280_LOG(ERROR, "Invalid humidity data\n");
         STATS_INC(g_bme280stats, invalid_data_errors);
-        return NAN;
+        return BME280_INVALID;
     }
 
-    if (!g_t_fine) {
-        if(!bme280_get_temperature(&temp)) {
-            (void)bme280_compensate_temperature(temp, bcd);
+    if (!pdd->t_fine) {
+        if(!bme280_get_temperature(itf, &temp)) {
+            (void)bme280_compensate_temperature(temp, pdd);
         }
     }
 
-    tmp32 = (g_t_fine - ((int32_t)76800));
+    tmp32 = (pdd->t_fine - ((int32_t)76800));
 
     tmp32 = (((((rawhumid << 14) - (((int32_t)pdd->bcd.bcd_dig_H4) << 20) -
              (((int32_t)pdd->bcd.bcd_dig_H5) * tmp32)) + ((int32_t)16384)) >> 15) *
@@ -442,9 +450,7 @@ bme280_compensate_humidity(struct sensor_itf *itf, uint32_t rawhumid,
 
     tmp32 = (tmp32 > 419430400) ? 419430400 : tmp32;
 
-    h = (tmp32 >> 12);
-
-    return  h / 1024.0;
+    return SENSOR_FP_FROM_RATIO(tmp32 >> 12, 1024);
 }
 
 #endif
@@ -498,7 +504,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         databuf.spd.spd_press = bme280_compensate_pressure(itf, rawpress, &(bme280->pdd));
 
-        if (databuf.spd.spd_press != NAN) {
+        if (BME280_IS_VALID(databuf.spd.spd_press)) {
             databuf.spd.spd_press_is_valid = 1;
         }
 
@@ -518,7 +524,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         databuf.std.std_temp = bme280_compensate_temperature(rawtemp, &(bme280->pdd));
 
-        if (databuf.std.std_temp != NAN) {
+        if (BME280_IS_VALID(databuf.std.std_temp)) {
             databuf.std.std_temp_is_valid = 1;
         }
 
@@ -538,7 +544,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         databuf.shd.shd_humid = bme280_compensate_humidity(itf, rawhumid, &(bme280->pdd));
 
-        if (databuf.shd.shd_humid != NAN) {
+        if (BME280_IS_VALID(databuf.shd.shd_humid)) {
             databuf.shd.shd_humid_is_valid = 1;
         }
 
@@ -2407,36 +2407,75 @@ err:
     return rc;
 }
 
-static int lis2dw12_do_read(struct sensor *sensor, sensor_data_func_t data_func,
-                            void * data_arg, uint8_t fs)
+static int
+lis2dw12_read_sample(struct sensor_itf *itf, uint8_t fs,
+                     struct sensor_accel_data *sad)
 {
-    struct sensor_accel_data sad;
-    struct sensor_itf *itf;
     int16_t x, y ,z;
-    float fx, fy ,fz;
     int rc;
 
-    itf = SENSOR_GET_ITF(sensor);
-
     x = y = z = 0;
 
     rc = lis2dw12_get_data(itf, fs, &x, &y, &z);
     if (rc) {
-        goto err;
+        return rc;
     }
 
     /* converting values from mg to ms^2 */
-    lis2dw12_calc_acc_ms2(x, &fx);
-    lis2dw12_calc_acc_ms2(y, &fy);
-    lis2dw12_calc_acc_ms2(z, &fz);
+    sad->sad_x = SENSOR_FP_MG_TO_MS2(x);
+    sad->sad_y = SENSOR_FP_MG_TO_MS2(y);
+    sad->sad_z = SENSOR_FP_MG_TO_MS2(z);
+
+    sad->sad_x_is_valid = 1;
+    sad->sad_y_is_valid = 1;
+    sad->sad_z_is_valid = 1;
+
+    return 0;
+}
+
+/**
+ * Sample period in microseconds for a LIS2DW12_DATA_RATE_* setting
+ */
+static uint32_t
+lis2dw12_rate_period_us(uint8_t rate)
+{
+    switch (rate) {
+    case LIS2DW12_DATA_RATE_1_6HZ:
+        return 625000;
+    case LIS2DW12_DATA_RATE_12_5HZ:
+        return 80000;
+    case LIS2DW12_DATA_RATE_25HZ:
+        return 40000;
+    case LIS2DW12_DATA_RATE_50HZ:
+        return 20000;
+    case LIS2DW12_DATA_RATE_100HZ:
+        return 10000;
+    case LIS2DW12_DATA_RATE_200HZ:
+        return 5000;
+    case LIS2DW12_DATA_RATE_400HZ:
+        return 2500;
+    case LIS2DW12_DATA_RATE_800HZ:
+        return 1250;
+    case LIS2DW12_DATA_RATE_1600HZ:
+        return 625;
+    default:
+        return 0;
+    }
+}
 
-    sad.sad_x = fx;
-    sad.sad_y = fy;
-    sad.sad_z = fz;
+static int lis2dw12_do_read(struct sensor *sensor, sensor_data_func_t data_func,
+                            void * data_arg, uint8_t fs)
+{
+    struct sensor_accel_data sad;
+    struct sensor_itf *itf;
+    int rc;
 
-    sad.sad_x_is_valid = 1;
-    sad.sad_y_is_valid = 1;
-    sad.sad_z_is_valid = 1;
+    itf = SENSOR_GET_ITF(sensor);
+
+    rc = lis2dw12_read_sample(itf, fs, &sad);
+    if (rc) {
+        goto err;
+    }
 
     /* Call data function */
     rc = data_func(sensor, data_arg, &sad, SENSOR_TYPE_ACCELEROMETER);
@@ -2514,6 +2553,8 @@ lis2dw12_stream_read(struct sensor *sensor,
     struct lis2dw12_cfg *cfg;
     os_time_t time_ticks;
     os_time_t stop_ticks = 0;
+    struct sensor_accel_data sad[MYNEWT_VAL(LIS2DW12_BATCH_SAMPLES)];
+    struct sensor_batch batch;
     uint8_t fifo_samples;
     uint8_t fs;
     int rc, rc2;
@@ -2570,14 +2611,29 @@ lis2dw12_stream_read(struct sensor *sensor,
 
         while(fifo_samples > 0) {
 
-            /* read all data we beleive is currently in fifo */
+            /* read all data we beleive is currently in fifo, handing it
+             * on in batches rather than one sample at a time
+             */
             while(fifo_samples > 0) {
-                rc = lis2dw12_do_read(sensor, read_func, read_arg, fs);
+                batch.sb_type = SENSOR_TYPE_ACCELEROMETER;
+                batch.sb_data = sad;
+                batch.sb_sample_size = sizeof(sad[0]);
+                batch.sb_period_us = lis2dw12_rate_period_us(cfg->rate);
+                batch.sb_count = 0;
+                while (fifo_samples > 0 &&
+                       batch.sb_count < MYNEWT_VAL(LIS2DW12_BATCH_SAMPLES)) {
+                    rc = lis2dw12_read_sample(itf, fs, &sad[batch.sb_count]);
+                    if (rc) {
+                        goto err;
+                    }
+                    batch.sb_count++;
+                    fifo_samples--;
+                }
+
+                rc = sensor_data_batch(sensor, read_func, read_arg, &batch);
                 if (rc) {
                     goto err;
                 }
-                fifo_samples--;
-
             }
 
             /* check if any data is available in fifo */
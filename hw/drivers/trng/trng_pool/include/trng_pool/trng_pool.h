@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __TRNG_POOL_H__
+#define __TRNG_POOL_H__
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "os/mynewt.h"
+#include "trng/trng.h"
+#include "tinycrypt/ctr_prng.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Entropy pool on top of a TRNG device.
+ *
+ * Random bytes are produced by a CTR-DRBG (tinycrypt ctr_prng) and kept in
+ * a buffer, so reading them is a copy and never waits for the TRNG.  Each
+ * read that leaves the buffer short schedules a refill on the pool's
+ * eventq; the refill reseeds the DRBG with whatever the TRNG driver has
+ * collected in the meantime (from its interrupt) and tops up the buffer.
+ */
+
+struct trng_pool;
+
+/**
+ * Called when a read takes the pool below TRNG_POOL_LOW_WATER bytes.  Runs
+ * in the context of the reader and must not block.
+ */
+typedef void (* trng_pool_low_func_t)(struct trng_pool *pool, void *arg);
+
+struct trng_pool {
+    struct trng_dev *tp_trng;
+    struct os_eventq *tp_evq;
+    struct os_event tp_refill_ev;
+    trng_pool_low_func_t tp_low_func;
+    void *tp_low_arg;
+    uint8_t tp_low;
+
+    TCCtrPrng_t tp_prng;
+    /* Fresh TRNG output collected for the next reseed */
+    uint8_t tp_seed[TC_AES_KEY_SIZE + TC_AES_BLOCK_SIZE];
+    uint8_t tp_seed_len;
+    uint32_t tp_reseeds;
+
+    uint16_t tp_out;
+    uint16_t tp_cnt;
+    uint8_t tp_buf[MYNEWT_VAL(TRNG_POOL_SIZE)];
+};
+
+/**
+ * Seed the DRBG from the TRNG and fill the pool.  Blocks until the TRNG
+ * has produced enough entropy for the initial seed.
+ *
+ * @param pool  pool to initialize
+ * @param trng  opened TRNG device
+ * @param evq   eventq to run refills on, NULL for the default eventq
+ *
+ * @return  0 on success, SYS_EUNKNOWN if the DRBG could not be seeded
+ */
+int trng_pool_init(struct trng_pool *pool, struct trng_dev *trng,
+                   struct os_eventq *evq);
+
+/**
+ * Set the callback for the pool running low
+ *
+ * @param pool  pool
+ * @param func  callback, NULL to disable
+ * @param arg   callback argument
+ */
+void trng_pool_set_low_func(struct trng_pool *pool,
+                            trng_pool_low_func_t func, void *arg);
+
+/**
+ * Copy random bytes out of the pool
+ *
+ * This function does not block; it reads no more than \p size bytes, up
+ * to the amount currently in the pool.  It may be called from interrupt
+ * context.
+ *
+ * @param pool  pool
+ * @param ptr   target buffer pointer
+ * @param size  target buffer size (in bytes)
+ *
+ * @return  number of bytes read from the pool
+ */
+size_t trng_pool_read(struct trng_pool *pool, void *ptr, size_t size);
+
+/**
+ * Get 32-bit random value
+ *
+ * Taken from the pool if it holds enough bytes, otherwise read from the
+ * TRNG itself, which blocks.
+ *
+ * @param pool  pool
+ *
+ * @return  random value
+ */
+uint32_t trng_pool_get_u32(struct trng_pool *pool);
+
+/**
+ * Number of bytes currently in the pool
+ */
+size_t trng_pool_avail(struct trng_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRNG_POOL_H__ */
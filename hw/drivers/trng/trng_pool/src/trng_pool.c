@@ -0,0 +1,228 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "trng/trng.h"
+#include "trng_pool/trng_pool.h"
+#include "tinycrypt/constants.h"
+
+/* Largest chunk generated at a time, bounds stack use during refill */
+#define TRNG_POOL_GEN_CHUNK     (64)
+
+static void
+trng_pool_collect(struct trng_pool *pool)
+{
+    pool->tp_seed_len += trng_read(pool->tp_trng,
+                                   &pool->tp_seed[pool->tp_seed_len],
+                                   sizeof(pool->tp_seed) - pool->tp_seed_len);
+}
+
+static void
+trng_pool_reseed(struct trng_pool *pool)
+{
+    int rc;
+
+    rc = tc_ctr_prng_reseed(&pool->tp_prng, pool->tp_seed,
+                            sizeof(pool->tp_seed), NULL, 0);
+    assert(rc == TC_CRYPTO_SUCCESS);
+    (void)rc;
+
+    memset(pool->tp_seed, 0, sizeof(pool->tp_seed));
+    pool->tp_seed_len = 0;
+    pool->tp_reseeds++;
+}
+
+/*
+ * Top the pool up from the DRBG.  Runs on the pool's eventq; the DRBG state
+ * is only ever touched from here (and from init), so it needs no locking.
+ */
+static void
+trng_pool_refill(struct trng_pool *pool)
+{
+    uint8_t chunk[TRNG_POOL_GEN_CHUNK];
+    uint16_t in;
+    int space;
+    int len;
+    int cnt;
+    int rc;
+    os_sr_t sr;
+
+    /* Mix in what the TRNG gathered since last time, once there's enough */
+    trng_pool_collect(pool);
+    if (pool->tp_seed_len == sizeof(pool->tp_seed)) {
+        trng_pool_reseed(pool);
+    }
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        space = sizeof(pool->tp_buf) - pool->tp_cnt;
+        OS_EXIT_CRITICAL(sr);
+
+        len = min(space, (int)sizeof(chunk));
+        if (len == 0) {
+            break;
+        }
+
+        rc = tc_ctr_prng_generate(&pool->tp_prng, NULL, 0, chunk, len);
+        if (rc == TC_CTR_PRNG_RESEED_REQ) {
+            /* Reseed is mandatory now, wait for the TRNG if needed */
+            while (pool->tp_seed_len < sizeof(pool->tp_seed)) {
+                trng_pool_collect(pool);
+                if (pool->tp_seed_len < sizeof(pool->tp_seed)) {
+                    os_time_delay(1);
+                }
+            }
+            trng_pool_reseed(pool);
+            continue;
+        }
+        assert(rc == TC_CRYPTO_SUCCESS);
+
+        /* Readers only remove data, so there is room for at least len */
+        OS_ENTER_CRITICAL(sr);
+        in = (pool->tp_out + pool->tp_cnt) % sizeof(pool->tp_buf);
+        cnt = min(len, (int)sizeof(pool->tp_buf) - in);
+        memcpy(&pool->tp_buf[in], chunk, cnt);
+        memcpy(pool->tp_buf, &chunk[cnt], len - cnt);
+        pool->tp_cnt += len;
+        if (pool->tp_cnt >= MYNEWT_VAL(TRNG_POOL_LOW_WATER)) {
+            pool->tp_low = 0;
+        }
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    memset(chunk, 0, sizeof(chunk));
+}
+
+static void
+trng_pool_refill_ev(struct os_event *ev)
+{
+    trng_pool_refill(ev->ev_arg);
+}
+
+int
+trng_pool_init(struct trng_pool *pool, struct trng_dev *trng,
+               struct os_eventq *evq)
+{
+    int rc;
+
+    assert(trng);
+
+    memset(pool, 0, sizeof(*pool));
+    pool->tp_trng = trng;
+    pool->tp_evq = evq ? evq : os_eventq_dflt_get();
+    pool->tp_refill_ev.ev_cb = trng_pool_refill_ev;
+    pool->tp_refill_ev.ev_arg = pool;
+
+    while (pool->tp_seed_len < sizeof(pool->tp_seed)) {
+        trng_pool_collect(pool);
+        if (pool->tp_seed_len < sizeof(pool->tp_seed)) {
+            os_time_delay(1);
+        }
+    }
+    rc = tc_ctr_prng_init(&pool->tp_prng, pool->tp_seed,
+                          sizeof(pool->tp_seed), NULL, 0);
+    memset(pool->tp_seed, 0, sizeof(pool->tp_seed));
+    pool->tp_seed_len = 0;
+    if (rc != TC_CRYPTO_SUCCESS) {
+        return SYS_EUNKNOWN;
+    }
+
+    trng_pool_refill(pool);
+
+    return 0;
+}
+
+void
+trng_pool_set_low_func(struct trng_pool *pool, trng_pool_low_func_t func,
+                       void *arg)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    pool->tp_low_func = func;
+    pool->tp_low_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+}
+
+size_t
+trng_pool_read(struct trng_pool *pool, void *ptr, size_t size)
+{
+    uint8_t *dst;
+    size_t cnt;
+    int notify;
+    os_sr_t sr;
+
+    dst = ptr;
+
+    OS_ENTER_CRITICAL(sr);
+    size = min(size, pool->tp_cnt);
+    cnt = min(size, sizeof(pool->tp_buf) - pool->tp_out);
+    memcpy(dst, &pool->tp_buf[pool->tp_out], cnt);
+    memcpy(dst + cnt, pool->tp_buf, size - cnt);
+    /* Bytes handed out must never be handed out again */
+    memset(&pool->tp_buf[pool->tp_out], 0, cnt);
+    memset(pool->tp_buf, 0, size - cnt);
+    pool->tp_out = (pool->tp_out + size) % sizeof(pool->tp_buf);
+    pool->tp_cnt -= size;
+
+    notify = 0;
+    if (pool->tp_cnt < MYNEWT_VAL(TRNG_POOL_LOW_WATER) && !pool->tp_low) {
+        pool->tp_low = 1;
+        notify = pool->tp_low_func != NULL;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (size > 0) {
+        os_eventq_put(pool->tp_evq, &pool->tp_refill_ev);
+    }
+    if (notify) {
+        pool->tp_low_func(pool, pool->tp_low_arg);
+    }
+
+    return size;
+}
+
+uint32_t
+trng_pool_get_u32(struct trng_pool *pool)
+{
+    uint32_t val;
+    os_sr_t sr;
+    int avail;
+
+    OS_ENTER_CRITICAL(sr);
+    avail = pool->tp_cnt >= sizeof(val);
+    if (avail) {
+        trng_pool_read(pool, &val, sizeof(val));
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (!avail) {
+        val = trng_get_u32(pool->tp_trng);
+    }
+
+    return val;
+}
+
+size_t
+trng_pool_avail(struct trng_pool *pool)
+{
+    return pool->tp_cnt;
+}
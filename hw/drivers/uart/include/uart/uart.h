@@ -66,6 +66,33 @@ typedef void (*uart_tx_done)(void *arg);
  */
 typedef int (*uart_rx_char)(void *arg, uint8_t byte);
 
+/*
+ * Function prototype for UART driver to ask for a block of data to send.
+ * Used instead of uart_tx_char by drivers which support it.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param sent		Number of bytes sent from the previous block.
+ * @param data		Set to point to the next block.  It must stay
+ *			unmodified until acknowledged by the next call.
+ *
+ * @return		Number of bytes in the block, 0 if no more data.
+ */
+typedef int (*uart_tx_block)(void *arg, int sent, const uint8_t **data);
+
+/*
+ * Function prototype for UART driver to report a block of incoming data.
+ * Used instead of uart_rx_char by drivers which support it.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param data		Received data, valid only during the call.
+ * @param len		Number of bytes received.
+ */
+typedef void (*uart_rx_block)(void *arg, const uint8_t *data, int len);
+
 struct uart_driver_funcs {
     void (*uf_start_tx)(struct uart_dev *);
     void (*uf_start_rx)(struct uart_dev *);
@@ -104,6 +131,10 @@ struct uart_conf {
     uart_rx_char uc_rx_char;
     uart_tx_done uc_tx_done;
     void *uc_cb_arg;
+    uart_tx_block uc_tx_block;  /* optional; uc_tx_char is still required */
+    uart_rx_block uc_rx_block;  /* optional; uc_rx_char is still required */
+    uint8_t *uc_rx_ring;        /* DMA receive ring for uc_rx_block */
+    int uc_rx_ring_len;
 };
 
 struct uart_dev {
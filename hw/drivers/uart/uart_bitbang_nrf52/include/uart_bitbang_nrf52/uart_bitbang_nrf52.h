@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __UART_BITBANG_NRF52_H__
+#define __UART_BITBANG_NRF52_H__
+
+#include <nrf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Software UART for nRF52 parts that run out of UARTE instances.
+ *
+ * TX plays each byte as a PWM sequence, one PWM period per bit, so whole
+ * chunks of bytes go out without CPU involvement.  RX timestamps every
+ * line edge in hardware (GPIOTE event -> PPI -> TIMER capture) and decodes
+ * the byte from the timestamps once its stop bit is due, so sampling does
+ * not depend on interrupt latency.
+ *
+ * Either pin can be -1 for a TX-only or RX-only port, in which case the
+ * corresponding peripherals are not needed.
+ */
+struct uart_bitbang_nrf52_conf {
+    int ubn_rxpin;
+    int ubn_txpin;
+    /* Free-running 16MHz timer for RX; uses CC[1] to CC[3] */
+    NRF_TIMER_Type *ubn_timer;
+    IRQn_Type ubn_timer_irqn;
+    /* PPI channel connecting the RX pin's GPIOTE event to the timer */
+    uint8_t ubn_ppi_ch;
+    /* PWM instance for TX */
+    NRF_PWM_Type *ubn_pwm;
+    IRQn_Type ubn_pwm_irqn;
+};
+
+struct os_dev;
+int uart_bitbang_nrf52_init(struct os_dev *, void *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_BITBANG_NRF52_H__ */
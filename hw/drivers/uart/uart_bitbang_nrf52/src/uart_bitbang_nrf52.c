@@ -0,0 +1,602 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include "os/mynewt.h"
+#include <hal/hal_gpio.h>
+#include <mcu/cmsis_nvic.h>
+#include <nrf.h>
+
+#include <uart/uart.h>
+
+#include "uart_bitbang_nrf52/uart_bitbang_nrf52.h"
+
+#if defined(NRF52840_XXAA)
+#define UBN_GPIOTE_PIN_MASK     (0x3FUL << GPIOTE_CONFIG_PSEL_Pos)
+#else
+#define UBN_GPIOTE_PIN_MASK     GPIOTE_CONFIG_PSEL_Msk
+#endif
+
+#define UBN_TIMER_FREQ          16000000UL
+
+/* Timer compare/capture registers used */
+#define UBN_CC_EDGE             1       /* edge timestamp, captured by PPI */
+#define UBN_CC_STOP             2       /* middle of the stop bit */
+#define UBN_CC_NOW              3       /* scratch for reading the time */
+
+/* Start bit, 8 data bits and the transition into the stop bit */
+#define UBN_RX_EDGES            10
+
+/* PWM slots per byte: start, 8 data bits, up to 2 stop bits */
+#define UBN_TX_SLOTS            11
+
+/*
+ * PWM sequence values for a line level held for a whole period.  The
+ * compare value is never reached since COUNTERTOP is kept below 0x7fff, so
+ * bit 15 (first edge polarity) alone decides the level.
+ */
+#define UBN_TX_HIGH             0x7fff
+#define UBN_TX_LOW              0xffff
+
+struct uart_bitbang_nrf52 {
+    struct uart_bitbang_nrf52_conf ub_conf;
+    /* Bit time, 1/256 timer ticks */
+    uint32_t ub_bittime_q8;
+    struct {
+        uint32_t start;         /* timestamp of the start bit edge */
+        uint32_t stop;          /* ticks from start to middle of stop bit */
+        uint32_t edges[UBN_RX_EDGES];   /* edge times relative to start */
+        uint8_t nedges;
+        uint8_t byte;           /* byte held while receiver is stalled */
+        uint8_t active:1;
+        uint8_t wait_high:1;    /* line low after a framing error */
+        uint8_t stall:1;
+        uint32_t framing_err;
+    } ub_rx;
+    struct {
+        uint16_t seq[UBN_TX_SLOTS * MYNEWT_VAL(UART_BITBANG_NRF52_TX_CHUNK)];
+        uint8_t stopbits;
+    } ub_tx;
+
+    uint8_t ub_open:1;
+    uint8_t ub_txing:1;
+    uart_rx_char ub_rx_func;
+    uart_tx_char ub_tx_func;
+    uart_tx_done ub_tx_done;
+    void *ub_func_arg;
+    SLIST_ENTRY(uart_bitbang_nrf52) ub_next;
+};
+
+/* All ports; they share one interrupt handler */
+static SLIST_HEAD(, uart_bitbang_nrf52) ubn_ports =
+    SLIST_HEAD_INITIALIZER(ubn_ports);
+
+static int
+ubn_tx_encode(struct uart_bitbang_nrf52 *ub, uint16_t *seq, uint8_t data)
+{
+    int i;
+
+    *seq++ = UBN_TX_LOW;
+    for (i = 0; i < 8; i++) {
+        *seq++ = (data & 0x01) ? UBN_TX_HIGH : UBN_TX_LOW;
+        data >>= 1;
+    }
+    for (i = 0; i < ub->ub_tx.stopbits; i++) {
+        *seq++ = UBN_TX_HIGH;
+    }
+
+    return 9 + ub->ub_tx.stopbits;
+}
+
+/*
+ * Queue the next chunk of bytes to the PWM, or stop if there are none.
+ * The line stays high (last value of the previous sequence) in between.
+ */
+static void
+ubn_tx_next(struct uart_bitbang_nrf52 *ub)
+{
+    NRF_PWM_Type *pwm;
+    int cnt;
+    int data;
+    int i;
+
+    pwm = ub->ub_conf.ubn_pwm;
+
+    cnt = 0;
+    for (i = 0; i < MYNEWT_VAL(UART_BITBANG_NRF52_TX_CHUNK); i++) {
+        data = ub->ub_tx_func(ub->ub_func_arg);
+        if (data < 0) {
+            break;
+        }
+        cnt += ubn_tx_encode(ub, &ub->ub_tx.seq[cnt], data);
+    }
+
+    if (cnt == 0) {
+        pwm->TASKS_STOP = 1;
+        if (ub->ub_txing && ub->ub_tx_done) {
+            ub->ub_tx_done(ub->ub_func_arg);
+        }
+        ub->ub_txing = 0;
+        return;
+    }
+
+    ub->ub_txing = 1;
+    pwm->SEQ[0].PTR = (uint32_t)ub->ub_tx.seq;
+    pwm->SEQ[0].CNT = cnt;
+    pwm->EVENTS_SEQEND[0] = 0;
+    pwm->TASKS_SEQSTART[0] = 1;
+}
+
+static void
+ubn_rx_deliver(struct uart_bitbang_nrf52 *ub, uint8_t byte)
+{
+    if (ub->ub_rx_func(ub->ub_func_arg, byte)) {
+        ub->ub_rx.byte = byte;
+        ub->ub_rx.stall = 1;
+        hal_gpio_irq_disable(ub->ub_conf.ubn_rxpin);
+    }
+}
+
+/*
+ * Decode the byte from the edge timestamps.  The line is low from the start
+ * edge and toggles at every following edge; each bit is taken at its
+ * middle.  Called with interrupts disabled.
+ */
+static void
+ubn_rx_done(struct uart_bitbang_nrf52 *ub)
+{
+    uint32_t center;
+    uint8_t byte;
+    int level;
+    int bit;
+    int e;
+
+    level = 0;
+    byte = 0;
+    e = 1;
+    for (bit = 0; bit < 9; bit++) {
+        center = ((2 * bit + 3) * ub->ub_bittime_q8 / 2) >> 8;
+        while (e < ub->ub_rx.nedges && ub->ub_rx.edges[e] < center) {
+            level ^= 1;
+            e++;
+        }
+        if (bit < 8) {
+            byte |= level << bit;
+        }
+    }
+    ub->ub_rx.active = 0;
+
+    if (!level) {
+        /* No stop bit.  If the line is still low, its next edge is not
+         * a start bit. */
+        ub->ub_rx.framing_err++;
+        ub->ub_rx.wait_high = !hal_gpio_read(ub->ub_conf.ubn_rxpin);
+        return;
+    }
+
+    ubn_rx_deliver(ub, byte);
+}
+
+/*
+ * GPIOTE interrupt for an RX line edge.  The edge time was already
+ * captured into CC[UBN_CC_EDGE] through PPI, so latency here only matters
+ * if it reaches a bit time and edges get lost.
+ */
+static void
+ubn_rx_edge(void *arg)
+{
+    struct uart_bitbang_nrf52 *ub;
+    NRF_TIMER_Type *timer;
+    uint32_t delta;
+    uint32_t t;
+    os_sr_t sr;
+
+    ub = arg;
+    timer = ub->ub_conf.ubn_timer;
+    t = timer->CC[UBN_CC_EDGE];
+
+    OS_ENTER_CRITICAL(sr);
+    if (ub->ub_rx.active) {
+        delta = t - ub->ub_rx.start;
+        if (delta < ub->ub_rx.stop) {
+            if (ub->ub_rx.nedges < UBN_RX_EDGES) {
+                ub->ub_rx.edges[ub->ub_rx.nedges++] = delta;
+            }
+            goto out;
+        }
+        /* Next start bit arrived before the stop compare was handled */
+        ubn_rx_done(ub);
+        if (ub->ub_rx.stall) {
+            goto out;
+        }
+    }
+    if (ub->ub_rx.wait_high) {
+        ub->ub_rx.wait_high = 0;
+        goto out;
+    }
+
+    ub->ub_rx.active = 1;
+    ub->ub_rx.start = t;
+    ub->ub_rx.edges[0] = 0;
+    ub->ub_rx.nedges = 1;
+    timer->EVENTS_COMPARE[UBN_CC_STOP] = 0;
+    timer->CC[UBN_CC_STOP] = t + ub->ub_rx.stop;
+out:
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+ubn_rx_stop(struct uart_bitbang_nrf52 *ub)
+{
+    NRF_TIMER_Type *timer;
+    os_sr_t sr;
+
+    timer = ub->ub_conf.ubn_timer;
+
+    OS_ENTER_CRITICAL(sr);
+    if (ub->ub_rx.active) {
+        timer->TASKS_CAPTURE[UBN_CC_NOW] = 1;
+        if (timer->CC[UBN_CC_NOW] - ub->ub_rx.start >= ub->ub_rx.stop) {
+            ubn_rx_done(ub);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+ubn_irq_handler(void)
+{
+    struct uart_bitbang_nrf52 *ub;
+    NRF_TIMER_Type *timer;
+    NRF_PWM_Type *pwm;
+
+    os_trace_isr_enter();
+
+    SLIST_FOREACH(ub, &ubn_ports, ub_next) {
+        if (!ub->ub_open) {
+            continue;
+        }
+        timer = ub->ub_conf.ubn_timer;
+        if (timer && timer->EVENTS_COMPARE[UBN_CC_STOP]) {
+            timer->EVENTS_COMPARE[UBN_CC_STOP] = 0;
+            ubn_rx_stop(ub);
+        }
+        pwm = ub->ub_conf.ubn_pwm;
+        if (pwm && pwm->EVENTS_SEQEND[0] &&
+            (pwm->INTEN & PWM_INTEN_SEQEND0_Msk)) {
+            pwm->EVENTS_SEQEND[0] = 0;
+            ubn_tx_next(ub);
+        }
+    }
+
+    os_trace_isr_exit();
+}
+
+static void
+uart_bitbang_nrf52_blocking_tx(struct uart_dev *dev, uint8_t data)
+{
+    struct uart_bitbang_nrf52 *ub;
+    uint16_t seq[UBN_TX_SLOTS];
+    NRF_PWM_Type *pwm;
+    os_sr_t sr;
+
+    ub = (struct uart_bitbang_nrf52 *)dev->ud_priv;
+    pwm = ub->ub_conf.ubn_pwm;
+    if (!ub->ub_open || !pwm) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (ub->ub_txing) {
+        /* Let the chunk being sent finish first */
+        while (!pwm->EVENTS_SEQEND[0]);
+    }
+    pwm->SEQ[0].PTR = (uint32_t)seq;
+    pwm->SEQ[0].CNT = ubn_tx_encode(ub, seq, data);
+    pwm->EVENTS_SEQEND[0] = 0;
+    pwm->TASKS_SEQSTART[0] = 1;
+    while (!pwm->EVENTS_SEQEND[0]);
+    if (!ub->ub_txing) {
+        pwm->EVENTS_SEQEND[0] = 0;
+        pwm->TASKS_STOP = 1;
+    }
+    /* Otherwise the pending SEQEND continues the interrupted transfer */
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+uart_bitbang_nrf52_start_tx(struct uart_dev *dev)
+{
+    struct uart_bitbang_nrf52 *ub;
+    os_sr_t sr;
+
+    ub = (struct uart_bitbang_nrf52 *)dev->ud_priv;
+    if (!ub->ub_open || !ub->ub_conf.ubn_pwm) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (!ub->ub_txing) {
+        ubn_tx_next(ub);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+uart_bitbang_nrf52_start_rx(struct uart_dev *dev)
+{
+    struct uart_bitbang_nrf52 *ub;
+    os_sr_t sr;
+
+    ub = (struct uart_bitbang_nrf52 *)dev->ud_priv;
+    if (!ub->ub_rx.stall) {
+        return;
+    }
+
+    if (ub->ub_rx_func(ub->ub_func_arg, ub->ub_rx.byte) == 0) {
+        OS_ENTER_CRITICAL(sr);
+        ub->ub_rx.stall = 0;
+        ub->ub_rx.active = 0;
+        ub->ub_rx.wait_high = !hal_gpio_read(ub->ub_conf.ubn_rxpin);
+        OS_EXIT_CRITICAL(sr);
+
+        /*
+         * Start looking for start bit again.
+         */
+        hal_gpio_irq_enable(ub->ub_conf.ubn_rxpin);
+    }
+}
+
+static int
+ubn_gpiote_find(int pin)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        if ((NRF_GPIOTE->CONFIG[i] & GPIOTE_CONFIG_MODE_Msk) ==
+            (GPIOTE_CONFIG_MODE_Event << GPIOTE_CONFIG_MODE_Pos) &&
+            (NRF_GPIOTE->CONFIG[i] & UBN_GPIOTE_PIN_MASK) ==
+            ((uint32_t)pin << GPIOTE_CONFIG_PSEL_Pos)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int
+ubn_rx_config(struct uart_bitbang_nrf52 *ub)
+{
+    const struct uart_bitbang_nrf52_conf *conf;
+    NRF_TIMER_Type *timer;
+    int ch;
+
+    conf = &ub->ub_conf;
+    timer = conf->ubn_timer;
+
+    /* Middle of the stop bit, 9.5 bit times after the start edge */
+    ub->ub_rx.stop = (19 * ub->ub_bittime_q8 / 2) >> 8;
+    ub->ub_rx.active = 0;
+    ub->ub_rx.stall = 0;
+    ub->ub_rx.wait_high = 0;
+
+    timer->TASKS_STOP = 1;
+    timer->TASKS_CLEAR = 1;
+    timer->MODE = TIMER_MODE_MODE_Timer;
+    timer->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    timer->PRESCALER = 0;
+    timer->INTENCLR = 0xffffffff;
+    timer->EVENTS_COMPARE[UBN_CC_STOP] = 0;
+    timer->INTENSET = TIMER_INTENSET_COMPARE0_Msk << UBN_CC_STOP;
+    NVIC_SetVector(conf->ubn_timer_irqn, (uint32_t)ubn_irq_handler);
+    NVIC_EnableIRQ(conf->ubn_timer_irqn);
+    timer->TASKS_START = 1;
+
+    if (hal_gpio_irq_init(conf->ubn_rxpin, ubn_rx_edge, ub,
+                          HAL_GPIO_TRIG_BOTH, HAL_GPIO_PULL_UP)) {
+        return -1;
+    }
+    ch = ubn_gpiote_find(conf->ubn_rxpin);
+    if (ch < 0) {
+        hal_gpio_irq_release(conf->ubn_rxpin);
+        return -1;
+    }
+
+    NRF_PPI->CH[conf->ubn_ppi_ch].EEP = (uint32_t)&NRF_GPIOTE->EVENTS_IN[ch];
+    NRF_PPI->CH[conf->ubn_ppi_ch].TEP =
+        (uint32_t)&timer->TASKS_CAPTURE[UBN_CC_EDGE];
+    NRF_PPI->CHENSET = 1UL << conf->ubn_ppi_ch;
+
+    hal_gpio_irq_enable(conf->ubn_rxpin);
+
+    return 0;
+}
+
+static int
+ubn_tx_config(struct uart_bitbang_nrf52 *ub, int32_t baudrate)
+{
+    const struct uart_bitbang_nrf52_conf *conf;
+    NRF_PWM_Type *pwm;
+    uint32_t top;
+    int prescaler;
+
+    conf = &ub->ub_conf;
+    pwm = conf->ubn_pwm;
+
+    /* Smallest prescaler giving a COUNTERTOP that fits */
+    for (prescaler = 0; prescaler <= 7; prescaler++) {
+        top = ((UBN_TIMER_FREQ >> prescaler) + baudrate / 2) / baudrate;
+        if (top < UBN_TX_HIGH) {
+            break;
+        }
+    }
+    if (prescaler > 7) {
+        return -1;
+    }
+
+    /* Idle level while the PWM is stopped */
+    if (hal_gpio_init_out(conf->ubn_txpin, 1)) {
+        return -1;
+    }
+
+    pwm->ENABLE = 0;
+    pwm->PSEL.OUT[0] = conf->ubn_txpin;
+    pwm->PSEL.OUT[1] = PWM_PSEL_OUT_CONNECT_Msk;
+    pwm->PSEL.OUT[2] = PWM_PSEL_OUT_CONNECT_Msk;
+    pwm->PSEL.OUT[3] = PWM_PSEL_OUT_CONNECT_Msk;
+    pwm->MODE = PWM_MODE_UPDOWN_Up;
+    pwm->PRESCALER = prescaler;
+    pwm->COUNTERTOP = top;
+    pwm->DECODER = (PWM_DECODER_LOAD_Common << PWM_DECODER_LOAD_Pos) |
+                   (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    pwm->LOOP = 0;
+    pwm->SEQ[0].REFRESH = 0;
+    pwm->SEQ[0].ENDDELAY = 0;
+    pwm->SHORTS = 0;
+    pwm->INTEN = PWM_INTEN_SEQEND0_Msk;
+    pwm->EVENTS_SEQEND[0] = 0;
+    NVIC_SetVector(conf->ubn_pwm_irqn, (uint32_t)ubn_irq_handler);
+    NVIC_EnableIRQ(conf->ubn_pwm_irqn);
+    pwm->ENABLE = PWM_ENABLE_ENABLE_Enabled;
+
+    return 0;
+}
+
+static int
+uart_bitbang_nrf52_config(struct uart_bitbang_nrf52 *ub, int32_t baudrate,
+  uint8_t databits, uint8_t stopbits, enum uart_parity parity,
+  enum uart_flow_ctl flow_ctl)
+{
+    if (databits != 8 || parity != UART_PARITY_NONE ||
+      flow_ctl != UART_FLOW_CTL_NONE) {
+        return -1;
+    }
+    if (stopbits != 1 && stopbits != 2) {
+        return -1;
+    }
+    if (baudrate <= 0 || baudrate > MYNEWT_VAL(UART_BITBANG_NRF52_MAX_BAUD)) {
+        return -1;
+    }
+
+    ub->ub_bittime_q8 = (UBN_TIMER_FREQ << 8) / baudrate;
+    ub->ub_tx.stopbits = stopbits;
+    ub->ub_txing = 0;
+
+    if (ub->ub_conf.ubn_txpin >= 0 && ubn_tx_config(ub, baudrate)) {
+        return -1;
+    }
+    if (ub->ub_conf.ubn_rxpin >= 0 && ubn_rx_config(ub)) {
+        return -1;
+    }
+
+    ub->ub_open = 1;
+    return 0;
+}
+
+static int
+uart_bitbang_nrf52_open(struct os_dev *odev, uint32_t wait, void *arg)
+{
+    struct uart_dev *dev = (struct uart_dev *)odev;
+    struct uart_bitbang_nrf52 *ub;
+    struct uart_conf *uc;
+
+    ub = (struct uart_bitbang_nrf52 *)dev->ud_priv;
+    uc = (struct uart_conf *)arg;
+
+    ub->ub_rx_func = uc->uc_rx_char;
+    ub->ub_tx_func = uc->uc_tx_char;
+    ub->ub_tx_done = uc->uc_tx_done;
+    ub->ub_func_arg = uc->uc_cb_arg;
+
+    if (uart_bitbang_nrf52_config(ub, uc->uc_speed, uc->uc_databits,
+        uc->uc_stopbits, uc->uc_parity, uc->uc_flow_ctl)) {
+        return OS_EINVAL;
+    }
+    return OS_OK;
+}
+
+static int
+uart_bitbang_nrf52_close(struct os_dev *odev)
+{
+    struct uart_dev *dev = (struct uart_dev *)odev;
+    struct uart_bitbang_nrf52 *ub;
+    const struct uart_bitbang_nrf52_conf *conf;
+    os_sr_t sr;
+
+    ub = (struct uart_bitbang_nrf52 *)dev->ud_priv;
+    conf = &ub->ub_conf;
+
+    OS_ENTER_CRITICAL(sr);
+    if (conf->ubn_rxpin >= 0) {
+        hal_gpio_irq_disable(conf->ubn_rxpin);
+        hal_gpio_irq_release(conf->ubn_rxpin);
+        NRF_PPI->CHENCLR = 1UL << conf->ubn_ppi_ch;
+        conf->ubn_timer->INTENCLR = 0xffffffff;
+        conf->ubn_timer->TASKS_STOP = 1;
+    }
+    if (conf->ubn_txpin >= 0) {
+        conf->ubn_pwm->INTEN = 0;
+        conf->ubn_pwm->TASKS_STOP = 1;
+        conf->ubn_pwm->ENABLE = 0;
+    }
+    ub->ub_open = 0;
+    ub->ub_txing = 0;
+    ub->ub_rx.active = 0;
+    ub->ub_rx.stall = 0;
+    OS_EXIT_CRITICAL(sr);
+    return OS_OK;
+}
+
+int
+uart_bitbang_nrf52_init(struct os_dev *odev, void *arg)
+{
+    struct uart_dev *dev = (struct uart_dev *)odev;
+    struct uart_bitbang_nrf52 *ub;
+    struct uart_bitbang_nrf52_conf *conf;
+
+    conf = (struct uart_bitbang_nrf52_conf *)arg;
+    if (conf->ubn_rxpin < 0 && conf->ubn_txpin < 0) {
+        return OS_EINVAL;
+    }
+    if ((conf->ubn_rxpin >= 0 && !conf->ubn_timer) ||
+        (conf->ubn_txpin >= 0 && !conf->ubn_pwm)) {
+        return OS_EINVAL;
+    }
+
+    ub = (struct uart_bitbang_nrf52 *)os_malloc(sizeof(*ub));
+    if (!ub) {
+        return OS_ENOMEM;
+    }
+    memset(ub, 0, sizeof(*ub));
+    ub->ub_conf = *conf;
+
+    OS_DEV_SETHANDLERS(odev, uart_bitbang_nrf52_open,
+                       uart_bitbang_nrf52_close);
+
+    dev->ud_funcs.uf_start_tx = uart_bitbang_nrf52_start_tx;
+    dev->ud_funcs.uf_start_rx = uart_bitbang_nrf52_start_rx;
+    dev->ud_funcs.uf_blocking_tx = uart_bitbang_nrf52_blocking_tx;
+    dev->ud_priv = ub;
+
+    SLIST_INSERT_HEAD(&ubn_ports, ub, ub_next);
+
+    return OS_OK;
+}
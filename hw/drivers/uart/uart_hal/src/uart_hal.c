@@ -95,6 +95,23 @@ uart_hal_open(struct os_dev *odev, uint32_t wait, void *arg)
         return OS_EINVAL;
     }
 
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    rc = hal_uart_init_tx_block(uart_hal_dev_get_id(dev), uc->uc_tx_block);
+    if (rc) {
+        return OS_EINVAL;
+    }
+#endif
+
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (uc->uc_rx_block) {
+        rc = hal_uart_init_rx_block(uart_hal_dev_get_id(dev), uc->uc_rx_block,
+                                    uc->uc_rx_ring, uc->uc_rx_ring_len);
+        if (rc) {
+            return OS_EINVAL;
+        }
+    }
+#endif
+
     rc = hal_uart_config(uart_hal_dev_get_id(dev), uc->uc_speed, uc->uc_databits,
       uc->uc_stopbits, (enum hal_uart_parity)uc->uc_parity, (enum hal_uart_flow_ctl)uc->uc_flow_ctl);
     if (rc) {
@@ -33,6 +33,23 @@ extern "C" {
 
 #include <inttypes.h>
 
+/**
+ * Operation counters for one flash device, kept when syscfg
+ * HAL_FLASH_STATS is set.
+ */
+struct hal_flash_stats {
+    /** Number of reads */
+    uint32_t reads;
+    /** Number of bytes read */
+    uint32_t read_bytes;
+    /** Number of writes */
+    uint32_t writes;
+    /** Number of bytes written */
+    uint32_t write_bytes;
+    /** Number of sectors erased */
+    uint32_t erases;
+};
+
 int hal_flash_ioctl(uint8_t flash_id, uint32_t cmd, void *args);
 int hal_flash_read(uint8_t flash_id, uint32_t address, void *dst,
   uint32_t num_bytes);
@@ -41,8 +58,21 @@ int hal_flash_write(uint8_t flash_id, uint32_t address, const void *src,
 int hal_flash_erase_sector(uint8_t flash_id, uint32_t sector_address);
 int hal_flash_erase(uint8_t flash_id, uint32_t address, uint32_t num_bytes);
 int hal_flash_isempty(uint8_t flash_id, uint32_t address, uint32_t num_bytes);
+/*
+ * Get a pointer through which the CPU can read flash directly.  Returns
+ * SYS_ENOTSUP if the flash is not memory mapped.
+ */
+int hal_flash_map(uint8_t flash_id, uint32_t address, uint32_t num_bytes,
+  const void **ptr);
 uint8_t hal_flash_align(uint8_t flash_id);
 int hal_flash_init(void);
+/*
+ * Read the operation counters of a flash device.  If reset is non-zero the
+ * counters are cleared after reading.  Returns SYS_ENOTSUP unless syscfg
+ * HAL_FLASH_STATS is set.
+ */
+int hal_flash_get_stats(uint8_t flash_id, struct hal_flash_stats *stats,
+  int reset);
 
 #ifdef __cplusplus
 }
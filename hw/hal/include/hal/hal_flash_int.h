@@ -43,6 +43,9 @@ struct hal_flash_funcs {
     int (*hff_is_empty)(const struct hal_flash *dev, uint32_t address,
             uint32_t num_bytes);
     int (*hff_init)(const struct hal_flash *dev);
+    /* Optional; for flash which the CPU can read directly. */
+    int (*hff_map)(const struct hal_flash *dev, uint32_t address,
+            uint32_t num_bytes, const void **ptr);
 };
 
 struct hal_flash {
@@ -64,6 +67,13 @@ uint32_t hal_flash_sector_size(const struct hal_flash *hf, int sec_idx);
 int hal_flash_is_zeroes(const struct hal_flash *, uint32_t, uint32_t);
 int hal_flash_is_ones(const struct hal_flash *, uint32_t, uint32_t);
 
+/*
+ * Use as hal_flash_funcs.hff_map if flash is readable by the CPU at its
+ * device address.
+ */
+int hal_flash_map_direct(const struct hal_flash *, uint32_t, uint32_t,
+        const void **);
+
 #ifdef __cplusplus
 }
 #endif
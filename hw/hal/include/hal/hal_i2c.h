@@ -79,6 +79,18 @@ extern "C" {
 /** Slave responded to data byte with NACK. */
 #define HAL_I2C_ERR_DATA_NACK           5
 
+/** A non-blocking transfer is already in progress. */
+#define HAL_I2C_ERR_BUSY                6
+
+/**
+ * Completion callback of a non-blocking transfer, called from interrupt
+ * context.
+ *
+ * @param arg The argument passed when the transfer was started
+ * @param status 0 on success, HAL_I2C_ERR_[...] code on failure
+ */
+typedef void (*hal_i2c_xfer_cb)(void *arg, int status);
+
 /**
  * When sending a packet, use this structure to pass the arguments.
  */
@@ -162,6 +174,36 @@ int hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
 int hal_i2c_master_probe(uint8_t i2c_num, uint8_t address,
                          uint32_t timeout);
 
+/**
+ * Starts a transfer in the background and returns immediately. The bytes in
+ * wbuf are written first, then rlen bytes are read into rbuf after a
+ * repeated start, and the transfer ends with a stop condition. Either
+ * length may be zero for a plain write or read.
+ *
+ * The buffers must stay valid until the callback has been called, and the
+ * blocking API must not be used on the same interface in the meantime.
+ * Platforms transfer with DMA and may restrict the buffers (e.g. to RAM) or
+ * the write length of combined transfers; such requests fail with
+ * HAL_I2C_ERR_INVAL.
+ *
+ * @param i2c_num The number of the I2C device
+ * @param address The 7-bit slave address
+ * @param wbuf Data to write, may be NULL if wlen is 0
+ * @param wlen Number of bytes to write
+ * @param rbuf Buffer to read into, may be NULL if rlen is 0
+ * @param rlen Number of bytes to read
+ * @param cb Function called once the transfer has completed
+ * @param arg Argument passed to cb
+ *
+ * @return 0 if the transfer was started, HAL_I2C_ERR_BUSY if another
+ *         non-blocking transfer is in progress, non-zero error code on
+ *         other failures
+ */
+int hal_i2c_master_xfer_nb(uint8_t i2c_num, uint8_t address,
+                           const uint8_t *wbuf, uint16_t wlen,
+                           uint8_t *rbuf, uint16_t rlen,
+                           hal_i2c_xfer_cb cb, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -60,6 +60,23 @@ extern "C" {
 /* Prototype for tx/rx callback */
 typedef void (*hal_spi_txrx_cb)(void *arg, int len);
 
+/** Deassert chip select after this segment and reassert it for the next */
+#define HAL_SPI_SEG_CS_TOGGLE       (0x01)
+
+/**
+ * One segment of a chained transfer, see hal_spi_txrx_chain_noblock().
+ */
+struct hal_spi_seg {
+    /** Values to send, NULL to send 0xff */
+    void            *tx_buf;
+    /** Buffer for received values, NULL to discard them */
+    void            *rx_buf;
+    /** Number of values in the segment */
+    uint16_t        len;
+    /** HAL_SPI_SEG_xxx flags */
+    uint8_t         flags;
+};
+
 /**
  * since one spi device can control multiple devices, some configuration
  * can be changed on the fly from the hal
@@ -214,6 +231,35 @@ int hal_spi_txrx(int spi_num, void *txbuf, void *rxbuf, int cnt);
  */
 int hal_spi_txrx_noblock(int spi_num, void *txbuf, void *rxbuf, int cnt);
 
+/**
+ * Non-blocking interface to run a chain of transfers back to back, e.g. a
+ * command, an address and a data phase, with a single completion callback.
+ * Segments are started from the transfer complete interrupt without task
+ * involvement. Chip select is asserted before the first segment and
+ * deasserted after the last one, and additionally toggled after segments
+ * flagged with HAL_SPI_SEG_CS_TOGGLE.
+ *
+ * Segments, and the buffers they point to, must stay valid until the
+ * callback is called. A segment cannot have both buffers NULL. Platforms
+ * may limit the segment length, e.g. to their DMA transfer size.
+ *
+ *     MASTER: runs the chain.
+ *     SLAVE: cannot be called for a slave; returns -1
+ *
+ * @param spi_num   SPI interface to use
+ * @param cs_pin    Chip select pin, active low, or -1 if not driven
+ * @param segs      Array of segments
+ * @param nsegs     Number of segments, at most 255
+ * @param cb        Called at interrupt context with the total number of
+ *                  values transferred once the chain has completed
+ * @param arg       Argument passed to cb
+ *
+ * @return int 0 on success, non-zero error code on failure.
+ */
+int hal_spi_txrx_chain_noblock(int spi_num, int cs_pin,
+                               const struct hal_spi_seg *segs, int nsegs,
+                               hal_spi_txrx_cb cb, void *arg);
+
 /**
  * Sets the default value transferred by the slave. Not valid for master
  *
@@ -60,6 +60,22 @@ struct hal_timer {
     TAILQ_ENTRY(hal_timer) link;    /* Queue linked list structure */
 };
 
+/**
+ * Dispatch latency of the timers on one HW timer, in ticks from the expiry
+ * tick to the callback being called. The spread between lat_min and
+ * lat_max is the jitter seen by timer users.
+ */
+struct hal_timer_stats {
+    /** Number of timers that expired */
+    uint32_t expired;
+    /** Latency of the most recently expired timer */
+    uint32_t lat_last;
+    /** Smallest latency seen */
+    uint32_t lat_min;
+    /** Largest latency seen */
+    uint32_t lat_max;
+};
+
 /**
  * Initialize a HW timer.
  *
@@ -161,6 +177,19 @@ int hal_timer_start_at(struct hal_timer *tmr, uint32_t tick);
  */
 int hal_timer_stop(struct hal_timer *tmr);
 
+/**
+ * Read the dispatch latency statistics of a HW timer. Only available when
+ * syscfg HAL_TIMER_STATS is set, and on MCUs which implement it.
+ *
+ * @param timer_num The number of the HW timer
+ * @param stats     Filled in with the statistics
+ * @param reset     If non-zero, statistics are cleared after reading
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int hal_timer_get_stats(int timer_num, struct hal_timer_stats *stats,
+                        int reset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,6 +57,29 @@ typedef void (*hal_uart_tx_done)(void *arg);
  */
 typedef int (*hal_uart_rx_char)(void *arg, uint8_t byte);
 
+/**
+ * Function prototype for UART driver to ask for a block of data to send.
+ * Used instead of hal_uart_tx_char when registered with
+ * hal_uart_init_tx_block().  The driver reports how many bytes of the
+ * previously returned block were sent, which may be fewer than were
+ * offered, and the callee sets *data to the next block.  The block must
+ * remain valid and unmodified until it is acknowledged by the next call.
+ * Returns the number of bytes in the block, 0 if no more data is available.
+ * Driver must call this with interrupts disabled.
+ */
+typedef int (*hal_uart_tx_block)(void *arg, int sent, const uint8_t **data);
+
+/**
+ * Function prototype for UART driver to report a block of incoming data.
+ * Used instead of hal_uart_rx_char when registered with
+ * hal_uart_init_rx_block().  Called when half of the ring buffer has been
+ * filled, when the ring wraps, and when the line goes idle with data
+ * pending.  Reception continues while the callback runs, so the data must
+ * be consumed before the call returns.
+ * Driver must call this with interrupts disabled.
+ */
+typedef void (*hal_uart_rx_block)(void *arg, const uint8_t *data, int len);
+
 /**
  * Initializes given uart. Mapping of logical UART number to physical
  * UART/GPIO pins is in BSP.
@@ -64,6 +87,38 @@ typedef int (*hal_uart_rx_char)(void *arg, uint8_t byte);
 int hal_uart_init_cbs(int uart, hal_uart_tx_char tx_func,
   hal_uart_tx_done tx_done, hal_uart_rx_char rx_func, void *arg);
 
+/**
+ * Registers a block transmit callback for given uart.  Must be called after
+ * hal_uart_init_cbs() and before hal_uart_config().  Only available when
+ * syscfg HAL_UART_TX_BLOCK is set, and on MCUs which implement it.  Drivers
+ * with DMA transmit the block directly from the caller's memory.
+ *
+ * @param uart      The uart number
+ * @param tx_block  Block callback; NULL reverts to the tx_char callback.
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+int hal_uart_init_tx_block(int uart, hal_uart_tx_block tx_block);
+
+/**
+ * Registers a block receive callback for given uart, along with the ring
+ * buffer the driver receives into by DMA.  Must be called after
+ * hal_uart_init_cbs() and before hal_uart_config().  Only available when
+ * syscfg HAL_UART_RX_BLOCK is set, and on MCUs which implement it.  The
+ * ring must be in RAM, and is owned by the driver until the uart is closed.
+ * Data arriving faster than the callback consumes half a ring overwrites
+ * older data.
+ *
+ * @param uart      The uart number
+ * @param rx_block  Block callback; NULL reverts to the rx_char callback.
+ * @param ring      Ring buffer to receive into.
+ * @param ring_len  Size of the ring buffer, in bytes.
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+int hal_uart_init_rx_block(int uart, hal_uart_rx_block rx_block,
+  uint8_t *ring, int ring_len);
+
 enum hal_uart_parity {
     /** No Parity */
     HAL_UART_PARITY_NONE = 0,
@@ -26,6 +26,20 @@
 #include "hal/hal_flash.h"
 #include "hal/hal_flash_int.h"
 
+#if MYNEWT_VAL(HAL_FLASH_STATS)
+static struct hal_flash_stats
+    hal_flash_stats[MYNEWT_VAL(HAL_FLASH_STATS_MAX_DEVS)];
+
+#define HAL_FLASH_STATS_ADD(id, field, n)                               \
+    do {                                                                \
+        if ((id) < MYNEWT_VAL(HAL_FLASH_STATS_MAX_DEVS)) {              \
+            hal_flash_stats[(id)].field += (n);                         \
+        }                                                               \
+    } while (0)
+#else
+#define HAL_FLASH_STATS_ADD(id, field, n)
+#endif
+
 int
 hal_flash_init(void)
 {
@@ -91,6 +105,8 @@ hal_flash_read(uint8_t id, uint32_t address, void *dst, uint32_t num_bytes)
       hal_flash_check_addr(hf, address + num_bytes)) {
         return -1;
     }
+    HAL_FLASH_STATS_ADD(id, reads, 1);
+    HAL_FLASH_STATS_ADD(id, read_bytes, num_bytes);
     return hf->hf_itf->hff_read(hf, address, dst, num_bytes);
 }
 
@@ -196,6 +212,8 @@ hal_flash_write(uint8_t id, uint32_t address, const void *src,
         return -1;
     }
 
+    HAL_FLASH_STATS_ADD(id, writes, 1);
+    HAL_FLASH_STATS_ADD(id, write_bytes, num_bytes);
     rc = hf->hf_itf->hff_write(hf, address, src, num_bytes);
     if (rc != 0) {
         return rc;
@@ -229,6 +247,7 @@ hal_flash_erase_sector(uint8_t id, uint32_t sector_address)
         return -1;
     }
 
+    HAL_FLASH_STATS_ADD(id, erases, 1);
     rc = hf->hf_itf->hff_erase_sector(hf, sector_address);
     if (rc != 0) {
         return rc;
@@ -286,6 +305,7 @@ hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
              * If some region of eraseable area falls inside sector,
              * erase the sector.
              */
+            HAL_FLASH_STATS_ADD(id, erases, 1);
             if (hf->hf_itf->hff_erase_sector(hf, start)) {
                 return -1;
             }
@@ -358,8 +378,59 @@ hal_flash_isempty(uint8_t id, uint32_t address, uint32_t num_bytes)
     }
 }
 
+int
+hal_flash_map_direct(const struct hal_flash *hf, uint32_t address,
+                     uint32_t num_bytes, const void **ptr)
+{
+    *ptr = (const void *)address;
+    return 0;
+}
+
+int
+hal_flash_map(uint8_t id, uint32_t address, uint32_t num_bytes,
+              const void **ptr)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return -1;
+    }
+    if (hal_flash_check_addr(hf, address) ||
+      hal_flash_check_addr(hf, address + num_bytes)) {
+        return -1;
+    }
+    if (!hf->hf_itf->hff_map) {
+        return SYS_ENOTSUP;
+    }
+    return hf->hf_itf->hff_map(hf, address, num_bytes, ptr);
+}
+
 int
 hal_flash_ioctl(uint8_t id, uint32_t cmd, void *args)
 {
     return 0;
 }
+
+int
+hal_flash_get_stats(uint8_t id, struct hal_flash_stats *stats, int reset)
+{
+#if MYNEWT_VAL(HAL_FLASH_STATS)
+    os_sr_t sr;
+
+    if (id >= MYNEWT_VAL(HAL_FLASH_STATS_MAX_DEVS)) {
+        return SYS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    *stats = hal_flash_stats[id];
+    if (reset) {
+        memset(&hal_flash_stats[id], 0, sizeof(hal_flash_stats[id]));
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+#else
+    return SYS_ENOTSUP;
+#endif
+}
@@ -45,7 +45,8 @@ static const struct hal_flash_funcs apollo2_flash_funcs = {
     .hff_write = apollo2_flash_write,
     .hff_erase_sector = apollo2_flash_erase_sector,
     .hff_sector_info = apollo2_flash_sector_info,
-    .hff_init = apollo2_flash_init
+    .hff_init = apollo2_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 const struct hal_flash apollo2_flash_dev = {
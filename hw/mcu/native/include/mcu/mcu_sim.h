@@ -19,6 +19,8 @@
 #ifndef __MCU_SIM_H__
 #define __MCU_SIM_H__
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +33,12 @@ extern const char *native_uart_dev_strs[];
 
 void mcu_sim_parse_args(int argc, char **argv);
 
+/*
+ * Number of times emulated flash sector idx has been erased since start-up,
+ * for wear simulation.
+ */
+uint32_t native_flash_erase_count(int idx);
+
 #ifdef __cplusplus
 }
 #endif
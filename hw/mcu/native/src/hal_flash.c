@@ -23,11 +23,13 @@
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "os/mynewt.h"
 
 #include "hal/hal_flash_int.h"
 #include "mcu/mcu_sim.h"
+#include "sim/sim.h"
 
 char *native_flash_file;
 static int file;
@@ -42,13 +44,16 @@ static int native_flash_erase_sector(const struct hal_flash *dev,
         uint32_t sector_address);
 static int native_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *size);
+static int native_flash_map(const struct hal_flash *dev, uint32_t address,
+        uint32_t length, const void **ptr);
 
 static const struct hal_flash_funcs native_flash_funcs = {
     .hff_read = native_flash_read,
     .hff_write = native_flash_write,
     .hff_erase_sector = native_flash_erase_sector,
     .hff_sector_info = native_flash_sector_info,
-    .hff_init = native_flash_init
+    .hff_init = native_flash_init,
+    .hff_map = native_flash_map
 };
 
 #if MYNEWT_VAL(MCU_FLASH_STYLE_ST)
@@ -83,12 +88,39 @@ const struct hal_flash native_flash_dev = {
     .hf_align = MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE),
 };
 
+static uint32_t native_flash_erases[FLASH_NUM_AREAS];
+
+#if MYNEWT_VAL(MCU_FLASH_SIM_TIMING)
+/*
+ * Charge the time the operation would take on real flash to simulated time,
+ * as the CPU would stall for it.
+ */
+#define flash_native_busy(ns)   sim_time_charge(ns)
+#else
+#define flash_native_busy(ns)
+#endif
+
 static void
 flash_native_erase(uint32_t addr, uint32_t len)
 {
     memset(file_loc + addr, 0xff, len);
 }
 
+/*
+ * A forked child (e.g. a test suite run by testutil in its own process)
+ * gets a copy-on-write view of the flash, so it cannot disturb the parent
+ * or its siblings.
+ */
+static void
+flash_native_atfork_child(void)
+{
+    void *loc;
+
+    loc = mmap(file_loc, native_flash_dev.hf_size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_FIXED, file, 0);
+    assert(loc == file_loc);
+}
+
 static void
 flash_native_file_open(char *name)
 {
@@ -121,6 +153,8 @@ flash_native_file_open(char *name)
     if (created) {
         flash_native_erase(0, native_flash_dev.hf_size);
     }
+
+    pthread_atfork(NULL, NULL, flash_native_atfork_child);
 }
 
 static void
@@ -171,6 +205,8 @@ flash_native_write_internal(uint32_t address, const void *src, uint32_t length,
     }
 
     memcpy((char *)file_loc + address, src, length);
+    flash_native_busy((uint64_t)length *
+                      MYNEWT_VAL(MCU_FLASH_SIM_WRITE_NS_PER_BYTE));
 
     return 0;
 }
@@ -196,6 +232,18 @@ native_flash_read(const struct hal_flash *dev, uint32_t address, void *dst,
 {
     flash_native_ensure_file_open();
     memcpy(dst, (char *)file_loc + address, length);
+    flash_native_busy((uint64_t)length *
+                      MYNEWT_VAL(MCU_FLASH_SIM_READ_NS_PER_BYTE));
+
+    return 0;
+}
+
+static int
+native_flash_map(const struct hal_flash *dev, uint32_t address,
+        uint32_t length, const void **ptr)
+{
+    flash_native_ensure_file_open();
+    *ptr = (char *)file_loc + address;
 
     return 0;
 }
@@ -241,9 +289,20 @@ native_flash_erase_sector(const struct hal_flash *dev, uint32_t sector_address)
     }
     len = flash_sector_len(area_id);
     flash_native_erase(sector_address, len);
+    native_flash_erases[area_id]++;
+    flash_native_busy((uint64_t)MYNEWT_VAL(MCU_FLASH_SIM_ERASE_US) * 1000);
     return 0;
 }
 
+uint32_t
+native_flash_erase_count(int idx)
+{
+    if (idx < 0 || idx >= FLASH_NUM_AREAS) {
+        return 0;
+    }
+    return native_flash_erases[idx];
+}
+
 static int
 native_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *size)
@@ -21,12 +21,21 @@
 #include "os/mynewt.h"
 #include "hal/hal_i2c.h"
 #include "mcu/mcu_sim_i2c.h"
+#include "sim/sim.h"
 
 struct {
     struct os_mutex mgr_lock;
     SLIST_HEAD(, hal_i2c_sim_driver) mgr_sim_list;
 } hal_i2c_sim_mgr;
 
+#if MYNEWT_VAL(MCU_I2C_SIM_TIMING)
+#define hal_i2c_sim_busy(len)                                       \
+    sim_time_charge(MYNEWT_VAL(MCU_I2C_SIM_XFER_NS) +               \
+                    (uint64_t)(len) * MYNEWT_VAL(MCU_I2C_SIM_NS_PER_BYTE))
+#else
+#define hal_i2c_sim_busy(len)
+#endif
+
 int
 hal_i2c_init(uint8_t i2c_num, void *cfg)
 {
@@ -45,6 +54,7 @@ hal_i2c_master_write(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
     SLIST_FOREACH(cursor, &hal_i2c_sim_mgr.mgr_sim_list, s_next) {
         if (cursor->addr == pdata->address) {
             /* Forward the read request to the sim driver */
+            hal_i2c_sim_busy(pdata->len);
             return cursor->sd_write(i2c_num, pdata, timeout, last_op);
         }
     }
@@ -62,6 +72,7 @@ hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
     SLIST_FOREACH(cursor, &hal_i2c_sim_mgr.mgr_sim_list, s_next) {
         if (cursor->addr == pdata->address) {
             /* Forward the read request to the sim driver */
+            hal_i2c_sim_busy(pdata->len);
             return cursor->sd_read(i2c_num, pdata, timeout, last_op);
         }
     }
@@ -78,6 +89,7 @@ hal_i2c_master_probe(uint8_t i2c_num, uint8_t address,
     cursor = NULL;
     SLIST_FOREACH(cursor, &hal_i2c_sim_mgr.mgr_sim_list, s_next) {
         if (cursor->addr == address) {
+            hal_i2c_sim_busy(0);
             return 0;
         }
     }
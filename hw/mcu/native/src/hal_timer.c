@@ -21,6 +21,7 @@
 #include "os/mynewt.h"
 
 #include "hal/hal_timer.h"
+#include "sim/sim.h"
 
 /*
  * For native cpu implementation.
@@ -169,6 +170,7 @@ hal_timer_read(int num)
     os_sr_t sr;
     uint32_t ostime;
     uint32_t delta_osticks;
+    uint32_t subtick;
 
     if (num != 0) {
         return -1;
@@ -182,9 +184,15 @@ hal_timer_read(int num)
         nt->cnt += nt->ticks_per_ostick * delta_osticks;
 
     }
+    /*
+     * Time charged by the device models that has not made up a full OS tick
+     * yet.  It is folded into OS time, and thus into cnt, later.
+     */
+    subtick = (uint64_t)sim_time_subtick_usecs() * nt->ticks_per_ostick /
+              (1000000 / OS_TICKS_PER_SEC);
     OS_EXIT_CRITICAL(sr);
 
-    return (uint32_t)nt->cnt;
+    return (uint32_t)(nt->cnt + subtick);
 }
 
 /**
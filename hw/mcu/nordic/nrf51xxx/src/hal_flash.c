@@ -42,7 +42,8 @@ static const struct hal_flash_funcs nrf51_flash_funcs = {
     .hff_write = nrf51_flash_write,
     .hff_erase_sector = nrf51_flash_erase_sector,
     .hff_sector_info = nrf51_flash_sector_info,
-    .hff_init = nrf51_flash_init
+    .hff_init = nrf51_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 const struct hal_flash nrf51_flash_dev = {
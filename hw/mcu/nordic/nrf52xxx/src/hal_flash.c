@@ -40,7 +40,8 @@ static const struct hal_flash_funcs nrf52k_flash_funcs = {
     .hff_write = nrf52k_flash_write,
     .hff_erase_sector = nrf52k_flash_erase_sector,
     .hff_sector_info = nrf52k_flash_sector_info,
-    .hff_init = nrf52k_flash_init
+    .hff_init = nrf52k_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 #ifdef NRF52840_XXAA
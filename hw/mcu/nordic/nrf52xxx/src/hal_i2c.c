@@ -49,16 +49,25 @@
 
 struct nrf52_hal_i2c {
     NRF_TWI_Type *nhi_regs;
+    IRQn_Type nhi_irq;
+    /* FREQUENCY register values in TWI and TWIM mode */
+    uint32_t nhi_twi_freq;
+    uint32_t nhi_twim_freq;
+    /* Completion callback of the non-blocking transfer in progress */
+    hal_i2c_xfer_cb nhi_cb;
+    void *nhi_cb_arg;
 };
 
 #if MYNEWT_VAL(I2C_0)
 struct nrf52_hal_i2c hal_twi_i2c0 = {
-    .nhi_regs = NRF_TWI0
+    .nhi_regs = NRF_TWI0,
+    .nhi_irq = SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn
 };
 #endif
 #if MYNEWT_VAL(I2C_1)
 struct nrf52_hal_i2c hal_twi_i2c1 = {
-    .nhi_regs = NRF_TWI1
+    .nhi_regs = NRF_TWI1,
+    .nhi_irq = SPIM1_SPIS1_TWIM1_TWIS1_SPI1_TWI1_IRQn
 };
 #endif
 
@@ -260,6 +269,7 @@ hal_i2c_init(uint8_t i2c_num, void *usercfg)
     NRF_TWI_Type *regs;
     struct nrf52_hal_i2c_cfg *cfg;
     uint32_t freq;
+    uint32_t twim_freq;
     int rc;
     NRF_GPIO_Type *scl_port, *sda_port;
 
@@ -276,12 +286,15 @@ hal_i2c_init(uint8_t i2c_num, void *usercfg)
     switch (cfg->i2c_frequency) {
     case 100:
         freq = TWI_FREQUENCY_FREQUENCY_K100;
+        twim_freq = TWIM_FREQUENCY_FREQUENCY_K100;
         break;
     case 250:
         freq = TWI_FREQUENCY_FREQUENCY_K250;
+        twim_freq = TWIM_FREQUENCY_FREQUENCY_K250;
         break;
     case 400:
         freq = TWI_FREQUENCY_FREQUENCY_K400;
+        twim_freq = TWIM_FREQUENCY_FREQUENCY_K400;
         break;
     default:
         rc = HAL_I2C_ERR_INVAL;
@@ -302,6 +315,9 @@ hal_i2c_init(uint8_t i2c_num, void *usercfg)
     regs->FREQUENCY = freq;
     regs->ENABLE = TWI_ENABLE_ENABLE_Enabled;
 
+    i2c->nhi_twi_freq = freq;
+    i2c->nhi_twim_freq = twim_freq;
+
     return (0);
 err:
     return (rc);
@@ -478,3 +494,152 @@ hal_i2c_master_probe(uint8_t i2c_num, uint8_t address, uint32_t timo)
 
     return hal_i2c_master_read(i2c_num, &rx, timo, 1);
 }
+
+/*
+ * Non-blocking transfers switch the peripheral to TWIM mode, which shares
+ * its pin and address registers with TWI, and let EasyDMA move the data.
+ * The blocking API keeps using TWI mode, restored once a transfer is done.
+ */
+static void
+hal_i2c_nb_irq(struct nrf52_hal_i2c *i2c)
+{
+    NRF_TWIM_Type *twim;
+    hal_i2c_xfer_cb cb;
+    uint32_t nrf_status;
+
+    os_trace_isr_enter();
+
+    twim = (NRF_TWIM_Type *)i2c->nhi_regs;
+
+    if (twim->EVENTS_ERROR && !twim->EVENTS_STOPPED) {
+        /* Transfer is aborted, completion is reported once stopped */
+        twim->EVENTS_ERROR = 0;
+        twim->INTENCLR = TWIM_INTENCLR_ERROR_Msk;
+        twim->SHORTS = 0;
+        twim->TASKS_RESUME = 1;
+        twim->TASKS_STOP = 1;
+        os_trace_isr_exit();
+        return;
+    }
+
+    if (twim->EVENTS_STOPPED) {
+        twim->EVENTS_STOPPED = 0;
+        twim->EVENTS_ERROR = 0;
+        twim->INTENCLR = TWIM_INTENCLR_STOPPED_Msk | TWIM_INTENCLR_ERROR_Msk;
+        twim->SHORTS = 0;
+
+        nrf_status = twim->ERRORSRC;
+        twim->ERRORSRC = nrf_status;
+
+        twim->ENABLE = TWIM_ENABLE_ENABLE_Disabled;
+        i2c->nhi_regs->FREQUENCY = i2c->nhi_twi_freq;
+        i2c->nhi_regs->ENABLE = TWI_ENABLE_ENABLE_Enabled;
+
+        cb = i2c->nhi_cb;
+        i2c->nhi_cb = NULL;
+        cb(i2c->nhi_cb_arg, hal_i2c_convert_status(nrf_status));
+    }
+
+    os_trace_isr_exit();
+}
+
+#if MYNEWT_VAL(I2C_0)
+static void
+hal_i2c0_nb_irq(void)
+{
+    hal_i2c_nb_irq(&hal_twi_i2c0);
+}
+#endif
+
+#if MYNEWT_VAL(I2C_1)
+static void
+hal_i2c1_nb_irq(void)
+{
+    hal_i2c_nb_irq(&hal_twi_i2c1);
+}
+#endif
+
+int
+hal_i2c_master_xfer_nb(uint8_t i2c_num, uint8_t address,
+                       const uint8_t *wbuf, uint16_t wlen,
+                       uint8_t *rbuf, uint16_t rlen,
+                       hal_i2c_xfer_cb cb, void *arg)
+{
+    struct nrf52_hal_i2c *i2c;
+    NRF_TWIM_Type *twim;
+    uint32_t irqh;
+    os_sr_t sr;
+    int rc;
+
+    rc = hal_i2c_resolve(i2c_num, &i2c);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (!cb || (!wlen && !rlen) ||
+        wlen > TWIM_TXD_MAXCNT_MAXCNT_Msk ||
+        rlen > TWIM_RXD_MAXCNT_MAXCNT_Msk ||
+        (wlen && !nrfx_is_in_ram(wbuf)) ||
+        (rlen && !nrfx_is_in_ram(rbuf))) {
+        return HAL_I2C_ERR_INVAL;
+    }
+
+    switch (i2c_num) {
+#if MYNEWT_VAL(I2C_0)
+    case 0:
+        irqh = (uint32_t)hal_i2c0_nb_irq;
+        break;
+#endif
+#if MYNEWT_VAL(I2C_1)
+    case 1:
+        irqh = (uint32_t)hal_i2c1_nb_irq;
+        break;
+#endif
+    default:
+        return HAL_I2C_ERR_INVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (i2c->nhi_cb) {
+        OS_EXIT_CRITICAL(sr);
+        return HAL_I2C_ERR_BUSY;
+    }
+    i2c->nhi_cb = cb;
+    i2c->nhi_cb_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+
+    i2c->nhi_regs->ENABLE = TWI_ENABLE_ENABLE_Disabled;
+
+    twim = (NRF_TWIM_Type *)i2c->nhi_regs;
+    twim->FREQUENCY = i2c->nhi_twim_freq;
+    twim->ENABLE = TWIM_ENABLE_ENABLE_Enabled;
+
+    twim->ADDRESS = address;
+    twim->TXD.PTR = (uint32_t)wbuf;
+    twim->TXD.MAXCNT = wlen;
+    twim->RXD.PTR = (uint32_t)rbuf;
+    twim->RXD.MAXCNT = rlen;
+
+    twim->EVENTS_STOPPED = 0;
+    twim->EVENTS_ERROR = 0;
+    twim->EVENTS_LASTTX = 0;
+    twim->EVENTS_LASTRX = 0;
+
+    NVIC_SetVector(i2c->nhi_irq, irqh);
+    NVIC_EnableIRQ(i2c->nhi_irq);
+    twim->INTENSET = TWIM_INTENSET_STOPPED_Msk | TWIM_INTENSET_ERROR_Msk;
+
+    if (wlen && rlen) {
+        twim->SHORTS = TWIM_SHORTS_LASTTX_STARTRX_Msk |
+                       TWIM_SHORTS_LASTRX_STOP_Msk;
+        twim->TASKS_STARTTX = 1;
+    } else if (wlen) {
+        twim->SHORTS = TWIM_SHORTS_LASTTX_STOP_Msk;
+        twim->TASKS_STARTTX = 1;
+    } else {
+        twim->SHORTS = TWIM_SHORTS_LASTRX_STOP_Msk;
+        twim->TASKS_STARTRX = 1;
+    }
+
+    return 0;
+}
@@ -23,6 +23,7 @@
 #include "os/mynewt.h"
 #include <mcu/cmsis_nvic.h>
 #include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
 #include "mcu/nrf52_hal.h"
 #include "nrf.h"
 
@@ -89,6 +90,15 @@ struct nrf52_hal_spi
     /* Callback and arguments */
     hal_spi_txrx_cb txrx_cb_func;
     void            *txrx_cb_arg;
+
+    /* Chained transfer in progress (master only) */
+    const struct hal_spi_seg *nhs_segs;
+    int nhs_cs_pin;
+    uint8_t nhs_nsegs;
+    uint8_t nhs_seg_idx;
+    int nhs_chain_len;
+    hal_spi_txrx_cb nhs_chain_cb;
+    void *nhs_chain_arg;
 };
 
 #if MYNEWT_VAL(SPI_0_MASTER) || MYNEWT_VAL(SPI_0_SLAVE)
@@ -131,6 +141,59 @@ static const struct nrf52_hal_spi *nrf52_hal_spis[NRF52_HAL_SPI_MAX] = {
     }
 
 #if (MYNEWT_VAL(SPI_0_MASTER) || MYNEWT_VAL(SPI_1_MASTER) || MYNEWT_VAL(SPI_2_MASTER))
+static void
+nrf52_spim_seg_start(struct nrf52_hal_spi *spi)
+{
+    const struct hal_spi_seg *seg;
+    NRF_SPIM_Type *spim;
+
+    spim = spi->nhs_spi.spim;
+    seg = &spi->nhs_segs[spi->nhs_seg_idx];
+
+    /* Missing TX data is clocked out as ORC, missing RX data is dropped */
+    spim->TXD.PTR = (uint32_t)seg->tx_buf;
+    spim->TXD.MAXCNT = seg->tx_buf ? seg->len : 0;
+    spim->RXD.PTR = (uint32_t)seg->rx_buf;
+    spim->RXD.MAXCNT = seg->rx_buf ? seg->len : 0;
+
+    spim->EVENTS_END = 0;
+    spim->TASKS_START = 1;
+}
+
+static void
+nrf52_irqm_chain_handler(struct nrf52_hal_spi *spi)
+{
+    const struct hal_spi_seg *seg;
+    NRF_SPIM_Type *spim;
+
+    spim = spi->nhs_spi.spim;
+    if (!spim->EVENTS_END) {
+        return;
+    }
+    spim->EVENTS_END = 0;
+
+    seg = &spi->nhs_segs[spi->nhs_seg_idx];
+    spi->nhs_chain_len += seg->len;
+
+    if (++spi->nhs_seg_idx < spi->nhs_nsegs) {
+        if ((seg->flags & HAL_SPI_SEG_CS_TOGGLE) && spi->nhs_cs_pin >= 0) {
+            hal_gpio_write(spi->nhs_cs_pin, 1);
+            hal_gpio_write(spi->nhs_cs_pin, 0);
+        }
+        nrf52_spim_seg_start(spi);
+        return;
+    }
+
+    if (spi->nhs_cs_pin >= 0) {
+        hal_gpio_write(spi->nhs_cs_pin, 1);
+    }
+    spim->INTENCLR = SPIM_INTENSET_END_Msk;
+    spi->nhs_segs = NULL;
+    spi->spi_xfr_flag = 0;
+
+    spi->nhs_chain_cb(spi->nhs_chain_arg, spi->nhs_chain_len);
+}
+
 static void
 nrf52_irqm_handler(struct nrf52_hal_spi *spi)
 {
@@ -145,6 +208,11 @@ nrf52_irqm_handler(struct nrf52_hal_spi *spi)
         return;
     }
 
+    if (spi->nhs_segs) {
+        nrf52_irqm_chain_handler(spi);
+        return;
+    }
+
     if ((spim->EVENTS_STARTED) && (spim->INTENSET & SPIM_INTENSET_STARTED_Msk)) {
         spim->EVENTS_STARTED = 0;
 
@@ -1100,6 +1168,85 @@ err:
     return rc;
 }
 
+#if (MYNEWT_VAL(SPI_0_MASTER) || MYNEWT_VAL(SPI_1_MASTER) || MYNEWT_VAL(SPI_2_MASTER))
+int
+hal_spi_txrx_chain_noblock(int spi_num, int cs_pin,
+                           const struct hal_spi_seg *segs, int nsegs,
+                           hal_spi_txrx_cb cb, void *arg)
+{
+    int rc;
+    int i;
+    NRF_SPIM_Type *spim;
+    struct nrf52_hal_spi *spi;
+
+    rc = EINVAL;
+    NRF52_HAL_SPI_RESOLVE(spi_num, spi);
+
+    if (spi->spi_type != HAL_SPI_TYPE_MASTER) {
+        rc = -1;
+        goto err;
+    }
+
+    if ((cb == NULL) || (segs == NULL) || (nsegs <= 0) || (nsegs > 255)) {
+        goto err;
+    }
+
+    for (i = 0; i < nsegs; i++) {
+        if ((segs[i].len == 0) || (segs[i].len > SPIM_TXD_MAXCNT_MAX) ||
+            ((segs[i].tx_buf == NULL) && (segs[i].rx_buf == NULL))) {
+            goto err;
+        }
+    }
+
+    /* Not allowed if transfer in progress */
+    if (spi->spi_xfr_flag) {
+        rc = -1;
+        goto err;
+    }
+    spim = spi->nhs_spi.spim;
+    spim->INTENCLR = SPIM_INTENSET_STARTED_Msk | SPIM_INTENSET_END_Msk;
+    spi->spi_xfr_flag = 1;
+
+    /* Must be enabled for SPIM as opposed to SPI */
+    if (spim->ENABLE != SPIM_ENABLE_ENABLE_Enabled) {
+        spim->ENABLE = 0;
+        spim->ENABLE = (SPIM_ENABLE_ENABLE_Enabled << SPIM_ENABLE_ENABLE_Pos);
+    }
+    spim->SHORTS &= ~SPIM_SHORTS_END_START_Msk;
+    spim->ORC = 0xff;
+
+    spi->nhs_segs = segs;
+    spi->nhs_nsegs = nsegs;
+    spi->nhs_seg_idx = 0;
+    spi->nhs_cs_pin = cs_pin;
+    spi->nhs_chain_len = 0;
+    spi->nhs_chain_cb = cb;
+    spi->nhs_chain_arg = arg;
+
+    if (cs_pin >= 0) {
+        hal_gpio_write(cs_pin, 0);
+    }
+
+    spim->EVENTS_STARTED = 0;
+    spim->EVENTS_STOPPED = 0;
+    spim->INTENSET = SPIM_INTENSET_END_Msk;
+    nrf52_spim_seg_start(spi);
+
+    return (0);
+
+err:
+    return (rc);
+}
+#else
+int
+hal_spi_txrx_chain_noblock(int spi_num, int cs_pin,
+                           const struct hal_spi_seg *segs, int nsegs,
+                           hal_spi_txrx_cb cb, void *arg)
+{
+    return (-1);
+}
+#endif
+
 /**
  * Sets the default value transferred by the slave. Not valid for master
  *
@@ -1153,6 +1300,12 @@ hal_spi_abort(int spi_num)
             spim->INTENCLR = NRF_SPI_IRQ_DISABLE_ALL;
             hal_spi_stop_transfer(spim);
             spi->spi_xfr_flag = 0;
+            if (spi->nhs_segs) {
+                if (spi->nhs_cs_pin >= 0) {
+                    hal_gpio_write(spi->nhs_cs_pin, 1);
+                }
+                spi->nhs_segs = NULL;
+            }
             spim->INTENSET = SPIM_INTENSET_END_Msk;
         }
     } else {
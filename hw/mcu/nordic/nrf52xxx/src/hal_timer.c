@@ -37,6 +37,21 @@ typedef void (*hal_timer_irq_handler_t)(void);
 /* Output compare 2 used for RTC timers */
 #define NRF_RTC_TIMER_CC_INT    (2)
 
+/*
+ * Compare channels handed out to the nearest deadlines, in order of use.
+ * The first one is the channel used when only one slot is configured.
+ * Only TIMER3 and TIMER4 have CC4 and CC5.
+ */
+#define NRF52_HAL_TIMER_SLOTS_MAX   (5)
+
+static const uint8_t nrf52_timer_slot_cc[NRF52_HAL_TIMER_SLOTS_MAX] = {
+    NRF_TIMER_CC_INT, 0, 1, 4, 5
+};
+
+static const uint8_t nrf52_rtc_slot_cc[] = {
+    NRF_RTC_TIMER_CC_INT, 0, 1
+};
+
 /* Maximum number of hal timers used */
 #define NRF52_HAL_TIMER_MAX     (6)
 
@@ -53,6 +68,14 @@ struct nrf52_hal_timer {
     uint32_t tmr_freq;
     void *tmr_reg;
     TAILQ_HEAD(hal_timer_qhead, hal_timer) hal_timer_q;
+    uint8_t tmr_nslots;
+    const uint8_t *tmr_slot_cc;
+    uint32_t tmr_int_mask;
+    /* Timer armed on each compare channel, NULL if free */
+    struct hal_timer *tmr_slot[NRF52_HAL_TIMER_SLOTS_MAX];
+#if MYNEWT_VAL(HAL_TIMER_STATS)
+    struct hal_timer_stats tmr_stats;
+#endif
 };
 
 #if MYNEWT_VAL(TIMER_0)
@@ -137,14 +160,17 @@ nrf_read_timer_cntr(NRF_TIMER_Type *hwtimer)
 /**
  * nrf timer set ocmp
  *
- * Set the OCMP used by the timer to the desired expiration tick
+ * Set an OCMP used by the timer to the desired expiration tick
  *
  * NOTE: Must be called with interrupts disabled.
  *
- * @param timer Pointer to timer.
+ * @param bsptimer Pointer to timer.
+ * @param cc Compare channel to use.
+ * @param expiry Expiration tick.
  */
 static void
-nrf_timer_set_ocmp(struct nrf52_hal_timer *bsptimer, uint32_t expiry)
+nrf_timer_set_ocmp(struct nrf52_hal_timer *bsptimer, uint8_t cc,
+                   uint32_t expiry)
 {
     int32_t delta_t;
     uint32_t temp;
@@ -154,7 +180,7 @@ nrf_timer_set_ocmp(struct nrf52_hal_timer *bsptimer, uint32_t expiry)
 
     if (bsptimer->tmr_rtc) {
         rtctimer = (NRF_RTC_Type *)bsptimer->tmr_reg;
-        rtctimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_RTC_TIMER_CC_INT);
+        rtctimer->INTENCLR = NRF_TIMER_INT_MASK(cc);
         temp = bsptimer->tmr_cntr;
         cntr = rtctimer->COUNTER;
         if (rtctimer->EVENTS_OVRFLW) {
@@ -174,27 +200,27 @@ nrf_timer_set_ocmp(struct nrf52_hal_timer *bsptimer, uint32_t expiry)
             NVIC_SetPendingIRQ(bsptimer->tmr_irq_num);
         } else  {
             if (delta_t < (1UL << 24)) {
-                rtctimer->CC[NRF_RTC_TIMER_CC_INT] = expiry & 0x00ffffff;
+                rtctimer->CC[cc] = expiry & 0x00ffffff;
             } else {
                 /* CC too far ahead. Just make sure we set compare far ahead */
-                rtctimer->CC[NRF_RTC_TIMER_CC_INT] = cntr + (1UL << 23);
+                rtctimer->CC[cc] = cntr + (1UL << 23);
             }
-            rtctimer->INTENSET = NRF_TIMER_INT_MASK(NRF_RTC_TIMER_CC_INT);
+            rtctimer->INTENSET = NRF_TIMER_INT_MASK(cc);
         }
     } else {
         hwtimer = bsptimer->tmr_reg;
 
         /* Disable ocmp interrupt and set new value */
-        hwtimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_TIMER_CC_INT);
+        hwtimer->INTENCLR = NRF_TIMER_INT_MASK(cc);
 
         /* Set output compare register to timer expiration */
-        hwtimer->CC[NRF_TIMER_CC_INT] = expiry;
+        hwtimer->CC[cc] = expiry;
 
         /* Clear interrupt flag */
-        hwtimer->EVENTS_COMPARE[NRF_TIMER_CC_INT] = 0;
+        hwtimer->EVENTS_COMPARE[cc] = 0;
 
         /* Enable the output compare interrupt */
-        hwtimer->INTENSET = NRF_TIMER_INT_MASK(NRF_TIMER_CC_INT);
+        hwtimer->INTENSET = NRF_TIMER_INT_MASK(cc);
 
         /* Force interrupt to occur as we may have missed it */
         if ((int32_t)(nrf_read_timer_cntr(hwtimer) - expiry) >= 0) {
@@ -205,16 +231,177 @@ nrf_timer_set_ocmp(struct nrf52_hal_timer *bsptimer, uint32_t expiry)
 
 /* Disable output compare used for timer */
 static void
-nrf_timer_disable_ocmp(NRF_TIMER_Type *hwtimer)
+nrf_timer_disable_ocmp(NRF_TIMER_Type *hwtimer, uint8_t cc)
+{
+    hwtimer->INTENCLR = NRF_TIMER_INT_MASK(cc);
+}
+
+static void
+nrf_rtc_disable_ocmp(NRF_RTC_Type *rtctimer, uint8_t cc)
+{
+    rtctimer->INTENCLR = NRF_TIMER_INT_MASK(cc);
+}
+
+static void
+hal_timer_disable_ocmp(struct nrf52_hal_timer *bsptimer, uint8_t cc)
+{
+    if (bsptimer->tmr_rtc) {
+        nrf_rtc_disable_ocmp((NRF_RTC_Type *)bsptimer->tmr_reg, cc);
+    } else {
+        nrf_timer_disable_ocmp(bsptimer->tmr_reg, cc);
+    }
+}
+
+/**
+ * hal timer slot release
+ *
+ * Free the compare channel held by a timer, if it has one.
+ *
+ * NOTE: Must be called with interrupts disabled.
+ */
+static void
+hal_timer_slot_release(struct nrf52_hal_timer *bsptimer,
+                       struct hal_timer *timer)
+{
+    int i;
+
+    for (i = 0; i < bsptimer->tmr_nslots; i++) {
+        if (bsptimer->tmr_slot[i] == timer) {
+            bsptimer->tmr_slot[i] = NULL;
+            hal_timer_disable_ocmp(bsptimer, bsptimer->tmr_slot_cc[i]);
+            break;
+        }
+    }
+}
+
+/**
+ * hal timer slots update
+ *
+ * Give each of the first tmr_nslots timers on the queue a compare channel
+ * of its own. Channels held by timers which are no longer among the
+ * nearest deadlines are taken back first; timers further out wait on the
+ * queue until a channel frees up. With a single slot this is the classic
+ * "OCMP follows the queue head".
+ *
+ * NOTE: Must be called with interrupts disabled.
+ */
+static void
+hal_timer_slots_update(struct nrf52_hal_timer *bsptimer)
+{
+    struct hal_timer *near[NRF52_HAL_TIMER_SLOTS_MAX];
+    struct hal_timer *timer;
+    int nnear;
+    int i;
+    int j;
+
+    nnear = 0;
+    TAILQ_FOREACH(timer, &bsptimer->hal_timer_q, link) {
+        if (nnear == bsptimer->tmr_nslots) {
+            break;
+        }
+        near[nnear++] = timer;
+    }
+
+    for (i = 0; i < bsptimer->tmr_nslots; i++) {
+        if (bsptimer->tmr_slot[i] == NULL) {
+            continue;
+        }
+        for (j = 0; j < nnear; j++) {
+            if (near[j] == bsptimer->tmr_slot[i]) {
+                break;
+            }
+        }
+        if (j == nnear) {
+            bsptimer->tmr_slot[i] = NULL;
+            hal_timer_disable_ocmp(bsptimer, bsptimer->tmr_slot_cc[i]);
+        }
+    }
+
+    for (j = 0; j < nnear; j++) {
+        for (i = 0; i < bsptimer->tmr_nslots; i++) {
+            if (bsptimer->tmr_slot[i] == near[j]) {
+                break;
+            }
+        }
+        if (i < bsptimer->tmr_nslots) {
+            /* Already armed */
+            continue;
+        }
+        for (i = 0; bsptimer->tmr_slot[i] != NULL; i++) {
+            /* There is always a free one, see above */
+        }
+        bsptimer->tmr_slot[i] = near[j];
+        nrf_timer_set_ocmp(bsptimer, bsptimer->tmr_slot_cc[i],
+                           near[j]->expiry);
+    }
+}
+
+#if (MYNEWT_VAL(TIMER_0) || MYNEWT_VAL(TIMER_1) || MYNEWT_VAL(TIMER_2) || \
+     MYNEWT_VAL(TIMER_3) || MYNEWT_VAL(TIMER_4) || MYNEWT_VAL(TIMER_5))
+/**
+ * hal timer slots fired
+ *
+ * Clear the compare events of all slots. Slots whose compare fired are
+ * released, so hal_timer_chk_queue() re-arms them if their timer is not
+ * due yet (an RTC compare set short of a far away expiry).
+ *
+ * NOTE: Must be called with interrupts disabled.
+ */
+static void
+hal_timer_slots_fired(struct nrf52_hal_timer *bsptimer)
 {
-    hwtimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_TIMER_CC_INT);
+    volatile uint32_t *event;
+    uint8_t cc;
+    int i;
+
+    for (i = 0; i < bsptimer->tmr_nslots; i++) {
+        cc = bsptimer->tmr_slot_cc[i];
+        if (bsptimer->tmr_rtc) {
+            event = &((NRF_RTC_Type *)bsptimer->tmr_reg)->EVENTS_COMPARE[cc];
+        } else {
+            event = &((NRF_TIMER_Type *)bsptimer->tmr_reg)->EVENTS_COMPARE[cc];
+        }
+        if (*event) {
+            *event = 0;
+            if (bsptimer->tmr_slot[i]) {
+                bsptimer->tmr_slot[i] = NULL;
+                hal_timer_disable_ocmp(bsptimer, cc);
+            }
+        }
+    }
+}
+
+#if MYNEWT_VAL(HAL_TIMER_STATS)
+static void
+hal_timer_stats_update(struct nrf52_hal_timer *bsptimer, int32_t late)
+{
+    struct hal_timer_stats *stats;
+    uint32_t lat;
+
+    /* RTC timers are serviced up to 3 ticks early */
+    lat = late > 0 ? late : 0;
+
+    stats = &bsptimer->tmr_stats;
+    stats->expired++;
+    stats->lat_last = lat;
+    if (lat < stats->lat_min) {
+        stats->lat_min = lat;
+    }
+    if (lat > stats->lat_max) {
+        stats->lat_max = lat;
+    }
 }
+#endif
+#endif
 
+#if MYNEWT_VAL(HAL_TIMER_STATS)
 static void
-nrf_rtc_disable_ocmp(NRF_RTC_Type *rtctimer)
+hal_timer_stats_reset(struct nrf52_hal_timer *bsptimer)
 {
-    rtctimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_RTC_TIMER_CC_INT);
+    memset(&bsptimer->tmr_stats, 0, sizeof(bsptimer->tmr_stats));
+    bsptimer->tmr_stats.lat_min = UINT32_MAX;
 }
+#endif
 
 static uint32_t
 hal_timer_read_bsptimer(struct nrf52_hal_timer *bsptimer)
@@ -274,23 +461,18 @@ hal_timer_chk_queue(struct nrf52_hal_timer *bsptimer)
         if ((int32_t)(tcntr - timer->expiry) >= delta) {
             TAILQ_REMOVE(&bsptimer->hal_timer_q, timer, link);
             timer->link.tqe_prev = NULL;
+            hal_timer_slot_release(bsptimer, timer);
+#if MYNEWT_VAL(HAL_TIMER_STATS)
+            hal_timer_stats_update(bsptimer, tcntr - timer->expiry);
+#endif
             timer->cb_func(timer->cb_arg);
         } else {
             break;
         }
     }
 
-    /* Any timers left on queue? If so, we need to set OCMP */
-    timer = TAILQ_FIRST(&bsptimer->hal_timer_q);
-    if (timer) {
-        nrf_timer_set_ocmp(bsptimer, timer->expiry);
-    } else {
-        if (bsptimer->tmr_rtc) {
-            nrf_rtc_disable_ocmp((NRF_RTC_Type *)bsptimer->tmr_reg);
-        } else {
-            nrf_timer_disable_ocmp(bsptimer->tmr_reg);
-        }
-    }
+    /* Any timers left on queue? If so, we need to set OCMPs */
+    hal_timer_slots_update(bsptimer);
     __HAL_ENABLE_INTERRUPTS(ctx);
 }
 #endif
@@ -314,17 +496,18 @@ hal_timer_chk_queue(struct nrf52_hal_timer *bsptimer)
 static void
 hal_timer_irq_handler(struct nrf52_hal_timer *bsptimer)
 {
-    uint32_t compare;
+    uint32_t pending;
+    uint32_t ctx;
     NRF_TIMER_Type *hwtimer;
 
     os_trace_isr_enter();
 
     /* Check interrupt source. If set, clear them */
     hwtimer = bsptimer->tmr_reg;
-    compare = hwtimer->EVENTS_COMPARE[NRF_TIMER_CC_INT];
-    if (compare) {
-        hwtimer->EVENTS_COMPARE[NRF_TIMER_CC_INT] = 0;
-    }
+    __HAL_DISABLE_INTERRUPTS(ctx);
+    pending = hwtimer->INTENCLR & bsptimer->tmr_int_mask;
+    hal_timer_slots_fired(bsptimer);
+    __HAL_ENABLE_INTERRUPTS(ctx);
 
     /* XXX: make these stats? */
     /* Count # of timer isrs */
@@ -339,10 +522,10 @@ hal_timer_irq_handler(struct nrf52_hal_timer *bsptimer)
      * flag set, so all we do is check to see if the compare interrupt is
      * enabled.
      */
-    if (hwtimer->INTENCLR & NRF_TIMER_INT_MASK(NRF_TIMER_CC_INT)) {
+    if (pending) {
         hal_timer_chk_queue(bsptimer);
         /* XXX: Recommended by nordic to make sure interrupts are cleared */
-        compare = hwtimer->EVENTS_COMPARE[NRF_TIMER_CC_INT];
+        (void)hwtimer->EVENTS_COMPARE[bsptimer->tmr_slot_cc[0]];
     }
 
     os_trace_isr_exit();
@@ -354,17 +537,16 @@ static void
 hal_rtc_timer_irq_handler(struct nrf52_hal_timer *bsptimer)
 {
     uint32_t overflow;
-    uint32_t compare;
+    uint32_t ctx;
     NRF_RTC_Type *rtctimer;
 
     os_trace_isr_enter();
 
     /* Check interrupt source. If set, clear them */
     rtctimer = (NRF_RTC_Type *)bsptimer->tmr_reg;
-    compare = rtctimer->EVENTS_COMPARE[NRF_RTC_TIMER_CC_INT];
-    if (compare) {
-       rtctimer->EVENTS_COMPARE[NRF_RTC_TIMER_CC_INT] = 0;
-    }
+    __HAL_DISABLE_INTERRUPTS(ctx);
+    hal_timer_slots_fired(bsptimer);
+    __HAL_ENABLE_INTERRUPTS(ctx);
 
     overflow = rtctimer->EVENTS_OVRFLW;
     if (overflow) {
@@ -387,7 +569,7 @@ hal_rtc_timer_irq_handler(struct nrf52_hal_timer *bsptimer)
     hal_timer_chk_queue(bsptimer);
 
     /* Recommended by nordic to make sure interrupts are cleared */
-    compare = rtctimer->EVENTS_COMPARE[NRF_RTC_TIMER_CC_INT];
+    (void)rtctimer->EVENTS_COMPARE[bsptimer->tmr_slot_cc[0]];
 
     os_trace_isr_exit();
 }
@@ -455,7 +637,10 @@ int
 hal_timer_init(int timer_num, void *cfg)
 {
     int rc;
+    int i;
     uint8_t irq_num;
+    uint8_t nslots;
+    uint8_t max_slots;
     struct nrf52_hal_timer *bsptimer;
     void *hwtimer;
     hal_timer_irq_handler_t irq_isr;
@@ -474,6 +659,8 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = TIMER0_IRQn;
         hwtimer = NRF_TIMER0;
         irq_isr = nrf52_timer0_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_0_CC_SLOTS);
+        max_slots = 3;
         break;
 #endif
 #if MYNEWT_VAL(TIMER_1)
@@ -481,6 +668,8 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = TIMER1_IRQn;
         hwtimer = NRF_TIMER1;
         irq_isr = nrf52_timer1_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_1_CC_SLOTS);
+        max_slots = 3;
         break;
 #endif
 #if MYNEWT_VAL(TIMER_2)
@@ -488,6 +677,8 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = TIMER2_IRQn;
         hwtimer = NRF_TIMER2;
         irq_isr = nrf52_timer2_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_2_CC_SLOTS);
+        max_slots = 3;
         break;
 #endif
 #if MYNEWT_VAL(TIMER_3)
@@ -495,6 +686,8 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = TIMER3_IRQn;
         hwtimer = NRF_TIMER3;
         irq_isr = nrf52_timer3_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_3_CC_SLOTS);
+        max_slots = 5;
         break;
 #endif
 #if MYNEWT_VAL(TIMER_4)
@@ -502,6 +695,8 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = TIMER4_IRQn;
         hwtimer = NRF_TIMER4;
         irq_isr = nrf52_timer4_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_4_CC_SLOTS);
+        max_slots = 5;
         break;
 #endif
 #if MYNEWT_VAL(TIMER_5)
@@ -509,21 +704,40 @@ hal_timer_init(int timer_num, void *cfg)
         irq_num = RTC0_IRQn;
         hwtimer = NRF_RTC0;
         irq_isr = nrf52_timer5_irq_handler;
+        nslots = MYNEWT_VAL(TIMER_5_CC_SLOTS);
+        max_slots = sizeof(nrf52_rtc_slot_cc);
         bsptimer->tmr_rtc = 1;
         break;
 #endif
     default:
         hwtimer = NULL;
+        nslots = 0;
+        max_slots = 0;
         break;
     }
 
-    if (hwtimer == NULL) {
+    if (hwtimer == NULL || nslots < 1 || nslots > max_slots) {
         rc = EINVAL;
         goto err;
     }
 
     bsptimer->tmr_reg = hwtimer;
     bsptimer->tmr_irq_num = irq_num;
+    bsptimer->tmr_nslots = nslots;
+    if (bsptimer->tmr_rtc) {
+        bsptimer->tmr_slot_cc = nrf52_rtc_slot_cc;
+    } else {
+        bsptimer->tmr_slot_cc = nrf52_timer_slot_cc;
+    }
+    bsptimer->tmr_int_mask = 0;
+    for (i = 0; i < nslots; i++) {
+        bsptimer->tmr_slot[i] = NULL;
+        bsptimer->tmr_int_mask |=
+            NRF_TIMER_INT_MASK(bsptimer->tmr_slot_cc[i]);
+    }
+#if MYNEWT_VAL(HAL_TIMER_STATS)
+    hal_timer_stats_reset(bsptimer);
+#endif
 
     /* Disable IRQ, set priority and set vector in table */
     NVIC_DisableIRQ(irq_num);
@@ -698,13 +912,14 @@ hal_timer_deinit(int timer_num)
     __HAL_DISABLE_INTERRUPTS(ctx);
     if (bsptimer->tmr_rtc) {
         rtctimer = (NRF_RTC_Type *)bsptimer->tmr_reg;
-        rtctimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_RTC_TIMER_CC_INT);
+        rtctimer->INTENCLR = bsptimer->tmr_int_mask;
         rtctimer->TASKS_STOP = 1;
     } else {
         hwtimer = (NRF_TIMER_Type *)bsptimer->tmr_reg;
-        hwtimer->INTENCLR = NRF_TIMER_INT_MASK(NRF_TIMER_CC_INT);
+        hwtimer->INTENCLR = bsptimer->tmr_int_mask;
         hwtimer->TASKS_STOP = 1;
     }
+    memset(bsptimer->tmr_slot, 0, sizeof(bsptimer->tmr_slot));
     bsptimer->tmr_enabled = 0;
     bsptimer->tmr_reg = NULL;
     __HAL_ENABLE_INTERRUPTS(ctx);
@@ -871,10 +1086,8 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
         }
     }
 
-    /* If this is the head, we need to set new OCMP */
-    if (timer == TAILQ_FIRST(&bsptimer->hal_timer_q)) {
-        nrf_timer_set_ocmp(bsptimer, timer->expiry);
-    }
+    /* If this is among the nearest deadlines, it needs an OCMP */
+    hal_timer_slots_update(bsptimer);
 
     __HAL_ENABLE_INTERRUPTS(ctx);
 
@@ -894,8 +1107,6 @@ int
 hal_timer_stop(struct hal_timer *timer)
 {
     uint32_t ctx;
-    int reset_ocmp;
-    struct hal_timer *entry;
     struct nrf52_hal_timer *bsptimer;
 
     if (timer == NULL) {
@@ -907,29 +1118,38 @@ hal_timer_stop(struct hal_timer *timer)
     __HAL_DISABLE_INTERRUPTS(ctx);
 
     if (timer->link.tqe_prev != NULL) {
-        reset_ocmp = 0;
-        if (timer == TAILQ_FIRST(&bsptimer->hal_timer_q)) {
-            /* If first on queue, we will need to reset OCMP */
-            entry = TAILQ_NEXT(timer, link);
-            reset_ocmp = 1;
-        }
         TAILQ_REMOVE(&bsptimer->hal_timer_q, timer, link);
         timer->link.tqe_prev = NULL;
-        if (reset_ocmp) {
-            if (entry) {
-                nrf_timer_set_ocmp((struct nrf52_hal_timer *)entry->bsp_timer,
-                                   entry->expiry);
-            } else {
-                if (bsptimer->tmr_rtc) {
-                    nrf_rtc_disable_ocmp((NRF_RTC_Type *)bsptimer->tmr_reg);
-                } else {
-                    nrf_timer_disable_ocmp(bsptimer->tmr_reg);
-                }
-            }
-        }
+        /* If it held an OCMP, hand it to the next waiting timer */
+        hal_timer_slot_release(bsptimer, timer);
+        hal_timer_slots_update(bsptimer);
     }
 
     __HAL_ENABLE_INTERRUPTS(ctx);
 
     return 0;
 }
+
+#if MYNEWT_VAL(HAL_TIMER_STATS)
+int
+hal_timer_get_stats(int timer_num, struct hal_timer_stats *stats, int reset)
+{
+    int rc;
+    uint32_t ctx;
+    struct nrf52_hal_timer *bsptimer;
+
+    NRF52_HAL_TIMER_RESOLVE(timer_num, bsptimer);
+
+    __HAL_DISABLE_INTERRUPTS(ctx);
+    *stats = bsptimer->tmr_stats;
+    if (reset) {
+        hal_timer_stats_reset(bsptimer);
+    }
+    __HAL_ENABLE_INTERRUPTS(ctx);
+
+    rc = 0;
+
+err:
+    return rc;
+}
+#endif
@@ -30,6 +30,8 @@
 
 #define UARTE_INT_ENDTX		UARTE_INTEN_ENDTX_Msk
 #define UARTE_INT_ENDRX		UARTE_INTEN_ENDRX_Msk
+#define UARTE_INT_RXTO		UARTE_INTEN_RXTO_Msk
+#define UARTE_INT_RXDRDY	UARTE_INTEN_RXDRDY_Msk
 #define UARTE_CONFIG_PARITY	UARTE_CONFIG_PARITY_Msk
 #define UARTE_CONFIG_HWFC	UARTE_CONFIG_HWFC_Msk
 #define UARTE_ENABLE		UARTE_ENABLE_ENABLE_Enabled
@@ -47,9 +49,31 @@ struct hal_uart {
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    hal_uart_tx_block u_tx_block;
+    uint16_t u_tx_len;
+#endif
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    hal_uart_rx_block u_rx_block;
+    uint8_t *u_rx_ring;
+    uint16_t u_rx_len;
+    uint16_t u_rx_pos;
+    uint8_t u_rx_flush;
+    uint8_t u_rx_fifo[4];
+    uint32_t u_rx_idle_us;
+    struct hal_timer u_rx_timer;
+#endif
     void *u_func_arg;
 };
 
+/*
+ * States of the idle flush; STOPRX ends the current receive with ENDRX and
+ * then RXTO, after which FLUSHRX drains the receiver FIFO with another ENDRX.
+ */
+#define HAL_UART_RX_RUNNING     0
+#define HAL_UART_RX_STOPPING    1
+#define HAL_UART_RX_FLUSHING    2
+
 #if defined(NRF52840_XXAA)
 static struct hal_uart uart0;
 static struct hal_uart uart1;
@@ -88,6 +112,184 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+int
+hal_uart_init_tx_block(int port, hal_uart_tx_block tx_block)
+{
+    struct hal_uart *u;
+
+#if defined(NRF52840_XXAA)
+    if (port == 0) {
+        u = &uart0;
+    } else if (port == 1) {
+        u = &uart1;
+    } else {
+        return -1;
+    }
+#else
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart0;
+#endif
+
+    if (u->u_open) {
+        return -1;
+    }
+    u->u_tx_block = tx_block;
+    u->u_tx_len = 0;
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+static NRF_UARTE_Type *
+hal_uart_rx_regs(struct hal_uart *u)
+{
+#if defined(NRF52840_XXAA)
+    if (u == &uart1) {
+        return NRF_UARTE1;
+    }
+#endif
+    return NRF_UARTE0;
+}
+
+/*
+ * Point EasyDMA at the ring from the current position up to the end of the
+ * half it is in, so that ENDRX marks the half and full points of the ring.
+ */
+static void
+hal_uart_rx_seg(NRF_UARTE_Type *nrf_uart, struct hal_uart *u)
+{
+    uint16_t end;
+
+    if (u->u_rx_pos < u->u_rx_len / 2) {
+        end = u->u_rx_len / 2;
+    } else {
+        end = u->u_rx_len;
+    }
+    nrf_uart->RXD.PTR = (uint32_t)&u->u_rx_ring[u->u_rx_pos];
+    nrf_uart->RXD.MAXCNT = end - u->u_rx_pos;
+}
+
+/*
+ * UARTE has no idle line detection, and RXD.AMOUNT is only updated when a
+ * receive ends.  While data is coming in this timer polls the RXDRDY
+ * event instead of taking an interrupt per byte; once a whole idle period
+ * passes without it, receive is stopped to collect the partial segment.
+ */
+static void
+hal_uart_rx_idle(void *arg)
+{
+    NRF_UARTE_Type *nrf_uart;
+    struct hal_uart *u;
+    int sr;
+
+    u = arg;
+    nrf_uart = hal_uart_rx_regs(u);
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (nrf_uart->EVENTS_RXDRDY) {
+        nrf_uart->EVENTS_RXDRDY = 0;
+        os_cputime_timer_relative(&u->u_rx_timer, u->u_rx_idle_us);
+    } else {
+        u->u_rx_flush = HAL_UART_RX_STOPPING;
+        nrf_uart->TASKS_STOPRX = 1;
+    }
+    __HAL_ENABLE_INTERRUPTS(sr);
+}
+
+int
+hal_uart_init_rx_block(int port, hal_uart_rx_block rx_block, uint8_t *ring,
+  int ring_len)
+{
+    struct hal_uart *u;
+
+#if defined(NRF52840_XXAA)
+    if (port == 0) {
+        u = &uart0;
+    } else if (port == 1) {
+        u = &uart1;
+    } else {
+        return -1;
+    }
+#else
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart0;
+#endif
+
+    if (u->u_open) {
+        return -1;
+    }
+    if (rx_block) {
+        if (!ring || ring_len < 2 || ring_len > UINT16_MAX ||
+          (ring_len + 1) / 2 > UARTE_RXD_MAXCNT_MAXCNT_Msk) {
+            return -1;
+        }
+        os_cputime_timer_init(&u->u_rx_timer, hal_uart_rx_idle, u);
+    }
+    u->u_rx_block = rx_block;
+    u->u_rx_ring = ring;
+    u->u_rx_len = ring_len;
+    return 0;
+}
+
+static void
+hal_uart_rx_block_irq(NRF_UARTE_Type *nrf_uart, struct hal_uart *u)
+{
+    const uint8_t *data;
+    int amount;
+    int sr;
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (nrf_uart->EVENTS_ENDRX) {
+        nrf_uart->EVENTS_ENDRX = 0;
+        amount = nrf_uart->RXD.AMOUNT;
+        if (u->u_rx_flush == HAL_UART_RX_FLUSHING) {
+            data = u->u_rx_fifo;
+        } else {
+            data = &u->u_rx_ring[u->u_rx_pos];
+            u->u_rx_pos += amount;
+            if (u->u_rx_pos == u->u_rx_len) {
+                u->u_rx_pos = 0;
+            }
+        }
+        if (amount > 0) {
+            u->u_rx_block(u->u_func_arg, data, amount);
+        }
+        if (u->u_rx_flush == HAL_UART_RX_FLUSHING) {
+            /*
+             * Flush done, go back to waiting for the first byte of the
+             * next burst.
+             */
+            u->u_rx_flush = HAL_UART_RX_RUNNING;
+            nrf_uart->EVENTS_RXDRDY = 0;
+            nrf_uart->INTENSET = UARTE_INT_RXDRDY;
+        }
+        if (u->u_rx_flush == HAL_UART_RX_RUNNING) {
+            hal_uart_rx_seg(nrf_uart, u);
+            nrf_uart->TASKS_STARTRX = 1;
+        }
+    }
+    if (nrf_uart->EVENTS_RXTO) {
+        nrf_uart->EVENTS_RXTO = 0;
+        u->u_rx_flush = HAL_UART_RX_FLUSHING;
+        nrf_uart->RXD.PTR = (uint32_t)u->u_rx_fifo;
+        nrf_uart->RXD.MAXCNT = sizeof(u->u_rx_fifo);
+        nrf_uart->TASKS_FLUSHRX = 1;
+    }
+    if ((nrf_uart->INTEN & UARTE_INT_RXDRDY) && nrf_uart->EVENTS_RXDRDY) {
+        /* Data is flowing; poll for the rest of the burst */
+        nrf_uart->EVENTS_RXDRDY = 0;
+        nrf_uart->INTENCLR = UARTE_INT_RXDRDY;
+        os_cputime_timer_relative(&u->u_rx_timer, u->u_rx_idle_us);
+    }
+    __HAL_ENABLE_INTERRUPTS(sr);
+}
+#endif
+
 static int
 hal_uart_tx_fill_buf(struct hal_uart *u)
 {
@@ -104,6 +306,39 @@ hal_uart_tx_fill_buf(struct hal_uart *u)
     return i;
 }
 
+/*
+ * Point EasyDMA at the next chunk of data. With a block callback the
+ * data is sent straight from the caller's buffer, which must be in RAM,
+ * otherwise it is copied into u_tx_buf a byte at a time.
+ */
+static int
+hal_uart_tx_next(NRF_UARTE_Type *nrf_uart, struct hal_uart *u)
+{
+    int rc;
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    const uint8_t *data;
+
+    if (u->u_tx_block) {
+        rc = u->u_tx_block(u->u_func_arg, u->u_tx_len, &data);
+        if (rc > (int)UARTE_TXD_MAXCNT_MAXCNT_Msk) {
+            rc = UARTE_TXD_MAXCNT_MAXCNT_Msk;
+        }
+        u->u_tx_len = rc > 0 ? rc : 0;
+        if (rc > 0) {
+            nrf_uart->TXD.PTR = (uint32_t)data;
+            nrf_uart->TXD.MAXCNT = rc;
+        }
+        return rc;
+    }
+#endif
+    rc = hal_uart_tx_fill_buf(u);
+    if (rc > 0) {
+        nrf_uart->TXD.PTR = (uint32_t)&u->u_tx_buf;
+        nrf_uart->TXD.MAXCNT = rc;
+    }
+    return rc;
+}
+
 void
 hal_uart_start_tx(int port)
 {
@@ -132,11 +367,9 @@ hal_uart_start_tx(int port)
 
     __HAL_DISABLE_INTERRUPTS(sr);
     if (u->u_tx_started == 0) {
-        rc = hal_uart_tx_fill_buf(u);
+        rc = hal_uart_tx_next(nrf_uart, u);
         if (rc > 0) {
             nrf_uart->INTENSET = UARTE_INT_ENDTX;
-            nrf_uart->TXD.PTR = (uint32_t)&u->u_tx_buf;
-            nrf_uart->TXD.MAXCNT = rc;
             nrf_uart->TASKS_STARTTX = 1;
             u->u_tx_started = 1;
         }
@@ -239,10 +472,8 @@ uart_irq_handler(NRF_UARTE_Type *nrf_uart, struct hal_uart *u)
 
     if (nrf_uart->EVENTS_ENDTX) {
         nrf_uart->EVENTS_ENDTX = 0;
-        rc = hal_uart_tx_fill_buf(u);
+        rc = hal_uart_tx_next(nrf_uart, u);
         if (rc > 0) {
-            nrf_uart->TXD.PTR = (uint32_t)&u->u_tx_buf;
-            nrf_uart->TXD.MAXCNT = rc;
             nrf_uart->TASKS_STARTTX = 1;
         } else {
             if (u->u_tx_done) {
@@ -253,6 +484,11 @@ uart_irq_handler(NRF_UARTE_Type *nrf_uart, struct hal_uart *u)
             u->u_tx_started = 0;
         }
     }
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        hal_uart_rx_block_irq(nrf_uart, u);
+    } else
+#endif
     if (nrf_uart->EVENTS_ENDRX) {
         nrf_uart->EVENTS_ENDRX = 0;
         rc = u->u_rx_func(u->u_func_arg, u->u_rx_buf);
@@ -435,9 +671,24 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
 
     nrf_uart->ENABLE = UARTE_ENABLE;
 
-    nrf_uart->INTENSET = UARTE_INT_ENDRX;
-    nrf_uart->RXD.PTR = (uint32_t)&u->u_rx_buf;
-    nrf_uart->RXD.MAXCNT = sizeof(u->u_rx_buf);
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        u->u_rx_pos = 0;
+        u->u_rx_flush = HAL_UART_RX_RUNNING;
+        /* 10 bits per character with 8N1 framing */
+        u->u_rx_idle_us = (uint32_t)MYNEWT_VAL(HAL_UART_RX_BLOCK_IDLE_CHARS) *
+          10 * 1000000 / baudrate;
+        nrf_uart->EVENTS_RXDRDY = 0;
+        nrf_uart->INTENSET = UARTE_INT_ENDRX | UARTE_INT_RXTO |
+          UARTE_INT_RXDRDY;
+        hal_uart_rx_seg(nrf_uart, u);
+    } else
+#endif
+    {
+        nrf_uart->INTENSET = UARTE_INT_ENDRX;
+        nrf_uart->RXD.PTR = (uint32_t)&u->u_rx_buf;
+        nrf_uart->RXD.MAXCNT = sizeof(u->u_rx_buf);
+    }
     nrf_uart->TASKS_STARTRX = 1;
 
     u->u_rx_stall = 0;
@@ -472,6 +723,11 @@ hal_uart_close(int port)
 #endif
 
     u->u_open = 0;
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        os_cputime_timer_stop(&u->u_rx_timer);
+    }
+#endif
     if (u->u_tx_started) {
         while (nrf_uart->EVENTS_ENDTX == 0) {
             /* Wait here until the dma is finished */
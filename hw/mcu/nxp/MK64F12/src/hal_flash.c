@@ -53,7 +53,8 @@ static const struct hal_flash_funcs mk64f12_flash_funcs = {
     .hff_write = mk64f12_flash_write,
     .hff_erase_sector = mk64f12_flash_erase_sector,
     .hff_sector_info = mk64f12_flash_sector_info,
-    .hff_init = mk64f12_flash_init
+    .hff_init = mk64f12_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 static flash_config_t mk64f12_config;
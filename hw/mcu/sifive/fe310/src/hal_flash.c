@@ -42,7 +42,8 @@ static const struct hal_flash_funcs fe310_flash_funcs = {
     .hff_write = fe310_flash_write,
     .hff_erase_sector = fe310_flash_erase_sector,
     .hff_sector_info = fe310_flash_sector_info,
-    .hff_init = fe310_flash_init
+    .hff_init = fe310_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 const struct hal_flash fe310_flash_dev = {
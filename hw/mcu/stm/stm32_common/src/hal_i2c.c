@@ -41,6 +41,9 @@ extern HAL_StatusTypeDef HAL_I2C_Master_Receive_Custom(I2C_HandleTypeDef *hi2c,
 
 struct stm32_hal_i2c {
     I2C_HandleTypeDef hid_handle;
+    /* Completion callback of the non-blocking transfer in progress */
+    hal_i2c_xfer_cb hid_cb;
+    void *hid_cb_arg;
 };
 
 #if MYNEWT_VAL(I2C_0)
@@ -71,6 +74,70 @@ static struct stm32_hal_i2c *hal_i2c_devs[HAL_I2C_MAX_DEVS] = {
 #endif
 };
 
+/*
+ * Interrupt handlers of the non-blocking transfers, one set per device.
+ */
+#define STM32_HAL_I2C_IRQS(n)                                   \
+static void                                                     \
+i2c##n##_irq_ev(void)                                           \
+{                                                               \
+    HAL_I2C_EV_IRQHandler(&i2c##n.hid_handle);                  \
+}                                                               \
+static void                                                     \
+i2c##n##_irq_er(void)                                           \
+{                                                               \
+    HAL_I2C_ER_IRQHandler(&i2c##n.hid_handle);                  \
+}                                                               \
+static void                                                     \
+i2c##n##_irq_dma_tx(void)                                       \
+{                                                               \
+    HAL_DMA_IRQHandler(i2c##n.hid_handle.hdmatx);               \
+}                                                               \
+static void                                                     \
+i2c##n##_irq_dma_rx(void)                                       \
+{                                                               \
+    HAL_DMA_IRQHandler(i2c##n.hid_handle.hdmarx);               \
+}
+
+#define STM32_HAL_I2C_IRQ_HANDLERS(n)                           \
+    { i2c##n##_irq_ev, i2c##n##_irq_er,                         \
+      i2c##n##_irq_dma_tx, i2c##n##_irq_dma_rx }
+
+struct stm32_hal_i2c_irqs {
+    void (*ev)(void);
+    void (*er)(void);
+    void (*dma_tx)(void);
+    void (*dma_rx)(void);
+};
+
+#if MYNEWT_VAL(I2C_0)
+STM32_HAL_I2C_IRQS(0)
+#endif
+#if MYNEWT_VAL(I2C_1)
+STM32_HAL_I2C_IRQS(1)
+#endif
+#if MYNEWT_VAL(I2C_2)
+STM32_HAL_I2C_IRQS(2)
+#endif
+
+static const struct stm32_hal_i2c_irqs hal_i2c_irqs[HAL_I2C_MAX_DEVS] = {
+#if MYNEWT_VAL(I2C_0)
+    STM32_HAL_I2C_IRQ_HANDLERS(0),
+#else
+    { 0 },
+#endif
+#if MYNEWT_VAL(I2C_1)
+    STM32_HAL_I2C_IRQ_HANDLERS(1),
+#else
+    { 0 },
+#endif
+#if MYNEWT_VAL(I2C_2)
+    STM32_HAL_I2C_IRQ_HANDLERS(2),
+#else
+    { 0 },
+#endif
+};
+
 #if MYNEWT_VAL(MCU_STM32F1)
 static void
 i2c_reset(I2C_HandleTypeDef *hi2c)
@@ -82,6 +149,37 @@ i2c_reset(I2C_HandleTypeDef *hi2c)
 }
 #endif
 
+/*
+ * Link the DMA channels provided by the BSP to the device and route the I2C
+ * and DMA interrupts to the HAL handlers. The BSP fills in the DMA handles
+ * (instance, channel/request, directions) and enables the DMA clock.
+ */
+static int
+i2c_dma_init(uint8_t i2c_num, struct stm32_hal_i2c *dev,
+             const struct stm32_hal_i2c_cfg *cfg)
+{
+    const struct stm32_hal_i2c_irqs *irqs = &hal_i2c_irqs[i2c_num];
+
+    __HAL_LINKDMA(&dev->hid_handle, hdmatx, *cfg->hic_dma_tx);
+    __HAL_LINKDMA(&dev->hid_handle, hdmarx, *cfg->hic_dma_rx);
+
+    if (HAL_DMA_Init(cfg->hic_dma_tx) != HAL_OK ||
+        HAL_DMA_Init(cfg->hic_dma_rx) != HAL_OK) {
+        return HAL_I2C_ERR_INVAL;
+    }
+
+    NVIC_SetVector(cfg->hic_irq_ev, (uint32_t)irqs->ev);
+    NVIC_EnableIRQ(cfg->hic_irq_ev);
+    NVIC_SetVector(cfg->hic_irq_er, (uint32_t)irqs->er);
+    NVIC_EnableIRQ(cfg->hic_irq_er);
+    NVIC_SetVector(cfg->hic_irq_dma_tx, (uint32_t)irqs->dma_tx);
+    NVIC_EnableIRQ(cfg->hic_irq_dma_tx);
+    NVIC_SetVector(cfg->hic_irq_dma_rx, (uint32_t)irqs->dma_rx);
+    NVIC_EnableIRQ(cfg->hic_irq_dma_rx);
+
+    return 0;
+}
+
 int
 hal_i2c_init(uint8_t i2c_num, void *usercfg)
 {
@@ -188,6 +286,13 @@ hal_i2c_init(uint8_t i2c_num, void *usercfg)
         goto err;
     }
 
+    if (cfg->hic_dma_tx && cfg->hic_dma_rx) {
+        rc = i2c_dma_init(i2c_num, dev, cfg);
+        if (rc) {
+            goto err;
+        }
+    }
+
     return 0;
 err:
     *cfg->hic_rcc_reg &= ~cfg->hic_rcc_dev;
@@ -242,3 +347,100 @@ hal_i2c_master_probe(uint8_t i2c_num, uint8_t address, uint32_t timo)
 
     return rc;
 }
+
+static void
+i2c_xfer_done(I2C_HandleTypeDef *hi2c, int status)
+{
+    struct stm32_hal_i2c *dev;
+    hal_i2c_xfer_cb cb;
+
+    dev = (struct stm32_hal_i2c *)hi2c;
+    cb = dev->hid_cb;
+    if (cb) {
+        dev->hid_cb = NULL;
+        cb(dev->hid_cb_arg, status);
+    }
+}
+
+void
+HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_xfer_done(hi2c, 0);
+}
+
+void
+HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_xfer_done(hi2c, 0);
+}
+
+void
+HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_xfer_done(hi2c, 0);
+}
+
+void
+HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (HAL_I2C_GetError(hi2c) & HAL_I2C_ERROR_AF) {
+        i2c_xfer_done(hi2c, HAL_I2C_ERR_ADDR_NACK);
+    } else {
+        i2c_xfer_done(hi2c, HAL_I2C_ERR_UNKNOWN);
+    }
+}
+
+/*
+ * Combined transfers use the HAL memory read, so the write part is limited
+ * to a one or two byte register address.
+ */
+int
+hal_i2c_master_xfer_nb(uint8_t i2c_num, uint8_t address,
+                       const uint8_t *wbuf, uint16_t wlen,
+                       uint8_t *rbuf, uint16_t rlen,
+                       hal_i2c_xfer_cb cb, void *arg)
+{
+    struct stm32_hal_i2c *dev;
+    I2C_HandleTypeDef *hi2c;
+    uint16_t mem_addr;
+    os_sr_t sr;
+    int rc;
+
+    if (i2c_num >= HAL_I2C_MAX_DEVS || !(dev = hal_i2c_devs[i2c_num])) {
+        return HAL_I2C_ERR_INVAL;
+    }
+    hi2c = &dev->hid_handle;
+
+    if (!cb || !hi2c->hdmatx || (!wlen && !rlen) || (rlen && wlen > 2)) {
+        return HAL_I2C_ERR_INVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (dev->hid_cb) {
+        OS_EXIT_CRITICAL(sr);
+        return HAL_I2C_ERR_BUSY;
+    }
+    dev->hid_cb = cb;
+    dev->hid_cb_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+
+    if (wlen && rlen) {
+        mem_addr = (wlen == 1) ? wbuf[0] : (wbuf[0] << 8) | wbuf[1];
+        rc = HAL_I2C_Mem_Read_DMA(hi2c, address << 1, mem_addr,
+                                  (wlen == 1) ? I2C_MEMADD_SIZE_8BIT :
+                                                I2C_MEMADD_SIZE_16BIT,
+                                  rbuf, rlen);
+    } else if (rlen) {
+        rc = HAL_I2C_Master_Receive_DMA(hi2c, address << 1, rbuf, rlen);
+    } else {
+        rc = HAL_I2C_Master_Transmit_DMA(hi2c, address << 1, (uint8_t *)wbuf,
+                                         wlen);
+    }
+
+    if (rc != HAL_OK) {
+        dev->hid_cb = NULL;
+        return (rc == HAL_BUSY) ? HAL_I2C_ERR_BUSY : HAL_I2C_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
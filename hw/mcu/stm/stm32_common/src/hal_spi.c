@@ -62,6 +62,14 @@ struct stm32_hal_spi {
     struct stm32_hal_spi_cfg *cfg;
     hal_spi_txrx_cb txrx_cb_func;     /* callback function */
     void            *txrx_cb_arg;     /* callback arguments */
+    /* master: chained transfer in progress */
+    const struct hal_spi_seg *chain_segs;
+    int             chain_cs_pin;
+    uint8_t         chain_nsegs;
+    uint8_t         chain_idx;
+    int             chain_len;
+    hal_spi_txrx_cb chain_cb;
+    void            *chain_arg;
 };
 
 static struct stm32_spi_stat {
@@ -175,6 +183,58 @@ stm32_resolve_spi_irq(SPI_HandleTypeDef *hspi)
     }
 }
 
+/*
+ * Start the current segment of a chained transfer. Segments without RX
+ * buffer are sent only, segments without TX buffer send their RX buffer
+ * after filling it with 0xff.
+ */
+static int
+spim_chain_seg_start(struct stm32_hal_spi *spi)
+{
+    const struct hal_spi_seg *seg;
+    int word_size;
+
+    seg = &spi->chain_segs[spi->chain_idx];
+    if (seg->rx_buf == NULL) {
+        return HAL_SPI_Transmit_IT_Custom(&spi->handle, seg->tx_buf, seg->len);
+    }
+    if (seg->tx_buf == NULL) {
+        word_size = (spi->handle.Init.DataSize > SPI_DATASIZE_8BIT) ? 2 : 1;
+        memset(seg->rx_buf, 0xff, seg->len * word_size);
+        return HAL_SPI_TransmitReceive_IT_Custom(&spi->handle, seg->rx_buf,
+                                                 seg->rx_buf, seg->len);
+    }
+    return HAL_SPI_TransmitReceive_IT_Custom(&spi->handle, seg->tx_buf,
+                                             seg->rx_buf, seg->len);
+}
+
+#if SPI_ENABLED
+static void
+spim_chain_next(struct stm32_hal_spi *spi)
+{
+    const struct hal_spi_seg *seg;
+
+    seg = &spi->chain_segs[spi->chain_idx];
+    spi->chain_len += seg->len;
+
+    if (++spi->chain_idx < spi->chain_nsegs) {
+        if ((seg->flags & HAL_SPI_SEG_CS_TOGGLE) && spi->chain_cs_pin >= 0) {
+            hal_gpio_write(spi->chain_cs_pin, 1);
+            hal_gpio_write(spi->chain_cs_pin, 0);
+        }
+        if (spim_chain_seg_start(spi) == HAL_OK) {
+            return;
+        }
+    }
+
+    if (spi->chain_cs_pin >= 0) {
+        hal_gpio_write(spi->chain_cs_pin, 1);
+    }
+    spi->chain_segs = NULL;
+    spi->chain_cb(spi->chain_arg, spi->chain_len);
+}
+#endif
+
 /*
  * SPI master IRQ handler.
  */
@@ -183,6 +243,10 @@ static void
 spim_irq_handler(struct stm32_hal_spi *spi)
 {
     if (spi->handle.TxXferCount == 0 && spi->handle.RxXferCount == 0) {
+        if (spi->chain_segs) {
+            spim_chain_next(spi);
+            return;
+        }
         if (spi->txrx_cb_func) {
             spi->txrx_cb_func(spi->txrx_cb_arg, spi->handle.TxXferSize);
         }
@@ -838,6 +902,61 @@ err:
     return (rc);
 }
 
+int
+hal_spi_txrx_chain_noblock(int spi_num, int cs_pin,
+                           const struct hal_spi_seg *segs, int nsegs,
+                           hal_spi_txrx_cb cb, void *arg)
+{
+    struct stm32_hal_spi *spi;
+    int rc;
+    int sr;
+    int i;
+
+    STM32_HAL_SPI_RESOLVE(spi_num, spi);
+
+    rc = -1;
+    if (spi->slave || cb == NULL || segs == NULL || nsegs <= 0 ||
+        nsegs > 255) {
+        goto err;
+    }
+    for (i = 0; i < nsegs; i++) {
+        if (segs[i].len == 0 ||
+            (segs[i].tx_buf == NULL && segs[i].rx_buf == NULL)) {
+            goto err;
+        }
+    }
+
+    spi_stat.tx++;
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (spi->chain_segs || spi->handle.State != HAL_SPI_STATE_READY) {
+        goto err_busy;
+    }
+
+    spi->chain_segs = segs;
+    spi->chain_nsegs = nsegs;
+    spi->chain_idx = 0;
+    spi->chain_cs_pin = cs_pin;
+    spi->chain_len = 0;
+    spi->chain_cb = cb;
+    spi->chain_arg = arg;
+
+    if (cs_pin >= 0) {
+        hal_gpio_write(cs_pin, 0);
+    }
+
+    rc = spim_chain_seg_start(spi);
+    if (rc) {
+        if (cs_pin >= 0) {
+            hal_gpio_write(cs_pin, 1);
+        }
+        spi->chain_segs = NULL;
+    }
+err_busy:
+    __HAL_ENABLE_INTERRUPTS(sr);
+err:
+    return (rc);
+}
+
 /**
  * Sets the default value transferred by the slave. Not valid for master
  *
@@ -998,6 +1117,12 @@ hal_spi_abort(int spi_num)
     spi->handle.State = HAL_SPI_STATE_READY;
     __HAL_SPI_DISABLE_IT(&spi->handle, SPI_IT_TXE | SPI_IT_RXNE | SPI_IT_ERR);
     spi->handle.Instance->CR1 &= ~SPI_CR1_SPE;
+    if (spi->chain_segs) {
+        if (spi->chain_cs_pin >= 0) {
+            hal_gpio_write(spi->chain_cs_pin, 1);
+        }
+        spi->chain_segs = NULL;
+    }
     __HAL_ENABLE_INTERRUPTS(sr);
 err:
     return rc;
@@ -34,6 +34,18 @@ struct hal_uart {
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    hal_uart_tx_block u_tx_block;
+    const uint8_t *u_tx_data;
+    uint16_t u_tx_len;
+    uint16_t u_tx_off;
+#endif
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    hal_uart_rx_block u_rx_block;
+    uint8_t *u_rx_ring;
+    uint16_t u_rx_len;
+    uint16_t u_rx_off;
+#endif
     void *u_func_arg;
     const struct stm32_uart_cfg *u_cfg;
 };
@@ -63,6 +75,8 @@ static struct hal_uart_irq uart_irqs[3];
 #  define RXNE          USART_ISR_RXNE
 #  define TXE           USART_ISR_TXE
 #  define TC            USART_ISR_TC
+#  define IDLE          USART_ISR_IDLE
+#  define CLEAR_IDLE(x) ((x)->ICR = USART_ICR_IDLECF)
 #  define RXDR(x)       ((x)->RDR)
 #  define TXDR(x)       ((x)->TDR)
 #  define BAUD(x,y)     UART_DIV_SAMPLING16((x), (y))
@@ -71,6 +85,8 @@ static struct hal_uart_irq uart_irqs[3];
 #  define RXNE          USART_SR_RXNE
 #  define TXE           USART_SR_TXE
 #  define TC            USART_SR_TC
+#  define IDLE          USART_SR_IDLE
+#  define CLEAR_IDLE(x) ((void)(x)->DR)
 #  define RXDR(x)       ((x)->DR)
 #  define TXDR(x)       ((x)->DR)
 #  define BAUD(x,y)     UART_BRR_SAMPLING16((x), (y))
@@ -93,6 +109,187 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+int
+hal_uart_init_tx_block(int port, hal_uart_tx_block tx_block)
+{
+    struct hal_uart *u;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (u->u_open) {
+        return -1;
+    }
+    u->u_tx_block = tx_block;
+    u->u_tx_len = 0;
+    u->u_tx_off = 0;
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+/*
+ * Hand everything the DMA has written since the last call to the block
+ * callback.  Called on DMA half and full transfer, and on idle line.
+ */
+static void
+uart_rx_block_deliver(struct hal_uart *u)
+{
+    uint16_t pos;
+    int sr;
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    pos = u->u_rx_len - __HAL_DMA_GET_COUNTER(u->u_cfg->suc_dma_rx);
+    if (pos < u->u_rx_off) {
+        u->u_rx_block(u->u_func_arg, &u->u_rx_ring[u->u_rx_off],
+                      u->u_rx_len - u->u_rx_off);
+        u->u_rx_off = 0;
+    }
+    if (pos > u->u_rx_off) {
+        u->u_rx_block(u->u_func_arg, &u->u_rx_ring[u->u_rx_off],
+                      pos - u->u_rx_off);
+        u->u_rx_off = pos;
+    }
+    __HAL_ENABLE_INTERRUPTS(sr);
+}
+
+static void
+uart_rx_dma_cb(DMA_HandleTypeDef *hdma)
+{
+    uart_rx_block_deliver(hdma->Parent);
+}
+
+static void
+uart_rx_dma_irq(int port)
+{
+    HAL_DMA_IRQHandler(uarts[port].u_cfg->suc_dma_rx);
+}
+
+static void
+uart_rx_dma_irq1(void)
+{
+    uart_rx_dma_irq(0);
+}
+
+#if UART_CNT > 1
+static void
+uart_rx_dma_irq2(void)
+{
+    uart_rx_dma_irq(1);
+}
+#endif
+
+#if UART_CNT > 2
+static void
+uart_rx_dma_irq3(void)
+{
+    uart_rx_dma_irq(2);
+}
+#endif
+
+static void (* const uart_rx_dma_irqs[])(void) = {
+    uart_rx_dma_irq1,
+#if UART_CNT > 1
+    uart_rx_dma_irq2,
+#endif
+#if UART_CNT > 2
+    uart_rx_dma_irq3,
+#endif
+};
+
+int
+hal_uart_init_rx_block(int port, hal_uart_rx_block rx_block, uint8_t *ring,
+  int ring_len)
+{
+    struct hal_uart *u;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (u->u_open) {
+        return -1;
+    }
+    if (rx_block) {
+        if (port >= (int)(sizeof(uart_rx_dma_irqs) /
+                          sizeof(uart_rx_dma_irqs[0])) ||
+          !u->u_cfg || !u->u_cfg->suc_dma_rx) {
+            return -1;
+        }
+        if (!ring || ring_len < 2 || ring_len > UINT16_MAX) {
+            return -1;
+        }
+    }
+    u->u_rx_block = rx_block;
+    u->u_rx_ring = ring;
+    u->u_rx_len = ring_len;
+    return 0;
+}
+
+/*
+ * Start the DMA channel from the BSP in circular mode over the ring.  The
+ * BSP fills in the instance and channel/request, and enables the DMA clock.
+ */
+static int
+uart_rx_block_start(int port, struct hal_uart *u)
+{
+    DMA_HandleTypeDef *hdma;
+
+    hdma = u->u_cfg->suc_dma_rx;
+    hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode = DMA_CIRCULAR;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        return -1;
+    }
+    hdma->Parent = u;
+    hdma->XferHalfCpltCallback = uart_rx_dma_cb;
+    hdma->XferCpltCallback = uart_rx_dma_cb;
+
+    NVIC_SetVector(u->u_cfg->suc_irqn_dma_rx, (uint32_t)uart_rx_dma_irqs[port]);
+    NVIC_EnableIRQ(u->u_cfg->suc_irqn_dma_rx);
+
+    u->u_rx_off = 0;
+    if (HAL_DMA_Start_IT(hdma, (uint32_t)&RXDR(u->u_regs),
+                         (uint32_t)u->u_rx_ring, u->u_rx_len) != HAL_OK) {
+        return -1;
+    }
+    u->u_regs->CR3 |= USART_CR3_DMAR;
+    return 0;
+}
+#endif
+
+/*
+ * Next byte to transmit, -1 if there is none.  With a block callback the
+ * bytes come from the current block, and the callback is only consulted
+ * once that has been written out.
+ */
+static int
+uart_tx_next(struct hal_uart *u)
+{
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    int rc;
+
+    if (u->u_tx_block) {
+        if (u->u_tx_off == u->u_tx_len) {
+            rc = u->u_tx_block(u->u_func_arg, u->u_tx_len, &u->u_tx_data);
+            u->u_tx_len = rc > 0 ? rc : 0;
+            u->u_tx_off = 0;
+            if (rc <= 0) {
+                return -1;
+            }
+        }
+        return u->u_tx_data[u->u_tx_off++];
+    }
+#endif
+    return u->u_tx_func(u->u_func_arg);
+}
+
 static void
 uart_irq_handler(int num)
 {
@@ -110,6 +307,14 @@ uart_irq_handler(int num)
     regs = u->u_regs;
 
     isr = STATUS(regs);
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        if (isr & IDLE) {
+            CLEAR_IDLE(regs);
+            uart_rx_block_deliver(u);
+        }
+    } else
+#endif
     if (isr & RXNE) {
         data = RXDR(regs);
         rc = u->u_rx_func(u->u_func_arg, data);
@@ -122,7 +327,7 @@ uart_irq_handler(int num)
     if (isr & (TXE | TC)) {
         cr1 = regs->CR1;
         if (isr & TXE) {
-            data = u->u_tx_func(u->u_func_arg);
+            data = uart_tx_next(u);
             if (data < 0) {
                 cr1 &= ~USART_CR1_TXEIE;
                 cr1 |= USART_CR1_TCIE;
@@ -476,6 +681,14 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
     (void)STATUS(u->u_regs);
     hal_uart_set_nvic(cfg->suc_irqn, u);
 
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        if (uart_rx_block_start(port, u)) {
+            return -1;
+        }
+        u->u_regs->CR1 |= (USART_CR1_IDLEIE | USART_CR1_UE);
+    } else
+#endif
     u->u_regs->CR1 |= (USART_CR1_RXNEIE | USART_CR1_UE);
     u->u_open = 1;
 
@@ -508,6 +721,12 @@ hal_uart_close(int port)
 
     u->u_open = 0;
     u->u_regs->CR1 = 0;
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    if (u->u_rx_block) {
+        u->u_regs->CR3 &= ~USART_CR3_DMAR;
+        HAL_DMA_Abort(u->u_cfg->suc_dma_rx);
+    }
+#endif
 
     return 0;
 }
@@ -0,0 +1,179 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(STM32_CRC_ENGINE)
+
+#include <inttypes.h>
+#include "mcu/stm32_hal.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "crc/crc_engine.h"
+
+/*
+ * util/crc engine on the CRC peripheral.  Only units with a programmable
+ * polynomial and initial value (CRC_CR_POLYSIZE present) can do this;
+ * F1/F4/L1 have CRC-32/MPEG-2 hardwired.
+ *
+ * The unit is shared by all algorithms, so it is set up from scratch for
+ * every chunk of words, with interrupts disabled.  Chunks are bounded to
+ * keep interrupt latency down.  Unaligned head and tail bytes are done in
+ * software.
+ */
+#ifndef CRC_CR_POLYSIZE
+#error "STM32_CRC_ENGINE needs a CRC unit with programmable polynomial"
+#endif
+
+#define STM32_CRC_CHUNK_WORDS   64
+
+#define STM32_CRC_POL_CRC16     0x1021
+#define STM32_CRC_POL_HDLC      0x04c11db7
+#define STM32_CRC_POL_CRC32C    0x1edc6f41
+
+/*
+ * Reflected CRC-32 over whole words.  crc is the finished CRC value, as
+ * crc32_hdlc() takes it.
+ */
+static uint32_t
+stm32_crc32_words(uint32_t pol, uint32_t crc, const uint32_t *w, int cnt)
+{
+    os_sr_t sr;
+    int n;
+
+    while (cnt > 0) {
+        n = min(cnt, STM32_CRC_CHUNK_WORDS);
+        cnt -= n;
+
+        OS_ENTER_CRITICAL(sr);
+        CRC->POL = pol;
+        CRC->INIT = __RBIT(~crc);
+        CRC->CR = CRC_CR_REV_IN | CRC_CR_REV_OUT | CRC_CR_RESET;
+        while (n--) {
+            CRC->DR = *w++;
+        }
+        crc = ~CRC->DR;
+        OS_EXIT_CRITICAL(sr);
+    }
+    return crc;
+}
+
+static uint32_t
+stm32_crc32(uint32_t pol, uint32_t (*sw)(uint32_t, const void *, int),
+            uint32_t crc, const void *buf, int len)
+{
+    const uint8_t *p;
+    int head;
+
+    p = buf;
+    head = (-(uintptr_t)p) & 3;
+    if (head > len) {
+        head = len;
+    }
+    if (head) {
+        crc = sw(crc, p, head);
+        p += head;
+        len -= head;
+    }
+    crc = stm32_crc32_words(pol, crc, (const uint32_t *)p, len >> 2);
+    p += len & ~3;
+    if (len & 3) {
+        crc = sw(crc, p, len & 3);
+    }
+    return crc;
+}
+
+static uint32_t
+stm32_crc32_hdlc(uint32_t crc, const void *buf, int len)
+{
+    return stm32_crc32(STM32_CRC_POL_HDLC, crc32_hdlc_sw, crc, buf, len);
+}
+
+static uint32_t
+stm32_crc32c(uint32_t crc, const void *buf, int len)
+{
+    return stm32_crc32(STM32_CRC_POL_CRC32C, crc32c_sw, crc, buf, len);
+}
+
+static uint16_t
+stm32_crc16_ccitt(uint16_t crc, const void *buf, int len)
+{
+    const uint8_t *p;
+    const uint32_t *w;
+    os_sr_t sr;
+    int head;
+    int cnt;
+    int n;
+
+    p = buf;
+    head = (-(uintptr_t)p) & 3;
+    if (head > len) {
+        head = len;
+    }
+    if (head) {
+        crc = crc16_ccitt_sw(crc, p, head);
+        p += head;
+        len -= head;
+    }
+
+    /*
+     * CRC-16/CCITT is MSB first; byte swap the words so that the unit
+     * sees the first byte in memory first.
+     */
+    w = (const uint32_t *)p;
+    cnt = len >> 2;
+    while (cnt > 0) {
+        n = min(cnt, STM32_CRC_CHUNK_WORDS);
+        cnt -= n;
+
+        OS_ENTER_CRITICAL(sr);
+        CRC->POL = STM32_CRC_POL_CRC16;
+        CRC->INIT = crc;
+        CRC->CR = CRC_CR_POLYSIZE_0 | CRC_CR_RESET;
+        while (n--) {
+            CRC->DR = __REV(*w++);
+        }
+        crc = CRC->DR & 0xffff;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    p += len & ~3;
+    if (len & 3) {
+        crc = crc16_ccitt_sw(crc, p, len & 3);
+    }
+    return crc;
+}
+
+static struct crc_engine stm32_crc_engine = {
+    .ce_name = "stm32",
+    .ce_crc16_ccitt = stm32_crc16_ccitt,
+    .ce_crc32_hdlc = stm32_crc32_hdlc,
+    .ce_crc32c = stm32_crc32c,
+};
+
+void
+stm32_crc_init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    crc_engine_register(&stm32_crc_engine);
+    crc_engine_select(&stm32_crc_engine);
+}
+
+#endif
@@ -39,6 +39,7 @@ static const struct hal_flash_funcs stm32f1_flash_funcs = {
     .hff_erase_sector = stm32f1_flash_erase_sector,
     .hff_sector_info = stm32f1_flash_sector_info,
     .hff_init = stm32f1_flash_init,
+    .hff_map = hal_flash_map_direct,
 };
 
 #define _FLASH_SIZE            (128 * 1024)
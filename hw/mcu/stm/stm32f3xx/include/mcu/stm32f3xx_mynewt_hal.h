@@ -56,6 +56,13 @@ struct stm32_hal_i2c_cfg {
     uint8_t hic_pin_af;
     uint8_t hic_10bit;
     uint32_t hic_timingr;               /* TIMINGR register */
+    /* Optional, enables non-blocking transfers when both are set */
+    DMA_HandleTypeDef *hic_dma_tx;
+    DMA_HandleTypeDef *hic_dma_rx;
+    IRQn_Type hic_irq_ev;
+    IRQn_Type hic_irq_er;
+    IRQn_Type hic_irq_dma_tx;
+    IRQn_Type hic_irq_dma_rx;
 };
 
 #ifdef __cplusplus
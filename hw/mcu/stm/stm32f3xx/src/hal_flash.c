@@ -46,7 +46,8 @@ static const struct hal_flash_funcs stm32f3_flash_funcs = {
     .hff_write = stm32f3_flash_write,
     .hff_erase_sector = stm32f3_flash_erase_sector,
     .hff_sector_info = stm32f3_flash_sector_info,
-    .hff_init = stm32f3_flash_init
+    .hff_init = stm32f3_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 struct hal_flash stm32f3_flash_dev_;
@@ -40,6 +40,9 @@ struct stm32_uart_cfg {
     int8_t suc_pin_cts;
     uint8_t suc_pin_af;				/* AF selection for this */
     IRQn_Type suc_irqn;				/* NVIC IRQn */
+    /* Optional, needed for hal_uart_init_rx_block() */
+    struct __DMA_HandleTypeDef *suc_dma_rx;
+    IRQn_Type suc_irqn_dma_rx;
 };
 
 /*
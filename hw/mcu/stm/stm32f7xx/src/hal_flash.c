@@ -38,7 +38,8 @@ static const struct hal_flash_funcs stm32f7_flash_funcs = {
     .hff_write = stm32f7_flash_write,
     .hff_erase_sector = stm32f7_flash_erase_sector,
     .hff_sector_info = stm32f7_flash_sector_info,
-    .hff_init = stm32f7_flash_init
+    .hff_init = stm32f7_flash_init,
+    .hff_map = hal_flash_map_direct
 };
 
 static const uint32_t stm32f7_flash_sectors[] = {
@@ -41,6 +41,7 @@ static const struct hal_flash_funcs stm32l1_flash_funcs = {
     .hff_erase_sector = stm32l1_flash_erase_sector,
     .hff_sector_info = stm32l1_flash_sector_info,
     .hff_init = stm32l1_flash_init,
+    .hff_map = hal_flash_map_direct,
 };
 
 #define _FLASH_SIZE            (256 * 1024)
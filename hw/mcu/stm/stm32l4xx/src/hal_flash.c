@@ -40,6 +40,7 @@ static const struct hal_flash_funcs stm32l4_flash_funcs = {
     .hff_erase_sector = stm32l4_flash_erase_sector,
     .hff_sector_info = stm32l4_flash_sector_info,
     .hff_init = stm32l4_flash_init,
+    .hff_map = hal_flash_map_direct,
 };
 
 #define _FLASH_SIZE            (1024 * 1024)
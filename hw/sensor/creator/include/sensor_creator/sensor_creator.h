@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SENSOR_CREATOR_H__
+#define __SENSOR_CREATOR_H__
+
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create and configure the on-board sensors enabled in syscfg.  Called
+ * through sysinit.
+ *
+ * With SENSOR_CREATOR_ASYNC, the devices are created before this returns
+ * but configured afterwards by one worker task per bus, in parallel across
+ * buses; use sensor_creator_wait() before using them.
+ */
+void sensor_dev_create(void);
+
+/**
+ * Wait until all sensors created by sensor_dev_create() are configured.
+ *
+ * @param timeout Timeout in OS ticks
+ *
+ * @return 0 when configuration finished, SYS_ETIMEOUT on timeout
+ */
+int sensor_creator_wait(os_time_t timeout);
+
+/**
+ * Get the time a sensor took to initialize and configure.
+ *
+ * @param name  Device name, e.g. "bme280_0"
+ * @param usecs Filled in with the time in microseconds
+ *
+ * @return The configuration result of the sensor, SYS_ENOENT if the
+ *         creator does not create it
+ */
+int sensor_creator_init_time(const char *name, uint32_t *usecs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_CREATOR_H__ */
@@ -20,6 +20,8 @@
 #include <assert.h>
 #include <string.h>
 #include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "sensor_creator/sensor_creator.h"
 
 #if MYNEWT_VAL(DRV2605_OFB)
 #include "hal/hal_gpio.h"
@@ -1073,22 +1075,36 @@ config_bma2xx_sensor(void)
 #endif
 
 /* Sensor device creation */
-void
-sensor_dev_create(void)
-{
-    int rc;
 
-    (void)rc;
-#if MYNEWT_VAL(DRV2605_OFB)
-    rc = hal_gpio_init_out(MYNEWT_VAL(DRV2605_EN_PIN), 1);
-    assert(rc == 0);
+/**
+ * A sensor device to create and configure.  Device init only sets up
+ * driver state; configuration talks to the device and is where drivers
+ * wait for resets and calibration, so it is what runs on the bus workers
+ * with SENSOR_CREATOR_ASYNC.
+ */
+struct sensor_creator_job {
+    const char *scj_name;
+    struct os_dev *scj_dev;
+    os_dev_init_func_t scj_init;
+    struct sensor_itf *scj_itf;
+    int (*scj_config)(void);
+
+    /* Time spent in device init and config, and the config result */
+    uint32_t scj_usecs;
+    int scj_rc;
+
+    /* Worker configuring the device, one per bus */
+    uint8_t scj_worker;
+};
 
-    rc = os_dev_create((struct os_dev *) &drv2605, "drv2605_0",
-      OS_DEV_INIT_PRIMARY, 0, drv2605_init, (void *)&i2c_0_itf_drv);
-    assert(rc == 0);
+#define SENSOR_CREATOR_JOB(__dev, __name, __init, __itf, __config)      \
+    { .scj_name = (__name), .scj_dev = (struct os_dev *)(__dev),        \
+      .scj_init = (__init), .scj_itf = (__itf), .scj_config = (__config) }
 
-    rc = config_drv2605_actuator();
-    assert(rc == 0);
+static struct sensor_creator_job sensor_creator_jobs[] = {
+#if MYNEWT_VAL(DRV2605_OFB)
+    SENSOR_CREATOR_JOB(&drv2605, "drv2605_0", drv2605_init,
+                       &i2c_0_itf_drv, config_drv2605_actuator),
 #endif
 
 #if MYNEWT_VAL(LSM303DLHC_OFB)
@@ -1098,156 +1114,261 @@ sensor_dev_create(void)
      * interface makes it take the address either from the driver or
      * from the config, however teh develeoper would like to deal with it.
      */
-    rc = os_dev_create((struct os_dev *) &lsm303dlhc, "lsm303dlhc_0",
-      OS_DEV_INIT_PRIMARY, 0, lsm303dlhc_init, (void *)&i2c_0_itf_lsm);
-    assert(rc == 0);
-
-    rc = config_lsm303dlhc_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&lsm303dlhc, "lsm303dlhc_0", lsm303dlhc_init,
+                       &i2c_0_itf_lsm, config_lsm303dlhc_sensor),
 #endif
 
 #if MYNEWT_VAL(MPU6050_OFB)
-    rc = os_dev_create((struct os_dev *) &mpu6050, "mpu6050_0",
-      OS_DEV_INIT_PRIMARY, 0, mpu6050_init, (void *)&i2c_0_itf_mpu);
-    assert(rc == 0);
-
-    rc = config_mpu6050_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&mpu6050, "mpu6050_0", mpu6050_init,
+                       &i2c_0_itf_mpu, config_mpu6050_sensor),
 #endif
 
 #if MYNEWT_VAL(BNO055_OFB)
-    rc = os_dev_create((struct os_dev *) &bno055, "bno055_0",
-      OS_DEV_INIT_PRIMARY, 0, bno055_init, (void *)&i2c_0_itf_bno);
-    assert(rc == 0);
-
-    rc = config_bno055_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&bno055, "bno055_0", bno055_init,
+                       &i2c_0_itf_bno, config_bno055_sensor),
 #endif
 
 #if MYNEWT_VAL(TSL2561_OFB)
-    rc = os_dev_create((struct os_dev *) &tsl2561, "tsl2561_0",
-      OS_DEV_INIT_PRIMARY, 0, tsl2561_init, (void *)&i2c_0_itf_tsl);
-    assert(rc == 0);
-
-    rc = config_tsl2561_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&tsl2561, "tsl2561_0", tsl2561_init,
+                       &i2c_0_itf_tsl, config_tsl2561_sensor),
 #endif
 
 #if MYNEWT_VAL(TSL2591_OFB)
-    rc = os_dev_create((struct os_dev *) &tsl2591, "tsl2591_0",
-      OS_DEV_INIT_PRIMARY, 0, tsl2591_init, (void *)&i2c_0_itf_tsl);
-    assert(rc == 0);
-
-    rc = config_tsl2591_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&tsl2591, "tsl2591_0", tsl2591_init,
+                       &i2c_0_itf_tsl, config_tsl2591_sensor),
 #endif
 
 #if MYNEWT_VAL(TCS34725_OFB)
-    rc = os_dev_create((struct os_dev *) &tcs34725, "tcs34725_0",
-      OS_DEV_INIT_PRIMARY, 0, tcs34725_init, (void *)&i2c_0_itf_tcs);
-    assert(rc == 0);
-
-    rc = config_tcs34725_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&tcs34725, "tcs34725_0", tcs34725_init,
+                       &i2c_0_itf_tcs, config_tcs34725_sensor),
 #endif
 
 #if MYNEWT_VAL(BME280_OFB)
-    rc = os_dev_create((struct os_dev *) &bme280, "bme280_0",
-      OS_DEV_INIT_PRIMARY, 0, bme280_init, (void *)&spi_0_itf_bme);
-    assert(rc == 0);
-
-    rc = config_bme280_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&bme280, "bme280_0", bme280_init,
+                       &spi_0_itf_bme, config_bme280_sensor),
 #endif
 
 #if MYNEWT_VAL(MS5837_OFB)
-    rc = os_dev_create((struct os_dev *) &ms5837, "ms5837_0",
-      OS_DEV_INIT_PRIMARY, 0, ms5837_init, (void *)&i2c_0_itf_ms37);
-    assert(rc == 0);
-
-    rc = config_ms5837_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&ms5837, "ms5837_0", ms5837_init,
+                       &i2c_0_itf_ms37, config_ms5837_sensor),
 #endif
 
 #if MYNEWT_VAL(MS5840_OFB)
-    rc = os_dev_create((struct os_dev *) &ms5840, "ms5840_0",
-      OS_DEV_INIT_PRIMARY, 0, ms5840_init, (void *)&i2c_0_itf_ms40);
-    assert(rc == 0);
-
-    rc = config_ms5840_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&ms5840, "ms5840_0", ms5840_init,
+                       &i2c_0_itf_ms40, config_ms5840_sensor),
 #endif
 
 #if MYNEWT_VAL(BMP280_OFB)
-    rc = os_dev_create((struct os_dev *) &bmp280, "bmp280_0",
-      OS_DEV_INIT_PRIMARY, 0, bmp280_init, (void *)&i2c_0_itf_bmp);
-    assert(rc == 0);
-
-    rc = config_bmp280_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&bmp280, "bmp280_0", bmp280_init,
+                       &i2c_0_itf_bmp, config_bmp280_sensor),
 #endif
 
 #if MYNEWT_VAL(BMA253_OFB)
-    rc = os_dev_create((struct os_dev *)&bma253, "bma253_0",
-      OS_DEV_INIT_PRIMARY, 0, bma253_init, &i2c_0_itf_lis);
-    assert(rc == 0);
-
-    rc = config_bma253_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&bma253, "bma253_0", bma253_init,
+                       &i2c_0_itf_lis, config_bma253_sensor),
 #endif
 
 #if MYNEWT_VAL(BMA2XX_OFB)
-    rc = os_dev_create((struct os_dev *)&bma2xx, "bma2xx_0",
-      OS_DEV_INIT_PRIMARY, 0, bma2xx_init, &spi2c_0_itf_bma2xx);
-    assert(rc == 0);
-
-    rc = config_bma2xx_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&bma2xx, "bma2xx_0", bma2xx_init,
+                       &spi2c_0_itf_bma2xx, config_bma2xx_sensor),
 #endif
 
 #if MYNEWT_VAL(ADXL345_OFB)
-    rc = os_dev_create((struct os_dev *) &adxl345, "adxl345_0",
-      OS_DEV_INIT_PRIMARY, 0, adxl345_init, (void *)&i2c_0_itf_adxl);
-    assert(rc == 0);
-
-    rc = config_adxl345_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&adxl345, "adxl345_0", adxl345_init,
+                       &i2c_0_itf_adxl, config_adxl345_sensor),
 #endif
 
 #if MYNEWT_VAL(LPS33HW_OFB)
-    rc = os_dev_create((struct os_dev *) &lps33hw, "lps33hw_0",
-      OS_DEV_INIT_PRIMARY, 0, lps33hw_init, (void *)&i2c_0_itf_lps);
-    assert(rc == 0);
-
-    rc = config_lps33hw_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&lps33hw, "lps33hw_0", lps33hw_init,
+                       &i2c_0_itf_lps, config_lps33hw_sensor),
 #endif
 
 #if MYNEWT_VAL(LPS33THW_OFB)
-    rc = os_dev_create((struct os_dev *) &lps33thw, "lps33thw_0",
-      OS_DEV_INIT_PRIMARY, 0, lps33thw_init, (void *)&i2c_0_itf_lpst);
-    assert(rc == 0);
-
-    rc = config_lps33thw_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&lps33thw, "lps33thw_0", lps33thw_init,
+                       &i2c_0_itf_lpst, config_lps33thw_sensor),
 #endif
 
 #if MYNEWT_VAL(LIS2DW12_OFB)
-    rc = os_dev_create((struct os_dev *) &lis2dw12, "lis2dw12_0",
-      OS_DEV_INIT_PRIMARY, 0, lis2dw12_init, (void *)&i2c_0_itf_lis2dw12);
-    assert(rc == 0);
-
-    rc = config_lis2dw12_sensor();
-    assert(rc == 0);
+    SENSOR_CREATOR_JOB(&lis2dw12, "lis2dw12_0", lis2dw12_init,
+                       &i2c_0_itf_lis2dw12, config_lis2dw12_sensor),
 #endif
 
 #if MYNEWT_VAL(LIS2DS12_OFB)
-    rc = os_dev_create((struct os_dev *) &lis2ds12, "lis2ds12_0",
-      OS_DEV_INIT_PRIMARY, 0, lis2ds12_init, (void *)&i2c_0_itf_lis2ds12);
+    SENSOR_CREATOR_JOB(&lis2ds12, "lis2ds12_0", lis2ds12_init,
+                       &i2c_0_itf_lis2ds12, config_lis2ds12_sensor),
+#endif
+
+    { .scj_name = NULL },
+};
+
+static void
+sensor_creator_config(struct sensor_creator_job *job)
+{
+    uint32_t start;
+
+    start = os_cputime_get32();
+    job->scj_rc = job->scj_config();
+    job->scj_usecs += os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+}
+
+#if MYNEWT_VAL(SENSOR_CREATOR_ASYNC)
+#define SENSOR_CREATOR_TASKS    MYNEWT_VAL(SENSOR_CREATOR_ASYNC_TASKS)
+#define SENSOR_CREATOR_STACK_SIZE \
+    OS_STACK_ALIGN(MYNEWT_VAL(SENSOR_CREATOR_ASYNC_STACK_SIZE))
+
+static struct os_task sensor_creator_tasks[SENSOR_CREATOR_TASKS];
+static os_stack_t
+    sensor_creator_stacks[SENSOR_CREATOR_TASKS][SENSOR_CREATOR_STACK_SIZE];
+static struct os_sem sensor_creator_sem;
+static uint8_t sensor_creator_workers;
+static uint8_t sensor_creator_running;
+
+static void
+sensor_creator_task(void *arg)
+{
+    struct sensor_creator_job *job;
+    uint8_t worker;
+    os_sr_t sr;
+    int last;
+
+    worker = (uint8_t)(uintptr_t)arg;
+
+    for (job = sensor_creator_jobs; job->scj_name != NULL; job++) {
+        if (job->scj_worker == worker) {
+            sensor_creator_config(job);
+        }
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    last = --sensor_creator_running == 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (last) {
+        os_sem_release(&sensor_creator_sem);
+    }
+
+    /* Done; sleep until sensor_creator_wait() removes the task */
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+/**
+ * Assigns each device to a worker, one per bus, and starts the workers.
+ */
+static void
+sensor_creator_start(void)
+{
+    struct sensor_creator_job *job;
+    struct sensor_creator_job *prev;
+    uint8_t nbus;
+    int rc;
+    int i;
+
+    nbus = 0;
+    for (job = sensor_creator_jobs; job->scj_name != NULL; job++) {
+        for (prev = sensor_creator_jobs; prev != job; prev++) {
+            if (prev->scj_itf->si_type == job->scj_itf->si_type &&
+                prev->scj_itf->si_num == job->scj_itf->si_num) {
+                break;
+            }
+        }
+        if (prev != job) {
+            job->scj_worker = prev->scj_worker;
+        } else {
+            job->scj_worker = nbus++ % SENSOR_CREATOR_TASKS;
+        }
+    }
+
+    sensor_creator_workers = min(nbus, SENSOR_CREATOR_TASKS);
+    sensor_creator_running = sensor_creator_workers;
+
+    rc = os_sem_init(&sensor_creator_sem, sensor_creator_workers ? 0 : 1);
     assert(rc == 0);
 
-    rc = config_lis2ds12_sensor();
+    for (i = 0; i < sensor_creator_workers; i++) {
+        rc = os_task_init(&sensor_creator_tasks[i], "sensor_creator",
+                          sensor_creator_task, (void *)(uintptr_t)i,
+                          MYNEWT_VAL(SENSOR_CREATOR_ASYNC_TASK_PRIO) + i,
+                          OS_WAIT_FOREVER, sensor_creator_stacks[i],
+                          SENSOR_CREATOR_STACK_SIZE);
+        assert(rc == 0);
+    }
+}
+
+int
+sensor_creator_wait(os_time_t timeout)
+{
+    os_error_t err;
+    int i;
+
+    err = os_sem_pend(&sensor_creator_sem, timeout);
+    if (err == OS_TIMEOUT) {
+        return SYS_ETIMEOUT;
+    }
+    assert(err == OS_OK);
+
+    /* Retire the finished workers once; let other waiters through */
+    for (i = 0; i < sensor_creator_workers; i++) {
+        os_task_remove(&sensor_creator_tasks[i]);
+    }
+    sensor_creator_workers = 0;
+    os_sem_release(&sensor_creator_sem);
+
+    return 0;
+}
+#else
+int
+sensor_creator_wait(os_time_t timeout)
+{
+    return 0;
+}
+#endif
+
+int
+sensor_creator_init_time(const char *name, uint32_t *usecs)
+{
+    struct sensor_creator_job *job;
+
+    for (job = sensor_creator_jobs; job->scj_name != NULL; job++) {
+        if (!strcmp(job->scj_name, name)) {
+            *usecs = job->scj_usecs;
+            return job->scj_rc;
+        }
+    }
+
+    return SYS_ENOENT;
+}
+
+void
+sensor_dev_create(void)
+{
+    struct sensor_creator_job *job;
+    uint32_t start;
+    int rc;
+
+    (void)rc;
+#if MYNEWT_VAL(DRV2605_OFB)
+    rc = hal_gpio_init_out(MYNEWT_VAL(DRV2605_EN_PIN), 1);
     assert(rc == 0);
 #endif
 
+    for (job = sensor_creator_jobs; job->scj_name != NULL; job++) {
+        start = os_cputime_get32();
+        rc = os_dev_create(job->scj_dev, (char *)job->scj_name,
+                           OS_DEV_INIT_PRIMARY, 0, job->scj_init,
+                           (void *)job->scj_itf);
+        assert(rc == 0);
+        job->scj_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() -
+                                                   start);
+
+#if !MYNEWT_VAL(SENSOR_CREATOR_ASYNC)
+        sensor_creator_config(job);
+        assert(job->scj_rc == 0);
+#endif
+    }
+
+#if MYNEWT_VAL(SENSOR_CREATOR_ASYNC)
+    sensor_creator_start();
+#endif
 }
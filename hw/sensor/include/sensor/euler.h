@@ -32,9 +32,9 @@ extern "C" {
  * Heading, Roll and Pitch
  */
 struct sensor_euler_data {
-    float sed_h;
-    float sed_r;
-    float sed_p;
+    sensor_fp_t sed_h;
+    sensor_fp_t sed_r;
+    sensor_fp_t sed_p;
     /* Validity */
     uint8_t sed_h_is_valid:1;
     uint8_t sed_r_is_valid:1;
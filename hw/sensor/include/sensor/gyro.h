@@ -31,9 +31,9 @@ extern "C" {
  * All values are in degress per sec
  */
 struct sensor_gyro_data {
-    float sgd_x;
-    float sgd_y;
-    float sgd_z;
+    sensor_fp_t sgd_x;
+    sensor_fp_t sgd_y;
+    sensor_fp_t sgd_z;
     /* Validity */
     uint8_t sgd_x_is_valid:1;
     uint8_t sgd_y_is_valid:1;
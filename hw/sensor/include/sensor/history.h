@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SENSOR_HISTORY_H__
+#define __SENSOR_HISTORY_H__
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct sensor_history;
+
+/**
+ * Called for each sample visited by a history query.
+ *
+ * @param sh   The history being queried
+ * @param t    OS time, in ticks, at which the sample was taken
+ * @param data Sample as the data struct for the history's sensor type
+ *             (e.g. struct sensor_accel_data)
+ * @param arg  Argument passed to the query
+ *
+ * @return 0 to continue, non-zero to stop the query and have it return
+ *         this value
+ */
+typedef int (*sensor_history_func_t)(struct sensor_history *sh, os_time_t t,
+                                     void *data, void *arg);
+
+/**
+ * Number of 32-bit words of storage needed for a history of n samples,
+ * each carrying nvals values (see sensor_type_nvals()).  Every record is
+ * the sample time followed by its values.
+ */
+#define SENSOR_HISTORY_BUF_WORDS(nvals, n)   ((1 + (nvals)) * (n))
+
+/**
+ * A ring of the most recent samples of one type from one sensor.  Samples
+ * are captured by a sensor listener, so every read of the sensor, polled or
+ * not, feeds the history.  Only the sample values are kept, not the
+ * per-axis validity bits; partially valid samples are not recorded.
+ */
+struct sensor_history {
+    struct sensor_listener sh_listener;
+    struct sensor *sh_sensor;
+    sensor_type_t sh_type;
+    uint8_t sh_nvals;
+
+    /* Capacity in samples, index of the oldest one and number stored */
+    uint16_t sh_cap;
+    uint16_t sh_head;
+    uint16_t sh_cnt;
+
+    /* Total number of samples ever recorded */
+    uint32_t sh_seq;
+
+    uint32_t *sh_buf;
+
+    SLIST_ENTRY(sensor_history) sh_next;
+};
+
+/**
+ * Initialize a sample history.
+ *
+ * @param sh   The history to initialize
+ * @param type Sensor type to record, a single type
+ * @param buf  Storage, SENSOR_HISTORY_BUF_WORDS(sensor_type_nvals(type), cap)
+ *             words
+ * @param cap  Number of samples the history can hold
+ *
+ * @return 0 on success, SYS_EINVAL if the type cannot be recorded
+ */
+int sensor_history_init(struct sensor_history *sh, sensor_type_t type,
+                        uint32_t *buf, uint16_t cap);
+
+/**
+ * Start recording samples read from a sensor into a history.  Only one
+ * history per sensor and type is used by sensor_history_find().
+ *
+ * @param sensor The sensor to record
+ * @param sh     An initialized history
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int sensor_history_attach(struct sensor *sensor, struct sensor_history *sh);
+
+/**
+ * Stop recording into a history.  Stored samples remain queryable.
+ *
+ * @param sh The history to detach
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int sensor_history_detach(struct sensor_history *sh);
+
+/**
+ * Find the history recording a given type from a sensor.
+ *
+ * @param sensor The sensor
+ * @param type   The sensor type
+ *
+ * @return The history, NULL if there is none
+ */
+struct sensor_history *sensor_history_find(struct sensor *sensor,
+                                           sensor_type_t type);
+
+/**
+ * Visit the stored samples taken between two times, oldest first.
+ *
+ * @param sh   The history to query
+ * @param from Earliest sample time, in OS ticks, inclusive
+ * @param to   Latest sample time, in OS ticks, inclusive
+ * @param func Called for each matching sample
+ * @param arg  Argument for func
+ *
+ * @return 0 on success, the non-zero return of func if it stopped the query
+ */
+int sensor_history_query(struct sensor_history *sh, os_time_t from,
+                         os_time_t to, sensor_history_func_t func, void *arg);
+
+/**
+ * Visit the most recent n stored samples, oldest first.
+ *
+ * @param sh   The history to query
+ * @param n    Number of samples
+ * @param func Called for each sample
+ * @param arg  Argument for func
+ *
+ * @return 0 on success, the non-zero return of func if it stopped the query
+ */
+int sensor_history_last(struct sensor_history *sh, uint16_t n,
+                        sensor_history_func_t func, void *arg);
+
+/**
+ * Get the time of the most recent stored sample.
+ *
+ * @param sh The history
+ * @param t  Filled in with the sample time, in OS ticks
+ *
+ * @return 0 on success, SYS_ENOENT if the history is empty
+ */
+int sensor_history_latest(struct sensor_history *sh, os_time_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_HISTORY_H__ */
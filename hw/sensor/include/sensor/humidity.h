@@ -31,7 +31,7 @@ extern "C" {
  * All values are in %rH
  */
 struct sensor_humid_data {
-    float shd_humid;
+    sensor_fp_t shd_humid;
 
     /* Validity */
     uint8_t shd_humid_is_valid:1;
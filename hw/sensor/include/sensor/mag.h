@@ -31,9 +31,9 @@ extern "C" {
  * All values are in uTesla
  */
 struct sensor_mag_data {
-    float smd_x;
-    float smd_y;
-    float smd_z;
+    sensor_fp_t smd_x;
+    sensor_fp_t smd_y;
+    sensor_fp_t smd_z;
     /* Validity */
     uint8_t smd_x_is_valid:1;
     uint8_t smd_y_is_valid:1;
@@ -31,7 +31,7 @@ extern "C" {
  * All values are in Pa
  */
 struct sensor_press_data {
-    float spd_press;
+    sensor_fp_t spd_press;
 
     /* Validity */
     uint8_t spd_press_is_valid:1;
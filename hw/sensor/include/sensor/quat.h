@@ -30,10 +30,10 @@ extern "C" {
 /* Data representing a singular read from a quat sensor.
  */
 struct sensor_quat_data {
-    float sqd_x;
-    float sqd_y;
-    float sqd_z;
-    float sqd_w;
+    sensor_fp_t sqd_x;
+    sensor_fp_t sqd_y;
+    sensor_fp_t sqd_z;
+    sensor_fp_t sqd_w;
     /* Validity */
     uint8_t sqd_x_is_valid:1;
     uint8_t sqd_y_is_valid:1;
@@ -169,6 +169,44 @@ typedef enum {
  */
 #define STANDARD_ACCEL_GRAVITY 9.80665F
 
+/**
+ * Sensor data values (accelerometer, gyro, temperature, ...) are of type
+ * sensor_fp_t.  By default this is a float.  With SENSOR_FIXED_POINT it is
+ * a signed 32-bit fixed point value with SENSOR_FIXED_POINT_FRAC_BITS
+ * fraction bits, so drivers on MCUs without an FPU need no soft-float;
+ * the conversion to float then only happens at the edges (shell, OIC).
+ *
+ * Drivers should fill values in with SENSOR_FP_FROM_INT() or
+ * SENSOR_FP_FROM_RATIO() and consumers read them with
+ * SENSOR_FP_TO_FLOAT(), which work in both representations.
+ */
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+typedef int32_t sensor_fp_t;
+
+#define SENSOR_FP_FRAC_BITS         MYNEWT_VAL(SENSOR_FIXED_POINT_FRAC_BITS)
+#define SENSOR_FP_ONE               ((sensor_fp_t)1 << SENSOR_FP_FRAC_BITS)
+
+#define SENSOR_FP_FROM_INT(i)       ((sensor_fp_t)((i) * SENSOR_FP_ONE))
+#define SENSOR_FP_FROM_RATIO(n, d)                                      \
+    ((sensor_fp_t)(((int64_t)(n) * SENSOR_FP_ONE) / (d)))
+#define SENSOR_FP_TO_FLOAT(v)       ((float)(v) / SENSOR_FP_ONE)
+#else
+typedef float sensor_fp_t;
+
+#define SENSOR_FP_FROM_INT(i)       ((sensor_fp_t)(i))
+#define SENSOR_FP_FROM_RATIO(n, d)  ((sensor_fp_t)(n) / (d))
+#define SENSOR_FP_TO_FLOAT(v)       ((float)(v))
+#endif
+
+/* Maximum number of values carried by a single sensor data struct */
+#define SENSOR_VALS_MAX     (4)
+
+/**
+ * Acceleration in milli-g to a sensor value in m/s^2
+ */
+#define SENSOR_FP_MG_TO_MS2(mg)                                         \
+    SENSOR_FP_FROM_RATIO((int64_t)(mg) * 980665, 100000000)
+
 /**
  * Configuration structure, describing a specific sensor type off of
  * an existing sensor.
@@ -212,6 +250,21 @@ typedef union {
 typedef int (*sensor_data_func_t)(struct sensor *, void *, void *,
              sensor_type_t);
 
+struct sensor_batch;
+
+/**
+ * Callback for handling a batch of sensor data, specified in a sensor
+ * listener that opts into batch delivery.
+ *
+ * @param sensor The sensor for which data is being returned
+ * @param arg The argument provided to sensor_read() function.
+ * @param batch The samples, see struct sensor_batch.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+typedef int (*sensor_batch_func_t)(struct sensor *, void *,
+             const struct sensor_batch *);
+
 /**
  * Callback for sending trigger notification.
  *
@@ -272,6 +325,12 @@ struct sensor_listener {
     /* Argument for the sensor listener */
     void *sl_arg;
 
+    /* Optional batch handler.  If set, it is called once per batch of
+     * samples instead of sl_func once per sample; samples read one at a
+     * time arrive as batches of one.
+     */
+    sensor_batch_func_t sl_batch_func;
+
     /* Next item in the sensor listener list.  The head of this list is
      * contained within the sensor object.
      */
@@ -312,6 +371,53 @@ struct sensor_read_ev_ctx {
     sensor_type_t srec_type;
 };
 
+#if MYNEWT_VAL(SENSOR_REPORT)
+/**
+ * Report-on-change configuration for a sensor type, applied to threshold
+ * triggers before their notify function (e.g. OIC observe notifications)
+ * is called.  It is evaluated on every read of the sensor type, so the
+ * intervals have the resolution of the poll rate.
+ */
+struct sensor_report_cfg {
+    /* Report when any value has moved more than this, or more than
+     * src_pct_delta percent of its last reported value, since the last
+     * report.  Both 0 disables change reporting.
+     */
+    sensor_fp_t src_abs_delta;
+    uint8_t src_pct_delta;
+
+    /* Once a threshold trigger has been reported, it is not reported again
+     * until the threshold condition has cleared and the values have moved
+     * at least this far from where it tripped.  0 reports the threshold
+     * condition on every read, as without a report configuration.
+     */
+    sensor_fp_t src_hysteresis;
+
+    /* Never report more often than src_min_itvl_ms; report at least every
+     * src_max_itvl_ms even without change (0 disables).
+     */
+    uint32_t src_min_itvl_ms;
+    uint32_t src_max_itvl_ms;
+};
+
+/**
+ * Report-on-change state, see sensor_set_report()
+ */
+struct sensor_report {
+    struct sensor_report_cfg sr_cfg;
+
+    os_time_t sr_min_ticks;
+    os_time_t sr_max_ticks;
+    os_time_t sr_time;
+    sensor_fp_t sr_last[SENSOR_VALS_MAX];
+    sensor_fp_t sr_trip[SENSOR_VALS_MAX];
+    uint8_t sr_reported:1;
+    uint8_t sr_last_valid:1;
+    uint8_t sr_tripped:1;
+    uint8_t sr_trip_valid:1;
+};
+#endif
+
 /**
  * Sensor type traits list
  */
@@ -340,6 +446,11 @@ struct sensor_type_traits {
     /* function ptr for setting comparison algo */
     sensor_trigger_cmp_func_t stt_trigger_cmp_algo;
 
+#if MYNEWT_VAL(SENSOR_REPORT)
+    /* Report-on-change filter for triggers, NULL for none */
+    struct sensor_report *stt_report;
+#endif
+
 #if MYNEWT_VAL(SENSOR_OIC)
     /* Sensor OIC resource */
     oc_resource_t *stt_oic_res;
@@ -486,6 +597,28 @@ struct sensor_timestamp {
     uint32_t st_cputime;
 };
 
+/**
+ * Evenly spaced samples of one sensor type, e.g. as drained from a FIFO.
+ * Sample i was taken at sb_base_ts + i * sb_period_us.
+ */
+struct sensor_batch {
+    /* Type of the samples */
+    sensor_type_t sb_type;
+
+    /* Array of sb_count samples of the data struct for sb_type (e.g.
+     * struct sensor_accel_data), each sb_sample_size bytes
+     */
+    void *sb_data;
+    uint16_t sb_count;
+    uint16_t sb_sample_size;
+
+    /* Time between consecutive samples, in microseconds */
+    uint32_t sb_period_us;
+
+    /* Time of the first sample; filled in by sensor_data_batch() */
+    struct sensor_timestamp sb_base_ts;
+};
+
 struct sensor_int {
     uint8_t host_pin;
     uint8_t device_pin;
@@ -757,6 +890,26 @@ int sensor_read(struct sensor *sensor, sensor_type_t type,
                 sensor_data_func_t data_func, void *arg,
                 uint32_t timeout);
 
+/**
+ * Hands a batch of samples to the data function a driver's read function
+ * was given, for drivers that read several samples at once.  The newest
+ * sample is taken to be current and the batch timestamp is set from it.
+ *
+ * Listeners with a batch handler get the whole batch in one call; other
+ * listeners and the sensor_read() callback get one call per sample, with
+ * the sensor timestamp (s_sts) set to that sample's time.  Data functions
+ * not from sensor_read() are also called per sample.
+ *
+ * @param sensor The sensor the samples are from
+ * @param data_func The data function passed to the driver's read function
+ * @param data_arg The argument passed along with data_func
+ * @param batch The samples; sb_base_ts is filled in
+ *
+ * @return 0 on success, non-zero error code from a data function on failure.
+ */
+int sensor_data_batch(struct sensor *sensor, sensor_data_func_t data_func,
+                      void *data_arg, struct sensor_batch *batch);
+
 /**
  * Set the driver functions for this sensor, along with the type of sensor
  * data available for the given sensor.
@@ -881,6 +1034,73 @@ int sensor_mgr_register(struct sensor *sensor);
  */
 struct os_eventq *sensor_mgr_evq_get(void);
 
+/**
+ * Get the rate at which the sensor manager wakes up to poll sensors,
+ * measured over the last window of a second or more.
+ *
+ * @return Wakeups per second
+ */
+uint32_t sensor_mgr_wakeups_per_sec(void);
+
+#if MYNEWT_VAL(SENSOR_XFER)
+
+struct sensor_xfer;
+
+/**
+ * Called from the completing event queue when an asynchronous sensor
+ * interface transfer is done; check sx_rc for the result.
+ */
+typedef void (*sensor_xfer_cb_t)(struct sensor_xfer *xfer, void *arg);
+
+/**
+ * An asynchronous register read.  The caller fills in sx_reg, sx_buf and
+ * sx_len; the rest is owned by the sensor package until the callback runs.
+ * The struct must stay valid until then.
+ */
+struct sensor_xfer {
+    /* First byte sent: the register address plus whatever read or
+     * auto-increment bits the device wants
+     */
+    uint8_t sx_reg;
+
+    /* Number of bytes to read into sx_buf, at most SENSOR_XFER_MAX_LEN */
+    uint8_t sx_len;
+    uint8_t *sx_buf;
+
+    /* Result of the transfer, 0 on success */
+    int sx_rc;
+
+    struct sensor_itf *sx_itf;
+    struct sensor_xfer_bus *sx_bus;
+    struct os_eventq *sx_evq;
+    sensor_xfer_cb_t sx_cb;
+    void *sx_arg;
+    struct os_event sx_ev;
+};
+
+/**
+ * Queue a register read on the sensor's bus without blocking.  Each bus
+ * has its own worker, so transfers on different buses overlap and the
+ * caller's task is free while they run.  SPI transfers use the HAL's
+ * non-blocking (DMA-backed on most MCUs) interface; I2C transfers block
+ * the bus worker only.  The interface lock is held for the transfer.
+ *
+ * @param itf The sensor interface to read from
+ * @param xfer The transfer, with sx_reg, sx_buf and sx_len set
+ * @param evq Event queue to run the callback on; NULL for the sensor
+ *            manager's
+ * @param cb Completion callback
+ * @param arg Argument passed to cb
+ *
+ * @return 0 if queued, SYS_EINVAL / SYS_ENOTSUP for a bad request,
+ *         SYS_ENOMEM if all SENSOR_XFER_BUSES workers are taken.
+ */
+int sensor_itf_read_async(struct sensor_itf *itf, struct sensor_xfer *xfer,
+                          struct os_eventq *evq, sensor_xfer_cb_t cb,
+                          void *arg);
+
+#endif
+
 /* Compare function pointer to get called for each sensor */
 typedef int (*sensor_mgr_compare_func_t)(struct sensor *, void *);
 
@@ -1019,6 +1239,25 @@ sensor_get_type_traits_byname(char *, struct sensor_type_traits **,
 int
 sensor_set_thresh(char *devname, struct sensor_type_traits *stt);
 
+#if MYNEWT_VAL(SENSOR_REPORT)
+/**
+ * Set the report-on-change configuration filtering the threshold triggers
+ * of a sensor type.  The sensor type traits must already exist, e.g.
+ * created by sensor_set_thresh() or the OIC resources.
+ *
+ * @param devname Name of the sensor
+ * @param type The sensor type
+ * @param sr Report state, initialized from cfg; must stay valid while set.
+ *           NULL removes the filter.
+ * @param cfg The report configuration
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int
+sensor_set_report(char *devname, sensor_type_t type, struct sensor_report *sr,
+                  const struct sensor_report_cfg *cfg);
+#endif
+
 /**
  * Clears the low threshold for a sensor
  *
@@ -31,7 +31,7 @@ extern "C" {
  * All values are in Deg C
  */
 struct sensor_temp_data {
-    float std_temp;
+    sensor_fp_t std_temp;
 
     /* Validity */
     uint8_t std_temp_is_valid:1;
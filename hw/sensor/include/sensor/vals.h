@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SENSOR_VALS_H__
+#define __SENSOR_VALS_H__
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "sensor/accel.h"
+#include "sensor/gyro.h"
+#include "sensor/mag.h"
+#include "sensor/euler.h"
+#include "sensor/quat.h"
+#include "sensor/temperature.h"
+#include "sensor/pressure.h"
+#include "sensor/humidity.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Storage large enough for any sensor data type with a value vector
+ * representation.
+ */
+union sensor_data_buf {
+    struct sensor_accel_data sad;
+    struct sensor_gyro_data sgd;
+    struct sensor_mag_data smd;
+    struct sensor_euler_data sed;
+    struct sensor_quat_data sqd;
+    struct sensor_temp_data std;
+    struct sensor_press_data spd;
+    struct sensor_humid_data shd;
+};
+
+/**
+ * Number of values carried by a sensor data type.
+ *
+ * @param type The sensor type
+ *
+ * @return Number of values, 0 if the type is not supported
+ */
+int sensor_type_nvals(sensor_type_t type);
+
+/**
+ * Copies the values out of a sensor data struct.
+ *
+ * @param type The sensor type of data
+ * @param data The sensor data struct
+ * @param v    Output vector, SENSOR_VALS_MAX entries
+ *
+ * @return 0 on success, SYS_EINVAL if the sample is not fully valid
+ */
+int sensor_data_to_vals(sensor_type_t type, const void *data, sensor_fp_t *v);
+
+/**
+ * Builds a sensor data struct, with all fields marked valid, from a
+ * value vector.
+ *
+ * @param type The sensor type to build
+ * @param v    Input vector
+ * @param d    Output data struct
+ */
+void sensor_vals_to_data(sensor_type_t type, const sensor_fp_t *v,
+                         union sensor_data_buf *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_VALS_H__ */
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SENSOR_PIPE_H__
+#define __SENSOR_PIPE_H__
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A sensor pipeline is built from stages.  Each stage listens to one or
+ * more source sensors (real sensors or other stages), processes their
+ * samples on the sensor manager event queue and publishes the result as
+ * a virtual sensor, which applications and further stages use like any
+ * other sensor: sensor_register_listener(), sensor_read(), shell, OIC.
+ */
+
+/* Keep one of every spc_n samples */
+#define SENSOR_PIPE_DECIMATE            1
+/* Mean of the last spc_n samples */
+#define SENSOR_PIPE_MOVING_AVG          2
+/* First order low pass: y += spc_gain * (x - y) */
+#define SENSOR_PIPE_IIR                 3
+/* FIR filter with spc_n taps spc_taps (Q15), newest sample first */
+#define SENSOR_PIPE_FIR                 4
+/* Mahony style complementary filter, accel + gyro (+ mag) to quaternion;
+ * spc_gain is the proportional gain Kp
+ */
+#define SENSOR_PIPE_COMPLEMENTARY       5
+/* Madgwick gradient descent filter, accel + gyro (+ mag) to quaternion;
+ * spc_gain is beta
+ */
+#define SENSOR_PIPE_MADGWICK            6
+
+struct sensor_pipe_cfg {
+    /* One of SENSOR_PIPE_* */
+    uint8_t spc_kind;
+
+    /* Data type consumed and published by decimate / filter stages.
+     * Fusion stages publish SENSOR_TYPE_ROTATION_VECTOR.
+     */
+    sensor_type_t spc_type;
+
+    /* Decimation factor, moving average window or number of FIR taps */
+    uint16_t spc_n;
+
+    /* IIR smoothing factor or fusion gain, Q16.16 */
+    uint32_t spc_gain_q16;
+
+    /* FIR taps in Q15, spc_n of them; must stay valid */
+    const int16_t *spc_taps;
+};
+
+/* An input sample, queued for the sensor manager task */
+struct sensor_pipe_sample {
+    sensor_type_t sps_type;
+    uint32_t sps_cputime;
+    sensor_fp_t sps_val[4];
+};
+
+struct sensor_pipe {
+    struct os_dev sp_dev;
+    struct sensor sp_sensor;
+    struct sensor_pipe_cfg sp_cfg;
+    sensor_type_t sp_out_type;
+
+    /* One listener per connected source */
+    struct sensor_listener sp_listeners[3];
+    struct sensor *sp_sources[3];
+    uint8_t sp_num_sources;
+
+    /* Input queue, drained by sp_ev on the sensor manager queue */
+    struct os_event sp_ev;
+    struct sensor_pipe_sample sp_queue[MYNEWT_VAL(SENSOR_PIPE_QUEUE_LEN)];
+    uint8_t sp_q_head;
+    uint8_t sp_q_cnt;
+    uint32_t sp_dropped;
+
+    /* Filter state */
+    sensor_fp_t sp_hist[MYNEWT_VAL(SENSOR_PIPE_WINDOW_MAX)][4];
+    uint16_t sp_hist_idx;
+    uint16_t sp_hist_cnt;
+    uint16_t sp_decim_cnt;
+
+    /* Fusion state */
+    float sp_quat[4];
+    float sp_acc[3];
+    float sp_mag[3];
+    uint8_t sp_have_acc:1;
+    uint8_t sp_have_mag:1;
+    uint8_t sp_have_time:1;
+    uint32_t sp_last_cputime;
+
+    /* Latest output */
+    sensor_fp_t sp_out[4];
+    uint8_t sp_have_out:1;
+};
+
+/**
+ * Create a pipeline stage and register it as a virtual sensor named name.
+ *
+ * @param sp The stage
+ * @param name Device name of the virtual sensor
+ * @param cfg Stage configuration, copied
+ *
+ * @return 0 on success, SYS_EINVAL for a bad configuration, other
+ *         non-zero error code on failure.
+ */
+int sensor_pipe_create(struct sensor_pipe *sp, char *name,
+                       const struct sensor_pipe_cfg *cfg);
+
+/**
+ * Feed a stage from a source sensor.  Filter stages take one source of
+ * their spc_type; fusion stages take an accelerometer, a gyroscope and
+ * optionally a magnetometer source.
+ *
+ * @param sp The stage
+ * @param src The source sensor, possibly another stage
+ * @param type The source data type to consume
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int sensor_pipe_connect(struct sensor_pipe *sp, struct sensor *src,
+                        sensor_type_t type);
+
+/**
+ * Stop feeding a stage from all of its sources.
+ *
+ * @param sp The stage
+ */
+void sensor_pipe_disconnect(struct sensor_pipe *sp);
+
+/**
+ * Number of input samples dropped because the stage's queue was full.
+ */
+static inline uint32_t
+sensor_pipe_dropped(const struct sensor_pipe *sp)
+{
+    return sp->sp_dropped;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_PIPE_H__ */
@@ -0,0 +1,432 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "sensor/vals.h"
+#include "sensor_pipe/sensor_pipe.h"
+#include "sensor_pipe_priv.h"
+
+#define SENSOR_PIPE_QUEUE_LEN   MYNEWT_VAL(SENSOR_PIPE_QUEUE_LEN)
+#define SENSOR_PIPE_WINDOW_MAX  MYNEWT_VAL(SENSOR_PIPE_WINDOW_MAX)
+
+/* Accumulator and scaling for filter arithmetic in either representation */
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+typedef int64_t sensor_pipe_acc_t;
+#define SENSOR_PIPE_SCALE(v, num, den)                                  \
+    ((sensor_fp_t)(((int64_t)(v) * (num)) / (den)))
+#else
+typedef float sensor_pipe_acc_t;
+#define SENSOR_PIPE_SCALE(v, num, den)                                  \
+    ((sensor_fp_t)((v) * (float)(num) / (float)(den)))
+#endif
+
+static int sensor_pipe_sensor_read(struct sensor *, sensor_type_t,
+        sensor_data_func_t, void *, uint32_t);
+static int sensor_pipe_sensor_get_config(struct sensor *, sensor_type_t,
+        struct sensor_cfg *);
+
+static const struct sensor_driver g_sensor_pipe_driver = {
+    .sd_read = sensor_pipe_sensor_read,
+    .sd_get_config = sensor_pipe_sensor_get_config,
+};
+
+/**
+ * Queues one input sample.  Called from whichever task delivers the
+ * source's data.
+ */
+static void
+sensor_pipe_enqueue(struct sensor_pipe *sp, sensor_type_t type,
+                    uint32_t cputime, const void *data)
+{
+    struct sensor_pipe_sample *sample;
+    sensor_fp_t v[SENSOR_VALS_MAX];
+    os_sr_t sr;
+
+    if (sensor_data_to_vals(type, data, v) != 0) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (sp->sp_q_cnt == SENSOR_PIPE_QUEUE_LEN) {
+        sp->sp_dropped++;
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    sample = &sp->sp_queue[(sp->sp_q_head + sp->sp_q_cnt) %
+                           SENSOR_PIPE_QUEUE_LEN];
+    sample->sps_type = type;
+    sample->sps_cputime = cputime;
+    memcpy(sample->sps_val, v, sizeof(v));
+    sp->sp_q_cnt++;
+    OS_EXIT_CRITICAL(sr);
+}
+
+static int
+sensor_pipe_batch_func(struct sensor *sensor, void *arg,
+                       const struct sensor_batch *batch)
+{
+    struct sensor_pipe *sp;
+    const uint8_t *data;
+    uint32_t step;
+    int i;
+
+    sp = arg;
+
+    step = os_cputime_usecs_to_ticks(batch->sb_period_us);
+    data = batch->sb_data;
+    for (i = 0; i < batch->sb_count; i++) {
+        sensor_pipe_enqueue(sp, batch->sb_type,
+                            batch->sb_base_ts.st_cputime + i * step, data);
+        data += batch->sb_sample_size;
+    }
+
+    os_eventq_put(sensor_mgr_evq_get(), &sp->sp_ev);
+
+    return 0;
+}
+
+static int
+sensor_pipe_data_func(struct sensor *sensor, void *arg, void *data,
+                      sensor_type_t type)
+{
+    struct sensor_pipe *sp;
+
+    sp = arg;
+
+    sensor_pipe_enqueue(sp, type, sensor->s_sts.st_cputime, data);
+    os_eventq_put(sensor_mgr_evq_get(), &sp->sp_ev);
+
+    return 0;
+}
+
+static void
+sensor_pipe_hist_push(struct sensor_pipe *sp, const sensor_fp_t *v)
+{
+    memcpy(sp->sp_hist[sp->sp_hist_idx], v, sizeof(sp->sp_hist[0]));
+    sp->sp_hist_idx = (sp->sp_hist_idx + 1) % sp->sp_cfg.spc_n;
+    if (sp->sp_hist_cnt < sp->sp_cfg.spc_n) {
+        sp->sp_hist_cnt++;
+    }
+}
+
+/**
+ * Runs one input sample through the stage.
+ *
+ * @return 1 if the stage has a new output in sp_out, 0 otherwise.
+ */
+static int
+sensor_pipe_process(struct sensor_pipe *sp,
+                    const struct sensor_pipe_sample *sample)
+{
+    sensor_pipe_acc_t acc;
+    uint16_t n;
+    int idx;
+    int i;
+    int k;
+
+    n = sp->sp_cfg.spc_n;
+
+    switch (sp->sp_cfg.spc_kind) {
+    case SENSOR_PIPE_DECIMATE:
+        if (++sp->sp_decim_cnt < n) {
+            return 0;
+        }
+        sp->sp_decim_cnt = 0;
+        memcpy(sp->sp_out, sample->sps_val, sizeof(sp->sp_out));
+        return 1;
+
+    case SENSOR_PIPE_MOVING_AVG:
+        sensor_pipe_hist_push(sp, sample->sps_val);
+        for (i = 0; i < 4; i++) {
+            acc = 0;
+            for (k = 0; k < sp->sp_hist_cnt; k++) {
+                acc += sp->sp_hist[k][i];
+            }
+            sp->sp_out[i] = acc / sp->sp_hist_cnt;
+        }
+        return 1;
+
+    case SENSOR_PIPE_IIR:
+        if (!sp->sp_have_out) {
+            memcpy(sp->sp_out, sample->sps_val, sizeof(sp->sp_out));
+            return 1;
+        }
+        for (i = 0; i < 4; i++) {
+            sp->sp_out[i] += SENSOR_PIPE_SCALE(sample->sps_val[i] -
+                                               sp->sp_out[i],
+                                               sp->sp_cfg.spc_gain_q16,
+                                               65536);
+        }
+        return 1;
+
+    case SENSOR_PIPE_FIR:
+        sensor_pipe_hist_push(sp, sample->sps_val);
+        if (sp->sp_hist_cnt < n) {
+            /* Not enough history yet. */
+            return 0;
+        }
+        for (i = 0; i < 4; i++) {
+            acc = 0;
+            for (k = 0; k < n; k++) {
+                /* Tap 0 applies to the newest sample. */
+                idx = (sp->sp_hist_idx + n - 1 - k) % n;
+                acc += SENSOR_PIPE_SCALE(sp->sp_hist[idx][i],
+                                         sp->sp_cfg.spc_taps[k], 32768);
+            }
+            sp->sp_out[i] = acc;
+        }
+        return 1;
+
+    case SENSOR_PIPE_COMPLEMENTARY:
+    case SENSOR_PIPE_MADGWICK:
+        return sensor_pipe_fusion_update(sp, sample);
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Drains the input queue on the sensor manager task and publishes each
+ * output through the virtual sensor, so its listeners see it as a read.
+ */
+static void
+sensor_pipe_ev_cb(struct os_event *ev)
+{
+    struct sensor_pipe_sample sample;
+    struct sensor_pipe *sp;
+    os_sr_t sr;
+
+    sp = ev->ev_arg;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (sp->sp_q_cnt == 0) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        sample = sp->sp_queue[sp->sp_q_head];
+        sp->sp_q_head = (sp->sp_q_head + 1) % SENSOR_PIPE_QUEUE_LEN;
+        sp->sp_q_cnt--;
+        OS_EXIT_CRITICAL(sr);
+
+        if (sensor_pipe_process(sp, &sample)) {
+            sp->sp_have_out = 1;
+            sensor_read(&sp->sp_sensor, sp->sp_out_type, NULL, NULL,
+                        OS_TIMEOUT_NEVER);
+        }
+    }
+}
+
+static int
+sensor_pipe_sensor_read(struct sensor *sensor, sensor_type_t type,
+        sensor_data_func_t data_func, void *data_arg, uint32_t timeout)
+{
+    union sensor_data_buf data;
+    struct sensor_pipe *sp;
+
+    sp = (struct sensor_pipe *)SENSOR_GET_DEVICE(sensor);
+
+    if (!(type & sp->sp_out_type)) {
+        return SYS_EINVAL;
+    }
+    if (!sp->sp_have_out) {
+        return SYS_EAGAIN;
+    }
+
+    sensor_vals_to_data(sp->sp_out_type, sp->sp_out, &data);
+
+    return data_func(sensor, data_arg, &data, sp->sp_out_type);
+}
+
+static int
+sensor_pipe_sensor_get_config(struct sensor *sensor, sensor_type_t type,
+        struct sensor_cfg *cfg)
+{
+    struct sensor_pipe *sp;
+
+    sp = (struct sensor_pipe *)SENSOR_GET_DEVICE(sensor);
+
+    if (type != sp->sp_out_type) {
+        return SYS_EINVAL;
+    }
+
+    switch (sensor_type_nvals(type)) {
+    case 1:
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32;
+#else
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_FLOAT;
+#endif
+        break;
+    case 3:
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32_TRIPLET;
+#else
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_FLOAT_TRIPLET;
+#endif
+        break;
+    default:
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_OPAQUE;
+        break;
+    }
+
+    return 0;
+}
+
+static int
+sensor_pipe_dev_init(struct os_dev *dev, void *arg)
+{
+    struct sensor_pipe *sp;
+    struct sensor *sensor;
+    int rc;
+
+    sp = (struct sensor_pipe *)dev;
+    sensor = &sp->sp_sensor;
+
+    rc = sensor_init(sensor, dev);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = sensor_set_driver(sensor, sp->sp_out_type,
+                           (struct sensor_driver *)&g_sensor_pipe_driver);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = sensor_set_type_mask(sensor, sp->sp_out_type);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return sensor_mgr_register(sensor);
+}
+
+int
+sensor_pipe_create(struct sensor_pipe *sp, char *name,
+                   const struct sensor_pipe_cfg *cfg)
+{
+    switch (cfg->spc_kind) {
+    case SENSOR_PIPE_DECIMATE:
+        if (cfg->spc_n == 0) {
+            return SYS_EINVAL;
+        }
+        break;
+    case SENSOR_PIPE_IIR:
+        break;
+    case SENSOR_PIPE_MOVING_AVG:
+    case SENSOR_PIPE_FIR:
+        if (cfg->spc_n == 0 || cfg->spc_n > SENSOR_PIPE_WINDOW_MAX) {
+            return SYS_EINVAL;
+        }
+        if (cfg->spc_kind == SENSOR_PIPE_FIR && cfg->spc_taps == NULL) {
+            return SYS_EINVAL;
+        }
+        break;
+    case SENSOR_PIPE_COMPLEMENTARY:
+    case SENSOR_PIPE_MADGWICK:
+        break;
+    default:
+        return SYS_EINVAL;
+    }
+
+    memset(sp, 0, sizeof(*sp));
+    sp->sp_cfg = *cfg;
+
+    if (cfg->spc_kind == SENSOR_PIPE_COMPLEMENTARY ||
+        cfg->spc_kind == SENSOR_PIPE_MADGWICK) {
+        sp->sp_out_type = SENSOR_TYPE_ROTATION_VECTOR;
+        sensor_pipe_fusion_init(sp);
+    } else {
+        if (sensor_type_nvals(cfg->spc_type) == 0) {
+            return SYS_EINVAL;
+        }
+        sp->sp_out_type = cfg->spc_type;
+    }
+
+    sp->sp_ev.ev_cb = sensor_pipe_ev_cb;
+    sp->sp_ev.ev_arg = sp;
+
+    return os_dev_create(&sp->sp_dev, name, OS_DEV_INIT_PRIMARY,
+                         OS_DEV_INIT_PRIO_DEFAULT, sensor_pipe_dev_init, sp);
+}
+
+int
+sensor_pipe_connect(struct sensor_pipe *sp, struct sensor *src,
+                    sensor_type_t type)
+{
+    struct sensor_listener *listener;
+    int rc;
+
+    if (sp->sp_num_sources == sizeof(sp->sp_listeners) /
+                              sizeof(sp->sp_listeners[0])) {
+        return SYS_ENOMEM;
+    }
+
+    switch (sp->sp_cfg.spc_kind) {
+    case SENSOR_PIPE_COMPLEMENTARY:
+    case SENSOR_PIPE_MADGWICK:
+        if (type != SENSOR_TYPE_ACCELEROMETER &&
+            type != SENSOR_TYPE_GYROSCOPE &&
+            type != SENSOR_TYPE_MAGNETIC_FIELD) {
+            return SYS_EINVAL;
+        }
+        break;
+    default:
+        if (type != sp->sp_cfg.spc_type || sp->sp_num_sources != 0) {
+            return SYS_EINVAL;
+        }
+        break;
+    }
+
+    listener = &sp->sp_listeners[sp->sp_num_sources];
+    memset(listener, 0, sizeof(*listener));
+    listener->sl_sensor_type = type;
+    listener->sl_func = sensor_pipe_data_func;
+    listener->sl_batch_func = sensor_pipe_batch_func;
+    listener->sl_arg = sp;
+
+    rc = sensor_register_listener(src, listener);
+    if (rc != 0) {
+        return rc;
+    }
+
+    sp->sp_sources[sp->sp_num_sources] = src;
+    sp->sp_num_sources++;
+
+    return 0;
+}
+
+void
+sensor_pipe_disconnect(struct sensor_pipe *sp)
+{
+    int i;
+
+    for (i = 0; i < sp->sp_num_sources; i++) {
+        sensor_unregister_listener(sp->sp_sources[i], &sp->sp_listeners[i]);
+    }
+    sp->sp_num_sources = 0;
+
+    os_eventq_remove(sensor_mgr_evq_get(), &sp->sp_ev);
+}
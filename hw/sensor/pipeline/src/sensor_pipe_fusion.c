@@ -0,0 +1,371 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Orientation fusion stages.  Both keep the orientation as a unit
+ * quaternion q = (w, x, y, z) rotating the sensor frame into the earth
+ * frame, integrate the gyroscope rate on each gyroscope sample and pull
+ * the estimate towards the measured gravity (and, with a magnetometer,
+ * magnetic north) direction:
+ *
+ * - complementary: Mahony style; the error is the cross product of the
+ *   measured and predicted directions, fed back into the rate with gain
+ *   Kp.
+ * - Madgwick: one gradient descent step on the direction error per
+ *   sample, with step size beta.
+ *
+ * Everything here is single precision float, whatever the sensor data
+ * representation; only the inputs and the published quaternion are
+ * converted.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "sensor_pipe/sensor_pipe.h"
+#include "sensor_pipe_priv.h"
+
+#define SENSOR_PIPE_DEG_TO_RAD  0.01745329252f
+
+/* Samples further apart than this are treated as a gap, not integrated. */
+#define SENSOR_PIPE_MAX_DT_US   1000000
+
+static float
+sensor_pipe_invsqrt(float x)
+{
+    union {
+        float f;
+        uint32_t i;
+    } u;
+    float y;
+
+    u.f = x;
+    u.i = 0x5f3759df - (u.i >> 1);
+    y = u.f;
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+
+    return y;
+}
+
+/**
+ * Normalizes a vector in place.
+ *
+ * @return 0 on success, -1 for a zero vector.
+ */
+static int
+sensor_pipe_normalize(float *v, int n)
+{
+    float sum;
+    float inv;
+    int i;
+
+    sum = 0.0f;
+    for (i = 0; i < n; i++) {
+        sum += v[i] * v[i];
+    }
+    if (sum == 0.0f) {
+        return -1;
+    }
+
+    inv = sensor_pipe_invsqrt(sum);
+    for (i = 0; i < n; i++) {
+        v[i] *= inv;
+    }
+
+    return 0;
+}
+
+/**
+ * Earth frame magnetic reference (bx, 0, bz) for the current orientation:
+ * the measured field rotated into the earth frame, with its horizontal
+ * part folded onto x.
+ */
+static void
+sensor_pipe_mag_ref(const float *q, const float *m, float *bx, float *bz)
+{
+    float hx;
+    float hy;
+    float hz;
+
+    hx = m[0] * (1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) +
+         m[1] * 2.0f * (q[1] * q[2] - q[0] * q[3]) +
+         m[2] * 2.0f * (q[1] * q[3] + q[0] * q[2]);
+    hy = m[0] * 2.0f * (q[1] * q[2] + q[0] * q[3]) +
+         m[1] * (1.0f - 2.0f * (q[1] * q[1] + q[3] * q[3])) +
+         m[2] * 2.0f * (q[2] * q[3] - q[0] * q[1]);
+    hz = m[0] * 2.0f * (q[1] * q[3] - q[0] * q[2]) +
+         m[1] * 2.0f * (q[2] * q[3] + q[0] * q[1]) +
+         m[2] * (1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]));
+
+    *bx = hx * hx + hy * hy;
+    *bx = *bx * sensor_pipe_invsqrt(*bx);
+    *bz = hz;
+}
+
+/**
+ * Predicted sensor frame directions of gravity (v) and of the magnetic
+ * reference (w), i.e. the earth frame vectors rotated by q^-1.
+ */
+static void
+sensor_pipe_predict(const float *q, float bx, float bz, float *v, float *w)
+{
+    v[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    v[1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+    v[2] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+
+    w[0] = bx * (1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) + bz * v[0];
+    w[1] = bx * 2.0f * (q[1] * q[2] - q[0] * q[3]) + bz * v[1];
+    w[2] = bx * 2.0f * (q[1] * q[3] + q[0] * q[2]) + bz * v[2];
+}
+
+/* qdot = 1/2 q (x) (0, g) */
+static void
+sensor_pipe_qdot(const float *q, const float *g, float *qdot)
+{
+    qdot[0] = 0.5f * (-q[1] * g[0] - q[2] * g[1] - q[3] * g[2]);
+    qdot[1] = 0.5f * (q[0] * g[0] + q[2] * g[2] - q[3] * g[1]);
+    qdot[2] = 0.5f * (q[0] * g[1] - q[1] * g[2] + q[3] * g[0]);
+    qdot[3] = 0.5f * (q[0] * g[2] + q[1] * g[1] - q[2] * g[0]);
+}
+
+static void
+sensor_pipe_complementary(struct sensor_pipe *sp, float *g, float dt)
+{
+    float *q;
+    float a[3];
+    float m[3];
+    float v[3];
+    float w[3];
+    float e[3];
+    float qdot[4];
+    float bx;
+    float bz;
+    float kp;
+    int i;
+
+    q = sp->sp_quat;
+    kp = sp->sp_cfg.spc_gain_q16 / 65536.0f;
+
+    memcpy(a, sp->sp_acc, sizeof(a));
+    if (sp->sp_have_acc && sensor_pipe_normalize(a, 3) == 0) {
+        bx = 0.0f;
+        bz = 0.0f;
+        if (sp->sp_have_mag) {
+            memcpy(m, sp->sp_mag, sizeof(m));
+            if (sensor_pipe_normalize(m, 3) == 0) {
+                sensor_pipe_mag_ref(q, m, &bx, &bz);
+            }
+        }
+        sensor_pipe_predict(q, bx, bz, v, w);
+
+        /* Error is the rotation taking the predicted onto the measured
+         * directions.
+         */
+        e[0] = a[1] * v[2] - a[2] * v[1];
+        e[1] = a[2] * v[0] - a[0] * v[2];
+        e[2] = a[0] * v[1] - a[1] * v[0];
+        if (bx != 0.0f || bz != 0.0f) {
+            e[0] += m[1] * w[2] - m[2] * w[1];
+            e[1] += m[2] * w[0] - m[0] * w[2];
+            e[2] += m[0] * w[1] - m[1] * w[0];
+        }
+
+        for (i = 0; i < 3; i++) {
+            g[i] += kp * e[i];
+        }
+    }
+
+    sensor_pipe_qdot(q, g, qdot);
+    for (i = 0; i < 4; i++) {
+        q[i] += qdot[i] * dt;
+    }
+    sensor_pipe_normalize(q, 4);
+}
+
+static void
+sensor_pipe_madgwick(struct sensor_pipe *sp, const float *g, float dt)
+{
+    float *q;
+    float a[3];
+    float m[3];
+    float v[3];
+    float w[3];
+    float f[6];
+    float jac[6][4];
+    float step[4];
+    float qdot[4];
+    float beta;
+    float bx;
+    float bz;
+    int rows;
+    int i;
+    int k;
+
+    q = sp->sp_quat;
+    beta = sp->sp_cfg.spc_gain_q16 / 65536.0f;
+
+    sensor_pipe_qdot(q, g, qdot);
+
+    memcpy(a, sp->sp_acc, sizeof(a));
+    if (sp->sp_have_acc && sensor_pipe_normalize(a, 3) == 0) {
+        rows = 3;
+        bx = 0.0f;
+        bz = 0.0f;
+        if (sp->sp_have_mag) {
+            memcpy(m, sp->sp_mag, sizeof(m));
+            if (sensor_pipe_normalize(m, 3) == 0) {
+                sensor_pipe_mag_ref(q, m, &bx, &bz);
+                rows = 6;
+            }
+        }
+        sensor_pipe_predict(q, bx, bz, v, w);
+
+        /* Objective: predicted minus measured directions. */
+        for (i = 0; i < 3; i++) {
+            f[i] = v[i] - a[i];
+        }
+
+        /* Jacobian of the predicted gravity direction */
+        jac[0][0] = -2.0f * q[2];
+        jac[0][1] = 2.0f * q[3];
+        jac[0][2] = -2.0f * q[0];
+        jac[0][3] = 2.0f * q[1];
+        jac[1][0] = 2.0f * q[1];
+        jac[1][1] = 2.0f * q[0];
+        jac[1][2] = 2.0f * q[3];
+        jac[1][3] = 2.0f * q[2];
+        jac[2][0] = 0.0f;
+        jac[2][1] = -4.0f * q[1];
+        jac[2][2] = -4.0f * q[2];
+        jac[2][3] = 0.0f;
+
+        if (rows == 6) {
+            for (i = 0; i < 3; i++) {
+                f[3 + i] = w[i] - m[i];
+            }
+
+            /* Jacobian of the predicted magnetic reference direction */
+            jac[3][0] = -2.0f * bz * q[2];
+            jac[3][1] = 2.0f * bz * q[3];
+            jac[3][2] = -4.0f * bx * q[2] - 2.0f * bz * q[0];
+            jac[3][3] = -4.0f * bx * q[3] + 2.0f * bz * q[1];
+            jac[4][0] = -2.0f * bx * q[3] + 2.0f * bz * q[1];
+            jac[4][1] = 2.0f * bx * q[2] + 2.0f * bz * q[0];
+            jac[4][2] = 2.0f * bx * q[1] + 2.0f * bz * q[3];
+            jac[4][3] = -2.0f * bx * q[0] + 2.0f * bz * q[2];
+            jac[5][0] = 2.0f * bx * q[2];
+            jac[5][1] = 2.0f * bx * q[3] - 4.0f * bz * q[1];
+            jac[5][2] = 2.0f * bx * q[0] - 4.0f * bz * q[2];
+            jac[5][3] = 2.0f * bx * q[1];
+        }
+
+        /* Gradient J^T f, normalized into a step direction */
+        for (k = 0; k < 4; k++) {
+            step[k] = 0.0f;
+            for (i = 0; i < rows; i++) {
+                step[k] += jac[i][k] * f[i];
+            }
+        }
+        if (sensor_pipe_normalize(step, 4) == 0) {
+            for (k = 0; k < 4; k++) {
+                qdot[k] -= beta * step[k];
+            }
+        }
+    }
+
+    for (k = 0; k < 4; k++) {
+        q[k] += qdot[k] * dt;
+    }
+    sensor_pipe_normalize(q, 4);
+}
+
+void
+sensor_pipe_fusion_init(struct sensor_pipe *sp)
+{
+    sp->sp_quat[0] = 1.0f;
+    sp->sp_quat[1] = 0.0f;
+    sp->sp_quat[2] = 0.0f;
+    sp->sp_quat[3] = 0.0f;
+}
+
+int
+sensor_pipe_fusion_update(struct sensor_pipe *sp,
+                          const struct sensor_pipe_sample *sample)
+{
+    uint32_t dt_us;
+    float g[3];
+    float dt;
+    int i;
+
+    switch (sample->sps_type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+        for (i = 0; i < 3; i++) {
+            sp->sp_acc[i] = SENSOR_FP_TO_FLOAT(sample->sps_val[i]);
+        }
+        sp->sp_have_acc = 1;
+        return 0;
+
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+        for (i = 0; i < 3; i++) {
+            sp->sp_mag[i] = SENSOR_FP_TO_FLOAT(sample->sps_val[i]);
+        }
+        sp->sp_have_mag = 1;
+        return 0;
+
+    case SENSOR_TYPE_GYROSCOPE:
+        break;
+
+    default:
+        return 0;
+    }
+
+    /* The gyroscope drives the filter; its sample times give the step. */
+    if (!sp->sp_have_time) {
+        sp->sp_have_time = 1;
+        sp->sp_last_cputime = sample->sps_cputime;
+        return 0;
+    }
+    dt_us = os_cputime_ticks_to_usecs(sample->sps_cputime -
+                                      sp->sp_last_cputime);
+    sp->sp_last_cputime = sample->sps_cputime;
+    if (dt_us == 0 || dt_us > SENSOR_PIPE_MAX_DT_US) {
+        return 0;
+    }
+    dt = dt_us / 1000000.0f;
+
+    for (i = 0; i < 3; i++) {
+        g[i] = SENSOR_FP_TO_FLOAT(sample->sps_val[i]) *
+               SENSOR_PIPE_DEG_TO_RAD;
+    }
+
+    if (sp->sp_cfg.spc_kind == SENSOR_PIPE_MADGWICK) {
+        sensor_pipe_madgwick(sp, g, dt);
+    } else {
+        sensor_pipe_complementary(sp, g, dt);
+    }
+
+    sp->sp_out[0] = SENSOR_PIPE_FP_FROM_FLOAT(sp->sp_quat[1]);
+    sp->sp_out[1] = SENSOR_PIPE_FP_FROM_FLOAT(sp->sp_quat[2]);
+    sp->sp_out[2] = SENSOR_PIPE_FP_FROM_FLOAT(sp->sp_quat[3]);
+    sp->sp_out[3] = SENSOR_PIPE_FP_FROM_FLOAT(sp->sp_quat[0]);
+
+    return 1;
+}
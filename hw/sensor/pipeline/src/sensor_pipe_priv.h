@@ -0,0 +1,35 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SENSOR_PIPE_PRIV_H__
+#define __SENSOR_PIPE_PRIV_H__
+
+#include "sensor_pipe/sensor_pipe.h"
+
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+#define SENSOR_PIPE_FP_FROM_FLOAT(f)    ((sensor_fp_t)((f) * SENSOR_FP_ONE))
+#else
+#define SENSOR_PIPE_FP_FROM_FLOAT(f)    ((sensor_fp_t)(f))
+#endif
+
+void sensor_pipe_fusion_init(struct sensor_pipe *sp);
+int sensor_pipe_fusion_update(struct sensor_pipe *sp,
+                              const struct sensor_pipe_sample *sample);
+
+#endif /* __SENSOR_PIPE_PRIV_H__ */
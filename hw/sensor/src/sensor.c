@@ -21,6 +21,7 @@
 #include <errno.h>
 #include <assert.h>
 #include "os/mynewt.h"
+#include "stats/stats.h"
 #include "sensor/sensor.h"
 #include "sensor_priv.h"
 #include "sensor/accel.h"
@@ -33,6 +34,7 @@
 #include "sensor/pressure.h"
 #include "sensor/humidity.h"
 #include "sensor/gyro.h"
+#include "sensor/vals.h"
 #include "console/console.h"
 
 #if MYNEWT_VAL(SENSOR_POLL_TEST_LOG)
@@ -53,13 +55,35 @@ os_time_t smgr_wakeup[500];
 
 struct {
     struct os_mutex mgr_lock;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    struct os_lock_prof mgr_lock_prof;
+#endif
 
     struct os_callout mgr_wakeup_callout;
     struct os_eventq *mgr_eventq;
 
+    /* Wakeup rate, measured over windows of at least a second */
+    os_time_t mgr_wakeup_window;
+    uint32_t mgr_window_wakeups;
+    uint32_t mgr_wakeups_ps;
+
     SLIST_HEAD(, sensor) mgr_sensor_list;
 } sensor_mgr;
 
+STATS_SECT_START(sensor_mgr_stats)
+    STATS_SECT_ENTRY(wakeups)
+    STATS_SECT_ENTRY(polls)
+    STATS_SECT_ENTRY(early_polls)
+STATS_SECT_END
+
+STATS_NAME_START(sensor_mgr_stats)
+    STATS_NAME(sensor_mgr_stats, wakeups)
+    STATS_NAME(sensor_mgr_stats, polls)
+    STATS_NAME(sensor_mgr_stats, early_polls)
+STATS_NAME_END(sensor_mgr_stats)
+
+static STATS_SECT_DECL(sensor_mgr_stats) sensor_mgr_stats;
+
 struct sensor_read_ctx {
     sensor_data_func_t user_func;
     void *user_arg;
@@ -71,6 +95,7 @@ struct os_callout st_up_osco;
 static void sensor_notify_ev_cb(struct os_event * ev);
 static void sensor_read_ev_cb(struct os_event *ev);
 static void sensor_interrupt_ev_cb(struct os_event *ev);
+static void sensor_up_timestamp(struct sensor *sensor);
 
 /** OS event - for doing a sensor read */
 static struct os_event sensor_read_event = {
@@ -524,18 +549,101 @@ sensor_poll_per_type_trait(struct sensor *sensor, os_time_t now,
     sensor_unlock(sensor);
 }
 
+static void
+sensor_mgr_poll_one(struct sensor *sensor, os_time_t now)
+{
+    sensor_lock(sensor);
+
+    if (sensor_type_traits_empty(sensor)) {
+        sensor_mgr_poll_bytype(sensor, sensor->s_mask, NULL, now);
+    } else {
+        sensor_poll_per_type_trait(sensor, now, 0);
+    }
+
+    sensor_update_nextrun(sensor, now);
+
+    sensor_unlock(sensor);
+
+    STATS_INC(sensor_mgr_stats, polls);
+}
+
+static int
+sensor_mgr_same_bus(const struct sensor *a, const struct sensor *b)
+{
+    return a->s_itf.si_type == b->s_itf.si_type &&
+           a->s_itf.si_num == b->s_itf.si_num;
+}
+
+/**
+ * Polls the given sensors, grouped by bus so that transactions on a
+ * shared bus run back to back.
+ */
+static void
+sensor_mgr_poll_due(struct sensor **due, int cnt, os_time_t now)
+{
+    struct sensor *leader;
+    int i;
+    int j;
+
+    for (i = 0; i < cnt; i++) {
+        if (due[i] == NULL) {
+            continue;
+        }
+        leader = due[i];
+        for (j = i; j < cnt; j++) {
+            if (due[j] != NULL && sensor_mgr_same_bus(leader, due[j])) {
+                sensor_mgr_poll_one(due[j], now);
+                due[j] = NULL;
+            }
+        }
+    }
+}
+
+static void
+sensor_mgr_count_wakeup(os_time_t now)
+{
+    os_time_t elapsed;
+
+    STATS_INC(sensor_mgr_stats, wakeups);
+
+    sensor_mgr.mgr_window_wakeups++;
+    elapsed = now - sensor_mgr.mgr_wakeup_window;
+    if (elapsed >= OS_TICKS_PER_SEC) {
+        sensor_mgr.mgr_wakeups_ps = (uint64_t)sensor_mgr.mgr_window_wakeups *
+                                    OS_TICKS_PER_SEC / elapsed;
+        sensor_mgr.mgr_window_wakeups = 0;
+        sensor_mgr.mgr_wakeup_window = now;
+    }
+}
+
+uint32_t
+sensor_mgr_wakeups_per_sec(void)
+{
+    return sensor_mgr.mgr_wakeups_ps;
+}
+
 /**
  * Event that wakes up the sensor manager, this goes through the sensor
  * list and polls any active sensors.
  *
+ * Sensors due within SENSOR_POLL_SLACK_MS of now are polled in the same
+ * wakeup rather than each getting their own.  Since the next run is set
+ * from the wakeup time, sensors with equal or multiple poll rates stay
+ * on shared ticks from then on.
+ *
  * @param OS event
  */
 static void
 sensor_mgr_wakeup_event(struct os_event *ev)
 {
+    struct sensor *due[MYNEWT_VAL(SENSOR_MGR_POLL_BATCH)];
     struct sensor *cursor;
-    os_time_t now;
+    os_time_t rate_ticks;
     os_time_t next_wakeup;
+    os_time_t delta;
+    os_time_t slack;
+    os_time_t now;
+    int cnt;
 
     now = os_time_get();
 
@@ -543,41 +651,53 @@ sensor_mgr_wakeup_event(struct os_event *ev)
     smgr_wakeup[smgr_wakeup_idx++%500] = now;
 #endif
 
-    sensor_mgr_lock();
+    sensor_mgr_count_wakeup(now);
 
-    cursor = NULL;
-    while (1) {
+    os_time_ms_to_ticks(MYNEWT_VAL(SENSOR_POLL_SLACK_MS), &slack);
 
-        cursor = sensor_find_min_nextrun_sensor(now, &next_wakeup);
+    sensor_mgr_lock();
 
-        sensor_lock(cursor);
-        /* Sensors that are not periodic are inserted at the end of the sensor
-         * list.
+    while (1) {
+        /* The list is sorted by what runs first, with sensors that are
+         * not periodic at the end.  Collect everything due, or due
+         * within the slack but less than a period away, so a sensor is
+         * never polled twice in one wakeup.
          */
-        if (!cursor->s_poll_rate) {
-            sensor_unlock(cursor);
-            sensor_mgr_unlock();
-            return;
+        cnt = 0;
+        SLIST_FOREACH(cursor, &sensor_mgr.mgr_sensor_list, s_next) {
+            if (!cursor->s_poll_rate) {
+                break;
+            }
+            delta = sensor_calc_nextrun_delta(cursor, now);
+            if (delta > slack) {
+                break;
+            }
+            os_time_ms_to_ticks(cursor->s_poll_rate, &rate_ticks);
+            if (delta > 0 && delta >= rate_ticks) {
+                continue;
+            }
+            if (delta > 0) {
+                STATS_INC(sensor_mgr_stats, early_polls);
+            }
+            due[cnt++] = cursor;
+            if (cnt == MYNEWT_VAL(SENSOR_MGR_POLL_BATCH)) {
+                break;
+            }
         }
 
-        /* List is sorted by what runs first.  If we reached the first element that
-         * doesn't run, break out.
-         */
-        if (next_wakeup > 0) {
+        if (cnt == 0) {
             break;
         }
 
-        if (sensor_type_traits_empty(cursor)) {
-
-            sensor_mgr_poll_bytype(cursor, cursor->s_mask, NULL, now);
-        } else {
-            sensor_poll_per_type_trait(cursor, now, next_wakeup);
-        }
-
-        sensor_update_nextrun(cursor, now);
+        sensor_mgr_poll_due(due, cnt, now);
+    }
 
-        sensor_unlock(cursor);
+    cursor = SLIST_FIRST(&sensor_mgr.mgr_sensor_list);
+    if (cursor == NULL || !cursor->s_poll_rate) {
+        sensor_mgr_unlock();
+        return;
     }
+    next_wakeup = sensor_calc_nextrun_delta(cursor, now);
 
     sensor_mgr_unlock();
 
@@ -683,7 +803,20 @@ sensor_mgr_init(void)
             sensor_base_ts_update_event, NULL);
     os_callout_reset(&st_up_osco, OS_TICKS_PER_SEC);
 
+    sensor_mgr.mgr_wakeup_window = os_time_get();
+
+    rc = stats_init_and_reg(STATS_HDR(sensor_mgr_stats),
+                            STATS_SIZE_INIT_PARMS(sensor_mgr_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(sensor_mgr_stats),
+                            "sensor_mgr");
+    assert(rc == 0);
+
     os_mutex_init(&sensor_mgr.mgr_lock);
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    os_mutex_prof_register(&sensor_mgr.mgr_lock, &sensor_mgr.mgr_lock_prof,
+                           "sensor_mgr");
+#endif
 }
 
 /**
@@ -852,6 +985,10 @@ sensor_pkg_init(void)
 {
     sensor_mgr_init();
 
+#if MYNEWT_VAL(SENSOR_XFER)
+    sensor_xfer_init();
+#endif
+
 #if MYNEWT_VAL(SENSOR_CLI)
     sensor_shell_register();
 #endif
@@ -1165,12 +1302,25 @@ sensor_read_data_func(struct sensor *sensor, void *arg, void *data,
     struct sensor_listener *listener;
     struct sensor_read_ctx *ctx;
 
+    struct sensor_batch batch;
+
     ctx = (struct sensor_read_ctx *) arg;
 
     if ((uint8_t)(uintptr_t)(ctx->user_arg) != SENSOR_IGN_LISTENER) {
         /* Notify all listeners first */
         SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
-            if (listener->sl_sensor_type & type) {
+            if (!(listener->sl_sensor_type & type)) {
+                continue;
+            }
+            if (listener->sl_batch_func != NULL) {
+                batch = (struct sensor_batch) {
+                    .sb_type = type,
+                    .sb_data = data,
+                    .sb_count = 1,
+                    .sb_base_ts = sensor->s_sts,
+                };
+                listener->sl_batch_func(sensor, listener->sl_arg, &batch);
+            } else {
                 listener->sl_func(sensor, listener->sl_arg, data, type);
             }
         }
@@ -1184,6 +1334,107 @@ sensor_read_data_func(struct sensor *sensor, void *arg, void *data,
     return (0);
 }
 
+/**
+ * Moves a sensor timestamp by a number of microseconds.
+ */
+static void
+sensor_timestamp_add_us(struct sensor_timestamp *sts, int32_t usecs)
+{
+    int32_t usec;
+
+    if (usecs < 0) {
+        sts->st_cputime -= os_cputime_usecs_to_ticks(-usecs);
+    } else {
+        sts->st_cputime += os_cputime_usecs_to_ticks(usecs);
+    }
+
+    usec = (int32_t)sts->st_ostv.tv_usec + usecs % 1000000;
+    sts->st_ostv.tv_sec += usecs / 1000000;
+    if (usec < 0) {
+        usec += 1000000;
+        sts->st_ostv.tv_sec--;
+    } else if (usec >= 1000000) {
+        usec -= 1000000;
+        sts->st_ostv.tv_sec++;
+    }
+    sts->st_ostv.tv_usec = usec;
+}
+
+int
+sensor_data_batch(struct sensor *sensor, sensor_data_func_t data_func,
+                  void *data_arg, struct sensor_batch *batch)
+{
+    struct sensor_listener *listener;
+    struct sensor_read_ctx *ctx;
+    struct sensor_timestamp newest;
+    uint8_t *sample;
+    int notify;
+    int rc;
+    int i;
+
+    if (batch->sb_count == 0) {
+        return 0;
+    }
+
+    sensor_up_timestamp(sensor);
+    newest = sensor->s_sts;
+    batch->sb_base_ts = newest;
+    sensor_timestamp_add_us(&batch->sb_base_ts,
+                            -(int32_t)(batch->sb_period_us *
+                                       (batch->sb_count - 1)));
+
+    ctx = NULL;
+    notify = 0;
+    if (data_func == sensor_read_data_func) {
+        ctx = data_arg;
+        notify = (uint8_t)(uintptr_t)(ctx->user_arg) != SENSOR_IGN_LISTENER;
+    }
+
+    if (notify) {
+        SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
+            if ((listener->sl_sensor_type & batch->sb_type) &&
+                listener->sl_batch_func != NULL) {
+                listener->sl_batch_func(sensor, listener->sl_arg, batch);
+            }
+        }
+    }
+
+    /* Per sample delivery for everyone else. */
+    rc = 0;
+    sensor->s_sts = batch->sb_base_ts;
+    sample = batch->sb_data;
+    for (i = 0; i < batch->sb_count; i++) {
+        if (i > 0) {
+            sensor_timestamp_add_us(&sensor->s_sts, batch->sb_period_us);
+        }
+
+        if (ctx == NULL) {
+            rc = data_func(sensor, data_arg, sample, batch->sb_type);
+        } else {
+            if (notify) {
+                SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
+                    if ((listener->sl_sensor_type & batch->sb_type) &&
+                        listener->sl_batch_func == NULL) {
+                        listener->sl_func(sensor, listener->sl_arg, sample,
+                                          batch->sb_type);
+                    }
+                }
+            }
+            if (ctx->user_func != NULL) {
+                rc = ctx->user_func(sensor, ctx->user_arg, sample,
+                                    batch->sb_type);
+            }
+        }
+        if (rc != 0) {
+            break;
+        }
+        sample += batch->sb_sample_size;
+    }
+    sensor->s_sts = newest;
+
+    return rc;
+}
+
 /**
  * Puts a interrupt event on the sensor manager evq
  *
@@ -2094,6 +2345,162 @@ err:
     return rc;
 }
 
+#if MYNEWT_VAL(SENSOR_REPORT)
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+#define SENSOR_REPORT_PCT(v, pct)   ((sensor_fp_t)(((int64_t)(v) * (pct)) / 100))
+#else
+#define SENSOR_REPORT_PCT(v, pct)   ((v) * (pct) / 100)
+#endif
+
+static sensor_fp_t
+sensor_report_abs(sensor_fp_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+/**
+ * Checks whether any value of a sample lies outside the deadband around the
+ * last reported one.  The band is expressed as a low and high watermark so
+ * the watermark comparison, which ignores invalid values, does the work.
+ */
+static uint8_t
+sensor_report_changed(struct sensor_report *sr, sensor_type_t type,
+                      void *data)
+{
+    union sensor_data_buf low_buf;
+    union sensor_data_buf high_buf;
+    sensor_fp_t low[SENSOR_VALS_MAX];
+    sensor_fp_t high[SENSOR_VALS_MAX];
+    sensor_data_t low_thresh;
+    sensor_data_t high_thresh;
+    sensor_fp_t band;
+    sensor_fp_t pct;
+    int i;
+
+    if (!sr->sr_last_valid ||
+        (!sr->sr_cfg.src_abs_delta && !sr->sr_cfg.src_pct_delta)) {
+        return 0;
+    }
+
+    for (i = 0; i < sensor_type_nvals(type); i++) {
+        band = sr->sr_cfg.src_abs_delta;
+        pct = SENSOR_REPORT_PCT(sensor_report_abs(sr->sr_last[i]),
+                                sr->sr_cfg.src_pct_delta);
+        if (pct > band) {
+            band = pct;
+        }
+        low[i] = sr->sr_last[i] - band;
+        high[i] = sr->sr_last[i] + band;
+    }
+
+    sensor_vals_to_data(type, low, &low_buf);
+    sensor_vals_to_data(type, high, &high_buf);
+
+    /* All members of sensor_data_t are pointers to the data structs */
+    low_thresh.sad = &low_buf.sad;
+    high_thresh.sad = &high_buf.sad;
+
+    return sensor_watermark_cmp(type, &low_thresh, &high_thresh, data);
+}
+
+/**
+ * Applies a report-on-change configuration to the result of the threshold
+ * comparison for a sample.
+ *
+ * @return 1 if the sample is to be reported, 0 if not
+ */
+static uint8_t
+sensor_report_filter(struct sensor_report *sr, sensor_type_t type,
+                     void *data, uint8_t thresh)
+{
+    sensor_fp_t v[SENSOR_VALS_MAX];
+    sensor_fp_t dist;
+    os_time_t now;
+    os_time_t since;
+    uint8_t report;
+    int have_vals;
+    int i;
+
+    now = os_time_get();
+    since = now - sr->sr_time;
+    if (sr->sr_reported && since < sr->sr_min_ticks) {
+        return 0;
+    }
+
+    have_vals = sensor_data_to_vals(type, data, v) == 0;
+
+    if (sr->sr_cfg.src_hysteresis) {
+        if (sr->sr_tripped) {
+            if (!thresh) {
+                dist = 0;
+                if (sr->sr_trip_valid && have_vals) {
+                    for (i = 0; i < sensor_type_nvals(type); i++) {
+                        if (sensor_report_abs(v[i] - sr->sr_trip[i]) > dist) {
+                            dist = sensor_report_abs(v[i] - sr->sr_trip[i]);
+                        }
+                    }
+                }
+                if (!sr->sr_trip_valid || dist >= sr->sr_cfg.src_hysteresis) {
+                    sr->sr_tripped = 0;
+                }
+            }
+            thresh = 0;
+        } else if (thresh) {
+            sr->sr_tripped = 1;
+            sr->sr_trip_valid = have_vals;
+            if (have_vals) {
+                memcpy(sr->sr_trip, v, sizeof(v));
+            }
+        }
+    }
+
+    report = thresh || !sr->sr_reported ||
+             sensor_report_changed(sr, type, data) ||
+             (sr->sr_max_ticks && since >= sr->sr_max_ticks);
+    if (report) {
+        sr->sr_time = now;
+        sr->sr_reported = 1;
+        sr->sr_last_valid = have_vals;
+        if (have_vals) {
+            memcpy(sr->sr_last, v, sizeof(v));
+        }
+    }
+
+    return report;
+}
+
+int
+sensor_set_report(char *devname, sensor_type_t type, struct sensor_report *sr,
+                  const struct sensor_report_cfg *cfg)
+{
+    struct sensor_type_traits *stt;
+    struct sensor *sensor;
+    int rc;
+
+    stt = NULL;
+    sensor = sensor_get_type_traits_byname(devname, &stt, type);
+    if (!sensor || !stt) {
+        return SYS_EINVAL;
+    }
+
+    if (sr) {
+        memset(sr, 0, sizeof(*sr));
+        sr->sr_cfg = *cfg;
+        sr->sr_min_ticks = os_time_ms_to_ticks32(cfg->src_min_itvl_ms);
+        sr->sr_max_ticks = os_time_ms_to_ticks32(cfg->src_max_itvl_ms);
+    }
+
+    rc = sensor_lock(sensor);
+    if (rc) {
+        return rc;
+    }
+    stt->stt_report = sr;
+    sensor_unlock(sensor);
+
+    return 0;
+}
+#endif
+
 static int
 sensor_generate_trig(struct sensor *sensor,
                      void *arg, void *data,
@@ -2111,6 +2518,9 @@ sensor_generate_trig(struct sensor *sensor,
 
     notify = arg;
     stt = sensor_get_type_traits_bytype(type, sensor);
+    if (!stt) {
+        return 0;
+    }
 
     tx_trigger = 0;
 
@@ -2122,6 +2532,13 @@ sensor_generate_trig(struct sensor *sensor,
                                                &high_thresh, data);
     }
 
+#if MYNEWT_VAL(SENSOR_REPORT)
+    if (stt->stt_report) {
+        tx_trigger = sensor_report_filter(stt->stt_report, type, data,
+                                          tx_trigger);
+    }
+#endif
+
     return tx_trigger ? notify(sensor, data, type): 0;
 }
 
@@ -2143,6 +2560,7 @@ sensor_trigger_init(struct sensor *sensor, sensor_type_t type,
     assert(sensor_trig_lner != NULL);
 
     sensor_trig_lner->sl_func = sensor_generate_trig;
+    sensor_trig_lner->sl_batch_func = NULL;
     sensor_trig_lner->sl_sensor_type = type;
     sensor_trig_lner->sl_arg = (void *)notify;
 
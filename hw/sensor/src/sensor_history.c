@@ -0,0 +1,293 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(SENSOR_HISTORY)
+
+#include "sensor/sensor.h"
+#include "sensor/vals.h"
+#include "sensor/history.h"
+
+static SLIST_HEAD(, sensor_history) g_sensor_history_list =
+    SLIST_HEAD_INITIALIZER(g_sensor_history_list);
+
+static inline uint32_t *
+sensor_history_rec(struct sensor_history *sh, uint16_t idx)
+{
+    return &sh->sh_buf[(uint32_t)idx * (1 + sh->sh_nvals)];
+}
+
+static void
+sensor_history_record(struct sensor_history *sh, os_time_t t, void *data)
+{
+    sensor_fp_t v[SENSOR_VALS_MAX];
+    uint32_t *rec;
+    uint16_t idx;
+    os_sr_t sr;
+
+    if (sensor_data_to_vals(sh->sh_type, data, v) != 0) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (sh->sh_cnt < sh->sh_cap) {
+        idx = (sh->sh_head + sh->sh_cnt) % sh->sh_cap;
+        sh->sh_cnt++;
+    } else {
+        idx = sh->sh_head;
+        sh->sh_head = (sh->sh_head + 1) % sh->sh_cap;
+    }
+    rec = sensor_history_rec(sh, idx);
+    rec[0] = t;
+    memcpy(&rec[1], v, sh->sh_nvals * sizeof(sensor_fp_t));
+    sh->sh_seq++;
+    OS_EXIT_CRITICAL(sr);
+}
+
+static int
+sensor_history_data_func(struct sensor *sensor, void *arg, void *data,
+                         sensor_type_t type)
+{
+    sensor_history_record(arg, os_time_get(), data);
+
+    return 0;
+}
+
+static int
+sensor_history_batch_func(struct sensor *sensor, void *arg,
+                          const struct sensor_batch *batch)
+{
+    struct sensor_history *sh;
+    uint8_t *sample;
+    os_time_t now;
+    uint64_t age_us;
+    int i;
+
+    sh = arg;
+    now = os_time_get();
+    sample = batch->sb_data;
+
+    /* The last sample of a batch was read just now, earlier ones one
+     * period apart before it.
+     */
+    for (i = 0; i < batch->sb_count; i++) {
+        age_us = (uint64_t)(batch->sb_count - 1 - i) * batch->sb_period_us;
+        sensor_history_record(sh,
+                              now - (os_time_t)(age_us * OS_TICKS_PER_SEC /
+                                                1000000),
+                              sample);
+        sample += batch->sb_sample_size;
+    }
+
+    return 0;
+}
+
+int
+sensor_history_init(struct sensor_history *sh, sensor_type_t type,
+                    uint32_t *buf, uint16_t cap)
+{
+    int nvals;
+
+    nvals = sensor_type_nvals(type);
+    if (nvals == 0 || buf == NULL || cap == 0) {
+        return SYS_EINVAL;
+    }
+
+    memset(sh, 0, sizeof(*sh));
+    sh->sh_type = type;
+    sh->sh_nvals = nvals;
+    sh->sh_cap = cap;
+    sh->sh_buf = buf;
+
+    sh->sh_listener.sl_sensor_type = type;
+    sh->sh_listener.sl_func = sensor_history_data_func;
+    sh->sh_listener.sl_batch_func = sensor_history_batch_func;
+    sh->sh_listener.sl_arg = sh;
+
+    return 0;
+}
+
+int
+sensor_history_attach(struct sensor *sensor, struct sensor_history *sh)
+{
+    int rc;
+
+    if (sh->sh_sensor != NULL) {
+        return SYS_EALREADY;
+    }
+
+    rc = sensor_register_listener(sensor, &sh->sh_listener);
+    if (rc) {
+        return rc;
+    }
+
+    sensor_mgr_lock();
+    sh->sh_sensor = sensor;
+    SLIST_INSERT_HEAD(&g_sensor_history_list, sh, sh_next);
+    sensor_mgr_unlock();
+
+    return 0;
+}
+
+int
+sensor_history_detach(struct sensor_history *sh)
+{
+    int rc;
+
+    if (sh->sh_sensor == NULL) {
+        return SYS_EINVAL;
+    }
+
+    rc = sensor_unregister_listener(sh->sh_sensor, &sh->sh_listener);
+    if (rc) {
+        return rc;
+    }
+
+    sensor_mgr_lock();
+    SLIST_REMOVE(&g_sensor_history_list, sh, sensor_history, sh_next);
+    sh->sh_sensor = NULL;
+    sensor_mgr_unlock();
+
+    return 0;
+}
+
+struct sensor_history *
+sensor_history_find(struct sensor *sensor, sensor_type_t type)
+{
+    struct sensor_history *sh;
+
+    sensor_mgr_lock();
+    SLIST_FOREACH(sh, &g_sensor_history_list, sh_next) {
+        if (sh->sh_sensor == sensor && sh->sh_type == type) {
+            break;
+        }
+    }
+    sensor_mgr_unlock();
+
+    return sh;
+}
+
+/**
+ * Visits samples from absolute sequence number seq onwards.  Each record is
+ * copied out with interrupts disabled and func is called without; samples
+ * overwritten in the meantime are skipped.
+ */
+static int
+sensor_history_walk(struct sensor_history *sh, uint32_t seq, os_time_t from,
+                    os_time_t to, int check_time,
+                    sensor_history_func_t func, void *arg)
+{
+    sensor_fp_t v[SENSOR_VALS_MAX];
+    union sensor_data_buf data;
+    uint32_t oldest;
+    uint32_t *rec;
+    os_time_t t;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (seq == sh->sh_seq) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        oldest = sh->sh_seq - sh->sh_cnt;
+        if ((int32_t)(seq - oldest) < 0) {
+            seq = oldest;
+        }
+        rec = sensor_history_rec(sh, (sh->sh_head + (seq - oldest)) %
+                                     sh->sh_cap);
+        t = rec[0];
+        memcpy(v, &rec[1], sh->sh_nvals * sizeof(sensor_fp_t));
+        OS_EXIT_CRITICAL(sr);
+
+        seq++;
+
+        if (check_time) {
+            if (OS_TIME_TICK_LT(t, from)) {
+                continue;
+            }
+            if (OS_TIME_TICK_GT(t, to)) {
+                break;
+            }
+        }
+
+        sensor_vals_to_data(sh->sh_type, v, &data);
+        rc = func(sh, t, &data, arg);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+int
+sensor_history_query(struct sensor_history *sh, os_time_t from,
+                     os_time_t to, sensor_history_func_t func, void *arg)
+{
+    uint32_t seq;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    seq = sh->sh_seq - sh->sh_cnt;
+    OS_EXIT_CRITICAL(sr);
+
+    return sensor_history_walk(sh, seq, from, to, 1, func, arg);
+}
+
+int
+sensor_history_last(struct sensor_history *sh, uint16_t n,
+                    sensor_history_func_t func, void *arg)
+{
+    uint32_t seq;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (n > sh->sh_cnt) {
+        n = sh->sh_cnt;
+    }
+    seq = sh->sh_seq - n;
+    OS_EXIT_CRITICAL(sr);
+
+    return sensor_history_walk(sh, seq, 0, 0, 0, func, arg);
+}
+
+int
+sensor_history_latest(struct sensor_history *sh, os_time_t *t)
+{
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (sh->sh_cnt == 0) {
+        rc = SYS_ENOENT;
+    } else {
+        *t = sensor_history_rec(sh, (sh->sh_head + sh->sh_cnt - 1) %
+                                    sh->sh_cap)[0];
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+#endif
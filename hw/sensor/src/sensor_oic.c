@@ -37,6 +37,7 @@
 #include "sensor/pressure.h"
 #include "sensor/humidity.h"
 #include "sensor/gyro.h"
+#include "sensor/history.h"
 
 /* OIC */
 #include <oic/oc_rep.h>
@@ -62,19 +63,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
 
             if (((struct sensor_gyro_data *)(databuf))->sgd_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_gyro_data *)(databuf))->sgd_x);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_gyro_data *)(databuf))->sgd_x));
             } else {
                 goto err;
             }
             if (((struct sensor_gyro_data *)(databuf))->sgd_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_gyro_data *)(databuf))->sgd_y);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_gyro_data *)(databuf))->sgd_y));
             } else {
                 goto err;
             }
             if (((struct sensor_gyro_data *)(databuf))->sgd_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_gyro_data *)(databuf))->sgd_z);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_gyro_data *)(databuf))->sgd_z));
             } else {
                 goto err;
             }
@@ -89,19 +90,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
 
             if (((struct sensor_accel_data *)(databuf))->sad_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_accel_data *)(databuf))->sad_x);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_x));
             } else {
                 goto err;
             }
             if (((struct sensor_accel_data *)(databuf))->sad_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_accel_data *)(databuf))->sad_y);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_y));
             } else {
                 goto err;
             }
             if (((struct sensor_accel_data *)(databuf))->sad_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_accel_data *)(databuf))->sad_z);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_z));
             } else {
                 goto err;
             }
@@ -111,19 +112,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_MAGNETIC_FIELD:
             if (((struct sensor_mag_data *)(databuf))->smd_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_mag_data *)(databuf))->smd_x);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_x));
             } else {
                 goto err;
             }
             if (((struct sensor_mag_data *)(databuf))->smd_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_mag_data *)(databuf))->smd_y);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_y));
             } else {
                 goto err;
             }
             if (((struct sensor_mag_data *)(databuf))->smd_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_mag_data *)(databuf))->smd_z);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_z));
             } else {
                 goto err;
             }
@@ -154,7 +155,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_TEMPERATURE:
             if (((struct sensor_temp_data *)(databuf))->std_temp_is_valid) {
                 oc_rep_set_double(root, temp,
-                    ((struct sensor_temp_data *)(databuf))->std_temp);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_temp_data *)(databuf))->std_temp));
             }
             break;
 
@@ -162,7 +163,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_AMBIENT_TEMPERATURE:
             if (((struct sensor_temp_data *)(databuf))->std_temp_is_valid) {
                 oc_rep_set_double(root, temp,
-                    ((struct sensor_temp_data *)(databuf))->std_temp);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_temp_data *)(databuf))->std_temp));
             }
             break;
 
@@ -170,7 +171,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_PRESSURE:
             if (((struct sensor_press_data *)(databuf))->spd_press_is_valid) {
                 oc_rep_set_double(root, press,
-                    ((struct sensor_press_data *)(databuf))->spd_press);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_press_data *)(databuf))->spd_press));
             }
             break;
 
@@ -178,7 +179,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_RELATIVE_HUMIDITY:
             if (((struct sensor_humid_data *)(databuf))->shd_humid_is_valid) {
                 oc_rep_set_double(root, humid,
-                    ((struct sensor_humid_data *)(databuf))->shd_humid);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_humid_data *)(databuf))->shd_humid));
             }
             break;
 
@@ -186,25 +187,25 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_ROTATION_VECTOR:
             if (((struct sensor_quat_data *)(databuf))->sqd_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_quat_data *)(databuf))->sqd_x);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_x));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_quat_data *)(databuf))->sqd_y);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_y));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_quat_data *)(databuf))->sqd_z);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_z));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_w_is_valid) {
                 oc_rep_set_double(root, w,
-                    ((struct sensor_quat_data *)(databuf))->sqd_w);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_w));
             } else {
                 goto err;
             }
@@ -214,19 +215,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
         case SENSOR_TYPE_EULER:
             if (((struct sensor_euler_data *)(databuf))->sed_h_is_valid) {
                 oc_rep_set_double(root, h,
-                    ((struct sensor_euler_data *)(databuf))->sed_h);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_h));
             } else {
                 goto err;
             }
             if (((struct sensor_euler_data *)(databuf))->sed_r_is_valid) {
                 oc_rep_set_double(root, r,
-                    ((struct sensor_euler_data *)(databuf))->sed_r);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_r));
             } else {
                 goto err;
             }
             if (((struct sensor_euler_data *)(databuf))->sed_p_is_valid) {
                 oc_rep_set_double(root, p,
-                    ((struct sensor_euler_data *)(databuf))->sed_p);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_p));
             } else {
                 goto err;
             }
@@ -284,7 +285,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf,
             }
             if (((struct sensor_color_data *)(databuf))->scd_cratio_is_valid) {
                 oc_rep_set_double(root, cratio,
-                    ((struct sensor_color_data *)(databuf))->scd_cratio);
+                    SENSOR_FP_TO_FLOAT(((struct sensor_color_data *)(databuf))->scd_cratio));
             } else {
                 goto err;
             }
@@ -526,6 +527,46 @@ err:
     return SYS_EINVAL;
 }
 
+#if MYNEWT_VAL(SENSOR_HISTORY) && MYNEWT_VAL(SENSOR_HISTORY_OIC_MAX_AGE_MS)
+static int
+sensor_oic_history_encode(struct sensor_history *sh, os_time_t t, void *data,
+                          void *arg)
+{
+    return sensor_oic_encode(sh->sh_sensor, arg, data, sh->sh_type);
+}
+
+/**
+ * Encodes the latest sample of a type from the sensor's history, avoiding a
+ * bus transaction, if the history has a recent enough one.
+ *
+ * @return 0 if the sample was encoded, non-zero if the sensor must be read
+ */
+static int
+sensor_oic_encode_history(struct sensor *sensor, sensor_type_t type)
+{
+    struct sensor_history *sh;
+    os_time_t t;
+    int rc;
+
+    sh = sensor_history_find(sensor, type);
+    if (!sh) {
+        return SYS_ENOENT;
+    }
+
+    rc = sensor_history_latest(sh, &t);
+    if (rc) {
+        return rc;
+    }
+
+    if (os_time_get() - t >
+        os_time_ms_to_ticks32(MYNEWT_VAL(SENSOR_HISTORY_OIC_MAX_AGE_MS))) {
+        return SYS_ENOENT;
+    }
+
+    return sensor_history_last(sh, 1, sensor_oic_history_encode, NULL);
+}
+#endif
+
 static void
 sensor_oic_get_data(oc_request_t *request, oc_interface_mask_t interface)
 {
@@ -572,6 +613,12 @@ sensor_oic_get_data(oc_request_t *request, oc_interface_mask_t interface)
             goto err;
         }
 
+#if MYNEWT_VAL(SENSOR_HISTORY) && MYNEWT_VAL(SENSOR_HISTORY_OIC_MAX_AGE_MS)
+        if (sensor_oic_encode_history(sensor, type) == 0) {
+            break;
+        }
+#endif
+
         rc = sensor_read(sensor, type, sensor_oic_encode,
                          (uintptr_t *)SENSOR_IGN_LISTENER,
                          OS_TIMEOUT_NEVER);
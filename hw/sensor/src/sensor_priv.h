@@ -26,4 +26,8 @@
 int sensor_shell_register(void);
 #endif
 
+#if MYNEWT_VAL(SENSOR_XFER)
+void sensor_xfer_init(void);
+#endif
+
 #endif /* __SENSOR_PRIV_H__ */
@@ -37,6 +37,7 @@
 #include "sensor/pressure.h"
 #include "sensor/humidity.h"
 #include "sensor/gyro.h"
+#include "sensor/history.h"
 #include "console/console.h"
 #include "shell/shell.h"
 #include "hal/hal_i2c.h"
@@ -82,6 +83,12 @@ sensor_display_help(void)
     console_printf("  type <sensor_name>\n");
     console_printf("      types supported by registered sensor\n");
     console_printf("  notify <sensor_name> [on/off] <type>\n");
+    console_printf("  wakeups\n");
+    console_printf("      sensor manager polling wakeups per second\n");
+#if MYNEWT_VAL(SENSOR_HISTORY)
+    console_printf("  history <sensor_name> <type> [n]\n");
+    console_printf("      last <n> samples of type:<type> stored in the sensor's history\n");
+#endif
 }
 
 static void
@@ -242,9 +249,8 @@ sensor_ftostr(float num, char *fltstr, int len)
     return fltstr;
 }
 
-static int
-sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
-                           sensor_type_t type)
+static void
+sensor_shell_print_data(void *data, sensor_type_t type)
 {
     struct sensor_accel_data *sad;
     struct sensor_mag_data *smd;
@@ -258,26 +264,19 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
     struct sensor_gyro_data *sgd;
     char tmpstr[13];
 
-    ++g_sensor_shell_num_entries;
-
-    console_printf("ts: [ secs: %ld usecs: %d cputime: %u ]\n",
-                   (long int)sensor->s_sts.st_ostv.tv_sec,
-                   (int)sensor->s_sts.st_ostv.tv_usec,
-                   (unsigned int)sensor->s_sts.st_cputime);
-
     if (type == SENSOR_TYPE_ACCELEROMETER ||
         type == SENSOR_TYPE_LINEAR_ACCEL  ||
         type == SENSOR_TYPE_GRAVITY) {
 
         sad = (struct sensor_accel_data *) data;
         if (sad->sad_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(sad->sad_x, tmpstr, 13));
+            console_printf("x = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sad->sad_x), tmpstr, 13));
         }
         if (sad->sad_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(sad->sad_y, tmpstr, 13));
+            console_printf("y = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sad->sad_y), tmpstr, 13));
         }
         if (sad->sad_z_is_valid) {
-            console_printf("z = %s", sensor_ftostr(sad->sad_z, tmpstr, 13));
+            console_printf("z = %s", sensor_ftostr(SENSOR_FP_TO_FLOAT(sad->sad_z), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -285,13 +284,13 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
     if (type == SENSOR_TYPE_MAGNETIC_FIELD) {
         smd = (struct sensor_mag_data *) data;
         if (smd->smd_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(smd->smd_x, tmpstr, 13));
+            console_printf("x = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(smd->smd_x), tmpstr, 13));
         }
         if (smd->smd_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(smd->smd_y, tmpstr, 13));
+            console_printf("y = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(smd->smd_y), tmpstr, 13));
         }
         if (smd->smd_z_is_valid) {
-            console_printf("z = %s ", sensor_ftostr(smd->smd_z, tmpstr, 13));
+            console_printf("z = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(smd->smd_z), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -299,13 +298,13 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
     if (type == SENSOR_TYPE_GYROSCOPE) {
         sgd = (struct sensor_gyro_data *) data;
         if (sgd->sgd_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(sgd->sgd_x, tmpstr, 13));
+            console_printf("x = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sgd->sgd_x), tmpstr, 13));
         }
         if (sgd->sgd_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(sgd->sgd_y, tmpstr, 13));
+            console_printf("y = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sgd->sgd_y), tmpstr, 13));
         }
         if (sgd->sgd_z_is_valid) {
-            console_printf("z = %s ", sensor_ftostr(sgd->sgd_z, tmpstr, 13));
+            console_printf("z = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sgd->sgd_z), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -329,7 +328,7 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
 
         std = (struct sensor_temp_data *) data;
         if (std->std_temp_is_valid) {
-            console_printf("temperature = %s Deg C", sensor_ftostr(std->std_temp, tmpstr, 13));
+            console_printf("temperature = %s Deg C", sensor_ftostr(SENSOR_FP_TO_FLOAT(std->std_temp), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -337,13 +336,13 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
     if (type == SENSOR_TYPE_EULER) {
         sed = (struct sensor_euler_data *) data;
         if (sed->sed_h_is_valid) {
-            console_printf("h = %s", sensor_ftostr(sed->sed_h, tmpstr, 13));
+            console_printf("h = %s", sensor_ftostr(SENSOR_FP_TO_FLOAT(sed->sed_h), tmpstr, 13));
         }
         if (sed->sed_r_is_valid) {
-            console_printf("r = %s", sensor_ftostr(sed->sed_r, tmpstr, 13));
+            console_printf("r = %s", sensor_ftostr(SENSOR_FP_TO_FLOAT(sed->sed_r), tmpstr, 13));
         }
         if (sed->sed_p_is_valid) {
-            console_printf("p = %s", sensor_ftostr(sed->sed_p, tmpstr, 13));
+            console_printf("p = %s", sensor_ftostr(SENSOR_FP_TO_FLOAT(sed->sed_p), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -351,16 +350,16 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
     if (type == SENSOR_TYPE_ROTATION_VECTOR) {
         sqd = (struct sensor_quat_data *) data;
         if (sqd->sqd_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(sqd->sqd_x, tmpstr, 13));
+            console_printf("x = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sqd->sqd_x), tmpstr, 13));
         }
         if (sqd->sqd_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(sqd->sqd_y, tmpstr, 13));
+            console_printf("y = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sqd->sqd_y), tmpstr, 13));
         }
         if (sqd->sqd_z_is_valid) {
-            console_printf("z = %s ", sensor_ftostr(sqd->sqd_z, tmpstr, 13));
+            console_printf("z = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sqd->sqd_z), tmpstr, 13));
         }
         if (sqd->sqd_w_is_valid) {
-            console_printf("w = %s ", sensor_ftostr(sqd->sqd_w, tmpstr, 13));
+            console_printf("w = %s ", sensor_ftostr(SENSOR_FP_TO_FLOAT(sqd->sqd_w), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -398,7 +397,7 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
             console_printf(scd->scd_is_sat ? "is saturated, " : "not saturated, ");
         }
         if (scd->scd_cratio_is_valid) {
-            console_printf("cRatio = %s, ", sensor_ftostr(scd->scd_cratio, tmpstr, 13));
+            console_printf("cRatio = %s, ", sensor_ftostr(SENSOR_FP_TO_FLOAT(scd->scd_cratio), tmpstr, 13));
         }
         if (scd->scd_maxlux_is_valid) {
             console_printf("max lux = %u, ", scd->scd_maxlux);
@@ -411,7 +410,7 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
         spd = (struct sensor_press_data *) data;
         if (spd->spd_press_is_valid) {
             console_printf("pressure = %s Pa",
-                           sensor_ftostr(spd->spd_press, tmpstr, 13));
+                           sensor_ftostr(SENSOR_FP_TO_FLOAT(spd->spd_press), tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -420,14 +419,65 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
         shd = (struct sensor_humid_data *) data;
         if (shd->shd_humid_is_valid) {
             console_printf("relative humidity = %s%%rh",
-                           sensor_ftostr(shd->shd_humid, tmpstr, 13));
+                           sensor_ftostr(SENSOR_FP_TO_FLOAT(shd->shd_humid), tmpstr, 13));
         }
         console_printf("\n");
     }
+}
+
+static int
+sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data,
+                           sensor_type_t type)
+{
+    ++g_sensor_shell_num_entries;
+
+    console_printf("ts: [ secs: %ld usecs: %d cputime: %u ]\n",
+                   (long int)sensor->s_sts.st_ostv.tv_sec,
+                   (int)sensor->s_sts.st_ostv.tv_usec,
+                   (unsigned int)sensor->s_sts.st_cputime);
+
+    sensor_shell_print_data(data, type);
 
     return (0);
 }
 
+#if MYNEWT_VAL(SENSOR_HISTORY)
+static int
+sensor_shell_history_entry(struct sensor_history *sh, os_time_t t,
+                           void *data, void *arg)
+{
+    console_printf("ticks: %lu age: %lu\n", (unsigned long)t,
+                   (unsigned long)(os_time_get() - t));
+    sensor_shell_print_data(data, sh->sh_type);
+
+    return (0);
+}
+
+static int
+sensor_cmd_history(char *name, sensor_type_t type, int n)
+{
+    struct sensor_history *sh;
+    struct sensor *sensor;
+
+    sensor = sensor_mgr_find_next_bydevname(name, NULL);
+    if (!sensor) {
+        console_printf("Sensor %s not found!\n", name);
+        return SYS_EINVAL;
+    }
+
+    sh = sensor_history_find(sensor, type);
+    if (!sh) {
+        console_printf("No history of type 0x%x for sensor %s\n",
+                       (int)type, name);
+        return SYS_EINVAL;
+    }
+
+    console_printf("%u of %u samples stored\n", sh->sh_cnt, sh->sh_cap);
+
+    return sensor_history_last(sh, n, sensor_shell_history_entry, NULL);
+}
+#endif
+
 /* Check for number of samples */
 static int
 sensor_shell_chk_nsamples(struct sensor_poll_data *spd)
@@ -725,6 +775,26 @@ sensor_cmd_exec(int argc, char **argv)
            goto done;
         }
 
+    } else if (!strcmp(argv[1], "wakeups")) {
+        console_printf("sensor mgr wakeups: %lu/s\n",
+                       (unsigned long)sensor_mgr_wakeups_per_sec());
+#if MYNEWT_VAL(SENSOR_HISTORY)
+    } else if (!strcmp(argv[1], "history")) {
+        if (argc < 4) {
+            console_printf("Too few arguments: %d\n"
+                           "Usage: sensor history <sensor_name> <type> [n]\n",
+                           argc - 2);
+            rc = SYS_EINVAL;
+            goto done;
+        }
+
+        rc = sensor_cmd_history(argv[2],
+                                (sensor_type_t) strtol(argv[3], NULL, 0),
+                                argc > 4 ? atoi(argv[4]) : 1);
+        if (rc) {
+            goto done;
+        }
+#endif
     } else if (!strcmp(argv[1], "read_stop")) {
         os_cputime_timer_stop(&g_sensor_shell_timer);
         console_printf("Stop read\n");
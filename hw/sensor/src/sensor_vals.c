@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "sensor/vals.h"
+
+int
+sensor_type_nvals(sensor_type_t type)
+{
+    switch (type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+    case SENSOR_TYPE_GYROSCOPE:
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+    case SENSOR_TYPE_EULER:
+        return 3;
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        return 4;
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+    case SENSOR_TYPE_PRESSURE:
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int
+sensor_data_to_vals(sensor_type_t type, const void *data, sensor_fp_t *v)
+{
+    const union sensor_data_buf *d;
+
+    d = data;
+    memset(v, 0, SENSOR_VALS_MAX * sizeof(*v));
+
+    switch (type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+        if (!d->sad.sad_x_is_valid || !d->sad.sad_y_is_valid ||
+            !d->sad.sad_z_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->sad.sad_x;
+        v[1] = d->sad.sad_y;
+        v[2] = d->sad.sad_z;
+        return 0;
+    case SENSOR_TYPE_GYROSCOPE:
+        if (!d->sgd.sgd_x_is_valid || !d->sgd.sgd_y_is_valid ||
+            !d->sgd.sgd_z_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->sgd.sgd_x;
+        v[1] = d->sgd.sgd_y;
+        v[2] = d->sgd.sgd_z;
+        return 0;
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+        if (!d->smd.smd_x_is_valid || !d->smd.smd_y_is_valid ||
+            !d->smd.smd_z_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->smd.smd_x;
+        v[1] = d->smd.smd_y;
+        v[2] = d->smd.smd_z;
+        return 0;
+    case SENSOR_TYPE_EULER:
+        if (!d->sed.sed_h_is_valid || !d->sed.sed_r_is_valid ||
+            !d->sed.sed_p_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->sed.sed_h;
+        v[1] = d->sed.sed_r;
+        v[2] = d->sed.sed_p;
+        return 0;
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        if (!d->sqd.sqd_x_is_valid || !d->sqd.sqd_y_is_valid ||
+            !d->sqd.sqd_z_is_valid || !d->sqd.sqd_w_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->sqd.sqd_x;
+        v[1] = d->sqd.sqd_y;
+        v[2] = d->sqd.sqd_z;
+        v[3] = d->sqd.sqd_w;
+        return 0;
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+        if (!d->std.std_temp_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->std.std_temp;
+        return 0;
+    case SENSOR_TYPE_PRESSURE:
+        if (!d->spd.spd_press_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->spd.spd_press;
+        return 0;
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        if (!d->shd.shd_humid_is_valid) {
+            return SYS_EINVAL;
+        }
+        v[0] = d->shd.shd_humid;
+        return 0;
+    default:
+        return SYS_EINVAL;
+    }
+}
+
+void
+sensor_vals_to_data(sensor_type_t type, const sensor_fp_t *v,
+                    union sensor_data_buf *d)
+{
+    memset(d, 0, sizeof(*d));
+
+    switch (type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+        d->sad.sad_x = v[0];
+        d->sad.sad_y = v[1];
+        d->sad.sad_z = v[2];
+        d->sad.sad_x_is_valid = 1;
+        d->sad.sad_y_is_valid = 1;
+        d->sad.sad_z_is_valid = 1;
+        break;
+    case SENSOR_TYPE_GYROSCOPE:
+        d->sgd.sgd_x = v[0];
+        d->sgd.sgd_y = v[1];
+        d->sgd.sgd_z = v[2];
+        d->sgd.sgd_x_is_valid = 1;
+        d->sgd.sgd_y_is_valid = 1;
+        d->sgd.sgd_z_is_valid = 1;
+        break;
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+        d->smd.smd_x = v[0];
+        d->smd.smd_y = v[1];
+        d->smd.smd_z = v[2];
+        d->smd.smd_x_is_valid = 1;
+        d->smd.smd_y_is_valid = 1;
+        d->smd.smd_z_is_valid = 1;
+        break;
+    case SENSOR_TYPE_EULER:
+        d->sed.sed_h = v[0];
+        d->sed.sed_r = v[1];
+        d->sed.sed_p = v[2];
+        d->sed.sed_h_is_valid = 1;
+        d->sed.sed_r_is_valid = 1;
+        d->sed.sed_p_is_valid = 1;
+        break;
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        d->sqd.sqd_x = v[0];
+        d->sqd.sqd_y = v[1];
+        d->sqd.sqd_z = v[2];
+        d->sqd.sqd_w = v[3];
+        d->sqd.sqd_x_is_valid = 1;
+        d->sqd.sqd_y_is_valid = 1;
+        d->sqd.sqd_z_is_valid = 1;
+        d->sqd.sqd_w_is_valid = 1;
+        break;
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+        d->std.std_temp = v[0];
+        d->std.std_temp_is_valid = 1;
+        break;
+    case SENSOR_TYPE_PRESSURE:
+        d->spd.spd_press = v[0];
+        d->spd.spd_press_is_valid = 1;
+        break;
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        d->shd.shd_humid = v[0];
+        d->shd.shd_humid_is_valid = 1;
+        break;
+    default:
+        break;
+    }
+}
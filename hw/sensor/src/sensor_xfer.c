@@ -0,0 +1,289 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include <assert.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(SENSOR_XFER)
+
+#include "hal/hal_gpio.h"
+#include "hal/hal_i2c.h"
+#include "hal/hal_spi.h"
+#include "sensor/sensor.h"
+#include "sensor_priv.h"
+
+#define SENSOR_XFER_BUSES       MYNEWT_VAL(SENSOR_XFER_BUSES)
+#define SENSOR_XFER_MAX_LEN     MYNEWT_VAL(SENSOR_XFER_MAX_LEN)
+
+/*
+ * One worker per bus.  Transfers queued on a bus are run in order by that
+ * bus's task, so a slow transfer only holds up sensors on the same bus.
+ */
+struct sensor_xfer_bus {
+    uint8_t sxb_type;
+    uint8_t sxb_num;
+    uint8_t sxb_used;
+    struct os_eventq sxb_evq;
+    struct os_task sxb_task;
+    struct os_sem sxb_done;
+    uint8_t sxb_tx[SENSOR_XFER_MAX_LEN + 1];
+    uint8_t sxb_rx[SENSOR_XFER_MAX_LEN + 1];
+};
+
+static struct sensor_xfer_bus sensor_xfer_buses[SENSOR_XFER_BUSES];
+static os_stack_t sensor_xfer_stacks[SENSOR_XFER_BUSES]
+    [OS_STACK_ALIGN(MYNEWT_VAL(SENSOR_XFER_STACK_SIZE))];
+static struct os_mutex sensor_xfer_mtx;
+
+static void
+sensor_xfer_task_handler(void *arg)
+{
+    struct sensor_xfer_bus *bus;
+
+    bus = arg;
+    while (1) {
+        os_eventq_run(&bus->sxb_evq);
+    }
+}
+
+/**
+ * Returns the worker for a bus, starting one the first time the bus is
+ * used.
+ */
+static struct sensor_xfer_bus *
+sensor_xfer_bus_get(uint8_t type, uint8_t num)
+{
+    struct sensor_xfer_bus *bus;
+    int rc;
+    int i;
+
+    os_mutex_pend(&sensor_xfer_mtx, OS_TIMEOUT_NEVER);
+
+    bus = NULL;
+    for (i = 0; i < SENSOR_XFER_BUSES; i++) {
+        if (!sensor_xfer_buses[i].sxb_used) {
+            if (bus == NULL) {
+                bus = &sensor_xfer_buses[i];
+            }
+            continue;
+        }
+        if (sensor_xfer_buses[i].sxb_type == type &&
+            sensor_xfer_buses[i].sxb_num == num) {
+            bus = &sensor_xfer_buses[i];
+            goto done;
+        }
+    }
+
+    if (bus == NULL) {
+        goto done;
+    }
+
+    bus->sxb_type = type;
+    bus->sxb_num = num;
+    os_eventq_init(&bus->sxb_evq);
+    os_sem_init(&bus->sxb_done, 0);
+    rc = os_task_init(&bus->sxb_task, "sensor_xfer", sensor_xfer_task_handler,
+                      bus, MYNEWT_VAL(SENSOR_XFER_TASK_PRIO) +
+                      (bus - sensor_xfer_buses), OS_WAIT_FOREVER,
+                      sensor_xfer_stacks[bus - sensor_xfer_buses],
+                      OS_STACK_ALIGN(MYNEWT_VAL(SENSOR_XFER_STACK_SIZE)));
+    if (rc != 0) {
+        bus = NULL;
+        goto done;
+    }
+    bus->sxb_used = 1;
+
+done:
+    os_mutex_release(&sensor_xfer_mtx);
+    return bus;
+}
+
+static void
+sensor_xfer_spi_cb(void *arg, int len)
+{
+    struct sensor_xfer_bus *bus;
+
+    bus = arg;
+    os_sem_release(&bus->sxb_done);
+}
+
+/**
+ * Runs a register read over SPI using the non-blocking (DMA where the MCU
+ * supports it) interface, sleeping until the transfer completes.
+ */
+static int
+sensor_xfer_spi(struct sensor_xfer_bus *bus, struct sensor_xfer *xfer)
+{
+    struct sensor_itf *itf;
+    os_time_t ticks;
+    int rc;
+
+    itf = xfer->sx_itf;
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(SENSOR_XFER_TMO), &ticks);
+    if (rc) {
+        return rc;
+    }
+
+    /* The callback can only be changed while the SPI is disabled. */
+    hal_spi_disable(itf->si_num);
+    rc = hal_spi_set_txrx_cb(itf->si_num, sensor_xfer_spi_cb, bus);
+    hal_spi_enable(itf->si_num);
+    if (rc) {
+        return rc;
+    }
+
+    memset(bus->sxb_tx, 0, xfer->sx_len + 1);
+    bus->sxb_tx[0] = xfer->sx_reg;
+
+    hal_gpio_write(itf->si_cs_pin, 0);
+
+    rc = hal_spi_txrx_noblock(itf->si_num, bus->sxb_tx, bus->sxb_rx,
+                              xfer->sx_len + 1);
+    if (rc == 0) {
+        rc = os_sem_pend(&bus->sxb_done, ticks);
+        if (rc != 0) {
+            hal_spi_abort(itf->si_num);
+            rc = SYS_ETIMEOUT;
+        }
+    }
+
+    hal_gpio_write(itf->si_cs_pin, 1);
+
+    if (rc == 0) {
+        memcpy(xfer->sx_buf, bus->sxb_rx + 1, xfer->sx_len);
+    }
+
+    return rc;
+}
+
+/**
+ * Runs a register read over I2C.  The I2C HAL has no non-blocking
+ * interface, so this blocks the bus worker, but nothing else.
+ */
+static int
+sensor_xfer_i2c(struct sensor_xfer *xfer)
+{
+    struct hal_i2c_master_data data_struct;
+    struct sensor_itf *itf;
+    os_time_t ticks;
+    int rc;
+
+    itf = xfer->sx_itf;
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(SENSOR_XFER_TMO), &ticks);
+    if (rc) {
+        return rc;
+    }
+
+    data_struct.address = itf->si_addr;
+    data_struct.len = 1;
+    data_struct.buffer = &xfer->sx_reg;
+
+    rc = hal_i2c_master_write(itf->si_num, &data_struct, ticks, 1);
+    if (rc) {
+        return rc;
+    }
+
+    data_struct.len = xfer->sx_len;
+    data_struct.buffer = xfer->sx_buf;
+
+    return hal_i2c_master_read(itf->si_num, &data_struct, ticks, 1);
+}
+
+static void
+sensor_xfer_done_ev(struct os_event *ev)
+{
+    struct sensor_xfer *xfer;
+
+    xfer = ev->ev_arg;
+    xfer->sx_cb(xfer, xfer->sx_arg);
+}
+
+static void
+sensor_xfer_run_ev(struct os_event *ev)
+{
+    struct sensor_xfer_bus *bus;
+    struct sensor_xfer *xfer;
+    int rc;
+
+    xfer = ev->ev_arg;
+    bus = xfer->sx_bus;
+
+    rc = sensor_itf_lock(xfer->sx_itf, MYNEWT_VAL(SENSOR_XFER_TMO));
+    if (rc == 0) {
+        if (bus->sxb_type == SENSOR_ITF_SPI) {
+            rc = sensor_xfer_spi(bus, xfer);
+        } else {
+            rc = sensor_xfer_i2c(xfer);
+        }
+        sensor_itf_unlock(xfer->sx_itf);
+    }
+
+    xfer->sx_rc = rc;
+    xfer->sx_ev.ev_cb = sensor_xfer_done_ev;
+    os_eventq_put(xfer->sx_evq, &xfer->sx_ev);
+}
+
+int
+sensor_itf_read_async(struct sensor_itf *itf, struct sensor_xfer *xfer,
+                      struct os_eventq *evq, sensor_xfer_cb_t cb, void *arg)
+{
+    struct sensor_xfer_bus *bus;
+
+    if (xfer->sx_len == 0 || xfer->sx_len > SENSOR_XFER_MAX_LEN ||
+        cb == NULL) {
+        return SYS_EINVAL;
+    }
+    if (itf->si_type != SENSOR_ITF_SPI && itf->si_type != SENSOR_ITF_I2C) {
+        return SYS_ENOTSUP;
+    }
+
+    bus = sensor_xfer_bus_get(itf->si_type, itf->si_num);
+    if (bus == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    if (evq == NULL) {
+        evq = sensor_mgr_evq_get();
+    }
+
+    xfer->sx_itf = itf;
+    xfer->sx_bus = bus;
+    xfer->sx_evq = evq;
+    xfer->sx_cb = cb;
+    xfer->sx_arg = arg;
+    xfer->sx_rc = 0;
+    xfer->sx_ev = (struct os_event) {
+        .ev_cb = sensor_xfer_run_ev,
+        .ev_arg = xfer,
+    };
+
+    os_eventq_put(&bus->sxb_evq, &xfer->sx_ev);
+
+    return 0;
+}
+
+void
+sensor_xfer_init(void)
+{
+    os_mutex_init(&sensor_xfer_mtx);
+}
+
+#endif
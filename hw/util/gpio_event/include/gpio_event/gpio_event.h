@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_GPIO_EVENT_
+#define H_GPIO_EVENT_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include "hal/hal_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * GPIO event service.
+ *
+ * Wraps hal_gpio_irq_init() so that the interrupt handler does the same
+ * small amount of work for every pin: it stamps the edge with
+ * os_cputime_get32(), samples the pin level and stores both in the
+ * listener's queue.  The queue has a single producer (the pin's ISR) and a
+ * single consumer (the dispatch event), so it needs no locking.  One
+ * os_event per listener is posted to the gpio_event eventq; edges that
+ * arrive before it runs are delivered in the same batch.
+ */
+
+/** A single edge. */
+struct gpio_event {
+    /** os_cputime when the interrupt handler ran */
+    uint32_t ge_time;
+    /** Pin level read in the interrupt handler */
+    uint8_t ge_level;
+};
+
+struct gpio_event_listener;
+
+/**
+ * Called from the gpio_event eventq for each queued edge, oldest first.
+ */
+typedef void (*gpio_event_cb)(struct gpio_event_listener *gel,
+                              const struct gpio_event *ev);
+
+/*
+ * All struct fields should be considered private; the counters may be
+ * read for diagnostics.
+ */
+struct gpio_event_listener {
+    int gel_pin;
+    gpio_event_cb gel_cb;
+    void *gel_arg;
+    volatile uint16_t gel_head;
+    volatile uint16_t gel_tail;
+    /** Number of edges queued */
+    uint32_t gel_events;
+    /** Number of edges dropped because the queue was full */
+    uint32_t gel_drops;
+    struct os_event gel_ev;
+    struct gpio_event gel_queue[MYNEWT_VAL(GPIO_EVENT_QUEUE_LEN)];
+};
+
+/**
+ * Sets up an interrupt on the given pin, delivering edges to cb.  The
+ * interrupt is left disabled; call gpio_event_enable() to start.
+ *
+ * @param gel       Listener, must remain valid until released.
+ * @param pin       Pin number.
+ * @param trig      Trigger mode, see hal_gpio.h
+ * @param pull      Pull type, see hal_gpio.h
+ * @param cb        Callback run from the eventq for each edge.
+ * @param arg       Argument available via gpio_event_arg().
+ *
+ * @return 0 on success, SYS_EINVAL if the pin interrupt can't be set up.
+ */
+int gpio_event_listener_init(struct gpio_event_listener *gel, int pin,
+                             hal_gpio_irq_trig_t trig, hal_gpio_pull_t pull,
+                             gpio_event_cb cb, void *arg);
+
+/**
+ * Releases the pin interrupt and drops any queued edges.
+ */
+void gpio_event_listener_release(struct gpio_event_listener *gel);
+
+/**
+ * Enables the pin interrupt of the listener.
+ */
+void gpio_event_enable(struct gpio_event_listener *gel);
+
+/**
+ * Disables the pin interrupt of the listener.  Edges already queued are
+ * still delivered.
+ */
+void gpio_event_disable(struct gpio_event_listener *gel);
+
+/**
+ * Sets the eventq used to dispatch edges.
+ *
+ * @note If not called, the default OS eventq will be used: os_eventq_dflt_get()
+ *
+ * @param evq       The eventq to use.
+ */
+void gpio_event_evq_set(struct os_eventq *evq);
+
+static inline int
+gpio_event_pin(const struct gpio_event_listener *gel)
+{
+    return gel->gel_pin;
+}
+
+static inline void *
+gpio_event_arg(const struct gpio_event_listener *gel)
+{
+    return gel->gel_arg;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_gpio.h"
+#include "gpio_event/gpio_event.h"
+
+#define GPIO_EVENT_QUEUE_LEN    MYNEWT_VAL(GPIO_EVENT_QUEUE_LEN)
+
+#if (GPIO_EVENT_QUEUE_LEN & (GPIO_EVENT_QUEUE_LEN - 1)) != 0
+#error "GPIO_EVENT_QUEUE_LEN must be a power of two"
+#endif
+
+static struct os_eventq *gpio_event_evq;
+
+static void
+gpio_event_isr(void *arg)
+{
+    struct gpio_event_listener *gel;
+    struct gpio_event *ev;
+    uint32_t now;
+    uint16_t head;
+
+    now = os_cputime_get32();
+    gel = arg;
+
+    head = gel->gel_head;
+    if ((uint16_t)(head - gel->gel_tail) == GPIO_EVENT_QUEUE_LEN) {
+        gel->gel_drops++;
+    } else {
+        ev = &gel->gel_queue[head & (GPIO_EVENT_QUEUE_LEN - 1)];
+        ev->ge_time = now;
+        ev->ge_level = hal_gpio_read(gel->gel_pin);
+        /* Publish the slot only once it has been filled in */
+        gel->gel_head = head + 1;
+        gel->gel_events++;
+    }
+
+    /* No-op if the previous batch hasn't been dispatched yet */
+    os_eventq_put(gpio_event_evq, &gel->gel_ev);
+}
+
+static void
+gpio_event_dispatch(struct os_event *ev)
+{
+    struct gpio_event_listener *gel;
+    uint16_t tail;
+
+    gel = ev->ev_arg;
+
+    tail = gel->gel_tail;
+    while (tail != gel->gel_head) {
+        gel->gel_cb(gel, &gel->gel_queue[tail & (GPIO_EVENT_QUEUE_LEN - 1)]);
+        gel->gel_tail = ++tail;
+    }
+}
+
+int
+gpio_event_listener_init(struct gpio_event_listener *gel, int pin,
+                         hal_gpio_irq_trig_t trig, hal_gpio_pull_t pull,
+                         gpio_event_cb cb, void *arg)
+{
+    assert(cb);
+
+    if (gpio_event_evq == NULL) {
+        gpio_event_evq = os_eventq_dflt_get();
+    }
+
+    memset(gel, 0, sizeof(*gel));
+    gel->gel_pin = pin;
+    gel->gel_cb = cb;
+    gel->gel_arg = arg;
+    gel->gel_ev.ev_cb = gpio_event_dispatch;
+    gel->gel_ev.ev_arg = gel;
+
+    if (hal_gpio_irq_init(pin, gpio_event_isr, gel, trig, pull)) {
+        return SYS_EINVAL;
+    }
+    hal_gpio_irq_disable(pin);
+
+    return 0;
+}
+
+void
+gpio_event_listener_release(struct gpio_event_listener *gel)
+{
+    hal_gpio_irq_release(gel->gel_pin);
+    os_eventq_remove(gpio_event_evq, &gel->gel_ev);
+    gel->gel_tail = gel->gel_head;
+}
+
+void
+gpio_event_enable(struct gpio_event_listener *gel)
+{
+    hal_gpio_irq_enable(gel->gel_pin);
+}
+
+void
+gpio_event_disable(struct gpio_event_listener *gel)
+{
+    hal_gpio_irq_disable(gel->gel_pin);
+}
+
+void
+gpio_event_evq_set(struct os_eventq *evq)
+{
+    gpio_event_evq = evq;
+}
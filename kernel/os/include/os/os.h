@@ -116,15 +116,18 @@ void os_start(void);
 #include "os/os_eventq.h"
 #include "os/os_fault.h"
 #include "os/os_heap.h"
+#include "os/os_lock_prof.h"
 #include "os/os_mbuf.h"
 #include "os/os_mempool.h"
 #include "os/os_mutex.h"
+#include "os/os_pm.h"
 #include "os/os_sanity.h"
 #include "os/os_sched.h"
 #include "os/os_sem.h"
 #include "os/os_task.h"
 #include "os/os_time.h"
 #include "os/os_trace_api.h"
+#include "os/os_work.h"
 #include "os/queue.h"
 #include "os/util.h"
 
@@ -32,6 +32,7 @@ extern "C" {
 #endif
 
 #include "os/os_eventq.h"
+#include "syscfg/syscfg.h"
 #include <stddef.h>
 
 /**
@@ -45,16 +46,31 @@ struct os_callout {
     struct os_eventq *c_evq;
     /** Number of ticks in the future to expire the callout */
     os_time_t c_ticks;
+#if MYNEWT_VAL(OS_CALLOUT_LAZY)
+    /**
+     * Deadline the callout is filed under.  os_callout_reset_lazy() may
+     * move c_ticks past it; the callout is then re-filed when this
+     * deadline is reached.
+     */
+    os_time_t c_armed;
+#endif
 
-
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    LIST_ENTRY(os_callout) c_next;
+#else
     TAILQ_ENTRY(os_callout) c_next;
+#endif
 };
 
 /**
  * @cond INTERNAL_HIDDEN
  */
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+LIST_HEAD(os_callout_list, os_callout);
+#else
 TAILQ_HEAD(os_callout_list, os_callout);
+#endif
 
 /**
  * @endcond
@@ -99,6 +115,31 @@ void os_callout_stop(struct os_callout *);
  */
 int os_callout_reset(struct os_callout *, os_time_t);
 
+#if MYNEWT_VAL(OS_CALLOUT_LAZY)
+/**
+ * Reset the callout to fire off in 'ticks' ticks, without relinking it if
+ * that only pushes a pending deadline back.
+ *
+ * Meant for inactivity timers that are reset far more often than they
+ * expire.  If the callout is pending and the new deadline is not earlier
+ * than the one it is filed under, only c_ticks is updated; when the old
+ * deadline comes, the callout is re-filed under the new one instead of
+ * posting its event.  Otherwise this is the same as os_callout_reset().
+ *
+ * @param c The callout to reset
+ * @param ticks The number of ticks to wait before posting an event
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int os_callout_reset_lazy(struct os_callout *, os_time_t);
+#else
+static inline int
+os_callout_reset_lazy(struct os_callout *c, os_time_t ticks)
+{
+    return os_callout_reset(c, ticks);
+}
+#endif
+
 /**
  * Returns the number of ticks which remains to callout.
  *
@@ -119,7 +160,11 @@ os_time_t os_callout_remaining_ticks(struct os_callout *, os_time_t);
 static inline int
 os_callout_queued(struct os_callout *c)
 {
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    return c->c_next.le_prev != NULL;
+#else
     return c->c_next.tqe_prev != NULL;
+#endif
 }
 
 /**
@@ -75,10 +75,22 @@ extern "C" {
 #endif
 
 #if defined(OS_CPUTIME_FREQ_HIGH)
+/* Conversion by num / den, as a 32.32 fixed-point multiplier. */
+struct os_cputime_ratio
+{
+    uint64_t mult;              /* floor(num * 2^32 / den) */
+    uint32_t num;
+    uint32_t den;
+};
+
 /* CPUTIME data. */
 struct os_cputime_data
 {
-    uint32_t ticks_per_usec;    /* number of ticks per usec */
+    uint32_t ticks_per_usec;    /* number of ticks per usec, truncated */
+    struct os_cputime_ratio usecs_to_ticks;
+    struct os_cputime_ratio ticks_to_usecs;
+    struct os_cputime_ratio nsecs_to_ticks;
+    struct os_cputime_ratio ticks_to_nsecs;
 };
 extern struct os_cputime_data g_os_cputime;
 #endif
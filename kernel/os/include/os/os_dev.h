@@ -71,6 +71,8 @@ struct os_dev;
  * initialized.  Fail device init if it does not.
  */
 #define OS_DEV_F_INIT_CRITICAL    (1 << 3)
+/** Suspend or resume started but not complete; private. */
+#define OS_DEV_F_PENDING          (1 << 4)
 
 /**
  * Initialize a device.
@@ -102,11 +104,15 @@ struct os_dev_handlers {
      * Suspend handler, called when the device is being suspended.
      * Up to the implementer to save device state before power down,
      * so that the device can be cleanly resumed -- or error out and
-     * delay suspension.
+     * delay suspension.  May return OS_EBUSY once suspending has started
+     * but has not completed (e.g. a transfer is draining); it is then
+     * called again until it returns something else, meanwhile other
+     * devices are suspended.
      */
     os_dev_suspend_func_t od_suspend;
     /**
      * Resume handler, restores device state after a suspend operation.
+     * May return OS_EBUSY like the suspend handler.
      */
     os_dev_resume_func_t od_resume;
     /**
@@ -139,9 +145,27 @@ struct os_dev {
     uint8_t od_flags;
     /** Device name */
     char *od_name;
-    STAILQ_ENTRY(os_dev) od_next;
+    TAILQ_ENTRY(os_dev) od_next;
+#if MYNEWT_VAL(OS_DEV_HASH_BUCKETS) > 0
+    /** Hash of od_name, and the next device in its hash bucket. */
+    uint32_t od_name_hash;
+    SLIST_ENTRY(os_dev) od_hnext;
+#endif
+};
+
+/**
+ * A device reference resolved by name once and then kept, so that hot paths
+ * don't look the device up on every use.  Initialize with
+ * OS_DEV_HANDLE_INIT() or os_dev_handle_init().  Fields are private.
+ */
+struct os_dev_handle {
+    const char *odh_name;
+    struct os_dev *odh_dev;
+    uint32_t odh_gen;
 };
 
+#define OS_DEV_HANDLE_INIT(__name) { .odh_name = (__name) }
+
 #define OS_DEV_SETHANDLERS(__dev, __open, __close)          \
     (__dev)->od_handlers.od_open = (__open);                \
     (__dev)->od_handlers.od_close = (__close);
@@ -197,6 +221,38 @@ int os_dev_create(struct os_dev *dev, char *name, uint8_t stage,
  */
 struct os_dev *os_dev_lookup(char *name);
 
+/**
+ * Initialize a device handle.
+ *
+ * @param h The handle to initialize.
+ * @param name The name of the device; must stay valid while the handle is
+ *             in use.
+ */
+void os_dev_handle_init(struct os_dev_handle *h, const char *name);
+
+/**
+ * Resolve a device handle.  The device is looked up the first time only;
+ * later calls return the cached pointer until the device list is reset.
+ *
+ * @param h The handle to resolve.
+ *
+ * @return The device, or NULL if no device of that name exists (yet).
+ */
+struct os_dev *os_dev_handle_lookup(struct os_dev_handle *h);
+
+/**
+ * Open the device a handle refers to.  Same as os_dev_open(), without the
+ * name lookup once the handle has been resolved.
+ *
+ * @param h The handle of the device to open.
+ * @param timo The timeout to open the device, if not specified.
+ * @param arg The argument to the device open() call.
+ *
+ * @return The device on success, NULL on failure.
+ */
+struct os_dev *os_dev_handle_open(struct os_dev_handle *h, uint32_t timo,
+                                  void *arg);
+
 /**
  * Initialize all devices for a given state.
  *
@@ -208,7 +264,11 @@ int os_dev_initialize_all(uint8_t);
 
 
 /**
- * Suspend all devices.
+ * Suspend all devices, in the reverse of their initialization order so that
+ * a device is suspended before the ones it was initialized after (and may
+ * depend on).  Devices of the same stage and priority are independent:
+ * while one of them is still busy suspending (see od_suspend), the others
+ * are suspended too.
  *
  * @param suspend_t The number of ticks to suspend this device for
  * @param force Whether or not to force suspending the device
@@ -219,9 +279,11 @@ int os_dev_initialize_all(uint8_t);
 int os_dev_suspend_all(os_time_t, uint8_t);
 
 /**
- * Resume all the devices that were suspended.
+ * Resume all the devices that were suspended, in initialization order.
+ * Devices of the same stage and priority are resumed together, as in
+ * os_dev_suspend_all().
  *
- * @return 0 on success, -1 if any of the devices have failed to resume.
+ * @return 0 on success, or the first error a device returned.
  */
 int os_dev_resume_all(void);
 
@@ -29,6 +29,7 @@
 #define _OS_EVENTQ_H
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "os/os_time.h"
 #include "os/queue.h"
 
@@ -46,6 +47,10 @@ typedef void os_event_fn(struct os_event *ev);
 struct os_event {
     /** Whether this OS event is queued on an event queue. */
     uint8_t ev_queued;
+#if MYNEWT_VAL(OS_EVENTQ_LANES) > 1
+    /** Lane of the event queue this event is queued on. */
+    uint8_t ev_lane;
+#endif
     /**
      * Callback to call when the event is taken off of an event queue.
      * APIs, except for os_eventq_run(), assume this callback will be called by
@@ -71,8 +76,21 @@ struct os_eventq {
      */
     struct os_task *evq_task;
 
+#if MYNEWT_VAL(OS_EVENTQ_BATCH_STATS)
+    /** Number of os_eventq_run_batch() wakeups */
+    uint32_t evq_batch_cnt;
+    /** Total number of events dispatched by os_eventq_run_batch() */
+    uint32_t evq_batch_ev_cnt;
+    /** Largest number of events dispatched in a single wakeup */
+    uint16_t evq_batch_max;
+#endif
 
+#if MYNEWT_VAL(OS_EVENTQ_LANES) > 1
+    /** One list per lane; lane 0 is served first. */
+    STAILQ_HEAD(, os_event) evq_list[MYNEWT_VAL(OS_EVENTQ_LANES)];
+#else
     STAILQ_HEAD(, os_event) evq_list;
+#endif
 };
 
 
@@ -98,6 +116,19 @@ int os_eventq_inited(const struct os_eventq *evq);
  */
 void os_eventq_put(struct os_eventq *, struct os_event *);
 
+/**
+ * Put an event on the given lane of the event queue.  Events on lower
+ * numbered lanes are always pulled off the queue before events on higher
+ * numbered lanes; os_eventq_put() uses the last lane,
+ * OS_EVENTQ_LANES - 1.  Events within a lane are pulled in FIFO order.
+ *
+ * @param evq The event queue to put an event on
+ * @param ev The event to put on the queue
+ * @param lane The lane to put the event on, 0 to OS_EVENTQ_LANES - 1
+ */
+void os_eventq_put_lane(struct os_eventq *evq, struct os_event *ev,
+                        int lane);
+
 /**
  * Poll an event from the event queue and return it immediately.
  * If no event is available, don't block, just return NULL.
@@ -124,12 +155,29 @@ struct os_event *os_eventq_get(struct os_eventq *);
  */
 void os_eventq_run(struct os_eventq *evq);
 
+/**
+ * Pull up to 'max' items off the event queue in a single critical section
+ * and call their event callbacks.  Blocks until at least one item is
+ * available.
+ *
+ * An event which is removed from the queue by a callback earlier in the
+ * same batch is not dispatched.  Putting an event which is waiting to be
+ * dispatched in the current batch has no effect.
+ *
+ * @param evq The event queue to pull the items off.
+ * @param max The maximum number of items to dispatch; capped at
+ *            OS_EVENTQ_BATCH_MAX.
+ *
+ * @return The number of event callbacks called.
+ */
+int os_eventq_run_batch(struct os_eventq *evq, int max);
+
 
 /**
  * Poll the list of event queues specified by the evq parameter
  * (size nevqs), and return the "first" event available on any of
  * the queues.  Event queues are searched in the order that they
- * are passed in the array.
+ * are passed in the array, one lane at a time, starting with lane 0.
  *
  * @param evq Array of event queues
  * @param nevqs Number of event queues in evq
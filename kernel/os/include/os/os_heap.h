@@ -30,6 +30,8 @@
 #define H_OS_HEAP_
 
 #include <stddef.h>
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +72,49 @@ void os_free(void *mem);
  */
 void *os_realloc(void *ptr, size_t size);
 
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+
+/**
+ * Heap usage snapshot, see os_heap_stats_get().  All sizes are in bytes and
+ * include the per block header.
+ */
+struct os_heap_stats {
+    /** Memory under control of the heap */
+    uint32_t ohs_total;
+    /** Memory in allocated blocks */
+    uint32_t ohs_used;
+    /** Highest value ohs_used has reached */
+    uint32_t ohs_used_max;
+    /** Memory in free blocks */
+    uint32_t ohs_free;
+    /** Largest single allocation that can currently succeed */
+    uint32_t ohs_free_block_max;
+    /** Number of allocation requests that could not be satisfied */
+    uint32_t ohs_alloc_fail;
+};
+
+/**
+ * Hands a region of memory over to the heap.  Can be used to place the heap,
+ * or part of it, in a specific RAM bank.  The region must not be used for
+ * anything else afterwards; it is never returned.
+ *
+ * @param mem The start of the region
+ * @param len The size of the region, in bytes
+ *
+ * @return 0 on success, OS_EINVAL if the region is too small to hold a block
+ */
+int os_heap_add_region(void *mem, size_t len);
+
+/**
+ * Reads the heap usage statistics.  The ratio of ohs_free_block_max to
+ * ohs_free tells how fragmented the free memory is.
+ *
+ * @param ohs Filled in with the current statistics
+ */
+void os_heap_stats_get(struct os_heap_stats *ohs);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSLockProf Lock contention profiling
+ *   @{
+ */
+
+#ifndef _OS_LOCK_PROF_H_
+#define _OS_LOCK_PROF_H_
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_mutex;
+struct os_sem;
+
+/**
+ * Contention record of one mutex or semaphore.  All times are in
+ * os_cputime ticks.
+ */
+struct os_lock_prof {
+    /** Name the lock was registered under */
+    const char *olp_name;
+    /** Number of times the lock was taken, nested mutex pends excluded */
+    uint32_t olp_acquired;
+    /** Number of pends that found the lock taken */
+    uint32_t olp_contended;
+    /** Number of contended pends that gave up without the lock */
+    uint32_t olp_timeouts;
+    /** Longest single wait */
+    uint32_t olp_wait_max;
+    /** Sum of all waits */
+    uint64_t olp_wait_total;
+    /** Longest a mutex was held in one go; always 0 for semaphores */
+    uint32_t olp_hold_max;
+    /** Name of the task that held the mutex for olp_hold_max */
+    const char *olp_hold_max_task;
+    /** Time the current owner got the mutex */
+    uint32_t olp_hold_start;
+    STAILQ_ENTRY(os_lock_prof) olp_next;
+};
+
+#if MYNEWT_VAL(OS_LOCK_PROF)
+
+/**
+ * Start profiling a mutex.  Must be called after os_mutex_init(), which
+ * detaches any record from the mutex.  A record that is already
+ * registered is only renamed and reattached.
+ *
+ * @param mu   The mutex to profile
+ * @param olp  The record to collect into; must stay valid for as long as
+ *             the mutex is used
+ * @param name The name the record is listed under
+ *
+ * @return 0 on success, OS_INVALID_PARM if any argument is NULL
+ */
+int os_mutex_prof_register(struct os_mutex *mu, struct os_lock_prof *olp,
+                           const char *name);
+
+/**
+ * Start profiling a semaphore.  Same rules as os_mutex_prof_register();
+ * semaphores have no owner, so no hold times are recorded.
+ *
+ * @param sem  The semaphore to profile
+ * @param olp  The record to collect into
+ * @param name The name the record is listed under
+ *
+ * @return 0 on success, OS_INVALID_PARM if any argument is NULL
+ */
+int os_sem_prof_register(struct os_sem *sem, struct os_lock_prof *olp,
+                         const char *name);
+
+/**
+ * Iterate over the registered lock records.
+ *
+ * @param prev The previously returned record, or NULL to get the first
+ *
+ * @return The next record, or NULL when there are no more
+ */
+struct os_lock_prof *os_lock_prof_next(struct os_lock_prof *prev);
+
+/**
+ * Clear the counters of every registered record.
+ */
+void os_lock_prof_reset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_LOCK_PROF_H_ */
+
+/**
+ *   @} OSLockProf
+ * @} OSKernel
+ */
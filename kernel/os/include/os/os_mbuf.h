@@ -54,9 +54,33 @@ struct os_mbuf_pool {
      */
     struct os_mempool *omp_pool;
 
+#if MYNEWT_VAL(OS_MSYS_STATS)
+    /** Number of msys requests this pool was the best fit for */
+    uint32_t omp_msys_req;
+    /** Best fit requests served by a larger pool as this one was empty */
+    uint32_t omp_msys_fallback;
+    /** Best fit requests that could not be served at all */
+    uint32_t omp_msys_fail;
+#endif
+
     STAILQ_ENTRY(os_mbuf_pool) omp_next;
 };
 
+/** Number of buckets in the msys request size histogram. */
+#define OS_MSYS_HIST_BUCKETS    (10)
+
+/**
+ * Msys request size histogram, see os_msys_stats_get().  Bucket 0 counts
+ * requests smaller than 16 bytes, bucket n requests of 8 << n up to
+ * (16 << n) - 1 bytes; the last bucket also takes all larger requests.
+ * Sizes include the packet header, if any.
+ */
+struct os_msys_stats {
+    uint32_t oms_hist[OS_MSYS_HIST_BUCKETS];
+    /** Largest size requested */
+    uint16_t oms_size_max;
+};
+
 
 /**
  * A packet header structure that preceeds the mbuf packet headers.
@@ -100,6 +124,19 @@ struct os_mbuf {
      */
     struct os_mbuf_pool *om_omp;
 
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    /**
+     * Number of holds on this mbuf's pool block: one for the mbuf itself
+     * while it is allocated, plus one for every mbuf whose data lives in it.
+     */
+    uint16_t om_refcnt;
+    /**
+     * The mbuf whose data buffer holds this mbuf's data, or NULL if the
+     * data is in this mbuf's own buffer.
+     */
+    struct os_mbuf *om_shared;
+#endif
+
     SLIST_ENTRY(os_mbuf) om_next;
 
     /**
@@ -108,6 +145,34 @@ struct os_mbuf {
     uint8_t om_databuf[0];
 };
 
+struct os_mbuf_ext;
+
+/**
+ * Called when the last mbuf referencing an external buffer is freed.
+ *
+ * @param ome                   The external buffer that is no longer in use.
+ */
+typedef void os_mbuf_ext_free_fn(struct os_mbuf_ext *ome);
+
+/**
+ * A caller-owned buffer that external data mbufs point into, instead of
+ * holding their data inside their own pool block.  The descriptor is shared
+ * by every mbuf referencing the buffer and must stay valid until its free
+ * callback has run.
+ */
+struct os_mbuf_ext {
+    /** Start of the external buffer */
+    uint8_t *ome_buf;
+    /** Size of the external buffer, in bytes */
+    uint16_t ome_len;
+    /** Number of mbufs referencing the buffer */
+    uint16_t ome_refcnt;
+    /** Called when the reference count drops to zero; may be NULL */
+    os_mbuf_ext_free_fn *ome_free_cb;
+    /** Argument for the free callback's use */
+    void *ome_arg;
+};
+
 /**
  * Structure representing a queue of mbufs.
  */
@@ -117,6 +182,24 @@ struct os_mqueue {
     struct os_event mq_ev;
 };
 
+/**
+ * Structure representing a single-producer, single-consumer ring of mbufs.
+ * Neither the producer nor the consumer takes a critical section, so the
+ * producer may run in interrupt context.
+ */
+struct os_mqueue_ring {
+    /** Ring storage; holds mqr_mask + 1 entries. */
+    struct os_mbuf **mqr_buf;
+    /** Number of entries in the ring minus one. */
+    uint16_t mqr_mask;
+    /** Free running index of the next entry to write; producer only. */
+    volatile uint16_t mqr_head;
+    /** Free running index of the next entry to read; consumer only. */
+    volatile uint16_t mqr_tail;
+    /** Event to post when the ring goes from empty to non-empty. */
+    struct os_event mqr_ev;
+};
+
 /*
  * Given a flag number, provide the mask for it
  *
@@ -124,6 +207,29 @@ struct os_mqueue {
  */
 #define OS_MBUF_F_MASK(__n) (1 << (__n))
 
+/** The mbuf's data lives in an external buffer, see os_mbuf_get_ext(). */
+#define OS_MBUF_F_EXT       OS_MBUF_F_MASK(0)
+
+/*
+ * Checks whether a given mbuf references external data
+ *
+ * @param __om The mbuf to check
+ */
+#define OS_MBUF_IS_EXT(__om) ((__om)->om_flags & OS_MBUF_F_EXT)
+
+/*
+ * Checks whether the data of a given mbuf may be in use by other mbufs, see
+ * os_mbuf_share().
+ *
+ * @param __om The mbuf to check
+ */
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+#define OS_MBUF_IS_SHARED(__om) \
+    ((__om)->om_shared != NULL || (__om)->om_refcnt > 1)
+#else
+#define OS_MBUF_IS_SHARED(__om) (0)
+#endif
+
 /*
  * Checks whether a given mbuf is a packet header mbuf
  *
@@ -184,6 +290,10 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    if (OS_MBUF_IS_EXT(om) || OS_MBUF_IS_SHARED(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -218,6 +328,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_EXT(om) || OS_MBUF_IS_SHARED(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -278,6 +392,58 @@ struct os_mbuf *os_mqueue_get(struct os_mqueue *);
  */
 int os_mqueue_put(struct os_mqueue *, struct os_eventq *, struct os_mbuf *);
 
+/**
+ * Initializes a ring mqueue.  A ring mqueue is a fixed size, lock-free
+ * alternative to an mqueue for a single producer (typically an interrupt
+ * handler) and a single consumer (typically a task's event callback).
+ *
+ * The event is only posted when the ring goes from empty to non-empty, so
+ * the callback must keep calling os_mqueue_ring_get() until it returns
+ * NULL.
+ *
+ * @param mqr                   The ring mqueue to initialize.
+ * @param buf                   Storage for the ring; 'cnt' mbuf pointers.
+ * @param cnt                   The number of entries in the ring.  Must be
+ *                                  a power of two, no greater than 32768.
+ * @param ev_cb                 The callback to associate with the ring
+ *                                  event.
+ * @param arg                   The argument to associate with the ring
+ *                                  event.
+ *
+ * @return                      0 on success, OS_EINVAL if cnt is not a
+ *                                  valid size.
+ */
+int os_mqueue_ring_init(struct os_mqueue_ring *mqr, struct os_mbuf **buf,
+                        uint16_t cnt, os_event_fn *ev_cb, void *arg);
+
+/**
+ * Adds an mbuf to a ring mqueue.  Must only be called by the ring's single
+ * producer.  Posts the ring event to the specified eventq if the ring was
+ * empty.
+ *
+ * @param mqr                   The ring mqueue to append the mbuf to.
+ * @param evq                   The event queue to post an event to, or
+ *                                  NULL to post nothing.
+ * @param m                     The mbuf to append.
+ *
+ * @return                      0 on success, OS_ENOMEM if the ring is full.
+ *                                  The caller keeps ownership of the mbuf
+ *                                  on failure.
+ */
+int os_mqueue_ring_put(struct os_mqueue_ring *mqr, struct os_eventq *evq,
+                       struct os_mbuf *m);
+
+/**
+ * Removes and returns a single mbuf from a ring mqueue.  Must only be
+ * called by the ring's single consumer.  Does not block.
+ *
+ * @param mqr                   The ring mqueue to pull an mbuf off of.
+ *
+ * @return                      The next mbuf in the ring, or NULL if the
+ *                                  ring is empty.
+ */
+struct os_mbuf *os_mqueue_ring_get(struct os_mqueue_ring *mqr);
+
 /**
  * MSYS is a system level mbuf registry.  Allows the system to share
  * packet buffers amongst the various networking stacks that can be running
@@ -298,7 +464,8 @@ int os_msys_register(struct os_mbuf_pool *);
 
 /**
  * Allocate a mbuf from msys.  Based upon the data size requested,
- * os_msys_get() will choose the mbuf pool that has the best fit.
+ * os_msys_get() will choose the mbuf pool that has the best fit.  With
+ * OS_MSYS_FALLBACK enabled, larger pools are tried if that pool is empty.
  *
  * @param dsize The estimated size of the data being stored in the mbuf
  * @param leadingspace The amount of leadingspace to allocate in the mbuf
@@ -337,6 +504,31 @@ int os_msys_count(void);
  */
 int os_msys_num_free(void);
 
+/**
+ * Iterates the pools registered with msys, in order of increasing buffer
+ * size.
+ *
+ * @param omp The previous pool, or NULL to get the first one
+ *
+ * @return The next pool, or NULL if there are no more
+ */
+struct os_mbuf_pool *os_msys_pool_next(struct os_mbuf_pool *omp);
+
+#if MYNEWT_VAL(OS_MSYS_STATS)
+/**
+ * Reads the msys request size histogram.  The per pool counters are kept in
+ * struct os_mbuf_pool.
+ *
+ * @param oms Filled in with the histogram
+ */
+void os_msys_stats_get(struct os_msys_stats *oms);
+
+/**
+ * Clears the request size histogram and all per pool counters.
+ */
+void os_msys_stats_reset(void);
+#endif
+
 /**
  * Initialize a pool of mbufs.
  *
@@ -373,8 +565,29 @@ struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
         uint8_t pkthdr_len);
 
+/**
+ * Get an mbuf that references a region of an external buffer instead of
+ * carrying the data itself.  The mbuf holds a reference on the buffer,
+ * which is dropped when the mbuf is freed; os_mbuf_dup() shares the buffer
+ * rather than copying it.  External data mbufs have no leading or trailing
+ * space, so data added with os_mbuf_append() or os_mbuf_prepend() goes into
+ * new mbufs.  Use os_mbuf_concat() to attach the mbuf to a packet.
+ *
+ * @param omp The mbuf pool to allocate the mbuf header out of
+ * @param ome The external buffer to reference
+ * @param off Offset of the referenced region within the buffer
+ * @param len Length of the referenced region
+ *
+ * @return An initialized mbuf on success, and NULL on failure.
+ */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp,
+                                struct os_mbuf_ext *ome, uint16_t off,
+                                uint16_t len);
+
 /**
  * Duplicate a chain of mbufs.  Return the start of the duplicated chain.
+ * With OS_MBUF_SHARED enabled this is os_mbuf_share() out of the chain's
+ * own pool.
  *
  * @param omp The mbuf pool to duplicate out of
  * @param om  The mbuf chain to duplicate
@@ -383,6 +596,24 @@ struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
  */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+/**
+ * Creates a chain of mbufs that refers to the data of another chain instead
+ * of copying it.  Only the mbuf headers are allocated, so a pool of small
+ * blocks that just fit a header and the packet header does for hdr_omp.
+ * The data stays allocated until both chains are freed.  As long as data is
+ * shared, neither chain has leading or trailing space, and
+ * os_mbuf_copyinto() copies a shared mbuf's data before writing to it.
+ *
+ * @param om      The mbuf chain to share
+ * @param hdr_omp The mbuf pool to allocate the new headers out of
+ *
+ * @return A pointer to the new chain of mbufs, NULL on failure
+ */
+struct os_mbuf *os_mbuf_share(struct os_mbuf *om,
+                              struct os_mbuf_pool *hdr_omp);
+#endif
+
 /**
  * Locates the specified absolute offset within an mbuf chain.  The offset
  * can be one past than the total length of the chain, but no greater.
@@ -400,6 +631,87 @@ struct os_mbuf *os_mbuf_off(const struct os_mbuf *om, int off,
                             uint16_t *out_off);
 
 
+/**
+ * Gives read access to a range of an mbuf chain without modifying the
+ * chain.  If the range lies within a single mbuf, a pointer into that
+ * mbuf's data is returned and nothing is copied.  Otherwise the range is
+ * copied into the caller's scratch buffer, which must hold len bytes.
+ * Use instead of os_mbuf_pullup() when the data only needs to be read.
+ *
+ * @param om                    The mbuf chain to read from.
+ * @param off                   The offset of the range within the chain.
+ * @param len                   The length of the range.
+ * @param scratch               Buffer for ranges spanning mbufs; may be
+ *                                  NULL, in which case such ranges fail.
+ *
+ * @return                      Pointer to the data on success;
+ *                              NULL if the range extends beyond the end of
+ *                                  the chain, or spans mbufs and scratch
+ *                                  is NULL.
+ */
+const void *os_mbuf_peek(const struct os_mbuf *om, int off, int len,
+                         void *scratch);
+
+/**
+ * A contiguous piece of an mbuf chain, as filled in by os_mbuf_iovec().
+ */
+struct os_iovec {
+    void *iov_base;
+    size_t iov_len;
+};
+
+/**
+ * Describes a range of an mbuf chain as an array of contiguous pieces, one
+ * per mbuf, for handing to scatter-gather DMA or hashing without copying.
+ * Empty mbufs are skipped.  The chain must not be modified while the
+ * vector is in use.
+ *
+ * @param om                    The mbuf chain to describe.
+ * @param off                   The offset of the range within the chain.
+ * @param len                   The length of the range.
+ * @param iov                   The array to fill in.
+ * @param iov_cnt               The number of entries in iov.
+ *
+ * @return                      The number of entries filled in on success;
+ *                              SYS_EINVAL if the range extends beyond the
+ *                                  end of the chain;
+ *                              SYS_ENOMEM if the range needs more than
+ *                                  iov_cnt entries.
+ */
+int os_mbuf_iovec(const struct os_mbuf *om, int off, int len,
+                  struct os_iovec *iov, int iov_cnt);
+
+/**
+ * Computes the ones-complement sum used by the Internet checksum (RFC
+ * 1071) over a buffer.  The sum is in the same byte order as the data, so
+ * its complement can be stored in a header as is.  Drop-in for lwIP's
+ * LWIP_CHKSUM.
+ *
+ * @param buf                   The data to sum; any alignment.
+ * @param len                   The number of bytes to sum.
+ *
+ * @return                      The 16-bit sum, not complemented.
+ */
+uint16_t os_cksum16(const void *buf, int len);
+
+/**
+ * Computes the ones-complement sum of a range of an mbuf chain, as
+ * os_cksum16() would over the same bytes if they were contiguous.  Each
+ * mbuf is summed in place; segments of odd length are accounted for.
+ *
+ * @param om                    The mbuf chain to sum.
+ * @param off                   The offset of the range within the chain.
+ * @param len                   The length of the range.
+ * @param out_sum               On success, the 16-bit sum, not
+ *                                  complemented.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if the range extends beyond the
+ *                                  end of the chain.
+ */
+int os_mbuf_cksum16(const struct os_mbuf *om, int off, int len,
+                    uint16_t *out_sum);
+
 /*
  * Copy data from an mbuf chain starting "off" bytes from the beginning,
  * continuing for "len" bytes, into the indicated buffer.
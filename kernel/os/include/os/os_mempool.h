@@ -64,6 +64,13 @@ struct os_mempool {
     uint16_t mp_min_free;
     /** Bitmap of OS_MEMPOOL_F_[...] values. */
     uint8_t mp_flags;
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+    /**
+     * Number of blocks at the end of the buffer which have never been
+     * handed out; they are not on the free list.
+     */
+    uint16_t mp_num_lazy;
+#endif
     /** Address of memory buffer used by pool */
     uint32_t mp_membuf_addr;
     STAILQ_ENTRY(os_mempool) mp_list;
@@ -168,6 +175,14 @@ typedef uint64_t os_membuf_t;
 #define OS_MEMPOOL_BYTES(n,blksize)     \
     (sizeof (os_membuf_t) * OS_MEMPOOL_SIZE((n), (blksize)))
 
+/**
+ * The block size os_mempool_init_aligned() uses for blocks of 'sz' bytes
+ * aligned to 'align': rounded up so that every block starts on an 'align'
+ * boundary.  Pass it to OS_MEMPOOL_SIZE() to size the memory buffer.
+ */
+#define OS_MEMPOOL_ALIGNED_BLOCK_SZ(sz, align)                          \
+    (OS_ALIGN(OS_MEMPOOL_BLOCK_SZ(sz), (align)) - OS_MEMPOOL_BLOCK_SZ(0))
+
 /**
  * Initialize a memory pool.
  *
@@ -182,6 +197,33 @@ typedef uint64_t os_membuf_t;
 os_error_t os_mempool_init(struct os_mempool *mp, uint16_t blocks,
                            uint32_t block_size, void *membuf, char *name);
 
+/**
+ * Initialize a memory pool whose blocks are aligned to more than
+ * OS_ALIGNMENT, e.g. to the data cache line size for DMA buffers.  The
+ * block size is rounded up with OS_MEMPOOL_ALIGNED_BLOCK_SZ(); the caller
+ * picks the memory region by where it places membuf.
+ *
+ * @param mp            Pointer to a pointer to a mempool
+ * @param blocks        The number of blocks in the pool
+ * @param block_size    The minimum size of a block, in bytes.
+ * @param membuf        Pointer to memory to contain blocks; must be aligned
+ *                      to 'align' and hold
+ *                      OS_MEMPOOL_SIZE(blocks,
+ *                      OS_MEMPOOL_ALIGNED_BLOCK_SZ(block_size, align))
+ *                      os_membuf_t elements.
+ * @param name          Name of the pool.
+ * @param align         Block alignment, in bytes; a power of two, at least
+ *                      OS_ALIGNMENT.
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     align is not a power of two of at least
+ *                          OS_ALIGNMENT.
+ *      OS_MEM_NOT_ALIGNED  membuf is not aligned to align.
+ */
+os_error_t os_mempool_init_aligned(struct os_mempool *mp, uint16_t blocks,
+                                   uint32_t block_size, void *membuf,
+                                   char *name, uint32_t align);
+
 /**
  * Initializes an extended memory pool.  Extended attributes (e.g., callbacks)
  * are not specified when this function is called; they are assigned manually
@@ -272,6 +314,63 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
  */
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 
+/**
+ * Size-class allocator.  Groups a set of mempools of different block sizes
+ * and serves each request from the smallest pool whose blocks fit it.
+ */
+struct os_mempool_multi {
+    /** Member pools, ordered by increasing block size */
+    struct os_mempool *mpm_pools[MYNEWT_VAL(OS_MEMPOOL_MULTI_MAX_POOLS)];
+    /** Number of member pools */
+    uint8_t mpm_num_pools;
+};
+
+/**
+ * Initializes an empty size-class allocator.
+ *
+ * @param mpm           The allocator to initialize.
+ */
+void os_mempool_multi_init(struct os_mempool_multi *mpm);
+
+/**
+ * Adds an initialized mempool to a size-class allocator.  The pool's blocks
+ * must not be handed out by other means while it is a member.
+ *
+ * @param mpm           The allocator to add the pool to.
+ * @param mp            The mempool to add.
+ *
+ * @return                      0 on success;
+ *                              OS_ENOMEM if the allocator already holds
+ *                                  OS_MEMPOOL_MULTI_MAX_POOLS pools.
+ */
+os_error_t os_mempool_multi_register(struct os_mempool_multi *mpm,
+                                     struct os_mempool *mp);
+
+/**
+ * Gets a block of at least the requested size.  The smallest fitting pool is
+ * tried first; if it is exhausted, the next larger pools are tried in turn.
+ *
+ * @param mpm           The allocator to allocate from.
+ * @param size          The number of bytes required.
+ *
+ * @return void* Pointer to block if available; NULL otherwise
+ */
+void *os_mempool_multi_get(struct os_mempool_multi *mpm, uint32_t size);
+
+/**
+ * Puts a block obtained with os_mempool_multi_get() back into the pool it
+ * came from.
+ *
+ * @param mpm           The allocator the block was allocated from.
+ * @param block_addr    Pointer to memory block.
+ *
+ * @return                      0 on success;
+ *                              OS_INVALID_PARM if the block does not belong
+ *                                  to any member pool.
+ */
+os_error_t os_mempool_multi_put(struct os_mempool_multi *mpm,
+                                void *block_addr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@
 
 #include "os/os.h"
 #include "os/queue.h"
+#include "os/os_lock_prof.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,10 @@ struct os_mutex {
     uint16_t    mu_level;
     /** Task that owns the mutex */
     struct os_task *mu_owner;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    /** Contention record, see os_mutex_prof_register() */
+    struct os_lock_prof *mu_prof;
+#endif
 };
 
 /*
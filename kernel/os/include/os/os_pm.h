@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSPm Power Management
+ *   @{
+ */
+
+#ifndef _OS_PM_H_
+#define _OS_PM_H_
+
+#include <inttypes.h>
+#include "os/os_time.h"
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_pm_state;
+
+/**
+ * Puts the MCU into a sleep state.  Called from the idle task with
+ * interrupts disabled.  Must arrange for a wakeup no later than 'ticks'
+ * OS ticks from now and keep OS time correct across the sleep; usually by
+ * preparing the state and then calling os_tick_idle(ticks).  Returns once
+ * the MCU is awake again.
+ */
+typedef void os_pm_enter_func_t(struct os_pm_state *ps, os_time_t ticks);
+
+/** Suspend all devices around this state, see os_dev_suspend_all(). */
+#define OS_PM_STATE_F_DEV_SUSPEND   (0x01U)
+
+/**
+ * A sleep state the idle task can choose from.  Filled in by the MCU or
+ * BSP and registered with os_pm_state_register().
+ */
+struct os_pm_state {
+    /** Name of this state */
+    const char *ops_name;
+    /** Enters the state */
+    os_pm_enter_func_t *ops_enter;
+    /** Time, in microseconds, it takes to enter the state */
+    uint32_t ops_entry_us;
+    /** Time, in microseconds, it takes to be running again after wakeup */
+    uint32_t ops_exit_us;
+    /** Shortest stay, in microseconds, that makes the state pay off */
+    uint32_t ops_min_residency_us;
+    /** OS_PM_STATE_F_[...] flags */
+    uint8_t ops_flags;
+
+    /*
+     * Filled in by the kernel.
+     */
+    /** Wakeup lead time, entry and exit latency in ticks */
+    os_time_t ops_exit_ticks;
+    /** Shortest idle period, in ticks, this state is chosen for */
+    os_time_t ops_min_ticks;
+    /** Number of times the state was entered */
+    uint32_t ops_enter_cnt;
+    /** Number of times the state was skipped because a device refused to
+     *  suspend */
+    uint32_t ops_dev_fail_cnt;
+    /** Total time spent in the state, in ticks */
+    uint64_t ops_residency_ticks;
+
+    SLIST_ENTRY(os_pm_state) ops_next;
+};
+
+/**
+ * Register a sleep state.  States are kept ordered by the idle time they
+ * need; the idle task uses the deepest one that fits before the next
+ * scheduled wakeup, and plain os_tick_idle() if none does.
+ *
+ * @param ps The state to register
+ *
+ * @return 0 on success, OS_INVALID_PARM if the state has no enter
+ *         function
+ */
+int os_pm_state_register(struct os_pm_state *ps);
+
+/**
+ * Iterate over the registered sleep states, shallowest first.
+ *
+ * @param prev The previously returned state, or NULL to get the first
+ *
+ * @return The next state, or NULL when there are no more
+ */
+struct os_pm_state *os_pm_state_next(struct os_pm_state *prev);
+
+/**
+ * Clear the residency statistics of all sleep states.
+ */
+void os_pm_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_PM_H_ */
+
+/**
+ *   @} OSPm
+ * @} OSKernel
+ */
@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 
+#include "syscfg/syscfg.h"
 #include "os/os_time.h"
 #include "os/queue.h"
 
@@ -49,6 +50,14 @@ struct os_sanity_check {
     os_sanity_check_func_t sc_func;
     /** Argument to pass to sanity check */
     void *sc_arg;
+    /** Time at which os_sanity_run() next looks at this check. */
+    os_time_t sc_next_run;
+#if MYNEWT_VAL(SANITY_RUNTIME)
+    /** Duration of the last run of sc_func, in microseconds. */
+    uint32_t sc_run_last;
+    /** Longest run of sc_func, in microseconds. */
+    uint32_t sc_run_max;
+#endif
 
     SLIST_ENTRY(os_sanity_check) sc_next;
 
@@ -103,6 +112,18 @@ int os_sanity_check_register(struct os_sanity_check *);
  */
 int os_sanity_check_reset(struct os_sanity_check *);
 
+#if MYNEWT_VAL(SANITY_RUNTIME)
+/**
+ * Find the sanity checks whose callbacks took longest to run.
+ *
+ * @param scs Array to fill with the checks, slowest first
+ * @param cnt Number of entries in scs
+ *
+ * @return The number of entries filled in
+ */
+int os_sanity_check_slowest(struct os_sanity_check **scs, int cnt);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
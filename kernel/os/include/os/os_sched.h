@@ -27,6 +27,7 @@
 #ifndef _OS_SCHED_H
 #define _OS_SCHED_H
 
+#include "syscfg/syscfg.h"
 #include "os/os_task.h"
 
 #ifdef __cplusplus
@@ -40,8 +41,11 @@ struct os_task;
 TAILQ_HEAD(os_task_list, os_task);
 
 extern struct os_task *g_current_task;
+#if !MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
 extern struct os_task_list g_os_run_list;
+#endif
 extern struct os_task_list g_os_sleep_list;
+extern struct os_task_list g_os_sleep_forever_list;
 
 void os_sched_ctx_sw_hook(struct os_task *);
 
@@ -57,6 +61,26 @@ struct os_task *os_sched_get_current_task(void);
 void os_sched_set_current_task(struct os_task *);
 struct os_task *os_sched_next_task(void);
 
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+/** @cond INTERNAL_HIDDEN */
+void os_sched_isr_enter(void);
+void os_sched_isr_exit(void);
+/** @endcond */
+
+/**
+ * Charges the time since the last context switch to the running task, so
+ * that the tasks' t_run_cputime values are up to date.
+ */
+void os_sched_cputime_update(void);
+
+/**
+ * Returns the total time spent in interrupt handlers, in os_cputime ticks.
+ * Only handlers that call os_trace_isr_enter() and os_trace_isr_exit() are
+ * counted.
+ */
+uint64_t os_sched_isr_cputime(void);
+#endif
+
 /**
  * Performs context switch if needed. If next_t is set, that task will be made
  * running. If next_t is NULL, highest priority ready to run is swapped in. This
@@ -93,6 +117,7 @@ void os_sched(struct os_task *);
 
 /** @cond INTERNAL_HIDDEN */
 void os_sched_os_timer_exp(void);
+void os_sched_run_list_init(void);
 os_error_t os_sched_insert(struct os_task *);
 int os_sched_sleep(struct os_task *, os_time_t nticks);
 int os_sched_wakeup(struct os_task *);
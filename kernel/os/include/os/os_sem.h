@@ -28,6 +28,7 @@
 #define _OS_SEM_H_
 
 #include "os/queue.h"
+#include "os/os_lock_prof.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +42,10 @@ struct os_sem {
     uint16_t    _pad;
     /** Number of tokens */
     uint16_t    sem_tokens;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    /** Contention record, see os_sem_prof_register() */
+    struct os_lock_prof *sem_prof;
+#endif
 };
 
 /*
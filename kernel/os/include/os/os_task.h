@@ -90,6 +90,12 @@ struct os_task {
     os_stack_t *t_stacktop;
     /** Size of this task's stack */
     uint16_t t_stacksize;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    /** Number of words at the stack bottom not yet seen touched */
+    uint16_t t_stack_untouched;
+    /** Next word the high-water mark scan checks */
+    uint16_t t_stack_scan;
+#endif
     /** Task ID */
     uint8_t t_taskid;
     /** Task Priority */
@@ -99,7 +105,8 @@ struct os_task {
     /** Task flags, bitmask */
     uint8_t t_flags;
     uint8_t t_lockcnt;
-    uint8_t t_pad;
+    /** Run queue the task is linked on (OS_SCHED_PRIO_BITMAP only) */
+    uint8_t t_sched_prio;
 
     /** Task name */
     const char *t_name;
@@ -118,6 +125,10 @@ struct os_task {
     os_time_t t_next_wakeup;
     /** Total task run time */
     os_time_t t_run_time;
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    /** Total task run time in os_cputime ticks, interrupts excluded */
+    uint64_t t_run_cputime;
+#endif
     /**
      * Total number of times this task has been context switched during
      * execution.
@@ -173,6 +184,23 @@ int os_task_remove(struct os_task *t);
  */
 uint8_t os_task_count(void);
 
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+/**
+ * Advance the incremental stack high-water mark scan of a task.
+ *
+ * The scan walks up from the bottom of the painted stack, a bounded number
+ * of words per call, and starts over once it reaches the lowest touched
+ * word seen so far.  os_sanity_run() calls this for every task.
+ *
+ * @param t     The task to sample
+ * @param words Number of words to check; 0 to finish a complete pass
+ *              from the stack bottom, e.g. from a fault handler
+ *
+ * @return The task's stack high-water mark, in os_stack_t words
+ */
+uint16_t os_task_stack_hwm_sample(struct os_task *t, int words);
+#endif
+
 /**
  * Information about an individual task, returned for management APIs.
  */
@@ -183,7 +211,11 @@ struct os_task_info {
     uint8_t oti_taskid;
     /** Task state, either READY or SLEEP */
     uint8_t oti_state;
-    /** Task stack usage */
+    /**
+     * Task stack usage.  With OS_TASK_STACK_HWM this is the sampled
+     * high-water mark, which may lag behind the real one by a few sanity
+     * intervals.
+     */
     uint16_t oti_stkusage;
     /** Task stack size */
     uint16_t oti_stksize;
@@ -191,6 +223,10 @@ struct os_task_info {
     uint32_t oti_cswcnt;
     /** Task runtime */
     uint32_t oti_runtime;
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    /** Task runtime in os_cputime ticks */
+    uint64_t oti_run_cputime;
+#endif
     /** Last time this task checked in with sanity */
     os_time_t oti_last_checkin;
     /** Next time this task is scheduled to check-in with sanity */
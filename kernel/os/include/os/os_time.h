@@ -62,6 +62,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "os/queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -183,6 +184,57 @@ struct os_timezone {
  */
 int os_settimeofday(struct os_timeval *utctime, struct os_timezone *tz);
 
+/**
+ * What os_settimeofday() changed.  Pointers are NULL for the parts that
+ * were not set.
+ */
+struct os_time_change_info {
+    /** UTC time before the change */
+    const struct os_timeval *tci_prev_utc;
+    /** Time zone before the change */
+    const struct os_timezone *tci_prev_tz;
+    /** UTC time after the change */
+    const struct os_timeval *tci_cur_utc;
+    /** Time zone after the change */
+    const struct os_timezone *tci_cur_tz;
+};
+
+/**
+ * Called after the time of day has been changed, in the context of the
+ * task that called os_settimeofday().
+ */
+typedef void os_time_change_fn(const struct os_time_change_info *info,
+                               void *arg);
+
+/**
+ * Registration of one os_time_change_fn.  All fields except tcl_fn and
+ * tcl_arg are private.
+ */
+struct os_time_change_listener {
+    os_time_change_fn *tcl_fn;
+    void *tcl_arg;
+    STAILQ_ENTRY(os_time_change_listener) tcl_next;
+};
+
+/**
+ * Registers a listener for time of day changes.  The listener must stay
+ * valid until removed.
+ *
+ * @param listener The listener to register
+ *
+ * @return 0 on success, OS_INVALID_PARM if already registered
+ */
+int os_time_change_listen(struct os_time_change_listener *listener);
+
+/**
+ * Unregisters a time change listener.
+ *
+ * @param listener The listener to unregister
+ *
+ * @return 0 on success, OS_INVALID_PARM if it was not registered
+ */
+int os_time_change_remove(const struct os_time_change_listener *listener);
+
 /**
  * Get the current time of day.  Returns the time of day in UTC
  * into the tv argument, and returns the timezone (if set) into
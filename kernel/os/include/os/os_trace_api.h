@@ -22,9 +22,15 @@
 
 #ifdef __ASSEMBLER__
 
+#if MYNEWT_VAL(SYSVIEW_FILTER)
+#define os_trace_isr_enter              sysview_filter_isr_enter
+#define os_trace_isr_exit               sysview_filter_isr_exit
+#define os_trace_task_start_exec        sysview_filter_task_start_exec
+#else
 #define os_trace_isr_enter              SEGGER_SYSVIEW_RecordEnterISR
 #define os_trace_isr_exit               SEGGER_SYSVIEW_RecordExitISR
 #define os_trace_task_start_exec        SEGGER_SYSVIEW_OnTaskStartExec
+#endif
 
 #else
 
@@ -33,6 +39,9 @@
 #include "syscfg/syscfg.h"
 #if MYNEWT_VAL(OS_SYSVIEW)
 #include "sysview/vendor/SEGGER_SYSVIEW.h"
+#if MYNEWT_VAL(SYSVIEW_FILTER)
+#include "sysview/sysview.h"
+#endif
 #endif
 #include "os/os.h"
 
@@ -62,6 +71,16 @@
 
 #if MYNEWT_VAL(OS_SYSVIEW)
 
+#if MYNEWT_VAL(SYSVIEW_FILTER)
+#define OS_TRACE_SYSVIEW_CAT(cat_)      sysview_filter_cat(SYSVIEW_CAT_ ## cat_)
+#define OS_TRACE_SYSVIEW_API(id_)       sysview_filter_api(id_)
+#define OS_TRACE_SYSVIEW_API_RET(id_)   sysview_filter_api_ret(id_)
+#else
+#define OS_TRACE_SYSVIEW_CAT(cat_)      (1)
+#define OS_TRACE_SYSVIEW_API(id_)       (1)
+#define OS_TRACE_SYSVIEW_API_RET(id_)   (1)
+#endif
+
 typedef struct SEGGER_SYSVIEW_MODULE_STRUCT os_trace_module_t;
 
 static inline uint32_t
@@ -91,13 +110,23 @@ os_trace_module_desc(const os_trace_module_t *m, const char *desc)
 static inline void
 os_trace_isr_enter(void)
 {
-    SEGGER_SYSVIEW_RecordEnterISR();
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    os_sched_isr_enter();
+#endif
+    if (OS_TRACE_SYSVIEW_CAT(ISR)) {
+        SEGGER_SYSVIEW_RecordEnterISR();
+    }
 }
 
 static inline void
 os_trace_isr_exit(void)
 {
-    SEGGER_SYSVIEW_RecordExitISR();
+    if (OS_TRACE_SYSVIEW_CAT(ISR)) {
+        SEGGER_SYSVIEW_RecordExitISR();
+    }
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    os_sched_isr_exit();
+#endif
 }
 
 static inline void
@@ -117,49 +146,65 @@ os_trace_task_info(const struct os_task *t)
 static inline void
 os_trace_task_create(const struct os_task *t)
 {
-    SEGGER_SYSVIEW_OnTaskCreate((uint32_t)t);
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnTaskCreate((uint32_t)t);
+    }
 }
 
 static inline void
 os_trace_task_start_exec(const struct os_task *t)
 {
-    SEGGER_SYSVIEW_OnTaskStartExec((uint32_t)t);
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnTaskStartExec((uint32_t)t);
+    }
 }
 
 static inline void
 os_trace_task_stop_exec(void)
 {
-    SEGGER_SYSVIEW_OnTaskStopExec();
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnTaskStopExec();
+    }
 }
 
 static inline void
 os_trace_task_start_ready(const struct os_task *t)
 {
-    SEGGER_SYSVIEW_OnTaskStartReady((uint32_t)t);
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnTaskStartReady((uint32_t)t);
+    }
 }
 
 static inline void
 os_trace_task_stop_ready(const struct os_task *t, unsigned reason)
 {
-    SEGGER_SYSVIEW_OnTaskStopReady((uint32_t)t, reason);
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnTaskStopReady((uint32_t)t, reason);
+    }
 }
 
 static inline void
 os_trace_idle(void)
 {
-    SEGGER_SYSVIEW_OnIdle();
+    if (OS_TRACE_SYSVIEW_CAT(SCHED)) {
+        SEGGER_SYSVIEW_OnIdle();
+    }
 }
 
 static inline void
 os_trace_user_start(unsigned id)
 {
-    SEGGER_SYSVIEW_OnUserStart(id);
+    if (OS_TRACE_SYSVIEW_CAT(USER)) {
+        SEGGER_SYSVIEW_OnUserStart(id);
+    }
 }
 
 static inline void
 os_trace_user_stop(unsigned id)
 {
-    SEGGER_SYSVIEW_OnUserStop(id);
+    if (OS_TRACE_SYSVIEW_CAT(USER)) {
+        SEGGER_SYSVIEW_OnUserStop(id);
+    }
 }
 
 #endif /* MYNEWT_VAL(OS_SYSVIEW) */
@@ -169,51 +214,158 @@ os_trace_user_stop(unsigned id)
 static inline void
 os_trace_api_void(unsigned id)
 {
-    SEGGER_SYSVIEW_RecordVoid(id);
+    if (OS_TRACE_SYSVIEW_API(id)) {
+        SEGGER_SYSVIEW_RecordVoid(id);
+    }
 }
 
 static inline void
 os_trace_api_u32(unsigned id, uint32_t p0)
 {
-    SEGGER_SYSVIEW_RecordU32(id, p0);
+    if (OS_TRACE_SYSVIEW_API(id)) {
+        SEGGER_SYSVIEW_RecordU32(id, p0);
+    }
 }
 
 static inline void
 os_trace_api_u32x2(unsigned id, uint32_t p0, uint32_t p1)
 {
-    SEGGER_SYSVIEW_RecordU32x2(id, p0, p1);
+    if (OS_TRACE_SYSVIEW_API(id)) {
+        SEGGER_SYSVIEW_RecordU32x2(id, p0, p1);
+    }
 }
 
 static inline void
 os_trace_api_u32x3(unsigned id, uint32_t p0, uint32_t p1, uint32_t p2)
 {
-    SEGGER_SYSVIEW_RecordU32x3(id, p0, p1, p2);
+    if (OS_TRACE_SYSVIEW_API(id)) {
+        SEGGER_SYSVIEW_RecordU32x3(id, p0, p1, p2);
+    }
 }
 
 static inline void
 os_trace_api_ret(unsigned id)
 {
-    SEGGER_SYSVIEW_RecordEndCall(id);
+    if (OS_TRACE_SYSVIEW_API_RET(id)) {
+        SEGGER_SYSVIEW_RecordEndCall(id);
+    }
 }
 
 static inline void
 os_trace_api_ret_u32(unsigned id, uint32_t ret)
 {
-    SEGGER_SYSVIEW_RecordEndCallU32(id, ret);
+    if (OS_TRACE_SYSVIEW_API_RET(id)) {
+        SEGGER_SYSVIEW_RecordEndCallU32(id, ret);
+    }
 }
 
 #endif /* MYNEWT_VAL(OS_SYSVIEW) && !defined(OS_TRACE_DISABLE_FILE_API) */
 
+#if MYNEWT_VAL(OS_TRACE_RING)
+
+/*
+ * Kernel event IDs recorded by the trace ring.  API IDs (40 and up) are
+ * shared with the SystemView modules above.
+ */
+#define OS_TRACE_ID_ISR_ENTER                   (1)
+#define OS_TRACE_ID_ISR_EXIT                    (2)
+#define OS_TRACE_ID_TASK_CREATE                 (3)
+#define OS_TRACE_ID_TASK_START_EXEC             (4)
+#define OS_TRACE_ID_TASK_STOP_EXEC              (5)
+#define OS_TRACE_ID_TASK_START_READY            (6)
+#define OS_TRACE_ID_TASK_STOP_READY             (7)
+#define OS_TRACE_ID_IDLE                        (8)
+#define OS_TRACE_ID_USER_START                  (9)
+#define OS_TRACE_ID_USER_STOP                   (10)
+
+/* Record marks the return of an API call; otr_arg0 is the return value. */
+#define OS_TRACE_REC_F_RET                      (0x01)
+/* Record was taken from interrupt context. */
+#define OS_TRACE_REC_F_ISR                      (0x02)
+
+/**
+ * One trace ring record.  The layout is fixed (16 bytes, target byte
+ * order) since records are exported as-is over newtmgr and in coredumps.
+ */
+struct os_trace_rec {
+    /** Value of os_cputime_get32() when the record was taken */
+    uint32_t otr_time;
+    /** OS_TRACE_ID_* */
+    uint8_t otr_id;
+    /** ID of the running task, 0xff before the OS is started */
+    uint8_t otr_taskid;
+    /** OS_TRACE_REC_F_* */
+    uint8_t otr_flags;
+    uint8_t _pad;
+    uint32_t otr_arg0;
+    uint32_t otr_arg1;
+};
+
+/**
+ * Appends a record to the trace ring, overwriting the oldest one if the
+ * ring is full.  Callable from interrupt context.
+ */
+void os_trace_ring_rec(uint8_t id, uint8_t flags, uint32_t arg0,
+                       uint32_t arg1);
+
+/**
+ * Returns the sequence number the next record will be stored with.
+ * Sequence numbers increase by one for every record and wrap at 2^32.
+ */
+uint32_t os_trace_ring_seq(void);
+
+/**
+ * Copies records out of the trace ring, oldest first.
+ *
+ * @param seq                   On entry, the sequence number of the first
+ *                                  record wanted.  If that record has been
+ *                                  overwritten, copying starts at the oldest
+ *                                  one still in the ring.  On exit, the
+ *                                  sequence number following the last
+ *                                  record copied.
+ * @param recs                  Where to copy the records.
+ * @param max                   Capacity of recs, in records.
+ *
+ * @return                      The number of records copied.
+ */
+int os_trace_ring_read(uint32_t *seq, struct os_trace_rec *recs, int max);
+
+/**
+ * Returns the ring storage itself, MYNEWT_VAL(OS_TRACE_RING_SIZE)
+ * records.  The record with sequence number n is at index
+ * n % OS_TRACE_RING_SIZE.  Meant for post-mortem dumps only.
+ *
+ * @param seq                   Filled with the next sequence number.
+ */
+const struct os_trace_rec *os_trace_ring_buf(uint32_t *seq);
+
+#endif /* MYNEWT_VAL(OS_TRACE_RING) */
+
 #if !MYNEWT_VAL(OS_SYSVIEW)
 
+#if MYNEWT_VAL(OS_TRACE_RING)
+#define OS_TRACE_RING_REC(id_, flags_, arg0_, arg1_)                    \
+    os_trace_ring_rec((id_), (flags_), (uint32_t)(arg0_), (uint32_t)(arg1_))
+#else
+#define OS_TRACE_RING_REC(id_, flags_, arg0_, arg1_)
+#endif
+
 static inline void
 os_trace_isr_enter(void)
 {
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    os_sched_isr_enter();
+#endif
+    OS_TRACE_RING_REC(OS_TRACE_ID_ISR_ENTER, 0, 0, 0);
 }
 
 static inline void
 os_trace_isr_exit(void)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_ISR_EXIT, 0, 0, 0);
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    os_sched_isr_exit();
+#endif
 }
 
 static inline void
@@ -224,75 +376,98 @@ os_trace_task_info(const struct os_task *t)
 static inline void
 os_trace_task_create(const struct os_task *t)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_TASK_CREATE, 0, t, t->t_taskid);
 }
 
 static inline void
 os_trace_task_start_exec(const struct os_task *t)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_TASK_START_EXEC, 0, t, t->t_taskid);
 }
 
 static inline void
 os_trace_task_stop_exec(void)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_TASK_STOP_EXEC, 0, 0, 0);
 }
 
 static inline void
 os_trace_task_start_ready(const struct os_task *t)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_TASK_START_READY, 0, t, t->t_taskid);
 }
 
 static inline void
 os_trace_task_stop_ready(const struct os_task *t, unsigned reason)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_TASK_STOP_READY, 0, t,
+                      (reason << 8) | t->t_taskid);
 }
 
 static inline void
 os_trace_idle(void)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_IDLE, 0, 0, 0);
 }
 
 static inline void
 os_trace_user_start(unsigned id)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_USER_START, 0, id, 0);
 }
 
 static inline void
 os_trace_user_stop(unsigned id)
 {
+    OS_TRACE_RING_REC(OS_TRACE_ID_USER_STOP, 0, id, 0);
 }
 
 #endif /* !MYNEWT_VAL(OS_SYSVIEW) */
 
 #if !MYNEWT_VAL(OS_SYSVIEW) || defined(OS_TRACE_DISABLE_FILE_API)
 
+#if !MYNEWT_VAL(OS_SYSVIEW) && !defined(OS_TRACE_DISABLE_FILE_API)
+#define OS_TRACE_RING_API(id_, flags_, arg0_, arg1_)                    \
+    OS_TRACE_RING_REC((id_), (flags_), (arg0_), (arg1_))
+#else
+#define OS_TRACE_RING_API(id_, flags_, arg0_, arg1_)
+#endif
+
 static inline void
 os_trace_api_void(unsigned id)
 {
+    OS_TRACE_RING_API(id, 0, 0, 0);
 }
 
 static inline void
 os_trace_api_u32(unsigned id, uint32_t p0)
 {
+    OS_TRACE_RING_API(id, 0, p0, 0);
 }
 
 static inline void
 os_trace_api_u32x2(unsigned id, uint32_t p0, uint32_t p1)
 {
+    OS_TRACE_RING_API(id, 0, p0, p1);
 }
 
 static inline void
 os_trace_api_u32x3(unsigned id, uint32_t p0, uint32_t p1, uint32_t p2)
 {
+    /* The ring keeps two arguments; the third one is dropped. */
+    OS_TRACE_RING_API(id, 0, p0, p1);
 }
 
 static inline void
 os_trace_api_ret(unsigned id)
 {
+    OS_TRACE_RING_API(id, OS_TRACE_REC_F_RET, 0, 0);
 }
 
 static inline void
 os_trace_api_ret_u32(unsigned id, uint32_t return_value)
 {
+    OS_TRACE_RING_API(id, OS_TRACE_REC_F_RET, return_value, 0);
 }
 
 #endif /* !MYNEWT_VAL(OS_SYSVIEW) || defined(OS_TRACE_DISABLE_FILE_API) */
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSWork Deferred Work
+ *   @{
+ */
+
+#ifndef _OS_WORK_H_
+#define _OS_WORK_H_
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/os_eventq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An item of deferred work, typically posted by an interrupt handler and
+ * run in the context of the kernel's work task.
+ */
+struct os_work {
+    /** Event handed to the work task; ev_cb is the work function */
+    struct os_event ow_ev;
+    /** Priority, 0 (most urgent) to OS_EVENTQ_LANES - 1 */
+    uint8_t ow_prio;
+#if MYNEWT_VAL(OS_WORK_STATS)
+    /** os_cputime when the work was last posted */
+    uint32_t ow_posted;
+#endif
+};
+
+/**
+ * Latency statistics of one work priority.  Latency is measured from
+ * os_work_post() to the start of the work function, in os_cputime ticks.
+ */
+struct os_work_stats {
+    /** Number of work items run */
+    uint32_t ows_runs;
+    /** Longest latency */
+    uint32_t ows_latency_max;
+    /** Sum of all latencies */
+    uint64_t ows_latency_total;
+};
+
+#if MYNEWT_VAL(OS_WORK)
+
+/**
+ * Initialize a work item.
+ *
+ * @param w    The work item to initialize
+ * @param fn   The function to run; called with &w->ow_ev
+ * @param arg  Stored in w->ow_ev.ev_arg
+ * @param prio The priority to run the work at.  Work of a lower numbered
+ *             priority always runs first; work of the same priority runs
+ *             in the order it was posted.
+ */
+void os_work_init(struct os_work *w, os_event_fn *fn, void *arg,
+                  uint8_t prio);
+
+/**
+ * Schedule a work item to run in the work task.  May be called from an
+ * interrupt handler.  Posting work that is already pending does nothing.
+ *
+ * @param w The work item to post
+ */
+void os_work_post(struct os_work *w);
+
+/**
+ * Remove a pending work item without running it.
+ *
+ * @param w The work item to cancel
+ */
+void os_work_cancel(struct os_work *w);
+
+/**
+ * Read the latency statistics of a work priority.
+ *
+ * @param prio The priority to read
+ * @param ows  Filled in with the statistics; all zero without
+ *             OS_WORK_STATS
+ *
+ * @return 0 on success, OS_EINVAL if prio is out of range
+ */
+int os_work_stats_get(uint8_t prio, struct os_work_stats *ows);
+
+/**
+ * Clear the latency statistics of all work priorities.
+ */
+void os_work_stats_reset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_WORK_H_ */
+
+/**
+ *   @} OSWork
+ * @} OSKernel
+ */
@@ -155,6 +155,10 @@ SVC_Done:
 /*-------------------------- PendSV_Handler ---------------------------------*/
 
 #       void PendSV_Handler (void);
+#
+#   With HARDFLOAT the EXC_RETURN value is saved with R4-R11.  Bit 4 clear
+#   means the task had used the FPU and took an extended frame, so S16-S31
+#   are saved too; otherwise the FP registers are left alone.
 
         .thumb_func
         .type   PendSV_Handler, %function
@@ -187,6 +187,20 @@ os_arch_init(void)
      * Trap on divide-by-zero.
      */
     SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+#if MYNEWT_VAL(HARDFLOAT)
+    /*
+     * Automatic, lazy FP state preservation.  Exceptions taken from a
+     * context that has used the FPU (CONTROL.FPCA) get an extended frame,
+     * with space for S0-S15 reserved but only written if the handler
+     * itself touches the FPU.  PendSV saves S16-S31 only for such frames,
+     * so switching between tasks which never used the FPU costs nothing
+     * extra.  These are the reset defaults; set them anyway in case
+     * startup code changed them.
+     */
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+    __DSB();
+    __ISB();
+#endif
     os_init_idle_task();
 }
 
@@ -60,8 +60,14 @@ struct os_task *g_fpu_task;
 
 struct os_task_t* g_fpu_user;
 
+/*
+ * Priority 1, which the core timer and context switch interrupts use, is
+ * always on shadow set 0, so these save the registers without checking
+ * SRSCtl first.
+ */
+
 /* core timer interrupt */
-void __attribute__((interrupt(IPL1AUTO),
+void __attribute__((interrupt(IPL1SOFT),
 vector(_CORE_TIMER_VECTOR))) isr_core_timer(void)
 {
     timer_handler();
@@ -71,9 +77,12 @@ vector(_CORE_TIMER_VECTOR))) isr_core_timer(void)
 
 /* context switch interrupt, in ctx.S */
 void
-__attribute__((interrupt(IPL1AUTO), vector(_CORE_SOFTWARE_0_VECTOR)))
+__attribute__((interrupt(IPL1SOFT), vector(_CORE_SOFTWARE_0_VECTOR)))
 isr_sw0(void);
 
+/* task context switch, in ctx.S */
+void os_arch_task_switch(void);
+
 static int
 os_in_isr(void)
 {
@@ -81,6 +90,14 @@ os_in_isr(void)
     return (_CP0_GET_STATUS() & _CP0_STATUS_EXL_MASK) ? 1 : 0;
 }
 
+static int
+os_in_task(void)
+{
+    /* interrupt handlers run with EXL set or the IPL raised */
+    return (_CP0_GET_STATUS() &
+            (_CP0_STATUS_EXL_MASK | _CP0_STATUS_IPL_MASK)) == 0;
+}
+
 void
 timer_handler(void)
 {
@@ -94,7 +111,16 @@ os_arch_ctx_sw(struct os_task *t)
         os_sched_ctx_sw_hook(t);
     }
 
-    IFS0SET = _IFS0_CS0IF_MASK;
+    /*
+     * A task giving up the CPU switches right away, saving only the
+     * callee-saved registers.  From an interrupt, the switch is left to the
+     * software interrupt.
+     */
+    if (os_sched_get_current_task() != NULL && os_in_task()) {
+        os_arch_task_switch();
+    } else {
+        IFS0SET = _IFS0_CS0IF_MASK;
+    }
 }
 
 os_sr_t
@@ -156,7 +182,8 @@ os_arch_task_stack_init(struct os_task *t, os_stack_t *stack_top, int size)
     ctx.regs[3] = (uint32_t)t->t_arg;
     ctx.regs[27] = get_global_pointer();
     ctx.status = (_CP0_GET_STATUS() & ~_CP0_STATUS_CU1_MASK) | _CP0_STATUS_IE_MASK;
-    ctx.cause = _CP0_GET_CAUSE();
+    /* IV set marks a full frame, see ctx.S */
+    ctx.cause = _CP0_GET_CAUSE() | _CP0_CAUSE_IV_MASK;
     ctx.epc = (uint32_t)t->t_func;
     /* copy struct onto the stack */
     memcpy(s, &ctx, sizeof(ctx));
@@ -174,6 +201,9 @@ os_error_t
 os_arch_os_init(void)
 {
     os_error_t err;
+#if MYNEWT_VAL(OS_PIC32_SHADOW_REG_IPL) && defined(_PRISS_PRI7SS_POSITION)
+    int ipl;
+#endif
 
     err = OS_ERR_IN_ISR;
     if (os_in_isr() == 0) {
@@ -205,6 +235,16 @@ os_arch_os_init(void)
         IPC0CLR = _IPC0_CS0IS_MASK;
         IPC0SET = (0 << _IPC0_CS0IS_POSITION); /* subpriority 0 */
 
+#if MYNEWT_VAL(OS_PIC32_SHADOW_REG_IPL) && defined(_PRISS_PRI7SS_POSITION)
+        /*
+         * Give each priority level from OS_PIC32_SHADOW_REG_IPL up the
+         * shadow register set of the same number.
+         */
+        for (ipl = MYNEWT_VAL(OS_PIC32_SHADOW_REG_IPL); ipl <= 7; ipl++) {
+            PRISSSET = ipl << (ipl * _PRISS_PRI1SS_POSITION);
+        }
+#endif
+
         OS_EXIT_CRITICAL(sr);
 
         /* should be in kernel mode here */
@@ -70,6 +70,9 @@ os_idle_task(void *arg)
     os_time_t iticks, sticks, cticks;
     os_time_t sanity_last;
     os_time_t sanity_itvl_ticks;
+#if MYNEWT_VAL(OS_PM)
+    struct os_pm_state *ps;
+#endif
 
     sanity_itvl_ticks = (MYNEWT_VAL(SANITY_INTERVAL) * OS_TICKS_PER_SEC) / 1000;
     sanity_last = 0;
@@ -109,8 +112,15 @@ os_idle_task(void *arg)
          */
 
         os_trace_idle();
+#if MYNEWT_VAL(OS_PM)
+        /* Use the deepest registered sleep state that fits. */
+        ps = os_pm_idle(now, iticks);
+        OS_EXIT_CRITICAL(sr);
+        os_pm_idle_done(ps, now);
+#else
         os_tick_idle(iticks);
         OS_EXIT_CRITICAL(sr);
+#endif
     }
 }
 
@@ -171,9 +181,13 @@ os_init(int (*main_fn)(int argc, char **arg))
     SEGGER_RTT_Init();
 #endif
 
-    TAILQ_INIT(&g_callout_list);
+    os_callout_list_init();
+    os_sched_run_list_init();
     STAILQ_INIT(&g_os_task_list);
     os_eventq_init(os_eventq_dflt_get());
+#if MYNEWT_VAL(OS_WORK)
+    os_work_task_init();
+#endif
 
     /* Initialize device list. */
     os_dev_reset();
@@ -26,7 +26,20 @@
 #include "os/mynewt.h"
 #include "os_priv.h"
 
-struct os_callout_list g_callout_list;
+/*
+ * With OS_CALLOUT_LAZY a callout is filed under c_armed, which
+ * os_callout_reset_lazy() leaves alone while moving c_ticks later.  A
+ * callout reached before its c_ticks is re-filed instead of expired.
+ */
+#if MYNEWT_VAL(OS_CALLOUT_LAZY)
+#define OS_CALLOUT_KEY(c)           ((c)->c_armed)
+#define OS_CALLOUT_ARM(c)           ((c)->c_armed = (c)->c_ticks)
+#define OS_CALLOUT_PUSHED(c, now)   OS_TIME_TICK_GT((c)->c_ticks, (now))
+#else
+#define OS_CALLOUT_KEY(c)           ((c)->c_ticks)
+#define OS_CALLOUT_ARM(c)
+#define OS_CALLOUT_PUSHED(c, now)   0
+#endif
 
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
@@ -41,6 +54,179 @@ void os_callout_init(struct os_callout *c, struct os_eventq *evq,
     os_trace_api_ret(OS_TRACE_ID_CALLOUT_INIT);
 }
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+/*
+ * Hierarchical timing wheel.
+ *
+ * Level 'l' has OS_CW_SLOTS slots, each covering 2^(l * OS_CW_BITS) ticks.
+ * A callout is filed in the lowest level which can hold its distance from
+ * the wheel's current position; when the lower levels wrap around, the
+ * next slot of the level above is emptied and its callouts are re-filed
+ * ("cascaded") closer to level 0.  Callouts expire from level 0 a whole
+ * slot at a time.  Per-level occupancy bitmaps let the tick handler and
+ * the idle task skip straight to the next non-empty slot.
+ */
+
+#define OS_CW_BITS          MYNEWT_VAL(OS_CALLOUT_WHEEL_BITS)
+#define OS_CW_LEVELS        MYNEWT_VAL(OS_CALLOUT_WHEEL_LEVELS)
+#define OS_CW_SLOTS         (1 << OS_CW_BITS)
+#define OS_CW_MASK          (OS_CW_SLOTS - 1)
+#define OS_CW_ALL           (0xffffffffUL >> (32 - OS_CW_SLOTS))
+#define OS_CW_SHIFT(level)  ((level) * OS_CW_BITS)
+#define OS_CW_RANGE         ((os_time_t)1 << OS_CW_SHIFT(OS_CW_LEVELS))
+
+#if OS_CW_BITS < 1 || OS_CW_BITS > 5
+#error "OS_CALLOUT_WHEEL_BITS must be between 1 and 5"
+#endif
+
+#if OS_CW_LEVELS < 1 || OS_CW_LEVELS * OS_CW_BITS > 31
+#error "OS_CALLOUT_WHEEL_LEVELS * OS_CALLOUT_WHEEL_BITS must not exceed 31"
+#endif
+
+static struct {
+    /** Next tick to be processed by os_callout_tick(). */
+    os_time_t cw_next;
+    /** One bit per non-empty slot, per level. */
+    uint32_t cw_occupied[OS_CW_LEVELS];
+    struct os_callout_list cw_slots[OS_CW_LEVELS][OS_CW_SLOTS];
+} os_callout_wheel;
+
+void
+os_callout_list_init(void)
+{
+    memset(&os_callout_wheel, 0, sizeof(os_callout_wheel));
+    os_callout_wheel.cw_next = os_time_get();
+}
+
+static void
+os_callout_wheel_insert(struct os_callout *c)
+{
+    os_time_t delta;
+    os_time_t key;
+    int level;
+    int idx;
+
+    key = OS_CALLOUT_KEY(c);
+    delta = key - os_callout_wheel.cw_next;
+    if ((int32_t)delta < 0) {
+        /* Already due; expire on the next tick processed. */
+        key = os_callout_wheel.cw_next;
+        delta = 0;
+    } else if (delta >= OS_CW_RANGE) {
+        /* Beyond the wheel; park in the furthest slot and re-file later. */
+        delta = OS_CW_RANGE - 1;
+        key = os_callout_wheel.cw_next + delta;
+    }
+
+    level = 0;
+    while (delta >= ((os_time_t)1 << OS_CW_SHIFT(level + 1))) {
+        level++;
+    }
+
+    idx = (key >> OS_CW_SHIFT(level)) & OS_CW_MASK;
+    LIST_INSERT_HEAD(&os_callout_wheel.cw_slots[level][idx], c, c_next);
+    os_callout_wheel.cw_occupied[level] |= 1UL << idx;
+}
+
+static void
+os_callout_wheel_remove(struct os_callout *c)
+{
+    struct os_callout_list *first;
+    struct os_callout_list *slot;
+    int off;
+
+    /*
+     * Only the first callout in a slot points back at the slot head, and
+     * only removing that one can leave the slot empty.  This keeps the
+     * occupancy bitmap exact without storing the slot in the callout.
+     */
+    first = &os_callout_wheel.cw_slots[0][0];
+    slot = (struct os_callout_list *)c->c_next.le_prev;
+
+    LIST_REMOVE(c, c_next);
+    c->c_next.le_prev = NULL;
+
+    if (slot >= first && slot < first + OS_CW_LEVELS * OS_CW_SLOTS &&
+        LIST_EMPTY(slot)) {
+        off = slot - first;
+        os_callout_wheel.cw_occupied[off / OS_CW_SLOTS] &=
+            ~(1UL << (off % OS_CW_SLOTS));
+    }
+}
+
+/*
+ * Returns the number of ticks from cw_next to the first tick at which a
+ * non-empty slot is either expired (level 0) or cascaded (upper levels).
+ * Returns OS_TIMEOUT_NEVER if the wheel is empty.
+ */
+static os_time_t
+os_callout_wheel_next_delta(void)
+{
+    os_time_t start;
+    os_time_t unit;
+    os_time_t best;
+    os_time_t d;
+    uint32_t bits;
+    int level;
+    int pos;
+
+    best = OS_TIMEOUT_NEVER;
+    for (level = 0; level < OS_CW_LEVELS; level++) {
+        bits = os_callout_wheel.cw_occupied[level];
+        if (bits == 0) {
+            continue;
+        }
+
+        /* First tick at or after cw_next at which this level advances. */
+        unit = (os_time_t)1 << OS_CW_SHIFT(level);
+        start = (os_time_t)(os_callout_wheel.cw_next + unit - 1) & ~(unit - 1);
+        pos = (start >> OS_CW_SHIFT(level)) & OS_CW_MASK;
+
+        /* Rotate so that bit 0 is the slot visited at 'start'. */
+        if (pos != 0) {
+            bits = ((bits >> pos) | (bits << (OS_CW_SLOTS - pos))) & OS_CW_ALL;
+        }
+
+        d = (start - os_callout_wheel.cw_next) +
+            ((os_time_t)__builtin_ctz(bits) << OS_CW_SHIFT(level));
+        if (d < best) {
+            best = d;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Re-files the upper level slots which are reached at tick cw_next.  Must
+ * be called with interrupts disabled.
+ */
+static void
+os_callout_wheel_cascade(void)
+{
+    struct os_callout_list *slot;
+    struct os_callout *c;
+    os_time_t t;
+    int level;
+    int idx;
+
+    t = os_callout_wheel.cw_next;
+    for (level = 1; level < OS_CW_LEVELS; level++) {
+        if ((t & (((os_time_t)1 << OS_CW_SHIFT(level)) - 1)) != 0) {
+            break;
+        }
+
+        idx = (t >> OS_CW_SHIFT(level)) & OS_CW_MASK;
+        slot = &os_callout_wheel.cw_slots[level][idx];
+        while ((c = LIST_FIRST(slot)) != NULL) {
+            os_callout_wheel_remove(c);
+            OS_CALLOUT_ARM(c);
+            os_callout_wheel_insert(c);
+        }
+    }
+}
+
 void
 os_callout_stop(struct os_callout *c)
 {
@@ -51,8 +237,7 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
-        TAILQ_REMOVE(&g_callout_list, c, c_next);
-        c->c_next.tqe_prev = NULL;
+        os_callout_wheel_remove(c);
     }
 
     if (c->c_evq) {
@@ -67,7 +252,6 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
-    struct os_callout *entry;
     os_sr_t sr;
     int ret;
 
@@ -87,10 +271,125 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     }
 
     c->c_ticks = os_time_get() + ticks;
+    OS_CALLOUT_ARM(c);
+    os_callout_wheel_insert(c);
+
+    OS_EXIT_CRITICAL(sr);
+
+    ret = OS_OK;
+
+err:
+    os_trace_api_ret_u32(OS_TRACE_ID_CALLOUT_RESET, (uint32_t)ret);
+    return ret;
+}
+
+/**
+ * This function is called by the OS in the time tick.  It advances the
+ * timing wheel up to the current time, jumping directly between non-empty
+ * slots, and posts an event for each callout in every level 0 slot that
+ * is reached.
+ */
+void
+os_callout_tick(void)
+{
+    struct os_callout_list *slot;
+    struct os_callout *c;
+    os_time_t delta;
+    os_time_t now;
+    os_sr_t sr;
+    int idx;
+
+    os_trace_api_void(OS_TRACE_ID_CALLOUT_TICK);
+
+    now = os_time_get();
+
+    OS_ENTER_CRITICAL(sr);
+    while (OS_TIME_TICK_GEQ(now, os_callout_wheel.cw_next)) {
+        delta = os_callout_wheel_next_delta();
+        if (delta > now - os_callout_wheel.cw_next) {
+            os_callout_wheel.cw_next = now + 1;
+            break;
+        }
+        os_callout_wheel.cw_next += delta;
+
+        os_callout_wheel_cascade();
+
+        idx = os_callout_wheel.cw_next & OS_CW_MASK;
+        slot = &os_callout_wheel.cw_slots[0][idx];
+        while ((c = LIST_FIRST(slot)) != NULL) {
+            os_callout_wheel_remove(c);
+            if (OS_CALLOUT_PUSHED(c, os_callout_wheel.cw_next)) {
+                /* Pushed back since it was filed; file it again. */
+                OS_CALLOUT_ARM(c);
+                os_callout_wheel_insert(c);
+                continue;
+            }
+            OS_EXIT_CRITICAL(sr);
+
+            if (c->c_evq) {
+                os_eventq_put(c->c_evq, &c->c_ev);
+            } else {
+                c->c_ev.ev_cb(&c->c_ev);
+            }
+
+            OS_ENTER_CRITICAL(sr);
+        }
+
+        os_callout_wheel.cw_next++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    os_trace_api_ret(OS_TRACE_ID_CALLOUT_TICK);
+}
+
+/*
+ * Returns the number of ticks to the next non-empty wheel slot.  This may
+ * be a cascade rather than an expiry, in which case the idle task wakes up
+ * early, re-files the slot and goes back to sleep.  If there are no
+ * pending callouts then return OS_TIMEOUT_NEVER instead.
+ *
+ * @param now The time now
+ *
+ * @return Number of ticks to first pending callout
+ */
+os_time_t
+os_callout_wakeup_ticks(os_time_t now)
+{
+    os_time_t delta;
+    os_time_t t;
+
+    OS_ASSERT_CRITICAL();
+
+    delta = os_callout_wheel_next_delta();
+    if (delta == OS_TIMEOUT_NEVER) {
+        return OS_TIMEOUT_NEVER;
+    }
+
+    t = os_callout_wheel.cw_next + delta;
+    if (OS_TIME_TICK_GEQ(t, now)) {
+        return t - now;
+    } else {
+        return 0;
+    }
+}
+
+#else
+
+struct os_callout_list g_callout_list;
+
+void
+os_callout_list_init(void)
+{
+    TAILQ_INIT(&g_callout_list);
+}
+
+static void
+os_callout_list_insert(struct os_callout *c)
+{
+    struct os_callout *entry;
 
-    entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
-        if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
+        if (OS_TIME_TICK_LT(OS_CALLOUT_KEY(c), OS_CALLOUT_KEY(entry))) {
             break;
         }
     }
@@ -100,6 +399,55 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+}
+
+void
+os_callout_stop(struct os_callout *c)
+{
+    os_sr_t sr;
+
+    os_trace_api_u32(OS_TRACE_ID_CALLOUT_STOP, (uint32_t)c);
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (os_callout_queued(c)) {
+        TAILQ_REMOVE(&g_callout_list, c, c_next);
+        c->c_next.tqe_prev = NULL;
+    }
+
+    if (c->c_evq) {
+        os_eventq_remove(c->c_evq, &c->c_ev);
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    os_trace_api_ret(OS_TRACE_ID_CALLOUT_STOP);
+}
+
+int
+os_callout_reset(struct os_callout *c, os_time_t ticks)
+{
+    os_sr_t sr;
+    int ret;
+
+    os_trace_api_u32x2(OS_TRACE_ID_CALLOUT_RESET, (uint32_t)c, (uint32_t)ticks);
+
+    if (ticks > INT32_MAX) {
+        ret = OS_EINVAL;
+        goto err;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    os_callout_stop(c);
+
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    c->c_ticks = os_time_get() + ticks;
+    OS_CALLOUT_ARM(c);
+    os_callout_list_insert(c);
 
     OS_EXIT_CRITICAL(sr);
 
@@ -132,9 +480,16 @@ os_callout_tick(void)
         OS_ENTER_CRITICAL(sr);
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
-            if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
+            if (OS_TIME_TICK_GEQ(now, OS_CALLOUT_KEY(c))) {
                 TAILQ_REMOVE(&g_callout_list, c, c_next);
                 c->c_next.tqe_prev = NULL;
+                if (OS_CALLOUT_PUSHED(c, now)) {
+                    /* Pushed back since it was filed; file it again. */
+                    OS_CALLOUT_ARM(c);
+                    os_callout_list_insert(c);
+                    OS_EXIT_CRITICAL(sr);
+                    continue;
+                }
             } else {
                 c = NULL;
             }
@@ -173,8 +528,8 @@ os_callout_wakeup_ticks(os_time_t now)
 
     c = TAILQ_FIRST(&g_callout_list);
     if (c != NULL) {
-        if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
-            rt = c->c_ticks - now;
+        if (OS_TIME_TICK_GEQ(OS_CALLOUT_KEY(c), now)) {
+            rt = OS_CALLOUT_KEY(c) - now;
         } else {
             rt = 0;     /* callout time is in the past */
         }
@@ -186,6 +541,39 @@ os_callout_wakeup_ticks(os_time_t now)
 }
 
 
+#endif
+
+#if MYNEWT_VAL(OS_CALLOUT_LAZY)
+int
+os_callout_reset_lazy(struct os_callout *c, os_time_t ticks)
+{
+    os_time_t deadline;
+    os_sr_t sr;
+
+    if (ticks > INT32_MAX) {
+        return OS_EINVAL;
+    }
+
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (os_callout_queued(c)) {
+        deadline = os_time_get() + ticks;
+        if (OS_TIME_TICK_GEQ(deadline, c->c_armed)) {
+            c->c_ticks = deadline;
+            OS_EXIT_CRITICAL(sr);
+            return OS_OK;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    /* Not pending, or moved earlier: relink. */
+    return os_callout_reset(c, ticks);
+}
+#endif
+
 os_time_t
 os_callout_remaining_ticks(struct os_callout *c, os_time_t now)
 {
@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+
+/*
+ * Internet checksum (RFC 1071) helpers.
+ *
+ * The ones-complement sum does not depend on byte order as long as data
+ * and result are in the same order, so data is summed as native 32-bit
+ * words and folded down to 16 bits at the end. A range starting at an odd
+ * address is summed from the next byte on and the result byte-swapped.
+ */
+
+#define OS_CKSUM_SWAP(s)    ((uint16_t)(((s) << 8) | ((s) >> 8)))
+
+static uint16_t
+os_cksum_fold(uint64_t sum)
+{
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    return sum;
+}
+
+/*
+ * Sums 32-bit words from a 4-byte aligned pointer; len is a multiple of 4.
+ */
+static uint64_t
+os_cksum_words(const uint32_t *p, int len, uint64_t sum)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    uint32_t acc;
+    uint32_t carry;
+    uint32_t a;
+    uint32_t b;
+
+    /*
+     * Sixteen bytes per iteration. Each carry out is added back in by the
+     * next adcs (2^32 == 1 modulo 0xffff); the last one is counted.
+     */
+    acc = 0;
+    carry = 0;
+    while (len >= 16) {
+        __asm__ volatile (
+            "ldr  %[a], [%[p]]\n\t"
+            "ldr  %[b], [%[p], #4]\n\t"
+            "adds %[s], %[s], %[a]\n\t"
+            "adcs %[s], %[s], %[b]\n\t"
+            "ldr  %[a], [%[p], #8]\n\t"
+            "ldr  %[b], [%[p], #12]\n\t"
+            "adcs %[s], %[s], %[a]\n\t"
+            "adcs %[s], %[s], %[b]\n\t"
+            "adc  %[c], %[c], #0\n\t"
+            : [s] "+r" (acc), [c] "+r" (carry), [a] "=&r" (a), [b] "=&r" (b)
+            : [p] "r" (p)
+            : "cc", "memory");
+        p += 4;
+        len -= 16;
+    }
+    sum += acc;
+    sum += carry;
+#endif
+    while (len >= 4) {
+        sum += *p++;
+        len -= 4;
+    }
+    return sum;
+}
+
+uint16_t
+os_cksum16(const void *buf, int len)
+{
+    const uint8_t *p;
+    uint64_t sum;
+    uint16_t t;
+    int odd;
+
+    p = buf;
+    sum = 0;
+    odd = (uintptr_t)p & 1;
+    if (odd && len > 0) {
+        t = 0;
+        ((uint8_t *)&t)[1] = *p++;
+        sum += t;
+        len--;
+    }
+    if (((uintptr_t)p & 2) && len >= 2) {
+        sum += *(const uint16_t *)p;
+        p += 2;
+        len -= 2;
+    }
+
+    sum = os_cksum_words((const uint32_t *)p, len & ~3, sum);
+    p += len & ~3;
+    len &= 3;
+
+    if (len >= 2) {
+        sum += *(const uint16_t *)p;
+        p += 2;
+        len -= 2;
+    }
+    if (len) {
+        t = 0;
+        ((uint8_t *)&t)[0] = *p;
+        sum += t;
+    }
+
+    t = os_cksum_fold(sum);
+    if (odd) {
+        t = OS_CKSUM_SWAP(t);
+    }
+    return t;
+}
+
+int
+os_mbuf_cksum16(const struct os_mbuf *om, int off, int len, uint16_t *out_sum)
+{
+    const struct os_mbuf *cur;
+    uint16_t cur_off;
+    uint32_t sum;
+    uint16_t s;
+    int count;
+    int pos;
+
+    cur = os_mbuf_off(om, off, &cur_off);
+    if (cur == NULL) {
+        return SYS_EINVAL;
+    }
+
+    sum = 0;
+    pos = 0;
+    while (len > 0) {
+        if (cur == NULL) {
+            return SYS_EINVAL;
+        }
+        count = min(cur->om_len - cur_off, len);
+        if (count > 0) {
+            s = os_cksum16(cur->om_data + cur_off, count);
+            if (pos & 1) {
+                /* Segment starts in the middle of a 16-bit word. */
+                s = OS_CKSUM_SWAP(s);
+            }
+            sum += s;
+            pos += count;
+            len -= count;
+        }
+        cur_off = 0;
+        cur = SLIST_NEXT(cur, om_next);
+    }
+
+    *out_sum = os_cksum_fold(sum);
+    return 0;
+}
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <assert.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 #if defined(OS_CPUTIME_FREQ_HIGH)
 struct os_cputime_data g_os_cputime;
@@ -31,9 +32,9 @@ os_cputime_init(uint32_t clock_freq)
 {
     int rc;
 
-    /* Set the ticks per microsecond. */
+    /* Precompute the tick conversions. */
 #if defined(OS_CPUTIME_FREQ_HIGH)
-    g_os_cputime.ticks_per_usec = clock_freq / 1000000U;
+    os_cputime_high_init(clock_freq);
 #endif
     rc = hal_timer_config(MYNEWT_VAL(OS_CPUTIME_TIMER_NUM), clock_freq);
     return rc;
@@ -18,6 +18,7 @@
  */
 
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 /**
  * This module implements cputime functionality for timers whose frequency is
@@ -33,6 +34,79 @@
  *   @{
  */
 
+/*
+ * The clock need not be a whole number of MHz, so each conversion is
+ * x * num / den.  To keep divisions out of the conversions (Cortex-M0 has no
+ * divider at all and the 64-bit divide is a libgcc call everywhere), num / den
+ * is precomputed by os_cputime_init() as a 32.32 fixed-point multiplier:
+ *
+ *     mult = floor(num * 2^32 / den)
+ *
+ * Since mult is at most one unit in the last place low, x * mult / 2^32
+ * undershoots x * num / den by less than x / 2^32 < 1, so the estimated
+ * quotient is either exact or one too small.  One multiply-and-compare against
+ * x * num settles which, so all conversions below are exact: the same result
+ * a 64-bit division would give, truncated to 32 bits.
+ */
+static void
+os_cputime_ratio_init(struct os_cputime_ratio *r, uint32_t num, uint32_t den)
+{
+    r->num = num;
+    r->den = den;
+    r->mult = ((uint64_t)num << 32) / den;
+}
+
+/*
+ * Returns floor(x * num / den).  If rem is non-NULL, it is set to
+ * x * num mod den.
+ */
+static inline uint64_t
+os_cputime_ratio_floor(const struct os_cputime_ratio *r, uint32_t x,
+                       uint32_t *rem)
+{
+    uint64_t prod;
+    uint64_t q;
+    uint64_t d;
+
+    /* x * mult >> 32, from two 32x32->64 multiplies. */
+    q = (uint64_t)x * (uint32_t)(r->mult >> 32) +
+        (((uint64_t)x * (uint32_t)r->mult) >> 32);
+
+    prod = (uint64_t)x * r->num;
+    d = prod - q * r->den;
+    if (d >= r->den) {
+        q++;
+        d -= r->den;
+    }
+
+    if (rem != NULL) {
+        *rem = d;
+    }
+    return q;
+}
+
+static inline uint64_t
+os_cputime_ratio_ceil(const struct os_cputime_ratio *r, uint32_t x)
+{
+    uint32_t rem;
+    uint64_t q;
+
+    q = os_cputime_ratio_floor(r, x, &rem);
+    return q + (rem != 0);
+}
+
+void
+os_cputime_high_init(uint32_t clock_freq)
+{
+    g_os_cputime.ticks_per_usec = clock_freq / 1000000U;
+    os_cputime_ratio_init(&g_os_cputime.usecs_to_ticks, clock_freq, 1000000U);
+    os_cputime_ratio_init(&g_os_cputime.ticks_to_usecs, 1000000U, clock_freq);
+    os_cputime_ratio_init(&g_os_cputime.nsecs_to_ticks, clock_freq,
+                          1000000000U);
+    os_cputime_ratio_init(&g_os_cputime.ticks_to_nsecs, 1000000000U,
+                          clock_freq);
+}
+
 /**
  * os cputime usecs to ticks
  *
@@ -45,7 +119,7 @@
 uint32_t
 os_cputime_usecs_to_ticks(uint32_t usecs)
 {
-    return usecs * g_os_cputime.ticks_per_usec;
+    return os_cputime_ratio_floor(&g_os_cputime.usecs_to_ticks, usecs, NULL);
 }
 
 /**
@@ -60,8 +134,7 @@ os_cputime_usecs_to_ticks(uint32_t usecs)
 uint32_t
 os_cputime_ticks_to_usecs(uint32_t ticks)
 {
-    return (ticks + g_os_cputime.ticks_per_usec - 1) /
-           g_os_cputime.ticks_per_usec;
+    return os_cputime_ratio_ceil(&g_os_cputime.ticks_to_usecs, ticks);
 }
 
 /**
@@ -76,7 +149,7 @@ os_cputime_ticks_to_usecs(uint32_t ticks)
 uint32_t
 os_cputime_nsecs_to_ticks(uint32_t nsecs)
 {
-    return (nsecs * g_os_cputime.ticks_per_usec + 999) / 1000;
+    return os_cputime_ratio_ceil(&g_os_cputime.nsecs_to_ticks, nsecs);
 }
 
 /**
@@ -91,8 +164,7 @@ os_cputime_nsecs_to_ticks(uint32_t nsecs)
 uint32_t
 os_cputime_ticks_to_nsecs(uint32_t ticks)
 {
-    return (ticks * 1000 + g_os_cputime.ticks_per_usec - 1) /
-           g_os_cputime.ticks_per_usec;
+    return os_cputime_ratio_ceil(&g_os_cputime.ticks_to_nsecs, ticks);
 }
 
 /**
@@ -20,7 +20,52 @@
 #include <string.h>
 #include "os/mynewt.h"
 
-static STAILQ_HEAD(, os_dev) g_os_dev_list;
+static TAILQ_HEAD(os_dev_list, os_dev) g_os_dev_list =
+    TAILQ_HEAD_INITIALIZER(g_os_dev_list);
+
+/* Bumped by os_dev_reset() to invalidate resolved device handles. */
+static uint32_t g_os_dev_gen;
+
+#if MYNEWT_VAL(OS_DEV_HASH_BUCKETS) > 0
+static SLIST_HEAD(, os_dev) g_os_dev_hash[MYNEWT_VAL(OS_DEV_HASH_BUCKETS)];
+
+/* FNV-1a */
+static uint32_t
+os_dev_name_hash(const char *name)
+{
+    uint32_t hash;
+
+    hash = 2166136261UL;
+    while (*name != '\0') {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+static void
+os_dev_hash_add(struct os_dev *dev)
+{
+    struct os_dev *prev;
+    struct os_dev *cur;
+    int idx;
+
+    dev->od_name_hash = os_dev_name_hash(dev->od_name);
+    idx = dev->od_name_hash % MYNEWT_VAL(OS_DEV_HASH_BUCKETS);
+
+    /* Append, so the first device created under a name wins, as before. */
+    prev = NULL;
+    SLIST_FOREACH(cur, &g_os_dev_hash[idx], od_hnext) {
+        prev = cur;
+    }
+    if (prev == NULL) {
+        SLIST_INSERT_HEAD(&g_os_dev_hash[idx], dev, od_hnext);
+    } else {
+        SLIST_INSERT_AFTER(prev, dev, od_hnext);
+    }
+}
+#endif
 
 static int
 os_dev_init(struct os_dev *dev, char *name, uint8_t stage,
@@ -51,31 +96,26 @@ os_dev_add(struct os_dev *dev)
 {
     struct os_dev *cur_dev;
 
-    /* If no devices present, insert into head */
-    if (STAILQ_FIRST(&g_os_dev_list) == NULL) {
-        STAILQ_INSERT_HEAD(&g_os_dev_list, dev, od_next);
-        return (0);
-    }
+#if MYNEWT_VAL(OS_DEV_HASH_BUCKETS) > 0
+    os_dev_hash_add(dev);
+#endif
 
     /* Add devices to the list, sorted first by stage, then by
      * priority.  Keep sorted in this order for initialization
-     * stage.
+     * stage; devices of equal stage and priority stay in creation order.
      */
-    cur_dev = NULL;
-    STAILQ_FOREACH(cur_dev, &g_os_dev_list, od_next) {
-        if (cur_dev->od_stage > dev->od_stage) {
-            continue;
-        }
-
-        if (dev->od_priority >= cur_dev->od_priority) {
+    TAILQ_FOREACH_REVERSE(cur_dev, &g_os_dev_list, os_dev_list, od_next) {
+        if (cur_dev->od_stage < dev->od_stage ||
+            (cur_dev->od_stage == dev->od_stage &&
+             cur_dev->od_priority <= dev->od_priority)) {
             break;
         }
     }
 
     if (cur_dev) {
-        STAILQ_INSERT_AFTER(&g_os_dev_list, cur_dev, dev, od_next);
+        TAILQ_INSERT_AFTER(&g_os_dev_list, cur_dev, dev, od_next);
     } else {
-        STAILQ_INSERT_TAIL(&g_os_dev_list, dev, od_next);
+        TAILQ_INSERT_HEAD(&g_os_dev_list, dev, od_next);
     }
 
     return (0);
@@ -136,7 +176,7 @@ os_dev_initialize_all(uint8_t stage)
     struct os_dev *dev;
     int rc = 0;
 
-    STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
+    TAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
         if (dev->od_stage == stage) {
             rc = os_dev_initialize(dev);
             if (rc) {
@@ -148,22 +188,90 @@ os_dev_initialize_all(uint8_t stage)
     return (rc);
 }
 
+/* Devices of the same stage and priority don't depend on each other. */
+static inline int
+os_dev_same_level(const struct os_dev *a, const struct os_dev *b)
+{
+    return a->od_stage == b->od_stage && a->od_priority == b->od_priority;
+}
+
+static int
+os_dev_resume_step(struct os_dev *dev, os_time_t suspend_t, uint8_t force)
+{
+    if (!(dev->od_flags & OS_DEV_F_STATUS_SUSPENDED)) {
+        /* Never suspended (or not open); nothing to resume. */
+        return 0;
+    }
+    return os_dev_resume(dev);
+}
+
+/*
+ * Runs step on every device of one level, starting at first and moving
+ * forward or backward through the list.  Devices that return OS_EBUSY are
+ * called again, after the rest of the level, until they finish.
+ *
+ * @return The device after the level, in the direction of travel.
+ */
+static struct os_dev *
+os_dev_level_run(struct os_dev *first, int backward,
+                 int (*step)(struct os_dev *, os_time_t, uint8_t),
+                 os_time_t suspend_t, uint8_t force, int *first_rc)
+{
+    struct os_dev *dev;
+    struct os_dev *end;
+    int pending;
+    int rc;
+
+    pending = 0;
+    for (dev = first; dev != NULL && os_dev_same_level(dev, first);
+         dev = backward ? TAILQ_PREV(dev, os_dev_list, od_next) :
+                          TAILQ_NEXT(dev, od_next)) {
+        rc = step(dev, suspend_t, force);
+        if (rc == OS_EBUSY) {
+            dev->od_flags |= OS_DEV_F_PENDING;
+            pending++;
+        } else if (rc != 0 && *first_rc == 0) {
+            *first_rc = rc;
+        }
+    }
+    end = dev;
+
+    while (pending > 0) {
+        for (dev = first; dev != end;
+             dev = backward ? TAILQ_PREV(dev, os_dev_list, od_next) :
+                              TAILQ_NEXT(dev, od_next)) {
+            if (!(dev->od_flags & OS_DEV_F_PENDING)) {
+                continue;
+            }
+            rc = step(dev, suspend_t, force);
+            if (rc == OS_EBUSY) {
+                continue;
+            }
+            dev->od_flags &= ~OS_DEV_F_PENDING;
+            pending--;
+            if (rc != 0 && *first_rc == 0) {
+                *first_rc = rc;
+            }
+        }
+    }
+
+    return end;
+}
+
 int
 os_dev_suspend_all(os_time_t suspend_t, uint8_t force)
 {
     struct os_dev *dev;
-    int suspend_failure;
     int rc;
 
-    suspend_failure = 0;
-    STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
-        rc = os_dev_suspend(dev, suspend_t, force);
-        if (rc != 0) {
-            suspend_failure = OS_ERROR;
-        }
+    rc = 0;
+    dev = TAILQ_LAST(&g_os_dev_list, os_dev_list);
+    while (dev != NULL) {
+        dev = os_dev_level_run(dev, 1, os_dev_suspend, suspend_t, force,
+                               &rc);
     }
 
-    return (suspend_failure);
+    return (rc != 0 ? OS_ERROR : 0);
 }
 
 int
@@ -172,43 +280,70 @@ os_dev_resume_all(void)
     struct os_dev *dev;
     int rc;
 
-    STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
-        rc = os_dev_resume(dev);
-        if (rc != 0) {
-            goto err;
-        }
+    rc = 0;
+    dev = TAILQ_FIRST(&g_os_dev_list);
+    while (dev != NULL) {
+        dev = os_dev_level_run(dev, 0, os_dev_resume_step, 0, 0, &rc);
     }
 
-    return (0);
-err:
     return (rc);
 }
 
-struct os_dev *
-os_dev_lookup(char *name)
+static struct os_dev *
+os_dev_lookup_name(const char *name)
 {
     struct os_dev *dev;
+#if MYNEWT_VAL(OS_DEV_HASH_BUCKETS) > 0
+    uint32_t hash;
 
+    hash = os_dev_name_hash(name);
+    SLIST_FOREACH(dev, &g_os_dev_hash[hash % MYNEWT_VAL(OS_DEV_HASH_BUCKETS)],
+                  od_hnext) {
+        if (dev->od_name_hash == hash && !strcmp(dev->od_name, name)) {
+            break;
+        }
+    }
+#else
     dev = NULL;
-    STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
+    TAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
         if (!strcmp(dev->od_name, name)) {
             break;
         }
     }
+#endif
     return (dev);
 }
 
 struct os_dev *
-os_dev_open(char *devname, uint32_t timo, void *arg)
+os_dev_lookup(char *name)
 {
-    struct os_dev *dev;
-    os_sr_t sr;
-    int rc;
+    return os_dev_lookup_name(name);
+}
 
-    dev = os_dev_lookup(devname);
-    if (dev == NULL) {
-        return (NULL);
+void
+os_dev_handle_init(struct os_dev_handle *h, const char *name)
+{
+    h->odh_name = name;
+    h->odh_dev = NULL;
+    h->odh_gen = 0;
+}
+
+struct os_dev *
+os_dev_handle_lookup(struct os_dev_handle *h)
+{
+    if (h->odh_dev == NULL || h->odh_gen != g_os_dev_gen) {
+        /* Only found devices are cached; one may be created later. */
+        h->odh_dev = os_dev_lookup_name(h->odh_name);
+        h->odh_gen = g_os_dev_gen;
     }
+    return (h->odh_dev);
+}
+
+static struct os_dev *
+os_dev_open_dev(struct os_dev *dev, uint32_t timo, void *arg)
+{
+    os_sr_t sr;
+    int rc;
 
     /* Device is not ready to be opened. */
     if ((dev->od_flags & OS_DEV_F_STATUS_READY) == 0) {
@@ -232,6 +367,32 @@ err:
     return (NULL);
 }
 
+struct os_dev *
+os_dev_open(char *devname, uint32_t timo, void *arg)
+{
+    struct os_dev *dev;
+
+    dev = os_dev_lookup_name(devname);
+    if (dev == NULL) {
+        return (NULL);
+    }
+
+    return os_dev_open_dev(dev, timo, arg);
+}
+
+struct os_dev *
+os_dev_handle_open(struct os_dev_handle *h, uint32_t timo, void *arg)
+{
+    struct os_dev *dev;
+
+    dev = os_dev_handle_lookup(h);
+    if (dev == NULL) {
+        return (NULL);
+    }
+
+    return os_dev_open_dev(dev, timo, arg);
+}
+
 int
 os_dev_close(struct os_dev *dev)
 {
@@ -317,6 +478,10 @@ os_dev_resume(struct os_dev *dev)
 void
 os_dev_reset(void)
 {
-    STAILQ_INIT(&g_os_dev_list);
+    TAILQ_INIT(&g_os_dev_list);
+#if MYNEWT_VAL(OS_DEV_HASH_BUCKETS) > 0
+    memset(g_os_dev_hash, 0, sizeof(g_os_dev_hash));
+#endif
+    g_os_dev_gen++;
 }
 
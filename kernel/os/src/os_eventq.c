@@ -25,27 +25,97 @@
 #endif
 #include "os/mynewt.h"
 
+/*
+ * Value of ev_queued for an event which has been taken off its queue by
+ * os_eventq_run_batch() but not dispatched yet.  Such an event still counts
+ * as queued: putting it again is a no-op and removing it cancels the
+ * pending dispatch.
+ */
+#define OS_EVENT_BATCHED    (2)
+
+#define OS_EVENTQ_LANES     MYNEWT_VAL(OS_EVENTQ_LANES)
+
+#if OS_EVENTQ_LANES < 1 || OS_EVENTQ_LANES > 4
+#error "OS_EVENTQ_LANES must be between 1 and 4"
+#endif
+
+#if OS_EVENTQ_LANES > 1
+#define OS_EVENTQ_LIST(evq, lane)   (&(evq)->evq_list[(lane)])
+#define OS_EVENT_LANE(ev)           ((ev)->ev_lane)
+#else
+#define OS_EVENTQ_LIST(evq, lane)   (&(evq)->evq_list)
+#define OS_EVENT_LANE(ev)           (0)
+#endif
+
 static struct os_eventq os_eventq_main;
 
+/*
+ * Unlinks and returns the first event on the highest priority non-empty
+ * lane of the queue, or NULL if the queue is empty.  The caller is
+ * responsible for updating ev_queued.
+ */
+static struct os_event *
+os_eventq_pull(struct os_eventq *evq)
+{
+    struct os_event *ev;
+    int lane;
+
+    for (lane = 0; lane < OS_EVENTQ_LANES; lane++) {
+        ev = STAILQ_FIRST(OS_EVENTQ_LIST(evq, lane));
+        if (ev != NULL) {
+            STAILQ_REMOVE_HEAD(OS_EVENTQ_LIST(evq, lane), ev_next);
+            return ev;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+os_eventq_empty(const struct os_eventq *evq)
+{
+    int lane;
+
+    for (lane = 0; lane < OS_EVENTQ_LANES; lane++) {
+        if (!STAILQ_EMPTY(OS_EVENTQ_LIST(evq, lane))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 void
 os_eventq_init(struct os_eventq *evq)
 {
+    int lane;
+
     memset(evq, 0, sizeof(*evq));
-    STAILQ_INIT(&evq->evq_list);
+    for (lane = 0; lane < OS_EVENTQ_LANES; lane++) {
+        STAILQ_INIT(OS_EVENTQ_LIST(evq, lane));
+    }
 }
 
 int
 os_eventq_inited(const struct os_eventq *evq)
 {
-    return evq->evq_list.stqh_last != NULL;
+    return OS_EVENTQ_LIST(evq, 0)->stqh_last != NULL;
 }
 
 void
 os_eventq_put(struct os_eventq *evq, struct os_event *ev)
+{
+    os_eventq_put_lane(evq, ev, OS_EVENTQ_LANES - 1);
+}
+
+void
+os_eventq_put_lane(struct os_eventq *evq, struct os_event *ev, int lane)
 {
     int resched;
     os_sr_t sr;
 
+    assert(lane >= 0 && lane < OS_EVENTQ_LANES);
+
     os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_PUT, (uint32_t)evq, (uint32_t)ev);
 
     OS_ENTER_CRITICAL(sr);
@@ -59,7 +129,10 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     /* Queue the event */
     ev->ev_queued = 1;
-    STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+#if OS_EVENTQ_LANES > 1
+    ev->ev_lane = lane;
+#endif
+    STAILQ_INSERT_TAIL(OS_EVENTQ_LIST(evq, lane), ev, ev_next);
 
     resched = 0;
     if (evq->evq_task) {
@@ -93,9 +166,8 @@ os_eventq_get_no_wait(struct os_eventq *evq)
 
     os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)evq);
 
-    ev = STAILQ_FIRST(&evq->evq_list);
+    ev = os_eventq_pull(evq);
     if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
         ev->ev_queued = 0;
     }
 
@@ -104,15 +176,15 @@ os_eventq_get_no_wait(struct os_eventq *evq)
     return ev;
 }
 
-struct os_event *
-os_eventq_get(struct os_eventq *evq)
+/*
+ * Makes the current task the owner of the event queue, if it has no owner
+ * yet, and returns the current task.
+ */
+static struct os_task *
+os_eventq_claim(struct os_eventq *evq)
 {
-    struct os_event *ev;
-    os_sr_t sr;
     struct os_task *t;
 
-    os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET, (uint32_t)evq);
-
     t = os_sched_get_current_task();
     if (evq->evq_owner != t) {
         if (evq->evq_owner == NULL) {
@@ -125,11 +197,24 @@ os_eventq_get(struct os_eventq *evq)
             assert(0);
         }
     }
+
+    return t;
+}
+
+struct os_event *
+os_eventq_get(struct os_eventq *evq)
+{
+    struct os_event *ev;
+    os_sr_t sr;
+    struct os_task *t;
+
+    os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET, (uint32_t)evq);
+
+    t = os_eventq_claim(evq);
     OS_ENTER_CRITICAL(sr);
 pull_one:
-    ev = STAILQ_FIRST(&evq->evq_list);
+    ev = os_eventq_pull(evq);
     if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
         ev->ev_queued = 0;
         t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
     } else {
@@ -162,29 +247,116 @@ os_eventq_run(struct os_eventq *evq)
     ev->ev_cb(ev);
 }
 
-static struct os_event *
-os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
 {
+    struct os_event *evs[MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)];
     struct os_event *ev;
+    struct os_task *t;
     os_sr_t sr;
+    int dispatched;
+    int cnt;
     int i;
 
-    os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_POLL_0TIMO, (uint32_t)evq[0],
-                   (uint32_t)nevqs);
+    assert(max > 0);
+    if (max > MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)) {
+        max = MYNEWT_VAL(OS_EVENTQ_BATCH_MAX);
+    }
 
-    ev = NULL;
+    t = os_eventq_claim(evq);
 
     OS_ENTER_CRITICAL(sr);
-    for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
-        if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
+    while (os_eventq_empty(evq)) {
+        evq->evq_task = t;
+        os_sched_sleep(t, OS_TIMEOUT_NEVER);
+        t->t_flags |= OS_TASK_FLAG_EVQ_WAIT;
+        OS_EXIT_CRITICAL(sr);
+
+        os_sched(NULL);
+
+        OS_ENTER_CRITICAL(sr);
+        evq->evq_task = NULL;
+    }
+    t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
+
+    cnt = 0;
+    while (cnt < max) {
+        ev = os_eventq_pull(evq);
+        if (ev == NULL) {
             break;
         }
+        ev->ev_queued = OS_EVENT_BATCHED;
+        evs[cnt++] = ev;
     }
     OS_EXIT_CRITICAL(sr);
 
+    dispatched = 0;
+    for (i = 0; i < cnt; i++) {
+        ev = evs[i];
+
+        /* Skip events removed (or removed and re-queued) by an earlier
+         * callback in this batch.
+         */
+        if (ev->ev_queued != OS_EVENT_BATCHED) {
+            continue;
+        }
+        ev->ev_queued = 0;
+
+        assert(ev->ev_cb != NULL);
+        ev->ev_cb(ev);
+        dispatched++;
+    }
+
+#if MYNEWT_VAL(OS_EVENTQ_BATCH_STATS)
+    evq->evq_batch_cnt++;
+    evq->evq_batch_ev_cnt += dispatched;
+    if (dispatched > evq->evq_batch_max) {
+        evq->evq_batch_max = dispatched;
+    }
+#endif
+
+    return dispatched;
+}
+
+/*
+ * Unlinks and returns the first event found on the given queues.  Lanes
+ * are searched in priority order, and within a lane, queues are searched
+ * in the order they are passed in the array.
+ */
+static struct os_event *
+os_eventq_poll_pull(struct os_eventq **evq, int nevqs)
+{
+    struct os_event *ev;
+    int lane;
+    int i;
+
+    for (lane = 0; lane < OS_EVENTQ_LANES; lane++) {
+        for (i = 0; i < nevqs; i++) {
+            ev = STAILQ_FIRST(OS_EVENTQ_LIST(evq[i], lane));
+            if (ev) {
+                STAILQ_REMOVE_HEAD(OS_EVENTQ_LIST(evq[i], lane), ev_next);
+                ev->ev_queued = 0;
+                return ev;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static struct os_event *
+os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
+{
+    struct os_event *ev;
+    os_sr_t sr;
+
+    os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_POLL_0TIMO, (uint32_t)evq[0],
+                   (uint32_t)nevqs);
+
+    OS_ENTER_CRITICAL(sr);
+    ev = os_eventq_poll_pull(evq, nevqs);
+    OS_EXIT_CRITICAL(sr);
+
     os_trace_api_ret_u32(OS_TRACE_ID_EVENTQ_POLL_0TIMO, (uint32_t)ev);
 
     return ev;
@@ -195,7 +367,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
 {
     struct os_event *ev;
     struct os_task *cur_t;
-    int i, j;
+    int i;
     os_sr_t sr;
 
     /* If the timeout is 0, don't involve the scheduler at all.  Grab an event
@@ -213,19 +385,12 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
     OS_ENTER_CRITICAL(sr);
     cur_t = os_sched_get_current_task();
 
+    ev = os_eventq_poll_pull(evq, nevqs);
+    if (ev) {
+        OS_EXIT_CRITICAL(sr);
+        goto has_event;
+    }
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
-        if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
-            /* Reset the items that already have an evq task set. */
-            for (j = 0; j < i; j++) {
-                evq[j]->evq_task = NULL;
-            }
-
-            OS_EXIT_CRITICAL(sr);
-            goto has_event;
-        }
         evq[i]->evq_task = cur_t;
     }
 
@@ -238,21 +403,13 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
 
     OS_ENTER_CRITICAL(sr);
     cur_t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
+    /* Clear the evq_task variable in every queue, given this task is no
+     * longer sleeping on the event queues.
+     */
     for (i = 0; i < nevqs; i++) {
-        /* Go through the entire loop to clear the evq_task variable,
-         * given this task is no longer sleeping on the event queues.
-         * Return the first event found, so only grab the event if
-         * we haven't found one.
-         */
-        if (!ev) {
-            ev = STAILQ_FIRST(&evq[i]->evq_list);
-            if (ev) {
-                STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-                ev->ev_queued = 0;
-            }
-        }
         evq[i]->evq_task = NULL;
     }
+    ev = os_eventq_poll_pull(evq, nevqs);
     OS_EXIT_CRITICAL(sr);
 
 has_event:
@@ -269,8 +426,9 @@ os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
     os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_REMOVE, (uint32_t)evq, (uint32_t)ev);
 
     OS_ENTER_CRITICAL(sr);
-    if (OS_EVENT_QUEUED(ev)) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
+    if (OS_EVENT_QUEUED(ev) && ev->ev_queued != OS_EVENT_BATCHED) {
+        STAILQ_REMOVE(OS_EVENTQ_LIST(evq, OS_EVENT_LANE(ev)), ev, os_event,
+                      ev_next);
     }
     ev->ev_queued = 0;
     OS_EXIT_CRITICAL(sr);
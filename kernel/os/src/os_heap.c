@@ -19,6 +19,17 @@
 
 #include <assert.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+#define os_heap_malloc      os_tlsf_malloc
+#define os_heap_free        os_tlsf_free
+#define os_heap_realloc     os_tlsf_realloc
+#else
+#define os_heap_malloc      malloc
+#define os_heap_free        free
+#define os_heap_realloc     realloc
+#endif
 
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
@@ -56,7 +67,7 @@ os_malloc(size_t size)
     void *ptr;
 
     os_malloc_lock();
-    ptr = malloc(size);
+    ptr = os_heap_malloc(size);
     os_malloc_unlock();
 
     return ptr;
@@ -66,7 +77,7 @@ void
 os_free(void *mem)
 {
     os_malloc_lock();
-    free(mem);
+    os_heap_free(mem);
     os_malloc_unlock();
 }
 
@@ -76,9 +87,31 @@ os_realloc(void *ptr, size_t size)
     void *new_ptr;
 
     os_malloc_lock();
-    new_ptr = realloc(ptr, size);
+    new_ptr = os_heap_realloc(ptr, size);
     os_malloc_unlock();
 
     return new_ptr;
 }
 
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+int
+os_heap_add_region(void *mem, size_t len)
+{
+    int rc;
+
+    os_malloc_lock();
+    rc = os_tlsf_add_region(mem, len);
+    os_malloc_unlock();
+
+    return rc;
+}
+
+void
+os_heap_stats_get(struct os_heap_stats *ohs)
+{
+    os_malloc_lock();
+    os_tlsf_stats(ohs);
+    os_malloc_unlock();
+}
+#endif
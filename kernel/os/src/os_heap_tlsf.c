@@ -0,0 +1,671 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+
+#include <assert.h>
+#include <string.h>
+#include "os_priv.h"
+
+/*
+ * Two-level segregated fit allocator.
+ *
+ * Free blocks are sorted into size classes: the first level splits sizes by
+ * power of two, the second level splits each power of two range into
+ * OS_TLSF_SL_COUNT equal parts.  A bitmap per level records which classes
+ * hold a free block, so finding a fit is a couple of bit scans rather than a
+ * list walk.
+ *
+ * Every block starts with a header holding the size of its payload; the two
+ * low bits of the size carry the free flags of the block and of its
+ * physical predecessor.  The header is preceded by a pointer to the
+ * previous physical block, which lives in the last word of the previous
+ * block's payload and is therefore only valid while that block is free.
+ * Free blocks additionally keep their free list links in the payload.
+ */
+
+#define OS_TLSF_ALIGN           sizeof(size_t)
+#define OS_TLSF_ALIGN_LOG2      (sizeof(size_t) == 8 ? 3 : 2)
+
+#define OS_TLSF_SL_LOG2         4
+#define OS_TLSF_SL_COUNT        (1 << OS_TLSF_SL_LOG2)
+#define OS_TLSF_FL_SHIFT        (OS_TLSF_SL_LOG2 + OS_TLSF_ALIGN_LOG2)
+#define OS_TLSF_FL_MAX          MYNEWT_VAL(OS_HEAP_TLSF_FL_MAX)
+#define OS_TLSF_FL_COUNT        (OS_TLSF_FL_MAX - OS_TLSF_FL_SHIFT + 1)
+#define OS_TLSF_SMALL_BLOCK     (1 << OS_TLSF_FL_SHIFT)
+
+#define OS_TLSF_F_FREE          0x1
+#define OS_TLSF_F_PREV_FREE     0x2
+
+struct os_tlsf_block {
+    /* Previous physical block; only valid if that block is free. */
+    struct os_tlsf_block *prev_phys;
+    /* Payload size in bytes, ORed with OS_TLSF_F_* flags. */
+    size_t size;
+    /* Free list links; only valid if this block is free. */
+    struct os_tlsf_block *next_free;
+    struct os_tlsf_block *prev_free;
+};
+
+/* Bytes an allocated block costs on top of its payload. */
+#define OS_TLSF_OVERHEAD        sizeof(size_t)
+/* Offset of the payload from the start of the block. */
+#define OS_TLSF_DATA_OFF        offsetof(struct os_tlsf_block, next_free)
+
+#define OS_TLSF_BLOCK_MIN \
+    (sizeof(struct os_tlsf_block) - sizeof(struct os_tlsf_block *))
+#define OS_TLSF_BLOCK_MAX       ((size_t)1 << OS_TLSF_FL_MAX)
+
+struct os_tlsf {
+    /* Terminates every free list; its links point to itself. */
+    struct os_tlsf_block null_block;
+
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[OS_TLSF_FL_COUNT];
+    struct os_tlsf_block *blocks[OS_TLSF_FL_COUNT][OS_TLSF_SL_COUNT];
+
+    uint32_t total;
+    uint32_t used;
+    uint32_t used_max;
+    uint32_t alloc_fail;
+    uint8_t initialized;
+};
+
+static struct os_tlsf os_tlsf;
+
+#if MYNEWT_VAL(OS_HEAP_TLSF_SIZE) > 0
+static os_membuf_t os_tlsf_mem[OS_MEMPOOL_SIZE(1,
+                                 MYNEWT_VAL(OS_HEAP_TLSF_SIZE))];
+#endif
+
+static inline int
+os_tlsf_fls(size_t word)
+{
+    return (int)(sizeof(unsigned long) * 8) - 1 -
+           __builtin_clzl((unsigned long)word);
+}
+
+static inline int
+os_tlsf_ffs(uint32_t word)
+{
+    return __builtin_ctz(word);
+}
+
+static inline size_t
+os_tlsf_align_up(size_t x)
+{
+    return (x + (OS_TLSF_ALIGN - 1)) & ~(OS_TLSF_ALIGN - 1);
+}
+
+static inline size_t
+os_tlsf_block_size(const struct os_tlsf_block *block)
+{
+    return block->size & ~(size_t)(OS_TLSF_F_FREE | OS_TLSF_F_PREV_FREE);
+}
+
+static inline void
+os_tlsf_block_set_size(struct os_tlsf_block *block, size_t size)
+{
+    block->size = size |
+                  (block->size & (OS_TLSF_F_FREE | OS_TLSF_F_PREV_FREE));
+}
+
+static inline int
+os_tlsf_block_is_free(const struct os_tlsf_block *block)
+{
+    return block->size & OS_TLSF_F_FREE;
+}
+
+static inline int
+os_tlsf_block_is_prev_free(const struct os_tlsf_block *block)
+{
+    return block->size & OS_TLSF_F_PREV_FREE;
+}
+
+static inline void *
+os_tlsf_block_to_ptr(struct os_tlsf_block *block)
+{
+    return (uint8_t *)block + OS_TLSF_DATA_OFF;
+}
+
+static inline struct os_tlsf_block *
+os_tlsf_ptr_to_block(void *ptr)
+{
+    return (struct os_tlsf_block *)((uint8_t *)ptr - OS_TLSF_DATA_OFF);
+}
+
+static inline struct os_tlsf_block *
+os_tlsf_block_next(struct os_tlsf_block *block)
+{
+    return (struct os_tlsf_block *)((uint8_t *)os_tlsf_block_to_ptr(block) +
+                                    os_tlsf_block_size(block) -
+                                    OS_TLSF_OVERHEAD);
+}
+
+/*
+ * Makes the next physical block point back at this one and returns it.
+ */
+static inline struct os_tlsf_block *
+os_tlsf_block_link_next(struct os_tlsf_block *block)
+{
+    struct os_tlsf_block *next;
+
+    next = os_tlsf_block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static void
+os_tlsf_block_mark_free(struct os_tlsf_block *block)
+{
+    struct os_tlsf_block *next;
+
+    next = os_tlsf_block_link_next(block);
+    next->size |= OS_TLSF_F_PREV_FREE;
+    block->size |= OS_TLSF_F_FREE;
+}
+
+static void
+os_tlsf_block_mark_used(struct os_tlsf_block *block)
+{
+    struct os_tlsf_block *next;
+
+    next = os_tlsf_block_next(block);
+    next->size &= ~(size_t)OS_TLSF_F_PREV_FREE;
+    block->size &= ~(size_t)OS_TLSF_F_FREE;
+}
+
+/*
+ * Maps a block size to the free list that holds blocks of that size.
+ */
+static void
+os_tlsf_mapping_insert(size_t size, int *fli, int *sli)
+{
+    int fl;
+    int sl;
+
+    if (size < OS_TLSF_SMALL_BLOCK) {
+        fl = 0;
+        sl = size / (OS_TLSF_SMALL_BLOCK / OS_TLSF_SL_COUNT);
+    } else {
+        fl = os_tlsf_fls(size);
+        sl = (size >> (fl - OS_TLSF_SL_LOG2)) ^ (1 << OS_TLSF_SL_LOG2);
+        fl -= OS_TLSF_FL_SHIFT - 1;
+    }
+
+    *fli = fl;
+    *sli = sl;
+}
+
+/*
+ * Maps a request size to the first free list whose blocks are all large
+ * enough to satisfy it.
+ */
+static void
+os_tlsf_mapping_search(size_t size, int *fli, int *sli)
+{
+    if (size >= OS_TLSF_SMALL_BLOCK) {
+        size += ((size_t)1 << (os_tlsf_fls(size) - OS_TLSF_SL_LOG2)) - 1;
+    }
+    os_tlsf_mapping_insert(size, fli, sli);
+}
+
+static struct os_tlsf_block *
+os_tlsf_search_suitable(struct os_tlsf *t, int *fli, int *sli)
+{
+    uint32_t sl_map;
+    uint32_t fl_map;
+    int fl;
+
+    fl = *fli;
+    sl_map = t->sl_bitmap[fl] & (~0UL << *sli);
+    if (!sl_map) {
+        fl_map = t->fl_bitmap & (~0UL << (fl + 1));
+        if (!fl_map) {
+            return NULL;
+        }
+        fl = os_tlsf_ffs(fl_map);
+        *fli = fl;
+        sl_map = t->sl_bitmap[fl];
+    }
+    *sli = os_tlsf_ffs(sl_map);
+
+    return t->blocks[fl][*sli];
+}
+
+static void
+os_tlsf_remove_free(struct os_tlsf *t, struct os_tlsf_block *block,
+                    int fl, int sl)
+{
+    struct os_tlsf_block *prev;
+    struct os_tlsf_block *next;
+
+    prev = block->prev_free;
+    next = block->next_free;
+    next->prev_free = prev;
+    prev->next_free = next;
+
+    if (t->blocks[fl][sl] == block) {
+        t->blocks[fl][sl] = next;
+        if (next == &t->null_block) {
+            t->sl_bitmap[fl] &= ~(1UL << sl);
+            if (!t->sl_bitmap[fl]) {
+                t->fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+}
+
+static void
+os_tlsf_insert_free(struct os_tlsf *t, struct os_tlsf_block *block,
+                    int fl, int sl)
+{
+    struct os_tlsf_block *cur;
+
+    cur = t->blocks[fl][sl];
+    block->next_free = cur;
+    block->prev_free = &t->null_block;
+    cur->prev_free = block;
+
+    t->blocks[fl][sl] = block;
+    t->fl_bitmap |= 1UL << fl;
+    t->sl_bitmap[fl] |= 1UL << sl;
+}
+
+static void
+os_tlsf_block_remove(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    int fl;
+    int sl;
+
+    os_tlsf_mapping_insert(os_tlsf_block_size(block), &fl, &sl);
+    os_tlsf_remove_free(t, block, fl, sl);
+}
+
+static void
+os_tlsf_block_insert(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    int fl;
+    int sl;
+
+    os_tlsf_mapping_insert(os_tlsf_block_size(block), &fl, &sl);
+    os_tlsf_insert_free(t, block, fl, sl);
+}
+
+static inline int
+os_tlsf_block_can_split(struct os_tlsf_block *block, size_t size)
+{
+    return os_tlsf_block_size(block) >= sizeof(struct os_tlsf_block) + size;
+}
+
+/*
+ * Cuts the block down to size bytes and returns the free remainder.
+ */
+static struct os_tlsf_block *
+os_tlsf_block_split(struct os_tlsf_block *block, size_t size)
+{
+    struct os_tlsf_block *rem;
+    size_t rem_size;
+
+    rem = (struct os_tlsf_block *)((uint8_t *)os_tlsf_block_to_ptr(block) +
+                                   size - OS_TLSF_OVERHEAD);
+    rem_size = os_tlsf_block_size(block) - (size + OS_TLSF_OVERHEAD);
+    rem->size = rem_size;
+    os_tlsf_block_set_size(block, size);
+    os_tlsf_block_mark_free(rem);
+
+    return rem;
+}
+
+/*
+ * Folds block into its physical predecessor prev, which is returned.
+ */
+static struct os_tlsf_block *
+os_tlsf_block_absorb(struct os_tlsf_block *prev, struct os_tlsf_block *block)
+{
+    prev->size += os_tlsf_block_size(block) + OS_TLSF_OVERHEAD;
+    os_tlsf_block_link_next(prev);
+    return prev;
+}
+
+static struct os_tlsf_block *
+os_tlsf_merge_prev(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    struct os_tlsf_block *prev;
+
+    if (os_tlsf_block_is_prev_free(block)) {
+        prev = block->prev_phys;
+        os_tlsf_block_remove(t, prev);
+        block = os_tlsf_block_absorb(prev, block);
+    }
+    return block;
+}
+
+static struct os_tlsf_block *
+os_tlsf_merge_next(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    struct os_tlsf_block *next;
+
+    next = os_tlsf_block_next(block);
+    if (os_tlsf_block_is_free(next)) {
+        os_tlsf_block_remove(t, next);
+        block = os_tlsf_block_absorb(block, next);
+    }
+    return block;
+}
+
+/*
+ * Returns the tail of a free block beyond size bytes to the heap.
+ */
+static void
+os_tlsf_trim_free(struct os_tlsf *t, struct os_tlsf_block *block,
+                  size_t size)
+{
+    struct os_tlsf_block *rem;
+
+    if (os_tlsf_block_can_split(block, size)) {
+        rem = os_tlsf_block_split(block, size);
+        os_tlsf_block_link_next(block);
+        rem->size |= OS_TLSF_F_PREV_FREE;
+        os_tlsf_block_insert(t, rem);
+    }
+}
+
+/*
+ * Returns the tail of a used block beyond size bytes to the heap.
+ */
+static void
+os_tlsf_trim_used(struct os_tlsf *t, struct os_tlsf_block *block,
+                  size_t size)
+{
+    struct os_tlsf_block *rem;
+
+    if (os_tlsf_block_can_split(block, size)) {
+        rem = os_tlsf_block_split(block, size);
+        rem->size &= ~(size_t)OS_TLSF_F_PREV_FREE;
+        rem = os_tlsf_merge_next(t, rem);
+        os_tlsf_block_insert(t, rem);
+    }
+}
+
+static size_t
+os_tlsf_adjust_size(size_t size)
+{
+    size_t adj;
+
+    if (size == 0 || size >= OS_TLSF_BLOCK_MAX) {
+        return 0;
+    }
+    adj = os_tlsf_align_up(size);
+    if (adj < OS_TLSF_BLOCK_MIN) {
+        adj = OS_TLSF_BLOCK_MIN;
+    }
+    return adj;
+}
+
+static void
+os_tlsf_used_add(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    t->used += os_tlsf_block_size(block) + OS_TLSF_OVERHEAD;
+    if (t->used > t->used_max) {
+        t->used_max = t->used;
+    }
+}
+
+static void
+os_tlsf_used_sub(struct os_tlsf *t, struct os_tlsf_block *block)
+{
+    t->used -= os_tlsf_block_size(block) + OS_TLSF_OVERHEAD;
+}
+
+static int
+os_tlsf_add_pool(struct os_tlsf *t, void *mem, size_t len)
+{
+    struct os_tlsf_block *block;
+    struct os_tlsf_block *next;
+    uintptr_t start;
+    uintptr_t end;
+    size_t size;
+
+    start = os_tlsf_align_up((uintptr_t)mem);
+    end = ((uintptr_t)mem + len) & ~(uintptr_t)(OS_TLSF_ALIGN - 1);
+    if (end <= start || end - start < 2 * OS_TLSF_OVERHEAD) {
+        return OS_EINVAL;
+    }
+
+    /*
+     * The pool holds one free block followed by a zero sized, used sentinel
+     * block that stops merging past the end of the pool.  The first block's
+     * prev_phys field would lie before the pool, which is fine: the block
+     * is never marked as having a free predecessor, so it is never read.
+     */
+    size = end - start - 2 * OS_TLSF_OVERHEAD;
+    if (size < OS_TLSF_BLOCK_MIN) {
+        return OS_EINVAL;
+    }
+    if (size > OS_TLSF_BLOCK_MAX - OS_TLSF_ALIGN) {
+        size = OS_TLSF_BLOCK_MAX - OS_TLSF_ALIGN;
+    }
+
+    block = (struct os_tlsf_block *)(start - OS_TLSF_OVERHEAD);
+    block->size = size | OS_TLSF_F_FREE;
+    os_tlsf_block_insert(t, block);
+
+    next = os_tlsf_block_link_next(block);
+    next->size = OS_TLSF_F_PREV_FREE;
+
+    t->total += size + OS_TLSF_OVERHEAD;
+
+    /* Hand the rest of an oversized region over as further pools. */
+    start += size + 2 * OS_TLSF_OVERHEAD;
+    if (start < end) {
+        os_tlsf_add_pool(t, (void *)start, end - start);
+    }
+
+    return OS_OK;
+}
+
+static void
+os_tlsf_init(struct os_tlsf *t)
+{
+    int fl;
+    int sl;
+
+    t->null_block.next_free = &t->null_block;
+    t->null_block.prev_free = &t->null_block;
+    for (fl = 0; fl < OS_TLSF_FL_COUNT; fl++) {
+        for (sl = 0; sl < OS_TLSF_SL_COUNT; sl++) {
+            t->blocks[fl][sl] = &t->null_block;
+        }
+    }
+    t->initialized = 1;
+
+#if MYNEWT_VAL(OS_HEAP_TLSF_SIZE) > 0
+    os_tlsf_add_pool(t, os_tlsf_mem, sizeof(os_tlsf_mem));
+#endif
+}
+
+static inline struct os_tlsf *
+os_tlsf_get(void)
+{
+    if (!os_tlsf.initialized) {
+        os_tlsf_init(&os_tlsf);
+    }
+    return &os_tlsf;
+}
+
+void *
+os_tlsf_malloc(size_t size)
+{
+    struct os_tlsf_block *block;
+    struct os_tlsf *t;
+    size_t adj;
+    int fl;
+    int sl;
+
+    t = os_tlsf_get();
+
+    adj = os_tlsf_adjust_size(size);
+    if (adj == 0) {
+        goto err;
+    }
+
+    os_tlsf_mapping_search(adj, &fl, &sl);
+    if (fl >= OS_TLSF_FL_COUNT) {
+        goto err;
+    }
+    block = os_tlsf_search_suitable(t, &fl, &sl);
+    if (block == NULL) {
+        goto err;
+    }
+    os_tlsf_remove_free(t, block, fl, sl);
+
+    os_tlsf_trim_free(t, block, adj);
+    os_tlsf_block_mark_used(block);
+    os_tlsf_used_add(t, block);
+
+    return os_tlsf_block_to_ptr(block);
+
+err:
+    if (size != 0) {
+        t->alloc_fail++;
+    }
+    return NULL;
+}
+
+void
+os_tlsf_free(void *ptr)
+{
+    struct os_tlsf_block *block;
+    struct os_tlsf *t;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    t = os_tlsf_get();
+    block = os_tlsf_ptr_to_block(ptr);
+    assert(!os_tlsf_block_is_free(block));
+
+    os_tlsf_used_sub(t, block);
+    os_tlsf_block_mark_free(block);
+    block = os_tlsf_merge_prev(t, block);
+    block = os_tlsf_merge_next(t, block);
+    os_tlsf_block_insert(t, block);
+}
+
+void *
+os_tlsf_realloc(void *ptr, size_t size)
+{
+    struct os_tlsf_block *block;
+    struct os_tlsf_block *next;
+    struct os_tlsf *t;
+    size_t cur;
+    size_t adj;
+    void *p;
+
+    if (ptr == NULL) {
+        return os_tlsf_malloc(size);
+    }
+    if (size == 0) {
+        os_tlsf_free(ptr);
+        return NULL;
+    }
+
+    t = os_tlsf_get();
+    block = os_tlsf_ptr_to_block(ptr);
+    next = os_tlsf_block_next(block);
+    cur = os_tlsf_block_size(block);
+
+    adj = os_tlsf_adjust_size(size);
+    if (adj == 0) {
+        t->alloc_fail++;
+        return NULL;
+    }
+
+    if (adj > cur && (!os_tlsf_block_is_free(next) ||
+                      adj > cur + os_tlsf_block_size(next) +
+                            OS_TLSF_OVERHEAD)) {
+        /* Cannot grow in place; move the data. */
+        p = os_tlsf_malloc(size);
+        if (p != NULL) {
+            memcpy(p, ptr, cur < size ? cur : size);
+            os_tlsf_free(ptr);
+        }
+        return p;
+    }
+
+    os_tlsf_used_sub(t, block);
+    if (adj > cur) {
+        block = os_tlsf_merge_next(t, block);
+        os_tlsf_block_mark_used(block);
+    }
+    os_tlsf_trim_used(t, block, adj);
+    os_tlsf_used_add(t, block);
+
+    return ptr;
+}
+
+int
+os_tlsf_add_region(void *mem, size_t len)
+{
+    return os_tlsf_add_pool(os_tlsf_get(), mem, len);
+}
+
+void
+os_tlsf_stats(struct os_heap_stats *ohs)
+{
+    struct os_tlsf_block *block;
+    struct os_tlsf *t;
+    uint32_t largest;
+    size_t size;
+    int fl;
+    int sl;
+
+    t = os_tlsf_get();
+
+    /*
+     * The largest free block sits in the highest populated size class.  A
+     * class spans sizes within 1/16th of each other, so walking just that
+     * one list finds it.
+     */
+    largest = 0;
+    if (t->fl_bitmap) {
+        fl = os_tlsf_fls(t->fl_bitmap);
+        sl = os_tlsf_fls(t->sl_bitmap[fl]);
+        for (block = t->blocks[fl][sl]; block != &t->null_block;
+             block = block->next_free) {
+            size = os_tlsf_block_size(block);
+            if (size > largest) {
+                largest = size;
+            }
+        }
+    }
+
+    ohs->ohs_total = t->total;
+    ohs->ohs_used = t->used;
+    ohs->ohs_used_max = t->used_max;
+    ohs->ohs_free = t->total - t->used;
+    ohs->ohs_free_block_max = largest;
+    ohs->ohs_alloc_fail = t->alloc_fail;
+}
+
+#endif
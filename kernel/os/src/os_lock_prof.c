@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_LOCK_PROF)
+
+#include "os_priv.h"
+
+static STAILQ_HEAD(, os_lock_prof) os_lock_prof_list =
+    STAILQ_HEAD_INITIALIZER(os_lock_prof_list);
+
+static void
+os_lock_prof_clear(struct os_lock_prof *olp)
+{
+    olp->olp_acquired = 0;
+    olp->olp_contended = 0;
+    olp->olp_timeouts = 0;
+    olp->olp_wait_max = 0;
+    olp->olp_wait_total = 0;
+    olp->olp_hold_max = 0;
+    olp->olp_hold_max_task = NULL;
+}
+
+static void
+os_lock_prof_insert(struct os_lock_prof *olp, const char *name)
+{
+    struct os_lock_prof *cur;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    olp->olp_name = name;
+    STAILQ_FOREACH(cur, &os_lock_prof_list, olp_next) {
+        if (cur == olp) {
+            break;
+        }
+    }
+    if (cur == NULL) {
+        os_lock_prof_clear(olp);
+        olp->olp_hold_start = 0;
+        STAILQ_INSERT_TAIL(&os_lock_prof_list, olp, olp_next);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+os_mutex_prof_register(struct os_mutex *mu, struct os_lock_prof *olp,
+                       const char *name)
+{
+    if (mu == NULL || olp == NULL || name == NULL) {
+        return OS_INVALID_PARM;
+    }
+
+    os_lock_prof_insert(olp, name);
+    mu->mu_prof = olp;
+
+    return 0;
+}
+
+int
+os_sem_prof_register(struct os_sem *sem, struct os_lock_prof *olp,
+                     const char *name)
+{
+    if (sem == NULL || olp == NULL || name == NULL) {
+        return OS_INVALID_PARM;
+    }
+
+    os_lock_prof_insert(olp, name);
+    sem->sem_prof = olp;
+
+    return 0;
+}
+
+struct os_lock_prof *
+os_lock_prof_next(struct os_lock_prof *prev)
+{
+    if (prev == NULL) {
+        return STAILQ_FIRST(&os_lock_prof_list);
+    }
+    return STAILQ_NEXT(prev, olp_next);
+}
+
+void
+os_lock_prof_reset(void)
+{
+    struct os_lock_prof *olp;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_FOREACH(olp, &os_lock_prof_list, olp_next) {
+        os_lock_prof_clear(olp);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * The hooks below are called by the mutex and semaphore code with
+ * interrupts disabled.
+ */
+
+void
+os_lock_prof_acquired(struct os_lock_prof *olp)
+{
+    olp->olp_acquired++;
+    olp->olp_hold_start = os_cputime_get32();
+}
+
+void
+os_lock_prof_waited(struct os_lock_prof *olp, uint32_t wait_start,
+                    int acquired)
+{
+    uint32_t wait;
+
+    wait = os_cputime_get32() - wait_start;
+    olp->olp_contended++;
+    olp->olp_wait_total += wait;
+    if (wait > olp->olp_wait_max) {
+        olp->olp_wait_max = wait;
+    }
+    if (acquired) {
+        olp->olp_acquired++;
+    } else {
+        olp->olp_timeouts++;
+    }
+}
+
+void
+os_lock_prof_released(struct os_lock_prof *olp, struct os_task *owner)
+{
+    uint32_t now;
+    uint32_t hold;
+
+    now = os_cputime_get32();
+    hold = now - olp->olp_hold_start;
+    if (hold > olp->olp_hold_max) {
+        olp->olp_hold_max = hold;
+        olp->olp_hold_max_task = owner->t_name;
+    }
+
+    /* A waiter, if any, owns the mutex from here on. */
+    olp->olp_hold_start = now;
+}
+
+#endif
@@ -120,24 +120,162 @@ err:
     return (rc);
 }
 
+/*
+ * Keeps the compiler from reordering ring accesses across index updates.
+ * The producer and consumer of a ring mqueue run on the same core, so
+ * this is all that is needed for the other side to see entries in order.
+ */
+#define OS_MQUEUE_RING_BARRIER()    __asm__ volatile("" ::: "memory")
+
+int
+os_mqueue_ring_init(struct os_mqueue_ring *mqr, struct os_mbuf **buf,
+                    uint16_t cnt, os_event_fn *ev_cb, void *arg)
+{
+    struct os_event *ev;
+
+    if (cnt == 0 || cnt > 0x8000 || (cnt & (cnt - 1)) != 0) {
+        return OS_EINVAL;
+    }
+
+    mqr->mqr_buf = buf;
+    mqr->mqr_mask = cnt - 1;
+    mqr->mqr_head = 0;
+    mqr->mqr_tail = 0;
+
+    ev = &mqr->mqr_ev;
+    memset(ev, 0, sizeof(*ev));
+    ev->ev_cb = ev_cb;
+    ev->ev_arg = arg;
+
+    return (0);
+}
+
+int
+os_mqueue_ring_put(struct os_mqueue_ring *mqr, struct os_eventq *evq,
+                   struct os_mbuf *m)
+{
+    uint16_t head;
+
+    head = mqr->mqr_head;
+    if ((uint16_t)(head - mqr->mqr_tail) > mqr->mqr_mask) {
+        return OS_ENOMEM;
+    }
+
+    mqr->mqr_buf[head & mqr->mqr_mask] = m;
+    OS_MQUEUE_RING_BARRIER();
+    mqr->mqr_head = head + 1;
+    OS_MQUEUE_RING_BARRIER();
+
+    /*
+     * Only post on the empty to non-empty transition.  The tail is read
+     * after the new head is published: if the consumer has already caught
+     * up to 'head' it has seen the ring empty and needs a new event;
+     * otherwise it is still draining and will find this entry.
+     */
+    if (evq && mqr->mqr_tail == head) {
+        os_eventq_put(evq, &mqr->mqr_ev);
+    }
+
+    return (0);
+}
+
+struct os_mbuf *
+os_mqueue_ring_get(struct os_mqueue_ring *mqr)
+{
+    struct os_mbuf *m;
+    uint16_t tail;
+
+    tail = mqr->mqr_tail;
+    if (tail == mqr->mqr_head) {
+        return (NULL);
+    }
+
+    OS_MQUEUE_RING_BARRIER();
+    m = mqr->mqr_buf[tail & mqr->mqr_mask];
+    OS_MQUEUE_RING_BARRIER();
+    mqr->mqr_tail = tail + 1;
+
+    return (m);
+}
+
+#if MYNEWT_VAL(OS_MSYS_STATS)
+static struct os_msys_stats os_msys_stats;
+
+static void
+os_msys_stats_record(uint16_t dsize, struct os_mbuf_pool *best,
+                     struct os_mbuf_pool *used)
+{
+    int bucket;
+
+    bucket = 0;
+    if (dsize >= 16) {
+        bucket = 31 - __builtin_clz(dsize) - 3;
+        if (bucket >= OS_MSYS_HIST_BUCKETS) {
+            bucket = OS_MSYS_HIST_BUCKETS - 1;
+        }
+    }
+    os_msys_stats.oms_hist[bucket]++;
+    if (dsize > os_msys_stats.oms_size_max) {
+        os_msys_stats.oms_size_max = dsize;
+    }
+
+    best->omp_msys_req++;
+    if (used == NULL) {
+        best->omp_msys_fail++;
+    } else if (used != best) {
+        best->omp_msys_fallback++;
+    }
+}
+
+void
+os_msys_stats_get(struct os_msys_stats *oms)
+{
+    *oms = os_msys_stats;
+}
+
+void
+os_msys_stats_reset(void)
+{
+    struct os_mbuf_pool *pool;
+
+    memset(&os_msys_stats, 0, sizeof os_msys_stats);
+    STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
+        pool->omp_msys_req = 0;
+        pool->omp_msys_fallback = 0;
+        pool->omp_msys_fail = 0;
+    }
+}
+#else
+#define os_msys_stats_record(dsize, best, used)
+#endif
+
 int
 os_msys_register(struct os_mbuf_pool *new_pool)
 {
+    struct os_mbuf_pool *prev;
     struct os_mbuf_pool *pool;
 
-    pool = NULL;
+    /* Keep the list sorted by increasing buffer size. */
+    prev = NULL;
     STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
-        if (new_pool->omp_databuf_len > pool->omp_databuf_len) {
+        if (new_pool->omp_databuf_len < pool->omp_databuf_len) {
             break;
         }
+        prev = pool;
     }
 
-    if (pool) {
-        STAILQ_INSERT_AFTER(&g_msys_pool_list, pool, new_pool, omp_next);
+    if (prev) {
+        STAILQ_INSERT_AFTER(&g_msys_pool_list, prev, new_pool, omp_next);
     } else {
-        STAILQ_INSERT_TAIL(&g_msys_pool_list, new_pool, omp_next);
+        STAILQ_INSERT_HEAD(&g_msys_pool_list, new_pool, omp_next);
     }
 
+#if MYNEWT_VAL(OS_MSYS_STATS)
+    new_pool->omp_msys_req = 0;
+    new_pool->omp_msys_fallback = 0;
+    new_pool->omp_msys_fail = 0;
+#endif
+
     return (0);
 }
 
@@ -147,6 +285,15 @@ os_msys_reset(void)
     STAILQ_INIT(&g_msys_pool_list);
 }
 
+struct os_mbuf_pool *
+os_msys_pool_next(struct os_mbuf_pool *omp)
+{
+    if (omp == NULL) {
+        return STAILQ_FIRST(&g_msys_pool_list);
+    }
+    return STAILQ_NEXT(omp, omp_next);
+}
+
 static struct os_mbuf_pool *
 _os_msys_find_pool(uint16_t dsize)
 {
@@ -171,14 +318,22 @@ struct os_mbuf *
 os_msys_get(uint16_t dsize, uint16_t leadingspace)
 {
     struct os_mbuf *m;
+    struct os_mbuf_pool *best;
     struct os_mbuf_pool *pool;
 
-    pool = _os_msys_find_pool(dsize);
-    if (!pool) {
+    best = _os_msys_find_pool(dsize);
+    if (!best) {
         goto err;
     }
 
-    m = os_mbuf_get(pool, leadingspace);
+    for (pool = best; pool != NULL; pool = STAILQ_NEXT(pool, omp_next)) {
+        m = os_mbuf_get(pool, leadingspace);
+        if (m != NULL || !MYNEWT_VAL(OS_MSYS_FALLBACK)) {
+            break;
+        }
+    }
+
+    os_msys_stats_record(dsize, best, m != NULL ? pool : NULL);
     return (m);
 err:
     return (NULL);
@@ -189,15 +344,24 @@ os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
 {
     uint16_t total_pkthdr_len;
     struct os_mbuf *m;
+    struct os_mbuf_pool *best;
     struct os_mbuf_pool *pool;
 
     total_pkthdr_len =  user_hdr_len + sizeof(struct os_mbuf_pkthdr);
-    pool = _os_msys_find_pool(dsize + total_pkthdr_len);
-    if (!pool) {
+    best = _os_msys_find_pool(dsize + total_pkthdr_len);
+    if (!best) {
         goto err;
     }
 
-    m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+    for (pool = best; pool != NULL; pool = STAILQ_NEXT(pool, omp_next)) {
+        m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+        if (m != NULL || !MYNEWT_VAL(OS_MSYS_FALLBACK)) {
+            break;
+        }
+    }
+
+    os_msys_stats_record(dsize + total_pkthdr_len, best,
+                         m != NULL ? pool : NULL);
     return (m);
 err:
     return (NULL);
@@ -266,12 +430,86 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
     om->om_len = 0;
     om->om_data = (&om->om_databuf[0] + leadingspace);
     om->om_omp = omp;
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    om->om_refcnt = 1;
+    om->om_shared = NULL;
+#endif
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MBUF_GET, (uint32_t)om);
     return om;
 }
 
+/*
+ * An external data mbuf keeps its os_mbuf_ext pointer in the last word of its
+ * data buffer, where it stays clear of a packet header at the front.
+ */
+static inline struct os_mbuf_ext **
+os_mbuf_ext_slot(const struct os_mbuf *om)
+{
+    uint16_t off;
+
+    off = (om->om_omp->omp_databuf_len - sizeof(struct os_mbuf_ext *)) &
+          ~(sizeof(struct os_mbuf_ext *) - 1);
+
+    return (struct os_mbuf_ext **)((uintptr_t)om->om_databuf + off);
+}
+
+static void
+os_mbuf_ext_attach(struct os_mbuf *om, struct os_mbuf_ext *ome,
+                   uint8_t *data, uint16_t len)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ome->ome_refcnt++;
+    OS_EXIT_CRITICAL(sr);
+
+    *os_mbuf_ext_slot(om) = ome;
+    om->om_flags |= OS_MBUF_F_EXT;
+    om->om_data = data;
+    om->om_len = len;
+}
+
+static void
+os_mbuf_ext_release(struct os_mbuf *om)
+{
+    struct os_mbuf_ext *ome;
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    ome = *os_mbuf_ext_slot(om);
+
+    OS_ENTER_CRITICAL(sr);
+    refcnt = --ome->ome_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt == 0 && ome->ome_free_cb != NULL) {
+        ome->ome_free_cb(ome);
+    }
+}
+
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, struct os_mbuf_ext *ome,
+                uint16_t off, uint16_t len)
+{
+    struct os_mbuf *om;
+
+    if (off > ome->ome_len || len > ome->ome_len - off) {
+        return NULL;
+    }
+    if (omp->omp_databuf_len < sizeof(struct os_mbuf_ext *)) {
+        return NULL;
+    }
+
+    om = os_mbuf_get(omp, 0);
+    if (om != NULL) {
+        os_mbuf_ext_attach(om, ome, ome->ome_buf + off, len);
+    }
+
+    return om;
+}
+
 struct os_mbuf *
 os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 {
@@ -305,15 +543,111 @@ done:
     return om;
 }
 
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+static void
+os_mbuf_hold(struct os_mbuf *om)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    om->om_refcnt++;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Drops a hold on an mbuf's pool block, and returns the block to its pool
+ * once no holds remain.
+ */
+static int
+os_mbuf_release(struct os_mbuf *om)
+{
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    refcnt = --om->om_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt != 0) {
+        return 0;
+    }
+    return os_memblock_put(om->om_omp->omp_pool, om);
+}
+
+/*
+ * Number of mbufs whose data lives in the same buffer as this mbuf's.
+ */
+static uint16_t
+os_mbuf_data_users(const struct os_mbuf *om)
+{
+    const struct os_mbuf *owner;
+
+    owner = om->om_shared != NULL ? om->om_shared : om;
+
+    /* The owner's hold on itself only counts if it still uses its data. */
+    return owner->om_refcnt - (owner->om_shared != NULL);
+}
+
+/*
+ * Gives an mbuf a private copy of its data if other mbufs use it too.
+ */
+static int
+os_mbuf_unshare(struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+    struct os_mbuf *copy;
+    int rc;
+
+    if (os_mbuf_data_users(om) <= 1) {
+        return 0;
+    }
+
+    owner = om->om_shared != NULL ? om->om_shared : om;
+
+    /* The copy only serves as data buffer; its hold belongs to om. */
+    copy = os_mbuf_get(owner->om_omp, 0);
+    if (copy == NULL) {
+        return SYS_ENOMEM;
+    }
+    memcpy(copy->om_databuf, om->om_data, om->om_len);
+
+    om->om_data = copy->om_databuf;
+    om->om_shared = copy;
+
+    rc = 0;
+    if (owner != om) {
+        rc = os_mbuf_release(owner);
+    }
+    return rc;
+}
+#endif
+
 int
 os_mbuf_free(struct os_mbuf *om)
 {
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    struct os_mbuf *owner;
+#endif
     int rc;
 
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
+    if (OS_MBUF_IS_EXT(om)) {
+        os_mbuf_ext_release(om);
+    }
+
     if (om->om_omp != NULL) {
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+        owner = om->om_shared;
+        om->om_shared = NULL;
+
+        rc = os_mbuf_release(om);
+        if (rc == 0 && owner != NULL) {
+            rc = os_mbuf_release(owner);
+        }
+#else
         rc = os_memblock_put(om->om_omp->omp_pool, om);
+#endif
         if (rc != 0) {
             goto done;
         }
@@ -487,9 +821,62 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
     return 0;
 }
 
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+struct os_mbuf *
+os_mbuf_share(struct os_mbuf *om, struct os_mbuf_pool *hdr_omp)
+{
+    struct os_mbuf *owner;
+    struct os_mbuf *head;
+    struct os_mbuf *copy;
+    struct os_mbuf *prev;
+
+    if (om->om_pkthdr_len > hdr_omp->omp_databuf_len) {
+        return NULL;
+    }
+
+    head = NULL;
+    prev = NULL;
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        copy = os_mbuf_get(hdr_omp, 0);
+        if (copy == NULL) {
+            os_mbuf_free_chain(head);
+            return NULL;
+        }
+
+        if (prev != NULL) {
+            SLIST_NEXT(prev, om_next) = copy;
+        } else {
+            head = copy;
+            if (OS_MBUF_IS_PKTHDR(om)) {
+                _os_mbuf_copypkthdr(head, om);
+            }
+        }
+        prev = copy;
+
+        if (OS_MBUF_IS_EXT(om)) {
+            os_mbuf_ext_attach(copy, *os_mbuf_ext_slot(om), om->om_data,
+                               om->om_len);
+            continue;
+        }
+
+        owner = om->om_shared != NULL ? om->om_shared : om;
+        os_mbuf_hold(owner);
+        copy->om_shared = owner;
+        copy->om_data = om->om_data;
+        copy->om_len = om->om_len;
+    }
+
+    return head;
+}
+#endif
+
 struct os_mbuf *
 os_mbuf_dup(struct os_mbuf *om)
 {
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    return os_mbuf_share(om, om->om_omp);
+#else
     struct os_mbuf_pool *omp;
     struct os_mbuf *head;
     struct os_mbuf *copy;
@@ -520,6 +907,12 @@ os_mbuf_dup(struct os_mbuf *om)
             }
             copy = head;
         }
+        if (OS_MBUF_IS_EXT(om)) {
+            /* Share the external buffer rather than copying it. */
+            os_mbuf_ext_attach(copy, *os_mbuf_ext_slot(om), om->om_data,
+                               om->om_len);
+            continue;
+        }
         copy->om_flags = om->om_flags;
         copy->om_len = om->om_len;
         memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
@@ -529,6 +922,7 @@ os_mbuf_dup(struct os_mbuf *om)
     return (head);
 err:
     return (NULL);
+#endif
 }
 
 struct os_mbuf *
@@ -559,6 +953,64 @@ os_mbuf_off(const struct os_mbuf *om, int off, uint16_t *out_off)
     }
 }
 
+const void *
+os_mbuf_peek(const struct os_mbuf *om, int off, int len, void *scratch)
+{
+    struct os_mbuf *cur;
+    uint16_t cur_off;
+
+    cur = os_mbuf_off(om, off, &cur_off);
+    if (cur == NULL) {
+        return NULL;
+    }
+
+    if (cur_off + len <= cur->om_len) {
+        return cur->om_data + cur_off;
+    }
+
+    if (scratch == NULL || os_mbuf_copydata(cur, cur_off, len, scratch)) {
+        return NULL;
+    }
+
+    return scratch;
+}
+
+int
+os_mbuf_iovec(const struct os_mbuf *om, int off, int len,
+              struct os_iovec *iov, int iov_cnt)
+{
+    struct os_mbuf *cur;
+    uint16_t cur_off;
+    int count;
+    int cnt;
+
+    cur = os_mbuf_off(om, off, &cur_off);
+    if (cur == NULL) {
+        return SYS_EINVAL;
+    }
+
+    cnt = 0;
+    while (len > 0) {
+        if (cur == NULL) {
+            return SYS_EINVAL;
+        }
+        count = min(cur->om_len - cur_off, len);
+        if (count > 0) {
+            if (cnt == iov_cnt) {
+                return SYS_ENOMEM;
+            }
+            iov[cnt].iov_base = cur->om_data + cur_off;
+            iov[cnt].iov_len = count;
+            cnt++;
+            len -= count;
+        }
+        cur_off = 0;
+        cur = SLIST_NEXT(cur, om_next);
+    }
+
+    return cnt;
+}
+
 int
 os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
 {
@@ -853,6 +1305,12 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
     while (1) {
         copylen = min(cur->om_len - cur_off, len);
         if (copylen > 0) {
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+            rc = os_mbuf_unshare(cur);
+            if (rc != 0) {
+                return rc;
+            }
+#endif
             memcpy(cur->om_data + cur_off, sptr, copylen);
             sptr += copylen;
             len -= copylen;
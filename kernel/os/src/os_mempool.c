@@ -115,15 +115,52 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard_check(mp, start)
 #endif
 
+/**
+ * Puts every block of the pool on its free list.  With lazy init the list is
+ * left empty and os_memblock_get() carves blocks off the buffer instead.
+ */
+static void
+os_mempool_chain_blocks(struct os_mempool *mp)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+    mp->mp_num_lazy = mp->mp_num_blocks;
+    SLIST_FIRST(mp) = NULL;
+#else
+    struct os_memblock *block_ptr;
+    int true_block_size;
+    uint8_t *block_addr;
+    uint16_t blocks;
+
+    true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
+
+    os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
+    os_mempool_guard(mp, (void *)mp->mp_membuf_addr);
+    SLIST_FIRST(mp) = (void *)mp->mp_membuf_addr;
+
+    /* Chain the memory blocks to the free list */
+    block_addr = (uint8_t *)mp->mp_membuf_addr;
+    block_ptr = (struct os_memblock *)block_addr;
+    blocks = mp->mp_num_blocks;
+
+    while (blocks > 1) {
+        block_addr += true_block_size;
+        os_mempool_poison(mp, block_addr);
+        os_mempool_guard(mp, block_addr);
+        SLIST_NEXT(block_ptr, mb_next) = (struct os_memblock *)block_addr;
+        block_ptr = (struct os_memblock *)block_addr;
+        --blocks;
+    }
+
+    /* Last one in the list should be NULL */
+    SLIST_NEXT(block_ptr, mb_next) = NULL;
+#endif
+}
+
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
                          uint32_t block_size, void *membuf, char *name,
                          uint8_t flags)
 {
-    int true_block_size;
-    uint8_t *block_addr;
-    struct os_memblock *block_ptr;
-
     /* Check for valid parameters */
     if (!mp || (blocks < 0) || (block_size <= 0)) {
         return OS_INVALID_PARM;
@@ -150,26 +187,7 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
     mp->mp_num_blocks = blocks;
     mp->mp_membuf_addr = (uint32_t)membuf;
     mp->name = name;
-    os_mempool_poison(mp, membuf);
-    os_mempool_guard(mp, membuf);
-    SLIST_FIRST(mp) = membuf;
-
-    true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
-
-    /* Chain the memory blocks to the free list */
-    block_addr = (uint8_t *)membuf;
-    block_ptr = (struct os_memblock *)block_addr;
-    while (blocks > 1) {
-        block_addr += true_block_size;
-        os_mempool_poison(mp, block_addr);
-        os_mempool_guard(mp, block_addr);
-        SLIST_NEXT(block_ptr, mb_next) = (struct os_memblock *)block_addr;
-        block_ptr = (struct os_memblock *)block_addr;
-        --blocks;
-    }
-
-    /* Last one in the list should be NULL */
-    SLIST_NEXT(block_ptr, mb_next) = NULL;
+    os_mempool_chain_blocks(mp);
 
     STAILQ_INSERT_TAIL(&g_os_mempool_list, mp, mp_list);
 
@@ -183,6 +201,28 @@ os_mempool_init(struct os_mempool *mp, uint16_t blocks, uint32_t block_size,
     return os_mempool_init_internal(mp, blocks, block_size, membuf, name, 0);
 }
 
+os_error_t
+os_mempool_init_aligned(struct os_mempool *mp, uint16_t blocks,
+                        uint32_t block_size, void *membuf, char *name,
+                        uint32_t align)
+{
+    if (align < OS_ALIGNMENT || (align & (align - 1)) != 0) {
+        return OS_INVALID_PARM;
+    }
+
+    if (((uint32_t)membuf & (align - 1)) != 0) {
+        return OS_MEM_NOT_ALIGNED;
+    }
+
+    /*
+     * Rounding the block size is enough: block n then starts at
+     * membuf + n * (aligned size), guard word included.
+     */
+    block_size = OS_MEMPOOL_ALIGNED_BLOCK_SZ(block_size, align);
+
+    return os_mempool_init_internal(mp, blocks, block_size, membuf, name, 0);
+}
+
 os_error_t
 os_mempool_ext_init(struct os_mempool_ext *mpe, uint16_t blocks,
                     uint32_t block_size, void *membuf, char *name)
@@ -242,40 +282,14 @@ os_mempool_unregister(struct os_mempool *mp)
 os_error_t
 os_mempool_clear(struct os_mempool *mp)
 {
-    struct os_memblock *block_ptr;
-    int true_block_size;
-    uint8_t *block_addr;
-    uint16_t blocks;
-
     if (!mp) {
         return OS_INVALID_PARM;
     }
 
-    true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
-
     /* cleanup the memory pool structure */
     mp->mp_num_free = mp->mp_num_blocks;
     mp->mp_min_free = mp->mp_num_blocks;
-    os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
-    os_mempool_guard(mp, (void *)mp->mp_membuf_addr);
-    SLIST_FIRST(mp) = (void *)mp->mp_membuf_addr;
-
-    /* Chain the memory blocks to the free list */
-    block_addr = (uint8_t *)mp->mp_membuf_addr;
-    block_ptr = (struct os_memblock *)block_addr;
-    blocks = mp->mp_num_blocks;
-
-    while (blocks > 1) {
-        block_addr += true_block_size;
-        os_mempool_poison(mp, block_addr);
-        os_mempool_guard(mp, block_addr);
-        SLIST_NEXT(block_ptr, mb_next) = (struct os_memblock *)block_addr;
-        block_ptr = (struct os_memblock *)block_addr;
-        --blocks;
-    }
-
-    /* Last one in the list should be NULL */
-    SLIST_NEXT(block_ptr, mb_next) = NULL;
+    os_mempool_chain_blocks(mp);
 
     return OS_OK;
 }
@@ -329,6 +343,11 @@ os_memblock_get(struct os_mempool *mp)
 {
     os_sr_t sr;
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+    bool fresh;
+
+    fresh = false;
+#endif
 
     os_trace_api_u32(OS_TRACE_ID_MEMBLOCK_GET, (uint32_t)mp);
 
@@ -338,11 +357,28 @@ os_memblock_get(struct os_mempool *mp)
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+            /*
+             * Reuse freed blocks first; only carve a new block off the
+             * buffer when there are none.
+             */
+            if (SLIST_EMPTY(mp)) {
+                block = (struct os_memblock *)(mp->mp_membuf_addr +
+                    (mp->mp_num_blocks - mp->mp_num_lazy) *
+                    OS_MEMPOOL_TRUE_BLOCK_SIZE(mp));
+                mp->mp_num_lazy--;
+                fresh = true;
+            } else {
+                block = SLIST_FIRST(mp);
+                SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
+            }
+#else
             /* Get a free block */
             block = SLIST_FIRST(mp);
 
             /* Set new free list head */
             SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
+#endif
 
             /* Decrement number free by 1 */
             mp->mp_num_free--;
@@ -352,6 +388,13 @@ os_memblock_get(struct os_mempool *mp)
         }
         OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+        if (fresh) {
+            /* Never used; lay down what the checks below expect. */
+            os_mempool_poison(mp, block);
+            os_mempool_guard(mp, block);
+        }
+#endif
         if (block) {
             os_mempool_poison_check(mp, block);
             os_mempool_guard_check(mp, block);
@@ -421,6 +464,12 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     SLIST_FOREACH(block, mp, mb_next) {
         assert(block != (struct os_memblock *)block_addr);
     }
+#if MYNEWT_VAL(OS_MEMPOOL_LAZY_INIT)
+    /* Blocks that were never handed out can't be freed either. */
+    assert((uint32_t)block_addr < mp->mp_membuf_addr +
+           (mp->mp_num_blocks - mp->mp_num_lazy) *
+           OS_MEMPOOL_TRUE_BLOCK_SIZE(mp));
+#endif
 #endif
     /* If this is an extended mempool with a put callback, call the callback
      * instead of freeing the block directly.
@@ -441,6 +490,72 @@ done:
     return ret;
 }
 
+void
+os_mempool_multi_init(struct os_mempool_multi *mpm)
+{
+    mpm->mpm_num_pools = 0;
+}
+
+os_error_t
+os_mempool_multi_register(struct os_mempool_multi *mpm,
+                          struct os_mempool *mp)
+{
+    int i;
+
+    if (mpm->mpm_num_pools >= MYNEWT_VAL(OS_MEMPOOL_MULTI_MAX_POOLS)) {
+        return OS_ENOMEM;
+    }
+
+    /* Keep the pools sorted by block size. */
+    for (i = mpm->mpm_num_pools; i > 0; i--) {
+        if (mpm->mpm_pools[i - 1]->mp_block_size <= mp->mp_block_size) {
+            break;
+        }
+        mpm->mpm_pools[i] = mpm->mpm_pools[i - 1];
+    }
+    mpm->mpm_pools[i] = mp;
+    mpm->mpm_num_pools++;
+
+    return OS_OK;
+}
+
+void *
+os_mempool_multi_get(struct os_mempool_multi *mpm, uint32_t size)
+{
+    struct os_mempool *mp;
+    void *block;
+    int i;
+
+    for (i = 0; i < mpm->mpm_num_pools; i++) {
+        mp = mpm->mpm_pools[i];
+        if (mp->mp_block_size < size) {
+            continue;
+        }
+        block = os_memblock_get(mp);
+        if (block != NULL) {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+os_error_t
+os_mempool_multi_put(struct os_mempool_multi *mpm, void *block_addr)
+{
+    struct os_mempool *mp;
+    int i;
+
+    for (i = 0; i < mpm->mpm_num_pools; i++) {
+        mp = mpm->mpm_pools[i];
+        if (os_memblock_from(mp, block_addr)) {
+            return os_memblock_put(mp, block_addr);
+        }
+    }
+
+    return OS_INVALID_PARM;
+}
+
 struct os_mempool *
 os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 {
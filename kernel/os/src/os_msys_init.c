@@ -22,24 +22,57 @@
 #include "mem/mem.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(MSYS_1_CORE_MEM) || MYNEWT_VAL(MSYS_2_CORE_MEM)
+#include "bsp/bsp.h"
+#ifndef sec_bss_core
+#error "MSYS_n_CORE_MEM needs a BSP that defines sec_bss_core"
+#endif
+#endif
+
 #if MYNEWT_VAL(MSYS_1_BLOCK_COUNT) > 0
+#if MYNEWT_VAL(MSYS_1_BLOCK_ALIGN) > 0
+#define SYSINIT_MSYS_1_ALIGN        MYNEWT_VAL(MSYS_1_BLOCK_ALIGN)
+#else
+#define SYSINIT_MSYS_1_ALIGN        OS_ALIGNMENT
+#endif
+#if MYNEWT_VAL(MSYS_1_CORE_MEM)
+#define SYSINIT_MSYS_1_SECTION      sec_bss_core
+#else
+#define SYSINIT_MSYS_1_SECTION
+#endif
 #define SYSINIT_MSYS_1_MEMBLOCK_SIZE                \
-    OS_ALIGN(MYNEWT_VAL(MSYS_1_BLOCK_SIZE), 4)
+    OS_MEMPOOL_ALIGNED_BLOCK_SZ(                    \
+        OS_ALIGN(MYNEWT_VAL(MSYS_1_BLOCK_SIZE), 4), \
+        SYSINIT_MSYS_1_ALIGN)
 #define SYSINIT_MSYS_1_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_1_BLOCK_COUNT),  \
                     SYSINIT_MSYS_1_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
+static os_membuf_t os_msys_init_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE]
+    __attribute__((aligned(SYSINIT_MSYS_1_ALIGN))) SYSINIT_MSYS_1_SECTION;
 static struct os_mbuf_pool os_msys_init_1_mbuf_pool;
 static struct os_mempool os_msys_init_1_mempool;
 #endif
 
 #if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
+#if MYNEWT_VAL(MSYS_2_BLOCK_ALIGN) > 0
+#define SYSINIT_MSYS_2_ALIGN        MYNEWT_VAL(MSYS_2_BLOCK_ALIGN)
+#else
+#define SYSINIT_MSYS_2_ALIGN        OS_ALIGNMENT
+#endif
+#if MYNEWT_VAL(MSYS_2_CORE_MEM)
+#define SYSINIT_MSYS_2_SECTION      sec_bss_core
+#else
+#define SYSINIT_MSYS_2_SECTION
+#endif
 #define SYSINIT_MSYS_2_MEMBLOCK_SIZE                \
-    OS_ALIGN(MYNEWT_VAL(MSYS_2_BLOCK_SIZE), 4)
+    OS_MEMPOOL_ALIGNED_BLOCK_SZ(                    \
+        OS_ALIGN(MYNEWT_VAL(MSYS_2_BLOCK_SIZE), 4), \
+        SYSINIT_MSYS_2_ALIGN)
 #define SYSINIT_MSYS_2_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_2_BLOCK_COUNT),  \
                     SYSINIT_MSYS_2_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
+static os_membuf_t os_msys_init_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE]
+    __attribute__((aligned(SYSINIT_MSYS_2_ALIGN))) SYSINIT_MSYS_2_SECTION;
 static struct os_mbuf_pool os_msys_init_2_mbuf_pool;
 static struct os_mempool os_msys_init_2_mempool;
 #endif
@@ -23,6 +23,7 @@
 #define OS_TRACE_DISABLE_FILE_API
 #endif
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 os_error_t
 os_mutex_init(struct os_mutex *mu)
@@ -40,6 +41,9 @@ os_mutex_init(struct os_mutex *mu)
     mu->mu_prio = 0;
     mu->mu_level = 0;
     mu->mu_owner = NULL;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    mu->mu_prof = NULL;
+#endif
     SLIST_FIRST(&mu->mu_head) = NULL;
 
     ret = OS_OK;
@@ -88,6 +92,12 @@ os_mutex_release(struct os_mutex *mu)
 
     OS_ENTER_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    if (mu->mu_prof) {
+        os_lock_prof_released(mu->mu_prof, current);
+    }
+#endif
+
     /* Restore owner task's priority; resort list if different  */
     if (current->t_prio != mu->mu_prio) {
         current->t_prio = mu->mu_prio;
@@ -141,6 +151,9 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
     struct os_task *current;
     struct os_task *entry;
     struct os_task *last;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    uint32_t wait_start;
+#endif
 
     os_trace_api_u32x2(OS_TRACE_ID_MUTEX_PEND, (uint32_t)mu, (uint32_t)timeout);
 
@@ -165,6 +178,11 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
         mu->mu_prio  = current->t_prio;
         current->t_lockcnt++;
         mu->mu_level = 1;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        if (mu->mu_prof) {
+            os_lock_prof_acquired(mu->mu_prof);
+        }
+#endif
         OS_EXIT_CRITICAL(sr);
         ret = OS_OK;
         goto done;
@@ -180,6 +198,11 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
 
     /* Mutex is not owned by us. If timeout is 0, return immediately */
     if (timeout == 0) {
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        if (mu->mu_prof) {
+            os_lock_prof_waited(mu->mu_prof, os_cputime_get32(), 0);
+        }
+#endif
         OS_EXIT_CRITICAL(sr);
         ret = OS_TIMEOUT;
         goto done;
@@ -212,6 +235,9 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
     /* Set mutex pointer in task */
     current->t_obj = mu;
     current->t_flags |= OS_TASK_FLAG_MUTEX_WAIT;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    wait_start = os_cputime_get32();
+#endif
     os_sched_sleep(current, timeout);
     OS_EXIT_CRITICAL(sr);
 
@@ -219,7 +245,6 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
 
     OS_ENTER_CRITICAL(sr);
     current->t_flags &= ~OS_TASK_FLAG_MUTEX_WAIT;
-    OS_EXIT_CRITICAL(sr);
 
     /* If we are owner we did not time out. */
     if (mu->mu_owner == current) {
@@ -227,6 +252,12 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
     } else {
         ret = OS_TIMEOUT;
     }
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    if (mu->mu_prof) {
+        os_lock_prof_waited(mu->mu_prof, wait_start, ret == OS_OK);
+    }
+#endif
+    OS_EXIT_CRITICAL(sr);
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MUTEX_PEND, (uint32_t)ret);
@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_PM)
+
+#include "hal/hal_os_tick.h"
+#include "os_priv.h"
+
+static SLIST_HEAD(, os_pm_state) os_pm_states =
+    SLIST_HEAD_INITIALIZER(os_pm_states);
+
+static os_time_t
+os_pm_us_to_ticks(uint32_t us)
+{
+    return ((uint64_t)us * OS_TICKS_PER_SEC + 999999) / 1000000;
+}
+
+int
+os_pm_state_register(struct os_pm_state *ps)
+{
+    struct os_pm_state *cur;
+    struct os_pm_state *prev;
+    os_sr_t sr;
+
+    if (ps == NULL || ps->ops_enter == NULL) {
+        return OS_INVALID_PARM;
+    }
+
+    ps->ops_exit_ticks = os_pm_us_to_ticks(ps->ops_exit_us);
+    ps->ops_min_ticks = os_pm_us_to_ticks(ps->ops_entry_us +
+                                          ps->ops_exit_us +
+                                          ps->ops_min_residency_us);
+    ps->ops_enter_cnt = 0;
+    ps->ops_dev_fail_cnt = 0;
+    ps->ops_residency_ticks = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    prev = NULL;
+    SLIST_FOREACH(cur, &os_pm_states, ops_next) {
+        if (cur->ops_min_ticks > ps->ops_min_ticks) {
+            break;
+        }
+        prev = cur;
+    }
+    if (prev) {
+        SLIST_INSERT_AFTER(prev, ps, ops_next);
+    } else {
+        SLIST_INSERT_HEAD(&os_pm_states, ps, ops_next);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+struct os_pm_state *
+os_pm_state_next(struct os_pm_state *prev)
+{
+    if (prev == NULL) {
+        return SLIST_FIRST(&os_pm_states);
+    }
+    return SLIST_NEXT(prev, ops_next);
+}
+
+void
+os_pm_stats_reset(void)
+{
+    struct os_pm_state *ps;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    SLIST_FOREACH(ps, &os_pm_states, ops_next) {
+        ps->ops_enter_cnt = 0;
+        ps->ops_dev_fail_cnt = 0;
+        ps->ops_residency_ticks = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Called by the idle task, with interrupts disabled, in place of
+ * os_tick_idle().  Returns the state that was entered, or NULL.
+ */
+struct os_pm_state *
+os_pm_idle(os_time_t now, os_time_t ticks)
+{
+    struct os_pm_state *ps;
+    struct os_pm_state *fit;
+
+    fit = NULL;
+    if (ticks != 0) {
+        SLIST_FOREACH(ps, &os_pm_states, ops_next) {
+            if (ps->ops_min_ticks > ticks) {
+                break;
+            }
+            fit = ps;
+        }
+    }
+
+    /* Deep states need every device suspended; fall back if one refuses. */
+    while (fit && (fit->ops_flags & OS_PM_STATE_F_DEV_SUSPEND)) {
+        if (os_dev_suspend_all(now, 0) == 0) {
+            break;
+        }
+        os_dev_resume_all();
+        fit->ops_dev_fail_cnt++;
+
+        SLIST_FOREACH(ps, &os_pm_states, ops_next) {
+            if (SLIST_NEXT(ps, ops_next) == fit) {
+                break;
+            }
+        }
+        fit = ps;
+    }
+
+    if (fit == NULL) {
+        os_tick_idle(ticks);
+        return NULL;
+    }
+
+    fit->ops_enter_cnt++;
+    fit->ops_enter(fit, ticks - fit->ops_exit_ticks);
+
+    if (fit->ops_flags & OS_PM_STATE_F_DEV_SUSPEND) {
+        os_dev_resume_all();
+    }
+
+    return fit;
+}
+
+/*
+ * Called by the idle task once interrupts are enabled again, so that the
+ * OS time has caught up with the sleep.
+ */
+void
+os_pm_idle_done(struct os_pm_state *ps, os_time_t start)
+{
+    if (ps != NULL) {
+        ps->ops_residency_ticks += os_time_get() - start;
+    }
+}
+
+#endif
@@ -28,12 +28,46 @@ extern "C" {
 #endif
 
 extern struct os_task g_idle_task;
+#if !MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
 extern struct os_task_list g_os_run_list;
+#endif
 extern struct os_task_list g_os_sleep_list;
+extern struct os_task_list g_os_sleep_forever_list;
 extern struct os_task_stailq g_os_task_list;
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
 extern struct os_callout_list g_callout_list;
+#endif
 
 void os_msys_init(void);
+void os_callout_list_init(void);
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+void *os_tlsf_malloc(size_t size);
+void os_tlsf_free(void *ptr);
+void *os_tlsf_realloc(void *ptr, size_t size);
+int os_tlsf_add_region(void *mem, size_t len);
+void os_tlsf_stats(struct os_heap_stats *ohs);
+#endif
+
+#if MYNEWT_VAL(OS_WORK)
+void os_work_task_init(void);
+#endif
+
+#if defined(OS_CPUTIME_FREQ_HIGH)
+void os_cputime_high_init(uint32_t clock_freq);
+#endif
+
+#if MYNEWT_VAL(OS_PM)
+struct os_pm_state *os_pm_idle(os_time_t now, os_time_t ticks);
+void os_pm_idle_done(struct os_pm_state *ps, os_time_t start);
+#endif
+
+#if MYNEWT_VAL(OS_LOCK_PROF)
+void os_lock_prof_acquired(struct os_lock_prof *olp);
+void os_lock_prof_waited(struct os_lock_prof *olp, uint32_t wait_start,
+                         int acquired);
+void os_lock_prof_released(struct os_lock_prof *olp, struct os_task *owner);
+#endif
 
 /**
  * Prints information about a crash to the console.  This functionality is
@@ -21,11 +21,18 @@
 #include <string.h>
 #include "os/mynewt.h"
 
+/*
+ * Registered checks, sorted by sc_next_run.  os_sanity_run() only looks at
+ * the checks at the head of the list which are due.
+ */
 SLIST_HEAD(, os_sanity_check) g_os_sanity_check_list =
     SLIST_HEAD_INITIALIZER(os_sanity_check_list);
 
 struct os_mutex g_os_sanity_check_mu;
 
+#define OS_SANITY_ITVL_TICKS \
+    ((MYNEWT_VAL(SANITY_INTERVAL) * OS_TICKS_PER_SEC) / 1000)
+
 int
 os_sanity_check_init(struct os_sanity_check *sc)
 {
@@ -82,6 +89,48 @@ err:
     return (rc);
 }
 
+/*
+ * Sets the time the check is next looked at, and puts it in its place in the
+ * list.  Checks without a callback only need looking at once their checkin
+ * interval has passed.  Callbacks run in the last pass before that, or again
+ * right after it if they have failed.
+ */
+static void
+os_sanity_check_schedule(struct os_sanity_check *sc, int failed)
+{
+    struct os_sanity_check *cur;
+    struct os_sanity_check *prev;
+    os_time_t itvl;
+    os_time_t now;
+
+    itvl = sc->sc_checkin_itvl;
+    if (!sc->sc_func || failed) {
+        sc->sc_next_run = sc->sc_checkin_last + itvl + 1;
+    } else if (itvl > OS_SANITY_ITVL_TICKS) {
+        sc->sc_next_run = sc->sc_checkin_last + itvl - OS_SANITY_ITVL_TICKS;
+    } else {
+        sc->sc_next_run = sc->sc_checkin_last + 1;
+    }
+    /* Expired checks with assert() compiled out: don't look again now. */
+    now = os_time_get();
+    if (!OS_TIME_TICK_GT(sc->sc_next_run, now)) {
+        sc->sc_next_run = now + 1;
+    }
+
+    prev = NULL;
+    SLIST_FOREACH(cur, &g_os_sanity_check_list, sc_next) {
+        if (OS_TIME_TICK_GT(cur->sc_next_run, sc->sc_next_run)) {
+            break;
+        }
+        prev = cur;
+    }
+    if (prev) {
+        SLIST_INSERT_AFTER(prev, sc, sc_next);
+    } else {
+        SLIST_INSERT_HEAD(&g_os_sanity_check_list, sc, sc_next);
+    }
+}
+
 int
 os_sanity_task_checkin(struct os_task *t)
 {
@@ -112,7 +161,7 @@ os_sanity_check_register(struct os_sanity_check *sc)
         goto err;
     }
 
-    SLIST_INSERT_HEAD(&g_os_sanity_check_list, sc, sc_next);
+    os_sanity_check_schedule(sc, 0);
 
     rc = os_sanity_check_list_unlock();
     if (rc != OS_OK) {
@@ -147,16 +196,70 @@ err:
     return (rc);
 }
 
+#if MYNEWT_VAL(SANITY_RUNTIME)
+int
+os_sanity_check_slowest(struct os_sanity_check **scs, int cnt)
+{
+    struct os_sanity_check *sc;
+    int num;
+    int i;
+
+    if (os_sanity_check_list_lock() != OS_OK) {
+        return 0;
+    }
+
+    num = 0;
+    SLIST_FOREACH(sc, &g_os_sanity_check_list, sc_next) {
+        if (!sc->sc_func) {
+            continue;
+        }
+        /* Insertion sort into scs, keeping the cnt slowest. */
+        for (i = num; i > 0; i--) {
+            if (scs[i - 1]->sc_run_max >= sc->sc_run_max) {
+                break;
+            }
+            if (i < cnt) {
+                scs[i] = scs[i - 1];
+            }
+        }
+        if (i < cnt) {
+            scs[i] = sc;
+            if (num < cnt) {
+                num++;
+            }
+        }
+    }
+
+    os_sanity_check_list_unlock();
+
+    return num;
+}
+#endif
+
 /*
  * Called from the IDLE task context, every MYNEWT_VAL(SANITY_INTERVAL) msecs.
  *
- * Goes through the sanity check list, and performs sanity checks.  If any of
- * these checks failed, or tasks have not checked in, it resets the processor.
+ * Performs the sanity checks which are due.  If any of these checks failed,
+ * or tasks have not checked in, it resets the processor.  With
+ * MYNEWT_VAL(SANITY_BUDGET_US) set, stops once that much time has been spent;
+ * checks which are still due get done in the next pass.
  */
 void
 os_sanity_run(void)
 {
     struct os_sanity_check *sc;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    struct os_task *t;
+#endif
+#if MYNEWT_VAL(SANITY_BUDGET_US)
+    uint32_t start;
+#endif
+#if MYNEWT_VAL(SANITY_RUNTIME)
+    uint32_t run_start;
+    uint32_t usecs;
+#endif
+    os_time_t now;
+    int failed;
     int rc;
 
     rc = os_sanity_check_list_lock();
@@ -164,14 +267,31 @@ os_sanity_run(void)
         assert(0);
     }
 
-    SLIST_FOREACH(sc, &g_os_sanity_check_list, sc_next) {
-        rc = OS_OK;
+    now = os_time_get();
+#if MYNEWT_VAL(SANITY_BUDGET_US)
+    start = os_cputime_get32();
+#endif
+    while ((sc = SLIST_FIRST(&g_os_sanity_check_list)) != NULL &&
+           OS_TIME_TICK_GEQ(now, sc->sc_next_run)) {
+        SLIST_REMOVE_HEAD(&g_os_sanity_check_list, sc_next);
+        failed = 0;
 
         if (sc->sc_func) {
+#if MYNEWT_VAL(SANITY_RUNTIME)
+            run_start = os_cputime_get32();
+#endif
             rc = sc->sc_func(sc, sc->sc_arg);
+#if MYNEWT_VAL(SANITY_RUNTIME)
+            usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - run_start);
+            sc->sc_run_last = usecs;
+            if (usecs > sc->sc_run_max) {
+                sc->sc_run_max = usecs;
+            }
+#endif
             if (rc == OS_OK) {
                 sc->sc_checkin_last = os_time_get();
-                continue;
+            } else {
+                failed = 1;
             }
         }
 
@@ -179,12 +299,27 @@ os_sanity_run(void)
                     sc->sc_checkin_last + sc->sc_checkin_itvl)) {
             assert(0);
         }
+
+        os_sanity_check_schedule(sc, failed);
+
+#if MYNEWT_VAL(SANITY_BUDGET_US)
+        if (os_cputime_ticks_to_usecs(os_cputime_get32() - start) >=
+            MYNEWT_VAL(SANITY_BUDGET_US)) {
+            break;
+        }
+#endif
     }
 
     rc = os_sanity_check_list_unlock();
     if (rc != 0) {
         assert(0);
     }
+
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+        os_task_stack_hwm_sample(t, MYNEWT_VAL(OS_TASK_STACK_HWM_SCAN_WORDS));
+    }
+#endif
 }
 
 int
@@ -18,17 +18,214 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
 
-struct os_task_list g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
+/*
+ * Tasks sleeping with a timeout are kept sorted by wakeup time in
+ * g_os_sleep_list, so the tick handler and the idle task only need to look
+ * at its head.  Tasks sleeping with no timeout are kept apart, unsorted.
+ */
 struct os_task_list g_os_sleep_list = TAILQ_HEAD_INITIALIZER(g_os_sleep_list);
+struct os_task_list g_os_sleep_forever_list =
+    TAILQ_HEAD_INITIALIZER(g_os_sleep_forever_list);
 
 struct os_task *g_current_task;
 
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+/*
+ * Interrupt time is summed into a free running 32-bit counter by the
+ * outermost handler on exit.  The scheduler only ever reads the counter and
+ * works with differences, so interrupts never have to be masked for it.
+ */
+static volatile uint32_t os_sched_isr_cputime_acc;
+static uint32_t os_sched_isr_cputime_snap;
+static uint64_t os_sched_isr_cputime_total;
+static uint32_t os_sched_isr_entry;
+static uint8_t os_sched_isr_nesting;
+static uint32_t os_sched_ctx_sw_cputime;
+
+void
+os_sched_isr_enter(void)
+{
+    if (os_sched_isr_nesting++ == 0) {
+        os_sched_isr_entry = os_cputime_get32();
+    }
+}
+
+void
+os_sched_isr_exit(void)
+{
+    if (--os_sched_isr_nesting == 0) {
+        os_sched_isr_cputime_acc += os_cputime_get32() - os_sched_isr_entry;
+    }
+}
+
+static void
+os_sched_cputime_charge(void)
+{
+    uint32_t elapsed;
+    uint32_t isr;
+    uint32_t now;
+
+    isr = os_sched_isr_cputime_acc - os_sched_isr_cputime_snap;
+    os_sched_isr_cputime_snap += isr;
+    os_sched_isr_cputime_total += isr;
+
+    now = os_cputime_get32();
+    elapsed = now - os_sched_ctx_sw_cputime;
+    os_sched_ctx_sw_cputime = now;
+
+    /*
+     * An interrupt that straddles the previous switch can make isr
+     * slightly larger than elapsed.
+     */
+    if (g_current_task != NULL && elapsed > isr) {
+        g_current_task->t_run_cputime += elapsed - isr;
+    }
+}
+
+void
+os_sched_cputime_update(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_sched_cputime_charge();
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint64_t
+os_sched_isr_cputime(void)
+{
+    uint64_t total;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_sched_cputime_charge();
+    total = os_sched_isr_cputime_total;
+    OS_EXIT_CRITICAL(sr);
+
+    return total;
+}
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+
+/*
+ * Ready tasks are kept in one FIFO per priority.  Bit (31 - n) of
+ * os_sched_ready[w] is set when list (w * 32 + n) is non-empty, and bit
+ * (31 - w) of os_sched_ready_words is set when os_sched_ready[w] is
+ * non-zero.  Ordering the bits from the MSB lets two count-leading-zeros
+ * operations find the highest priority ready task.
+ */
+#define OS_SCHED_PRIO_CNT   256
+#define OS_SCHED_WORD_CNT   (OS_SCHED_PRIO_CNT / 32)
+#define OS_SCHED_BIT(n)     (0x80000000UL >> ((n) & 31))
+
+static struct os_task_list os_sched_run_lists[OS_SCHED_PRIO_CNT];
+static uint32_t os_sched_ready[OS_SCHED_WORD_CNT];
+static uint32_t os_sched_ready_words;
+
+void
+os_sched_run_list_init(void)
+{
+    int i;
+
+    for (i = 0; i < OS_SCHED_PRIO_CNT; i++) {
+        TAILQ_INIT(&os_sched_run_lists[i]);
+    }
+    memset(os_sched_ready, 0, sizeof(os_sched_ready));
+    os_sched_ready_words = 0;
+}
+
+static struct os_task *
+os_sched_run_list_first(void)
+{
+    int w;
+
+    if (os_sched_ready_words == 0) {
+        return NULL;
+    }
+
+    w = __builtin_clz(os_sched_ready_words);
+    return TAILQ_FIRST(&os_sched_run_lists[w * 32 +
+                                           __builtin_clz(os_sched_ready[w])]);
+}
+
+static void
+os_sched_run_list_add(struct os_task *t)
+{
+    int p;
+
+    p = t->t_prio;
+    t->t_sched_prio = p;
+    TAILQ_INSERT_TAIL(&os_sched_run_lists[p], t, t_os_list);
+    os_sched_ready[p / 32] |= OS_SCHED_BIT(p);
+    os_sched_ready_words |= OS_SCHED_BIT(p / 32);
+}
+
+static void
+os_sched_run_list_del(struct os_task *t)
+{
+    int p;
+
+    /* The task's priority may have changed since it was linked. */
+    p = t->t_sched_prio;
+    TAILQ_REMOVE(&os_sched_run_lists[p], t, t_os_list);
+    if (TAILQ_EMPTY(&os_sched_run_lists[p])) {
+        os_sched_ready[p / 32] &= ~OS_SCHED_BIT(p);
+        if (os_sched_ready[p / 32] == 0) {
+            os_sched_ready_words &= ~OS_SCHED_BIT(p / 32);
+        }
+    }
+}
+
+#else
+
+struct os_task_list g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
+
+void
+os_sched_run_list_init(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+}
+
+static struct os_task *
+os_sched_run_list_first(void)
+{
+    return TAILQ_FIRST(&g_os_run_list);
+}
+
+static void
+os_sched_run_list_add(struct os_task *t)
+{
+    struct os_task *entry;
+
+    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
+        if (t->t_prio < entry->t_prio) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, t, t_os_list);
+    }
+}
+
+static void
+os_sched_run_list_del(struct os_task *t)
+{
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
+#endif
+
 /**
  * os sched insert
  *
@@ -43,7 +240,6 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
-    struct os_task *entry;
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,18 +248,8 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
-    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
-        if (t->t_prio < entry->t_prio) {
-            break;
-        }
-    }
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
-    } else {
-        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
-    }
+    os_sched_run_list_add(t);
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -82,10 +268,17 @@ os_sched_ctx_sw_hook(struct os_task *next_t)
     for (i = 0; i < MYNEWT_VAL(OS_CTX_SW_STACK_GUARD); i++) {
         assert(top[i] == OS_STACK_PATTERN);
     }
+#endif
+#if MYNEWT_VAL(OS_TRACE_RING)
+    /* SystemView records this from the context switch handler instead. */
+    os_trace_task_start_exec(next_t);
 #endif
     next_t->t_ctx_sw_cnt++;
     g_current_task->t_run_time += g_os_time - g_os_last_ctx_sw_time;
     g_os_last_ctx_sw_time = g_os_time;
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    os_sched_cputime_charge();
+#endif
 }
 
 struct os_task *
@@ -125,6 +318,16 @@ os_sched(struct os_task *next_t)
     OS_EXIT_CRITICAL(sr);
 }
 
+static void
+os_sched_sleep_list_del(struct os_task *t)
+{
+    if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
+        TAILQ_REMOVE(&g_os_sleep_forever_list, t, t_os_list);
+    } else {
+        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+    }
+}
+
 /**
  * os sched sleep
  *
@@ -145,23 +348,27 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
 
     entry = NULL;
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_del(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
         t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
-        TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+        TAILQ_INSERT_TAIL(&g_os_sleep_forever_list, t, t_os_list);
     } else {
-        TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
-            if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
-                    OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
+        /*
+         * Search from the tail; new deadlines are usually later than the
+         * ones already queued.
+         */
+        TAILQ_FOREACH_REVERSE(entry, &g_os_sleep_list, os_task_list,
+                              t_os_list) {
+            if (!OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
                 break;
             }
         }
         if (entry) {
-            TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+            TAILQ_INSERT_AFTER(&g_os_sleep_list, entry, t, t_os_list);
         } else {
-            TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+            TAILQ_INSERT_HEAD(&g_os_sleep_list, t, t_os_list);
         }
     }
 
@@ -187,9 +394,9 @@ os_sched_remove(struct os_task *t)
 {
 
     if (t->t_state == OS_TASK_SLEEP) {
-        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+        os_sched_sleep_list_del(t);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_del(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -229,10 +436,10 @@ os_sched_wakeup(struct os_task *t)
     }
 
     /* Remove task from sleep list */
+    os_sched_sleep_list_del(t);
     t->t_state = OS_TASK_READY;
     t->t_next_wakeup = 0;
     t->t_flags &= ~OS_TASK_FLAG_NO_TIMEOUT;
-    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     os_sched_insert(t);
 
     os_trace_task_start_ready(t);
@@ -266,10 +473,6 @@ os_sched_os_timer_exp(void)
      */
     t = TAILQ_FIRST(&g_os_sleep_list);
     while (t) {
-        /* If task waiting forever, do not check next wakeup time */
-        if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
-            break;
-        }
         next = TAILQ_NEXT(t, t_os_list);
         if (OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
             os_sched_wakeup(t);
@@ -295,7 +498,7 @@ os_sched_wakeup_ticks(os_time_t now)
     OS_ASSERT_CRITICAL();
 
     t = TAILQ_FIRST(&g_os_sleep_list);
-    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+    if (t == NULL) {
         rt = OS_TIMEOUT_NEVER;
     } else if (OS_TIME_TICK_GEQ(t->t_next_wakeup, now)) {
         rt = t->t_next_wakeup - now;
@@ -319,7 +522,7 @@ os_sched_wakeup_ticks(os_time_t now)
 struct os_task *
 os_sched_next_task(void)
 {
-    return (TAILQ_FIRST(&g_os_run_list));
+    return (os_sched_run_list_first());
 }
 
 /**
@@ -339,7 +542,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
-        os_sched_insert(t);
+        os_sched_run_list_del(t);
+        os_sched_run_list_add(t);
     }
 }
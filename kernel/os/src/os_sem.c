@@ -23,6 +23,7 @@
 #define OS_TRACE_DISABLE_FILE_API
 #endif
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 /* XXX:
  * 1) Should I check to see if we are within an ISR for some of these?
@@ -43,6 +44,9 @@ os_sem_init(struct os_sem *sem, uint16_t tokens)
     }
 
     sem->sem_tokens = tokens;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    sem->sem_prof = NULL;
+#endif
     SLIST_FIRST(&sem->sem_head) = NULL;
 
     ret = OS_OK;
@@ -120,6 +124,9 @@ os_sem_pend(struct os_sem *sem, os_time_t timeout)
     struct os_task *entry;
     struct os_task *last;
     os_error_t ret;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    uint32_t wait_start;
+#endif
 
     os_trace_api_u32x2(OS_TRACE_ID_SEM_PEND, (uint32_t)sem, (uint32_t)timeout);
 
@@ -147,8 +154,18 @@ os_sem_pend(struct os_sem *sem, os_time_t timeout)
      */
     if (sem->sem_tokens != 0) {
         sem->sem_tokens--;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        if (sem->sem_prof) {
+            os_lock_prof_acquired(sem->sem_prof);
+        }
+#endif
         ret = OS_OK;
     } else if (timeout == 0) {
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        if (sem->sem_prof) {
+            os_lock_prof_waited(sem->sem_prof, os_cputime_get32(), 0);
+        }
+#endif
         ret = OS_TIMEOUT;
     } else {
         /* Silence gcc maybe-uninitialized warning. */
@@ -176,6 +193,9 @@ os_sem_pend(struct os_sem *sem, os_time_t timeout)
 
         /* We will put this task to sleep */
         sched = 1;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        wait_start = os_cputime_get32();
+#endif
         os_sched_sleep(current, timeout);
     }
 
@@ -192,6 +212,13 @@ os_sem_pend(struct os_sem *sem, os_time_t timeout)
         } else {
             ret = OS_OK;
         }
+#if MYNEWT_VAL(OS_LOCK_PROF)
+        if (sem->sem_prof) {
+            OS_ENTER_CRITICAL(sr);
+            os_lock_prof_waited(sem->sem_prof, wait_start, ret == OS_OK);
+            OS_EXIT_CRITICAL(sr);
+        }
+#endif
     }
 
 done:
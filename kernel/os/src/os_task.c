@@ -95,6 +95,9 @@ os_task_init(struct os_task *t, const char *name, os_task_func_t func,
     _clear_stack(stack_bottom, stack_size);
     t->t_stacktop = &stack_bottom[stack_size];
     t->t_stacksize = stack_size;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    t->t_stack_untouched = stack_size;
+#endif
     t->t_stackptr = os_arch_task_stack_init(t, t->t_stacktop,
             t->t_stacksize);
 
@@ -169,16 +172,67 @@ os_task_remove(struct os_task *t)
 }
 
 
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+uint16_t
+os_task_stack_hwm_sample(struct os_task *t, int words)
+{
+    os_stack_t *bottom;
+    uint16_t scan;
+    uint16_t untouched;
+    int full;
+
+    bottom = t->t_stacktop - t->t_stacksize;
+    scan = t->t_stack_scan;
+    untouched = t->t_stack_untouched;
+
+    full = (words == 0);
+    if (full) {
+        scan = 0;
+    }
+
+    while (full || words-- > 0) {
+        if (scan >= untouched) {
+            /* Reached the mark; start over from the bottom. */
+            scan = 0;
+            if (full || untouched == 0) {
+                break;
+            }
+        }
+        if (bottom[scan] != OS_STACK_PATTERN) {
+            untouched = scan;
+            scan = 0;
+            if (full) {
+                /* Everything below was just seen untouched. */
+                break;
+            }
+        } else {
+            scan++;
+        }
+    }
+
+    t->t_stack_scan = scan;
+    t->t_stack_untouched = untouched;
+
+    return t->t_stacksize - untouched;
+}
+#endif
+
 struct os_task *
 os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
 {
     struct os_task *next;
+#if !MYNEWT_VAL(OS_TASK_STACK_HWM)
     os_stack_t *top;
     os_stack_t *bottom;
+#endif
 
     if (prev != NULL) {
         next = STAILQ_NEXT(prev, t_os_task_list);
     } else {
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+        /* Bring the running task's figures up to date for this pass. */
+        os_sched_cputime_update();
+#endif
         next = STAILQ_FIRST(&g_os_task_list);
     }
 
@@ -193,6 +247,9 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
     oti->oti_taskid = next->t_taskid;
     oti->oti_state = next->t_state;
 
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    oti->oti_stkusage = next->t_stacksize - next->t_stack_untouched;
+#else
     top = next->t_stacktop;
     bottom = next->t_stacktop - next->t_stacksize;
     while (bottom < top) {
@@ -203,9 +260,13 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
     }
 
     oti->oti_stkusage = (uint16_t) (next->t_stacktop - bottom);
+#endif
     oti->oti_stksize = next->t_stacksize;
     oti->oti_cswcnt = next->t_ctx_sw_cnt;
     oti->oti_runtime = next->t_run_time;
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    oti->oti_run_cputime = next->t_run_cputime;
+#endif
     oti->oti_last_checkin = next->t_sanity_check.sc_checkin_last;
     oti->oti_next_checkin = next->t_sanity_check.sc_checkin_last +
         next->t_sanity_check.sc_checkin_itvl;
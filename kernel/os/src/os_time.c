@@ -36,6 +36,9 @@ static struct {
     struct os_timezone timezone;
 } basetod;
 
+static STAILQ_HEAD(, os_time_change_listener) os_time_change_listeners =
+    STAILQ_HEAD_INITIALIZER(os_time_change_listeners);
+
 static void
 os_deltatime(os_time_t delta, const struct os_timeval *base,
     struct os_timeval *result)
@@ -119,15 +122,22 @@ os_time_delay(os_time_t osticks)
 int
 os_settimeofday(struct os_timeval *utctime, struct os_timezone *tz)
 {
+    struct os_time_change_listener *listener;
+    struct os_time_change_info info;
+    struct os_timeval prev_utc;
+    struct os_timezone prev_tz;
     os_sr_t sr;
     os_time_t delta;
 
     OS_ENTER_CRITICAL(sr);
+    delta = os_time_get() - basetod.ostime;
+    os_deltatime(delta, &basetod.utctime, &prev_utc);
+    prev_tz = basetod.timezone;
+
     if (utctime != NULL) {
         /*
          * Update all time-of-day base values.
          */
-        delta = os_time_get() - basetod.ostime;
         os_deltatime(delta, &basetod.uptime, &basetod.uptime);
         basetod.utctime = *utctime;
         basetod.ostime += delta;
@@ -138,9 +148,50 @@ os_settimeofday(struct os_timeval *utctime, struct os_timezone *tz)
     }
     OS_EXIT_CRITICAL(sr);
 
+    info = (struct os_time_change_info) {
+        .tci_prev_utc = utctime ? &prev_utc : NULL,
+        .tci_prev_tz = tz ? &prev_tz : NULL,
+        .tci_cur_utc = utctime,
+        .tci_cur_tz = tz,
+    };
+    STAILQ_FOREACH(listener, &os_time_change_listeners, tcl_next) {
+        listener->tcl_fn(&info, listener->tcl_arg);
+    }
+
     return (0);
 }
 
+int
+os_time_change_listen(struct os_time_change_listener *listener)
+{
+    struct os_time_change_listener *cur;
+
+    STAILQ_FOREACH(cur, &os_time_change_listeners, tcl_next) {
+        if (cur == listener) {
+            return OS_INVALID_PARM;
+        }
+    }
+    STAILQ_INSERT_TAIL(&os_time_change_listeners, listener, tcl_next);
+
+    return 0;
+}
+
+int
+os_time_change_remove(const struct os_time_change_listener *listener)
+{
+    struct os_time_change_listener *cur;
+
+    STAILQ_FOREACH(cur, &os_time_change_listeners, tcl_next) {
+        if (cur == listener) {
+            STAILQ_REMOVE(&os_time_change_listeners, cur,
+                          os_time_change_listener, tcl_next);
+            return 0;
+        }
+    }
+
+    return OS_INVALID_PARM;
+}
+
 int
 os_gettimeofday(struct os_timeval *tv, struct os_timezone *tz)
 {
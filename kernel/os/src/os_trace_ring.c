@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_TRACE_RING)
+
+#define OS_TRACE_RING_MASK      (MYNEWT_VAL(OS_TRACE_RING_SIZE) - 1)
+
+#if (MYNEWT_VAL(OS_TRACE_RING_SIZE) & OS_TRACE_RING_MASK) != 0
+#error "OS_TRACE_RING_SIZE must be a power of two"
+#endif
+
+static struct os_trace_rec os_trace_ring[MYNEWT_VAL(OS_TRACE_RING_SIZE)];
+static uint32_t os_trace_ring_head;
+/* Number of valid records; saturates at OS_TRACE_RING_SIZE. */
+static uint32_t os_trace_ring_cnt;
+static uint8_t os_trace_ring_isr_nest;
+
+void
+os_trace_ring_rec(uint8_t id, uint8_t flags, uint32_t arg0, uint32_t arg1)
+{
+    struct os_trace_rec *rec;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (id == OS_TRACE_ID_ISR_EXIT && os_trace_ring_isr_nest > 0) {
+        os_trace_ring_isr_nest--;
+    }
+    if (os_trace_ring_isr_nest > 0) {
+        flags |= OS_TRACE_REC_F_ISR;
+    }
+    if (id == OS_TRACE_ID_ISR_ENTER) {
+        os_trace_ring_isr_nest++;
+    }
+
+    rec = &os_trace_ring[os_trace_ring_head & OS_TRACE_RING_MASK];
+    os_trace_ring_head++;
+    if (os_trace_ring_cnt < MYNEWT_VAL(OS_TRACE_RING_SIZE)) {
+        os_trace_ring_cnt++;
+    }
+
+    rec->otr_time = os_cputime_get32();
+    rec->otr_id = id;
+    rec->otr_taskid = g_current_task ? g_current_task->t_taskid : 0xff;
+    rec->otr_flags = flags;
+    rec->_pad = 0;
+    rec->otr_arg0 = arg0;
+    rec->otr_arg1 = arg1;
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint32_t
+os_trace_ring_seq(void)
+{
+    return os_trace_ring_head;
+}
+
+int
+os_trace_ring_read(uint32_t *seq, struct os_trace_rec *recs, int max)
+{
+    uint32_t cur;
+    os_sr_t sr;
+    int cnt;
+
+    cur = *seq;
+    for (cnt = 0; cnt < max; cnt++) {
+        /*
+         * Copy one record at a time so that interrupts are not held off
+         * for the whole read.
+         */
+        OS_ENTER_CRITICAL(sr);
+        if (os_trace_ring_head - cur > os_trace_ring_cnt) {
+            /* Requested record was overwritten; skip to the oldest one. */
+            cur = os_trace_ring_head - os_trace_ring_cnt;
+        }
+        if (cur == os_trace_ring_head) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        recs[cnt] = os_trace_ring[cur & OS_TRACE_RING_MASK];
+        OS_EXIT_CRITICAL(sr);
+        cur++;
+    }
+    *seq = cur;
+
+    return cnt;
+}
+
+const struct os_trace_rec *
+os_trace_ring_buf(uint32_t *seq)
+{
+    *seq = os_trace_ring_head;
+    return os_trace_ring;
+}
+
+#endif
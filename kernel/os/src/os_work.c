@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_WORK)
+
+#include "os_priv.h"
+
+#define OS_WORK_PRIOS   MYNEWT_VAL(OS_EVENTQ_LANES)
+
+static struct os_eventq os_work_evq;
+
+static struct os_task os_work_task;
+OS_TASK_STACK_DEFINE(os_work_stack, MYNEWT_VAL(OS_WORK_STACK_SIZE));
+
+#if MYNEWT_VAL(OS_WORK_STATS)
+static struct os_work_stats os_work_stats[OS_WORK_PRIOS];
+#endif
+
+void
+os_work_init(struct os_work *w, os_event_fn *fn, void *arg, uint8_t prio)
+{
+    assert(prio < OS_WORK_PRIOS);
+
+    memset(w, 0, sizeof(*w));
+    w->ow_ev.ev_cb = fn;
+    w->ow_ev.ev_arg = arg;
+    w->ow_prio = prio;
+}
+
+void
+os_work_post(struct os_work *w)
+{
+#if MYNEWT_VAL(OS_WORK_STATS)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!OS_EVENT_QUEUED(&w->ow_ev)) {
+        w->ow_posted = os_cputime_get32();
+    }
+    os_eventq_put_lane(&os_work_evq, &w->ow_ev, w->ow_prio);
+    OS_EXIT_CRITICAL(sr);
+#else
+    os_eventq_put_lane(&os_work_evq, &w->ow_ev, w->ow_prio);
+#endif
+}
+
+void
+os_work_cancel(struct os_work *w)
+{
+    os_eventq_remove(&os_work_evq, &w->ow_ev);
+}
+
+int
+os_work_stats_get(uint8_t prio, struct os_work_stats *ows)
+{
+#if MYNEWT_VAL(OS_WORK_STATS)
+    os_sr_t sr;
+#endif
+
+    if (prio >= OS_WORK_PRIOS) {
+        return OS_EINVAL;
+    }
+
+#if MYNEWT_VAL(OS_WORK_STATS)
+    OS_ENTER_CRITICAL(sr);
+    *ows = os_work_stats[prio];
+    OS_EXIT_CRITICAL(sr);
+#else
+    memset(ows, 0, sizeof(*ows));
+#endif
+
+    return 0;
+}
+
+void
+os_work_stats_reset(void)
+{
+#if MYNEWT_VAL(OS_WORK_STATS)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(os_work_stats, 0, sizeof(os_work_stats));
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
+
+/*
+ * Only os_work_post() puts events on the work queue, so every event pulled
+ * off it is the first member of an os_work.
+ */
+static void
+os_work_task_handler(void *arg)
+{
+    struct os_event *ev;
+#if MYNEWT_VAL(OS_WORK_STATS)
+    struct os_work_stats *ows;
+    struct os_work *w;
+    uint32_t latency;
+    os_sr_t sr;
+#endif
+
+    while (1) {
+        ev = os_eventq_get(&os_work_evq);
+#if MYNEWT_VAL(OS_WORK_STATS)
+        w = (struct os_work *)ev;
+        ows = &os_work_stats[w->ow_prio];
+
+        OS_ENTER_CRITICAL(sr);
+        latency = os_cputime_get32() - w->ow_posted;
+        ows->ows_runs++;
+        ows->ows_latency_total += latency;
+        if (latency > ows->ows_latency_max) {
+            ows->ows_latency_max = latency;
+        }
+        OS_EXIT_CRITICAL(sr);
+#endif
+        assert(ev->ev_cb != NULL);
+        ev->ev_cb(ev);
+    }
+}
+
+void
+os_work_task_init(void)
+{
+    int rc;
+
+    os_eventq_init(&os_work_evq);
+
+    rc = os_task_init(&os_work_task, "work", os_work_task_handler, NULL,
+                      MYNEWT_VAL(OS_WORK_TASK_PRIO), OS_WAIT_FOREVER,
+                      os_work_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(OS_WORK_STACK_SIZE)));
+    assert(rc == 0);
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+struct os_dev g_dev_test_devs[DEV_TEST_NUM_DEVS];
+int g_dev_test_log[DEV_TEST_NUM_DEVS * 4];
+int g_dev_test_log_len;
+int g_dev_test_busy[DEV_TEST_NUM_DEVS];
+
+static void
+dev_test_log(struct os_dev *dev)
+{
+    TEST_ASSERT_FATAL(g_dev_test_log_len < DEV_TEST_NUM_DEVS * 4);
+    g_dev_test_log[g_dev_test_log_len++] = dev - g_dev_test_devs;
+}
+
+static int
+dev_test_suspend(struct os_dev *dev, os_time_t suspend_t, int force)
+{
+    dev_test_log(dev);
+    if (g_dev_test_busy[dev - g_dev_test_devs] > 0) {
+        g_dev_test_busy[dev - g_dev_test_devs]--;
+        return OS_EBUSY;
+    }
+    return 0;
+}
+
+static int
+dev_test_resume(struct os_dev *dev)
+{
+    dev_test_log(dev);
+    return 0;
+}
+
+static int
+dev_test_init(struct os_dev *dev, void *arg)
+{
+    OS_DEV_SETHANDLERS(dev, NULL, NULL);
+    dev->od_handlers.od_suspend = dev_test_suspend;
+    dev->od_handlers.od_resume = dev_test_resume;
+    return 0;
+}
+
+/*
+ * Replaces the device list with:
+ *   dev0 "d0": primary, prio 0
+ *   dev1 "d1": secondary, prio 0
+ *   dev2 "d2": secondary, prio 0
+ *   dev3 "d3": secondary, prio 1
+ * and opens them all.
+ */
+void
+dev_test_setup(void)
+{
+    static char *names[DEV_TEST_NUM_DEVS] = { "d0", "d1", "d2", "d3" };
+    static const uint8_t stages[DEV_TEST_NUM_DEVS] = {
+        OS_DEV_INIT_PRIMARY, OS_DEV_INIT_SECONDARY,
+        OS_DEV_INIT_SECONDARY, OS_DEV_INIT_SECONDARY,
+    };
+    static const uint8_t prios[DEV_TEST_NUM_DEVS] = { 0, 0, 0, 1 };
+    int rc;
+    int i;
+
+    os_dev_reset();
+    memset(g_dev_test_devs, 0, sizeof(g_dev_test_devs));
+    memset(g_dev_test_busy, 0, sizeof(g_dev_test_busy));
+    g_dev_test_log_len = 0;
+
+    for (i = 0; i < DEV_TEST_NUM_DEVS; i++) {
+        rc = os_dev_create(&g_dev_test_devs[i], names[i], stages[i], prios[i],
+                           dev_test_init, NULL);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = os_dev_initialize_all(OS_DEV_INIT_PRIMARY);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_dev_initialize_all(OS_DEV_INIT_SECONDARY);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < DEV_TEST_NUM_DEVS; i++) {
+        TEST_ASSERT_FATAL(os_dev_open(names[i], 0, NULL) ==
+                          &g_dev_test_devs[i]);
+    }
+}
+
+TEST_CASE_DECL(os_dev_test_lookup)
+TEST_CASE_DECL(os_dev_test_handle)
+TEST_CASE_DECL(os_dev_test_suspend_all)
+
+TEST_SUITE(os_dev_test_suite)
+{
+    os_dev_test_lookup();
+    os_dev_test_handle();
+    os_dev_test_suspend_all();
+}
@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _DEV_TEST_H
+#define _DEV_TEST_H
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEV_TEST_NUM_DEVS   4
+
+extern struct os_dev g_dev_test_devs[DEV_TEST_NUM_DEVS];
+
+/* Order in which the suspend / resume handlers ran, as device indices. */
+extern int g_dev_test_log[DEV_TEST_NUM_DEVS * 4];
+extern int g_dev_test_log_len;
+
+/* Number of times each device's suspend handler reports OS_EBUSY first. */
+extern int g_dev_test_busy[DEV_TEST_NUM_DEVS];
+
+void dev_test_setup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DEV_TEST_H */
@@ -71,11 +71,19 @@ os_stack_t eventq_task_stack_poll_single_s[POLL_STACK_SIZE];
 struct os_task eventq_task_poll_single_r;
 os_stack_t eventq_task_stack_poll_single_r[POLL_STACK_SIZE];
 
+/* Define the task stack for the eventq_task_run_batch */
+struct os_task eventq_task_run_batch_t;
+os_stack_t eventq_task_stack_run_batch[POLL_STACK_SIZE];
+
+/* Number of times each of m_event[] was dispatched by os_eventq_run_batch */
+static int run_batch_cnt[SIZE_MULTI_EVENT];
+
 TEST_CASE_DECL(event_test_sr)
 TEST_CASE_DECL(event_test_poll_sr)
 TEST_CASE_DECL(event_test_poll_timeout_sr)
 TEST_CASE_DECL(event_test_poll_single_sr)
 TEST_CASE_DECL(event_test_poll_0timo)
+TEST_CASE_DECL(event_test_run_batch)
 
 /* This is the task function  to send data */
 void
@@ -252,6 +260,52 @@ eventq_task_poll_single_receive(void *arg)
     os_test_restart();
 }
 
+static void
+eventq_run_batch_cb(struct os_event *ev)
+{
+    run_batch_cnt[ev - m_event]++;
+
+    /* The first event cancels the last one, which is in the same batch. */
+    if (ev == &m_event[0]) {
+        os_eventq_remove(&my_eventq, &m_event[SIZE_MULTI_EVENT - 1]);
+    }
+}
+
+void
+eventq_task_run_batch(void *arg)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        m_event[i].ev_cb = eventq_run_batch_cb;
+        os_eventq_put(&my_eventq, &m_event[i]);
+    }
+
+    /* All but the cancelled event get dispatched in one wakeup. */
+    rc = os_eventq_run_batch(&my_eventq, SIZE_MULTI_EVENT);
+    TEST_ASSERT(rc == SIZE_MULTI_EVENT - 1);
+    for (i = 0; i < SIZE_MULTI_EVENT - 1; i++) {
+        TEST_ASSERT(run_batch_cnt[i] == 1);
+    }
+    TEST_ASSERT(run_batch_cnt[SIZE_MULTI_EVENT - 1] == 0);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&m_event[SIZE_MULTI_EVENT - 1]));
+
+    /* A batch never takes more than 'max' events. */
+    os_eventq_put(&my_eventq, &m_event[1]);
+    os_eventq_put(&my_eventq, &m_event[2]);
+    rc = os_eventq_run_batch(&my_eventq, 1);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(run_batch_cnt[1] == 2);
+    TEST_ASSERT(OS_EVENT_QUEUED(&m_event[2]));
+    rc = os_eventq_run_batch(&my_eventq, 1);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(run_batch_cnt[2] == 2);
+
+    /* Finishes the test when OS has been started */
+    os_test_restart();
+}
+
 TEST_SUITE(os_eventq_test_suite)
 {
     event_test_sr();
@@ -259,4 +313,5 @@ TEST_SUITE(os_eventq_test_suite)
     event_test_poll_timeout_sr();
     event_test_poll_single_sr();
     event_test_poll_0timo();
+    event_test_run_batch();
 }
@@ -102,6 +102,11 @@ TEST_CASE_DECL(os_mbuf_test_extend)
 TEST_CASE_DECL(os_mbuf_test_adj)
 TEST_CASE_DECL(os_mbuf_test_get_pkthdr)
 TEST_CASE_DECL(os_mbuf_test_widen)
+TEST_CASE_DECL(os_mbuf_test_mqueue_ring)
+TEST_CASE_DECL(os_mbuf_test_ext)
+TEST_CASE_DECL(os_mbuf_test_share)
+TEST_CASE_DECL(os_mbuf_test_msys)
+TEST_CASE_DECL(os_mbuf_test_peek)
 
 TEST_SUITE(os_mbuf_test_suite)
 {
@@ -113,4 +118,9 @@ TEST_SUITE(os_mbuf_test_suite)
     os_mbuf_test_adj();
     os_mbuf_test_get_pkthdr();
     os_mbuf_test_widen();
+    os_mbuf_test_mqueue_ring();
+    os_mbuf_test_ext();
+    os_mbuf_test_share();
+    os_mbuf_test_msys();
+    os_mbuf_test_peek();
 }
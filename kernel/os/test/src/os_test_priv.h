@@ -25,6 +25,7 @@
 #include "os_test_priv.h"
 
 #include "callout_test.h"
+#include "dev_test.h"
 
 #include "eventq_test.h"
 #include "mbuf_test.h"
@@ -53,6 +54,8 @@ int os_mbuf_test_suite(void);
 int os_sem_test_suite(void);
 int os_eventq_test_suite(void);
 int os_callout_test_suite(void);
+int os_cputime_test_suite(void);
+int os_dev_test_suite(void);
 
 #ifdef __cplusplus
 }
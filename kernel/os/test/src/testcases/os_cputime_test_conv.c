@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+#if defined(OS_CPUTIME_FREQ_HIGH)
+static uint32_t
+cputime_test_floor(uint32_t x, uint32_t num, uint32_t den)
+{
+    return (uint64_t)x * num / den;
+}
+
+static uint32_t
+cputime_test_ceil(uint32_t x, uint32_t num, uint32_t den)
+{
+    return ((uint64_t)x * num + den - 1) / den;
+}
+
+static void
+cputime_test_check(uint32_t freq, uint32_t x)
+{
+    TEST_ASSERT_FATAL(os_cputime_usecs_to_ticks(x) ==
+                      cputime_test_floor(x, freq, 1000000),
+                      "usecs_to_ticks(%lu) @ %lu Hz",
+                      (unsigned long)x, (unsigned long)freq);
+    TEST_ASSERT_FATAL(os_cputime_ticks_to_usecs(x) ==
+                      cputime_test_ceil(x, 1000000, freq),
+                      "ticks_to_usecs(%lu) @ %lu Hz",
+                      (unsigned long)x, (unsigned long)freq);
+    TEST_ASSERT_FATAL(os_cputime_nsecs_to_ticks(x) ==
+                      cputime_test_ceil(x, freq, 1000000000),
+                      "nsecs_to_ticks(%lu) @ %lu Hz",
+                      (unsigned long)x, (unsigned long)freq);
+    TEST_ASSERT_FATAL(os_cputime_ticks_to_nsecs(x) ==
+                      cputime_test_ceil(x, 1000000000, freq),
+                      "ticks_to_nsecs(%lu) @ %lu Hz",
+                      (unsigned long)x, (unsigned long)freq);
+}
+#endif
+
+TEST_CASE(os_cputime_test_conv)
+{
+#if defined(OS_CPUTIME_FREQ_HIGH)
+    static const uint32_t freqs[] = {
+        1000001, 2000000, 12500000, 16000000, 16384000, 32000000,
+        48000000, 64000000, 96000000, 200000000,
+    };
+    uint32_t seed;
+    uint32_t x;
+    int i;
+    int j;
+
+    /* The conversions must match 64-bit division exactly everywhere. */
+    for (i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+        os_cputime_init(freqs[i]);
+
+        for (j = 0; j < 1000; j++) {
+            cputime_test_check(freqs[i], j);
+            cputime_test_check(freqs[i], UINT32_MAX - j);
+        }
+
+        /* Strided sweep of the full 32-bit range. */
+        x = 0;
+        do {
+            cputime_test_check(freqs[i], x);
+            x += 65521;
+        } while (x >= 65521);
+
+        seed = freqs[i];
+        for (j = 0; j < 100000; j++) {
+            seed = seed * 1664525 + 1013904223;
+            cputime_test_check(freqs[i], seed);
+        }
+    }
+
+    os_cputime_init(MYNEWT_VAL(OS_CPUTIME_FREQ));
+#else
+    /* Only clocks above 1 MHz use the precomputed conversions. */
+#endif
+}
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+TEST_CASE(os_dev_test_handle)
+{
+    static struct os_dev_handle h_d2 = OS_DEV_HANDLE_INIT("d2");
+    struct os_dev_handle h_late;
+    struct os_dev late;
+    struct os_dev *dev;
+
+    dev_test_setup();
+
+    TEST_ASSERT(os_dev_handle_lookup(&h_d2) == &g_dev_test_devs[2]);
+    TEST_ASSERT(os_dev_handle_lookup(&h_d2) == &g_dev_test_devs[2]);
+
+    dev = os_dev_handle_open(&h_d2, 0, NULL);
+    TEST_ASSERT(dev == &g_dev_test_devs[2]);
+    TEST_ASSERT(dev->od_open_ref == 2);
+
+    /* A miss is not cached; the device can show up later. */
+    os_dev_handle_init(&h_late, "late");
+    TEST_ASSERT(os_dev_handle_lookup(&h_late) == NULL);
+    TEST_ASSERT(os_dev_handle_open(&h_late, 0, NULL) == NULL);
+    memset(&late, 0, sizeof(late));
+    TEST_ASSERT(os_dev_create(&late, "late", OS_DEV_INIT_SECONDARY, 0,
+                              NULL, NULL) == 0);
+    TEST_ASSERT(os_dev_handle_lookup(&h_late) == &late);
+
+    /* Resetting the list drops cached devices. */
+    os_dev_reset();
+    TEST_ASSERT(os_dev_handle_lookup(&h_d2) == NULL);
+    TEST_ASSERT(os_dev_handle_lookup(&h_late) == NULL);
+
+    dev_test_setup();
+    TEST_ASSERT(os_dev_handle_lookup(&h_d2) == &g_dev_test_devs[2]);
+}
@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+TEST_CASE(os_dev_test_lookup)
+{
+    int i;
+
+    dev_test_setup();
+
+    TEST_ASSERT(os_dev_lookup("d0") == &g_dev_test_devs[0]);
+    TEST_ASSERT(os_dev_lookup("d1") == &g_dev_test_devs[1]);
+    TEST_ASSERT(os_dev_lookup("d2") == &g_dev_test_devs[2]);
+    TEST_ASSERT(os_dev_lookup("d3") == &g_dev_test_devs[3]);
+    TEST_ASSERT(os_dev_lookup("d") == NULL);
+    TEST_ASSERT(os_dev_lookup("d00") == NULL);
+    TEST_ASSERT(os_dev_lookup("") == NULL);
+
+    for (i = 0; i < DEV_TEST_NUM_DEVS; i++) {
+        TEST_ASSERT(os_dev_close(&g_dev_test_devs[i]) == 0);
+    }
+
+    /* Nothing is left once the list is reset. */
+    os_dev_reset();
+    TEST_ASSERT(os_dev_lookup("d0") == NULL);
+}
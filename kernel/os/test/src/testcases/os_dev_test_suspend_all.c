@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+TEST_CASE(os_dev_test_suspend_all)
+{
+    int rc;
+    int i;
+
+    dev_test_setup();
+
+    /*
+     * d1 and d2 share a level.  d2 is polled first (reverse order), stays
+     * busy once and is finished after d1; d0 only goes after both.
+     */
+    g_dev_test_busy[2] = 1;
+
+    rc = os_dev_suspend_all(0, 0);
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT_FATAL(g_dev_test_log_len == 5);
+    TEST_ASSERT(g_dev_test_log[0] == 3);
+    TEST_ASSERT(g_dev_test_log[1] == 2);
+    TEST_ASSERT(g_dev_test_log[2] == 1);
+    TEST_ASSERT(g_dev_test_log[3] == 2);
+    TEST_ASSERT(g_dev_test_log[4] == 0);
+
+    for (i = 0; i < DEV_TEST_NUM_DEVS; i++) {
+        TEST_ASSERT(g_dev_test_devs[i].od_flags & OS_DEV_F_STATUS_SUSPENDED);
+        TEST_ASSERT(!(g_dev_test_devs[i].od_flags & OS_DEV_F_PENDING));
+    }
+
+    g_dev_test_log_len = 0;
+    rc = os_dev_resume_all();
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT_FATAL(g_dev_test_log_len == 4);
+    for (i = 0; i < DEV_TEST_NUM_DEVS; i++) {
+        TEST_ASSERT(g_dev_test_log[i] == i);
+        TEST_ASSERT(!(g_dev_test_devs[i].od_flags &
+                      OS_DEV_F_STATUS_SUSPENDED));
+    }
+
+    /* Devices that were never suspended are skipped on resume. */
+    g_dev_test_log_len = 0;
+    rc = os_dev_resume_all();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(g_dev_test_log_len == 0);
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int os_mbuf_test_ext_freed;
+
+static void
+os_mbuf_test_ext_free_cb(struct os_mbuf_ext *ome)
+{
+    TEST_ASSERT(ome->ome_refcnt == 0);
+    os_mbuf_test_ext_freed++;
+}
+
+TEST_CASE(os_mbuf_test_ext)
+{
+    struct os_mbuf_ext ome;
+    struct os_mbuf *om;
+    struct os_mbuf *ext;
+    struct os_mbuf *dup;
+    uint8_t buf[500];
+    int rc;
+
+    os_mbuf_test_setup();
+
+    ome.ome_buf = os_mbuf_test_data;
+    ome.ome_len = 500;
+    ome.ome_refcnt = 0;
+    ome.ome_free_cb = os_mbuf_test_ext_free_cb;
+    ome.ome_arg = NULL;
+    os_mbuf_test_ext_freed = 0;
+
+    /*** Region outside the buffer. */
+    TEST_ASSERT(os_mbuf_get_ext(&os_mbuf_pool, &ome, 400, 101) == NULL);
+    TEST_ASSERT(os_mbuf_get_ext(&os_mbuf_pool, &ome, 501, 0) == NULL);
+
+    /*** Attach a region larger than a pool buffer to a packet. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ext = os_mbuf_get_ext(&os_mbuf_pool, &ome, 10, 490);
+    TEST_ASSERT_FATAL(ext != NULL);
+    TEST_ASSERT(OS_MBUF_IS_EXT(ext));
+    TEST_ASSERT(ext->om_data == os_mbuf_test_data + 10);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(ext) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(ext) == 0);
+    TEST_ASSERT(ome.ome_refcnt == 1);
+
+    os_mbuf_concat(om, ext);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 500);
+
+    rc = os_mbuf_copydata(om, 0, 500, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data, 500) == 0);
+
+    /*** Appending goes into a new mbuf and leaves the buffer alone. */
+    rc = os_mbuf_append(om, os_mbuf_test_data + 500, 20);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(SLIST_NEXT(ext, om_next) != NULL);
+    TEST_ASSERT(ext->om_len == 490);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 520);
+
+    /*** Trimming adjusts the reference only. */
+    os_mbuf_adj(om, 20);
+    TEST_ASSERT(ext->om_data == os_mbuf_test_data + 20);
+    os_mbuf_adj(om, -20);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 480);
+    rc = os_mbuf_copydata(om, 0, 480, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data + 20, 480) == 0);
+
+    /*** Duplicating shares the buffer. */
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(ome.ome_refcnt == 2);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 480);
+    TEST_ASSERT(SLIST_NEXT(dup, om_next)->om_data ==
+                os_mbuf_test_data + 20);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data + 20, 480) == 0);
+
+    /*** The free callback runs once the last reference is gone. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 0);
+    TEST_ASSERT(ome.ome_refcnt == 1);
+
+    rc = os_mbuf_free_chain(dup);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
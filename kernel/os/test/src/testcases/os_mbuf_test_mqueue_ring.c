@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+#include "os_test_priv.h"
+
+static int os_mbuf_test_mqr_ev_cnt;
+
+static void
+os_mbuf_test_mqr_ev_cb(struct os_event *ev)
+{
+    os_mbuf_test_mqr_ev_cnt++;
+}
+
+TEST_CASE(os_mbuf_test_mqueue_ring)
+{
+    struct os_mqueue_ring mqr;
+    struct os_mbuf *ring[4];
+    struct os_mbuf *m[5];
+    struct os_eventq evq;
+    struct os_event *ev;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+    os_eventq_init(&evq);
+
+    rc = os_mqueue_ring_init(&mqr, ring, 3, os_mbuf_test_mqr_ev_cb, NULL);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = os_mqueue_ring_init(&mqr, ring, 4, os_mbuf_test_mqr_ev_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_ASSERT(os_mqueue_ring_get(&mqr) == NULL);
+
+    for (i = 0; i < 5; i++) {
+        m[i] = os_mbuf_get(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(m[i] != NULL);
+    }
+
+    /* Only the first put into an empty ring posts the event. */
+    for (i = 0; i < 4; i++) {
+        rc = os_mqueue_ring_put(&mqr, &evq, m[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = os_mqueue_ring_put(&mqr, &evq, m[4]);
+    TEST_ASSERT(rc == OS_ENOMEM);
+
+    ev = os_eventq_get_no_wait(&evq);
+    TEST_ASSERT_FATAL(ev == &mqr.mqr_ev);
+    ev->ev_cb(ev);
+    TEST_ASSERT(os_mbuf_test_mqr_ev_cnt == 1);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+
+    /* Entries come out in order, wrapping around the ring. */
+    for (i = 0; i < 2; i++) {
+        TEST_ASSERT(os_mqueue_ring_get(&mqr) == m[i]);
+    }
+    rc = os_mqueue_ring_put(&mqr, &evq, m[4]);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+    for (i = 2; i < 5; i++) {
+        TEST_ASSERT(os_mqueue_ring_get(&mqr) == m[i]);
+    }
+    TEST_ASSERT(os_mqueue_ring_get(&mqr) == NULL);
+
+    /* Once drained, the next put posts the event again. */
+    rc = os_mqueue_ring_put(&mqr, &evq, m[0]);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == &mqr.mqr_ev);
+    TEST_ASSERT(os_mqueue_ring_get(&mqr) == m[0]);
+
+    for (i = 0; i < 5; i++) {
+        os_mbuf_free(m[i]);
+    }
+}
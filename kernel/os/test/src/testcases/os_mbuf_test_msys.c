@@ -0,0 +1,114 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define OMTM_MAX_POOLS  8
+
+static os_membuf_t omtm_small_membuf[OS_MEMPOOL_SIZE(2, 128)];
+static struct os_mempool omtm_small_mempool;
+static struct os_mbuf_pool omtm_small_pool;
+
+TEST_CASE(os_mbuf_test_msys)
+{
+    struct os_mbuf_pool *saved[OMTM_MAX_POOLS];
+    struct os_mbuf_pool *omp;
+    struct os_mbuf *om[4];
+    int num_saved;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    rc = os_mempool_init(&omtm_small_mempool, 2, 128, omtm_small_membuf,
+                         "msys_small");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&omtm_small_pool, &omtm_small_mempool, 128, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Swap the system's msys pools for the test pools. */
+    num_saved = 0;
+    for (omp = os_msys_pool_next(NULL); omp != NULL;
+         omp = os_msys_pool_next(omp)) {
+        TEST_ASSERT_FATAL(num_saved < OMTM_MAX_POOLS);
+        saved[num_saved++] = omp;
+    }
+    os_msys_reset();
+
+    /* Register the larger pool first; msys keeps them sorted. */
+    os_msys_register(&os_mbuf_pool);
+    os_msys_register(&omtm_small_pool);
+    TEST_ASSERT(os_msys_pool_next(NULL) == &omtm_small_pool);
+    TEST_ASSERT(os_msys_pool_next(&omtm_small_pool) == &os_mbuf_pool);
+    TEST_ASSERT(os_msys_pool_next(&os_mbuf_pool) == NULL);
+
+    /*** Best fit. */
+    om[0] = os_msys_get(50, 0);
+    TEST_ASSERT_FATAL(om[0] != NULL);
+    TEST_ASSERT(om[0]->om_omp == &omtm_small_pool);
+    om[1] = os_msys_get(200, 0);
+    TEST_ASSERT_FATAL(om[1] != NULL);
+    TEST_ASSERT(om[1]->om_omp == &os_mbuf_pool);
+
+    /*** Exhaust the small pool. */
+    om[2] = os_msys_get(50, 0);
+    TEST_ASSERT_FATAL(om[2] != NULL);
+    TEST_ASSERT(om[2]->om_omp == &omtm_small_pool);
+
+    om[3] = os_msys_get_pkthdr(40, 0);
+#if MYNEWT_VAL(OS_MSYS_FALLBACK)
+    TEST_ASSERT_FATAL(om[3] != NULL);
+    TEST_ASSERT(om[3]->om_omp == &os_mbuf_pool);
+#else
+    TEST_ASSERT(om[3] == NULL);
+#endif
+
+#if MYNEWT_VAL(OS_MSYS_STATS)
+    {
+        struct os_msys_stats oms;
+
+        os_msys_stats_get(&oms);
+        TEST_ASSERT(omtm_small_pool.omp_msys_req == 3);
+        TEST_ASSERT(os_mbuf_pool.omp_msys_req == 1);
+        TEST_ASSERT(omtm_small_pool.omp_msys_fallback ==
+                    MYNEWT_VAL(OS_MSYS_FALLBACK));
+        TEST_ASSERT(omtm_small_pool.omp_msys_fail ==
+                    !MYNEWT_VAL(OS_MSYS_FALLBACK));
+        TEST_ASSERT(oms.oms_hist[2] == 3);
+        TEST_ASSERT(oms.oms_hist[4] == 1);
+        TEST_ASSERT(oms.oms_size_max == 200);
+
+        os_msys_stats_reset();
+        os_msys_stats_get(&oms);
+        TEST_ASSERT(oms.oms_hist[2] == 0);
+        TEST_ASSERT(omtm_small_pool.omp_msys_req == 0);
+    }
+#endif
+
+    for (i = 0; i < 4; i++) {
+        if (om[i] != NULL) {
+            os_mbuf_free(om[i]);
+        }
+    }
+
+    os_msys_reset();
+    for (i = 0; i < num_saved; i++) {
+        os_msys_register(saved[i]);
+    }
+    os_mempool_unregister(&omtm_small_mempool);
+}
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mbuf_test_peek)
+{
+    struct os_iovec iov[4];
+    struct os_mbuf *om;
+    struct os_mbuf *om2;
+    const uint8_t *data;
+    uint8_t scratch[64];
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL, "Error allocating mbuf");
+    rc = os_mbuf_append(om, os_mbuf_test_data, 40);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL, "Error allocating mbuf");
+    rc = os_mbuf_append(om2, os_mbuf_test_data + 40, 20);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(om, om2);
+
+    /*** Within one mbuf: no copy. */
+    data = os_mbuf_peek(om, 10, 20, scratch);
+    TEST_ASSERT(data == om->om_data + 10);
+    data = os_mbuf_peek(om, 45, 15, NULL);
+    TEST_ASSERT(data == om2->om_data + 5);
+
+    /*** Spanning mbufs: copied into scratch. */
+    data = os_mbuf_peek(om, 30, 20, scratch);
+    TEST_ASSERT(data == scratch);
+    TEST_ASSERT(memcmp(data, os_mbuf_test_data + 30, 20) == 0);
+    TEST_ASSERT(os_mbuf_peek(om, 30, 20, NULL) == NULL);
+
+    /*** Out of range. */
+    TEST_ASSERT(os_mbuf_peek(om, 50, 11, scratch) == NULL);
+    TEST_ASSERT(os_mbuf_peek(om, 61, 0, scratch) == NULL);
+
+    /*** Chain unchanged. */
+    TEST_ASSERT(om->om_len == 40);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) == om2);
+
+    /*** I/O vector. */
+    rc = os_mbuf_iovec(om, 0, 60, iov, 4);
+    TEST_ASSERT(rc == 2);
+    TEST_ASSERT(iov[0].iov_base == om->om_data && iov[0].iov_len == 40);
+    TEST_ASSERT(iov[1].iov_base == om2->om_data && iov[1].iov_len == 20);
+
+    rc = os_mbuf_iovec(om, 35, 10, iov, 4);
+    TEST_ASSERT(rc == 2);
+    TEST_ASSERT(iov[0].iov_base == om->om_data + 35 && iov[0].iov_len == 5);
+    TEST_ASSERT(iov[1].iov_base == om2->om_data && iov[1].iov_len == 5);
+
+    rc = os_mbuf_iovec(om, 40, 20, iov, 4);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(iov[0].iov_base == om2->om_data && iov[0].iov_len == 20);
+
+    rc = os_mbuf_iovec(om, 0, 60, iov, 1);
+    TEST_ASSERT(rc == SYS_ENOMEM);
+    rc = os_mbuf_iovec(om, 10, 51, iov, 4);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mbuf_test_share)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *dup;
+    uint8_t buf[300];
+    uint8_t val;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 300);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 300);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data, 300) == 0);
+
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    /* Only the two headers were allocated, no data was copied. */
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free ==
+                MBUF_TEST_POOL_BUF_COUNT - 4);
+    TEST_ASSERT(dup->om_data == om->om_data);
+    TEST_ASSERT(OS_MBUF_IS_SHARED(om));
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
+#endif
+
+    /*** Writes to one chain do not show in the other. */
+    val = 0xaa;
+    rc = os_mbuf_copyinto(dup, 10, &val, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    val = 0x55;
+    rc = os_mbuf_copyinto(om, 290, &val, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_copydata(om, 0, 300, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[10] == os_mbuf_test_data[10]);
+    TEST_ASSERT(buf[290] == 0x55);
+
+    rc = os_mbuf_copydata(dup, 0, 300, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[10] == 0xaa);
+    TEST_ASSERT(buf[290] == os_mbuf_test_data[290]);
+
+    /*** Appending and prepending leave the other chain alone. */
+    rc = os_mbuf_append(dup, os_mbuf_test_data, 8);
+    TEST_ASSERT_FATAL(rc == 0);
+    om = os_mbuf_prepend(om, 4);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 304);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 308);
+    TEST_ASSERT(os_mbuf_cmpf(om, 4, os_mbuf_test_data, 290) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 300, os_mbuf_test_data, 8) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 11, os_mbuf_test_data + 11, 289) == 0);
+
+    /*** Everything returns to the pool. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT(rc == 0);
+    rc = os_mbuf_free_chain(dup);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define ALIGNED_TEST_ALIGN  32
+#define ALIGNED_TEST_BLKSZ  \
+    OS_MEMPOOL_ALIGNED_BLOCK_SZ(20, ALIGNED_TEST_ALIGN)
+
+TEST_CASE(os_mempool_test_aligned)
+{
+    static os_membuf_t buf[OS_MEMPOOL_SIZE(3, ALIGNED_TEST_BLKSZ)]
+        __attribute__((aligned(ALIGNED_TEST_ALIGN)));
+    struct os_mempool mp;
+    void *b[3];
+    int rc;
+    int i;
+
+    /*** Bad alignments are rejected. */
+    rc = os_mempool_init_aligned(&mp, 3, 20, buf, "aligned", 24);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+    rc = os_mempool_init_aligned(&mp, 3, 20, buf, "aligned",
+                                 OS_ALIGNMENT / 2);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+    rc = os_mempool_init_aligned(&mp, 3, 20, (uint8_t *)buf + OS_ALIGNMENT,
+                                 "aligned", ALIGNED_TEST_ALIGN);
+    TEST_ASSERT(rc == OS_MEM_NOT_ALIGNED);
+
+    rc = os_mempool_init_aligned(&mp, 3, 20, buf, "aligned",
+                                 ALIGNED_TEST_ALIGN);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mp.mp_block_size == ALIGNED_TEST_BLKSZ);
+    TEST_ASSERT(mp.mp_block_size >= 20);
+
+    /*** Every block starts on an alignment boundary. */
+    for (i = 0; i < 3; i++) {
+        b[i] = os_memblock_get(&mp);
+        TEST_ASSERT_FATAL(b[i] != NULL);
+        TEST_ASSERT(((uintptr_t)b[i] & (ALIGNED_TEST_ALIGN - 1)) == 0);
+        TEST_ASSERT((uint8_t *)b[i] + mp.mp_block_size <=
+                    (uint8_t *)buf + sizeof(buf));
+    }
+    TEST_ASSERT(os_memblock_get(&mp) == NULL);
+
+    for (i = 0; i < 3; i++) {
+        rc = os_memblock_put(&mp, b[i]);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(os_mempool_is_sane(&mp));
+
+    os_mempool_unregister(&mp);
+}
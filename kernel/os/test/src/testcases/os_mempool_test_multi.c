@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mempool_test_multi)
+{
+    static uint8_t buf16[OS_MEMPOOL_BYTES(2, 16)];
+    static uint8_t buf64[OS_MEMPOOL_BYTES(2, 64)];
+    static uint8_t buf32[OS_MEMPOOL_BYTES(2, 32)];
+    struct os_mempool_multi mpm;
+    struct os_mempool mp16;
+    struct os_mempool mp32;
+    struct os_mempool mp64;
+    void *b[6];
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&mp16, 2, 16, buf16, "multi16");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_init(&mp32, 2, 32, buf32, "multi32");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_init(&mp64, 2, 64, buf64, "multi64");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Register out of order; the allocator sorts by block size. */
+    os_mempool_multi_init(&mpm);
+    rc = os_mempool_multi_register(&mpm, &mp64);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_multi_register(&mpm, &mp16);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_multi_register(&mpm, &mp32);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Smallest fitting pool is used. */
+    b[0] = os_mempool_multi_get(&mpm, 10);
+    TEST_ASSERT(os_memblock_from(&mp16, b[0]));
+    b[1] = os_mempool_multi_get(&mpm, 17);
+    TEST_ASSERT(os_memblock_from(&mp32, b[1]));
+    b[2] = os_mempool_multi_get(&mpm, 64);
+    TEST_ASSERT(os_memblock_from(&mp64, b[2]));
+
+    /*** Too large. */
+    TEST_ASSERT(os_mempool_multi_get(&mpm, 65) == NULL);
+
+    /*** Exhausted pools spill over into larger ones. */
+    b[3] = os_mempool_multi_get(&mpm, 16);
+    TEST_ASSERT(os_memblock_from(&mp16, b[3]));
+    b[4] = os_mempool_multi_get(&mpm, 16);
+    TEST_ASSERT(os_memblock_from(&mp32, b[4]));
+    b[5] = os_mempool_multi_get(&mpm, 1);
+    TEST_ASSERT(os_memblock_from(&mp64, b[5]));
+    TEST_ASSERT(os_mempool_multi_get(&mpm, 1) == NULL);
+
+    /*** Frees are routed back to the owning pool. */
+    for (i = 0; i < 6; i++) {
+        rc = os_mempool_multi_put(&mpm, b[i]);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(mp16.mp_num_free == 2);
+    TEST_ASSERT(mp32.mp_num_free == 2);
+    TEST_ASSERT(mp64.mp_num_free == 2);
+
+    rc = os_mempool_multi_put(&mpm, &mpm);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+
+    os_mempool_unregister(&mp16);
+    os_mempool_unregister(&mp32);
+    os_mempool_unregister(&mp64);
+}
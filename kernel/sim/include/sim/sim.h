@@ -48,6 +48,31 @@ void sim_restore_sr(os_sr_t osr);
 int sim_in_critical(void);
 void sim_tick_idle(os_time_t ticks);
 
+/**
+ * Charges simulated time for work a device model pretends to do (a flash
+ * erase, a bus transfer...).  OS time and cputime move forward by the given
+ * amount on top of host time, so the time shows up in anything measured
+ * with the OS clocks.  Whole ticks are applied immediately, unless the
+ * caller is in a critical section, in which case they are applied on the
+ * next timer tick.
+ *
+ * @param nsecs                 Nanoseconds to charge.
+ */
+void sim_time_charge(uint64_t nsecs);
+
+/**
+ * Returns charged time that has not yet added up to a whole OS tick, in
+ * microseconds.  Used by the native timer to give cputime sub-tick
+ * resolution for charged time.  Must be called with interrupts disabled.
+ */
+uint32_t sim_time_subtick_usecs(void);
+
+/**
+ * Returns a microsecond clock: host monotonic time plus all time charged
+ * with sim_time_charge().
+ */
+uint64_t sim_time_usecs(void);
+
 /**
  * Prints information about a crash to stdout.  This functionality is defined
  * as a macro rather than a function to ensure that it gets inlined, enforcing
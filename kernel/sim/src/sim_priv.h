@@ -31,6 +31,7 @@ extern "C" {
 
 void sim_switch_tasks(void);
 void sim_tick(void);
+void sim_tick_warp(os_time_t ticks);
 void sim_signals_init(void);
 void sim_signals_cleanup(void);
 
@@ -36,6 +36,7 @@
 #include <setjmp.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <time.h>
 #include <assert.h>
 #include "sim/sim.h"
 #include "sim_priv.h"
@@ -45,6 +46,16 @@
 
 pid_t sim_pid;
 
+/*
+ * Time charged by device models through sim_time_charge().  The pending
+ * part is folded into OS ticks by sim_tick(); whatever is left over is less
+ * than a tick and is reported by sim_time_subtick_usecs().
+ */
+static uint64_t sim_charged_ns;
+static uint64_t sim_charge_pending_ns;
+
+#define SIM_NSEC_PER_TICK   ((uint64_t)OS_USEC_PER_TICK * 1000)
+
 void
 sim_switch_tasks(void)
 {
@@ -97,6 +108,7 @@ sim_tick(void)
         time_inited = 1;
     }
 
+    ticks = 0;
     gettimeofday(&time_now, NULL);
     if (timercmp(&time_now, &time_last, <)) {
         /*
@@ -106,7 +118,7 @@ sim_tick(void)
     } else {
         timersub(&time_now, &time_last, &time_diff);
 
-        ticks = time_diff.tv_sec * OS_TICKS_PER_SEC;
+        ticks += time_diff.tv_sec * OS_TICKS_PER_SEC;
         ticks += time_diff.tv_usec / OS_USEC_PER_TICK;
 
         /*
@@ -116,9 +128,76 @@ sim_tick(void)
         time_diff.tv_sec = 0;
         time_diff.tv_usec %= OS_USEC_PER_TICK;
         timersub(&time_now, &time_diff, &time_last);
+    }
+
+    ticks += sim_charge_pending_ns / SIM_NSEC_PER_TICK;
+    sim_charge_pending_ns %= SIM_NSEC_PER_TICK;
+
+    os_time_advance(ticks);
+}
+
+void
+sim_time_charge(uint64_t nsecs)
+{
+    os_sr_t sr;
+
+    if (nsecs == 0) {
+        return;
+    }
 
-        os_time_advance(ticks);
+    /*
+     * When the caller already has interrupts disabled the charge is left
+     * pending until the next timer tick; advancing OS time here could
+     * switch tasks under it.
+     */
+    if (sim_in_critical()) {
+        sim_charged_ns += nsecs;
+        sim_charge_pending_ns += nsecs;
+        return;
     }
+
+    OS_ENTER_CRITICAL(sr);
+    sim_charged_ns += nsecs;
+    sim_charge_pending_ns += nsecs;
+    sim_tick();
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+sim_tick_warp(os_time_t ticks)
+{
+    uint64_t nsecs;
+
+    OS_ASSERT_CRITICAL();
+
+    nsecs = (uint64_t)ticks * SIM_NSEC_PER_TICK;
+    sim_charged_ns += nsecs;
+    sim_charge_pending_ns += nsecs;
+    sim_tick();
+}
+
+uint32_t
+sim_time_subtick_usecs(void)
+{
+    OS_ASSERT_CRITICAL();
+
+    return sim_charge_pending_ns / 1000;
+}
+
+uint64_t
+sim_time_usecs(void)
+{
+    struct timespec ts;
+    uint64_t charged;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    charged = sim_charged_ns;
+    OS_EXIT_CRITICAL(sr);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 +
+           charged / 1000;
 }
 
 static void
@@ -243,8 +322,9 @@ sim_os_init(void)
     g_current_task = NULL;
 
     STAILQ_INIT(&g_os_task_list);
-    TAILQ_INIT(&g_os_run_list);
+    os_sched_run_list_init();
     TAILQ_INIT(&g_os_sleep_list);
+    TAILQ_INIT(&g_os_sleep_forever_list);
 
     sim_signals_init();
 
@@ -171,6 +171,14 @@ sim_tick_idle(os_time_t ticks)
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(SIM_TIME_WARP)
+    if (ticks > 0) {
+        /* Nothing to do until the next timeout; skip straight to it. */
+        sim_tick_warp(ticks);
+        return;
+    }
+#endif
+
     if (ticks > 0) {
         /*
          * Enter tickless regime and set the timer to fire after 'ticks'
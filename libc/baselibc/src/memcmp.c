@@ -3,12 +3,58 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+#include "syscfg/syscfg.h"
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
     int d = 0;
 
-#if defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7)
+#if MYNEWT_VAL(BASELIBC_MEM_OPT_SPEED) && \
+    (defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7))
+    /*
+     * Compare 8 bytes per iteration with unaligned word loads.  On a
+     * mismatch the words are byte reversed so that an unsigned compare
+     * orders them like the bytes in memory.  The tail is done bytewise.
+     */
+    const unsigned char *c1 = s1, *c2 = s2;
+    uint32_t w1, w2;
+
+    asm volatile (".syntax unified              \n"
+                  "   mov   %[d], #0           \n"
+                  "   b     2f                 \n"
+                  "1: ldr   %[w1], [%[c1]], #4 \n"
+                  "   ldr   %[w2], [%[c2]], #4 \n"
+                  "   cmp   %[w1], %[w2]       \n"
+                  "   bne   3f                 \n"
+                  "   ldr   %[w1], [%[c1]], #4 \n"
+                  "   ldr   %[w2], [%[c2]], #4 \n"
+                  "   cmp   %[w1], %[w2]       \n"
+                  "   bne   3f                 \n"
+                  "2: subs  %[n], #8           \n"
+                  "   bcs   1b                 \n"
+                  "   adds  %[n], #8           \n"
+                  "   b     4f                 \n"
+                  "3: rev   %[w1], %[w1]       \n"
+                  "   rev   %[w2], %[w2]       \n"
+                  "   cmp   %[w1], %[w2]       \n"
+                  "   ite   hi                 \n"
+                  "   movhi %[d], #1           \n"
+                  "   movls %[d], #-1          \n"
+                  "4:                          \n"
+                  : [d] "=&r" (d), [w1] "=&r" (w1), [w2] "=&r" (w2),
+                    [c1] "+r" (c1), [c2] "+r" (c2), [n] "+r" (n)
+                  :
+                  : "cc", "memory");
+
+    if (d == 0) {
+        while (n--) {
+            d = (int)*c1++ - (int)*c2++;
+            if (d)
+                break;
+        }
+    }
+#elif defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7)
     asm (".syntax unified                   \n"
          "       push  {r4, r5, r6}         \n"
          "       mov   r5, #0               \n"
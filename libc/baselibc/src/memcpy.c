@@ -4,6 +4,69 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BASELIBC_MEM_OPT_SPEED) && \
+    (defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7))
+/*
+ * ARMv7-M: align the destination, then move 16 bytes per iteration.  When
+ * the source ends up aligned too this is an LDM/STM pair; otherwise the
+ * loads are unaligned LDRs (LDM cannot be unaligned) feeding an aligned
+ * STM.  Leftover words and bytes are copied one at a time.
+ */
+static void
+memcpy_armv7m(uint8_t *q, const uint8_t *p, size_t n)
+{
+	if (n >= 16) {
+		while ((uintptr_t)q & 3) {
+			*q++ = *p++;
+			n--;
+		}
+
+		if (((uintptr_t)p & 3) == 0) {
+			asm volatile (".syntax unified                  \n"
+				      "   b     2f                     \n"
+				      "1: ldmia %[p]!, {r3, r4, r5, r12} \n"
+				      "   stmia %[q]!, {r3, r4, r5, r12} \n"
+				      "2: subs  %[n], #16              \n"
+				      "   bcs   1b                     \n"
+				      "   adds  %[n], #16              \n"
+				      : [p] "+r" (p), [q] "+r" (q), [n] "+r" (n)
+				      :
+				      : "r3", "r4", "r5", "r12", "cc", "memory");
+		} else {
+			asm volatile (".syntax unified                  \n"
+				      "   b     2f                     \n"
+				      "1: ldr   r3, [%[p]], #4         \n"
+				      "   ldr   r4, [%[p]], #4         \n"
+				      "   ldr   r5, [%[p]], #4         \n"
+				      "   ldr   r12, [%[p]], #4        \n"
+				      "   stmia %[q]!, {r3, r4, r5, r12} \n"
+				      "2: subs  %[n], #16              \n"
+				      "   bcs   1b                     \n"
+				      "   adds  %[n], #16              \n"
+				      : [p] "+r" (p), [q] "+r" (q), [n] "+r" (n)
+				      :
+				      : "r3", "r4", "r5", "r12", "cc", "memory");
+		}
+
+		asm volatile (".syntax unified                  \n"
+			      "   b     2f                     \n"
+			      "1: ldr   r3, [%[p]], #4         \n"
+			      "   str   r3, [%[q]], #4         \n"
+			      "2: subs  %[n], #4               \n"
+			      "   bcs   1b                     \n"
+			      "   adds  %[n], #4               \n"
+			      : [p] "+r" (p), [q] "+r" (q), [n] "+r" (n)
+			      :
+			      : "r3", "cc", "memory");
+	}
+
+	while (n--) {
+		*q++ = *p++;
+	}
+}
+#endif
 
 void *memcpy(void *dst, const void *src, size_t n)
 {
@@ -19,6 +82,9 @@ void *memcpy(void *dst, const void *src, size_t n)
 	asm volatile ("cld ; rep ; movsq ; movl %3,%%ecx ; rep ; movsb":"+c"
 		      (nq), "+S"(p), "+D"(q)
 		      :"r"((uint32_t) (n & 7)));
+#elif MYNEWT_VAL(BASELIBC_MEM_OPT_SPEED) && \
+    (defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7))
+	memcpy_armv7m((uint8_t *)q, (const uint8_t *)p, n);
 #elif defined(ARCH_cortex_m0) || defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7)
         (void)p;
         (void)q;
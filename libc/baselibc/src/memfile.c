@@ -1,20 +1,21 @@
 #include <stdio.h>
+#include <string.h>
 
 size_t memfile_write(FILE *instance, const char *bp, size_t n)
 {
     struct MemFile *f = (struct MemFile*)instance;
     size_t i = 0;
-    
-    while (n--)
+
+    if (f->bytes_written < f->size)
     {
-        f->bytes_written++;
-        if (f->bytes_written <= f->size)
-        {
-            *f->buffer++ = *bp++;
-            i++;
-        }
+        i = f->size - f->bytes_written;
+        if (i > n)
+            i = n;
+        memcpy(f->buffer, bp, i);
+        f->buffer += i;
     }
-    
+    f->bytes_written += n;
+
     return i;
 }
 
@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "syscfg/syscfg.h"
 
 void *memset(void *dst, int c, size_t n)
 {
@@ -20,6 +21,40 @@ void *memset(void *dst, int c, size_t n)
 		      :"+c" (nq), "+D" (q)
 		      : "a" ((unsigned char)c * 0x0101010101010101U),
 			"r" ((uint32_t) n & 7));
+#elif MYNEWT_VAL(BASELIBC_MEM_OPT_SPEED) && \
+    (defined(ARCH_cortex_m3) || defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7))
+	/*
+	 * Align, then store 16 bytes per STM and finish with single words
+	 * and bytes.
+	 */
+	if (n >= 16) {
+		while ((uintptr_t)q & 3) {
+			*q++ = c;
+			n--;
+		}
+
+		asm volatile (".syntax unified                  \n"
+			      "   mov   r3, %[w]               \n"
+			      "   mov   r4, %[w]               \n"
+			      "   mov   r5, %[w]               \n"
+			      "   mov   r12, %[w]              \n"
+			      "   b     2f                     \n"
+			      "1: stmia %[q]!, {r3, r4, r5, r12} \n"
+			      "2: subs  %[n], #16              \n"
+			      "   bcs   1b                     \n"
+			      "   adds  %[n], #12              \n"
+			      "   bcc   4f                     \n"
+			      "3: str   r3, [%[q]], #4         \n"
+			      "   subs  %[n], #4               \n"
+			      "   bcs   3b                     \n"
+			      "4: adds  %[n], #4               \n"
+			      : [q] "+r" (q), [n] "+r" (n)
+			      : [w] "r" ((unsigned char)c * 0x01010101U)
+			      : "r3", "r4", "r5", "r12", "cc", "memory");
+	}
+	while (n--) {
+		*q++ = c;
+	}
 #else
 	while (n--) {
 		*q++ = c;
@@ -64,6 +64,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdarg.h>
 #include <stdio.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include "os/mynewt.h"
 
@@ -197,6 +198,153 @@ static unsigned putchw(FILE *putp, struct param *p)
     return written;
 }
 
+#if MYNEWT_VAL(BASELIBC_PRINTF_FAST)
+/*
+ * Fast path for plain %d %i %u %x %X %p %c %s conversions with optional
+ * zero padding and width, on values that fit in 32 bits.  Digits are
+ * produced with 32-bit arithmetic only, and each field goes out in a
+ * handful of writes rather than one call per character.  Anything else
+ * (%ll, %o, '#', '-', floats) takes the generic path.
+ */
+
+/* n / 10 with shifts and adds; exact for all 32-bit n. */
+static uint32_t divu10(uint32_t n, uint32_t *rem)
+{
+    uint32_t q;
+    uint32_t r;
+
+    q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    r = n - ((q << 3) + (q << 1));
+    if (r > 9) {
+        q++;
+        r -= 10;
+    }
+    *rem = r;
+    return q;
+}
+
+/* Writes the digits of num right to left, ending at end. */
+static char *u32toa(uint32_t num, int base, int uc, char *end)
+{
+    const char *digits;
+    uint32_t r;
+    char *bf = end;
+
+    if (base == 10) {
+        do {
+            num = divu10(num, &r);
+            *--bf = '0' + r;
+        } while (num);
+    } else {
+        digits = uc ? "0123456789ABCDEF" : "0123456789abcdef";
+        do {
+            *--bf = digits[num & 0xf];
+            num >>= 4;
+        } while (num);
+    }
+    return bf;
+}
+
+static unsigned putpad(FILE *putp, char c, int n)
+{
+    static const char spaces[16] = "                ";
+    static const char zeros[16] = "0000000000000000";
+    const char *pad = (c == '0') ? zeros : spaces;
+    unsigned written = 0;
+    int chunk;
+
+    while (n > 0) {
+        chunk = n < (int)sizeof(spaces) ? n : (int)sizeof(spaces);
+        written += fwrite(pad, 1, chunk, putp);
+        n -= chunk;
+    }
+    return written;
+}
+
+/**
+ * Formats one conversion on the fast path.  Returns the number of
+ * characters written, or -1 without consuming an argument if the
+ * conversion has to take the generic path.
+ */
+static int tfp_fast(FILE *putp, char ch, char lng, struct param *p,
+                    va_list *va)
+{
+    char buf[10];
+    char *end = buf + sizeof(buf);
+    const char *bf;
+    unsigned written = 0;
+    uint32_t num;
+    int32_t snum;
+    int neg = 0;
+    int len;
+    int pad;
+
+    if (p->alt || p->left || (lng && sizeof(long) != sizeof(uint32_t))) {
+        return -1;
+    }
+
+    switch (ch) {
+    case 'd':
+    case 'i':
+        snum = lng ? va_arg(*va, long) : va_arg(*va, int);
+        if (snum < 0) {
+            neg = 1;
+            num = -(uint32_t)snum;
+        } else {
+            num = snum;
+        }
+        bf = u32toa(num, 10, 0, end);
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+        num = lng ? va_arg(*va, unsigned long) : va_arg(*va, unsigned int);
+        bf = u32toa(num, ch == 'u' ? 10 : 16, ch == 'X', end);
+        break;
+    case 'p':
+        if (sizeof(void *) != sizeof(uint32_t)) {
+            return -1;
+        }
+        num = (uintptr_t)va_arg(*va, void *);
+        bf = u32toa(num, 16, 0, end);
+        p->width = 2 * sizeof(void *);
+        p->lz = 1;
+        written += fwrite("0x", 1, 2, putp);
+        break;
+    case 'c':
+        buf[0] = va_arg(*va, int);
+        return fwrite(buf, 1, 1, putp);
+    case 's':
+        bf = va_arg(*va, char *);
+        end = (char *)bf + strlen(bf);
+        break;
+    default:
+        return -1;
+    }
+
+    len = end - bf;
+    pad = p->width - len - neg;
+    if (p->lz) {
+        if (neg) {
+            written += fwrite("-", 1, 1, putp);
+        }
+        written += putpad(putp, '0', pad);
+    } else {
+        written += putpad(putp, ' ', pad);
+        if (neg) {
+            written += fwrite("-", 1, 1, putp);
+        }
+    }
+    written += fwrite(bf, 1, len, putp);
+
+    return written;
+}
+#endif
+
 static unsigned long long
 intarg(int lng, int sign, va_list *va)
 {
@@ -240,6 +388,10 @@ size_t tfp_format(FILE *putp, const char *fmt, va_list va)
     char ch;
     char lng;
     void *v;
+#if MYNEWT_VAL(BASELIBC_PRINTF_FAST)
+    const char *lit;
+    int fast;
+#endif
 #if MYNEWT_VAL(FLOAT_USER)
     double d;
     int n;
@@ -249,7 +401,16 @@ size_t tfp_format(FILE *putp, const char *fmt, va_list va)
 
     while ((ch = *(fmt++))) {
         if (ch != '%') {
+#if MYNEWT_VAL(BASELIBC_PRINTF_FAST)
+            /* Pass the whole run of literal text on in one write. */
+            lit = fmt - 1;
+            while (*fmt && *fmt != '%') {
+                fmt++;
+            }
+            written += fwrite(lit, 1, fmt - lit, putp);
+#else
             written += putf(putp, ch);
+#endif
         } else {
             /* Init parameter struct */
             p.lz = 0;
@@ -299,6 +460,14 @@ size_t tfp_format(FILE *putp, const char *fmt, va_list va)
                 ch = *(fmt++);
             }
 
+#if MYNEWT_VAL(BASELIBC_PRINTF_FAST)
+            fast = tfp_fast(putp, ch, lng, &p, &va);
+            if (fast >= 0) {
+                written += fast;
+                continue;
+            }
+#endif
+
             switch (ch) {
             case 0:
                 goto abort;
@@ -85,6 +85,12 @@ int imgr_ver_str(struct image_version *ver, char *dst);
  */
 int imgr_read_info(int area_id, struct image_version *ver, uint8_t *hash, uint32_t *flags);
 
+/*
+ * Drops image info cached by imgr_read_info() (IMGMGR_INFO_CACHE).  Call
+ * after writing to an image slot without going through imgmgr.
+ */
+void imgr_info_invalidate(void);
+
 /*
  * Returns version number of current image (if available).
  */
@@ -106,6 +112,29 @@ int imgr_my_version(struct image_version *ver);
  */
 void imgr_set_upload_cb(imgr_upload_fn *cb, void *arg);
 
+/** Statistics for the most recent image upload. */
+struct imgmgr_upload_stats {
+    /** Image bytes accepted. */
+    uint32_t ius_bytes;
+
+    /** Chunks accepted. */
+    uint32_t ius_chunks;
+
+    /** Chunks dropped because of a wrong offset or a full upload window. */
+    uint32_t ius_drops;
+
+    /** OS time of the first chunk. */
+    uint32_t ius_start;
+
+    /** OS time of the last chunk; 0 while the upload is in progress. */
+    uint32_t ius_end;
+};
+
+/**
+ * Retrieves statistics for the current or most recent image upload.
+ */
+void imgmgr_upload_stats(struct imgmgr_upload_stats *out_stats);
+
 uint8_t imgmgr_state_flags(int query_slot);
 int imgmgr_state_slot_in_use(int slot);
 int imgmgr_state_set_pending(int slot, int permanent);
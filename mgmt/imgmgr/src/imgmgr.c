@@ -27,7 +27,11 @@
 #include "cborattr/cborattr.h"
 #include "bootutil/image.h"
 #include "bootutil/bootutil.h"
+#if MYNEWT_VAL(IMGMGR_DELTA)
+#include "bootutil/delta.h"
+#endif
 #include "mgmt/mgmt.h"
+#include "crc/crc16.h"
 #if MYNEWT_VAL(LOG_FCB_SLOT1)
 #include "log/log_fcb_slot1.h"
 #endif
@@ -36,6 +40,7 @@
 #include "imgmgr_priv.h"
 
 static int imgr_upload(struct mgmt_cbuf *);
+static int imgr_upload_query(struct mgmt_cbuf *);
 static int imgr_erase(struct mgmt_cbuf *);
 static int imgr_erase_state(struct mgmt_cbuf *);
 
@@ -43,6 +48,7 @@ static int imgr_erase_state(struct mgmt_cbuf *);
 struct imgr_upload_req {
     unsigned long long int off;     /* -1 if unspecified */
     unsigned long long int size;    /* -1 if unspecified */
+    unsigned long long int crc;     /* -1 if unspecified */
     size_t data_len;
     size_t data_sha_len;
     uint8_t img_data[MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)];
@@ -65,6 +71,12 @@ struct imgr_upload_action {
 
     /** Whether to erase the destination flash area. */
     bool erase;
+
+    /** Whether the upload is a delta image to be applied to slot 0. */
+    bool delta;
+
+    /** The number of bytes the image occupies in flash. */
+    uint32_t img_size;
 };
 
 static const struct mgmt_handler imgr_nmgr_handlers[] = {
@@ -73,7 +85,7 @@ static const struct mgmt_handler imgr_nmgr_handlers[] = {
         .mh_write = imgmgr_state_write,
     },
     [IMGMGR_NMGR_ID_UPLOAD] = {
-        .mh_read = NULL,
+        .mh_read = imgr_upload_query,
         .mh_write = imgr_upload
     },
     [IMGMGR_NMGR_ID_ERASE] = {
@@ -127,8 +139,20 @@ static struct {
     /** Hash of image data; used for resumption of a partial upload. */
     uint8_t data_sha_len;
     uint8_t data_sha[IMGMGR_DATA_SHA_LEN];
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    /** Whether the data is a delta image rather than a full one. */
+    bool delta;
+#endif
 } imgr_state;
 
+#if MYNEWT_VAL(IMGMGR_DELTA)
+/** Rebuilds the new image while a delta image is uploaded. */
+static struct bootutil_delta imgr_delta;
+#endif
+
+static struct imgmgr_upload_stats imgr_upload_stats;
+
 static imgr_upload_fn *imgr_upload_cb;
 static void *imgr_upload_arg;
 
@@ -140,6 +164,7 @@ static const char *imgmgr_err_str_no_slot = "no slot";
 static const char *imgmgr_err_str_flash_open_failed = "fa open fail";
 static const char *imgmgr_err_str_flash_erase_failed = "fa erase fail";
 static const char *imgmgr_err_str_flash_write_failed = "fa write fail";
+static const char *imgmgr_err_str_delta_failed = "delta fail";
 #else
 #define imgmgr_err_str_app_reject                   NULL
 #define imgmgr_err_str_hdr_malformed                NULL
@@ -148,6 +173,7 @@ static const char *imgmgr_err_str_flash_write_failed = "fa write fail";
 #define imgmgr_err_str_flash_open_failed            NULL
 #define imgmgr_err_str_flash_erase_failed           NULL
 #define imgmgr_err_str_flash_write_failed           NULL
+#define imgmgr_err_str_delta_failed                 NULL
 #endif
 
 #if MYNEWT_VAL(BOOTUTIL_IMAGE_FORMAT_V2)
@@ -182,6 +208,20 @@ imgr_img_tlvs(const struct flash_area *fa, struct image_header *hdr,
     return 0;
 }
 #endif
+
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+/** Result of the last flash read of an image slot. */
+struct imgr_info_entry {
+    bool valid;
+    int8_t rc;
+    uint32_t flags;
+    struct image_version ver;
+    uint8_t hash[IMGMGR_HASH_LEN];
+};
+
+static struct imgr_info_entry imgr_info_cache[IMGMGR_MAX_IMGS];
+#endif
+
 /*
  * Read version and build hash from image located slot "image_slot".  Note:
  * this is a slot index, not a flash area ID.
@@ -196,9 +236,9 @@ imgr_img_tlvs(const struct flash_area *fa, struct image_header *hdr,
  * Returns 1 if there is not a full image.
  * Returns 2 if slot is empty. XXXX not there yet
  */
-int
-imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
-               uint32_t *flags)
+static int
+imgr_read_info_flash(int image_slot, struct image_version *ver,
+                     uint8_t *hash, uint32_t *flags)
 {
     struct image_header *hdr;
     struct image_tlv *tlv;
@@ -290,6 +330,87 @@ end:
     return rc;
 }
 
+void
+imgr_info_invalidate(void)
+{
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+    int i;
+
+    for (i = 0; i < IMGMGR_MAX_IMGS; i++) {
+        imgr_info_cache[i].valid = false;
+    }
+#endif
+}
+
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+/*
+ * A slot that is being uploaded to changes under us; always go to flash for
+ * it.
+ */
+static bool
+imgr_info_cacheable(int image_slot)
+{
+    if (image_slot < 0 || image_slot >= IMGMGR_MAX_IMGS) {
+        return false;
+    }
+    if (imgr_state.area_id != -1 &&
+        imgr_state.area_id == flash_area_id_from_image_slot(image_slot)) {
+        return false;
+    }
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+    if (!imgr_window_idle()) {
+        return false;
+    }
+#endif
+    return true;
+}
+#endif
+
+int
+imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
+               uint32_t *flags)
+{
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+    struct imgr_info_entry *entry;
+    int rc;
+
+    if (!imgr_info_cacheable(image_slot)) {
+        return imgr_read_info_flash(image_slot, ver, hash, flags);
+    }
+
+    entry = &imgr_info_cache[image_slot];
+    if (!entry->valid) {
+        memset(entry, 0xff, sizeof(*entry));
+        rc = imgr_read_info_flash(image_slot, &entry->ver, entry->hash,
+                                  &entry->flags);
+        if (rc < 0) {
+            /* Read error; try again next time. */
+            entry->valid = false;
+            return rc;
+        }
+        entry->rc = rc;
+        entry->valid = true;
+    }
+
+    /* Copy out what the flash read would have filled in. */
+    if (ver) {
+        memcpy(ver, &entry->ver, sizeof(*ver));
+    }
+    if (entry->rc == 2) {
+        return entry->rc;
+    }
+    if (flags) {
+        *flags = entry->flags;
+    }
+    if (hash && entry->rc == 0) {
+        memcpy(hash, entry->hash, IMGMGR_HASH_LEN);
+    }
+    return entry->rc;
+#else
+    return imgr_read_info_flash(image_slot, ver, hash, flags);
+#endif
+}
+
 int
 imgr_my_version(struct image_version *ver)
 {
@@ -419,10 +540,18 @@ imgr_erase(struct mgmt_cbuf *cb)
         }
         rc = flash_area_erase(fa, 0, fa->fa_size);
         flash_area_close(fa);
+        imgr_info_invalidate();
         if (rc) {
             return imgr_error_rsp(cb, MGMT_ERR_EINVAL,
                                   imgmgr_err_str_flash_erase_failed);
         }
+
+        if (area_id == imgr_state.area_id) {
+            imgr_state.area_id = -1;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+            imgr_persist_clear();
+#endif
+        }
     } else {
         /*
          * No slot where to erase!
@@ -456,6 +585,7 @@ imgr_erase_state(struct mgmt_cbuf *cb)
         }
 
         rc = flash_area_erase(fa, 0, sizeof(struct image_header));
+        imgr_info_invalidate();
         if (rc) {
             return imgr_error_rsp(cb, MGMT_ERR_EINVAL,
                                   imgmgr_err_str_flash_erase_failed);
@@ -483,6 +613,40 @@ imgr_erase_state(struct mgmt_cbuf *cb)
     return 0;
 }
 
+#if MYNEWT_VAL(IMGMGR_DELTA)
+/**
+ * Checks that the first chunk of an upload is a delta image against the image
+ * currently in slot 0.
+ */
+static int
+imgr_upload_inspect_delta(const struct imgr_upload_req *req,
+                          struct imgr_upload_action *action,
+                          const char **errstr)
+{
+    const struct bootutil_delta_hdr *dhdr;
+    uint8_t hash[IMGMGR_HASH_LEN];
+    int rc;
+
+    dhdr = (const struct bootutil_delta_hdr *)req->img_data;
+    if (req->data_len < sizeof *dhdr ||
+        dhdr->bdh_magic != BOOTUTIL_DELTA_MAGIC) {
+
+        *errstr = imgmgr_err_str_magic_mismatch;
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = imgr_read_info(0, NULL, hash, NULL);
+    if (rc != 0 || memcmp(hash, dhdr->bdh_src_hash, sizeof hash) != 0) {
+        *errstr = imgmgr_err_str_delta_failed;
+        return MGMT_ERR_EINVAL;
+    }
+
+    action->delta = true;
+    action->img_size = dhdr->bdh_dst_size;
+    return 0;
+}
+#endif
+
 /**
  * Verifies an upload request and indicates the actions that should be taken
  * during processing of the request.  This is a "read only" function in the
@@ -531,11 +695,19 @@ imgr_upload_inspect(const struct imgr_upload_req *req,
             return MGMT_ERR_EINVAL;
         }
         action->size = req->size;
+        action->img_size = req->size;
 
         hdr = (struct image_header *)req->img_data;
         if (hdr->ih_magic != IMAGE_MAGIC) {
+#if MYNEWT_VAL(IMGMGR_DELTA)
+            rc = imgr_upload_inspect_delta(req, action, errstr);
+            if (rc != 0) {
+                return rc;
+            }
+#else
             *errstr = imgmgr_err_str_magic_mismatch;
             return MGMT_ERR_EINVAL;
+#endif
         }
 
         /*
@@ -576,6 +748,9 @@ imgr_upload_inspect(const struct imgr_upload_req *req,
         /* Continuation of upload. */
         action->area_id = imgr_state.area_id;
         action->size = imgr_state.size;
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        action->delta = imgr_state.delta;
+#endif
 
         if (req->off != imgr_state.off) {
             /*
@@ -627,16 +802,189 @@ imgr_upload_good_rsp(struct mgmt_cbuf *cb)
     return 0;
 }
 
+#if MYNEWT_VAL(IMGMGR_DELTA)
+static int
+imgr_delta_start(const struct flash_area *dst)
+{
+    const struct flash_area *src;
+    int rc;
+
+    rc = flash_area_open(flash_area_id_from_image_slot(0), &src);
+    if (rc != 0) {
+        return MGMT_ERR_EUNKNOWN;
+    }
+
+    bootutil_delta_init(&imgr_delta, src, dst);
+    return 0;
+}
+
+/**
+ * Applies the next chunk of a delta image.  The new image is complete and
+ * flushed to flash once the last chunk has been processed.
+ */
+static int
+imgr_delta_write(const void *data, uint32_t len, bool last)
+{
+    int rc;
+
+    rc = bootutil_delta_process(&imgr_delta, data, len);
+    if (rc == 0 && last) {
+        rc = bootutil_delta_finish(&imgr_delta);
+    }
+    if (rc != 0) {
+        /* The rebuilt image is unusable; the upload must restart. */
+        imgr_state.area_id = -1;
+        return MGMT_ERR_EINVAL;
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+/**
+ * Records upload progress so the upload can be resumed after a reset.
+ * Progress is written every IMGMGR_UPLOAD_PERSIST_INTERVAL bytes, when the
+ * upload completes, and if force is set.
+ */
+static void
+imgr_upload_persist(bool force)
+{
+    static uint32_t last_off;
+    uint32_t off;
+
+    if (imgr_state.area_id == -1) {
+        imgr_persist_clear();
+        return;
+    }
+
+    /* Only record data that is known to be in flash. */
+    off = imgr_state.off;
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+    off -= imgr_window_pending_bytes();
+#endif
+
+    if (force || off < last_off ||
+        off - last_off >= MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST_INTERVAL)) {
+
+        imgr_persist_save(imgr_state.area_id, imgr_state.size, off,
+                          imgr_state.data_sha, imgr_state.data_sha_len);
+        last_off = off;
+    }
+}
+
+/**
+ * Restores the state of an upload interrupted by a reset.  Data may have
+ * been written past the persisted offset, so the upload resumes after the
+ * last programmed byte.
+ */
+int
+imgr_upload_restore(int area_id, uint32_t size, uint32_t off,
+                    const uint8_t *sha, uint8_t sha_len)
+{
+    const struct flash_area *fa;
+    uint8_t buf[64];
+    uint32_t end;
+    uint32_t chunk;
+    uint8_t align;
+    int rc;
+    int i;
+
+    rc = flash_area_open(area_id, &fa);
+    if (rc != 0) {
+        return rc;
+    }
+    if (off > size || size > fa->fa_size) {
+        flash_area_close(fa);
+        return OS_EINVAL;
+    }
+
+    /* Scan backwards for the last byte that is not erased. */
+    end = size;
+    while (end > off) {
+        chunk = end - off;
+        if (chunk > sizeof buf) {
+            chunk = sizeof buf;
+        }
+        rc = flash_area_read(fa, end - chunk, buf, chunk);
+        if (rc != 0) {
+            flash_area_close(fa);
+            return rc;
+        }
+        for (i = chunk - 1; i >= 0; i--) {
+            if (buf[i] != 0xff) {
+                break;
+            }
+        }
+        if (i >= 0) {
+            end -= chunk - i - 1;
+            break;
+        }
+        end -= chunk;
+    }
+
+    align = flash_area_align(fa);
+    end = (end + align - 1) / align * align;
+    if (end > size) {
+        end = size;
+    }
+    flash_area_close(fa);
+
+    imgr_state.area_id = area_id;
+    imgr_state.size = size;
+    imgr_state.off = end;
+    imgr_state.data_sha_len = sha_len;
+    memcpy(imgr_state.data_sha, sha, sha_len);
+
+#if MYNEWT_VAL(LOG_FCB_SLOT1)
+    if (area_id == FLASH_AREA_IMAGE_1) {
+        log_fcb_slot1_lock();
+    }
+#endif
+
+    return 0;
+}
+#endif
+
+/**
+ * Reports the state of the upload in progress, if any.  The image data in
+ * [off, len) is still missing.
+ */
+static int
+imgr_upload_query(struct mgmt_cbuf *cb)
+{
+    CborError err = CborNoError;
+
+    err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    if (imgr_state.area_id != -1) {
+        err |= cbor_encode_text_stringz(&cb->encoder, "off");
+        err |= cbor_encode_uint(&cb->encoder, imgr_state.off);
+        err |= cbor_encode_text_stringz(&cb->encoder, "len");
+        err |= cbor_encode_uint(&cb->encoder, imgr_state.size);
+        err |= cbor_encode_text_stringz(&cb->encoder, "sha");
+        err |= cbor_encode_byte_string(&cb->encoder, imgr_state.data_sha,
+                                       imgr_state.data_sha_len);
+    }
+
+    if (err != 0) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
 static int
 imgr_upload(struct mgmt_cbuf *cb)
 {
     struct imgr_upload_req req = {
         .off = -1,
         .size = -1,
+        .crc = -1,
         .data_len = 0,
         .data_sha_len = 0,
     };
-    const struct cbor_attr_t off_attr[5] = {
+    const struct cbor_attr_t off_attr[6] = {
         [0] = {
             .attribute = "data",
             .type = CborAttrByteStringType,
@@ -663,14 +1011,21 @@ imgr_upload(struct mgmt_cbuf *cb)
             .addr.bytestring.len = &req.data_sha_len,
             .len = sizeof(req.data_sha)
         },
-        [4] = { 0 },
+        [4] = {
+            .attribute = "crc",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &req.crc,
+            .nodefault = true
+        },
+        [5] = { 0 },
     };
+    CBORATTR_INDEX_DEFINE(off_idx, 5);
     int rc;
     const char *errstr = NULL;
     struct imgr_upload_action action;
     const struct flash_area *fa = NULL;
 
-    rc = cbor_read_object(&cb->it, off_attr);
+    rc = cbor_read_object_indexed(&cb->it, off_attr, &off_idx);
     if (rc != 0) {
         return MGMT_ERR_EINVAL;
     }
@@ -685,9 +1040,26 @@ imgr_upload(struct mgmt_cbuf *cb)
         /* Request specifies incorrect offset.  Respond with a success code and
          * the correct offset.
          */
+        imgr_upload_stats.ius_drops++;
+        return imgr_upload_good_rsp(cb);
+    }
+
+    if (req.crc != -1 &&
+        crc16_ccitt(0, req.img_data, req.data_len) != req.crc) {
+        /* Corrupted chunk.  Drop it; the response tells the client where to
+         * resume from.
+         */
+        imgr_upload_stats.ius_drops++;
         return imgr_upload_good_rsp(cb);
     }
 
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+    if (req.off == 0 && !imgr_window_idle()) {
+        /* Writes from an abandoned upload are still in flight. */
+        return MGMT_ERR_EBADSTATE;
+    }
+#endif
+
     /* Request is valid.  Give the application a chance to reject this upload
      * request.
      */
@@ -701,6 +1073,9 @@ imgr_upload(struct mgmt_cbuf *cb)
     /* Remember flash area ID and image size for subsequent upload requests. */
     imgr_state.area_id = action.area_id;
     imgr_state.size = action.size;
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    imgr_state.delta = action.delta;
+#endif
 
     rc = flash_area_open(imgr_state.area_id, &fa);
     if (rc != 0) {
@@ -714,6 +1089,9 @@ imgr_upload(struct mgmt_cbuf *cb)
          */
         imgr_state.off = 0;
 
+        memset(&imgr_upload_stats, 0, sizeof imgr_upload_stats);
+        imgr_upload_stats.ius_start = os_time_get();
+
         /*
          * We accept SHA trimmed to any length by client since it's up to client
          * to make sure provided data are good enough to avoid collisions when
@@ -735,31 +1113,87 @@ imgr_upload(struct mgmt_cbuf *cb)
 #endif
 
         if (action.erase) {
-            rc = flash_area_erase(fa, 0, req.size);
+            rc = flash_area_erase(fa, 0, action.img_size);
             if (rc != 0) {
                 rc = MGMT_ERR_EUNKNOWN;
                 errstr = imgmgr_err_str_flash_erase_failed;
             }
         }
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+        if (rc == 0) {
+            imgr_upload_persist(true);
+        }
+#endif
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        if (rc == 0 && action.delta) {
+            rc = imgr_delta_start(fa);
+            if (rc != 0) {
+                errstr = imgmgr_err_str_flash_open_failed;
+            }
+        }
+#endif
     }
 
     /* Write the image data to flash. */
     if (rc == 0 && req.data_len != 0) {
-        rc = flash_area_write(fa, req.off, req.img_data, action.write_bytes);
-        if (rc != 0) {
-            rc = MGMT_ERR_EUNKNOWN;
-            errstr = imgmgr_err_str_flash_write_failed;
-        } else {
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        if (action.delta) {
+            rc = imgr_delta_write(req.img_data, action.write_bytes,
+                                  req.off + action.write_bytes ==
+                                  imgr_state.size);
+            if (rc != 0) {
+                errstr = imgmgr_err_str_delta_failed;
+            }
+        } else
+#endif
+        {
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+            rc = imgr_window_write(fa, req.off, req.img_data,
+                                   action.write_bytes,
+                                   req.off + action.write_bytes ==
+                                   imgr_state.size);
+            if (rc == IMGR_WINDOW_BUSY) {
+                /* Not accepted; the client resends from the acked offset. */
+                imgr_upload_stats.ius_drops++;
+                flash_area_close(fa);
+                return imgr_upload_good_rsp(cb);
+            }
+            if (rc != 0) {
+                imgr_state.area_id = -1;
+                errstr = imgmgr_err_str_flash_write_failed;
+            }
+#else
+            rc = flash_area_write(fa, req.off, req.img_data,
+                                  action.write_bytes);
+            if (rc != 0) {
+                rc = MGMT_ERR_EUNKNOWN;
+                errstr = imgmgr_err_str_flash_write_failed;
+            }
+#endif
+        }
+
+        if (rc == 0) {
             imgr_state.off += action.write_bytes;
+            imgr_upload_stats.ius_bytes += action.write_bytes;
+            imgr_upload_stats.ius_chunks++;
             if (imgr_state.off == imgr_state.size) {
                 /* Done */
                 imgr_state.area_id = -1;
+                imgr_upload_stats.ius_end = os_time_get();
             }
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+            imgr_upload_persist(false);
+#endif
         }
     }
 
     flash_area_close(fa);
 
+    /* The slot was erased or written. */
+    imgr_info_invalidate();
+
     if (rc != 0) {
         return imgr_error_rsp(cb, rc, errstr);
     }
@@ -767,6 +1201,12 @@ imgr_upload(struct mgmt_cbuf *cb)
     return imgr_upload_good_rsp(cb);
 }
 
+void
+imgmgr_upload_stats(struct imgmgr_upload_stats *out_stats)
+{
+    *out_stats = imgr_upload_stats;
+}
+
 void
 imgr_set_upload_cb(imgr_upload_fn *cb, void *arg)
 {
@@ -782,6 +1222,8 @@ imgmgr_module_init(void)
     /* Ensure this function only gets called by sysinit. */
     SYSINIT_ASSERT_ACTIVE();
 
+    imgr_state.area_id = -1;
+
     rc = mgmt_group_register(&imgr_nmgr_group);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
@@ -790,6 +1232,11 @@ imgmgr_module_init(void)
     SYSINIT_PANIC_ASSERT(rc == 0);
 #endif
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+    rc = imgr_persist_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
 #if MYNEWT_VAL(LOG_FCB_SLOT1)
     /*
      * If logging to slot1 is enabled, make sure we lock it if slot1 is in use
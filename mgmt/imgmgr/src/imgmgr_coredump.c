@@ -76,11 +76,9 @@ imgr_core_load(struct mgmt_cbuf *cb)
     int sz;
     const struct flash_area *fa;
     uint8_t data[MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)];
-    struct coredump_header *hdr;
+    uint32_t size;
     CborError g_err = CborNoError;
 
-    hdr = (struct coredump_header *)data;
-
     rc = cbor_read_object(&cb->it, dload_attr);
     if (rc || off == UINT_MAX) {
         return MGMT_ERR_EINVAL;
@@ -91,24 +89,28 @@ imgr_core_load(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
 
-    rc = flash_area_read(fa, 0, hdr, sizeof(*hdr));
-    if (rc) {
-        rc = MGMT_ERR_EINVAL;
+    /*
+     * Serve the corefile with compressed memory expanded, so that tools
+     * reading it don't need to know about compression.
+     */
+    rc = coredump_size(fa, &size);
+    if (rc == SYS_ENOENT) {
+        rc = MGMT_ERR_ENOENT;
         goto err_close;
     }
-    if (hdr->ch_magic != COREDUMP_MAGIC) {
-        rc = MGMT_ERR_ENOENT;
+    if (rc) {
+        rc = MGMT_ERR_EINVAL;
         goto err_close;
     }
-    if (off > hdr->ch_size) {
-        off = hdr->ch_size;
+    if (off > size) {
+        off = size;
     }
-    sz = hdr->ch_size - off;
+    sz = size - off;
     if (sz > sizeof(data)) {
         sz = sizeof(data);
     }
 
-    rc = flash_area_read(fa, off, data, sz);
+    rc = coredump_read(fa, off, data, sz);
     if (rc) {
         rc = MGMT_ERR_EINVAL;
         goto err_close;
@@ -124,7 +126,7 @@ imgr_core_load(struct mgmt_cbuf *cb)
     /* Only include length in first response. */
     if (off == 0) {
         g_err |= cbor_encode_text_stringz(&cb->encoder, "len");
-        g_err |= cbor_encode_uint(&cb->encoder, hdr->ch_size);
+        g_err |= cbor_encode_uint(&cb->encoder, size);
     }
 
     flash_area_close(fa);
@@ -157,6 +159,8 @@ imgr_core_erase(struct mgmt_cbuf *cb)
     if (rc == 0 &&
       (hdr.ch_magic == COREDUMP_MAGIC || hdr.ch_magic == 0xffffffff)) {
         rc = flash_area_erase(fa, 0, fa->fa_size);
+        /* The coredump area may double as an image slot. */
+        imgr_info_invalidate();
         if (rc != 0) {
             return MGMT_ERR_EINVAL;
         }
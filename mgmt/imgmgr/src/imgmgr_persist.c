@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+
+#include <string.h>
+
+#include "config/config.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Progress of an interrupted upload, persisted as "imgmgr/upload".  An empty
+ * value means no upload is in progress.
+ */
+struct imgr_persist_rec {
+    int8_t ipr_area_id;
+    uint8_t ipr_sha_len;
+    uint32_t ipr_size;
+    uint32_t ipr_off;
+    uint8_t ipr_sha[IMGMGR_DATA_SHA_LEN];
+};
+
+static struct imgr_persist_rec imgr_persist_loaded;
+static bool imgr_persist_have_loaded;
+
+static int imgr_persist_conf_set(int argc, char **argv, char *val);
+static int imgr_persist_conf_commit(void);
+
+static struct conf_handler imgr_persist_conf_handler = {
+    .ch_name = "imgmgr",
+    .ch_get = NULL,
+    .ch_set = imgr_persist_conf_set,
+    .ch_commit = imgr_persist_conf_commit,
+    .ch_export = NULL,
+};
+
+static int
+imgr_persist_conf_set(int argc, char **argv, char *val)
+{
+    int len;
+    int rc;
+
+    if (argc != 1 || strcmp(argv[0], "upload") != 0) {
+        return OS_ENOENT;
+    }
+
+    imgr_persist_have_loaded = false;
+    if (val == NULL || val[0] == '\0') {
+        return 0;
+    }
+
+    len = sizeof imgr_persist_loaded;
+    rc = conf_bytes_from_str(val, &imgr_persist_loaded, &len);
+    if (rc != 0 || len != sizeof imgr_persist_loaded ||
+        imgr_persist_loaded.ipr_sha_len > IMGMGR_DATA_SHA_LEN) {
+
+        return OS_EINVAL;
+    }
+
+    imgr_persist_have_loaded = true;
+    return 0;
+}
+
+static int
+imgr_persist_conf_commit(void)
+{
+    if (!imgr_persist_have_loaded) {
+        return 0;
+    }
+    imgr_persist_have_loaded = false;
+
+    return imgr_upload_restore(imgr_persist_loaded.ipr_area_id,
+                               imgr_persist_loaded.ipr_size,
+                               imgr_persist_loaded.ipr_off,
+                               imgr_persist_loaded.ipr_sha,
+                               imgr_persist_loaded.ipr_sha_len);
+}
+
+int
+imgr_persist_save(int area_id, uint32_t size, uint32_t off,
+                  const uint8_t *sha, uint8_t sha_len)
+{
+    struct imgr_persist_rec rec;
+    char buf[CONF_STR_FROM_BYTES_LEN(sizeof rec)];
+
+    memset(&rec, 0, sizeof rec);
+    rec.ipr_area_id = area_id;
+    rec.ipr_sha_len = sha_len;
+    rec.ipr_size = size;
+    rec.ipr_off = off;
+    memcpy(rec.ipr_sha, sha, sha_len);
+
+    if (conf_str_from_bytes(&rec, sizeof rec, buf, sizeof buf) == NULL) {
+        return OS_EINVAL;
+    }
+
+    return conf_save_one("imgmgr/upload", buf);
+}
+
+int
+imgr_persist_clear(void)
+{
+    return conf_save_one("imgmgr/upload", "");
+}
+
+int
+imgr_persist_init(void)
+{
+    return conf_register(&imgr_persist_conf_handler);
+}
+
+#endif
@@ -67,6 +67,7 @@ struct imgmgr_upload_cmd {
  *      "off":<offset>,
  *      "len":<img_size>		inspected when off = 0
  *      "data":<base64encoded binary>
+ *      "crc":<crc16-ccitt of data>	optional; chunk dropped on mismatch
  * }
  *
  *
@@ -76,6 +77,14 @@ struct imgmgr_upload_cmd {
  * }
  *
  *
+ * Response to upload read (upload in progress):
+ * {
+ *      "off":<offset>			data in [off, len) is missing
+ *      "len":<img_size>
+ *      "sha":<data sha>
+ * }
+ *
+ *
  * Request to image upload:
  * {
  *      "off":<offset>
@@ -96,6 +105,27 @@ int imgr_find_by_ver(struct image_version *find, uint8_t *hash);
 int imgr_find_by_hash(uint8_t *find, struct image_version *ver);
 int imgr_cli_register(void);
 
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+struct flash_area;
+
+/** Returned by imgr_window_write() when the chunk cannot be taken yet. */
+#define IMGR_WINDOW_BUSY        (-1)
+
+int imgr_window_write(const struct flash_area *fa, uint32_t off,
+                      const void *data, uint32_t len, bool last);
+int imgr_window_idle(void);
+uint32_t imgr_window_pending_bytes(void);
+#endif
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_PERSIST)
+int imgr_persist_init(void);
+int imgr_persist_save(int area_id, uint32_t size, uint32_t off,
+                      const uint8_t *sha, uint8_t sha_len);
+int imgr_persist_clear(void);
+int imgr_upload_restore(int area_id, uint32_t size, uint32_t off,
+                        const uint8_t *sha, uint8_t sha_len);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
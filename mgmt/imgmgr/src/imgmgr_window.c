@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(IMGMGR_WINDOW)
+
+#include <string.h>
+
+#include "flash_map/flash_map.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Windowed upload: a chunk is acknowledged as soon as it has been copied into
+ * one of the window buffers and its flash write queued.  The client can keep
+ * several chunks in flight and only needs to go back to the acknowledged
+ * offset when a chunk is dropped.  The final chunk is only accepted once all
+ * earlier writes are done, so an acknowledged image is complete in flash.
+ */
+struct imgr_window_buf {
+    struct flash_area_req iwb_req;
+    bool iwb_busy;
+    uint16_t iwb_len;
+    uint8_t iwb_data[MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)];
+};
+
+static struct {
+    struct imgr_window_buf bufs[MYNEWT_VAL(IMGMGR_WINDOW_SIZE)];
+    int pending;
+    uint32_t pending_bytes;
+
+    /** First write error since the window was last checked. */
+    int err;
+} imgr_window;
+
+static void
+imgr_window_write_done(struct os_event *ev)
+{
+    struct imgr_window_buf *buf;
+
+    buf = ev->ev_arg;
+    if (buf->iwb_req.far_rc != 0 && imgr_window.err == 0) {
+        imgr_window.err = buf->iwb_req.far_rc;
+    }
+
+    buf->iwb_busy = false;
+    imgr_window.pending--;
+    imgr_window.pending_bytes -= buf->iwb_len;
+}
+
+int
+imgr_window_idle(void)
+{
+    return imgr_window.pending == 0;
+}
+
+uint32_t
+imgr_window_pending_bytes(void)
+{
+    return imgr_window.pending_bytes;
+}
+
+int
+imgr_window_write(const struct flash_area *fa, uint32_t off, const void *data,
+                  uint32_t len, bool last)
+{
+    struct imgr_window_buf *buf;
+    int rc;
+    int i;
+
+    if (imgr_window.err != 0) {
+        imgr_window.err = 0;
+        return MGMT_ERR_EUNKNOWN;
+    }
+
+    if (last) {
+        if (!imgr_window_idle()) {
+            return IMGR_WINDOW_BUSY;
+        }
+        rc = flash_area_write(fa, off, data, len);
+        if (rc != 0) {
+            return MGMT_ERR_EUNKNOWN;
+        }
+        return 0;
+    }
+
+    buf = NULL;
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_WINDOW_SIZE); i++) {
+        if (!imgr_window.bufs[i].iwb_busy) {
+            buf = &imgr_window.bufs[i];
+            break;
+        }
+    }
+    if (buf == NULL) {
+        return IMGR_WINDOW_BUSY;
+    }
+
+    memcpy(buf->iwb_data, data, len);
+    buf->iwb_req.far_ev.ev_cb = imgr_window_write_done;
+    buf->iwb_req.far_ev.ev_arg = buf;
+    buf->iwb_req.far_evq = mgmt_evq_get();
+
+    rc = flash_area_write_async(fa, off, buf->iwb_data, len, &buf->iwb_req);
+    if (rc != 0) {
+        return MGMT_ERR_EUNKNOWN;
+    }
+
+    buf->iwb_busy = true;
+    buf->iwb_len = len;
+    imgr_window.pending++;
+    imgr_window.pending_bytes += len;
+    return 0;
+}
+
+#endif
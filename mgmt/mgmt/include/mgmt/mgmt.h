@@ -113,6 +113,54 @@ const struct mgmt_handler *mgmt_find_handler(uint16_t group_id,
 struct os_eventq *mgmt_evq_get(void);
 void mgmt_evq_set(struct os_eventq *evq);
 
+#if MYNEWT_VAL(MGMT_METRICS)
+/**
+ * Counters for one group/command pair.  Times are in microseconds.
+ */
+struct mgmt_metrics_entry {
+    uint16_t mme_group;
+    uint8_t mme_id;
+    uint32_t mme_count;
+    uint32_t mme_bytes_in;
+    uint32_t mme_bytes_out;
+    uint32_t mme_handler_total;
+    uint32_t mme_handler_max;
+    uint32_t mme_wait_total;
+    uint32_t mme_wait_max;
+};
+
+void mgmt_metrics_init(void);
+
+/**
+ * Accounts for one handled request.  Safe to call from any task.
+ *
+ * @param group_id              The request's group.
+ * @param handler_id            The request's command ID.
+ * @param bytes_in              Request payload length.
+ * @param bytes_out             Response payload length.
+ * @param handler_usecs         Time spent in the handler.
+ * @param wait_usecs            Time between reception of the request and
+ *                                  the start of the handler.
+ */
+void mgmt_metrics_record(uint16_t group_id, uint8_t handler_id,
+                         uint32_t bytes_in, uint32_t bytes_out,
+                         uint32_t handler_usecs, uint32_t wait_usecs);
+
+/**
+ * Copies out the idx'th tracked entry.
+ *
+ * @return                      0 on success; SYS_ENOENT if there is no
+ *                                  such entry.
+ */
+int mgmt_metrics_get(int idx, struct mgmt_metrics_entry *out);
+
+/**
+ * Clears the per command table.  The stats group is left alone; it can be
+ * cleared through the stats API.
+ */
+void mgmt_metrics_reset(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
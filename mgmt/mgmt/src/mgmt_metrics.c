@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(MGMT_METRICS)
+
+#include <string.h>
+
+#include "stats/stats.h"
+#include "mgmt/mgmt.h"
+
+STATS_SECT_START(mgmt_stats)
+    STATS_SECT_ENTRY(requests)
+    STATS_SECT_ENTRY(bytes_in)
+    STATS_SECT_ENTRY(bytes_out)
+    STATS_SECT_ENTRY(handler_us)
+    STATS_SECT_ENTRY(wait_us)
+    STATS_SECT_ENTRY(untracked)
+STATS_SECT_END
+
+STATS_NAME_START(mgmt_stats)
+    STATS_NAME(mgmt_stats, requests)
+    STATS_NAME(mgmt_stats, bytes_in)
+    STATS_NAME(mgmt_stats, bytes_out)
+    STATS_NAME(mgmt_stats, handler_us)
+    STATS_NAME(mgmt_stats, wait_us)
+    STATS_NAME(mgmt_stats, untracked)
+STATS_NAME_END(mgmt_stats)
+
+static STATS_SECT_DECL(mgmt_stats) mgmt_stats;
+
+static struct mgmt_metrics_entry
+    mgmt_metrics[MYNEWT_VAL(MGMT_METRICS_MAX_ENTRIES)];
+static int mgmt_metrics_cnt;
+
+/* Must be called with interrupts disabled. */
+static struct mgmt_metrics_entry *
+mgmt_metrics_find(uint16_t group_id, uint8_t handler_id)
+{
+    struct mgmt_metrics_entry *mme;
+    int i;
+
+    for (i = 0; i < mgmt_metrics_cnt; i++) {
+        mme = &mgmt_metrics[i];
+        if (mme->mme_group == group_id && mme->mme_id == handler_id) {
+            return mme;
+        }
+    }
+
+    if (mgmt_metrics_cnt >= MYNEWT_VAL(MGMT_METRICS_MAX_ENTRIES)) {
+        return NULL;
+    }
+
+    mme = &mgmt_metrics[mgmt_metrics_cnt++];
+    memset(mme, 0, sizeof(*mme));
+    mme->mme_group = group_id;
+    mme->mme_id = handler_id;
+
+    return mme;
+}
+
+void
+mgmt_metrics_record(uint16_t group_id, uint8_t handler_id,
+                    uint32_t bytes_in, uint32_t bytes_out,
+                    uint32_t handler_usecs, uint32_t wait_usecs)
+{
+    struct mgmt_metrics_entry *mme;
+    os_sr_t sr;
+
+    STATS_INC(mgmt_stats, requests);
+    STATS_INCN(mgmt_stats, bytes_in, bytes_in);
+    STATS_INCN(mgmt_stats, bytes_out, bytes_out);
+    STATS_INCN(mgmt_stats, handler_us, handler_usecs);
+    STATS_INCN(mgmt_stats, wait_us, wait_usecs);
+
+    OS_ENTER_CRITICAL(sr);
+
+    mme = mgmt_metrics_find(group_id, handler_id);
+    if (mme == NULL) {
+        OS_EXIT_CRITICAL(sr);
+        STATS_INC(mgmt_stats, untracked);
+        return;
+    }
+
+    mme->mme_count++;
+    mme->mme_bytes_in += bytes_in;
+    mme->mme_bytes_out += bytes_out;
+    mme->mme_handler_total += handler_usecs;
+    if (handler_usecs > mme->mme_handler_max) {
+        mme->mme_handler_max = handler_usecs;
+    }
+    mme->mme_wait_total += wait_usecs;
+    if (wait_usecs > mme->mme_wait_max) {
+        mme->mme_wait_max = wait_usecs;
+    }
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+mgmt_metrics_get(int idx, struct mgmt_metrics_entry *out)
+{
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (idx < 0 || idx >= mgmt_metrics_cnt) {
+        rc = SYS_ENOENT;
+    } else {
+        *out = mgmt_metrics[idx];
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+void
+mgmt_metrics_reset(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    mgmt_metrics_cnt = 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+mgmt_metrics_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = stats_init_and_reg(STATS_HDR(mgmt_stats),
+                            STATS_SIZE_INIT_PARMS(mgmt_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(mgmt_stats),
+                            "mgmt");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
@@ -50,6 +50,10 @@ typedef uint16_t (*nmgr_transport_get_mtu_func_t)(struct os_mbuf *m);
 
 struct nmgr_transport {
     struct os_mqueue nt_imq;
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+    /* Requests for the groups handled by the newtmgr worker task. */
+    struct os_mqueue nt_wmq;
+#endif
     nmgr_transport_out_func_t nt_output;
     nmgr_transport_get_mtu_func_t nt_get_mtu;
 };
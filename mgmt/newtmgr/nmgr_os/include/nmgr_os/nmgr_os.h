@@ -33,6 +33,9 @@ extern "C" {
 #define NMGR_ID_MPSTATS         3
 #define NMGR_ID_DATETIME_STR    4
 #define NMGR_ID_RESET           5
+#define NMGR_ID_LOCKPROF        6
+#define NMGR_ID_TRACE           7
+#define NMGR_ID_MGMT_METRICS    8
 
 int nmgr_os_groups_register(void);
 
@@ -48,6 +48,17 @@ static int nmgr_def_mpstat_read(struct mgmt_cbuf *njb);
 static int nmgr_datetime_get(struct mgmt_cbuf *njb);
 static int nmgr_datetime_set(struct mgmt_cbuf *njb);
 static int nmgr_reset(struct mgmt_cbuf *njb);
+#if MYNEWT_VAL(OS_LOCK_PROF)
+static int nmgr_def_lockprof_read(struct mgmt_cbuf *njb);
+static int nmgr_def_lockprof_reset(struct mgmt_cbuf *njb);
+#endif
+#if MYNEWT_VAL(OS_TRACE_RING)
+static int nmgr_def_trace_read(struct mgmt_cbuf *njb);
+#endif
+#if MYNEWT_VAL(MGMT_METRICS)
+static int nmgr_def_metrics_read(struct mgmt_cbuf *njb);
+static int nmgr_def_metrics_reset(struct mgmt_cbuf *njb);
+#endif
 
 static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_ECHO] = {
@@ -68,6 +79,21 @@ static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_RESET] = {
         NULL, nmgr_reset
     },
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    [NMGR_ID_LOCKPROF] = {
+        nmgr_def_lockprof_read, nmgr_def_lockprof_reset
+    },
+#endif
+#if MYNEWT_VAL(OS_TRACE_RING)
+    [NMGR_ID_TRACE] = {
+        nmgr_def_trace_read, NULL
+    },
+#endif
+#if MYNEWT_VAL(MGMT_METRICS)
+    [NMGR_ID_MGMT_METRICS] = {
+        nmgr_def_metrics_read, nmgr_def_metrics_reset
+    },
+#endif
 };
 
 #define NMGR_DEF_GROUP_SZ                                               \
@@ -174,6 +200,10 @@ nmgr_def_taskstat_read(struct mgmt_cbuf *cb)
         g_err |= cbor_encode_uint(&task, oti.oti_cswcnt);
         g_err |= cbor_encode_text_stringz(&task, "runtime");
         g_err |= cbor_encode_uint(&task, oti.oti_runtime);
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+        g_err |= cbor_encode_text_stringz(&task, "cputime");
+        g_err |= cbor_encode_uint(&task, oti.oti_run_cputime);
+#endif
         g_err |= cbor_encode_text_stringz(&task, "last_checkin");
         g_err |= cbor_encode_uint(&task, oti.oti_last_checkin);
         g_err |= cbor_encode_text_stringz(&task, "next_checkin");
@@ -231,6 +261,192 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(OS_LOCK_PROF)
+static int
+nmgr_def_lockprof_read(struct mgmt_cbuf *cb)
+{
+    struct os_lock_prof *olp;
+    CborError g_err = CborNoError;
+    CborEncoder locks;
+    CborEncoder lock;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "locks");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &locks,
+                                     CborIndefiniteLength);
+
+    olp = NULL;
+    while (1) {
+        olp = os_lock_prof_next(olp);
+        if (olp == NULL) {
+            break;
+        }
+
+        g_err |= cbor_encode_text_stringz(&locks, olp->olp_name);
+        g_err |= cbor_encoder_create_map(&locks, &lock, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&lock, "acq");
+        g_err |= cbor_encode_uint(&lock, olp->olp_acquired);
+        g_err |= cbor_encode_text_stringz(&lock, "cont");
+        g_err |= cbor_encode_uint(&lock, olp->olp_contended);
+        g_err |= cbor_encode_text_stringz(&lock, "tmo");
+        g_err |= cbor_encode_uint(&lock, olp->olp_timeouts);
+        g_err |= cbor_encode_text_stringz(&lock, "waitmax");
+        g_err |= cbor_encode_uint(&lock, olp->olp_wait_max);
+        g_err |= cbor_encode_text_stringz(&lock, "waittot");
+        g_err |= cbor_encode_uint(&lock, olp->olp_wait_total);
+        g_err |= cbor_encode_text_stringz(&lock, "holdmax");
+        g_err |= cbor_encode_uint(&lock, olp->olp_hold_max);
+        if (olp->olp_hold_max_task != NULL) {
+            g_err |= cbor_encode_text_stringz(&lock, "holder");
+            g_err |= cbor_encode_text_stringz(&lock, olp->olp_hold_max_task);
+        }
+        g_err |= cbor_encoder_close_container(&locks, &lock);
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &locks);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
+static int
+nmgr_def_lockprof_reset(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+
+    os_lock_prof_reset();
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(OS_TRACE_RING)
+/*
+ * Returns up to NMGR_TRACE_RECS raw trace records starting at sequence
+ * number "seq".  "seq" in the response is that of the first record
+ * returned (larger than requested if records were overwritten), "next"
+ * is what to ask for in the following request.
+ */
+#define NMGR_TRACE_RECS         16
+
+static int
+nmgr_def_trace_read(struct mgmt_cbuf *cb)
+{
+    struct os_trace_rec recs[NMGR_TRACE_RECS];
+    CborError g_err = CborNoError;
+    unsigned long long seq;
+    uint32_t cur;
+    int cnt;
+    int rc;
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "seq",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &seq,
+            .nodefault = 1
+        },
+        { 0 },
+    };
+
+    seq = 0;
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    cur = seq;
+    cnt = os_trace_ring_read(&cur, recs, NMGR_TRACE_RECS);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "seq");
+    g_err |= cbor_encode_uint(&cb->encoder, (uint32_t)(cur - cnt));
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "next");
+    g_err |= cbor_encode_uint(&cb->encoder, cur);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "recs");
+    g_err |= cbor_encode_byte_string(&cb->encoder, (uint8_t *)recs,
+                                     cnt * sizeof(recs[0]));
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(MGMT_METRICS)
+static int
+nmgr_def_metrics_read(struct mgmt_cbuf *cb)
+{
+    struct mgmt_metrics_entry mme;
+    CborError g_err = CborNoError;
+    CborEncoder cmds;
+    CborEncoder cmd;
+    int i;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "cmds");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &cmds,
+                                       CborIndefiniteLength);
+
+    for (i = 0; mgmt_metrics_get(i, &mme) == 0; i++) {
+        g_err |= cbor_encoder_create_map(&cmds, &cmd, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&cmd, "group");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_group);
+        g_err |= cbor_encode_text_stringz(&cmd, "id");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_id);
+        g_err |= cbor_encode_text_stringz(&cmd, "cnt");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_count);
+        g_err |= cbor_encode_text_stringz(&cmd, "in");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_bytes_in);
+        g_err |= cbor_encode_text_stringz(&cmd, "out");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_bytes_out);
+        g_err |= cbor_encode_text_stringz(&cmd, "runtot");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_handler_total);
+        g_err |= cbor_encode_text_stringz(&cmd, "runmax");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_handler_max);
+        g_err |= cbor_encode_text_stringz(&cmd, "waittot");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_wait_total);
+        g_err |= cbor_encode_text_stringz(&cmd, "waitmax");
+        g_err |= cbor_encode_uint(&cmd, mme.mme_wait_max);
+        g_err |= cbor_encoder_close_container(&cmds, &cmd);
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &cmds);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
+static int
+nmgr_def_metrics_reset(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+
+    mgmt_metrics_reset();
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
 static int
 nmgr_datetime_get(struct mgmt_cbuf *cb)
 {
@@ -22,30 +22,56 @@
 
 #include "os/mynewt.h"
 
-#include "mem/mem.h"
-
 #include "mgmt/mgmt.h"
 
 #include "newtmgr/newtmgr.h"
 #include "nmgr_os/nmgr_os.h"
 
 #include "tinycbor/cbor.h"
-#include "tinycbor/cbor_mbuf_writer.h"
 #include "tinycbor/cbor_mbuf_reader.h"
 
 /* Shared queue that newtmgr uses for work items. */
 struct os_eventq *nmgr_evq;
 
+/*
+ * cbor writer that encodes a response straight into transport sized
+ * fragments.  Each fragment is a packet header mbuf holding at most mtu
+ * bytes; a new one is started whenever the current one fills up, so the
+ * response never has to be split and copied before transmission.
+ */
+struct nmgr_frag_writer {
+    struct cbor_encoder_writer enc;
+    STAILQ_HEAD(, os_mbuf_pkthdr) frags;
+    struct os_mbuf *cur;
+    uint16_t mtu;
+};
+
 /*
  * cbor buffer for newtmgr
  */
 static struct nmgr_cbuf {
     struct mgmt_cbuf n_b;
-    struct cbor_mbuf_writer writer;
+    struct nmgr_frag_writer writer;
     struct cbor_mbuf_reader reader;
-    struct os_mbuf *n_out_m;
+#if MYNEWT_VAL(MGMT_METRICS)
+    /* Reception time of the request being handled, in cputime ticks. */
+    uint32_t n_rx_ticks;
+#endif
 } nmgr_task_cbuf;
 
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+/*
+ * Worker task for the groups in NEWTMGR_WORKER_GROUPS.  It has its own cbor
+ * buffer so that it can encode a response while the mgmt event queue is
+ * handling another request.
+ */
+static struct nmgr_cbuf nmgr_worker_cbuf;
+static struct os_eventq nmgr_worker_evq;
+static struct os_task nmgr_worker_task;
+static os_stack_t nmgr_worker_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(NEWTMGR_WORKER_STACK_SIZE))];
+#endif
+
 struct os_eventq *
 mgmt_evq_get(void)
 {
@@ -65,8 +91,143 @@ nmgr_cbuf_init(struct nmgr_cbuf *njb)
     return (0);
 }
 
+/**
+ * Allocates an mbuf to contain an outgoing response fragment.
+ */
+static struct os_mbuf *
+nmgr_rsp_frag_alloc(uint16_t frag_size, void *arg)
+{
+    struct os_mbuf *src_rsp;
+    struct os_mbuf *frag;
+
+    /* We need to duplicate the user header from the source response, as that
+     * is where transport-specific information is stored.
+     */
+    src_rsp = arg;
+
+    frag = os_msys_get_pkthdr(frag_size, OS_MBUF_USRHDR_LEN(src_rsp));
+    if (frag != NULL) {
+        /* Copy the user header from the response into the fragment mbuf. */
+        memcpy(OS_MBUF_USRHDR(frag), OS_MBUF_USRHDR(src_rsp),
+               OS_MBUF_USRHDR_LEN(src_rsp));
+    }
+
+    return frag;
+}
+
+static int
+nmgr_frag_write(struct cbor_encoder_writer *arg, const char *data, int len)
+{
+    struct nmgr_frag_writer *fw;
+    struct os_mbuf *frag;
+    int space;
+    int rc;
+
+    fw = (struct nmgr_frag_writer *)arg;
+
+    while (len > 0) {
+        space = fw->mtu - OS_MBUF_PKTLEN(fw->cur);
+        if (space <= 0) {
+            /* Current fragment is full; the first one supplies the user
+             * header for the new one.
+             */
+            frag = nmgr_rsp_frag_alloc(fw->mtu,
+              OS_MBUF_PKTHDR_TO_MBUF(STAILQ_FIRST(&fw->frags)));
+            if (frag == NULL) {
+                return CborErrorOutOfMemory;
+            }
+            STAILQ_INSERT_TAIL(&fw->frags, OS_MBUF_PKTHDR(frag), omp_next);
+            fw->cur = frag;
+            continue;
+        }
+        if (space > len) {
+            space = len;
+        }
+
+        rc = os_mbuf_append(fw->cur, data, space);
+        if (rc != 0) {
+            return CborErrorOutOfMemory;
+        }
+        fw->enc.bytes_written += space;
+        data += space;
+        len -= space;
+    }
+
+    return CborNoError;
+}
+
+static void
+nmgr_frag_writer_init(struct nmgr_frag_writer *fw, struct os_mbuf *m,
+                      uint16_t mtu)
+{
+    STAILQ_INIT(&fw->frags);
+    STAILQ_INSERT_HEAD(&fw->frags, OS_MBUF_PKTHDR(m), omp_next);
+    fw->cur = m;
+    fw->mtu = mtu;
+    fw->enc.bytes_written = 0;
+    fw->enc.write = nmgr_frag_write;
+    fw->enc.replace = NULL;
+}
+
+/**
+ * Frees every fragment after the first one; the first fragment is left to
+ * the caller so that it can be reused for an error response.
+ */
+static void
+nmgr_frags_trim(struct nmgr_frag_writer *fw)
+{
+    struct os_mbuf_pkthdr *first;
+    struct os_mbuf_pkthdr *omp;
+
+    first = STAILQ_FIRST(&fw->frags);
+    if (first == NULL) {
+        return;
+    }
+    while ((omp = STAILQ_NEXT(first, omp_next)) != NULL) {
+        STAILQ_REMOVE_AFTER(&fw->frags, first, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    fw->cur = OS_MBUF_PKTHDR_TO_MBUF(first);
+}
+
+static void
+nmgr_frags_free(struct nmgr_frag_writer *fw)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    while ((omp = STAILQ_FIRST(&fw->frags)) != NULL) {
+        STAILQ_REMOVE_HEAD(&fw->frags, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+}
+
+/**
+ * Sends the fragments of an encoded response, in order.  All fragments are
+ * consumed, whether or not transmission succeeds.
+ */
+static int
+nmgr_rsp_tx(struct nmgr_transport *nt, struct nmgr_frag_writer *fw)
+{
+    struct os_mbuf_pkthdr *omp;
+    int rc;
+
+    while ((omp = STAILQ_FIRST(&fw->frags)) != NULL) {
+        STAILQ_REMOVE_HEAD(&fw->frags, omp_next);
+
+        rc = nt->nt_output(nt, OS_MBUF_PKTHDR_TO_MBUF(omp));
+        if (rc != 0) {
+            /* Output function already freed mbuf. */
+            nmgr_frags_free(fw);
+            return MGMT_ERR_EUNKNOWN;
+        }
+    }
+
+    return MGMT_ERR_EOK;
+}
+
 static struct nmgr_hdr *
-nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
+nmgr_init_rsp(struct nmgr_cbuf *cb, struct os_mbuf *m, struct nmgr_hdr *src,
+              uint16_t mtu)
 {
     struct nmgr_hdr *hdr;
 
@@ -84,104 +245,53 @@ nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
     hdr->nh_id = src->nh_id;
 
     /* setup state for cbor encoding */
-    cbor_mbuf_writer_init(&nmgr_task_cbuf.writer, m);
-    cbor_encoder_init(&nmgr_task_cbuf.n_b.encoder, &nmgr_task_cbuf.writer.enc, 0);
-    nmgr_task_cbuf.n_out_m = m;
+    nmgr_frag_writer_init(&cb->writer, m, mtu);
+    cbor_encoder_init(&cb->n_b.encoder, &cb->writer.enc, 0);
     return hdr;
 }
 
 static void
-nmgr_send_err_rsp(struct nmgr_transport *nt, struct os_mbuf *m,
-                  struct nmgr_hdr *hdr, int status)
+nmgr_send_err_rsp(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                  struct os_mbuf *m, struct nmgr_hdr *hdr, int status,
+                  uint16_t mtu)
 {
     struct CborEncoder map;
     int rc;
 
-    hdr = nmgr_init_rsp(m, hdr);
+    hdr = nmgr_init_rsp(cb, m, hdr, mtu);
     if (!hdr) {
         os_mbuf_free_chain(m);
         return;
     }
 
-    rc = cbor_encoder_create_map(&nmgr_task_cbuf.n_b.encoder, &map,
+    rc = cbor_encoder_create_map(&cb->n_b.encoder, &map,
                                  CborIndefiniteLength);
     if (rc != 0) {
+        nmgr_frags_free(&cb->writer);
         return;
     }
 
-    rc = mgmt_cbuf_setoerr(&nmgr_task_cbuf.n_b, status);
+    rc = mgmt_cbuf_setoerr(&cb->n_b, status);
     if (rc != 0) {
+        nmgr_frags_free(&cb->writer);
         return;
     }
 
-    rc = cbor_encoder_close_container(&nmgr_task_cbuf.n_b.encoder, &map);
+    rc = cbor_encoder_close_container(&cb->n_b.encoder, &map);
     if (rc != 0) {
+        nmgr_frags_free(&cb->writer);
         return;
     }
 
     hdr->nh_len =
-        htons(cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder));
+        htons(cbor_encode_bytes_written(&cb->n_b.encoder));
 
-    nt->nt_output(nt, nmgr_task_cbuf.n_out_m);
-}
-
-/**
- * Allocates an mbuf to contain an outgoing response fragment.
- */
-static struct os_mbuf *
-nmgr_rsp_frag_alloc(uint16_t frag_size, void *arg)
-{
-    struct os_mbuf *src_rsp;
-    struct os_mbuf *frag;
-
-    /* We need to duplicate the user header from the source response, as that
-     * is where transport-specific information is stored.
-     */
-    src_rsp = arg;
-
-    frag = os_msys_get_pkthdr(frag_size, OS_MBUF_USRHDR_LEN(src_rsp));
-    if (frag != NULL) {
-        /* Copy the user header from the response into the fragment mbuf. */
-        memcpy(OS_MBUF_USRHDR(frag), OS_MBUF_USRHDR(src_rsp),
-               OS_MBUF_USRHDR_LEN(src_rsp));
-    }
-
-    return frag;
-}
-
-/**
- * Sends a newtmgr response, fragmenting it as needed.  The supplied response
- * mbuf is consumed on success and in some failure cases.  If the mbuf is
- * consumed, the supplied pointer is set to NULL.
- *
- * This function prefers not to consume the supplied mbuf on failure.  The
- * reason for this is to allow the caller to reuse the mbuf for an error
- * response.
- */
-static int
-nmgr_rsp_tx(struct nmgr_transport *nt, struct os_mbuf **rsp, uint16_t mtu)
-{
-    struct os_mbuf *frag;
-    int rc;
-
-    while (*rsp != NULL) {
-        frag = mem_split_frag(rsp, mtu, nmgr_rsp_frag_alloc, *rsp);
-        if (frag == NULL) {
-            return MGMT_ERR_ENOMEM;
-        }
-
-        rc = nt->nt_output(nt, frag);
-        if (rc != 0) {
-            /* Output function already freed mbuf. */
-            return MGMT_ERR_EUNKNOWN;
-        }
-    }
-
-    return MGMT_ERR_EOK;
+    nmgr_rsp_tx(nt, &cb->writer);
 }
 
 static void
-nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
+nmgr_handle_req(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                struct os_mbuf *req)
 {
     struct os_mbuf *rsp;
     const struct mgmt_handler *handler;
@@ -192,10 +302,22 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
     uint16_t len;
     uint16_t mtu;
     int rc;
+#if MYNEWT_VAL(MGMT_METRICS)
+    uint32_t start;
+    uint32_t end;
+#endif
 
     rsp_hdr = NULL;
+    rsp = NULL;
+
+    mtu = nt->nt_get_mtu(req);
+    if (mtu == 0) {
+        /* The transport cannot support a transmission right now. */
+        goto err_norsp;
+    }
 
-    rsp = os_msys_get_pkthdr(512, OS_MBUF_USRHDR_LEN(req));
+    /* The first response fragment also carries the request user header. */
+    rsp = nmgr_rsp_frag_alloc(mtu, req);
     if (!rsp) {
         rc = os_mbuf_copydata(req, 0, sizeof(hdr), &hdr);
         if (rc < 0) {
@@ -203,22 +325,22 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
         }
         rsp = req;
         req = NULL;
+        rc = MGMT_ERR_ENOMEM;
         goto err;
     }
 
-    mtu = nt->nt_get_mtu(req);
-    if (mtu == 0) {
-        /* The transport cannot support a transmission right now. */
-        goto err_norsp;
-    }
-
-    /* Copy the request user header into the response. */
-    memcpy(OS_MBUF_USRHDR(rsp), OS_MBUF_USRHDR(req), OS_MBUF_USRHDR_LEN(req));
-
     off = 0;
     len = OS_MBUF_PKTHDR(req)->omp_len;
 
     while (off < len) {
+        if (!rsp) {
+            /* The previous response was consumed by the transport. */
+            rsp = nmgr_rsp_frag_alloc(mtu, req);
+            if (!rsp) {
+                goto err_norsp;
+            }
+        }
+
         rc = os_mbuf_copydata(req, off, sizeof(hdr), &hdr);
         if (rc < 0) {
             rc = MGMT_ERR_EINVAL;
@@ -236,47 +358,60 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
         /* Build response header apriori.  Then pass to the handlers
          * to fill out the response data, and adjust length & flags.
          */
-        rsp_hdr = nmgr_init_rsp(rsp, &hdr);
+        rsp_hdr = nmgr_init_rsp(cb, rsp, &hdr, mtu);
         if (!rsp_hdr) {
             rc = MGMT_ERR_ENOMEM;
             goto err_norsp;
         }
 
-        cbor_mbuf_reader_init(&nmgr_task_cbuf.reader, req, sizeof(hdr));
-        cbor_parser_init(&nmgr_task_cbuf.reader.r, 0,
-                         &nmgr_task_cbuf.n_b.parser, &nmgr_task_cbuf.n_b.it);
+        cbor_mbuf_reader_init(&cb->reader, req, sizeof(hdr));
+        cbor_parser_init(&cb->reader.r, 0,
+                         &cb->n_b.parser, &cb->n_b.it);
 
         /* Begin response payload.  Response fields are inserted into the root
          * map as key value pairs.
          */
-        rc = cbor_encoder_create_map(&nmgr_task_cbuf.n_b.encoder, &payload_enc,
+        rc = cbor_encoder_create_map(&cb->n_b.encoder, &payload_enc,
                                      CborIndefiniteLength);
         if (rc != 0) {
             rc = MGMT_ERR_ENOMEM;
             goto err;
         }
 
+#if MYNEWT_VAL(MGMT_METRICS)
+        start = os_cputime_get32();
+#endif
+
         if (hdr.nh_op == NMGR_OP_READ) {
             if (handler->mh_read) {
-                rc = handler->mh_read(&nmgr_task_cbuf.n_b);
+                rc = handler->mh_read(&cb->n_b);
             } else {
                 rc = MGMT_ERR_ENOENT;
             }
         } else if (hdr.nh_op == NMGR_OP_WRITE) {
             if (handler->mh_write) {
-                rc = handler->mh_write(&nmgr_task_cbuf.n_b);
+                rc = handler->mh_write(&cb->n_b);
             } else {
                 rc = MGMT_ERR_ENOENT;
             }
         } else {
             rc = MGMT_ERR_EINVAL;
         }
+
+#if MYNEWT_VAL(MGMT_METRICS)
+        end = os_cputime_get32();
+        mgmt_metrics_record(ntohs(hdr.nh_group), hdr.nh_id, hdr.nh_len,
+                            cbor_encode_bytes_written(&cb->n_b.encoder),
+                            os_cputime_ticks_to_usecs(end - start),
+                            os_cputime_ticks_to_usecs(start - cb->n_rx_ticks));
+#endif
+
         if (rc != 0) {
             goto err;
         }
 
         /* End response payload. */
-        rc = cbor_encoder_close_container(&nmgr_task_cbuf.n_b.encoder,
+        rc = cbor_encoder_close_container(&cb->n_b.encoder,
                                           &payload_enc);
         if (rc != 0) {
             rc = MGMT_ERR_ENOMEM;
@@ -284,19 +419,14 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
         }
 
         rsp_hdr->nh_len +=
-            cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
+            cbor_encode_bytes_written(&cb->n_b.encoder);
         rsp_hdr->nh_len = htons(rsp_hdr->nh_len);
 
-        rc = nmgr_rsp_tx(nt, &rsp, mtu);
+        /* All fragments are consumed, whether or not this succeeds. */
+        rc = nmgr_rsp_tx(nt, &cb->writer);
+        rsp = NULL;
         if (rc) {
-            /* If the entire mbuf was consumed by the transport, don't attempt
-             * to send an error response.
-             */
-            if (rsp == NULL) {
-                goto err_norsp;
-            } else {
-                goto err;
-            }
+            goto err_norsp;
         }
 
         off += sizeof(hdr) + OS_ALIGN(hdr.nh_len, 4);
@@ -307,40 +437,104 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
     return;
 
 err:
-    /* Clear partially written response. */
+    /* Clear partially written response; only its first fragment is reused. */
+    nmgr_frags_trim(&cb->writer);
     os_mbuf_adj(rsp, OS_MBUF_PKTLEN(rsp));
 
-    nmgr_send_err_rsp(nt, rsp, &hdr, rc);
+    nmgr_send_err_rsp(cb, nt, rsp, &hdr, rc, mtu);
     os_mbuf_free_chain(req);
     return;
 
 err_norsp:
-    os_mbuf_free_chain(rsp);
+    /* Once encoding has started, the writer owns the response fragments. */
+    if (STAILQ_EMPTY(&cb->writer.frags)) {
+        os_mbuf_free_chain(rsp);
+    } else {
+        nmgr_frags_free(&cb->writer);
+    }
     os_mbuf_free_chain(req);
     return;
 }
 
 
 static void
-nmgr_process(struct nmgr_transport *nt)
+nmgr_process(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+             struct os_mqueue *mq)
 {
     struct os_mbuf *m;
 
     while (1) {
-        m = os_mqueue_get(&nt->nt_imq);
+        m = os_mqueue_get(mq);
         if (!m) {
             break;
         }
 
-        nmgr_handle_req(nt, m);
+#if MYNEWT_VAL(MGMT_METRICS)
+        /* Strip the reception timestamp added by nmgr_rx_req(). */
+        if (os_mbuf_copydata(m, 0, sizeof(cb->n_rx_ticks),
+                             &cb->n_rx_ticks) != 0) {
+            os_mbuf_free_chain(m);
+            continue;
+        }
+        os_mbuf_adj(m, sizeof(cb->n_rx_ticks));
+#endif
+
+        nmgr_handle_req(cb, nt, m);
     }
 }
 
 static void
 nmgr_event_data_in(struct os_event *ev)
 {
-    nmgr_process(ev->ev_arg);
+    struct nmgr_transport *nt;
+
+    nt = ev->ev_arg;
+    nmgr_process(&nmgr_task_cbuf, nt, &nt->nt_imq);
+}
+
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+static void
+nmgr_event_worker_in(struct os_event *ev)
+{
+    struct nmgr_transport *nt;
+
+    nt = ev->ev_arg;
+    nmgr_process(&nmgr_worker_cbuf, nt, &nt->nt_wmq);
+}
+
+static void
+nmgr_worker_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&nmgr_worker_evq);
+    }
+}
+
+/**
+ * Indicates whether a request belongs to one of the groups handled by the
+ * worker task.  A buffer carrying several requests is routed by its first
+ * header.
+ */
+static bool
+nmgr_req_is_worker(struct os_mbuf *req)
+{
+    struct nmgr_hdr hdr;
+    uint16_t group;
+    int rc;
+
+    rc = os_mbuf_copydata(req, 0, sizeof(hdr), &hdr);
+    if (rc != 0) {
+        return false;
+    }
+
+    group = ntohs(hdr.nh_group);
+    if (group >= 32) {
+        return false;
+    }
+
+    return (MYNEWT_VAL(NEWTMGR_WORKER_GROUPS) & (1UL << group)) != 0;
 }
+#endif
 
 int
 nmgr_transport_init(struct nmgr_transport *nt,
@@ -357,6 +551,13 @@ nmgr_transport_init(struct nmgr_transport *nt,
         goto err;
     }
 
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+    rc = os_mqueue_init(&nt->nt_wmq, nmgr_event_worker_in, nt);
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
     return (0);
 err:
     return (rc);
@@ -376,9 +577,35 @@ err:
 int
 nmgr_rx_req(struct nmgr_transport *nt, struct os_mbuf *req)
 {
+    struct os_mqueue *mq;
+    struct os_eventq *evq;
     int rc;
+#if MYNEWT_VAL(MGMT_METRICS)
+    uint32_t rx_ticks;
+#endif
+
+    mq = &nt->nt_imq;
+    evq = mgmt_evq_get();
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+    if (nmgr_req_is_worker(req)) {
+        mq = &nt->nt_wmq;
+        evq = &nmgr_worker_evq;
+    }
+#endif
 
-    rc = os_mqueue_put(&nt->nt_imq, mgmt_evq_get(), req);
+#if MYNEWT_VAL(MGMT_METRICS)
+    /* Tag the request with its reception time so the time it spends queued
+     * can be accounted for.
+     */
+    rx_ticks = os_cputime_get32();
+    req = os_mbuf_prepend_pullup(req, sizeof(rx_ticks));
+    if (req == NULL) {
+        return MGMT_ERR_ENOMEM;
+    }
+    memcpy(req->om_data, &rx_ticks, sizeof(rx_ticks));
+#endif
+
+    rc = os_mqueue_put(mq, evq, req);
     if (rc != 0) {
         os_mbuf_free_chain(req);
     }
@@ -399,5 +626,16 @@ nmgr_pkg_init(void)
 
     nmgr_cbuf_init(&nmgr_task_cbuf);
 
+#if MYNEWT_VAL(NEWTMGR_WORKER)
+    nmgr_cbuf_init(&nmgr_worker_cbuf);
+    os_eventq_init(&nmgr_worker_evq);
+
+    rc = os_task_init(&nmgr_worker_task, "nmgr", nmgr_worker_task_handler,
+                      NULL, MYNEWT_VAL(NEWTMGR_WORKER_PRIO), OS_WAIT_FOREVER,
+                      nmgr_worker_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(NEWTMGR_WORKER_STACK_SIZE)));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
     mgmt_evq_set(os_eventq_dflt_get());
 }
@@ -25,9 +25,7 @@
 #include "mgmt/mgmt.h"
 #include "newtmgr/newtmgr.h"
 #include "console/console.h"
-
-/* nmgr ble mqueue */
-struct os_mqueue nmgr_ble_mq;
+#include "stats/stats.h"
 
 /* ble nmgr transport */
 struct nmgr_transport ble_nt;
@@ -35,6 +33,63 @@ struct nmgr_transport ble_nt;
 /* ble nmgr attr handle */
 uint16_t g_ble_nmgr_attr_handle;
 
+#define NMGR_BLE_NUM_CONNS      MYNEWT_VAL(BLE_MAX_CONNECTIONS)
+#define NMGR_BLE_TXQ_MAX        MYNEWT_VAL(NMGR_BLE_TXQ_MAX)
+
+/*
+ * Per connection transmit state.  Response fragments are queued here in
+ * order and sent in bursts of up to NMGR_BLE_TX_CREDITS notifications, so
+ * the controller has enough data to fill each connection event while
+ * other connections still get their turn.  nbc_ts holds the time each
+ * queued fragment was handed to the transport, for the latency stats.
+ */
+struct nmgr_ble_conn {
+    uint16_t nbc_conn_handle;
+    uint8_t nbc_negotiated;
+    uint8_t nbc_q_len;
+    uint8_t nbc_ts_head;
+    STAILQ_HEAD(, os_mbuf_pkthdr) nbc_txq;
+    uint32_t nbc_ts[NMGR_BLE_TXQ_MAX];
+};
+
+static struct nmgr_ble_conn nmgr_ble_conns[NMGR_BLE_NUM_CONNS];
+
+/* Index of the connection served first by the next transmit pass. */
+static int nmgr_ble_tx_next;
+
+static void nmgr_ble_tx_event(struct os_event *ev);
+
+static struct os_event nmgr_ble_tx_ev = {
+    .ev_cb = nmgr_ble_tx_event,
+};
+
+/* Restarts transmission after msys ran low. */
+static struct os_callout nmgr_ble_tx_retry;
+
+STATS_SECT_START(nmgr_ble_stats)
+    STATS_SECT_ENTRY(frags_queued)
+    STATS_SECT_ENTRY(frags_sent)
+    STATS_SECT_ENTRY(frags_dropped)
+    STATS_SECT_ENTRY(tx_fail)
+    STATS_SECT_ENTRY(tx_stall)
+    STATS_SECT_ENTRY(frag_wait_us)
+    STATS_SECT_ENTRY(frag_wait_max_us)
+    STATS_SECT_ENTRY(mtu_exchanges)
+STATS_SECT_END
+
+STATS_NAME_START(nmgr_ble_stats)
+    STATS_NAME(nmgr_ble_stats, frags_queued)
+    STATS_NAME(nmgr_ble_stats, frags_sent)
+    STATS_NAME(nmgr_ble_stats, frags_dropped)
+    STATS_NAME(nmgr_ble_stats, tx_fail)
+    STATS_NAME(nmgr_ble_stats, tx_stall)
+    STATS_NAME(nmgr_ble_stats, frag_wait_us)
+    STATS_NAME(nmgr_ble_stats, frag_wait_max_us)
+    STATS_NAME(nmgr_ble_stats, mtu_exchanges)
+STATS_NAME_END(nmgr_ble_stats)
+
+static STATS_SECT_DECL(nmgr_ble_stats) nmgr_ble_stats;
+
 /**
  * The vendor specific "newtmgr" service consists of one write no-rsp
  * characteristic for newtmgr requests: a single-byte characteristic that can
@@ -78,6 +133,108 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     },
 };
 
+/**
+ * Frees every fragment queued on a connection.  Must be called with
+ * interrupts disabled.
+ */
+static void
+nmgr_ble_conn_flush(struct nmgr_ble_conn *nbc)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    while ((omp = STAILQ_FIRST(&nbc->nbc_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&nbc->nbc_txq, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+        STATS_INC(nmgr_ble_stats, frags_dropped);
+    }
+    nbc->nbc_q_len = 0;
+    nbc->nbc_ts_head = 0;
+}
+
+/**
+ * Looks up the transmit state of a connection, claiming a free entry if
+ * there is none.  Entries of connections that have gone away are reclaimed
+ * on the way.
+ *
+ * @return the entry, or NULL if all entries are busy.
+ */
+static struct nmgr_ble_conn *
+nmgr_ble_conn_get(uint16_t conn_handle)
+{
+    struct nmgr_ble_conn *nbc;
+    struct nmgr_ble_conn *avail;
+    os_sr_t sr;
+    int i;
+
+    avail = NULL;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < NMGR_BLE_NUM_CONNS; i++) {
+        nbc = &nmgr_ble_conns[i];
+        if (nbc->nbc_conn_handle == conn_handle) {
+            OS_EXIT_CRITICAL(sr);
+            return nbc;
+        }
+        if (avail == NULL && nbc->nbc_conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+            avail = nbc;
+        }
+    }
+    if (avail != NULL) {
+        avail->nbc_conn_handle = conn_handle;
+        avail->nbc_negotiated = 0;
+        OS_EXIT_CRITICAL(sr);
+        return avail;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    /* Table full; drop state of any connection that no longer exists. */
+    for (i = 0; i < NMGR_BLE_NUM_CONNS; i++) {
+        nbc = &nmgr_ble_conns[i];
+        if (ble_gap_conn_find(nbc->nbc_conn_handle, NULL) != 0) {
+            OS_ENTER_CRITICAL(sr);
+            nmgr_ble_conn_flush(nbc);
+            nbc->nbc_conn_handle = conn_handle;
+            nbc->nbc_negotiated = 0;
+            OS_EXIT_CRITICAL(sr);
+            return nbc;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Asks for a link that can carry large responses: the largest ATT MTU the
+ * host is configured for and, optionally, the 2M PHY.  Done once per
+ * connection, when its first request arrives.  Data length extension is
+ * negotiated by the controller itself (BLE_LL_CONN_INIT_MAX_TX_BYTES).
+ */
+static void
+nmgr_ble_negotiate(uint16_t conn_handle)
+{
+    struct nmgr_ble_conn *nbc;
+
+    nbc = nmgr_ble_conn_get(conn_handle);
+    if (nbc == NULL || nbc->nbc_negotiated) {
+        return;
+    }
+    nbc->nbc_negotiated = 1;
+
+#if MYNEWT_VAL(NMGR_BLE_NEGOTIATE_MTU)
+    if (ble_att_mtu(conn_handle) == BLE_ATT_MTU_DFLT &&
+        ble_gattc_exchange_mtu(conn_handle, NULL, NULL) == 0) {
+
+        STATS_INC(nmgr_ble_stats, mtu_exchanges);
+    }
+#endif
+
+#if MYNEWT_VAL(NMGR_BLE_PREFER_2M_PHY)
+    ble_gap_set_prefered_le_phy(conn_handle, BLE_GAP_LE_PHY_2M_MASK,
+                                BLE_GAP_LE_PHY_2M_MASK,
+                                BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+}
+
 static int
 gatt_svr_chr_access_newtmgr(uint16_t conn_handle, uint16_t attr_handle,
                             struct ble_gatt_access_ctxt *ctxt, void *arg)
@@ -130,6 +287,8 @@ gatt_svr_chr_access_newtmgr(uint16_t conn_handle, uint16_t attr_handle,
              */
             memcpy(OS_MBUF_USRHDR(m_req), &conn_handle, sizeof(conn_handle));
 
+            nmgr_ble_negotiate(conn_handle);
+
             rc = nmgr_rx_req(&ble_nt, m_req);
             if (rc != 0) {
                 return BLE_ATT_ERR_UNLIKELY;
@@ -162,39 +321,136 @@ nmgr_ble_get_mtu(struct os_mbuf *req) {
 }
 
 /**
- * Nmgr ble process mqueue event
- * Gets an event from the nmgr mqueue and does a notify with the response
+ * Sends up to NMGR_BLE_TX_CREDITS queued fragments of one connection.
  *
- * @param eventq
- * @return 0 on success; non-zero on failure
+ * @return 1 if fragments remain queued, 0 otherwise; -1 if msys is too low
+ *         to transmit.
  */
+static int
+nmgr_ble_conn_tx(struct nmgr_ble_conn *nbc)
+{
+    struct os_mbuf_pkthdr *omp;
+    uint32_t wait;
+    uint16_t conn_handle;
+    int credits;
+    int rc;
+    os_sr_t sr;
+
+    for (credits = MYNEWT_VAL(NMGR_BLE_TX_CREDITS); credits > 0; credits--) {
+        if (os_msys_num_free() <= MYNEWT_VAL(NMGR_BLE_MSYS_RESERVE)) {
+            STATS_INC(nmgr_ble_stats, tx_stall);
+            return -1;
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        omp = STAILQ_FIRST(&nbc->nbc_txq);
+        if (omp == NULL) {
+            OS_EXIT_CRITICAL(sr);
+            return 0;
+        }
+        STAILQ_REMOVE_HEAD(&nbc->nbc_txq, omp_next);
+        wait = os_cputime_get32() - nbc->nbc_ts[nbc->nbc_ts_head];
+        nbc->nbc_ts_head = (nbc->nbc_ts_head + 1) % NMGR_BLE_TXQ_MAX;
+        nbc->nbc_q_len--;
+        conn_handle = nbc->nbc_conn_handle;
+        OS_EXIT_CRITICAL(sr);
+
+        wait = os_cputime_ticks_to_usecs(wait);
+        STATS_INCN(nmgr_ble_stats, frag_wait_us, wait);
+        if (wait > STATS_GET(nmgr_ble_stats, frag_wait_max_us)) {
+            STATS_GET(nmgr_ble_stats, frag_wait_max_us) = wait;
+        }
+
+        rc = ble_gattc_notify_custom(conn_handle, g_ble_nmgr_attr_handle,
+                                     OS_MBUF_PKTHDR_TO_MBUF(omp));
+        if (rc == 0) {
+            STATS_INC(nmgr_ble_stats, frags_sent);
+        } else {
+            STATS_INC(nmgr_ble_stats, tx_fail);
+            if (rc == BLE_HS_ENOTCONN) {
+                OS_ENTER_CRITICAL(sr);
+                nmgr_ble_conn_flush(nbc);
+                nbc->nbc_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+                OS_EXIT_CRITICAL(sr);
+                return 0;
+            }
+        }
+    }
 
+    return !STAILQ_EMPTY(&nbc->nbc_txq);
+}
+
+/**
+ * Serves the connections round robin, one burst each.  If anything is left
+ * the event is requeued, so other management work can run in between.
+ */
 static void
-nmgr_ble_event_data_in(struct os_event *ev)
+nmgr_ble_tx_event(struct os_event *ev)
 {
-    struct os_mbuf *m_resp;
-    uint16_t conn_handle;
+    int pending;
+    int rc;
+    int i;
+    int n;
+
+    pending = 0;
+    n = NMGR_BLE_NUM_CONNS;
+    for (i = 0; i < n; i++) {
+        rc = nmgr_ble_conn_tx(&nmgr_ble_conns[(nmgr_ble_tx_next + i) % n]);
+        if (rc < 0) {
+            os_callout_reset(&nmgr_ble_tx_retry, 1);
+            return;
+        }
+        pending |= rc;
+    }
+    nmgr_ble_tx_next = (nmgr_ble_tx_next + 1) % n;
 
-    while ((m_resp = os_mqueue_get(&nmgr_ble_mq)) != NULL) {
-        assert(OS_MBUF_USRHDR_LEN(m_resp) >= sizeof (conn_handle));
-        memcpy(&conn_handle, OS_MBUF_USRHDR(m_resp), sizeof (conn_handle));
-        ble_gattc_notify_custom(conn_handle, g_ble_nmgr_attr_handle,
-                                m_resp);
+    if (pending) {
+        os_eventq_put(mgmt_evq_get(), &nmgr_ble_tx_ev);
     }
 }
 
+static void
+nmgr_ble_tx_retry_cb(struct os_event *ev)
+{
+    nmgr_ble_tx_event(ev);
+}
+
 static int
 nmgr_ble_out(struct nmgr_transport *nt, struct os_mbuf *om)
 {
+    struct nmgr_ble_conn *nbc;
+    uint16_t conn_handle;
+    uint8_t slot;
+    os_sr_t sr;
     int rc;
 
-    rc = os_mqueue_put(&nmgr_ble_mq, mgmt_evq_get(), om);
-    if (rc != 0) {
+    assert(OS_MBUF_USRHDR_LEN(om) >= sizeof (conn_handle));
+    memcpy(&conn_handle, OS_MBUF_USRHDR(om), sizeof (conn_handle));
+
+    nbc = nmgr_ble_conn_get(conn_handle);
+    if (nbc == NULL) {
+        rc = OS_ENOMEM;
         goto err;
     }
 
+    OS_ENTER_CRITICAL(sr);
+    if (nbc->nbc_q_len >= NMGR_BLE_TXQ_MAX) {
+        OS_EXIT_CRITICAL(sr);
+        rc = OS_ENOMEM;
+        goto err;
+    }
+    slot = (nbc->nbc_ts_head + nbc->nbc_q_len) % NMGR_BLE_TXQ_MAX;
+    nbc->nbc_ts[slot] = os_cputime_get32();
+    nbc->nbc_q_len++;
+    STAILQ_INSERT_TAIL(&nbc->nbc_txq, OS_MBUF_PKTHDR(om), omp_next);
+    OS_EXIT_CRITICAL(sr);
+
+    STATS_INC(nmgr_ble_stats, frags_queued);
+    os_eventq_put(mgmt_evq_get(), &nmgr_ble_tx_ev);
+
     return (0);
 err:
+    STATS_INC(nmgr_ble_stats, frags_dropped);
     os_mbuf_free_chain(om);
     return (rc);
 }
@@ -209,6 +465,7 @@ int
 nmgr_ble_gatt_svr_init(void)
 {
     int rc;
+    int i;
 
     rc = ble_gatts_count_cfg(gatt_svr_svcs);
     if (rc != 0) {
@@ -220,7 +477,21 @@ nmgr_ble_gatt_svr_init(void)
         return rc;
     }
 
-    os_mqueue_init(&nmgr_ble_mq, &nmgr_ble_event_data_in, NULL);
+    for (i = 0; i < NMGR_BLE_NUM_CONNS; i++) {
+        nmgr_ble_conns[i].nbc_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        STAILQ_INIT(&nmgr_ble_conns[i].nbc_txq);
+    }
+    os_callout_init(&nmgr_ble_tx_retry, mgmt_evq_get(),
+                    nmgr_ble_tx_retry_cb, NULL);
+
+    rc = stats_init_and_reg(STATS_HDR(nmgr_ble_stats),
+                            STATS_SIZE_INIT_PARMS(nmgr_ble_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(nmgr_ble_stats),
+                            "nmgr_ble");
+    if (rc != 0) {
+        return rc;
+    }
 
     rc = nmgr_transport_init(&ble_nt, nmgr_ble_out, nmgr_ble_get_mtu);
 
@@ -28,6 +28,9 @@
 
 #include <crc/crc16.h>
 #include <base64/base64.h>
+#if MYNEWT_VAL(NMGR_UART_COBS)
+#include <cobs/cobs_uart.h>
+#endif
 
 #define SHELL_NLIP_PKT          0x0609
 #define SHELL_NLIP_DATA         0x0414
@@ -57,6 +60,9 @@ struct nmgr_ser_hdr {
 };
 
 static struct nmgr_uart_state nmgr_uart_state;
+#if MYNEWT_VAL(NMGR_UART_COBS)
+static struct cobs_uart nmgr_uart_cobs;
+#endif
 
 static uint16_t
 nmgr_uart_mtu(struct os_mbuf *m)
@@ -64,6 +70,26 @@ nmgr_uart_mtu(struct os_mbuf *m)
     return MGMT_MAX_MTU;
 }
 
+#if MYNEWT_VAL(NMGR_UART_COBS)
+
+static int
+nmgr_uart_cobs_out(struct nmgr_transport *nt, struct os_mbuf *m)
+{
+    return cobs_uart_tx(&nmgr_uart_cobs, m);
+}
+
+static void
+nmgr_uart_cobs_rx(struct os_event *ev)
+{
+    struct os_mbuf *m;
+
+    while ((m = cobs_uart_rx(&nmgr_uart_cobs)) != NULL) {
+        nmgr_rx_req(&nmgr_uart_state.nus_transport, m);
+    }
+}
+
+#else
+
 /*
  * Called by mgmt to queue packet out to UART.
  */
@@ -357,11 +383,27 @@ nmgr_uart_rx_char(void *arg, uint8_t data)
     return 0;
 }
 
+#endif /* MYNEWT_VAL(NMGR_UART_COBS) */
+
 void
 nmgr_uart_pkg_init(void)
 {
     struct nmgr_uart_state *nus = &nmgr_uart_state;
     int rc;
+#if MYNEWT_VAL(NMGR_UART_COBS)
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = nmgr_transport_init(&nus->nus_transport, nmgr_uart_cobs_out,
+                             nmgr_uart_mtu);
+    assert(rc == 0);
+
+    rc = cobs_uart_open(&nmgr_uart_cobs, MYNEWT_VAL(NMGR_UART),
+                        MYNEWT_VAL(NMGR_UART_SPEED), mgmt_evq_get(),
+                        nmgr_uart_cobs_rx, NULL);
+    assert(rc == 0);
+#else
     struct uart_conf uc = {
         .uc_speed = MYNEWT_VAL(NMGR_UART_SPEED),
         .uc_databits = 8,
@@ -384,4 +426,5 @@ nmgr_uart_pkg_init(void)
     assert(nus->nus_dev);
 
     nus->nus_cb_ev.ev_cb = nmgr_uart_rx_frame;
+#endif
 }
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLE_STORE_FCB_
+#define H_BLE_STORE_FCB_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+union ble_store_key;
+union ble_store_value;
+struct ble_store_value_sec;
+
+/*
+ * NimBLE host store kept in an FCB.  Each bond (our and peer security
+ * material) and each CCCD is its own record; writing one appends a single
+ * record instead of rewriting the whole set.  A sorted in-RAM index maps
+ * peer addresses to the newest record, so lookups don't touch flash until
+ * the value itself is read.
+ *
+ * The package installs itself as the host's store at sysinit.
+ */
+
+int ble_store_fcb_read(int obj_type, const union ble_store_key *key,
+                       union ble_store_value *value);
+int ble_store_fcb_write(int obj_type, const union ble_store_value *val);
+int ble_store_fcb_delete(int obj_type, const union ble_store_key *key);
+
+/**
+ * Looks up a peer bond by its identity resolving key.
+ *
+ * @param irk                   The 16 byte IRK to search for.
+ * @param out_value             On success, the peer's security material.
+ *
+ * @return                      0 on success; BLE_HS_ENOENT if no bond has
+ *                                  this IRK; other nonzero on error.
+ */
+int ble_store_fcb_read_peer_sec_by_irk(const uint8_t *irk,
+                                       struct ble_store_value_sec *out_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,639 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+#include "host/ble_hs.h"
+#include "ble_store_fcb/ble_store_fcb.h"
+
+#define BLE_STORE_FCB_VERS          1
+
+/* The record deletes the object it names instead of setting it. */
+#define BLE_STORE_FCB_F_DELETED     0x01
+
+/*
+ * Record as written to flash.  The value is kept in the host's own
+ * representation; the FCB version is bumped if that changes.
+ */
+struct ble_store_fcb_rec {
+    uint8_t bsr_obj_type;
+    uint8_t bsr_flags;
+    union ble_store_value bsr_val;
+};
+
+/*
+ * Index entry: identity of one stored object and the location of its newest
+ * record.  For peer bonds with an IRK, bse_irk_word holds the first four
+ * bytes of the IRK; IRKs are random, so this is as good as a hash.
+ */
+struct ble_store_fcb_ent {
+    ble_addr_t bse_peer_addr;
+    uint16_t bse_chr_val_handle;
+    uint32_t bse_irk_word;
+    struct flash_area *bse_area;
+    uint32_t bse_data_off;
+};
+
+/* Entries sorted by peer address, then CCCD handle. */
+struct ble_store_fcb_idx {
+    struct ble_store_fcb_ent *bsx_ents;
+    int bsx_cnt;
+    int bsx_max;
+};
+
+static struct ble_store_fcb_ent
+    ble_store_fcb_our_sec_ents[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static struct ble_store_fcb_ent
+    ble_store_fcb_peer_sec_ents[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static struct ble_store_fcb_ent
+    ble_store_fcb_cccd_ents[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+
+static struct ble_store_fcb_idx ble_store_fcb_our_sec = {
+    .bsx_ents = ble_store_fcb_our_sec_ents,
+    .bsx_max = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+};
+static struct ble_store_fcb_idx ble_store_fcb_peer_sec = {
+    .bsx_ents = ble_store_fcb_peer_sec_ents,
+    .bsx_max = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+};
+static struct ble_store_fcb_idx ble_store_fcb_cccd = {
+    .bsx_ents = ble_store_fcb_cccd_ents,
+    .bsx_max = MYNEWT_VAL(BLE_STORE_MAX_CCCDS),
+};
+
+static struct flash_area
+    ble_store_fcb_areas[MYNEWT_VAL(BLE_STORE_FCB_NUM_AREAS) + 1];
+
+static struct fcb ble_store_fcb_fcb = {
+    .f_magic = MYNEWT_VAL(BLE_STORE_FCB_MAGIC),
+    .f_version = BLE_STORE_FCB_VERS,
+    .f_sectors = ble_store_fcb_areas,
+};
+
+static struct ble_store_fcb_idx *
+ble_store_fcb_idx_get(int obj_type)
+{
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        return &ble_store_fcb_our_sec;
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        return &ble_store_fcb_peer_sec;
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        return &ble_store_fcb_cccd;
+    default:
+        return NULL;
+    }
+}
+
+static void
+ble_store_fcb_ident(int obj_type, const union ble_store_value *val,
+                    struct ble_store_fcb_ent *ent)
+{
+    memset(ent, 0, sizeof(*ent));
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        ent->bse_peer_addr = val->cccd.peer_addr;
+        ent->bse_chr_val_handle = val->cccd.chr_val_handle;
+    } else {
+        ent->bse_peer_addr = val->sec.peer_addr;
+        if (obj_type == BLE_STORE_OBJ_TYPE_PEER_SEC && val->sec.irk_present) {
+            memcpy(&ent->bse_irk_word, val->sec.irk,
+                   sizeof(ent->bse_irk_word));
+        }
+    }
+}
+
+static int
+ble_store_fcb_ent_cmp(const ble_addr_t *addr, uint16_t chr_val_handle,
+                      const struct ble_store_fcb_ent *ent)
+{
+    int rc;
+
+    rc = ble_addr_cmp(addr, &ent->bse_peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+    return (int)chr_val_handle - (int)ent->bse_chr_val_handle;
+}
+
+/**
+ * Returns the position of the first entry not ordered before the given
+ * identity.
+ */
+static int
+ble_store_fcb_lower_bound(const struct ble_store_fcb_idx *idx,
+                          const ble_addr_t *addr, uint16_t chr_val_handle)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = idx->bsx_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ble_store_fcb_ent_cmp(addr, chr_val_handle,
+                                  &idx->bsx_ents[mid]) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Points the entry for an identity at a new record, adding the entry if
+ * the identity is not indexed yet.
+ */
+static int
+ble_store_fcb_idx_set(struct ble_store_fcb_idx *idx,
+                      const struct ble_store_fcb_ent *ent)
+{
+    int i;
+
+    i = ble_store_fcb_lower_bound(idx, &ent->bse_peer_addr,
+                                  ent->bse_chr_val_handle);
+    if (i < idx->bsx_cnt &&
+        ble_store_fcb_ent_cmp(&ent->bse_peer_addr, ent->bse_chr_val_handle,
+                              &idx->bsx_ents[i]) == 0) {
+        idx->bsx_ents[i] = *ent;
+        return 0;
+    }
+
+    if (idx->bsx_cnt >= idx->bsx_max) {
+        return BLE_HS_ESTORE_CAP;
+    }
+
+    memmove(&idx->bsx_ents[i + 1], &idx->bsx_ents[i],
+            (idx->bsx_cnt - i) * sizeof(idx->bsx_ents[0]));
+    idx->bsx_ents[i] = *ent;
+    idx->bsx_cnt++;
+    return 0;
+}
+
+static void
+ble_store_fcb_idx_remove(struct ble_store_fcb_idx *idx, int i)
+{
+    idx->bsx_cnt--;
+    memmove(&idx->bsx_ents[i], &idx->bsx_ents[i + 1],
+            (idx->bsx_cnt - i) * sizeof(idx->bsx_ents[0]));
+}
+
+static int
+ble_store_fcb_rec_read(struct flash_area *fa, uint32_t off,
+                       struct ble_store_fcb_rec *rec)
+{
+    if (flash_area_read(fa, off, rec, sizeof(*rec)) != 0) {
+        return BLE_HS_ESTORE_FAIL;
+    }
+    return 0;
+}
+
+/**
+ * Finds the entry matching a host store key.  As with the other stores, an
+ * address of BLE_ADDR_ANY or a CCCD handle of 0 match anything, and key
+ * idx selects among several matches.
+ *
+ * @return the position of the entry in idx, or -1 if none matches.
+ */
+static int
+ble_store_fcb_find(int obj_type, const union ble_store_key *key,
+                   struct ble_store_fcb_idx *idx)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_ent *ent;
+    const ble_addr_t *addr;
+    uint16_t chr_val_handle;
+    uint8_t skip;
+    int any;
+    int i;
+
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        addr = &key->cccd.peer_addr;
+        chr_val_handle = key->cccd.chr_val_handle;
+        skip = key->cccd.idx;
+    } else {
+        addr = &key->sec.peer_addr;
+        chr_val_handle = 0;
+        skip = key->sec.idx;
+    }
+
+    any = ble_addr_cmp(addr, BLE_ADDR_ANY) == 0;
+    i = any ? 0 : ble_store_fcb_lower_bound(idx, addr, chr_val_handle);
+    for (; i < idx->bsx_cnt; i++) {
+        ent = &idx->bsx_ents[i];
+        if (!any && ble_addr_cmp(addr, &ent->bse_peer_addr) != 0) {
+            break;
+        }
+        if (chr_val_handle != 0 &&
+            ent->bse_chr_val_handle != chr_val_handle) {
+            continue;
+        }
+        if (obj_type != BLE_STORE_OBJ_TYPE_CCCD &&
+            key->sec.ediv_rand_present) {
+
+            if (ble_store_fcb_rec_read(ent->bse_area, ent->bse_data_off,
+                                       &rec) != 0 ||
+                rec.bsr_val.sec.ediv != key->sec.ediv ||
+                rec.bsr_val.sec.rand_num != key->sec.rand_num) {
+                continue;
+            }
+        }
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        return i;
+    }
+
+    return -1;
+}
+
+/**
+ * Looks up the index entry whose newest record is at the given location.
+ */
+static struct ble_store_fcb_ent *
+ble_store_fcb_ent_at(const struct fcb_entry *loc,
+                     struct ble_store_fcb_idx **out_idx, int *out_i)
+{
+    static struct ble_store_fcb_idx * const idxs[] = {
+        &ble_store_fcb_our_sec,
+        &ble_store_fcb_peer_sec,
+        &ble_store_fcb_cccd,
+    };
+    struct ble_store_fcb_ent *ent;
+    int i;
+    int j;
+
+    for (i = 0; i < sizeof(idxs) / sizeof(idxs[0]); i++) {
+        for (j = 0; j < idxs[i]->bsx_cnt; j++) {
+            ent = &idxs[i]->bsx_ents[j];
+            if (ent->bse_area == loc->fe_area &&
+                ent->bse_data_off == loc->fe_data_off) {
+
+                *out_idx = idxs[i];
+                *out_i = j;
+                return ent;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Frees the oldest sector, first copying the records in it that are still
+ * the newest for their object.  Superseded records and deletions are
+ * dropped; anything a deletion there refers to is in the same sector.
+ */
+static void
+ble_store_fcb_compress(void)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_idx *idx;
+    struct ble_store_fcb_ent *ent;
+    struct fcb_entry loc1;
+    struct fcb_entry loc2;
+    int i;
+    int rc;
+
+    rc = fcb_append_to_scratch(&ble_store_fcb_fcb);
+    if (rc) {
+        return;
+    }
+
+    loc1.fe_area = NULL;
+    loc1.fe_elem_off = 0;
+    while (fcb_getnext(&ble_store_fcb_fcb, &loc1) == 0) {
+        if (loc1.fe_area != ble_store_fcb_fcb.f_oldest) {
+            break;
+        }
+        ent = ble_store_fcb_ent_at(&loc1, &idx, &i);
+        if (!ent) {
+            continue;
+        }
+
+        rc = ble_store_fcb_rec_read(loc1.fe_area, loc1.fe_data_off, &rec);
+        if (rc == 0) {
+            rc = fcb_append(&ble_store_fcb_fcb, sizeof(rec), &loc2);
+        }
+        if (rc == 0) {
+            rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, &rec,
+                                  sizeof(rec));
+        }
+        if (rc) {
+            /* The record is lost with the sector; forget it. */
+            ble_store_fcb_idx_remove(idx, i);
+            continue;
+        }
+        fcb_append_finish(&ble_store_fcb_fcb, &loc2);
+        ent->bse_area = loc2.fe_area;
+        ent->bse_data_off = loc2.fe_data_off;
+    }
+
+    fcb_rotate(&ble_store_fcb_fcb);
+}
+
+static int
+ble_store_fcb_append(const struct ble_store_fcb_rec *rec,
+                     struct fcb_entry *out_loc)
+{
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        rc = fcb_append(&ble_store_fcb_fcb, sizeof(*rec), &loc);
+        if (rc != FCB_ERR_NOSPACE) {
+            break;
+        }
+        if (ble_store_fcb_fcb.f_scratch_cnt == 0) {
+            return BLE_HS_ESTORE_CAP;
+        }
+        ble_store_fcb_compress();
+    }
+    if (rc) {
+        return BLE_HS_ESTORE_FAIL;
+    }
+
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, rec, sizeof(*rec));
+    if (rc) {
+        return BLE_HS_ESTORE_FAIL;
+    }
+    fcb_append_finish(&ble_store_fcb_fcb, &loc);
+
+    *out_loc = loc;
+    return 0;
+}
+
+int
+ble_store_fcb_read(int obj_type, const union ble_store_key *key,
+                   union ble_store_value *value)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_idx *idx;
+    struct ble_store_fcb_ent *ent;
+    int rc;
+    int i;
+
+    idx = ble_store_fcb_idx_get(obj_type);
+    if (!idx) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    i = ble_store_fcb_find(obj_type, key, idx);
+    if (i < 0) {
+        return BLE_HS_ENOENT;
+    }
+
+    ent = &idx->bsx_ents[i];
+    rc = ble_store_fcb_rec_read(ent->bse_area, ent->bse_data_off, &rec);
+    if (rc) {
+        return rc;
+    }
+
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        value->cccd = rec.bsr_val.cccd;
+    } else {
+        value->sec = rec.bsr_val.sec;
+    }
+    return 0;
+}
+
+int
+ble_store_fcb_write(int obj_type, const union ble_store_value *val)
+{
+    struct ble_store_fcb_rec old;
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_idx *idx;
+    struct ble_store_fcb_ent ent;
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    idx = ble_store_fcb_idx_get(obj_type);
+    if (!idx) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.bsr_obj_type = obj_type;
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        rec.bsr_val.cccd = val->cccd;
+    } else {
+        rec.bsr_val.sec = val->sec;
+    }
+
+    ble_store_fcb_ident(obj_type, val, &ent);
+    i = ble_store_fcb_lower_bound(idx, &ent.bse_peer_addr,
+                                  ent.bse_chr_val_handle);
+    if (i < idx->bsx_cnt &&
+        ble_store_fcb_ent_cmp(&ent.bse_peer_addr, ent.bse_chr_val_handle,
+                              &idx->bsx_ents[i]) == 0) {
+        /* Rewriting an unchanged value costs flash for nothing. */
+        rc = ble_store_fcb_rec_read(idx->bsx_ents[i].bse_area,
+                                    idx->bsx_ents[i].bse_data_off, &old);
+        if (rc == 0 && memcmp(&old, &rec, sizeof(rec)) == 0) {
+            return 0;
+        }
+    } else if (idx->bsx_cnt >= idx->bsx_max) {
+        return BLE_HS_ESTORE_CAP;
+    }
+
+    rc = ble_store_fcb_append(&rec, &loc);
+    if (rc) {
+        return rc;
+    }
+
+    ent.bse_area = loc.fe_area;
+    ent.bse_data_off = loc.fe_data_off;
+    return ble_store_fcb_idx_set(idx, &ent);
+}
+
+int
+ble_store_fcb_delete(int obj_type, const union ble_store_key *key)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_idx *idx;
+    struct ble_store_fcb_ent ent;
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    idx = ble_store_fcb_idx_get(obj_type);
+    if (!idx) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    i = ble_store_fcb_find(obj_type, key, idx);
+    if (i < 0) {
+        return BLE_HS_ENOENT;
+    }
+    ent = idx->bsx_ents[i];
+
+    memset(&rec, 0, sizeof(rec));
+    rec.bsr_obj_type = obj_type;
+    rec.bsr_flags = BLE_STORE_FCB_F_DELETED;
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        rec.bsr_val.cccd.peer_addr = ent.bse_peer_addr;
+        rec.bsr_val.cccd.chr_val_handle = ent.bse_chr_val_handle;
+    } else {
+        rec.bsr_val.sec.peer_addr = ent.bse_peer_addr;
+    }
+
+    rc = ble_store_fcb_append(&rec, &loc);
+    if (rc) {
+        return rc;
+    }
+
+    /* Compaction may have shifted the index; look the entry up again. */
+    i = ble_store_fcb_lower_bound(idx, &ent.bse_peer_addr,
+                                  ent.bse_chr_val_handle);
+    if (i < idx->bsx_cnt &&
+        ble_store_fcb_ent_cmp(&ent.bse_peer_addr, ent.bse_chr_val_handle,
+                              &idx->bsx_ents[i]) == 0) {
+        ble_store_fcb_idx_remove(idx, i);
+    }
+    return 0;
+}
+
+int
+ble_store_fcb_read_peer_sec_by_irk(const uint8_t *irk,
+                                   struct ble_store_value_sec *out_value)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_ent *ent;
+    uint32_t word;
+    int i;
+
+    memcpy(&word, irk, sizeof(word));
+    for (i = 0; i < ble_store_fcb_peer_sec.bsx_cnt; i++) {
+        ent = &ble_store_fcb_peer_sec.bsx_ents[i];
+        if (ent->bse_irk_word != word) {
+            continue;
+        }
+        if (ble_store_fcb_rec_read(ent->bse_area, ent->bse_data_off,
+                                   &rec) != 0) {
+            continue;
+        }
+        if (rec.bsr_val.sec.irk_present &&
+            memcmp(rec.bsr_val.sec.irk, irk, 16) == 0) {
+
+            *out_value = rec.bsr_val.sec;
+            return 0;
+        }
+    }
+    return BLE_HS_ENOENT;
+}
+
+/**
+ * Replays the FCB into the index.  Records are walked oldest first, so
+ * each object ends up pointing at its newest record.
+ */
+static int
+ble_store_fcb_load_cb(struct fcb_entry *loc, void *arg)
+{
+    struct ble_store_fcb_rec rec;
+    struct ble_store_fcb_idx *idx;
+    struct ble_store_fcb_ent ent;
+    int i;
+
+    if (loc->fe_data_len != sizeof(rec) ||
+        ble_store_fcb_rec_read(loc->fe_area, loc->fe_data_off, &rec) != 0) {
+        return 0;
+    }
+    idx = ble_store_fcb_idx_get(rec.bsr_obj_type);
+    if (!idx) {
+        return 0;
+    }
+
+    ble_store_fcb_ident(rec.bsr_obj_type, &rec.bsr_val, &ent);
+    ent.bse_area = loc->fe_area;
+    ent.bse_data_off = loc->fe_data_off;
+
+    if (rec.bsr_flags & BLE_STORE_FCB_F_DELETED) {
+        i = ble_store_fcb_lower_bound(idx, &ent.bse_peer_addr,
+                                      ent.bse_chr_val_handle);
+        if (i < idx->bsx_cnt &&
+            ble_store_fcb_ent_cmp(&ent.bse_peer_addr, ent.bse_chr_val_handle,
+                                  &idx->bsx_ents[i]) == 0) {
+            ble_store_fcb_idx_remove(idx, i);
+        }
+    } else {
+        /* If the store shrank, objects that no longer fit are dropped. */
+        ble_store_fcb_idx_set(idx, &ent);
+    }
+    return 0;
+}
+
+void
+ble_store_fcb_pkg_init(void)
+{
+    struct fcb *fcb;
+    int cnt;
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    fcb = &ble_store_fcb_fcb;
+
+    rc = flash_area_to_sectors(MYNEWT_VAL(BLE_STORE_FCB_FLASH_AREA), &cnt,
+                               NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    SYSINIT_PANIC_ASSERT(
+        cnt <= sizeof(ble_store_fcb_areas) / sizeof(ble_store_fcb_areas[0]));
+    flash_area_to_sectors(MYNEWT_VAL(BLE_STORE_FCB_FLASH_AREA), &cnt,
+                          ble_store_fcb_areas);
+
+    fcb->f_sector_cnt = cnt;
+    fcb->f_scratch_cnt = cnt > 1 ? 1 : 0;
+    while (1) {
+        rc = fcb_init(fcb);
+        if (rc) {
+            for (cnt = 0; cnt < fcb->f_sector_cnt; cnt++) {
+                flash_area_erase(&ble_store_fcb_areas[cnt], 0,
+                                 ble_store_fcb_areas[cnt].fa_size);
+            }
+            rc = fcb_init(fcb);
+            SYSINIT_PANIC_ASSERT(rc == 0);
+        }
+
+        /*
+         * A reset in the middle of compaction leaves no free scratch
+         * sector; the partially filled one is redone.
+         */
+        if (fcb->f_scratch_cnt && fcb_free_sector_cnt(fcb) < 1) {
+            flash_area_erase(fcb->f_active.fe_area, 0,
+                             fcb->f_active.fe_area->fa_size);
+        } else {
+            break;
+        }
+    }
+
+    rc = fcb_walk(fcb, NULL, ble_store_fcb_load_cb, NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    ble_hs_cfg.store_read_cb = ble_store_fcb_read;
+    ble_hs_cfg.store_write_cb = ble_store_fcb_write;
+    ble_hs_cfg.store_delete_cb = ble_store_fcb_delete;
+}
@@ -114,6 +114,17 @@ extern "C" {
  */
 #define PBUF_POOL_FREE_OOSEQ            0
 
+/* Custom pbufs carry socket mbufs to lwIP without copying. */
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+
+/* Lets drivers with checksum offload turn off lwIP checksumming. */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+
+/* Software checksums use the kernel's word-at-a-time routine. */
+#include <stdint.h>
+uint16_t os_cksum16(const void *buf, int len);
+#define LWIP_CHKSUM                     os_cksum16
+
 /* PBUF_LINK_HLEN: the number of bytes that should be allocated for a
    link level header. */
 #define PBUF_LINK_HLEN                  16
@@ -20,6 +20,8 @@
 #define __SYS_MN_SOCKET_H_
 
 #include <inttypes.h>
+#include "os/os_eventq.h"
+#include "os/queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -69,12 +71,18 @@ extern "C" {
 struct mn_socket;
 struct mn_socket_ops;
 struct mn_sock_cb;
+struct mn_poll;
 struct os_mbuf;
 
 struct mn_socket {
     const union mn_socket_cb *ms_cbs;          /* filled in by user */
     void *ms_cb_arg;                           /* filled in by user */
     const struct mn_socket_ops *ms_ops;        /* filled in by mn_socket */
+    struct mn_poll *ms_poll;                   /* filled in by mn_poll_add */
+    STAILQ_ENTRY(mn_socket) ms_poll_next;
+    uint8_t ms_poll_events;
+    uint8_t ms_poll_revents;
+    int16_t ms_poll_err;
 };
 
 /*
@@ -158,6 +166,14 @@ struct mn_mreq {
  *
  * If remote end closes the socket, socket callback (*readable) will be
  * called.
+ *
+ * mn_recvfrom_batch() and mn_sendto_batch() move several datagrams in one
+ * call. Each packet carries its peer address in the packet header's user
+ * area, which must have room for struct mn_sockaddr_in6.
+ * mn_recvfrom_batch() appends up to max packets to the list, and returns
+ * MN_EAGAIN if none were queued. mn_sendto_batch() sends packets from the
+ * head of the list. On error the packet that failed and the ones after it
+ * are left on the list, and remain owned by the caller.
  */
 int mn_socket(struct mn_socket **, uint8_t domain, uint8_t type, uint8_t proto);
 int mn_bind(struct mn_socket *, struct mn_sockaddr *);
@@ -168,6 +184,11 @@ int mn_recvfrom(struct mn_socket *, struct os_mbuf **,
   struct mn_sockaddr *from);
 int mn_sendto(struct mn_socket *, struct os_mbuf *, struct mn_sockaddr *to);
 
+STAILQ_HEAD(mn_pkt_list, os_mbuf_pkthdr);
+
+int mn_recvfrom_batch(struct mn_socket *, struct mn_pkt_list *, int max);
+int mn_sendto_batch(struct mn_socket *, struct mn_pkt_list *);
+
 int mn_getsockopt(struct mn_socket *, uint8_t level, uint8_t optname,
   void *optval);
 int mn_setsockopt(struct mn_socket *, uint8_t level, uint8_t optname,
@@ -184,6 +205,40 @@ int mn_close(struct mn_socket *);
         (sock)->ms_cb_arg = (cb_arg);                                   \
     } while (0)
 
+/*
+ * Readiness multiplexing.
+ *
+ * Sockets added to an mn_poll report readiness through one event, posted to
+ * the poll's event queue when the first of them becomes ready. mn_poll_get()
+ * then returns the ready sockets in a batch. Notifications are edge
+ * triggered: a socket is reported once per readable/writable upcall from
+ * the socket provider, so the application should read until mn_recvfrom()
+ * returns MN_EAGAIN. Socket callbacks set with mn_socket_set_cbs() are
+ * still called. Listen sockets are not supported. A socket is removed from
+ * its poll when it's closed.
+ */
+#define MN_POLLIN               0x01
+#define MN_POLLOUT              0x02
+#define MN_POLLERR              0x04    /* always reported */
+
+struct mn_poll {
+    struct os_eventq *mp_evq;
+    struct os_event mp_ev;
+    STAILQ_HEAD(, mn_socket) mp_ready;
+};
+
+struct mn_poll_result {
+    struct mn_socket *mpr_sock;
+    uint8_t mpr_revents;
+    int mpr_err;                /* error with MN_POLLERR */
+};
+
+void mn_poll_init(struct mn_poll *mp, struct os_eventq *evq, os_event_fn *cb,
+  void *cb_arg);
+int mn_poll_add(struct mn_poll *mp, struct mn_socket *, uint8_t events);
+void mn_poll_del(struct mn_socket *);
+int mn_poll_get(struct mn_poll *mp, struct mn_poll_result *res, int max);
+
 /*
  * Address conversion
  */
@@ -31,6 +31,9 @@ extern "C" {
  *   the socket provider.
  * - mso_close() closes the socket, memory should be freed. User should not
  *   be using the socket pointer once it has been closed.
+ * - mso_recvfrom_batch() and mso_sendto_batch() are optional. If they're
+ *   not provided, mn_sendto_batch() falls back to mso_sendto(), and
+ *   mn_recvfrom_batch() returns MN_EPROTONOSUPPORT.
  */
 struct mn_socket_ops {
     int (*mso_create)(struct mn_socket **, uint8_t domain, uint8_t type,
@@ -45,6 +48,9 @@ struct mn_socket_ops {
       struct mn_sockaddr *to);
     int (*mso_recvfrom)(struct mn_socket *, struct os_mbuf **,
       struct mn_sockaddr *from);
+    int (*mso_sendto_batch)(struct mn_socket *, struct mn_pkt_list *);
+    int (*mso_recvfrom_batch)(struct mn_socket *, struct mn_pkt_list *,
+      int max);
 
     int (*mso_getsockopt)(struct mn_socket *, uint8_t level, uint8_t name,
       void *val);
@@ -60,9 +66,18 @@ struct mn_socket_ops {
 
 int mn_socket_ops_reg(const struct mn_socket_ops *ops);
 
+/*
+ * Socket providers must clear ms_poll on sockets they create for incoming
+ * connections before passing them to mn_socket_newconn().
+ */
+void mn_poll_notify(struct mn_socket *s, uint8_t events, int error);
+
 static inline void
 mn_socket_writable(struct mn_socket *s, int error)
 {
+    if (s->ms_poll) {
+        mn_poll_notify(s, MN_POLLOUT, error);
+    }
     if (s->ms_cbs && s->ms_cbs->socket.writable) {
         s->ms_cbs->socket.writable(s->ms_cb_arg, error);
     }
@@ -71,6 +86,9 @@ mn_socket_writable(struct mn_socket *s, int error)
 static inline void
 mn_socket_readable(struct mn_socket *s, int error)
 {
+    if (s->ms_poll) {
+        mn_poll_notify(s, MN_POLLIN, error);
+    }
     if (s->ms_cbs && s->ms_cbs->socket.readable) {
         s->ms_cbs->socket.readable(s->ms_cb_arg, error);
     }
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#include "mn_socket/mn_socket.h"
+#include "mn_socket/mn_socket_ops.h"
+
+void
+mn_poll_init(struct mn_poll *mp, struct os_eventq *evq, os_event_fn *cb,
+  void *cb_arg)
+{
+    memset(mp, 0, sizeof(*mp));
+    mp->mp_evq = evq;
+    mp->mp_ev.ev_cb = cb;
+    mp->mp_ev.ev_arg = cb_arg;
+    STAILQ_INIT(&mp->mp_ready);
+}
+
+int
+mn_poll_add(struct mn_poll *mp, struct mn_socket *s, uint8_t events)
+{
+    os_sr_t sr;
+    int rc;
+
+    rc = 0;
+    OS_ENTER_CRITICAL(sr);
+    if (s->ms_poll == NULL) {
+        s->ms_poll = mp;
+        s->ms_poll_revents = 0;
+        s->ms_poll_err = 0;
+    }
+    if (s->ms_poll == mp) {
+        s->ms_poll_events = events;
+    } else {
+        rc = MN_EINVAL;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+void
+mn_poll_del(struct mn_socket *s)
+{
+    struct mn_poll *mp;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    mp = s->ms_poll;
+    if (mp && s->ms_poll_revents) {
+        STAILQ_REMOVE(&mp->mp_ready, s, mn_socket, ms_poll_next);
+    }
+    s->ms_poll = NULL;
+    s->ms_poll_revents = 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+mn_poll_get(struct mn_poll *mp, struct mn_poll_result *res, int max)
+{
+    struct mn_socket *s;
+    os_sr_t sr;
+    int more;
+    int cnt;
+
+    OS_ENTER_CRITICAL(sr);
+    for (cnt = 0; cnt < max; cnt++) {
+        s = STAILQ_FIRST(&mp->mp_ready);
+        if (!s) {
+            break;
+        }
+        STAILQ_REMOVE_HEAD(&mp->mp_ready, ms_poll_next);
+        res[cnt].mpr_sock = s;
+        res[cnt].mpr_revents = s->ms_poll_revents;
+        res[cnt].mpr_err = s->ms_poll_err;
+        s->ms_poll_revents = 0;
+        s->ms_poll_err = 0;
+    }
+    more = !STAILQ_EMPTY(&mp->mp_ready);
+    OS_EXIT_CRITICAL(sr);
+
+    if (more) {
+        /*
+         * Didn't fit, come back for the rest.
+         */
+        os_eventq_put(mp->mp_evq, &mp->mp_ev);
+    }
+
+    return cnt;
+}
+
+/*
+ * Called by socket providers, through mn_socket_readable() and
+ * mn_socket_writable().
+ */
+void
+mn_poll_notify(struct mn_socket *s, uint8_t events, int error)
+{
+    struct mn_poll *mp;
+    os_sr_t sr;
+
+    if (error) {
+        events |= MN_POLLERR;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    mp = s->ms_poll;
+    if (mp) {
+        events &= s->ms_poll_events | MN_POLLERR;
+    } else {
+        events = 0;
+    }
+    if (events) {
+        if (!s->ms_poll_revents) {
+            STAILQ_INSERT_TAIL(&mp->mp_ready, s, ms_poll_next);
+        }
+        s->ms_poll_revents |= events;
+        if (error) {
+            s->ms_poll_err = error;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (events) {
+        os_eventq_put(mp->mp_evq, &mp->mp_ev);
+    }
+}
@@ -62,6 +62,7 @@ mn_socket(struct mn_socket **sp, uint8_t domain, uint8_t type, uint8_t proto)
     rc = mn_sock_tgt->mso_create(sp, domain, type, proto);
     if (*sp) {
         (*sp)->ms_ops = mn_sock_tgt;
+        (*sp)->ms_poll = NULL;
     }
     return rc;
 }
@@ -96,6 +97,36 @@ mn_sendto(struct mn_socket *s, struct os_mbuf *m, struct mn_sockaddr *to)
     return s->ms_ops->mso_sendto(s, m, to);
 }
 
+int
+mn_recvfrom_batch(struct mn_socket *s, struct mn_pkt_list *list, int max)
+{
+    if (!s->ms_ops->mso_recvfrom_batch) {
+        return MN_EPROTONOSUPPORT;
+    }
+    return s->ms_ops->mso_recvfrom_batch(s, list, max);
+}
+
+int
+mn_sendto_batch(struct mn_socket *s, struct mn_pkt_list *list)
+{
+    struct os_mbuf_pkthdr *omp;
+    int rc;
+
+    if (s->ms_ops->mso_sendto_batch) {
+        return s->ms_ops->mso_sendto_batch(s, list);
+    }
+    while ((omp = STAILQ_FIRST(list)) != NULL) {
+        STAILQ_REMOVE_HEAD(list, omp_next);
+        rc = s->ms_ops->mso_sendto(s, OS_MBUF_PKTHDR_TO_MBUF(omp),
+                                   (struct mn_sockaddr *)(omp + 1));
+        if (rc) {
+            STAILQ_INSERT_HEAD(list, omp, omp_next);
+            return rc;
+        }
+    }
+    return 0;
+}
+
 int
 mn_getsockopt(struct mn_socket *s, uint8_t level, uint8_t name, void *val)
 {
@@ -123,6 +154,9 @@ mn_getpeername(struct mn_socket *s, struct mn_sockaddr *addr)
 int
 mn_close(struct mn_socket *s)
 {
+    if (s->ms_poll) {
+        mn_poll_del(s);
+    }
     return s->ms_ops->mso_close(s);
 }
 
@@ -33,6 +33,8 @@ void sock_open_close(void);
 void sock_listen(void);
 void sock_tcp_connect(void);
 void sock_udp_data(void);
+void sock_udp_poll(void);
+void sock_udp_batch(void);
 void sock_tcp_data(void);
 void sock_itf_list(void);
 void sock_udp_ll(void);
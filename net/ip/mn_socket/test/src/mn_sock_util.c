@@ -277,6 +277,208 @@ sock_udp_data(void)
     mn_close(sock2);
 }
 
+static void
+sup_poll_cb(struct os_event *ev)
+{
+}
+
+void
+sock_udp_poll(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_socket *sock3;
+    struct mn_sockaddr_in msin;
+    struct mn_sockaddr_in msin2;
+    struct mn_sockaddr_in from;
+    struct os_eventq evq;
+    struct os_eventq *evqp;
+    struct os_event *ev;
+    struct mn_poll mp;
+    struct mn_poll mp2;
+    struct mn_poll_result res[2];
+    struct os_mbuf *m;
+    char data[] = "1234567890";
+    int seen1;
+    int seen3;
+    int cnt;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+    evqp = &evq;
+    mn_poll_init(&mp, &evq, sup_poll_cb, NULL);
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    rc = mn_socket(&sock3, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = htons(12446);
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    msin2 = msin;
+    msin2.msin_port = htons(12447);
+    rc = mn_bind(sock3, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT(rc == 0);
+
+    rc = mn_poll_add(&mp, sock1, MN_POLLIN);
+    TEST_ASSERT(rc == 0);
+    rc = mn_poll_add(&mp, sock3, MN_POLLIN);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Socket can only be in one poll set at a time.
+     */
+    mn_poll_init(&mp2, &evq, sup_poll_cb, NULL);
+    rc = mn_poll_add(&mp2, sock1, MN_POLLIN);
+    TEST_ASSERT(rc == MN_EINVAL);
+
+    m = os_msys_get(sizeof(data), 0);
+    TEST_ASSERT(m);
+    rc = os_mbuf_copyinto(m, 0, data, sizeof(data));
+    TEST_ASSERT(rc == 0);
+    rc = mn_sendto(sock2, m, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    m = os_msys_get(sizeof(data), 0);
+    TEST_ASSERT(m);
+    rc = os_mbuf_copyinto(m, 0, data, sizeof(data));
+    TEST_ASSERT(rc == 0);
+    rc = mn_sendto(sock2, m, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Both sockets should show up as readable, possibly over
+     * several poll events.
+     */
+    seen1 = 0;
+    seen3 = 0;
+    while (!seen1 || !seen3) {
+        ev = os_eventq_poll(&evqp, 1, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(ev == &mp.mp_ev);
+
+        cnt = mn_poll_get(&mp, res, 2);
+        for (i = 0; i < cnt; i++) {
+            TEST_ASSERT(res[i].mpr_revents == MN_POLLIN);
+            TEST_ASSERT(res[i].mpr_err == 0);
+            if (res[i].mpr_sock == sock1) {
+                seen1++;
+            } else if (res[i].mpr_sock == sock3) {
+                seen3++;
+            } else {
+                TEST_ASSERT(0);
+            }
+            rc = mn_recvfrom(res[i].mpr_sock, &m,
+              (struct mn_sockaddr *)&from);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(m != NULL);
+            if (m) {
+                TEST_ASSERT(OS_MBUF_PKTLEN(m) == sizeof(data));
+                os_mbuf_free_chain(m);
+            }
+        }
+    }
+    TEST_ASSERT(seen1 == 1);
+    TEST_ASSERT(seen3 == 1);
+    TEST_ASSERT(mn_poll_get(&mp, res, 2) == 0);
+
+    mn_close(sock1);
+    mn_close(sock2);
+    mn_close(sock3);
+}
+
+void
+sock_udp_batch(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_sockaddr_in msin;
+    struct mn_pkt_list pkts;
+    struct os_mbuf_pkthdr *omp;
+    struct mn_sockaddr_in *from;
+    struct os_mbuf *m;
+    union mn_socket_cb sock_cbs = {
+        .socket.readable = sud_readable
+    };
+    char data[] = "1234567890";
+    int cnt;
+    int rc;
+    int i;
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    mn_socket_set_cbs(sock1, NULL, &sock_cbs);
+
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = htons(12448);
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    STAILQ_INIT(&pkts);
+    rc = mn_recvfrom_batch(sock1, &pkts, 4);
+    TEST_ASSERT(rc == MN_EAGAIN);
+
+    /*
+     * Queue 3 datagrams, destination address in the user header.
+     */
+    for (i = 0; i < 3; i++) {
+        m = os_msys_get_pkthdr(sizeof(data), sizeof(struct mn_sockaddr_in6));
+        TEST_ASSERT_FATAL(m != NULL);
+        rc = os_mbuf_copyinto(m, 0, data, sizeof(data));
+        TEST_ASSERT(rc == 0);
+        memcpy(OS_MBUF_USRHDR(m), &msin, sizeof(msin));
+        STAILQ_INSERT_TAIL(&pkts, OS_MBUF_PKTHDR(m), omp_next);
+    }
+    rc = mn_sendto_batch(sock2, &pkts);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(STAILQ_EMPTY(&pkts));
+
+    cnt = 0;
+    while (cnt < 3) {
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        STAILQ_INIT(&pkts);
+        rc = mn_recvfrom_batch(sock1, &pkts, 4);
+        if (rc == MN_EAGAIN) {
+            continue;
+        }
+        TEST_ASSERT(rc == 0);
+        while ((omp = STAILQ_FIRST(&pkts)) != NULL) {
+            STAILQ_REMOVE_HEAD(&pkts, omp_next);
+            m = OS_MBUF_PKTHDR_TO_MBUF(omp);
+            from = OS_MBUF_USRHDR(m);
+            TEST_ASSERT(from->msin_family == MN_AF_INET);
+            TEST_ASSERT(from->msin_port != 0);
+            TEST_ASSERT(OS_MBUF_PKTLEN(m) == sizeof(data));
+            os_mbuf_free_chain(m);
+            cnt++;
+        }
+    }
+    TEST_ASSERT(cnt == 3);
+
+    /*
+     * Consume the remaining readable notifications.
+     */
+    while (os_sem_pend(&test_sem, 0) == 0) {
+    }
+
+    mn_close(sock1);
+    mn_close(sock2);
+}
+
 void
 std_writable(void *cb_arg, int err)
 {
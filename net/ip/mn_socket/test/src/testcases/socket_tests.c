@@ -27,6 +27,8 @@ TEST_CASE_TASK(socket_tests)
     sock_listen();
     sock_tcp_connect();
     sock_udp_data();
+    sock_udp_poll();
+    sock_udp_batch();
     sock_tcp_data();
     sock_itf_list();
     sock_udp_ll();
@@ -43,6 +43,8 @@ int native_sock_sendto(struct mn_socket *, struct os_mbuf *,
   struct mn_sockaddr *);
 int native_sock_recvfrom(struct mn_socket *, struct os_mbuf **,
   struct mn_sockaddr *);
+int native_sock_recvfrom_batch(struct mn_socket *, struct mn_pkt_list *,
+  int max);
 int native_sock_getsockopt(struct mn_socket *, uint8_t level,
   uint8_t name, void *val);
 int native_sock_setsockopt(struct mn_socket *, uint8_t level,
@@ -66,6 +66,7 @@ static const struct mn_socket_ops native_sock_ops = {
 
     .mso_sendto = native_sock_sendto,
     .mso_recvfrom = native_sock_recvfrom,
+    .mso_recvfrom_batch = native_sock_recvfrom_batch,
 
     .mso_getsockopt = native_sock_getsockopt,
     .mso_setsockopt = native_sock_setsockopt,
@@ -595,6 +596,42 @@ native_sock_recvfrom(struct mn_socket *s, struct os_mbuf **mp,
     return 0;
 }
 
+int
+native_sock_recvfrom_batch(struct mn_socket *s, struct mn_pkt_list *list,
+  int max)
+{
+    struct native_sock *ns = (struct native_sock *)s;
+    struct sockaddr_storage ss;
+    struct sockaddr *sa = (struct sockaddr *)&ss;
+    uint8_t tmpbuf[MYNEWT_VAL(NATIVE_SOCKETS_MAX_UDP)];
+    struct os_mbuf *m;
+    socklen_t slen;
+    int cnt;
+    int rc;
+
+    if (ns->ns_type != SOCK_DGRAM) {
+        return MN_EPROTONOSUPPORT;
+    }
+    for (cnt = 0; cnt < max; cnt++) {
+        slen = sizeof(ss);
+        rc = recvfrom(ns->ns_fd, tmpbuf, sizeof(tmpbuf), 0, sa, &slen);
+        if (rc < 0) {
+            if (cnt == 0) {
+                return native_sock_err_to_mn_err(errno);
+            }
+            break;
+        }
+        m = os_msys_get_pkthdr(rc, sizeof(struct mn_sockaddr_in6));
+        if (!m) {
+            return cnt ? 0 : MN_ENOBUFS;
+        }
+        os_mbuf_copyinto(m, 0, tmpbuf, rc);
+        native_sock_addr_to_mn_addr(sa, OS_MBUF_USRHDR(m));
+        STAILQ_INSERT_TAIL(list, OS_MBUF_PKTHDR(m), omp_next);
+    }
+    return 0;
+}
+
 int
 native_sock_getsockopt(struct mn_socket *s, uint8_t level, uint8_t name,
   void *val)
@@ -777,6 +814,7 @@ socket_task(void *arg)
                     }
                     new_ns->ns_type = ns->ns_type;
                     new_ns->ns_sock.ms_ops = &native_sock_ops;
+                    new_ns->ns_sock.ms_poll = NULL;
                     os_mutex_release(&nss->mtx);
                     if (mn_socket_newconn(&ns->ns_sock, &new_ns->ns_sock)) {
                         /*
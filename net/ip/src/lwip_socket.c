@@ -40,6 +40,9 @@ static int lwip_sendto(struct mn_socket *, struct os_mbuf *,
   struct mn_sockaddr *);
 static int lwip_recvfrom(struct mn_socket *, struct os_mbuf **,
   struct mn_sockaddr *);
+static int lwip_sendto_batch(struct mn_socket *, struct mn_pkt_list *);
+static int lwip_recvfrom_batch(struct mn_socket *, struct mn_pkt_list *,
+  int max);
 static int lwip_getsockopt(struct mn_socket *, uint8_t level,
   uint8_t name, void *val);
 static int lwip_setsockopt(struct mn_socket *, uint8_t level,
@@ -57,6 +60,8 @@ static const struct mn_socket_ops lwip_sock_ops = {
 
     .mso_sendto = lwip_sendto,
     .mso_recvfrom = lwip_recvfrom,
+    .mso_sendto_batch = lwip_sendto_batch,
+    .mso_recvfrom_batch = lwip_recvfrom_batch,
 
     .mso_getsockopt = lwip_getsockopt,
     .mso_setsockopt = lwip_setsockopt,
@@ -84,6 +89,172 @@ static struct os_mempool lwip_sockets;
 
 static int lwip_stream_tx(struct lwip_sock *s, int notify);
 
+#if MYNEWT_VAL(LWIP_SOCK_ZERO_COPY)
+/*
+ * Received pbuf segment lent to an external data mbuf.
+ */
+struct lwip_rx_ext {
+    struct os_mbuf_ext re_ext;
+    struct pbuf *re_pbuf;
+};
+
+/*
+ * Custom pbuf pointing to the data of an mbuf being sent.
+ */
+struct lwip_tx_pbuf {
+    struct pbuf_custom tp_pbuf;
+    struct os_mbuf *tp_om;
+};
+
+static struct os_mempool lwip_rx_exts;
+static struct os_mempool lwip_tx_pbufs;
+
+static void
+lwip_rx_ext_free(struct os_mbuf_ext *ome)
+{
+    struct lwip_rx_ext *re = (struct lwip_rx_ext *)ome;
+
+    pbuf_free(re->re_pbuf);
+    os_memblock_put(&lwip_rx_exts, re);
+}
+
+/*
+ * Appends the data in pbuf chain p to packet m by reference. Each segment
+ * holds a reference to its pbuf until the mbuf pointing to it is freed.
+ */
+static int
+lwip_pbuf_lend(struct os_mbuf *m, struct pbuf *p)
+{
+    struct lwip_rx_ext *re;
+    struct os_mbuf *n;
+    struct pbuf *q;
+
+    for (q = p; q; q = q->next) {
+        if (!q->len) {
+            continue;
+        }
+        re = os_memblock_get(&lwip_rx_exts);
+        if (!re) {
+            return -1;
+        }
+        re->re_ext.ome_buf = q->payload;
+        re->re_ext.ome_len = q->len;
+        re->re_ext.ome_refcnt = 0;
+        re->re_ext.ome_free_cb = lwip_rx_ext_free;
+        re->re_ext.ome_arg = NULL;
+        re->re_pbuf = q;
+
+        n = os_mbuf_get_ext(m->om_omp, &re->re_ext, 0, q->len);
+        if (!n) {
+            os_memblock_put(&lwip_rx_exts, re);
+            return -1;
+        }
+        pbuf_ref(q);
+        os_mbuf_concat(m, n);
+    }
+    return 0;
+}
+
+static void
+lwip_tx_pbuf_free(struct pbuf *p)
+{
+    struct lwip_tx_pbuf *tp = (struct lwip_tx_pbuf *)p;
+
+    if (tp->tp_om) {
+        os_mbuf_free(tp->tp_om);
+    }
+    os_memblock_put(&lwip_tx_pbufs, tp);
+}
+
+/*
+ * Detaches the mbufs from a pbuf chain built by lwip_mbuf_lend() and frees
+ * the pbufs, leaving the mbuf chain with the caller.
+ */
+static void
+lwip_mbuf_unlend(struct pbuf *p)
+{
+    struct pbuf *q;
+
+    for (q = p; q; q = q->next) {
+        ((struct lwip_tx_pbuf *)q)->tp_om = NULL;
+    }
+    if (p) {
+        pbuf_free(p);
+    }
+}
+/*
+ * Returns a pbuf chain pointing to the data in mbuf chain m. Each mbuf is
+ * freed when lwIP lets go of the pbuf pointing to it.
+ */
+static struct pbuf *
+lwip_mbuf_lend(struct os_mbuf *m)
+{
+    struct lwip_tx_pbuf *tp;
+    struct os_mbuf *n;
+    struct pbuf *head;
+    struct pbuf *p;
+
+    head = NULL;
+    for (n = m; n; n = SLIST_NEXT(n, om_next)) {
+        tp = os_memblock_get(&lwip_tx_pbufs);
+        if (!tp) {
+            break;
+        }
+        tp->tp_pbuf.custom_free_function = lwip_tx_pbuf_free;
+        tp->tp_om = n;
+        p = pbuf_alloced_custom(PBUF_RAW, n->om_len, PBUF_REF, &tp->tp_pbuf,
+                                n->om_data, n->om_len);
+        if (head) {
+            pbuf_cat(head, p);
+        } else {
+            head = p;
+        }
+    }
+    if (n) {
+        /* ran out; give the mbufs back to the caller */
+        lwip_mbuf_unlend(head);
+        return NULL;
+    }
+    return head;
+}
+
+#endif
+
+/*
+ * Moves the data of pbuf chain p to a new mbuf packet with a user header
+ * of hdr_len bytes.
+ */
+static struct os_mbuf *
+lwip_pbuf_to_mbuf(struct pbuf *p, uint16_t hdr_len)
+{
+    struct os_mbuf *m;
+    struct pbuf *q;
+    int off;
+
+#if MYNEWT_VAL(LWIP_SOCK_ZERO_COPY)
+    m = os_msys_get_pkthdr(0, hdr_len);
+    if (m) {
+        if (lwip_pbuf_lend(m, p) == 0) {
+            return m;
+        }
+        os_mbuf_free_chain(m);
+    }
+#endif
+    m = os_msys_get_pkthdr(p->tot_len, hdr_len);
+    if (!m) {
+        return NULL;
+    }
+    off = 0;
+    for (q = p; q; q = q->next) {
+        if (os_mbuf_copyinto(m, off, q->payload, q->len)) {
+            os_mbuf_free_chain(m);
+            return NULL;
+        }
+        off += q->len;
+    }
+    return m;
+}
+
 static int
 lwip_mn_addr_to_addr(struct mn_sockaddr *ms, ip_addr_t *addr, uint16_t *port)
 {
@@ -184,21 +355,14 @@ lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
-    m = os_msys_get_pkthdr(p->tot_len, sizeof(struct mn_sockaddr_in6));
+    m = lwip_pbuf_to_mbuf(p, sizeof(struct mn_sockaddr_in6));
+    pbuf_free(p);
     if (!m) {
-        pbuf_free(p);
         return;
     }
     lwip_addr_to_mn_addr((struct mn_sockaddr *)OS_MBUF_USRHDR(m),
       addr, port);
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
-    }
-    pbuf_free(p);
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
     mn_socket_readable(&s->ls_sock, 0);
 }
@@ -210,8 +374,6 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
     if (!p) {
         /*
@@ -220,12 +382,10 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
         mn_socket_readable(&s->ls_sock, MN_ECONNABORTED);
         return ERR_OK;
     }
-    m = os_msys_get_pkthdr(p->tot_len, 0);
-    assert(m);
-    /* XXX fix this */
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
+    m = lwip_pbuf_to_mbuf(p, 0);
+    if (!m) {
+        /* lwIP holds on to the data and offers it again later */
+        return ERR_MEM;
     }
     pbuf_free(p);
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
@@ -275,6 +435,7 @@ lwip_sock_accept(void *arg, struct tcp_pcb *new, err_t err)
     }
     new_s->ls_type = MN_SOCK_STREAM;
     new_s->ls_sock.ms_ops = &lwip_sock_ops;
+    new_s->ls_sock.ms_poll = NULL;
     new_s->ls_pcb.tcp = new;
     tcp_arg(new, new_s);
     tcp_recv(new, lwip_sock_tcp_rx);
@@ -493,28 +654,34 @@ lwip_stream_tx(struct lwip_sock *s, int notify)
     return rc;
 }
 
+#if LWIP_UDP
+/*
+ * Called with TCPIP core locked.
+ */
 static int
-lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
-  struct mn_sockaddr *addr)
+lwip_udp_tx(struct lwip_sock *s, struct os_mbuf *m, struct mn_sockaddr *addr)
 {
-    struct lwip_sock *s = (struct lwip_sock *)ms;
     struct pbuf *p;
     struct os_mbuf *n;
     ip_addr_t ip_addr;
     uint16_t port;
+    int copied;
     int off;
     int rc;
 
-    switch (s->ls_type) {
-#if LWIP_UDP
-    case MN_SOCK_DGRAM:
-        if (!addr) {
-            return MN_EDESTADDRREQ;
-        }
-        rc = lwip_mn_addr_to_addr(addr, &ip_addr, &port);
-        if (rc) {
-            return rc;
-        }
+    if (!addr) {
+        return MN_EDESTADDRREQ;
+    }
+    rc = lwip_mn_addr_to_addr(addr, &ip_addr, &port);
+    if (rc) {
+        return rc;
+    }
+    p = NULL;
+    copied = 0;
+#if MYNEWT_VAL(LWIP_SOCK_ZERO_COPY)
+    p = lwip_mbuf_lend(m);
+#endif
+    if (!p) {
         off = 0;
         for (n = m; n; n = SLIST_NEXT(n, om_next)) {
             off += n->om_len;
@@ -529,16 +696,43 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
             pbuf_take_at(p, n->om_data, n->om_len, off);
             off += n->om_len;
         }
+        copied = 1;
+    }
+    rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
+#if MYNEWT_VAL(LWIP_SOCK_ZERO_COPY)
+    if (rc && !copied) {
+        /* on error the caller keeps the mbufs */
+        lwip_mbuf_unlend(p);
+        p = NULL;
+    }
+#endif
+    if (p) {
+        pbuf_free(p);
+    }
+    if (rc) {
+        return lwip_err_to_mn_err(rc);
+    }
+    if (copied) {
+        os_mbuf_free_chain(m);
+    }
+    return 0;
+}
+#endif
+
+static int
+lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
+  struct mn_sockaddr *addr)
+{
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    int rc;
+
+    switch (s->ls_type) {
+#if LWIP_UDP
+    case MN_SOCK_DGRAM:
         LOCK_TCPIP_CORE();
-        rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
+        rc = lwip_udp_tx(s, m, addr);
         UNLOCK_TCPIP_CORE();
-        if (rc) {
-            rc = lwip_err_to_mn_err(rc);
-            pbuf_free(p);
-            return rc;
-        }
-        os_mbuf_free_chain(m);
-        return 0;
+        return rc;
 #endif
 #if LWIP_TCP
     case MN_SOCK_STREAM:
@@ -559,6 +753,35 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
     }
 }
 
+static int
+lwip_sendto_batch(struct mn_socket *ms, struct mn_pkt_list *list)
+{
+#if LWIP_UDP
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    struct os_mbuf_pkthdr *omp;
+    int rc;
+
+    if (s->ls_type != MN_SOCK_DGRAM) {
+        return MN_EPROTONOSUPPORT;
+    }
+    rc = 0;
+    LOCK_TCPIP_CORE();
+    while ((omp = STAILQ_FIRST(list)) != NULL) {
+        STAILQ_REMOVE_HEAD(list, omp_next);
+        rc = lwip_udp_tx(s, OS_MBUF_PKTHDR_TO_MBUF(omp),
+                         (struct mn_sockaddr *)(omp + 1));
+        if (rc) {
+            STAILQ_INSERT_HEAD(list, omp, omp_next);
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+    return rc;
+#else
+    return MN_EPROTONOSUPPORT;
+#endif
+}
+
 static int
 lwip_recvfrom(struct mn_socket *ms, struct os_mbuf **mp,
   struct mn_sockaddr *addr)
@@ -601,6 +824,34 @@ lwip_recvfrom(struct mn_socket *ms, struct os_mbuf **mp,
     }
 }
 
+static int
+lwip_recvfrom_batch(struct mn_socket *ms, struct mn_pkt_list *list, int max)
+{
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    struct os_mbuf_pkthdr *m;
+    int cnt;
+
+    /*
+     * Datagrams are queued with the source address already in the
+     * user header, so they can be handed over as they are.
+     */
+    if (s->ls_type != MN_SOCK_DGRAM) {
+        return MN_EPROTONOSUPPORT;
+    }
+    LOCK_TCPIP_CORE();
+    for (cnt = 0; cnt < max; cnt++) {
+        m = STAILQ_FIRST(&s->ls_rx);
+        if (!m) {
+            break;
+        }
+        STAILQ_REMOVE_HEAD(&s->ls_rx, omp_next);
+        STAILQ_INSERT_TAIL(list, m, omp_next);
+    }
+    UNLOCK_TCPIP_CORE();
+
+    return cnt ? 0 : MN_EAGAIN;
+}
+
 static int
 lwip_getsockopt(struct mn_socket *s, uint8_t level,
   uint8_t name, void *val)
@@ -737,6 +988,24 @@ lwip_socket_init(void)
     }
     os_mempool_init(&lwip_sockets, cnt, sizeof(struct lwip_sock), mem, "sock");
 
+#if MYNEWT_VAL(LWIP_SOCK_ZERO_COPY)
+    cnt = MYNEWT_VAL(LWIP_SOCK_ZERO_COPY_RX_CNT);
+    mem = os_malloc(OS_MEMPOOL_BYTES(cnt, sizeof(struct lwip_rx_ext)));
+    if (!mem) {
+        return -1;
+    }
+    os_mempool_init(&lwip_rx_exts, cnt, sizeof(struct lwip_rx_ext), mem,
+                    "sock_zrx");
+
+    cnt = MYNEWT_VAL(LWIP_SOCK_ZERO_COPY_TX_CNT);
+    mem = os_malloc(OS_MEMPOOL_BYTES(cnt, sizeof(struct lwip_tx_pbuf)));
+    if (!mem) {
+        return -1;
+    }
+    os_mempool_init(&lwip_tx_pbufs, cnt, sizeof(struct lwip_tx_pbuf), mem,
+                    "sock_ztx");
+#endif
+
     rc = mn_socket_ops_reg(&lwip_sock_ops);
     if (rc) {
         return -1;
@@ -45,6 +45,11 @@ STATS_SECT_START(lora_mac_stats)
     STATS_SECT_ENTRY(rx_invalid)
     STATS_SECT_ENTRY(no_bufs)
     STATS_SECT_ENTRY(already_joined)
+    STATS_SECT_ENTRY(tx_aggr_pkts)
+    STATS_SECT_ENTRY(tx_airtime_ms)
+    STATS_SECT_ENTRY(txq_pkts)
+    STATS_SECT_ENTRY(txq_wait_ms)
+    STATS_SECT_ENTRY(rx_port_drops)
 STATS_SECT_END
 extern STATS_SECT_DECL(lora_mac_stats) lora_mac_stats;
 
@@ -173,6 +178,11 @@ struct lora_txd_info
      * The uplink channel related to the frame
      */
     uint32_t uplink_chan;
+
+    /*!
+     * When the packet was queued for transmission (os ticks)
+     */
+    uint32_t queued_at;
 };
 
 /*
@@ -309,6 +319,49 @@ int lora_app_mtu(void);
 
 #endif
 
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+/*
+ * Per uplink link record.
+ */
+struct lora_link_rec
+{
+    uint32_t llr_time;          /* os ticks when the uplink completed */
+    uint32_t llr_airtime;       /* time on air of the last attempt (msecs) */
+    uint8_t llr_datarate;
+    int8_t llr_txpower;         /* dBm */
+    uint8_t llr_retries;
+    uint8_t llr_status;         /* LoRaMacEventInfoStatus_t */
+    uint8_t llr_ack:1;          /* confirmed uplink was acked */
+    uint8_t llr_rx:1;           /* rssi/snr valid */
+    int16_t llr_rssi;           /* of the downlink following the uplink */
+    int8_t llr_snr;
+};
+
+/**
+ * Read a link record from history.
+ *
+ * @param idx Which record; 0 is the most recent uplink.
+ * @param rec Where to store the record.
+ *
+ * @return 0 on success, non-zero if there is no such record.
+ */
+int lora_node_link_hist(int idx, struct lora_link_rec *rec);
+
+/**
+ * Data rate and TX power index the link history supports. Uses the ADR
+ * algorithm of the network server, on the SNR of the downlinks received at
+ * the current data rate, which assumes a roughly symmetric link. The
+ * application can apply the advice when ADR is off, or use it to judge the
+ * network's choice.
+ *
+ * @param dr Where to store the advised data rate.
+ * @param txpower Where to store the advised TX power index.
+ *
+ * @return 0 if advice was given, non-zero if there are too few samples.
+ */
+int lora_node_adr_advice(uint8_t *dr, int8_t *txpower);
+#endif
+
 /**
  * Set the join callback. This will be called when joining succeeds or fails.
  *
@@ -143,6 +143,16 @@ struct lora_mac_obj
     int16_t lm_rssi_avg;
     int16_t lm_snr_avg;
 
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+    /* Link history ring, and the last downlink's RSSI/SNR */
+    struct lora_link_rec lm_link_hist[MYNEWT_VAL(LORA_NODE_LINK_HIST)];
+    uint8_t lm_link_idx;
+    uint8_t lm_link_cnt;
+    uint8_t lm_link_rx;
+    int8_t lm_link_snr;
+    int16_t lm_link_rssi;
+#endif
+
     /* TODO: this is temporary until we figure out a better way to deal */
     /* Transmit queue timer */
     struct os_callout lm_txq_timer;
@@ -162,6 +172,15 @@ struct lora_mac_obj
     /* Pointer to current transmit mbuf. Can be NULL and still txing */
     struct os_mbuf *cur_tx_mbuf;
 
+#if MYNEWT_VAL(LORA_NODE_TX_AGGREGATE)
+    /*
+     * Packets whose payload was appended to cur_tx_mbuf, and the length of
+     * cur_tx_mbuf's own payload.
+     */
+    STAILQ_HEAD(, os_mbuf_pkthdr) tx_aggr;
+    uint16_t tx_aggr_len;
+#endif
+
     /*!
      * Retransmission timer. This is used for confirmed frames on both class
      * A and C devices and for unconfirmed transmissions on class C devices
@@ -178,6 +197,12 @@ struct lora_mac_obj
     uint8_t *rxbuf;
     struct lora_pkt_info rxpkt;
 
+    /*
+     * Downlink mbuf the application payload was decrypted into, if one
+     * could be allocated. Handed to the app by lora_node_mac_mcps_indicate.
+     */
+    struct os_mbuf *rxom;
+
     /* Flags */
     union lora_mac_flags lmflags;
 
@@ -209,6 +234,7 @@ void lora_app_init(void);
 struct os_mbuf;
 void lora_app_mcps_indicate(struct os_mbuf *om);
 void lora_app_mcps_confirm(struct os_mbuf *om);
+void lora_node_mcps_confirm(struct os_mbuf *om);
 void lora_app_join_confirm(LoRaMacEventInfoStatus_t status, uint8_t attempts);
 void lora_app_link_chk_confirm(LoRaMacEventInfoStatus_t status, uint8_t num_gw,
                                uint8_t demod_margin);
@@ -224,6 +250,9 @@ bool lora_node_txq_empty(void);
 bool lora_mac_srv_ack_requested(void);
 uint8_t lora_mac_cmd_buffer_len(void);
 void lora_node_qual_sample(int16_t rssi, int16_t snr);
+void lora_node_link_record(struct lora_pkt_info *txi);
+void lora_mac_adr_steps(int steps, uint8_t *dr, int8_t *txpower);
+int lora_nmgr_init(void);
 
 /* Lora debug log */
 #define LORA_NODE_DEBUG_LOG
@@ -900,9 +900,9 @@ typedef struct sRxConfigParams
      */
     LoRaMacRxSlot_t RxSlot;
     /*!
-     * The symbol time, in msecs
+     * The symbol time, in usecs
      */
-    double tsymbol;
+    uint32_t tsymbol;
 }RxConfigParams_t;
 
 /*!
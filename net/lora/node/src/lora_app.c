@@ -39,13 +39,16 @@ struct lora_app_port
     uint8_t pad8;
     lora_rxd_func rxd_cb;
     lora_txd_func txd_cb;
+
+    /* Downlinks waiting for rxd_cb; at most LORA_APP_PORT_RX_Q_MAX */
+    struct os_mqueue rx_q;
+    uint8_t rx_q_len;
 };
 
 /* Port memory */
 static struct lora_app_port lora_app_ports[MYNEWT_VAL(LORA_APP_NUM_PORTS)];
 
-/* Lora APP Receive queue and event */
-struct os_mqueue lora_node_app_rx_q;
+/* Lora APP transmit done queue and event */
 struct os_mqueue lora_node_app_txd_q;
 
 /* Lora app event queue pointer */
@@ -73,7 +76,6 @@ struct lora_app_link_chk_ev_obj
 static struct lora_app_link_chk_ev_obj lora_app_link_chk_ev_data;
 
 /* Internal protos */
-static int lora_app_port_receive(struct os_mbuf *om);
 static int lora_app_port_txd(struct os_mbuf *om);
 
 /* Get the lora app event queue. */
@@ -111,22 +113,49 @@ lora_app_port_find_open(uint8_t port)
 }
 
 /**
- * Process received packet event. This event is processed by the task
- * that handles the lora app.
+ * Process a port's received packet event. This event is processed by the
+ * task that handles the lora app.
  *
- * @param ev Pointer to event.
+ * @param ev Pointer to event. The argument is the port.
  */
 static void
 lora_node_proc_app_rxd_event(struct os_event *ev)
 {
+    os_sr_t sr;
     struct os_mbuf *om;
+    struct lora_app_port *lap;
+    struct lora_pkt_info *lpkt;
 
-    /* Go through packet queue and call rx callback for all */
-    while ((om = os_mqueue_get(&lora_node_app_rx_q)) != NULL) {
-        lora_app_port_receive(om);
+    lap = ev->ev_arg;
+
+    /* Go through port packet queue and call rx callback for all */
+    while ((om = os_mqueue_get(&lap->rx_q)) != NULL) {
+        OS_ENTER_CRITICAL(sr);
+        --lap->rx_q_len;
+        OS_EXIT_CRITICAL(sr);
+
+        lpkt = LORA_PKT_INFO_PTR(om);
+        lap->rxd_cb(lpkt->port, lpkt->status, lpkt->pkt_type, om);
     }
 }
 
+/**
+ * Frees any downlinks still queued on a port.
+ *
+ * @param lap Pointer to port
+ */
+static void
+lora_app_port_rx_flush(struct lora_app_port *lap)
+{
+    struct os_mbuf *om;
+
+    os_eventq_remove(lora_node_app_evq_get(), &lap->rx_q.mq_ev);
+    while ((om = os_mqueue_get(&lap->rx_q)) != NULL) {
+        os_mbuf_free_chain(om);
+    }
+    lap->rx_q_len = 0;
+}
+
 /**
  * Process transmit done event. This event is processed by the task
  * that handles the lora app.
@@ -194,6 +223,9 @@ lora_app_port_open(uint8_t port, lora_txd_func txd_cb, lora_rxd_func rxd_cb)
         lora_app_ports[avail].rxd_cb = rxd_cb;
         lora_app_ports[avail].txd_cb = txd_cb;
         lora_app_ports[avail].retries = 8;
+        os_mqueue_init(&lora_app_ports[avail].rx_q,
+                       lora_node_proc_app_rxd_event, &lora_app_ports[avail]);
+        lora_app_ports[avail].rx_q_len = 0;
         lora_app_ports[avail].opened = 1;
         rc = LORA_APP_STATUS_OK;
     } else {
@@ -214,12 +246,16 @@ int
 lora_app_port_close(uint8_t port)
 {
     int rc;
+    os_sr_t sr;
     struct lora_app_port *lap;
 
     rc = LORA_APP_STATUS_NO_PORT;
     lap = lora_app_port_find_open(port);
     if (lap) {
+        OS_ENTER_CRITICAL(sr);
         lap->opened = 0;
+        OS_EXIT_CRITICAL(sr);
+        lora_app_port_rx_flush(lap);
         rc = LORA_APP_STATUS_OK;
     }
 
@@ -314,36 +350,6 @@ lora_app_mtu(void)
     return lora_node_mtu();
 }
 
-/**
- * Called by lora task when a packet has been received for an application port.
- *
- * NOTE: This API is not to be called by an application; it is called
- * by the task handling lora events.
- *
- * @param om Pointer to received packet
- *
- * @return int A return code from set of lora return codes
- */
-static int
-lora_app_port_receive(struct os_mbuf *om)
-{
-    int rc;
-    struct lora_app_port *lap;
-    struct lora_pkt_info *lpkt;
-
-    lpkt = LORA_PKT_INFO_PTR(om);
-    lap = lora_app_port_find_open(lpkt->port);
-    if (lap) {
-        lap->rxd_cb(lpkt->port, lpkt->status, lpkt->pkt_type, om);
-        rc = LORA_APP_STATUS_OK;
-    } else {
-        os_mbuf_free_chain(om);
-        rc = LORA_APP_STATUS_NO_PORT;
-    }
-
-    return rc;
-}
-
 /**
  * Called by lora task when a packet has been transmitted.
  *
@@ -376,7 +382,8 @@ lora_app_port_txd(struct os_mbuf *om)
 
 /**
  * Called from lower layer when a packet has been received for an application
- * port.
+ * port. The packet is queued on the port; packets for ports that are not
+ * open, or whose queue is full, are dropped.
  *
  * @param om Pointer to received packet
  */
@@ -384,9 +391,31 @@ void
 lora_app_mcps_indicate(struct os_mbuf *om)
 {
     int rc;
+    os_sr_t sr;
+    struct lora_app_port *lap;
+    struct lora_pkt_info *lpkt;
 
-    rc = os_mqueue_put(&lora_node_app_rx_q, lora_node_app_evq_get(), om);
-    assert(rc == 0);
+    lpkt = LORA_PKT_INFO_PTR(om);
+
+    /*
+     * The port table is changed by the app task. Enqueue atomically so a
+     * port being closed is either flushed of this packet or never sees it.
+     */
+    OS_ENTER_CRITICAL(sr);
+    lap = lora_app_port_find_open(lpkt->port);
+    if (lap && (lap->rx_q_len < MYNEWT_VAL(LORA_APP_PORT_RX_Q_MAX))) {
+        ++lap->rx_q_len;
+        rc = os_mqueue_put(&lap->rx_q, lora_node_app_evq_get(), om);
+        assert(rc == 0);
+    } else {
+        lap = NULL;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (lap == NULL) {
+        STATS_INC(lora_mac_stats, rx_port_drops);
+        os_mbuf_free_chain(om);
+    }
 }
 
 /**
@@ -540,9 +569,6 @@ lora_app_init(void)
     lora_app_link_chk_ev.ev_arg = &lora_app_link_chk_ev_data;
     lora_app_link_chk_ev.ev_cb = lora_app_link_chk_ev_cb;
 
-    /* Set up receive queue and event */
-    os_mqueue_init(&lora_node_app_rx_q, lora_node_proc_app_rxd_event, NULL);
-
     /* Set up transmit done queue and event */
     os_mqueue_init(&lora_node_app_txd_q, lora_node_proc_app_txd_event, NULL);
 }
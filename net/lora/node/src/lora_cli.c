@@ -576,6 +576,43 @@ static struct shell_cmd lora_node_log_cmd = {
 };
 #endif
 
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+static int lora_cli_link_cmd(int argc, char **argv);
+
+static struct shell_cmd lora_node_link_cmd = {
+    .sc_cmd = "ln_link",
+    .sc_cmd_func = lora_cli_link_cmd
+};
+
+static int
+lora_cli_link_cmd(int argc, char **argv)
+{
+    struct lora_link_rec llr;
+    uint8_t dr;
+    int8_t txpower;
+    int i;
+
+    console_printf("Lora link history (newest first)\n");
+    for (i = 0; lora_node_link_hist(i, &llr) == 0; i++) {
+        console_printf("time=%lu dr=%u pwr=%d retries=%u status=%u ack=%u "
+                       "airtime=%lu",
+                       (unsigned long)llr.llr_time, llr.llr_datarate,
+                       llr.llr_txpower, llr.llr_retries, llr.llr_status,
+                       llr.llr_ack, (unsigned long)llr.llr_airtime);
+        if (llr.llr_rx) {
+            console_printf(" rssi=%d snr=%d", llr.llr_rssi, llr.llr_snr);
+        }
+        console_printf("\n");
+    }
+    if (lora_node_adr_advice(&dr, &txpower) == 0) {
+        console_printf("adr advice: dr=%u txpower=%d\n", dr, txpower);
+    } else {
+        console_printf("adr advice: not enough samples\n");
+    }
+    return 0;
+}
+#endif
+
 int
 lora_cli_log_cmd(int argc, char **argv)
 {
@@ -705,5 +742,9 @@ lora_cli_init(void)
     int rc;
     rc = shell_cmd_register(&lora_node_log_cmd);
     assert(rc == 0);
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+    rc = shell_cmd_register(&lora_node_link_cmd);
+    assert(rc == 0);
+#endif
 }
 #endif /* MYNEWT_VAL(LORA_NODE_LOG_CLI) */
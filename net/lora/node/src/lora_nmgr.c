@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LORA_NODE_NEWTMGR)
+
+#include <tinycbor/cbor.h>
+#include "mgmt/mgmt.h"
+#include "node/lora_priv.h"
+
+static int lora_nmgr_link(struct mgmt_cbuf *cb);
+
+static struct mgmt_group lora_nmgr_group;
+
+#define LORA_NMGR_ID_LINK   (0)
+
+static struct mgmt_handler lora_nmgr_group_handlers[] = {
+    [LORA_NMGR_ID_LINK] = {lora_nmgr_link, NULL},
+};
+
+/*
+ * Link history, newest first, and the ADR advice based on it.
+ */
+static int
+lora_nmgr_link(struct mgmt_cbuf *cb)
+{
+    struct lora_link_rec llr;
+    CborError g_err = CborNoError;
+    CborEncoder recs;
+    CborEncoder rec;
+    uint8_t dr;
+    int8_t txpower;
+    int i;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "hist");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &recs,
+                                       CborIndefiniteLength);
+    for (i = 0; lora_node_link_hist(i, &llr) == 0; i++) {
+        g_err |= cbor_encoder_create_map(&recs, &rec, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&rec, "time");
+        g_err |= cbor_encode_uint(&rec, llr.llr_time);
+        g_err |= cbor_encode_text_stringz(&rec, "dr");
+        g_err |= cbor_encode_uint(&rec, llr.llr_datarate);
+        g_err |= cbor_encode_text_stringz(&rec, "pwr");
+        g_err |= cbor_encode_int(&rec, llr.llr_txpower);
+        g_err |= cbor_encode_text_stringz(&rec, "retries");
+        g_err |= cbor_encode_uint(&rec, llr.llr_retries);
+        g_err |= cbor_encode_text_stringz(&rec, "status");
+        g_err |= cbor_encode_uint(&rec, llr.llr_status);
+        g_err |= cbor_encode_text_stringz(&rec, "ack");
+        g_err |= cbor_encode_boolean(&rec, llr.llr_ack);
+        g_err |= cbor_encode_text_stringz(&rec, "airtime");
+        g_err |= cbor_encode_uint(&rec, llr.llr_airtime);
+        if (llr.llr_rx) {
+            g_err |= cbor_encode_text_stringz(&rec, "rssi");
+            g_err |= cbor_encode_int(&rec, llr.llr_rssi);
+            g_err |= cbor_encode_text_stringz(&rec, "snr");
+            g_err |= cbor_encode_int(&rec, llr.llr_snr);
+        }
+        g_err |= cbor_encoder_close_container(&recs, &rec);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &recs);
+
+    if (lora_node_adr_advice(&dr, &txpower) == 0) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "adr_dr");
+        g_err |= cbor_encode_uint(&cb->encoder, dr);
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "adr_pwr");
+        g_err |= cbor_encode_int(&cb->encoder, txpower);
+    }
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+int
+lora_nmgr_init(void)
+{
+    MGMT_GROUP_SET_HANDLERS(&lora_nmgr_group, lora_nmgr_group_handlers);
+    lora_nmgr_group.mg_group_id = MYNEWT_VAL(LORA_NODE_NEWTMGR_GROUP);
+
+    return mgmt_group_register(&lora_nmgr_group);
+}
+
+#endif
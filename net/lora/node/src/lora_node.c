@@ -44,6 +44,11 @@ STATS_NAME_START(lora_mac_stats)
     STATS_NAME(lora_mac_stats, rx_invalid)
     STATS_NAME(lora_mac_stats, no_bufs)
     STATS_NAME(lora_mac_stats, already_joined)
+    STATS_NAME(lora_mac_stats, tx_aggr_pkts)
+    STATS_NAME(lora_mac_stats, tx_airtime_ms)
+    STATS_NAME(lora_mac_stats, txq_pkts)
+    STATS_NAME(lora_mac_stats, txq_wait_ms)
+    STATS_NAME(lora_mac_stats, rx_port_drops)
 STATS_NAME_END(lora_mac_stats)
 
 /* Device EUI */
@@ -124,12 +129,49 @@ void
 lora_node_mcps_request(struct os_mbuf *om)
 {
     int rc;
+    struct lora_pkt_info *lpkt;
 
     lora_node_log(LORA_NODE_LOG_APP_TX, 0, OS_MBUF_PKTLEN(om), (uint32_t)om);
+    lpkt = LORA_PKT_INFO_PTR(om);
+    lpkt->txdinfo.queued_at = os_time_get();
     rc = os_mqueue_put(&g_lora_mac_data.lm_txq, &g_lora_mac_data.lm_evq, om);
     assert(rc == 0);
 }
 
+/**
+ * Hands a transmitted packet back to the application. Packets which were
+ * sent in the same frame are split off again and confirmed with the same
+ * status.
+ *
+ * @param om Pointer to transmitted packet
+ */
+void
+lora_node_mcps_confirm(struct os_mbuf *om)
+{
+#if MYNEWT_VAL(LORA_NODE_TX_AGGREGATE)
+    struct lora_pkt_info *lpkt;
+    struct lora_pkt_info *alpkt;
+    struct os_mbuf_pkthdr *mp;
+
+    lpkt = LORA_PKT_INFO_PTR(om);
+    if (!STAILQ_EMPTY(&g_lora_mac_data.tx_aggr)) {
+        os_mbuf_adj(om, g_lora_mac_data.tx_aggr_len - OS_MBUF_PKTLEN(om));
+    }
+    lora_app_mcps_confirm(om);
+
+    while ((mp = STAILQ_FIRST(&g_lora_mac_data.tx_aggr)) != NULL) {
+        STAILQ_REMOVE_HEAD(&g_lora_mac_data.tx_aggr, omp_next);
+        om = OS_MBUF_PKTHDR_TO_MBUF(mp);
+        alpkt = LORA_PKT_INFO_PTR(om);
+        alpkt->status = lpkt->status;
+        alpkt->txdinfo = lpkt->txdinfo;
+        lora_app_mcps_confirm(om);
+    }
+#else
+    lora_app_mcps_confirm(om);
+#endif
+}
+
 /**
  * What's the maximum payload which can be sent on next frame
  *
@@ -166,6 +208,71 @@ lora_node_chk_txq(void)
     os_eventq_put(&g_lora_mac_data.lm_evq, &g_lora_mac_data.lm_txq.mq_ev);
 }
 
+static void
+lora_node_txq_wait(struct os_mbuf *om)
+{
+    struct lora_pkt_info *lpkt;
+    uint32_t ms;
+
+    lpkt = LORA_PKT_INFO_PTR(om);
+    if (os_time_ticks_to_ms(os_time_get() - lpkt->txdinfo.queued_at, &ms)) {
+        ms = 0;
+    }
+    STATS_INC(lora_mac_stats, txq_pkts);
+    STATS_INCN(lora_mac_stats, txq_wait_ms, ms);
+}
+
+#if MYNEWT_VAL(LORA_NODE_TX_AGGREGATE)
+/**
+ * Appends the payloads of unconfirmed packets for the same port, queued
+ * right behind om, for as long as they fit in the frame. While the MAC is
+ * held back by the duty cycle, packets collect in the queue and go out
+ * together once it is free.
+ *
+ * @param om Pointer to packet about to be sent
+ */
+static void
+lora_node_tx_aggregate(struct os_mbuf *om)
+{
+    struct lora_pkt_info *lpkt;
+    struct lora_pkt_info *nlpkt;
+    struct os_mbuf_pkthdr *mp;
+    struct os_mbuf *n;
+    LoRaMacTxInfo_t txinfo;
+    uint16_t len;
+
+    lpkt = LORA_PKT_INFO_PTR(om);
+    len = OS_MBUF_PKTLEN(om);
+    g_lora_mac_data.tx_aggr_len = len;
+    if (lpkt->pkt_type != MCPS_UNCONFIRMED) {
+        return;
+    }
+
+    while ((mp = STAILQ_FIRST(&g_lora_mac_data.lm_txq.mq_head)) != NULL) {
+        n = OS_MBUF_PKTHDR_TO_MBUF(mp);
+        nlpkt = LORA_PKT_INFO_PTR(n);
+        if (nlpkt->port != lpkt->port ||
+            nlpkt->pkt_type != MCPS_UNCONFIRMED) {
+            break;
+        }
+        if (LoRaMacQueryTxPossible(len + mp->omp_len, &txinfo) !=
+            LORAMAC_STATUS_OK) {
+            break;
+        }
+        if (os_mbuf_appendfrom(om, n, 0, mp->omp_len)) {
+            os_mbuf_adj(om, len - OS_MBUF_PKTLEN(om));
+            break;
+        }
+        len += mp->omp_len;
+
+        n = os_mqueue_get(&g_lora_mac_data.lm_txq);
+        lora_node_txq_wait(n);
+        STAILQ_INSERT_TAIL(&g_lora_mac_data.tx_aggr, mp, omp_next);
+        STATS_INC(lora_mac_stats, tx_aggr_pkts);
+    }
+}
+#endif
+
 bool
 lora_node_txq_empty(void)
 {
@@ -194,25 +301,36 @@ lora_node_mac_mcps_indicate(void)
     struct os_mbuf *om;
     struct lora_pkt_info *lpkt;
 
+    /* Payload was decrypted into this mbuf if the MAC could allocate one */
+    om = g_lora_mac_data.rxom;
+    g_lora_mac_data.rxom = NULL;
+
     /*
      * Not sure if this is possible, but port 0 is not a valid application port.
      * If the port is 0 do not send indicate
      */
     if (g_lora_mac_data.rxpkt.port == 0) {
         /* XXX: count a statistic? */
+        if (om) {
+            os_mbuf_free_chain(om);
+        }
         return;
     }
 
-    om = lora_pkt_alloc();
-    if (om) {
-        /* Copy data into mbuf */
-        rc = os_mbuf_copyinto(om, 0, g_lora_mac_data.rxbuf,
-                              g_lora_mac_data.rxbufsize);
-        if (rc) {
-            os_mbuf_free_chain(om);
-            return;
+    if (om == NULL) {
+        om = lora_pkt_alloc();
+        if (om) {
+            /* Copy data into mbuf */
+            rc = os_mbuf_copyinto(om, 0, g_lora_mac_data.rxbuf,
+                                  g_lora_mac_data.rxbufsize);
+            if (rc) {
+                os_mbuf_free_chain(om);
+                return;
+            }
         }
+    }
 
+    if (om) {
         /* Set lora packet info */
         lpkt = LORA_PKT_INFO_PTR(om);
         memcpy(lpkt, &g_lora_mac_data.rxpkt, sizeof(struct lora_pkt_info));
@@ -309,6 +427,12 @@ send_from_txq:
             om = os_mqueue_get(&g_lora_mac_data.lm_txq);
             assert(om != NULL);
             lpkt = LORA_PKT_INFO_PTR(om);
+            lora_node_txq_wait(om);
+#if MYNEWT_VAL(LORA_NODE_TX_AGGREGATE)
+            if (rc == LORAMAC_STATUS_OK) {
+                lora_node_tx_aggregate(om);
+            }
+#endif
             g_lora_mac_data.curtx = lpkt;
             g_lora_node_last_tx_mac_cmd = 0;
         }
@@ -374,7 +498,7 @@ send_from_txq:
          */
 proc_txq_om_done:
         lpkt->status = evstatus;
-        lora_app_mcps_confirm(om);
+        lora_node_mcps_confirm(om);
     }
 }
 
@@ -585,8 +709,148 @@ lora_node_qual_sample(int16_t rssi, int16_t snr)
 {
     lora_node_calc_avg(&g_lora_mac_data.lm_rssi_avg, rssi);
     lora_node_calc_avg(&g_lora_mac_data.lm_snr_avg, snr);
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+    g_lora_mac_data.lm_link_rssi = rssi;
+    g_lora_mac_data.lm_link_snr = snr;
+    g_lora_mac_data.lm_link_rx = 1;
+#endif
 }
 
+/**
+ * Called by the MAC when an uplink has completed, to add it to the link
+ * history along with the downlink received in its receive windows, if any.
+ *
+ * @param txi Pointer to the uplink's packet information
+ */
+void
+lora_node_link_record(struct lora_pkt_info *txi)
+{
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+    struct lora_mac_obj *lmo = &g_lora_mac_data;
+    struct lora_link_rec *llr;
+
+    llr = &lmo->lm_link_hist[lmo->lm_link_idx];
+    memset(llr, 0, sizeof(*llr));
+    llr->llr_time = os_time_get();
+    llr->llr_airtime = txi->txdinfo.tx_time_on_air;
+    llr->llr_datarate = txi->txdinfo.datarate;
+    llr->llr_txpower = txi->txdinfo.txpower;
+    llr->llr_retries = txi->txdinfo.retries;
+    llr->llr_status = txi->status;
+    llr->llr_ack = txi->txdinfo.ack_rxd;
+    if (lmo->lm_link_rx) {
+        llr->llr_rx = 1;
+        llr->llr_rssi = lmo->lm_link_rssi;
+        llr->llr_snr = lmo->lm_link_snr;
+        lmo->lm_link_rx = 0;
+    }
+
+    if (++lmo->lm_link_idx == MYNEWT_VAL(LORA_NODE_LINK_HIST)) {
+        lmo->lm_link_idx = 0;
+    }
+    if (lmo->lm_link_cnt < MYNEWT_VAL(LORA_NODE_LINK_HIST)) {
+        lmo->lm_link_cnt++;
+    }
+#endif
+}
+
+#if MYNEWT_VAL(LORA_NODE_LINK_HIST) > 0
+int
+lora_node_link_hist(int idx, struct lora_link_rec *rec)
+{
+    struct lora_mac_obj *lmo = &g_lora_mac_data;
+    int i;
+
+    if (idx < 0 || idx >= lmo->lm_link_cnt) {
+        return -1;
+    }
+    i = lmo->lm_link_idx - 1 - idx;
+    if (i < 0) {
+        i += MYNEWT_VAL(LORA_NODE_LINK_HIST);
+    }
+    *rec = lmo->lm_link_hist[i];
+    return 0;
+}
+
+/*
+ * SNR, in 1/2 dB, needed to demodulate a given data rate. Data rates map to
+ * LoRa spreading factors by region; each step in spreading factor is worth
+ * 2.5 dB, SF7 needing -7.5 dB. Returns non-zero for non-LoRa data rates.
+ */
+static int
+lora_node_dr_snr_req(uint8_t dr, int *snr2)
+{
+    int sf;
+
+#if defined(REGION_AU915) || defined(REGION_US915) || \
+    defined(REGION_US915_HYBRID)
+    if (dr <= 3) {
+        sf = 10 - dr;
+    } else if (dr == 4) {
+        sf = 8;
+    } else {
+        return -1;
+    }
+#else
+    if (dr <= 5) {
+        sf = 12 - dr;
+    } else if (dr == 6) {
+        sf = 7;
+    } else {
+        return -1;
+    }
+#endif
+    *snr2 = -15 - 5 * (sf - 7);
+    return 0;
+}
+
+int
+lora_node_adr_advice(uint8_t *dr, int8_t *txpower)
+{
+    struct lora_link_rec llr;
+    MibRequestConfirm_t mib;
+    int samples;
+    int snr_max;
+    int margin;
+    int req;
+    int i;
+
+    mib.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm(&mib);
+    if (lora_node_dr_snr_req(mib.Param.ChannelsDatarate, &req)) {
+        return -1;
+    }
+
+    /* Best SNR of the most recent uplinks at the current data rate. */
+    samples = 0;
+    snr_max = INT8_MIN;
+    for (i = 0; lora_node_link_hist(i, &llr) == 0; i++) {
+        if (llr.llr_datarate != mib.Param.ChannelsDatarate) {
+            break;
+        }
+        if (llr.llr_rx) {
+            samples++;
+            if (llr.llr_snr > snr_max) {
+                snr_max = llr.llr_snr;
+            }
+        }
+    }
+    if (samples < MYNEWT_VAL(LORA_NODE_ADR_MIN_SAMPLES)) {
+        return -1;
+    }
+
+    /* One step per 3 dB of margin, rounding towards fewer steps. */
+    margin = 2 * snr_max - req - 2 * MYNEWT_VAL(LORA_NODE_ADR_MARGIN);
+    if (margin >= 0) {
+        i = margin / 6;
+    } else {
+        i = -((-margin + 5) / 6);
+    }
+    lora_mac_adr_steps(i, dr, txpower);
+    return 0;
+}
+#endif
+
 /**
  * Report tracked RSSI/SNR averages
  *
@@ -644,6 +908,10 @@ lora_node_init(void)
 #if MYNEWT_VAL(LORA_NODE_LOG_CLI) == 1
     lora_cli_init();
 #endif
+#if MYNEWT_VAL(LORA_NODE_NEWTMGR)
+    rc = lora_nmgr_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
 
     /*--- MAC INIT ---*/
     /* Initialize eventq */
@@ -651,6 +919,9 @@ lora_node_init(void)
 
     /* Set up transmit done queue and event */
     os_mqueue_init(&g_lora_mac_data.lm_txq, lora_mac_proc_tx_q_event, NULL);
+#if MYNEWT_VAL(LORA_NODE_TX_AGGREGATE)
+    STAILQ_INIT(&g_lora_mac_data.tx_aggr);
+#endif
 
     /* Create the mac task */
     os_task_init(&g_lora_mac_task, "loramac", lora_mac_task, NULL,
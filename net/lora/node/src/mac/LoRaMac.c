@@ -212,6 +212,9 @@ static struct hal_timer RxWindowTimer2;
 static RxConfigParams_t RxWindow1Config;
 static RxConfigParams_t RxWindow2Config;
 
+/* LORA_MAC_TIMER_NUM ticks at which the radio reported tx done */
+static uint32_t RadioTxDoneTime;
+
 /* Lengths of MAC commands */
 static const uint8_t
 g_lora_mac_cmd_lens[LORA_MAC_MAX_MAC_CMD_CID + 1] = {0, 0, 1, 2, 1, 2, 3, 2, 1};
@@ -228,6 +231,29 @@ struct os_event g_lora_mac_rx_win2_event;
 struct os_event g_lora_mac_tx_delay_timeout_event;
 
 static void lora_mac_rx_on_window2(void);
+
+/*
+ * Allocates the mbuf a downlink application payload is decrypted into.
+ * Returns NULL if the packet pool cannot hold len bytes in one buffer.
+ */
+static struct os_mbuf *
+lora_mac_rx_mbuf(uint16_t len)
+{
+    struct os_mbuf *om;
+
+    om = lora_pkt_alloc();
+    if (om == NULL) {
+        return NULL;
+    }
+    if (OS_MBUF_TRAILINGSPACE(om) < len) {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+    om->om_len = len;
+    OS_MBUF_PKTHDR(om)->omp_len = len;
+
+    return om;
+}
 static uint8_t lora_mac_extract_mac_cmds(uint8_t max_cmd_bytes, uint8_t *buf);
 
 static void
@@ -278,6 +304,7 @@ lora_mac_rx_win2_stop(void)
 static void
 OnRadioTxDone(void)
 {
+    RadioTxDoneTime = Radio.GetIrqTime();
     os_eventq_put(lora_node_mac_evq_get(), &g_lora_mac_radio_tx_event);
 }
 
@@ -286,7 +313,7 @@ OnRadioTxDone(void)
  *
  * Posts received packet event to MAC task for processing.
  *
- * Context: ISR
+ * Context: ISR, or MAC task if the radio driver defers interrupt work
  *
  */
 static void
@@ -309,7 +336,7 @@ OnRadioRxDone(uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr)
 /**
  * Radio transmit timeout event
  *
- * Context: ISR
+ * Context: ISR, or MAC task if the radio driver defers interrupt work
  */
 static void
 OnRadioTxTimeout(void)
@@ -530,8 +557,9 @@ lora_mac_send_mcps_confirm(LoRaMacEventInfoStatus_t status)
     if (LM_F_IS_MCPS_REQ()) {
         assert(g_lora_mac_data.curtx != NULL);
         g_lora_mac_data.curtx->status = status;
+        lora_node_link_record(g_lora_mac_data.curtx);
         if (g_lora_mac_data.cur_tx_mbuf) {
-            lora_app_mcps_confirm(g_lora_mac_data.cur_tx_mbuf);
+            lora_node_mcps_confirm(g_lora_mac_data.cur_tx_mbuf);
         }
         LM_F_IS_MCPS_REQ() = 0;
     }
@@ -803,8 +831,8 @@ lora_mac_process_radio_tx(struct os_event *ev)
     PhyParam_t phyParam;
     SetBandTxDoneParams_t txDone;
 
-    /* XXX: We need to time this more accurately */
-    uint32_t curTime = hal_timer_read(LORA_MAC_TIMER_NUM);
+    /* Receive windows are relative to the tx done interrupt */
+    uint32_t curTime = RadioTxDoneTime;
 
     if (LoRaMacDeviceClass != CLASS_C) {
         Radio.Sleep( );
@@ -850,8 +878,8 @@ lora_mac_process_radio_tx(struct os_event *ev)
             if (LM_F_LAST_TX_IS_JOIN_REQ()) {
                 timeout += (2000 * 1000);
             } else {
-                timeout += (uint32_t)((RxWindow2Config.tsymbol * 1000) *
-                    RxWindow2Config.WindowTimeout);
+                timeout += RxWindow2Config.tsymbol *
+                    RxWindow2Config.WindowTimeout;
             }
             hal_timer_start_at(&g_lora_mac_data.rtx_timer, curTime + timeout);
         }
@@ -896,6 +924,7 @@ lora_mac_process_radio_rx(struct os_event *ev)
     GetPhyParams_t getPhy;
     PhyParam_t phyParam;
     uint8_t *payload;
+    uint8_t *rxbuf;
     uint16_t size;
     int8_t snr;
     uint8_t hdrlen;
@@ -1176,16 +1205,29 @@ lora_mac_process_radio_rx(struct os_event *ev)
                                            snr);
                     }
 
+                    /*
+                     * Decrypt straight into the mbuf handed to the app.
+                     * LoRaMacRxPayload is only used if there is no mbuf
+                     * large enough.
+                     */
+                    rxbuf = LoRaMacRxPayload;
+                    if (skipIndication == false) {
+                        g_lora_mac_data.rxom = lora_mac_rx_mbuf(frameLen);
+                        if (g_lora_mac_data.rxom) {
+                            rxbuf = g_lora_mac_data.rxom->om_data;
+                        }
+                    }
+
                     LoRaMacPayloadDecrypt( payload + appPayloadStartIndex,
                                            frameLen,
                                            appSKey,
                                            address,
                                            DOWN_LINK,
                                            downLinkCounter,
-                                           LoRaMacRxPayload );
+                                           rxbuf );
 
                     if (skipIndication == false ) {
-                        g_lora_mac_data.rxbuf = LoRaMacRxPayload;
+                        g_lora_mac_data.rxbuf = rxbuf;
                         g_lora_mac_data.rxbufsize = frameLen;
                         rxi->rxdinfo.rxdata = true;
                         send_indicate = true;
@@ -2362,6 +2404,7 @@ SendFrameOnChannel(uint8_t channel)
     txi->txdinfo.txpower = txPower;
     txi->txdinfo.uplink_chan = channel;
     txi->txdinfo.tx_time_on_air = g_lora_mac_data.tx_time_on_air;
+    STATS_INCN(lora_mac_stats, tx_airtime_ms, g_lora_mac_data.tx_time_on_air);
 
     // Send now
     Radio.Send(LoRaMacBuffer, LoRaMacBufferPktLen);
@@ -2522,6 +2565,7 @@ LoRaMacInitialization(LoRaMacCallback_t *callbacks, LoRaMacRegion_t region)
     RadioEvents.RxError = OnRadioRxError;
     RadioEvents.TxTimeout = OnRadioTxTimeout;
     RadioEvents.RxTimeout = OnRadioRxTimeout;
+    Radio.SetEventq( lora_node_mac_evq_get() );
     Radio.Init( &RadioEvents );
 
     // Random seed initialization
@@ -3289,3 +3333,46 @@ lora_mac_extract_mac_cmds(uint8_t max_cmd_bytes, uint8_t *buf)
 
     return bytes_added;
 }
+
+/**
+ * Moves the current data rate and TX power by a number of ADR steps, as
+ * the network server would: a positive step raises the data rate until the
+ * maximum, then lowers TX power by one index. A negative step raises TX
+ * power back up to the maximum.
+ *
+ * @param steps Number of steps; see lora_node_adr_advice().
+ * @param dr Where to store the data rate.
+ * @param txpower Where to store the TX power index.
+ */
+void
+lora_mac_adr_steps(int steps, uint8_t *dr, int8_t *txpower)
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    VerifyParams_t verify;
+    uint8_t max_dr;
+
+    getPhy.Attribute = PHY_MAX_TX_DR;
+    getPhy.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
+    phyParam = RegionGetPhyParam(LoRaMacRegion, &getPhy);
+    max_dr = phyParam.Value;
+
+    *dr = LoRaMacParams.ChannelsDatarate;
+    *txpower = LoRaMacParams.ChannelsTxPower;
+    while (steps > 0) {
+        if (*dr < max_dr) {
+            (*dr)++;
+        } else {
+            verify.TxPower = *txpower + 1;
+            if (RegionVerify(LoRaMacRegion, &verify, PHY_TX_POWER) != true) {
+                break;
+            }
+            (*txpower)++;
+        }
+        steps--;
+    }
+    while (steps < 0 && *txpower > 0) {
+        (*txpower)--;
+        steps++;
+    }
+}
@@ -20,6 +20,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jä
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "os/mynewt.h"
 #include "node/utilities.h"
 
 #include "aes.h"
@@ -27,6 +28,10 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jä
 
 #include "node/mac/LoRaMacCrypto.h"
 
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+#include "crypto/crypto.h"
+#endif
+
 /*!
  * CMAC/AES Message Integrity Code (MIC) Block B0 size
  */
@@ -66,6 +71,50 @@ static aes_context AesContext;
  */
 static AES_CMAC_CTX AesCmacCtx[1];
 
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+/*!
+ * Hardware AES engine and the key for LoRaMacAesBlock()
+ */
+static struct crypto_dev *LoRaMacCryptoDev;
+static uint8_t AesKey[16];
+
+void LoRaMacAesEncrypt( const uint8_t *key, const uint8_t *in, uint8_t *out )
+{
+    if( LoRaMacCryptoDev == NULL )
+    {
+        LoRaMacCryptoDev = ( struct crypto_dev * )os_dev_open( MYNEWT_VAL( LORA_NODE_CRYPTO_DEV ), 0, NULL );
+        assert( LoRaMacCryptoDev != NULL );
+    }
+    if( crypto_aes_ecb_encrypt( LoRaMacCryptoDev, key, in, out ) != 0 )
+    {
+        // Engine is busy (e.g. preempted by the radio stack); do this
+        // block in software
+        memset( AesContext.ksch, '\0', 240 );
+        aes_set_key( key, 16, &AesContext );
+        aes_encrypt( in, out, &AesContext );
+    }
+}
+#endif
+
+static void LoRaMacAesSetKey( const uint8_t *key )
+{
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+    memcpy( AesKey, key, sizeof( AesKey ) );
+#else
+    memset( AesContext.ksch, '\0', 240 );
+    aes_set_key( key, 16, &AesContext );
+#endif
+}
+
+static void LoRaMacAesBlock( const uint8_t *in, uint8_t *out )
+{
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+    LoRaMacAesEncrypt( AesKey, in, out );
+#else
+    aes_encrypt( in, out, &AesContext );
+#endif
+}
+
 /*!
  * \brief Computes the LoRaMAC frame MIC field
  *
@@ -112,8 +161,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     uint8_t bufferIndex = 0;
     uint16_t ctr = 1;
 
-    memset( AesContext.ksch, '\0', 240 );
-    aes_set_key( key, 16, &AesContext );
+    LoRaMacAesSetKey( key );
 
     aBlock[5] = dir;
 
@@ -131,7 +179,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
         ctr++;
-        aes_encrypt( aBlock, sBlock, &AesContext );
+        LoRaMacAesBlock( aBlock, sBlock );
         for( i = 0; i < 16; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
@@ -143,7 +191,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     if( size > 0 )
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
-        aes_encrypt( aBlock, sBlock, &AesContext );
+        LoRaMacAesBlock( aBlock, sBlock );
         for( i = 0; i < size; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
@@ -171,13 +219,12 @@ void LoRaMacJoinComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t
 
 void LoRaMacJoinDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint8_t *decBuffer )
 {
-    memset( AesContext.ksch, '\0', 240 );
-    aes_set_key( key, 16, &AesContext );
-    aes_encrypt( buffer, decBuffer, &AesContext );
+    LoRaMacAesSetKey( key );
+    LoRaMacAesBlock( buffer, decBuffer );
     // Check if optional CFList is included
     if( size >= 16 )
     {
-        aes_encrypt( buffer + 16, decBuffer + 16, &AesContext );
+        LoRaMacAesBlock( buffer + 16, decBuffer + 16 );
     }
 }
 
@@ -186,18 +233,17 @@ void LoRaMacJoinComputeSKeys( const uint8_t *key, const uint8_t *appNonce, uint1
     uint8_t nonce[16];
     uint8_t *pDevNonce = ( uint8_t * )&devNonce;
 
-    memset( AesContext.ksch, '\0', 240 );
-    aes_set_key( key, 16, &AesContext );
+    LoRaMacAesSetKey( key );
 
     memset( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x01;
     memcpy( nonce + 1, appNonce, 6 );
     memcpy( nonce + 7, pDevNonce, 2 );
-    aes_encrypt( nonce, nwkSKey, &AesContext );
+    LoRaMacAesBlock( nonce, nwkSKey );
 
     memset( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x02;
     memcpy( nonce + 1, appNonce, 6 );
     memcpy( nonce + 7, pDevNonce, 2 );
-    aes_encrypt( nonce, appSKey, &AesContext );
+    LoRaMacAesBlock( nonce, appSKey );
 }
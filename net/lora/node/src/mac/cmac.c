@@ -55,18 +55,32 @@ DEALINGS WITH THE SOFTWARE
         }                          \
     } while (0) \
 
+static void AES_CMAC_Encrypt(AES_CMAC_CTX *ctx, const uint8_t *in, uint8_t *out)
+{
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+    LoRaMacAesEncrypt(ctx->key, in, out);
+#else
+    aes_encrypt(in, out, &ctx->rijndael);
+#endif
+}
 
 void AES_CMAC_Init(AES_CMAC_CTX *ctx)
 {
     memset(ctx->X, 0, sizeof ctx->X);
     ctx->M_n = 0;
+#if !MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
     memset(ctx->rijndael.ksch, '\0', 240);
+#endif
 }
 
 void AES_CMAC_SetKey(AES_CMAC_CTX *ctx, const uint8_t key[AES_CMAC_KEY_LENGTH])
 {
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+    memcpy(ctx->key, key, AES_CMAC_KEY_LENGTH);
+#else
            //rijndael_set_key_enc_only(&ctx->rijndael, key, 128);
        aes_set_key( key, AES_CMAC_KEY_LENGTH, &ctx->rijndael);
+#endif
 }
 
 void AES_CMAC_Update(AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len)
@@ -82,7 +96,7 @@ void AES_CMAC_Update(AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len)
                             return;
                    XOR(ctx->M_last, ctx->X);
                     //rijndael_encrypt(&ctx->rijndael, ctx->X, ctx->X);
-            aes_encrypt( ctx->X, ctx->X, &ctx->rijndael);
+            AES_CMAC_Encrypt(ctx, ctx->X, ctx->X);
                     data += mlen;
                     len -= mlen;
             }
@@ -92,7 +106,7 @@ void AES_CMAC_Update(AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len)
                     //rijndael_encrypt(&ctx->rijndael, ctx->X, ctx->X);
 
                     memcpy(in, &ctx->X[0], 16); //Bestela ez du ondo iten
-            aes_encrypt( in, in, &ctx->rijndael);
+            AES_CMAC_Encrypt(ctx, in, in);
                     memcpy(&ctx->X[0], in, 16);
 
                     data += 16;
@@ -113,7 +127,7 @@ void AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX *ctx)
 
             //rijndael_encrypt(&ctx->rijndael, K, K);
 
-            aes_encrypt( K, K, &ctx->rijndael);
+            AES_CMAC_Encrypt(ctx, K, K);
 
             if (K[0] & 0x80) {
                     LSHIFT(K, K);
@@ -148,7 +162,7 @@ void AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX *ctx)
            //rijndael_encrypt(&ctx->rijndael, ctx->X, digest);
 
        memcpy(in, &ctx->X[0], 16); //Bestela ez du ondo iten
-       aes_encrypt(in, digest, &ctx->rijndael);
+       AES_CMAC_Encrypt(ctx, in, digest);
            memset(K, 0, sizeof K);
 
 }
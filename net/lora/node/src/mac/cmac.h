@@ -37,12 +37,17 @@ DEALINGS WITH THE SOFTWARE
 #define _CMAC_H_
 
 #include "aes.h" 
+#include "syscfg/syscfg.h"
   
 #define AES_CMAC_KEY_LENGTH     16
 #define AES_CMAC_DIGEST_LENGTH  16
  
 typedef struct _AES_CMAC_CTX {
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+            uint8_t        key[AES_CMAC_KEY_LENGTH];
+#else
             aes_context    rijndael;
+#endif
             uint8_t        X[16];
             uint8_t        M_last[16];
             uint32_t       M_n;
@@ -59,5 +64,13 @@ void     AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX  *
             //     __attribute__((__bounded__(__minbytes__,1,AES_CMAC_DIGEST_LENGTH)));
 //__END_DECLS
 
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HW)
+/*
+ * Single block AES-128 encryption on the crypto device; implemented in
+ * LoRaMacCrypto.c.
+ */
+void     LoRaMacAesEncrypt(const uint8_t *key, const uint8_t *in, uint8_t *out);
+#endif
+
 #endif /* _CMAC_H_ */
 
@@ -291,17 +291,22 @@ uint8_t RegionCommonLinkAdrReqVerifyParams( RegionCommonLinkAdrReqVerifyParams_t
     return status;
 }
 
-double RegionCommonComputeSymbolTimeLoRa( uint8_t phyDr, uint32_t bandwidth )
+/*
+ * Symbol times are kept in integer usecs, so that scheduling a TX does not
+ * need floating point. They are exact for the 125, 250 and 500 kHz LoRa
+ * bandwidths and for FSK at 50 kbps.
+ */
+uint32_t RegionCommonComputeSymbolTimeLoRa( uint8_t phyDr, uint32_t bandwidth )
 {
-    return ( ( double )( 1 << phyDr ) / ( double )bandwidth ) * 1000;
+    return ( ( uint32_t )( 1 << phyDr ) * 1000 ) / ( bandwidth / 1000 );
 }
 
-double RegionCommonComputeSymbolTimeFsk( uint8_t phyDr )
+uint32_t RegionCommonComputeSymbolTimeFsk( uint8_t phyDr )
 {
-    return ( 8.0 / ( double )phyDr ); // 1 symbol equals 1 byte
+    return ( 8000 / ( uint32_t )phyDr ); // 1 symbol equals 1 byte
 }
 
-void RegionCommonComputeRxWindowParameters( double tSymbol, uint8_t minRxSymbols, uint32_t rxError, uint32_t wakeUpTime, uint32_t* windowTimeout, int32_t* windowOffset )
+void RegionCommonComputeRxWindowParameters( uint32_t tSymbol, uint8_t minRxSymbols, uint32_t rxError, uint32_t wakeUpTime, uint32_t* windowTimeout, int32_t* windowOffset )
 {
 /* XXX: I do not understand this */
 #if 0
@@ -309,11 +314,20 @@ void RegionCommonComputeRxWindowParameters( double tSymbol, uint8_t minRxSymbols
     *windowOffset = ( int32_t )ceil( ( 4.0 * tSymbol ) - ( ( *windowTimeout * tSymbol ) / 2.0 ) - wakeUpTime );
 #else
     uint16_t add_symbols;
+    int32_t num;
+    int32_t symbols;
 
-    *windowTimeout = MAX( ( uint32_t )ceil( ( ( 2 * minRxSymbols - 8 ) * tSymbol + 2 * rxError ) / tSymbol ), minRxSymbols ); // Computed number of symbols
+    // Computed number of symbols, rounded up
+    num = ( 2 * minRxSymbols - 8 ) * ( int32_t )tSymbol + 2 * ( int32_t )rxError * 1000;
+    symbols = num / ( int32_t )tSymbol;
+    if( ( num > 0 ) && ( num % ( int32_t )tSymbol ) )
+    {
+        symbols++;
+    }
+    *windowTimeout = MAX( symbols, minRxSymbols );
     add_symbols = 1;
-    if (wakeUpTime >= tSymbol) {
-        add_symbols += ((double)wakeUpTime / tSymbol);
+    if (wakeUpTime * 1000 >= tSymbol) {
+        add_symbols += (wakeUpTime * 1000) / tSymbol;
     }
     *windowTimeout += add_symbols;
     *windowOffset = -1 * wakeUpTime;
@@ -0,0 +1,198 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __MQTT_CLIENT_H_
+#define __MQTT_CLIENT_H_
+
+#include <inttypes.h>
+
+#include "os/mynewt.h"
+#include "mn_socket/mn_socket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous MQTT 3.1.1 client.
+ *
+ * The client runs off an event queue given at init time. Socket I/O,
+ * keepalive and acknowledgement processing all happen as events on that
+ * queue, and application is notified through the event callback. All
+ * mqtt_client_*() calls must be made from the task which processes the
+ * event queue.
+ *
+ * Packets are built directly into mbuf chains; payload of an outgoing
+ * publish is chained behind the header without copying.
+ *
+ * Up to MQTT_CLIENT_INFLIGHT_MAX QoS 1/2 publishes can be waiting for
+ * acknowledgement. mqtt_client_publish() returns SYS_EAGAIN when window
+ * is full; MQTT_CLIENT_EV_PUB_DONE tells when a slot frees up.
+ *
+ * If broker refuses the connection, MQTT_CLIENT_EV_CONNECTED is reported
+ * with the non-zero return code, followed by MQTT_CLIENT_EV_DISCONNECTED.
+ */
+
+#define MQTT_QOS0                       0
+#define MQTT_QOS1                       1
+#define MQTT_QOS2                       2
+
+/*
+ * Event types.
+ */
+#define MQTT_CLIENT_EV_CONNECTED        1   /* mce_status is CONNACK code */
+#define MQTT_CLIENT_EV_DISCONNECTED     2   /* mce_status is SYS_E* */
+#define MQTT_CLIENT_EV_PUBLISH          3   /* incoming publish */
+#define MQTT_CLIENT_EV_PUB_DONE         4   /* outgoing publish acked */
+#define MQTT_CLIENT_EV_SUBACK           5   /* mce_status is return code */
+#define MQTT_CLIENT_EV_UNSUBACK         6
+
+struct mqtt_client_event {
+    uint8_t mce_type;
+    int mce_status;
+    uint16_t mce_pkt_id;
+    union {
+        struct {
+            uint8_t session_present;
+        } connected;
+        /*
+         * Payload is in om, starting at off. It is only valid for the
+         * duration of the callback.
+         */
+        struct {
+            const char *topic;
+            struct os_mbuf *om;
+            uint16_t off;
+            uint16_t len;
+            uint8_t qos;
+            uint8_t retain:1;
+            uint8_t dup:1;
+        } publish;
+    } mce_u;
+};
+
+struct mqtt_client;
+typedef void mqtt_client_event_fn(struct mqtt_client *,
+                                  const struct mqtt_client_event *, void *arg);
+
+struct mqtt_client_cfg {
+    const char *client_id;
+    const char *username;               /* optional */
+    const char *password;               /* optional */
+    const char *will_topic;             /* optional */
+    const char *will_msg;
+    uint8_t will_qos;
+    uint8_t will_retain:1;
+    uint8_t clean_session:1;
+    uint16_t keepalive;                 /* seconds, 0 disables */
+    mqtt_client_event_fn *cb;
+    void *cb_arg;
+};
+
+struct mqtt_client_inflight {
+    uint16_t mci_id;
+    uint8_t mci_state;
+    struct os_mbuf *mci_om;             /* kept for resend on reconnect */
+};
+
+struct mqtt_client {
+    const struct mqtt_client_cfg *mc_cfg;
+    struct os_eventq *mc_evq;
+    struct mn_socket *mc_sock;
+    struct mn_poll mc_poll;
+    struct os_callout mc_timer;
+    uint8_t mc_state;
+    uint8_t mc_ping_outstanding:1;
+    uint16_t mc_next_id;
+    os_time_t mc_last_tx;
+    struct os_mbuf *mc_rx;
+    STAILQ_HEAD(, os_mbuf_pkthdr) mc_txq;
+    struct mqtt_client_inflight
+        mc_inflight[MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX)];
+    uint16_t mc_rx_qos2[MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX)];
+    char mc_topic[MYNEWT_VAL(MQTT_CLIENT_TOPIC_MAX) + 1];
+};
+
+/**
+ * Initializes client state.
+ *
+ * @param mc                    Client to initialize.
+ * @param cfg                   Connection parameters. Must stay valid for as
+ *                                  long as the client is used.
+ * @param evq                   Event queue to run the client from.
+ */
+void mqtt_client_init(struct mqtt_client *mc,
+                      const struct mqtt_client_cfg *cfg,
+                      struct os_eventq *evq);
+
+/**
+ * Starts connecting to broker. Result is reported with
+ * MQTT_CLIENT_EV_CONNECTED or MQTT_CLIENT_EV_DISCONNECTED.
+ *
+ * If session was not clean, unacknowledged publishes from previous
+ * connection are resent once broker accepts the connection.
+ *
+ * @return                      0 on success, SYS_EALREADY if not
+ *                                  disconnected, SYS_E* on other errors.
+ */
+int mqtt_client_connect(struct mqtt_client *mc, struct mn_sockaddr *broker);
+
+/**
+ * Sends DISCONNECT and closes the connection once it has been written.
+ * MQTT_CLIENT_EV_DISCONNECTED is reported with status 0.
+ */
+int mqtt_client_disconnect(struct mqtt_client *mc);
+
+/**
+ * Queues a publish.
+ *
+ * @param topic                 Topic name.
+ * @param payload               Payload, can be NULL. Consumed on success.
+ * @param qos                   MQTT_QOS0, MQTT_QOS1 or MQTT_QOS2.
+ * @param retain                Set retain flag.
+ * @param pkt_id                Filled with packet ID for QoS 1/2, reported
+ *                                  back with MQTT_CLIENT_EV_PUB_DONE. Can be
+ *                                  NULL.
+ *
+ * @return                      0 on success, SYS_EAGAIN if in-flight window
+ *                                  is full, SYS_E* on other errors.
+ */
+int mqtt_client_publish(struct mqtt_client *mc, const char *topic,
+                        struct os_mbuf *payload, uint8_t qos, uint8_t retain,
+                        uint16_t *pkt_id);
+
+/**
+ * Sends SUBSCRIBE for one topic filter. Result is reported with
+ * MQTT_CLIENT_EV_SUBACK.
+ */
+int mqtt_client_subscribe(struct mqtt_client *mc, const char *filter,
+                          uint8_t qos, uint16_t *pkt_id);
+
+/**
+ * Sends UNSUBSCRIBE for one topic filter. Result is reported with
+ * MQTT_CLIENT_EV_UNSUBACK.
+ */
+int mqtt_client_unsubscribe(struct mqtt_client *mc, const char *filter,
+                            uint16_t *pkt_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MQTT_CLIENT_H_ */
@@ -0,0 +1,981 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "mn_socket/mn_socket.h"
+#include "mqtt/mqtt_client.h"
+
+/*
+ * Control packet types, upper nibble of the first byte.
+ */
+#define MQTT_PKT_CONNECT                0x10
+#define MQTT_PKT_CONNACK                0x20
+#define MQTT_PKT_PUBLISH                0x30
+#define MQTT_PKT_PUBACK                 0x40
+#define MQTT_PKT_PUBREC                 0x50
+#define MQTT_PKT_PUBREL                 0x60
+#define MQTT_PKT_PUBCOMP                0x70
+#define MQTT_PKT_SUBSCRIBE              0x80
+#define MQTT_PKT_SUBACK                 0x90
+#define MQTT_PKT_UNSUBSCRIBE            0xa0
+#define MQTT_PKT_UNSUBACK               0xb0
+#define MQTT_PKT_PINGREQ                0xc0
+#define MQTT_PKT_PINGRESP               0xd0
+#define MQTT_PKT_DISCONNECT             0xe0
+
+#define MQTT_PKT_F_QOS1                 0x02 /* PUBREL, (UN)SUBSCRIBE */
+
+#define MQTT_PUB_DUP                    0x08
+#define MQTT_PUB_RETAIN                 0x01
+
+#define MQTT_CONN_USERNAME              0x80
+#define MQTT_CONN_PASSWORD              0x40
+#define MQTT_CONN_WILL_RETAIN           0x20
+#define MQTT_CONN_WILL                  0x04
+#define MQTT_CONN_CLEAN                 0x02
+
+#define MQTT_REM_LEN_MAX                268435455
+
+/*
+ * Client states.
+ */
+#define MQTT_ST_IDLE                    0
+#define MQTT_ST_TCP_CONNECT             1
+#define MQTT_ST_CONNACK_WAIT            2
+#define MQTT_ST_CONNECTED               3
+#define MQTT_ST_DISCONNECTING           4
+
+/*
+ * In-flight publish states.
+ */
+#define MQTT_IF_FREE                    0
+#define MQTT_IF_PUBACK                  1 /* QoS 1 PUBLISH sent */
+#define MQTT_IF_PUBREC                  2 /* QoS 2 PUBLISH sent */
+#define MQTT_IF_PUBCOMP                 3 /* PUBREL sent */
+
+static void mqtt_client_drop(struct mqtt_client *mc, int reason);
+
+static void
+mqtt_client_report(struct mqtt_client *mc, struct mqtt_client_event *ev)
+{
+    if (mc->mc_cfg->cb) {
+        mc->mc_cfg->cb(mc, ev, mc->mc_cfg->cb_arg);
+    }
+}
+
+static int
+mqtt_put_u8(struct os_mbuf *om, uint8_t val)
+{
+    return os_mbuf_append(om, &val, sizeof(val));
+}
+
+static int
+mqtt_put_u16(struct os_mbuf *om, uint16_t val)
+{
+    uint8_t buf[2];
+
+    buf[0] = val >> 8;
+    buf[1] = val;
+    return os_mbuf_append(om, buf, sizeof(buf));
+}
+
+static int
+mqtt_put_str(struct os_mbuf *om, const char *str)
+{
+    uint16_t len;
+    int rc;
+
+    len = strlen(str);
+    rc = mqtt_put_u16(om, len);
+    if (rc) {
+        return rc;
+    }
+    return os_mbuf_append(om, str, len);
+}
+
+static uint32_t
+mqtt_str_len(const char *str)
+{
+    return sizeof(uint16_t) + strlen(str);
+}
+
+static uint16_t
+mqtt_get_u16(struct os_mbuf *om, int off)
+{
+    uint8_t buf[2];
+
+    os_mbuf_copydata(om, off, sizeof(buf), buf);
+    return (buf[0] << 8) | buf[1];
+}
+
+/*
+ * Allocates a packet, and fills in the fixed header. hdr_len is
+ * a hint of how much data is going to be appended to the first buffer.
+ */
+static struct os_mbuf *
+mqtt_pkt_alloc(uint8_t type, uint32_t rem_len, uint16_t hdr_len)
+{
+    struct os_mbuf *om;
+    uint8_t buf[5];
+    int i;
+
+    if (rem_len > MQTT_REM_LEN_MAX) {
+        return NULL;
+    }
+    om = os_msys_get_pkthdr(sizeof(buf) + hdr_len, 0);
+    if (!om) {
+        return NULL;
+    }
+    i = 0;
+    buf[i++] = type;
+    do {
+        buf[i] = rem_len & 0x7f;
+        rem_len >>= 7;
+        if (rem_len) {
+            buf[i] |= 0x80;
+        }
+        i++;
+    } while (rem_len);
+
+    if (os_mbuf_append(om, buf, i)) {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+    return om;
+}
+
+/*
+ * Copy of an outgoing publish, kept until it has been acknowledged.
+ */
+static struct os_mbuf *
+mqtt_client_copy(struct os_mbuf *om)
+{
+#if MYNEWT_VAL(OS_MBUF_SHARED)
+    return os_mbuf_share(om, om->om_omp);
+#else
+    return os_mbuf_dup(om);
+#endif
+}
+
+static struct mqtt_client_inflight *
+mqtt_client_inflight_find(struct mqtt_client *mc, uint16_t id)
+{
+    struct mqtt_client_inflight *mci;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+        mci = &mc->mc_inflight[i];
+        if (mci->mci_state != MQTT_IF_FREE && mci->mci_id == id) {
+            return mci;
+        }
+    }
+    return NULL;
+}
+
+static struct mqtt_client_inflight *
+mqtt_client_inflight_free(struct mqtt_client *mc)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+        if (mc->mc_inflight[i].mci_state == MQTT_IF_FREE) {
+            return &mc->mc_inflight[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+mqtt_client_inflight_done(struct mqtt_client *mc,
+                          struct mqtt_client_inflight *mci, int status)
+{
+    struct mqtt_client_event ev;
+
+    if (mci->mci_om) {
+        os_mbuf_free_chain(mci->mci_om);
+        mci->mci_om = NULL;
+    }
+    mci->mci_state = MQTT_IF_FREE;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.mce_type = MQTT_CLIENT_EV_PUB_DONE;
+    ev.mce_status = status;
+    ev.mce_pkt_id = mci->mci_id;
+    mqtt_client_report(mc, &ev);
+}
+
+static uint16_t
+mqtt_client_next_id(struct mqtt_client *mc)
+{
+    do {
+        if (++mc->mc_next_id == 0) {
+            mc->mc_next_id = 1;
+        }
+    } while (mqtt_client_inflight_find(mc, mc->mc_next_id));
+
+    return mc->mc_next_id;
+}
+
+/*
+ * Writes out everything queued as one chain. If socket is busy, retried
+ * when it reports being writable again.
+ */
+static void
+mqtt_client_tx_flush(struct mqtt_client *mc)
+{
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    int rc;
+
+    if (mc->mc_state < MQTT_ST_CONNACK_WAIT) {
+        return;
+    }
+    omp = STAILQ_FIRST(&mc->mc_txq);
+    if (!omp) {
+        if (mc->mc_state == MQTT_ST_DISCONNECTING) {
+            /*
+             * DISCONNECT has been written out.
+             */
+            mqtt_client_drop(mc, 0);
+        }
+        return;
+    }
+    STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+    om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+    while ((omp = STAILQ_FIRST(&mc->mc_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+        os_mbuf_concat(om, OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+
+    rc = mn_sendto(mc->mc_sock, om, NULL);
+    if (rc == MN_EAGAIN) {
+        STAILQ_INSERT_HEAD(&mc->mc_txq, OS_MBUF_PKTHDR(om), omp_next);
+    } else if (rc) {
+        /*
+         * Stream socket holds on to data even on error, it gets freed
+         * with the socket.
+         */
+        mqtt_client_drop(mc, SYS_EIO);
+    }
+}
+
+static void
+mqtt_client_tx(struct mqtt_client *mc, struct os_mbuf *om)
+{
+    if (mc->mc_state == MQTT_ST_DISCONNECTING) {
+        os_mbuf_free_chain(om);
+        return;
+    }
+    STAILQ_INSERT_TAIL(&mc->mc_txq, OS_MBUF_PKTHDR(om), omp_next);
+    mc->mc_last_tx = os_time_get();
+    mqtt_client_tx_flush(mc);
+}
+
+static int
+mqtt_client_send_simple(struct mqtt_client *mc, uint8_t type)
+{
+    struct os_mbuf *om;
+
+    om = mqtt_pkt_alloc(type, 0, 0);
+    if (!om) {
+        return SYS_ENOMEM;
+    }
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+static int
+mqtt_client_send_ack(struct mqtt_client *mc, uint8_t type, uint16_t id)
+{
+    struct os_mbuf *om;
+
+    om = mqtt_pkt_alloc(type, sizeof(id), sizeof(id));
+    if (!om) {
+        return SYS_ENOMEM;
+    }
+    if (mqtt_put_u16(om, id)) {
+        os_mbuf_free_chain(om);
+        return SYS_ENOMEM;
+    }
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+static int
+mqtt_client_send_connect(struct mqtt_client *mc)
+{
+    const struct mqtt_client_cfg *cfg = mc->mc_cfg;
+    struct os_mbuf *om;
+    uint32_t rem_len;
+    uint8_t flags;
+
+    rem_len = 10 + mqtt_str_len(cfg->client_id);
+    flags = 0;
+    if (cfg->clean_session) {
+        flags |= MQTT_CONN_CLEAN;
+    }
+    if (cfg->will_topic) {
+        flags |= MQTT_CONN_WILL | (cfg->will_qos << 3);
+        if (cfg->will_retain) {
+            flags |= MQTT_CONN_WILL_RETAIN;
+        }
+        rem_len += mqtt_str_len(cfg->will_topic) +
+          mqtt_str_len(cfg->will_msg ? cfg->will_msg : "");
+    }
+    if (cfg->username) {
+        flags |= MQTT_CONN_USERNAME;
+        rem_len += mqtt_str_len(cfg->username);
+    }
+    if (cfg->password) {
+        flags |= MQTT_CONN_PASSWORD;
+        rem_len += mqtt_str_len(cfg->password);
+    }
+
+    om = mqtt_pkt_alloc(MQTT_PKT_CONNECT, rem_len, rem_len);
+    if (!om) {
+        return SYS_ENOMEM;
+    }
+    if (os_mbuf_append(om, "\0\4MQTT\4", 7) ||
+        mqtt_put_u8(om, flags) ||
+        mqtt_put_u16(om, cfg->keepalive) ||
+        mqtt_put_str(om, cfg->client_id)) {
+        goto err;
+    }
+    if (cfg->will_topic) {
+        if (mqtt_put_str(om, cfg->will_topic) ||
+            mqtt_put_str(om, cfg->will_msg ? cfg->will_msg : "")) {
+            goto err;
+        }
+    }
+    if (cfg->username && mqtt_put_str(om, cfg->username)) {
+        goto err;
+    }
+    if (cfg->password && mqtt_put_str(om, cfg->password)) {
+        goto err;
+    }
+    mc->mc_state = MQTT_ST_CONNACK_WAIT;
+    mqtt_client_tx(mc, om);
+    return 0;
+err:
+    os_mbuf_free_chain(om);
+    return SYS_ENOMEM;
+}
+
+/*
+ * Resends unacknowledged publishes from a previous connection.
+ */
+static void
+mqtt_client_resend(struct mqtt_client *mc)
+{
+    struct mqtt_client_inflight *mci;
+    struct os_mbuf *om;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+        mci = &mc->mc_inflight[i];
+        switch (mci->mci_state) {
+        case MQTT_IF_PUBACK:
+        case MQTT_IF_PUBREC:
+            mci->mci_om->om_data[0] |= MQTT_PUB_DUP;
+            om = mqtt_client_copy(mci->mci_om);
+            if (om) {
+                mqtt_client_tx(mc, om);
+            }
+            break;
+        case MQTT_IF_PUBCOMP:
+            mqtt_client_send_ack(mc, MQTT_PKT_PUBREL | MQTT_PKT_F_QOS1,
+                                 mci->mci_id);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void
+mqtt_client_drop(struct mqtt_client *mc, int reason)
+{
+    struct mqtt_client_event ev;
+    struct mqtt_client_inflight *mci;
+    struct os_mbuf_pkthdr *omp;
+    int i;
+
+    os_callout_stop(&mc->mc_timer);
+    if (mc->mc_sock) {
+        mn_close(mc->mc_sock);
+        mc->mc_sock = NULL;
+    }
+    while ((omp = STAILQ_FIRST(&mc->mc_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    if (mc->mc_rx) {
+        os_mbuf_free_chain(mc->mc_rx);
+        mc->mc_rx = NULL;
+    }
+    mc->mc_state = MQTT_ST_IDLE;
+    mc->mc_ping_outstanding = 0;
+
+    if (mc->mc_cfg->clean_session) {
+        memset(mc->mc_rx_qos2, 0, sizeof(mc->mc_rx_qos2));
+        for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+            mci = &mc->mc_inflight[i];
+            if (mci->mci_state != MQTT_IF_FREE) {
+                mqtt_client_inflight_done(mc, mci, SYS_EIO);
+            }
+        }
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.mce_type = MQTT_CLIENT_EV_DISCONNECTED;
+    ev.mce_status = reason;
+    mqtt_client_report(mc, &ev);
+}
+
+static int
+mqtt_client_rx_publish(struct mqtt_client *mc, uint8_t type, int off,
+                       uint32_t len)
+{
+    struct mqtt_client_event ev;
+    uint16_t topic_len;
+    uint16_t id;
+    uint8_t qos;
+    int deliver;
+    int hdr_len;
+    int i;
+
+    qos = (type >> 1) & 0x3;
+    if (qos > MQTT_QOS2 || len < sizeof(topic_len)) {
+        return SYS_EINVAL;
+    }
+    topic_len = mqtt_get_u16(mc->mc_rx, off);
+    hdr_len = sizeof(topic_len) + topic_len + (qos ? sizeof(id) : 0);
+    if (hdr_len > len) {
+        return SYS_EINVAL;
+    }
+    id = 0;
+    if (qos) {
+        id = mqtt_get_u16(mc->mc_rx, off + sizeof(topic_len) + topic_len);
+    }
+
+    deliver = (topic_len <= MYNEWT_VAL(MQTT_CLIENT_TOPIC_MAX));
+    if (qos == MQTT_QOS2) {
+        /*
+         * Deliver only once; broker resends until it gets PUBREC, and
+         * ID stays in use until PUBREL.
+         */
+        for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+            if (mc->mc_rx_qos2[i] == id) {
+                deliver = 0;
+                break;
+            }
+        }
+        if (i == MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX)) {
+            for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+                if (mc->mc_rx_qos2[i] == 0) {
+                    mc->mc_rx_qos2[i] = id;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (deliver) {
+        os_mbuf_copydata(mc->mc_rx, off + sizeof(topic_len), topic_len,
+                         mc->mc_topic);
+        mc->mc_topic[topic_len] = '\0';
+
+        memset(&ev, 0, sizeof(ev));
+        ev.mce_type = MQTT_CLIENT_EV_PUBLISH;
+        ev.mce_pkt_id = id;
+        ev.mce_u.publish.topic = mc->mc_topic;
+        ev.mce_u.publish.om = mc->mc_rx;
+        ev.mce_u.publish.off = off + hdr_len;
+        ev.mce_u.publish.len = len - hdr_len;
+        ev.mce_u.publish.qos = qos;
+        ev.mce_u.publish.retain = !!(type & MQTT_PUB_RETAIN);
+        ev.mce_u.publish.dup = !!(type & MQTT_PUB_DUP);
+        mqtt_client_report(mc, &ev);
+    }
+
+    if (qos == MQTT_QOS1) {
+        return mqtt_client_send_ack(mc, MQTT_PKT_PUBACK, id);
+    } else if (qos == MQTT_QOS2) {
+        return mqtt_client_send_ack(mc, MQTT_PKT_PUBREC, id);
+    }
+    return 0;
+}
+
+static int
+mqtt_client_rx_pkt(struct mqtt_client *mc, uint8_t type, int off,
+                   uint32_t len)
+{
+    struct mqtt_client_inflight *mci;
+    struct mqtt_client_event ev;
+    uint8_t buf[2];
+    uint16_t id;
+    int i;
+
+    memset(&ev, 0, sizeof(ev));
+
+    switch (type & 0xf0) {
+    case MQTT_PKT_CONNACK:
+        if (mc->mc_state != MQTT_ST_CONNACK_WAIT || len != 2) {
+            return SYS_EINVAL;
+        }
+        os_mbuf_copydata(mc->mc_rx, off, sizeof(buf), buf);
+        ev.mce_type = MQTT_CLIENT_EV_CONNECTED;
+        ev.mce_status = buf[1];
+        ev.mce_u.connected.session_present = buf[0] & 0x01;
+        if (buf[1]) {
+            mqtt_client_report(mc, &ev);
+            return SYS_EACCES;
+        }
+        mc->mc_state = MQTT_ST_CONNECTED;
+        os_callout_stop(&mc->mc_timer);
+        if (mc->mc_cfg->keepalive) {
+            os_callout_reset(&mc->mc_timer,
+                             mc->mc_cfg->keepalive * OS_TICKS_PER_SEC);
+        }
+        if (!mc->mc_cfg->clean_session) {
+            mqtt_client_resend(mc);
+        }
+        mqtt_client_report(mc, &ev);
+        return 0;
+    case MQTT_PKT_PUBLISH:
+        if (mc->mc_state != MQTT_ST_CONNECTED) {
+            return 0;
+        }
+        return mqtt_client_rx_publish(mc, type, off, len);
+    case MQTT_PKT_PUBACK:
+    case MQTT_PKT_PUBREC:
+    case MQTT_PKT_PUBCOMP:
+        if (len != 2) {
+            return SYS_EINVAL;
+        }
+        id = mqtt_get_u16(mc->mc_rx, off);
+        mci = mqtt_client_inflight_find(mc, id);
+        if ((type & 0xf0) == MQTT_PKT_PUBREC) {
+            if (mci && mci->mci_state == MQTT_IF_PUBREC) {
+                os_mbuf_free_chain(mci->mci_om);
+                mci->mci_om = NULL;
+                mci->mci_state = MQTT_IF_PUBCOMP;
+            }
+            return mqtt_client_send_ack(mc, MQTT_PKT_PUBREL | MQTT_PKT_F_QOS1,
+                                        id);
+        }
+        if (mci && (((type & 0xf0) == MQTT_PKT_PUBACK &&
+                     mci->mci_state == MQTT_IF_PUBACK) ||
+                    ((type & 0xf0) == MQTT_PKT_PUBCOMP &&
+                     mci->mci_state == MQTT_IF_PUBCOMP))) {
+            mqtt_client_inflight_done(mc, mci, 0);
+        }
+        return 0;
+    case MQTT_PKT_PUBREL:
+        if (len != 2) {
+            return SYS_EINVAL;
+        }
+        id = mqtt_get_u16(mc->mc_rx, off);
+        for (i = 0; i < MYNEWT_VAL(MQTT_CLIENT_INFLIGHT_MAX); i++) {
+            if (mc->mc_rx_qos2[i] == id) {
+                mc->mc_rx_qos2[i] = 0;
+            }
+        }
+        return mqtt_client_send_ack(mc, MQTT_PKT_PUBCOMP, id);
+    case MQTT_PKT_SUBACK:
+        if (len < 3) {
+            return SYS_EINVAL;
+        }
+        ev.mce_type = MQTT_CLIENT_EV_SUBACK;
+        ev.mce_pkt_id = mqtt_get_u16(mc->mc_rx, off);
+        os_mbuf_copydata(mc->mc_rx, off + 2, 1, buf);
+        ev.mce_status = buf[0];
+        mqtt_client_report(mc, &ev);
+        return 0;
+    case MQTT_PKT_UNSUBACK:
+        if (len != 2) {
+            return SYS_EINVAL;
+        }
+        ev.mce_type = MQTT_CLIENT_EV_UNSUBACK;
+        ev.mce_pkt_id = mqtt_get_u16(mc->mc_rx, off);
+        mqtt_client_report(mc, &ev);
+        return 0;
+    case MQTT_PKT_PINGRESP:
+        mc->mc_ping_outstanding = 0;
+        return 0;
+    default:
+        return SYS_EINVAL;
+    }
+}
+
+/*
+ * Processes all complete packets in receive buffer. Data is consumed from
+ * the chain only after processing, so publish payloads can be passed to
+ * application without copying.
+ */
+static void
+mqtt_client_rx_parse(struct mqtt_client *mc)
+{
+    uint8_t hdr[5];
+    uint32_t rem_len;
+    int hdr_len;
+    int avail;
+    int off;
+    int cnt;
+    int rc;
+    int i;
+
+    off = 0;
+    while (mc->mc_rx) {
+        avail = OS_MBUF_PKTLEN(mc->mc_rx) - off;
+        if (avail < 2) {
+            break;
+        }
+        cnt = min(avail, sizeof(hdr));
+        os_mbuf_copydata(mc->mc_rx, off, cnt, hdr);
+
+        rem_len = 0;
+        hdr_len = 0;
+        for (i = 1; i < cnt; i++) {
+            rem_len |= (uint32_t)(hdr[i] & 0x7f) << (7 * (i - 1));
+            if (!(hdr[i] & 0x80)) {
+                hdr_len = i + 1;
+                break;
+            }
+        }
+        if (!hdr_len) {
+            if (cnt == sizeof(hdr)) {
+                mqtt_client_drop(mc, SYS_EINVAL);
+                return;
+            }
+            break;
+        }
+        if (rem_len > MYNEWT_VAL(MQTT_CLIENT_RX_MAX)) {
+            mqtt_client_drop(mc, SYS_ERANGE);
+            return;
+        }
+        if (avail < hdr_len + rem_len) {
+            break;
+        }
+        rc = mqtt_client_rx_pkt(mc, hdr[0], off + hdr_len, rem_len);
+        if (rc) {
+            mqtt_client_drop(mc, rc);
+            return;
+        }
+        off += hdr_len + rem_len;
+    }
+    if (mc->mc_rx) {
+        os_mbuf_adj(mc->mc_rx, off);
+        if (OS_MBUF_PKTLEN(mc->mc_rx) == 0) {
+            os_mbuf_free_chain(mc->mc_rx);
+            mc->mc_rx = NULL;
+        } else {
+            mc->mc_rx = os_mbuf_trim_front(mc->mc_rx);
+        }
+    }
+}
+
+static void
+mqtt_client_rx(struct mqtt_client *mc)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    while (1) {
+        rc = mn_recvfrom(mc->mc_sock, &om, NULL);
+        if (rc == MN_EAGAIN) {
+            break;
+        }
+        if (rc) {
+            mqtt_client_drop(mc, SYS_EIO);
+            return;
+        }
+        assert(OS_MBUF_IS_PKTHDR(om));
+        if (mc->mc_rx) {
+            os_mbuf_concat(mc->mc_rx, om);
+        } else {
+            mc->mc_rx = om;
+        }
+    }
+    mqtt_client_rx_parse(mc);
+}
+
+static void
+mqtt_client_sock_event(struct os_event *ev)
+{
+    struct mqtt_client *mc = ev->ev_arg;
+    struct mn_poll_result res;
+
+    while (mn_poll_get(&mc->mc_poll, &res, 1) == 1) {
+        if (res.mpr_sock != mc->mc_sock) {
+            continue;
+        }
+        if (res.mpr_revents & MN_POLLERR) {
+            mqtt_client_drop(mc, SYS_EIO);
+            continue;
+        }
+        if (res.mpr_revents & MN_POLLOUT) {
+            if (mc->mc_state == MQTT_ST_TCP_CONNECT) {
+                if (mqtt_client_send_connect(mc)) {
+                    mqtt_client_drop(mc, SYS_ENOMEM);
+                    continue;
+                }
+            } else {
+                mqtt_client_tx_flush(mc);
+            }
+        }
+        if ((res.mpr_revents & MN_POLLIN) && mc->mc_sock) {
+            mqtt_client_rx(mc);
+        }
+    }
+}
+
+static void
+mqtt_client_timer_cb(struct os_event *ev)
+{
+    struct mqtt_client *mc = ev->ev_arg;
+    os_time_t ka;
+    os_time_t idle;
+
+    switch (mc->mc_state) {
+    case MQTT_ST_CONNECTED:
+        if (mc->mc_ping_outstanding) {
+            mqtt_client_drop(mc, SYS_ETIMEOUT);
+            return;
+        }
+        ka = mc->mc_cfg->keepalive * OS_TICKS_PER_SEC;
+        idle = os_time_get() - mc->mc_last_tx;
+        if (idle >= ka) {
+            if (mqtt_client_send_simple(mc, MQTT_PKT_PINGREQ)) {
+                mqtt_client_drop(mc, SYS_ENOMEM);
+                return;
+            }
+            mc->mc_ping_outstanding = 1;
+            os_callout_reset(&mc->mc_timer, ka);
+        } else {
+            os_callout_reset(&mc->mc_timer, ka - idle);
+        }
+        break;
+    case MQTT_ST_DISCONNECTING:
+        mqtt_client_drop(mc, 0);
+        break;
+    case MQTT_ST_IDLE:
+        break;
+    default:
+        mqtt_client_drop(mc, SYS_ETIMEOUT);
+        break;
+    }
+}
+
+void
+mqtt_client_init(struct mqtt_client *mc, const struct mqtt_client_cfg *cfg,
+                 struct os_eventq *evq)
+{
+    memset(mc, 0, sizeof(*mc));
+    mc->mc_cfg = cfg;
+    mc->mc_evq = evq;
+    STAILQ_INIT(&mc->mc_txq);
+    mn_poll_init(&mc->mc_poll, evq, mqtt_client_sock_event, mc);
+    os_callout_init(&mc->mc_timer, evq, mqtt_client_timer_cb, mc);
+}
+
+int
+mqtt_client_connect(struct mqtt_client *mc, struct mn_sockaddr *broker)
+{
+    int rc;
+
+    if (mc->mc_state != MQTT_ST_IDLE) {
+        return SYS_EALREADY;
+    }
+    rc = mn_socket(&mc->mc_sock, broker->msa_family, MN_SOCK_STREAM, 0);
+    if (rc) {
+        mc->mc_sock = NULL;
+        return SYS_ENOMEM;
+    }
+    mn_poll_add(&mc->mc_poll, mc->mc_sock, MN_POLLIN | MN_POLLOUT);
+    mc->mc_state = MQTT_ST_TCP_CONNECT;
+    mc->mc_ping_outstanding = 0;
+
+    rc = mn_connect(mc->mc_sock, broker);
+    if (rc) {
+        mn_close(mc->mc_sock);
+        mc->mc_sock = NULL;
+        mc->mc_state = MQTT_ST_IDLE;
+        return SYS_EIO;
+    }
+    os_callout_reset(&mc->mc_timer,
+                     os_time_ms_to_ticks32(
+                         MYNEWT_VAL(MQTT_CLIENT_CONNECT_TIMEOUT)));
+    return 0;
+}
+
+int
+mqtt_client_disconnect(struct mqtt_client *mc)
+{
+    switch (mc->mc_state) {
+    case MQTT_ST_IDLE:
+        return SYS_EALREADY;
+    case MQTT_ST_DISCONNECTING:
+        return 0;
+    case MQTT_ST_CONNECTED:
+        if (mqtt_client_send_simple(mc, MQTT_PKT_DISCONNECT) == 0 &&
+            mc->mc_state == MQTT_ST_CONNECTED) {
+            /*
+             * Socket is closed once it reports that the DISCONNECT
+             * has been written out.
+             */
+            mc->mc_state = MQTT_ST_DISCONNECTING;
+            os_callout_reset(&mc->mc_timer,
+                             os_time_ms_to_ticks32(
+                                 MYNEWT_VAL(MQTT_CLIENT_CONNECT_TIMEOUT)));
+            return 0;
+        }
+        /* fallthrough */
+    default:
+        if (mc->mc_state != MQTT_ST_IDLE) {
+            mqtt_client_drop(mc, 0);
+        }
+        return 0;
+    }
+}
+
+int
+mqtt_client_publish(struct mqtt_client *mc, const char *topic,
+                    struct os_mbuf *payload, uint8_t qos, uint8_t retain,
+                    uint16_t *pkt_id)
+{
+    struct mqtt_client_inflight *mci;
+    struct os_mbuf *last;
+    struct os_mbuf *om;
+    struct os_mbuf *cp;
+    uint32_t rem_len;
+    uint16_t hdr_len;
+    uint16_t id;
+    uint8_t type;
+
+    if (qos > MQTT_QOS2) {
+        return SYS_EINVAL;
+    }
+    if (mc->mc_state != MQTT_ST_CONNECTED) {
+        return SYS_EIO;
+    }
+    mci = NULL;
+    id = 0;
+    if (qos) {
+        mci = mqtt_client_inflight_free(mc);
+        if (!mci) {
+            return SYS_EAGAIN;
+        }
+        id = mqtt_client_next_id(mc);
+    }
+
+    hdr_len = mqtt_str_len(topic) + (qos ? sizeof(id) : 0);
+    rem_len = hdr_len;
+    if (payload) {
+        rem_len += os_mbuf_len(payload);
+    }
+    type = MQTT_PKT_PUBLISH | (qos << 1);
+    if (retain) {
+        type |= MQTT_PUB_RETAIN;
+    }
+    om = mqtt_pkt_alloc(type, rem_len, hdr_len);
+    if (!om) {
+        return SYS_ENOMEM;
+    }
+    if (mqtt_put_str(om, topic) || (qos && mqtt_put_u16(om, id))) {
+        os_mbuf_free_chain(om);
+        return SYS_ENOMEM;
+    }
+
+    last = om;
+    while (SLIST_NEXT(last, om_next)) {
+        last = SLIST_NEXT(last, om_next);
+    }
+    if (payload) {
+        os_mbuf_concat(om, payload);
+    }
+    if (mci) {
+        cp = mqtt_client_copy(om);
+        if (!cp) {
+            /*
+             * Give payload back to caller.
+             */
+            SLIST_NEXT(last, om_next) = NULL;
+            os_mbuf_free_chain(om);
+            return SYS_ENOMEM;
+        }
+        mci->mci_id = id;
+        mci->mci_state = (qos == MQTT_QOS1) ? MQTT_IF_PUBACK : MQTT_IF_PUBREC;
+        mci->mci_om = cp;
+    }
+    if (pkt_id) {
+        *pkt_id = id;
+    }
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+static int
+mqtt_client_send_sub(struct mqtt_client *mc, uint8_t type, const char *filter,
+                     int qos, uint16_t *pkt_id)
+{
+    struct os_mbuf *om;
+    uint32_t rem_len;
+    uint16_t id;
+
+    if (mc->mc_state != MQTT_ST_CONNECTED) {
+        return SYS_EIO;
+    }
+    id = mqtt_client_next_id(mc);
+    rem_len = sizeof(id) + mqtt_str_len(filter) + (qos >= 0 ? 1 : 0);
+    om = mqtt_pkt_alloc(type | MQTT_PKT_F_QOS1, rem_len, rem_len);
+    if (!om) {
+        return SYS_ENOMEM;
+    }
+    if (mqtt_put_u16(om, id) || mqtt_put_str(om, filter) ||
+        (qos >= 0 && mqtt_put_u8(om, qos))) {
+        os_mbuf_free_chain(om);
+        return SYS_ENOMEM;
+    }
+    if (pkt_id) {
+        *pkt_id = id;
+    }
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+int
+mqtt_client_subscribe(struct mqtt_client *mc, const char *filter,
+                      uint8_t qos, uint16_t *pkt_id)
+{
+    if (qos > MQTT_QOS2) {
+        return SYS_EINVAL;
+    }
+    return mqtt_client_send_sub(mc, MQTT_PKT_SUBSCRIBE, filter, qos, pkt_id);
+}
+
+int
+mqtt_client_unsubscribe(struct mqtt_client *mc, const char *filter,
+                        uint16_t *pkt_id)
+{
+    return mqtt_client_send_sub(mc, MQTT_PKT_UNSUBSCRIBE, filter, -1, pkt_id);
+}
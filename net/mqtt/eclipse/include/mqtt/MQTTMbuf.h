@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef MQTTMBUF_H_
+#define MQTTMBUF_H_
+
+#include "os/mynewt.h"
+#include "MQTTPacket.h"
+
+/*
+ * Variants of the publish serialization functions which work on mbuf
+ * chains instead of flat buffers.
+ */
+
+int MQTTSerialize_publish_mbuf(struct os_mbuf** om, unsigned char dup, int qos, unsigned char retained,
+		unsigned short packetid, MQTTString topicName);
+
+int MQTTDeserialize_publish_mbuf(unsigned char* dup, int* qos, unsigned char* retained, unsigned short* packetid,
+		int* topicoff, int* topiclen, int* payloadoff, int* payloadlen, struct os_mbuf* om);
+
+#endif /* MQTTMBUF_H_ */
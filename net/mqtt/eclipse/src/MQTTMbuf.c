@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "MQTTPacket.h"
+#include "MQTTMbuf.h"
+#include "StackTrace.h"
+
+#include <string.h>
+
+#define MAX_NO_OF_REMAINING_LENGTH_BYTES 4
+
+/**
+  * Serializes the publish headers in front of a payload which is already in an mbuf chain.
+  * Headers are written into the leading space of the first mbuf; a new mbuf is
+  * prepended only if there is not enough room.  The payload is not copied.
+  * @param om pointer to the payload chain, updated to point to the start of the packet.
+  * On failure the chain is freed, and *om is set to NULL.
+  * @param dup integer - the MQTT dup flag
+  * @param qos integer - the MQTT QoS value
+  * @param retained integer - the MQTT retained flag
+  * @param packetid integer - the MQTT packet identifier
+  * @param topicName MQTTString - the MQTT topic in the publish
+  * @return the length of the serialized packet.  <= 0 indicates error
+  */
+int MQTTSerialize_publish_mbuf(struct os_mbuf** om, unsigned char dup, int qos, unsigned char retained,
+		unsigned short packetid, MQTTString topicName)
+{
+	unsigned char *ptr;
+	MQTTHeader header = {0};
+	int payloadlen;
+	int rem_len;
+	int hdr_len;
+	int rc = 0;
+
+	FUNC_ENTRY;
+	payloadlen = os_mbuf_len(*om);
+	rem_len = 2 + MQTTstrlen(topicName) + payloadlen;
+	if (qos > 0)
+		rem_len += 2; /* packetid */
+	hdr_len = MQTTPacket_len(rem_len) - payloadlen;
+
+	*om = os_mbuf_prepend_pullup(*om, hdr_len);
+	if (*om == NULL)
+	{
+		rc = MQTTPACKET_BUFFER_TOO_SHORT;
+		goto exit;
+	}
+	ptr = (*om)->om_data;
+
+	header.bits.type = PUBLISH;
+	header.bits.dup = dup;
+	header.bits.qos = qos;
+	header.bits.retain = retained;
+	writeChar(&ptr, header.byte); /* write header */
+
+	ptr += MQTTPacket_encode(ptr, rem_len); /* write remaining length */;
+
+	writeMQTTString(&ptr, topicName);
+
+	if (qos > 0)
+		writeInt(&ptr, packetid);
+
+	rc = hdr_len + payloadlen;
+
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+
+
+static int readIntAt(struct os_mbuf* om, int off)
+{
+	unsigned char buf[2];
+
+	os_mbuf_copydata(om, off, sizeof(buf), buf);
+	return 256 * buf[0] + buf[1];
+}
+
+
+/**
+  * Deserializes a publish packet held in an mbuf chain, without copying it.
+  * Packet can be split arbitrarily across chain segments; topic and payload
+  * are returned as offsets into the chain, use os_mbuf_copydata() or
+  * os_mbuf_cmpf() to access them.
+  * @param dup returned integer - the MQTT dup flag
+  * @param qos returned integer - the MQTT QoS value
+  * @param retained returned integer - the MQTT retained flag
+  * @param packetid returned integer - the MQTT packet identifier
+  * @param topicoff returned integer - offset of the topic name
+  * @param topiclen returned integer - length of the topic name
+  * @param payloadoff returned integer - offset of the payload
+  * @param payloadlen returned integer - the length of the MQTT payload
+  * @param om the mbuf chain holding the packet
+  * @return error code.  1 is success
+  */
+int MQTTDeserialize_publish_mbuf(unsigned char* dup, int* qos, unsigned char* retained, unsigned short* packetid,
+		int* topicoff, int* topiclen, int* payloadoff, int* payloadlen, struct os_mbuf* om)
+{
+	MQTTHeader header = {0};
+	unsigned char c;
+	int multiplier = 1;
+	int rem_len = 0;
+	int totlen;
+	int off = 0;
+	int rc = 0;
+
+	FUNC_ENTRY;
+	totlen = os_mbuf_len(om);
+	if (os_mbuf_copydata(om, off++, 1, &header.byte) != 0)
+		goto exit;
+	if (header.bits.type != PUBLISH)
+		goto exit;
+	*dup = header.bits.dup;
+	*qos = header.bits.qos;
+	*retained = header.bits.retain;
+
+	do
+	{
+		if (off > MAX_NO_OF_REMAINING_LENGTH_BYTES ||
+				os_mbuf_copydata(om, off++, 1, &c) != 0)
+			goto exit;
+		rem_len += (c & 127) * multiplier;
+		multiplier *= 128;
+	} while ((c & 128) != 0);
+
+	if (off + rem_len > totlen || rem_len < 2)
+		goto exit;
+	totlen = off + rem_len;
+
+	*topiclen = readIntAt(om, off);
+	*topicoff = off + 2;
+	off = *topicoff + *topiclen;
+	if (off > totlen)
+		goto exit;
+
+	if (*qos > 0)
+	{
+		if (off + 2 > totlen)
+			goto exit;
+		*packetid = readIntAt(om, off);
+		off += 2;
+	}
+
+	*payloadoff = off;
+	*payloadlen = totlen - off;
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
@@ -97,9 +97,18 @@ enum
 #define IS_OPTION(packet, opt)                                                 \
   ((packet)->options[opt / OPTION_MAP_SIZE] & (1 << (opt % OPTION_MAP_SIZE)))
 
+/*
+ * Location of a received option value within the mbuf chain.
+ */
+struct coap_opt_ref {
+    uint16_t off;
+    uint16_t len;
+};
+
 /*
  * For COAP RX, structure stores the offsets and lengths of option fields
- * within the mbuf chain.
+ * within the mbuf chain. Values are decoded only when asked for through
+ * the coap_get_header_*() accessors.
  */
 struct coap_packet_rx {
     struct os_mbuf *m;
@@ -115,49 +124,17 @@ struct coap_packet_rx {
     /* bitmap to check if option is set */
     uint8_t options[COAP_OPTION_SIZE1 / OPTION_MAP_SIZE + 1];
 
-    /* parse options once and store */
-    uint16_t content_format;
-    uint32_t max_age;
-#if 0
-    uint8_t etag_len;
-    uint8_t etag[COAP_ETAG_LEN];
-#endif
-#if COAP_PROXY_OPTION_PROCESSING
-    uint16_t proxy_uri_len;
-    uint16_t proxy_uri_off;
-    uint16_t proxy_scheme_len;
-    uint16_t proxy_scheme_off;
-#endif
-    uint16_t uri_host_len;
-    uint16_t uri_host_off;
-#if 0
-    uint16_t loc_path_len;
-    uint16_t loc_path_off;
-    uint16_t loc_query_len;
-    uint16_t loc_query_off;
-#endif
-    uint16_t uri_port;
-    uint16_t uri_path_len;
-    uint16_t uri_path_off;
-    uint16_t accept;
-    int32_t observe;
-#if 0
-    uint8_t if_match_len;
-    uint8_t if_match[COAP_ETAG_LEN];
-#endif
-    uint32_t block2_num;
-    uint8_t block2_more;
-    uint16_t block2_size;
-    uint32_t block2_offset;
-    uint32_t block1_num;
-    uint8_t block1_more;
-    uint16_t block1_size;
-    uint32_t block1_offset;
-    uint32_t size2;
-    uint32_t size1;
-    uint16_t uri_query_len;
-    uint16_t uri_query_off;
-    uint8_t if_none_match;
+    struct coap_opt_ref content_format;
+    struct coap_opt_ref max_age;
+    struct coap_opt_ref accept;
+    struct coap_opt_ref observe;
+    struct coap_opt_ref block2;
+    struct coap_opt_ref block1;
+    struct coap_opt_ref size2;
+    struct coap_opt_ref size1;
+    /* first segment; following segments are joined on access */
+    struct coap_opt_ref uri_path;
+    struct coap_opt_ref uri_query;
 
     uint16_t payload_off;
     uint16_t payload_len;
@@ -298,6 +275,20 @@ extern char *coap_error_message;
 void coap_init_connection(void);
 uint16_t coap_get_mid(void);
 
+/* Hash bucket for a token, see COAP_HASH_SIZE. */
+static inline unsigned int
+coap_token_hash(const uint8_t *token, uint8_t token_len)
+{
+    unsigned int h;
+    int i;
+
+    h = token_len;
+    for (i = 0; i < token_len; i++) {
+        h = h * 31 + token[i];
+    }
+    return h & (COAP_HASH_SIZE - 1);
+}
+
 uint16_t coap_tcp_msg_size(uint8_t *hdr, int datalen);
 
 void coap_init_message(coap_packet_t *, coap_message_type_t type,
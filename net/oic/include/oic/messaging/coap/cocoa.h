@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef COAP_COCOA_H
+#define COAP_COCOA_H
+
+#include "os/mynewt.h"
+#include "oic/port/oc_connectivity.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CoCoA style adaptive retransmission timeouts (draft-ietf-core-cocoa).
+ * Every peer gets a strong RTT estimator, fed by exchanges that were not
+ * retransmitted, and a weak one, fed by exchanges that needed one or two
+ * retransmissions.  Their estimates are blended into the RTO used for the
+ * next confirmable message to that peer.  At most OC_COAP_NSTART
+ * confirmable messages are outstanding per peer; further ones wait.
+ */
+
+struct coap_transaction;
+
+struct coap_cocoa_ep {
+    oc_endpoint_t ce_ep;
+    uint32_t ce_rto;            /* overall RTO, in os ticks */
+    uint32_t ce_strong_srtt;
+    uint32_t ce_strong_rttvar;
+    uint32_t ce_weak_srtt;
+    uint32_t ce_weak_rttvar;
+    uint32_t ce_strong_cnt;     /* number of strong samples */
+    uint32_t ce_weak_cnt;       /* number of weak samples */
+    os_time_t ce_updated;       /* last RTO update or aging */
+    os_time_t ce_used;          /* last transmission, for replacement */
+    uint8_t ce_outstanding;
+    uint8_t ce_in_use:1;
+    STAILQ_HEAD(, coap_transaction) ce_pending;
+};
+
+/*
+ * Per endpoint RTT statistics; times are in milliseconds.
+ */
+struct coap_cocoa_stats {
+    oc_endpoint_t ep;
+    uint32_t rto;
+    uint32_t strong_srtt;
+    uint32_t strong_rttvar;
+    uint32_t weak_srtt;
+    uint32_t weak_rttvar;
+    uint32_t strong_cnt;
+    uint32_t weak_cnt;
+    uint8_t outstanding;
+};
+
+/**
+ * Returns the state for an endpoint, allocating it if needed.  Returns NULL
+ * if the table is full of peers with exchanges in flight; the caller then
+ * falls back to the fixed CoAP timers.
+ */
+struct coap_cocoa_ep *coap_cocoa_get(oc_endpoint_t *ep);
+
+/**
+ * Returns the initial timeout for a new confirmable message, in os ticks,
+ * after aging a stale RTO towards the default.
+ */
+uint32_t coap_cocoa_rto(struct coap_cocoa_ep *ce);
+
+/**
+ * Returns the next timeout after tmo expired (variable backoff factor).
+ */
+uint32_t coap_cocoa_backoff(uint32_t tmo);
+
+/**
+ * Feeds an RTT sample, measured from the first transmission of a message
+ * which was transmitted retrans + 1 times.
+ */
+void coap_cocoa_sample(struct coap_cocoa_ep *ce, uint32_t rtt, int retrans);
+
+/**
+ * Reads the statistics of the idx'th tracked endpoint.
+ *
+ * @return                      0 on success; SYS_ENOENT if there is no
+ *                                  such entry.
+ */
+int coap_cocoa_stats_get(int idx, struct coap_cocoa_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_COCOA_H */
@@ -68,6 +68,10 @@ extern "C" {
 #define COAP_MAX_OBSERVERS (MAX_APP_RESOURCES + MAX_NUM_CONCURRENT_REQUESTS)
 #endif /* COAP_MAX_OBSERVERS */
 
+/* Buckets in the transaction, client callback and observer lookup tables. */
+#define COAP_HASH_SIZE MYNEWT_VAL(OC_COAP_HASH_SIZE)
+#define COAP_MID_HASH(mid) ((mid) & (COAP_HASH_SIZE - 1))
+
 /* Interval in notifies in which NON notifies are changed to CON notifies to
  * check client. */
 #define COAP_OBSERVE_REFRESH_INTERVAL 20
@@ -48,6 +48,9 @@ extern "C" {
 
 typedef struct coap_observer {
   SLIST_ENTRY(coap_observer) next;
+  SLIST_ENTRY(coap_observer) res_next;  /* in resource->observers */
+  SLIST_ENTRY(coap_observer) tok_next;  /* in the token hash bucket */
+  SLIST_ENTRY(coap_observer) mid_next;  /* in the last_mid hash bucket */
 
   oc_resource_t *resource;
 
@@ -34,6 +34,7 @@ typedef struct oc_response_buffer {
     int32_t *block_offset;
     uint16_t response_length;
     int code;
+    uint8_t block1_accepted;    /* handler consumed the request's Block1 */
 } oc_response_buffer_t;
 
 #ifdef __cplusplus
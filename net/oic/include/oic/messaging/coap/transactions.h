@@ -35,6 +35,9 @@
 #define TRANSACTIONS_H
 
 #include "coap.h"
+#if MYNEWT_VAL(OC_COAP_COCOA)
+#include "oic/messaging/coap/cocoa.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,7 +58,7 @@ extern "C" {
 
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
-    SLIST_ENTRY(coap_transaction) next;
+    SLIST_ENTRY(coap_transaction) next;     /* in the MID hash bucket */
 
     uint16_t mid;
     uint8_t retrans_counter;
@@ -63,14 +66,25 @@ typedef struct coap_transaction {
     uint32_t retrans_tmo;
     struct os_callout retrans_timer;
     struct os_mbuf *m;
+#if MYNEWT_VAL(OC_COAP_COCOA)
+    struct coap_cocoa_ep *cocoa;            /* peer state, if tracked */
+    os_time_t start;                        /* first transmission */
+    uint8_t cocoa_state;                    /* COAP_COCOA_XXX */
+    STAILQ_ENTRY(coap_transaction) pend_next;
+#endif
 } coap_transaction_t;
 
+#define COAP_COCOA_IDLE         0
+#define COAP_COCOA_PENDING      1   /* waiting for NSTART */
+#define COAP_COCOA_OUTSTANDING  2
+
 void coap_register_as_transaction_handler(void);
 
 coap_transaction_t *coap_new_transaction(uint16_t mid, oc_endpoint_t *);
 
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
+void coap_ack_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
 
 void coap_check_transactions(void);
@@ -108,6 +108,27 @@ int oc_get_query_value(oc_request_t *request, const char *key, char **value);
 void oc_send_response(oc_request_t *request, oc_status_t response_code);
 void oc_ignore_request(oc_request_t *request);
 
+/*
+ * Block-wise transfers (RFC 7959).
+ *
+ * A PUT/POST handler can consume a large payload one block at a time.
+ * oc_get_request_block1() describes the block carried by the request
+ * (payload at request->packet->payload_off).  oc_accept_request_block1()
+ * tells the client the block was taken: it is asked for the next block with
+ * 2.31 Continue, or gets the handler's response after the last one.
+ *
+ * A GET handler can produce a large representation one block at a time.
+ * oc_get_response_block_offset() returns the offset the client wants; the
+ * handler encodes data from there and reports the offset of the following
+ * block with oc_set_response_block_next(), or -1 once the end is reached.
+ * Responses of handlers that do neither are sliced by the stack.
+ */
+bool oc_get_request_block1(oc_request_t *request, uint32_t *offset,
+                           bool *more);
+void oc_accept_request_block1(oc_request_t *request);
+uint32_t oc_get_response_block_offset(oc_request_t *request);
+void oc_set_response_block_next(oc_request_t *request, int32_t next);
+
 #if MYNEWT_VAL(OC_SEPARATE_RESPONSES)
 void oc_indicate_separate_response(oc_request_t *request,
                                    oc_separate_response_t *response);
@@ -17,6 +17,8 @@
 #ifndef OC_BUFFER_H
 #define OC_BUFFER_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,6 +29,26 @@ struct os_mbuf *oc_allocate_mbuf(struct oc_endpoint *oe);
 
 void oc_send_message(struct os_mbuf *m);
 
+/*
+ * Per transport TX queue statistics. Latencies are in OS ticks, measured
+ * from queueing to handing the message to the transport.
+ */
+struct oc_txq_stats {
+    uint16_t ots_depth;
+    uint16_t ots_max_depth;
+    uint32_t ots_sent;
+    uint32_t ots_drops;
+    uint32_t ots_lat_max;
+    uint32_t ots_lat_total;
+};
+
+int oc_buffer_txq_stats(uint8_t transport_id, struct oc_txq_stats *stats);
+
+/*
+ * Called by a transport with ot_tx_ready() when it can take more data.
+ */
+void oc_buffer_tx_resume(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,11 @@ extern "C" {
 
 void oc_create_discovery_resource(void);
 
+/*
+ * Drops encoded discovery links; called when set of resources changes.
+ */
+void oc_discovery_invalidate(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include <tinycbor/cbor.h>
+#include <tinycbor/cbor_mbuf_reader.h>
 #include "oic/oc_constants.h"
 #include "oic/oc_helpers.h"
 #include "oic/port/mynewt/config.h"
@@ -198,6 +199,58 @@ int oc_rep_finalize(void);
     g_err |= cbor_encoder_close_container(&object##_map, &key##_value_array);  \
   } while (0)
 
+/*
+ * Streaming decode of a payload, without building an oc_rep_t tree.
+ * Keys and values are read directly from the mbuf as the caller iterates;
+ * nothing is allocated, and strings are only copied into caller supplied
+ * buffers.
+ *
+ *     struct oc_rep_cursor cur;
+ *     struct oc_rep_iter it;
+ *
+ *     if (oc_rep_cursor_init(&cur, m, off) || oc_rep_cursor_map(&cur, &it)) {
+ *         ...bad request...
+ *     }
+ *     while (oc_rep_iter_next(&it) > 0) {
+ *         if (oc_rep_iter_key_is(&it, "value")) {
+ *             oc_rep_iter_get_bool(&it, &value);
+ *         }
+ *     }
+ *
+ * The cursor must stay in place while iterators derived from it are in use.
+ */
+struct oc_rep_cursor {
+    struct cbor_mbuf_reader orc_reader;
+    CborParser orc_parser;
+    CborValue orc_root;
+};
+
+/*
+ * Position within a map or an array. After oc_rep_iter_next() returns 1,
+ * the current element is in ori_val, and for maps its key in ori_key.
+ */
+struct oc_rep_iter {
+    CborValue ori_key;
+    CborValue ori_val;
+    uint8_t ori_map:1;
+    uint8_t ori_started:1;
+};
+
+int oc_rep_cursor_init(struct oc_rep_cursor *cur, struct os_mbuf *m,
+                       uint16_t payload_off);
+int oc_rep_cursor_map(struct oc_rep_cursor *cur, struct oc_rep_iter *it);
+int oc_rep_cursor_array(struct oc_rep_cursor *cur, struct oc_rep_iter *it);
+
+int oc_rep_iter_next(struct oc_rep_iter *it);
+bool oc_rep_iter_key_is(struct oc_rep_iter *it, const char *key);
+int oc_rep_iter_get_int(struct oc_rep_iter *it, int64_t *val);
+int oc_rep_iter_get_bool(struct oc_rep_iter *it, bool *val);
+int oc_rep_iter_get_double(struct oc_rep_iter *it, double *val);
+int oc_rep_iter_get_text(struct oc_rep_iter *it, char *buf, size_t *len);
+int oc_rep_iter_get_bytes(struct oc_rep_iter *it, uint8_t *buf, size_t *len);
+int oc_rep_iter_enter_map(struct oc_rep_iter *it, struct oc_rep_iter *child);
+int oc_rep_iter_enter_array(struct oc_rep_iter *it, struct oc_rep_iter *child);
+
 #ifdef OC_CLIENT
 typedef enum {
   NIL = 0,
@@ -47,8 +47,12 @@ typedef struct oc_request {
 
 typedef void (*oc_request_handler_t)(oc_request_t *, oc_interface_mask_t);
 
+struct coap_observer;
+
 typedef struct oc_resource {
   SLIST_ENTRY(oc_resource) next;
+  SLIST_ENTRY(oc_resource) hash_next;
+  uint32_t uri_hash;
   int device;
   oc_string_t uri;
   oc_string_array_t types;
@@ -62,6 +66,7 @@ typedef struct oc_resource {
   struct os_callout callout;
   uint32_t observe_period_mseconds;
   uint8_t num_observers;
+  SLIST_HEAD(, coap_observer) observers;
 } oc_resource_t;
 
 void oc_ri_init(void);
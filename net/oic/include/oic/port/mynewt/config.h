@@ -37,6 +37,8 @@ typedef os_time_t oc_clock_time_t;
 /* Server-side parameters */
 /* Maximum number of server resources */
 #define MAX_APP_RESOURCES MYNEWT_VAL(OC_APP_RESOURCES)
+/* Number of buckets in the resource URI hash */
+#define APP_RESOURCES_HASH_SIZE MYNEWT_VAL(OC_APP_RESOURCES_HASH_SIZE)
 
 /* Common paramters */
 /* Maximum number of concurrent requests */
@@ -34,6 +34,63 @@ struct oc_endpoint_lora {
 
 extern uint8_t oc_lora_transport_id;
 
+#if MYNEWT_VAL(OC_LORA_SCHC)
+/*
+ * Static context header compression (after RFC 8724) for CoAP over LoRa.
+ *
+ * Each rule describes one message shape. Fields which the rule fixes are
+ * elided from the frame; the rest are carried as byte-aligned residue
+ * behind the rule ID, in header order. Payload follows without the 0xff
+ * marker. Rule ID 0 is reserved for frames sent uncompressed. Both ends
+ * must be configured with the same rules.
+ */
+#define OC_LORA_SCHC_RULE_NONE  0
+
+/* osr_type/osr_tkl/osr_code: field value is sent rather than matched. */
+#define OC_LORA_SCHC_ANY        0xff
+
+/* osr_mid: how the message ID is carried. */
+#define OC_LORA_SCHC_MID_SEND   0   /* both bytes sent */
+#define OC_LORA_SCHC_MID_LSB    1   /* low byte sent, high must match */
+
+/*
+ * Option field descriptor. Options in the message must appear in the
+ * same order and with the same numbers as in the rule. If oso_val is
+ * NULL, the value is sent as length byte + value; otherwise it must match
+ * and is elided.
+ */
+struct oc_lora_schc_opt {
+    uint16_t oso_num;
+    uint8_t oso_len;
+    const uint8_t *oso_val;
+};
+
+struct oc_lora_schc_rule {
+    uint8_t osr_id;             /* non-zero, unique */
+    uint8_t osr_port;           /* LoRa port, 0 for any */
+    uint8_t osr_type;           /* COAP_TYPE_* or OC_LORA_SCHC_ANY */
+    uint8_t osr_tkl;            /* token length or OC_LORA_SCHC_ANY */
+    uint8_t osr_code;           /* CoAP code or OC_LORA_SCHC_ANY */
+    uint8_t osr_mid;            /* OC_LORA_SCHC_MID_* */
+    uint16_t osr_mid_val;       /* high byte used with MID_LSB */
+    uint8_t osr_nopts;
+    const struct oc_lora_schc_opt *osr_opts;
+};
+
+/*
+ * Replace the rule table. The table is not copied, and must stay valid
+ * while the LoRa transport is in use. Rules are tried in table order.
+ */
+void oc_lora_schc_rules_set(const struct oc_lora_schc_rule *rules, int cnt);
+
+/*
+ * Compress/decompress a CoAP message in place of the mbuf chain. Return
+ * the new chain, or NULL if it was freed on error.
+ */
+struct os_mbuf *oc_lora_schc_compress(struct os_mbuf *m, uint8_t port);
+struct os_mbuf *oc_lora_schc_decompress(struct os_mbuf *m, uint8_t port);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
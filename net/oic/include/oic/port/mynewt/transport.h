@@ -39,6 +39,7 @@ struct oc_transport {
     uint8_t (*ot_ep_size)(const struct oc_endpoint *);
     void (*ot_tx_ucast)(struct os_mbuf *);
     void (*ot_tx_mcast)(struct os_mbuf *);
+    int (*ot_tx_ready)(void);           /* optional; 0 if busy */
     enum oc_resource_properties
          (*ot_get_trans_security)(const struct oc_endpoint *);
     char *(*ot_ep_str)(char *ptr, int maxlen, const struct oc_endpoint *);
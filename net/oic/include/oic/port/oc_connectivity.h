@@ -38,6 +38,7 @@ struct oc_ep_hdr {
 
 #define OC_ENDPOINT_MULTICAST   (1 << 0)
 #define OC_ENDPOINT_SECURED     (1 << 1)
+#define OC_ENDPOINT_RX_MCAST    (1 << 2)    /* request came via multicast */
 
 /*
  * Use this when reserving memory for oc_endpoint of unknown type.
@@ -29,10 +29,158 @@
 #include "oic/oc_buffer.h"
 #include "oic/port/mynewt/adaptor.h"
 #include "oic/port/mynewt/transport.h"
+#include "oic/port/oc_random.h"
 
 static struct os_mqueue oc_inq;
 static struct os_mqueue oc_outq;
 
+/*
+ * Unicast messages wait in a queue per transport. The queues are served
+ * round robin, one message from each per pass, and the event is requeued
+ * between passes; a slow adapter does not hold up the others. Transports
+ * with ot_tx_ready() are skipped while busy, and call
+ * oc_buffer_tx_resume() once they can take more.
+ */
+struct oc_txq {
+    STAILQ_HEAD(, os_mbuf_pkthdr) otq_pkts;
+    os_time_t otq_enq[MYNEWT_VAL(OC_TX_QUEUE_MAX)];  /* FIFO with otq_pkts */
+    uint8_t otq_head;
+    struct oc_txq_stats otq_stats;
+};
+
+static struct oc_txq oc_txqs[OC_TRANSPORT_MAX];
+
+static void oc_txq_run(struct os_event *ev);
+static struct os_event oc_txq_ev = {
+    .ev_cb = oc_txq_run
+};
+
+static void
+oc_txq_put(struct os_mbuf *m)
+{
+    struct oc_txq *q;
+    int idx;
+
+    q = &oc_txqs[OC_MBUF_ENDPOINT(m)->ep.oe_type];
+    if (q->otq_stats.ots_depth >= MYNEWT_VAL(OC_TX_QUEUE_MAX)) {
+        OC_LOG(ERROR, "oc_buffer_tx: queue full\n");
+        q->otq_stats.ots_drops++;
+        os_mbuf_free_chain(m);
+        return;
+    }
+    idx = (q->otq_head + q->otq_stats.ots_depth) %
+      MYNEWT_VAL(OC_TX_QUEUE_MAX);
+    q->otq_enq[idx] = os_time_get();
+    STAILQ_INSERT_TAIL(&q->otq_pkts, OS_MBUF_PKTHDR(m), omp_next);
+    if (++q->otq_stats.ots_depth > q->otq_stats.ots_max_depth) {
+        q->otq_stats.ots_max_depth = q->otq_stats.ots_depth;
+    }
+}
+
+static struct os_mbuf *
+oc_txq_get(struct oc_txq *q)
+{
+    struct os_mbuf_pkthdr *omp;
+    os_time_t lat;
+
+    omp = STAILQ_FIRST(&q->otq_pkts);
+    STAILQ_REMOVE_HEAD(&q->otq_pkts, omp_next);
+    STAILQ_NEXT(omp, omp_next) = NULL;
+
+    lat = os_time_get() - q->otq_enq[q->otq_head];
+    q->otq_head = (q->otq_head + 1) % MYNEWT_VAL(OC_TX_QUEUE_MAX);
+    q->otq_stats.ots_depth--;
+    q->otq_stats.ots_sent++;
+    q->otq_stats.ots_lat_total += lat;
+    if (lat > q->otq_stats.ots_lat_max) {
+        q->otq_stats.ots_lat_max = lat;
+    }
+    return OS_MBUF_PKTHDR_TO_MBUF(omp);
+}
+
+static void
+oc_txq_run(struct os_event *ev)
+{
+    const struct oc_transport *ot;
+    struct oc_txq *q;
+    int more = 0;
+    int i;
+
+    for (i = 0; i < OC_TRANSPORT_MAX; i++) {
+        q = &oc_txqs[i];
+        if (STAILQ_EMPTY(&q->otq_pkts)) {
+            continue;
+        }
+        ot = oc_transports[i];
+        if (ot && ot->ot_tx_ready && !ot->ot_tx_ready()) {
+            continue;
+        }
+        oc_send_buffer(oc_txq_get(q));
+        if (!STAILQ_EMPTY(&q->otq_pkts)) {
+            more = 1;
+        }
+    }
+    if (more) {
+        os_eventq_put(oc_evq_get(), &oc_txq_ev);
+    }
+}
+
+void
+oc_buffer_tx_resume(void)
+{
+    os_eventq_put(oc_evq_get(), &oc_txq_ev);
+}
+
+int
+oc_buffer_txq_stats(uint8_t transport_id, struct oc_txq_stats *stats)
+{
+    if (transport_id >= OC_TRANSPORT_MAX) {
+        return -1;
+    }
+    *stats = oc_txqs[transport_id].otq_stats;
+    return 0;
+}
+
+#if MYNEWT_VAL(OC_SERVER) && MYNEWT_VAL(OC_MCAST_RESPONSE_JITTER) > 0
+/*
+ * Responses to multicast requests, waiting for their random delay to pass.
+ */
+static STAILQ_HEAD(, os_mbuf_pkthdr) oc_jitterq =
+    STAILQ_HEAD_INITIALIZER(oc_jitterq);
+static struct os_callout oc_jitter_timer;
+
+static void
+oc_jitter_tx(struct os_event *ev)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    while ((omp = STAILQ_FIRST(&oc_jitterq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&oc_jitterq, omp_next);
+        STAILQ_NEXT(omp, omp_next) = NULL;
+        oc_txq_put(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    oc_txq_run(NULL);
+}
+
+/*
+ * Hold a response to a multicast request for a random time, up to
+ * OC_MCAST_RESPONSE_JITTER ms.  Everything queued goes out when the timer
+ * expires; the timer is not pushed back by later responses.
+ */
+static void
+oc_jitter_queue(struct os_mbuf *m)
+{
+    uint32_t ticks;
+
+    STAILQ_INSERT_TAIL(&oc_jitterq, OS_MBUF_PKTHDR(m), omp_next);
+    if (!os_callout_queued(&oc_jitter_timer)) {
+        ticks = os_time_ms_to_ticks32(oc_random_rand() %
+                                      MYNEWT_VAL(OC_MCAST_RESPONSE_JITTER));
+        os_callout_reset(&oc_jitter_timer, ticks);
+    }
+}
+#endif
+
 struct os_mbuf *
 oc_allocate_mbuf(struct oc_endpoint *oe)
 {
@@ -77,6 +225,13 @@ oc_buffer_tx(struct os_event *ev)
         STAILQ_NEXT(OS_MBUF_PKTHDR(m), omp_next) = NULL;
         OC_LOG(DEBUG, "oc_buffer_tx: ");
         OC_LOG_ENDPOINT(LOG_LEVEL_DEBUG, OC_MBUF_ENDPOINT(m));
+#if MYNEWT_VAL(OC_SERVER) && MYNEWT_VAL(OC_MCAST_RESPONSE_JITTER) > 0
+        if (OC_MBUF_ENDPOINT(m)->ep.oe_flags & OC_ENDPOINT_RX_MCAST) {
+            OC_MBUF_ENDPOINT(m)->ep.oe_flags &= ~OC_ENDPOINT_RX_MCAST;
+            oc_jitter_queue(m);
+            continue;
+        }
+#endif
 #ifdef OC_CLIENT
         if (OC_MBUF_ENDPOINT(m)->ep.oe_flags & OC_ENDPOINT_MULTICAST) {
             oc_send_multicast_message(m);
@@ -97,12 +252,13 @@ oc_buffer_tx(struct os_event *ev)
             } else
 #endif
             {
-                oc_send_buffer(m);
+                oc_txq_put(m);
             }
 #ifdef OC_CLIENT
         }
 #endif
     }
+    oc_txq_run(NULL);
 }
 
 static void
@@ -140,7 +296,15 @@ oc_buffer_rx(struct os_event *ev)
 void
 oc_buffer_init(void)
 {
+    int i;
+
     os_mqueue_init(&oc_inq, oc_buffer_rx, NULL);
     os_mqueue_init(&oc_outq, oc_buffer_tx, NULL);
+    for (i = 0; i < OC_TRANSPORT_MAX; i++) {
+        STAILQ_INIT(&oc_txqs[i].otq_pkts);
+    }
+#if MYNEWT_VAL(OC_SERVER) && MYNEWT_VAL(OC_MCAST_RESPONSE_JITTER) > 0
+    os_callout_init(&oc_jitter_timer, oc_evq_get(), oc_jitter_tx, NULL);
+#endif
 }
 
@@ -18,6 +18,7 @@
 
 #include "oic/port/mynewt/config.h"
 #include "oic/oc_core_res.h"
+#include "oic/oc_discovery.h"
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_ri.h"
@@ -273,6 +274,7 @@ oc_core_populate_resource(int type, const char *uri, const char *rt,
     r->put_handler = put;
     r->post_handler = post;
     r->delete_handler = delete;
+    oc_discovery_invalidate();
 }
 
 oc_uuid_t *
@@ -24,30 +24,52 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_api.h"
 #include "oic/oc_core_res.h"
+#include "oic/oc_discovery.h"
 #include "oic/port/mynewt/ip.h"
 
+/*
+ * Encoded link objects of all discoverable resources. Discovery responses
+ * are assembled from these, instead of encoding each resource for every
+ * request. Rebuilt after resources have been added or removed.
+ */
+#define OC_DISC_LINKS_MAX                                               \
+    (1 + MAX_NUM_DEVICES + MAX_APP_RESOURCES + 1)
+
+struct oc_disc_link {
+    oc_resource_t *odl_res;
+    uint16_t odl_off;
+    uint16_t odl_len;
+};
+
+static struct {
+    struct os_mbuf *m;
+    int cnt;
+    struct oc_disc_link links[OC_DISC_LINKS_MAX];
+} oc_disc_cache;
+
 static bool
-filter_resource(oc_resource_t *resource, const char *rt, int rt_len,
-                CborEncoder *links)
+filter_resource(oc_resource_t *resource, const char *rt, int rt_len)
 {
   int i;
-  bool match = true;
-  if (rt_len > 0) {
-    match = false;
-    for (i = 0; i < oc_string_array_get_allocated_size(resource->types); i++) {
-      int size = oc_string_array_get_item_size(resource->types, i);
-      const char *t =
-        (const char *)oc_string_array_get_item(resource->types, i);
-      if (rt_len == size && strncmp(rt, t, rt_len) == 0) {
-        match = true;
-        break;
-      }
+
+  if (rt_len <= 0) {
+    return true;
+  }
+  for (i = 0; i < oc_string_array_get_allocated_size(resource->types); i++) {
+    int size = oc_string_array_get_item_size(resource->types, i);
+    const char *t =
+      (const char *)oc_string_array_get_item(resource->types, i);
+    if (rt_len == size && strncmp(rt, t, rt_len) == 0) {
+      return true;
     }
   }
+  return false;
+}
 
-  if (!match) {
-    return false;
-  }
+static void
+encode_resource(oc_resource_t *resource, CborEncoder *links)
+{
+  int i;
 
   oc_rep_start_object(*links, res);
 
@@ -80,49 +102,115 @@ filter_resource(oc_resource_t *resource, const char *rt, int rt_len,
   oc_rep_close_object(res, p);
 
   oc_rep_end_object(*links, res);
-  return true;
 }
 
+static void
+oc_disc_cache_add(oc_resource_t *resource)
+{
+    struct oc_disc_link *odl;
+    int off;
+
+    if (oc_disc_cache.cnt >= OC_DISC_LINKS_MAX) {
+        g_err |= CborErrorOutOfMemory;
+        return;
+    }
+    off = OS_MBUF_PKTLEN(oc_disc_cache.m);
+    encode_resource(resource, &g_encoder);
+
+    odl = &oc_disc_cache.links[oc_disc_cache.cnt++];
+    odl->odl_res = resource;
+    odl->odl_off = off;
+    odl->odl_len = OS_MBUF_PKTLEN(oc_disc_cache.m) - off;
+}
+
+/*
+ * Uses the oc_rep encoder; caller must restart its own encoding afterwards.
+ */
 static int
-process_device_object(CborEncoder *device, const char *uuid, const char *rt,
-                      int rt_len)
+oc_disc_cache_build(void)
 {
-  int dev, matches = 0;
+    int dev;
 #ifdef OC_SERVER
-  oc_resource_t *resource;
+    oc_resource_t *resource;
+#endif
+
+    oc_disc_cache.m = os_msys_get_pkthdr(0, 0);
+    if (!oc_disc_cache.m) {
+        return -1;
+    }
+    oc_disc_cache.cnt = 0;
+    oc_rep_new(oc_disc_cache.m);
+
+    oc_disc_cache_add(oc_core_get_resource_by_index(OCF_P));
+    for (dev = 0; dev < oc_core_get_num_devices(); dev++) {
+        oc_disc_cache_add(
+          oc_core_get_resource_by_index(NUM_OC_CORE_RESOURCES - 1 - dev));
+    }
+#ifdef OC_SERVER
+    for (resource = oc_ri_get_app_resources(); resource;
+         resource = SLIST_NEXT(resource, next)) {
+        if (resource->properties & OC_DISCOVERABLE) {
+            oc_disc_cache_add(resource);
+        }
+    }
 #endif
+#ifdef OC_SECURITY
+    oc_disc_cache_add(oc_core_get_resource_by_index(OCF_SEC_DOXM));
+#endif
+
+    if (oc_rep_finalize() < 0) {
+        oc_discovery_invalidate();
+        return -1;
+    }
+    return 0;
+}
+
+void
+oc_discovery_invalidate(void)
+{
+    if (oc_disc_cache.m) {
+        os_mbuf_free_chain(oc_disc_cache.m);
+        oc_disc_cache.m = NULL;
+    }
+    oc_disc_cache.cnt = 0;
+}
+
+/*
+ * Appends cached links matching the rt filter. Adjacent matches are
+ * copied with a single append, so an unfiltered query is one copy.
+ */
+static int
+process_device_object(struct os_mbuf *m, CborEncoder *device,
+                      const char *uuid, const char *rt, int rt_len)
+{
+  struct oc_disc_link *odl;
+  int run_off = 0, run_len = 0;
+  int i, matches = 0;
+
   oc_rep_start_object(*device, links);
   oc_rep_set_text_string(links, di, uuid);
   oc_rep_set_array(links, links);
 
-  if (filter_resource(oc_core_get_resource_by_index(OCF_P), rt, rt_len,
-                      oc_rep_array(links)))
+  for (i = 0; i < oc_disc_cache.cnt; i++) {
+    odl = &oc_disc_cache.links[i];
+    if (!filter_resource(odl->odl_res, rt, rt_len)) {
+      continue;
+    }
     matches++;
-
-  for (dev = 0; dev < oc_core_get_num_devices(); dev++) {
-    if (filter_resource(
-          oc_core_get_resource_by_index(NUM_OC_CORE_RESOURCES - 1 - dev), rt,
-          rt_len, oc_rep_array(links)))
-      matches++;
+    if (run_len && run_off + run_len == odl->odl_off) {
+      run_len += odl->odl_len;
+      continue;
+    }
+    if (run_len &&
+        os_mbuf_appendfrom(m, oc_disc_cache.m, run_off, run_len)) {
+      g_err |= CborErrorOutOfMemory;
+    }
+    run_off = odl->odl_off;
+    run_len = odl->odl_len;
   }
-
-#ifdef OC_SERVER
-  for (resource = oc_ri_get_app_resources(); resource;
-       resource = SLIST_NEXT(resource, next)) {
-      if (!(resource->properties & OC_DISCOVERABLE)) {
-          continue;
-      }
-      if (filter_resource(resource, rt, rt_len, oc_rep_array(links))) {
-          matches++;
-      }
+  if (run_len && os_mbuf_appendfrom(m, oc_disc_cache.m, run_off, run_len)) {
+    g_err |= CborErrorOutOfMemory;
   }
-#endif
-
-#ifdef OC_SECURITY
-  if (filter_resource(oc_core_get_resource_by_index(OCF_SEC_DOXM), rt, rt_len,
-                      oc_rep_array(links)))
-    matches++;
-#endif
 
   oc_rep_close_array(links, links);
   oc_rep_end_object(*device, links);
@@ -133,10 +221,20 @@ process_device_object(CborEncoder *device, const char *uuid, const char *rt,
 static void
 oc_core_discovery_handler(oc_request_t *req, oc_interface_mask_t interface)
 {
+    struct os_mbuf *m = req->response->response_buffer->buffer;
     char *rt = NULL;
     int rt_len = 0, matches = 0;
     char uuid[37];
 
+    if (!oc_disc_cache.m) {
+        if (oc_disc_cache_build()) {
+            req->response->response_buffer->code =
+              oc_status_code(OC_STATUS_SERVICE_UNAVAILABLE);
+            return;
+        }
+        oc_rep_new(m);
+    }
+
     rt_len = oc_ri_get_query_value(req->query, req->query_len, "rt", &rt);
 
     oc_uuid_to_str(oc_core_get_device_id(0), uuid, sizeof(uuid));
@@ -144,14 +242,16 @@ oc_core_discovery_handler(oc_request_t *req, oc_interface_mask_t interface)
     switch (interface) {
     case OC_IF_LL: {
         oc_rep_start_links_array();
-        matches = process_device_object(oc_rep_array(links), uuid, rt, rt_len);
+        matches = process_device_object(m, oc_rep_array(links), uuid,
+                                        rt, rt_len);
         oc_rep_end_links_array();
     } break;
     case OC_IF_BASELINE: {
         oc_rep_start_root_object();
         oc_process_baseline_interface(req->resource);
         oc_rep_set_array(root, links);
-        matches = process_device_object(oc_rep_array(links), uuid, rt, rt_len);
+        matches = process_device_object(m, oc_rep_array(links), uuid,
+                                        rt, rt_len);
         oc_rep_close_array(root, links);
         oc_rep_end_root_object();
     } break;
@@ -64,6 +64,165 @@ oc_rep_reset(void)
     memset(&g_encoder, 0, sizeof(g_encoder));
 }
 
+/*
+ * Starts decoding the payload at payload_off. Returns 0 on success, the
+ * CborError from tinycbor otherwise.
+ */
+int
+oc_rep_cursor_init(struct oc_rep_cursor *cur, struct os_mbuf *m,
+                   uint16_t payload_off)
+{
+    cbor_mbuf_reader_init(&cur->orc_reader, m, payload_off);
+    return cbor_parser_init(&cur->orc_reader.r, 0, &cur->orc_parser,
+                            &cur->orc_root);
+}
+
+static int
+oc_rep_iter_enter(CborValue *container, struct oc_rep_iter *it, int map)
+{
+    memset(it, 0, sizeof(*it));
+    if (cbor_value_enter_container(container, &it->ori_val)) {
+        return -1;
+    }
+    it->ori_map = map;
+    return 0;
+}
+
+int
+oc_rep_cursor_map(struct oc_rep_cursor *cur, struct oc_rep_iter *it)
+{
+    if (!cbor_value_is_map(&cur->orc_root)) {
+        return -1;
+    }
+    return oc_rep_iter_enter(&cur->orc_root, it, 1);
+}
+
+int
+oc_rep_cursor_array(struct oc_rep_cursor *cur, struct oc_rep_iter *it)
+{
+    if (!cbor_value_is_array(&cur->orc_root)) {
+        return -1;
+    }
+    return oc_rep_iter_enter(&cur->orc_root, it, 0);
+}
+
+/*
+ * Moves to the next element. Returns 1 if there is one, 0 at the end of the
+ * container and -1 if the payload is malformed.
+ */
+int
+oc_rep_iter_next(struct oc_rep_iter *it)
+{
+    if (it->ori_started) {
+        if (cbor_value_advance(&it->ori_val)) {
+            return -1;
+        }
+    }
+    it->ori_started = 1;
+    if (cbor_value_at_end(&it->ori_val)) {
+        return 0;
+    }
+    if (it->ori_map) {
+        if (!cbor_value_is_text_string(&it->ori_val)) {
+            return -1;
+        }
+        it->ori_key = it->ori_val;
+        if (cbor_value_advance(&it->ori_val) ||
+            cbor_value_at_end(&it->ori_val)) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+bool
+oc_rep_iter_key_is(struct oc_rep_iter *it, const char *key)
+{
+    bool match;
+
+    if (!it->ori_map ||
+        cbor_value_text_string_equals(&it->ori_key, key, &match)) {
+        return false;
+    }
+    return match;
+}
+
+int
+oc_rep_iter_get_int(struct oc_rep_iter *it, int64_t *val)
+{
+    if (!cbor_value_is_integer(&it->ori_val) ||
+        cbor_value_get_int64(&it->ori_val, val)) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+oc_rep_iter_get_bool(struct oc_rep_iter *it, bool *val)
+{
+    if (!cbor_value_is_boolean(&it->ori_val) ||
+        cbor_value_get_boolean(&it->ori_val, val)) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+oc_rep_iter_get_double(struct oc_rep_iter *it, double *val)
+{
+    if (!cbor_value_is_double(&it->ori_val) ||
+        cbor_value_get_double(&it->ori_val, val)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Copies a text string, NUL terminated. On entry *len is the size of buf,
+ * on return the length of the string.
+ */
+int
+oc_rep_iter_get_text(struct oc_rep_iter *it, char *buf, size_t *len)
+{
+    if (!cbor_value_is_text_string(&it->ori_val) ||
+        cbor_value_copy_text_string(&it->ori_val, buf, len, NULL)) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+oc_rep_iter_get_bytes(struct oc_rep_iter *it, uint8_t *buf, size_t *len)
+{
+    if (!cbor_value_is_byte_string(&it->ori_val) ||
+        cbor_value_copy_byte_string(&it->ori_val, buf, len, NULL)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Iterate over a nested container. The parent iterator can be moved on
+ * without reaching the end of the child.
+ */
+int
+oc_rep_iter_enter_map(struct oc_rep_iter *it, struct oc_rep_iter *child)
+{
+    if (!cbor_value_is_map(&it->ori_val)) {
+        return -1;
+    }
+    return oc_rep_iter_enter(&it->ori_val, child, 1);
+}
+
+int
+oc_rep_iter_enter_array(struct oc_rep_iter *it, struct oc_rep_iter *child)
+{
+    if (!cbor_value_is_array(&it->ori_val)) {
+        return -1;
+    }
+    return oc_rep_iter_enter(&it->ori_val, child, 0);
+}
+
 #ifdef OC_CLIENT
 static oc_rep_t *
 _alloc_rep(void)
@@ -288,15 +447,14 @@ uint16_t
 oc_parse_rep(struct os_mbuf *m, uint16_t payload_off,
              uint16_t payload_size, oc_rep_t **out_rep)
 {
-  CborParser parser;
-  CborValue root_value, cur_value, map;
+  struct oc_rep_cursor cursor;
+  CborValue *root_value = &cursor.orc_root;
+  CborValue cur_value, map;
   CborError err = CborNoError;
-  struct cbor_mbuf_reader br;
 
-  cbor_mbuf_reader_init(&br, m, payload_off);
-  err |= cbor_parser_init(&br.r, 0, &parser, &root_value);
-  if (cbor_value_is_map(&root_value)) {
-    err |= cbor_value_enter_container(&root_value, &cur_value);
+  err |= oc_rep_cursor_init(&cursor, m, payload_off);
+  if (cbor_value_is_map(root_value)) {
+    err |= cbor_value_enter_container(root_value, &cur_value);
     *out_rep = 0;
     oc_rep_t **cur = out_rep;
     while (cbor_value_is_valid(&cur_value)) {
@@ -304,8 +462,8 @@ oc_parse_rep(struct os_mbuf *m, uint16_t payload_off,
       err |= cbor_value_advance(&cur_value);
       cur = &(*cur)->next;
     }
-  } else if (cbor_value_is_array(&root_value)) {
-    err |= cbor_value_enter_container(&root_value, &map);
+  } else if (cbor_value_is_array(root_value)) {
+    err |= cbor_value_enter_container(root_value, &map);
     err |= cbor_value_enter_container(&map, &cur_value);
     *out_rep = 0;
     oc_rep_t **cur = out_rep;
@@ -46,6 +46,8 @@
 #ifdef OC_SERVER
 static SLIST_HEAD(, oc_resource) oc_app_resources =
     SLIST_HEAD_INITIALIZER(&oc_app_resources);
+/* Application resources hashed by URI. */
+static SLIST_HEAD(, oc_resource) oc_app_resources_hash[APP_RESOURCES_HASH_SIZE];
 static struct os_mempool oc_resource_pool;
 static uint8_t oc_resource_area[OS_MEMPOOL_BYTES(MAX_APP_RESOURCES,
       sizeof(oc_resource_t))];
@@ -55,7 +57,9 @@ static void periodic_observe_handler(struct os_event *ev);
 
 #ifdef OC_CLIENT
 #include "oc_client_state.h"
-static SLIST_HEAD(, oc_client_cb) oc_client_cbs;
+/* Outstanding client requests, hashed by token and by MID. */
+static SLIST_HEAD(, oc_client_cb) oc_client_cbs[COAP_HASH_SIZE];
+static SLIST_HEAD(, oc_client_cb) oc_client_cbs_mid[COAP_HASH_SIZE];
 static struct os_mempool oc_client_cb_pool;
 static uint8_t oc_client_cb_area[OS_MEMPOOL_BYTES(MAX_NUM_CONCURRENT_REQUESTS,
       sizeof(oc_client_cb_t))];
@@ -191,19 +195,57 @@ stop_processes(void)
 }
 
 #ifdef OC_SERVER
-oc_resource_t *
-oc_ri_get_app_resource_by_uri(const char *uri)
+/*
+ * FNV-1a over the URI, without the leading '/'.
+ */
+static uint32_t
+oc_ri_uri_hash(const char *uri, int len)
+{
+    uint32_t hash = 2166136261UL;
+
+    if (len > 0 && uri[0] == '/') {
+        uri++;
+        len--;
+    }
+    while (len-- > 0) {
+        hash ^= (uint8_t)*uri++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/*
+ * Finds application resource by URI. uri does not need to be
+ * NUL-terminated, and the leading '/' is optional.
+ */
+static oc_resource_t *
+oc_ri_find_app_resource(const char *uri, int len)
 {
     oc_resource_t *res;
+    uint32_t hash;
 
-    SLIST_FOREACH(res, &oc_app_resources, next) {
-        if (oc_string_len(res->uri) == strlen(uri) &&
-          strncmp(uri, oc_string(res->uri), strlen(uri)) == 0)
+    hash = oc_ri_uri_hash(uri, len);
+    if (len > 0 && uri[0] == '/') {
+        uri++;
+        len--;
+    }
+    SLIST_FOREACH(res, &oc_app_resources_hash[hash &
+                                              (APP_RESOURCES_HASH_SIZE - 1)],
+                  hash_next) {
+        if (res->uri_hash == hash &&
+          oc_string_len(res->uri) == len + 1 &&
+          memcmp(uri, oc_string(res->uri) + 1, len) == 0) {
             return res;
+        }
     }
-
     return NULL;
 }
+
+oc_resource_t *
+oc_ri_get_app_resource_by_uri(const char *uri)
+{
+    return oc_ri_find_app_resource(uri, strlen(uri));
+}
 #endif
 
 void
@@ -225,7 +267,12 @@ void
 oc_ri_init(void)
 {
 #ifdef OC_CLIENT
-    SLIST_INIT(&oc_client_cbs);
+    int i;
+
+    for (i = 0; i < COAP_HASH_SIZE; i++) {
+        SLIST_INIT(&oc_client_cbs[i]);
+        SLIST_INIT(&oc_client_cbs_mid[i]);
+    }
 #endif
 
     start_processes();
@@ -237,6 +284,7 @@ oc_ri_shutdown(void)
 {
   oc_random_destroy();
   stop_processes();
+  oc_discovery_invalidate();
 }
 
 #ifdef OC_SERVER
@@ -261,10 +309,14 @@ oc_ri_delete_resource(oc_resource_t *resource)
     SLIST_FOREACH(tmp, &oc_app_resources, next) {
         if (tmp == resource) {
             SLIST_REMOVE(&oc_app_resources, tmp, oc_resource, next);
+            SLIST_REMOVE(&oc_app_resources_hash[resource->uri_hash &
+                                                (APP_RESOURCES_HASH_SIZE - 1)],
+                         tmp, oc_resource, hash_next);
             break;
         }
     }
     os_memblock_put(&oc_resource_pool, resource);
+    oc_discovery_invalidate();
 }
 
 bool
@@ -281,7 +333,13 @@ oc_ri_add_resource(oc_resource_t *resource)
         valid = false;
     }
     if (valid) {
+        resource->uri_hash = oc_ri_uri_hash(oc_string(resource->uri),
+                                            oc_string_len(resource->uri));
         SLIST_INSERT_HEAD(&oc_app_resources, resource, next);
+        SLIST_INSERT_HEAD(&oc_app_resources_hash[resource->uri_hash &
+                                                 (APP_RESOURCES_HASH_SIZE - 1)],
+                          resource, hash_next);
+        oc_discovery_invalidate();
     }
 
     return valid;
@@ -415,6 +473,7 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
   response_buffer.block_offset = offset;
   response_buffer.code = 0;
   response_buffer.response_length = 0;
+  response_buffer.block1_accepted = 0;
 
   response_obj.separate_response = 0;
   response_obj.response_buffer = &response_buffer;
@@ -474,14 +533,8 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
   /* Check against list of declared application resources.
    */
   if (!cur_resource && !bad_request) {
-      SLIST_FOREACH(resource, &oc_app_resources, next) {
-          if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-            strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-              uri_path_len) == 0) {
-              request_obj.resource = cur_resource = resource;
-              break;
-          }
-      }
+      request_obj.resource = cur_resource =
+        oc_ri_find_app_resource(uri_path, uri_path_len);
   }
 #endif
 
@@ -681,6 +734,19 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
      *  code.
      */
     coap_set_status_code(response, response_buffer.code);
+
+    if (response_buffer.block1_accepted) {
+      uint32_t block_num;
+      uint16_t block_size;
+      uint8_t more;
+
+      /* Acknowledge the block; ask for the next one if more follow. */
+      coap_get_header_block1(request, &block_num, &more, &block_size, NULL);
+      coap_set_header_block1(response, block_num, more, block_size);
+      if (more && response->code < BAD_REQUEST_4_00) {
+        coap_set_status_code(response, CONTINUE_2_31);
+      }
+    }
   }
   if (response_buffer.buffer) {
       os_mbuf_free_chain(response_buffer.buffer);
@@ -694,7 +760,10 @@ free_client_cb(oc_client_cb_t *cb)
 {
     os_callout_stop(&cb->callout);
     oc_free_string(&cb->uri);
-    SLIST_REMOVE(&oc_client_cbs, cb, oc_client_cb, next);
+    SLIST_REMOVE(&oc_client_cbs[coap_token_hash(cb->token, cb->token_len)],
+                 cb, oc_client_cb, next);
+    SLIST_REMOVE(&oc_client_cbs_mid[COAP_MID_HASH(cb->mid)], cb, oc_client_cb,
+                 mid_next);
     os_memblock_put(&oc_client_cb_pool, cb);
 }
 
@@ -703,7 +772,7 @@ oc_ri_remove_client_cb_by_mid(uint16_t mid)
 {
     oc_client_cb_t *cb;
 
-    SLIST_FOREACH(cb, &oc_client_cbs, next) {
+    SLIST_FOREACH(cb, &oc_client_cbs_mid[COAP_MID_HASH(mid)], mid_next) {
         if (cb->mid == mid) {
             break;
         }
@@ -755,7 +824,8 @@ oc_ri_invoke_client_cb(struct coap_packet_rx *rsp, oc_endpoint_t *endpoint)
     */
     coap_get_header_content_format(rsp, &content_format);
 
-    cb = SLIST_FIRST(&oc_client_cbs);
+    cb = SLIST_FIRST(&oc_client_cbs[coap_token_hash(rsp->token,
+                                                    rsp->token_len)]);
     while (cb != NULL) {
         tmp = SLIST_NEXT(cb, next);
         if (cb->token_len != rsp->token_len ||
@@ -844,14 +914,17 @@ oc_ri_get_client_cb(const char *uri, oc_server_handle_t *server,
                     oc_method_t method)
 {
     oc_client_cb_t *cb;
+    int i;
 
-    SLIST_FOREACH(cb, &oc_client_cbs, next) {
-        if (oc_string_len(cb->uri) == strlen(uri) &&
-          strncmp(oc_string(cb->uri), uri, strlen(uri)) == 0 &&
-          memcmp(&cb->server.endpoint, &server->endpoint,
-                 oc_endpoint_size(&cb->server.endpoint)) == 0 &&
-          cb->method == method) {
-            return cb;
+    for (i = 0; i < COAP_HASH_SIZE; i++) {
+        SLIST_FOREACH(cb, &oc_client_cbs[i], next) {
+            if (oc_string_len(cb->uri) == strlen(uri) &&
+              strncmp(oc_string(cb->uri), uri, strlen(uri)) == 0 &&
+              memcmp(&cb->server.endpoint, &server->endpoint,
+                     oc_endpoint_size(&cb->server.endpoint)) == 0 &&
+              cb->method == method) {
+                return cb;
+            }
         }
     }
 
@@ -898,7 +971,11 @@ oc_ri_alloc_client_cb(const char *uri, oc_server_handle_t *server,
 
     os_callout_init(&cb->callout, oc_evq_get(), oc_ri_remove_cb, cb);
 
-    SLIST_INSERT_HEAD(&oc_client_cbs, cb, next);
+    SLIST_INSERT_HEAD(&oc_client_cbs[coap_token_hash(cb->token,
+                                                     cb->token_len)],
+                      cb, next);
+    SLIST_INSERT_HEAD(&oc_client_cbs_mid[COAP_MID_HASH(cb->mid)], cb,
+                      mid_next);
     return cb;
 }
 #endif /* OC_CLIENT */
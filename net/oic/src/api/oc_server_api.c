@@ -24,6 +24,7 @@
 #include "oic/oc_api.h"
 #include "oic/oc_constants.h"
 #include "oic/oc_core_res.h"
+#include "oic/oc_discovery.h"
 
 extern int oc_stack_errno;
 // TODO:
@@ -82,6 +83,45 @@ oc_ignore_request(oc_request_t *request)
   request->response->response_buffer->code = OC_IGNORE;
 }
 
+bool
+oc_get_request_block1(oc_request_t *request, uint32_t *offset, bool *more)
+{
+  uint8_t m;
+
+  if (!coap_get_header_block1(request->packet, NULL, &m, NULL, offset)) {
+    return false;
+  }
+  *more = m != 0;
+  return true;
+}
+
+void
+oc_accept_request_block1(oc_request_t *request)
+{
+  request->response->response_buffer->block1_accepted = 1;
+}
+
+uint32_t
+oc_get_response_block_offset(oc_request_t *request)
+{
+  int32_t *offset = request->response->response_buffer->block_offset;
+
+  if (!offset || *offset < 0) {
+    return 0;
+  }
+  return *offset;
+}
+
+void
+oc_set_response_block_next(oc_request_t *request, int32_t next)
+{
+  int32_t *offset = request->response->response_buffer->block_offset;
+
+  if (offset) {
+    *offset = next;
+  }
+}
+
 void
 oc_process_baseline_interface(oc_resource_t *resource)
 {
@@ -113,6 +153,7 @@ oc_new_resource(const char *uri, uint8_t num_resource_types, int device)
   resource->observe_period_mseconds = 0;
   resource->properties = OC_ACTIVE;
   resource->num_observers = 0;
+  SLIST_INIT(&resource->observers);
   resource->device = device;
   return resource;
 }
@@ -201,6 +242,7 @@ void
 oc_deactivate_resource(oc_resource_t *resource)
 {
   resource->properties ^= OC_ACTIVE;
+  oc_discovery_invalidate();
 }
 
 void
@@ -87,7 +87,7 @@ coap_parse_int_option(struct os_mbuf *m, uint16_t off, size_t length)
     uint32_t var = 0;
     int i = 0;
 
-    if (length >= 4) {
+    if (length > 4) {
         return -1;
     }
     if (os_mbuf_copydata(m, off, length, bytes)) {
@@ -238,32 +238,75 @@ coap_append_array_opt(struct os_mbuf *m,
 /*---------------------------------------------------------------------------*/
 
 static void
-coap_merge_multi_option(struct os_mbuf *m, uint16_t *off1, uint16_t *len1,
-                        uint16_t off2, uint16_t len2, char separator)
+coap_parse_block_option(struct os_mbuf *m, struct coap_opt_ref *ref,
+                        uint32_t *num, uint8_t *more, uint16_t *size,
+                        uint32_t *offset)
 {
-    uint8_t tmp[4];
-    int i;
-    int blk;
-
-    /* merge multiple options */
-    if (*len1 > 0) {
-        /* dst already contains an option: concatenate */
-        os_mbuf_copyinto(m, *off1 + *len1, &separator, 1);
-        *len1 += 1;
-
-        for (i = 0; i < len2; i += blk) {
-            blk = min(sizeof(tmp), len2 - i);
-            os_mbuf_copydata(m, off2 + i, blk, tmp);
-            os_mbuf_copyinto(m, *off1 + *len1 + i, tmp, blk);
-        }
+    uint32_t val;
 
-        *len1 += len2;
-    } else {
-        /* off1 is empty: set to off2 */
-        *off1 = off2;
-        *len1 = len2;
+    val = coap_parse_int_option(m, ref->off, ref->len);
+
+    /* pointers may be NULL to get only specific block parameters */
+    if (num != NULL) {
+        *num = val >> 4;
+    }
+    if (more != NULL) {
+        *more = (val & 0x08) >> 3;
+    }
+    if (size != NULL) {
+        *size = 16 << (val & 0x07);
+    }
+    if (offset != NULL) {
+        *offset = (val & ~0x0000000F) << (val & 0x07);
     }
 }
+/*---------------------------------------------------------------------------*/
+/*
+ * Copies a repeatable option (Uri-Path, Uri-Query) into buf, joining the
+ * segments with separator. ref points to the first segment; the rest follow
+ * it in the mbuf with option delta 0.
+ */
+static int
+coap_get_multi_option(struct os_mbuf *m, struct coap_opt_ref *ref,
+                      char separator, char *buf, int maxlen)
+{
+    uint8_t tmp[2];
+    uint16_t off;
+    uint16_t len;
+    int blen;
+
+    blen = min(maxlen, ref->len);
+    os_mbuf_copydata(m, ref->off, blen, buf);
+
+    off = ref->off + ref->len;
+    while (blen < maxlen) {
+        /* stops on next option number, payload marker or end of packet */
+        if (os_mbuf_copydata(m, off, 1, tmp) || (tmp[0] & 0xF0) != 0) {
+            break;
+        }
+        len = tmp[0] & 0x0F;
+        ++off;
+        if (len == 13) {
+            if (os_mbuf_copydata(m, off, 1, tmp)) {
+                break;
+            }
+            len += tmp[0];
+            ++off;
+        } else if (len == 14) {
+            if (os_mbuf_copydata(m, off, 2, tmp)) {
+                break;
+            }
+            len += (255 + (tmp[0] << 8) + tmp[1]);
+            off += 2;
+        }
+        buf[blen++] = separator;
+        len = min(maxlen - blen, len);
+        os_mbuf_copydata(m, off, len, buf + blen);
+        blen += len;
+        off += len;
+    }
+    return blen;
+}
 
 /*---------------------------------------------------------------------------*/
 #if 0
@@ -548,6 +591,12 @@ coap_tcp_msg_size(uint8_t *hdr, int datalen)
 }
 
 /*---------------------------------------------------------------------------*/
+#define COAP_RX_OPT_SET(ref, o, l)                                      \
+    do {                                                                \
+        (ref)->off = (o);                                               \
+        (ref)->len = (l);                                               \
+    } while (0)
+
 coap_status_t
 coap_parse_message(struct coap_packet_rx *pkt, struct os_mbuf **mp)
 {
@@ -577,20 +626,9 @@ coap_parse_message(struct coap_packet_rx *pkt, struct os_mbuf **mp)
     is_tcp = oc_endpoint_use_tcp(OC_MBUF_ENDPOINT(m));
 
     /*
-     * Make sure that the header is in contiguous area of memory.
+     * Header fields are copied out of the chain as they are parsed, so
+     * it does not need to be contiguous.
      */
-    opt_len = sizeof(struct coap_tcp_hdr32);
-    if (opt_len > OS_MBUF_PKTLEN(m)) {
-        opt_len = OS_MBUF_PKTLEN(m);
-    }
-    if (m->om_len < opt_len) {
-        m = os_mbuf_pullup(m, opt_len);
-        *mp = m;
-        if (!m) {
-            STATS_INC(coap_stats, imem);
-            return INTERNAL_SERVER_ERROR_5_00;
-        }
-    }
     pkt->m = m;
 
     /* parse header fields */
@@ -626,9 +664,6 @@ err_short:
 
         if (data_len < 13) {
             cur_opt = sizeof(cth.c0);
-            if (m->om_len < cur_opt) {
-                goto err_short;
-            }
             pkt->token_len = cth.c0.token_len;
             pkt->code = cth.c0.code;
         } else if (data_len == 13) {
@@ -726,152 +761,48 @@ err_short:
         opt_num += opt_delta;
 
         if (opt_num < COAP_OPTION_SIZE1) {
-            OC_LOG(DEBUG, "OPTION %u (delta %u, len %zu): ",
+            OC_LOG(DEBUG, "OPTION %u (delta %u, len %zu)\n",
                          opt_num, opt_delta, opt_len);
             SET_OPTION(pkt, opt_num);
         }
 
+        /*
+         * Only record where the value is; coap_get_header_*() decodes it.
+         */
         switch (opt_num) {
         case COAP_OPTION_CONTENT_FORMAT:
-            pkt->content_format = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Content-Format [%u]\n", pkt->content_format);
+            COAP_RX_OPT_SET(&pkt->content_format, cur_opt, opt_len);
             break;
         case COAP_OPTION_MAX_AGE:
-            pkt->max_age = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Max-Age [%lu]\n", (unsigned long)pkt->max_age);
+            COAP_RX_OPT_SET(&pkt->max_age, cur_opt, opt_len);
             break;
-#if 0
-        case COAP_OPTION_ETAG:
-            pkt->etag_len = MIN(COAP_ETAG_LEN, opt_len);
-            if (os_mbuf_copydata(m, cur_opt, pkt->etag_len, pkt->etag)) {
-                goto err_short;
-            }
-            OC_LOG(DEBUG, "ETag %u ");
-            OC_LOG_HEX(LOG_LEVEL_DEBUG, pkt->etag, pkt->etag_len);
-            break;
-#endif
         case COAP_OPTION_ACCEPT:
-            pkt->accept = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Accept [%u]\n", pkt->accept);
-            break;
-#if 0
-        case COAP_OPTION_IF_MATCH:
-            /* TODO support multiple ETags */
-            pkt->if_match_len = MIN(COAP_ETAG_LEN, opt_len);
-            if (os_mbuf_copydata(m, cur_opt, pkt->if_match_len,
-                                 pkt->if_match)) {
-                goto err_short;
-            }
-            OC_LOG(DEBUG, "If-Match %u ");
-            OC_LOG_HEX(LOG_LEVEL_DEBUG, pkt->if_match, pkt->if_match_len);
-            break;
-        case COAP_OPTION_IF_NONE_MATCH:
-            pkt->if_none_match = 1;
-            OC_LOG(DEBUG, "If-None-Match\n");
-            break;
-
-        case COAP_OPTION_PROXY_URI:
-#if COAP_PROXY_OPTION_PROCESSING
-            pkt->proxy_uri_off = cur_opt;
-            pkt->proxy_uri_len = opt_len;
-#endif
-            OC_LOG(DEBUG, "Proxy-Uri NOT IMPLEMENTED\n");
-            coap_error_message =
-              "This is a constrained server (MyNewt)";
-            STATS_INC(coap_stats, ierr);
-            return PROXYING_NOT_SUPPORTED_5_05;
-            break;
-        case COAP_OPTION_PROXY_SCHEME:
-#if COAP_PROXY_OPTION_PROCESSING
-            pkt->proxy_scheme_off = cur_opt;
-            pkt->proxy_scheme_len = opt_len;
-#endif
-            OC_LOG(DEBUG, "Proxy-Scheme NOT IMPLEMENTED\n");
-            coap_error_message =
-              "This is a constrained server (MyNewt)";
-            STATS_INC(coap_stats, ierr);
-            return PROXYING_NOT_SUPPORTED_5_05;
-            break;
-
-        case COAP_OPTION_URI_HOST:
-            pkt->uri_host_off = cur_opt;
-            pkt->uri_host_len = opt_len;
-            OC_LOG(DEBUG, "Uri-Host ");
-            OC_LOG_STR_MBUF(LOG_LEVEL_DEBUG, m, pkt->uri_host_off,
-                            pkt->uri_host_len);
+            COAP_RX_OPT_SET(&pkt->accept, cur_opt, opt_len);
             break;
-        case COAP_OPTION_URI_PORT:
-            pkt->uri_port = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Uri-Port [%u]\n", pkt->uri_port);
-            break;
-#endif
         case COAP_OPTION_URI_PATH:
-            /* coap_merge_multi_option() operates in-place on the buf */
-            coap_merge_multi_option(m, &pkt->uri_path_off, &pkt->uri_path_len,
-                                    cur_opt, opt_len, '/');
-            OC_LOG(DEBUG, "Uri-Path ");
-            OC_LOG_STR_MBUF(LOG_LEVEL_DEBUG, m, pkt->uri_path_off,
-                            pkt->uri_path_len);
+            if (!pkt->uri_path.off) {
+                COAP_RX_OPT_SET(&pkt->uri_path, cur_opt, opt_len);
+            }
             break;
         case COAP_OPTION_URI_QUERY:
-            /* coap_merge_multi_option() operates in-place on the mbuf */
-            coap_merge_multi_option(m, &pkt->uri_query_off, &pkt->uri_query_len,
-                                    cur_opt, opt_len, '&');
-            OC_LOG(DEBUG, "Uri-Query ");
-            OC_LOG_STR_MBUF(LOG_LEVEL_DEBUG, m, pkt->uri_query_off,
-                            pkt->uri_query_len);
-            break;
-#if 0
-        case COAP_OPTION_LOCATION_PATH:
-            /* coap_merge_multi_option() operates in-place on the mbuf */
-            coap_merge_multi_option(m, &pkt->loc_path_off, &pkt->loc_path_len,
-                                    cur_opt, opt_len, '/');
-            OC_LOG(DEBUG, "Location-Path ");
-            OC_LOG_STR_MBUF(LOG_LEVEL_DEBUG, m, pkt->loc_path,
-                            pkt->loc_path_len);
-            break;
-        case COAP_OPTION_LOCATION_QUERY:
-            /* coap_merge_multi_option() operates in-place on the mbuf */
-            coap_merge_multi_option(m, &pkt->loc_query_off, &pkt->loc_query_len,
-                                    cur_opt, opt_len, '&');
-            OC_LOG(DEBUG, "Location-Query ");
-            OC_LOG_STR_MBUF(LOG_LEVEL_DEBUG, m, pkt->loc_query_off,
-                            pkt->loc_query_len);
+            if (!pkt->uri_query.off) {
+                COAP_RX_OPT_SET(&pkt->uri_query, cur_opt, opt_len);
+            }
             break;
-#endif
         case COAP_OPTION_OBSERVE:
-            pkt->observe = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Observe [%lu]\n", (unsigned long)pkt->observe);
+            COAP_RX_OPT_SET(&pkt->observe, cur_opt, opt_len);
             break;
         case COAP_OPTION_BLOCK2:
-            pkt->block2_num = coap_parse_int_option(m, cur_opt, opt_len);
-            pkt->block2_more = (pkt->block2_num & 0x08) >> 3;
-            pkt->block2_size = 16 << (pkt->block2_num & 0x07);
-            pkt->block2_offset =
-              (pkt->block2_num & ~0x0000000F) << (pkt->block2_num & 0x07);
-            pkt->block2_num >>= 4;
-            OC_LOG(DEBUG, "Block2 [%lu%s (%u B/blk)]\n",
-                         (unsigned long)pkt->block2_num,
-                         pkt->block2_more ? "+" : "", pkt->block2_size);
+            COAP_RX_OPT_SET(&pkt->block2, cur_opt, opt_len);
             break;
         case COAP_OPTION_BLOCK1:
-            pkt->block1_num = coap_parse_int_option(m, cur_opt, opt_len);
-            pkt->block1_more = (pkt->block1_num & 0x08) >> 3;
-            pkt->block1_size = 16 << (pkt->block1_num & 0x07);
-            pkt->block1_offset =
-              (pkt->block1_num & ~0x0000000F) << (pkt->block1_num & 0x07);
-            pkt->block1_num >>= 4;
-            OC_LOG(DEBUG, "Block1 [%lu%s (%u B/blk)]\n",
-                         (unsigned long)pkt->block1_num,
-                         pkt->block1_more ? "+" : "", pkt->block1_size);
+            COAP_RX_OPT_SET(&pkt->block1, cur_opt, opt_len);
             break;
         case COAP_OPTION_SIZE2:
-            pkt->size2 = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Size2 [%lu]\n", (unsigned long)pkt->size2);
+            COAP_RX_OPT_SET(&pkt->size2, cur_opt, opt_len);
             break;
         case COAP_OPTION_SIZE1:
-            pkt->size1 = coap_parse_int_option(m, cur_opt, opt_len);
-            OC_LOG(DEBUG, "Size1 [%lu]\n", (unsigned long)pkt->size1);
+            COAP_RX_OPT_SET(&pkt->size1, cur_opt, opt_len);
             break;
         default:
             OC_LOG(DEBUG, "unknown (%u)\n", opt_num);
@@ -937,7 +868,8 @@ coap_get_header_content_format(struct coap_packet_rx *pkt, unsigned int *format)
     if (!IS_OPTION(pkt, COAP_OPTION_CONTENT_FORMAT)) {
         return 0;
     }
-    *format = pkt->content_format;
+    *format = coap_parse_int_option(pkt->m, pkt->content_format.off,
+                                    pkt->content_format.len);
     return 1;
 }
 #endif
@@ -956,7 +888,7 @@ coap_get_header_accept(struct coap_packet_rx *pkt, unsigned int *accept)
     if (!IS_OPTION(pkt, COAP_OPTION_ACCEPT)) {
         return 0;
     }
-    *accept = pkt->accept;
+    *accept = coap_parse_int_option(pkt->m, pkt->accept.off, pkt->accept.len);
     return 1;
 }
 #endif
@@ -978,7 +910,8 @@ coap_get_header_max_age(struct coap_packet_rx *pkt, uint32_t *age)
     if (!IS_OPTION(pkt, COAP_OPTION_MAX_AGE)) {
         *age = COAP_DEFAULT_MAX_AGE;
     } else {
-        *age = pkt->max_age;
+        *age = coap_parse_int_option(pkt->m, pkt->max_age.off,
+                                     pkt->max_age.len);
     }
     return 1;
 }
@@ -1099,9 +1032,7 @@ coap_get_header_uri_path(struct coap_packet_rx *pkt, char *path, int maxlen)
     if (!IS_OPTION(pkt, COAP_OPTION_URI_PATH)) {
         return 0;
     }
-    maxlen = min(maxlen, pkt->uri_path_len);
-    os_mbuf_copydata(pkt->m, pkt->uri_path_off, maxlen, path);
-    return maxlen;
+    return coap_get_multi_option(pkt->m, &pkt->uri_path, '/', path, maxlen);
 }
 #ifdef OC_CLIENT
 int
@@ -1124,9 +1055,7 @@ coap_get_header_uri_query(struct coap_packet_rx *pkt, char *query, int maxlen)
     if (!IS_OPTION(pkt, COAP_OPTION_URI_QUERY)) {
         return 0;
     }
-    maxlen = min(maxlen, pkt->uri_query_len);
-    os_mbuf_copydata(pkt->m, pkt->uri_query_off, maxlen, query);
-    return maxlen;
+    return coap_get_multi_option(pkt->m, &pkt->uri_query, '&', query, maxlen);
 }
 #ifdef OC_CLIENT
 int
@@ -1208,7 +1137,8 @@ coap_get_header_observe(struct coap_packet_rx *pkt, uint32_t *observe)
     if (!IS_OPTION(pkt, COAP_OPTION_OBSERVE)) {
         return 0;
     }
-    *observe = pkt->observe;
+    *observe = coap_parse_int_option(pkt->m, pkt->observe.off,
+                                     pkt->observe.len);
     return 1;
 }
 
@@ -1228,19 +1158,7 @@ coap_get_header_block2(struct coap_packet_rx *pkt, uint32_t *num,
     if (!IS_OPTION(pkt, COAP_OPTION_BLOCK2)) {
         return 0;
     }
-    /* pointers may be NULL to get only specific block parameters */
-    if (num != NULL) {
-        *num = pkt->block2_num;
-    }
-    if (more != NULL) {
-        *more = pkt->block2_more;
-    }
-    if (size != NULL) {
-        *size = pkt->block2_size;
-    }
-    if (offset != NULL) {
-        *offset = pkt->block2_offset;
-    }
+    coap_parse_block_option(pkt->m, &pkt->block2, num, more, size, offset);
     return 1;
 }
 
@@ -1272,19 +1190,7 @@ coap_get_header_block1(struct coap_packet_rx *pkt, uint32_t *num, uint8_t *more,
     if (!IS_OPTION(pkt, COAP_OPTION_BLOCK1)) {
         return 0;
     }
-    /* pointers may be NULL to get only specific block parameters */
-    if (num != NULL) {
-        *num = pkt->block1_num;
-    }
-    if (more != NULL) {
-        *more = pkt->block1_more;
-    }
-    if (size != NULL) {
-        *size = pkt->block1_size;
-    }
-    if (offset != NULL) {
-        *offset = pkt->block1_offset;
-    }
+    coap_parse_block_option(pkt->m, &pkt->block1, num, more, size, offset);
     return 1;
 }
 
@@ -1315,7 +1221,7 @@ int coap_get_header_size2(struct coap_packet_rx * const pkt, uint32_t *size)
     if (!IS_OPTION(pkt, COAP_OPTION_SIZE2)) {
         return 0;
     }
-    *size = pkt->size2;
+    *size = coap_parse_int_option(pkt->m, pkt->size2.off, pkt->size2.len);
     return 1;
 }
 
@@ -1333,7 +1239,7 @@ coap_get_header_size1(struct coap_packet_rx *pkt, uint32_t *size)
     if (!IS_OPTION(pkt, COAP_OPTION_SIZE1)) {
         return 0;
     }
-    *size = pkt->size1;
+    *size = coap_parse_int_option(pkt->m, pkt->size1.off, pkt->size1.len);
     return 1;
 }
 int
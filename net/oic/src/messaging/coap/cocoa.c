@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OC_COAP_COCOA)
+
+#include "oic/messaging/coap/cocoa.h"
+#include "oic/messaging/coap/transactions.h"
+
+#define COCOA_RTO_DFLT          COAP_RESPONSE_TIMEOUT_TICKS
+#define COCOA_RTO_MIN           (OS_TICKS_PER_SEC / 10)
+#define COCOA_RTO_MAX           (OS_TICKS_PER_SEC * 60)
+#define COCOA_RTO_SMALL         (OS_TICKS_PER_SEC * 1)
+#define COCOA_RTO_LARGE         (OS_TICKS_PER_SEC * 3)
+
+/* RTO multipliers of the strong and weak estimators (K in RFC 6298). */
+#define COCOA_K_STRONG          4
+#define COCOA_K_WEAK            1
+
+static struct coap_cocoa_ep coap_cocoa_eps[MYNEWT_VAL(OC_COAP_COCOA_ENDPOINTS)];
+
+struct coap_cocoa_ep *
+coap_cocoa_get(oc_endpoint_t *ep)
+{
+    struct coap_cocoa_ep *ce;
+    struct coap_cocoa_ep *victim;
+    int i;
+
+    victim = NULL;
+    for (i = 0; i < MYNEWT_VAL(OC_COAP_COCOA_ENDPOINTS); i++) {
+        ce = &coap_cocoa_eps[i];
+        if (!ce->ce_in_use) {
+            if (!victim || victim->ce_in_use) {
+                victim = ce;
+            }
+            continue;
+        }
+        if (memcmp(&ce->ce_ep, ep, oc_endpoint_size(ep)) == 0) {
+            return ce;
+        }
+        /* Replace the least recently used idle peer. */
+        if (ce->ce_outstanding == 0 && STAILQ_EMPTY(&ce->ce_pending) &&
+          (!victim || (victim->ce_in_use &&
+                       OS_TIME_TICK_LT(ce->ce_used, victim->ce_used)))) {
+            victim = ce;
+        }
+    }
+    if (!victim) {
+        return NULL;
+    }
+
+    memset(victim, 0, sizeof(*victim));
+    memcpy(&victim->ce_ep, ep, oc_endpoint_size(ep));
+    victim->ce_rto = COCOA_RTO_DFLT;
+    victim->ce_updated = os_time_get();
+    victim->ce_used = victim->ce_updated;
+    victim->ce_in_use = 1;
+    STAILQ_INIT(&victim->ce_pending);
+
+    return victim;
+}
+
+uint32_t
+coap_cocoa_rto(struct coap_cocoa_ep *ce)
+{
+    os_time_t now;
+    uint32_t age;
+
+    now = os_time_get();
+    age = now - ce->ce_updated;
+
+    /*
+     * An RTO that has not been confirmed for a while is moved back towards
+     * the default: small ones are doubled after 16 RTOs, large ones halved
+     * towards the default after 4.
+     */
+    if (ce->ce_rto < COCOA_RTO_SMALL && age > 16 * ce->ce_rto) {
+        ce->ce_rto *= 2;
+        ce->ce_updated = now;
+    } else if (ce->ce_rto > COCOA_RTO_LARGE && age > 4 * ce->ce_rto) {
+        ce->ce_rto = (ce->ce_rto + COCOA_RTO_DFLT) / 2;
+        ce->ce_updated = now;
+    }
+    ce->ce_used = now;
+
+    return ce->ce_rto;
+}
+
+uint32_t
+coap_cocoa_backoff(uint32_t tmo)
+{
+    if (tmo < COCOA_RTO_SMALL) {
+        tmo *= 3;
+    } else if (tmo > COCOA_RTO_LARGE) {
+        tmo += tmo / 2;
+    } else {
+        tmo *= 2;
+    }
+    if (tmo > COCOA_RTO_MAX) {
+        tmo = COCOA_RTO_MAX;
+    }
+    return tmo;
+}
+
+/*
+ * RFC 6298 estimator, returning the RTO estimate it yields.
+ */
+static uint32_t
+coap_cocoa_estimate(uint32_t *srtt, uint32_t *rttvar, uint32_t cnt,
+                    uint32_t rtt, int k)
+{
+    uint32_t diff;
+
+    if (cnt == 0) {
+        *srtt = rtt;
+        *rttvar = rtt / 2;
+    } else {
+        diff = (*srtt > rtt) ? *srtt - rtt : rtt - *srtt;
+        *rttvar = (3 * *rttvar + diff) / 4;
+        *srtt = (7 * *srtt + rtt) / 8;
+    }
+    return *srtt + k * *rttvar;
+}
+
+void
+coap_cocoa_sample(struct coap_cocoa_ep *ce, uint32_t rtt, int retrans)
+{
+    uint32_t est;
+
+    if (retrans == 0) {
+        est = coap_cocoa_estimate(&ce->ce_strong_srtt, &ce->ce_strong_rttvar,
+                                  ce->ce_strong_cnt++, rtt, COCOA_K_STRONG);
+        ce->ce_rto = (ce->ce_rto + est) / 2;
+    } else if (retrans <= 2) {
+        est = coap_cocoa_estimate(&ce->ce_weak_srtt, &ce->ce_weak_rttvar,
+                                  ce->ce_weak_cnt++, rtt, COCOA_K_WEAK);
+        ce->ce_rto = (3 * ce->ce_rto + est) / 4;
+    } else {
+        /* Too ambiguous to tell which transmission was answered. */
+        return;
+    }
+
+    if (ce->ce_rto < COCOA_RTO_MIN) {
+        ce->ce_rto = COCOA_RTO_MIN;
+    } else if (ce->ce_rto > COCOA_RTO_MAX) {
+        ce->ce_rto = COCOA_RTO_MAX;
+    }
+    ce->ce_updated = os_time_get();
+}
+
+int
+coap_cocoa_stats_get(int idx, struct coap_cocoa_stats *stats)
+{
+    struct coap_cocoa_ep *ce;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(OC_COAP_COCOA_ENDPOINTS); i++) {
+        ce = &coap_cocoa_eps[i];
+        if (!ce->ce_in_use || idx-- > 0) {
+            continue;
+        }
+        memcpy(&stats->ep, &ce->ce_ep, sizeof(stats->ep));
+        stats->rto = os_time_ticks_to_ms32(ce->ce_rto);
+        stats->strong_srtt = os_time_ticks_to_ms32(ce->ce_strong_srtt);
+        stats->strong_rttvar = os_time_ticks_to_ms32(ce->ce_strong_rttvar);
+        stats->weak_srtt = os_time_ticks_to_ms32(ce->ce_weak_srtt);
+        stats->weak_rttvar = os_time_ticks_to_ms32(ce->ce_weak_rttvar);
+        stats->strong_cnt = ce->ce_strong_cnt;
+        stats->weak_cnt = ce->ce_weak_cnt;
+        stats->outstanding = ce->ce_outstanding;
+        return 0;
+    }
+    return SYS_ENOENT;
+}
+
+#endif /* MYNEWT_VAL(OC_COAP_COCOA) */
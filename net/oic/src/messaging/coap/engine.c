@@ -192,6 +192,8 @@ coap_receive(struct os_mbuf **mp)
                             coap_set_header_block2(response, block_num,
                                          response->payload_len - block_offset >
                                            block_size, block_size);
+                            /* skip the blocks already transferred */
+                            os_mbuf_adj(response->payload_m, block_offset);
                             response->payload_len = MIN(response->payload_len -
                                                         block_offset,
                                                         block_size);
@@ -220,6 +222,16 @@ coap_receive(struct os_mbuf **mp)
                                            COAP_MAX_BLOCK_SIZE);
                     response->payload_len = MIN(response->payload_len,
                                                 COAP_MAX_BLOCK_SIZE);
+#if MYNEWT_VAL(OC_BLOCK2_AUTO)
+                    /* Response too large for one block */
+                } else if (response->payload_len > COAP_MAX_BLOCK_SIZE) {
+                    OC_LOG(DEBUG, " block: response %u B, sending block 0\n",
+                                 response->payload_len);
+
+                    coap_set_header_block2(response, 0, 1,
+                                           COAP_MAX_BLOCK_SIZE);
+                    response->payload_len = COAP_MAX_BLOCK_SIZE;
+#endif
                 } /* blockwise transfer handling */
             }   /* no errors/hooks */
             /* successful service callback */
@@ -246,7 +258,7 @@ coap_receive(struct os_mbuf **mp)
 
         /* Open transaction now cleared for ACK since mid matches */
         if ((transaction = coap_get_transaction_by_mid(message->mid))) {
-            coap_clear_transaction(transaction);
+            coap_ack_transaction(transaction);
         }
         /* if(ACKed transaction) */
         transaction = NULL;
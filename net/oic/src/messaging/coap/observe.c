@@ -49,6 +49,9 @@
 uint64_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
 static SLIST_HEAD(, coap_observer) oc_observers;
+/* The same observers, hashed by token and by the MID of the last notify. */
+static SLIST_HEAD(, coap_observer) oc_observers_tok[COAP_HASH_SIZE];
+static SLIST_HEAD(, coap_observer) oc_observers_mid[COAP_HASH_SIZE];
 
 static struct os_mempool coap_observer_pool;
 static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
@@ -85,11 +88,26 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
           coap_observer_pool.mp_num_blocks - coap_observer_pool.mp_num_free,
           coap_observer_pool.mp_num_blocks, o->url, o->token[0], o->token[1]);
         SLIST_INSERT_HEAD(&oc_observers, o, next);
+        SLIST_INSERT_HEAD(&resource->observers, o, res_next);
+        SLIST_INSERT_HEAD(&oc_observers_tok[coap_token_hash(o->token,
+                                                            o->token_len)],
+                          o, tok_next);
+        SLIST_INSERT_HEAD(&oc_observers_mid[COAP_MID_HASH(o->last_mid)], o,
+                          mid_next);
         return dup;
     }
     return -1;
 }
 /*---------------------------------------------------------------------------*/
+static void
+coap_observer_set_mid(coap_observer_t *o, uint16_t mid)
+{
+    SLIST_REMOVE(&oc_observers_mid[COAP_MID_HASH(o->last_mid)], o,
+                 coap_observer, mid_next);
+    o->last_mid = mid;
+    SLIST_INSERT_HEAD(&oc_observers_mid[COAP_MID_HASH(mid)], o, mid_next);
+}
+/*---------------------------------------------------------------------------*/
 /*- Removal -----------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 void
@@ -98,6 +116,11 @@ coap_remove_observer(coap_observer_t *o)
     OC_LOG(DEBUG, "Removing observer for /%s [0x%02X%02X]\n",
                  o->url, o->token[0], o->token[1]);
     SLIST_REMOVE(&oc_observers, o, coap_observer, next);
+    SLIST_REMOVE(&o->resource->observers, o, coap_observer, res_next);
+    SLIST_REMOVE(&oc_observers_tok[coap_token_hash(o->token, o->token_len)],
+                 o, coap_observer, tok_next);
+    SLIST_REMOVE(&oc_observers_mid[COAP_MID_HASH(o->last_mid)], o,
+                 coap_observer, mid_next);
     os_memblock_put(&coap_observer_pool, o);
 }
 /*---------------------------------------------------------------------------*/
@@ -127,9 +150,9 @@ coap_remove_observer_by_token(oc_endpoint_t *endpoint, uint8_t *token,
     int removed = 0;
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = SLIST_FIRST(&oc_observers_tok[coap_token_hash(token, token_len)]);
     while (obs) {
-        next = SLIST_NEXT(obs, next);
+        next = SLIST_NEXT(obs, tok_next);
         if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
           obs->token_len == token_len &&
           memcmp(obs->token, token, token_len) == 0) {
@@ -170,9 +193,9 @@ coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
     int removed = 0;
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = SLIST_FIRST(&oc_observers_mid[COAP_MID_HASH(mid)]);
     while (obs) {
-        next = SLIST_NEXT(obs, next);
+        next = SLIST_NEXT(obs, mid_next);
         if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
           obs->last_mid == mid) {
             obs->resource->num_observers--;
@@ -187,6 +210,57 @@ coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*
+ * Sends one notification.  The representation in response_buf was encoded
+ * once for the whole notification cycle; only the header, token and observe
+ * sequence are specific to this observer.  The payload is duplicated into
+ * the transaction, which keeps it for retransmission.
+ */
+static void
+coap_notify_observer(coap_observer_t *obs, oc_response_buffer_t *response_buf)
+{
+    coap_transaction_t *transaction;
+    coap_packet_t notification[1];
+
+    transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint);
+    if (!transaction) {
+        return;
+    }
+
+    /* update last MID for RST matching */
+    coap_observer_set_mid(obs, transaction->mid);
+
+    /* build notification */
+    coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
+
+    notification->mid = transaction->mid;
+    if (!oc_endpoint_use_tcp(&obs->endpoint) &&
+        obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0) {
+        OC_LOG(DEBUG, "coap_observe_notify: forcing CON "
+                     "notification to check for client liveness\n");
+        notification->type = COAP_TYPE_CON;
+    }
+    coap_set_payload(notification, response_buf->buffer,
+                     OS_MBUF_PKTLEN(response_buf->buffer));
+    coap_set_status_code(notification, response_buf->code);
+    coap_set_header_content_format(notification, APPLICATION_CBOR);
+    if (notification->code < BAD_REQUEST_4_00 &&
+      obs->resource->num_observers) {
+        coap_set_header_observe(notification, (obs->obs_counter)++);
+        observe_counter++;
+    } else {
+        coap_set_header_observe(notification, 1);
+    }
+    coap_set_token(notification, obs->token, obs->token_len);
+
+    if (!coap_serialize_message(notification, transaction->m)) {
+        transaction->type = notification->type;
+        coap_send_transaction(transaction);
+    } else {
+        coap_clear_transaction(transaction);
+    }
+}
+/*---------------------------------------------------------------------------*/
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
@@ -197,6 +271,8 @@ coap_notify_observers(oc_resource_t *resource,
     oc_response_t response = {};
     oc_response_buffer_t response_buffer;
     struct os_mbuf *m = NULL;
+    coap_observer_t *obs;
+    coap_observer_t *next;
 
     if (resource) {
         if (!resource->num_observers) {
@@ -208,7 +284,7 @@ coap_notify_observers(oc_resource_t *resource,
     response.separate_response = 0;
     if (!response_buf && resource) {
         OC_LOG(DEBUG, "coap_notify_observers: Issue GET request to resource\n");
-        /* performing GET on the resource */
+        /* performing GET on the resource, once for all of its observers */
         m = os_msys_get_pkthdr(0, 0);
         if (!m) {
             /* XXX count */
@@ -229,13 +305,25 @@ coap_notify_observers(oc_resource_t *resource,
         }
     }
 
-    coap_observer_t *obs = NULL;
-    /* iterate over observers */
-    for (obs = SLIST_FIRST(&oc_observers); obs; obs = SLIST_NEXT(obs, next)) {
-        /* skip if neither resource nor endpoint match */
-        if ((resource && resource != obs->resource) ||
-            (endpoint && memcmp(&obs->endpoint, endpoint,
-                                oc_endpoint_size(endpoint)) != 0)) {
+    /*
+     * Only a resource's own observers need to be looked at; notifications
+     * for an endpoint (separate responses) walk the whole list.
+     */
+    if (resource) {
+        obs = SLIST_FIRST(&resource->observers);
+    } else {
+        obs = SLIST_FIRST(&oc_observers);
+    }
+    for (; obs; obs = next) {
+        if (resource) {
+            next = SLIST_NEXT(obs, res_next);
+        } else {
+            next = SLIST_NEXT(obs, next);
+        }
+
+        /* skip if endpoint does not match */
+        if (endpoint && memcmp(&obs->endpoint, endpoint,
+                               oc_endpoint_size(endpoint)) != 0) {
             continue;
         }
 
@@ -245,10 +333,8 @@ coap_notify_observers(oc_resource_t *resource,
           response_buf->code == oc_status_code(OC_STATUS_OK)) {
             struct coap_packet_rx req[1];
 
-            req->block1_num = 0;
-            req->block1_size = 0;
-            req->block2_num = 0;
-            req->block2_size = 0;
+            /* no options, no block-wise transfer */
+            memset(req, 0, sizeof(req));
 
             req->type = COAP_TYPE_NON;
             req->code = CONTENT_2_05;
@@ -263,45 +349,8 @@ coap_notify_observers(oc_resource_t *resource,
         } else {
 #endif /* OC_SEPARATE_RESPONSES */
             OC_LOG(DEBUG, "coap_notify_observers: notifying observer\n");
-            coap_transaction_t *transaction = NULL;
-            if (response_buf && (transaction = coap_new_transaction(
-                  coap_get_mid(), &obs->endpoint))) {
-
-                /* update last MID for RST matching */
-                obs->last_mid = transaction->mid;
-
-                /* prepare response */
-                /* build notification */
-                coap_packet_t notification[1];
-                /* this way the packet can be treated as pointer as usual */
-                coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
-
-                notification->mid = transaction->mid;
-                if (!oc_endpoint_use_tcp(&obs->endpoint) &&
-                    obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0) {
-                    OC_LOG(DEBUG, "coap_observe_notify: forcing CON "
-                                 "notification to check for client liveness\n");
-                    notification->type = COAP_TYPE_CON;
-                }
-                coap_set_payload(notification, response_buf->buffer,
-                                 OS_MBUF_PKTLEN(response_buf->buffer));
-                coap_set_status_code(notification, response_buf->code);
-                coap_set_header_content_format(notification, APPLICATION_CBOR);
-                if (notification->code < BAD_REQUEST_4_00 &&
-                  obs->resource->num_observers) {
-                    coap_set_header_observe(notification, (obs->obs_counter)++);
-                    observe_counter++;
-                } else {
-                    coap_set_header_observe(notification, 1);
-                }
-                coap_set_token(notification, obs->token, obs->token_len);
-
-                if (!coap_serialize_message(notification, transaction->m)) {
-                    transaction->type = notification->type;
-                    coap_send_transaction(transaction);
-                } else {
-                    coap_clear_transaction(transaction);
-                }
+            if (response_buf) {
+                coap_notify_observer(obs, response_buf);
             }
 #if MYNEWT_VAL(OC_SEPARATE_RESPONSES)
         }
@@ -317,19 +366,20 @@ int
 coap_observe_handler(struct coap_packet_rx *coap_req, coap_packet_t *coap_res,
                      oc_resource_t *resource, oc_endpoint_t *endpoint)
 {
+    uint32_t observe;
     int dup = -1;
 
     if (coap_req->code == COAP_GET &&
       coap_res->code < 128) { /* GET request and response without error code */
-        if (IS_OPTION(coap_req, COAP_OPTION_OBSERVE)) {
-            if (coap_req->observe == 0) {
+        if (coap_get_header_observe(coap_req, &observe)) {
+            if (observe == 0) {
                 char uri[COAP_MAX_URI];
                 int uri_len;
 
                 uri_len = coap_get_header_uri_path(coap_req, uri, sizeof(uri));
                 dup = add_observer(resource, endpoint, coap_req->token,
                                    coap_req->token_len, uri, uri_len);
-            } else if (coap_req->observe == 1) {
+            } else if (observe == 1) {
                 /* remove client if it is currently observe */
                 dup = coap_remove_observer_by_token(endpoint, coap_req->token,
                                                     coap_req->token_len);
@@ -118,13 +118,19 @@ coap_separate_accept(struct coap_packet_rx *coap_req,
     memcpy(separate_store->token, coap_req->token, coap_req->token_len);
     separate_store->token_len = coap_req->token_len;
 
-    separate_store->block1_num = coap_req->block1_num;
-    separate_store->block1_size = coap_req->block1_size;
-
-    separate_store->block2_num = coap_req->block2_num;
+    separate_store->block1_num = 0;
+    separate_store->block1_size = 0;
+    coap_get_header_block1(coap_req, &separate_store->block1_num, NULL,
+                           &separate_store->block1_size, NULL);
+
+    separate_store->block2_num = 0;
+    separate_store->block2_size = 0;
+    coap_get_header_block2(coap_req, &separate_store->block2_num, NULL,
+                           &separate_store->block2_size, NULL);
     separate_store->block2_size =
-      coap_req->block2_size > 0 ?
-      MIN(COAP_MAX_BLOCK_SIZE, coap_req->block2_size) : COAP_MAX_BLOCK_SIZE;
+      separate_store->block2_size > 0 ?
+      MIN(COAP_MAX_BLOCK_SIZE, separate_store->block2_size) :
+      COAP_MAX_BLOCK_SIZE;
 
     separate_store->observe = observe;
     return 1;
@@ -54,7 +54,8 @@
 static struct os_mempool oc_transaction_memb;
 static uint8_t oc_transaction_area[OS_MEMPOOL_BYTES(COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t))];
-static SLIST_HEAD(, coap_transaction) oc_transaction_list;
+/* Open transactions, hashed by MID. */
+static SLIST_HEAD(, coap_transaction) oc_transactions[COAP_HASH_SIZE];
 
 static void coap_transaction_retrans(struct os_event *ev);
 
@@ -78,11 +79,14 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
             t->mid = mid;
             t->retrans_counter = 0;
             t->m = m;
+#if MYNEWT_VAL(OC_COAP_COCOA)
+            t->cocoa = NULL;
+            t->cocoa_state = COAP_COCOA_IDLE;
+#endif
 
             os_callout_init(&t->retrans_timer, oc_evq_get(),
               coap_transaction_retrans, t);
-            /* list itself makes sure same element is not added twice */
-            SLIST_INSERT_HEAD(&oc_transaction_list, t, next);
+            SLIST_INSERT_HEAD(&oc_transactions[COAP_MID_HASH(mid)], t, next);
         } else {
             os_memblock_put(&oc_transaction_memb, t);
             t = NULL;
@@ -93,6 +97,85 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
 }
 
 /*---------------------------------------------------------------------------*/
+#if MYNEWT_VAL(OC_COAP_COCOA)
+/*
+ * Accounts a confirmable transaction against its peer's NSTART limit.
+ * Returns 1 if it has to wait for an earlier exchange to complete.
+ */
+static int
+coap_transaction_cocoa_start(coap_transaction_t *t)
+{
+    struct coap_cocoa_ep *ce;
+
+    ce = coap_cocoa_get(OC_MBUF_ENDPOINT(t->m));
+    t->cocoa = ce;
+    if (!ce) {
+        return 0;
+    }
+    if (ce->ce_outstanding >= MYNEWT_VAL(OC_COAP_NSTART)) {
+        OC_LOG(DEBUG, "Deferring transaction %u (NSTART)\n", t->mid);
+        STAILQ_INSERT_TAIL(&ce->ce_pending, t, pend_next);
+        t->cocoa_state = COAP_COCOA_PENDING;
+        return 1;
+    }
+    ce->ce_outstanding++;
+    t->cocoa_state = COAP_COCOA_OUTSTANDING;
+    t->start = os_time_get();
+    return 0;
+}
+
+/*
+ * Releases the transaction's NSTART slot, and sends the next transaction
+ * waiting for it.
+ */
+static void
+coap_transaction_cocoa_done(coap_transaction_t *t)
+{
+    struct coap_cocoa_ep *ce;
+    coap_transaction_t *next;
+
+    ce = t->cocoa;
+    if (t->cocoa_state == COAP_COCOA_PENDING) {
+        STAILQ_REMOVE(&ce->ce_pending, t, coap_transaction, pend_next);
+    } else if (t->cocoa_state == COAP_COCOA_OUTSTANDING) {
+        ce->ce_outstanding--;
+        next = STAILQ_FIRST(&ce->ce_pending);
+        if (next) {
+            STAILQ_REMOVE_HEAD(&ce->ce_pending, pend_next);
+            next->cocoa_state = COAP_COCOA_IDLE;
+            coap_send_transaction(next);
+        }
+    }
+    t->cocoa_state = COAP_COCOA_IDLE;
+}
+#endif
+
+static uint32_t
+coap_transaction_first_tmo(coap_transaction_t *t)
+{
+#if MYNEWT_VAL(OC_COAP_COCOA)
+    uint32_t rto;
+
+    if (t->cocoa) {
+        rto = coap_cocoa_rto(t->cocoa);
+        return rto + (oc_random_rand() % (rto / 2 + 1));
+    }
+#endif
+    return COAP_RESPONSE_TIMEOUT_TICKS +
+      (oc_random_rand() % (oc_clock_time_t)COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+}
+
+static uint32_t
+coap_transaction_next_tmo(coap_transaction_t *t)
+{
+#if MYNEWT_VAL(OC_COAP_COCOA)
+    if (t->cocoa) {
+        return coap_cocoa_backoff(t->retrans_tmo);
+    }
+#endif
+    return t->retrans_tmo << 1; /* double */
+}
+
 void
 coap_send_transaction(coap_transaction_t *t)
 {
@@ -106,15 +189,17 @@ coap_send_transaction(coap_transaction_t *t)
         if (t->retrans_counter < COAP_MAX_RETRANSMIT) {
             /* not timed out yet */
             if (t->retrans_counter == 0) {
-                t->retrans_tmo =
-                  COAP_RESPONSE_TIMEOUT_TICKS +
-                  (oc_random_rand() %
-                    (oc_clock_time_t)COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+#if MYNEWT_VAL(OC_COAP_COCOA)
+                if (coap_transaction_cocoa_start(t)) {
+                    return;
+                }
+#endif
+                t->retrans_tmo = coap_transaction_first_tmo(t);
                 OC_LOG(DEBUG, "Initial interval " OC_CLK_FMT "\n",
                              t->retrans_tmo);
             } else {
-                t->retrans_tmo <<= 1; /* double */
-                OC_LOG(DEBUG, "Doubled " OC_CLK_FMT "\n", t->retrans_tmo);
+                t->retrans_tmo = coap_transaction_next_tmo(t);
+                OC_LOG(DEBUG, "Backed off " OC_CLK_FMT "\n", t->retrans_tmo);
             }
 
             os_callout_reset(&t->retrans_timer, t->retrans_tmo);
@@ -158,14 +243,18 @@ coap_clear_transaction(coap_transaction_t *t)
 
     if (t) {
         os_callout_stop(&t->retrans_timer);
+#if MYNEWT_VAL(OC_COAP_COCOA)
+        coap_transaction_cocoa_done(t);
+#endif
         os_mbuf_free_chain(t->m);
 
         /*
          * Transaction might not be in the list yet.
          */
-        SLIST_FOREACH(tmp, &oc_transaction_list, next) {
+        SLIST_FOREACH(tmp, &oc_transactions[COAP_MID_HASH(t->mid)], next) {
             if (t == tmp) {
-                SLIST_REMOVE(&oc_transaction_list, t, coap_transaction, next);
+                SLIST_REMOVE(&oc_transactions[COAP_MID_HASH(t->mid)], t,
+                             coap_transaction, next);
                 break;
             }
         }
@@ -173,12 +262,28 @@ coap_clear_transaction(coap_transaction_t *t)
   }
 }
 
+/*
+ * Completes a transaction whose peer answered (ACK or RST), feeding the
+ * round trip time to the peer's RTO estimate.
+ */
+void
+coap_ack_transaction(coap_transaction_t *t)
+{
+#if MYNEWT_VAL(OC_COAP_COCOA)
+    if (t->cocoa_state == COAP_COCOA_OUTSTANDING) {
+        coap_cocoa_sample(t->cocoa, os_time_get() - t->start,
+                          t->retrans_counter);
+    }
+#endif
+    coap_clear_transaction(t);
+}
+
 coap_transaction_t *
 coap_get_transaction_by_mid(uint16_t mid)
 {
     coap_transaction_t *t;
 
-    SLIST_FOREACH(t, &oc_transaction_list, next) {
+    SLIST_FOREACH(t, &oc_transactions[COAP_MID_HASH(mid)], next) {
         if (t->mid == mid) {
             return t;
         }
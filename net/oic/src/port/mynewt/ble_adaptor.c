@@ -26,6 +26,7 @@
 #if (MYNEWT_VAL(OC_TRANSPORT_GATT) == 1)
 
 #include <stats/stats.h>
+#include <mem/mem.h>
 #include "oic/oc_gatt.h"
 #include "oic/oc_log.h"
 #include "oic/oc_ri.h"
@@ -111,8 +112,6 @@ STATS_NAME_START(oc_ble_stats)
     STATS_NAME(oc_ble_stats, oerr)
 STATS_NAME_END(oc_ble_stats)
 
-static STAILQ_HEAD(, os_mbuf_pkthdr) oc_ble_reass_q;
-
 #if (MYNEWT_VAL(OC_SERVER) == 1)
 /*
  * BLE nmgr attribute handles for service
@@ -123,6 +122,22 @@ static struct {
     uint16_t rsp;
 } oc_ble_srv_handles[OC_BLE_SRV_CNT];
 
+/*
+ * Incoming frames being reassembled, one per connection and service, so
+ * clients writing at the same time don't wait on each other.  need is the
+ * total length of the frame, read from its header once enough of it has
+ * arrived; 0 until then.
+ */
+struct oc_ble_reass {
+    struct os_mbuf *om;
+    uint16_t need;
+};
+
+static struct oc_ble_conn {
+    uint16_t conn_handle;
+    struct oc_ble_reass reass[OC_BLE_SRV_CNT];
+} oc_ble_conns[MYNEWT_VAL(BLE_MAX_CONNECTIONS)];
+
 static int oc_gatt_chr_access(uint16_t conn_handle, uint16_t attr_handle,
                    struct ble_gatt_access_ctxt *ctxt, void *arg);
 
@@ -205,14 +220,86 @@ oc_log_ep_gatt(char *ptr, int maxlen, const struct oc_endpoint *oe)
     return ptr;
 }
 
+/*
+ * Returns the reassembly state for a connection and service, claiming an
+ * unused connection entry if necessary.  Entries of connections that went
+ * away without oc_ble_coap_conn_del() being called are reused.
+ */
+static struct oc_ble_reass *
+oc_ble_reass_get(uint16_t conn_handle, uint8_t srv_idx)
+{
+    struct oc_ble_conn *obc;
+    struct oc_ble_conn *avail;
+    int i;
+
+    avail = NULL;
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        obc = &oc_ble_conns[i];
+        if (obc->conn_handle == conn_handle) {
+            return &obc->reass[srv_idx];
+        }
+        if (!avail && obc->conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+            avail = obc;
+        }
+    }
+    if (!avail) {
+        for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+            if (ble_gap_conn_find(oc_ble_conns[i].conn_handle, NULL)) {
+                oc_ble_coap_conn_del(oc_ble_conns[i].conn_handle);
+                avail = &oc_ble_conns[i];
+                break;
+            }
+        }
+        if (!avail) {
+            return NULL;
+        }
+    }
+    avail->conn_handle = conn_handle;
+    return &avail->reass[srv_idx];
+}
+
+/*
+ * Returns the total length of the CoAP-over-TCP frame in om, or 0 if its
+ * header has not been fully received yet.
+ */
+static uint16_t
+oc_ble_frame_len(struct os_mbuf *om)
+{
+    uint8_t hdr[sizeof(struct coap_tcp_hdr32)] = { 0 };
+    struct coap_tcp_hdr0 *cth0;
+    int hlen;
+
+    if (os_mbuf_copydata(om, 0, 1, hdr)) {
+        return 0;
+    }
+    cth0 = (struct coap_tcp_hdr0 *)hdr;
+    switch (cth0->data_len) {
+    case COAP_TCP_TYPE8:
+        hlen = sizeof(struct coap_tcp_hdr8);
+        break;
+    case COAP_TCP_TYPE16:
+        hlen = sizeof(struct coap_tcp_hdr16);
+        break;
+    case COAP_TCP_TYPE32:
+        hlen = sizeof(struct coap_tcp_hdr32);
+        break;
+    default:
+        hlen = sizeof(struct coap_tcp_hdr0);
+        break;
+    }
+    if (os_mbuf_copydata(om, 0, hlen, hdr)) {
+        return 0;
+    }
+    return coap_tcp_msg_size(hdr, sizeof(hdr));
+}
+
 int
 oc_ble_reass(struct os_mbuf *om1, uint16_t conn_handle, uint8_t srv_idx)
 {
     struct os_mbuf_pkthdr *pkt1;
     struct oc_endpoint_ble *oe_ble;
+    struct oc_ble_reass *reass;
     struct os_mbuf *om2;
-    struct os_mbuf_pkthdr *pkt2;
-    uint8_t hdr[6]; /* sizeof(coap_tcp_hdr32) */
 
     pkt1 = OS_MBUF_PKTHDR(om1);
     assert(pkt1);
@@ -223,26 +310,19 @@ oc_ble_reass(struct os_mbuf *om1, uint16_t conn_handle, uint8_t srv_idx)
     OC_LOG(DEBUG, "oc_gatt rx seg %u-%x-%u\n", conn_handle,
                  (unsigned)pkt1, pkt1->omp_len);
 
-    STAILQ_FOREACH(pkt2, &oc_ble_reass_q, omp_next) {
-        om2 = OS_MBUF_PKTHDR_TO_MBUF(pkt2);
-        oe_ble = (struct oc_endpoint_ble *)OC_MBUF_ENDPOINT(om2);
-        if (conn_handle == oe_ble->conn_handle && srv_idx == oe_ble->srv_idx) {
-            /*
-             * Data from same connection. Append.
-             */
-            os_mbuf_concat(om2, om1);
-            os_mbuf_copydata(om2, 0, sizeof(hdr), hdr);
-
-            if (coap_tcp_msg_size(hdr, sizeof(hdr)) <= pkt2->omp_len) {
-                STAILQ_REMOVE(&oc_ble_reass_q, pkt2, os_mbuf_pkthdr, omp_next);
-                STATS_INC(oc_ble_stats, iframe);
-                oc_recv_message(om2);
-            }
-            pkt1 = NULL;
-            break;
-        }
+    reass = oc_ble_reass_get(conn_handle, srv_idx);
+    if (!reass) {
+        OC_LOG(ERROR, "oc_gatt_rx: No reassembly slot\n");
+        STATS_INC(oc_ble_stats, ierr);
+        return -1;
     }
-    if (pkt1) {
+
+    if (reass->om) {
+        /*
+         * Data from same connection. Append.
+         */
+        os_mbuf_concat(reass->om, om1);
+    } else {
         /*
          * New frame, need to add oc_endpoint_ble in the front.
          * Check if there is enough space available. If not, allocate a
@@ -265,16 +345,24 @@ oc_ble_reass(struct os_mbuf *om1, uint16_t conn_handle, uint8_t srv_idx)
         oe_ble->ep.oe_flags = 0;
         oe_ble->srv_idx = srv_idx;
         oe_ble->conn_handle = conn_handle;
-        pkt2 = OS_MBUF_PKTHDR(om2);
 
-        os_mbuf_copydata(om2, 0, sizeof(hdr), hdr);
-        if (coap_tcp_msg_size(hdr, sizeof(hdr)) > pkt2->omp_len) {
-            STAILQ_INSERT_TAIL(&oc_ble_reass_q, pkt2, omp_next);
-        } else {
-            STATS_INC(oc_ble_stats, iframe);
-            oc_recv_message(om2);
+        reass->om = om2;
+        reass->need = 0;
+    }
+
+    if (!reass->need) {
+        reass->need = oc_ble_frame_len(reass->om);
+        if (!reass->need) {
+            return 0;
         }
     }
+    if (OS_MBUF_PKTLEN(reass->om) >= reass->need) {
+        om2 = reass->om;
+        reass->om = NULL;
+        reass->need = 0;
+        STATS_INC(oc_ble_stats, iframe);
+        oc_recv_message(om2);
+    }
     return 0;
 }
 
@@ -336,26 +424,41 @@ oc_ble_coap_conn_new(uint16_t conn_handle)
 void
 oc_ble_coap_conn_del(uint16_t conn_handle)
 {
-    struct os_mbuf_pkthdr *pkt;
-    struct os_mbuf *m;
-    struct oc_endpoint_ble *oe_ble;
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+    struct oc_ble_conn *obc;
+    int i;
+    int j;
+#endif
 
     OC_LOG(DEBUG, "oc_gatt endconn %x\n", conn_handle);
-    STAILQ_FOREACH(pkt, &oc_ble_reass_q, omp_next) {
-        m = OS_MBUF_PKTHDR_TO_MBUF(pkt);
-        oe_ble = (struct oc_endpoint_ble *)OC_MBUF_ENDPOINT(m);
-        if (oe_ble->conn_handle == conn_handle) {
-            STAILQ_REMOVE(&oc_ble_reass_q, pkt, os_mbuf_pkthdr, omp_next);
-            os_mbuf_free_chain(m);
-            break;
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        obc = &oc_ble_conns[i];
+        if (obc->conn_handle != conn_handle) {
+            continue;
+        }
+        for (j = 0; j < OC_BLE_SRV_CNT; j++) {
+            os_mbuf_free_chain(obc->reass[j].om);
+            obc->reass[j].om = NULL;
+            obc->reass[j].need = 0;
         }
+        obc->conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        break;
     }
+#endif
 }
 
 int
 oc_connectivity_init_gatt(void)
 {
-    STAILQ_INIT(&oc_ble_reass_q);
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+    int i;
+
+    memset(oc_ble_conns, 0, sizeof(oc_ble_conns));
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        oc_ble_conns[i].conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    }
+#endif
     return 0;
 }
 
@@ -366,47 +469,10 @@ oc_connectivity_shutdown_gatt(void)
 }
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
-static int
-oc_ble_frag(struct os_mbuf *m, uint16_t mtu)
+static struct os_mbuf *
+oc_ble_frag_alloc(uint16_t frag_size, void *arg)
 {
-    struct os_mbuf_pkthdr *pkt;
-    struct os_mbuf *n;
-    uint16_t off, blk;
-
-    pkt = OS_MBUF_PKTHDR(m);
-    if (pkt->omp_len <= mtu) {
-        STAILQ_NEXT(pkt, omp_next) = NULL;
-        return 0;
-    }
-
-    off = pkt->omp_len - (pkt->omp_len % mtu);
-    while (off >= mtu) {
-        n = os_msys_get_pkthdr(mtu, 0);
-        if (!n) {
-            goto err;
-        }
-        STAILQ_NEXT(OS_MBUF_PKTHDR(n), omp_next) = STAILQ_NEXT(pkt, omp_next);
-        STAILQ_NEXT(pkt, omp_next) = OS_MBUF_PKTHDR(n);
-
-        blk = pkt->omp_len - off;
-        if (os_mbuf_appendfrom(n, m, off, blk)) {
-            goto err;
-        }
-        off -= mtu;
-        os_mbuf_adj(m, -blk);
-    }
-    return 0;
-err:
-    pkt = OS_MBUF_PKTHDR(m);
-    while (1) {
-        pkt = STAILQ_NEXT(pkt, omp_next);
-        os_mbuf_free_chain(m);
-        if (!pkt) {
-            break;
-        }
-        m = OS_MBUF_PKTHDR_TO_MBUF(pkt);
-    };
-    return -1;
+    return os_msys_get_pkthdr(frag_size, 0);
 }
 #endif
 
@@ -415,7 +481,7 @@ oc_send_buffer_gatt(struct os_mbuf *m)
 {
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     struct oc_endpoint_ble *oe_ble;
-    struct os_mbuf_pkthdr *pkt;
+    struct os_mbuf *n;
     uint16_t mtu;
     uint16_t conn_handle;
     uint16_t attr_handle;
@@ -442,20 +508,17 @@ oc_send_buffer_gatt(struct os_mbuf *m)
     }
     mtu -= 3; /* # of bytes for ATT notification base */
 
-    if (oc_ble_frag(m, mtu)) {
-        STATS_INC(oc_ble_stats, oerr);
-        return;
-    }
-    while (1) {
-        STATS_INC(oc_ble_stats, oseg);
-        pkt = STAILQ_NEXT(OS_MBUF_PKTHDR(m), omp_next);
-
-        ble_gattc_notify_custom(conn_handle, attr_handle, m);
-        if (pkt) {
-            m = OS_MBUF_PKTHDR_TO_MBUF(pkt);
-        } else {
-            break;
+    /*
+     * Fragments take the mbufs of the response by reference; only the
+     * data around fragment boundaries gets copied.
+     */
+    while (m) {
+        n = mem_split_frag_ref(&m, mtu, oc_ble_frag_alloc, NULL);
+        if (!n) {
+            goto err;
         }
+        STATS_INC(oc_ble_stats, oseg);
+        ble_gattc_notify_custom(conn_handle, attr_handle, n);
     }
     return;
 
@@ -54,11 +54,11 @@ static const struct oc_transport oc_ip6_transport = {
     .ot_shutdown = oc_connectivity_shutdown_ip6
 };
 
-static struct os_event oc_sock6_read_event = {
-    .ev_cb = oc_event_ip6,
-};
+/* readiness of the sockets below */
+static struct mn_poll oc_sock6_poll;
 
 #define COAP_PORT_UNSECURED (5683)
+#define OC_IP_RX_BATCH (8)
 
 /* link-local scoped address ff02::fd */
 static const struct mn_in6_addr coap_all_nodes_v6 = {
@@ -210,19 +210,14 @@ oc_send_buffer_ip6_mcast(struct os_mbuf *m)
 }
 
 static struct os_mbuf *
-oc_attempt_rx_ip6_sock(struct mn_socket *rxsock)
+oc_rx_ip6_pkt(struct os_mbuf *n)
 {
-    int rc;
     struct os_mbuf *m;
-    struct os_mbuf *n;
     struct oc_endpoint_ip *oe_ip;
-    struct mn_sockaddr_in6 from;
+    struct mn_sockaddr_in6 *from;
 
-    rc = mn_recvfrom(rxsock, &n, (struct mn_sockaddr *) &from);
-    if (rc != 0) {
-        return NULL;
-    }
     assert(OS_MBUF_IS_PKTHDR(n));
+    from = (struct mn_sockaddr_in6 *)OS_MBUF_USRHDR(n);
 
     STATS_INC(oc_ip_stats, iframe);
     STATS_INCN(oc_ip_stats, ibytes, OS_MBUF_PKTLEN(n));
@@ -238,9 +233,9 @@ oc_attempt_rx_ip6_sock(struct mn_socket *rxsock)
 
     oe_ip->ep.oe_type = oc_ip6_transport_id;
     oe_ip->ep.oe_flags = 0;
-    memcpy(&oe_ip->v6.address, &from.msin6_addr, sizeof(oe_ip->v6.address));
-    oe_ip->v6.scope = from.msin6_scope_id;
-    oe_ip->port = ntohs(from.msin6_port);
+    memcpy(&oe_ip->v6.address, &from->msin6_addr, sizeof(oe_ip->v6.address));
+    oe_ip->v6.scope = from->msin6_scope_id;
+    oe_ip->port = ntohs(from->msin6_port);
 
     return m;
 
@@ -251,33 +246,6 @@ rx_attempt_err:
     return NULL;
 }
 
-static struct os_mbuf *
-oc_attempt_rx_ip6(void)
-{
-    struct os_mbuf *m;
-
-    m = oc_attempt_rx_ip6_sock(oc_ucast6);
-#if (MYNEWT_VAL(OC_SERVER) == 1)
-    if (m == NULL) {
-        m = oc_attempt_rx_ip6_sock(oc_mcast6);
-    }
-#endif
-    return m;
-}
-
-static void oc_socks6_readable(void *cb_arg, int err);
-
-union mn_socket_cb oc_sock6_cbs = {
-    .socket.readable = oc_socks6_readable,
-    .socket.writable = NULL
-};
-
-void
-oc_socks6_readable(void *cb_arg, int err)
-{
-    os_eventq_put(oc_evq_get(), &oc_sock6_read_event);
-}
-
 void
 oc_connectivity_shutdown_ip6(void)
 {
@@ -296,10 +264,32 @@ oc_connectivity_shutdown_ip6(void)
 static void
 oc_event_ip6(struct os_event *ev)
 {
+    struct mn_poll_result res[2];
+    struct mn_pkt_list pkts;
+    struct os_mbuf_pkthdr *omp;
     struct os_mbuf *m;
-
-    while ((m = oc_attempt_rx_ip6()) != NULL) {
-        oc_recv_message(m);
+    int cnt;
+    int i;
+
+    cnt = mn_poll_get(&oc_sock6_poll, res, sizeof(res) / sizeof(res[0]));
+    for (i = 0; i < cnt; i++) {
+        STAILQ_INIT(&pkts);
+        while (mn_recvfrom_batch(res[i].mpr_sock, &pkts,
+                                 OC_IP_RX_BATCH) == 0) {
+            while ((omp = STAILQ_FIRST(&pkts)) != NULL) {
+                STAILQ_REMOVE_HEAD(&pkts, omp_next);
+                m = oc_rx_ip6_pkt(OS_MBUF_PKTHDR_TO_MBUF(omp));
+                if (m) {
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+                    if (res[i].mpr_sock == oc_mcast6) {
+                        OC_MBUF_ENDPOINT(m)->ep.oe_flags |=
+                          OC_ENDPOINT_RX_MCAST;
+                    }
+#endif
+                    oc_recv_message(m);
+                }
+            }
+        }
     }
 }
 
@@ -311,13 +301,14 @@ oc_connectivity_init_ip6(void)
     struct mn_itf itf;
 
     memset(&itf, 0, sizeof(itf));
+    mn_poll_init(&oc_sock6_poll, oc_evq_get(), oc_event_ip6, NULL);
 
     rc = mn_socket(&oc_ucast6, MN_PF_INET6, MN_SOCK_DGRAM, 0);
     if (rc != 0 || !oc_ucast6) {
         OC_LOG(ERROR, "Could not create oc unicast socket\n");
         return rc;
     }
-    mn_socket_set_cbs(oc_ucast6, oc_ucast6, &oc_sock6_cbs);
+    mn_poll_add(&oc_sock6_poll, oc_ucast6, MN_POLLIN);
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     rc = mn_socket(&oc_mcast6, MN_PF_INET6, MN_SOCK_DGRAM, 0);
@@ -326,7 +317,7 @@ oc_connectivity_init_ip6(void)
         OC_LOG(ERROR, "Could not create oc multicast socket\n");
         return rc;
     }
-    mn_socket_set_cbs(oc_mcast6, oc_mcast6, &oc_sock6_cbs);
+    mn_poll_add(&oc_sock6_poll, oc_mcast6, MN_POLLIN);
 #endif
 
     sin.msin6_len = sizeof(sin);
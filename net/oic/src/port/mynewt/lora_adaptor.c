@@ -28,6 +28,7 @@
 #include <log/log.h>
 #include <stats/stats.h>
 #include <crc/crc16.h>
+#include <crc/crc_mbuf.h>
 
 #ifdef OC_DUMP_LORA
 #include <console/console.h>
@@ -36,6 +37,7 @@
 #include <node/lora.h>
 
 #include "oic/oc_log.h"
+#include "oic/oc_buffer.h"
 #include "oic/port/oc_connectivity.h"
 #include "oic/port/mynewt/adaptor.h"
 #include "oic/port/mynewt/transport.h"
@@ -46,6 +48,7 @@
 #endif
 
 static void oc_send_buffer_lora(struct os_mbuf *m);
+static int oc_lora_tx_ready(void);
 static uint8_t oc_ep_lora_size(const struct oc_endpoint *oe);
 static char *oc_log_ep_lora(char *ptr, int maxlen, const struct oc_endpoint *);
 static int oc_connectivity_init_lora(void);
@@ -56,6 +59,7 @@ static const struct oc_transport oc_lora_transport = {
     .ot_ep_size = oc_ep_lora_size,
     .ot_tx_ucast = oc_send_buffer_lora,
     .ot_tx_mcast = oc_send_buffer_lora,
+    .ot_tx_ready = oc_lora_tx_ready,
     .ot_get_trans_security = NULL,
     .ot_ep_str = oc_log_ep_lora,
     .ot_init = oc_connectivity_init_lora,
@@ -72,6 +76,7 @@ STATS_SECT_START(oc_lora_stats)
     STATS_SECT_ENTRY(ishort)
     STATS_SECT_ENTRY(ioof)
     STATS_SECT_ENTRY(idup)
+    STATS_SECT_ENTRY(idecomp)
     STATS_SECT_ENTRY(oframe)
     STATS_SECT_ENTRY(obytes)
     STATS_SECT_ENTRY(oerr)
@@ -86,6 +91,7 @@ STATS_NAME_START(oc_lora_stats)
     STATS_NAME(oc_lora_stats, ishort)
     STATS_NAME(oc_lora_stats, ioof)
     STATS_NAME(oc_lora_stats, idup)
+    STATS_NAME(oc_lora_stats, idecomp)
     STATS_NAME(oc_lora_stats, oframe)
     STATS_NAME(oc_lora_stats, obytes)
     STATS_NAME(oc_lora_stats, oerr)
@@ -177,7 +183,6 @@ oc_send_frag_lora(struct oc_lora_state *os)
     struct os_mbuf_pkthdr *pkt;
     struct os_mbuf *m;
     struct os_mbuf *n;
-    struct os_mbuf *o;
     int mtu;
     int blk_len;
     uint16_t crc;
@@ -194,9 +199,7 @@ oc_send_frag_lora(struct oc_lora_state *os)
     }
     if (os->tx_frag_num == 0) {
         crc = CRC16_INITIAL_CRC;
-        for (o = m; o; o = SLIST_NEXT(o, om_next)) {
-            crc = crc16_ccitt(crc, o->om_data, o->om_len);
-        }
+        crc16_ccitt_mbuf(&crc, m, 0, OS_MBUF_PKTLEN(m));
         hdr.s.frag_num = 0;
         hdr.s.crc = crc;
         os->tx_frag_num = 1;
@@ -238,8 +241,12 @@ err:
     os_mbuf_free_chain(n);
     os_mbuf_free_chain(m);
     STAILQ_REMOVE_HEAD(&os->tx_q, omp_next);
+    os->tx_frag_num = 0;
     /* XXX unlikely that there's something else queued, but if there is,
      * we should start tx again */
+    if (STAILQ_EMPTY(&os->tx_q)) {
+        oc_buffer_tx_resume();
+    }
 }
 
 static void
@@ -263,15 +270,37 @@ oc_lora_tx_cb(uint8_t port, LoRaMacEventInfoStatus_t status, Mcps_t pkt_type,
     }
     if (!STAILQ_EMPTY(&os->tx_q)) {
         oc_send_frag_lora(os);
+    } else {
+        oc_buffer_tx_resume();
     }
 }
 
+/*
+ * Unicast messages are held in the oc_buffer queue until the previous one
+ * has been fully sent.
+ */
+static int
+oc_lora_tx_ready(void)
+{
+    return STAILQ_EMPTY(&oc_lora_state.tx_q);
+}
+
 void
 oc_send_buffer_lora(struct os_mbuf *m)
 {
     struct oc_lora_state *os = &oc_lora_state;
     int in_progress = 0;
 
+#if MYNEWT_VAL(OC_LORA_SCHC)
+    struct oc_endpoint_lora *oe;
+
+    oe = (struct oc_endpoint_lora *)OC_MBUF_ENDPOINT(m);
+    m = oc_lora_schc_compress(m, oe->port);
+    if (!m) {
+        STATS_INC(oc_lora_stats, oom);
+        return;
+    }
+#endif
     if (!STAILQ_EMPTY(&os->tx_q)) {
         in_progress = 1;
     }
@@ -319,6 +348,25 @@ oc_lora_deliver(struct oc_lora_state *os)
 
     os->rx_pkt = NULL;
 
+    /*
+     * Check CRC.
+     */
+    crc = CRC16_INITIAL_CRC;
+    crc16_ccitt_mbuf(&crc, m, 0, OS_MBUF_PKTLEN(m));
+    if (crc != os->rx_crc) {
+        STATS_INC(oc_lora_stats, icsum);
+        os_mbuf_free_chain(m);
+        return;
+    }
+
+#if MYNEWT_VAL(OC_LORA_SCHC)
+    m = oc_lora_schc_decompress(m, os->rx_port);
+    if (!m) {
+        STATS_INC(oc_lora_stats, idecomp);
+        return;
+    }
+#endif
+
     /*
      * add oc_endpoint_lora in the front.
      */
@@ -339,19 +387,7 @@ oc_lora_deliver(struct oc_lora_state *os)
     oe->ep.oe_flags = 0;
     oe->port = os->rx_port;
 
-    /*
-     * Check CRC.
-     */
-    crc = CRC16_INITIAL_CRC;
-    for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-        crc = crc16_ccitt(crc, n->om_data, n->om_len);
-    }
-    if (crc != os->rx_crc) {
-        STATS_INC(oc_lora_stats, icsum);
-        os_mbuf_free_chain(m);
-    } else {
-        oc_recv_message(m);
-    }
+    oc_recv_message(m);
 }
 
 static void
@@ -368,12 +404,7 @@ oc_lora_rx_reass(struct os_mbuf *m, uint16_t port)
         goto err;
     }
     frag_num = COAP_LORA_FRAG_NUM(cf.frag_num);
-    if (frag_num == 0) {
-        m = os_mbuf_pullup(m, sizeof(*cfs));
-    } else {
-        m = os_mbuf_pullup(m, sizeof(cf));
-    }
-    if (!m) {
+    if (frag_num == 0 && OS_MBUF_PKTLEN(m) < sizeof(*cfs)) {
         STATS_INC(oc_lora_stats, ishort);
         goto err;
     }
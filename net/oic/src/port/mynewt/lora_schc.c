@@ -0,0 +1,476 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OC_TRANSPORT_LORA) && MYNEWT_VAL(OC_LORA_SCHC)
+
+#include "oic/oc_log.h"
+#include "oic/messaging/coap/constants.h"
+#include "oic/port/oc_connectivity.h"
+#include "oic/port/mynewt/lora.h"
+
+/*
+ * Header portion of a message (CoAP header, token, options) must fit in
+ * this much stack. Messages with longer headers are sent uncompressed.
+ */
+#define OC_LORA_SCHC_HDR_MAX    128
+#define OC_LORA_SCHC_MAX_OPTS   12
+
+#define COAP_PAYLOAD_MARKER     0xff
+
+struct oc_lora_schc_msg {
+    uint8_t hdr;                /* version, type, token length */
+    uint8_t code;
+    uint16_t mid;
+    const uint8_t *token;
+    uint8_t nopts;
+    struct {
+        uint16_t num;
+        uint16_t len;
+        const uint8_t *val;
+    } opts[OC_LORA_SCHC_MAX_OPTS];
+    int hdr_len;                /* offset of payload within message */
+};
+
+#if MYNEWT_VAL(OC_LORA_SCHC_DEFAULT_RULES)
+static const uint8_t oc_lora_schc_cbor[] = { APPLICATION_CBOR };
+
+/* 2.05 with CBOR payload, as sent in response to GET */
+static const struct oc_lora_schc_opt oc_lora_schc_opts_content[] = {
+    { COAP_OPTION_CONTENT_FORMAT, 1, oc_lora_schc_cbor },
+};
+
+/* Observe notification */
+static const struct oc_lora_schc_opt oc_lora_schc_opts_notify[] = {
+    { COAP_OPTION_OBSERVE, 0, NULL },
+    { COAP_OPTION_CONTENT_FORMAT, 1, oc_lora_schc_cbor },
+};
+
+/* Discovery request, GET /oic/res */
+static const struct oc_lora_schc_opt oc_lora_schc_opts_res[] = {
+    { COAP_OPTION_URI_PATH, 3, (const uint8_t *)"oic" },
+    { COAP_OPTION_URI_PATH, 3, (const uint8_t *)"res" },
+};
+
+static const struct oc_lora_schc_rule oc_lora_schc_default_rules[] = {
+    {
+        .osr_id = 1,
+        .osr_type = OC_LORA_SCHC_ANY,
+        .osr_tkl = OC_LORA_SCHC_ANY,
+        .osr_code = CONTENT_2_05,
+        .osr_mid = OC_LORA_SCHC_MID_SEND,
+        .osr_nopts = 1,
+        .osr_opts = oc_lora_schc_opts_content,
+    },
+    {
+        .osr_id = 2,
+        .osr_type = OC_LORA_SCHC_ANY,
+        .osr_tkl = OC_LORA_SCHC_ANY,
+        .osr_code = CONTENT_2_05,
+        .osr_mid = OC_LORA_SCHC_MID_SEND,
+        .osr_nopts = 2,
+        .osr_opts = oc_lora_schc_opts_notify,
+    },
+    {
+        .osr_id = 3,
+        .osr_type = OC_LORA_SCHC_ANY,
+        .osr_tkl = OC_LORA_SCHC_ANY,
+        .osr_code = COAP_GET,
+        .osr_mid = OC_LORA_SCHC_MID_SEND,
+        .osr_nopts = 2,
+        .osr_opts = oc_lora_schc_opts_res,
+    },
+};
+
+static const struct oc_lora_schc_rule *oc_lora_schc_rules =
+    oc_lora_schc_default_rules;
+static int oc_lora_schc_nrules =
+    sizeof(oc_lora_schc_default_rules) / sizeof(oc_lora_schc_default_rules[0]);
+#else
+static const struct oc_lora_schc_rule *oc_lora_schc_rules;
+static int oc_lora_schc_nrules;
+#endif
+
+void
+oc_lora_schc_rules_set(const struct oc_lora_schc_rule *rules, int cnt)
+{
+    oc_lora_schc_rules = rules;
+    oc_lora_schc_nrules = cnt;
+}
+
+/*
+ * Read extended option delta/length.
+ */
+static int
+oc_lora_schc_opt_ext(const uint8_t **pp, const uint8_t *end, unsigned *val)
+{
+    const uint8_t *p = *pp;
+
+    if (*val == 13) {
+        if (p + 1 > end) {
+            return -1;
+        }
+        *val = 13 + p[0];
+        p += 1;
+    } else if (*val == 14) {
+        if (p + 2 > end) {
+            return -1;
+        }
+        *val = 269 + ((p[0] << 8) | p[1]);
+        p += 2;
+    } else if (*val == 15) {
+        return -1;
+    }
+    *pp = p;
+    return 0;
+}
+
+/*
+ * Parse header of a CoAP message from buf, which holds the first buf_len
+ * bytes of a pkt_len byte message.
+ */
+static int
+oc_lora_schc_parse(const uint8_t *buf, int buf_len, int pkt_len,
+                   struct oc_lora_schc_msg *msg)
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    unsigned delta;
+    unsigned len;
+    uint16_t num;
+
+    if (buf_len < 4 || (buf[0] >> 6) != 1 || (buf[0] & 0xf) > COAP_TOKEN_LEN) {
+        return -1;
+    }
+    msg->hdr = buf[0];
+    msg->code = buf[1];
+    msg->mid = (buf[2] << 8) | buf[3];
+    msg->token = buf + 4;
+    msg->nopts = 0;
+
+    p = buf + 4 + (buf[0] & 0xf);
+    end = buf + buf_len;
+    num = 0;
+    while (1) {
+        if (p >= end) {
+            if (buf_len < pkt_len) {
+                /* header did not fit */
+                return -1;
+            }
+            msg->hdr_len = pkt_len;
+            return 0;
+        }
+        if (*p == COAP_PAYLOAD_MARKER) {
+            msg->hdr_len = p + 1 - buf;
+            return 0;
+        }
+        if (msg->nopts >= OC_LORA_SCHC_MAX_OPTS) {
+            return -1;
+        }
+        delta = *p >> 4;
+        len = *p & 0xf;
+        p++;
+        if (oc_lora_schc_opt_ext(&p, end, &delta) ||
+            oc_lora_schc_opt_ext(&p, end, &len) || p + len > end) {
+            return -1;
+        }
+        num += delta;
+        msg->opts[msg->nopts].num = num;
+        msg->opts[msg->nopts].len = len;
+        msg->opts[msg->nopts].val = p;
+        msg->nopts++;
+        p += len;
+    }
+}
+
+static int
+oc_lora_schc_match(const struct oc_lora_schc_rule *r,
+                   const struct oc_lora_schc_msg *msg, uint8_t port)
+{
+    const struct oc_lora_schc_opt *o;
+    int i;
+
+    if (r->osr_port && r->osr_port != port) {
+        return 0;
+    }
+    if (r->osr_type != OC_LORA_SCHC_ANY &&
+        r->osr_type != ((msg->hdr >> 4) & 0x3)) {
+        return 0;
+    }
+    if (r->osr_tkl != OC_LORA_SCHC_ANY && r->osr_tkl != (msg->hdr & 0xf)) {
+        return 0;
+    }
+    if (r->osr_code != OC_LORA_SCHC_ANY && r->osr_code != msg->code) {
+        return 0;
+    }
+    if (r->osr_mid == OC_LORA_SCHC_MID_LSB &&
+        (r->osr_mid_val & 0xff00) != (msg->mid & 0xff00)) {
+        return 0;
+    }
+    if (r->osr_nopts != msg->nopts) {
+        return 0;
+    }
+    for (i = 0; i < msg->nopts; i++) {
+        o = &r->osr_opts[i];
+        if (o->oso_num != msg->opts[i].num) {
+            return 0;
+        }
+        if (o->oso_val) {
+            if (o->oso_len != msg->opts[i].len ||
+                memcmp(o->oso_val, msg->opts[i].val, o->oso_len)) {
+                return 0;
+            }
+        } else if (msg->opts[i].len > 0xff) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static const struct oc_lora_schc_rule *
+oc_lora_schc_find(uint8_t id, uint8_t port)
+{
+    const struct oc_lora_schc_rule *r;
+    int i;
+
+    for (i = 0; i < oc_lora_schc_nrules; i++) {
+        r = &oc_lora_schc_rules[i];
+        if (r->osr_id == id && (!r->osr_port || r->osr_port == port)) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Build a new packet header mbuf carrying the same user header as m,
+ * with data from buf followed by m's bytes from off onwards.
+ */
+static struct os_mbuf *
+oc_lora_schc_rebuild(struct os_mbuf *m, const uint8_t *buf, int len, int off)
+{
+    struct os_mbuf *n;
+
+    n = os_msys_get_pkthdr(len, OS_MBUF_USRHDR_LEN(m));
+    if (!n) {
+        goto err;
+    }
+    memcpy(OS_MBUF_USRHDR(n), OS_MBUF_USRHDR(m), OS_MBUF_USRHDR_LEN(m));
+    if (os_mbuf_append(n, buf, len)) {
+        goto err;
+    }
+    if (off < OS_MBUF_PKTLEN(m) &&
+        os_mbuf_appendfrom(n, m, off, OS_MBUF_PKTLEN(m) - off)) {
+        goto err;
+    }
+    os_mbuf_free_chain(m);
+    return n;
+err:
+    os_mbuf_free_chain(n);
+    os_mbuf_free_chain(m);
+    return NULL;
+}
+
+struct os_mbuf *
+oc_lora_schc_compress(struct os_mbuf *m, uint8_t port)
+{
+    const struct oc_lora_schc_rule *r;
+    struct oc_lora_schc_msg msg;
+    uint8_t in[OC_LORA_SCHC_HDR_MAX];
+    uint8_t out[OC_LORA_SCHC_HDR_MAX + 1];
+    uint8_t *p;
+    int in_len;
+    int i;
+
+    in_len = min(OS_MBUF_PKTLEN(m), sizeof(in));
+    os_mbuf_copydata(m, 0, in_len, in);
+
+    r = NULL;
+    if (!oc_lora_schc_parse(in, in_len, OS_MBUF_PKTLEN(m), &msg)) {
+        for (i = 0; i < oc_lora_schc_nrules; i++) {
+            if (oc_lora_schc_match(&oc_lora_schc_rules[i], &msg, port)) {
+                r = &oc_lora_schc_rules[i];
+                break;
+            }
+        }
+    }
+    if (!r) {
+        out[0] = OC_LORA_SCHC_RULE_NONE;
+        return oc_lora_schc_rebuild(m, out, 1, 0);
+    }
+
+    p = out;
+    *p++ = r->osr_id;
+    if (r->osr_type == OC_LORA_SCHC_ANY || r->osr_tkl == OC_LORA_SCHC_ANY) {
+        *p++ = msg.hdr;
+    }
+    if (r->osr_code == OC_LORA_SCHC_ANY) {
+        *p++ = msg.code;
+    }
+    if (r->osr_mid == OC_LORA_SCHC_MID_SEND) {
+        *p++ = msg.mid >> 8;
+    }
+    *p++ = msg.mid;
+    memcpy(p, msg.token, msg.hdr & 0xf);
+    p += msg.hdr & 0xf;
+    for (i = 0; i < msg.nopts; i++) {
+        if (!r->osr_opts[i].oso_val) {
+            *p++ = msg.opts[i].len;
+            memcpy(p, msg.opts[i].val, msg.opts[i].len);
+            p += msg.opts[i].len;
+        }
+    }
+    return oc_lora_schc_rebuild(m, out, p - out, msg.hdr_len);
+}
+
+static uint8_t *
+oc_lora_schc_put_opt(uint8_t *p, unsigned delta, unsigned len)
+{
+    uint8_t *hdr = p++;
+
+    *hdr = 0;
+    if (delta > 268) {
+        *hdr |= 14 << 4;
+        *p++ = (delta - 269) >> 8;
+        *p++ = delta - 269;
+    } else if (delta > 12) {
+        *hdr |= 13 << 4;
+        *p++ = delta - 13;
+    } else {
+        *hdr |= delta << 4;
+    }
+    if (len > 12) {
+        *hdr |= 13;
+        *p++ = len - 13;
+    } else {
+        *hdr |= len;
+    }
+    return p;
+}
+
+struct os_mbuf *
+oc_lora_schc_decompress(struct os_mbuf *m, uint8_t port)
+{
+    const struct oc_lora_schc_rule *r;
+    const struct oc_lora_schc_opt *o;
+    uint8_t in[OC_LORA_SCHC_HDR_MAX + 1];
+    uint8_t out[OC_LORA_SCHC_HDR_MAX];
+    const uint8_t *ip;
+    const uint8_t *iend;
+    const uint8_t *val;
+    uint8_t *op;
+    uint16_t num;
+    int in_len;
+    int len;
+    int tkl;
+    int i;
+
+    in_len = min(OS_MBUF_PKTLEN(m), sizeof(in));
+    if (in_len < 1) {
+        goto err;
+    }
+    os_mbuf_copydata(m, 0, in_len, in);
+    if (in[0] == OC_LORA_SCHC_RULE_NONE) {
+        os_mbuf_adj(m, 1);
+        return m;
+    }
+    r = oc_lora_schc_find(in[0], port);
+    if (!r) {
+        goto err;
+    }
+
+    ip = in + 1;
+    iend = in + in_len;
+    op = out;
+
+#define OC_LORA_SCHC_NEED(n)                                            \
+    if (ip + (n) > iend) {                                              \
+        goto err;                                                       \
+    }
+
+    if (r->osr_type == OC_LORA_SCHC_ANY || r->osr_tkl == OC_LORA_SCHC_ANY) {
+        OC_LORA_SCHC_NEED(1);
+        *op++ = *ip++;
+    } else {
+        *op++ = (1 << 6) | (r->osr_type << 4) | r->osr_tkl;
+    }
+    tkl = out[0] & 0xf;
+    if ((out[0] >> 6) != 1 || tkl > COAP_TOKEN_LEN) {
+        goto err;
+    }
+    if (r->osr_code == OC_LORA_SCHC_ANY) {
+        OC_LORA_SCHC_NEED(1);
+        *op++ = *ip++;
+    } else {
+        *op++ = r->osr_code;
+    }
+    if (r->osr_mid == OC_LORA_SCHC_MID_SEND) {
+        OC_LORA_SCHC_NEED(2);
+        *op++ = *ip++;
+    } else {
+        OC_LORA_SCHC_NEED(1);
+        *op++ = r->osr_mid_val >> 8;
+    }
+    *op++ = *ip++;
+    OC_LORA_SCHC_NEED(tkl);
+    memcpy(op, ip, tkl);
+    op += tkl;
+    ip += tkl;
+
+    num = 0;
+    for (i = 0; i < r->osr_nopts; i++) {
+        o = &r->osr_opts[i];
+        if (o->oso_val) {
+            len = o->oso_len;
+            val = o->oso_val;
+        } else {
+            OC_LORA_SCHC_NEED(1);
+            len = *ip++;
+            OC_LORA_SCHC_NEED(len);
+            val = ip;
+            ip += len;
+        }
+        /* option header is at most 4 bytes */
+        if (o->oso_num < num || op + 4 + len > out + sizeof(out)) {
+            goto err;
+        }
+        op = oc_lora_schc_put_opt(op, o->oso_num - num, len);
+        memcpy(op, val, len);
+        op += len;
+        num = o->oso_num;
+    }
+#undef OC_LORA_SCHC_NEED
+
+    if (ip - in < OS_MBUF_PKTLEN(m)) {
+        if (op >= out + sizeof(out)) {
+            goto err;
+        }
+        *op++ = COAP_PAYLOAD_MARKER;
+    }
+    return oc_lora_schc_rebuild(m, out, op - out, ip - in);
+err:
+    os_mbuf_free_chain(m);
+    return NULL;
+}
+
+#endif
@@ -24,7 +24,11 @@
 
 #if (MYNEWT_VAL(OC_TRANSPORT_SERIAL) == 1)
 
+#if MYNEWT_VAL(OC_SERIAL_COBS)
+#include <cobs/cobs_uart.h>
+#else
 #include <shell/shell.h>
+#endif
 
 #include "oic/oc_log.h"
 #include "oic/port/oc_connectivity.h"
@@ -49,7 +53,11 @@ static const struct oc_transport oc_serial_transport = {
 };
 
 uint8_t oc_serial_transport_id;
+#if MYNEWT_VAL(OC_SERIAL_COBS)
+static struct cobs_uart oc_serial_cobs;
+#else
 static struct os_mqueue oc_serial_mqueue;
+#endif
 static struct os_mbuf *oc_attempt_rx_serial(void);
 
 static char *
@@ -64,16 +72,20 @@ oc_ep_serial_size(const struct oc_endpoint *oe)
     return sizeof(struct oc_endpoint_plain);
 }
 
+#if !MYNEWT_VAL(OC_SERIAL_COBS)
 static int
 oc_serial_in(struct os_mbuf *m, void *arg)
 {
     return os_mqueue_put(&oc_serial_mqueue, oc_evq_get(), m);
 }
+#endif
 
 void
 oc_connectivity_shutdown_serial(void)
 {
+#if !MYNEWT_VAL(OC_SERIAL_COBS)
     shell_nlip_input_register(NULL, NULL);
+#endif
 }
 
 static void
@@ -91,6 +103,17 @@ oc_connectivity_init_serial(void)
 {
     int rc;
 
+#if MYNEWT_VAL(OC_SERIAL_COBS)
+    /* Binary frames straight from the UART, no shell or base64 */
+    rc = cobs_uart_open(&oc_serial_cobs, MYNEWT_VAL(OC_SERIAL_COBS_UART),
+                        MYNEWT_VAL(OC_SERIAL_COBS_SPEED), oc_evq_get(),
+                        oc_event_serial, NULL);
+    if (rc != 0) {
+        goto err;
+    }
+
+    return 0;
+#else
     rc = shell_nlip_input_register(oc_serial_in, NULL);
     if (rc != 0) {
         goto err;
@@ -102,6 +125,7 @@ oc_connectivity_init_serial(void)
     }
 
     return 0;
+#endif
 
 err:
     oc_connectivity_shutdown_serial();
@@ -112,10 +136,16 @@ err:
 void
 oc_send_buffer_serial(struct os_mbuf *m)
 {
+#if MYNEWT_VAL(OC_SERIAL_COBS)
+    if (cobs_uart_tx(&oc_serial_cobs, m)) {
+        OC_LOG(ERROR, "oc_transport_serial: cobs output failed\n");
+    }
+#else
     /* send over the shell output */
     if (shell_nlip_output(m)) {
         OC_LOG(ERROR, "oc_transport_serial: nlip output failed\n");
     }
+#endif
 }
 
 static struct os_mbuf *
@@ -126,7 +156,11 @@ oc_attempt_rx_serial(void)
     struct oc_endpoint_plain *oe_plain;
 
     /* get an mbuf from the queue */
+#if MYNEWT_VAL(OC_SERIAL_COBS)
+    n = cobs_uart_rx(&oc_serial_cobs);
+#else
     n = os_mqueue_get(&oc_serial_mqueue);
+#endif
     if (NULL == n) {
         return NULL;
     }
@@ -14,6 +14,15 @@
 // limitations under the License.
 */
 
+/*
+ * Note: OC_SECURITY is not defined anywhere in the Mynewt port, so this
+ * file is not built. It still targets the iotivity-constrained tinydtls
+ * glue (flat oc_message_t buffers, dtls_context_t), which is neither
+ * in the tree nor matched by the current mbuf-based messaging layer.
+ * Session caching, resumption and Connection ID need to be designed
+ * against whatever DTLS stack replaces it (e.g. crypto/mbedtls).
+ */
+
 #ifdef OC_SECURITY
 
 #include "oc_dtls.h"
@@ -69,6 +69,17 @@ struct wifi_if {
     char wi_ssid[WIFI_SSID_MAX + 1];
     char wi_key[WIFI_KEY_MAX + 1];
     uint8_t wi_myip[4];
+
+    /*
+     * Fast reconnect. wi_last is the AP last successfully connected to;
+     * connects go to it directly before falling back to a full scan.
+     */
+    struct wifi_ap wi_last;
+    struct wifi_ap *wi_conn_ap;         /* AP of the connect in progress */
+    uint8_t wi_fast:1;                  /* connecting to wi_last */
+    uint8_t wi_fast_fail:1;             /* wi_last failed, scan instead */
+    uint8_t wi_reconnect:1;             /* connect again once in INIT */
+    os_time_t wi_conn_start;
 };
 
 /*
@@ -27,6 +27,12 @@ extern "C" {
 
 /*
  * Interface between Wi-fi management and the driver.
+ *
+ * wio_connect() is given either a scan result, or when reconnecting, the AP
+ * which was last connected to. In the latter case the driver should join
+ * directly using wa_bssid and wa_channel, without scanning other channels.
+ * If that fails, it reports it with wifi_connect_done(), and a full scan
+ * follows.
  */
 struct wifi_if_ops {
     int (*wio_init)(struct wifi_if *);
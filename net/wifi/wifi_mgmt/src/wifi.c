@@ -26,6 +26,7 @@
 #include <hal/hal_gpio.h>
 #include <shell/shell.h>
 #include <console/console.h>
+#include <stats/stats.h>
 
 #include "wifi_mgmt/wifi_mgmt.h"
 #include "wifi_mgmt/wifi_mgmt_if.h"
@@ -41,6 +42,29 @@ static void wifi_event_state(struct os_event *ev);
 
 static struct wifi_if *wifi_if;
 
+STATS_SECT_START(wifi_stats)
+    STATS_SECT_ENTRY(conn_ok)
+    STATS_SECT_ENTRY(conn_fail)
+    STATS_SECT_ENTRY(fast_try)
+    STATS_SECT_ENTRY(fast_ok)
+    STATS_SECT_ENTRY(full_scan)
+    STATS_SECT_ENTRY(conn_ms_last)
+    STATS_SECT_ENTRY(conn_ms_max)
+    STATS_SECT_ENTRY(conn_ms_total)
+STATS_SECT_END
+STATS_SECT_DECL(wifi_stats) wifi_stats;
+
+STATS_NAME_START(wifi_stats)
+    STATS_NAME(wifi_stats, conn_ok)
+    STATS_NAME(wifi_stats, conn_fail)
+    STATS_NAME(wifi_stats, fast_try)
+    STATS_NAME(wifi_stats, fast_ok)
+    STATS_NAME(wifi_stats, full_scan)
+    STATS_NAME(wifi_stats, conn_ms_last)
+    STATS_NAME(wifi_stats, conn_ms_max)
+    STATS_NAME(wifi_stats, conn_ms_total)
+STATS_NAME_END(wifi_stats)
+
 /*
  * Looks up interface based on port number.
  */
@@ -131,6 +155,19 @@ wifi_connect_done(struct wifi_if *wi, int status)
 {
     console_printf("connect_done : %d\n", status);
     if (status) {
+        STATS_INC(wifi_stats, conn_fail);
+#if MYNEWT_VAL(WIFI_MGMT_FAST_RECONNECT)
+        if (wi->wi_fast) {
+            /*
+             * AP not where it was last time. Forget stale scan results,
+             * and come back through INIT to do a full scan.
+             */
+            wi->wi_fast = 0;
+            wi->wi_fast_fail = 1;
+            wi->wi_scan_cnt = 0;
+            wi->wi_reconnect = 1;
+        }
+#endif
         wifi_tgt_state(wi, INIT);
         return;
     }
@@ -155,6 +192,16 @@ void
 wifi_disconnected(struct wifi_if *wi, int status)
 {
     console_printf("disconnect : %d\n", status);
+#if MYNEWT_VAL(WIFI_MGMT_FAST_RECONNECT)
+    if (wi->wi_state == DHCP_WAIT || wi->wi_state == CONNECTED) {
+        /*
+         * Link lost. Reconnect, starting with the AP we just lost.
+         */
+        wi->wi_fast_fail = 0;
+        wi->wi_reconnect = 1;
+        wi->wi_conn_start = os_time_get();
+    }
+#endif
     wifi_tgt_state(wi, INIT);
 }
 
@@ -171,6 +218,76 @@ wifi_find_ap(struct wifi_if *wi, char *ssid)
     return NULL;
 }
 
+/*
+ * Returns the AP to try before scanning, if any.
+ */
+static struct wifi_ap *
+wifi_fast_ap(struct wifi_if *wi)
+{
+#if MYNEWT_VAL(WIFI_MGMT_FAST_RECONNECT)
+    if (wi->wi_fast_fail) {
+        return NULL;
+    }
+#if MYNEWT_VAL(WIFI_MGMT_PERSIST)
+    if (WIFI_SSID_EMPTY(wi->wi_last.wa_ssid)) {
+        wifi_persist_load(&wi->wi_last);
+    }
+#endif
+    if (WIFI_SSID_EMPTY(wi->wi_last.wa_ssid) ||
+        strcmp(wi->wi_last.wa_ssid, wi->wi_ssid)) {
+        return NULL;
+    }
+    return &wi->wi_last;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * Connection is up. Record time to connect, and remember the AP for
+ * reconnecting.
+ */
+static void
+wifi_connected(struct wifi_if *wi)
+{
+    static uint32_t max_ms;
+#if MYNEWT_VAL(WIFI_MGMT_FAST_RECONNECT)
+    struct wifi_ap ap;
+#endif
+    uint32_t ms;
+
+    ms = os_time_ticks_to_ms32(os_time_get() - wi->wi_conn_start);
+    STATS_INC(wifi_stats, conn_ok);
+    STATS_CLEAR(wifi_stats, conn_ms_last);
+    STATS_INCN(wifi_stats, conn_ms_last, ms);
+    STATS_INCN(wifi_stats, conn_ms_total, ms);
+    if (ms > max_ms) {
+        max_ms = ms;
+        STATS_CLEAR(wifi_stats, conn_ms_max);
+        STATS_INCN(wifi_stats, conn_ms_max, ms);
+    }
+    console_printf("connected in %lu ms\n", (unsigned long)ms);
+
+#if MYNEWT_VAL(WIFI_MGMT_FAST_RECONNECT)
+    if (wi->wi_fast) {
+        STATS_INC(wifi_stats, fast_ok);
+        wi->wi_fast = 0;
+    } else if (wi->wi_conn_ap) {
+        ap = *wi->wi_conn_ap;
+        /* RSSI changes all the time, don't let it cause a save. */
+        ap.wa_rssi = 0;
+        if (memcmp(&wi->wi_last, &ap, sizeof(ap))) {
+            wi->wi_last = ap;
+#if MYNEWT_VAL(WIFI_MGMT_PERSIST)
+            wifi_persist_save(&wi->wi_last);
+#endif
+        }
+    }
+    wi->wi_fast_fail = 0;
+#endif
+    wi->wi_conn_ap = NULL;
+}
+
 static void
 wifi_events(struct os_event *ev)
 {
@@ -216,6 +333,8 @@ wifi_connect(struct wifi_if *wi)
         if (WIFI_SSID_EMPTY(wi->wi_ssid)) {
             return -1;
         }
+        wi->wi_fast_fail = 0;
+        wi->wi_conn_start = os_time_get();
         wifi_tgt_state(wi, CONNECTING);
         return 0;
     default:
@@ -255,6 +374,7 @@ wifi_step(struct wifi_if *wi)
             wi->wi_ops->wio_deinit(wi);
             wi->wi_state = STOPPED;
         }
+        wi->wi_reconnect = 0;
         break;
     case INIT:
         if (wi->wi_state == STOPPED) {
@@ -263,15 +383,18 @@ wifi_step(struct wifi_if *wi)
             if (!rc) {
                 wi->wi_state = INIT;
             }
-        } else if (wi->wi_state == SCANNING) {
-            wi->wi_state = wi->wi_tgt;
-        } else if (wi->wi_state == CONNECTING) {
-            wi->wi_state = wi->wi_tgt;
+        } else {
+            wi->wi_state = INIT;
+            if (wi->wi_reconnect) {
+                wi->wi_reconnect = 0;
+                wi->wi_tgt = CONNECTING;
+            }
         }
         break;
     case SCANNING:
         if (wi->wi_state == INIT) {
             memset(wi->wi_scan, 0, sizeof(wi->wi_scan));
+            wi->wi_scan_cnt = 0;
             rc = wi->wi_ops->wio_scan_start(wi);
             console_printf("wifi_request_scan : %d\n", rc);
             if (rc != 0) {
@@ -284,16 +407,29 @@ wifi_step(struct wifi_if *wi)
         break;
     case CONNECTING:
         if (wi->wi_state == INIT || wi->wi_state == SCANNING) {
-            ap = wifi_find_ap(wi, wi->wi_ssid);
+            ap = NULL;
+            if (wi->wi_state == INIT) {
+                ap = wifi_fast_ap(wi);
+            }
+            if (ap) {
+                wi->wi_fast = 1;
+                STATS_INC(wifi_stats, fast_try);
+            } else {
+                wi->wi_fast = 0;
+                ap = wifi_find_ap(wi, wi->wi_ssid);
+            }
             if (!ap) {
+                STATS_INC(wifi_stats, full_scan);
                 wifi_tgt_state(wi, SCANNING);
                 break;
             }
             rc = wi->wi_ops->wio_connect(wi, ap);
             console_printf("wifi_connect : %d\n", rc);
             if (rc == 0) {
+                wi->wi_conn_ap = ap;
                 wi->wi_state = CONNECTING;
             } else {
+                wi->wi_fast = 0;
                 wi->wi_tgt = STOPPED;
             }
         }
@@ -302,6 +438,9 @@ wifi_step(struct wifi_if *wi)
         wi->wi_state = wi->wi_tgt;
         break;
     case CONNECTED:
+        if (wi->wi_state != CONNECTED) {
+            wifi_connected(wi);
+        }
         wi->wi_state = wi->wi_tgt;
         break;
     default:
@@ -330,6 +469,25 @@ wifi_task(void *arg)
     }
 }
 
+void
+wifi_mgmt_pkg_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = stats_init_and_reg(STATS_HDR(wifi_stats),
+                            STATS_SIZE_INIT_PARMS(wifi_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(wifi_stats), "wifi");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(WIFI_MGMT_PERSIST)
+    rc = wifi_persist_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
 int
 wifi_task_init(uint8_t prio, os_stack_t *stack, uint16_t stack_size)
 {
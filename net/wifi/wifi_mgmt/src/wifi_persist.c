@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(WIFI_MGMT_PERSIST)
+
+#include <string.h>
+
+#include "config/config.h"
+
+#include "wifi_mgmt/wifi_mgmt.h"
+#include "wifi_priv.h"
+
+/*
+ * AP last connected to, persisted as "wifi/ap" so that fast reconnect works
+ * across reboots. The key is not stored; the application provides it with
+ * the SSID as before.
+ */
+static struct wifi_ap wifi_persist_ap;
+static bool wifi_persist_have_loaded;
+
+static int wifi_persist_conf_set(int argc, char **argv, char *val);
+
+static struct conf_handler wifi_persist_conf_handler = {
+    .ch_name = "wifi",
+    .ch_get = NULL,
+    .ch_set = wifi_persist_conf_set,
+    .ch_commit = NULL,
+    .ch_export = NULL,
+};
+
+static int
+wifi_persist_conf_set(int argc, char **argv, char *val)
+{
+    int len;
+    int rc;
+
+    if (argc != 1 || strcmp(argv[0], "ap") != 0) {
+        return OS_ENOENT;
+    }
+
+    wifi_persist_have_loaded = false;
+    if (val == NULL || val[0] == '\0') {
+        return 0;
+    }
+
+    len = sizeof wifi_persist_ap;
+    rc = conf_bytes_from_str(val, &wifi_persist_ap, &len);
+    if (rc != 0 || len != sizeof wifi_persist_ap) {
+        return OS_EINVAL;
+    }
+    wifi_persist_ap.wa_ssid[WIFI_SSID_MAX] = '\0';
+
+    wifi_persist_have_loaded = true;
+    return 0;
+}
+
+/*
+ * Copies the persisted AP to ap. Returns 0 on success, OS_ENOENT if nothing
+ * was loaded from config.
+ */
+int
+wifi_persist_load(struct wifi_ap *ap)
+{
+    if (!wifi_persist_have_loaded) {
+        return OS_ENOENT;
+    }
+    *ap = wifi_persist_ap;
+    return 0;
+}
+
+int
+wifi_persist_save(const struct wifi_ap *ap)
+{
+    char buf[CONF_STR_FROM_BYTES_LEN(sizeof *ap)];
+
+    if (conf_str_from_bytes((void *)ap, sizeof *ap, buf, sizeof buf) == NULL) {
+        return OS_EINVAL;
+    }
+    wifi_persist_ap = *ap;
+    wifi_persist_have_loaded = true;
+
+    return conf_save_one("wifi/ap", buf);
+}
+
+int
+wifi_persist_init(void)
+{
+    return conf_register(&wifi_persist_conf_handler);
+}
+
+#endif
@@ -30,6 +30,14 @@ extern "C" {
 extern struct shell_cmd wifi_cli_cmd;
 #endif
 
+#if MYNEWT_VAL(WIFI_MGMT_PERSIST)
+struct wifi_ap;
+
+int wifi_persist_init(void);
+int wifi_persist_load(struct wifi_ap *ap);
+int wifi_persist_save(const struct wifi_ap *ap);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
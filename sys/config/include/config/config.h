@@ -165,6 +165,9 @@ struct conf_handler {
     conf_commit_handler_t ch_commit;
     /** Export configuration value */
     conf_export_handler_t ch_export;
+    /** @cond INTERNAL_HIDDEN */
+    SLIST_ENTRY(conf_handler) ch_hash_list;
+    /** @endcond */
 };
 
 void conf_init(void);
@@ -230,6 +233,29 @@ int conf_save_tree(char *name);
  */
 int conf_save_one(const char *name, char *var);
 
+/**
+ * Queue a single configuration value to be written to persisted storage.
+ * Repeated saves of the same name are coalesced in RAM; the latest value
+ * is written by conf_save_flush(), conf_commit(), or when the flush timer
+ * expires.  Meant for frequently updated values where losing the last
+ * update on an unexpected reset is acceptable.  Requires
+ * CONFIG_SAVE_CACHE.
+ *
+ * @param name Name/key of the configuration item.
+ * @param var Value of the configuration item.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_save_one_deferred(const char *name, char *var);
+
+/**
+ * Write all values queued with conf_save_one_deferred() to persisted
+ * storage.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_save_flush(void);
+
 /**
  * Set configuration item identified by @p name to be value @p val_str.
  * This finds the configuration handler for this subtree and calls it's
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SYS_CONFIG_BIN_H_
+#define __SYS_CONFIG_BIN_H_
+
+#include "fcb/fcb.h"
+#include "config/config.h"
+#include "config/config_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary config store, kept in an FCB.
+ *
+ * Each FCB element holds a struct conf_bin_hdr followed by the name and the
+ * raw value. Values saved through the generic store interface are kept as
+ * CONF_STRING; values saved with conf_bin_save_value() keep their native
+ * type and are only converted to a string if read back through conf_load().
+ */
+struct conf_bin {
+    struct conf_store cb_store;
+    struct fcb cb_fcb;
+};
+
+/** @cond INTERNAL_HIDDEN */
+struct conf_bin_hdr {
+    uint32_t cbh_hash;          /* FNV-1a of name */
+    uint8_t cbh_type;           /* enum conf_type; CONF_NONE if deleted */
+    uint8_t cbh_name_len;
+    uint16_t cbh_val_len;
+};
+/** @endcond */
+
+/**
+ * Add binary FCB as a source of persisted configuration
+ *
+ * @param cb Information regarding FCB area to add.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_bin_src(struct conf_bin *cb);
+
+/**
+ * Set binary FCB as the destination for persisting configuration
+ *
+ * @param cb Information regarding FCB area to add. This FCB area should have
+ *           been added using conf_bin_src() previously.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_bin_dst(struct conf_bin *cb);
+
+/**
+ * Persist a value in its native representation, without converting it to a
+ * string.
+ *
+ * @param cb   Binary store to write to.
+ * @param name Name of the configuration item.
+ * @param type Type of the value.
+ * @param val  Pointer to the value. NULL deletes the item.
+ * @param len  Length of the value; only used for CONF_BYTES. For CONF_STRING
+ *             the length is taken from the string.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_bin_save_value(struct conf_bin *cb, const char *name,
+                        enum conf_type type, const void *val, int len);
+
+/**
+ * Read the newest persisted value of a configuration item.
+ *
+ * Values stored with a different type than requested are converted if one
+ * of them is CONF_STRING.
+ *
+ * @param cb   Binary store to read from.
+ * @param name Name of the configuration item.
+ * @param type Type of the value.
+ * @param val  Where to store the value.
+ * @param len  On entry, size of the buffer at val; on return, the length of
+ *             the value.
+ *
+ * @return 0 on success, OS_ENOENT if the item is not stored or was deleted,
+ *         other non-zero value on failure.
+ */
+int conf_bin_load_value(struct conf_bin *cb, const char *name,
+                        enum conf_type type, void *val, int *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_CONFIG_BIN_H_ */
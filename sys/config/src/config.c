@@ -28,9 +28,20 @@
 
 struct conf_handler_head conf_handlers;
 
+/*
+ * Handlers hashed by name, so that lookups while loading don't need to
+ * compare against every registered handler.
+ */
+#define CONF_HANDLER_HASH_SIZE  MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE)
+
+static SLIST_HEAD(, conf_handler) conf_handler_hash[CONF_HANDLER_HASH_SIZE];
+
 static os_event_fn conf_ev_fn_load;
 
 static struct os_mutex conf_mtx;
+#if MYNEWT_VAL(OS_LOCK_PROF)
+static struct os_lock_prof conf_mtx_prof;
+#endif
 
 /* OS event - causes persisted config values to be loaded at startup. */
 static struct os_event conf_ev_load = {
@@ -41,10 +52,17 @@ void
 conf_init(void)
 {
     int rc;
+    int i;
 
     os_mutex_init(&conf_mtx);
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    os_mutex_prof_register(&conf_mtx, &conf_mtx_prof, "conf");
+#endif
 
     SLIST_INIT(&conf_handlers);
+    for (i = 0; i < CONF_HANDLER_HASH_SIZE; i++) {
+        SLIST_INIT(&conf_handler_hash[i]);
+    }
     conf_store_init();
 
     (void)rc;
@@ -77,11 +95,29 @@ conf_unlock(void)
     os_mutex_release(&conf_mtx);
 }
 
+static uint32_t
+conf_handler_hash_idx(const char *name)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619;
+    }
+    return hash % CONF_HANDLER_HASH_SIZE;
+}
+
 int
 conf_register(struct conf_handler *handler)
 {
+    uint32_t idx;
+
+    idx = conf_handler_hash_idx(handler->ch_name);
+
     conf_lock();
     SLIST_INSERT_HEAD(&conf_handlers, handler, ch_list);
+    SLIST_INSERT_HEAD(&conf_handler_hash[idx], handler, ch_hash_list);
     conf_unlock();
     return 0;
 }
@@ -100,7 +136,8 @@ conf_handler_lookup(char *name)
 {
     struct conf_handler *ch;
 
-    SLIST_FOREACH(ch, &conf_handlers, ch_list) {
+    SLIST_FOREACH(ch, &conf_handler_hash[conf_handler_hash_idx(name)],
+                  ch_hash_list) {
         if (!strcmp(name, ch->ch_name)) {
             return ch;
         }
@@ -342,6 +379,10 @@ conf_commit(char *name)
             }
         }
     }
+    rc2 = conf_save_flush();
+    if (!rc) {
+        rc = rc2;
+    }
 out:
     conf_unlock();
     return rc;
@@ -0,0 +1,560 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(CONFIG_BIN)
+
+#include <fcb/fcb.h>
+#include <string.h>
+
+#include "config/config.h"
+#include "config/config_store.h"
+#include "config/config_bin.h"
+#include "config_priv.h"
+
+#define CONF_BIN_VERS       1
+
+#define CONF_BIN_ELEM_MAX   \
+    (sizeof(struct conf_bin_hdr) + CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN)
+
+/*
+ * A decoded element. Name and value point into conf_bin_buf and are NUL
+ * terminated.
+ */
+struct conf_bin_elem {
+    struct conf_bin_hdr ce_hdr;
+    char *ce_name;
+    uint8_t *ce_val;
+};
+
+struct conf_bin_load_cb_arg {
+    conf_store_load_cb cb;
+    void *cb_arg;
+};
+
+struct conf_bin_find_arg {
+    const char *name;
+    uint32_t hash;
+    struct fcb_entry loc;
+    int found;
+};
+
+static int conf_bin_load(struct conf_store *, conf_store_load_cb cb,
+                         void *cb_arg);
+static int conf_bin_save(struct conf_store *, const char *name,
+                         const char *value);
+
+static struct conf_store_itf conf_bin_itf = {
+    .csi_load = conf_bin_load,
+    .csi_save = conf_bin_save,
+};
+
+/* Element buffer, protected by the config lock */
+static union {
+    struct conf_bin_hdr hdr;
+    uint8_t buf[CONF_BIN_ELEM_MAX + 2];
+} conf_bin_buf;
+
+static uint32_t
+conf_bin_hash(const char *name)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619;
+    }
+    return hash;
+}
+
+int
+conf_bin_src(struct conf_bin *cb)
+{
+    int rc;
+
+    cb->cb_fcb.f_version = CONF_BIN_VERS;
+    if (cb->cb_fcb.f_sector_cnt > 1) {
+        cb->cb_fcb.f_scratch_cnt = 1;
+    } else {
+        cb->cb_fcb.f_scratch_cnt = 0;
+    }
+    while (1) {
+        rc = fcb_init(&cb->cb_fcb);
+        if (rc) {
+            return OS_INVALID_PARM;
+        }
+
+        /*
+         * Check if system was reset in middle of emptying a sector. This
+         * situation is recognized by checking if the scratch block is missing.
+         */
+        if (cb->cb_fcb.f_scratch_cnt &&
+            fcb_free_sector_cnt(&cb->cb_fcb) < 1) {
+            flash_area_erase(cb->cb_fcb.f_active.fe_area, 0,
+              cb->cb_fcb.f_active.fe_area->fa_size);
+        } else {
+            break;
+        }
+    }
+
+    cb->cb_store.cs_itf = &conf_bin_itf;
+    conf_src_register(&cb->cb_store);
+
+    return OS_OK;
+}
+
+int
+conf_bin_dst(struct conf_bin *cb)
+{
+    cb->cb_store.cs_itf = &conf_bin_itf;
+    conf_dst_register(&cb->cb_store);
+
+    return OS_OK;
+}
+
+/*
+ * Read header and name of an element. Name is returned NUL terminated.
+ */
+static int
+conf_bin_read_hdr(struct fcb_entry *loc, struct conf_bin_hdr *hdr,
+                  char *name)
+{
+    int rc;
+
+    if (loc->fe_data_len < sizeof(*hdr)) {
+        return OS_EINVAL;
+    }
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, hdr, sizeof(*hdr));
+    if (rc) {
+        return OS_EINVAL;
+    }
+    if (hdr->cbh_name_len > CONF_MAX_NAME_LEN ||
+        hdr->cbh_val_len > CONF_MAX_VAL_LEN ||
+        sizeof(*hdr) + hdr->cbh_name_len + hdr->cbh_val_len >
+        loc->fe_data_len) {
+        return OS_EINVAL;
+    }
+    if (name) {
+        rc = flash_area_read(loc->fe_area, loc->fe_data_off + sizeof(*hdr),
+                             name, hdr->cbh_name_len);
+        if (rc) {
+            return OS_EINVAL;
+        }
+        name[hdr->cbh_name_len] = '\0';
+    }
+    return 0;
+}
+
+/*
+ * Read an element into conf_bin_buf.
+ */
+static int
+conf_bin_read_elem(struct fcb_entry *loc, struct conf_bin_elem *ce)
+{
+    int rc;
+
+    ce->ce_name = (char *)conf_bin_buf.buf + sizeof(ce->ce_hdr);
+    rc = conf_bin_read_hdr(loc, &ce->ce_hdr, ce->ce_name);
+    if (rc) {
+        return rc;
+    }
+    ce->ce_val = (uint8_t *)ce->ce_name + ce->ce_hdr.cbh_name_len + 1;
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off +
+                         sizeof(ce->ce_hdr) + ce->ce_hdr.cbh_name_len,
+                         ce->ce_val, ce->ce_hdr.cbh_val_len);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    ce->ce_val[ce->ce_hdr.cbh_val_len] = '\0';
+    return 0;
+}
+
+static int
+conf_bin_name_match(struct fcb_entry *loc, struct conf_bin_hdr *hdr,
+                    const char *name, uint32_t hash)
+{
+    char name2[CONF_MAX_NAME_LEN + 1];
+
+    /* Compare hashes first so that most names need not be read. */
+    if (conf_bin_read_hdr(loc, hdr, NULL)) {
+        return 0;
+    }
+    if (hdr->cbh_hash != hash || hdr->cbh_name_len != strlen(name)) {
+        return 0;
+    }
+    if (conf_bin_read_hdr(loc, hdr, name2)) {
+        return 0;
+    }
+    return !strcmp(name, name2);
+}
+
+/*
+ * Tells whether there is an entry with the same name after loc.
+ */
+static int
+conf_bin_is_replaced(struct fcb *fcb, struct fcb_entry *loc,
+                     const char *name, uint32_t hash)
+{
+    struct conf_bin_hdr hdr;
+    struct fcb_entry loc2;
+
+    loc2 = *loc;
+    while (fcb_getnext(fcb, &loc2) == 0) {
+        if (conf_bin_name_match(&loc2, &hdr, name, hash)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void
+conf_bin_compress(struct fcb *fcb)
+{
+    char name[CONF_MAX_NAME_LEN + 1];
+    struct conf_bin_hdr hdr;
+    struct fcb_entry loc1;
+    struct fcb_entry loc2;
+    int len;
+    int rc;
+
+    rc = fcb_append_to_scratch(fcb);
+    if (rc) {
+        return;
+    }
+
+    loc1.fe_area = NULL;
+    loc1.fe_elem_off = 0;
+    while (fcb_getnext(fcb, &loc1) == 0) {
+        if (loc1.fe_area != fcb->f_oldest) {
+            break;
+        }
+        rc = conf_bin_read_hdr(&loc1, &hdr, name);
+        if (rc) {
+            continue;
+        }
+        if (hdr.cbh_type == CONF_NONE) {
+            /* Deleted */
+            continue;
+        }
+        if (conf_bin_is_replaced(fcb, &loc1, name, hdr.cbh_hash)) {
+            continue;
+        }
+
+        /* Still current; copy the element as is. */
+        len = sizeof(hdr) + hdr.cbh_name_len + hdr.cbh_val_len;
+        rc = flash_area_read(loc1.fe_area, loc1.fe_data_off,
+                             conf_bin_buf.buf, len);
+        if (rc) {
+            continue;
+        }
+        rc = fcb_append(fcb, len, &loc2);
+        if (rc) {
+            continue;
+        }
+        rc = flash_area_write(loc2.fe_area, loc2.fe_data_off,
+                              conf_bin_buf.buf, len);
+        if (rc) {
+            continue;
+        }
+        fcb_append_finish(fcb, &loc2);
+    }
+    fcb_rotate(fcb);
+}
+
+/*
+ * Lay out an element in conf_bin_buf, returning its length.
+ */
+static int
+conf_bin_layout(const char *name, int name_len, uint8_t type,
+                const void *val, int val_len)
+{
+    struct conf_bin_hdr *hdr = &conf_bin_buf.hdr;
+
+    hdr->cbh_hash = conf_bin_hash(name);
+    hdr->cbh_type = type;
+    hdr->cbh_name_len = name_len;
+    hdr->cbh_val_len = val_len;
+    memcpy(conf_bin_buf.buf + sizeof(*hdr), name, name_len);
+    memcpy(conf_bin_buf.buf + sizeof(*hdr) + name_len, val, val_len);
+
+    return sizeof(*hdr) + name_len + val_len;
+}
+
+static int
+conf_bin_append(struct fcb *fcb, const char *name, uint8_t type,
+                const void *val, int val_len)
+{
+    struct fcb_entry loc;
+    int name_len;
+    int len;
+    int rc;
+    int i;
+
+    name_len = strlen(name);
+    if (name_len > CONF_MAX_NAME_LEN || val_len > CONF_MAX_VAL_LEN) {
+        return OS_INVALID_PARM;
+    }
+
+    for (i = 0; i < 10; i++) {
+        rc = fcb_append(fcb,
+                        sizeof(struct conf_bin_hdr) + name_len + val_len,
+                        &loc);
+        if (rc != FCB_ERR_NOSPACE) {
+            break;
+        }
+        if (fcb->f_scratch_cnt == 0) {
+            return OS_ENOMEM;
+        }
+        conf_bin_compress(fcb);
+    }
+    if (rc) {
+        return OS_EINVAL;
+    }
+
+    /*
+     * Header, name and value go to flash in a single write; FCB takes care
+     * of padding the element to the flash alignment.
+     */
+    len = conf_bin_layout(name, name_len, type, val, val_len);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, conf_bin_buf.buf,
+                          len);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    fcb_append_finish(fcb, &loc);
+    return OS_OK;
+}
+
+static int
+conf_bin_load_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_bin_load_cb_arg *argp = arg;
+    struct conf_bin_elem ce;
+    char str[CONF_MAX_VAL_LEN + 1];
+    union {
+        int64_t i64;
+        int32_t i32;
+        int16_t i16;
+        int8_t i8;
+        bool b;
+    } v;
+    char *val;
+
+    if (conf_bin_read_elem(loc, &ce)) {
+        return 0;
+    }
+
+    switch (ce.ce_hdr.cbh_type) {
+    case CONF_NONE:
+        val = NULL;
+        break;
+    case CONF_STRING:
+        val = (char *)ce.ce_val;
+        break;
+    case CONF_BYTES:
+        val = conf_str_from_bytes(ce.ce_val, ce.ce_hdr.cbh_val_len, str,
+                                  sizeof(str));
+        if (!val) {
+            return 0;
+        }
+        break;
+    default:
+        if (ce.ce_hdr.cbh_val_len > sizeof(v)) {
+            return 0;
+        }
+        memcpy(&v, ce.ce_val, ce.ce_hdr.cbh_val_len);
+        val = conf_str_from_value(ce.ce_hdr.cbh_type, &v, str, sizeof(str));
+        if (!val) {
+            return 0;
+        }
+        break;
+    }
+    argp->cb(ce.ce_name, val, argp->cb_arg);
+    return 0;
+}
+
+static int
+conf_bin_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
+{
+    struct conf_bin *cbs = (struct conf_bin *)cs;
+    struct conf_bin_load_cb_arg arg;
+    int rc;
+
+    arg.cb = cb;
+    arg.cb_arg = cb_arg;
+    rc = fcb_walk(&cbs->cb_fcb, 0, conf_bin_load_cb, &arg);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    return OS_OK;
+}
+
+static int
+conf_bin_save(struct conf_store *cs, const char *name, const char *value)
+{
+    struct conf_bin *cbs = (struct conf_bin *)cs;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+    if (!value) {
+        return conf_bin_append(&cbs->cb_fcb, name, CONF_NONE, NULL, 0);
+    }
+    return conf_bin_append(&cbs->cb_fcb, name, CONF_STRING, value,
+                           strlen(value));
+}
+
+static int
+conf_bin_find_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_bin_find_arg *cfa = arg;
+    struct conf_bin_hdr hdr;
+
+    if (conf_bin_name_match(loc, &hdr, cfa->name, cfa->hash)) {
+        cfa->loc = *loc;
+        cfa->found = 1;
+    }
+    return 0;
+}
+
+/*
+ * Find the newest element for name, and read it into conf_bin_buf.
+ */
+static int
+conf_bin_find(struct conf_bin *cb, const char *name, struct conf_bin_elem *ce)
+{
+    struct conf_bin_find_arg cfa;
+    int rc;
+
+    cfa.name = name;
+    cfa.hash = conf_bin_hash(name);
+    cfa.found = 0;
+    rc = fcb_walk(&cb->cb_fcb, 0, conf_bin_find_cb, &cfa);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    if (!cfa.found) {
+        return OS_ENOENT;
+    }
+    return conf_bin_read_elem(&cfa.loc, ce);
+}
+
+static int
+conf_bin_type_len(enum conf_type type, const void *val, int len)
+{
+    switch (type) {
+    case CONF_INT8:
+        return sizeof(int8_t);
+    case CONF_INT16:
+        return sizeof(int16_t);
+    case CONF_INT32:
+        return sizeof(int32_t);
+    case CONF_INT64:
+        return sizeof(int64_t);
+    case CONF_BOOL:
+        return sizeof(bool);
+    case CONF_STRING:
+        return strlen(val);
+    case CONF_BYTES:
+        return len;
+    default:
+        return -1;
+    }
+}
+
+int
+conf_bin_save_value(struct conf_bin *cb, const char *name,
+                    enum conf_type type, const void *val, int len)
+{
+    struct conf_bin_elem ce;
+    int rc;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+    if (!val) {
+        type = CONF_NONE;
+        len = 0;
+    } else {
+        len = conf_bin_type_len(type, val, len);
+        if (len < 0) {
+            return OS_INVALID_PARM;
+        }
+    }
+
+    conf_lock();
+
+    /* Don't store the same value again. */
+    rc = conf_bin_find(cb, name, &ce);
+    if (rc == 0 && ce.ce_hdr.cbh_type == type &&
+        ce.ce_hdr.cbh_val_len == len && !memcmp(ce.ce_val, val, len)) {
+        rc = 0;
+    } else {
+        rc = conf_bin_append(&cb->cb_fcb, name, type, val, len);
+    }
+
+    conf_unlock();
+    return rc;
+}
+
+int
+conf_bin_load_value(struct conf_bin *cb, const char *name,
+                    enum conf_type type, void *val, int *len)
+{
+    struct conf_bin_elem ce;
+    int rc;
+
+    conf_lock();
+
+    rc = conf_bin_find(cb, name, &ce);
+    if (rc) {
+        goto out;
+    }
+
+    if (ce.ce_hdr.cbh_type == CONF_NONE) {
+        rc = OS_ENOENT;
+    } else if (ce.ce_hdr.cbh_type == type) {
+        if (ce.ce_hdr.cbh_val_len + (type == CONF_STRING) > *len) {
+            rc = OS_INVALID_PARM;
+            goto out;
+        }
+        /* Strings are returned NUL terminated */
+        memcpy(val, ce.ce_val, ce.ce_hdr.cbh_val_len + (type == CONF_STRING));
+        *len = ce.ce_hdr.cbh_val_len;
+    } else if (ce.ce_hdr.cbh_type == CONF_STRING) {
+        if (type == CONF_BYTES) {
+            rc = conf_bytes_from_str((char *)ce.ce_val, val, len);
+        } else {
+            rc = conf_value_from_str((char *)ce.ce_val, type, val, *len);
+            if (rc == 0) {
+                *len = conf_bin_type_len(type, val, *len);
+            }
+        }
+    } else {
+        rc = OS_INVALID_PARM;
+    }
+
+out:
+    conf_unlock();
+    return rc;
+}
+
+#endif
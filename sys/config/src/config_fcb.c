@@ -32,11 +32,33 @@
 
 #define CONF_FCB_VERS		1
 
+#define CONF_FCB_BUF_LEN    (CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32)
+
 struct conf_fcb_load_cb_arg {
     conf_store_load_cb cb;
     void *cb_arg;
 };
 
+#if MYNEWT_VAL(CONFIG_FCB_LOAD_DEDUP)
+/*
+ * Location of the newest entry for each name, keyed by a hash of the name.
+ * Filled in by a first pass over the FCB, so that the second pass hands only
+ * the final value of each name to the load callback.
+ */
+struct conf_fcb_last {
+    struct flash_area *cfl_area;    /* NULL if slot is unused */
+    uint32_t cfl_data_off;
+    uint16_t cfl_data_len;
+    uint8_t cfl_multi;              /* More than one name has this hash */
+    uint32_t cfl_hash;
+};
+
+#define CONF_FCB_LAST_CNT   MYNEWT_VAL(CONFIG_FCB_LOAD_MAP_SIZE)
+
+/* Protected by the config lock, which is held by all callers of csi_load */
+static struct conf_fcb_last conf_fcb_last[CONF_FCB_LAST_CNT];
+#endif
+
 struct conf_kv_load_cb_arg {
     const char *name;
     char *value;
@@ -98,33 +120,140 @@ conf_fcb_dst(struct conf_fcb *cf)
     return OS_OK;
 }
 
+static int
+conf_fcb_line_read(struct flash_area *fa, uint32_t off, int len, char *buf,
+                   char **name, char **val)
+{
+    int rc;
+
+    if (len >= CONF_FCB_BUF_LEN) {
+        len = CONF_FCB_BUF_LEN - 1;
+    }
+
+    rc = flash_area_read(fa, off, buf, len);
+    if (rc) {
+        return rc;
+    }
+    buf[len] = '\0';
+
+    return conf_line_parse(buf, name, val);
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_LOAD_DEDUP)
+static uint32_t
+conf_fcb_name_hash(const char *name)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619;
+    }
+    return hash;
+}
+
+/*
+ * Returns the slot for given hash, or a free slot to put it in. NULL if the
+ * map is full.
+ */
+static struct conf_fcb_last *
+conf_fcb_last_find(uint32_t hash)
+{
+    struct conf_fcb_last *cfl;
+    int i;
+    int n;
+
+    i = hash % CONF_FCB_LAST_CNT;
+    for (n = 0; n < CONF_FCB_LAST_CNT; n++) {
+        cfl = &conf_fcb_last[i];
+        if (!cfl->cfl_area || cfl->cfl_hash == hash) {
+            return cfl;
+        }
+        if (++i == CONF_FCB_LAST_CNT) {
+            i = 0;
+        }
+    }
+    return NULL;
+}
+
+static int
+conf_fcb_last_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_fcb_last *cfl;
+    char buf1[CONF_FCB_BUF_LEN];
+    char buf2[CONF_FCB_BUF_LEN];
+    char *name1, *name2;
+    char *val;
+    uint32_t hash;
+    int rc;
+
+    rc = conf_fcb_line_read(loc->fe_area, loc->fe_data_off, loc->fe_data_len,
+                            buf1, &name1, &val);
+    if (rc) {
+        return 0;
+    }
+
+    hash = conf_fcb_name_hash(name1);
+    cfl = conf_fcb_last_find(hash);
+    if (!cfl) {
+        /* Not tracked; every entry with this name gets loaded */
+        return 0;
+    }
+    if (cfl->cfl_area && !cfl->cfl_multi) {
+        /* Same hash seen earlier; make sure it's the same name */
+        rc = conf_fcb_line_read(cfl->cfl_area, cfl->cfl_data_off,
+                                cfl->cfl_data_len, buf2, &name2, &val);
+        if (rc || strcmp(name1, name2)) {
+            cfl->cfl_multi = 1;
+        }
+    }
+    cfl->cfl_area = loc->fe_area;
+    cfl->cfl_data_off = loc->fe_data_off;
+    cfl->cfl_data_len = loc->fe_data_len;
+    cfl->cfl_hash = hash;
+
+    return 0;
+}
+
+/*
+ * Tells whether entry is the one which should be loaded for its name.
+ */
+static int
+conf_fcb_is_last(struct fcb_entry *loc, const char *name)
+{
+    struct conf_fcb_last *cfl;
+
+    cfl = conf_fcb_last_find(conf_fcb_name_hash(name));
+    if (!cfl || !cfl->cfl_area || cfl->cfl_multi) {
+        return 1;
+    }
+    return cfl->cfl_area == loc->fe_area &&
+           cfl->cfl_data_off == loc->fe_data_off;
+}
+#endif
+
 static int
 conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
 {
     struct conf_fcb_load_cb_arg *argp;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf[CONF_FCB_BUF_LEN];
     char *name_str;
     char *val_str;
     int rc;
-    int len;
 
     argp = (struct conf_fcb_load_cb_arg *)arg;
 
-    len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
-    }
-
-    rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
+    rc = conf_fcb_line_read(loc->fe_area, loc->fe_data_off, loc->fe_data_len,
+                            buf, &name_str, &val_str);
     if (rc) {
         return 0;
     }
-    buf[len] = '\0';
-
-    rc = conf_line_parse(buf, &name_str, &val_str);
-    if (rc) {
+#if MYNEWT_VAL(CONFIG_FCB_LOAD_DEDUP)
+    if (!conf_fcb_is_last(loc, name_str)) {
         return 0;
     }
+#endif
     argp->cb(name_str, val_str, argp->cb_arg);
     return 0;
 }
@@ -136,6 +265,14 @@ conf_fcb_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
     struct conf_fcb_load_cb_arg arg;
     int rc;
 
+#if MYNEWT_VAL(CONFIG_FCB_LOAD_DEDUP)
+    memset(conf_fcb_last, 0, sizeof(conf_fcb_last));
+    rc = fcb_walk(&cf->cf_fcb, 0, conf_fcb_last_cb, NULL);
+    if (rc) {
+        return OS_EINVAL;
+    }
+#endif
+
     arg.cb = cb;
     arg.cb_arg = cb_arg;
     rc = fcb_walk(&cf->cf_fcb, 0, conf_fcb_load_cb, &arg);
@@ -88,6 +88,48 @@ config_init_fcb(void)
     SYSINIT_PANIC_ASSERT(rc == 0);
 }
 
+#elif MYNEWT_VAL(CONFIG_BIN)
+#include "fcb/fcb.h"
+#include "config/config_bin.h"
+
+static struct flash_area conf_bin_area[MYNEWT_VAL(CONFIG_BIN_NUM_AREAS) + 1];
+
+static struct conf_bin config_init_conf_bin = {
+    .cb_fcb.f_magic = MYNEWT_VAL(CONFIG_BIN_MAGIC),
+    .cb_fcb.f_sectors = conf_bin_area,
+};
+
+static void
+config_init_bin(void)
+{
+    int cnt;
+    int rc;
+
+    rc = flash_area_to_sectors(MYNEWT_VAL(CONFIG_BIN_FLASH_AREA), &cnt, NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    SYSINIT_PANIC_ASSERT(
+        cnt <= sizeof(conf_bin_area) / sizeof(conf_bin_area[0]));
+    flash_area_to_sectors(
+        MYNEWT_VAL(CONFIG_BIN_FLASH_AREA), &cnt, conf_bin_area);
+
+    config_init_conf_bin.cb_fcb.f_sector_cnt = cnt;
+
+    rc = conf_bin_src(&config_init_conf_bin);
+    if (rc) {
+        for (cnt = 0;
+             cnt < config_init_conf_bin.cb_fcb.f_sector_cnt;
+             cnt++) {
+
+            flash_area_erase(&conf_bin_area[cnt], 0,
+                             conf_bin_area[cnt].fa_size);
+        }
+        rc = conf_bin_src(&config_init_conf_bin);
+    }
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    rc = conf_bin_dst(&config_init_conf_bin);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
 #endif
 #endif
 
@@ -104,6 +146,8 @@ config_pkg_init(void)
     config_init_fs();
 #elif MYNEWT_VAL(CONFIG_FCB)
     config_init_fcb();
+#elif MYNEWT_VAL(CONFIG_BIN)
+    config_init_bin();
 #endif
 #endif
 }
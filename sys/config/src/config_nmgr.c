@@ -41,16 +41,136 @@ static struct mgmt_group conf_nmgr_group = {
     .mg_group_id = MGMT_GROUP_ID_CONFIG
 };
 
+/*
+ * State for encoding the values under a prefix.  Export callbacks don't take
+ * an argument; access is serialized by conf_lock().
+ */
+static struct {
+    CborEncoder *enc;
+    const char *prefix;
+    int prefix_len;
+    CborError err;
+} conf_nmgr_exp;
+
+/*
+ * Returns true if name is prefix itself, or lies in the subtree under it.
+ */
+static bool
+conf_nmgr_prefix_match(const char *name, const char *prefix, int prefix_len)
+{
+    if (prefix_len == 0) {
+        return true;
+    }
+    if (strncmp(name, prefix, prefix_len)) {
+        return false;
+    }
+    return prefix[prefix_len - 1] == '/' || name[prefix_len] == '\0' ||
+      name[prefix_len] == '/';
+}
+
+static void
+conf_nmgr_export_one(char *name, char *val)
+{
+    if (!conf_nmgr_prefix_match(name, conf_nmgr_exp.prefix,
+                                conf_nmgr_exp.prefix_len)) {
+        return;
+    }
+    conf_nmgr_exp.err |= cbor_encode_text_stringz(conf_nmgr_exp.enc, name);
+    if (val) {
+        conf_nmgr_exp.err |= cbor_encode_text_stringz(conf_nmgr_exp.enc, val);
+    } else {
+        conf_nmgr_exp.err |= cbor_encode_null(conf_nmgr_exp.enc);
+    }
+}
+
+/*
+ * Encodes the running values of all settings under prefix.  Handlers whose
+ * subtree cannot contain the prefix are not asked to export.
+ */
+static CborError
+conf_nmgr_read_prefix(CborEncoder *enc, const char *prefix)
+{
+    struct conf_handler *ch;
+    int len;
+    CborError err;
+
+    conf_lock();
+    conf_nmgr_exp.enc = enc;
+    conf_nmgr_exp.prefix = prefix;
+    conf_nmgr_exp.prefix_len = strlen(prefix);
+    conf_nmgr_exp.err = CborNoError;
+
+    len = strcspn(prefix, "/");
+    SLIST_FOREACH(ch, &conf_handlers, ch_list) {
+        if (!ch->ch_export) {
+            continue;
+        }
+        if (len && (strncmp(ch->ch_name, prefix, len) ||
+                    ch->ch_name[len] != '\0')) {
+            continue;
+        }
+        ch->ch_export(conf_nmgr_export_one, CONF_EXPORT_SHOW);
+    }
+    err = conf_nmgr_exp.err;
+    conf_unlock();
+
+    return err;
+}
+
+/*
+ * Encodes the values of the names listed in an array; names which don't
+ * resolve get a null value.
+ */
+static int
+conf_nmgr_read_names(CborEncoder *enc, CborValue *names)
+{
+    char name_str[CONF_MAX_NAME_LEN];
+    char val_str[CONF_MAX_VAL_LEN];
+    CborValue it;
+    CborError g_err = CborNoError;
+    size_t len;
+    char *val;
+
+    if (cbor_value_enter_container(names, &it)) {
+        return MGMT_ERR_EINVAL;
+    }
+    while (!cbor_value_at_end(&it)) {
+        if (!cbor_value_is_text_string(&it)) {
+            return MGMT_ERR_EINVAL;
+        }
+        len = sizeof(name_str);
+        if (cbor_value_copy_text_string(&it, name_str, &len, &it)) {
+            return MGMT_ERR_EINVAL;
+        }
+        g_err |= cbor_encode_text_stringz(enc, name_str);
+        val = conf_get_value(name_str, val_str, sizeof(val_str));
+        if (val) {
+            g_err |= cbor_encode_text_stringz(enc, val);
+        } else {
+            g_err |= cbor_encode_null(enc);
+        }
+    }
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
 static int
 conf_nmgr_read(struct mgmt_cbuf *cb)
 {
     int rc;
     char name_str[CONF_MAX_NAME_LEN];
+    char prefix_str[CONF_MAX_NAME_LEN];
     char val_str[CONF_MAX_VAL_LEN];
     char *val;
+    CborValue req;
+    CborValue names;
+    CborValue prefix;
+    CborEncoder vals;
     CborError g_err = CborNoError;
 
-    const struct cbor_attr_t attr[2] = {
+    const struct cbor_attr_t attr[3] = {
         [0] = {
             .attribute = "name",
             .type = CborAttrTextStringType,
@@ -58,22 +178,66 @@ conf_nmgr_read(struct mgmt_cbuf *cb)
             .len = sizeof(name_str)
         },
         [1] = {
+            .attribute = "prefix",
+            .type = CborAttrTextStringType,
+            .addr.string = prefix_str,
+            .len = sizeof(prefix_str)
+        },
+        [2] = {
             .attribute = NULL
         }
     };
 
+    if (!cbor_value_is_map(&cb->it)) {
+        return MGMT_ERR_EINVAL;
+    }
+    req = cb->it;
+    name_str[0] = '\0';
+    prefix_str[0] = '\0';
+
     rc = cbor_read_object(&cb->it, attr);
     if (rc) {
         return MGMT_ERR_EINVAL;
     }
-
-    val = conf_get_value(name_str, val_str, sizeof(val_str));
-    if (!val) {
+    if (cbor_value_map_find_value(&req, "names", &names) ||
+        cbor_value_map_find_value(&req, "prefix", &prefix)) {
         return MGMT_ERR_EINVAL;
     }
 
-    g_err |= cbor_encode_text_stringz(&cb->encoder, "val");
-    g_err |= cbor_encode_text_stringz(&cb->encoder, val);
+    if (!cbor_value_is_valid(&names) && !cbor_value_is_valid(&prefix)) {
+        val = conf_get_value(name_str, val_str, sizeof(val_str));
+        if (!val) {
+            return MGMT_ERR_EINVAL;
+        }
+
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "val");
+        g_err |= cbor_encode_text_stringz(&cb->encoder, val);
+
+        if (g_err) {
+            return MGMT_ERR_ENOMEM;
+        }
+        return 0;
+    }
+
+    /*
+     * Batch read: values of a list of names, or of all settings under a
+     * prefix, returned as a map from name to value.
+     */
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "vals");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &vals,
+                                     CborIndefiniteLength);
+    if (cbor_value_is_array(&names)) {
+        rc = conf_nmgr_read_names(&vals, &names);
+        if (rc) {
+            return rc;
+        }
+    } else if (cbor_value_is_valid(&names)) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (cbor_value_is_valid(&prefix)) {
+        g_err |= conf_nmgr_read_prefix(&vals, prefix_str);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &vals);
 
     if (g_err) {
         return MGMT_ERR_ENOMEM;
@@ -81,6 +245,51 @@ conf_nmgr_read(struct mgmt_cbuf *cb)
     return 0;
 }
 
+/*
+ * Sets the values in a map from name to value; a null value deletes the
+ * setting.  Stops at the first value which can't be set.
+ */
+static int
+conf_nmgr_write_vals(CborValue *vals)
+{
+    char name_str[CONF_MAX_NAME_LEN];
+    char val_str[CONF_MAX_VAL_LEN];
+    CborValue it;
+    size_t len;
+    int rc;
+
+    if (cbor_value_enter_container(vals, &it)) {
+        return MGMT_ERR_EINVAL;
+    }
+    while (!cbor_value_at_end(&it)) {
+        if (!cbor_value_is_text_string(&it)) {
+            return MGMT_ERR_EINVAL;
+        }
+        len = sizeof(name_str);
+        if (cbor_value_copy_text_string(&it, name_str, &len, &it)) {
+            return MGMT_ERR_EINVAL;
+        }
+        if (cbor_value_is_null(&it)) {
+            rc = conf_set_value(name_str, NULL);
+            if (cbor_value_advance_fixed(&it)) {
+                return MGMT_ERR_EINVAL;
+            }
+        } else if (cbor_value_is_text_string(&it)) {
+            len = sizeof(val_str);
+            if (cbor_value_copy_text_string(&it, val_str, &len, &it)) {
+                return MGMT_ERR_EINVAL;
+            }
+            rc = conf_set_value(name_str, val_str);
+        } else {
+            return MGMT_ERR_EINVAL;
+        }
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+    return 0;
+}
+
 static int
 conf_nmgr_write(struct mgmt_cbuf *cb)
 {
@@ -88,6 +297,8 @@ conf_nmgr_write(struct mgmt_cbuf *cb)
     char name_str[CONF_MAX_NAME_LEN];
     char val_str[CONF_MAX_VAL_LEN];
     bool do_save = false;
+    CborValue req;
+    CborValue vals;
     const struct cbor_attr_t val_attr[] = {
         [0] = {
             .attribute = "name",
@@ -110,11 +321,16 @@ conf_nmgr_write(struct mgmt_cbuf *cb)
             .attribute = NULL
         }
     };
+    CBORATTR_INDEX_DEFINE(val_idx, 3);
 
+    if (!cbor_value_is_map(&cb->it)) {
+        return MGMT_ERR_EINVAL;
+    }
+    req = cb->it;
     name_str[0] = '\0';
     val_str[0] = '\0';
 
-    rc = cbor_read_object(&cb->it, val_attr);
+    rc = cbor_read_object_indexed(&cb->it, val_attr, &val_idx);
     if (rc) {
         return MGMT_ERR_EINVAL;
     }
@@ -129,6 +345,23 @@ conf_nmgr_write(struct mgmt_cbuf *cb)
             return MGMT_ERR_EINVAL;
         }
     }
+
+    /*
+     * Batch write: all values in "vals" are set before the single commit
+     * and save below.
+     */
+    if (cbor_value_map_find_value(&req, "vals", &vals)) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (cbor_value_is_map(&vals)) {
+        rc = conf_nmgr_write_vals(&vals);
+        if (rc) {
+            return rc;
+        }
+    } else if (cbor_value_is_valid(&vals)) {
+        return MGMT_ERR_EINVAL;
+    }
+
     rc = conf_commit(NULL);
     if (rc) {
         return MGMT_ERR_EINVAL;
@@ -130,19 +130,13 @@ conf_dup_check_cb(char *name, char *val, void *cb_arg)
 
 /*
  * Append a single value to persisted config. Don't store duplicate value.
+ * Must be called with config lock held.
  */
-int
-conf_save_one(const char *name, char *value)
+static int
+conf_save_one_write(const char *name, char *value)
 {
     struct conf_store *cs;
     struct conf_dup_check_arg cdca;
-    int rc;
-
-    conf_lock();
-    if (!conf_save_dst) {
-        rc = OS_ENOENT;
-        goto out;
-    }
 
     /*
      * Check if we're writing the same value again.
@@ -154,11 +148,195 @@ conf_save_one(const char *name, char *value)
         cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
     }
     if (cdca.is_dup == 1) {
-        rc = 0;
-        goto out;
+        return 0;
     }
     cs = conf_save_dst;
-    rc = cs->cs_itf->csi_save(cs, name, value);
+    return cs->cs_itf->csi_save(cs, name, value);
+}
+
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+/*
+ * Write-back cache for conf_save_one_deferred().  Holds the latest value
+ * of each name; older values of the same name are simply overwritten.
+ */
+struct conf_save_cache_entry {
+    char csce_name[CONF_MAX_NAME_LEN + 1];
+    char csce_val[MYNEWT_VAL(CONFIG_SAVE_CACHE_VAL_LEN) + 1];
+    uint8_t csce_used:1;
+    uint8_t csce_null:1;
+};
+
+static struct conf_save_cache_entry
+    conf_save_cache[MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT)];
+static int conf_save_cache_cnt;
+
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_FLUSH_MS) > 0
+static struct os_callout conf_save_cache_timer;
+
+static void
+conf_save_cache_timer_cb(struct os_event *ev)
+{
+    conf_save_flush();
+}
+#endif
+
+static struct conf_save_cache_entry *
+conf_save_cache_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT); i++) {
+        if (conf_save_cache[i].csce_used &&
+          !strcmp(conf_save_cache[i].csce_name, name)) {
+            return &conf_save_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+conf_save_cache_drop(struct conf_save_cache_entry *csce)
+{
+    csce->csce_used = 0;
+    conf_save_cache_cnt--;
+}
+
+int
+conf_save_one_deferred(const char *name, char *value)
+{
+    struct conf_save_cache_entry *csce;
+    int rc;
+    int i;
+
+    conf_lock();
+    if (!conf_save_dst) {
+        rc = OS_ENOENT;
+        goto out;
+    }
+
+    csce = conf_save_cache_find(name);
+    if (strlen(name) > CONF_MAX_NAME_LEN ||
+      (value && strlen(value) > MYNEWT_VAL(CONFIG_SAVE_CACHE_VAL_LEN))) {
+        /*
+         * Does not fit; the new value supersedes whatever was pending.
+         */
+        if (csce) {
+            conf_save_cache_drop(csce);
+        }
+        rc = conf_save_one_write(name, value);
+        goto out;
+    }
+
+    if (!csce) {
+        if (conf_save_cache_cnt == MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT)) {
+            rc = conf_save_flush();
+            if (rc) {
+                rc = conf_save_one_write(name, value);
+                goto out;
+            }
+        }
+        for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT); i++) {
+            if (!conf_save_cache[i].csce_used) {
+                csce = &conf_save_cache[i];
+                break;
+            }
+        }
+        strcpy(csce->csce_name, name);
+        csce->csce_used = 1;
+        conf_save_cache_cnt++;
+    }
+    if (value) {
+        strcpy(csce->csce_val, value);
+        csce->csce_null = 0;
+    } else {
+        csce->csce_val[0] = '\0';
+        csce->csce_null = 1;
+    }
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_FLUSH_MS) > 0
+    if (!os_callout_queued(&conf_save_cache_timer)) {
+        os_callout_reset(&conf_save_cache_timer,
+          os_time_ms_to_ticks32(MYNEWT_VAL(CONFIG_SAVE_CACHE_FLUSH_MS)));
+    }
+#endif
+    rc = 0;
+out:
+    conf_unlock();
+    return rc;
+}
+#endif
+
+int
+conf_save_flush(void)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+    struct conf_save_cache_entry *csce;
+    int rc;
+    int rc2;
+    int i;
+
+    conf_lock();
+    rc = 0;
+    if (!conf_save_cache_cnt) {
+        goto out;
+    }
+    if (!conf_save_dst) {
+        rc = OS_ENOENT;
+        goto out;
+    }
+    for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT); i++) {
+        csce = &conf_save_cache[i];
+        if (!csce->csce_used) {
+            continue;
+        }
+        rc2 = conf_save_one_write(csce->csce_name,
+                                  csce->csce_null ? NULL : csce->csce_val);
+        if (rc2) {
+            /*
+             * Leave it pending, next flush will retry.
+             */
+            if (!rc) {
+                rc = rc2;
+            }
+            continue;
+        }
+        conf_save_cache_drop(csce);
+    }
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_FLUSH_MS) > 0
+    if (!conf_save_cache_cnt) {
+        os_callout_stop(&conf_save_cache_timer);
+    }
+#endif
+out:
+    conf_unlock();
+    return rc;
+#else
+    return 0;
+#endif
+}
+
+int
+conf_save_one(const char *name, char *value)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+    struct conf_save_cache_entry *csce;
+#endif
+    int rc;
+
+    conf_lock();
+    if (!conf_save_dst) {
+        rc = OS_ENOENT;
+        goto out;
+    }
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+    /*
+     * This write supersedes any deferred save of the same name.
+     */
+    csce = conf_save_cache_find(name);
+    if (csce) {
+        conf_save_cache_drop(csce);
+    }
+#endif
+    rc = conf_save_one_write(name, value);
 out:
     conf_unlock();
     return rc;
@@ -239,4 +417,12 @@ conf_store_init(void)
 {
     conf_loaded = false;
     SLIST_INIT(&conf_load_srcs);
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+    memset(conf_save_cache, 0, sizeof(conf_save_cache));
+    conf_save_cache_cnt = 0;
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_FLUSH_MS) > 0
+    os_callout_init(&conf_save_cache_timer, os_eventq_dflt_get(),
+                    conf_save_cache_timer_cb, NULL);
+#endif
+#endif
 }
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <flash_map/flash_map.h>
+#include <testutil/testutil.h>
+#include <fcb/fcb.h>
+#include "config/config.h"
+#include "config/config_bin.h"
+#include "config_priv.h"
+#include "conf_test_bin.h"
+
+int8_t val8;
+int64_t val64;
+char val_str[CONF_MAX_VAL_LEN];
+
+static char *
+ctest_bin_get(int argc, char **argv, char *val, int val_len_max)
+{
+    if (argc == 1 && !strcmp(argv[0], "v8")) {
+        return conf_str_from_value(CONF_INT8, &val8, val, val_len_max);
+    }
+    if (argc == 1 && !strcmp(argv[0], "v64")) {
+        return conf_str_from_value(CONF_INT64, &val64, val, val_len_max);
+    }
+    if (argc == 1 && !strcmp(argv[0], "str")) {
+        return val_str;
+    }
+    return NULL;
+}
+
+static int
+ctest_bin_set(int argc, char **argv, char *val)
+{
+    if (argc == 1 && !strcmp(argv[0], "v8")) {
+        return CONF_VALUE_SET(val, CONF_INT8, val8);
+    }
+    if (argc == 1 && !strcmp(argv[0], "v64")) {
+        return CONF_VALUE_SET(val, CONF_INT64, val64);
+    }
+    if (argc == 1 && !strcmp(argv[0], "str")) {
+        return CONF_VALUE_SET(val, CONF_STRING, val_str);
+    }
+    return OS_ENOENT;
+}
+
+static int
+ctest_bin_export(void (*cb)(char *name, char *value),
+                 enum conf_export_tgt tgt)
+{
+    char value[32];
+
+    conf_str_from_value(CONF_INT8, &val8, value, sizeof(value));
+    cb("tb/v8", value);
+
+    conf_str_from_value(CONF_INT64, &val64, value, sizeof(value));
+    cb("tb/v64", value);
+
+    cb("tb/str", val_str);
+
+    return 0;
+}
+
+struct conf_handler config_test_bin_handler = {
+    .ch_name = "tb",
+    .ch_get = ctest_bin_get,
+    .ch_set = ctest_bin_set,
+    .ch_export = ctest_bin_export,
+};
+
+struct flash_area fcb_areas[] = {
+    [0] = {
+        .fa_off = 0x00000000,
+        .fa_size = 16 * 1024
+    },
+    [1] = {
+        .fa_off = 0x00004000,
+        .fa_size = 16 * 1024
+    },
+    [2] = {
+        .fa_off = 0x00008000,
+        .fa_size = 16 * 1024
+    },
+    [3] = {
+        .fa_off = 0x0000c000,
+        .fa_size = 16 * 1024
+    }
+};
+
+void
+config_wipe_srcs(void)
+{
+    SLIST_INIT(&conf_load_srcs);
+    conf_save_dst = NULL;
+}
+
+void
+config_wipe_fcb(struct flash_area *fa, int cnt)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_erase(&fa[i], 0, fa[i].fa_size);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+/*
+ * Wipe flash and register a fresh binary store as source and destination.
+ */
+void
+config_test_bin_setup(struct conf_bin *cb)
+{
+    int rc;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(cb, 0, sizeof(*cb));
+    cb->cb_fcb.f_magic = MYNEWT_VAL(CONFIG_BIN_MAGIC);
+    cb->cb_fcb.f_sectors = fcb_areas;
+    cb->cb_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_bin_src(cb);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_bin_dst(cb);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE_DECL(config_test_bin_save_load)
+TEST_CASE_DECL(config_test_bin_typed)
+TEST_CASE_DECL(config_test_bin_compress)
+
+TEST_SUITE(config_test_bin_all)
+{
+    int rc;
+
+    rc = conf_register(&config_test_bin_handler);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    config_test_bin_save_load();
+    config_test_bin_typed();
+    config_test_bin_compress();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    conf_init();
+    config_test_bin_all();
+
+    return tu_any_failed;
+}
+
+#endif
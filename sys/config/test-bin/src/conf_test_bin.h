@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _CONF_TEST_BIN_H
+#define _CONF_TEST_BIN_H
+
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include <flash_map/flash_map.h>
+#include <testutil/testutil.h>
+#include <fcb/fcb.h>
+#include <config/config.h>
+#include <config/config_bin.h>
+#include "config_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONF_TEST_BIN_FLASH_CNT   4
+
+extern struct flash_area fcb_areas[CONF_TEST_BIN_FLASH_CNT];
+
+extern int8_t val8;
+extern int64_t val64;
+extern char val_str[CONF_MAX_VAL_LEN];
+
+extern struct conf_handler config_test_bin_handler;
+
+void config_wipe_srcs(void);
+void config_wipe_fcb(struct flash_area *fa, int cnt);
+void config_test_bin_setup(struct conf_bin *cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CONF_TEST_BIN_H */
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_bin.h"
+
+TEST_CASE(config_test_bin_compress)
+{
+    struct conf_bin cb;
+    int32_t i32;
+    int len;
+    int rc;
+    int i;
+
+    config_test_bin_setup(&cb);
+
+    i32 = 7;
+    rc = conf_bin_save_value(&cb, "tb/keep", CONF_INT32, &i32, 0);
+    TEST_ASSERT(rc == 0);
+
+    /* Write enough to wrap around all sectors a few times. */
+    for (i = 0; i < 4000; i++) {
+        rc = conf_bin_save_value(&cb, "tb/v64", CONF_INT32, &i, 0);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(cb.cb_fcb.f_oldest != &fcb_areas[0]);
+
+    len = sizeof(i32);
+    rc = conf_bin_load_value(&cb, "tb/keep", CONF_INT32, &i32, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(i32 == 7);
+
+    len = sizeof(i32);
+    rc = conf_bin_load_value(&cb, "tb/v64", CONF_INT32, &i32, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(i32 == 3999);
+}
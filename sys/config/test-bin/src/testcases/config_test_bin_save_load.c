@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_bin.h"
+
+TEST_CASE(config_test_bin_save_load)
+{
+    struct conf_bin cb;
+    char str[16];
+    int len;
+    int rc;
+
+    config_test_bin_setup(&cb);
+
+    val8 = 33;
+    val64 = 0x1122334455667788LL;
+    strcpy(val_str, "hello");
+    rc = conf_save();
+    TEST_ASSERT(rc == 0);
+
+    val8 = 0;
+    val64 = 0;
+    val_str[0] = '\0';
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 33);
+    TEST_ASSERT(val64 == 0x1122334455667788LL);
+    TEST_ASSERT(!strcmp(val_str, "hello"));
+
+    /* Newest value wins. */
+    rc = conf_save_one("tb/v8", "-5");
+    TEST_ASSERT(rc == 0);
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == -5);
+
+    rc = conf_save_one("tb/str", NULL);
+    TEST_ASSERT(rc == 0);
+    len = sizeof(str);
+    rc = conf_bin_load_value(&cb, "tb/str", CONF_STRING, str, &len);
+    TEST_ASSERT(rc == OS_ENOENT);
+}
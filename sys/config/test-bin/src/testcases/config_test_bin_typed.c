@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_bin.h"
+
+TEST_CASE(config_test_bin_typed)
+{
+    struct conf_bin cb;
+    uint8_t bytes[5] = { 1, 2, 0, 4, 5 };
+    uint8_t bytes_out[8];
+    char str[16];
+    int32_t i32;
+    int len;
+    int rc;
+
+    config_test_bin_setup(&cb);
+
+    len = sizeof(i32);
+    rc = conf_bin_load_value(&cb, "tb/v64", CONF_INT32, &i32, &len);
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    /* Native values read back as is, and through conf_load() as text. */
+    i32 = 100;
+    rc = conf_bin_save_value(&cb, "tb/v64", CONF_INT32, &i32, 0);
+    TEST_ASSERT(rc == 0);
+    rc = conf_bin_save_value(&cb, "tb/raw", CONF_BYTES, bytes, sizeof(bytes));
+    TEST_ASSERT(rc == 0);
+
+    i32 = 0;
+    len = sizeof(i32);
+    rc = conf_bin_load_value(&cb, "tb/v64", CONF_INT32, &i32, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(i32 == 100);
+    TEST_ASSERT(len == sizeof(i32));
+
+    len = sizeof(bytes_out);
+    rc = conf_bin_load_value(&cb, "tb/raw", CONF_BYTES, bytes_out, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == sizeof(bytes));
+    TEST_ASSERT(!memcmp(bytes, bytes_out, sizeof(bytes)));
+
+    val64 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val64 == 100);
+
+    /* Values saved as text are converted on typed reads. */
+    rc = conf_save_one("tb/v8", "12");
+    TEST_ASSERT(rc == 0);
+    len = sizeof(i32);
+    rc = conf_bin_load_value(&cb, "tb/v8", CONF_INT32, &i32, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(i32 == 12);
+
+    len = sizeof(str);
+    rc = conf_bin_load_value(&cb, "tb/v8", CONF_STRING, str, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(str, "12"));
+
+    /* Deleted values are gone. */
+    rc = conf_bin_save_value(&cb, "tb/raw", CONF_BYTES, NULL, 0);
+    TEST_ASSERT(rc == 0);
+    len = sizeof(bytes_out);
+    rc = conf_bin_load_value(&cb, "tb/raw", CONF_BYTES, bytes_out, &len);
+    TEST_ASSERT(rc == OS_ENOENT);
+}
@@ -319,6 +319,7 @@ config_test_fill_area(
 
 TEST_CASE_DECL(config_empty_lookups)
 TEST_CASE_DECL(config_test_insert)
+TEST_CASE_DECL(config_test_lookup_many)
 TEST_CASE_DECL(config_test_getset_unknown)
 TEST_CASE_DECL(config_test_getset_int)
 TEST_CASE_DECL(config_test_getset_bytes)
@@ -333,6 +334,8 @@ TEST_CASE_DECL(config_test_save_3_fcb)
 TEST_CASE_DECL(config_test_compress_reset)
 TEST_CASE_DECL(config_test_save_one_fcb)
 TEST_CASE_DECL(config_test_custom_compress)
+TEST_CASE_DECL(config_test_load_last_fcb)
+TEST_CASE_DECL(config_test_save_deferred)
 
 TEST_SUITE(config_test_all)
 {
@@ -341,6 +344,7 @@ TEST_SUITE(config_test_all)
      */
     config_empty_lookups();
     config_test_insert();
+    config_test_lookup_many();
     config_test_getset_unknown();
     config_test_getset_int();
     config_test_getset_bytes();
@@ -365,6 +369,8 @@ TEST_SUITE(config_test_all)
     config_test_custom_compress();
 
     config_test_save_one_fcb();
+    config_test_load_last_fcb();
+    config_test_save_deferred();
 }
 
 #if MYNEWT_VAL(SELFTEST)
@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+static int load_last_set_cnt;
+static char load_last_a[8];
+
+static int
+load_last_handle_set(int argc, char **argv, char *val)
+{
+    load_last_set_cnt++;
+    if (argc == 1 && !strcmp(argv[0], "a")) {
+        strcpy(load_last_a, val ? val : "");
+    }
+    return 0;
+}
+
+static struct conf_handler load_last_handler = {
+    .ch_name = "ll",
+    .ch_set = load_last_handle_set,
+};
+
+TEST_CASE(config_test_load_last_fcb)
+{
+    struct conf_fcb cf;
+    char val[8];
+    int rc;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_register(&load_last_handler);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < 10; i++) {
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_save_one("ll/a", val);
+        TEST_ASSERT(rc == 0);
+        rc = conf_save_one("ll/b", val);
+        TEST_ASSERT(rc == 0);
+    }
+    rc = conf_save_one("ll/b", NULL);
+    TEST_ASSERT(rc == 0);
+
+    load_last_set_cnt = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(load_last_a, "9"));
+
+#if MYNEWT_VAL(CONFIG_FCB_LOAD_DEDUP)
+    /* Only the newest value of each name is handed to the handler. */
+    TEST_ASSERT(load_last_set_cnt == 2);
+#else
+    TEST_ASSERT(load_last_set_cnt == 21);
+#endif
+}
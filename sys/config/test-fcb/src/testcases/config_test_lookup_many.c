@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+#include "conf_test_fcb.h"
+
+#define CONFIG_TEST_LOOKUP_CNT  24
+
+static char lookup_names[CONFIG_TEST_LOOKUP_CNT][8];
+static struct conf_handler lookup_handlers[CONFIG_TEST_LOOKUP_CNT];
+
+static int
+lookup_handle_set(int argc, char **argv, char *val)
+{
+    return 0;
+}
+
+TEST_CASE(config_test_lookup_many)
+{
+    struct conf_handler *ch;
+    char name[16];
+    char *name_argv[CONF_MAX_DIR_DEPTH];
+    int name_argc;
+    int rc;
+    int i;
+
+    for (i = 0; i < CONFIG_TEST_LOOKUP_CNT; i++) {
+        snprintf(lookup_names[i], sizeof(lookup_names[i]), "lk%d", i);
+        lookup_handlers[i].ch_name = lookup_names[i];
+        lookup_handlers[i].ch_set = lookup_handle_set;
+        rc = conf_register(&lookup_handlers[i]);
+        TEST_ASSERT(rc == 0);
+    }
+
+    for (i = 0; i < CONFIG_TEST_LOOKUP_CNT; i++) {
+        snprintf(name, sizeof(name), "%s/x", lookup_names[i]);
+        ch = conf_parse_and_lookup(name, &name_argc, name_argv);
+        TEST_ASSERT(ch == &lookup_handlers[i]);
+        TEST_ASSERT(name_argc == 2);
+    }
+
+    strcpy(name, "lk/x");
+    ch = conf_parse_and_lookup(name, &name_argc, name_argv);
+    TEST_ASSERT(ch == NULL);
+
+    /* Handlers registered earlier are still found. */
+    strcpy(name, "myfoo/mybar");
+    ch = conf_parse_and_lookup(name, &name_argc, name_argv);
+    TEST_ASSERT(ch == &config_test_handler);
+}
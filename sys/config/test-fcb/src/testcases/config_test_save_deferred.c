@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+static int
+save_deferred_cnt_cb(struct fcb_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+static int
+save_deferred_cnt(struct conf_fcb *cf)
+{
+    int cnt;
+
+    cnt = 0;
+    fcb_walk(&cf->cf_fcb, NULL, save_deferred_cnt_cb, &cnt);
+    return cnt;
+}
+
+TEST_CASE(config_test_save_deferred)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE)
+    struct conf_fcb cf;
+    char val[8];
+    int rc;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Repeated saves of one name stay in RAM until flushed.
+     */
+    for (i = 0; i < 10; i++) {
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_save_one_deferred("myfoo/mybar", val);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(save_deferred_cnt(&cf) == 0);
+
+    rc = conf_save_flush();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(save_deferred_cnt(&cf) == 1);
+
+    val8 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 9);
+
+    /*
+     * Nothing pending; flushing again writes nothing.
+     */
+    rc = conf_save_flush();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(save_deferred_cnt(&cf) == 1);
+
+    /*
+     * A direct save supersedes the pending deferred one.
+     */
+    rc = conf_save_one_deferred("myfoo/mybar", "20");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("myfoo/mybar", "21");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(save_deferred_cnt(&cf) == 2);
+    rc = conf_save_flush();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(save_deferred_cnt(&cf) == 2);
+
+    /*
+     * Commit flushes too.
+     */
+    rc = conf_save_one_deferred("myfoo/mybar", "22");
+    TEST_ASSERT(rc == 0);
+    rc = conf_commit(NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(save_deferred_cnt(&cf) == 3);
+
+    val8 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 22);
+#endif
+}
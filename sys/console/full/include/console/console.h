@@ -86,6 +86,13 @@ extern int console_is_midline;
 extern int console_out(int character);
 extern void console_rx_restart(void);
 
+#if MYNEWT_VAL(CONSOLE_UART_TX_DROP)
+/**
+ * Number of characters dropped because the UART transmit buffer was full.
+ */
+uint32_t console_tx_dropped(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,8 +30,8 @@
 #include "console_priv.h"
 
 struct console_ring {
-    uint8_t head;
-    uint8_t tail;
+    uint16_t head;
+    uint16_t tail;
     uint16_t size;
     uint8_t *buf;
 };
@@ -39,6 +39,13 @@ struct console_ring {
 static struct uart_dev *uart_dev;
 static struct console_ring cr_tx;
 static uint8_t cr_tx_buf[MYNEWT_VAL(CONSOLE_UART_TX_BUF_SIZE)];
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+/* Bytes at the tail of cr_tx handed to the driver, but not yet sent. */
+static uint16_t cr_tx_inflight;
+#endif
+#if MYNEWT_VAL(CONSOLE_UART_TX_DROP)
+static uint32_t cr_tx_dropped;
+#endif
 typedef void (*console_write_char)(struct uart_dev*, uint8_t);
 static console_write_char write_char_cb;
 
@@ -94,6 +101,14 @@ uart_console_queue_char(struct uart_dev *uart_dev, uint8_t ch)
     }
 
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(CONSOLE_UART_TX_DROP)
+    if (uart_console_ring_is_full(&cr_tx)) {
+        cr_tx_dropped++;
+        OS_EXIT_CRITICAL(sr);
+        uart_start_tx(uart_dev);
+        return;
+    }
+#endif
     while (uart_console_ring_is_full(&cr_tx)) {
         /* TX needs to drain */
         uart_start_tx(uart_dev);
@@ -116,6 +131,12 @@ uart_console_tx_flush(int cnt)
     int i;
     uint8_t byte;
 
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+    /* Block already handed to the driver gets finished by it. */
+    cr_tx.tail = (cr_tx.tail + cr_tx_inflight) & (cr_tx.size - 1);
+    cr_tx_inflight = 0;
+#endif
+
     for (i = 0; i < cnt; i++) {
         if (uart_console_ring_is_empty(&cr_tx)) {
             break;
@@ -200,6 +221,43 @@ uart_console_tx_char(void *arg)
     return uart_console_ring_pull_char(&cr_tx);
 }
 
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+/*
+ * Interrupts disabled when called.  Hands the driver the longest block
+ * from the tail of the ring which does not wrap; the bytes stay in the
+ * ring until the driver reports them sent.
+ */
+static int
+uart_console_tx_block(void *arg, int sent, const uint8_t **data)
+{
+    int len;
+
+    if (sent > cr_tx_inflight) {
+        sent = cr_tx_inflight;
+    }
+    cr_tx.tail = (cr_tx.tail + sent) & (cr_tx.size - 1);
+    cr_tx_inflight = 0;
+
+    if (cr_tx.head >= cr_tx.tail) {
+        len = cr_tx.head - cr_tx.tail;
+    } else {
+        len = cr_tx.size - cr_tx.tail;
+    }
+    *data = &cr_tx.buf[cr_tx.tail];
+    cr_tx_inflight = len;
+
+    return len;
+}
+#endif
+
+#if MYNEWT_VAL(CONSOLE_UART_TX_DROP)
+uint32_t
+console_tx_dropped(void)
+{
+    return cr_tx_dropped;
+}
+#endif
+
 /*
  * Interrupts disabled when console_tx_char/console_rx_char are called.
  */
@@ -277,6 +335,9 @@ uart_console_init(void)
         .uc_flow_ctl = MYNEWT_VAL(CONSOLE_UART_FLOW_CONTROL),
         .uc_tx_char = uart_console_tx_char,
         .uc_rx_char = uart_console_rx_char,
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+        .uc_tx_block = uart_console_tx_block,
+#endif
     };
 
     cr_tx.size = MYNEWT_VAL(CONSOLE_UART_TX_BUF_SIZE);
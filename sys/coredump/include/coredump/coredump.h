@@ -34,6 +34,9 @@ extern "C" {
 #define COREDUMP_TLV_IMAGE          1   /* SHA256 of image creating this */
 #define COREDUMP_TLV_MEM            2   /* Memory dump */
 #define COREDUMP_TLV_REGS           3   /* CPU registers */
+#define COREDUMP_TLV_STACKS         4   /* Task stack usage */
+#define COREDUMP_TLV_TRACE          5   /* Kernel trace ring */
+#define COREDUMP_TLV_MEM_Z          6   /* Compressed memory dump */
 
 struct coredump_tlv {
     uint8_t ct_type;
@@ -42,6 +45,45 @@ struct coredump_tlv {
     uint32_t ct_off;
 };
 
+/*
+ * One entry of a COREDUMP_TLV_STACKS record; sizes are in os_stack_t words.
+ */
+struct coredump_task_stack {
+    uint8_t cts_taskid;
+    uint8_t cts_prio;
+    uint16_t cts_stksize;
+    uint16_t cts_stkusage;
+    uint16_t _pad;
+    uint32_t cts_stacktop;              /* Address of the stack top */
+};
+
+/*
+ * Start of a COREDUMP_TLV_TRACE record; followed by the trace ring storage,
+ * ctt_cnt records of ctt_rec_sz bytes each.  The record with sequence
+ * number n is at index n % ctt_cnt.
+ */
+struct coredump_trace {
+    uint32_t ctt_seq;                   /* Next sequence number */
+    uint16_t ctt_cnt;
+    uint16_t ctt_rec_sz;
+};
+
+/*
+ * A COREDUMP_TLV_MEM_Z record holds up to COREDUMP_COMPRESS_BLOCK bytes of
+ * memory starting at ct_off.  The payload is the uncompressed length
+ * (uint16_t, little endian) followed by a stream of tokens:
+ *
+ *   0lllllll                 l + 1 literal bytes follow
+ *   10llllll llllllll        l + 1 zero bytes
+ *   11llllll oooooooo x2     copy l + 4 bytes from o (little endian) bytes
+ *                            back in the output; o >= 1
+ *
+ * Matches never reach back beyond the start of the record.
+ */
+struct coredump_mem_z {
+    uint16_t cmz_len;
+};
+
 /*
  * Corefile header.  All fields are in little endian byte order.
  */
@@ -52,6 +94,22 @@ struct coredump_header {
 
 void coredump_dump(void *regs, int regs_sz);
 
+struct flash_area;
+
+/*
+ * Corefile as it reads with every COREDUMP_TLV_MEM_Z record expanded into
+ * a COREDUMP_TLV_MEM one, so that tools reading corefiles don't need to
+ * know about compression.  coredump_size() returns the size of that view
+ * and coredump_read() reads from it; the header's ch_size is adjusted to
+ * match.  Without COREDUMP_COMPRESS these read the flash area as is.
+ *
+ * Return 0 on success, SYS_ENOENT if there is no corefile, SYS_EIO on flash
+ * errors and SYS_EINVAL if the corefile is corrupt.
+ */
+int coredump_size(const struct flash_area *fa, uint32_t *size);
+int coredump_read(const struct flash_area *fa, uint32_t off, void *buf,
+                  uint32_t len);
+
 /*
  * Set this to non-zero to prevent coredump from taking place.
  */
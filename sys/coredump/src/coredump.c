@@ -18,6 +18,7 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include <limits.h>
 #include "os/mynewt.h"
 #include "hal/hal_bsp.h"
@@ -25,9 +26,23 @@
 #include "bootutil/image.h"
 #include "imgmgr/imgmgr.h"
 #include "coredump/coredump.h"
+#include "coredump_priv.h"
+#if MYNEWT_VAL(LOG_TIER)
+#include "log/log_tier.h"
+#endif
 
 uint8_t coredump_disabled;
 
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+/*
+ * Memory is copied here before compressing, so that the result stays
+ * consistent even when the block covers memory which changes while
+ * dumping.
+ */
+static uint8_t coredump_blk[MYNEWT_VAL(COREDUMP_COMPRESS_BLOCK)];
+static uint8_t coredump_zbuf[MYNEWT_VAL(COREDUMP_COMPRESS_BLOCK)];
+#endif
+
 static void
 dump_core_tlv(const struct flash_area *fa, uint32_t *off,
   struct coredump_tlv *tlv, void *data)
@@ -39,6 +54,181 @@ dump_core_tlv(const struct flash_area *fa, uint32_t *off,
     *off += tlv->ct_len;
 }
 
+/*
+ * Dump memory from addr to addr + len as COREDUMP_TLV_MEM records, or
+ * COREDUMP_TLV_MEM_Z records where compressing helps.
+ *
+ * Returns -1 when the flash area is full, 0 otherwise.
+ */
+static int
+dump_core_mem(const struct flash_area *fa, uint32_t *off, uint32_t addr,
+  uint32_t len)
+{
+    struct coredump_tlv tlv;
+    uint32_t end;
+    void *data;
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+    struct coredump_mem_z cmz;
+    uint32_t chunk;
+    int zlen;
+#endif
+
+    end = addr + len;
+    while (addr < end) {
+        tlv.ct_type = COREDUMP_TLV_MEM;
+        tlv._pad = 0;
+        tlv.ct_off = addr;
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+        chunk = end - addr;
+        if (chunk > sizeof(coredump_blk)) {
+            chunk = sizeof(coredump_blk);
+        }
+        /* The block can overlap coredump_blk itself. */
+        memmove(coredump_blk, (void *)addr, chunk);
+
+        /* Only keep the compressed form if it is smaller. */
+        zlen = coredump_compress(coredump_blk, chunk, coredump_zbuf,
+                                 (int)chunk - (int)sizeof(cmz) - 1);
+        if (zlen > 0) {
+            tlv.ct_type = COREDUMP_TLV_MEM_Z;
+            tlv.ct_len = sizeof(cmz) + zlen;
+            if (*off + sizeof(tlv) + tlv.ct_len > fa->fa_size) {
+                return -1;
+            }
+            cmz.cmz_len = chunk;
+            flash_area_write(fa, *off, &tlv, sizeof(tlv));
+            *off += sizeof(tlv);
+            flash_area_write(fa, *off, &cmz, sizeof(cmz));
+            *off += sizeof(cmz);
+            flash_area_write(fa, *off, coredump_zbuf, zlen);
+            *off += zlen;
+            addr += chunk;
+            continue;
+        }
+        tlv.ct_len = chunk;
+        data = coredump_blk;
+#else
+        if (end - addr > USHRT_MAX) {
+            tlv.ct_len = USHRT_MAX - 3; /* 0xfffc */
+        } else {
+            tlv.ct_len = end - addr;
+        }
+        data = (void *)addr;
+#endif
+        if (*off + tlv.ct_len + sizeof(tlv) > fa->fa_size) {
+            if (*off + sizeof(tlv) >= fa->fa_size) {
+                return -1;
+            }
+            tlv.ct_len = fa->fa_size - (*off + sizeof(tlv));
+        }
+        dump_core_tlv(fa, off, &tlv, data);
+        addr += tlv.ct_len;
+    }
+    return 0;
+}
+
+#if MYNEWT_VAL(COREDUMP_MINIMAL)
+/*
+ * Only dump task control blocks, task stacks and memory pool headers.
+ */
+static void
+dump_core_minimal(const struct flash_area *fa, uint32_t *off)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    struct os_task *t;
+
+    STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+        if (dump_core_mem(fa, off, (uint32_t)t, sizeof(*t))) {
+            return;
+        }
+        if (dump_core_mem(fa, off,
+                          (uint32_t)(t->t_stacktop - t->t_stacksize),
+                          t->t_stacksize * sizeof(os_stack_t))) {
+            return;
+        }
+    }
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (dump_core_mem(fa, off, (uint32_t)mp, sizeof(*mp))) {
+            return;
+        }
+    }
+}
+#endif
+
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+static void
+dump_core_stacks(const struct flash_area *fa, uint32_t *off)
+{
+    struct coredump_task_stack cts;
+    struct coredump_tlv tlv;
+    struct os_task *t;
+    int cnt;
+
+    cnt = 0;
+    STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+        cnt++;
+    }
+
+    tlv.ct_type = COREDUMP_TLV_STACKS;
+    tlv._pad = 0;
+    tlv.ct_len = cnt * sizeof(cts);
+    tlv.ct_off = 0;
+    if (*off + sizeof(tlv) + tlv.ct_len > fa->fa_size) {
+        return;
+    }
+
+    flash_area_write(fa, *off, &tlv, sizeof(tlv));
+    *off += sizeof(tlv);
+
+    STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+        cts.cts_taskid = t->t_taskid;
+        cts.cts_prio = t->t_prio;
+        cts.cts_stksize = t->t_stacksize;
+        /* Finish the scan; the incremental mark may be behind. */
+        cts.cts_stkusage = os_task_stack_hwm_sample(t, 0);
+        cts._pad = 0;
+        cts.cts_stacktop = (uint32_t)t->t_stacktop;
+
+        flash_area_write(fa, *off, &cts, sizeof(cts));
+        *off += sizeof(cts);
+    }
+}
+#endif
+
+#if MYNEWT_VAL(OS_TRACE_RING)
+static void
+dump_core_trace(const struct flash_area *fa, uint32_t *off)
+{
+    const struct os_trace_rec *ring;
+    struct coredump_trace ctt;
+    struct coredump_tlv tlv;
+    uint32_t ring_sz;
+
+    ring = os_trace_ring_buf(&ctt.ctt_seq);
+    ctt.ctt_cnt = MYNEWT_VAL(OS_TRACE_RING_SIZE);
+    ctt.ctt_rec_sz = sizeof(*ring);
+    ring_sz = ctt.ctt_cnt * ctt.ctt_rec_sz;
+
+    tlv.ct_type = COREDUMP_TLV_TRACE;
+    tlv._pad = 0;
+    tlv.ct_len = sizeof(ctt) + ring_sz;
+    tlv.ct_off = 0;
+    if (*off + sizeof(tlv) + tlv.ct_len > fa->fa_size) {
+        return;
+    }
+
+    flash_area_write(fa, *off, &tlv, sizeof(tlv));
+    *off += sizeof(tlv);
+    flash_area_write(fa, *off, &ctt, sizeof(ctt));
+    *off += sizeof(ctt);
+    flash_area_write(fa, *off, ring, ring_sz);
+    *off += ring_sz;
+}
+#endif
+
 void
 coredump_dump(void *regs, int regs_sz)
 {
@@ -46,13 +236,19 @@ coredump_dump(void *regs, int regs_sz)
     struct coredump_tlv tlv;
     const struct flash_area *fa;
     struct image_version ver;
+#if !MYNEWT_VAL(COREDUMP_MINIMAL)
     const struct hal_bsp_mem_dump *mem, *cur;
     int area_cnt, i;
+#endif
     uint8_t hash[IMGMGR_HASH_LEN];
     uint32_t off;
-    uint32_t area_off, area_end;
     int slot;
 
+#if MYNEWT_VAL(LOG_TIER)
+    /* Get the last entries into flash before anything else can fail. */
+    log_tier_spill_all();
+#endif
+
     if (coredump_disabled) {
         return;
     }
@@ -102,29 +298,25 @@ coredump_dump(void *regs, int regs_sz)
         dump_core_tlv(fa, &off, &tlv, hash);
     }
 
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    dump_core_stacks(fa, &off);
+#endif
+#if MYNEWT_VAL(OS_TRACE_RING)
+    dump_core_trace(fa, &off);
+#endif
+
+#if MYNEWT_VAL(COREDUMP_MINIMAL)
+    dump_core_minimal(fa, &off);
+#else
     mem = hal_bsp_core_dump(&area_cnt);
     for (i = 0; i < area_cnt; i++) {
         cur = &mem[i];
-        area_off = (uint32_t)cur->hbmd_start;
-        area_end = area_off + cur->hbmd_size;
-        while (area_off < area_end) {
-            tlv.ct_type = COREDUMP_TLV_MEM;
-            if (area_end - area_off > USHRT_MAX) {
-                tlv.ct_len = USHRT_MAX - 3; /* 0xfffc */
-            } else {
-                tlv.ct_len = area_end - area_off;
-            }
-            if (off + tlv.ct_len + sizeof(tlv) > fa->fa_size) {
-                if (off + sizeof(tlv) >= fa->fa_size) {
-                    break;
-                }
-                tlv.ct_len = fa->fa_size - (off + sizeof(tlv));
-            }
-            tlv.ct_off = area_off;
-            dump_core_tlv(fa, &off, &tlv, (void *)area_off);
-            area_off += tlv.ct_len;
+        if (dump_core_mem(fa, &off, (uint32_t)cur->hbmd_start,
+                          cur->hbmd_size)) {
+            break;
         }
     }
+#endif
     hdr.ch_magic = COREDUMP_MAGIC;
     hdr.ch_size = off;
 
@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __COREDUMP_PRIV_H__
+#define __COREDUMP_PRIV_H__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Worst case size of a compressed block of n bytes; one literal token per
+ * 128 bytes.
+ */
+#define COREDUMP_Z_MAX(n)           ((n) + ((n) + 127) / 128)
+
+int coredump_compress(const uint8_t *src, int src_len, uint8_t *dst,
+                      int dst_len);
+int coredump_decompress(const uint8_t *src, int src_len, uint8_t *dst,
+                        int dst_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COREDUMP_PRIV_H__ */
@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+#include "coredump/coredump.h"
+#include "coredump_priv.h"
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+static uint8_t coredump_rd_z[MYNEWT_VAL(COREDUMP_COMPRESS_BLOCK)];
+static uint8_t coredump_rd_blk[MYNEWT_VAL(COREDUMP_COMPRESS_BLOCK)];
+#endif
+
+static int
+coredump_read_hdr(const struct flash_area *fa, struct coredump_header *hdr)
+{
+    if (flash_area_read(fa, 0, hdr, sizeof(*hdr))) {
+        return SYS_EIO;
+    }
+    if (hdr->ch_magic != COREDUMP_MAGIC) {
+        return SYS_ENOENT;
+    }
+    if (hdr->ch_size < sizeof(*hdr) || hdr->ch_size > fa->fa_size) {
+        return SYS_EINVAL;
+    }
+    return 0;
+}
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+/*
+ * Copy the part of src, which is at voff in the expanded corefile, that
+ * falls within the range [off, off + len) being read.
+ */
+static void
+coredump_copy(uint32_t voff, const void *src, uint32_t src_len,
+              uint32_t off, uint8_t *buf, uint32_t len)
+{
+    uint32_t start;
+    uint32_t end;
+
+    start = voff > off ? voff : off;
+    end = voff + src_len < off + len ? voff + src_len : off + len;
+    if (start < end) {
+        memcpy(buf + (start - off), (const uint8_t *)src + (start - voff),
+               end - start);
+    }
+}
+
+/*
+ * Walk the records of the corefile, keeping track of where each one ends
+ * up once expanded.  If buf is not NULL, the part of the expanded corefile
+ * from off to off + len is read into it, skipping the header; otherwise
+ * the full expanded size is returned in *size.
+ */
+static int
+coredump_walk(const struct flash_area *fa, uint32_t off, uint8_t *buf,
+              uint32_t len, uint32_t *size)
+{
+    struct coredump_header hdr;
+    struct coredump_mem_z cmz;
+    struct coredump_tlv tlv;
+    uint32_t start;
+    uint32_t end;
+    uint32_t poff;
+    uint32_t voff;
+    int zlen;
+    int rc;
+
+    rc = coredump_read_hdr(fa, &hdr);
+    if (rc) {
+        return rc;
+    }
+
+    poff = sizeof(hdr);
+    voff = sizeof(hdr);
+    while (poff < hdr.ch_size) {
+        if (buf && voff >= off + len) {
+            break;
+        }
+        if (poff + sizeof(tlv) > hdr.ch_size) {
+            return SYS_EINVAL;
+        }
+        if (flash_area_read(fa, poff, &tlv, sizeof(tlv))) {
+            return SYS_EIO;
+        }
+        if (poff + sizeof(tlv) + tlv.ct_len > hdr.ch_size) {
+            return SYS_EINVAL;
+        }
+
+        if (tlv.ct_type != COREDUMP_TLV_MEM_Z) {
+            /* Stored as is. */
+            start = voff > off ? voff : off;
+            end = voff + sizeof(tlv) + tlv.ct_len;
+            if (end > off + len) {
+                end = off + len;
+            }
+            if (buf && start < end &&
+              flash_area_read(fa, poff + (start - voff), buf + (start - off),
+                              end - start)) {
+                return SYS_EIO;
+            }
+            voff += sizeof(tlv) + tlv.ct_len;
+            poff += sizeof(tlv) + tlv.ct_len;
+            continue;
+        }
+
+        if (tlv.ct_len < sizeof(cmz)) {
+            return SYS_EINVAL;
+        }
+        if (flash_area_read(fa, poff + sizeof(tlv), &cmz, sizeof(cmz))) {
+            return SYS_EIO;
+        }
+        if (buf && voff + sizeof(tlv) + cmz.cmz_len > off) {
+            zlen = tlv.ct_len - sizeof(cmz);
+            tlv.ct_type = COREDUMP_TLV_MEM;
+            tlv.ct_len = cmz.cmz_len;
+            coredump_copy(voff, &tlv, sizeof(tlv), off, buf, len);
+
+            if (voff + sizeof(tlv) < off + len) {
+                if (zlen > sizeof(coredump_rd_z) ||
+                  cmz.cmz_len > sizeof(coredump_rd_blk)) {
+                    return SYS_EINVAL;
+                }
+                if (flash_area_read(fa, poff + sizeof(tlv) + sizeof(cmz),
+                                    coredump_rd_z, zlen)) {
+                    return SYS_EIO;
+                }
+                if (coredump_decompress(coredump_rd_z, zlen, coredump_rd_blk,
+                                        cmz.cmz_len) != cmz.cmz_len) {
+                    return SYS_EINVAL;
+                }
+                coredump_copy(voff + sizeof(tlv), coredump_rd_blk,
+                              cmz.cmz_len, off, buf, len);
+            }
+            tlv.ct_len = zlen + sizeof(cmz);
+        }
+        voff += sizeof(tlv) + cmz.cmz_len;
+        poff += sizeof(tlv) + tlv.ct_len;
+    }
+
+    if (size) {
+        *size = voff;
+    }
+    return 0;
+}
+#endif
+
+int
+coredump_size(const struct flash_area *fa, uint32_t *size)
+{
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+    return coredump_walk(fa, 0, NULL, 0, size);
+#else
+    struct coredump_header hdr;
+    int rc;
+
+    rc = coredump_read_hdr(fa, &hdr);
+    if (rc) {
+        return rc;
+    }
+    *size = hdr.ch_size;
+    return 0;
+#endif
+}
+
+/*
+ * off + len must not be past the size returned by coredump_size().
+ * Uses static buffers; don't call this from more than one task at a time.
+ */
+int
+coredump_read(const struct flash_area *fa, uint32_t off, void *buf,
+              uint32_t len)
+{
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+    struct coredump_header hdr;
+    int rc;
+
+    if (off < sizeof(hdr)) {
+        hdr.ch_magic = COREDUMP_MAGIC;
+        rc = coredump_size(fa, &hdr.ch_size);
+        if (rc) {
+            return rc;
+        }
+        coredump_copy(0, &hdr, sizeof(hdr), off, buf, len);
+    }
+    return coredump_walk(fa, off, buf, len, NULL);
+#else
+    if (flash_area_read(fa, off, buf, len)) {
+        return SYS_EIO;
+    }
+    return 0;
+#endif
+}
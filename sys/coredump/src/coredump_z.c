@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+
+#include "coredump_priv.h"
+
+#define COREDUMP_Z_LIT_MAX          128
+#define COREDUMP_Z_ZERO             0x80
+#define COREDUMP_Z_ZERO_MIN         3
+#define COREDUMP_Z_ZERO_MAX         (1 << 14)
+#define COREDUMP_Z_MATCH            0xc0
+#define COREDUMP_Z_MATCH_MIN        4
+#define COREDUMP_Z_MATCH_MAX        (COREDUMP_Z_MATCH_MIN + 0x3f)
+
+#define COREDUMP_Z_HASH_BITS        MYNEWT_VAL(COREDUMP_COMPRESS_HASH_BITS)
+#define COREDUMP_Z_HASH_NONE        0xffff
+
+/*
+ * Used from the fault handler; keep it off the stack.
+ */
+static uint16_t coredump_z_htab[1 << COREDUMP_Z_HASH_BITS];
+
+static int
+coredump_z_hash(const uint8_t *p)
+{
+    uint32_t v;
+
+    v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (v * 2654435761U) >> (32 - COREDUMP_Z_HASH_BITS);
+}
+
+static int
+coredump_z_put_lit(const uint8_t *lit, int lit_len, uint8_t *dst, int op,
+                   int dst_len)
+{
+    int n;
+
+    while (lit_len > 0) {
+        n = lit_len;
+        if (n > COREDUMP_Z_LIT_MAX) {
+            n = COREDUMP_Z_LIT_MAX;
+        }
+        if (op + 1 + n > dst_len) {
+            return -1;
+        }
+        dst[op++] = n - 1;
+        memcpy(dst + op, lit, n);
+        op += n;
+        lit += n;
+        lit_len -= n;
+    }
+    return op;
+}
+
+/*
+ * Compresses src into dst.  Returns the length of the compressed stream,
+ * or -1 if it doesn't fit in dst_len bytes.  src_len must be at most
+ * 65535.
+ */
+int
+coredump_compress(const uint8_t *src, int src_len, uint8_t *dst,
+                  int dst_len)
+{
+    int anchor;
+    int ip;
+    int op;
+    int len;
+    int ref;
+    int h;
+
+    memset(coredump_z_htab, 0xff, sizeof(coredump_z_htab));
+
+    anchor = 0;
+    ip = 0;
+    op = 0;
+    while (ip < src_len) {
+        if (src[ip] == 0) {
+            for (len = 1; ip + len < src_len && len < COREDUMP_Z_ZERO_MAX;
+                 len++) {
+                if (src[ip + len] != 0) {
+                    break;
+                }
+            }
+            if (len >= COREDUMP_Z_ZERO_MIN) {
+                op = coredump_z_put_lit(src + anchor, ip - anchor, dst, op,
+                                        dst_len);
+                if (op < 0 || op + 2 > dst_len) {
+                    return -1;
+                }
+                dst[op++] = COREDUMP_Z_ZERO | ((len - 1) >> 8);
+                dst[op++] = len - 1;
+                ip += len;
+                anchor = ip;
+                continue;
+            }
+        }
+        if (ip + COREDUMP_Z_MATCH_MIN <= src_len) {
+            h = coredump_z_hash(src + ip);
+            ref = coredump_z_htab[h];
+            coredump_z_htab[h] = ip;
+            if (ref != COREDUMP_Z_HASH_NONE &&
+              !memcmp(src + ref, src + ip, COREDUMP_Z_MATCH_MIN)) {
+                len = COREDUMP_Z_MATCH_MIN;
+                while (ip + len < src_len && len < COREDUMP_Z_MATCH_MAX &&
+                       src[ref + len] == src[ip + len]) {
+                    len++;
+                }
+                op = coredump_z_put_lit(src + anchor, ip - anchor, dst, op,
+                                        dst_len);
+                if (op < 0 || op + 3 > dst_len) {
+                    return -1;
+                }
+                dst[op++] = COREDUMP_Z_MATCH | (len - COREDUMP_Z_MATCH_MIN);
+                dst[op++] = ip - ref;
+                dst[op++] = (ip - ref) >> 8;
+                ip += len;
+                anchor = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+    return coredump_z_put_lit(src + anchor, src_len - anchor, dst, op,
+                              dst_len);
+}
+
+/*
+ * Decompresses src into dst.  Returns the number of bytes written to dst,
+ * or -1 if the stream is corrupt or doesn't fit in dst_len bytes.
+ */
+int
+coredump_decompress(const uint8_t *src, int src_len, uint8_t *dst,
+                    int dst_len)
+{
+    int ip;
+    int op;
+    int len;
+    int off;
+    int i;
+    uint8_t t;
+
+    ip = 0;
+    op = 0;
+    while (ip < src_len) {
+        t = src[ip++];
+        if (t < COREDUMP_Z_ZERO) {
+            len = t + 1;
+            if (ip + len > src_len || op + len > dst_len) {
+                return -1;
+            }
+            memcpy(dst + op, src + ip, len);
+            ip += len;
+        } else if (t < COREDUMP_Z_MATCH) {
+            if (ip + 1 > src_len) {
+                return -1;
+            }
+            len = (((t & 0x3f) << 8) | src[ip++]) + 1;
+            if (op + len > dst_len) {
+                return -1;
+            }
+            memset(dst + op, 0, len);
+        } else {
+            if (ip + 2 > src_len) {
+                return -1;
+            }
+            len = (t & 0x3f) + COREDUMP_Z_MATCH_MIN;
+            off = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            if (off == 0 || off > op || op + len > dst_len) {
+                return -1;
+            }
+            /* Byte at a time; source and destination may overlap. */
+            for (i = 0; i < len; i++) {
+                dst[op + i] = dst[op - off + i];
+            }
+        }
+        op += len;
+    }
+    return op;
+}
+
+#endif
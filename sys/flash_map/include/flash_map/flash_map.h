@@ -43,6 +43,10 @@ extern "C" {
  */
 #include <stdbool.h>
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
+#if MYNEWT_VAL(FLASH_MAP_ASYNC)
+#include "os/os_eventq.h"
+#endif
 
 struct flash_area {
     uint8_t fa_id;
@@ -77,6 +81,14 @@ int flash_area_write(const struct flash_area *, uint32_t off, const void *src,
   uint32_t len);
 int flash_area_erase(const struct flash_area *, uint32_t off, uint32_t len);
 
+/*
+ * Get a pointer for reading flash area contents in place, without copying.
+ * Only works on flash which is memory mapped; returns SYS_ENOTSUP otherwise.
+ * The pointer is valid until the area is written or erased.
+ */
+int flash_area_map(const struct flash_area *, uint32_t off, uint32_t len,
+  const void **ptr);
+
 /*
  * Whether the whole area is empty.
  */
@@ -107,6 +119,55 @@ int flash_area_getnext_sector(int id, int *sec_id, struct flash_area *ret);
 int flash_area_id_from_image_slot(int slot);
 int flash_area_id_to_image_slot(int area_id);
 
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+/*
+ * Enable or disable caching of reads from a flash area.  Only area IDs
+ * below 32 can be cached.
+ */
+int flash_area_cache_set(uint8_t id, bool enable);
+#endif
+
+#if MYNEWT_VAL(FLASH_MAP_ASYNC)
+/*
+ * Asynchronous read/write/erase request.  Before submitting, set
+ * far_ev.ev_cb (and ev_arg) and optionally far_evq.  When the operation
+ * completes, far_rc holds its result and far_ev is posted to far_evq, or to
+ * the default event queue if far_evq is NULL.  The request and its buffer
+ * must stay valid until then.
+ */
+struct flash_area_req {
+    struct os_event far_ev;
+    struct os_eventq *far_evq;
+    int far_rc;
+
+    /* Private */
+    STAILQ_ENTRY(flash_area_req) far_next;
+    void *far_buf;
+    uint32_t far_addr;
+    uint32_t far_len;
+    uint8_t far_dev;
+    uint8_t far_op;
+};
+
+/*
+ * Queue an operation; offset is relative from beginning of flash area.
+ * Returns 0 if the request was queued, nonzero if the range is invalid.
+ */
+int flash_area_read_async(const struct flash_area *, uint32_t off, void *dst,
+  uint32_t len, struct flash_area_req *req);
+int flash_area_write_async(const struct flash_area *, uint32_t off,
+  const void *src, uint32_t len, struct flash_area_req *req);
+int flash_area_erase_async(const struct flash_area *, uint32_t off,
+  uint32_t len, struct flash_area_req *req);
+
+/*
+ * Selects the event queue the flash operations themselves are executed
+ * from.  Defaults to the default event queue; point it at a low priority
+ * task's queue to keep flash work from delaying other events.
+ */
+void flash_area_async_evq_set(struct os_eventq *evq);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,7 @@
 #include "hal/hal_flash_int.h"
 #include "mfg/mfg.h"
 #include "flash_map/flash_map.h"
+#include "flash_map_priv.h"
 
 const struct flash_area *flash_map;
 int flash_map_entries;
@@ -138,6 +139,11 @@ flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    if (flash_map_cache_enabled(fa)) {
+        return flash_map_cache_read(fa, off, dst, len);
+    }
+#endif
     return hal_flash_read(fa->fa_device_id, fa->fa_off + off, dst, len);
 }
 
@@ -145,20 +151,42 @@ int
 flash_area_write(const struct flash_area *fa, uint32_t off, const void *src,
     uint32_t len)
 {
+    int rc;
+
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
-    return hal_flash_write(fa->fa_device_id, fa->fa_off + off,
-                           (void *)src, len);
+    rc = hal_flash_write(fa->fa_device_id, fa->fa_off + off,
+                         (void *)src, len);
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    flash_map_cache_invalidate(fa->fa_device_id, fa->fa_off + off, len);
+#endif
+    return rc;
 }
 
 int
 flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
 {
+    int rc;
+
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
-    return hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
+    rc = hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    flash_map_cache_invalidate(fa->fa_device_id, fa->fa_off + off, len);
+#endif
+    return rc;
+}
+
+int
+flash_area_map(const struct flash_area *fa, uint32_t off, uint32_t len,
+    const void **ptr)
+{
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+    return hal_flash_map(fa->fa_device_id, fa->fa_off + off, len, ptr);
 }
 
 uint8_t
@@ -318,6 +346,10 @@ flash_map_init(void)
     rc = hal_flash_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    flash_map_cache_init();
+#endif
+
     /* Use the hardcoded default flash map.  This is done for two reasons:
      * 1. A minimal flash map configuration is required to boot strap the
      *    process of reading the flash map from the manufacturing meta region.
@@ -0,0 +1,282 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "hal/hal_flash.h"
+#include "flash_map/flash_map.h"
+#include "flash_map_priv.h"
+
+#if MYNEWT_VAL(FLASH_MAP_ASYNC)
+
+#define FLASH_AREA_REQ_READ     0
+#define FLASH_AREA_REQ_WRITE    1
+#define FLASH_AREA_REQ_ERASE    2
+
+STAILQ_HEAD(flash_area_req_list, flash_area_req);
+
+static struct flash_area_req_list flash_area_reqs =
+    STAILQ_HEAD_INITIALIZER(flash_area_reqs);
+
+static struct os_eventq *flash_area_async_evq;
+
+static void flash_area_async_ev_cb(struct os_event *ev);
+
+static struct os_event flash_area_async_ev = {
+    .ev_cb = flash_area_async_ev_cb,
+};
+
+static struct os_eventq *
+flash_area_async_evq_get(void)
+{
+    if (flash_area_async_evq == NULL) {
+        return os_eventq_dflt_get();
+    }
+    return flash_area_async_evq;
+}
+
+void
+flash_area_async_evq_set(struct os_eventq *evq)
+{
+    flash_area_async_evq = evq;
+}
+
+static bool
+flash_area_req_overlap(const struct flash_area_req *a,
+  const struct flash_area_req *b)
+{
+    return a->far_dev == b->far_dev &&
+           a->far_addr < b->far_addr + b->far_len &&
+           b->far_addr < a->far_addr + a->far_len;
+}
+
+/*
+ * Whether a queued request can be executed now.  Writes and erases run in
+ * submission order per device; a read may pass writes and erases queued
+ * before it, as long as it does not overlap any of them.
+ */
+static bool
+flash_area_req_ready(const struct flash_area_req *req)
+{
+    const struct flash_area_req *prev;
+
+    STAILQ_FOREACH(prev, &flash_area_reqs, far_next) {
+        if (prev == req) {
+            return true;
+        }
+        if (prev->far_dev != req->far_dev) {
+            continue;
+        }
+        if (req->far_op != FLASH_AREA_REQ_READ) {
+            return false;
+        }
+        if (prev->far_op != FLASH_AREA_REQ_READ &&
+            flash_area_req_overlap(prev, req)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Picks the next request to execute: the first ready read, else the first
+ * ready write or erase.
+ */
+static struct flash_area_req *
+flash_area_req_pick(void)
+{
+    struct flash_area_req *other;
+    struct flash_area_req *req;
+
+    other = NULL;
+    STAILQ_FOREACH(req, &flash_area_reqs, far_next) {
+        if (!flash_area_req_ready(req)) {
+            continue;
+        }
+        if (req->far_op == FLASH_AREA_REQ_READ) {
+            return req;
+        }
+        if (other == NULL) {
+            other = req;
+        }
+    }
+
+    return other;
+}
+
+/*
+ * Finds a ready read which continues where the batch ends, both on flash
+ * and in memory, so that it can be done as part of the same hal_flash_read().
+ */
+static struct flash_area_req *
+flash_area_req_adjacent(uint8_t dev, uint32_t addr, uint8_t *buf)
+{
+    struct flash_area_req *req;
+
+    STAILQ_FOREACH(req, &flash_area_reqs, far_next) {
+        if (req->far_op == FLASH_AREA_REQ_READ &&
+            req->far_dev == dev &&
+            req->far_addr == addr &&
+            req->far_buf == buf &&
+            flash_area_req_ready(req)) {
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+flash_area_req_done(struct flash_area_req *req, int rc)
+{
+    struct os_eventq *evq;
+
+    req->far_rc = rc;
+
+    evq = req->far_evq;
+    if (evq == NULL) {
+        evq = os_eventq_dflt_get();
+    }
+    os_eventq_put(evq, &req->far_ev);
+}
+
+/*
+ * Executes one request, or one batch of adjacent reads, per event so that
+ * other events on the same queue get to run between flash operations.
+ */
+static void
+flash_area_async_ev_cb(struct os_event *ev)
+{
+    struct flash_area_req_list batch;
+    struct flash_area_req *req;
+    struct flash_area_req *next;
+    uint32_t len;
+    bool more;
+    int rc;
+    os_sr_t sr;
+
+    STAILQ_INIT(&batch);
+
+    OS_ENTER_CRITICAL(sr);
+    req = flash_area_req_pick();
+    if (req == NULL) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    STAILQ_REMOVE(&flash_area_reqs, req, flash_area_req, far_next);
+    STAILQ_INSERT_TAIL(&batch, req, far_next);
+
+    len = req->far_len;
+    if (req->far_op == FLASH_AREA_REQ_READ) {
+        while ((next = flash_area_req_adjacent(req->far_dev,
+                                               req->far_addr + len,
+                                               (uint8_t *)req->far_buf + len))
+               != NULL) {
+            STAILQ_REMOVE(&flash_area_reqs, next, flash_area_req, far_next);
+            STAILQ_INSERT_TAIL(&batch, next, far_next);
+            len += next->far_len;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    switch (req->far_op) {
+    case FLASH_AREA_REQ_READ:
+        rc = hal_flash_read(req->far_dev, req->far_addr, req->far_buf, len);
+        break;
+    case FLASH_AREA_REQ_WRITE:
+        rc = hal_flash_write(req->far_dev, req->far_addr, req->far_buf, len);
+        break;
+    default:
+        rc = hal_flash_erase(req->far_dev, req->far_addr, len);
+        break;
+    }
+
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    if (req->far_op != FLASH_AREA_REQ_READ) {
+        flash_map_cache_invalidate(req->far_dev, req->far_addr, len);
+    }
+#endif
+
+    while ((req = STAILQ_FIRST(&batch)) != NULL) {
+        STAILQ_REMOVE_HEAD(&batch, far_next);
+        flash_area_req_done(req, rc);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    more = !STAILQ_EMPTY(&flash_area_reqs);
+    OS_EXIT_CRITICAL(sr);
+
+    if (more) {
+        os_eventq_put(flash_area_async_evq_get(), &flash_area_async_ev);
+    }
+}
+
+static int
+flash_area_req_submit(const struct flash_area *fa, uint32_t off, void *buf,
+  uint32_t len, uint8_t op, struct flash_area_req *req)
+{
+    os_sr_t sr;
+
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+
+    req->far_buf = buf;
+    req->far_addr = fa->fa_off + off;
+    req->far_len = len;
+    req->far_dev = fa->fa_device_id;
+    req->far_op = op;
+    req->far_rc = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&flash_area_reqs, req, far_next);
+    OS_EXIT_CRITICAL(sr);
+
+    os_eventq_put(flash_area_async_evq_get(), &flash_area_async_ev);
+
+    return 0;
+}
+
+int
+flash_area_read_async(const struct flash_area *fa, uint32_t off, void *dst,
+  uint32_t len, struct flash_area_req *req)
+{
+    return flash_area_req_submit(fa, off, dst, len, FLASH_AREA_REQ_READ, req);
+}
+
+int
+flash_area_write_async(const struct flash_area *fa, uint32_t off,
+  const void *src, uint32_t len, struct flash_area_req *req)
+{
+    return flash_area_req_submit(fa, off, (void *)src, len,
+                                 FLASH_AREA_REQ_WRITE, req);
+}
+
+int
+flash_area_erase_async(const struct flash_area *fa, uint32_t off,
+  uint32_t len, struct flash_area_req *req)
+{
+    return flash_area_req_submit(fa, off, NULL, len, FLASH_AREA_REQ_ERASE,
+                                 req);
+}
+
+#endif
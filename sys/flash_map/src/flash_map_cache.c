@@ -0,0 +1,279 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "hal/hal_flash.h"
+#include "stats/stats.h"
+#include "flash_map/flash_map.h"
+#include "flash_map_priv.h"
+
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+
+#define FLASH_MAP_CACHE_LINE    MYNEWT_VAL(FLASH_MAP_CACHE_LINE_SIZE)
+#define FLASH_MAP_CACHE_SETS    MYNEWT_VAL(FLASH_MAP_CACHE_SETS)
+#define FLASH_MAP_CACHE_WAYS    MYNEWT_VAL(FLASH_MAP_CACHE_WAYS)
+
+#if (FLASH_MAP_CACHE_LINE & (FLASH_MAP_CACHE_LINE - 1)) != 0
+#error "FLASH_MAP_CACHE_LINE_SIZE must be a power of two"
+#endif
+#if (FLASH_MAP_CACHE_SETS & (FLASH_MAP_CACHE_SETS - 1)) != 0
+#error "FLASH_MAP_CACHE_SETS must be a power of two"
+#endif
+
+struct flash_map_cache_line {
+    uint32_t fcl_addr;          /* Device address of first byte in line. */
+    uint32_t fcl_used;          /* flash_map_cache_clock at last access. */
+    uint8_t fcl_dev;
+    uint8_t fcl_valid;
+};
+
+static struct flash_map_cache_line
+    flash_map_cache_lines[FLASH_MAP_CACHE_SETS][FLASH_MAP_CACHE_WAYS];
+static uint8_t flash_map_cache_data
+    [FLASH_MAP_CACHE_SETS][FLASH_MAP_CACHE_WAYS][FLASH_MAP_CACHE_LINE];
+static uint32_t flash_map_cache_clock;
+static uint32_t flash_map_cache_areas;
+static struct os_mutex flash_map_cache_mtx;
+
+STATS_SECT_START(flash_map_cache_stats)
+    STATS_SECT_ENTRY(hits)
+    STATS_SECT_ENTRY(misses)
+    STATS_SECT_ENTRY(invalidations)
+STATS_SECT_END
+
+STATS_NAME_START(flash_map_cache_stats)
+    STATS_NAME(flash_map_cache_stats, hits)
+    STATS_NAME(flash_map_cache_stats, misses)
+    STATS_NAME(flash_map_cache_stats, invalidations)
+STATS_NAME_END(flash_map_cache_stats)
+
+static STATS_SECT_DECL(flash_map_cache_stats) flash_map_cache_stats;
+
+static int
+flash_map_cache_set_idx(uint8_t dev, uint32_t addr)
+{
+    return ((addr / FLASH_MAP_CACHE_LINE) ^ dev) & (FLASH_MAP_CACHE_SETS - 1);
+}
+
+static void
+flash_map_cache_lock(void)
+{
+    os_mutex_pend(&flash_map_cache_mtx, OS_TIMEOUT_NEVER);
+}
+
+static void
+flash_map_cache_unlock(void)
+{
+    os_mutex_release(&flash_map_cache_mtx);
+}
+
+/*
+ * Returns the data of the line holding the given line-aligned address,
+ * reading it from flash on a miss.  Must be called with the lock held.
+ */
+static int
+flash_map_cache_line_get(uint8_t dev, uint32_t addr, uint8_t **data)
+{
+    struct flash_map_cache_line *set;
+    struct flash_map_cache_line *victim;
+    int set_idx;
+    int way;
+    int rc;
+
+    set_idx = flash_map_cache_set_idx(dev, addr);
+    set = flash_map_cache_lines[set_idx];
+
+    victim = NULL;
+    for (way = 0; way < FLASH_MAP_CACHE_WAYS; way++) {
+        if (set[way].fcl_valid && set[way].fcl_dev == dev &&
+            set[way].fcl_addr == addr) {
+
+            set[way].fcl_used = ++flash_map_cache_clock;
+            *data = flash_map_cache_data[set_idx][way];
+            STATS_INC(flash_map_cache_stats, hits);
+            return 0;
+        }
+
+        if (victim == NULL || !set[way].fcl_valid ||
+            (victim->fcl_valid &&
+             (int32_t)(set[way].fcl_used - victim->fcl_used) < 0)) {
+            victim = &set[way];
+        }
+    }
+
+    STATS_INC(flash_map_cache_stats, misses);
+
+    way = victim - set;
+    victim->fcl_valid = 0;
+    rc = hal_flash_read(dev, addr, flash_map_cache_data[set_idx][way],
+                        FLASH_MAP_CACHE_LINE);
+    if (rc != 0) {
+        return rc;
+    }
+
+    victim->fcl_addr = addr;
+    victim->fcl_dev = dev;
+    victim->fcl_valid = 1;
+    victim->fcl_used = ++flash_map_cache_clock;
+    *data = flash_map_cache_data[set_idx][way];
+
+    return 0;
+}
+
+int
+flash_map_cache_read(const struct flash_area *fa, uint32_t off, void *dst,
+  uint32_t len)
+{
+    uint8_t *line;
+    uint8_t *u8p;
+    uint32_t addr;
+    uint32_t line_addr;
+    uint32_t line_off;
+    uint32_t chunk;
+    int rc;
+
+    rc = 0;
+    u8p = dst;
+    addr = fa->fa_off + off;
+
+    flash_map_cache_lock();
+    while (len > 0) {
+        line_addr = addr & ~(FLASH_MAP_CACHE_LINE - 1);
+        line_off = addr - line_addr;
+        chunk = FLASH_MAP_CACHE_LINE - line_off;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        rc = flash_map_cache_line_get(fa->fa_device_id, line_addr, &line);
+        if (rc != 0) {
+            break;
+        }
+        memcpy(u8p, line + line_off, chunk);
+
+        u8p += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+    flash_map_cache_unlock();
+
+    return rc;
+}
+
+/*
+ * Drops cached lines overlapping the given device range.  Called after a
+ * write or erase through flash_area_*; changes made by calling hal_flash
+ * directly are not seen by the cache.
+ */
+void
+flash_map_cache_invalidate(uint8_t dev, uint32_t addr, uint32_t len)
+{
+    struct flash_map_cache_line *line;
+    int set_idx;
+    int way;
+
+    if (len == 0) {
+        return;
+    }
+
+    flash_map_cache_lock();
+    for (set_idx = 0; set_idx < FLASH_MAP_CACHE_SETS; set_idx++) {
+        for (way = 0; way < FLASH_MAP_CACHE_WAYS; way++) {
+            line = &flash_map_cache_lines[set_idx][way];
+            if (line->fcl_valid && line->fcl_dev == dev &&
+                line->fcl_addr < addr + len &&
+                addr < line->fcl_addr + FLASH_MAP_CACHE_LINE) {
+
+                line->fcl_valid = 0;
+                STATS_INC(flash_map_cache_stats, invalidations);
+            }
+        }
+    }
+    flash_map_cache_unlock();
+}
+
+bool
+flash_map_cache_enabled(const struct flash_area *fa)
+{
+    return fa->fa_id < 32 && (flash_map_cache_areas & (1UL << fa->fa_id));
+}
+
+int
+flash_area_cache_set(uint8_t id, bool enable)
+{
+    const struct flash_area *fa;
+    int rc;
+
+    if (id >= 32) {
+        return SYS_EINVAL;
+    }
+
+    rc = flash_area_open(id, &fa);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (enable) {
+        flash_map_cache_areas |= 1UL << id;
+    } else {
+        flash_map_cache_areas &= ~(1UL << id);
+        flash_map_cache_invalidate(fa->fa_device_id, fa->fa_off,
+                                   fa->fa_size);
+    }
+    flash_area_close(fa);
+
+    return 0;
+}
+
+void
+flash_map_cache_init(void)
+{
+    int rc;
+
+    memset(flash_map_cache_lines, 0, sizeof flash_map_cache_lines);
+    flash_map_cache_areas = MYNEWT_VAL(FLASH_MAP_CACHE_AREAS);
+
+    rc = os_mutex_init(&flash_map_cache_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+/*
+ * Stats can only be registered after the stats package is initialized,
+ * which happens after flash_map_init().
+ */
+void
+flash_map_cache_stats_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = stats_init_and_reg(STATS_HDR(flash_map_cache_stats),
+                            STATS_SIZE_INIT_PARMS(flash_map_cache_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(flash_map_cache_stats),
+                            "flash_map_cache");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
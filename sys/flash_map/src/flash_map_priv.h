@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_FLASH_MAP_PRIV_
+#define H_FLASH_MAP_PRIV_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+void flash_map_cache_init(void);
+void flash_map_cache_stats_init(void);
+int flash_map_cache_read(const struct flash_area *fa, uint32_t off,
+  void *dst, uint32_t len);
+void flash_map_cache_invalidate(uint8_t dev, uint32_t addr, uint32_t len);
+bool flash_map_cache_enabled(const struct flash_area *fa);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_FLASH_MAP_PRIV_ */
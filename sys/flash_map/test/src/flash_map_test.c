@@ -39,12 +39,26 @@ struct flash_area *fa_sectors;
 TEST_CASE_DECL(flash_map_test_case_1)
 TEST_CASE_DECL(flash_map_test_case_2)
 TEST_CASE_DECL(flash_map_test_case_3)
+TEST_CASE_DECL(flash_map_test_case_6)
+#if MYNEWT_VAL(FLASH_MAP_ASYNC)
+TEST_CASE_DECL(flash_map_test_case_4)
+#endif
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+TEST_CASE_DECL(flash_map_test_case_5)
+#endif
 
 TEST_SUITE(flash_map_test_suite)
 {
     flash_map_test_case_1();
     flash_map_test_case_2();
     flash_map_test_case_3();
+    flash_map_test_case_6();
+#if MYNEWT_VAL(FLASH_MAP_ASYNC)
+    flash_map_test_case_4();
+#endif
+#if MYNEWT_VAL(FLASH_MAP_CACHE)
+    flash_map_test_case_5();
+#endif
 }
 
 #if MYNEWT_VAL(SELFTEST)
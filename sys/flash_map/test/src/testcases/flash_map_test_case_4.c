@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+extern struct flash_area *fa_sectors;
+
+static struct os_eventq fmt4_evq;
+static int fmt4_order[8];
+static int fmt4_done;
+
+static void
+fmt4_done_cb(struct os_event *ev)
+{
+    fmt4_order[fmt4_done++] = (int)(intptr_t)ev->ev_arg;
+}
+
+static void
+fmt4_req_init(struct flash_area_req *req, int idx)
+{
+    memset(req, 0, sizeof(*req));
+    req->far_ev.ev_cb = fmt4_done_cb;
+    req->far_ev.ev_arg = (void *)(intptr_t)idx;
+    req->far_evq = &fmt4_evq;
+}
+
+/*
+ * Test asynchronous erase/write/read
+ */
+TEST_CASE(flash_map_test_case_4)
+{
+    const struct flash_area *fa;
+    struct flash_area_req req[5];
+    struct flash_area_req bad;
+    int sec_cnt;
+    int i;
+    int rc;
+    uint8_t wd[256];
+    uint8_t rd[256];
+    uint8_t rd2[64];
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_to_sectors(FLASH_AREA_IMAGE_0, &sec_cnt, fa_sectors);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_to_sectors failed");
+    TEST_ASSERT_FATAL(sec_cnt > 1);
+
+    os_eventq_init(&fmt4_evq);
+    flash_area_async_evq_set(&fmt4_evq);
+
+    /* make the second sector readable */
+    rc = flash_area_erase(fa, fa_sectors[1].fa_off - fa->fa_off, sizeof(rd2));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i;
+    }
+    memset(rd, 0, sizeof(rd));
+    memset(rd2, 0, sizeof(rd2));
+
+    for (i = 0; i < 5; i++) {
+        fmt4_req_init(&req[i], i);
+    }
+    rc = flash_area_erase_async(fa, 0, fa_sectors[0].fa_size, &req[0]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write_async(fa, 0, wd, sizeof(wd), &req[1]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_read_async(fa, 0, rd, sizeof(rd) / 2, &req[2]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_read_async(fa, sizeof(rd) / 2, rd + sizeof(rd) / 2,
+                               sizeof(rd) / 2, &req[3]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_read_async(fa, fa_sectors[1].fa_off - fa->fa_off, rd2,
+                               sizeof(rd2), &req[4]);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* out of range requests are not queued */
+    fmt4_req_init(&bad, 5);
+    rc = flash_area_read_async(fa, fa->fa_size, rd, 1, &bad);
+    TEST_ASSERT(rc != 0);
+
+    for (i = 0; i < 20 && fmt4_done < 5; i++) {
+        os_eventq_run(&fmt4_evq);
+    }
+    TEST_ASSERT_FATAL(fmt4_done == 5);
+
+    /*
+     * The read of the other sector goes ahead of the erase; the reads of the
+     * first sector wait for the write, and are done as one read.
+     */
+    TEST_ASSERT(fmt4_order[0] == 4);
+    TEST_ASSERT(fmt4_order[1] == 0);
+    TEST_ASSERT(fmt4_order[2] == 1);
+    TEST_ASSERT(fmt4_order[3] == 2);
+    TEST_ASSERT(fmt4_order[4] == 3);
+
+    for (i = 0; i < 5; i++) {
+        TEST_ASSERT(req[i].far_rc == 0);
+    }
+    TEST_ASSERT(memcmp(wd, rd, sizeof(rd)) == 0);
+    for (i = 0; i < sizeof(rd2); i++) {
+        TEST_ASSERT(rd2[i] == 0xff);
+    }
+
+    flash_area_async_evq_set(NULL);
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+/*
+ * Test read cache
+ */
+TEST_CASE(flash_map_test_case_5)
+{
+    const struct flash_area *fa;
+    int i;
+    int rc;
+    uint8_t wd[300];
+    uint8_t rd[300];
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_cache_set(FLASH_AREA_IMAGE_0, true);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = flash_area_erase(fa, 0, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* prime the cache with erased contents */
+    rc = flash_area_read(fa, 3, rd, sizeof(rd) - 3);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < sizeof(rd) - 3; i++) {
+        TEST_ASSERT(rd[i] == 0xff);
+    }
+
+    /* write must invalidate the cached lines */
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i * 3;
+    }
+    rc = flash_area_write(fa, 0, wd, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* unaligned reads spanning several lines, twice to hit in the cache */
+    for (i = 0; i < 2; i++) {
+        memset(rd, 0, sizeof(rd));
+        rc = flash_area_read(fa, 7, rd, sizeof(rd) - 7);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(memcmp(rd, wd + 7, sizeof(rd) - 7) == 0);
+    }
+
+    /* and so must erase */
+    rc = flash_area_erase(fa, 0, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < sizeof(rd); i++) {
+        TEST_ASSERT(rd[i] == 0xff);
+    }
+
+    rc = flash_area_cache_set(FLASH_AREA_IMAGE_0, false);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,50 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+/*
+ * Test flash_area_map()
+ */
+TEST_CASE(flash_map_test_case_6)
+{
+    const struct flash_area *fa;
+    const void *ptr;
+    uint8_t wd[64];
+    int i;
+    int rc;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_1, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_erase(fa, 0, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = 0x80 | i;
+    }
+    rc = flash_area_write(fa, 16, wd, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = flash_area_map(fa, 16, sizeof(wd), &ptr);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_map() fail");
+    TEST_ASSERT(memcmp(ptr, wd, sizeof(wd)) == 0);
+
+    rc = flash_area_map(fa, fa->fa_size - 8, 16, &ptr);
+    TEST_ASSERT(rc != 0);
+}
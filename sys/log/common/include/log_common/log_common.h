@@ -68,6 +68,8 @@ extern "C" {
 #if MYNEWT_VAL(LOG_VERSION) > 2
 #define LOG_ETYPE_CBOR           (1)
 #define LOG_ETYPE_BINARY         (2)
+/* Unformatted log_printf(); see LOG_PRINTF_DEFER. */
+#define LOG_ETYPE_FMT            (3)
 #endif
 
 /* Logging medium */
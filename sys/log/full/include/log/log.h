@@ -19,6 +19,7 @@
 #ifndef __SYS_LOG_FULL_H__
 #define __SYS_LOG_FULL_H__
 
+#include <stdarg.h>
 #include "os/mynewt.h"
 #include "cbmem/cbmem.h"
 #include "log_common/log_common.h"
@@ -63,6 +64,12 @@ struct log_storage_info {
 };
 #endif
 
+/* One message body in a call to log_append_batch(). */
+struct log_batch_ent {
+    const void *lbe_body;
+    uint16_t lbe_len;
+};
+
 typedef int (*log_walk_func_t)(struct log *, struct log_offset *log_offset,
         void *dptr, uint16_t len);
 
@@ -82,6 +89,10 @@ typedef int (*lh_append_mbuf_func_t)(struct log *, const struct os_mbuf *om);
 typedef int (*lh_append_mbuf_body_func_t)(struct log *log,
                                           const struct log_entry_hdr *hdr,
                                           const struct os_mbuf *om);
+typedef int (*lh_append_batch_func_t)(struct log *log,
+                                      const struct log_entry_hdr *hdr,
+                                      const struct log_batch_ent *ents,
+                                      int cnt);
 typedef int (*lh_walk_func_t)(struct log *,
         log_walk_func_t walk_func, struct log_offset *log_offset);
 typedef int (*lh_flush_func_t)(struct log *);
@@ -101,6 +112,8 @@ struct log_handler {
     lh_append_body_func_t log_append_body;
     lh_append_mbuf_func_t log_append_mbuf;
     lh_append_mbuf_body_func_t log_append_mbuf_body;
+    /* Optional; log_append_batch() falls back to log_append_body. */
+    lh_append_batch_func_t log_append_batch;
     lh_walk_func_t log_walk;
     lh_flush_func_t log_flush;
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
@@ -177,6 +190,9 @@ struct log {
     void *l_arg;
     STAILQ_ENTRY(log) l_next;
     uint8_t l_level;
+#if MYNEWT_VAL(LOG_ASYNC)
+    uint8_t l_async;
+#endif
 };
 
 /* Log system level functions (for all logs.) */
@@ -358,6 +374,29 @@ int log_append_mbuf_body_no_free(struct log *log, uint8_t module,
 int log_append_mbuf_body(struct log *log, uint8_t module, uint8_t level,
                          uint8_t etype, struct os_mbuf *om);
 
+/**
+ * @brief Writes several messages to a log in one operation.
+ *
+ * The entries share a module, level, type and timestamp, and get
+ * consecutive indices.  Handlers that support it (e.g. FCB) write them with
+ * fewer flash operations than separate log_append_body() calls would.
+ *
+ * @param log                   The log to write to.
+ * @param module                The log module of the entries to write.
+ * @param level                 The severity of the entries to write.
+ * @param etype                 The type of data being written; one of the
+ *                                  `LOG_ETYPE_[...]` constants.
+ * @param ents                  The message bodies to write.
+ * @param cnt                   The number of elements in ents.
+ *
+ * @return                      0 on success; nonzero on failure.  On
+ *                                  failure, a prefix of the entries may
+ *                                  have been written.
+ */
+int log_append_batch(struct log *log, uint8_t module, uint8_t level,
+                     uint8_t etype, const struct log_batch_ent *ents,
+                     int cnt);
+
 #if MYNEWT_VAL(LOG_CONSOLE)
 struct log *log_console_get(void);
 void log_console_init(void);
@@ -598,6 +637,48 @@ int log_storage_info(struct log *log, struct log_storage_info *info);
 int log_set_watermark(struct log *log, uint32_t index);
 #endif
 
+#if MYNEWT_VAL(LOG_ASYNC)
+/**
+ * Switch a log to asynchronous writes
+ *
+ * Entries appended to an asynchronous log are timestamped, indexed and
+ * copied into a RAM ring by the caller, then written to the log's handler
+ * by the log writer task.  Appends never block on the handler; if the ring
+ * is full the entry is dropped, the append fails with SYS_ENOMEM and the
+ * "dropped" statistic of the log_async stats group is incremented.
+ *
+ * @param log    The log to configure; must already be registered.
+ * @param async  1 to write asynchronously, 0 to write in the caller.
+ */
+void log_set_async(struct log *log, int async);
+
+/**
+ * Write out all entries queued for asynchronous logs
+ *
+ * Returns once every fully queued entry has been passed to its handler.
+ */
+void log_async_drain(void);
+#endif
+
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+/**
+ * Format a deferred log_printf() entry
+ *
+ * Expands the body of a LOG_ETYPE_FMT entry into text, as log_printf()
+ * would have at the time of the call.  The entry must have been written
+ * by the running image, since it refers to the format string by address.
+ *
+ * @param body     The entry body.
+ * @param len      Length of the body.
+ * @param buf      The buffer to write the text to; always NUL terminated.
+ * @param buf_len  Size of buf.
+ *
+ * @return         The length of the full text, like snprintf(), or -1 if
+ *                 the body is malformed.
+ */
+int log_fmt_format(const void *body, int len, char *buf, int buf_len);
+#endif
+
 /* Handler exports */
 #if MYNEWT_VAL(LOG_CONSOLE)
 extern const struct log_handler log_console_handler;
@@ -607,11 +688,34 @@ extern const struct log_handler log_cbmem_handler;
 extern const struct log_handler log_fcb_handler;
 extern const struct log_handler log_fcb_slot1_handler;
 #endif
+#if MYNEWT_VAL(LOG_FCB_LZ)
+extern const struct log_handler log_fcb_lz_handler;
+#endif
+#if MYNEWT_VAL(LOG_FANOUT)
+extern const struct log_handler log_fanout_handler;
+#endif
+#if MYNEWT_VAL(LOG_TIER)
+extern const struct log_handler log_tier_handler;
+#endif
 
 /* Private */
 #if MYNEWT_VAL(LOG_NEWTMGR)
 int log_nmgr_register_group(void);
 #endif
+#if MYNEWT_VAL(LOG_ASYNC)
+void log_async_init(void);
+int log_async_append(struct log *log, const void *data, uint16_t len);
+int log_async_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                          const void *body, uint16_t body_len);
+int log_async_append_mbuf(struct log *log, const struct log_entry_hdr *hdr,
+                          const struct os_mbuf *om);
+#endif
+#if MYNEWT_VAL(LOG_FCB_LZ)
+void log_fcb_lz_pkg_init(void);
+#endif
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+int log_fmt_pack(void *buf, int buf_len, const char *fmt, va_list ap);
+#endif
 
 #ifdef __cplusplus
 }
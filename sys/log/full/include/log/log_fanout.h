@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SYS_LOG_FANOUT_H__
+#define __SYS_LOG_FANOUT_H__
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_FANOUT)
+
+#include "log/log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Optional per-sink filter.  Returns nonzero if the entry should be written
+ * to the sink.
+ */
+typedef int (*log_fanout_filter_fn)(const struct log_entry_hdr *hdr,
+                                    void *arg);
+
+/*
+ * One destination of a fanout log.
+ *
+ * lfs_log holds the handler and handler argument of the sink, as passed to
+ * log_register() for a standalone log; lfs_log.l_level is the minimum level
+ * written to this sink.  The sink log is not registered itself.
+ */
+struct log_fanout_sink {
+    struct log lfs_log;
+    log_fanout_filter_fn lfs_filter;
+    void *lfs_filter_arg;
+};
+
+/*
+ * Argument for log_fanout_handler
+ *
+ * Every entry appended to the fanout log is built once and then passed to
+ * each sink which accepts its level and module.  Reads and walks go to the
+ * first sink which is not a stream, typically the FCB or cbmem.  Sinks
+ * without mbuf support (e.g. console) are skipped for mbuf appends.  With
+ * LOG_PRINTF_DEFER, deferred printf entries are expanded to text once for
+ * all stream sinks.
+ *
+ * log_fanout_init() shall be used to initialize this structure.
+ */
+struct log_fanout {
+    struct log_fanout_sink *lf_sinks;
+    int lf_num_sinks;
+    struct log *lf_primary;
+};
+
+/*
+ * Initialize a fanout sink
+ *
+ * @param sink     Sink to initialize
+ * @param lh       Handler of the sink, e.g. log_cbmem_handler
+ * @param arg      Handler argument, as for log_register()
+ * @param level    Minimum level of entries written to this sink
+ */
+void log_fanout_sink_init(struct log_fanout_sink *sink,
+                          const struct log_handler *lh, void *arg,
+                          uint8_t level);
+
+/*
+ * Set a module filter on a fanout sink
+ *
+ * @param sink     Sink to configure
+ * @param filter   Filter function; NULL to accept all modules
+ * @param arg      Argument passed to filter
+ */
+void log_fanout_sink_filter(struct log_fanout_sink *sink,
+                            log_fanout_filter_fn filter, void *arg);
+
+/*
+ * Initialize log data for log_fanout handler
+ *
+ * The fanout log's own level should be no higher than the lowest sink
+ * level, since entries below it are dropped before reaching any sink.
+ * The sinks array must stay valid for as long as the log is used.
+ *
+ * @param lf         Log data structure to initialize
+ * @param sinks      Sinks to write to, initialized with
+ *                   log_fanout_sink_init()
+ * @param num_sinks  Number of entries in sinks
+ *
+ * @return 0 on success, SYS_EINVAL on bad arguments
+ */
+int log_fanout_init(struct log_fanout *lf, struct log_fanout_sink *sinks,
+                    int num_sinks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MYNEWT_VAL(LOG_FANOUT) */
+
+#endif /* __SYS_LOG_FANOUT_H__ */
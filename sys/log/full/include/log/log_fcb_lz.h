@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SYS_LOG_FCB_LZ_H__
+#define __SYS_LOG_FCB_LZ_H__
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_FCB_LZ)
+
+#include "log/log.h"
+#include "fcb/fcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Argument for log_fcb_lz_handler
+ *
+ * Entries are collected in buf and written to the FCB as one compressed
+ * element when the block is full, or when log_fcb_lz_sync() is called.
+ * Entries still in buf are lost on reset.
+ *
+ * log_fcb_lz_init() shall be used to initialize this structure.
+ */
+struct log_fcb_lz {
+    struct log l_fcb;
+
+    uint16_t len;
+    uint8_t buf[MYNEWT_VAL(LOG_FCB_LZ_BLOCK_SIZE)];
+};
+
+/*
+ * Initialize log data for log_fcb_lz handler
+ *
+ * fcb_arg is the same as for log_fcb, and must already be initialized.
+ * Restoring the last fl_entries entries on rotation is not supported, so
+ * fcb_arg->fl_entries must be 0.
+ *
+ * @param lz             Log data structure to initialize
+ * @param fcb_arg        Log data for log_fcb
+ *
+ * @return 0 on success; non-zero on error
+ */
+int log_fcb_lz_init(struct log_fcb_lz *lz, struct fcb_log *fcb_arg);
+
+/*
+ * Write out the entries collected so far as a (partial) compressed block.
+ *
+ * @param log            Log registered with log_fcb_lz_handler
+ *
+ * @return 0 on success; non-zero on error
+ */
+int log_fcb_lz_sync(struct log *log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif /* __SYS_LOG_FCB_LZ_H__ */
@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SYS_LOG_TIER_H__
+#define __SYS_LOG_TIER_H__
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_TIER)
+
+#include "log/log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Argument for log_tier_handler
+ *
+ * Entries are appended to a RAM tier (typically cbmem) only, and copied to
+ * a flash tier (typically FCB) in batches from the default event queue:
+ * once lt_spill_thresh bytes are waiting, and every LOG_TIER_SPILL_ITVL ms
+ * otherwise.  Entries keep the index they were logged with, so walks and
+ * reads see the flash tier followed by the entries which have not been
+ * copied yet, as one log.  If the RAM tier wraps before its entries are
+ * copied, the overwritten entries are lost; size lt_spill_thresh
+ * accordingly.
+ *
+ * log_tier_init() shall be used to initialize this structure.
+ */
+struct log_tier {
+    struct log lt_ram;
+    struct log lt_flash;
+    uint32_t lt_spill_thresh;
+    uint32_t lt_pending;
+    uint32_t lt_flash_last;
+    uint8_t lt_flash_any;
+    struct os_event lt_ev;
+};
+
+/*
+ * Initialize log data for log_tier handler
+ *
+ * @param lt            Log data structure to initialize
+ * @param ram_lh        Handler of the RAM tier, e.g. log_cbmem_handler
+ * @param ram_arg       Argument of the RAM tier, as for log_register()
+ * @param flash_lh      Handler of the flash tier, e.g. log_fcb_handler
+ * @param flash_arg     Argument of the flash tier, as for log_register()
+ * @param spill_thresh  Bytes appended to the RAM tier which trigger a copy
+ *                      to flash; should be well below the RAM tier size
+ *
+ * @return 0 on success, SYS_EINVAL on bad arguments
+ */
+int log_tier_init(struct log_tier *lt,
+                  const struct log_handler *ram_lh, void *ram_arg,
+                  const struct log_handler *flash_lh, void *flash_arg,
+                  uint32_t spill_thresh);
+
+/*
+ * Copy all entries which are only in RAM to flash now.
+ *
+ * @param log  Log registered with log_tier_handler
+ *
+ * @return 0 on success, SYS_EIO if the flash tier failed
+ */
+int log_tier_spill(struct log *log);
+
+/*
+ * Copy the RAM-only entries of every registered tiered log to flash,
+ * without taking any locks.  For use from fault and coredump paths, where
+ * the system is about to reset.
+ */
+void log_tier_spill_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MYNEWT_VAL(LOG_TIER) */
+
+#endif /* __SYS_LOG_TIER_H__ */
@@ -144,6 +144,14 @@ log_init(void)
     log_console_init();
 #endif
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    log_async_init();
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_LZ)
+    log_fcb_lz_pkg_init();
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
     rc = conf_register(&log_conf);
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -319,6 +327,9 @@ log_register(char *name, struct log *log, const struct log_handler *lh,
     log->l_log = lh;
     log->l_arg = arg;
     log->l_level = level;
+#if MYNEWT_VAL(LOG_ASYNC)
+    log->l_async = 0;
+#endif
 
     if (!log_registered(log)) {
         STAILQ_INSERT_TAIL(&g_log_list, log, l_next);
@@ -347,9 +358,25 @@ log_register(char *name, struct log *log, const struct log_handler *lh,
     return (0);
 }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+void
+log_set_async(struct log *log, int async)
+{
+    if (!async && log->l_async) {
+        /* Keep entries already queued ahead of synchronous ones. */
+        log_async_drain();
+    }
+    log->l_async = async;
+}
+#endif
+
+/**
+ * Fills in the header for the first of cnt entries and reserves an index for
+ * each of them.
+ */
 static int
-log_append_prepare(struct log *log, uint8_t module, uint8_t level,
-                   uint8_t etype, struct log_entry_hdr *ue)
+log_append_prepare_n(struct log *log, uint8_t module, uint8_t level,
+                     uint8_t etype, uint32_t cnt, struct log_entry_hdr *ue)
 {
     int rc;
     int sr;
@@ -384,7 +411,8 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
     }
 
     OS_ENTER_CRITICAL(sr);
-    idx = g_log_info.li_next_index++;
+    idx = g_log_info.li_next_index;
+    g_log_info.li_next_index += cnt;
     OS_EXIT_CRITICAL(sr);
 
     /* Try to get UTC Time */
@@ -408,6 +436,13 @@ err:
     return (rc);
 }
 
+static int
+log_append_prepare(struct log *log, uint8_t module, uint8_t level,
+                   uint8_t etype, struct log_entry_hdr *ue)
+{
+    return log_append_prepare_n(log, module, level, etype, 1, ue);
+}
+
 int
 log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
                  void *data, uint16_t len)
@@ -420,6 +455,12 @@ log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         goto err;
     }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append(log, data, len + LOG_ENTRY_HDR_SIZE);
+    }
+#endif
+
     rc = log->l_log->log_append(log, data, len + LOG_ENTRY_HDR_SIZE);
     if (rc != 0) {
         goto err;
@@ -442,6 +483,12 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append_body(log, &hdr, body, body_len);
+    }
+#endif
+
     rc = log->l_log->log_append_body(log, &hdr, body, body_len);
     if (rc != 0) {
         return rc;
@@ -477,6 +524,17 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        rc = log_async_append_mbuf(log, NULL, om);
+        if (rc != 0) {
+            goto err;
+        }
+        *om_ptr = om;
+        return 0;
+    }
+#endif
+
     rc = log->l_log->log_append_mbuf(log, om);
     if (rc != 0) {
         goto err;
@@ -526,6 +584,12 @@ log_append_mbuf_body_no_free(struct log *log, uint8_t module, uint8_t level,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append_mbuf(log, &hdr, om);
+    }
+#endif
+
     rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
     if (rc != 0) {
         return rc;
@@ -546,6 +610,53 @@ log_append_mbuf_body(struct log *log, uint8_t module, uint8_t level,
     return rc;
 }
 
+int
+log_append_batch(struct log *log, uint8_t module, uint8_t level,
+                 uint8_t etype, const struct log_batch_ent *ents, int cnt)
+{
+    struct log_entry_hdr hdr;
+    int rc;
+    int i;
+
+    if (cnt <= 0) {
+        return SYS_EINVAL;
+    }
+
+    rc = log_append_prepare_n(log, module, level, etype, cnt, &hdr);
+    if (rc != 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        for (i = 0; i < cnt; i++) {
+            rc = log_async_append_body(log, &hdr, ents[i].lbe_body,
+                                       ents[i].lbe_len);
+            if (rc != 0) {
+                return rc;
+            }
+            hdr.ue_index++;
+        }
+        return 0;
+    }
+#endif
+
+    if (log->l_log->log_append_batch) {
+        return log->l_log->log_append_batch(log, &hdr, ents, cnt);
+    }
+
+    for (i = 0; i < cnt; i++) {
+        rc = log->l_log->log_append_body(log, &hdr, ents[i].lbe_body,
+                                         ents[i].lbe_len);
+        if (rc != 0) {
+            return rc;
+        }
+        hdr.ue_index++;
+    }
+
+    return 0;
+}
+
 void
 log_printf(struct log *log, uint8_t module, uint8_t level,
            const char *msg, ...)
@@ -554,6 +665,19 @@ log_printf(struct log *log, uint8_t module, uint8_t level,
     char buf[LOG_PRINTF_MAX_ENTRY_LEN];
     int len;
 
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+    /* Streams are read by people; leave formatting to readers otherwise. */
+    if (log->l_log->log_type != LOG_TYPE_STREAM) {
+        va_start(args, msg);
+        len = log_fmt_pack(buf, sizeof(buf), msg, args);
+        va_end(args);
+        if (len >= 0) {
+            log_append_body(log, module, level, LOG_ETYPE_FMT, buf, len);
+            return;
+        }
+    }
+#endif
+
     va_start(args, msg);
     len = vsnprintf(buf, LOG_PRINTF_MAX_ENTRY_LEN, msg, args);
     va_end(args);
@@ -710,6 +834,13 @@ log_flush(struct log *log)
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        /* Don't let queued entries land after the flush. */
+        log_async_drain();
+    }
+#endif
+
     rc = log->l_log->log_flush(log);
     if (rc != 0) {
         goto err;
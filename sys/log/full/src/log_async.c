@@ -0,0 +1,338 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+#include <string.h>
+#include "defs/error.h"
+#include "stats/stats.h"
+#include "log/log.h"
+
+/*
+ * Asynchronous log writer.
+ *
+ * Appending tasks reserve space for an entry in a RAM ring, copy the entry
+ * in and mark it ready; the only thing serialized between them is the
+ * reservation, which is a few instructions with interrupts disabled.  The
+ * log writer task drains ready entries in order and hands them to the
+ * log's handler, so callers never wait on an FCB or cbmem lock.
+ *
+ * Entries never wrap around the end of the buffer.  If the tail of the
+ * buffer is too short for an entry it is skipped, marked with a padding
+ * entry when there is room for one.
+ */
+
+#define LOG_ASYNC_BUF_SIZE  MYNEWT_VAL(LOG_ASYNC_BUF_SIZE)
+
+#if LOG_ASYNC_BUF_SIZE % 4 != 0
+#error "LOG_ASYNC_BUF_SIZE must be a multiple of 4"
+#endif
+
+struct log_async_ent {
+    /* Log the entry is for; NULL marks padding up to the end of the ring */
+    struct log *lae_log;
+    /* Length of the entry that follows, header included */
+    uint16_t lae_len;
+    /* Set once the entry has been copied in */
+    uint8_t lae_ready;
+    uint8_t _pad;
+};
+
+#define LOG_ASYNC_ENT_SIZE(len)                                         \
+    OS_ALIGN(sizeof(struct log_async_ent) + (len), 4)
+
+STATS_SECT_START(log_async_stats)
+    STATS_SECT_ENTRY(queued)
+    STATS_SECT_ENTRY(written)
+    STATS_SECT_ENTRY(dropped)
+    STATS_SECT_ENTRY(errors)
+STATS_SECT_END
+
+STATS_NAME_START(log_async_stats)
+    STATS_NAME(log_async_stats, queued)
+    STATS_NAME(log_async_stats, written)
+    STATS_NAME(log_async_stats, dropped)
+    STATS_NAME(log_async_stats, errors)
+STATS_NAME_END(log_async_stats)
+
+static STATS_SECT_DECL(log_async_stats) log_async_stats;
+
+static uint32_t log_async_buf[LOG_ASYNC_BUF_SIZE / 4];
+static uint16_t log_async_head;
+static uint16_t log_async_tail;
+static uint16_t log_async_used;
+
+static struct os_mutex log_async_drain_mtx;
+static struct os_eventq log_async_evq;
+static struct os_task log_async_task;
+OS_TASK_STACK_DEFINE(log_async_stack, MYNEWT_VAL(LOG_ASYNC_STACK_SIZE));
+
+static void log_async_drain_ev(struct os_event *ev);
+
+static struct os_event log_async_ev = {
+    .ev_cb = log_async_drain_ev,
+};
+
+static inline struct log_async_ent *
+log_async_ent_at(uint16_t off)
+{
+    return (struct log_async_ent *)((uint8_t *)log_async_buf + off);
+}
+
+/**
+ * Reserves ring space for an entry of the given length.
+ *
+ * @return                      The entry, or NULL if the ring is full.
+ */
+static struct log_async_ent *
+log_async_reserve(struct log *log, uint16_t len)
+{
+    struct log_async_ent *ent;
+    uint16_t skip;
+    uint16_t off;
+    uint32_t sz;
+    os_sr_t sr;
+
+    sz = LOG_ASYNC_ENT_SIZE(len);
+    if (sz > LOG_ASYNC_BUF_SIZE) {
+        return NULL;
+    }
+
+    skip = 0;
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (log_async_used == 0) {
+        /* Empty; start over at the beginning for maximum room. */
+        log_async_head = 0;
+        log_async_tail = 0;
+    }
+
+    ent = NULL;
+    off = log_async_head;
+    if (log_async_used != 0 && log_async_head <= log_async_tail) {
+        /* Free space is the gap between head and tail. */
+        if (log_async_tail - log_async_head < sz) {
+            goto out;
+        }
+    } else if (LOG_ASYNC_BUF_SIZE - log_async_head < sz) {
+        /* Doesn't fit before the end; wrap if it fits before the tail. */
+        if (log_async_tail < sz) {
+            goto out;
+        }
+        skip = LOG_ASYNC_BUF_SIZE - log_async_head;
+        if (skip >= sizeof(*ent)) {
+            log_async_ent_at(log_async_head)->lae_log = NULL;
+        }
+        off = 0;
+    }
+
+    ent = log_async_ent_at(off);
+    ent->lae_log = log;
+    ent->lae_len = len;
+    ent->lae_ready = 0;
+
+    log_async_head = (off + sz) % LOG_ASYNC_BUF_SIZE;
+    log_async_used += skip + sz;
+
+out:
+    OS_EXIT_CRITICAL(sr);
+
+    if (ent == NULL) {
+        STATS_INC(log_async_stats, dropped);
+        return NULL;
+    }
+    return ent;
+}
+
+static void
+log_async_commit(struct log_async_ent *ent)
+{
+    os_sr_t sr;
+
+    /* The critical section also orders the copy before the flag. */
+    OS_ENTER_CRITICAL(sr);
+    ent->lae_ready = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    STATS_INC(log_async_stats, queued);
+    os_eventq_put(&log_async_evq, &log_async_ev);
+}
+
+int
+log_async_append(struct log *log, const void *data, uint16_t len)
+{
+    struct log_async_ent *ent;
+
+    ent = log_async_reserve(log, len);
+    if (ent == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    memcpy(ent + 1, data, len);
+    log_async_commit(ent);
+
+    return 0;
+}
+
+int
+log_async_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                      const void *body, uint16_t body_len)
+{
+    struct log_async_ent *ent;
+    uint8_t *dst;
+
+    ent = log_async_reserve(log, LOG_ENTRY_HDR_SIZE + body_len);
+    if (ent == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    dst = (uint8_t *)(ent + 1);
+    memcpy(dst, hdr, LOG_ENTRY_HDR_SIZE);
+    memcpy(dst + LOG_ENTRY_HDR_SIZE, body, body_len);
+    log_async_commit(ent);
+
+    return 0;
+}
+
+int
+log_async_append_mbuf(struct log *log, const struct log_entry_hdr *hdr,
+                      const struct os_mbuf *om)
+{
+    struct log_async_ent *ent;
+    uint16_t len;
+    uint8_t *dst;
+
+    /* Without a separate header, the mbuf starts with it. */
+    len = OS_MBUF_PKTLEN(om);
+    if (hdr != NULL) {
+        len += LOG_ENTRY_HDR_SIZE;
+    }
+
+    ent = log_async_reserve(log, len);
+    if (ent == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    dst = (uint8_t *)(ent + 1);
+    if (hdr != NULL) {
+        memcpy(dst, hdr, LOG_ENTRY_HDR_SIZE);
+        dst += LOG_ENTRY_HDR_SIZE;
+    }
+    os_mbuf_copydata(om, 0, OS_MBUF_PKTLEN(om), dst);
+    log_async_commit(ent);
+
+    return 0;
+}
+
+void
+log_async_drain(void)
+{
+    struct log_async_ent *ent;
+    uint16_t skip;
+    uint16_t sz;
+    os_sr_t sr;
+    int rc;
+
+    /* Before the OS is started this is a no-op; there is no contention. */
+    os_mutex_pend(&log_async_drain_mtx, OS_TIMEOUT_NEVER);
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (log_async_used == 0) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        skip = LOG_ASYNC_BUF_SIZE - log_async_tail;
+        if (skip < sizeof(*ent) ||
+            log_async_ent_at(log_async_tail)->lae_log == NULL) {
+            /* Padding up to the end of the ring. */
+            log_async_tail = 0;
+            log_async_used -= skip;
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+        ent = log_async_ent_at(log_async_tail);
+        OS_EXIT_CRITICAL(sr);
+
+        if (!ent->lae_ready) {
+            /*
+             * Still being copied in; the appender posts the drain event
+             * again when it is done.
+             */
+            break;
+        }
+
+        rc = ent->lae_log->l_log->log_append(ent->lae_log, ent + 1,
+                                             ent->lae_len);
+        if (rc == 0) {
+            STATS_INC(log_async_stats, written);
+        } else {
+            STATS_INC(log_async_stats, errors);
+        }
+
+        sz = LOG_ASYNC_ENT_SIZE(ent->lae_len);
+        OS_ENTER_CRITICAL(sr);
+        log_async_tail = (log_async_tail + sz) % LOG_ASYNC_BUF_SIZE;
+        log_async_used -= sz;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    os_mutex_release(&log_async_drain_mtx);
+}
+
+static void
+log_async_drain_ev(struct os_event *ev)
+{
+    log_async_drain();
+}
+
+static void
+log_async_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_async_evq);
+    }
+}
+
+void
+log_async_init(void)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(log_async_stats),
+                            STATS_SIZE_INIT_PARMS(log_async_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(log_async_stats),
+                            "log_async");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_mutex_init(&log_async_drain_mtx);
+    os_eventq_init(&log_async_evq);
+
+    rc = os_task_init(&log_async_task, "log", log_async_task_handler, NULL,
+                      MYNEWT_VAL(LOG_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                      log_async_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(LOG_ASYNC_STACK_SIZE)));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
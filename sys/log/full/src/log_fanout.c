@@ -0,0 +1,391 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FANOUT)
+
+#include <string.h>
+
+#include "log/log.h"
+#include "log/log_fanout.h"
+
+/* Deferred printf entries are text to stream sinks. */
+#define LOG_FANOUT_EXPAND                                           \
+    (MYNEWT_VAL(LOG_PRINTF_DEFER) && MYNEWT_VAL(LOG_VERSION) > 2)
+
+static int
+log_fanout_accept(const struct log_fanout_sink *sink,
+                  const struct log_entry_hdr *hdr)
+{
+    if (hdr->ue_level < sink->lfs_log.l_level) {
+        return 0;
+    }
+    if (sink->lfs_filter != NULL &&
+        !sink->lfs_filter(hdr, sink->lfs_filter_arg)) {
+        return 0;
+    }
+    return 1;
+}
+
+static int
+log_fanout_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                       const void *body, int body_len)
+{
+    struct log_fanout_sink *sink;
+    struct log_fanout *lf;
+    int rc;
+    int i;
+#if LOG_FANOUT_EXPAND
+    struct log_entry_hdr txt_hdr;
+    char txt[LOG_PRINTF_MAX_ENTRY_LEN];
+    int txt_len;
+
+    txt_len = -1;
+#endif
+
+    lf = log->l_arg;
+    rc = 0;
+
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        if (!log_fanout_accept(sink, hdr)) {
+            continue;
+        }
+
+#if LOG_FANOUT_EXPAND
+        if (hdr->ue_etype == LOG_ETYPE_FMT &&
+            sink->lfs_log.l_log->log_type == LOG_TYPE_STREAM) {
+
+            /* Format at most once, however many streams there are. */
+            if (txt_len < 0) {
+                txt_len = log_fmt_format(body, body_len, txt, sizeof txt);
+                if (txt_len < 0) {
+                    continue;
+                }
+                if (txt_len >= (int)sizeof txt) {
+                    txt_len = sizeof txt - 1;
+                }
+                txt_hdr = *hdr;
+                txt_hdr.ue_etype = LOG_ETYPE_STRING;
+            }
+            if (sink->lfs_log.l_log->log_append_body(&sink->lfs_log,
+                                                     &txt_hdr, txt,
+                                                     txt_len) != 0) {
+                rc = SYS_EIO;
+            }
+            continue;
+        }
+#endif
+
+        if (sink->lfs_log.l_log->log_append_body(&sink->lfs_log, hdr, body,
+                                                 body_len) != 0) {
+            rc = SYS_EIO;
+        }
+    }
+
+    return rc;
+}
+
+static int
+log_fanout_append(struct log *log, void *buf, int len)
+{
+    return log_fanout_append_body(log, buf,
+                                  (uint8_t *)buf + LOG_ENTRY_HDR_SIZE,
+                                  len - LOG_ENTRY_HDR_SIZE);
+}
+
+static int
+log_fanout_append_mbuf(struct log *log, const struct os_mbuf *om)
+{
+    struct log_fanout_sink *sink;
+    struct log_entry_hdr hdr;
+    struct log_fanout *lf;
+    int rc;
+    int i;
+
+    if (os_mbuf_copydata(om, 0, LOG_ENTRY_HDR_SIZE, &hdr) != 0) {
+        return SYS_EINVAL;
+    }
+
+    lf = log->l_arg;
+    rc = 0;
+
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        if (sink->lfs_log.l_log->log_append_mbuf == NULL ||
+            !log_fanout_accept(sink, &hdr)) {
+            continue;
+        }
+        if (sink->lfs_log.l_log->log_append_mbuf(&sink->lfs_log, om) != 0) {
+            rc = SYS_EIO;
+        }
+    }
+
+    return rc;
+}
+
+static int
+log_fanout_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
+                            const struct os_mbuf *om)
+{
+    struct log_fanout_sink *sink;
+    struct log_fanout *lf;
+    int rc;
+    int i;
+
+    lf = log->l_arg;
+    rc = 0;
+
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        if (sink->lfs_log.l_log->log_append_mbuf_body == NULL ||
+            !log_fanout_accept(sink, hdr)) {
+            continue;
+        }
+        if (sink->lfs_log.l_log->log_append_mbuf_body(&sink->lfs_log, hdr,
+                                                      om) != 0) {
+            rc = SYS_EIO;
+        }
+    }
+
+    return rc;
+}
+
+static int
+log_fanout_append_batch(struct log *log, const struct log_entry_hdr *hdr,
+                        const struct log_batch_ent *ents, int cnt)
+{
+    struct log_entry_hdr ent_hdr;
+    struct log_fanout_sink *sink;
+    struct log_fanout *lf;
+    int rc;
+    int i;
+    int j;
+
+    lf = log->l_arg;
+    rc = 0;
+
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        if (!log_fanout_accept(sink, hdr)) {
+            continue;
+        }
+
+        if (sink->lfs_log.l_log->log_append_batch != NULL) {
+            if (sink->lfs_log.l_log->log_append_batch(&sink->lfs_log, hdr,
+                                                      ents, cnt) != 0) {
+                rc = SYS_EIO;
+            }
+            continue;
+        }
+
+        ent_hdr = *hdr;
+        for (j = 0; j < cnt; j++) {
+            if (sink->lfs_log.l_log->log_append_body(&sink->lfs_log,
+                                                     &ent_hdr,
+                                                     ents[j].lbe_body,
+                                                     ents[j].lbe_len) != 0) {
+                rc = SYS_EIO;
+                break;
+            }
+            ent_hdr.ue_index++;
+        }
+    }
+
+    return rc;
+}
+
+static int
+log_fanout_read(struct log *log, void *dptr, void *buf, uint16_t offset,
+                uint16_t len)
+{
+    struct log *primary;
+
+    primary = ((struct log_fanout *)log->l_arg)->lf_primary;
+    if (primary == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return primary->l_log->log_read(primary, dptr, buf, offset, len);
+}
+
+static int
+log_fanout_read_mbuf(struct log *log, void *dptr, struct os_mbuf *om,
+                     uint16_t offset, uint16_t len)
+{
+    struct log *primary;
+
+    primary = ((struct log_fanout *)log->l_arg)->lf_primary;
+    if (primary == NULL || primary->l_log->log_read_mbuf == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return primary->l_log->log_read_mbuf(primary, dptr, om, offset, len);
+}
+
+static int
+log_fanout_walk(struct log *log, log_walk_func_t walk_func,
+                struct log_offset *log_offset)
+{
+    struct log *primary;
+
+    primary = ((struct log_fanout *)log->l_arg)->lf_primary;
+    if (primary == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return primary->l_log->log_walk(primary, walk_func, log_offset);
+}
+
+static int
+log_fanout_flush(struct log *log)
+{
+    struct log_fanout_sink *sink;
+    struct log_fanout *lf;
+    int rc;
+    int i;
+
+    lf = log->l_arg;
+    rc = 0;
+
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        if (sink->lfs_log.l_log->log_flush(&sink->lfs_log) != 0) {
+            rc = SYS_EIO;
+        }
+    }
+
+    return rc;
+}
+
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+static int
+log_fanout_storage_info(struct log *log, struct log_storage_info *info)
+{
+    struct log *primary;
+
+    primary = ((struct log_fanout *)log->l_arg)->lf_primary;
+    if (primary == NULL || primary->l_log->log_storage_info == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return primary->l_log->log_storage_info(primary, info);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+static int
+log_fanout_set_watermark(struct log *log, uint32_t index)
+{
+    struct log *primary;
+
+    primary = ((struct log_fanout *)log->l_arg)->lf_primary;
+    if (primary == NULL || primary->l_log->log_set_watermark == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return primary->l_log->log_set_watermark(primary, index);
+}
+#endif
+
+static int
+log_fanout_registered(struct log *log)
+{
+    struct log_fanout_sink *sink;
+    struct log_fanout *lf;
+    int i;
+
+    lf = log->l_arg;
+
+    /* l_log, l_arg and l_level are set in log_fanout_sink_init() */
+    for (i = 0; i < lf->lf_num_sinks; i++) {
+        sink = &lf->lf_sinks[i];
+        sink->lfs_log.l_name = log->l_name;
+        if (sink->lfs_log.l_log->log_registered != NULL) {
+            sink->lfs_log.l_log->log_registered(&sink->lfs_log);
+        }
+    }
+
+    return 0;
+}
+
+const struct log_handler log_fanout_handler = {
+    .log_type = LOG_TYPE_STORAGE,
+    .log_read = log_fanout_read,
+    .log_read_mbuf = log_fanout_read_mbuf,
+    .log_append = log_fanout_append,
+    .log_append_body = log_fanout_append_body,
+    .log_append_mbuf = log_fanout_append_mbuf,
+    .log_append_mbuf_body = log_fanout_append_mbuf_body,
+    .log_append_batch = log_fanout_append_batch,
+    .log_walk = log_fanout_walk,
+    .log_flush = log_fanout_flush,
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+    .log_storage_info = log_fanout_storage_info,
+#endif
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    .log_set_watermark = log_fanout_set_watermark,
+#endif
+    .log_registered = log_fanout_registered,
+};
+
+void
+log_fanout_sink_init(struct log_fanout_sink *sink,
+                     const struct log_handler *lh, void *arg, uint8_t level)
+{
+    memset(sink, 0, sizeof(*sink));
+
+    sink->lfs_log.l_log = lh;
+    sink->lfs_log.l_arg = arg;
+    sink->lfs_log.l_level = level;
+}
+
+void
+log_fanout_sink_filter(struct log_fanout_sink *sink,
+                       log_fanout_filter_fn filter, void *arg)
+{
+    sink->lfs_filter = filter;
+    sink->lfs_filter_arg = arg;
+}
+
+int
+log_fanout_init(struct log_fanout *lf, struct log_fanout_sink *sinks,
+                int num_sinks)
+{
+    int i;
+
+    if (sinks == NULL || num_sinks <= 0) {
+        return SYS_EINVAL;
+    }
+
+    memset(lf, 0, sizeof(*lf));
+
+    lf->lf_sinks = sinks;
+    lf->lf_num_sinks = num_sinks;
+
+    for (i = 0; i < num_sinks; i++) {
+        if (sinks[i].lfs_log.l_log == NULL) {
+            return SYS_EINVAL;
+        }
+        if (lf->lf_primary == NULL &&
+            sinks[i].lfs_log.l_log->log_type != LOG_TYPE_STREAM) {
+            lf->lf_primary = &sinks[i].lfs_log;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(LOG_FANOUT) */
@@ -30,24 +30,244 @@
 /* Assume the flash alignment requirement is no stricter than 8. */
 #define LOG_FCB_MAX_ALIGN   8
 
+/* Number of entries log_fcb_append_batch() reserves space for at a time. */
+#define LOG_FCB_BATCH_MAX   8
+
 static struct flash_area sector;
 
 static int log_fcb_rtr_erase(struct log *log, void *arg);
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+/*
+ * Set while entries are being copied to and from the scratch area; the
+ * copies go through the regular append path with a bare struct fcb as
+ * the log argument.
+ */
+static uint8_t log_fcb_idx_suspended;
+
+static struct fcb_log_sector *
+log_fcb_idx_sector(struct fcb_log *fcb_log, const struct flash_area *fa)
+{
+    int i;
+
+    i = fa - fcb_log->fl_fcb.f_sectors;
+    if (i < 0 || i >= MYNEWT_VAL(LOG_FCB_SECTOR_INDEX_MAX)) {
+        return NULL;
+    }
+    return &fcb_log->fl_sectors[i];
+}
+
+static struct flash_area *
+log_fcb_idx_next_area(struct fcb *fcb, struct flash_area *fa)
+{
+    fa++;
+    if (fa == &fcb->f_sectors[fcb->f_sector_cnt]) {
+        fa = &fcb->f_sectors[0];
+    }
+    return fa;
+}
+
+/**
+ * Records the entry just appended at loc if it is the first one in its
+ * sector.  Recording a later entry instead is harmless; it only makes
+ * seeks start a sector early.
+ */
+static void
+log_fcb_idx_note(struct log *log, const struct fcb_entry *loc,
+                 const void *hdrp)
+{
+    struct fcb_log_sector *fls;
+    struct log_entry_hdr hdr;
+
+    if (log_fcb_idx_suspended) {
+        return;
+    }
+    fls = log_fcb_idx_sector(log->l_arg, loc->fe_area);
+    if (fls != NULL && !fls->fls_valid) {
+        memcpy(&hdr, hdrp, sizeof(hdr));
+        fls->fls_index = hdr.ue_index;
+        fls->fls_ts = hdr.ue_ts;
+        fls->fls_valid = 1;
+    }
+}
+
+/**
+ * Rebuilds the index by reading the first entry header of every sector in
+ * use.
+ */
+static void
+log_fcb_idx_rebuild(struct fcb_log *fcb_log)
+{
+    struct fcb_log_sector *fls;
+    struct log_entry_hdr hdr;
+    struct flash_area *fa;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int rc;
+
+    fcb = &fcb_log->fl_fcb;
+    memset(fcb_log->fl_sectors, 0, sizeof(fcb_log->fl_sectors));
+
+    fa = fcb->f_oldest;
+    while (1) {
+        fls = log_fcb_idx_sector(fcb_log, fa);
+        memset(&loc, 0, sizeof(loc));
+        loc.fe_area = fa;
+        if (fls != NULL && fcb_getnext(fcb, &loc) == 0 && loc.fe_area == fa) {
+            rc = flash_area_read(fa, loc.fe_data_off, &hdr, sizeof(hdr));
+            if (rc == 0) {
+                fls->fls_index = hdr.ue_index;
+                fls->fls_ts = hdr.ue_ts;
+                fls->fls_valid = 1;
+            }
+        }
+        if (fa == fcb->f_active.fe_area) {
+            break;
+        }
+        fa = log_fcb_idx_next_area(fcb, fa);
+    }
+}
+
+/**
+ * Points loc at the first entry of the sector a walk with the given
+ * filter should start from.  Leaves loc alone (i.e. start at the oldest
+ * entry) if the index can't tell.
+ */
+static void
+log_fcb_idx_seek(struct fcb_log *fcb_log, const struct log_offset *log_offset,
+                 struct fcb_entry *loc)
+{
+    struct fcb_log_sector *fls;
+    struct flash_area *start;
+    struct flash_area *prev;
+    struct flash_area *fa;
+    struct fcb *fcb;
+    int64_t last_ts;
+
+    if (log_offset->lo_ts == 0 && log_offset->lo_index == 0) {
+        return;
+    }
+
+    fcb = &fcb_log->fl_fcb;
+    start = NULL;
+    prev = NULL;
+    last_ts = INT64_MIN;
+
+    /*
+     * Find the newest sector which starts before the requested entry.
+     * Sector start indices increase monotonically; timestamps usually do,
+     * but the clock may be set backwards, in which case don't seek.
+     */
+    fa = fcb->f_oldest;
+    while (1) {
+        fls = log_fcb_idx_sector(fcb_log, fa);
+        if (fls != NULL && fls->fls_valid) {
+            if (log_offset->lo_ts == 0) {
+                if (fls->fls_index < log_offset->lo_index) {
+                    start = prev;
+                }
+            } else {
+                if (fls->fls_ts < last_ts) {
+                    return;
+                }
+                last_ts = fls->fls_ts;
+                if (fls->fls_ts < log_offset->lo_ts) {
+                    start = prev;
+                }
+            }
+        }
+        if (fa == fcb->f_active.fe_area) {
+            break;
+        }
+        prev = fa;
+        fa = log_fcb_idx_next_area(fcb, fa);
+    }
+
+    /*
+     * start is the sector before the one found: entries are indexed and
+     * timestamped before they are written, so a few at the end of that
+     * sector may still qualify.
+     */
+    if (start != NULL) {
+        loc->fe_area = start;
+        loc->fe_elem_off = 0;
+    }
+}
+#endif
+
+/**
+ * Makes room for more entries, by erasing the oldest sector or, if the log
+ * keeps a number of entries, by restoring just those.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
 static int
-log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
+log_fcb_make_room(struct log *log)
 {
     struct fcb *fcb;
     struct fcb_log *fcb_log;
     struct flash_area *old_fa;
-    int rc = 0;
+    int rc;
 
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
+    if (fcb_log->fl_entries) {
+        return log_fcb_rtr_erase(log, fcb_log);
+    }
+
+    old_fa = fcb->f_oldest;
+    (void)old_fa; /* to avoid #ifdefs everywhere... */
+
+    rc = fcb_rotate(fcb);
+    if (rc) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (!log_fcb_idx_suspended) {
+        struct fcb_log_sector *fls;
+
+        fls = log_fcb_idx_sector(fcb_log, old_fa);
+        if (fls != NULL) {
+            fls->fls_valid = 0;
+        }
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    /*
+     * FCB was rotated successfully so let's check if watermark was within
+     * oldest flash area which was erased. If yes, then move watermark to
+     * beginning of current oldest area.
+     */
+    if ((fcb_log->fl_watermark_off >= old_fa->fa_off) &&
+        (fcb_log->fl_watermark_off < old_fa->fa_off + old_fa->fa_size)) {
+        fcb_log->fl_watermark_off = fcb->f_oldest->fa_off;
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * Reserves space for up to cnt entries, rotating the log as needed.
+ *
+ * @return                      The number of entries reserved on success;
+ *                              negative FCB error code on failure.
+ */
+static int
+log_fcb_start_append_multi(struct log *log, const uint16_t *lens, int cnt,
+                           struct fcb_entry *locs)
+{
+    struct fcb *fcb;
+    int rc = 0;
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+
     while (1) {
-        rc = fcb_append(fcb, len, loc);
-        if (rc == 0) {
+        rc = fcb_append_multi(fcb, lens, cnt, locs);
+        if (rc > 0) {
             break;
         }
 
@@ -55,39 +275,56 @@ log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
             goto err;
         }
 
-        if (fcb_log->fl_entries) {
-            rc = log_fcb_rtr_erase(log, fcb_log);
-            if (rc) {
-                goto err;
-            }
-            continue;
+        rc = log_fcb_make_room(log);
+        if (rc) {
+            goto err;
         }
+    }
 
-        old_fa = fcb->f_oldest;
-        (void)old_fa; /* to avoid #ifdefs everywhere... */
+err:
+    return (rc);
+}
 
-        rc = fcb_rotate(fcb);
-        if (rc) {
-            goto err;
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+/**
+ * Appends a complete entry through the FCB write buffer, rotating the log
+ * as needed.
+ */
+static int
+log_fcb_append_bufs(struct log *log, const struct fcb_buf *bufs, int cnt,
+                    struct fcb_entry *loc)
+{
+    struct fcb *fcb;
+    int rc;
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+
+    while (1) {
+        rc = fcb_append_bufs(fcb, bufs, cnt, loc);
+        if (rc != FCB_ERR_NOSPACE) {
+            return rc;
         }
 
-#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
-        /*
-         * FCB was rotated successfully so let's check if watermark was within
-         * oldest flash area which was erased. If yes, then move watermark to
-         * beginning of current oldest area.
-         */
-        if ((fcb_log->fl_watermark_off >= old_fa->fa_off) &&
-            (fcb_log->fl_watermark_off < old_fa->fa_off + old_fa->fa_size)) {
-            fcb_log->fl_watermark_off = fcb->f_oldest->fa_off;
+        rc = log_fcb_make_room(log);
+        if (rc) {
+            return rc;
         }
+    }
+}
 #endif
 
+static int
+log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
+{
+    uint16_t len16;
+    int rc;
 
+    len16 = len;
+    rc = log_fcb_start_append_multi(log, &len16, 1, loc);
+    if (rc < 0) {
+        return rc;
     }
-
-err:
-    return (rc);
+    return 0;
 }
 
 static int
@@ -101,6 +338,15 @@ log_fcb_append(struct log *log, void *buf, int len)
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    if (fcb->f_wbuf) {
+        struct fcb_buf fb = { .fb_data = buf, .fb_len = len };
+
+        rc = log_fcb_append_bufs(log, &fb, 1, &loc);
+        goto done;
+    }
+#endif
+
     rc = log_fcb_start_append(log, len, &loc);
     if (rc) {
         goto err;
@@ -112,6 +358,14 @@ log_fcb_append(struct log *log, void *buf, int len)
     }
 
     rc = fcb_append_finish(fcb, &loc);
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+done:
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (rc == 0) {
+        log_fcb_idx_note(log, &loc, buf);
+    }
+#endif
 
 err:
     return (rc);
@@ -138,31 +392,20 @@ log_fcb_hdr_body_bytes(uint8_t align)
     return align - mod;
 }
 
+/**
+ * Writes a header and body to the space reserved at loc.
+ */
 static int
-log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
-                    const void *body, int body_len)
+log_fcb_write_body(struct fcb *fcb, const struct fcb_entry *loc,
+                   const struct log_entry_hdr *hdr, const void *body,
+                   int body_len)
 {
     uint8_t buf[sizeof (struct log_entry_hdr) + LOG_FCB_MAX_ALIGN - 1];
-    struct fcb *fcb;
-    struct fcb_entry loc;
-    struct fcb_log *fcb_log;
     const uint8_t *u8p;
     int hdr_alignment;
     int chunk_sz;
     int rc;
 
-    fcb_log = (struct fcb_log *)log->l_arg;
-    fcb = &fcb_log->fl_fcb;
-
-    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
-        return SYS_ENOTSUP;
-    }
-
-    rc = log_fcb_start_append(log, sizeof *hdr + body_len, &loc);
-    if (rc != 0) {
-        return rc;
-    }
-
     /* Append the first chunk (header + x-bytes of body, where x is however
      * many bytes are required to increase the chunk size up to a multiple of
      * the flash alignment).
@@ -179,7 +422,7 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
     memcpy(buf, hdr, sizeof *hdr);
     memcpy(buf + sizeof *hdr, u8p, hdr_alignment);
 
-    rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, chunk_sz);
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, buf, chunk_sz);
     if (rc != 0) {
         return rc;
     }
@@ -190,18 +433,149 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
     body_len -= hdr_alignment;
 
     if (body_len > 0) {
-        rc = flash_area_write(loc.fe_area, loc.fe_data_off + chunk_sz, u8p,
+        rc = flash_area_write(loc->fe_area, loc->fe_data_off + chunk_sz, u8p,
                               body_len);
         if (rc != 0) {
             return rc;
         }
     }
 
+    return 0;
+}
+
+static int
+log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                    const void *body, int body_len)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    if (fcb->f_wbuf) {
+        struct fcb_buf fbs[2] = {
+            { .fb_data = hdr, .fb_len = sizeof *hdr },
+            { .fb_data = body, .fb_len = body_len },
+        };
+
+        rc = log_fcb_append_bufs(log, fbs, 2, &loc);
+        if (rc != 0) {
+            return rc;
+        }
+        goto done;
+    }
+#endif
+
+    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
+        return SYS_ENOTSUP;
+    }
+
+    rc = log_fcb_start_append(log, sizeof *hdr + body_len, &loc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = log_fcb_write_body(fcb, &loc, hdr, body, body_len);
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = fcb_append_finish(fcb, &loc);
     if (rc != 0) {
         return rc;
     }
 
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+done:
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_idx_note(log, &loc, hdr);
+#endif
+
+    return 0;
+}
+
+static int
+log_fcb_append_batch(struct log *log, const struct log_entry_hdr *hdr,
+                     const struct log_batch_ent *ents, int cnt)
+{
+    struct fcb_entry locs[LOG_FCB_BATCH_MAX];
+    uint16_t lens[LOG_FCB_BATCH_MAX];
+    struct log_entry_hdr ueh;
+    struct fcb_log *fcb_log;
+    struct fcb *fcb;
+    int num;
+    int rc;
+    int i;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    ueh = *hdr;
+
+#if MYNEWT_VAL(FCB_WRITE_BUF)
+    /* The write buffer already combines the entries. */
+    if (fcb->f_wbuf) {
+        struct fcb_buf fbs[2];
+
+        for (i = 0; i < cnt; i++) {
+            fbs[0].fb_data = &ueh;
+            fbs[0].fb_len = sizeof ueh;
+            fbs[1].fb_data = ents[i].lbe_body;
+            fbs[1].fb_len = ents[i].lbe_len;
+            rc = log_fcb_append_bufs(log, fbs, 2, &locs[0]);
+            if (rc != 0) {
+                return rc;
+            }
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+            log_fcb_idx_note(log, &locs[0], &ueh);
+#endif
+            ueh.ue_index++;
+        }
+        return 0;
+    }
+#endif
+
+    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
+        return SYS_ENOTSUP;
+    }
+
+    while (cnt > 0) {
+        num = min(cnt, LOG_FCB_BATCH_MAX);
+        for (i = 0; i < num; i++) {
+            lens[i] = sizeof ueh + ents[i].lbe_len;
+        }
+
+        /* Reserves as many as fit in the active sector. */
+        num = log_fcb_start_append_multi(log, lens, num, locs);
+        if (num < 0) {
+            return num;
+        }
+
+        for (i = 0; i < num; i++) {
+            rc = log_fcb_write_body(fcb, &locs[i], &ueh, ents[i].lbe_body,
+                                    ents[i].lbe_len);
+            if (rc == 0) {
+                rc = fcb_append_finish(fcb, &locs[i]);
+            }
+            if (rc != 0) {
+                return rc;
+            }
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+            log_fcb_idx_note(log, &locs[i], &ueh);
+#endif
+            ueh.ue_index++;
+        }
+
+        ents += num;
+        cnt -= num;
+    }
+
     return 0;
 }
 
@@ -230,6 +604,9 @@ log_fcb_append_mbuf(struct log *log, const struct os_mbuf *om)
     struct fcb *fcb;
     struct fcb_entry loc;
     struct fcb_log *fcb_log;
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    struct log_entry_hdr hdr;
+#endif
     int len;
     int rc;
 
@@ -260,6 +637,12 @@ log_fcb_append_mbuf(struct log *log, const struct os_mbuf *om)
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (os_mbuf_copydata(om, 0, sizeof(hdr), &hdr) == 0) {
+        log_fcb_idx_note(log, &loc, &hdr);
+    }
+#endif
+
     return 0;
 }
 
@@ -305,6 +688,10 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_idx_note(log, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -376,9 +763,14 @@ log_fcb_walk(struct log *log, log_walk_func_t walk_func,
     struct fcb_entry *locp;
     int rc;
 
-    rc = 0;
     fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
 
+    /* Readers see everything appended so far. */
+    rc = fcb_flush(fcb);
+    if (rc) {
+        return rc;
+    }
+
     memset(&loc, 0, sizeof(loc));
 
     /*
@@ -388,6 +780,9 @@ log_fcb_walk(struct log *log, log_walk_func_t walk_func,
         locp = &fcb->f_active;
         rc = walk_func(log, log_offset, (void *)locp, locp->fe_data_len);
     } else {
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+        log_fcb_idx_seek(log->l_arg, log_offset, &loc);
+#endif
         while (fcb_getnext(fcb, &loc) == 0) {
             rc = walk_func(log, log_offset, (void *) &loc, loc.fe_data_len);
             if (rc) {
@@ -401,6 +796,13 @@ log_fcb_walk(struct log *log, log_walk_func_t walk_func,
 static int
 log_fcb_flush(struct log *log)
 {
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    struct fcb_log *fl;
+
+    fl = (struct fcb_log *)log->l_arg;
+    memset(fl->fl_sectors, 0, sizeof(fl->fl_sectors));
+#endif
+
     return fcb_clear(&((struct fcb_log *)log->l_arg)->fl_fcb);
 }
 
@@ -422,6 +824,9 @@ log_fcb_registered(struct log *log)
     } else {
         fl->fl_watermark_off = fcb->f_oldest->fa_off;
     }
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_idx_rebuild(log->l_arg);
 #endif
     return 0;
 }
@@ -650,6 +1055,10 @@ log_fcb_rtr_erase(struct log *log, void *arg)
         goto err;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_idx_suspended = 1;
+#endif
+
     /* Copy to scratch */
     rc = log_fcb_copy(log, fcb, &fcb_scratch, entry.fe_elem_off);
     if (rc) {
@@ -666,6 +1075,12 @@ log_fcb_rtr_erase(struct log *log, void *arg)
     rc = log_fcb_copy(log, &fcb_scratch, fcb, 0);
 
 err:
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (log_fcb_idx_suspended) {
+        log_fcb_idx_suspended = 0;
+        log_fcb_idx_rebuild(fcb_log);
+    }
+#endif
     return (rc);
 }
 
@@ -677,6 +1092,7 @@ const struct log_handler log_fcb_handler = {
     .log_append_body = log_fcb_append_body,
     .log_append_mbuf = log_fcb_append_mbuf,
     .log_append_mbuf_body = log_fcb_append_mbuf_body,
+    .log_append_batch = log_fcb_append_batch,
     .log_walk = log_fcb_walk,
     .log_flush = log_fcb_flush,
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
@@ -0,0 +1,715 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_LZ)
+
+#include <string.h>
+
+#include "log/log.h"
+#include "log/log_fcb_lz.h"
+
+/*
+ * Each FCB element holds one block of entries:
+ *
+ *     [header of first entry][info (2)][payload]
+ *
+ * The copy of the first entry's header lets log_fcb index and watermark
+ * blocks as if they were plain entries.  The info word holds the raw block
+ * length, and whether the payload is stored uncompressed.  The raw block is
+ * a sequence of [length (2)][entry] records.
+ *
+ * The payload uses an LZ77 byte format in the style of LZ4: each sequence
+ * is a token (literal count << 4 | match length - 4), optional extra
+ * literal count bytes, the literals, then (unless it is the last sequence)
+ * a 2-byte match offset and optional extra match length bytes.
+ */
+
+#define LOG_FCB_LZ_BLOCK_SIZE   MYNEWT_VAL(LOG_FCB_LZ_BLOCK_SIZE)
+
+#define LOG_FCB_LZ_INFO_STORED  0x8000
+#define LOG_FCB_LZ_INFO_LEN     0x7fff
+
+#define LOG_FCB_LZ_BLOCK_HDR_SZ (LOG_ENTRY_HDR_SIZE + 2)
+#define LOG_FCB_LZ_ELEM_MAX     (LOG_FCB_LZ_BLOCK_HDR_SZ + \
+                                 LOG_FCB_LZ_BLOCK_SIZE)
+
+#define LOG_FCB_LZ_MIN_MATCH    4
+#define LOG_FCB_LZ_HASH_BITS    8
+#define LOG_FCB_LZ_HASH_EMPTY   0xffff
+
+/* Entry within a decompressed block; passed to walk callbacks as dptr. */
+struct log_fcb_lz_ent {
+    const uint8_t *data;
+    uint16_t len;
+};
+
+struct log_fcb_lz_walk_arg {
+    struct log *log;
+    log_walk_func_t walk_func;
+    struct log_offset *log_offset;
+    /* Only report the last entry (lo_ts < 0). */
+    bool last_only;
+    uint16_t raw_len;
+};
+
+/*
+ * Work buffers, shared by all logs.  The mutex also protects each log's
+ * pending block.  Walk callbacks may append to the log (the mutex is
+ * recursive), hence the separate buffers for compression and walking.
+ */
+static struct os_mutex log_fcb_lz_mtx;
+static uint16_t log_fcb_lz_htab[1 << LOG_FCB_LZ_HASH_BITS];
+static uint8_t log_fcb_lz_out[LOG_FCB_LZ_ELEM_MAX];
+static uint8_t log_fcb_lz_in[LOG_FCB_LZ_ELEM_MAX];
+static uint8_t log_fcb_lz_raw[LOG_FCB_LZ_BLOCK_SIZE];
+
+static uint16_t
+log_fcb_lz_get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static void
+log_fcb_lz_put16(uint8_t *p, uint16_t val)
+{
+    p[0] = val;
+    p[1] = val >> 8;
+}
+
+static int
+log_fcb_lz_hash(const uint8_t *p)
+{
+    uint32_t val;
+
+    val = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    val *= 2654435761U;
+    return val >> (32 - LOG_FCB_LZ_HASH_BITS);
+}
+
+static uint8_t *
+log_fcb_lz_put_ext(uint8_t *op, const uint8_t *oend, int val)
+{
+    while (val >= 255) {
+        if (op >= oend) {
+            return NULL;
+        }
+        *op++ = 255;
+        val -= 255;
+    }
+    if (op >= oend) {
+        return NULL;
+    }
+    *op++ = val;
+
+    return op;
+}
+
+/**
+ * Emits one sequence.  A match length of 0 marks the last sequence, which
+ * has no match part.
+ */
+static uint8_t *
+log_fcb_lz_put_seq(uint8_t *op, const uint8_t *oend, const uint8_t *lit,
+                   int lit_len, int off, int match_len)
+{
+    uint8_t *token;
+
+    if (op >= oend) {
+        return NULL;
+    }
+    token = op++;
+    *token = min(lit_len, 15) << 4;
+    if (lit_len >= 15) {
+        op = log_fcb_lz_put_ext(op, oend, lit_len - 15);
+        if (op == NULL) {
+            return NULL;
+        }
+    }
+    if (oend - op < lit_len) {
+        return NULL;
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len == 0) {
+        return op;
+    }
+
+    if (oend - op < 2) {
+        return NULL;
+    }
+    log_fcb_lz_put16(op, off);
+    op += 2;
+
+    match_len -= LOG_FCB_LZ_MIN_MATCH;
+    *token |= min(match_len, 15);
+    if (match_len >= 15) {
+        op = log_fcb_lz_put_ext(op, oend, match_len - 15);
+    }
+
+    return op;
+}
+
+/**
+ * @return                      The compressed length on success;
+ *                              -1 if it would exceed dst_len.
+ */
+static int
+log_fcb_lz_compress(const uint8_t *src, int src_len, uint8_t *dst,
+                    int dst_len)
+{
+    const uint8_t *oend;
+    uint8_t *op;
+    int match_len;
+    int anchor;
+    int ref;
+    int ip;
+    int h;
+
+    memset(log_fcb_lz_htab, 0xff, sizeof(log_fcb_lz_htab));
+
+    op = dst;
+    oend = dst + dst_len;
+    anchor = 0;
+    ip = 0;
+    while (ip + LOG_FCB_LZ_MIN_MATCH <= src_len) {
+        h = log_fcb_lz_hash(src + ip);
+        ref = log_fcb_lz_htab[h];
+        log_fcb_lz_htab[h] = ip;
+
+        if (ref == LOG_FCB_LZ_HASH_EMPTY ||
+            memcmp(src + ref, src + ip, LOG_FCB_LZ_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+
+        match_len = LOG_FCB_LZ_MIN_MATCH;
+        while (ip + match_len < src_len &&
+               src[ref + match_len] == src[ip + match_len]) {
+            match_len++;
+        }
+
+        op = log_fcb_lz_put_seq(op, oend, src + anchor, ip - anchor,
+                                ip - ref, match_len);
+        if (op == NULL) {
+            return -1;
+        }
+        ip += match_len;
+        anchor = ip;
+    }
+
+    op = log_fcb_lz_put_seq(op, oend, src + anchor, src_len - anchor, 0, 0);
+    if (op == NULL) {
+        return -1;
+    }
+
+    return op - dst;
+}
+
+static int
+log_fcb_lz_get_ext(const uint8_t *src, int src_len, int *ip, int *val)
+{
+    uint8_t b;
+
+    do {
+        if (*ip >= src_len) {
+            return -1;
+        }
+        b = src[(*ip)++];
+        *val += b;
+    } while (b == 255);
+
+    return 0;
+}
+
+/**
+ * @return                      The decompressed length on success;
+ *                              -1 if the input is malformed.
+ */
+static int
+log_fcb_lz_decompress(const uint8_t *src, int src_len, uint8_t *dst,
+                      int dst_len)
+{
+    uint8_t token;
+    int match_len;
+    int lit_len;
+    int off;
+    int ip;
+    int op;
+
+    ip = 0;
+    op = 0;
+    while (ip < src_len) {
+        token = src[ip++];
+
+        lit_len = token >> 4;
+        if (lit_len == 15 &&
+            log_fcb_lz_get_ext(src, src_len, &ip, &lit_len) != 0) {
+            return -1;
+        }
+        if (lit_len > src_len - ip || lit_len > dst_len - op) {
+            return -1;
+        }
+        memcpy(dst + op, src + ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == src_len) {
+            /* Last sequence. */
+            break;
+        }
+
+        if (src_len - ip < 2) {
+            return -1;
+        }
+        off = log_fcb_lz_get16(src + ip);
+        ip += 2;
+
+        match_len = token & 0x0f;
+        if (match_len == 15 &&
+            log_fcb_lz_get_ext(src, src_len, &ip, &match_len) != 0) {
+            return -1;
+        }
+        match_len += LOG_FCB_LZ_MIN_MATCH;
+
+        if (off == 0 || off > op || match_len > dst_len - op) {
+            return -1;
+        }
+        /* Byte by byte; the match may overlap the output. */
+        while (match_len-- > 0) {
+            dst[op] = dst[op - off];
+            op++;
+        }
+    }
+
+    return op;
+}
+
+/**
+ * Writes the pending block out to the FCB.  The block is dropped even if
+ * the write fails, so that one bad write doesn't stall the log.
+ */
+static int
+log_fcb_lz_flush_block(struct log_fcb_lz *lz)
+{
+    uint16_t info;
+    int len;
+    int rc;
+
+    if (lz->len == 0) {
+        return 0;
+    }
+
+    memcpy(log_fcb_lz_out, lz->buf + 2, LOG_ENTRY_HDR_SIZE);
+
+    len = log_fcb_lz_compress(lz->buf, lz->len,
+                              log_fcb_lz_out + LOG_FCB_LZ_BLOCK_HDR_SZ,
+                              lz->len - 1);
+    if (len < 0) {
+        memcpy(log_fcb_lz_out + LOG_FCB_LZ_BLOCK_HDR_SZ, lz->buf, lz->len);
+        len = lz->len;
+        info = lz->len | LOG_FCB_LZ_INFO_STORED;
+    } else {
+        info = lz->len;
+    }
+    log_fcb_lz_put16(log_fcb_lz_out + LOG_ENTRY_HDR_SIZE, info);
+
+    rc = lz->l_fcb.l_log->log_append(&lz->l_fcb, log_fcb_lz_out,
+                                     LOG_FCB_LZ_BLOCK_HDR_SZ + len);
+    lz->len = 0;
+
+    return rc;
+}
+
+/**
+ * Adds an entry to the pending block.  The entry is hdr (if not NULL)
+ * followed by body_len bytes from either body or om.
+ */
+static int
+log_fcb_lz_add(struct log *log, const struct log_entry_hdr *hdr,
+               const void *body, const struct os_mbuf *om, int body_len)
+{
+    struct log_fcb_lz *lz;
+    uint8_t *p;
+    int len;
+    int rc;
+
+    lz = log->l_arg;
+
+    len = body_len;
+    if (hdr != NULL) {
+        len += LOG_ENTRY_HDR_SIZE;
+    }
+    if (len < LOG_ENTRY_HDR_SIZE || 2 + len > LOG_FCB_LZ_BLOCK_SIZE) {
+        return SYS_EINVAL;
+    }
+
+    os_mutex_pend(&log_fcb_lz_mtx, OS_TIMEOUT_NEVER);
+
+    rc = 0;
+    if (lz->len + 2 + len > LOG_FCB_LZ_BLOCK_SIZE) {
+        rc = log_fcb_lz_flush_block(lz);
+        if (rc != 0) {
+            goto done;
+        }
+    }
+
+    p = lz->buf + lz->len;
+    log_fcb_lz_put16(p, len);
+    p += 2;
+    if (hdr != NULL) {
+        memcpy(p, hdr, LOG_ENTRY_HDR_SIZE);
+        p += LOG_ENTRY_HDR_SIZE;
+    }
+    if (om != NULL) {
+        if (os_mbuf_copydata(om, 0, body_len, p) != 0) {
+            rc = SYS_EINVAL;
+            goto done;
+        }
+    } else {
+        memcpy(p, body, body_len);
+    }
+    lz->len += 2 + len;
+
+    /* Write the block out as soon as no further entry can fit. */
+    if (lz->len + 2 + LOG_ENTRY_HDR_SIZE > LOG_FCB_LZ_BLOCK_SIZE) {
+        rc = log_fcb_lz_flush_block(lz);
+    }
+
+done:
+    os_mutex_release(&log_fcb_lz_mtx);
+    return rc;
+}
+
+static int
+log_fcb_lz_append(struct log *log, void *buf, int len)
+{
+    return log_fcb_lz_add(log, NULL, buf, NULL, len);
+}
+
+static int
+log_fcb_lz_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                       const void *body, int body_len)
+{
+    return log_fcb_lz_add(log, hdr, body, NULL, body_len);
+}
+
+static int
+log_fcb_lz_append_mbuf(struct log *log, const struct os_mbuf *om)
+{
+    return log_fcb_lz_add(log, NULL, NULL, om, os_mbuf_len(om));
+}
+
+static int
+log_fcb_lz_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
+                            const struct os_mbuf *om)
+{
+    return log_fcb_lz_add(log, hdr, NULL, om, os_mbuf_len(om));
+}
+
+static int
+log_fcb_lz_read(struct log *log, void *dptr, void *buf, uint16_t offset,
+                uint16_t len)
+{
+    struct log_fcb_lz_ent *ent;
+
+    ent = dptr;
+    if (offset >= ent->len) {
+        return 0;
+    }
+    if (len > ent->len - offset) {
+        len = ent->len - offset;
+    }
+    memcpy(buf, ent->data + offset, len);
+
+    return len;
+}
+
+static int
+log_fcb_lz_read_mbuf(struct log *log, void *dptr, struct os_mbuf *om,
+                     uint16_t offset, uint16_t len)
+{
+    struct log_fcb_lz_ent *ent;
+
+    ent = dptr;
+    if (offset >= ent->len) {
+        return 0;
+    }
+    if (len > ent->len - offset) {
+        len = ent->len - offset;
+    }
+    if (os_mbuf_append(om, ent->data + offset, len) != 0) {
+        return 0;
+    }
+
+    return len;
+}
+
+/**
+ * Reports the entries of a raw block, or only the last one.
+ */
+static int
+log_fcb_lz_walk_raw(struct log_fcb_lz_walk_arg *wa, const uint8_t *raw,
+                    int raw_len)
+{
+    struct log_fcb_lz_ent ent;
+    int off;
+    int rc;
+
+    ent.len = 0;
+    off = 0;
+    while (off + 2 <= raw_len) {
+        ent.len = log_fcb_lz_get16(raw + off);
+        ent.data = raw + off + 2;
+        off += 2;
+        if (ent.len > raw_len - off) {
+            break;
+        }
+        off += ent.len;
+        if (wa->last_only && off + 2 <= raw_len) {
+            continue;
+        }
+
+        rc = wa->walk_func(wa->log, wa->log_offset, &ent, ent.len);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * log_fcb walk callback; decodes one block.
+ */
+static int
+log_fcb_lz_walk_block(struct log *fcb_log, struct log_offset *log_offset,
+                      void *dptr, uint16_t len)
+{
+    struct log_fcb_lz_walk_arg *wa;
+    uint16_t raw_len;
+    uint16_t info;
+    const uint8_t *payload;
+    int rc;
+
+    wa = log_offset->lo_arg;
+
+    /* Skip anything that isn't a well-formed block. */
+    if (len < LOG_FCB_LZ_BLOCK_HDR_SZ || len > LOG_FCB_LZ_ELEM_MAX) {
+        return 0;
+    }
+    rc = fcb_log->l_log->log_read(fcb_log, dptr, log_fcb_lz_in, 0, len);
+    if (rc != len) {
+        return 0;
+    }
+
+    info = log_fcb_lz_get16(log_fcb_lz_in + LOG_ENTRY_HDR_SIZE);
+    raw_len = info & LOG_FCB_LZ_INFO_LEN;
+    payload = log_fcb_lz_in + LOG_FCB_LZ_BLOCK_HDR_SZ;
+    len -= LOG_FCB_LZ_BLOCK_HDR_SZ;
+    if (raw_len > LOG_FCB_LZ_BLOCK_SIZE) {
+        return 0;
+    }
+
+    /* The raw buffer is about to be overwritten. */
+    wa->raw_len = 0;
+
+    if (info & LOG_FCB_LZ_INFO_STORED) {
+        if (len != raw_len) {
+            return 0;
+        }
+        memcpy(log_fcb_lz_raw, payload, len);
+    } else {
+        rc = log_fcb_lz_decompress(payload, len, log_fcb_lz_raw,
+                                   LOG_FCB_LZ_BLOCK_SIZE);
+        if (rc != raw_len) {
+            return 0;
+        }
+    }
+
+    if (wa->last_only) {
+        /* Only the newest block matters; report it once the walk is done. */
+        wa->raw_len = raw_len;
+        return 0;
+    }
+
+    return log_fcb_lz_walk_raw(wa, log_fcb_lz_raw, raw_len);
+}
+
+static int
+log_fcb_lz_walk(struct log *log, log_walk_func_t walk_func,
+                struct log_offset *log_offset)
+{
+    struct log_fcb_lz_walk_arg wa;
+    struct log_offset fcb_offset;
+    struct log_fcb_lz *lz;
+    int len;
+    int rc;
+
+    lz = log->l_arg;
+
+    wa.log = log;
+    wa.walk_func = walk_func;
+    wa.log_offset = log_offset;
+    wa.last_only = log_offset->lo_ts < 0;
+    wa.raw_len = 0;
+
+    /* Blocks are indexed by their first entry, so log_fcb can still seek. */
+    fcb_offset = *log_offset;
+    if (fcb_offset.lo_ts < 0) {
+        fcb_offset.lo_ts = 0;
+    }
+    fcb_offset.lo_arg = &wa;
+
+    os_mutex_pend(&log_fcb_lz_mtx, OS_TIMEOUT_NEVER);
+
+    /* The pending block is newest; copy it in case a callback appends. */
+    if (wa.last_only && lz->len > 0) {
+        len = lz->len;
+        memcpy(log_fcb_lz_raw, lz->buf, len);
+        rc = log_fcb_lz_walk_raw(&wa, log_fcb_lz_raw, len);
+        goto done;
+    }
+
+    rc = lz->l_fcb.l_log->log_walk(&lz->l_fcb, log_fcb_lz_walk_block,
+                                   &fcb_offset);
+    if (rc != 0) {
+        goto done;
+    }
+
+    if (wa.last_only) {
+        rc = log_fcb_lz_walk_raw(&wa, log_fcb_lz_raw, wa.raw_len);
+    } else if (lz->len > 0) {
+        len = lz->len;
+        memcpy(log_fcb_lz_raw, lz->buf, len);
+        rc = log_fcb_lz_walk_raw(&wa, log_fcb_lz_raw, len);
+    }
+
+done:
+    os_mutex_release(&log_fcb_lz_mtx);
+    return rc;
+}
+
+static int
+log_fcb_lz_flush(struct log *log)
+{
+    struct log_fcb_lz *lz;
+    int rc;
+
+    lz = log->l_arg;
+
+    os_mutex_pend(&log_fcb_lz_mtx, OS_TIMEOUT_NEVER);
+    lz->len = 0;
+    rc = lz->l_fcb.l_log->log_flush(&lz->l_fcb);
+    os_mutex_release(&log_fcb_lz_mtx);
+
+    return rc;
+}
+
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+static int
+log_fcb_lz_storage_info(struct log *log, struct log_storage_info *info)
+{
+    struct log_fcb_lz *lz;
+
+    lz = log->l_arg;
+    return lz->l_fcb.l_log->log_storage_info(&lz->l_fcb, info);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+static int
+log_fcb_lz_set_watermark(struct log *log, uint32_t index)
+{
+    struct log_fcb_lz *lz;
+
+    lz = log->l_arg;
+    return lz->l_fcb.l_log->log_set_watermark(&lz->l_fcb, index);
+}
+#endif
+
+static int
+log_fcb_lz_registered(struct log *log)
+{
+    struct log_fcb_lz *lz;
+
+    lz = log->l_arg;
+
+    /* l_log and l_arg are set in log_fcb_lz_init() */
+    lz->l_fcb.l_name = log->l_name;
+    lz->l_fcb.l_level = log->l_level;
+
+    return lz->l_fcb.l_log->log_registered(&lz->l_fcb);
+}
+
+const struct log_handler log_fcb_lz_handler = {
+    .log_type = LOG_TYPE_STORAGE,
+    .log_read = log_fcb_lz_read,
+    .log_read_mbuf = log_fcb_lz_read_mbuf,
+    .log_append = log_fcb_lz_append,
+    .log_append_body = log_fcb_lz_append_body,
+    .log_append_mbuf = log_fcb_lz_append_mbuf,
+    .log_append_mbuf_body = log_fcb_lz_append_mbuf_body,
+    .log_walk = log_fcb_lz_walk,
+    .log_flush = log_fcb_lz_flush,
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+    .log_storage_info = log_fcb_lz_storage_info,
+#endif
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    .log_set_watermark = log_fcb_lz_set_watermark,
+#endif
+    .log_registered = log_fcb_lz_registered,
+};
+
+int
+log_fcb_lz_init(struct log_fcb_lz *lz, struct fcb_log *fcb_arg)
+{
+    if (!fcb_arg || fcb_arg->fl_entries) {
+        return -1;
+    }
+
+    memset(lz, 0, sizeof(*lz));
+
+    lz->l_fcb.l_log = &log_fcb_handler;
+    lz->l_fcb.l_arg = fcb_arg;
+
+    return 0;
+}
+
+int
+log_fcb_lz_sync(struct log *log)
+{
+    int rc;
+
+    os_mutex_pend(&log_fcb_lz_mtx, OS_TIMEOUT_NEVER);
+    rc = log_fcb_lz_flush_block(log->l_arg);
+    os_mutex_release(&log_fcb_lz_mtx);
+
+    return rc;
+}
+
+void
+log_fcb_lz_pkg_init(void)
+{
+    os_mutex_init(&log_fcb_lz_mtx);
+}
+
+#endif
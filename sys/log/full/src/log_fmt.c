@@ -0,0 +1,392 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "log/log.h"
+
+/*
+ * Deferred log_printf() entries (LOG_ETYPE_FMT).
+ *
+ * The entry body is the address of the format string followed by the raw
+ * arguments, each stored in its promoted size and padded to a multiple of
+ * 4 bytes, in the target's byte order:
+ *
+ *     [fmt address][arg 0][arg 1]...
+ *
+ * '*' widths and precisions are stored as int arguments in the order they
+ * are consumed.  Formats using %s or %n can't be deferred since the
+ * argument is a pointer to data which may not exist at read time; such
+ * calls are formatted immediately, as without LOG_PRINTF_DEFER.
+ */
+
+#if MYNEWT_VAL(LOG_VERSION) < 3
+#error "LOG_PRINTF_DEFER requires LOG_VERSION 3"
+#endif
+
+#define LOG_FMT_ARGS_MAX        (MYNEWT_VAL(LOG_PRINTF_DEFER_MAX_ARGS) * 4)
+
+/* Longest conversion specification that is reformatted. */
+#define LOG_FMT_SPEC_MAX        16
+
+enum log_fmt_arg {
+    LOG_FMT_ARG_NONE,
+    LOG_FMT_ARG_INT,
+    LOG_FMT_ARG_LONG,
+    LOG_FMT_ARG_LLONG,
+    LOG_FMT_ARG_SIZE,
+    LOG_FMT_ARG_PTR,
+    LOG_FMT_ARG_DOUBLE,
+    LOG_FMT_ARG_BAD,
+};
+
+struct log_fmt_spec {
+    const char *lfs_start;
+    const char *lfs_end;
+    uint8_t lfs_star_width;
+    uint8_t lfs_star_prec;
+    uint8_t lfs_arg;
+};
+
+static const uint8_t log_fmt_arg_sz[] = {
+    [LOG_FMT_ARG_INT] = sizeof(int),
+    [LOG_FMT_ARG_LONG] = sizeof(long),
+    [LOG_FMT_ARG_LLONG] = sizeof(long long),
+    [LOG_FMT_ARG_SIZE] = sizeof(size_t),
+    [LOG_FMT_ARG_PTR] = sizeof(void *),
+    [LOG_FMT_ARG_DOUBLE] = sizeof(double),
+};
+
+#define LOG_FMT_ARG_SZ(arg)     OS_ALIGN(log_fmt_arg_sz[arg], 4)
+
+/**
+ * Parses the conversion specification starting at *p, which points at a
+ * '%'.
+ */
+static void
+log_fmt_parse(const char *p, struct log_fmt_spec *spec)
+{
+    int len;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->lfs_start = p++;
+
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        p++;
+    }
+    if (*p == '*') {
+        spec->lfs_star_width = 1;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->lfs_star_prec = 1;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    len = 0;
+    while (*p != '\0' && strchr("hlzjt", *p) != NULL) {
+        if (*p == 'l') {
+            len++;
+        } else if (*p != 'h') {
+            len = -1;
+        }
+        p++;
+    }
+
+    switch (*p) {
+    case '%':
+        spec->lfs_arg = LOG_FMT_ARG_NONE;
+        break;
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        if (len < 0) {
+            spec->lfs_arg = LOG_FMT_ARG_SIZE;
+        } else if (len == 0) {
+            spec->lfs_arg = LOG_FMT_ARG_INT;
+        } else if (len == 1) {
+            spec->lfs_arg = LOG_FMT_ARG_LONG;
+        } else {
+            spec->lfs_arg = LOG_FMT_ARG_LLONG;
+        }
+        break;
+    case 'p':
+        spec->lfs_arg = LOG_FMT_ARG_PTR;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+        spec->lfs_arg = LOG_FMT_ARG_DOUBLE;
+        break;
+    default:
+        /* %s, %n, long double, or garbage. */
+        spec->lfs_arg = LOG_FMT_ARG_BAD;
+        break;
+    }
+
+    if (*p != '\0') {
+        p++;
+    }
+    spec->lfs_end = p;
+}
+
+int
+log_fmt_pack(void *buf, int buf_len, const char *fmt, va_list ap)
+{
+    struct log_fmt_spec spec;
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        void *p;
+        double d;
+    } val;
+    uint8_t *dst;
+    const char *p;
+    int stars;
+    int off;
+    int sz;
+
+    buf_len = min(buf_len, OS_ALIGN(sizeof(fmt), 4) + LOG_FMT_ARGS_MAX);
+    if (buf_len < sizeof(fmt)) {
+        return -1;
+    }
+    dst = buf;
+    memcpy(dst, &fmt, sizeof(fmt));
+    off = OS_ALIGN(sizeof(fmt), 4);
+
+    for (p = strchr(fmt, '%'); p != NULL; p = strchr(p, '%')) {
+        log_fmt_parse(p, &spec);
+        p = spec.lfs_end;
+
+        if (spec.lfs_arg == LOG_FMT_ARG_BAD) {
+            return -1;
+        }
+
+        for (stars = spec.lfs_star_width + spec.lfs_star_prec; stars > 0;
+             stars--) {
+            if (off + LOG_FMT_ARG_SZ(LOG_FMT_ARG_INT) > buf_len) {
+                return -1;
+            }
+            val.i = va_arg(ap, int);
+            memcpy(dst + off, &val.i, sizeof(val.i));
+            off += LOG_FMT_ARG_SZ(LOG_FMT_ARG_INT);
+        }
+
+        if (spec.lfs_arg == LOG_FMT_ARG_NONE) {
+            continue;
+        }
+
+        sz = LOG_FMT_ARG_SZ(spec.lfs_arg);
+        if (off + sz > buf_len) {
+            return -1;
+        }
+        memset(&val, 0, sizeof(val));
+        switch (spec.lfs_arg) {
+        case LOG_FMT_ARG_INT:
+            val.i = va_arg(ap, int);
+            break;
+        case LOG_FMT_ARG_LONG:
+            val.l = va_arg(ap, long);
+            break;
+        case LOG_FMT_ARG_LLONG:
+            val.ll = va_arg(ap, long long);
+            break;
+        case LOG_FMT_ARG_SIZE:
+            val.z = va_arg(ap, size_t);
+            break;
+        case LOG_FMT_ARG_PTR:
+            val.p = va_arg(ap, void *);
+            break;
+        case LOG_FMT_ARG_DOUBLE:
+            val.d = va_arg(ap, double);
+            break;
+        }
+        memcpy(dst + off, &val, log_fmt_arg_sz[spec.lfs_arg]);
+        off += sz;
+    }
+
+    return off;
+}
+
+/**
+ * Reads the next int argument; returns 0 if the body is exhausted.
+ */
+static int
+log_fmt_arg_int(const uint8_t *body, int len, int *off)
+{
+    int val;
+
+    val = 0;
+    if (*off + LOG_FMT_ARG_SZ(LOG_FMT_ARG_INT) <= len) {
+        memcpy(&val, body + *off, sizeof(val));
+    }
+    *off += LOG_FMT_ARG_SZ(LOG_FMT_ARG_INT);
+
+    return val;
+}
+
+int
+log_fmt_format(const void *body, int len, char *buf, int buf_len)
+{
+    struct log_fmt_spec spec;
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        void *p;
+        double d;
+    } val;
+    /* Room for the two '*'s to expand to an int each. */
+    char spec_buf[LOG_FMT_SPEC_MAX + 24];
+    const uint8_t *src;
+    const char *fmt;
+    const char *p;
+    const char *q;
+    char *dst;
+    int width;
+    int prec;
+    int out;
+    int off;
+    int rc;
+    int n;
+
+    if (len < sizeof(fmt) || buf_len <= 0) {
+        return -1;
+    }
+    src = body;
+    memcpy(&fmt, src, sizeof(fmt));
+    if (fmt == NULL) {
+        return -1;
+    }
+    off = OS_ALIGN(sizeof(fmt), 4);
+
+    out = 0;
+    buf[0] = '\0';
+    p = fmt;
+    while (*p != '\0') {
+        q = strchr(p, '%');
+        if (q == NULL) {
+            q = p + strlen(p);
+        }
+
+        /* Literal text up to the next conversion. */
+        n = q - p;
+        if (out < buf_len - 1) {
+            rc = min(n, buf_len - 1 - out);
+            memcpy(buf + out, p, rc);
+            buf[out + rc] = '\0';
+        }
+        out += n;
+        if (*q == '\0') {
+            break;
+        }
+
+        log_fmt_parse(q, &spec);
+        p = spec.lfs_end;
+        if (spec.lfs_arg == LOG_FMT_ARG_BAD ||
+            spec.lfs_end - spec.lfs_start >= LOG_FMT_SPEC_MAX) {
+            return -1;
+        }
+
+        /*
+         * Rebuild the specification with the '*'s replaced by the values
+         * stored for them.
+         */
+        width = 0;
+        prec = 0;
+        if (spec.lfs_star_width) {
+            width = log_fmt_arg_int(src, len, &off);
+        }
+        if (spec.lfs_star_prec) {
+            prec = log_fmt_arg_int(src, len, &off);
+        }
+        n = 0;
+        for (q = spec.lfs_start; q < spec.lfs_end; q++) {
+            if (*q == '*') {
+                n += sprintf(spec_buf + n, "%d",
+                             (q[-1] == '.') ? prec : width);
+            } else {
+                spec_buf[n++] = *q;
+            }
+        }
+        spec_buf[n] = '\0';
+
+        memset(&val, 0, sizeof(val));
+        if (spec.lfs_arg != LOG_FMT_ARG_NONE) {
+            if (off + LOG_FMT_ARG_SZ(spec.lfs_arg) > len) {
+                return -1;
+            }
+            memcpy(&val, src + off, log_fmt_arg_sz[spec.lfs_arg]);
+            off += LOG_FMT_ARG_SZ(spec.lfs_arg);
+        }
+
+        /* Once the buffer is full, keep counting like snprintf(). */
+        dst = buf + min(out, buf_len - 1);
+        n = buf_len - (dst - buf);
+        switch (spec.lfs_arg) {
+        case LOG_FMT_ARG_NONE:
+            rc = snprintf(dst, n, "%%");
+            break;
+        case LOG_FMT_ARG_INT:
+            rc = snprintf(dst, n, spec_buf, val.i);
+            break;
+        case LOG_FMT_ARG_LONG:
+            rc = snprintf(dst, n, spec_buf, val.l);
+            break;
+        case LOG_FMT_ARG_LLONG:
+            rc = snprintf(dst, n, spec_buf, val.ll);
+            break;
+        case LOG_FMT_ARG_SIZE:
+            rc = snprintf(dst, n, spec_buf, val.z);
+            break;
+        case LOG_FMT_ARG_PTR:
+            rc = snprintf(dst, n, spec_buf, val.p);
+            break;
+        case LOG_FMT_ARG_DOUBLE:
+            rc = snprintf(dst, n, spec_buf, val.d);
+            break;
+        default:
+            rc = 0;
+            break;
+        }
+        if (rc < 0) {
+            return -1;
+        }
+        out += rc;
+    }
+
+    return out;
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include "mgmt/mgmt.h"
 #include "cborattr/cborattr.h"
 #include "tinycbor/cbor_cnt_writer.h"
+#include "tinycbor/cbor_mbuf_writer.h"
 #include "log/log.h"
 
 /* Source code is only included if the newtmgr library is enabled.  Otherwise
@@ -63,6 +64,91 @@ struct log_encode_data {
     CborEncoder *enc;
 };
 
+#if MYNEWT_VAL(LOG_VERSION) > 2
+/**
+ * Returns the mbuf the encoder writes to, or NULL if it is not writing to
+ * one or the log can't read into mbufs.
+ */
+static struct os_mbuf *
+log_nmgr_rsp_mbuf(struct log *log, CborEncoder *enc)
+{
+    if (enc->writer->write != cbor_mbuf_writer ||
+        log->l_log->log_read_mbuf == NULL) {
+        return NULL;
+    }
+
+    return ((struct cbor_mbuf_writer *)enc->writer)->m;
+}
+
+/**
+ * Encodes an entry body as a byte string.
+ *
+ * If zero_copy is set, the body is encoded as a definite-length byte string
+ * read straight into om; if om is NULL, only the encoded length is counted.
+ * Otherwise it is copied through a bounce buffer as an indefinite-length
+ * byte string.
+ */
+static CborError
+log_nmgr_encode_body(CborEncoder *enc, struct log *log, void *dptr,
+                     uint16_t len, int zero_copy, struct os_mbuf *om)
+{
+    CborEncoder str_encoder;
+    CborError g_err = CborNoError;
+    uint8_t data[128];
+    int off;
+    int rc;
+
+    if (zero_copy) {
+        if (len < 24) {
+            data[0] = 0x40 | len;
+            off = 1;
+        } else if (len < 256) {
+            data[0] = 0x58;
+            data[1] = len;
+            off = 2;
+        } else {
+            data[0] = 0x59;
+            data[1] = len >> 8;
+            data[2] = len;
+            off = 3;
+        }
+        g_err |= enc->writer->write(enc->writer, (char *)data, off);
+        if (g_err) {
+            return g_err;
+        }
+
+        if (om != NULL) {
+            rc = log_read_mbuf_body(log, dptr, om, 0, len);
+            if (rc != len) {
+                return CborErrorOutOfMemory;
+            }
+        }
+        enc->writer->bytes_written += len;
+        return CborNoError;
+    }
+
+    /*
+     * Write entry data as byte string. Since this may not fit into single
+     * chunk of data we will write as indefinite-length byte string which is
+     * basically a indefinite-length container with definite-length strings
+     * inside.
+     */
+    g_err |= cbor_encoder_create_indef_byte_string(enc, &str_encoder);
+    for (off = 0; off < len && !g_err; ) {
+        rc = log_read_body(log, dptr, data, off, sizeof(data));
+        if (rc < 0) {
+            g_err |= 1;
+            break;
+        }
+        g_err |= cbor_encode_byte_string(&str_encoder, data, rc);
+        off += rc;
+    }
+    g_err |= cbor_encoder_close_container(enc, &str_encoder);
+
+    return g_err;
+}
+#endif
+
 /**
  * Log encode entry
  * @param log structure, log_offset, dataptr, len
@@ -73,7 +159,9 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
                       const struct log_entry_hdr *ueh, void *dptr,
                       uint16_t len)
 {
+#if MYNEWT_VAL(LOG_VERSION) < 3
     uint8_t data[128];
+#endif
     int rc;
     int rsp_len;
     CborError g_err = CborNoError;
@@ -82,8 +170,7 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
     struct CborCntWriter cnt_writer;
     CborEncoder cnt_encoder;
 #if MYNEWT_VAL(LOG_VERSION) > 2
-    CborEncoder str_encoder;
-    int off;
+    struct os_mbuf *om;
 #endif
     rc = OS_OK;
 
@@ -116,6 +203,10 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
     data[rc] = 0;
 #endif
 
+#if MYNEWT_VAL(LOG_VERSION) > 2
+    om = log_nmgr_rsp_mbuf(log, ed->enc);
+#endif
+
     /*calculate whether this would fit */
     /* create a counting encoder for cbor */
     cbor_cnt_writer_init(&cnt_writer);
@@ -134,6 +225,13 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
         g_err |= cbor_encode_text_stringz(&rsp, "type");
         g_err |= cbor_encode_text_stringz(&rsp, "bin");
         break;
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+    case LOG_ETYPE_FMT:
+        /* Raw body; formatted on the host using the image's symbols. */
+        g_err |= cbor_encode_text_stringz(&rsp, "type");
+        g_err |= cbor_encode_text_stringz(&rsp, "fmt");
+        break;
+#endif
     case LOG_ETYPE_STRING:
     default:
         /* no need for type here */
@@ -143,24 +241,7 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
     }
 
     g_err |= cbor_encode_text_stringz(&rsp, "msg");
-
-    /*
-     * Write entry data as byte string. Since this may not fit into single
-     * chunk of data we will write as indefinite-length byte string which is
-     * basically a indefinite-length container with definite-length strings
-     * inside.
-     */
-    g_err |= cbor_encoder_create_indef_byte_string(&rsp, &str_encoder);
-    for (off = 0; off < len && !g_err; ) {
-        rc = log_read_body(log, dptr, data, off, sizeof(data));
-        if (rc < 0) {
-            g_err |= 1;
-            break;
-        }
-        g_err |= cbor_encode_byte_string(&str_encoder, data, rc);
-        off += rc;
-    }
-    g_err |= cbor_encoder_close_container(&rsp, &str_encoder);
+    g_err |= log_nmgr_encode_body(&rsp, log, dptr, len, om != NULL, NULL);
 #else
     g_err |= cbor_encode_text_stringz(&rsp, "msg");
     g_err |= cbor_encode_text_stringz(&rsp, (char *)data);
@@ -180,7 +261,7 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
      * exceeds this magic value. This is to make sure we can read long log
      * entries, even if they have to be read one by one.
      */
-    if ((rsp_len > 400) && (ed->counter > 0)) {
+    if ((rsp_len > MYNEWT_VAL(LOG_NMGR_MAX_RSP_LEN)) && (ed->counter > 0)) {
         rc = OS_ENOMEM;
         goto err;
     }
@@ -197,6 +278,13 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
         g_err |= cbor_encode_text_stringz(&rsp, "type");
         g_err |= cbor_encode_text_stringz(&rsp, "bin");
         break;
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+    case LOG_ETYPE_FMT:
+        /* Raw body; formatted on the host using the image's symbols. */
+        g_err |= cbor_encode_text_stringz(&rsp, "type");
+        g_err |= cbor_encode_text_stringz(&rsp, "fmt");
+        break;
+#endif
     case LOG_ETYPE_STRING:
     default:
         /* no need for type here */
@@ -206,24 +294,7 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
     }
 
     g_err |= cbor_encode_text_stringz(&rsp, "msg");
-
-    /*
-     * Write entry data as byte string. Since this may not fit into single
-     * chunk of data we will write as indefinite-length byte string which is
-     * basically a indefinite-length container with definite-length strings
-     * inside.
-     */
-    g_err |= cbor_encoder_create_indef_byte_string(&rsp, &str_encoder);
-    for (off = 0; off < len && !g_err; ) {
-        rc = log_read_body(log, dptr, data, off, sizeof(data));
-        if (rc < 0) {
-            g_err |= 1;
-            break;
-        }
-        g_err |= cbor_encode_byte_string(&str_encoder, data, rc);
-        off += rc;
-    }
-    g_err |= cbor_encoder_close_container(&rsp, &str_encoder);
+    g_err |= log_nmgr_encode_body(&rsp, log, dptr, len, om != NULL, om);
 #else
     g_err |= cbor_encode_text_stringz(&rsp, "msg");
     g_err |= cbor_encode_text_stringz(&rsp, (char *)data);
@@ -278,7 +349,7 @@ log_encode_entries(struct log *log, CborEncoder *cb,
     g_err |= cbor_encoder_close_container(&cnt_encoder, &entries);
     rsp_len = cbor_encode_bytes_written(cb) +
               cbor_encode_bytes_written(&cnt_encoder);
-    if (rsp_len > 400) {
+    if (rsp_len > MYNEWT_VAL(LOG_NMGR_MAX_RSP_LEN)) {
         rc = OS_ENOMEM;
         goto err;
     }
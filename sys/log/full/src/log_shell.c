@@ -43,6 +43,22 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
     char data[128];
     int dlen;
     int rc;
+#if MYNEWT_VAL(LOG_PRINTF_DEFER)
+    char body[LOG_PRINTF_MAX_ENTRY_LEN];
+
+    if (ueh->ue_etype == LOG_ETYPE_FMT) {
+        dlen = min(len, sizeof(body));
+        rc = log_read_body(log, dptr, body, 0, dlen);
+        if (rc < 0) {
+            return rc;
+        }
+        if (log_fmt_format(body, rc, data, sizeof(data)) < 0) {
+            strcpy(data, "<bad fmt entry>");
+        }
+        console_printf("[%llu] %s\n", ueh->ue_ts, data);
+        return 0;
+    }
+#endif
 
     dlen = min(len, 128);
 
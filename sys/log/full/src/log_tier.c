@@ -0,0 +1,507 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_TIER)
+
+#include <string.h>
+
+#include "log/log.h"
+#include "log/log_tier.h"
+
+/* Wraps the tier's own dptr, so reads know which tier to go to. */
+struct log_tier_dptr {
+    struct log *ltd_log;
+    void *ltd_dptr;
+};
+
+struct log_tier_walk_arg {
+    struct log *ltw_log;
+    log_walk_func_t ltw_func;
+    struct log_offset *ltw_offset;
+    /* RAM entries at or below this index are already in flash. */
+    uint32_t ltw_flash_last;
+    uint8_t ltw_flash_any;
+    uint8_t ltw_ram;
+    int ltw_rc;
+};
+
+/* Serializes copying to flash and walks, for all tiered logs. */
+static struct os_mutex log_tier_mtx;
+static uint8_t log_tier_buf[MYNEWT_VAL(LOG_TIER_MAX_ENTRY_LEN)];
+static struct os_callout log_tier_callout;
+static bool log_tier_started;
+static bool log_tier_spill_failed;
+
+static bool
+log_tier_in_ram_only(const struct log_tier *lt, uint32_t idx)
+{
+    return !lt->lt_flash_any || (int32_t)(idx - lt->lt_flash_last) > 0;
+}
+
+static int
+log_tier_spill_walk(struct log *ram, struct log_offset *log_offset,
+                    void *dptr, uint16_t len)
+{
+    struct log_entry_hdr *hdr;
+    struct log_tier *lt;
+    int rc;
+
+    lt = log_offset->lo_arg;
+    hdr = (struct log_entry_hdr *)log_tier_buf;
+
+    rc = ram->l_log->log_read(ram, dptr, log_tier_buf, 0,
+                              min(len, sizeof(log_tier_buf)));
+    if (rc < (int)LOG_ENTRY_HDR_SIZE) {
+        return 0;
+    }
+    if (!log_tier_in_ram_only(lt, hdr->ue_index)) {
+        return 0;
+    }
+
+    /* Entries which don't fit the copy buffer stay in RAM only. */
+    if (len <= sizeof(log_tier_buf)) {
+        rc = lt->lt_flash.l_log->log_append(&lt->lt_flash, log_tier_buf, len);
+        if (rc != 0) {
+            log_tier_spill_failed = true;
+            return 1;
+        }
+    }
+    lt->lt_flash_last = hdr->ue_index;
+    lt->lt_flash_any = 1;
+
+    return 0;
+}
+
+/*
+ * Copies the RAM-only entries to flash.  Called with log_tier_mtx held,
+ * or from a fault path.
+ */
+static int
+log_tier_spill_locked(struct log *log)
+{
+    struct log_offset log_offset;
+    struct log_tier *lt;
+    uint32_t pending;
+
+    lt = log->l_arg;
+    pending = lt->lt_pending;
+
+    log_offset.lo_arg = lt;
+    log_offset.lo_ts = 0;
+    log_offset.lo_index = 0;
+    log_offset.lo_data_len = 0;
+
+    log_tier_spill_failed = false;
+    lt->lt_ram.l_log->log_walk(&lt->lt_ram, log_tier_spill_walk, &log_offset);
+    if (log_tier_spill_failed) {
+        /* Leave it to the timer to retry. */
+        lt->lt_pending = max(lt->lt_pending, 1);
+        return SYS_EIO;
+    }
+
+    /* Appends made during the walk still count towards the next spill. */
+    lt->lt_pending -= min(pending, lt->lt_pending);
+    return 0;
+}
+
+int
+log_tier_spill(struct log *log)
+{
+    int rc;
+
+    os_mutex_pend(&log_tier_mtx, OS_TIMEOUT_NEVER);
+    rc = log_tier_spill_locked(log);
+    os_mutex_release(&log_tier_mtx);
+
+    return rc;
+}
+
+void
+log_tier_spill_all(void)
+{
+    struct log *log;
+
+    log = NULL;
+    while ((log = log_list_get_next(log)) != NULL) {
+        if (log->l_log == &log_tier_handler) {
+            log_tier_spill_locked(log);
+        }
+    }
+}
+
+static void
+log_tier_ev_cb(struct os_event *ev)
+{
+    log_tier_spill(ev->ev_arg);
+}
+
+static void
+log_tier_timer_cb(struct os_event *ev)
+{
+    struct log_tier *lt;
+    struct log *log;
+
+    log = NULL;
+    while ((log = log_list_get_next(log)) != NULL) {
+        if (log->l_log != &log_tier_handler) {
+            continue;
+        }
+        lt = log->l_arg;
+        if (lt->lt_pending > 0) {
+            log_tier_spill(log);
+        }
+    }
+
+    os_callout_reset(&log_tier_callout,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(LOG_TIER_SPILL_ITVL)));
+}
+
+static void
+log_tier_appended(struct log *log, int rc, uint32_t len)
+{
+    struct log_tier *lt;
+
+    if (rc != 0) {
+        return;
+    }
+
+    lt = log->l_arg;
+    lt->lt_pending += len;
+    if (lt->lt_pending >= lt->lt_spill_thresh) {
+        os_eventq_put(os_eventq_dflt_get(), &lt->lt_ev);
+    }
+}
+
+static int
+log_tier_append(struct log *log, void *buf, int len)
+{
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+    rc = lt->lt_ram.l_log->log_append(&lt->lt_ram, buf, len);
+    log_tier_appended(log, rc, len);
+
+    return rc;
+}
+
+static int
+log_tier_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                     const void *body, int body_len)
+{
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+    rc = lt->lt_ram.l_log->log_append_body(&lt->lt_ram, hdr, body, body_len);
+    log_tier_appended(log, rc, LOG_ENTRY_HDR_SIZE + body_len);
+
+    return rc;
+}
+
+static int
+log_tier_append_mbuf(struct log *log, const struct os_mbuf *om)
+{
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+    if (lt->lt_ram.l_log->log_append_mbuf == NULL) {
+        return SYS_ENOTSUP;
+    }
+    rc = lt->lt_ram.l_log->log_append_mbuf(&lt->lt_ram, om);
+    log_tier_appended(log, rc, os_mbuf_len(om));
+
+    return rc;
+}
+
+static int
+log_tier_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
+                          const struct os_mbuf *om)
+{
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+    if (lt->lt_ram.l_log->log_append_mbuf_body == NULL) {
+        return SYS_ENOTSUP;
+    }
+    rc = lt->lt_ram.l_log->log_append_mbuf_body(&lt->lt_ram, hdr, om);
+    log_tier_appended(log, rc, LOG_ENTRY_HDR_SIZE + os_mbuf_len(om));
+
+    return rc;
+}
+
+static int
+log_tier_read(struct log *log, void *dptr, void *buf, uint16_t offset,
+              uint16_t len)
+{
+    struct log_tier_dptr *ltd;
+
+    ltd = dptr;
+    return ltd->ltd_log->l_log->log_read(ltd->ltd_log, ltd->ltd_dptr, buf,
+                                         offset, len);
+}
+
+static int
+log_tier_read_mbuf(struct log *log, void *dptr, struct os_mbuf *om,
+                   uint16_t offset, uint16_t len)
+{
+    struct log_tier_dptr *ltd;
+
+    ltd = dptr;
+    if (ltd->ltd_log->l_log->log_read_mbuf == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return ltd->ltd_log->l_log->log_read_mbuf(ltd->ltd_log, ltd->ltd_dptr, om,
+                                              offset, len);
+}
+
+static int
+log_tier_walk_one(struct log *tier, struct log_offset *log_offset,
+                  void *dptr, uint16_t len)
+{
+    struct log_tier_walk_arg *ltw;
+    struct log_entry_hdr hdr;
+    struct log_tier_dptr ltd;
+    int rc;
+
+    ltw = log_offset->lo_arg;
+
+    if (ltw->ltw_ram && ltw->ltw_flash_any) {
+        /* Skip entries which were already seen in flash. */
+        rc = tier->l_log->log_read(tier, dptr, &hdr, 0, sizeof(hdr));
+        if (rc < (int)sizeof(hdr) ||
+            (int32_t)(hdr.ue_index - ltw->ltw_flash_last) <= 0) {
+            return 0;
+        }
+    }
+
+    ltd.ltd_log = tier;
+    ltd.ltd_dptr = dptr;
+    rc = ltw->ltw_func(ltw->ltw_log, ltw->ltw_offset, &ltd, len);
+    if (rc != 0) {
+        ltw->ltw_rc = rc;
+    }
+    return rc;
+}
+
+static int
+log_tier_walk_tier(struct log *tier, struct log_tier_walk_arg *ltw)
+{
+    struct log_offset log_offset;
+
+    log_offset = *ltw->ltw_offset;
+    log_offset.lo_arg = ltw;
+
+    return tier->l_log->log_walk(tier, log_tier_walk_one, &log_offset);
+}
+
+static int
+log_tier_walk(struct log *log, log_walk_func_t walk_func,
+              struct log_offset *log_offset)
+{
+    struct log_tier_walk_arg ltw;
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+
+    ltw.ltw_log = log;
+    ltw.ltw_func = walk_func;
+    ltw.ltw_offset = log_offset;
+    ltw.ltw_rc = 0;
+
+    os_mutex_pend(&log_tier_mtx, OS_TIMEOUT_NEVER);
+
+    ltw.ltw_flash_last = lt->lt_flash_last;
+    ltw.ltw_flash_any = lt->lt_flash_any;
+
+    if (log_offset->lo_ts < 0 && lt->lt_pending > 0) {
+        /* The last entry is still only in RAM. */
+        ltw.ltw_ram = 0;
+        rc = log_tier_walk_tier(&lt->lt_ram, &ltw);
+        goto done;
+    }
+
+    ltw.ltw_ram = 0;
+    rc = log_tier_walk_tier(&lt->lt_flash, &ltw);
+    if (rc == 0 && ltw.ltw_rc == 0 && log_offset->lo_ts >= 0) {
+        ltw.ltw_ram = 1;
+        rc = log_tier_walk_tier(&lt->lt_ram, &ltw);
+    }
+
+done:
+    os_mutex_release(&log_tier_mtx);
+    return rc;
+}
+
+static int
+log_tier_flush(struct log *log)
+{
+    struct log_tier *lt;
+    int rc;
+
+    lt = log->l_arg;
+
+    os_mutex_pend(&log_tier_mtx, OS_TIMEOUT_NEVER);
+
+    rc = lt->lt_ram.l_log->log_flush(&lt->lt_ram);
+    if (lt->lt_flash.l_log->log_flush(&lt->lt_flash) != 0) {
+        rc = SYS_EIO;
+    }
+    lt->lt_pending = 0;
+    lt->lt_flash_any = 0;
+
+    os_mutex_release(&log_tier_mtx);
+
+    return rc;
+}
+
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+static int
+log_tier_storage_info(struct log *log, struct log_storage_info *info)
+{
+    struct log_tier *lt;
+
+    lt = log->l_arg;
+    if (lt->lt_flash.l_log->log_storage_info == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return lt->lt_flash.l_log->log_storage_info(&lt->lt_flash, info);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+static int
+log_tier_set_watermark(struct log *log, uint32_t index)
+{
+    struct log_tier *lt;
+
+    lt = log->l_arg;
+    if (lt->lt_flash.l_log->log_set_watermark == NULL) {
+        return SYS_ENOTSUP;
+    }
+    return lt->lt_flash.l_log->log_set_watermark(&lt->lt_flash, index);
+}
+#endif
+
+static int
+log_tier_last_walk(struct log *flash, struct log_offset *log_offset,
+                   void *dptr, uint16_t len)
+{
+    struct log_entry_hdr hdr;
+    struct log_tier *lt;
+    int rc;
+
+    lt = log_offset->lo_arg;
+
+    rc = flash->l_log->log_read(flash, dptr, &hdr, 0, sizeof(hdr));
+    if (rc >= (int)sizeof(hdr)) {
+        lt->lt_flash_last = hdr.ue_index;
+        lt->lt_flash_any = 1;
+    }
+    return 1;
+}
+
+static int
+log_tier_registered(struct log *log)
+{
+    struct log_offset log_offset;
+    struct log_tier *lt;
+
+    lt = log->l_arg;
+
+    lt->lt_ram.l_name = log->l_name;
+    lt->lt_flash.l_name = log->l_name;
+    if (lt->lt_ram.l_log->log_registered != NULL) {
+        lt->lt_ram.l_log->log_registered(&lt->lt_ram);
+    }
+    if (lt->lt_flash.l_log->log_registered != NULL) {
+        lt->lt_flash.l_log->log_registered(&lt->lt_flash);
+    }
+
+    /* Anything in RAM at this point was not logged by us. */
+    log_offset.lo_arg = lt;
+    log_offset.lo_ts = -1;
+    log_offset.lo_index = 0;
+    log_offset.lo_data_len = 0;
+    lt->lt_flash_any = 0;
+    lt->lt_flash.l_log->log_walk(&lt->lt_flash, log_tier_last_walk,
+                                 &log_offset);
+
+    if (!log_tier_started) {
+        log_tier_started = true;
+        os_mutex_init(&log_tier_mtx);
+        os_callout_init(&log_tier_callout, os_eventq_dflt_get(),
+                        log_tier_timer_cb, NULL);
+        os_callout_reset(&log_tier_callout,
+                         os_time_ms_to_ticks32(
+                             MYNEWT_VAL(LOG_TIER_SPILL_ITVL)));
+    }
+
+    lt->lt_ev.ev_cb = log_tier_ev_cb;
+    lt->lt_ev.ev_arg = log;
+
+    return 0;
+}
+
+const struct log_handler log_tier_handler = {
+    .log_type = LOG_TYPE_STORAGE,
+    .log_read = log_tier_read,
+    .log_read_mbuf = log_tier_read_mbuf,
+    .log_append = log_tier_append,
+    .log_append_body = log_tier_append_body,
+    .log_append_mbuf = log_tier_append_mbuf,
+    .log_append_mbuf_body = log_tier_append_mbuf_body,
+    .log_walk = log_tier_walk,
+    .log_flush = log_tier_flush,
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+    .log_storage_info = log_tier_storage_info,
+#endif
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    .log_set_watermark = log_tier_set_watermark,
+#endif
+    .log_registered = log_tier_registered,
+};
+
+int
+log_tier_init(struct log_tier *lt,
+              const struct log_handler *ram_lh, void *ram_arg,
+              const struct log_handler *flash_lh, void *flash_arg,
+              uint32_t spill_thresh)
+{
+    if (ram_lh == NULL || flash_lh == NULL || spill_thresh == 0) {
+        return SYS_EINVAL;
+    }
+
+    memset(lt, 0, sizeof(*lt));
+
+    lt->lt_ram.l_log = ram_lh;
+    lt->lt_ram.l_arg = ram_arg;
+    lt->lt_flash.l_log = flash_lh;
+    lt->lt_flash.l_arg = flash_arg;
+    lt->lt_spill_thresh = spill_thresh;
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(LOG_TIER) */
@@ -59,6 +59,7 @@ TEST_CASE_DECL(log_test_case_fcb_append_mbuf);
 TEST_CASE_DECL(log_test_case_fcb_append_mbuf_body);
 
 TEST_SUITE_DECL(log_test_suite_misc);
+TEST_CASE_DECL(log_test_case_fanout);
 TEST_CASE_DECL(log_test_case_level);
 
 #ifdef __cplusplus
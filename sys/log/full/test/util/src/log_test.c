@@ -48,5 +48,6 @@ TEST_SUITE(log_test_suite_fcb_mbuf)
 
 TEST_SUITE(log_test_suite_misc)
 {
+    log_test_case_fanout();
     log_test_case_level();
 }
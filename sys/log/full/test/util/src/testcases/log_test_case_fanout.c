@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_FANOUT)
+
+#include "log/log_fanout.h"
+
+static uint8_t ltf_cbmem_bufs[2][1024];
+
+static int
+ltf_count_walk(struct log *log, struct log_offset *log_offset,
+               void *dptr, uint16_t len)
+{
+    (*(int *)log_offset->lo_arg)++;
+    return 0;
+}
+
+static int
+ltf_count(struct log *log)
+{
+    struct log_offset lo;
+    int cnt;
+
+    cnt = 0;
+    memset(&lo, 0, sizeof lo);
+    lo.lo_arg = &cnt;
+    log_walk(log, ltf_count_walk, &lo);
+
+    return cnt;
+}
+
+static int
+ltf_module1(const struct log_entry_hdr *hdr, void *arg)
+{
+    return hdr->ue_module == 1;
+}
+
+#endif
+
+TEST_CASE(log_test_case_fanout)
+{
+#if MYNEWT_VAL(LOG_FANOUT)
+    struct log_fanout_sink sinks[2];
+    struct log_fanout lf;
+    struct cbmem cbmem[2];
+    struct os_mbuf *om;
+    struct log log;
+    int rc;
+
+    sysinit();
+
+    cbmem_init(&cbmem[0], ltf_cbmem_bufs[0], sizeof ltf_cbmem_bufs[0]);
+    cbmem_init(&cbmem[1], ltf_cbmem_bufs[1], sizeof ltf_cbmem_bufs[1]);
+
+    /* Sink 0 takes everything; sink 1 only module 1 at level 2 or up. */
+    log_fanout_sink_init(&sinks[0], &log_cbmem_handler, &cbmem[0], 0);
+    log_fanout_sink_init(&sinks[1], &log_cbmem_handler, &cbmem[1], 2);
+    log_fanout_sink_filter(&sinks[1], ltf_module1, NULL);
+
+    rc = log_fanout_init(&lf, sinks, 0);
+    TEST_ASSERT(rc == SYS_EINVAL);
+    rc = log_fanout_init(&lf, sinks, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = log_register("fanout", &log, &log_fanout_handler, &lf, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    log_append_body(&log, 0, 0, LOG_ETYPE_STRING, "a", 1);
+    log_append_body(&log, 1, 1, LOG_ETYPE_STRING, "b", 1);
+    log_append_body(&log, 1, 2, LOG_ETYPE_STRING, "c", 1);
+    log_append_body(&log, 2, 3, LOG_ETYPE_STRING, "d", 1);
+    log_printf(&log, 1, 3, "e%d", 1);
+
+    om = ltu_flat_to_fragged_mbuf("f", 1, 1);
+    log_append_mbuf_body(&log, 1, 3, LOG_ETYPE_STRING, om);
+
+    TEST_ASSERT(ltf_count(&sinks[0].lfs_log) == 6);
+    TEST_ASSERT(ltf_count(&sinks[1].lfs_log) == 3);
+
+    /* Reads go to the first sink. */
+    TEST_ASSERT(ltf_count(&log) == 6);
+
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltf_count(&sinks[0].lfs_log) == 0);
+    TEST_ASSERT(ltf_count(&sinks[1].lfs_log) == 0);
+#endif
+}
@@ -39,9 +39,17 @@
  *       than the module's minimum level are discarded.
  *
  * Costs of using modlog rather than the bare `sys/log` facility are:
- *     o Increased RAM usage (`MODLOG_MAX_MAPPINGS` * 12).
+ *     o Increased RAM usage (`MODLOG_MAX_MAPPINGS` * 12, plus 512 bytes for
+ *       the per-module table if `MODLOG_MODULE_TABLE` is enabled).
  *     o Increased CPU usage - each log write requires a lookup in the set
- *       of configured modlog mappings.
+ *       of configured modlog mappings.  With `MODLOG_MODULE_TABLE` this is
+ *       a table index, and the `MODLOG_[...]` macros skip writes below the
+ *       module's level before their arguments are evaluated.
+ *
+ * Writes can also be removed at compile time, either for all modules with
+ * `LOG_LEVEL` or for individual modules with `MODLOG_MODULE_LEVELS`.  A
+ * `MODLOG_[...]` macro call below either threshold generates no code as long
+ * as the module ID is a constant.
  */
 
 #ifndef H_MODLOG_
@@ -84,6 +92,52 @@ struct modlog_desc {
  */
 typedef int modlog_foreach_fn(const struct modlog_desc *desc, void *arg);
 
+/**
+ * Compile-time minimum level of each module, from `MODLOG_MODULE_LEVELS`.
+ * Only used with constant indices, so that it folds away.
+ */
+static const uint8_t modlog_module_levels_min[256] = {
+    MYNEWT_VAL(MODLOG_MODULE_LEVELS)
+};
+
+#if MYNEWT_VAL(LOG_FULL) && MYNEWT_VAL(MODLOG_MODULE_TABLE)
+/* Maintained by modlog; use modlog_enabled() rather than reading this. */
+extern uint8_t modlog_module_levels[256];
+#endif
+
+/**
+ * @brief Indicates whether a write to the specified module and level would
+ * be stored in any log.
+ *
+ * This is resolved at compile time if the module and level are constants and
+ * the write is excluded by `MODLOG_MODULE_LEVELS`.  Otherwise the module's
+ * level from log_level_set() is checked and, with `MODLOG_MODULE_TABLE`
+ * enabled, the lowest level of the module's mappings.
+ *
+ * @param module                The log module to check.
+ * @param level                 The severity of the prospective entry.
+ *
+ * @return                      true if the write may be stored;
+ *                              false if it would be discarded.
+ */
+static inline bool
+modlog_enabled(uint8_t module, uint8_t level)
+{
+    if (level < modlog_module_levels_min[module]) {
+        return false;
+    }
+#if MYNEWT_VAL(LOG_FULL)
+    if (level < log_level_get(module)) {
+        return false;
+    }
+#endif
+#if MYNEWT_VAL(LOG_FULL) && MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    return level >= modlog_module_levels[module];
+#else
+    return true;
+#endif
+}
+
 /* Only enable modlog if logging is also enabled. */
 #if MYNEWT_VAL(LOG_FULL) || defined(__DOXYGEN__)
 
@@ -240,18 +294,34 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
 
 #endif
 
+/**
+ * @brief Writes a formatted text entry if the module accepts the level.
+ *
+ * The format arguments are only evaluated if modlog_enabled() passes.  The
+ * module argument may be evaluated more than once.
+ *
+ * @param ml_mod_               The log module to write to.
+ * @param ml_lvl_               The severity of the log entry to write.
+ * @param ml_msg_               The "printf" formatted string to write.
+ */
+#define MODLOG_PRINTF_LEVEL(ml_mod_, ml_lvl_, ml_msg_, ...)             \
+    (modlog_enabled((ml_mod_), (ml_lvl_)) ?                             \
+     modlog_printf((ml_mod_), (ml_lvl_), (ml_msg_), ##__VA_ARGS__) :    \
+     (void)0)
+
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG || defined __DOXYGEN__
 /**
  * @brief Writes a formatted debug text entry to the specified log module.
  *
  * This expands to nothing if the global log level is greater than
- * `LOG_LEVEL_DEBUG`.
+ * `LOG_LEVEL_DEBUG`.  The arguments are not evaluated if the module's level
+ * is greater than `LOG_LEVEL_DEBUG`.
  *
  * @param ml_mod_               The log module to write to.
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_DEBUG(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_DEBUG, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_LEVEL((ml_mod_), LOG_LEVEL_DEBUG, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_DEBUG(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -261,13 +331,14 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @brief Writes a formatted info text entry to the specified log module.
  *
  * This expands to nothing if the global log level is greater than
- * `LOG_LEVEL_INFO`.
+ * `LOG_LEVEL_INFO`.  The arguments are not evaluated if the module's level
+ * is greater than `LOG_LEVEL_INFO`.
  *
  * @param ml_mod_               The log module to write to.
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_INFO(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_INFO, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_LEVEL((ml_mod_), LOG_LEVEL_INFO, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_INFO(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -277,13 +348,14 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @brief Writes a formatted warn text entry to the specified log module.
  *
  * This expands to nothing if the global log level is greater than
- * `LOG_LEVEL_WARN`.
+ * `LOG_LEVEL_WARN`.  The arguments are not evaluated if the module's level
+ * is greater than `LOG_LEVEL_WARN`.
  *
  * @param ml_mod_               The log module to write to.
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_WARN(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_WARN, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_LEVEL((ml_mod_), LOG_LEVEL_WARN, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_WARN(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -293,13 +365,14 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @brief Writes a formatted error text entry to the specified log module.
  *
  * This expands to nothing if the global log level is greater than
- * `LOG_LEVEL_ERROR`.
+ * `LOG_LEVEL_ERROR`.  The arguments are not evaluated if the module's level
+ * is greater than `LOG_LEVEL_ERROR`.
  *
  * @param ml_mod_               The log module to write to.
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_ERROR(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_ERROR, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_LEVEL((ml_mod_), LOG_LEVEL_ERROR, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_ERROR(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -309,13 +382,15 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @brief Writes a formatted critical text entry to the specified log module.
  *
  * This expands to nothing if the global log level is greater than
- * `LOG_LEVEL_CRITICAL`.
+ * `LOG_LEVEL_CRITICAL`.  The arguments are not evaluated if the module's level
+ * is greater than `LOG_LEVEL_CRITICAL`.
  *
  * @param ml_mod_               The log module to write to.
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_CRITICAL(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_CRITICAL, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_LEVEL((ml_mod_), LOG_LEVEL_CRITICAL, (ml_msg_), \
+                        ##__VA_ARGS__)
 #else
 #define MODLOG_CRITICAL(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "rwlock/rwlock.h"
 #include "log/log.h"
@@ -51,6 +52,23 @@ static struct modlog_list modlog_mappings =
  */
 static struct modlog_mapping *modlog_first_dflt;
 
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+/** Lowest level written for each module; read by modlog_enabled(). */
+uint8_t modlog_module_levels[256];
+
+/**
+ * Handle of the first mapping for each module, MODLOG_HANDLE_NONE if the
+ * module is unmapped.
+ */
+static uint8_t modlog_module_first[256];
+
+#define MODLOG_HANDLE_NONE  0xff
+
+#if MYNEWT_VAL(MODLOG_MAX_MAPPINGS) >= MODLOG_HANDLE_NONE
+#error "MODLOG_MODULE_TABLE requires MODLOG_MAX_MAPPINGS < 255"
+#endif
+#endif
+
 static struct modlog_mapping *
 modlog_alloc(void)
 {
@@ -88,6 +106,53 @@ modlog_infer_handle(const struct modlog_mapping *mm)
     return idx;
 }
 
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+static struct modlog_mapping *
+modlog_from_handle(uint8_t handle)
+{
+    size_t elem_sz;
+
+    elem_sz = sizeof modlog_mapping_buf / MYNEWT_VAL(MODLOG_MAX_MAPPINGS);
+
+    return (void *)((uint8_t *)modlog_mapping_buf + handle * elem_sz);
+}
+
+/**
+ * Rebuilds the per-module tables from the mapping list.  Must be called
+ * with the write lock held after every change to the list.
+ */
+static void
+modlog_table_update(void)
+{
+    struct modlog_mapping *mm;
+    uint8_t dflt_level;
+    uint8_t module;
+    int i;
+
+    memset(modlog_module_first, MODLOG_HANDLE_NONE,
+           sizeof modlog_module_first);
+    memset(modlog_module_levels, UINT8_MAX, sizeof modlog_module_levels);
+
+    SLIST_FOREACH(mm, &modlog_mappings, next) {
+        module = mm->desc.module;
+        if (modlog_module_first[module] == MODLOG_HANDLE_NONE) {
+            modlog_module_first[module] = mm->desc.handle;
+        }
+        if (mm->desc.min_level < modlog_module_levels[module]) {
+            modlog_module_levels[module] = mm->desc.min_level;
+        }
+    }
+
+    /* Unmapped modules are written to the default set. */
+    dflt_level = modlog_module_levels[MODLOG_MODULE_DFLT];
+    for (i = 0; i < MODLOG_MODULE_DFLT; i++) {
+        if (modlog_module_first[i] == MODLOG_HANDLE_NONE) {
+            modlog_module_levels[i] = dflt_level;
+        }
+    }
+}
+#endif
+
 static struct modlog_mapping *
 modlog_find(uint8_t handle, struct modlog_mapping **out_prev)
 {
@@ -137,6 +202,25 @@ modlog_find_by_module(uint8_t module, struct modlog_mapping **out_prev)
     return cur;
 }
 
+/**
+ * Finds the first mapping for the given module, or NULL if it is unmapped.
+ */
+static struct modlog_mapping *
+modlog_first_for_module(uint8_t module)
+{
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    uint8_t handle;
+
+    handle = modlog_module_first[module];
+    if (handle == MODLOG_HANDLE_NONE) {
+        return NULL;
+    }
+    return modlog_from_handle(handle);
+#else
+    return modlog_find_by_module(module, NULL);
+#endif
+}
+
 static void
 modlog_insert(struct modlog_mapping *mm)
 {
@@ -191,6 +275,9 @@ modlog_register_no_lock(uint8_t module, struct log *log, uint8_t min_level,
     };
 
     modlog_insert(mm);
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    modlog_table_update();
+#endif
 
     if (out_handle != NULL) {
         *out_handle = mm->desc.handle;
@@ -212,6 +299,9 @@ modlog_delete_no_lock(uint8_t handle)
 
     modlog_remove(mm, prev);
     modlog_free(mm);
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    modlog_table_update();
+#endif
 
     return 0;
 }
@@ -243,7 +333,7 @@ modlog_append_no_lock(uint8_t module, uint8_t level, uint8_t etype,
         return SYS_EINVAL;
     }
 
-    mm = modlog_find_by_module(module, NULL);
+    mm = modlog_first_for_module(module);
     if (mm != NULL) {
         while (mm != NULL && mm->desc.module == module) {
             rc = modlog_append_one(mm, module, level, etype, data, len);
@@ -292,25 +382,22 @@ modlog_append_mbuf_no_lock(uint8_t module, uint8_t level, uint8_t etype,
                            struct os_mbuf *om)
 {
     struct modlog_mapping *mm;
-    bool found;
     int rc;
 
-    found = false;
-    SLIST_FOREACH(mm, &modlog_mappings, next) {
-        if (mm->desc.module == module) {
-            found = true;
-
+    mm = modlog_first_for_module(module);
+    if (mm != NULL) {
+        while (mm != NULL && mm->desc.module == module) {
             rc = modlog_append_mbuf_one(mm, module, level, etype, om);
             if (rc != 0) {
                 return rc;
             }
-        } else if (mm->desc.module > module) {
-            break;
-        }
-    }
 
-    /* If no mappings match the specified module, write to the default set. */
-    if (!found) {
+            mm = SLIST_NEXT(mm, next);
+        }
+    } else {
+        /* No mappings match the specified module; write to the default
+         * set.
+         */
         for (mm = modlog_first_dflt;
              mm != NULL;
              mm = SLIST_NEXT(mm, next)) {
@@ -408,6 +495,9 @@ modlog_clear(void)
         modlog_remove(mm, NULL);
         modlog_free(mm);
     }
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    modlog_table_update();
+#endif
 
     rwlock_release_write(&modlog_rwl);
 }
@@ -418,6 +508,10 @@ modlog_append(uint8_t module, uint8_t level, uint8_t etype,
 {
     int rc;
 
+    if (!modlog_enabled(module, level)) {
+        return 0;
+    }
+
     rwlock_acquire_read(&modlog_rwl);
     rc = modlog_append_no_lock(module, level, etype, data, len);
     rwlock_release_read(&modlog_rwl);
@@ -431,6 +525,11 @@ modlog_append_mbuf(uint8_t module, uint8_t level, uint8_t etype,
 {
     int rc;
 
+    if (!modlog_enabled(module, level)) {
+        os_mbuf_free_chain(om);
+        return 0;
+    }
+
     rwlock_acquire_read(&modlog_rwl);
     rc = modlog_append_mbuf_no_lock(module, level, etype, om);
     rwlock_release_read(&modlog_rwl);
@@ -457,6 +556,10 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
     char buf[MYNEWT_VAL(MODLOG_MAX_PRINTF_LEN)];
     int len;
 
+    if (!modlog_enabled(module, level)) {
+        return;
+    }
+
     va_start(args, msg);
     len = vsnprintf(buf, MYNEWT_VAL(MODLOG_MAX_PRINTF_LEN), msg, args);
     va_end(args);
@@ -482,6 +585,9 @@ modlog_init(void)
 
     SLIST_INIT(&modlog_mappings);
     modlog_first_dflt = NULL;
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    modlog_table_update();
+#endif
 
     rc = rwlock_init(&modlog_rwl);
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "modlog_test.h"
+
+TEST_CASE(modlog_test_case_level)
+{
+    struct mltu_log_arg mla1;
+    struct mltu_log_arg mla2;
+    struct log log1;
+    struct log log2;
+    uint8_t handle;
+    int cnt;
+    int rc;
+
+    sysinit();
+
+    memset(&mla1, 0, sizeof mla1);
+    mltu_register_log(&log1, &mla1, "log1", 0);
+
+    memset(&mla2, 0, sizeof mla2);
+    mltu_register_log(&log2, &mla2, "log2", 0);
+
+    rc = modlog_register(1, &log1, LOG_LEVEL_WARN, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = modlog_register(MODLOG_MODULE_DFLT, &log2, LOG_LEVEL_ERROR,
+                         &handle);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Arguments are only evaluated if the module accepts the level. */
+    cnt = 0;
+    MODLOG_INFO(1, "%d", cnt++);
+    TEST_ASSERT(mla1.num_entries == 0);
+    MODLOG_WARN(1, "%d", cnt++);
+    TEST_ASSERT(mla1.num_entries == 1);
+    MODLOG_WARN(2, "%d", cnt++);
+    TEST_ASSERT(mla2.num_entries == 0);
+    MODLOG_ERROR(2, "%d", cnt++);
+    TEST_ASSERT(mla2.num_entries == 1);
+
+    TEST_ASSERT(modlog_enabled(1, LOG_LEVEL_WARN));
+    TEST_ASSERT(modlog_enabled(2, LOG_LEVEL_ERROR));
+
+#if MYNEWT_VAL(MODLOG_MODULE_TABLE)
+    TEST_ASSERT(cnt == 2);
+    TEST_ASSERT(!modlog_enabled(1, LOG_LEVEL_INFO));
+    TEST_ASSERT(!modlog_enabled(2, LOG_LEVEL_WARN));
+
+    /* Unmapped modules follow the default mappings. */
+    rc = modlog_delete(handle);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!modlog_enabled(2, LOG_LEVEL_CRITICAL));
+    TEST_ASSERT(modlog_enabled(1, LOG_LEVEL_WARN));
+
+    rc = modlog_register(2, &log2, LOG_LEVEL_DEBUG, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(modlog_enabled(2, LOG_LEVEL_DEBUG));
+
+    modlog_clear();
+    TEST_ASSERT(!modlog_enabled(1, LOG_LEVEL_CRITICAL));
+#endif
+}
@@ -142,6 +142,14 @@ extern "C" {
  * As number of values increases in a series it may be necessary to allocate
  * more blocks for the same data series. Once event data is reset, all blocks
  * allocated for an event are freed.
+ *
+ * If METRICS_HIST is enabled, a metric can also be a histogram
+ * (METRICS_TYPE_HISTOGRAM) which records the distribution of values set for
+ * it, e.g. latencies. Each histogram takes one block from a separate pool of
+ * METRICS_HIST_POOL_COUNT blocks on first value and returns it when event data
+ * is reset. Values are counted in log-linear buckets, so a percentile read
+ * back with metrics_get_hist_percentile() is accurate to 1/2^SUB_BITS of its
+ * value, where SUB_BITS is METRICS_HIST_SUB_BITS.
  */
 
 /* Helper to define metric type - use types defined below instead! */
@@ -157,6 +165,7 @@ extern "C" {
 #define METRICS_TYPE_SERIES_S8          METRICS_TYPE(1, 1, sizeof(uint8_t))
 #define METRICS_TYPE_SERIES_S16         METRICS_TYPE(1, 1, sizeof(uint16_t))
 #define METRICS_TYPE_SERIES_S32         METRICS_TYPE(1, 1, sizeof(uint32_t))
+#define METRICS_TYPE_HISTOGRAM          (0x20 | sizeof(uint32_t))
 #define METRICS_TYPE_SINGLE             (METRICS_TYPE_SINGLE_U)
 #define METRICS_TYPE_SERIES             (METRICS_TYPE_SERIES_U32)
 
@@ -396,6 +405,41 @@ int metrics_set_single_value(struct metrics_event_hdr *hdr, uint8_t metric,
 int metrics_set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
                              uint32_t val);
 
+#if MYNEWT_VAL(METRICS_HIST)
+/**
+ * Get percentile of histogram metric
+ *
+ * Returns the upper bound of the bucket holding the value at given percentile,
+ * clipped to the largest value recorded. A percentile of 100 thus returns the
+ * maximum value.
+ *
+ * @param hdr     Event header
+ * @param metric  Metric identifier
+ * @param pct     Percentile (0-100)
+ * @param val     Percentile value
+ *
+ * @return 0 on success, negative value if metric is not a histogram or has no
+ *         data set
+ */
+int metrics_get_hist_percentile(struct metrics_event_hdr *hdr, uint8_t metric,
+                                uint8_t pct, uint32_t *val);
+
+/**
+ * Get summary of histogram metric
+ *
+ * @param hdr     Event header
+ * @param metric  Metric identifier
+ * @param count   Number of values recorded
+ * @param min     Smallest value recorded
+ * @param max     Largest value recorded
+ *
+ * @return 0 on success, negative value if metric is not a histogram or has no
+ *         data set
+ */
+int metrics_get_hist_summary(struct metrics_event_hdr *hdr, uint8_t metric,
+                             uint32_t *count, uint32_t *min, uint32_t *max);
+#endif
+
 /**
  * Serialize event data to CBOR
  *
@@ -403,6 +447,10 @@ int metrics_set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
  * metrics will be included in output. Metrics which do not have data set will
  * have value set to 'undefined'.
  *
+ * Histogram metrics are encoded as a map with bucket layout ("sb", sub-bucket
+ * bits), count ("n"), "min", "max" and "b", an array of index/count pairs for
+ * non-empty buckets only.
+ *
  * Data collected in an event remain unaffected. The only exception is when
  * destination mbuf is allocated using event_metric_get_mbuf() - data are then
  * removed from event during serialization to reduce memory usage and free space
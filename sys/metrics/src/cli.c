@@ -78,6 +78,8 @@ metric_type_str(uint8_t type)
         return "unsigned32-series";
     case METRICS_TYPE_SERIES_S32:
         return "signed32-series";
+    case METRICS_TYPE_HISTOGRAM:
+        return "histogram";
     }
 
     return "<unknown>";
@@ -219,6 +221,53 @@ cmd_event_end(int argc, char **argv)
     return 0;
 }
 
+#if MYNEWT_VAL(METRICS_HIST)
+static int
+cmd_metric_hist(int argc, char **argv)
+{
+    static const uint8_t pcts[] = { 50, 90, 99 };
+    struct metrics_event_hdr *hdr;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t val;
+    int i;
+    int j;
+
+    if (argc < 3) {
+        console_printf("Event and/or metric name not specified\n");
+        return -1;
+    }
+
+    hdr = find_event_by_name(argv[1]);
+    if (!hdr) {
+        console_printf("Event '%s' not found\n", argv[1]);
+        return -1;
+    }
+
+    i = find_metric_by_name(hdr, argv[2]);
+    if (i < 0) {
+        console_printf("Metric '%s' not found\n", argv[2]);
+        return -1;
+    }
+
+    if (metrics_get_hist_summary(hdr, i, &count, &min, &max)) {
+        console_printf("No histogram data for '%s'\n", argv[2]);
+        return -1;
+    }
+
+    console_printf("count=%lu min=%lu", (unsigned long)count,
+                   (unsigned long)min);
+    for (j = 0; j < (int)sizeof(pcts); j++) {
+        metrics_get_hist_percentile(hdr, i, pcts[j], &val);
+        console_printf(" p%d=%lu", pcts[j], (unsigned long)val);
+    }
+    console_printf(" max=%lu\n", (unsigned long)max);
+
+    return 0;
+}
+#endif
+
 static const struct shell_cmd metrics_commands[] = {
     {
         .sc_cmd = "list-events",
@@ -240,6 +289,12 @@ static const struct shell_cmd metrics_commands[] = {
         .sc_cmd = "event-end",
         .sc_cmd_func = cmd_event_end,
     },
+#if MYNEWT_VAL(METRICS_HIST)
+    {
+        .sc_cmd = "metric-hist",
+        .sc_cmd_func = cmd_metric_hist,
+    },
+#endif
     { },
 };
 
@@ -38,12 +38,39 @@
 
 #define METRICS_TYPE_SERIES_MASK    0x80
 #define METRICS_TYPE_SIGNED_MASK    0x40
+#define METRICS_TYPE_HIST_MASK      0x20
 #define METRICS_TYPE_SIZE_MASK      0x0f
 
+#if MYNEWT_VAL(METRICS_HIST)
+/*
+ * Log-linear histogram: values below 2^SUB_BITS get a bucket each, and every
+ * power of two above that is split into 2^SUB_BITS equal buckets, so each
+ * bucket spans at most 1/2^SUB_BITS of its lower bound.
+ */
+#define HIST_SUB_BITS   MYNEWT_VAL(METRICS_HIST_SUB_BITS)
+#define HIST_SUB_CNT    (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS    ((33 - HIST_SUB_BITS) << HIST_SUB_BITS)
+
+struct metrics_hist {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint16_t buckets[HIST_BUCKETS];
+};
+
+static os_membuf_t metrics_hist_data[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(METRICS_HIST_POOL_COUNT),
+                    sizeof(struct metrics_hist)) ];
+static struct os_mempool metrics_hist_pool;
+#endif
+
 union metrics_metric_val {
     uintptr_t notused;
     uint32_t val;
     struct os_mbuf *series;
+#if MYNEWT_VAL(METRICS_HIST)
+    struct metrics_hist *hist;
+#endif
 };
 
 struct metrics_event {
@@ -144,6 +171,13 @@ metrics_event_end(struct metrics_event_hdr *hdr)
                 os_mbuf_free_chain(v->series);
             }
             v->series = NULL;
+#if MYNEWT_VAL(METRICS_HIST)
+        } else if (def->type & METRICS_TYPE_HIST_MASK) {
+            if (v->hist) {
+                os_memblock_put(&metrics_hist_pool, v->hist);
+            }
+            v->hist = NULL;
+#endif
         } else {
             v->val = 0;
         }
@@ -228,6 +262,180 @@ set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
     return 0;
 }
 
+#if MYNEWT_VAL(METRICS_HIST)
+static int
+hist_bucket(uint32_t val)
+{
+    int exp;
+
+    if (val < HIST_SUB_CNT) {
+        return val;
+    }
+
+    exp = 31 - __builtin_clz(val);
+
+    return ((exp - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+           (val >> (exp - HIST_SUB_BITS)) - HIST_SUB_CNT;
+}
+
+static uint32_t
+hist_bucket_max(int idx)
+{
+    int shift;
+
+    if (idx < HIST_SUB_CNT) {
+        return idx;
+    }
+
+    shift = (idx >> HIST_SUB_BITS) - 1;
+
+    return (((uint32_t)(HIST_SUB_CNT + (idx & (HIST_SUB_CNT - 1))) << shift) +
+            ((uint32_t)1 << shift) - 1);
+}
+
+static int
+set_hist_value(struct metrics_event_hdr *hdr, uint8_t metric, uint32_t val)
+{
+    struct metrics_event *em = (struct metrics_event *)hdr;
+    struct metrics_hist *h;
+    uint16_t *bucket;
+
+    h = em->vals[metric].hist;
+    if (!h) {
+        h = os_memblock_get(&metrics_hist_pool);
+        if (!h) {
+            return -1;
+        }
+        memset(h, 0, sizeof(*h));
+        h->min = UINT32_MAX;
+        em->vals[metric].hist = h;
+    }
+
+    bucket = &h->buckets[hist_bucket(val)];
+    if (*bucket < UINT16_MAX) {
+        (*bucket)++;
+    }
+
+    h->count++;
+    if (val < h->min) {
+        h->min = val;
+    }
+    if (val > h->max) {
+        h->max = val;
+    }
+
+    hdr->set |= (1 << metric);
+
+    return 0;
+}
+
+int
+metrics_get_hist_percentile(struct metrics_event_hdr *hdr, uint8_t metric,
+                            uint8_t pct, uint32_t *val)
+{
+    struct metrics_event *em = (struct metrics_event *)hdr;
+    struct metrics_hist *h;
+    uint32_t target;
+    uint32_t sum;
+    int i;
+
+    assert(metric < hdr->count);
+
+    if ((hdr->defs[metric].type & METRICS_TYPE_HIST_MASK) == 0 || pct > 100) {
+        return -1;
+    }
+
+    h = em->vals[metric].hist;
+    if (!h || !h->count) {
+        return -1;
+    }
+
+    /* Bucket counts saturate, so rank against their sum, not h->count */
+    sum = 0;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        sum += h->buckets[i];
+    }
+
+    target = (sum * pct + 99) / 100;
+    if (target == 0) {
+        *val = h->min;
+        return 0;
+    }
+
+    sum = 0;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        sum += h->buckets[i];
+        if (sum >= target) {
+            break;
+        }
+    }
+
+    *val = min(hist_bucket_max(i), h->max);
+
+    return 0;
+}
+
+int
+metrics_get_hist_summary(struct metrics_event_hdr *hdr, uint8_t metric,
+                         uint32_t *count, uint32_t *min, uint32_t *max)
+{
+    struct metrics_event *em = (struct metrics_event *)hdr;
+    struct metrics_hist *h;
+
+    assert(metric < hdr->count);
+
+    if ((hdr->defs[metric].type & METRICS_TYPE_HIST_MASK) == 0) {
+        return -1;
+    }
+
+    h = em->vals[metric].hist;
+    if (!h || !h->count) {
+        return -1;
+    }
+
+    *count = h->count;
+    *min = h->min;
+    *max = h->max;
+
+    return 0;
+}
+
+static int
+append_hist_to_cbor(CborEncoder *encoder, struct metrics_hist *h)
+{
+    CborEncoder map;
+    CborEncoder arr;
+    int rc;
+    int i;
+
+    rc = cbor_encoder_create_map(encoder, &map, 5);
+
+    rc |= cbor_encode_text_stringz(&map, "sb");
+    rc |= cbor_encode_uint(&map, HIST_SUB_BITS);
+    rc |= cbor_encode_text_stringz(&map, "n");
+    rc |= cbor_encode_uint(&map, h->count);
+    rc |= cbor_encode_text_stringz(&map, "min");
+    rc |= cbor_encode_uint(&map, h->min);
+    rc |= cbor_encode_text_stringz(&map, "max");
+    rc |= cbor_encode_uint(&map, h->max);
+
+    /* Only non-empty buckets, as flat index/count pairs */
+    rc |= cbor_encode_text_stringz(&map, "b");
+    rc |= cbor_encoder_create_array(&map, &arr, CborIndefiniteLength);
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        if (h->buckets[i]) {
+            rc |= cbor_encode_uint(&arr, i);
+            rc |= cbor_encode_uint(&arr, h->buckets[i]);
+        }
+    }
+    rc |= cbor_encoder_close_container(&map, &arr);
+
+    rc |= cbor_encoder_close_container(encoder, &map);
+
+    return rc ? -1 : 0;
+}
+#endif
+
 int
 metrics_set_value(struct metrics_event_hdr *hdr, uint8_t metric,
                  uint32_t val)
@@ -244,6 +452,10 @@ metrics_set_value(struct metrics_event_hdr *hdr, uint8_t metric,
 
     if (def->type & METRICS_TYPE_SERIES_MASK) {
         return set_series_value(hdr, metric, val, def->type);
+#if MYNEWT_VAL(METRICS_HIST)
+    } else if (def->type & METRICS_TYPE_HIST_MASK) {
+        return set_hist_value(hdr, metric, val);
+#endif
     } else {
         return set_single_value(hdr, metric, val);
     }
@@ -259,7 +471,7 @@ metrics_set_single_value(struct metrics_event_hdr *hdr, uint8_t metric, uint32_t
     assert(metric < hdr->count);
 
     def = &hdr->defs[metric];
-    if (def->type & METRICS_TYPE_SERIES_MASK) {
+    if (def->type & (METRICS_TYPE_SERIES_MASK | METRICS_TYPE_HIST_MASK)) {
         return -1;
     }
 
@@ -470,6 +682,16 @@ metrics_event_to_cbor(struct metrics_event_hdr *hdr, struct os_mbuf *om)
             continue;
         }
 
+#if MYNEWT_VAL(METRICS_HIST)
+        if (def->type & METRICS_TYPE_HIST_MASK) {
+            rc = append_hist_to_cbor(&map, v->hist);
+            if (rc != 0) {
+                goto failed;
+            }
+            continue;
+        }
+#endif
+
         if ((def->type & METRICS_TYPE_SERIES_MASK) == 0) {
             if (def->type & METRICS_TYPE_SIGNED_MASK) {
                 cbor_encode_int(&map, (int32_t)v->val);
@@ -557,6 +779,14 @@ metrics_pkg_init(void)
                            MEMPOOL_SIZE, MEMPOOL_COUNT);
     assert(rc == 0);
 
+#if MYNEWT_VAL(METRICS_HIST)
+    rc = os_mempool_init(&metrics_hist_pool,
+                         MYNEWT_VAL(METRICS_HIST_POOL_COUNT),
+                         sizeof(struct metrics_hist), metrics_hist_data,
+                         "metrics_hist");
+    assert(rc == 0);
+#endif
+
 #if MYNEWT_VAL(METRICS_CLI)
     metrics_cli_init();
 #endif
@@ -153,6 +153,10 @@ log_reboot(enum hal_reset_reason reason)
 #endif
 
     if (reason == HAL_RESET_REQUESTED) {
+        /*
+         * About to reset; don't lose config saves still held in RAM.
+         */
+        conf_save_flush();
         conf_save_one("reboot/soft_reboot", "1");
     } else {
         conf_save_one("reboot/soft_reboot", "0");
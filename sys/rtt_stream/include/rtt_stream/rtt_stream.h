@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __RTT_STREAM_H__
+#define __RTT_STREAM_H__
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct cbmem;
+struct log;
+
+/*
+ * RTT stream: a dedicated RTT up-buffer ("Stream") carrying binary records.
+ * Data is copied straight from where it lives (log entry, cbmem, trace ring,
+ * stats group) into the RTT buffer, with no formatting and no intermediate
+ * buffer.  A record is written whole or dropped; the sequence number lets
+ * the host spot drops.
+ *
+ * Every record starts with struct rtt_stream_hdr (target byte order),
+ * followed by rsh_len bytes of payload:
+ *
+ *  RTT_STREAM_TYPE_LOG:    struct log_entry_hdr, then the entry body.
+ *  RTT_STREAM_TYPE_CBMEM:  one raw cbmem entry (for log_cbmem logs, this is
+ *                          the same as a LOG payload).
+ *  RTT_STREAM_TYPE_TRACE:  one or more struct os_trace_rec.
+ *  RTT_STREAM_TYPE_STATS:  struct rtt_stream_stats_hdr, the group name
+ *                          (rss_name_len bytes, no terminator), then
+ *                          rss_cnt counters of rss_size bytes each.
+ */
+#define RTT_STREAM_TYPE_LOG         (1)
+#define RTT_STREAM_TYPE_CBMEM       (2)
+#define RTT_STREAM_TYPE_TRACE       (3)
+#define RTT_STREAM_TYPE_STATS       (4)
+
+struct rtt_stream_hdr {
+    uint16_t rsh_len;
+    uint8_t rsh_type;
+    uint8_t _pad;
+    /* Incremented for every record, including dropped ones */
+    uint32_t rsh_seq;
+};
+
+struct rtt_stream_stats_hdr {
+    uint8_t rss_size;
+    uint8_t rss_cnt;
+    uint8_t rss_name_len;
+    uint8_t _pad;
+};
+
+struct rtt_stream_iov {
+    const void *rsi_base;
+    uint16_t rsi_len;
+};
+
+/**
+ * Writes one record made up of several pieces.  Callable from interrupt
+ * context.
+ *
+ * @param type                  RTT_STREAM_TYPE_*, or an application value
+ *                                  of 128 or more.
+ * @param iov                   Pieces of the payload, in order.
+ * @param iovcnt                Number of pieces.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOMEM if the record did not fit and
+ *                                  was dropped;
+ *                              SYS_EINVAL if the payload is too long.
+ */
+int rtt_stream_writev(uint8_t type, const struct rtt_stream_iov *iov,
+                      int iovcnt);
+
+/**
+ * Writes one record with a contiguous payload.  See rtt_stream_writev().
+ */
+int rtt_stream_write(uint8_t type, const void *data, uint16_t len);
+
+/**
+ * Sends every entry in a cbmem, oldest first, as RTT_STREAM_TYPE_CBMEM
+ * records.  Stops at the first record that does not fit.
+ *
+ * @return                      0 if all entries were sent;
+ *                              SYS_ENOMEM if the buffer filled up.
+ */
+int rtt_stream_cbmem(struct cbmem *cbmem);
+
+#if MYNEWT_VAL(RTT_STREAM_STATS_ITVL)
+/**
+ * Sends all registered stats groups as RTT_STREAM_TYPE_STATS records.
+ *
+ * @return                      0 if all groups were sent;
+ *                              SYS_ENOMEM if the buffer filled up.
+ */
+int rtt_stream_stats(void);
+#endif
+
+#if MYNEWT_VAL(RTT_STREAM_LOG)
+/**
+ * Returns the "rtt_stream" log.
+ */
+struct log *rtt_stream_log_get(void);
+#endif
+
+/**
+ * Returns the number of records dropped because the buffer was full.
+ */
+uint32_t rtt_stream_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTT_STREAM_H__ */
@@ -0,0 +1,338 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "rtt/SEGGER_RTT.h"
+#include "cbmem/cbmem.h"
+#include "rtt_stream/rtt_stream.h"
+#if MYNEWT_VAL(RTT_STREAM_LOG)
+#include "log/log.h"
+#endif
+#if MYNEWT_VAL(RTT_STREAM_STATS_ITVL)
+#include "stats/stats.h"
+#endif
+
+#define RTT_STREAM_TRACE    (MYNEWT_VAL(RTT_STREAM_TRACE_ITVL) && \
+                             MYNEWT_VAL(OS_TRACE_RING))
+
+/* Trace records sent per RTT record */
+#define RTT_STREAM_TRACE_BATCH  (8)
+
+static uint8_t rtt_stream_buf[MYNEWT_VAL(RTT_STREAM_BUFFER_SIZE)];
+static int rtt_stream_idx = -1;
+static uint32_t rtt_stream_seq;
+static uint32_t rtt_stream_drops;
+
+#if RTT_STREAM_TRACE
+static struct os_callout rtt_stream_trace_co;
+static uint32_t rtt_stream_trace_seq;
+#endif
+
+#if MYNEWT_VAL(RTT_STREAM_STATS_ITVL)
+static struct os_callout rtt_stream_stats_co;
+#endif
+
+/* Free space in the up-buffer; one byte always stays unused. */
+static unsigned
+rtt_stream_space(void)
+{
+    SEGGER_RTT_BUFFER_UP *up;
+    unsigned rd;
+    unsigned wr;
+
+    up = &_SEGGER_RTT.aUp[rtt_stream_idx];
+    rd = up->RdOff;
+    wr = up->WrOff;
+
+    if (rd > wr) {
+        return rd - wr - 1;
+    }
+    return up->SizeOfBuffer - (wr - rd) - 1;
+}
+
+int
+rtt_stream_writev(uint8_t type, const struct rtt_stream_iov *iov, int iovcnt)
+{
+    struct rtt_stream_hdr hdr;
+    uint32_t len;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    if (rtt_stream_idx < 0) {
+        return SYS_ENOMEM;
+    }
+
+    len = 0;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].rsi_len;
+    }
+    if (len > UINT16_MAX) {
+        return SYS_EINVAL;
+    }
+
+    hdr.rsh_len = len;
+    hdr.rsh_type = type;
+    hdr._pad = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    hdr.rsh_seq = rtt_stream_seq++;
+    if (rtt_stream_space() < sizeof(hdr) + len) {
+        rtt_stream_drops++;
+        rc = SYS_ENOMEM;
+    } else {
+        SEGGER_RTT_WriteNoLock(rtt_stream_idx, &hdr, sizeof(hdr));
+        for (i = 0; i < iovcnt; i++) {
+            SEGGER_RTT_WriteNoLock(rtt_stream_idx, iov[i].rsi_base,
+                                   iov[i].rsi_len);
+        }
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+int
+rtt_stream_write(uint8_t type, const void *data, uint16_t len)
+{
+    struct rtt_stream_iov iov = {
+        .rsi_base = data,
+        .rsi_len = len,
+    };
+
+    return rtt_stream_writev(type, &iov, 1);
+}
+
+uint32_t
+rtt_stream_dropped(void)
+{
+    return rtt_stream_drops;
+}
+
+static int
+rtt_stream_cbmem_walk(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+                      void *arg)
+{
+    int *rc;
+
+    rc = arg;
+
+    /* Entries are contiguous in the cbmem buffer, send them from there */
+    *rc = rtt_stream_write(RTT_STREAM_TYPE_CBMEM, hdr + 1, hdr->ceh_len);
+    if (*rc != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+rtt_stream_cbmem(struct cbmem *cbmem)
+{
+    int walk_rc;
+    int rc;
+
+    walk_rc = 0;
+    rc = cbmem_walk(cbmem, rtt_stream_cbmem_walk, &walk_rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return walk_rc;
+}
+
+#if RTT_STREAM_TRACE
+static void
+rtt_stream_trace_ev(struct os_event *ev)
+{
+    struct os_trace_rec recs[RTT_STREAM_TRACE_BATCH];
+    uint32_t seq;
+    int cnt;
+
+    while (1) {
+        seq = rtt_stream_trace_seq;
+        cnt = os_trace_ring_read(&rtt_stream_trace_seq, recs,
+                                 RTT_STREAM_TRACE_BATCH);
+        if (cnt == 0) {
+            break;
+        }
+        if (rtt_stream_write(RTT_STREAM_TYPE_TRACE, recs,
+                             cnt * sizeof(recs[0])) != 0) {
+            /* Retry these on the next run, unless overwritten by then */
+            rtt_stream_trace_seq = seq;
+            break;
+        }
+    }
+
+    os_callout_reset(&rtt_stream_trace_co,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(RTT_STREAM_TRACE_ITVL)));
+}
+#endif
+
+#if MYNEWT_VAL(RTT_STREAM_STATS_ITVL)
+static int
+rtt_stream_stats_walk(struct stats_hdr *hdr, void *arg)
+{
+    struct rtt_stream_stats_hdr shdr;
+    struct rtt_stream_iov iov[3];
+    int *rc;
+
+    rc = arg;
+
+    shdr.rss_size = hdr->s_size;
+    shdr.rss_cnt = hdr->s_cnt;
+    shdr.rss_name_len = strlen(hdr->s_name);
+    shdr._pad = 0;
+
+    iov[0].rsi_base = &shdr;
+    iov[0].rsi_len = sizeof(shdr);
+    iov[1].rsi_base = hdr->s_name;
+    iov[1].rsi_len = shdr.rss_name_len;
+    /* The counters follow the header in every stats section */
+    iov[2].rsi_base = hdr + 1;
+    iov[2].rsi_len = hdr->s_size * hdr->s_cnt;
+
+    *rc = rtt_stream_writev(RTT_STREAM_TYPE_STATS, iov, 3);
+    if (*rc != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+rtt_stream_stats(void)
+{
+    int rc;
+
+    rc = 0;
+    stats_group_walk(rtt_stream_stats_walk, &rc);
+
+    return rc;
+}
+
+static void
+rtt_stream_stats_ev(struct os_event *ev)
+{
+    rtt_stream_stats();
+
+    os_callout_reset(&rtt_stream_stats_co,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(RTT_STREAM_STATS_ITVL)));
+}
+#endif
+
+#if MYNEWT_VAL(RTT_STREAM_LOG)
+static struct log rtt_stream_log;
+
+struct log *
+rtt_stream_log_get(void)
+{
+    return &rtt_stream_log;
+}
+
+static int
+rtt_stream_log_append(struct log *log, void *buf, int len)
+{
+    return rtt_stream_write(RTT_STREAM_TYPE_LOG, buf, len);
+}
+
+static int
+rtt_stream_log_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                           const void *body, int body_len)
+{
+    struct rtt_stream_iov iov[2] = {
+        {
+            .rsi_base = hdr,
+            .rsi_len = sizeof(*hdr),
+        },
+        {
+            .rsi_base = body,
+            .rsi_len = body_len,
+        },
+    };
+
+    return rtt_stream_writev(RTT_STREAM_TYPE_LOG, iov, 2);
+}
+
+static int
+rtt_stream_log_read(struct log *log, void *dptr, void *buf, uint16_t offset,
+                    uint16_t len)
+{
+    return SYS_ENOTSUP;
+}
+
+static int
+rtt_stream_log_walk(struct log *log, log_walk_func_t walk_func,
+                    struct log_offset *log_offset)
+{
+    return SYS_ENOTSUP;
+}
+
+static int
+rtt_stream_log_flush(struct log *log)
+{
+    return SYS_ENOTSUP;
+}
+
+static const struct log_handler rtt_stream_log_handler = {
+    .log_type = LOG_TYPE_STREAM,
+    .log_read = rtt_stream_log_read,
+    .log_append = rtt_stream_log_append,
+    .log_append_body = rtt_stream_log_append_body,
+    .log_walk = rtt_stream_log_walk,
+    .log_flush = rtt_stream_log_flush,
+};
+#endif
+
+void
+rtt_stream_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rtt_stream_idx = SEGGER_RTT_AllocUpBuffer("Stream", rtt_stream_buf,
+                                              sizeof(rtt_stream_buf),
+                                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    SYSINIT_PANIC_ASSERT(rtt_stream_idx >= 0);
+
+#if MYNEWT_VAL(RTT_STREAM_LOG)
+    rc = log_register("rtt_stream", &rtt_stream_log, &rtt_stream_log_handler,
+                      NULL, MYNEWT_VAL(LOG_LEVEL));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
+#if RTT_STREAM_TRACE
+    rtt_stream_trace_seq = os_trace_ring_seq();
+    os_callout_init(&rtt_stream_trace_co, os_eventq_dflt_get(),
+                    rtt_stream_trace_ev, NULL);
+    os_callout_reset(&rtt_stream_trace_co, 0);
+#endif
+
+#if MYNEWT_VAL(RTT_STREAM_STATS_ITVL)
+    os_callout_init(&rtt_stream_stats_co, os_eventq_dflt_get(),
+                    rtt_stream_stats_ev, NULL);
+    os_callout_reset(&rtt_stream_stats_co, 0);
+#endif
+
+    (void)rc;
+}
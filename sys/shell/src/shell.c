@@ -31,6 +31,21 @@
 static struct shell_module shell_modules[MYNEWT_VAL(SHELL_MAX_MODULES)];
 static size_t num_of_shell_entities;
 
+/*
+ * Command tables may be const, so they are kept in name order through an
+ * index.  A NULL index means the table is used as is, and is sorted only
+ * if sco_sorted is set.
+ */
+struct shell_cmd_order {
+    const uint8_t *sco_idx;
+    uint8_t sco_cnt;
+    uint8_t sco_sorted;
+};
+
+static struct shell_cmd_order shell_cmd_orders[MYNEWT_VAL(SHELL_MAX_MODULES)];
+static uint8_t shell_cmd_index[MYNEWT_VAL(SHELL_CMD_INDEX_SIZE)];
+static int shell_cmd_index_used;
+
 static const char *prompt;
 static int default_module = -1;
 
@@ -120,6 +135,113 @@ line2argv(char *str, char *argv[], size_t size)
     return argc;
 }
 
+/*
+ * Compare the first len characters of name, or all of it if len is
+ * negative, to a command name.
+ */
+static int
+shell_cmd_cmp(const char *name, int len, const char *cmd)
+{
+    int rc;
+
+    if (len < 0) {
+        return strcmp(name, cmd);
+    }
+    rc = strncmp(name, cmd, len);
+    if (rc == 0 && cmd[len] != '\0') {
+        rc = -1;
+    }
+    return rc;
+}
+
+/*
+ * Index in the module's command table of the i'th command in name order,
+ * or in table order if the module's commands are not sorted.
+ */
+static int
+shell_cmd_at(int module, int i)
+{
+    const struct shell_cmd_order *sco;
+
+    sco = &shell_cmd_orders[module];
+    return sco->sco_idx ? sco->sco_idx[i] : i;
+}
+
+/*
+ * First position, in name order, of a command starting with prefix.
+ */
+static int
+shell_cmd_lower_bound(int module, const char *prefix, int len)
+{
+    const struct shell_module *shell_module;
+    const struct shell_cmd_order *sco;
+    int lo, hi, mid;
+
+    shell_module = &shell_modules[module];
+    sco = &shell_cmd_orders[module];
+    if (!sco->sco_sorted) {
+        return 0;
+    }
+
+    lo = 0;
+    hi = sco->sco_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (strncmp(shell_module->commands[shell_cmd_at(module, mid)].sc_cmd,
+                    prefix, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * Look up a command by name; only the first len characters of name are
+ * used, unless len is negative.  Returns the index of the command in the
+ * module's table, or -1.
+ */
+static int
+shell_cmd_find(int module, const char *name, int len)
+{
+    const struct shell_module *shell_module;
+    const struct shell_cmd_order *sco;
+    int lo, hi, mid;
+    int idx;
+    int rc;
+    int i;
+
+    shell_module = &shell_modules[module];
+    sco = &shell_cmd_orders[module];
+
+    if (!sco->sco_sorted) {
+        for (i = 0; i < sco->sco_cnt; i++) {
+            if (!shell_cmd_cmp(name, len, shell_module->commands[i].sc_cmd)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    lo = 0;
+    hi = sco->sco_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        idx = shell_cmd_at(module, mid);
+        rc = shell_cmd_cmp(name, len, shell_module->commands[idx].sc_cmd);
+        if (rc == 0) {
+            return idx;
+        }
+        if (rc < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return -1;
+}
+
 static int
 get_destination_module(const char *module_str, int len)
 {
@@ -204,38 +326,35 @@ show_cmd_help(char *argv[])
     }
 
     shell_module = &shell_modules[module];
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        cmd = &shell_module->commands[i];
-
-        if (!strcmp(command, cmd->sc_cmd)) {
-
-            if (!cmd->help || (!cmd->help->summary &&
-                               !cmd->help->usage &&
-                               !cmd->help->params)) {
-                console_printf("(no help available)\n");
-                return 0;
-            }
+    i = shell_cmd_find(module, command, -1);
+    if (i == -1) {
+        console_printf("Unrecognized command: %s\n", argv[0]);
+        return 0;
+    }
+    cmd = &shell_module->commands[i];
 
-            if (cmd->help->summary) {
-                console_printf("Summary:\n");
-                console_printf("%s\n", cmd->help->summary);
-            }
+    if (!cmd->help || (!cmd->help->summary &&
+                       !cmd->help->usage &&
+                       !cmd->help->params)) {
+        console_printf("(no help available)\n");
+        return 0;
+    }
 
-            if (cmd->help->usage) {
-                console_printf("Usage:\n");
-                console_printf("%s\n", cmd->help->usage);
-            }
+    if (cmd->help->summary) {
+        console_printf("Summary:\n");
+        console_printf("%s\n", cmd->help->summary);
+    }
 
-            if (cmd->help->params) {
-                console_printf("Parameters:\n");
-                print_command_params(module, i);
-            }
+    if (cmd->help->usage) {
+        console_printf("Usage:\n");
+        console_printf("%s\n", cmd->help->usage);
+    }
 
-            return 0;
-        }
+    if (cmd->help->params) {
+        console_printf("Parameters:\n");
+        print_command_params(module, i);
     }
 
-    console_printf("Unrecognized command: %s\n", argv[0]);
     return 0;
 }
 
@@ -253,15 +372,16 @@ static void
 print_module_commands(const int module)
 {
     const struct shell_module *shell_module = &shell_modules[module];
+    const struct shell_cmd *cmd;
     int i;
 
     console_printf("help\n");
 
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        console_printf("%-30s", shell_module->commands[i].sc_cmd);
-        if (shell_module->commands[i].help &&
-            shell_module->commands[i].help->summary) {
-        console_printf("%s", shell_module->commands[i].help->summary);
+    for (i = 0; i < shell_cmd_orders[module].sco_cnt; i++) {
+        cmd = &shell_module->commands[shell_cmd_at(module, i)];
+        console_printf("%-30s", cmd->sc_cmd);
+        if (cmd->help && cmd->help->summary) {
+            console_printf("%s", cmd->help->summary);
         }
         console_printf("\n");
     }
@@ -361,13 +481,12 @@ get_cb(int argc, char *argv[])
     }
 
     shell_module = &shell_modules[module];
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        if (!strcmp(command, shell_module->commands[i].sc_cmd)) {
-            return shell_module->commands[i].sc_cmd_func;
-        }
+    i = shell_cmd_find(module, command, -1);
+    if (i == -1) {
+        return NULL;
     }
 
-    return NULL;
+    return shell_module->commands[i].sc_cmd_func;
 }
 
 static void
@@ -465,21 +584,7 @@ shell(struct os_event *ev)
 static int
 get_command_from_module(const char *command, int len, int module)
 {
-    int i;
-    const struct shell_module *shell_module;
-
-    shell_module = &shell_modules[module];
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-
-        if (strlen(shell_module->commands[i].sc_cmd) != len) {
-            continue;
-        }
-
-        if (!strncmp(command, shell_module->commands[i].sc_cmd, len)) {
-            return i;
-        }
-    }
-    return -1;
+    return shell_cmd_find(module, command, len);
 }
 
 static int
@@ -595,17 +700,23 @@ complete_command(char *line, char *command_prefix,
     const char *first_match = NULL;
     int i, j, common_chars = -1, space = 0;
     const struct shell_module *module;
+    const struct shell_cmd *cmd;
 
     module = &shell_modules[module_idx];
 
-    for (i = 0; module->commands[i].sc_cmd; i++) {
-        if (strncmp(command_prefix,
-            module->commands[i].sc_cmd, command_len)) {
+    /* In a sorted module, the matches are next to each other. */
+    for (i = shell_cmd_lower_bound(module_idx, command_prefix, command_len);
+         i < shell_cmd_orders[module_idx].sco_cnt; i++) {
+        cmd = &module->commands[shell_cmd_at(module_idx, i)];
+        if (strncmp(command_prefix, cmd->sc_cmd, command_len)) {
+            if (shell_cmd_orders[module_idx].sco_sorted) {
+                break;
+            }
             continue;
         }
 
         if (!first_match) {
-            first_match = module->commands[i].sc_cmd;
+            first_match = cmd->sc_cmd;
             continue;
         }
 
@@ -618,14 +729,14 @@ complete_command(char *line, char *command_prefix,
 
         /* cut common part of matching names */
         for (j = 0; j < common_chars; j++) {
-            if (first_match[j] != module->commands[i].sc_cmd[j]) {
+            if (first_match[j] != cmd->sc_cmd[j]) {
                 break;
             }
         }
 
         common_chars = j;
 
-        console_printf("%s\n", module->commands[i].sc_cmd);
+        console_printf("%s\n", cmd->sc_cmd);
     }
 
     /* no match, do nothing */
@@ -888,6 +999,55 @@ shell_avail_queue_init(void)
     }
 }
 
+/*
+ * Build the name ordered index of a module's commands.  If there is no
+ * room for it, the module is searched linearly.
+ */
+static void
+shell_cmd_sort(int module)
+{
+    const struct shell_cmd *commands;
+    struct shell_cmd_order *sco;
+    uint8_t *idx;
+    uint8_t tmp;
+    int cnt;
+    int i, j;
+
+    commands = shell_modules[module].commands;
+    sco = &shell_cmd_orders[module];
+
+    for (cnt = 0; commands[cnt].sc_cmd; cnt++) {
+    }
+    if (cnt > UINT8_MAX) {
+        console_printf("Too many commands in module %s\n",
+                       shell_modules[module].name);
+        assert(0);
+    }
+    sco->sco_cnt = cnt;
+
+    if (shell_cmd_index_used + cnt > MYNEWT_VAL(SHELL_CMD_INDEX_SIZE)) {
+        sco->sco_idx = NULL;
+        sco->sco_sorted = 0;
+        return;
+    }
+    idx = &shell_cmd_index[shell_cmd_index_used];
+    shell_cmd_index_used += cnt;
+
+    for (i = 0; i < cnt; i++) {
+        tmp = i;
+        for (j = i; j > 0; j--) {
+            if (strcmp(commands[idx[j - 1]].sc_cmd, commands[tmp].sc_cmd) <=
+                0) {
+                break;
+            }
+            idx[j] = idx[j - 1];
+        }
+        idx[j] = tmp;
+    }
+    sco->sco_idx = idx;
+    sco->sco_sorted = 1;
+}
+
 int
 shell_register(const char *module_name, const struct shell_cmd *commands)
 {
@@ -898,6 +1058,7 @@ shell_register(const char *module_name, const struct shell_cmd *commands)
 
     shell_modules[num_of_shell_entities].name = module_name;
     shell_modules[num_of_shell_entities].commands = commands;
+    shell_cmd_sort(num_of_shell_entities);
     ++num_of_shell_entities;
 
     return 0;
@@ -907,28 +1068,44 @@ shell_register(const char *module_name, const struct shell_cmd *commands)
 #define SHELL_COMPAT_MODULE_NAME "compat"
 static struct shell_cmd compat_commands[MYNEWT_VAL(SHELL_MAX_COMPAT_COMMANDS) + 1];
 static int num_compat_commands;
-static int module_registered;
+static int compat_module = -1;
 
 int
 shell_cmd_register(const struct shell_cmd *sc)
 {
+    struct shell_cmd_order *sco;
+    int i;
+
     if (num_compat_commands >= MYNEWT_VAL(SHELL_MAX_COMPAT_COMMANDS)) {
         console_printf("Max number of compat commands reached\n");
         assert(0);
     }
 
-    if (!module_registered) {
+    if (compat_module == -1) {
+        compat_module = num_of_shell_entities;
         shell_register(SHELL_COMPAT_MODULE_NAME, compat_commands);
         set_default_module(SHELL_COMPAT_MODULE_NAME);
-        module_registered = 1;
     }
 
-    compat_commands[num_compat_commands].sc_cmd = sc->sc_cmd;
-    compat_commands[num_compat_commands].sc_cmd_func = sc->sc_cmd_func;
+    /* Keep the table itself in name order. */
+    for (i = num_compat_commands; i > 0; i--) {
+        if (strcmp(compat_commands[i - 1].sc_cmd, sc->sc_cmd) <= 0) {
+            break;
+        }
+        compat_commands[i] = compat_commands[i - 1];
+    }
+    memset(&compat_commands[i], 0, sizeof(compat_commands[i]));
+    compat_commands[i].sc_cmd = sc->sc_cmd;
+    compat_commands[i].sc_cmd_func = sc->sc_cmd_func;
 #if MYNEWT_VAL(SHELL_CMD_HELP)
-    compat_commands[num_compat_commands].help = sc->help;
+    compat_commands[i].help = sc->help;
 #endif
     ++num_compat_commands;
+
+    sco = &shell_cmd_orders[compat_module];
+    sco->sco_idx = NULL;
+    sco->sco_cnt = num_compat_commands;
+    sco->sco_sorted = 1;
     return 0;
 }
 #endif
@@ -23,6 +23,7 @@
 #include <stddef.h>
 #include "base64/base64.h"
 #include "crc/crc16.h"
+#include "crc/crc_mbuf.h"
 #include "console/console.h"
 #include "shell/shell.h"
 #include "shell_priv.h"
@@ -48,7 +49,6 @@ shell_nlip_process(char *data, int len)
 {
     uint16_t copy_len;
     int rc;
-    struct os_mbuf *m;
     uint16_t crc;
 
     rc = base64_decode(data, data);
@@ -86,9 +86,8 @@ shell_nlip_process(char *data, int len)
     if (OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len == g_nlip_expected_len) {
         if (g_shell_nlip_in_func) {
             crc = CRC16_INITIAL_CRC;
-            for (m = g_nlip_mbuf; m; m = SLIST_NEXT(m, om_next)) {
-                crc = crc16_ccitt(crc, m->om_data, m->om_len);
-            }
+            crc16_ccitt_mbuf(&crc, g_nlip_mbuf, 0,
+                             OS_MBUF_PKTLEN(g_nlip_mbuf));
             if (crc == 0 && g_nlip_expected_len >= sizeof(crc)) {
                 os_mbuf_adj(g_nlip_mbuf, -sizeof(crc));
                 g_shell_nlip_in_func(g_nlip_mbuf, g_shell_nlip_in_arg);
@@ -124,7 +123,6 @@ shell_nlip_mtx(struct os_mbuf *m)
     uint16_t nwritten;
     uint16_t linelen;
     int rc;
-    struct os_mbuf *tmp;
     void *ptr;
 
     /* Convert the mbuf into a packet.
@@ -141,9 +139,7 @@ shell_nlip_mtx(struct os_mbuf *m)
      * buffer has been sent.
      */
     crc = CRC16_INITIAL_CRC;
-    for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
-        crc = crc16_ccitt(crc, tmp->om_data, tmp->om_len);
-    }
+    crc16_ccitt_mbuf(&crc, m, 0, OS_MBUF_PKTLEN(m));
     crc = htons(crc);
     ptr = os_mbuf_extend(m, sizeof(crc));
     if (!ptr) {
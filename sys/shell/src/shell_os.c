@@ -31,11 +31,28 @@
 
 #define SHELL_OS "os"
 
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+/* Share of part in total, in tenths of a percent. */
+static unsigned long
+shell_os_permille(uint64_t part, uint64_t total)
+{
+    if (total == 0) {
+        return 0;
+    }
+    return (unsigned long)(part * 1000 / total);
+}
+#endif
+
 int
 shell_os_tasks_display_cmd(int argc, char **argv)
 {
     struct os_task *prev_task;
     struct os_task_info oti;
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    uint64_t isr_cputime;
+    uint64_t total;
+    unsigned long load;
+#endif
     char *name;
     int found;
 
@@ -46,11 +63,29 @@ shell_os_tasks_display_cmd(int argc, char **argv)
         name = argv[1];
     }
 
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    /* Loads are relative to all time accounted since boot. */
+    isr_cputime = os_sched_isr_cputime();
+    total = isr_cputime;
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+        total += oti.oti_run_cputime;
+    }
+#endif
+
     console_printf("Tasks: \n");
     prev_task = NULL;
-    console_printf("%8s %3s %3s %8s %8s %8s %8s %8s %8s %3s\n",
+    console_printf("%8s %3s %3s %8s %8s %8s %8s %8s %8s %3s",
       "task", "pri", "tid", "runtime", "csw", "stksz", "stkuse",
       "lcheck", "ncheck", "flg");
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    console_printf(" %6s", "load");
+#endif
+    console_printf("\n");
     while (1) {
         prev_task = os_task_info_get_next(prev_task, &oti);
         if (prev_task == NULL) {
@@ -65,14 +100,26 @@ shell_os_tasks_display_cmd(int argc, char **argv)
             }
         }
 
-        console_printf("%8s %3u %3u %8lu %8lu %8u %8u %8lu %8lu\n",
+        console_printf("%8s %3u %3u %8lu %8lu %8u %8u %8lu %8lu",
                 oti.oti_name, oti.oti_prio, oti.oti_taskid,
                 (unsigned long)oti.oti_runtime, (unsigned long)oti.oti_cswcnt,
                 oti.oti_stksize, oti.oti_stkusage,
                 (unsigned long)oti.oti_last_checkin,
                 (unsigned long)oti.oti_next_checkin);
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+        load = shell_os_permille(oti.oti_run_cputime, total);
+        console_printf("     %3lu.%lu%%", load / 10, load % 10);
+#endif
+        console_printf("\n");
+    }
 
+#if MYNEWT_VAL(OS_TASK_RUN_TIME_CPUTIME)
+    if (!name) {
+        load = shell_os_permille(isr_cputime, total);
+        console_printf("%8s %76s %3lu.%lu%%\n", "isr", "", load / 10,
+                       load % 10);
     }
+#endif
 
     if (name && !found) {
         console_printf("Couldn't find task with name %s\n", name);
@@ -127,6 +174,205 @@ shell_os_mpool_display_cmd(int argc, char **argv)
     return 0;
 }
 
+#if MYNEWT_VAL(OS_MSYS_STATS)
+int
+shell_os_msys_display_cmd(int argc, char **argv)
+{
+    struct os_msys_stats oms;
+    struct os_mbuf_pool *omp;
+    struct os_mempool *mp;
+    uint32_t total;
+    uint32_t sum;
+    int used_max;
+    int i;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_msys_stats_reset();
+        return 0;
+    }
+
+    console_printf("Msys pools: \n");
+    console_printf("%5s %4s %4s %4s %8s %8s %8s  %s\n", "bufsz", "cnt",
+                   "free", "min", "req", "fallback", "fail", "hint");
+    omp = NULL;
+    while (1) {
+        omp = os_msys_pool_next(omp);
+        if (omp == NULL) {
+            break;
+        }
+
+        mp = omp->omp_pool;
+        console_printf("%5u %4u %4u %4u %8lu %8lu %8lu  ",
+                       omp->omp_databuf_len, mp->mp_num_blocks,
+                       mp->mp_num_free, mp->mp_min_free,
+                       (unsigned long)omp->omp_msys_req,
+                       (unsigned long)omp->omp_msys_fallback,
+                       (unsigned long)omp->omp_msys_fail);
+
+        /* Suggest a block count from the pool's low water mark. */
+        used_max = mp->mp_num_blocks - mp->mp_min_free;
+        if (omp->omp_msys_fallback != 0 || omp->omp_msys_fail != 0) {
+            console_printf("exhausted, raise count above %u\n",
+                           mp->mp_num_blocks);
+        } else if (mp->mp_min_free > 1) {
+            console_printf("count %d would do\n", used_max + 1);
+        } else {
+            console_printf("-\n");
+        }
+    }
+
+    os_msys_stats_get(&oms);
+    total = 0;
+    for (i = 0; i < OS_MSYS_HIST_BUCKETS; i++) {
+        total += oms.oms_hist[i];
+    }
+
+    console_printf("Request sizes (max %u): \n", oms.oms_size_max);
+    sum = 0;
+    for (i = 0; i < OS_MSYS_HIST_BUCKETS; i++) {
+        if (oms.oms_hist[i] == 0) {
+            continue;
+        }
+        sum += oms.oms_hist[i];
+        if (i < OS_MSYS_HIST_BUCKETS - 1) {
+            console_printf("  < %5u", 16u << i);
+        } else {
+            console_printf(" >= %5u", 8u << i);
+        }
+        console_printf(": %8lu (%3lu%% cumulative)\n",
+                       (unsigned long)oms.oms_hist[i],
+                       (unsigned long)(sum * 100 / total));
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_LOCK_PROF)
+int
+shell_os_lockprof_display_cmd(int argc, char **argv)
+{
+    struct os_lock_prof *olp;
+    uint32_t wait_avg;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_lock_prof_reset();
+        return 0;
+    }
+
+    console_printf("Lock contention (cputime ticks): \n");
+    console_printf("%16s %8s %8s %6s %8s %8s %8s  %s\n", "name", "acq",
+                   "cont", "tmo", "wait_avg", "wait_max", "hold_max",
+                   "holder");
+    olp = NULL;
+    while (1) {
+        olp = os_lock_prof_next(olp);
+        if (olp == NULL) {
+            break;
+        }
+
+        if (olp->olp_contended != 0) {
+            wait_avg = olp->olp_wait_total / olp->olp_contended;
+        } else {
+            wait_avg = 0;
+        }
+        console_printf("%16s %8lu %8lu %6lu %8lu %8lu %8lu  %s\n",
+                       olp->olp_name,
+                       (unsigned long)olp->olp_acquired,
+                       (unsigned long)olp->olp_contended,
+                       (unsigned long)olp->olp_timeouts,
+                       (unsigned long)wait_avg,
+                       (unsigned long)olp->olp_wait_max,
+                       (unsigned long)olp->olp_hold_max,
+                       olp->olp_hold_max_task ? olp->olp_hold_max_task : "-");
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_PM)
+int
+shell_os_pm_display_cmd(int argc, char **argv)
+{
+    struct os_pm_state *ps;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_pm_stats_reset();
+        return 0;
+    }
+
+    console_printf("Sleep states: \n");
+    console_printf("%12s %8s %8s %8s %12s\n", "name", "min_tick", "entered",
+                   "dev_fail", "ticks");
+    ps = NULL;
+    while (1) {
+        ps = os_pm_state_next(ps);
+        if (ps == NULL) {
+            break;
+        }
+
+        console_printf("%12s %8lu %8lu %8lu %12llu\n", ps->ops_name,
+                       (unsigned long)ps->ops_min_ticks,
+                       (unsigned long)ps->ops_enter_cnt,
+                       (unsigned long)ps->ops_dev_fail_cnt,
+                       (unsigned long long)ps->ops_residency_ticks);
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_WORK_STATS)
+int
+shell_os_work_display_cmd(int argc, char **argv)
+{
+    struct os_work_stats ows;
+    uint32_t avg;
+    int prio;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_work_stats_reset();
+        return 0;
+    }
+
+    console_printf("Work latency (cputime ticks): \n");
+    console_printf("%4s %8s %8s %8s\n", "prio", "runs", "avg", "max");
+    for (prio = 0; os_work_stats_get(prio, &ows) == 0; prio++) {
+        if (ows.ows_runs != 0) {
+            avg = ows.ows_latency_total / ows.ows_runs;
+        } else {
+            avg = 0;
+        }
+        console_printf("%4d %8lu %8lu %8lu\n", prio,
+                       (unsigned long)ows.ows_runs, (unsigned long)avg,
+                       (unsigned long)ows.ows_latency_max);
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+int
+shell_os_sysinit_display_cmd(int argc, char **argv)
+{
+    const struct sysinit_profile_entry *spe;
+    int i;
+
+    console_printf("Boot profile (usec): \n");
+    console_printf("%10s %10s %5s %s\n", "start", "dur", "async", "name");
+    for (i = 0; (spe = sysinit_profile_get(i)) != NULL; i++) {
+        console_printf("%10lu %10lu %5d %s\n",
+                       (unsigned long)spe->spe_start_us,
+                       (unsigned long)spe->spe_dur_us, spe->spe_async,
+                       spe->spe_name);
+    }
+
+    return 0;
+}
+#endif
+
 int
 shell_os_date_cmd(int argc, char **argv)
 {
@@ -196,6 +442,66 @@ static const struct shell_cmd_help mpool_help = {
     .params = mpool_params,
 };
 
+#if MYNEWT_VAL(OS_MSYS_STATS)
+static const struct shell_param msys_params[] = {
+    {"reset", "clear the statistics"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help msys_help = {
+    .summary = "show msys usage and pool sizing hints",
+    .usage = NULL,
+    .params = msys_params,
+};
+#endif
+
+#if MYNEWT_VAL(OS_LOCK_PROF)
+static const struct shell_param lockprof_params[] = {
+    {"reset", "clear the statistics"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help lockprof_help = {
+    .summary = "show mutex and semaphore contention",
+    .usage = NULL,
+    .params = lockprof_params,
+};
+#endif
+
+#if MYNEWT_VAL(OS_PM)
+static const struct shell_param pm_params[] = {
+    {"reset", "clear the statistics"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help pm_help = {
+    .summary = "show sleep state residency",
+    .usage = NULL,
+    .params = pm_params,
+};
+#endif
+
+#if MYNEWT_VAL(OS_WORK_STATS)
+static const struct shell_param work_params[] = {
+    {"reset", "clear the statistics"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help work_help = {
+    .summary = "show deferred work latency",
+    .usage = NULL,
+    .params = work_params,
+};
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+static const struct shell_cmd_help sysinit_help = {
+    .summary = "show how long system initialization took",
+    .usage = NULL,
+    .params = NULL,
+};
+#endif
+
 static const struct shell_param date_params[] = {
     {"", "datetime to set"},
     {NULL, NULL}
@@ -236,6 +542,51 @@ static const struct shell_cmd os_commands[] = {
         .help = &mpool_help,
 #endif
     },
+#if MYNEWT_VAL(OS_MSYS_STATS)
+    {
+        .sc_cmd = "msys",
+        .sc_cmd_func = shell_os_msys_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &msys_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_LOCK_PROF)
+    {
+        .sc_cmd = "lockprof",
+        .sc_cmd_func = shell_os_lockprof_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &lockprof_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_PM)
+    {
+        .sc_cmd = "pm",
+        .sc_cmd_func = shell_os_pm_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &pm_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_WORK_STATS)
+    {
+        .sc_cmd = "work",
+        .sc_cmd_func = shell_os_work_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &work_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    {
+        .sc_cmd = "sysinit",
+        .sc_cmd_func = shell_os_sysinit_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &sysinit_help,
+#endif
+    },
+#endif
     {
         .sc_cmd = "date",
         .sc_cmd_func = shell_os_date_cmd,
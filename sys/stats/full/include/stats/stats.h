@@ -130,6 +130,20 @@ int stats_group_walk(stats_group_walk_func_t, void *);
 
 struct stats_hdr *stats_group_find(char *name);
 
+#if MYNEWT_VAL(STATS_SNAP)
+typedef int (*stats_snap_delta_func_t)(struct stats_hdr *, void *, char *,
+        uint16_t, uint64_t);
+int stats_snap_add(struct stats_hdr *hdr);
+int stats_snap_take(uint32_t *out_seq);
+int stats_snap_delta(struct stats_hdr *hdr, uint32_t from_seq,
+                     uint32_t to_seq, stats_snap_delta_func_t func, void *arg,
+                     uint32_t *out_elapsed_ms);
+#endif
+
+#if MYNEWT_VAL(STATS_PERSIST)
+void stats_persist_save(void);
+#endif
+
 /* Private */
 #if MYNEWT_VAL(STATS_NEWTMGR)
 int stats_nmgr_register_group(void);
@@ -137,6 +151,13 @@ int stats_nmgr_register_group(void);
 #if MYNEWT_VAL(STATS_CLI)
 int stats_shell_register(void);
 #endif
+#if MYNEWT_VAL(STATS_SNAP)
+void stats_snap_init(void);
+#endif
+#if MYNEWT_VAL(STATS_PERSIST)
+void stats_persist_init(void);
+void stats_persist_restore(struct stats_hdr *hdr);
+#endif
 
 #ifdef __cplusplus
 }
@@ -175,6 +175,14 @@ stats_module_init(void)
 
     STAILQ_INIT(&g_stats_registry);
 
+#if MYNEWT_VAL(STATS_SNAP)
+    stats_snap_init();
+#endif
+
+#if MYNEWT_VAL(STATS_PERSIST)
+    stats_persist_init();
+#endif
+
 #if MYNEWT_VAL(STATS_CLI)
     rc = stats_shell_register();
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -310,6 +318,13 @@ stats_register(char *name, struct stats_hdr *shdr)
 
     STATS_INC(g_stats_stats, num_registered);
 
+#if MYNEWT_VAL(STATS_PERSIST)
+    /* The registration count is rebuilt on every boot. */
+    if (shdr != STATS_HDR(g_stats_stats)) {
+        stats_persist_restore(shdr);
+    }
+#endif
+
     return (0);
 err:
     return (rc);
@@ -33,47 +33,197 @@
  */
 static int stats_nmgr_read(struct mgmt_cbuf *cb);
 static int stats_nmgr_list(struct mgmt_cbuf *cb);
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+static int stats_nmgr_schema(struct mgmt_cbuf *cb);
+#endif
 
 static struct mgmt_group shell_nmgr_group;
 
 #define STATS_NMGR_ID_READ  (0)
 #define STATS_NMGR_ID_LIST  (1)
+#define STATS_NMGR_ID_SCHEMA (2)
 
 /* ORDER MATTERS HERE.
  * Each element represents the command ID, referenced from newtmgr.
  */
 static struct mgmt_handler shell_nmgr_group_handlers[] = {
     [STATS_NMGR_ID_READ] = {stats_nmgr_read, stats_nmgr_read},
-    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list}
+    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list},
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+    [STATS_NMGR_ID_SCHEMA] = {stats_nmgr_schema, stats_nmgr_schema},
+#endif
 };
 
-static int
-stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
+static CborError
+stats_nmgr_encode_val(CborEncoder *penc, struct stats_hdr *hdr,
         uint16_t stat_off)
 {
     void *stat_val;
-    CborEncoder *penc = (CborEncoder *) arg;
-    CborError g_err = CborNoError;
 
     stat_val = (uint8_t *)hdr + stat_off;
 
-    g_err |= cbor_encode_text_stringz(penc, sname);
-
     switch (hdr->s_size) {
         case sizeof(uint16_t):
-            g_err |= cbor_encode_uint(penc, *(uint16_t *) stat_val);
-            break;
+            return cbor_encode_uint(penc, *(uint16_t *) stat_val);
         case sizeof(uint32_t):
-            g_err |= cbor_encode_uint(penc, *(uint32_t *) stat_val);
-            break;
+            return cbor_encode_uint(penc, *(uint32_t *) stat_val);
         case sizeof(uint64_t):
-            g_err |= cbor_encode_uint(penc, *(uint64_t *) stat_val);
-            break;
+            return cbor_encode_uint(penc, *(uint64_t *) stat_val);
+    }
+
+    return CborNoError;
+}
+
+static int
+stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    CborEncoder *penc = (CborEncoder *) arg;
+    CborError g_err = CborNoError;
+
+    g_err |= cbor_encode_text_stringz(penc, sname);
+    g_err |= stats_nmgr_encode_val(penc, hdr, stat_off);
+
+    return (g_err);
+}
+
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+static int
+stats_nmgr_val_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    return stats_nmgr_encode_val(arg, hdr, stat_off);
+}
+
+static int
+stats_nmgr_field_name_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    return cbor_encode_text_stringz(arg, sname);
+}
+
+static int
+stats_nmgr_hash_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    uint32_t *hash = arg;
+
+    /* FNV-1a, including the terminator so that names can't run together. */
+    do {
+        *hash = (*hash ^ (uint8_t)*sname) * 16777619;
+    } while (*sname++ != '\0');
+
+    return 0;
+}
+
+/**
+ * Hashes the layout of a group: the counter size and the name of each
+ * counter in order.  A client which has fetched the names for a hash can
+ * decode compact reads carrying the same hash.
+ */
+static uint32_t
+stats_nmgr_schema_hash(struct stats_hdr *hdr)
+{
+    uint32_t hash;
+
+    hash = (2166136261 ^ hdr->s_size) * 16777619;
+    stats_walk(hdr, stats_nmgr_hash_func, &hash);
+
+    return hash;
+}
+#endif
+
+#if MYNEWT_VAL(STATS_SNAP)
+struct stats_nmgr_delta_arg {
+    CborEncoder *penc;
+    uint32_t elapsed_ms;
+    bool compact;
+};
+
+static CborError
+stats_nmgr_encode_key(struct stats_nmgr_delta_arg *sda,
+        struct stats_hdr *hdr, char *sname, uint16_t stat_off)
+{
+    /* Compact reads key counters by their index in the group. */
+    if (sda->compact) {
+        return cbor_encode_uint(sda->penc,
+                                (stat_off - sizeof(*hdr)) / hdr->s_size);
     }
+    return cbor_encode_text_stringz(sda->penc, sname);
+}
+
+static int
+stats_nmgr_delta_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off, uint64_t delta)
+{
+    struct stats_nmgr_delta_arg *sda = arg;
+    CborError g_err = CborNoError;
+
+    g_err |= stats_nmgr_encode_key(sda, hdr, sname, stat_off);
+    g_err |= cbor_encode_uint(sda->penc, delta);
+
+    return (g_err);
+}
+
+static int
+stats_nmgr_rate_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off, uint64_t delta)
+{
+    struct stats_nmgr_delta_arg *sda = arg;
+    CborError g_err = CborNoError;
+
+    /* Per second, rounded down. */
+    g_err |= stats_nmgr_encode_key(sda, hdr, sname, stat_off);
+    g_err |= cbor_encode_uint(sda->penc, delta * 1000 / sda->elapsed_ms);
 
     return (g_err);
 }
 
+/**
+ * Encodes the counters which changed between two snapshots and, if
+ * requested, their per-second rates.
+ */
+static int
+stats_nmgr_encode_delta(struct mgmt_cbuf *cb, struct stats_hdr *hdr,
+        uint32_t since, uint32_t seq, uint32_t elapsed_ms, bool rates,
+        bool compact)
+{
+    struct stats_nmgr_delta_arg sda;
+    CborError g_err = CborNoError;
+    CborEncoder stats;
+
+    sda.penc = &stats;
+    sda.elapsed_ms = elapsed_ms;
+    sda.compact = compact;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "snap");
+    g_err |= cbor_encode_uint(&cb->encoder, seq);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "elapsed_ms");
+    g_err |= cbor_encode_uint(&cb->encoder, elapsed_ms);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "fields");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &stats,
+                                     CborIndefiniteLength);
+    stats_snap_delta(hdr, since, seq, stats_nmgr_delta_func, &sda, NULL);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &stats);
+
+    if (rates && elapsed_ms != 0) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "rates");
+        g_err |= cbor_encoder_create_map(&cb->encoder, &stats,
+                                         CborIndefiniteLength);
+        stats_snap_delta(hdr, since, seq, stats_nmgr_rate_func, &sda, NULL);
+        g_err |= cbor_encoder_close_container(&cb->encoder, &stats);
+    }
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return (0);
+}
+#endif
+
 static int
 stats_nmgr_encode_name(struct stats_hdr *hdr, void *arg)
 {
@@ -88,9 +238,29 @@ stats_nmgr_read(struct mgmt_cbuf *cb)
     struct stats_hdr *hdr;
 #define STATS_NMGR_NAME_LEN (32)
     char stats_name[STATS_NMGR_NAME_LEN];
+#if MYNEWT_VAL(STATS_SNAP)
+    uint64_t since = 0;
+    bool rates = false;
+    uint32_t elapsed_ms;
+    uint32_t seq;
+    int rc;
+#endif
+#if MYNEWT_VAL(STATS_SNAP) || MYNEWT_VAL(STATS_NMGR_COMPACT)
+    bool compact = false;
+#endif
     struct cbor_attr_t attrs[] = {
         { "name", CborAttrTextStringType, .addr.string = &stats_name[0],
             .len = sizeof(stats_name) },
+#if MYNEWT_VAL(STATS_SNAP)
+        { "since", CborAttrUnsignedIntegerType, .addr.uinteger = &since,
+            .nodefault = true },
+        { "rates", CborAttrBooleanType, .addr.boolean = &rates,
+            .nodefault = true },
+#endif
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+        { "compact", CborAttrBooleanType, .addr.boolean = &compact,
+            .nodefault = true },
+#endif
         { NULL },
     };
     CborError g_err = CborNoError;
@@ -106,6 +276,25 @@ stats_nmgr_read(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
 
+#if MYNEWT_VAL(STATS_SNAP)
+    /* A "since" read is answered with the counters which changed since that
+     * snapshot.  A new snapshot is taken for the client to pass as "since"
+     * next time, so that consecutive reads neither miss nor repeat counts.
+     */
+    if (since != 0) {
+        if (since > UINT32_MAX) {
+            return MGMT_ERR_EINVAL;
+        }
+        rc = stats_snap_take(&seq);
+        if (rc == 0) {
+            rc = stats_snap_delta(hdr, since, seq, NULL, NULL, &elapsed_ms);
+        }
+        if (rc != 0) {
+            return MGMT_ERR_ENOENT;
+        }
+    }
+#endif
+
     g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
     g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
 
@@ -115,6 +304,42 @@ stats_nmgr_read(struct mgmt_cbuf *cb)
     g_err |= cbor_encode_text_stringz(&cb->encoder, "group");
     g_err |= cbor_encode_text_string(&cb->encoder, "sys", sizeof("sys")-1);
 
+#if MYNEWT_VAL(STATS_SNAP)
+    if (since != 0) {
+        if (g_err) {
+            return MGMT_ERR_ENOMEM;
+        }
+        return stats_nmgr_encode_delta(cb, hdr, since, seq, elapsed_ms,
+                                       rates, compact);
+    }
+
+    /* Give the client a starting point for its first "since" read. */
+    if (stats_snap_take(&seq) == 0) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "snap");
+        g_err |= cbor_encode_uint(&cb->encoder, seq);
+    }
+#endif
+
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+    /* Values only, in group order; the names are fetched once with the
+     * schema command and matched up by hash.
+     */
+    if (compact) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "schema");
+        g_err |= cbor_encode_uint(&cb->encoder, stats_nmgr_schema_hash(hdr));
+
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "vals");
+        g_err |= cbor_encoder_create_array(&cb->encoder, &stats, hdr->s_cnt);
+        stats_walk(hdr, stats_nmgr_val_func, &stats);
+        g_err |= cbor_encoder_close_container(&cb->encoder, &stats);
+
+        if (g_err) {
+            return MGMT_ERR_ENOMEM;
+        }
+        return (0);
+    }
+#endif
+
     g_err |= cbor_encode_text_stringz(&cb->encoder, "fields");
 
     g_err |= cbor_encoder_create_map(&cb->encoder, &stats,
@@ -151,6 +376,54 @@ stats_nmgr_list(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(STATS_NMGR_COMPACT)
+static int
+stats_nmgr_schema(struct mgmt_cbuf *cb)
+{
+    struct stats_hdr *hdr;
+    char stats_name[STATS_NMGR_NAME_LEN];
+    struct cbor_attr_t attrs[] = {
+        { "name", CborAttrTextStringType, .addr.string = &stats_name[0],
+            .len = sizeof(stats_name) },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    CborEncoder names;
+
+    g_err = cbor_read_object(&cb->it, attrs);
+    if (g_err != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    hdr = stats_group_find(stats_name);
+    if (!hdr) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "name");
+    g_err |= cbor_encode_text_stringz(&cb->encoder, stats_name);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "schema");
+    g_err |= cbor_encode_uint(&cb->encoder, stats_nmgr_schema_hash(hdr));
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "size");
+    g_err |= cbor_encode_uint(&cb->encoder, hdr->s_size);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "fields");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &names, hdr->s_cnt);
+    stats_walk(hdr, stats_nmgr_field_name_func, &names);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &names);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
 /**
  * Register nmgr group handlers
  */
@@ -0,0 +1,326 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(STATS_PERSIST)
+
+#include "bsp/bsp.h"
+#include "crc/crc16.h"
+#include "stats/stats.h"
+#if MYNEWT_VAL(STATS_PERSIST_FLASH)
+#include "flash_map/flash_map.h"
+#endif
+
+/**
+ * Statistics that survive a warm reset.
+ *
+ * The counters of all registered groups are copied every
+ * STATS_PERSIST_INTERVAL ms into an image in RAM that is not cleared at
+ * startup.  Increments themselves cost nothing extra.  After a reset, each
+ * group picks its values back up from the image when it is registered,
+ * provided the image's CRC is good and the group still has the same name
+ * and layout.  The image stays untouched until the first copy after
+ * startup, so groups registered later than that start from zero.
+ *
+ * With STATS_PERSIST_FLASH, the image is also appended to a flash area
+ * every STATS_PERSIST_FLASH_INTERVAL ms, but only if it changed since the
+ * last write.  After a cold start, the newest good image in flash is used
+ * instead.
+ *
+ * Each group is stored as a record:
+ *     name length (1), entry size (1), entry count (1), name, values.
+ */
+
+#define STATS_PERSIST_MAGIC     0x53545053  /* "STPS" */
+
+struct stats_persist_img {
+    uint32_t spi_magic;
+    uint16_t spi_len;
+    uint16_t spi_crc;
+    uint8_t spi_data[MYNEWT_VAL(STATS_PERSIST_BUF_SIZE)];
+};
+
+#ifndef bssnz_t
+#define bssnz_t
+#endif
+
+static struct stats_persist_img stats_persist_img bssnz_t;
+
+/* Whether stats_persist_img still holds the values from before the reset. */
+static bool stats_persist_restoring;
+
+static struct os_callout stats_persist_callout;
+
+#if MYNEWT_VAL(STATS_PERSIST_FLASH)
+static struct os_callout stats_persist_flash_callout;
+static uint32_t stats_persist_flash_slot_size;
+static int stats_persist_flash_next;
+static uint16_t stats_persist_flash_crc;
+#endif
+
+static uint16_t
+stats_persist_crc(const struct stats_persist_img *img)
+{
+    uint16_t crc;
+
+    crc = crc16_ccitt(0, &img->spi_len, sizeof(img->spi_len));
+    return crc16_ccitt(crc, img->spi_data, img->spi_len);
+}
+
+static bool
+stats_persist_valid(const struct stats_persist_img *img)
+{
+    return img->spi_magic == STATS_PERSIST_MAGIC &&
+           img->spi_len <= sizeof(img->spi_data) &&
+           img->spi_crc == stats_persist_crc(img);
+}
+
+static uint16_t
+stats_persist_group_len(const struct stats_hdr *hdr)
+{
+    return hdr->s_size * hdr->s_cnt;
+}
+
+static int
+stats_persist_save_group(struct stats_hdr *hdr, void *arg)
+{
+    uint16_t name_len;
+    uint16_t *len;
+    uint8_t *p;
+
+    len = arg;
+    name_len = strlen(hdr->s_name);
+    if (name_len > UINT8_MAX ||
+        *len + 3 + name_len + stats_persist_group_len(hdr) >
+        sizeof(stats_persist_img.spi_data)) {
+        /* Doesn't fit; keep going, a smaller group might. */
+        return 0;
+    }
+
+    p = stats_persist_img.spi_data + *len;
+    p[0] = name_len;
+    p[1] = hdr->s_size;
+    p[2] = hdr->s_cnt;
+    memcpy(p + 3, hdr->s_name, name_len);
+    memcpy(p + 3 + name_len, hdr + 1, stats_persist_group_len(hdr));
+    *len += 3 + name_len + stats_persist_group_len(hdr);
+
+    return 0;
+}
+
+/**
+ * Copies the counters of all registered groups into the persistent image.
+ * Groups that don't fit are left out.  Safe to call from a fault handler
+ * right before resetting.
+ */
+void
+stats_persist_save(void)
+{
+    uint16_t len;
+    os_sr_t sr;
+
+    len = 0;
+
+    OS_ENTER_CRITICAL(sr);
+
+    stats_persist_restoring = false;
+    stats_persist_img.spi_magic = 0;
+
+    stats_group_walk(stats_persist_save_group, &len);
+
+    stats_persist_img.spi_len = len;
+    stats_persist_img.spi_crc = stats_persist_crc(&stats_persist_img);
+    stats_persist_img.spi_magic = STATS_PERSIST_MAGIC;
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Loads a newly registered group's counters from before the reset, if the
+ * image has them.
+ */
+void
+stats_persist_restore(struct stats_hdr *hdr)
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    uint16_t name_len;
+
+    if (!stats_persist_restoring) {
+        return;
+    }
+
+    name_len = strlen(hdr->s_name);
+    p = stats_persist_img.spi_data;
+    end = p + stats_persist_img.spi_len;
+    while (p + 3 <= end && p + 3 + p[0] + p[1] * p[2] <= end) {
+        if (p[0] == name_len && p[1] == hdr->s_size && p[2] == hdr->s_cnt &&
+            !memcmp(p + 3, hdr->s_name, name_len)) {
+
+            memcpy(hdr + 1, p + 3 + name_len, stats_persist_group_len(hdr));
+            return;
+        }
+        p += 3 + p[0] + p[1] * p[2];
+    }
+}
+
+static void
+stats_persist_timer_cb(struct os_event *ev)
+{
+    stats_persist_save();
+    os_callout_reset(&stats_persist_callout,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(STATS_PERSIST_INTERVAL)));
+}
+
+#if MYNEWT_VAL(STATS_PERSIST_FLASH)
+/*
+ * Images are appended to the flash area in fixed-size slots.  The area is
+ * erased when the last slot has been used, so the newest good image is the
+ * last non-empty slot.
+ */
+static int
+stats_persist_flash_slot_cnt(const struct flash_area *fa)
+{
+    return fa->fa_size / stats_persist_flash_slot_size;
+}
+
+static void
+stats_persist_flash_load(void)
+{
+    const struct flash_area *fa;
+    int cnt;
+    int rc;
+    int i;
+
+    if (flash_area_open(MYNEWT_VAL(STATS_PERSIST_FLASH_AREA), &fa) != 0) {
+        return;
+    }
+
+    stats_persist_flash_slot_size = sizeof(stats_persist_img);
+    i = flash_area_align(fa);
+    if (i > 1) {
+        stats_persist_flash_slot_size =
+            (stats_persist_flash_slot_size + i - 1) / i * i;
+    }
+
+    cnt = stats_persist_flash_slot_cnt(fa);
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_isempty_at(fa, i * stats_persist_flash_slot_size,
+                                   stats_persist_flash_slot_size);
+        if (rc != 0) {
+            break;
+        }
+    }
+    stats_persist_flash_next = i;
+
+    if (!stats_persist_restoring && i > 0) {
+        rc = flash_area_read(fa, (i - 1) * stats_persist_flash_slot_size,
+                             &stats_persist_img, sizeof(stats_persist_img));
+        if (rc == 0 && stats_persist_valid(&stats_persist_img)) {
+            stats_persist_restoring = true;
+            stats_persist_flash_crc = stats_persist_img.spi_crc;
+        }
+    }
+
+    flash_area_close(fa);
+}
+
+/**
+ * Writes the persistent image to flash, unless flash already has it.
+ *
+ * @return 0 on success; SYS_EIO on flash failure.
+ */
+static int
+stats_persist_flash_save(void)
+{
+    const struct flash_area *fa;
+    int rc;
+
+    if (stats_persist_restoring ||
+        stats_persist_img.spi_crc == stats_persist_flash_crc) {
+        return 0;
+    }
+
+    rc = flash_area_open(MYNEWT_VAL(STATS_PERSIST_FLASH_AREA), &fa);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+
+    if (stats_persist_flash_next >= stats_persist_flash_slot_cnt(fa)) {
+        rc = flash_area_erase(fa, 0, fa->fa_size);
+        if (rc != 0) {
+            rc = SYS_EIO;
+            goto done;
+        }
+        stats_persist_flash_next = 0;
+    }
+
+    rc = flash_area_write(fa,
+                          stats_persist_flash_next *
+                          stats_persist_flash_slot_size,
+                          &stats_persist_img, sizeof(stats_persist_img));
+    stats_persist_flash_next++;
+    if (rc != 0) {
+        rc = SYS_EIO;
+        goto done;
+    }
+    stats_persist_flash_crc = stats_persist_img.spi_crc;
+
+done:
+    flash_area_close(fa);
+    return rc;
+}
+
+static void
+stats_persist_flash_timer_cb(struct os_event *ev)
+{
+    stats_persist_flash_save();
+    os_callout_reset(&stats_persist_flash_callout,
+                     os_time_ms_to_ticks32(
+                         MYNEWT_VAL(STATS_PERSIST_FLASH_INTERVAL)));
+}
+#endif
+
+void
+stats_persist_init(void)
+{
+    stats_persist_restoring = stats_persist_valid(&stats_persist_img);
+
+#if MYNEWT_VAL(STATS_PERSIST_FLASH)
+    stats_persist_flash_load();
+#endif
+
+    os_callout_init(&stats_persist_callout, os_eventq_dflt_get(),
+                    stats_persist_timer_cb, NULL);
+    os_callout_reset(&stats_persist_callout,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(STATS_PERSIST_INTERVAL)));
+
+#if MYNEWT_VAL(STATS_PERSIST_FLASH)
+    os_callout_init(&stats_persist_flash_callout, os_eventq_dflt_get(),
+                    stats_persist_flash_timer_cb, NULL);
+    os_callout_reset(&stats_persist_flash_callout,
+                     os_time_ms_to_ticks32(
+                         MYNEWT_VAL(STATS_PERSIST_FLASH_INTERVAL)));
+#endif
+}
+
+#endif /* MYNEWT_VAL(STATS_PERSIST) */
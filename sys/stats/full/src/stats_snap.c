@@ -0,0 +1,303 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(STATS_SNAP)
+
+#include "stats/stats.h"
+
+/**
+ * Snapshots of selected statistics groups.
+ *
+ * Each snapshot holds the raw counter values of all selected groups, copied
+ * back to back in the order the groups were added.  Snapshots live in a
+ * small ring and are identified by a sequence number which starts at 1.
+ * Groups can only be added, so a snapshot covers the first ss_num_groups
+ * selected groups.
+ */
+struct stats_snap {
+    uint32_t ss_seq;
+    os_time_t ss_time;
+    uint8_t ss_num_groups;
+    uint8_t ss_data[MYNEWT_VAL(STATS_SNAP_BUF_SIZE)];
+};
+
+struct stats_snap_delta_arg {
+    const uint8_t *old_data;
+    const uint8_t *new_data;
+    stats_snap_delta_func_t func;
+    void *arg;
+};
+
+static struct stats_hdr *stats_snap_groups[MYNEWT_VAL(STATS_SNAP_MAX_GROUPS)];
+static uint16_t stats_snap_group_off[MYNEWT_VAL(STATS_SNAP_MAX_GROUPS)];
+static uint8_t stats_snap_num_groups;
+static uint16_t stats_snap_data_len;
+
+static struct stats_snap stats_snap_ring[MYNEWT_VAL(STATS_SNAP_CNT)];
+static uint32_t stats_snap_next_seq;
+static struct os_mutex stats_snap_mtx;
+
+#if MYNEWT_VAL(STATS_SNAP_INTERVAL) > 0
+static struct os_callout stats_snap_callout;
+#endif
+
+static uint16_t
+stats_snap_group_len(const struct stats_hdr *hdr)
+{
+    return hdr->s_size * hdr->s_cnt;
+}
+
+static struct stats_snap *
+stats_snap_find(uint32_t seq)
+{
+    struct stats_snap *snap;
+
+    snap = &stats_snap_ring[seq % MYNEWT_VAL(STATS_SNAP_CNT)];
+    if (seq == 0 || snap->ss_seq != seq) {
+        return NULL;
+    }
+
+    return snap;
+}
+
+/**
+ * Adds a statistics group to the set captured by each snapshot.
+ *
+ * @param hdr The statistics group to capture.
+ *
+ * @return 0 on success; SYS_EALREADY if the group is already selected;
+ *         SYS_ENOMEM if there is no room for it.
+ */
+int
+stats_snap_add(struct stats_hdr *hdr)
+{
+    int rc;
+    int i;
+
+    os_mutex_pend(&stats_snap_mtx, OS_TIMEOUT_NEVER);
+
+    for (i = 0; i < stats_snap_num_groups; i++) {
+        if (stats_snap_groups[i] == hdr) {
+            rc = SYS_EALREADY;
+            goto done;
+        }
+    }
+
+    if (stats_snap_num_groups >= MYNEWT_VAL(STATS_SNAP_MAX_GROUPS) ||
+        stats_snap_data_len + stats_snap_group_len(hdr) >
+        MYNEWT_VAL(STATS_SNAP_BUF_SIZE)) {
+        rc = SYS_ENOMEM;
+        goto done;
+    }
+
+    stats_snap_groups[stats_snap_num_groups] = hdr;
+    stats_snap_group_off[stats_snap_num_groups] = stats_snap_data_len;
+    stats_snap_num_groups++;
+    stats_snap_data_len += stats_snap_group_len(hdr);
+    rc = 0;
+
+done:
+    os_mutex_release(&stats_snap_mtx);
+    return rc;
+}
+
+/**
+ * Captures the selected statistics groups, replacing the oldest snapshot.
+ *
+ * @param out_seq On success, the sequence number of the new snapshot.  May
+ *                be NULL.
+ *
+ * @return 0 on success; SYS_ENOENT if no groups are selected.
+ */
+int
+stats_snap_take(uint32_t *out_seq)
+{
+    struct stats_snap *snap;
+    struct stats_hdr *hdr;
+    uint32_t seq;
+    int i;
+
+    os_mutex_pend(&stats_snap_mtx, OS_TIMEOUT_NEVER);
+
+    if (stats_snap_num_groups == 0) {
+        os_mutex_release(&stats_snap_mtx);
+        return SYS_ENOENT;
+    }
+
+    seq = ++stats_snap_next_seq;
+    if (seq == 0) {
+        seq = ++stats_snap_next_seq;
+    }
+    snap = &stats_snap_ring[seq % MYNEWT_VAL(STATS_SNAP_CNT)];
+
+    snap->ss_seq = seq;
+    snap->ss_time = os_time_get();
+    snap->ss_num_groups = stats_snap_num_groups;
+    for (i = 0; i < stats_snap_num_groups; i++) {
+        hdr = stats_snap_groups[i];
+        memcpy(snap->ss_data + stats_snap_group_off[i], hdr + 1,
+               stats_snap_group_len(hdr));
+    }
+
+    os_mutex_release(&stats_snap_mtx);
+
+    if (out_seq != NULL) {
+        *out_seq = seq;
+    }
+    return 0;
+}
+
+static uint64_t
+stats_snap_get(const uint8_t *data, uint8_t size)
+{
+    uint64_t val64;
+    uint32_t val32;
+    uint16_t val16;
+
+    switch (size) {
+    case sizeof(uint16_t):
+        memcpy(&val16, data, sizeof(val16));
+        return val16;
+    case sizeof(uint32_t):
+        memcpy(&val32, data, sizeof(val32));
+        return val32;
+    default:
+        memcpy(&val64, data, sizeof(val64));
+        return val64;
+    }
+}
+
+static int
+stats_snap_delta_walk(struct stats_hdr *hdr, void *arg, char *name,
+                      uint16_t stat_off)
+{
+    struct stats_snap_delta_arg *sda;
+    uint64_t delta;
+    uint16_t off;
+
+    sda = arg;
+    off = stat_off - sizeof(*hdr);
+
+    /* Counters wrap at their own width. */
+    delta = stats_snap_get(sda->new_data + off, hdr->s_size) -
+            stats_snap_get(sda->old_data + off, hdr->s_size);
+    if (hdr->s_size < sizeof(uint64_t)) {
+        delta &= (1ULL << (hdr->s_size * 8)) - 1;
+    }
+
+    if (delta == 0) {
+        return 0;
+    }
+    return sda->func(hdr, sda->arg, name, stat_off, delta);
+}
+
+/**
+ * Calls func for each counter in a group that changed between two
+ * snapshots, with the amount it changed by.
+ *
+ * @param hdr            The statistics group.
+ * @param from_seq       The older snapshot.
+ * @param to_seq         The newer snapshot.
+ * @param func           Called for each changed counter.  If NULL, only
+ *                       checks that the snapshots can be compared.
+ * @param arg            Passed to func.
+ * @param out_elapsed_ms On success, the time between the snapshots in
+ *                       milliseconds.  May be NULL.
+ *
+ * @return 0 on success; SYS_ENOENT if either snapshot is no longer in the
+ *         ring or doesn't cover the group; the return code of func on abort.
+ */
+int
+stats_snap_delta(struct stats_hdr *hdr, uint32_t from_seq, uint32_t to_seq,
+                 stats_snap_delta_func_t func, void *arg,
+                 uint32_t *out_elapsed_ms)
+{
+    struct stats_snap_delta_arg sda;
+    struct stats_snap *from;
+    struct stats_snap *to;
+    int rc;
+    int i;
+
+    os_mutex_pend(&stats_snap_mtx, OS_TIMEOUT_NEVER);
+
+    from = stats_snap_find(from_seq);
+    to = stats_snap_find(to_seq);
+    for (i = 0; i < stats_snap_num_groups; i++) {
+        if (stats_snap_groups[i] == hdr) {
+            break;
+        }
+    }
+    if (from == NULL || to == NULL ||
+        i >= from->ss_num_groups || i >= to->ss_num_groups) {
+        rc = SYS_ENOENT;
+        goto done;
+    }
+
+    if (out_elapsed_ms != NULL) {
+        *out_elapsed_ms = os_time_ticks_to_ms32(to->ss_time - from->ss_time);
+    }
+
+    if (func == NULL) {
+        rc = 0;
+        goto done;
+    }
+
+    sda.old_data = from->ss_data + stats_snap_group_off[i];
+    sda.new_data = to->ss_data + stats_snap_group_off[i];
+    sda.func = func;
+    sda.arg = arg;
+    rc = stats_walk(hdr, stats_snap_delta_walk, &sda);
+
+done:
+    os_mutex_release(&stats_snap_mtx);
+    return rc;
+}
+
+#if MYNEWT_VAL(STATS_SNAP_INTERVAL) > 0
+static void
+stats_snap_timer_cb(struct os_event *ev)
+{
+    stats_snap_take(NULL);
+    os_callout_reset(&stats_snap_callout,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(STATS_SNAP_INTERVAL)));
+}
+#endif
+
+void
+stats_snap_init(void)
+{
+    memset(stats_snap_ring, 0, sizeof(stats_snap_ring));
+    stats_snap_num_groups = 0;
+    stats_snap_data_len = 0;
+    stats_snap_next_seq = 0;
+    os_mutex_init(&stats_snap_mtx);
+
+#if MYNEWT_VAL(STATS_SNAP_INTERVAL) > 0
+    os_callout_init(&stats_snap_callout, os_eventq_dflt_get(),
+                    stats_snap_timer_cb, NULL);
+    os_callout_reset(&stats_snap_callout,
+                     os_time_ms_to_ticks32(MYNEWT_VAL(STATS_SNAP_INTERVAL)));
+#endif
+}
+
+#endif /* MYNEWT_VAL(STATS_SNAP) */
@@ -84,6 +84,49 @@ void sysinit_panic_set(sysinit_panic_fn *panic_fn);
 #define SYSINIT_ASSERT_ACTIVE()
 #endif
 
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+
+/** One recorded initialization step; times are in microseconds. */
+struct sysinit_profile_entry {
+    const char *spe_name;
+    /** Start of the step, relative to sysinit_start(). */
+    uint32_t spe_start_us;
+    uint32_t spe_dur_us;
+    /** Step ran on the async init task. */
+    uint8_t spe_async;
+};
+
+uint32_t sysinit_profile_begin(void);
+void sysinit_profile_end(const char *name, uint32_t begin);
+const struct sysinit_profile_entry *sysinit_profile_get(int idx);
+
+/**
+ * Runs a statement and records how long it took under the given name.
+ * Packages with slow initialization can wrap parts of their init function
+ * with this to have them show up in the boot profile.
+ */
+#define SYSINIT_PROFILE_RUN(name, stmt) do                                  \
+{                                                                           \
+    uint32_t sysinit_prof_begin__ = sysinit_profile_begin();                \
+    stmt;                                                                   \
+    sysinit_profile_end((name), sysinit_prof_begin__);                      \
+} while (0)
+
+#else
+
+#define SYSINIT_PROFILE_RUN(name, stmt) do { stmt; } while (0)
+
+#endif
+
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+
+typedef void sysinit_async_fn(void *arg);
+
+int sysinit_async(const char *name, sysinit_async_fn *fn, void *arg);
+int sysinit_async_wait(uint32_t timeout);
+
+#endif
+
 #if MYNEWT_VAL(SPLIT_LOADER)
 
 /*** System initialization for loader (first stage of split image). */
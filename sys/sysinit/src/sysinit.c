@@ -21,6 +21,9 @@
 #include <stddef.h>
 #include <limits.h>
 #include "os/mynewt.h"
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+#include "modlog/modlog.h"
+#endif
 
 static void
 sysinit_dflt_panic_cb(const char *file, int line, const char *func,
@@ -39,6 +42,33 @@ sysinit_panic_fn *sysinit_panic_cb = sysinit_dflt_panic_cb;
 
 uint8_t sysinit_active;
 
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+static struct sysinit_profile_entry
+    sysinit_profile[MYNEWT_VAL(SYSINIT_PROFILE_MAX)];
+static uint8_t sysinit_profile_cnt;
+static uint32_t sysinit_profile_base;
+#endif
+
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+struct sysinit_async_job {
+    struct os_event saj_ev;
+    const char *saj_name;
+    sysinit_async_fn *saj_fn;
+    void *saj_arg;
+};
+
+static struct sysinit_async_job
+    sysinit_async_jobs[MYNEWT_VAL(SYSINIT_ASYNC_MAX)];
+static uint8_t sysinit_async_cnt;
+static uint8_t sysinit_async_done;
+static struct os_event sysinit_async_done_ev;
+static struct os_eventq sysinit_async_evq;
+static struct os_sem sysinit_async_sem;
+static struct os_task sysinit_async_task;
+OS_TASK_STACK_DEFINE(sysinit_async_stack,
+                     MYNEWT_VAL(SYSINIT_ASYNC_STACK_SIZE));
+#endif
+
 /**
  * Sets the sysinit panic function; i.e., the function which executes when
  * initialization fails.  By default, a panic triggers a failed assertion.
@@ -49,14 +79,232 @@ sysinit_panic_set(sysinit_panic_fn *panic_cb)
     sysinit_panic_cb = panic_cb;
 }
 
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+static void
+sysinit_profile_add(const char *name, uint32_t begin, int async)
+{
+    struct sysinit_profile_entry *spe;
+    uint32_t now;
+    os_sr_t sr;
+
+    now = os_cputime_get32();
+
+    OS_ENTER_CRITICAL(sr);
+    if (sysinit_profile_cnt < MYNEWT_VAL(SYSINIT_PROFILE_MAX)) {
+        spe = &sysinit_profile[sysinit_profile_cnt++];
+        spe->spe_name = name;
+        spe->spe_start_us =
+            os_cputime_ticks_to_usecs(begin - sysinit_profile_base);
+        spe->spe_dur_us = os_cputime_ticks_to_usecs(now - begin);
+        spe->spe_async = async;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+sysinit_profile_log(int async)
+{
+    const struct sysinit_profile_entry *spe;
+    int i;
+
+    for (i = 0; (spe = sysinit_profile_get(i)) != NULL; i++) {
+        if (spe->spe_async == async) {
+            MODLOG_DFLT(INFO, "sysinit %s%s: start=%lu dur=%lu us\n",
+                        spe->spe_name, async ? " (async)" : "",
+                        (unsigned long)spe->spe_start_us,
+                        (unsigned long)spe->spe_dur_us);
+        }
+    }
+}
+
+/**
+ * Starts timing an initialization step.
+ *
+ * @return                      Value to pass to sysinit_profile_end().
+ */
+uint32_t
+sysinit_profile_begin(void)
+{
+    return os_cputime_get32();
+}
+
+/**
+ * Records an initialization step in the boot profile.  Steps beyond
+ * SYSINIT_PROFILE_MAX are not recorded.
+ *
+ * @param name                  Name of the step; must stay valid.
+ * @param begin                 Value returned by sysinit_profile_begin().
+ */
+void
+sysinit_profile_end(const char *name, uint32_t begin)
+{
+    sysinit_profile_add(name, begin, 0);
+}
+
+/**
+ * Reads a recorded initialization step.  Entries are in the order the
+ * steps completed.  The whole of sysinit is recorded as "sysinit".
+ *
+ * @param idx                   Index of the entry to read.
+ *
+ * @return                      The entry, or NULL past the last one.
+ */
+const struct sysinit_profile_entry *
+sysinit_profile_get(int idx)
+{
+    if (idx < 0 || idx >= sysinit_profile_cnt) {
+        return NULL;
+    }
+    return &sysinit_profile[idx];
+}
+#endif
+
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+static void
+sysinit_async_job_cb(struct os_event *ev)
+{
+    struct sysinit_async_job *saj;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    uint32_t begin;
+#endif
+
+    saj = ev->ev_arg;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    begin = os_cputime_get32();
+    saj->saj_fn(saj->saj_arg);
+    sysinit_profile_add(saj->saj_name, begin, 1);
+#else
+    saj->saj_fn(saj->saj_arg);
+#endif
+}
+
+static void
+sysinit_async_done_cb(struct os_event *ev)
+{
+    sysinit_async_done = 1;
+    os_sem_release(&sysinit_async_sem);
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    sysinit_profile_log(1);
+#endif
+}
+
+static void
+sysinit_async_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&sysinit_async_evq);
+    }
+}
+
+/**
+ * Queues part of a package's initialization to run on the async init task
+ * instead of blocking the rest of sysinit.  Jobs run one at a time, in the
+ * order they were queued; since packages are initialized in stage order,
+ * a job can rely on jobs queued from earlier stages having completed.
+ * Initialization which depends on an async job must itself be queued as
+ * an async job; code running after sysinit calls sysinit_async_wait()
+ * instead.  May only be called during sysinit.
+ *
+ * @param name                  Name of the job, used in the boot profile.
+ * @param fn                    Function to run.
+ * @param arg                   Argument to pass to fn.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOMEM if SYSINIT_ASYNC_MAX jobs are
+ *                                  already queued.
+ */
+int
+sysinit_async(const char *name, sysinit_async_fn *fn, void *arg)
+{
+    struct sysinit_async_job *saj;
+    int rc;
+
+    SYSINIT_ASSERT_ACTIVE();
+
+    if (sysinit_async_cnt >= MYNEWT_VAL(SYSINIT_ASYNC_MAX)) {
+        return SYS_ENOMEM;
+    }
+
+    if (sysinit_async_cnt == 0) {
+        os_eventq_init(&sysinit_async_evq);
+        rc = os_sem_init(&sysinit_async_sem, 0);
+        assert(rc == 0);
+        rc = os_task_init(&sysinit_async_task, "sysinit",
+                          sysinit_async_task_handler, NULL,
+                          MYNEWT_VAL(SYSINIT_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                          sysinit_async_stack,
+                          OS_STACK_ALIGN(
+                              MYNEWT_VAL(SYSINIT_ASYNC_STACK_SIZE)));
+        assert(rc == 0);
+    }
+
+    saj = &sysinit_async_jobs[sysinit_async_cnt++];
+    saj->saj_name = name;
+    saj->saj_fn = fn;
+    saj->saj_arg = arg;
+    saj->saj_ev.ev_cb = sysinit_async_job_cb;
+    saj->saj_ev.ev_arg = saj;
+    os_eventq_put(&sysinit_async_evq, &saj->saj_ev);
+
+    return 0;
+}
+
+/**
+ * Waits for all jobs queued with sysinit_async() to complete.  Must be
+ * called after sysinit() has returned.
+ *
+ * @param timeout               Maximum time to wait, in OS ticks, or
+ *                                  OS_WAIT_FOREVER.
+ *
+ * @return                      0 when all jobs have completed;
+ *                              OS_TIMEOUT if they have not done so within
+ *                                  the timeout.
+ */
+int
+sysinit_async_wait(uint32_t timeout)
+{
+    int rc;
+
+    /* The last job can't complete before sysinit does. */
+    assert(!sysinit_active);
+
+    if (sysinit_async_cnt == 0 || sysinit_async_done) {
+        return 0;
+    }
+
+    rc = os_sem_pend(&sysinit_async_sem, timeout);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Let other waiters through too. */
+    os_sem_release(&sysinit_async_sem);
+    return 0;
+}
+#endif
+
 void
 sysinit_start(void)
 {
     sysinit_active = 1;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    sysinit_profile_cnt = 0;
+    sysinit_profile_base = os_cputime_get32();
+#endif
 }
 
 void
 sysinit_end(void)
 {
     sysinit_active = 0;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    sysinit_profile_add("sysinit", sysinit_profile_base, 0);
+    sysinit_profile_log(0);
+#endif
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+    if (sysinit_async_cnt != 0) {
+        sysinit_async_done_ev.ev_cb = sysinit_async_done_cb;
+        os_eventq_put(&sysinit_async_evq, &sysinit_async_done_ev);
+    }
+#endif
 }
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_SYSVIEW_
+#define H_SYSVIEW_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "syscfg/syscfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_task;
+
+#if MYNEWT_VAL(SYSVIEW_FILTER)
+
+/*
+ * Event categories.  The kernel API categories match the
+ * OS_SYSVIEW_TRACE_* settings, which remove the events at compile time;
+ * the filter below can only narrow down what is compiled in.
+ */
+#define SYSVIEW_CAT_SCHED       (1 << 0)    /* Task switches, ready, idle */
+#define SYSVIEW_CAT_ISR         (1 << 1)    /* Interrupt entry / exit */
+#define SYSVIEW_CAT_EVENTQ      (1 << 2)
+#define SYSVIEW_CAT_MUTEX       (1 << 3)
+#define SYSVIEW_CAT_SEM         (1 << 4)
+#define SYSVIEW_CAT_CALLOUT     (1 << 5)
+#define SYSVIEW_CAT_MEMPOOL     (1 << 6)
+#define SYSVIEW_CAT_MBUF        (1 << 7)
+#define SYSVIEW_CAT_USER        (1 << 8)    /* os_trace_user_start / stop */
+#define SYSVIEW_CAT_CNT         (9)
+#define SYSVIEW_CAT_ALL         ((1 << SYSVIEW_CAT_CNT) - 1)
+
+/** Enabled categories, SYSVIEW_CAT_*. */
+extern volatile uint32_t sysview_filter_cats;
+
+/**
+ * Checks whether a category is enabled.  Used for events which have to
+ * stay paired (task switches, interrupts), so they are never sampled,
+ * rate limited or filtered by task.
+ */
+static inline bool
+sysview_filter_cat(uint32_t cat)
+{
+    return (sysview_filter_cats & cat) != 0;
+}
+
+/**
+ * Decides whether a kernel API call event is sent.  Applies the category
+ * mask, the task set, sampling and the rate limit, and counts the events
+ * dropped by the last three.
+ *
+ * @param id                    OS_TRACE_ID_* of the call.
+ *
+ * @return                      true if the event is to be sent.
+ */
+bool sysview_filter_api(unsigned id);
+
+/**
+ * Decides whether the end of a kernel API call is sent.  The end of a
+ * call is dropped whenever the matching start was.
+ *
+ * @param id                    OS_TRACE_ID_* of the call.
+ *
+ * @return                      true if the event is to be sent.
+ */
+bool sysview_filter_api_ret(unsigned id);
+
+/**
+ * Sets the enabled categories.
+ *
+ * @param cats                  Mask of SYSVIEW_CAT_*.
+ */
+void sysview_filter_set_cats(uint32_t cats);
+
+/**
+ * Adds a task to, or removes it from, the set of traced tasks.  While the
+ * set is empty, API calls from all tasks are traced.  Calls made from
+ * interrupt handlers are attributed to the interrupted task.
+ *
+ * @param t                     The task.
+ * @param on                    true to trace the task, false to stop.
+ */
+void sysview_filter_task(const struct os_task *t, bool on);
+
+/**
+ * Empties the task set, so API calls from all tasks are traced.
+ */
+void sysview_filter_task_clear(void);
+
+/**
+ * Sends only one in every n API events of a category.
+ *
+ * @param cat                   A single SYSVIEW_CAT_* API category.
+ * @param n                     1 to send every event.
+ *
+ * @return                      0 on success, SYS_EINVAL on a bad category.
+ */
+int sysview_filter_set_sample(uint32_t cat, uint16_t n);
+
+/**
+ * Limits the number of API events sent per OS tick, over all categories.
+ *
+ * @param max                   Events per tick; 0 for no limit.
+ */
+void sysview_filter_set_rate(uint16_t max);
+
+/**
+ * Returns the number of API events of a category dropped by the task
+ * set, sampling or the rate limit.  Events of disabled categories are
+ * not counted.
+ *
+ * @param cat                   A single SYSVIEW_CAT_* category.
+ */
+uint32_t sysview_filter_dropped(uint32_t cat);
+
+/**
+ * Resets all dropped event counters.
+ */
+void sysview_filter_dropped_clear(void);
+
+/*
+ * Filtered versions of the SystemView calls made from assembly, which
+ * can't use the inline os_trace_* functions.
+ */
+void sysview_filter_isr_enter(void);
+void sysview_filter_isr_exit(void);
+void sysview_filter_task_start_exec(uint32_t task);
+
+#endif /* MYNEWT_VAL(SYSVIEW_FILTER) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_SYSVIEW_ */
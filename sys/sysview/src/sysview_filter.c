@@ -0,0 +1,282 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(SYSVIEW_FILTER)
+
+#include "sysview/sysview.h"
+#include "sysview/vendor/SEGGER_SYSVIEW.h"
+
+/* Kernel API IDs are grouped by tens, OS_TRACE_ID_EVENTQ_PUT (40) first. */
+#define SYSVIEW_FILTER_API_ID_MIN       (40)
+#define SYSVIEW_FILTER_API_ID_MAX       (99)
+#define SYSVIEW_FILTER_API_CAT_FIRST    (2)     /* SYSVIEW_CAT_EVENTQ */
+
+volatile uint32_t sysview_filter_cats = MYNEWT_VAL(SYSVIEW_FILTER_CATS);
+
+/* Bit n set if the task with t_taskid n is traced. */
+static uint32_t sysview_filter_tasks[256 / 32];
+static uint8_t sysview_filter_task_cnt;
+
+static uint16_t sysview_filter_sample[SYSVIEW_CAT_CNT] = {
+    [2] = MYNEWT_VAL(SYSVIEW_FILTER_SAMPLE_EVENTQ),
+    [5] = MYNEWT_VAL(SYSVIEW_FILTER_SAMPLE_CALLOUT),
+    [6] = MYNEWT_VAL(SYSVIEW_FILTER_SAMPLE_MEMPOOL),
+    [7] = MYNEWT_VAL(SYSVIEW_FILTER_SAMPLE_MBUF),
+};
+static uint16_t sysview_filter_sample_cnt[SYSVIEW_CAT_CNT];
+
+static uint16_t sysview_filter_rate_max = MYNEWT_VAL(SYSVIEW_FILTER_RATE_MAX);
+static uint16_t sysview_filter_rate_cnt;
+static os_time_t sysview_filter_rate_tick;
+
+/* Bit n set if the last start of a call in category n was dropped. */
+static uint32_t sysview_filter_ret_drop;
+
+static uint32_t sysview_filter_drops[SYSVIEW_CAT_CNT];
+
+static int
+sysview_filter_cat_idx(uint32_t cat)
+{
+    if (cat == 0 || (cat & (cat - 1)) != 0 || cat > SYSVIEW_CAT_ALL) {
+        return -1;
+    }
+    return __builtin_ctz(cat);
+}
+
+static int
+sysview_filter_api_idx(unsigned id)
+{
+    if (id < SYSVIEW_FILTER_API_ID_MIN || id > SYSVIEW_FILTER_API_ID_MAX) {
+        return -1;
+    }
+    return id / 10 - SYSVIEW_FILTER_API_ID_MIN / 10 +
+           SYSVIEW_FILTER_API_CAT_FIRST;
+}
+
+static bool
+sysview_filter_task_pass(void)
+{
+    struct os_task *t;
+
+    if (sysview_filter_task_cnt == 0) {
+        return true;
+    }
+
+    t = os_sched_get_current_task();
+    if (t == NULL) {
+        return true;
+    }
+    return (sysview_filter_tasks[t->t_taskid / 32] &
+            (1UL << (t->t_taskid % 32))) != 0;
+}
+
+static bool
+sysview_filter_rate_pass(void)
+{
+    os_time_t now;
+
+    if (sysview_filter_rate_max == 0) {
+        return true;
+    }
+
+    now = os_time_get();
+    if (now != sysview_filter_rate_tick) {
+        sysview_filter_rate_tick = now;
+        sysview_filter_rate_cnt = 0;
+    }
+    if (sysview_filter_rate_cnt >= sysview_filter_rate_max) {
+        return false;
+    }
+    sysview_filter_rate_cnt++;
+    return true;
+}
+
+bool
+sysview_filter_api(unsigned id)
+{
+    os_sr_t sr;
+    bool pass;
+    int idx;
+
+    idx = sysview_filter_api_idx(id);
+    if (idx < 0) {
+        /* Not a kernel API event; only the rate limit applies. */
+        OS_ENTER_CRITICAL(sr);
+        pass = sysview_filter_rate_pass();
+        OS_EXIT_CRITICAL(sr);
+        return pass;
+    }
+    if (!(sysview_filter_cats & (1UL << idx))) {
+        return false;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    pass = sysview_filter_task_pass();
+    if (pass && sysview_filter_sample[idx] > 1) {
+        if (++sysview_filter_sample_cnt[idx] >= sysview_filter_sample[idx]) {
+            sysview_filter_sample_cnt[idx] = 0;
+        } else {
+            pass = false;
+        }
+    }
+    if (pass) {
+        pass = sysview_filter_rate_pass();
+    }
+
+    if (pass) {
+        sysview_filter_ret_drop &= ~(1UL << idx);
+    } else {
+        sysview_filter_ret_drop |= 1UL << idx;
+        sysview_filter_drops[idx]++;
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    return pass;
+}
+
+bool
+sysview_filter_api_ret(unsigned id)
+{
+    int idx;
+
+    idx = sysview_filter_api_idx(id);
+    if (idx < 0) {
+        return true;
+    }
+    if (!(sysview_filter_cats & (1UL << idx))) {
+        return false;
+    }
+    return !(sysview_filter_ret_drop & (1UL << idx));
+}
+
+void
+sysview_filter_set_cats(uint32_t cats)
+{
+    sysview_filter_cats = cats & SYSVIEW_CAT_ALL;
+}
+
+void
+sysview_filter_task(const struct os_task *t, bool on)
+{
+    uint32_t bit;
+    uint32_t *w;
+    os_sr_t sr;
+
+    w = &sysview_filter_tasks[t->t_taskid / 32];
+    bit = 1UL << (t->t_taskid % 32);
+
+    OS_ENTER_CRITICAL(sr);
+    if (on && !(*w & bit)) {
+        *w |= bit;
+        sysview_filter_task_cnt++;
+    } else if (!on && (*w & bit)) {
+        *w &= ~bit;
+        sysview_filter_task_cnt--;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+sysview_filter_task_clear(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(sysview_filter_tasks, 0, sizeof(sysview_filter_tasks));
+    sysview_filter_task_cnt = 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+sysview_filter_set_sample(uint32_t cat, uint16_t n)
+{
+    os_sr_t sr;
+    int idx;
+
+    idx = sysview_filter_cat_idx(cat);
+    if (idx < SYSVIEW_FILTER_API_CAT_FIRST || cat == SYSVIEW_CAT_USER) {
+        return SYS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    sysview_filter_sample[idx] = n;
+    sysview_filter_sample_cnt[idx] = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+void
+sysview_filter_set_rate(uint16_t max)
+{
+    sysview_filter_rate_max = max;
+}
+
+uint32_t
+sysview_filter_dropped(uint32_t cat)
+{
+    int idx;
+
+    idx = sysview_filter_cat_idx(cat);
+    if (idx < 0) {
+        return 0;
+    }
+    return sysview_filter_drops[idx];
+}
+
+void
+sysview_filter_dropped_clear(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(sysview_filter_drops, 0, sizeof(sysview_filter_drops));
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+sysview_filter_isr_enter(void)
+{
+    if (sysview_filter_cat(SYSVIEW_CAT_ISR)) {
+        SEGGER_SYSVIEW_RecordEnterISR();
+    }
+}
+
+void
+sysview_filter_isr_exit(void)
+{
+    if (sysview_filter_cat(SYSVIEW_CAT_ISR)) {
+        SEGGER_SYSVIEW_RecordExitISR();
+    }
+}
+
+void
+sysview_filter_task_start_exec(uint32_t task)
+{
+    if (sysview_filter_cat(SYSVIEW_CAT_SCHED)) {
+        SEGGER_SYSVIEW_OnTaskStartExec(task);
+    }
+}
+
+#endif /* MYNEWT_VAL(SYSVIEW_FILTER) */
@@ -27,6 +27,7 @@ extern "C" {
 
 #define RUNTEST_NMGR_OP_TEST    0
 #define RUNTEST_NMGR_OP_LIST    1
+#define RUNTEST_NMGR_OP_BENCH   2
 
 /* Define the prefix to to add to all test log messages.  If the user's syscfg
  * specifies the `RUNTEST_PREFIX` setting, use that value.  Otherwise, generate
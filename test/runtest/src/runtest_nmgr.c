@@ -33,12 +33,18 @@
 
 static int runtest_nmgr_test(struct mgmt_cbuf *);
 static int runtest_nmgr_list(struct mgmt_cbuf *);
+#if MYNEWT_VAL(TESTUTIL_BENCH)
+static int runtest_nmgr_bench(struct mgmt_cbuf *);
+#endif
 
 static struct mgmt_group runtest_nmgr_group;
 
 static const struct mgmt_handler runtest_nmgr_handlers[] = {
     [RUNTEST_NMGR_OP_TEST] = { NULL, runtest_nmgr_test },
-    [RUNTEST_NMGR_OP_LIST] = { runtest_nmgr_list, NULL }
+    [RUNTEST_NMGR_OP_LIST] = { runtest_nmgr_list, NULL },
+#if MYNEWT_VAL(TESTUTIL_BENCH)
+    [RUNTEST_NMGR_OP_BENCH] = { runtest_nmgr_bench, NULL },
+#endif
 };
 
 /*
@@ -129,6 +135,69 @@ runtest_nmgr_list(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(TESTUTIL_BENCH)
+/*
+ * Report the retained TEST_BENCH results, oldest first.  Times are in
+ * ticks of "clock_hz".
+ */
+static int
+runtest_nmgr_bench(struct mgmt_cbuf *cb)
+{
+    const struct tu_bench_result *r;
+    CborError g_err = CborNoError;
+    CborEncoder bench_list;
+    CborEncoder bench;
+    int i;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "clock_hz");
+    g_err |= cbor_encode_uint(&cb->encoder, tu_bench_clock_hz());
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "benches");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &bench_list,
+                                       CborIndefiniteLength);
+
+    for (i = 0; i < tu_bench_result_count(); i++) {
+        r = tu_bench_result_get(i);
+
+        g_err |= cbor_encoder_create_map(&bench_list, &bench,
+                                         CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&bench, "name");
+        g_err |= cbor_encode_text_stringz(&bench, r->tbr_name);
+        g_err |= cbor_encode_text_stringz(&bench, "iters");
+        g_err |= cbor_encode_uint(&bench, r->tbr_iters);
+        g_err |= cbor_encode_text_stringz(&bench, "samples");
+        g_err |= cbor_encode_uint(&bench, r->tbr_samples);
+        g_err |= cbor_encode_text_stringz(&bench, "min");
+        g_err |= cbor_encode_uint(&bench, r->tbr_min);
+        g_err |= cbor_encode_text_stringz(&bench, "median");
+        g_err |= cbor_encode_uint(&bench, r->tbr_median);
+        g_err |= cbor_encode_text_stringz(&bench, "p99");
+        g_err |= cbor_encode_uint(&bench, r->tbr_p99);
+        g_err |= cbor_encode_text_stringz(&bench, "max");
+        g_err |= cbor_encode_uint(&bench, r->tbr_max);
+        g_err |= cbor_encode_text_stringz(&bench, "total");
+        g_err |= cbor_encode_uint(&bench, r->tbr_total);
+        g_err |= cbor_encode_text_stringz(&bench, "heap");
+        g_err |= cbor_encode_int(&bench, r->tbr_heap_delta);
+        g_err |= cbor_encode_text_stringz(&bench, "mempool");
+        g_err |= cbor_encode_int(&bench, r->tbr_mempool_delta);
+        g_err |= cbor_encode_text_stringz(&bench, "stack");
+        g_err |= cbor_encode_int(&bench, r->tbr_stack_delta);
+        g_err |= cbor_encoder_close_container(&bench_list, &bench);
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &bench_list);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
 /*
  * Register nmgr group handlers
  */
@@ -79,6 +79,21 @@ void tu_suite_complete(void);
 
 int tu_suite_register(tu_testsuite_fn_t* ts, const char *name);
 
+#if MYNEWT_VAL(TESTUTIL_SIM_JOBS) > 0
+int tu_suite_fork(const char *name);
+void tu_suite_fork_exit(void);
+
+#define TU_SUITE_FORK(name) do {                             \
+    if (tu_suite_fork(name)) {                               \
+        return 0;                                            \
+    }                                                        \
+} while (0)
+#define TU_SUITE_FORK_EXIT() tu_suite_fork_exit()
+#else
+#define TU_SUITE_FORK(name)
+#define TU_SUITE_FORK_EXIT()
+#endif
+
 struct ts_suite {
     SLIST_ENTRY(ts_suite) ts_next;
     const char *ts_name;
@@ -207,9 +222,11 @@ TEST_SUITE_##suite_name(void);                               \
     int                                                      \
     suite_name(void)                                         \
     {                                                        \
+        TU_SUITE_FORK(#suite_name);                          \
         tu_suite_init(#suite_name);                          \
         TEST_SUITE_##suite_name();                           \
         tu_suite_complete();                                 \
+        TU_SUITE_FORK_EXIT();                                \
                                                              \
         return tu_suite_failed;                              \
     }                                                        \
@@ -311,6 +328,49 @@ TEST_SUITE_##suite_name(void);                               \
 #define TEST_PASS(...)                                        \
     tu_case_pass_manual(__FILE__, __LINE__, __VA_ARGS__);
 
+#if MYNEWT_VAL(TESTUTIL_BENCH)
+
+/*
+ * Microbenchmarks
+ *
+ * TEST_BENCH(name, iters) runs the statement that follows it iters times,
+ * timing every pass.  Times are in ticks of tu_bench_clock_hz().
+ *
+ *     TEST_BENCH(crc16_1k, 1000) {
+ *         crc16_ccitt(0, buf, sizeof buf);
+ *     }
+ */
+struct tu_bench_result {
+    const char *tbr_name;
+    uint32_t tbr_iters;
+    /* Number of samples the median and p99 were computed over. */
+    uint32_t tbr_samples;
+    uint32_t tbr_min;
+    uint32_t tbr_median;
+    uint32_t tbr_p99;
+    uint32_t tbr_max;
+    /* Sum of all passes. */
+    uint32_t tbr_total;
+    /* Bytes of heap consumed over the run (0 without TESTUTIL_BENCH_HEAP). */
+    int32_t tbr_heap_delta;
+    /* Mempool blocks consumed over the run, summed across all pools. */
+    int32_t tbr_mempool_delta;
+    /* Growth of the running task's stack high-water mark, in bytes. */
+    int32_t tbr_stack_delta;
+};
+
+void tu_bench_start(const char *name, uint32_t iters);
+int tu_bench_next(void);
+uint32_t tu_bench_clock_hz(void);
+int tu_bench_result_count(void);
+const struct tu_bench_result *tu_bench_result_get(int idx);
+void tu_bench_results_clear(void);
+
+#define TEST_BENCH(bench_name, iters)                         \
+    for (tu_bench_start(#bench_name, (iters)); tu_bench_next(); )
+
+#endif
+
 #if MYNEWT_VAL(TEST)
 #define ASSERT_IF_TEST(expr) assert(expr)
 #else
@@ -0,0 +1,299 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(TESTUTIL_BENCH)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "testutil_priv.h"
+
+#if MYNEWT_VAL(TESTUTIL_BENCH_CYCCNT)
+#include <mcu/cmsis_nvic.h>
+#elif defined(ARCH_sim)
+#include "sim/sim.h"
+#endif
+
+#define TU_BENCH_MAX_SAMPLES    MYNEWT_VAL(TESTUTIL_BENCH_MAX_SAMPLES)
+#define TU_BENCH_MAX_RESULTS    MYNEWT_VAL(TESTUTIL_BENCH_MAX_RESULTS)
+
+static struct {
+    struct tu_bench_result *cur;
+    uint32_t iters;
+    uint32_t done;
+    /* Every stride'th pass is kept as a sample. */
+    uint32_t stride;
+    uint32_t t0;
+    int running;
+
+    int32_t heap0;
+    int32_t pool0;
+    int32_t stack0;
+} tu_bench_state;
+
+static uint32_t tu_bench_samples[TU_BENCH_MAX_SAMPLES];
+
+/* Ring of the most recent results; tu_bench_total counts every run. */
+static struct tu_bench_result tu_bench_results[TU_BENCH_MAX_RESULTS];
+static uint32_t tu_bench_total;
+
+static inline uint32_t
+tu_bench_now(void)
+{
+#if MYNEWT_VAL(TESTUTIL_BENCH_CYCCNT)
+    return DWT->CYCCNT;
+#elif defined(ARCH_sim)
+    /*
+     * cputime in sim only moves on OS ticks; use the host clock plus any
+     * time charged by the emulated devices.
+     */
+    return sim_time_usecs();
+#else
+    return os_cputime_get32();
+#endif
+}
+
+uint32_t
+tu_bench_clock_hz(void)
+{
+#if MYNEWT_VAL(TESTUTIL_BENCH_CYCCNT)
+    return SystemCoreClock;
+#elif defined(ARCH_sim)
+    return 1000000;
+#else
+    return MYNEWT_VAL(OS_CPUTIME_FREQ);
+#endif
+}
+
+static int32_t
+tu_bench_heap_free(void)
+{
+#if MYNEWT_VAL(TESTUTIL_BENCH_HEAP)
+    size_t free_bytes;
+    size_t largest;
+
+    get_malloc_memory_status(&free_bytes, &largest);
+    return free_bytes;
+#else
+    return 0;
+#endif
+}
+
+static int32_t
+tu_bench_pool_free(void)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    int32_t num_free;
+
+    num_free = 0;
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        num_free += omi.omi_num_free;
+    }
+
+    return num_free;
+}
+
+static int32_t
+tu_bench_stack_used(void)
+{
+    struct os_task *t;
+#if !MYNEWT_VAL(OS_TASK_STACK_HWM)
+    os_stack_t *bottom;
+#endif
+
+    t = os_sched_get_current_task();
+    if (t == NULL) {
+        /* OS not started; nothing meaningful to measure. */
+        return 0;
+    }
+
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    return os_task_stack_hwm_sample(t, 0) * sizeof(os_stack_t);
+#else
+    bottom = t->t_stacktop - t->t_stacksize;
+    while (bottom < t->t_stacktop && *bottom == OS_STACK_PATTERN) {
+        bottom++;
+    }
+    return (t->t_stacktop - bottom) * sizeof(os_stack_t);
+#endif
+}
+
+static void
+tu_bench_sort(uint32_t *v, int n)
+{
+    uint32_t x;
+    int i;
+    int j;
+
+    /* Insertion sort; n is bounded by TESTUTIL_BENCH_MAX_SAMPLES. */
+    for (i = 1; i < n; i++) {
+        x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--) {
+            v[j] = v[j - 1];
+        }
+        v[j] = x;
+    }
+}
+
+void
+tu_bench_start(const char *name, uint32_t iters)
+{
+    struct tu_bench_result *r;
+
+    r = &tu_bench_results[tu_bench_total % TU_BENCH_MAX_RESULTS];
+    tu_bench_total++;
+
+    memset(r, 0, sizeof *r);
+    r->tbr_name = name;
+    r->tbr_iters = iters;
+    r->tbr_min = UINT32_MAX;
+
+    tu_bench_state.cur = r;
+    tu_bench_state.iters = iters;
+    tu_bench_state.done = 0;
+    tu_bench_state.stride = (iters + TU_BENCH_MAX_SAMPLES - 1) /
+                            TU_BENCH_MAX_SAMPLES;
+    if (tu_bench_state.stride == 0) {
+        tu_bench_state.stride = 1;
+    }
+    tu_bench_state.running = 0;
+
+#if MYNEWT_VAL(TESTUTIL_BENCH_CYCCNT)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    tu_bench_state.heap0 = tu_bench_heap_free();
+    tu_bench_state.pool0 = tu_bench_pool_free();
+    tu_bench_state.stack0 = tu_bench_stack_used();
+}
+
+static void
+tu_bench_finish(void)
+{
+    struct tu_bench_result *r;
+    const char *suite;
+    uint32_t n;
+
+    r = tu_bench_state.cur;
+    n = r->tbr_samples;
+
+    r->tbr_heap_delta = tu_bench_state.heap0 - tu_bench_heap_free();
+    r->tbr_mempool_delta = tu_bench_state.pool0 - tu_bench_pool_free();
+    r->tbr_stack_delta = tu_bench_stack_used() - tu_bench_state.stack0;
+
+    if (n == 0) {
+        r->tbr_min = 0;
+    } else {
+        tu_bench_sort(tu_bench_samples, n);
+        r->tbr_median = tu_bench_samples[(n - 1) / 2];
+        /* Nearest-rank: the ceil(0.99 * n)'th smallest sample. */
+        r->tbr_p99 = tu_bench_samples[(n * 99 + 99) / 100 - 1];
+    }
+
+    if (ts_config.ts_print_results) {
+        suite = ts_current_config->ts_suite_name;
+        printf("[bench] %s/%s iters=%" PRIu32 " min=%" PRIu32
+               " median=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32
+               " heap=%" PRId32 " pool=%" PRId32 " stack=%" PRId32 "\n",
+               suite != NULL ? suite : "", r->tbr_name,
+               r->tbr_iters, r->tbr_min, r->tbr_median, r->tbr_p99,
+               r->tbr_max, r->tbr_heap_delta, r->tbr_mempool_delta,
+               r->tbr_stack_delta);
+    }
+
+    tu_bench_state.cur = NULL;
+}
+
+int
+tu_bench_next(void)
+{
+    struct tu_bench_result *r;
+    uint32_t now;
+    uint32_t dt;
+
+    now = tu_bench_now();
+    r = tu_bench_state.cur;
+
+    if (tu_bench_state.running) {
+        dt = now - tu_bench_state.t0;
+        r->tbr_total += dt;
+        if (dt < r->tbr_min) {
+            r->tbr_min = dt;
+        }
+        if (dt > r->tbr_max) {
+            r->tbr_max = dt;
+        }
+        if ((tu_bench_state.done - 1) % tu_bench_state.stride == 0 &&
+            r->tbr_samples < TU_BENCH_MAX_SAMPLES) {
+
+            tu_bench_samples[r->tbr_samples++] = dt;
+        }
+    }
+
+    if (tu_bench_state.done < tu_bench_state.iters) {
+        tu_bench_state.done++;
+        tu_bench_state.running = 1;
+        tu_bench_state.t0 = tu_bench_now();
+        return 1;
+    }
+
+    tu_bench_state.running = 0;
+    tu_bench_finish();
+    return 0;
+}
+
+int
+tu_bench_result_count(void)
+{
+    if (tu_bench_total > TU_BENCH_MAX_RESULTS) {
+        return TU_BENCH_MAX_RESULTS;
+    }
+    return tu_bench_total;
+}
+
+const struct tu_bench_result *
+tu_bench_result_get(int idx)
+{
+    uint32_t first;
+
+    if (idx < 0 || idx >= tu_bench_result_count()) {
+        return NULL;
+    }
+
+    first = 0;
+    if (tu_bench_total > TU_BENCH_MAX_RESULTS) {
+        first = tu_bench_total - TU_BENCH_MAX_RESULTS;
+    }
+
+    return &tu_bench_results[(first + idx) % TU_BENCH_MAX_RESULTS];
+}
+
+void
+tu_bench_results_clear(void)
+{
+    tu_bench_total = 0;
+}
+
+#endif /* MYNEWT_VAL(TESTUTIL_BENCH) */
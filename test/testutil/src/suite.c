@@ -19,6 +19,13 @@
 
 #include <assert.h>
 #include "os/mynewt.h"
+#if MYNEWT_VAL(TESTUTIL_SIM_JOBS) > 0
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 #include "testutil/testutil.h"
 #include "testutil_priv.h"
 
@@ -145,3 +152,150 @@ tu_suite_init(const char *name)
         ts_config.ts_suite_init_cb(ts_config.ts_suite_init_arg);
     }
 }
+
+#if MYNEWT_VAL(TESTUTIL_SIM_JOBS) > 0
+
+/*
+ * Parallel suites (sim only)
+ *
+ * Every top-level suite runs in a child process forked just before it
+ * starts, so it sees the process exactly as main() left it, no matter
+ * what the suites before it did.  Up to TESTUTIL_SIM_JOBS children run at
+ * once.  The parent collects their exit statuses and, on exit, waits for
+ * the stragglers and prints a summary; the process exits non-zero if any
+ * suite failed or crashed.
+ */
+static struct {
+    pid_t pid;
+    const char *name;
+} tu_jobs[MYNEWT_VAL(TESTUTIL_SIM_JOBS)];
+
+static int tu_jobs_running;
+static int tu_jobs_suites;
+static int tu_jobs_failed;
+static int tu_jobs_child;
+
+static void
+tu_suite_reap(void)
+{
+    pid_t pid;
+    int status;
+    int i;
+
+    pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+        return;
+    }
+
+    for (i = 0; i < MYNEWT_VAL(TESTUTIL_SIM_JOBS); i++) {
+        if (tu_jobs[i].pid == pid) {
+            break;
+        }
+    }
+    if (i == MYNEWT_VAL(TESTUTIL_SIM_JOBS)) {
+        /* Not one of ours. */
+        return;
+    }
+
+    if (WIFSIGNALED(status)) {
+        printf("[FAIL] %s: killed by signal %d\n", tu_jobs[i].name,
+               WTERMSIG(status));
+        tu_jobs_failed++;
+    } else if (WEXITSTATUS(status) != 0) {
+        tu_jobs_failed++;
+    }
+
+    tu_jobs[i].pid = 0;
+    tu_jobs_running--;
+    tu_jobs_suites++;
+}
+
+static void
+tu_suite_wait_all(void)
+{
+    if (tu_jobs_child) {
+        return;
+    }
+
+    while (tu_jobs_running > 0) {
+        tu_suite_reap();
+    }
+
+    if (ts_config.ts_print_results) {
+        printf("%d suites, %d failed\n", tu_jobs_suites, tu_jobs_failed);
+    }
+
+    if (tu_jobs_failed) {
+        tu_any_failed = 1;
+        fflush(stdout);
+        _exit(1);
+    }
+}
+
+int
+tu_suite_fork(const char *name)
+{
+    static int inited;
+    pid_t pid;
+    int i;
+
+    if (tu_jobs_child) {
+        /* Nested suite; run it in this process. */
+        return 0;
+    }
+
+    if (!inited) {
+        atexit(tu_suite_wait_all);
+        inited = 1;
+    }
+
+    while (tu_jobs_running >= MYNEWT_VAL(TESTUTIL_SIM_JOBS)) {
+        tu_suite_reap();
+    }
+
+    /* Don't let the child inherit (and print again) buffered output. */
+    fflush(stdout);
+    fflush(stderr);
+
+    pid = fork();
+    if (pid < 0) {
+        /* Out of processes; run the suite here instead. */
+        return 0;
+    }
+    if (pid == 0) {
+        tu_jobs_child = 1;
+        return 0;
+    }
+
+    for (i = 0; i < MYNEWT_VAL(TESTUTIL_SIM_JOBS); i++) {
+        if (tu_jobs[i].pid == 0) {
+            tu_jobs[i].pid = pid;
+            tu_jobs[i].name = name;
+            break;
+        }
+    }
+    tu_jobs_running++;
+
+    /*
+     * The child owns the callbacks main() configured for this suite; clear
+     * them here as tu_suite_complete() would have.
+     */
+    tu_suite_set_init_cb(NULL, NULL);
+    tu_suite_set_pre_test_cb(NULL, NULL);
+    tu_suite_set_post_test_cb(NULL, NULL);
+    tu_suite_set_complete_cb(NULL, NULL);
+
+    return 1;
+}
+
+void
+tu_suite_fork_exit(void)
+{
+    if (tu_jobs_child) {
+        fflush(stdout);
+        fflush(stderr);
+        _exit(tu_suite_failed ? 1 : 0);
+    }
+}
+
+#endif
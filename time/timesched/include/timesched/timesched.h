@@ -37,7 +37,8 @@ struct timesched_timer {
     struct os_eventq *evq;
     struct os_event ev;
 
-    TAILQ_ENTRY(timesched_timer) link;
+    /* Position in the queue of started timers plus one; 0 if stopped */
+    uint16_t heap_idx;
 };
 
 /**
@@ -59,12 +60,14 @@ void timesched_timer_init(struct timesched_timer *timer, struct os_eventq *evq,
 /**
  * Start timer
  *
- * This function starts a timer to expire at specified clock time.
+ * This function starts a timer to expire at specified clock time.  A timer
+ * which is already started is moved to the new time.  At most
+ * TIMESCHED_MAX_TIMERS timers can be started at once.
  *
  * @param timer    Timer to start
  * @param utctime  Time value (UTC) at which timer should expire
  *
- * @return OS_OK on success, error otherwise
+ * @return OS_OK on success, OS_ENOMEM if too many timers are started
  */
 int timesched_timer_start(struct timesched_timer *timer,
                           struct os_timeval *utctime);
@@ -21,29 +21,118 @@
 #include "os/mynewt.h"
 #include "timesched/timesched.h"
 
-static TAILQ_HEAD(timesched_q, timesched_timer) g_timesched_q;
+#define TIMESCHED_MAX_TIMERS    MYNEWT_VAL(TIMESCHED_MAX_TIMERS)
+
+/*
+ * Started timers form a binary min-heap on expiry time, so the next one to
+ * fire is always g_timesched_heap[0].  Each timer records its own position
+ * (plus one) so it can be stopped or restarted without a search.
+ */
+static struct timesched_timer *g_timesched_heap[TIMESCHED_MAX_TIMERS];
+static int g_timesched_cnt;
 
 static struct os_callout g_timesched_co;
+static struct os_time_change_listener g_timesched_tcl;
 
-void
-timesched_resched(void)
+static void
+timesched_heap_set(int idx, struct timesched_timer *timer)
+{
+    g_timesched_heap[idx] = timer;
+    timer->heap_idx = idx + 1;
+}
+
+static int
+timesched_heap_up(int idx)
 {
     struct timesched_timer *timer;
-    os_time_t ticks;
+    int parent;
+
+    timer = g_timesched_heap[idx];
+    while (idx > 0) {
+        parent = (idx - 1) / 2;
+        if (!OS_TIMEVAL_LT(timer->expire, g_timesched_heap[parent]->expire)) {
+            break;
+        }
+        timesched_heap_set(idx, g_timesched_heap[parent]);
+        idx = parent;
+    }
+    timesched_heap_set(idx, timer);
+
+    return idx;
+}
+
+static void
+timesched_heap_down(int idx)
+{
+    struct timesched_timer *timer;
+    int child;
+
+    timer = g_timesched_heap[idx];
+    while ((child = 2 * idx + 1) < g_timesched_cnt) {
+        if (child + 1 < g_timesched_cnt &&
+            OS_TIMEVAL_LT(g_timesched_heap[child + 1]->expire,
+                          g_timesched_heap[child]->expire)) {
+            child++;
+        }
+        if (!OS_TIMEVAL_LT(g_timesched_heap[child]->expire, timer->expire)) {
+            break;
+        }
+        timesched_heap_set(idx, g_timesched_heap[child]);
+        idx = child;
+    }
+    timesched_heap_set(idx, timer);
+}
+
+/* Restores heap order after the expiry of the timer at idx changed. */
+static void
+timesched_heap_fix(int idx)
+{
+    if (timesched_heap_up(idx) == idx) {
+        timesched_heap_down(idx);
+    }
+}
+
+static void
+timesched_heap_remove(struct timesched_timer *timer)
+{
+    int idx;
+
+    idx = timer->heap_idx - 1;
+    timer->heap_idx = 0;
+
+    g_timesched_cnt--;
+    if (idx != g_timesched_cnt) {
+        timesched_heap_set(idx, g_timesched_heap[g_timesched_cnt]);
+        timesched_heap_fix(idx);
+    }
+    g_timesched_heap[g_timesched_cnt] = NULL;
+}
+
+/*
+ * Arms the callout for the first timer to expire.
+ */
+static void
+timesched_resched(void)
+{
+    struct os_timeval expire;
     struct os_timeval time;
+    os_time_t ticks;
     uint64_t msec;
+    os_sr_t sr;
 
-    os_callout_stop(&g_timesched_co);
-
-    timer = TAILQ_FIRST(&g_timesched_q);
-    if (!timer) {
-        /* No timer was started, no need to start callout */
+    OS_ENTER_CRITICAL(sr);
+    if (g_timesched_cnt == 0) {
+        OS_EXIT_CRITICAL(sr);
+        /* No timer was started, no need to run callout */
+        os_callout_stop(&g_timesched_co);
         return;
     }
+    expire = g_timesched_heap[0]->expire;
+    OS_EXIT_CRITICAL(sr);
 
     os_gettimeofday(&time, NULL);
 
-    os_timersub(&timer->expire, &time, &time);
+    os_timersub(&expire, &time, &time);
 
     if (time.tv_sec < 0) {
         /* We're already past expiry time - fire callout "immediately" */
@@ -52,13 +141,11 @@ timesched_resched(void)
         msec = time.tv_sec * 1000 + time.tv_usec / 1000;
 
         /*
-         * We could just schedule next callout to expire at calculated value,
-         * however we need to assume time may be adjusted on device in the
-         * meantime. Since there is no notification from OS that this happened,
-         * we'll just schedule callout at shorter interval to adjust callout if
-         * necessary. For now let's use 1 minute max.
+         * Changes to the time of day are reported by os_settimeofday(), so
+         * the callout only needs to wake up early enough for its tick count
+         * not to overflow.  A day is well within range at any tick rate.
          */
-        msec = min(msec, 60 * 1000);
+        msec = min(msec, 24 * 60 * 60 * 1000);
 
         ticks = os_time_ms_to_ticks32(msec);
     }
@@ -77,12 +164,13 @@ timesched_timer_co_cb(struct os_event *ev)
 
     OS_ENTER_CRITICAL(sr);
 
-    timer = TAILQ_FIRST(&g_timesched_q);
-    while (timer && OS_TIMEVAL_LEQ(timer->expire, time)) {
+    while (g_timesched_cnt > 0) {
+        timer = g_timesched_heap[0];
+        if (!OS_TIMEVAL_LEQ(timer->expire, time)) {
+            break;
+        }
+        timesched_heap_remove(timer);
         os_eventq_put(timer->evq, &timer->ev);
-
-        TAILQ_REMOVE(&g_timesched_q, timer, link);
-        timer = TAILQ_FIRST(&g_timesched_q);
     }
 
     OS_EXIT_CRITICAL(sr);
@@ -90,6 +178,18 @@ timesched_timer_co_cb(struct os_event *ev)
     timesched_resched();
 }
 
+/*
+ * Expiry times are absolute, so a change to the time of day leaves the heap
+ * as it is; only the callout for the first timer needs re-arming.
+ */
+static void
+timesched_time_changed(const struct os_time_change_info *info, void *arg)
+{
+    if (info->tci_cur_utc != NULL) {
+        timesched_resched();
+    }
+}
+
 void
 timesched_timer_init(struct timesched_timer *timer, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
@@ -104,31 +204,33 @@ timesched_timer_init(struct timesched_timer *timer, struct os_eventq *evq,
 int
 timesched_timer_start(struct timesched_timer *timer, struct os_timeval *utctime)
 {
-    struct timesched_timer *entry;
+    struct timesched_timer *head;
     os_sr_t sr;
 
-    timer->expire = *utctime;
-
     OS_ENTER_CRITICAL(sr);
 
-    if (TAILQ_EMPTY(&g_timesched_q)) {
-        TAILQ_INSERT_HEAD(&g_timesched_q, timer, link);
-    } else {
-        TAILQ_FOREACH(entry, &g_timesched_q, link) {
-            if (OS_TIMEVAL_LT(timer->expire, entry->expire)) {
-                TAILQ_INSERT_BEFORE(entry, timer, link);
-                break;
-            }
-        }
+    head = g_timesched_cnt ? g_timesched_heap[0] : NULL;
 
-        if (!entry) {
-            TAILQ_INSERT_TAIL(&g_timesched_q, timer, link);
+    if (timer->heap_idx != 0) {
+        /* Already started; move it to its new place. */
+        timer->expire = *utctime;
+        timesched_heap_fix(timer->heap_idx - 1);
+    } else {
+        if (g_timesched_cnt >= TIMESCHED_MAX_TIMERS) {
+            OS_EXIT_CRITICAL(sr);
+            return OS_ENOMEM;
         }
+        timer->expire = *utctime;
+        timesched_heap_set(g_timesched_cnt, timer);
+        g_timesched_cnt++;
+        timesched_heap_up(g_timesched_cnt - 1);
     }
 
     OS_EXIT_CRITICAL(sr);
 
-    timesched_resched();
+    if (timer == head || timer->heap_idx == 1) {
+        timesched_resched();
+    }
 
     return OS_OK;
 }
@@ -136,20 +238,36 @@ timesched_timer_start(struct timesched_timer *timer, struct os_timeval *utctime)
 int
 timesched_timer_stop(struct timesched_timer *timer)
 {
+    bool was_head;
     os_sr_t sr;
 
     OS_ENTER_CRITICAL(sr);
 
-    TAILQ_REMOVE(&g_timesched_q, timer, link);
+    if (timer->heap_idx == 0) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_OK;
+    }
+    was_head = timer->heap_idx == 1;
+    timesched_heap_remove(timer);
 
     OS_EXIT_CRITICAL(sr);
 
+    if (was_head) {
+        timesched_resched();
+    }
+
     return OS_OK;
 }
 
 void
 timesched_init(void)
 {
+    int rc;
+
     os_callout_init(&g_timesched_co, os_eventq_dflt_get(),
                     timesched_timer_co_cb, NULL);
+
+    g_timesched_tcl.tcl_fn = timesched_time_changed;
+    rc = os_time_change_listen(&g_timesched_tcl);
+    SYSINIT_PANIC_ASSERT(rc == 0);
 }
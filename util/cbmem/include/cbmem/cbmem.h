@@ -38,12 +38,25 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+
+    /*
+     * Bumped before and after the writer drops old entries; odd while it is
+     * doing so.  Lets readers notice entries that went away under them.
+     */
+    volatile uint32_t c_seq;
+    /* Appends do not take c_lock, see cbmem_set_single_writer(). */
+    uint8_t c_single_writer;
+    /* A flush is waiting for the writer to perform it. */
+    volatile uint8_t c_flush_pending;
+    /* Buffer descriptor used by mbufs from cbmem_read_mbuf_ext(). */
+    struct os_mbuf_ext c_ext;
 };
 
 struct cbmem_iter {
     struct cbmem_entry_hdr *ci_start;
     struct cbmem_entry_hdr *ci_cur;
     struct cbmem_entry_hdr *ci_end;
+    uint32_t ci_seq;
 };
 
 /**
@@ -81,6 +94,21 @@ int cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
 int cbmem_append(struct cbmem *cbmem, void *data, uint16_t len);
 int cbmem_append_mbuf(struct cbmem *cbmem, const struct os_mbuf *om);
 
+/**
+ * @brief Lets appends to the cbmem run without taking its lock.
+ *
+ * Only valid when a single context, which may be an interrupt handler, ever
+ * appends to the cbmem.  Readers still serialize among themselves with the
+ * lock; a read or iteration which races with the writer dropping the entry
+ * it is on fails instead of returning overwritten data.  cbmem_flush() from
+ * any context only marks the cbmem empty, the writer releases the space on
+ * its next append.
+ *
+ * @param cbmem                 The cbmem to configure.
+ * @param on                    1 for lock free appends; 0 to take the lock.
+ */
+void cbmem_set_single_writer(struct cbmem *cbmem, int on);
+
 /**
  * @brief Performs a scatter-gather write to the provided cbmem.
  *
@@ -99,6 +127,27 @@ int cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
         uint16_t off, uint16_t len);
 int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
                     struct os_mbuf *om, uint16_t off, uint16_t len);
+
+/**
+ * @brief Appends part of an entry to an mbuf chain without copying it.
+ *
+ * The data is attached as an external buffer mbuf, allocated from the pool
+ * of om, which points into the cbmem.  While any such mbuf is alive the
+ * cbmem does not drop old entries: appends which need the space fail, and
+ * flushes are deferred until the mbufs have been freed.
+ *
+ * @param cbmem                 The cbmem to read from.
+ * @param hdr                   The entry to read.
+ * @param om                    The mbuf chain to append to.
+ * @param off                   Offset within the entry to start at.
+ * @param len                   Number of bytes to read; truncated at the end
+ *                                  of the entry.
+ *
+ * @return                      Number of bytes appended on success; -1 on
+ *                                  failure.
+ */
+int cbmem_read_mbuf_ext(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+                        struct os_mbuf *om, uint16_t off, uint16_t len);
 int cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg);
 
 int cbmem_flush(struct cbmem *);
@@ -23,6 +23,9 @@
 
 typedef void (copy_data_func_t) (void *dst, const void *data, uint16_t len);
 
+/* Keeps the compiler from reordering accesses around lock free updates. */
+#define CBMEM_BARRIER()     __asm__ volatile("" ::: "memory")
+
 int
 cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
 {
@@ -35,6 +38,12 @@ cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
     return (0);
 }
 
+void
+cbmem_set_single_writer(struct cbmem *cbmem, int on)
+{
+    cbmem->c_single_writer = !!on;
+}
+
 int
 cbmem_lock_acquire(struct cbmem *cbmem)
 {
@@ -74,18 +83,71 @@ err:
 }
 
 
+/*
+ * Bracket changes which drop entries, so that lock free readers can tell
+ * that the entry they were reading may have been overwritten.
+ */
+static void
+cbmem_seq_begin(struct cbmem *cbmem)
+{
+    cbmem->c_seq++;
+    CBMEM_BARRIER();
+}
+
+static void
+cbmem_seq_end(struct cbmem *cbmem)
+{
+    CBMEM_BARRIER();
+    cbmem->c_seq++;
+}
+
+/*
+ * Performs a pending flush.  Called by the writer; fails if mbufs from
+ * cbmem_read_mbuf_ext() still point into the buffer.
+ */
+static int
+cbmem_flush_pending(struct cbmem *cbmem)
+{
+    int rc;
+
+    cbmem_seq_begin(cbmem);
+    if (cbmem->c_ext.ome_refcnt == 0) {
+        cbmem->c_entry_start = NULL;
+        cbmem->c_entry_end = NULL;
+        cbmem->c_buf_cur_end = NULL;
+        cbmem->c_flush_pending = 0;
+        rc = 0;
+    } else {
+        rc = -1;
+    }
+    cbmem_seq_end(cbmem);
+
+    return (rc);
+}
+
 static int
 cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
                       copy_data_func_t *copy_func)
 {
     struct cbmem_entry_hdr *dst;
+    uint8_t *cur_end;
     uint8_t *start;
     uint8_t *end;
+    bool drop;
     int rc;
 
-    rc = cbmem_lock_acquire(cbmem);
-    if (rc != 0) {
-        goto err;
+    if (!cbmem->c_single_writer) {
+        rc = cbmem_lock_acquire(cbmem);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    if (cbmem->c_flush_pending) {
+        rc = cbmem_flush_pending(cbmem);
+        if (rc != 0) {
+            goto done;
+        }
     }
 
     if (cbmem->c_entry_end) {
@@ -94,16 +156,18 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
     }
     end = (uint8_t *) dst + len + sizeof(*dst);
+    start = (uint8_t *) cbmem->c_entry_start;
+    cur_end = cbmem->c_buf_cur_end;
 
     /* If this item would take us past the end of this buffer, then adjust
      * the item to the beginning of the buffer.
      */
     if (end > cbmem->c_buf_end) {
-        cbmem->c_buf_cur_end = (uint8_t *) dst;
+        cur_end = (uint8_t *) dst;
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
         end = (uint8_t *) dst + len + sizeof(*dst);
-        if ((uint8_t *) cbmem->c_entry_start >= cbmem->c_buf_cur_end) {
-            cbmem->c_entry_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
+        if (start >= cur_end) {
+            start = cbmem->c_buf;
         }
     }
 
@@ -111,16 +175,31 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
      * start of the buffer, move start forward until you don't overwrite it
      * anymore.
      */
-    start = (uint8_t *) cbmem->c_entry_start;
     if (start && (uint8_t *) dst < start + CBMEM_ENTRY_SIZE(start) &&
             end > start) {
         while (start < end) {
             start = (uint8_t *) CBMEM_ENTRY_NEXT(start);
-            if (start == cbmem->c_buf_cur_end) {
+            if (start == cur_end) {
                 start = cbmem->c_buf;
                 break;
             }
         }
+    }
+
+    /* Entries are only dropped when nothing references them.  The sequence
+     * is bumped before looking at the reference count so that a concurrent
+     * cbmem_read_mbuf_ext() either sees the bump or blocks the drop.
+     */
+    drop = start != (uint8_t *) cbmem->c_entry_start ||
+           cur_end != cbmem->c_buf_cur_end;
+    if (drop) {
+        cbmem_seq_begin(cbmem);
+        if (cbmem->c_ext.ome_refcnt != 0) {
+            cbmem_seq_end(cbmem);
+            rc = -1;
+            goto done;
+        }
+        cbmem->c_buf_cur_end = cur_end;
         cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     }
 
@@ -129,12 +208,24 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
     dst->ceh_len = len;
     copy_func((uint8_t *) dst + sizeof(*dst), data, len);
 
+    /* Publish the entry only once it is complete. */
+    CBMEM_BARRIER();
     cbmem->c_entry_end = dst;
     if (!cbmem->c_entry_start) {
         cbmem->c_entry_start = dst;
     }
 
-    rc = cbmem_lock_release(cbmem);
+    if (drop) {
+        cbmem_seq_end(cbmem);
+    }
+    rc = 0;
+
+done:
+    if (!cbmem->c_single_writer) {
+        if (cbmem_lock_release(cbmem) != 0) {
+            goto err;
+        }
+    }
     if (rc != 0) {
         goto err;
     }
@@ -226,6 +317,16 @@ cbmem_append_scat_gath(struct cbmem *cbmem, const struct cbmem_scat_gath *sg)
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
+    iter->ci_seq = cbmem->c_seq;
+    CBMEM_BARRIER();
+
+    if ((iter->ci_seq & 1) || cbmem->c_flush_pending) {
+        iter->ci_start = NULL;
+        iter->ci_cur = NULL;
+        iter->ci_end = NULL;
+        return;
+    }
+
     iter->ci_start = cbmem->c_entry_start;
     iter->ci_cur = cbmem->c_entry_start;
     iter->ci_end = cbmem->c_entry_end;
@@ -236,6 +337,14 @@ cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
     struct cbmem_entry_hdr *hdr;
 
+    /* Stop early if the writer has dropped entries since the iteration
+     * started; the remaining ones may have been overwritten.
+     */
+    CBMEM_BARRIER();
+    if (cbmem->c_seq != iter->ci_seq) {
+        return (NULL);
+    }
+
     if (iter->ci_start > iter->ci_end) {
         hdr = iter->ci_cur;
         iter->ci_cur = CBMEM_ENTRY_NEXT(iter->ci_cur);
@@ -271,9 +380,16 @@ cbmem_flush(struct cbmem *cbmem)
         goto err;
     }
 
-    cbmem->c_entry_start = NULL;
-    cbmem->c_entry_end = NULL;
-    cbmem->c_buf_cur_end = NULL;
+    /* Leave the flush to the writer if it does not take the lock, or if
+     * mbufs still point at the entries.
+     */
+    if (cbmem->c_single_writer || cbmem->c_ext.ome_refcnt != 0) {
+        cbmem->c_flush_pending = 1;
+    } else {
+        cbmem->c_entry_start = NULL;
+        cbmem->c_entry_end = NULL;
+        cbmem->c_buf_cur_end = NULL;
+    }
 
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
@@ -285,10 +401,54 @@ err:
     return (rc);
 }
 
+/*
+ * Checks that hdr is still one of the entries in the cbmem.  Together with
+ * cbmem_read_done() this makes reads safe against a lock free writer.
+ */
+static int
+cbmem_read_start(struct cbmem *cbmem, const struct cbmem_entry_hdr *hdr,
+                 uint32_t *seq)
+{
+    const struct cbmem_entry_hdr *start;
+    const struct cbmem_entry_hdr *end;
+
+    *seq = cbmem->c_seq;
+    CBMEM_BARRIER();
+
+    start = cbmem->c_entry_start;
+    end = cbmem->c_entry_end;
+    if ((*seq & 1) || cbmem->c_flush_pending || !start || !end) {
+        return (-1);
+    }
+
+    if (start <= end) {
+        if (hdr < start || hdr > end) {
+            return (-1);
+        }
+    } else if (hdr < start && hdr > end) {
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int
+cbmem_read_done(struct cbmem *cbmem, uint32_t seq)
+{
+    CBMEM_BARRIER();
+
+    if (cbmem->c_seq != seq) {
+        return (-1);
+    }
+
+    return (0);
+}
+
 int
 cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
         uint16_t off, uint16_t len)
 {
+    uint32_t seq;
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -296,6 +456,12 @@ cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
         goto err;
     }
 
+    rc = cbmem_read_start(cbmem, hdr, &seq);
+    if (rc != 0) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
     /* Only read the maximum number of bytes, if we exceed that,
      * truncate the read.
      */
@@ -311,6 +477,12 @@ cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
 
     memcpy(buf, (uint8_t *) hdr + sizeof(*hdr) + off, len);
 
+    rc = cbmem_read_done(cbmem, seq);
+    if (rc != 0) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
         goto err;
@@ -324,6 +496,7 @@ err:
 int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
                     struct os_mbuf *om, uint16_t off, uint16_t len)
 {
+    uint32_t seq;
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -331,6 +504,12 @@ int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
         goto err;
     }
 
+    rc = cbmem_read_start(cbmem, hdr, &seq);
+    if (rc != 0) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
     /* Only read the maximum number of bytes, if we exceed that,
      * truncate the read.
      */
@@ -350,6 +529,15 @@ int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
         goto err;
     }
 
+    /* The data may have been overwritten while it was copied.  The caller
+     * is left to trim what was appended.
+     */
+    rc = cbmem_read_done(cbmem, seq);
+    if (rc != 0) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
     cbmem_lock_release(cbmem);
 
     return (len);
@@ -358,6 +546,71 @@ err:
 
 }
 
+int
+cbmem_read_mbuf_ext(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+                    struct os_mbuf *om, uint16_t off, uint16_t len)
+{
+    struct os_mbuf *ext;
+    uint32_t seq;
+    int rc;
+
+    rc = cbmem_lock_acquire(cbmem);
+    if (rc != 0) {
+        goto err;
+    }
+
+    rc = cbmem_read_start(cbmem, hdr, &seq);
+    if (rc != 0) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
+    if (off + len > hdr->ceh_len) {
+        len = hdr->ceh_len - off;
+    }
+
+    if (off > hdr->ceh_len) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
+    if (len == 0) {
+        cbmem_lock_release(cbmem);
+        return (0);
+    }
+
+    /* The buffer descriptor is pointed at the entry, so that offsets fit in
+     * 16 bits however large the cbmem is.  Mbufs keep their own data
+     * pointer, and readers hold the lock, so moving it is safe.
+     */
+    cbmem->c_ext.ome_buf = (uint8_t *) hdr + sizeof(*hdr);
+    cbmem->c_ext.ome_len = hdr->ceh_len;
+
+    ext = os_mbuf_get_ext(om->om_omp, &cbmem->c_ext, off, len);
+    if (ext == NULL) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
+    /* Taking the reference pins the entry; if the writer dropped it before
+     * seeing the reference, give it back.
+     */
+    rc = cbmem_read_done(cbmem, seq);
+    if (rc != 0) {
+        os_mbuf_free(ext);
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
+    os_mbuf_concat(om, ext);
+
+    cbmem_lock_release(cbmem);
+
+    return (len);
+err:
+    return (-1);
+}
+
 int
 cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg)
 {
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cbmem_test.h"
+
+#define CBMEM_TEST_4_MBUF_CNT   4
+#define CBMEM_TEST_4_MBUF_SIZE  \
+    (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + 64)
+
+static os_membuf_t cbmem_test_4_mbuf_mem[
+    OS_MEMPOOL_SIZE(CBMEM_TEST_4_MBUF_CNT, CBMEM_TEST_4_MBUF_SIZE)];
+
+TEST_CASE(cbmem_test_case_4)
+{
+    struct os_mbuf_pool mbuf_pool;
+    struct os_mempool mempool;
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    struct os_mbuf *om;
+    struct cbmem cbmem;
+    uint8_t buf[4 * (sizeof(*hdr) + 16)];
+    uint8_t entry[16];
+    uint8_t data[16];
+    int i;
+    int rc;
+
+    rc = os_mempool_init(&mempool, CBMEM_TEST_4_MBUF_CNT,
+                         CBMEM_TEST_4_MBUF_SIZE, cbmem_test_4_mbuf_mem,
+                         "cbmem_test_4");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&mbuf_pool, &mempool, CBMEM_TEST_4_MBUF_SIZE,
+                           CBMEM_TEST_4_MBUF_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = cbmem_init(&cbmem, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == 0);
+    cbmem_set_single_writer(&cbmem, 1);
+
+    /* Fill the buffer. */
+    for (i = 0; i < 4; i++) {
+        memset(entry, i, sizeof(entry));
+        rc = cbmem_append(&cbmem, entry, sizeof(entry));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Reference the oldest entry without copying it. */
+    om = os_mbuf_get_pkthdr(&mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    cbmem_iter_start(&cbmem, &iter);
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    rc = cbmem_read_mbuf_ext(&cbmem, hdr, om, 4, 100);
+    TEST_ASSERT_FATAL(rc == 12);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 12);
+    TEST_ASSERT(OS_MBUF_IS_EXT(SLIST_NEXT(om, om_next)));
+    TEST_ASSERT(SLIST_NEXT(om, om_next)->om_data ==
+                (uint8_t *)hdr + sizeof(*hdr) + 4);
+
+    /* The entry can not be dropped while it is referenced. */
+    memset(entry, 4, sizeof(entry));
+    rc = cbmem_append(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT(rc != 0);
+
+    /* Neither can it be flushed; the cbmem looks empty until it is freed. */
+    rc = cbmem_flush(&cbmem);
+    TEST_ASSERT(rc == 0);
+    cbmem_iter_start(&cbmem, &iter);
+    TEST_ASSERT(cbmem_iter_next(&cbmem, &iter) == NULL);
+    rc = cbmem_read(&cbmem, hdr, data, 0, sizeof(data));
+    TEST_ASSERT(rc < 0);
+    rc = cbmem_append(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT(rc != 0);
+
+    os_mbuf_copydata(om, 0, 12, data);
+    for (i = 0; i < 12; i++) {
+        TEST_ASSERT(data[i] == 0);
+    }
+
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(cbmem.c_ext.ome_refcnt == 0);
+
+    /* Once freed, the writer performs the flush. */
+    rc = cbmem_append(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT_FATAL(rc == 0);
+    cbmem_iter_start(&cbmem, &iter);
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    rc = cbmem_read(&cbmem, hdr, data, 0, sizeof(data));
+    TEST_ASSERT(rc == sizeof(data));
+    TEST_ASSERT(data[0] == 4);
+    TEST_ASSERT(cbmem_iter_next(&cbmem, &iter) == NULL);
+
+    /* An iteration stops once the writer drops entries under it. */
+    for (i = 0; i < 3; i++) {
+        rc = cbmem_append(&cbmem, entry, sizeof(entry));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    cbmem_iter_start(&cbmem, &iter);
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    rc = cbmem_append(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(cbmem_iter_next(&cbmem, &iter) == NULL);
+}
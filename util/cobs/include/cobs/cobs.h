@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_COBS_
+#define H_COBS_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Consistent Overhead Byte Stuffing.  Encoded data contains no zero bytes,
+ * so a zero delimits frames; the overhead is one byte per 254 bytes of
+ * data, at most.
+ */
+
+/* Maximum encoded length of len bytes, without delimiters. */
+#define COBS_ENCODE_MAX_LEN(len)    ((len) + (len) / 254 + 1)
+
+/**
+ * Called by the decoder with each complete frame.  The callee owns the
+ * mbuf chain.
+ */
+typedef void cobs_frame_fn(void *arg, struct os_mbuf *om);
+
+/**
+ * Incremental decoder.  Data can be fed in pieces of any size, e.g. as it
+ * is received; decoded frames are built in msys mbufs.
+ */
+struct cobs_dec {
+    /* Frame being decoded, NULL between frames */
+    struct os_mbuf *cd_om;
+    cobs_frame_fn *cd_frame_cb;
+    void *cd_arg;
+    /* Longest frame accepted */
+    uint16_t cd_max;
+    /* Data bytes left in the current block */
+    uint8_t cd_left;
+    /* The current block is followed by an implicit zero */
+    uint8_t cd_zero:1;
+    /* Discarding data until the next delimiter */
+    uint8_t cd_drop:1;
+    /* Frames dropped: malformed, too long, or out of mbufs */
+    uint32_t cd_errs;
+};
+
+/**
+ * Initializes a decoder.
+ *
+ * @param cd                    The decoder.
+ * @param max_len               Decoded frames longer than this are dropped.
+ * @param cb                    Called with each complete frame.
+ * @param arg                   Passed to cb.
+ */
+void cobs_dec_init(struct cobs_dec *cd, uint16_t max_len, cobs_frame_fn *cb,
+                   void *arg);
+
+/**
+ * Feeds encoded data to a decoder.  Safe to call from interrupt context;
+ * cd_frame_cb is called from the same context.
+ *
+ * @param cd                    The decoder.
+ * @param data                  Encoded data, including zero delimiters.
+ * @param len                   Length of data.
+ */
+void cobs_dec_feed(struct cobs_dec *cd, const uint8_t *data, int len);
+
+/**
+ * Discards any partially decoded frame.
+ */
+void cobs_dec_reset(struct cobs_dec *cd);
+
+/**
+ * Encodes an mbuf chain, appending the encoded data to another chain.
+ * No delimiters are added.
+ *
+ * @param dst                   Chain to append to.
+ * @param src                   Chain to encode.
+ *
+ * @return                      0 on success, OS_ENOMEM if dst could not
+ *                                  be extended.
+ */
+int cobs_encode(struct os_mbuf *dst, const struct os_mbuf *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_COBS_ */
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_COBS_UART_
+#define H_COBS_UART_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include "cobs/cobs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uart_dev;
+
+/*
+ * Framed binary link over a UART.  Each frame is the payload followed by
+ * its CRC16-CCITT (big endian), COBS encoded, between zero delimiters.
+ * Received frames are decoded in the UART interrupt, by DMA blocks when
+ * HAL_UART_RX_BLOCK is enabled, and queued for a task.
+ */
+struct cobs_uart {
+    struct uart_dev *cu_dev;
+    struct cobs_dec cu_dec;
+    struct os_mqueue cu_rxq;
+    struct os_eventq *cu_evq;
+
+    /* Encoded data being sent; the first mbuf is partly sent */
+    struct os_mbuf *cu_tx;
+    int cu_tx_off;
+
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+    uint8_t cu_rx_ring[MYNEWT_VAL(COBS_UART_RX_RING_SIZE)];
+#endif
+
+    /* Received frames with a bad CRC */
+    uint32_t cu_crc_errs;
+};
+
+/**
+ * Opens a UART for framed transfers.
+ *
+ * @param cu                    The link.
+ * @param dev_name              Name of the UART device, e.g. "uart1".
+ * @param speed                 Baudrate.
+ * @param evq                   Queue rx_cb is run from.
+ * @param rx_cb                 Called when frames are available; read them
+ *                                  with cobs_uart_rx().
+ * @param arg                   ev_arg of the event passed to rx_cb.
+ *
+ * @return                      0 on success, SYS_ENODEV if the UART could
+ *                                  not be opened.
+ */
+int cobs_uart_open(struct cobs_uart *cu, const char *dev_name, uint32_t speed,
+                   struct os_eventq *evq, os_event_fn *rx_cb, void *arg);
+
+/**
+ * Gets the next received frame, with its CRC checked and removed.
+ * Frames with a bad CRC are dropped.
+ *
+ * @return                      Packet header mbuf chain, NULL if none.
+ */
+struct os_mbuf *cobs_uart_rx(struct cobs_uart *cu);
+
+/**
+ * Queues a frame for sending.  Consumes om, also on failure.
+ *
+ * @param cu                    The link.
+ * @param om                    Packet header mbuf chain with the payload.
+ *
+ * @return                      0 on success, OS_ENOMEM when out of mbufs.
+ */
+int cobs_uart_tx(struct cobs_uart *cu, struct os_mbuf *om);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_COBS_UART_ */
@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cobs/cobs.h"
+
+/* Longest block: code byte plus 254 data bytes. */
+#define COBS_BLOCK_MAX      (255)
+
+void
+cobs_dec_init(struct cobs_dec *cd, uint16_t max_len, cobs_frame_fn *cb,
+              void *arg)
+{
+    memset(cd, 0, sizeof(*cd));
+    cd->cd_max = max_len;
+    cd->cd_frame_cb = cb;
+    cd->cd_arg = arg;
+}
+
+void
+cobs_dec_reset(struct cobs_dec *cd)
+{
+    os_mbuf_free_chain(cd->cd_om);
+    cd->cd_om = NULL;
+    cd->cd_left = 0;
+    cd->cd_zero = 0;
+    cd->cd_drop = 0;
+}
+
+/*
+ * Drops the current frame; the rest of it is skipped up to the next
+ * delimiter.
+ */
+static void
+cobs_dec_drop(struct cobs_dec *cd)
+{
+    cobs_dec_reset(cd);
+    cd->cd_drop = 1;
+    cd->cd_errs++;
+}
+
+static int
+cobs_dec_append(struct cobs_dec *cd, const uint8_t *data, int len)
+{
+    if (OS_MBUF_PKTLEN(cd->cd_om) + len > cd->cd_max ||
+        os_mbuf_append(cd->cd_om, data, len) != 0) {
+        cobs_dec_drop(cd);
+        return -1;
+    }
+    return 0;
+}
+
+static void
+cobs_dec_end(struct cobs_dec *cd)
+{
+    struct os_mbuf *om;
+
+    if (cd->cd_drop || cd->cd_om == NULL) {
+        /* End of a dropped frame, or back-to-back delimiters */
+        cobs_dec_reset(cd);
+        return;
+    }
+    if (cd->cd_left != 0) {
+        /* Delimiter in the middle of a block */
+        cobs_dec_drop(cd);
+        cd->cd_drop = 0;
+        return;
+    }
+
+    /* The implicit zero after the last block is not part of the data. */
+    om = cd->cd_om;
+    cd->cd_om = NULL;
+    cobs_dec_reset(cd);
+    cd->cd_frame_cb(cd->cd_arg, om);
+}
+
+void
+cobs_dec_feed(struct cobs_dec *cd, const uint8_t *data, int len)
+{
+    static const uint8_t zero;
+    int run;
+
+    while (len > 0) {
+        if (*data == 0) {
+            cobs_dec_end(cd);
+            data++;
+            len--;
+            continue;
+        }
+        if (cd->cd_drop) {
+            data++;
+            len--;
+            continue;
+        }
+
+        if (cd->cd_left == 0) {
+            /* Code byte starting a new block */
+            if (cd->cd_om == NULL) {
+                cd->cd_om = os_msys_get_pkthdr(0, 0);
+                if (cd->cd_om == NULL) {
+                    cobs_dec_drop(cd);
+                    continue;
+                }
+            } else if (cd->cd_zero) {
+                if (cobs_dec_append(cd, &zero, 1)) {
+                    continue;
+                }
+            }
+            cd->cd_zero = *data != 0xff;
+            cd->cd_left = *data - 1;
+            data++;
+            len--;
+            continue;
+        }
+
+        /* Data bytes, up to the end of the block or a delimiter */
+        for (run = 0; run < len && run < cd->cd_left && data[run] != 0; run++);
+        if (cobs_dec_append(cd, data, run)) {
+            continue;
+        }
+        cd->cd_left -= run;
+        data += run;
+        len -= run;
+    }
+}
+
+int
+cobs_encode(struct os_mbuf *dst, const struct os_mbuf *src)
+{
+    uint8_t blk[COBS_BLOCK_MAX];
+    const struct os_mbuf *m;
+    int n;
+    int i;
+
+    n = 1;
+    for (m = src; m != NULL; m = SLIST_NEXT(m, om_next)) {
+        for (i = 0; i < m->om_len; i++) {
+            if (m->om_data[i] != 0) {
+                blk[n++] = m->om_data[i];
+                if (n < COBS_BLOCK_MAX) {
+                    continue;
+                }
+            }
+            /* Zero, or a full block: the code byte is the block length. */
+            blk[0] = n;
+            if (os_mbuf_append(dst, blk, n)) {
+                return OS_ENOMEM;
+            }
+            n = 1;
+        }
+    }
+
+    blk[0] = n;
+    if (os_mbuf_append(dst, blk, n)) {
+        return OS_ENOMEM;
+    }
+    return 0;
+}
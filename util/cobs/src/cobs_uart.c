@@ -0,0 +1,218 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "uart/uart.h"
+#include "crc/crc16.h"
+#include "crc/crc_mbuf.h"
+#include "cobs/cobs.h"
+#include "cobs/cobs_uart.h"
+
+static void
+cobs_uart_frame(void *arg, struct os_mbuf *om)
+{
+    struct cobs_uart *cu = arg;
+
+    if (os_mqueue_put(&cu->cu_rxq, cu->cu_evq, om)) {
+        os_mbuf_free_chain(om);
+    }
+}
+
+/*
+ * UART callbacks; called with interrupts disabled.
+ */
+static int
+cobs_uart_rx_char(void *arg, uint8_t byte)
+{
+    struct cobs_uart *cu = arg;
+
+    cobs_dec_feed(&cu->cu_dec, &byte, 1);
+    return 0;
+}
+
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+static void
+cobs_uart_rx_block(void *arg, const uint8_t *data, int len)
+{
+    struct cobs_uart *cu = arg;
+
+    cobs_dec_feed(&cu->cu_dec, data, len);
+}
+#endif
+
+/*
+ * Drops fully sent mbufs from the front of the tx chain.
+ */
+static void
+cobs_uart_tx_advance(struct cobs_uart *cu)
+{
+    struct os_mbuf *m;
+
+    while (cu->cu_tx != NULL && cu->cu_tx_off >= cu->cu_tx->om_len) {
+        m = SLIST_NEXT(cu->cu_tx, om_next);
+        os_mbuf_free(cu->cu_tx);
+        cu->cu_tx = m;
+        cu->cu_tx_off = 0;
+    }
+}
+
+static int
+cobs_uart_tx_char(void *arg)
+{
+    struct cobs_uart *cu = arg;
+
+    cobs_uart_tx_advance(cu);
+    if (cu->cu_tx == NULL) {
+        return -1;
+    }
+    return cu->cu_tx->om_data[cu->cu_tx_off++];
+}
+
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+static int
+cobs_uart_tx_block(void *arg, int sent, const uint8_t **data)
+{
+    struct cobs_uart *cu = arg;
+
+    cu->cu_tx_off += sent;
+    cobs_uart_tx_advance(cu);
+    if (cu->cu_tx == NULL) {
+        return 0;
+    }
+    *data = cu->cu_tx->om_data + cu->cu_tx_off;
+    return cu->cu_tx->om_len - cu->cu_tx_off;
+}
+#endif
+
+static uint16_t
+cobs_uart_crc(const struct os_mbuf *om, int len)
+{
+    uint16_t crc;
+
+    crc = CRC16_INITIAL_CRC;
+    crc16_ccitt_mbuf(&crc, om, 0, len);
+    return crc;
+}
+
+struct os_mbuf *
+cobs_uart_rx(struct cobs_uart *cu)
+{
+    struct os_mbuf *om;
+    uint8_t tail[2];
+    int len;
+
+    while ((om = os_mqueue_get(&cu->cu_rxq)) != NULL) {
+        len = OS_MBUF_PKTLEN(om) - sizeof(tail);
+        if (len > 0 &&
+            os_mbuf_copydata(om, len, sizeof(tail), tail) == 0 &&
+            cobs_uart_crc(om, len) == ((tail[0] << 8) | tail[1])) {
+            os_mbuf_adj(om, -(int)sizeof(tail));
+            return om;
+        }
+        cu->cu_crc_errs++;
+        os_mbuf_free_chain(om);
+    }
+    return NULL;
+}
+
+int
+cobs_uart_tx(struct cobs_uart *cu, struct os_mbuf *om)
+{
+    static const uint8_t delim;
+    struct os_mbuf *enc;
+    uint16_t crc;
+    uint8_t tail[2];
+    os_sr_t sr;
+
+    enc = NULL;
+
+    crc = cobs_uart_crc(om, OS_MBUF_PKTLEN(om));
+    tail[0] = crc >> 8;
+    tail[1] = crc;
+    if (os_mbuf_append(om, tail, sizeof(tail))) {
+        goto err;
+    }
+
+    /* A leading delimiter ends whatever line noise the peer has seen. */
+    enc = os_msys_get_pkthdr(COBS_ENCODE_MAX_LEN(OS_MBUF_PKTLEN(om)) + 2, 0);
+    if (enc == NULL ||
+        os_mbuf_append(enc, &delim, 1) ||
+        cobs_encode(enc, om) ||
+        os_mbuf_append(enc, &delim, 1)) {
+        goto err;
+    }
+    os_mbuf_free_chain(om);
+
+    OS_ENTER_CRITICAL(sr);
+    if (cu->cu_tx == NULL) {
+        cu->cu_tx = enc;
+        cu->cu_tx_off = 0;
+    } else {
+        os_mbuf_concat(cu->cu_tx, enc);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    uart_start_tx(cu->cu_dev);
+    return 0;
+
+err:
+    os_mbuf_free_chain(om);
+    os_mbuf_free_chain(enc);
+    return OS_ENOMEM;
+}
+
+int
+cobs_uart_open(struct cobs_uart *cu, const char *dev_name, uint32_t speed,
+               struct os_eventq *evq, os_event_fn *rx_cb, void *arg)
+{
+    struct uart_conf uc = {
+        .uc_speed = speed,
+        .uc_databits = 8,
+        .uc_stopbits = 1,
+        .uc_parity = UART_PARITY_NONE,
+        .uc_flow_ctl = UART_FLOW_CTL_NONE,
+        .uc_tx_char = cobs_uart_tx_char,
+        .uc_rx_char = cobs_uart_rx_char,
+        .uc_cb_arg = cu,
+#if MYNEWT_VAL(HAL_UART_TX_BLOCK)
+        .uc_tx_block = cobs_uart_tx_block,
+#endif
+#if MYNEWT_VAL(HAL_UART_RX_BLOCK)
+        .uc_rx_block = cobs_uart_rx_block,
+        .uc_rx_ring = cu->cu_rx_ring,
+        .uc_rx_ring_len = sizeof(cu->cu_rx_ring),
+#endif
+    };
+
+    cu->cu_evq = evq;
+    cu->cu_tx = NULL;
+    cu->cu_tx_off = 0;
+    cu->cu_crc_errs = 0;
+    cobs_dec_init(&cu->cu_dec, MYNEWT_VAL(COBS_UART_MAX_FRAME) + 2,
+                  cobs_uart_frame, cu);
+    os_mqueue_init(&cu->cu_rxq, rx_cb, arg);
+
+    cu->cu_dev = (struct uart_dev *)os_dev_open((char *)dev_name, 0, &uc);
+    if (cu->cu_dev == NULL) {
+        return SYS_ENODEV;
+    }
+    return 0;
+}
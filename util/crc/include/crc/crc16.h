@@ -36,6 +36,8 @@ extern "C" {
 
 #define CRC16_INITIAL_CRC       0       /* what to seed crc16 with */
 unsigned short crc16_ccitt(uint16_t initial_crc, const void *buf, int len);
+/* Software implementation, regardless of the selected CRC engine */
+uint16_t crc16_ccitt_sw(uint16_t initial_crc, const void *buf, int len);
 
 #ifdef __cplusplus
 }
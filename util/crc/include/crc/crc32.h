@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * CRC-32 in its two common reflected forms:
+ *
+ *  crc32_hdlc: ISO-HDLC / IEEE 802.3 / zlib, polynomial 0x04c11db7.
+ *  crc32c:     Castagnoli (iSCSI, ext4, SCTP), polynomial 0x1edc6f41.
+ *
+ * Both take and return the finished CRC value (initial ~0 and final
+ * complement are applied internally), so a CRC over several buffers is
+ * computed by passing the previous result back in, starting from
+ * CRC32_INITIAL_CRC.
+ */
+
+#ifndef _UTIL_CRC32_H_
+#define _UTIL_CRC32_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_INITIAL_CRC       0       /* what to seed crc32 with */
+
+uint32_t crc32_hdlc(uint32_t crc, const void *buf, int len);
+uint32_t crc32c(uint32_t crc, const void *buf, int len);
+
+/* Software implementations, regardless of the selected CRC engine */
+uint32_t crc32_hdlc_sw(uint32_t crc, const void *buf, int len);
+uint32_t crc32c_sw(uint32_t crc, const void *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * CRC engines.
+ *
+ * crc16_ccitt(), crc32_hdlc() and crc32c() run on the selected engine when
+ * CRC_ENGINE is enabled.  The software engine ("sw") is always present and
+ * selected initially; MCU code can register engines backed by a CRC
+ * peripheral.  An engine leaves a function NULL for algorithms it cannot
+ * do, and those fall back to software.
+ */
+
+#ifndef _UTIL_CRC_ENGINE_H_
+#define _UTIL_CRC_ENGINE_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct crc_engine {
+    const char *ce_name;
+    uint16_t (*ce_crc16_ccitt)(uint16_t crc, const void *buf, int len);
+    uint32_t (*ce_crc32_hdlc)(uint32_t crc, const void *buf, int len);
+    uint32_t (*ce_crc32c)(uint32_t crc, const void *buf, int len);
+    struct crc_engine *ce_next;
+};
+
+/**
+ * Adds an engine to the list of engines that can be selected.
+ */
+void crc_engine_register(struct crc_engine *ce);
+
+/**
+ * Returns the engine with the given name, NULL if there is none.
+ */
+struct crc_engine *crc_engine_find(const char *name);
+
+/**
+ * Iterates over registered engines; pass NULL to get the first one.
+ */
+struct crc_engine *crc_engine_next(const struct crc_engine *prev);
+
+/**
+ * Makes crc16_ccitt(), crc32_hdlc() and crc32c() use the given engine.
+ * Callers must make sure no CRC calculation is in progress.
+ */
+void crc_engine_select(struct crc_engine *ce);
+
+/**
+ * Returns the selected engine.
+ */
+struct crc_engine *crc_engine_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
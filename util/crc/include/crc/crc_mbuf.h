@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC_MBUF_H_
+#define _UTIL_CRC_MBUF_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_mbuf;
+
+/*
+ * CRCs over a range of an mbuf chain, computed segment by segment without
+ * copying.  *crc holds the starting value (e.g. CRC16_INITIAL_CRC) and is
+ * updated with the result.
+ *
+ * Return 0 on success, SYS_EINVAL if the range extends beyond the end of
+ * the chain (*crc is then left unchanged).
+ */
+int crc16_ccitt_mbuf(uint16_t *crc, const struct os_mbuf *om, int off,
+                     int len);
+int crc32_hdlc_mbuf(uint32_t *crc, const struct os_mbuf *om, int off,
+                    int len);
+int crc32c_mbuf(uint32_t *crc, const struct os_mbuf *om, int off, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
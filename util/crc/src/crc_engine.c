@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "crc/crc_engine.h"
+#include "crc_priv.h"
+
+#if MYNEWT_VAL(CRC_ENGINE)
+
+static struct crc_engine crc_engine_sw = {
+    .ce_name = "sw",
+};
+
+static struct crc_engine *crc_engines = &crc_engine_sw;
+struct crc_engine *crc_engine_cur = &crc_engine_sw;
+
+void
+crc_engine_register(struct crc_engine *ce)
+{
+    struct crc_engine **cep;
+
+    for (cep = &crc_engines; *cep; cep = &(*cep)->ce_next) {
+        if (*cep == ce) {
+            return;
+        }
+    }
+    ce->ce_next = NULL;
+    *cep = ce;
+}
+
+struct crc_engine *
+crc_engine_find(const char *name)
+{
+    struct crc_engine *ce;
+
+    for (ce = crc_engines; ce; ce = ce->ce_next) {
+        if (!strcmp(ce->ce_name, name)) {
+            return ce;
+        }
+    }
+    return NULL;
+}
+
+struct crc_engine *
+crc_engine_next(const struct crc_engine *prev)
+{
+    if (!prev) {
+        return crc_engines;
+    }
+    return prev->ce_next;
+}
+
+void
+crc_engine_select(struct crc_engine *ce)
+{
+    crc_engine_cur = ce ? ce : &crc_engine_sw;
+}
+
+struct crc_engine *
+crc_engine_get(void)
+{
+    return crc_engine_cur;
+}
+
+#endif
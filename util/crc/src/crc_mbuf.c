@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "crc/crc_mbuf.h"
+
+/*
+ * Each helper runs the buffer CRC over the chain's segments in place; all
+ * of these CRCs can be continued across buffers by passing the previous
+ * result back in.
+ */
+#define CRC_MBUF_WALK(crc, fn, om, off, len)                            \
+    do {                                                                \
+        const struct os_mbuf *cur;                                      \
+        uint16_t cur_off;                                               \
+        int count;                                                      \
+                                                                        \
+        cur = os_mbuf_off((om), (off), &cur_off);                       \
+        if (cur == NULL) {                                              \
+            return SYS_EINVAL;                                          \
+        }                                                               \
+        while ((len) > 0) {                                             \
+            if (cur == NULL) {                                          \
+                return SYS_EINVAL;                                      \
+            }                                                           \
+            count = min(cur->om_len - cur_off, (len));                  \
+            (crc) = fn((crc), cur->om_data + cur_off, count);           \
+            (len) -= count;                                             \
+            cur_off = 0;                                                \
+            cur = SLIST_NEXT(cur, om_next);                             \
+        }                                                               \
+    } while (0)
+
+int
+crc16_ccitt_mbuf(uint16_t *crc, const struct os_mbuf *om, int off, int len)
+{
+    uint16_t c;
+
+    c = *crc;
+    CRC_MBUF_WALK(c, crc16_ccitt, om, off, len);
+    *crc = c;
+    return 0;
+}
+
+int
+crc32_hdlc_mbuf(uint32_t *crc, const struct os_mbuf *om, int off, int len)
+{
+    uint32_t c;
+
+    c = *crc;
+    CRC_MBUF_WALK(c, crc32_hdlc, om, off, len);
+    *crc = c;
+    return 0;
+}
+
+int
+crc32c_mbuf(uint32_t *crc, const struct os_mbuf *om, int off, int len)
+{
+    uint32_t c;
+
+    c = *crc;
+    CRC_MBUF_WALK(c, crc32c, om, off, len);
+    *crc = c;
+    return 0;
+}
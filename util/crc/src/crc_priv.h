@@ -0,0 +1,36 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC_PRIV_H_
+#define _UTIL_CRC_PRIV_H_
+
+#include "syscfg/syscfg.h"
+#include "crc/crc_engine.h"
+
+#define CRC_SLICE               MYNEWT_VAL(CRC_SLICE)
+
+#if CRC_SLICE != 1 && CRC_SLICE != 4 && CRC_SLICE != 8
+#error "CRC_SLICE must be 1, 4 or 8"
+#endif
+
+#if MYNEWT_VAL(CRC_ENGINE)
+extern struct crc_engine *crc_engine_cur;
+#endif
+
+#endif
@@ -136,4 +136,87 @@ int32_t back_int_in(int32_t step, int32_t max_steps, int32_t max_val);
 int32_t back_int_out(int32_t step, int32_t max_steps, int32_t max_val);
 int32_t back_int_io(int32_t step, int32_t max_steps, int32_t max_val);
 
+/* Fixed-point Functions
+ *
+ * These take the progress t as a Q16 fraction (0 to 65536) and return the
+ * eased value as a Q16 fraction.  Back and bounce curves may leave [0, 1].
+ * They use no floating point, for cores without an FPU.
+ */
+typedef int32_t (*easing_q16_func_t)(int32_t t);
+
+/* Custom.  sine_custom_q16_io rises and falls back over one period. */
+int32_t exponential_custom_q16_io(int32_t t);
+int32_t exp_sin_custom_q16_io(int32_t t);
+int32_t sine_custom_q16_io(int32_t t);
+
+/* Linear */
+int32_t linear_q16_io(int32_t t);
+
+/* Exponential */
+int32_t exponential_q16_in(int32_t t);
+int32_t exponential_q16_out(int32_t t);
+int32_t exponential_q16_io(int32_t t);
+
+/* Quadratic */
+int32_t quadratic_q16_in(int32_t t);
+int32_t quadratic_q16_out(int32_t t);
+int32_t quadratic_q16_io(int32_t t);
+
+/* Cubic */
+int32_t cubic_q16_in(int32_t t);
+int32_t cubic_q16_out(int32_t t);
+int32_t cubic_q16_io(int32_t t);
+
+/* Quartic */
+int32_t quartic_q16_in(int32_t t);
+int32_t quartic_q16_out(int32_t t);
+int32_t quartic_q16_io(int32_t t);
+
+/* Quintic */
+int32_t quintic_q16_in(int32_t t);
+int32_t quintic_q16_out(int32_t t);
+int32_t quintic_q16_io(int32_t t);
+
+/* Circular */
+int32_t circular_q16_in(int32_t t);
+int32_t circular_q16_out(int32_t t);
+int32_t circular_q16_io(int32_t t);
+
+/* Sine */
+int32_t sine_q16_in(int32_t t);
+int32_t sine_q16_out(int32_t t);
+int32_t sine_q16_io(int32_t t);
+
+/* Bounce */
+int32_t bounce_q16_in(int32_t t);
+int32_t bounce_q16_out(int32_t t);
+int32_t bounce_q16_io(int32_t t);
+
+/* Back */
+int32_t back_q16_in(int32_t t);
+int32_t back_q16_out(int32_t t);
+int32_t back_q16_io(int32_t t);
+
+/*
+ * Evaluates a Q16 curve with Q15 progress and result; INT16_MAX stands for
+ * the end of the curve.  The result saturates.
+ */
+int16_t easing_q15(easing_q16_func_t func, int16_t t);
+
+/*
+ * Evaluates a Q16 curve at step out of max_steps, scaled to max_val; a
+ * drop-in for the integer functions above.
+ */
+int32_t easing_q16_step(easing_q16_func_t func, int32_t step,
+                        int32_t max_steps, int32_t max_val);
+
+/*
+ * Fills n_steps values of a curve going from 0 to max_val, ending exactly
+ * at the end of the curve, e.g. for a pwm_seq.  Values go stride entries
+ * apart, so one channel of an interleaved buffer can be filled.  Values are
+ * clamped to [0, UINT16_MAX].
+ */
+void easing_q16_fill(easing_q16_func_t func, uint16_t *buf, uint16_t n_steps,
+                     uint16_t stride, uint16_t max_val);
+
 #endif /* _UTIL_EASING_H_ */
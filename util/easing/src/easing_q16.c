@@ -0,0 +1,561 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Fixed-point easing functions.  Progress and results are Q16 fractions
+ * (65536 == 1.0); no floating point or libm.  Sines come from a quarter-wave
+ * table with linear interpolation, powers of two from a cubic polynomial.
+ * Errors stay within about 16 LSBs of Q16.
+ */
+
+#include <stdint.h>
+#include "easing/easing.h"
+
+#define Q16_ONE         65536
+#define Q16_HALF        32768
+
+/* log2(e), 1/e and 1/(e - 1/e) in Q16. */
+#define Q16_LOG2E       94548
+#define Q16_INV_E       24109
+#define Q16_INV_E_SPAN  27883
+
+/* Overshoot of the back curves: 1.70158 and 1.70158 * 1.525. */
+#define Q16_BACK_S      111515
+#define Q16_BACK_S_IO   170060
+
+/* 2^f - 1 - f ~= -f(1 - f)(C1 + C2 f) over [0, 1). */
+#define Q16_EXP2_C1     19928
+#define Q16_EXP2_C2     5186
+
+/* sin(i * pi / 256) in Q16; the 129th entry (1.0) is implied. */
+static const uint16_t easing_sin_tab[128] = {
+        0,   804,  1608,  2412,  3216,  4019,  4821,  5623,
+     6424,  7224,  8022,  8820,  9616, 10411, 11204, 11996,
+    12785, 13573, 14359, 15143, 15924, 16703, 17479, 18253,
+    19024, 19792, 20557, 21320, 22078, 22834, 23586, 24335,
+    25080, 25821, 26558, 27291, 28020, 28745, 29466, 30182,
+    30893, 31600, 32303, 33000, 33692, 34380, 35062, 35738,
+    36410, 37076, 37736, 38391, 39040, 39683, 40320, 40951,
+    41576, 42194, 42806, 43412, 44011, 44604, 45190, 45769,
+    46341, 46906, 47464, 48015, 48559, 49095, 49624, 50146,
+    50660, 51166, 51665, 52156, 52639, 53114, 53581, 54040,
+    54491, 54934, 55368, 55794, 56212, 56621, 57022, 57414,
+    57798, 58172, 58538, 58896, 59244, 59583, 59914, 60235,
+    60547, 60851, 61145, 61429, 61705, 61971, 62228, 62476,
+    62714, 62943, 63162, 63372, 63572, 63763, 63944, 64115,
+    64277, 64429, 64571, 64704, 64827, 64940, 65043, 65137,
+    65220, 65294, 65358, 65413, 65457, 65492, 65516, 65531,
+};
+
+static inline int32_t
+q16_mul(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> 16);
+}
+
+/* sin(x * pi / 2) for x in [0, 1]. */
+static int32_t
+q16_sin_quarter(int32_t x)
+{
+    int32_t idx;
+    int32_t frac;
+    int32_t a;
+    int32_t b;
+
+    if (x <= 0) {
+        return 0;
+    }
+    if (x >= Q16_ONE) {
+        return Q16_ONE;
+    }
+
+    idx = x >> 9;
+    frac = x & 0x1ff;
+    a = easing_sin_tab[idx];
+    b = idx == 127 ? Q16_ONE : easing_sin_tab[idx + 1];
+
+    return a + (((b - a) * frac) >> 9);
+}
+
+/* cos(2 * pi * x), x being a fraction of a turn. */
+static int32_t
+q16_cos_turn(int32_t x)
+{
+    int32_t r;
+
+    r = (x & 0x3fff) << 2;
+
+    switch ((x >> 14) & 3) {
+    case 0:
+        return q16_sin_quarter(Q16_ONE - r);
+    case 1:
+        return -q16_sin_quarter(r);
+    case 2:
+        return -q16_sin_quarter(Q16_ONE - r);
+    default:
+        return q16_sin_quarter(r);
+    }
+}
+
+/* 2^x; x must be below 15. */
+static int32_t
+q16_exp2(int32_t x)
+{
+    int32_t n;
+    int32_t f;
+    int32_t p;
+
+    n = x >> 16;
+    f = x & 0xffff;
+    if (n < -17) {
+        return 0;
+    }
+
+    p = Q16_ONE + f -
+        q16_mul(q16_mul(f, Q16_ONE - f), Q16_EXP2_C1 + q16_mul(Q16_EXP2_C2, f));
+
+    return n >= 0 ? p << n : p >> -n;
+}
+
+/* sqrt(x) for x in [0, 1]. */
+static int32_t
+q16_sqrt(int32_t x)
+{
+    uint32_t op;
+    uint32_t res;
+    uint32_t one;
+
+    if (x <= 0) {
+        return 0;
+    }
+    if (x >= Q16_ONE) {
+        return Q16_ONE;
+    }
+
+    op = (uint32_t)x << 16;
+    res = 0;
+    one = 1UL << 30;
+    while (one > op) {
+        one >>= 2;
+    }
+    while (one != 0) {
+        if (op >= res + one) {
+            op -= res + one;
+            res = (res >> 1) + one;
+        } else {
+            res >>= 1;
+        }
+        one >>= 2;
+    }
+
+    return res;
+}
+
+static inline int32_t
+q16_clamp(int32_t v)
+{
+    if (v < 0) {
+        return 0;
+    }
+    if (v > Q16_ONE) {
+        return Q16_ONE;
+    }
+    return v;
+}
+
+/*
+ * The out and in-out shapes derive from the in shape: out mirrors it, and
+ * in-out runs it at double speed for the first half and mirrored for the
+ * second.
+ */
+#define Q16_OUT(in, t)  (Q16_ONE - (in)(Q16_ONE - (t)))
+#define Q16_IO(in, t)                                           \
+    ((t) < Q16_HALF ? (in)(2 * (t)) / 2 :                       \
+                      Q16_ONE - (in)(2 * (Q16_ONE - (t))) / 2)
+
+static int32_t
+q16_exponential_in(int32_t t)
+{
+    if (t <= 0) {
+        return 0;
+    }
+    return q16_exp2(10 * (t - Q16_ONE));
+}
+
+static int32_t
+q16_quadratic_in(int32_t t)
+{
+    return q16_mul(t, t);
+}
+
+static int32_t
+q16_cubic_in(int32_t t)
+{
+    return q16_mul(q16_mul(t, t), t);
+}
+
+static int32_t
+q16_quartic_in(int32_t t)
+{
+    int32_t t2;
+
+    t2 = q16_mul(t, t);
+    return q16_mul(t2, t2);
+}
+
+static int32_t
+q16_quintic_in(int32_t t)
+{
+    int32_t t2;
+
+    t2 = q16_mul(t, t);
+    return q16_mul(q16_mul(t2, t2), t);
+}
+
+static int32_t
+q16_circular_in(int32_t t)
+{
+    return Q16_ONE - q16_sqrt(Q16_ONE - q16_mul(t, t));
+}
+
+static int32_t
+q16_sine_in(int32_t t)
+{
+    return Q16_ONE - q16_sin_quarter(Q16_ONE - t);
+}
+
+static int32_t
+q16_bounce_out(int32_t t)
+{
+    if (t >= Q16_ONE) {
+        return Q16_ONE;
+    }
+
+    /* 7.5625 * r^2 plus an offset, for each of the four bounces. */
+    if (t < 23831) {
+        return q16_mul(495616, q16_mul(t, t));
+    }
+    if (t < 47663) {
+        t -= 35747;
+        return q16_mul(495616, q16_mul(t, t)) + 49152;
+    }
+    if (t < 59578) {
+        t -= 53620;
+        return q16_mul(495616, q16_mul(t, t)) + 61440;
+    }
+    t -= 62557;
+    return q16_mul(495616, q16_mul(t, t)) + 64512;
+}
+
+static int32_t
+q16_bounce_in(int32_t t)
+{
+    return Q16_OUT(q16_bounce_out, t);
+}
+
+static inline int32_t
+q16_back(int32_t t, int32_t s)
+{
+    return q16_mul(q16_mul(t, t), q16_mul(s + Q16_ONE, t) - s);
+}
+
+static int32_t
+q16_back_in(int32_t t)
+{
+    return q16_back(t, Q16_BACK_S);
+}
+
+static int32_t
+q16_back_in_io(int32_t t)
+{
+    return q16_back(t, Q16_BACK_S_IO);
+}
+
+/* Custom, used for breathing */
+int32_t
+exponential_custom_q16_io(int32_t t)
+{
+    if (t <= 0) {
+        return 0;
+    }
+    return q16_exp2(16 * (t - Q16_ONE));
+}
+
+int32_t
+exp_sin_custom_q16_io(int32_t t)
+{
+    int32_t e;
+
+    e = q16_exp2(q16_mul(-q16_cos_turn(t / 2), Q16_LOG2E));
+    return q16_clamp(q16_mul(e - Q16_INV_E, Q16_INV_E_SPAN));
+}
+
+int32_t
+sine_custom_q16_io(int32_t t)
+{
+    return (Q16_ONE - q16_cos_turn(t)) / 2;
+}
+
+/* Linear */
+int32_t
+linear_q16_io(int32_t t)
+{
+    return t;
+}
+
+/* Exponential */
+int32_t
+exponential_q16_in(int32_t t)
+{
+    return q16_exponential_in(t);
+}
+int32_t
+exponential_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_exponential_in, t);
+}
+int32_t
+exponential_q16_io(int32_t t)
+{
+    return Q16_IO(q16_exponential_in, t);
+}
+
+/* Quadratic */
+int32_t
+quadratic_q16_in(int32_t t)
+{
+    return q16_quadratic_in(t);
+}
+int32_t
+quadratic_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_quadratic_in, t);
+}
+int32_t
+quadratic_q16_io(int32_t t)
+{
+    return Q16_IO(q16_quadratic_in, t);
+}
+
+/* Cubic */
+int32_t
+cubic_q16_in(int32_t t)
+{
+    return q16_cubic_in(t);
+}
+int32_t
+cubic_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_cubic_in, t);
+}
+int32_t
+cubic_q16_io(int32_t t)
+{
+    return Q16_IO(q16_cubic_in, t);
+}
+
+/* Quartic */
+int32_t
+quartic_q16_in(int32_t t)
+{
+    return q16_quartic_in(t);
+}
+int32_t
+quartic_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_quartic_in, t);
+}
+int32_t
+quartic_q16_io(int32_t t)
+{
+    return Q16_IO(q16_quartic_in, t);
+}
+
+/* Quintic */
+int32_t
+quintic_q16_in(int32_t t)
+{
+    return q16_quintic_in(t);
+}
+int32_t
+quintic_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_quintic_in, t);
+}
+int32_t
+quintic_q16_io(int32_t t)
+{
+    return Q16_IO(q16_quintic_in, t);
+}
+
+/* Circular */
+int32_t
+circular_q16_in(int32_t t)
+{
+    return q16_circular_in(t);
+}
+int32_t
+circular_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_circular_in, t);
+}
+int32_t
+circular_q16_io(int32_t t)
+{
+    return Q16_IO(q16_circular_in, t);
+}
+
+/* Sine */
+int32_t
+sine_q16_in(int32_t t)
+{
+    return q16_sine_in(t);
+}
+int32_t
+sine_q16_out(int32_t t)
+{
+    return q16_sin_quarter(t);
+}
+int32_t
+sine_q16_io(int32_t t)
+{
+    return (Q16_ONE - q16_cos_turn(t / 2)) / 2;
+}
+
+/* Bounce */
+int32_t
+bounce_q16_in(int32_t t)
+{
+    return q16_bounce_in(t);
+}
+int32_t
+bounce_q16_out(int32_t t)
+{
+    return q16_bounce_out(t);
+}
+int32_t
+bounce_q16_io(int32_t t)
+{
+    return Q16_IO(q16_bounce_in, t);
+}
+
+/* Back */
+int32_t
+back_q16_in(int32_t t)
+{
+    return q16_back_in(t);
+}
+int32_t
+back_q16_out(int32_t t)
+{
+    return Q16_OUT(q16_back_in, t);
+}
+int32_t
+back_q16_io(int32_t t)
+{
+    return Q16_IO(q16_back_in_io, t);
+}
+
+/* Q15 and scaled helpers */
+int16_t
+easing_q15(easing_q16_func_t func, int16_t t)
+{
+    int32_t v;
+
+    /* Q15 cannot hold 1.0; take its largest value to mean the end. */
+    v = func(t >= INT16_MAX ? Q16_ONE : (int32_t)t << 1) >> 1;
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return v;
+}
+
+static inline uint16_t
+easing_q16_to_u16(int32_t v, uint16_t max_val)
+{
+    v = (int32_t)(((int64_t)v * max_val + Q16_HALF) >> 16);
+    if (v < 0) {
+        return 0;
+    }
+    if (v > UINT16_MAX) {
+        return UINT16_MAX;
+    }
+    return v;
+}
+
+int32_t
+easing_q16_step(easing_q16_func_t func, int32_t step, int32_t max_steps,
+                int32_t max_val)
+{
+    int32_t t;
+
+    if (max_steps <= 0 || step >= max_steps) {
+        t = Q16_ONE;
+    } else if (step <= 0) {
+        t = 0;
+    } else {
+        t = (int32_t)(((int64_t)step << 16) / max_steps);
+    }
+
+    return (int32_t)(((int64_t)func(t) * max_val + Q16_HALF) >> 16);
+}
+
+void
+easing_q16_fill(easing_q16_func_t func, uint16_t *buf, uint16_t n_steps,
+                uint16_t stride, uint16_t max_val)
+{
+    uint32_t span;
+    uint32_t inc;
+    uint32_t rem;
+    uint32_t acc;
+    int32_t t;
+    uint16_t i;
+
+    if (n_steps == 0) {
+        return;
+    }
+    if (n_steps == 1) {
+        buf[0] = easing_q16_to_u16(func(Q16_ONE), max_val);
+        return;
+    }
+
+    /*
+     * Step t from 0 to exactly 1.0 over n_steps points, carrying the
+     * remainder of 1.0 / span so there is no division per step.
+     */
+    span = n_steps - 1;
+    inc = Q16_ONE / span;
+    rem = Q16_ONE % span;
+    acc = 0;
+    t = 0;
+    for (i = 0; i < n_steps; i++) {
+        *buf = easing_q16_to_u16(func(t), max_val);
+        buf += stride;
+
+        t += inc;
+        acc += rem;
+        if (acc >= span) {
+            acc -= span;
+            t++;
+        }
+    }
+}
@@ -300,6 +300,124 @@ err:
     return NULL;
 }
 
+/**
+ * Splits a fragment from the front of an mbuf chain without copying the bulk
+ * of its data.  Behaves like mem_split_frag(), except that mbufs which lie
+ * entirely within the fragment are unlinked from the source chain and linked
+ * into the fragment as they are.  Only the data in the first mbuf of the
+ * source chain (which keeps the packet header of the remainder) and the
+ * leading part of the mbuf in which the fragment boundary falls are copied.
+ *
+ * The fragment ends up holding mbufs which belong to the source chain's pool;
+ * use mem_split_frag() if the fragment must consist of mbufs obtained from
+ * alloc_cb only.
+ *
+ * @param om                    The packet to fragment.  Upon fragmentation,
+ *                                  this mbuf is adjusted such that the
+ *                                  fragment data is removed.  If the packet
+ *                                  constitutes a single fragment, this gets
+ *                                  set to NULL on success.
+ * @param max_frag_sz           The maximum payload size of a fragment.
+ * @param alloc_cb              Points to a function that allocates the first
+ *                                  mbuf of a fragment.  This function gets
+ *                                  called before the source mbuf chain is
+ *                                  modified, so it can safely inspect it.
+ * @param cb_arg                Generic parameter that gets passed to the
+ *                                  callback function.
+ *
+ * @return                      The next fragment to send on success;
+ *                              NULL on failure, in which case the source
+ *                                  mbuf chain is left unmodified.
+ */
+struct os_mbuf *
+mem_split_frag_ref(struct os_mbuf **om, uint16_t max_frag_sz,
+                   mem_frag_alloc_fn *alloc_cb, void *cb_arg)
+{
+    struct os_mbuf *frag;
+    struct os_mbuf *head;
+    struct os_mbuf *first;
+    struct os_mbuf *last;
+    struct os_mbuf *cur;
+    struct os_mbuf *tail;
+    uint16_t head_len;
+    uint16_t ref_len;
+    uint16_t left;
+    int rc;
+
+    if (OS_MBUF_PKTLEN(*om) <= max_frag_sz) {
+        /* Final fragment. */
+        frag = *om;
+        *om = NULL;
+        return frag;
+    }
+
+    frag = alloc_cb(max_frag_sz, cb_arg);
+    if (frag == NULL) {
+        return NULL;
+    }
+    tail = NULL;
+
+    head = *om;
+    head_len = min(head->om_len, max_frag_sz);
+    left = max_frag_sz - head_len;
+
+    /* Find the run of mbufs which fit in the fragment whole. */
+    first = SLIST_NEXT(head, om_next);
+    last = NULL;
+    ref_len = 0;
+    for (cur = first; cur != NULL && cur->om_len <= left;
+         cur = SLIST_NEXT(cur, om_next)) {
+        left -= cur->om_len;
+        ref_len += cur->om_len;
+        last = cur;
+    }
+
+    /* Copy everything which isn't moved before touching the source chain, so
+     * that it can be left intact on failure.
+     */
+    rc = os_mbuf_append(frag, head->om_data, head_len);
+    if (rc != 0) {
+        goto err;
+    }
+    if (left > 0) {
+        if (last == NULL) {
+            rc = os_mbuf_appendfrom(frag, cur, 0, left);
+        } else {
+            tail = os_mbuf_get(frag->om_omp, 0);
+            if (tail == NULL) {
+                goto err;
+            }
+            rc = os_mbuf_appendfrom(tail, cur, 0, left);
+        }
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    if (last != NULL) {
+        cur = frag;
+        while (SLIST_NEXT(cur, om_next) != NULL) {
+            cur = SLIST_NEXT(cur, om_next);
+        }
+        SLIST_NEXT(cur, om_next) = first;
+        SLIST_NEXT(head, om_next) = SLIST_NEXT(last, om_next);
+        SLIST_NEXT(last, om_next) = tail;
+        OS_MBUF_PKTHDR(frag)->omp_len += ref_len + (tail ? left : 0);
+        OS_MBUF_PKTHDR(head)->omp_len -= ref_len;
+    }
+    os_mbuf_adj(head, head_len + left);
+
+    /* Free unused portion of of source mbuf chain, if possible. */
+    *om = os_mbuf_trim_front(head);
+
+    return frag;
+
+err:
+    os_mbuf_free_chain(tail);
+    os_mbuf_free_chain(frag);
+    return NULL;
+}
+
 /**
  * Applies a pullup operation to the supplied mbuf and returns a pointer to the
  * start of the mbuf data.  This is simply a convenience function which allows
@@ -22,10 +22,26 @@
 
 #include "os/mynewt.h"
 
+#if MYNEWT_VAL(RWLOCK_STATS)
+/** Contention counters of one lock. */
+struct rwlock_stats {
+    /** Read acquisitions, including ones that had to wait. */
+    uint32_t rd_acquired;
+    /** Read acquisitions that had to wait. */
+    uint32_t rd_blocked;
+    /** Write acquisitions, including ones that had to wait. */
+    uint32_t wr_acquired;
+    /** Write acquisitions that had to wait. */
+    uint32_t wr_blocked;
+    /** Times the writer's priority was raised by a waiting task. */
+    uint32_t wr_boosts;
+};
+#endif
+
 /**
  * @brief Readers–writer lock - lock for multiple readers, single writer.
  *
- * This lock is write-preferring.  That is:
+ * By default the lock is write-preferring.  That is:
  *     o If there is no active writer and no pending writers, read-acquisitions
  *       do not block.
  *     o If there is an active writer or a pending writer, read-acquisitions
@@ -34,18 +50,28 @@
  *       is acquired by a pending writer if there is one.  If there are no
  *       pending writers, the lock is acquired by all pending readers.
  *
- * All struct fields should be considered private.
+ * With RWLOCK_READER_PREF, read-acquisitions only block on an active writer,
+ * and a releasing writer hands the lock to pending readers first.  Writers
+ * can starve if readers keep overlapping.
+ *
+ * The state is kept in a few bytes updated inside a critical section, so an
+ * uncontended acquire or release costs no more than that.  A task that has
+ * to wait for the writer lends the writer its priority, if higher, until
+ * the writer releases the lock.
+ *
+ * All struct fields should be considered private, except stats, which may
+ * be read (and cleared) by the application.
  */
 struct rwlock {
-    /** Protects access to rwlock's internal state. */
-    struct os_mutex mtx;
-
     /** Blocks and wakes up pending readers. */
     struct os_sem rsem;
 
     /** Blocks and wakes up pending writers. */
     struct os_sem wsem;
 
+    /** The active writer, once it has run; NULL if none. */
+    struct os_task *writer;
+
     /** The number of active readers. */
     uint8_t num_readers;
 
@@ -58,11 +84,12 @@ struct rwlock {
     /** The number of blocked writers. */
     uint8_t pending_writers;
 
-    /**
-     * The number of ownership transfers currently in progress.  No new
-     * acquisitions are allowed until all handoffs are complete.
-     */
-    uint8_t handoffs;
+    /** Priority of the active writer before anyone raised it. */
+    uint8_t writer_prio;
+
+#if MYNEWT_VAL(RWLOCK_STATS)
+    struct rwlock_stats stats;
+#endif
 };
 
 /**
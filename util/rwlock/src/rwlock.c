@@ -26,43 +26,18 @@
 #define RWLOCK_DBG_ASSERT(expr)
 #endif
 
-/**
- * Unblocks the next pending user.  The caller must lock the mutex prior to
- * calling this.
- */
-static void
-rwlock_unblock(struct rwlock *lock)
-{
-    RWLOCK_DBG_ASSERT(lock->mtx.mu_owner == g_current_task);
-    RWLOCK_DBG_ASSERT(lock->handoffs == 0);
-
-    /* Give priority to pending writers. */
-    if (lock->pending_writers > 0) {
-        /* Indicate that ownership is being transfered to a single writer. */
-        lock->handoffs = 1;
-
-        os_sem_release(&lock->wsem);
-        lock->pending_writers--;
-    } else {
-        /* Indicate that ownership is being transfered to a collection of
-         * readers.
-         */
-        lock->handoffs = lock->pending_readers;
-
-        while (lock->pending_readers > 0) {
-            os_sem_release(&lock->rsem);
-            lock->pending_readers--;
-        }
-    }
-}
+#if MYNEWT_VAL(RWLOCK_STATS)
+#define RWLOCK_STATS_INC(lock, field) ((lock)->stats.field++)
+#else
+#define RWLOCK_STATS_INC(lock, field)
+#endif
 
-static void
-rwlock_complete_handoff(struct rwlock *lock)
-{
-    RWLOCK_DBG_ASSERT(lock->mtx.mu_owner == g_current_task);
-    RWLOCK_DBG_ASSERT(lock->handoffs > 0);
-    lock->handoffs--;
-}
+/*
+ * All of the lock state is read and written with interrupts disabled.
+ * Ownership is handed over by the releasing task: it updates the counts
+ * on behalf of the tasks it wakes, so a woken task owns the lock as soon
+ * as its pend returns.
+ */
 
 /**
  * Indicates whether a prospective reader must wait for the lock to become
@@ -71,11 +46,12 @@ rwlock_complete_handoff(struct rwlock *lock)
 static bool
 rwlock_read_must_block(const struct rwlock *lock)
 {
-    RWLOCK_DBG_ASSERT(lock->mtx.mu_owner == g_current_task);
-
+#if MYNEWT_VAL(RWLOCK_READER_PREF)
+    return lock->active_writer;
+#else
     return lock->active_writer ||
-           lock->pending_writers > 0 ||
-           lock->handoffs > 0;
+           lock->pending_writers > 0;
+#endif
 }
 
 /**
@@ -85,50 +61,112 @@ rwlock_read_must_block(const struct rwlock *lock)
 static bool
 rwlock_write_must_block(const struct rwlock *lock)
 {
-    RWLOCK_DBG_ASSERT(lock->mtx.mu_owner == g_current_task);
-
     return lock->active_writer ||
-           lock->num_readers > 0 ||
-           lock->handoffs > 0;
+           lock->num_readers > 0;
 }
 
-void
-rwlock_acquire_read(struct rwlock *lock)
+/**
+ * Lends the current task's priority to the active writer, if that is
+ * higher than the writer's own.  Readers holding the lock are not boosted;
+ * there is no record of who they are.  Interrupts must be disabled.
+ */
+static void
+rwlock_boost_writer(struct rwlock *lock)
+{
+    struct os_task *current;
+
+    current = os_sched_get_current_task();
+    if (lock->writer != NULL && lock->writer->t_prio > current->t_prio) {
+        lock->writer->t_prio = current->t_prio;
+        os_sched_resort(lock->writer);
+        RWLOCK_STATS_INC(lock, wr_boosts);
+    }
+}
+
+/**
+ * Records the current task as the active writer.  Interrupts must be
+ * disabled.
+ */
+static void
+rwlock_set_writer(struct rwlock *lock)
+{
+    lock->writer = os_sched_get_current_task();
+    lock->writer_prio = lock->writer->t_prio;
+}
+
+/**
+ * Passes the lock on to pending writers or readers, whichever the
+ * preference puts first.  The lock must be free.  Interrupts must be
+ * disabled; the returned number of readers, or writer if -1, must be woken
+ * once they are enabled again.
+ */
+static int
+rwlock_unblock(struct rwlock *lock)
 {
-    bool acquired;
+    int num;
+
+    RWLOCK_DBG_ASSERT(!lock->active_writer && lock->num_readers == 0);
+
+#if MYNEWT_VAL(RWLOCK_READER_PREF)
+    if (lock->pending_readers == 0 && lock->pending_writers > 0) {
+#else
+    if (lock->pending_writers > 0) {
+#endif
+        lock->pending_writers--;
+        lock->active_writer = true;
+        return -1;
+    }
 
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
+    num = lock->pending_readers;
+    lock->num_readers = num;
+    lock->pending_readers = 0;
+    return num;
+}
 
-    if (rwlock_read_must_block(lock)) {
-        lock->pending_readers++;
-        acquired = false;
+static void
+rwlock_wake(struct rwlock *lock, int num)
+{
+    if (num < 0) {
+        os_sem_release(&lock->wsem);
     } else {
-        lock->num_readers++;
-        acquired = true;
+        while (num-- > 0) {
+            os_sem_release(&lock->rsem);
+        }
     }
+}
 
-    os_mutex_release(&lock->mtx);
+void
+rwlock_acquire_read(struct rwlock *lock)
+{
+    os_sr_t sr;
 
-    if (acquired) {
+    OS_ENTER_CRITICAL(sr);
+    RWLOCK_STATS_INC(lock, rd_acquired);
+    if (!rwlock_read_must_block(lock)) {
         /* No contention; lock acquired. */
+        lock->num_readers++;
+        OS_EXIT_CRITICAL(sr);
         return;
     }
 
-    /* Wait for the lock to become available. */
-    os_sem_pend(&lock->rsem, OS_TIMEOUT_NEVER);
+    RWLOCK_STATS_INC(lock, rd_blocked);
+    lock->pending_readers++;
+    rwlock_boost_writer(lock);
+    OS_EXIT_CRITICAL(sr);
 
-    /* Record reader ownership. */
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
-    lock->num_readers++;
-    rwlock_complete_handoff(lock);
-    os_mutex_release(&lock->mtx);
+    /* Wait for the lock to be handed over. */
+    os_sem_pend(&lock->rsem, OS_TIMEOUT_NEVER);
 }
 
 void
 rwlock_release_read(struct rwlock *lock)
 {
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
+    os_sr_t sr;
+    int num;
 
+    num = 0;
+
+    OS_ENTER_CRITICAL(sr);
     RWLOCK_DBG_ASSERT(lock->num_readers > 0);
     lock->num_readers--;
 
@@ -136,55 +174,74 @@ rwlock_release_read(struct rwlock *lock)
      * one.
      */
     if (lock->num_readers == 0) {
-        rwlock_unblock(lock);
+        num = rwlock_unblock(lock);
     }
+    OS_EXIT_CRITICAL(sr);
 
-    os_mutex_release(&lock->mtx);
+    rwlock_wake(lock, num);
 }
 
 void
 rwlock_acquire_write(struct rwlock *lock)
 {
-    bool acquired;
-
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
+    os_sr_t sr;
 
-    if (rwlock_write_must_block(lock)) {
-        lock->pending_writers++;
-        acquired = false;
-    } else {
-        lock->active_writer = true;
-        acquired = true;
-    }
-
-    os_mutex_release(&lock->mtx);
-
-    if (acquired) {
+    OS_ENTER_CRITICAL(sr);
+    RWLOCK_STATS_INC(lock, wr_acquired);
+    if (!rwlock_write_must_block(lock)) {
         /* No contention; lock acquired. */
+        lock->active_writer = true;
+        rwlock_set_writer(lock);
+        OS_EXIT_CRITICAL(sr);
         return;
     }
 
-    /* Wait for the lock to become available. */
+    RWLOCK_STATS_INC(lock, wr_blocked);
+    lock->pending_writers++;
+    rwlock_boost_writer(lock);
+    OS_EXIT_CRITICAL(sr);
+
+    /* Wait for the lock to be handed over. */
     os_sem_pend(&lock->wsem, OS_TIMEOUT_NEVER);
 
-    /* Record writer ownership. */
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
-    lock->active_writer = true;
-    rwlock_complete_handoff(lock);
-    os_mutex_release(&lock->mtx);
+    OS_ENTER_CRITICAL(sr);
+    RWLOCK_DBG_ASSERT(lock->active_writer && lock->writer == NULL);
+    rwlock_set_writer(lock);
+    OS_EXIT_CRITICAL(sr);
 }
 
 void
 rwlock_release_write(struct rwlock *lock)
 {
-    os_mutex_pend(&lock->mtx, OS_TIMEOUT_NEVER);
+    struct os_task *writer;
+    bool resched;
+    os_sr_t sr;
+    int num;
+
+    resched = false;
 
+    OS_ENTER_CRITICAL(sr);
     RWLOCK_DBG_ASSERT(lock->active_writer);
+
+    /* Drop any priority lent to the writer. */
+    writer = lock->writer;
+    if (writer != NULL && writer->t_prio != lock->writer_prio) {
+        writer->t_prio = lock->writer_prio;
+        os_sched_resort(writer);
+        resched = true;
+    }
+    lock->writer = NULL;
     lock->active_writer = false;
 
-    rwlock_unblock(lock);
+    num = rwlock_unblock(lock);
+    OS_EXIT_CRITICAL(sr);
+
+    rwlock_wake(lock, num);
 
-    os_mutex_release(&lock->mtx);
+    /* Without its lent priority the writer may no longer be the one to run. */
+    if (resched) {
+        os_sched(NULL);
+    }
 }
 
 int
@@ -194,11 +251,6 @@ rwlock_init(struct rwlock *lock)
 
     *lock = (struct rwlock) { 0 };
 
-    rc = os_mutex_init(&lock->mtx);
-    if (rc != 0) {
-        return rc;
-    }
-
     rc = os_sem_init(&lock->rsem, 0);
     if (rc != 0) {
         return rc;